@@ -0,0 +1,212 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "benchmark_knowhere.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/dataset.h"
+
+// Measures the build of every index type phase by phase, Train, Add, Serialize and Deserialize, across build thread
+// counts. Every phase records its wall time, its CPU time, the peak RSS of the process during the phase and, for
+// Serialize, the size of the binaries. The results are printed and written as JSON to benchmark_build_<test>.json.
+class Benchmark_build : public Benchmark_knowhere, public ::testing::Test {
+    using Clock = std::chrono::steady_clock;
+
+ public:
+    template <typename T>
+    void
+    test_build(const knowhere::Json& cfg, const std::string& params) {
+        std::string data_type_str = get_data_type_name<T>();
+        auto base = knowhere::ConvertToDataTypeIfNeeded<T>(knowhere::GenDataSet(nb_, dim_, xb_));
+
+        printf("\n[%0.3f s] %s | %s(%s) | %s\n", get_time_diff(), ann_test_name_.c_str(), index_type_.c_str(),
+               data_type_str.c_str(), params.c_str());
+        printf("================================================================================\n");
+        for (auto thread_num : THREAD_NUMs_) {
+            knowhere::KnowhereConfig::SetBuildThreadPoolSize(thread_num);
+            auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+            auto index = knowhere::IndexFactory::Instance().Create<T>(index_type_, version).value();
+            knowhere::BinarySet binset;
+            int64_t serialized_size = 0;
+
+            knowhere::Json run;
+            run["index_type"] = index_type_;
+            run["data_type"] = data_type_str;
+            run["params"] = params;
+            run["thread_num"] = thread_num;
+            run["rows"] = nb_;
+            run["dim"] = dim_;
+            run["train"] = measure([&] { return index.Train(base, cfg); });
+            run["add"] = measure([&] { return index.Add(base, cfg); });
+            run["serialize"] = measure([&] {
+                auto status = index.Serialize(binset);
+                for (const auto& [name, binary] : binset.binary_map_) {
+                    serialized_size += binary->size;
+                }
+                return status;
+            });
+            run["serialize"]["size_bytes"] = serialized_size;
+            auto loaded = knowhere::IndexFactory::Instance().Create<T>(index_type_, version).value();
+            run["deserialize"] = measure([&] { return loaded.Deserialize(binset, cfg); });
+
+            printf("  thread_num = %2d", thread_num);
+            for (const char* phase : {"train", "add", "serialize", "deserialize"}) {
+                printf(", %s = %.3fs/%.3fs cpu/%.1fMB", phase, run[phase]["wall_s"].get<double>(),
+                       run[phase]["cpu_s"].get<double>(), run[phase]["peak_rss_bytes"].get<int64_t>() / 1048576.0);
+            }
+            printf(", size = %.1fMB\n", serialized_size / 1048576.0);
+            std::fflush(stdout);
+            results_.push_back(std::move(run));
+        }
+        printf("================================================================================\n");
+        printf("[%.3f s] Test '%s/%s' done\n\n", get_time_diff(), ann_test_name_.c_str(), index_type_.c_str());
+    }
+
+ private:
+    static double
+    cpu_seconds() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+    }
+
+    // resets the peak RSS of the process to its current RSS, false where the kernel does not support it
+    static bool
+    reset_peak_rss() {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+        return clear_refs.good();
+    }
+
+    static int64_t
+    peak_rss_bytes() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) {
+                return std::stoll(line.substr(6)) * 1024;
+            }
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss * 1024;
+    }
+
+    knowhere::Json
+    measure(const std::function<knowhere::Status()>& phase) {
+        const bool peak_reset = reset_peak_rss();
+        const double cpu_start = cpu_seconds();
+        const auto start = Clock::now();
+        const auto status = phase();
+        knowhere::Json result;
+        result["wall_s"] = std::chrono::duration<double>(Clock::now() - start).count();
+        result["cpu_s"] = cpu_seconds() - cpu_start;
+        result["peak_rss_bytes"] = peak_rss_bytes();
+        // without the reset the peak is that of the whole process so far
+        result["peak_rss_of_phase"] = peak_reset;
+        result["status"] = knowhere::Status2String(status);
+        EXPECT_EQ(status, knowhere::Status::success);
+        return result;
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        set_ann_test_name("sift-128-euclidean");
+        parse_ann_test_name();
+        load_hdf5_data<knowhere::fp32>();
+
+        cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AVX2);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(default_search_thread_num);
+    }
+
+    void
+    TearDown() override {
+        const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+        const std::string filename = std::string("benchmark_build_") + test->name() + ".json";
+        std::ofstream out(filename);
+        out << knowhere::Json(results_).dump(2) << std::endl;
+        printf("[%.3f s] Results written to %s\n", get_time_diff(), filename.c_str());
+        free_all();
+    }
+
+ protected:
+    std::vector<knowhere::Json> results_;
+
+    const std::vector<int32_t> THREAD_NUMs_ = {1, 4, 16};
+
+    // IVF index params
+    const int32_t NLIST_ = 1024;
+
+    // IVFPQ index params
+    const int32_t M_ = 16;
+    const int32_t NBITS_ = 8;
+
+    // HNSW index params
+    const int32_t HNSW_M_ = 16;
+    const int32_t EFCON_ = 200;
+};
+
+TEST_F(Benchmark_build, TEST_IVF_FLAT) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFFLAT;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    test_build<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_));
+}
+
+TEST_F(Benchmark_build, TEST_IVF_SQ8) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFSQ8;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    test_build<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_));
+}
+
+TEST_F(Benchmark_build, TEST_IVF_PQ) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFPQ;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::M] = M_;
+    conf[knowhere::indexparam::NBITS] = NBITS_;
+    test_build<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_) + ", m=" + std::to_string(M_));
+}
+
+TEST_F(Benchmark_build, TEST_SCANN) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_SCANN;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::WITH_RAW_DATA] = true;
+    test_build<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_));
+}
+
+TEST_F(Benchmark_build, TEST_HNSW) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    test_build<knowhere::fp32>(conf, "M=" + std::to_string(HNSW_M_) + ", efConstruction=" + std::to_string(EFCON_));
+    test_build<knowhere::fp16>(conf, "M=" + std::to_string(HNSW_M_) + ", efConstruction=" + std::to_string(EFCON_));
+}
@@ -0,0 +1,245 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+#include "benchmark_knowhere.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/comp/warm_up.h"
+#include "knowhere/dataset.h"
+
+// Loads an index with DeserializeFromFile() and enable_mmap from a file none of whose pages are cached, as a new
+// node of an autoscaled cluster does, and reports the latency of its first queries and how long it takes for them to
+// reach the steady state latency, without and with a WarmUp() of each level after the load.
+//
+// The pages of the file are dropped with posix_fadvise(POSIX_FADV_DONTNEED), that needs no privileges and leaves the
+// rest of the page cache alone. The steady state is the median latency of the same queries once the whole index is
+// paged in, it is reached when the median of a window of STEADY_WINDOW_ queries is within STEADY_SLACK_ of it.
+class Benchmark_float_cold_start : public Benchmark_knowhere, public ::testing::Test {
+    using Clock = std::chrono::steady_clock;
+
+ public:
+    template <typename T>
+    void
+    test_cold_start(const knowhere::Json& cfg, const std::string& params) {
+        auto conf = cfg;
+        conf[knowhere::meta::TOPK] = topk_;
+        conf["enable_mmap"] = true;
+        std::string data_type_str = get_data_type_name<T>();
+        const std::string mmap_file = get_index_name<T>(std::vector<std::string>{"mmap"});
+        write_mmap_file(mmap_file);
+
+        // the reference, every page of the index is resident
+        std::vector<double> steady_ms;
+        {
+            auto index = load<T>(mmap_file, conf, nullptr);
+            ASSERT_EQ(index.WarmUp(knowhere::WarmUpLevel::ALL), knowhere::Status::success);
+            steady_ms = first_queries<T>(index, conf);
+        }
+        std::sort(steady_ms.begin(), steady_ms.end());
+        const double steady_p50 = steady_ms[steady_ms.size() / 2];
+
+        printf("\n[%0.3f s] %s | %s(%s) | %s, k=%d, steady p50 = %.3fms\n", get_time_diff(), ann_test_name_.c_str(),
+               index_type_.c_str(), data_type_str.c_str(), params.c_str(), topk_, steady_p50);
+        printf("================================================================================\n");
+        const std::vector<std::pair<const char*, knowhere::WarmUpLevel>> warm_ups = {
+            {"none", knowhere::WarmUpLevel::NONE},
+            {"structure", knowhere::WarmUpLevel::STRUCTURE},
+            {"all", knowhere::WarmUpLevel::ALL}};
+        for (const auto& [name, level] : warm_ups) {
+            drop_page_cache(mmap_file);
+            const auto start = Clock::now();
+            double load_s = 0.0, warm_up_s = 0.0;
+            auto index = load<T>(mmap_file, conf, &load_s);
+            if (level != knowhere::WarmUpLevel::NONE) {
+                CALC_TIME_SPAN(ASSERT_EQ(index.WarmUp(level), knowhere::Status::success));
+                warm_up_s = TDIFF_;
+            }
+            const long faults_before = major_faults();
+            auto ms = first_queries<T>(index, conf);
+            const long faults = major_faults() - faults_before;
+
+            // the first window whose median is close to the steady one
+            size_t steady_at = ms.size();
+            for (size_t i = STEADY_WINDOW_; i <= ms.size(); i++) {
+                std::vector<double> window(ms.begin() + i - STEADY_WINDOW_, ms.begin() + i);
+                std::nth_element(window.begin(), window.begin() + window.size() / 2, window.end());
+                if (window[window.size() / 2] <= steady_p50 * STEADY_SLACK_) {
+                    steady_at = i;
+                    break;
+                }
+            }
+            double query_s = 0.0;
+            for (size_t i = 0; i < steady_at; i++) {
+                query_s += ms[i] / 1000.0;
+            }
+            printf("  warm_up = %-9s, load = %7.3fs, warm up = %7.3fs, major faults = %6ld\n", name, load_s, warm_up_s,
+                   faults);
+            for (auto n : {10, 100, FIRST_QUERY_NUM_}) {
+                print_latencies(ms, n);
+            }
+            if (steady_at < ms.size()) {
+                printf("    steady after %zu queries, %.3fs after the load started\n", steady_at,
+                       load_s + warm_up_s + query_s);
+            } else {
+                printf("    not steady after %zu queries, %.3fs after the load started\n", ms.size(),
+                       std::chrono::duration<double>(Clock::now() - start).count());
+            }
+            std::fflush(stdout);
+        }
+        printf("================================================================================\n");
+        printf("[%.3f s] Test '%s/%s' done\n\n", get_time_diff(), ann_test_name_.c_str(), index_type_.c_str());
+        std::remove(mmap_file.c_str());
+    }
+
+ private:
+    // the file DeserializeFromFile() maps, the binary of the index
+    void
+    write_mmap_file(const std::string& filename) {
+        knowhere::BinarySet binary_set;
+        ASSERT_EQ(index_.value().Serialize(binary_set), knowhere::Status::success);
+        auto binary = binary_set.binary_map_.size() == 1 ? binary_set.binary_map_.begin()->second
+                                                         : binary_set.GetByName(index_.value().Type());
+        ASSERT_NE(binary, nullptr);
+        std::ofstream out(filename, std::ios::binary);
+        out.write((const char*)binary->data.get(), binary->size);
+    }
+
+    static void
+    drop_page_cache(const std::string& filename) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        ASSERT_GE(fd, 0);
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+
+    template <typename T>
+    knowhere::Index<knowhere::IndexNode>
+    load(const std::string& filename, const knowhere::Json& conf, double* load_s) {
+        auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+        auto index = knowhere::IndexFactory::Instance().Create<T>(index_type_, version).value();
+        knowhere::Status status;
+        CALC_TIME_SPAN(status = index.DeserializeFromFile(filename, conf));
+        EXPECT_EQ(status, knowhere::Status::success);
+        if (load_s != nullptr) {
+            *load_s = TDIFF_;
+        }
+        return index;
+    }
+
+    // the latencies of FIRST_QUERY_NUM_ queries searched one at a time, in ms
+    template <typename T>
+    std::vector<double>
+    first_queries(const knowhere::Index<knowhere::IndexNode>& index, const knowhere::Json& conf) {
+        std::vector<double> ms(FIRST_QUERY_NUM_);
+        for (int32_t i = 0; i < FIRST_QUERY_NUM_; i++) {
+            auto ds_ptr = knowhere::GenDataSet(1, dim_, (const float*)xq_ + (i % nq_) * dim_);
+            auto query = knowhere::ConvertToDataTypeIfNeeded<T>(ds_ptr);
+            const auto start = Clock::now();
+            index.Search(query, conf, nullptr);
+            ms[i] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        return ms;
+    }
+
+    static void
+    print_latencies(const std::vector<double>& all_ms, int32_t n) {
+        std::vector<double> ms(all_ms.begin(), all_ms.begin() + std::min<size_t>(n, all_ms.size()));
+        std::sort(ms.begin(), ms.end());
+        auto percentile = [&ms](double p) { return ms[std::min<size_t>(ms.size() - 1, p * ms.size())]; };
+        printf("    first %5zu queries, p50 = %8.3fms, p99 = %8.3fms, max = %8.3fms\n", ms.size(), percentile(0.5),
+               percentile(0.99), ms.back());
+    }
+
+    static long
+    major_faults() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_majflt;
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        set_ann_test_name("sift-128-euclidean");
+        parse_ann_test_name();
+        load_hdf5_data<knowhere::fp32>();
+
+        cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AVX2);
+        knowhere::KnowhereConfig::SetBuildThreadPoolSize(default_build_thread_num);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(default_search_thread_num);
+    }
+
+    void
+    TearDown() override {
+        free_all();
+    }
+
+ protected:
+    const int32_t topk_ = 10;
+    const int32_t FIRST_QUERY_NUM_ = 2000;
+    const size_t STEADY_WINDOW_ = 50;
+    const double STEADY_SLACK_ = 1.2;
+
+    // IVF index params
+    const int32_t NLIST_ = 1024;
+    const int32_t NPROBE_ = 16;
+
+    // HNSW index params
+    const int32_t HNSW_M_ = 16;
+    const int32_t EFCON_ = 100;
+    const int32_t EF_ = 64;
+};
+
+TEST_F(Benchmark_float_cold_start, TEST_IDMAP) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IDMAP;
+
+    knowhere::Json conf = cfg_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_cold_start<knowhere::fp32>(conf, "flat");
+}
+
+TEST_F(Benchmark_float_cold_start, TEST_IVF_FLAT) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFFLAT;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::NPROBE] = NPROBE_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_cold_start<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_) + ", nprobe=" + std::to_string(NPROBE_));
+}
+
+TEST_F(Benchmark_float_cold_start, TEST_HNSW) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    conf[knowhere::indexparam::EF] = EF_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{HNSW_M_, EFCON_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_cold_start<knowhere::fp32>(conf, "M=" + std::to_string(HNSW_M_) + ", efConstruction=" +
+                                              std::to_string(EFCON_) + ", ef=" + std::to_string(EF_));
+}
@@ -0,0 +1,222 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "benchmark_knowhere.h"
+#include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/dataset.h"
+
+// Sweeps the filter ratio of filtered searches on a fine grid, for filters of three shapes, and reports the QPS and
+// recall curves of an index, also written to benchmark_float_filter_<index>.csv:
+//   random:      the rows that pass are random
+//   correlated:  the rows that pass are the clusters closest to the query, as a filter on a category the query is of
+//   anti:        the rows that pass are the clusters farthest from the query, the hard case for graph indexes
+// The clusters are the nearest of CLUSTER_NUM_ base rows sampled as centroids. Every query is searched alone with its
+// own bitset, so that the filter follows it. The curves show where the brute force thresholds of the HNSW search
+// (HnswSearchThresholds) and the planner switch strategies.
+class Benchmark_float_filter : public Benchmark_knowhere, public ::testing::Test {
+    using Clock = std::chrono::steady_clock;
+
+ public:
+    template <typename T>
+    void
+    test_filter(const knowhere::Json& cfg, const std::string& params) {
+        auto conf = cfg;
+        conf[knowhere::meta::TOPK] = topk_;
+        std::string data_type_str = get_data_type_name<T>();
+        const std::string csv_name = "benchmark_float_filter_" + index_type_ + "_" + data_type_str + ".csv";
+        std::ofstream csv(csv_name);
+        csv << "shape,filter_ratio,qps,recall\n";
+
+        printf("\n[%0.3f s] %s | %s(%s) | %s, nq=%d, k=%d\n", get_time_diff(), ann_test_name_.c_str(),
+               index_type_.c_str(), data_type_str.c_str(), params.c_str(), FILTER_NQ_, topk_);
+        printf("================================================================================\n");
+        for (auto shape : {"random", "correlated", "anti"}) {
+            for (auto ratio : FILTER_RATIOs_) {
+                double search_s = 0.0;
+                float recall = 0.0f;
+                for (int32_t i = 0; i < FILTER_NQ_; i++) {
+                    auto bitset_data = gen_bitset(shape, ratio, i);
+                    knowhere::BitsetView bitset(bitset_data.data(), nb_);
+                    auto ds_ptr = knowhere::GenDataSet(1, dim_, (const float*)xq_ + i * dim_);
+                    auto query = knowhere::ConvertToDataTypeIfNeeded<T>(ds_ptr);
+                    auto g_result = golden_index_.value().Search(ds_ptr, conf, bitset);
+                    const auto start = Clock::now();
+                    auto result = index_.value().Search(query, conf, bitset);
+                    search_s += std::chrono::duration<double>(Clock::now() - start).count();
+                    ASSERT_TRUE(result.has_value());
+                    recall += CalcRecall(g_result.value()->GetIds(), result.value()->GetIds(), 1, topk_);
+                }
+                recall /= FILTER_NQ_;
+                printf("  shape = %-10s, filter_ratio = %.3f, QPS = %9.1f, R@%d = %.4f\n", shape, ratio,
+                       FILTER_NQ_ / search_s, topk_, recall);
+                csv << shape << "," << ratio << "," << FILTER_NQ_ / search_s << "," << recall << "\n";
+                std::fflush(stdout);
+            }
+        }
+        printf("================================================================================\n");
+        printf("[%.3f s] Test '%s/%s' done, curves written to %s\n\n", get_time_diff(), ann_test_name_.c_str(),
+               index_type_.c_str(), csv_name.c_str());
+    }
+
+ private:
+    // nb_ * ratio rows filtered out, a set bit filters a row out
+    std::vector<uint8_t>
+    gen_bitset(const std::string& shape, float ratio, int32_t query) {
+        const size_t filtered = nb_ * ratio;
+        if (shape == "random") {
+            return GenRandomBitset(nb_, filtered);
+        }
+        std::vector<uint8_t> data((nb_ + 7) / 8, 0xff);
+        size_t kept = nb_ - filtered;
+        const int64_t* ranked = query_clusters_.data() + static_cast<size_t>(query) * CLUSTER_NUM_;
+        for (int32_t c = 0; c < CLUSTER_NUM_ && kept > 0; c++) {
+            const auto& members = cluster_members_[ranked[shape == "correlated" ? c : CLUSTER_NUM_ - 1 - c]];
+            for (size_t j = 0; j < members.size() && kept > 0; j++, kept--) {
+                data[members[j] >> 3] &= ~(0x1 << (members[j] & 0x7));
+            }
+        }
+        return data;
+    }
+
+    // the clusters of the base rows, and the clusters of every query from the closest to the farthest
+    void
+    cluster() {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int32_t> row(0, nb_ - 1);
+        centroids_.resize(static_cast<size_t>(CLUSTER_NUM_) * dim_);
+        for (int32_t c = 0; c < CLUSTER_NUM_; c++) {
+            std::memcpy(centroids_.data() + c * dim_, (const float*)xb_ + static_cast<size_t>(row(rng)) * dim_,
+                        dim_ * sizeof(float));
+        }
+        auto centroids = knowhere::GenDataSet(CLUSTER_NUM_, dim_, centroids_.data());
+        knowhere::Json conf;
+        conf[knowhere::meta::DIM] = dim_;
+        conf[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+        conf[knowhere::meta::TOPK] = 1;
+        auto assign = knowhere::BruteForce::Search<knowhere::fp32>(centroids, knowhere::GenDataSet(nb_, dim_, xb_),
+                                                                   conf, nullptr);
+        ASSERT_TRUE(assign.has_value());
+        cluster_members_.assign(CLUSTER_NUM_, {});
+        for (int32_t i = 0; i < nb_; i++) {
+            cluster_members_[assign.value()->GetIds()[i]].push_back(i);
+        }
+
+        conf[knowhere::meta::TOPK] = CLUSTER_NUM_;
+        auto ranked = knowhere::BruteForce::Search<knowhere::fp32>(
+            centroids, knowhere::GenDataSet(FILTER_NQ_, dim_, xq_), conf, nullptr);
+        ASSERT_TRUE(ranked.has_value());
+        query_clusters_.assign(ranked.value()->GetIds(),
+                               ranked.value()->GetIds() + static_cast<size_t>(FILTER_NQ_) * CLUSTER_NUM_);
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        set_ann_test_name("sift-128-euclidean");
+        parse_ann_test_name();
+        load_hdf5_data<knowhere::fp32>();
+
+        cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AVX2);
+        knowhere::KnowhereConfig::SetBuildThreadPoolSize(default_build_thread_num);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(default_search_thread_num);
+
+        create_golden_index(cfg_);
+        cluster();
+        printf("[%.3f s] Clustered %d rows into %d clusters\n", get_time_diff(), nb_, CLUSTER_NUM_);
+    }
+
+    void
+    TearDown() override {
+        free_all();
+    }
+
+ protected:
+    const int32_t topk_ = 10;
+    const int32_t FILTER_NQ_ = 200;
+    const int32_t CLUSTER_NUM_ = 256;
+    const std::vector<float> FILTER_RATIOs_ = {0.0f,  0.1f,  0.2f,  0.3f,  0.4f,  0.5f,  0.6f,  0.7f,  0.75f,
+                                               0.8f,  0.85f, 0.9f,  0.93f, 0.95f, 0.97f, 0.98f, 0.99f, 0.995f};
+
+    std::vector<float> centroids_;
+    std::vector<std::vector<int32_t>> cluster_members_;
+    std::vector<int64_t> query_clusters_;
+
+    // IVF index params
+    const int32_t NLIST_ = 1024;
+    const int32_t NPROBE_ = 16;
+
+    // HNSW index params
+    const int32_t HNSW_M_ = 16;
+    const int32_t EFCON_ = 100;
+    const int32_t EF_ = 64;
+};
+
+TEST_F(Benchmark_float_filter, TEST_IVF_FLAT) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFFLAT;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::NPROBE] = NPROBE_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_filter<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_) + ", nprobe=" + std::to_string(NPROBE_));
+}
+
+TEST_F(Benchmark_float_filter, TEST_IVF_SQ8) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFSQ8;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::NPROBE] = NPROBE_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_filter<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_) + ", nprobe=" + std::to_string(NPROBE_));
+}
+
+TEST_F(Benchmark_float_filter, TEST_HNSW) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    conf[knowhere::indexparam::EF] = EF_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{HNSW_M_, EFCON_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_filter<knowhere::fp32>(conf, "M=" + std::to_string(HNSW_M_) + ", efConstruction=" + std::to_string(EFCON_) +
+                                          ", ef=" + std::to_string(EF_));
+}
+
+TEST_F(Benchmark_float_filter, TEST_HNSW_SQ) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW_SQ;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    conf[knowhere::indexparam::EF] = EF_;
+    conf[knowhere::indexparam::SQ_TYPE] = "SQ8";
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{HNSW_M_, EFCON_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_filter<knowhere::fp32>(conf, "M=" + std::to_string(HNSW_M_) + ", efConstruction=" + std::to_string(EFCON_) +
+                                          ", ef=" + std::to_string(EF_) + ", SQ8");
+}
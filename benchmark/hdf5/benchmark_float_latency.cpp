@@ -0,0 +1,238 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "benchmark_knowhere.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/dataset.h"
+
+// Drives concurrent clients that search one query at a time and reports the latency percentiles of the queries.
+// Closed loop clients issue their next query once the last one returns, so the load follows the latency. Open loop
+// clients issue queries at Poisson arrivals of a fixed total rate, the latency then includes the wait behind the
+// queries issued before, as under a real offered load.
+class Benchmark_float_latency : public Benchmark_knowhere, public ::testing::Test {
+    using Clock = std::chrono::steady_clock;
+
+ public:
+    template <typename T>
+    void
+    test_latency(const knowhere::Json& cfg, const std::string& params) {
+        auto conf = cfg;
+        conf[knowhere::meta::TOPK] = topk_;
+        std::string data_type_str = get_data_type_name<T>();
+
+        auto ds_ptr = knowhere::GenDataSet(nq_, dim_, xq_);
+        auto query = knowhere::ConvertToDataTypeIfNeeded<T>(ds_ptr);
+        auto result = index_.value().Search(query, conf, nullptr);
+        float recall = CalcRecall(result.value()->GetIds(), nq_, topk_);
+
+        printf("\n[%0.3f s] %s | %s(%s) | %s, k=%d, R@=%.4f\n", get_time_diff(), ann_test_name_.c_str(),
+               index_type_.c_str(), data_type_str.c_str(), params.c_str(), topk_, recall);
+        printf("================================================================================\n");
+        for (auto client_num : CLIENT_NUMs_) {
+            auto latencies = closed_loop<T>(conf, client_num);
+            print_latencies("closed loop", "clients", client_num, latencies);
+        }
+        for (auto rate : OFFERED_QPSs_) {
+            auto latencies = open_loop<T>(conf, rate);
+            print_latencies("open loop", "offered qps", rate, latencies);
+        }
+        printf("================================================================================\n");
+        printf("[%.3f s] Test '%s/%s' done\n\n", get_time_diff(), ann_test_name_.c_str(), index_type_.c_str());
+    }
+
+ private:
+    struct Latencies {
+        // of every query, in ms
+        std::vector<double> ms;
+        double elapsed_s = 0.0;
+    };
+
+    void
+    print_latencies(const char* mode, const char* load_name, int32_t load, Latencies& latencies) {
+        auto& ms = latencies.ms;
+        std::sort(ms.begin(), ms.end());
+        auto percentile = [&ms](double p) {
+            return ms.empty() ? 0.0 : ms[std::min<size_t>(ms.size() - 1, p * ms.size())];
+        };
+        printf("  %s, %s = %5d, QPS = %9.1f, p50 = %7.3fms, p90 = %7.3fms, p99 = %7.3fms, p999 = %7.3fms\n", mode,
+               load_name, load, ms.size() / latencies.elapsed_s, percentile(0.5), percentile(0.9), percentile(0.99),
+               percentile(0.999));
+        std::fflush(stdout);
+    }
+
+    template <typename T>
+    knowhere::DataSetPtr
+    query_of(int32_t i) {
+        auto ds_ptr = knowhere::GenDataSet(1, dim_, (const float*)xq_ + (i % nq_) * dim_);
+        return knowhere::ConvertToDataTypeIfNeeded<T>(ds_ptr);
+    }
+
+    // every client searches its share of QUERY_NUM_ queries back to back
+    template <typename T>
+    Latencies
+    closed_loop(const knowhere::Json& conf, int32_t client_num) {
+        std::vector<std::vector<double>> client_ms(client_num);
+        auto client = [&](int32_t idx) {
+            for (int32_t i = idx; i < QUERY_NUM_; i += client_num) {
+                auto query = query_of<T>(i);
+                const auto start = Clock::now();
+                index_.value().Search(query, conf, nullptr);
+                client_ms[idx].push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            }
+        };
+
+        Latencies latencies;
+        const auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int32_t i = 0; i < client_num; i++) {
+            threads.emplace_back(client, i);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        latencies.elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+        for (auto& ms : client_ms) {
+            latencies.ms.insert(latencies.ms.end(), ms.begin(), ms.end());
+        }
+        return latencies;
+    }
+
+    // QUERY_NUM_ queries are scheduled at Poisson arrivals of `rate` per second, OPEN_LOOP_CLIENTS_ clients take them.
+    // A query is timed from its scheduled arrival, so a client that falls behind adds the backlog to the latency.
+    template <typename T>
+    Latencies
+    open_loop(const knowhere::Json& conf, int32_t rate) {
+        std::vector<Clock::duration> arrivals(QUERY_NUM_);
+        std::mt19937_64 rng(42);
+        std::exponential_distribution<double> gap(rate);
+        Clock::duration at{};
+        for (auto& arrival : arrivals) {
+            at += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(rng)));
+            arrival = at;
+        }
+
+        std::vector<double> ms(QUERY_NUM_);
+        std::atomic<int32_t> next = 0;
+        const auto start = Clock::now();
+        auto client = [&]() {
+            for (int32_t i = next++; i < QUERY_NUM_; i = next++) {
+                const auto arrival = start + arrivals[i];
+                std::this_thread::sleep_until(arrival);
+                auto query = query_of<T>(i);
+                index_.value().Search(query, conf, nullptr);
+                ms[i] = std::chrono::duration<double, std::milli>(Clock::now() - arrival).count();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int32_t i = 0; i < OPEN_LOOP_CLIENTS_; i++) {
+            threads.emplace_back(client);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        Latencies latencies;
+        latencies.elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+        latencies.ms = std::move(ms);
+        return latencies;
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        set_ann_test_name("sift-128-euclidean");
+        parse_ann_test_name();
+        load_hdf5_data<knowhere::fp32>();
+
+        cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AVX2);
+        knowhere::KnowhereConfig::SetBuildThreadPoolSize(default_build_thread_num);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(default_search_thread_num);
+    }
+
+    void
+    TearDown() override {
+        free_all();
+    }
+
+ protected:
+    const int32_t topk_ = 10;
+    // the queries of every run, the queries of the data set are repeated
+    const int32_t QUERY_NUM_ = 20000;
+    const std::vector<int32_t> CLIENT_NUMs_ = {1, 4, 16, 64};
+    const std::vector<int32_t> OFFERED_QPSs_ = {500, 1000, 2000, 4000, 8000};
+    // enough for the open loop clients never to be the bottleneck of the offered load
+    const int32_t OPEN_LOOP_CLIENTS_ = 256;
+
+    // IVF index params
+    const int32_t NLIST_ = 1024;
+    const int32_t NPROBE_ = 16;
+
+    // HNSW index params
+    const int32_t HNSW_M_ = 16;
+    const int32_t EFCON_ = 100;
+    const int32_t EF_ = 64;
+};
+
+TEST_F(Benchmark_float_latency, TEST_IDMAP) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IDMAP;
+
+    knowhere::Json conf = cfg_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_latency<knowhere::fp32>(conf, "flat");
+}
+
+TEST_F(Benchmark_float_latency, TEST_IVF_FLAT) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFFLAT;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::NPROBE] = NPROBE_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_latency<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_) + ", nprobe=" + std::to_string(NPROBE_));
+}
+
+TEST_F(Benchmark_float_latency, TEST_IVF_SQ8) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFSQ8;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::NPROBE] = NPROBE_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_latency<knowhere::fp32>(conf, "nlist=" + std::to_string(NLIST_) + ", nprobe=" + std::to_string(NPROBE_));
+}
+
+TEST_F(Benchmark_float_latency, TEST_HNSW) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    conf[knowhere::indexparam::EF] = EF_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{HNSW_M_, EFCON_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_latency<knowhere::fp32>(conf, "M=" + std::to_string(HNSW_M_) + ", efConstruction=" + std::to_string(EFCON_) +
+                                           ", ef=" + std::to_string(EF_));
+}
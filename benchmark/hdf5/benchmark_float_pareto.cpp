@@ -0,0 +1,274 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <variant>
+#include <vector>
+
+#include "benchmark_knowhere.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/dataset.h"
+#include "knowhere/index/index_static.h"
+
+// Sweeps the search params of an index on a grid and writes the recall/QPS Pareto frontier, the points that no other
+// point beats on both recall and QPS, to benchmark_float_pareto_<index>.csv (every point, frontier flagged) and .json
+// (the frontier only), as AutoTune of faiss does for its indexes.
+//
+// The grid of a param doubles from its low to its high bound, both clipped to the range the config of the index
+// declares for it with KNOWHERE_CONFIG_DECLARE_FIELD. The points the config rejects, such as ef < k, are skipped.
+class Benchmark_float_pareto : public Benchmark_knowhere, public ::testing::Test {
+ public:
+    struct TunedParam {
+        std::string name;
+        double low;
+        double high;
+    };
+
+    template <typename T>
+    void
+    test_pareto(const knowhere::Json& cfg, const std::vector<TunedParam>& tuned) {
+        auto conf = cfg;
+        conf[knowhere::meta::TOPK] = topk_;
+        std::string data_type_str = get_data_type_name<T>();
+        auto ds_ptr = knowhere::GenDataSet(nq_, dim_, xq_);
+        auto query = knowhere::ConvertToDataTypeIfNeeded<T>(ds_ptr);
+
+        std::vector<std::vector<knowhere::Json>> grids;
+        for (const auto& param : tuned) {
+            grids.push_back(grid<T>(param));
+            ASSERT_FALSE(grids.back().empty()) << "no value of " << param.name << " to sweep";
+        }
+        printf("\n[%0.3f s] %s | %s(%s) | k=%d, sweeping", get_time_diff(), ann_test_name_.c_str(),
+               index_type_.c_str(), data_type_str.c_str(), topk_);
+        for (size_t i = 0; i < tuned.size(); i++) {
+            printf(" %s (%zu values)", tuned[i].name.c_str(), grids[i].size());
+        }
+        printf("\n================================================================================\n");
+
+        std::vector<Point> points;
+        std::vector<size_t> at(tuned.size(), 0);
+        while (!tuned.empty() && at[0] < grids[0].size()) {
+            Point point;
+            for (size_t i = 0; i < tuned.size(); i++) {
+                conf[tuned[i].name] = grids[i][at[i]];
+                point.params[tuned[i].name] = grids[i][at[i]];
+            }
+            knowhere::expected<knowhere::DataSetPtr> result;
+            CALC_TIME_SPAN(result = index_.value().Search(query, conf, nullptr));
+            if (result.has_value()) {
+                point.qps = nq_ / TDIFF_;
+                point.recall = CalcRecall(result.value()->GetIds(), nq_, topk_);
+                printf("  %s, QPS = %9.1f, R@%d = %.4f\n", point.params.dump().c_str(), point.qps, topk_,
+                       point.recall);
+                std::fflush(stdout);
+                points.push_back(std::move(point));
+            }
+            // the next point of the grid, the last param first
+            for (size_t i = tuned.size(); i-- > 0;) {
+                if (++at[i] < grids[i].size() || i == 0) {
+                    break;
+                }
+                at[i] = 0;
+            }
+        }
+
+        mark_frontier(points);
+        printf("  Pareto frontier:\n");
+        const std::string name = "benchmark_float_pareto_" + index_type_ + "_" + data_type_str;
+        std::ofstream csv(name + ".csv");
+        csv << "params,qps,recall,pareto\n";
+        knowhere::Json frontier = knowhere::Json::array();
+        for (const auto& point : points) {
+            std::string params = point.params.dump();
+            std::replace(params.begin(), params.end(), ',', ';');
+            csv << params << "," << point.qps << "," << point.recall << "," << point.pareto << "\n";
+            if (point.pareto) {
+                printf("    %s, QPS = %9.1f, R@%d = %.4f\n", point.params.dump().c_str(), point.qps, topk_,
+                       point.recall);
+                frontier.push_back({{"params", point.params}, {"qps", point.qps}, {"recall", point.recall}});
+            }
+        }
+        knowhere::Json out = {{"index_type", index_type_}, {"data_type", data_type_str}, {"dataset", ann_test_name_},
+                              {"topk", topk_},             {"frontier", frontier}};
+        std::ofstream(name + ".json") << out.dump(2) << "\n";
+        printf("================================================================================\n");
+        printf("[%.3f s] Test '%s/%s' done, written to %s.{csv,json}\n\n", get_time_diff(), ann_test_name_.c_str(),
+               index_type_.c_str(), name.c_str());
+    }
+
+ private:
+    struct Point {
+        knowhere::Json params;
+        double qps = 0.0;
+        float recall = 0.0f;
+        bool pareto = false;
+    };
+
+    // sorted by recall, a point is on the frontier if it is faster than every point with a higher recall
+    static void
+    mark_frontier(std::vector<Point>& points) {
+        std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+            return a.recall != b.recall ? a.recall > b.recall : a.qps > b.qps;
+        });
+        double best_qps = -1.0;
+        for (auto& point : points) {
+            if (point.qps > best_qps) {
+                point.pareto = true;
+                best_qps = point.qps;
+            }
+        }
+    }
+
+    // the values of a param, within the range its config entry declares
+    template <typename T>
+    std::vector<knowhere::Json>
+    grid(const TunedParam& param) {
+        auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+        auto config = knowhere::IndexStaticFaced<T>::CreateConfig(index_type_, version);
+        double low = param.low, high = param.high;
+        bool is_float = false;
+        auto it = config->__DICT__.find(param.name);
+        if (it != config->__DICT__.end()) {
+            std::visit(
+                [&](const auto& entry) {
+                    using EntryT = std::decay_t<decltype(entry)>;
+                    if constexpr (std::is_same_v<EntryT, knowhere::Entry<CFG_FLOAT>> ||
+                                  std::is_same_v<EntryT, knowhere::Entry<CFG_INT>> ||
+                                  std::is_same_v<EntryT, knowhere::Entry<CFG_INT64>>) {
+                        is_float = std::is_same_v<EntryT, knowhere::Entry<CFG_FLOAT>>;
+                        if (entry.range.has_value()) {
+                            low = std::max<double>(low, entry.range->left);
+                            high = std::min<double>(high, entry.range->right);
+                        }
+                    }
+                },
+                it->second);
+        } else {
+            printf("[%.3f s] %s has no search param %s\n", get_time_diff(), index_type_.c_str(), param.name.c_str());
+        }
+        std::vector<knowhere::Json> values;
+        for (double v = low; v <= high; v *= 2) {
+            if (is_float) {
+                values.emplace_back(v);
+            } else {
+                values.emplace_back(static_cast<int64_t>(std::llround(v)));
+            }
+        }
+        return values;
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        set_ann_test_name("sift-128-euclidean");
+        parse_ann_test_name();
+        load_hdf5_data<knowhere::fp32>();
+
+        cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AVX2);
+        knowhere::KnowhereConfig::SetBuildThreadPoolSize(default_build_thread_num);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(default_search_thread_num);
+    }
+
+    void
+    TearDown() override {
+        free_all();
+    }
+
+ protected:
+    const int32_t topk_ = 10;
+
+    // IVF index params
+    const int32_t NLIST_ = 1024;
+    const int32_t M_ = 32;
+    const int32_t NBITS_ = 8;
+
+    // HNSW index params
+    const int32_t HNSW_M_ = 16;
+    const int32_t EFCON_ = 200;
+};
+
+TEST_F(Benchmark_float_pareto, TEST_IVF_FLAT) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFFLAT;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_pareto<knowhere::fp32>(conf, {{knowhere::indexparam::NPROBE, 1, NLIST_ / 2}});
+}
+
+TEST_F(Benchmark_float_pareto, TEST_IVF_SQ8) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFSQ8;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_pareto<knowhere::fp32>(conf, {{knowhere::indexparam::NPROBE, 1, NLIST_ / 2}});
+}
+
+TEST_F(Benchmark_float_pareto, TEST_IVF_PQ) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_IVFPQ;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::M] = M_;
+    conf[knowhere::indexparam::NBITS] = NBITS_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_, M_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_pareto<knowhere::fp32>(conf, {{knowhere::indexparam::NPROBE, 1, NLIST_ / 2}});
+}
+
+TEST_F(Benchmark_float_pareto, TEST_SCANN) {
+    index_type_ = knowhere::IndexEnum::INDEX_FAISS_SCANN;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::NLIST] = NLIST_;
+    conf[knowhere::indexparam::WITH_RAW_DATA] = true;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{NLIST_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_pareto<knowhere::fp32>(
+        conf, {{knowhere::indexparam::NPROBE, 1, NLIST_ / 2}, {knowhere::indexparam::REORDER_K, topk_, topk_ * 64}});
+}
+
+TEST_F(Benchmark_float_pareto, TEST_HNSW) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<int32_t>{HNSW_M_, EFCON_});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_pareto<knowhere::fp32>(conf, {{knowhere::indexparam::EF, topk_, 2048}});
+}
+
+TEST_F(Benchmark_float_pareto, TEST_HNSW_SQ) {
+    index_type_ = knowhere::IndexEnum::INDEX_HNSW_SQ;
+
+    knowhere::Json conf = cfg_;
+    conf[knowhere::indexparam::HNSW_M] = HNSW_M_;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = EFCON_;
+    conf[knowhere::indexparam::SQ_TYPE] = "SQ8";
+    conf[knowhere::indexparam::HNSW_REFINE] = true;
+    conf[knowhere::indexparam::HNSW_REFINE_TYPE] = "FLAT";
+    std::string index_file_name = get_index_name<knowhere::fp32>(std::vector<std::string>{
+        std::to_string(HNSW_M_), std::to_string(EFCON_), "SQ8", "FLAT"});
+    create_index<knowhere::fp32>(index_file_name, conf);
+    test_pareto<knowhere::fp32>(
+        conf, {{knowhere::indexparam::EF, topk_, 2048}, {knowhere::indexparam::HNSW_REFINE_K, 1, 16}});
+}
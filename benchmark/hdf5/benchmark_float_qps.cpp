@@ -202,11 +202,16 @@ class Benchmark_float_qps : public Benchmark_knowhere, public ::testing::Test {
                    ann_test_name_.c_str(), index_type_.c_str(), data_type_str.c_str(), M, efConstruction, ef, topk_,
                    recall);
             printf("================================================================================\n");
-            for (auto thread_num : THREAD_NUMs_) {
-                CALC_TIME_SPAN(task<T>(conf, thread_num, nq_));
-                printf("  thread_num = %2d, elapse = %6.3fs, VPS = %.3f\n", thread_num, TDIFF_, nq_ / TDIFF_);
-                std::fflush(stdout);
+            for (auto prefetch_depth : HNSW_PREFETCH_DEPTHs_) {
+                conf[knowhere::indexparam::HNSW_PREFETCH_DEPTH] = prefetch_depth;
+                for (auto thread_num : THREAD_NUMs_) {
+                    CALC_TIME_SPAN(task<T>(conf, thread_num, nq_));
+                    printf("  prefetch_depth = %2d, thread_num = %2d, elapse = %6.3fs, VPS = %.3f\n", prefetch_depth,
+                           thread_num, TDIFF_, nq_ / TDIFF_);
+                    std::fflush(stdout);
+                }
             }
+            conf.erase(knowhere::indexparam::HNSW_PREFETCH_DEPTH);
             printf("================================================================================\n");
             printf("[%.3f s] Test '%s/%s' done\n\n", get_time_diff(), ann_test_name_.c_str(), index_type_.c_str());
         }
@@ -403,6 +408,8 @@ class Benchmark_float_qps : public Benchmark_knowhere, public ::testing::Test {
     // HNSW index params
     const std::vector<int32_t> HNSW_Ms_ = {16};
     const std::vector<int32_t> EFCONs_ = {100};
+    // 0 means no pipelined prefetching during the graph expansion
+    const std::vector<int32_t> HNSW_PREFETCH_DEPTHs_ = {0, 8};
 
     // SCANN index params
     const std::vector<int32_t> SCANN_REORDER_K = {256, 512, 768, 1024};
@@ -14,6 +14,7 @@
 #include <assert.h>
 #include <hdf5.h>
 
+#include <cstdlib>
 #include <unordered_set>
 #include <vector>
 
@@ -54,9 +55,11 @@ static const char* METRIC_JAC_STR = "jaccard";
 
 class Benchmark_hdf5 : public Benchmark_base {
  public:
+    // KNOWHERE_BENCHMARK_DATASET overrides the dataset of a test, e.g. for the datasets of a regression run
     void
     set_ann_test_name(const char* test_name) {
-        ann_test_name_ = test_name;
+        const char* dataset = std::getenv("KNOWHERE_BENCHMARK_DATASET");
+        ann_test_name_ = (dataset != nullptr && dataset[0] != '\0') ? dataset : test_name;
     }
 
     int32_t
@@ -0,0 +1,254 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark_base.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/comp/local_file_manager.h"
+#include "knowhere/dataset.h"
+#include "knowhere/index/index_factory.h"
+
+namespace fs = std::filesystem;
+
+// Builds MINHASH_LSH for several band counts, then loads each index with the hash codes in memory or mapped, with
+// one bloom filter per band or a shared one, and reports the load time, the memory it takes and the QPS and recall of
+// the plain and the batch search.
+//
+// The signatures are read from $MINHASH_DATA_PATH, in the raw format of the index: uint32 rows, uint32 dim in bits,
+// then the signatures. Without it $MINHASH_ROWS random signatures, 1M by default, are generated into
+// $MINHASH_WORK_DIR, where the indexes are also built. Each query is a base signature with a part of its hash values
+// replaced, so the base signature it comes from is its nearest neighbor, and the recall is how often the search
+// returns it. That needs no brute force, which does not scale to the 10M-1B rows of a dedup cluster.
+class Benchmark_minhash : public Benchmark_base, public ::testing::Test {
+ public:
+    void
+    test_minhash() {
+        for (auto band : BANDs_) {
+            const std::string index_dir = work_dir_ + "/band_" + std::to_string(band) + "/";
+            fs::create_directories(index_dir);
+            knowhere::Json conf = cfg_;
+            conf[knowhere::indexparam::MH_LSH_BAND] = band;
+            conf[knowhere::meta::INDEX_PREFIX] = index_dir;
+            conf[knowhere::meta::DATA_PATH] = data_path_;
+            conf[knowhere::indexparam::MH_LSH_ALIGNED_BLOCK_SIZE] = 4096;
+            conf[knowhere::indexparam::WITH_RAW_DATA] = true;
+
+            auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+            auto pack = knowhere::Pack(std::shared_ptr<knowhere::FileManager>(new knowhere::LocalFileManager()));
+            {
+                auto index = knowhere::IndexFactory::Instance()
+                                 .Create<knowhere::bin1>(knowhere::IndexEnum::INDEX_MINHASH_LSH, version, pack)
+                                 .value();
+                knowhere::Status status;
+                CALC_TIME_SPAN(status = index.Build(nullptr, conf));
+                ASSERT_EQ(status, knowhere::Status::success);
+            }
+            size_t index_size = 0;
+            for (const auto& entry : fs::directory_iterator(index_dir)) {
+                index_size += entry.file_size();
+            }
+            printf("\n[%0.3f s] %s | rows=%ld, band=%d, build = %.3fs, index file = %.1fMB\n", get_time_diff(),
+                   data_path_.c_str(), nb_, band, TDIFF_, index_size / 1048576.0);
+            printf("================================================================================\n");
+            for (auto code_in_mem : {true, false}) {
+                for (auto shared_bloom_filter : {false, true}) {
+                    conf[knowhere::indexparam::MH_LSH_HASH_CODE_IN_MEM] = code_in_mem;
+                    conf[knowhere::indexparam::MH_LSH_SHARED_BLOOM_FILTER] = shared_bloom_filter;
+                    load_and_search(version, pack, conf, code_in_mem, shared_bloom_filter);
+                }
+            }
+            printf("================================================================================\n");
+            fs::remove_all(index_dir);
+        }
+        printf("[%.3f s] Test 'MINHASH_LSH' done\n\n", get_time_diff());
+    }
+
+ private:
+    void
+    load_and_search(int32_t version, const knowhere::Object& pack, knowhere::Json& conf, bool code_in_mem,
+                    bool shared_bloom_filter) {
+        auto index = knowhere::IndexFactory::Instance()
+                         .Create<knowhere::bin1>(knowhere::IndexEnum::INDEX_MINHASH_LSH, version, pack)
+                         .value();
+        const int64_t rss_before = rss_bytes();
+        knowhere::Status status;
+        CALC_TIME_SPAN(status = index.Deserialize(knowhere::BinarySet(), conf));
+        ASSERT_EQ(status, knowhere::Status::success);
+        printf("  %-9s | %-17s | load = %7.3fs, rss += %.1fMB\n", code_in_mem ? "in-memory" : "mmap",
+               shared_bloom_filter ? "shared bloom" : "bloom per band", TDIFF_,
+               (rss_bytes() - rss_before) / 1048576.0);
+        for (auto batch_search : {false, true}) {
+            conf[knowhere::indexparam::MH_LSH_BATCH_SEARCH] = batch_search;
+            knowhere::expected<knowhere::DataSetPtr> result;
+            CALC_TIME_SPAN(result = index.Search(queries_, conf, nullptr));
+            ASSERT_TRUE(result.has_value());
+            printf("    batch_search = %d, QPS = %9.1f, R@%d = %.4f\n", batch_search, nq_ / TDIFF_, topk_,
+                   source_recall(result.value()->GetIds()));
+            std::fflush(stdout);
+        }
+    }
+
+    // the share of the queries the base signature of which is in their results
+    float
+    source_recall(const int64_t* ids) const {
+        int32_t hits = 0;
+        for (int32_t i = 0; i < nq_; i++) {
+            hits += std::count(ids + i * topk_, ids + (i + 1) * topk_, source_ids_[i]) > 0;
+        }
+        return static_cast<float>(hits) / nq_;
+    }
+
+    static int64_t
+    rss_bytes() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) {
+                return std::stoll(line.substr(6)) * 1024;
+            }
+        }
+        return 0;
+    }
+
+    // writes the random signatures chunk by chunk, so that the base never has to fit in memory
+    void
+    generate(int64_t rows) {
+        std::ofstream out(data_path_, std::ios::binary);
+        const uint32_t num = rows, dim = dim_;
+        out.write((const char*)&num, sizeof(num));
+        out.write((const char*)&dim, sizeof(dim));
+        std::mt19937_64 rng(42);
+        std::vector<uint64_t> chunk;
+        for (int64_t begin = 0; begin < rows; begin += GEN_CHUNK_ROWS_) {
+            const int64_t n = std::min<int64_t>(GEN_CHUNK_ROWS_, rows - begin);
+            chunk.resize(n * row_bytes() / sizeof(uint64_t));
+            for (auto& word : chunk) {
+                word = rng();
+            }
+            out.write((const char*)chunk.data(), chunk.size() * sizeof(uint64_t));
+        }
+        if (!out) {
+            throw std::runtime_error("cannot write " + data_path_);
+        }
+    }
+
+    // copies random base signatures and replaces MUTATE_RATIO_ of their hash values
+    void
+    make_queries() {
+        std::ifstream in(data_path_, std::ios::binary);
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<int64_t> row(0, nb_ - 1);
+        std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+        const size_t element_bytes = ELEMENT_BIT_WIDTH_ / 8;
+        query_data_.resize(static_cast<size_t>(nq_) * row_bytes());
+        source_ids_.resize(nq_);
+        for (int32_t i = 0; i < nq_; i++) {
+            source_ids_[i] = row(rng);
+            uint8_t* query = query_data_.data() + static_cast<size_t>(i) * row_bytes();
+            in.seekg(2 * sizeof(uint32_t) + source_ids_[i] * row_bytes());
+            in.read((char*)query, row_bytes());
+            for (int32_t h = 0; h < HASH_NUM_; h++) {
+                if (coin(rng) < MUTATE_RATIO_) {
+                    const uint64_t value = rng();
+                    std::memcpy(query + h * element_bytes, &value, element_bytes);
+                }
+            }
+        }
+        if (!in) {
+            throw std::runtime_error("cannot read the base signatures from " + data_path_);
+        }
+        queries_ = knowhere::GenDataSet(nq_, dim_, query_data_.data());
+    }
+
+    size_t
+    row_bytes() const {
+        return dim_ / 8;
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        const char* work_dir = std::getenv("MINHASH_WORK_DIR");
+        work_dir_ = work_dir != nullptr ? work_dir : "minhash_benchmark";
+        fs::create_directories(work_dir_);
+        if (const char* data_path = std::getenv("MINHASH_DATA_PATH")) {
+            data_path_ = data_path;
+            std::ifstream in(data_path_, std::ios::binary);
+            uint32_t num = 0, dim = 0;
+            in.read((char*)&num, sizeof(num));
+            in.read((char*)&dim, sizeof(dim));
+            if (!in || dim != dim_) {
+                throw std::runtime_error(data_path_ + " does not hold signatures of " + std::to_string(dim_) + " bits");
+            }
+            nb_ = num;
+        } else {
+            const char* rows = std::getenv("MINHASH_ROWS");
+            nb_ = rows != nullptr ? std::stoll(rows) : 1000000;
+            data_path_ = work_dir_ + "/raw_data";
+            generate(nb_);
+            printf("[%.3f s] Generated %ld signatures of %d hash values into %s\n", get_time_diff(), nb_, HASH_NUM_,
+                   data_path_.c_str());
+        }
+        make_queries();
+
+        cfg_[knowhere::meta::DIM] = dim_;
+        cfg_[knowhere::meta::METRIC_TYPE] = knowhere::metric::MHJACCARD;
+        cfg_[knowhere::meta::TOPK] = topk_;
+        cfg_[knowhere::indexparam::MH_ELEMENT_BIT_WIDTH] = ELEMENT_BIT_WIDTH_;
+        cfg_[knowhere::indexparam::MH_LSH_SEARCH_WITH_JACCARD] = true;
+        knowhere::KnowhereConfig::SetBuildThreadPoolSize(BUILD_THREAD_NUM_);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(SEARCH_THREAD_NUM_);
+    }
+
+    void
+    TearDown() override {
+        if (std::getenv("MINHASH_DATA_PATH") == nullptr) {
+            fs::remove(data_path_);
+        }
+    }
+
+ protected:
+    const int32_t topk_ = 10;
+    const int32_t nq_ = 10000;
+    const int32_t HASH_NUM_ = 128;
+    const int32_t ELEMENT_BIT_WIDTH_ = 32;
+    const int32_t dim_ = HASH_NUM_ * ELEMENT_BIT_WIDTH_;
+    const float MUTATE_RATIO_ = 0.2f;
+    const int64_t GEN_CHUNK_ROWS_ = 1 << 20;
+    const int32_t BUILD_THREAD_NUM_ = 32;
+    const int32_t SEARCH_THREAD_NUM_ = 16;
+    const std::vector<int32_t> BANDs_ = {8, 16, 32, 64};
+
+    std::string work_dir_;
+    std::string data_path_;
+    int64_t nb_ = 0;
+    std::vector<uint8_t> query_data_;
+    std::vector<int64_t> source_ids_;
+    knowhere::DataSetPtr queries_;
+    knowhere::Json cfg_;
+};
+
+TEST_F(Benchmark_minhash, TEST_MINHASH_LSH) {
+    test_minhash();
+}
@@ -289,7 +289,53 @@ class Benchmark_simd_qps : public Benchmark_knowhere, public ::testing::Test {
         }
     }
 
+    template <typename T>
+    static void
+    ip_batch_8_worker(knowhere::DataSetPtr base, knowhere::DataSetPtr query, int32_t start, int32_t num, float* dist) {
+        batch_8_worker<T, false>(base, query, start, num, dist);
+    }
+
+    template <typename T>
+    static void
+    l2_batch_8_worker(knowhere::DataSetPtr base, knowhere::DataSetPtr query, int32_t start, int32_t num, float* dist) {
+        batch_8_worker<T, true>(base, query, start, num, dist);
+    }
+
  private:
+    template <typename T, bool L2>
+    static void
+    batch_8_worker(knowhere::DataSetPtr base, knowhere::DataSetPtr query, int32_t start, int32_t num, float* dist) {
+        auto dim = base->GetDim();
+        auto nb = base->GetRows();
+        auto xb = (const T*)base->GetTensor();
+
+        auto nq = query->GetRows();
+        auto xq = (const T*)query->GetTensor();
+
+        num = std::min<int32_t>(num, nq - start);
+        for (int32_t i = 0; i < num; i++) {
+            const size_t offset = (start + i) * dim;
+            const T* x = xq + offset;
+            for (int32_t j = 0; j + 8 <= nb; j += 8) {
+                const T* y[8];
+                for (int32_t k = 0; k < 8; k++) {
+                    y[k] = xb + (j + k) * dim;
+                }
+                float d[8];
+                float* out = dist ? dist + (start + i) * nb + j : d;
+                if constexpr (std::is_same_v<T, knowhere::fp32>) {
+                    (L2 ? faiss::fvec_L2sqr_batch_8 : faiss::fvec_inner_product_batch_8)(x, y, dim, out);
+                } else if constexpr (std::is_same_v<T, knowhere::fp16>) {
+                    (L2 ? faiss::fp16_vec_L2sqr_batch_8 : faiss::fp16_vec_inner_product_batch_8)(x, y, dim, out);
+                } else if constexpr (std::is_same_v<T, knowhere::bf16>) {
+                    (L2 ? faiss::bf16_vec_L2sqr_batch_8 : faiss::bf16_vec_inner_product_batch_8)(x, y, dim, out);
+                } else if constexpr (std::is_same_v<T, knowhere::int8>) {
+                    (L2 ? faiss::int8_vec_L2sqr_batch_8 : faiss::int8_vec_inner_product_batch_8)(x, y, dim, out);
+                }
+            }
+        }
+    }
+
     template <typename T>
     void
     task(knowhere::DataSetPtr base, knowhere::DataSetPtr query, worker worker_func, int32_t worker_num, float* dist) {
@@ -335,6 +381,7 @@ class Benchmark_simd_qps : public Benchmark_knowhere, public ::testing::Test {
         knowhere::KnowhereConfig::SimdType::AVX2,
         knowhere::KnowhereConfig::SimdType::SSE4_2,
 #endif
+        // the hooks of aarch64 follow the cpu, SVE where it is supported, NEON otherwise
         knowhere::KnowhereConfig::SimdType::GENERIC,
     };
 };
@@ -346,6 +393,8 @@ TEST_F(Benchmark_simd_qps, TEST_SIMD) {
     test_simd<T1>("L2_NORM", l2_norm_worker<T1>);
     test_simd<T1>("IP_BATCH_4", ip_batch_4_worker<T1>);
     test_simd<T1>("L2_BATCH_4", l2_batch_4_worker<T1>);
+    test_simd<T1>("IP_BATCH_8", ip_batch_8_worker<T1>);
+    test_simd<T1>("L2_BATCH_8", l2_batch_8_worker<T1>);
 
     using T2 = knowhere::fp16;
     test_simd<T2>("IP", ip_worker<T2>);
@@ -353,6 +402,8 @@ TEST_F(Benchmark_simd_qps, TEST_SIMD) {
     test_simd<T2>("L2_NORM", l2_norm_worker<T2>);
     test_simd<T2>("IP_BATCH_4", ip_batch_4_worker<T2>);
     test_simd<T2>("L2_BATCH_4", l2_batch_4_worker<T2>);
+    test_simd<T2>("IP_BATCH_8", ip_batch_8_worker<T2>);
+    test_simd<T2>("L2_BATCH_8", l2_batch_8_worker<T2>);
 
     using T3 = knowhere::bf16;
     test_simd<T3>("IP", ip_worker<T3>);
@@ -360,6 +411,8 @@ TEST_F(Benchmark_simd_qps, TEST_SIMD) {
     test_simd<T3>("L2_NORM", l2_norm_worker<T3>);
     test_simd<T3>("IP_BATCH_4", ip_batch_4_worker<T3>);
     test_simd<T3>("L2_BATCH_4", l2_batch_4_worker<T3>);
+    test_simd<T3>("IP_BATCH_8", ip_batch_8_worker<T3>);
+    test_simd<T3>("L2_BATCH_8", l2_batch_8_worker<T3>);
 
     using T4 = knowhere::int8;
     test_simd<T4>("IP", ip_worker<T4>);
@@ -367,4 +420,6 @@ TEST_F(Benchmark_simd_qps, TEST_SIMD) {
     test_simd<T4>("L2_NORM", l2_norm_worker<T4>);
     test_simd<T4>("IP_BATCH_4", ip_batch_4_worker<T4>);
     test_simd<T4>("L2_BATCH_4", l2_batch_4_worker<T4>);
+    test_simd<T4>("IP_BATCH_8", ip_batch_8_worker<T4>);
+    test_simd<T4>("L2_BATCH_8", l2_batch_8_worker<T4>);
 }
@@ -0,0 +1,225 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark_base.h"
+#include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/dataset.h"
+#include "knowhere/index/index_factory.h"
+#include "knowhere/sparse_utils.h"
+
+// Sweeps the algorithms of the sparse inverted indexes and their pruning params on a CSR data set, such as the SPLADE
+// encoded MS MARCO of the big-ann-benchmarks sparse track, and reports QPS, recall and the memory of the index.
+//
+// The files are read from $SPARSE_DATA_DIR, the current directory by default:
+//   base.csr, queries.csr: int64 rows, cols, nnz, then int64 indptr[rows + 1], int32 indices[nnz], float data[nnz]
+//   base.gt (optional):    uint32 nq, k, then int32 ids[nq * k] and float distances[nq * k], as the big-ann tools
+//                          write them. Without it the ground truth is computed by brute force.
+class Benchmark_sparse : public Benchmark_base, public ::testing::Test {
+ public:
+    void
+    test_sparse(const std::string& index_type, const knowhere::Json& cfg) {
+        for (const auto& algo : ALGOs_) {
+            auto conf = cfg;
+            conf[knowhere::indexparam::INVERTED_INDEX_ALGO] = algo;
+            auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+            auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+            const int64_t rss_before = rss_bytes();
+            CALC_TIME_SPAN(index.Build(base_, conf));
+            printf("\n[%0.3f s] %s | %s | metric=%s, algo=%s, build = %.3fs, index size = %.1fMB, rss += %.1fMB\n",
+                   get_time_diff(), data_dir_.c_str(), index_type.c_str(), metric_type_.c_str(), algo.c_str(),
+                   TDIFF_, index.Size() / 1048576.0, (rss_bytes() - rss_before) / 1048576.0);
+            printf("================================================================================\n");
+            for (auto drop_ratio : DROP_RATIO_SEARCHs_) {
+                conf[knowhere::indexparam::DROP_RATIO_SEARCH] = drop_ratio;
+                const bool approximate = algo != "TAAT_NAIVE";
+                for (auto dim_max_score_ratio : approximate ? DIM_MAX_SCORE_RATIOs_ : std::vector<float>{1.0f}) {
+                    conf[knowhere::meta::DIM_MAX_SCORE_RATIO] = dim_max_score_ratio;
+                    search(index, conf, drop_ratio, dim_max_score_ratio);
+                }
+            }
+            printf("================================================================================\n");
+        }
+        printf("[%.3f s] Test '%s' done\n\n", get_time_diff(), index_type.c_str());
+    }
+
+ private:
+    void
+    search(knowhere::Index<knowhere::IndexNode>& index, const knowhere::Json& conf, float drop_ratio,
+           float dim_max_score_ratio) {
+        knowhere::expected<knowhere::DataSetPtr> result;
+        CALC_TIME_SPAN(result = index.Search(queries_, conf, nullptr));
+        ASSERT_TRUE(result.has_value());
+        float recall = CalcRecall(gt_ids_.data(), result.value()->GetIds(), nq_, topk_);
+        printf("  drop_ratio_search = %.2f, dim_max_score_ratio = %.2f, QPS = %9.1f, R@%d = %.4f\n", drop_ratio,
+               dim_max_score_ratio, nq_ / TDIFF_, topk_, recall);
+        std::fflush(stdout);
+    }
+
+    static int64_t
+    rss_bytes() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) {
+                return std::stoll(line.substr(6)) * 1024;
+            }
+        }
+        return 0;
+    }
+
+    static knowhere::DataSetPtr
+    load_csr(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot open " + filename);
+        }
+        int64_t rows, cols, nnz;
+        in.read((char*)&rows, sizeof(rows));
+        in.read((char*)&cols, sizeof(cols));
+        in.read((char*)&nnz, sizeof(nnz));
+        std::vector<int64_t> indptr(rows + 1);
+        std::vector<int32_t> indices(nnz);
+        std::vector<float> data(nnz);
+        in.read((char*)indptr.data(), indptr.size() * sizeof(int64_t));
+        in.read((char*)indices.data(), indices.size() * sizeof(int32_t));
+        in.read((char*)data.data(), data.size() * sizeof(float));
+        if (!in) {
+            throw std::runtime_error("truncated CSR file " + filename);
+        }
+
+        auto tensor = std::make_unique<knowhere::sparse::SparseRow<float>[]>(rows);
+        for (int64_t i = 0; i < rows; i++) {
+            knowhere::sparse::SparseRow<float> row(indptr[i + 1] - indptr[i]);
+            for (int64_t j = indptr[i]; j < indptr[i + 1]; j++) {
+                row.set_at(j - indptr[i], indices[j], data[j]);
+            }
+            tensor[i] = std::move(row);
+        }
+        auto ds = knowhere::GenDataSet(rows, cols, tensor.release());
+        ds->SetIsOwner(true);
+        ds->SetIsSparse(true);
+        return ds;
+    }
+
+    // the ground truth of the big-ann tools, false if there is no such file
+    bool
+    load_gt(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        uint32_t nq, k;
+        in.read((char*)&nq, sizeof(nq));
+        in.read((char*)&k, sizeof(k));
+        if (static_cast<int32_t>(nq) != nq_ || static_cast<int32_t>(k) < topk_) {
+            throw std::runtime_error("the ground truth " + filename + " does not match the queries");
+        }
+        std::vector<int32_t> ids(static_cast<size_t>(nq) * k);
+        in.read((char*)ids.data(), ids.size() * sizeof(int32_t));
+        gt_ids_.resize(static_cast<size_t>(nq_) * topk_);
+        for (int32_t i = 0; i < nq_; i++) {
+            std::copy_n(ids.begin() + static_cast<size_t>(i) * k, topk_, gt_ids_.begin() + i * topk_);
+        }
+        return true;
+    }
+
+ protected:
+    void
+    SetUp() override {
+        T0_ = elapsed();
+        const char* dir = std::getenv("SPARSE_DATA_DIR");
+        data_dir_ = dir != nullptr ? dir : ".";
+        base_ = load_csr(data_dir_ + "/base.csr");
+        queries_ = load_csr(data_dir_ + "/queries.csr");
+        nq_ = queries_->GetRows();
+        printf("[%.3f s] Loaded %ld base rows and %d queries of %ld dims\n", get_time_diff(), base_->GetRows(), nq_,
+               base_->GetDim());
+
+        cfg_[knowhere::meta::TOPK] = topk_;
+        knowhere::KnowhereConfig::SetBuildThreadPoolSize(BUILD_THREAD_NUM_);
+        knowhere::KnowhereConfig::SetSearchThreadPoolSize(SEARCH_THREAD_NUM_);
+    }
+
+    // the ground truth of the metric of the test, it is only read from the file for IP
+    void
+    prepare_gt() {
+        if (metric_type_ == knowhere::metric::IP && load_gt(data_dir_ + "/base.gt")) {
+            return;
+        }
+        printf("[%.3f s] Computing the ground truth by brute force\n", get_time_diff());
+        auto result = knowhere::BruteForce::SearchSparse(base_, queries_, cfg_, nullptr);
+        ASSERT_TRUE(result.has_value());
+        gt_ids_.assign(result.value()->GetIds(), result.value()->GetIds() + static_cast<size_t>(nq_) * topk_);
+    }
+
+    // the mean number of terms of the documents, for BM25 on term frequencies
+    float
+    avgdl() const {
+        auto rows = static_cast<const knowhere::sparse::SparseRow<float>*>(base_->GetTensor());
+        double sum = 0.0;
+        for (int64_t i = 0; i < base_->GetRows(); i++) {
+            for (size_t j = 0; j < rows[i].size(); j++) {
+                sum += rows[i][j].val;
+            }
+        }
+        return sum / std::max<int64_t>(base_->GetRows(), 1);
+    }
+
+ protected:
+    const int32_t topk_ = 10;
+    const int32_t BUILD_THREAD_NUM_ = 32;
+    const int32_t SEARCH_THREAD_NUM_ = 16;
+    const std::vector<std::string> ALGOs_ = {"TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND"};
+    const std::vector<float> DROP_RATIO_SEARCHs_ = {0.0f, 0.1f, 0.3f, 0.5f};
+    const std::vector<float> DIM_MAX_SCORE_RATIOs_ = {0.8f, 0.9f, 1.0f, 1.1f};
+
+    std::string data_dir_;
+    std::string metric_type_;
+    knowhere::DataSetPtr base_;
+    knowhere::DataSetPtr queries_;
+    int32_t nq_ = 0;
+    std::vector<int64_t> gt_ids_;
+    knowhere::Json cfg_;
+};
+
+TEST_F(Benchmark_sparse, TEST_SPARSE_INVERTED_INDEX_IP) {
+    metric_type_ = knowhere::metric::IP;
+    cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+    prepare_gt();
+    test_sparse(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, cfg_);
+}
+
+TEST_F(Benchmark_sparse, TEST_SPARSE_WAND_IP) {
+    metric_type_ = knowhere::metric::IP;
+    cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+    prepare_gt();
+    test_sparse(knowhere::IndexEnum::INDEX_SPARSE_WAND, cfg_);
+}
+
+TEST_F(Benchmark_sparse, TEST_SPARSE_INVERTED_INDEX_BM25) {
+    metric_type_ = knowhere::metric::BM25;
+    cfg_[knowhere::meta::METRIC_TYPE] = metric_type_;
+    cfg_[knowhere::meta::BM25_K1] = 1.2;
+    cfg_[knowhere::meta::BM25_B] = 0.75;
+    cfg_[knowhere::meta::BM25_AVGDL] = avgdl();
+    prepare_gt();
+    test_sparse(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, cfg_);
+}
@@ -0,0 +1,813 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+// Microbenchmarks of the kernels of the searches: the distance functions of src/simd/hook.h for every ISA the cpu
+// supports, the heaps and result handlers, the bitset scans and the SQ / PQ decoders. The hardware counters of
+// every timed loop are reported per iteration, see perf_counters.h.
+//
+//   ./benchmark_kernels --benchmark_filter='avx2/fvec_L2sqr/.*'
+//   ./benchmark_kernels --benchmark_format=json --benchmark_out=kernels.json
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "faiss/impl/ProductQuantizer.h"
+#include "faiss/impl/ResultHandler.h"
+#include "faiss/impl/ScalarQuantizer.h"
+#include "faiss/utils/Heap.h"
+#include "knowhere/bitsetview.h"
+#include "knowhere/comp/knowhere_config.h"
+#include "knowhere/operands.h"
+#include "perf_counters.h"
+#include "src/simd/hook.h"
+
+namespace {
+
+using SimdType = knowhere::KnowhereConfig::SimdType;
+using BenchmarkFn = std::function<void(benchmark::State&)>;
+
+// the vectors a query is compared to in an iteration, more than the L1 cache holds for the larger dims
+constexpr size_t kNy = 1024;
+constexpr size_t kTopk = 10;
+const std::vector<int64_t> kDims = {32, 128, 512, 1536};
+
+template <typename T>
+std::vector<T>
+RandomVectors(size_t n, size_t dim, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> distrib(-1.0f, 1.0f);
+    std::vector<T> v(n * dim);
+    for (auto& e : v) {
+        if constexpr (std::is_same_v<T, int8_t>) {
+            e = static_cast<int8_t>(distrib(rng) * 127);
+        } else if constexpr (std::is_same_v<T, uint8_t>) {
+            e = static_cast<uint8_t>(rng());
+        } else {
+            e = T(distrib(rng));
+        }
+    }
+    return v;
+}
+
+void
+SetProcessed(benchmark::State& state, size_t items, size_t bytes) {
+    state.SetItemsProcessed(state.iterations() * items);
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+// the hooks of hook.h follow the ISA of the running benchmark, SetSimdType() is only called when it changes
+void
+UseIsa(SimdType isa) {
+    static SimdType current = SimdType::AUTO;
+    static bool set = false;
+    if (!set || current != isa) {
+        knowhere::KnowhereConfig::SetSimdType(isa);
+        current = isa;
+        set = true;
+    }
+}
+
+/*****************************************************************************/
+// distances, the kernels are lambdas so that they read the hooks when they run
+
+template <typename T, typename Kernel>
+void
+OneToOne(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<T>(1, dim, 1);
+    const auto y = RandomVectors<T>(kNy, dim, 2);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j++) {
+                benchmark::DoNotOptimize(kernel(x.data(), y.data() + j * dim, dim));
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * dim * sizeof(T));
+}
+
+template <typename T, typename Kernel>
+void
+Norm(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const auto y = RandomVectors<T>(kNy, dim, 2);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j++) {
+                benchmark::DoNotOptimize(kernel(y.data() + j * dim, dim));
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * dim * sizeof(T));
+}
+
+template <typename T, typename Kernel>
+void
+Batch4(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<T>(1, dim, 1);
+    const auto y = RandomVectors<T>(kNy, dim, 2);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j += 4) {
+                float d0, d1, d2, d3;
+                const T* y0 = y.data() + j * dim;
+                kernel(x.data(), y0, y0 + dim, y0 + 2 * dim, y0 + 3 * dim, dim, d0, d1, d2, d3);
+                benchmark::DoNotOptimize(d0 + d1 + d2 + d3);
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * dim * sizeof(T));
+}
+
+template <typename T, typename Kernel>
+void
+Batch8(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<T>(1, dim, 1);
+    const auto y = RandomVectors<T>(kNy, dim, 2);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j += 8) {
+                const T* ys[8];
+                for (size_t b = 0; b < 8; b++) {
+                    ys[b] = y.data() + (j + b) * dim;
+                }
+                float dis[8];
+                kernel(x.data(), ys, dim, dis);
+                benchmark::DoNotOptimize(dis);
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * dim * sizeof(T));
+}
+
+// the kernels that compare x with kNy contiguous vectors at once
+template <typename T, typename Kernel>
+void
+OneToMany(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<T>(1, dim, 1);
+    const auto y = RandomVectors<T>(kNy, dim, 2);
+    std::vector<float> dis(kNy);
+    std::vector<int64_t> ids(kNy);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            kernel(x.data(), y.data(), dim, dis.data(), ids.data());
+            benchmark::DoNotOptimize(dis.data());
+        }
+    }
+    SetProcessed(state, kNy, kNy * dim * sizeof(T));
+}
+
+// y is stored dimension by dimension, as the centroids of the kmeans assignment
+template <typename Kernel>
+void
+Transposed(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<float>(1, dim, 1);
+    const auto y = RandomVectors<float>(kNy, dim, 2);
+    std::vector<float> y_sqlen(kNy);
+    for (size_t j = 0; j < kNy; j++) {
+        float s = 0.0f;
+        for (size_t d = 0; d < dim; d++) {
+            s += y[d * kNy + j] * y[d * kNy + j];
+        }
+        y_sqlen[j] = s;
+    }
+    std::vector<float> dis(kNy);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(kernel(dis.data(), x.data(), y.data(), y_sqlen.data(), dim, kNy, kNy));
+        }
+    }
+    SetProcessed(state, kNy, kNy * dim * sizeof(float));
+}
+
+void
+Madd(benchmark::State& state, bool argmin) {
+    const size_t n = state.range(0) * kNy;
+    const auto a = RandomVectors<float>(n, 1, 1);
+    const auto b = RandomVectors<float>(n, 1, 2);
+    std::vector<float> c(n);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            if (argmin) {
+                benchmark::DoNotOptimize(faiss::fvec_madd_and_argmin(n, a.data(), -2.0f, b.data(), c.data()));
+            } else {
+                faiss::fvec_madd(n, a.data(), -2.0f, b.data(), c.data());
+                benchmark::DoNotOptimize(c.data());
+            }
+        }
+    }
+    SetProcessed(state, n, 2 * n * sizeof(float));
+}
+
+// binary codes of dim bits
+template <typename Dis, typename Kernel>
+void
+BinaryNy(benchmark::State& state, Kernel kernel) {
+    const size_t code_size = state.range(0) / 8;
+    const auto x = RandomVectors<uint8_t>(1, code_size, 1);
+    const auto y = RandomVectors<uint8_t>(kNy, code_size, 2);
+    std::vector<Dis> dis(kNy);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            kernel(x.data(), y.data(), code_size, kNy, dis.data());
+            benchmark::DoNotOptimize(dis.data());
+        }
+    }
+    SetProcessed(state, kNy, kNy * code_size);
+}
+
+// minhash signatures of dim elements of ElementType
+template <typename ElementType, typename Kernel>
+void
+MinHashJaccard(benchmark::State& state, Kernel kernel) {
+    const size_t dim = state.range(0);
+    const size_t bytes = dim * sizeof(ElementType);
+    const auto x = RandomVectors<uint8_t>(1, bytes, 1);
+    const auto y = RandomVectors<uint8_t>(kNy, bytes, 2);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j++) {
+                benchmark::DoNotOptimize(kernel(reinterpret_cast<const char*>(x.data()),
+                                                reinterpret_cast<const char*>(y.data() + j * bytes), dim,
+                                                sizeof(ElementType)));
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * bytes);
+}
+
+void
+BinarySearch(benchmark::State& state, bool eq) {
+    const size_t n = state.range(0);
+    std::vector<uint64_t> sorted(n);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    for (auto& v : sorted) {
+        v *= 3;
+    }
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> keys(kNy);
+    for (auto& k : keys) {
+        k = rng() % (3 * n);
+    }
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (auto key : keys) {
+                benchmark::DoNotOptimize(eq ? faiss::u64_binary_search_eq(sorted.data(), n, key)
+                                            : faiss::u64_binary_search_ge(sorted.data(), n, key));
+            }
+        }
+    }
+    SetProcessed(state, kNy, 0);
+}
+
+void
+Hash(benchmark::State& state) {
+    const size_t bytes = state.range(0) * sizeof(float);
+    const auto data = RandomVectors<uint8_t>(kNy, bytes, 1);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j++) {
+                benchmark::DoNotOptimize(
+                    faiss::calculate_hash(reinterpret_cast<const char*>(data.data() + j * bytes), bytes));
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * bytes);
+}
+
+void
+RaBitQ(benchmark::State& state, bool popcnt) {
+    const size_t dim = state.range(0);
+    const size_t code_size = (dim + 7) / 8;
+    // the query quantized to 4 bit planes
+    constexpr size_t kQueryBits = 4;
+    const auto q = RandomVectors<float>(1, dim, 1);
+    const auto q_bits = RandomVectors<uint8_t>(kQueryBits, code_size, 1);
+    const auto codes = RandomVectors<uint8_t>(kNy, code_size, 2);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j++) {
+                if (popcnt) {
+                    benchmark::DoNotOptimize(
+                        faiss::rabitq_dp_popcnt(q_bits.data(), codes.data() + j * code_size, dim, kQueryBits));
+                } else {
+                    benchmark::DoNotOptimize(faiss::fvec_masked_sum(q.data(), codes.data() + j * code_size, dim));
+                }
+            }
+        }
+    }
+    SetProcessed(state, kNy, kNy * code_size);
+}
+
+// the posting lists of the sparse index
+void
+BitpackedDeltaDecode(benchmark::State& state) {
+    const size_t n = state.range(0);
+    constexpr size_t kBits = 12;
+    // 8 bytes past the last packed delta are read
+    const auto data = RandomVectors<uint8_t>(1, (n * kBits + 7) / 8 + 8, 1);
+    std::vector<uint32_t> out(n);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            faiss::u32_bitpacked_delta_decode(data.data(), kBits, n, 0, out.data());
+            benchmark::DoNotOptimize(out.data());
+        }
+    }
+    SetProcessed(state, n, (n * kBits + 7) / 8);
+}
+
+void
+SparseIntersect(benchmark::State& state) {
+    const size_t n = state.range(0);
+    // elements of an id and a value, half of the ids in common
+    std::vector<uint32_t> a(2 * n), b(2 * n);
+    for (size_t i = 0; i < n; i++) {
+        a[2 * i] = 2 * i;
+        b[2 * i] = 3 * i;
+    }
+    std::vector<uint32_t> a_pos(n), b_pos(n);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(
+                faiss::u32_sparse_intersect(a.data(), n, b.data(), n, a_pos.data(), b_pos.data()));
+        }
+    }
+    SetProcessed(state, 2 * n, 2 * n * 2 * sizeof(uint32_t));
+}
+
+void
+Pq4FastScan(benchmark::State& state) {
+    // dim / 2 subquantizers of 4 bits
+    const size_t nbytes = state.range(0) / 4;
+    const size_t nb = kNy / 32;
+    const auto codes = RandomVectors<uint8_t>(nb * 32 + 1, nbytes, 1);
+    const auto lut = RandomVectors<uint8_t>(32, nbytes, 2);
+    std::vector<uint16_t> out(nb * 32);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            faiss::u8_pq4_fast_scan(codes.data(), nb, nbytes, lut.data(), out.data());
+            benchmark::DoNotOptimize(out.data());
+        }
+    }
+    SetProcessed(state, kNy, kNy * nbytes);
+}
+
+/*****************************************************************************/
+// heaps and result handlers
+
+// streams kNy distances into a max heap of range(0) results
+void
+HeapReplaceTop(benchmark::State& state) {
+    const size_t k = state.range(0);
+    const auto dis = RandomVectors<float>(kNy, 1, 1);
+    std::vector<float> heap_dis(k);
+    std::vector<int64_t> heap_ids(k);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            faiss::maxheap_heapify(k, heap_dis.data(), heap_ids.data());
+            for (size_t j = 0; j < kNy; j++) {
+                if (dis[j] < heap_dis[0]) {
+                    faiss::maxheap_replace_top(k, heap_dis.data(), heap_ids.data(), dis[j], j);
+                }
+            }
+            faiss::maxheap_reorder(k, heap_dis.data(), heap_ids.data());
+            benchmark::DoNotOptimize(heap_dis.data());
+        }
+    }
+    SetProcessed(state, kNy, kNy * sizeof(float));
+}
+
+// the block of range(0) queries by kNy distances of a brute force, into range(1) results per query
+void
+HeapBlockResultHandler(benchmark::State& state) {
+    const size_t nq = state.range(0);
+    const size_t k = state.range(1);
+    const auto dis = RandomVectors<float>(nq, kNy, 1);
+    std::vector<float> heap_dis(nq * k);
+    std::vector<int64_t> heap_ids(nq * k);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            faiss::HeapBlockResultHandler<faiss::CMax<float, int64_t>> handler(nq, heap_dis.data(), heap_ids.data(),
+                                                                               k);
+            handler.begin_multiple(0, nq);
+            handler.add_results(0, kNy, dis.data());
+            handler.end_multiple();
+            benchmark::DoNotOptimize(heap_dis.data());
+        }
+    }
+    SetProcessed(state, nq * kNy, nq * kNy * sizeof(float));
+}
+
+/*****************************************************************************/
+// bitsets, range(0) is the percentage of the rows filtered out
+
+std::vector<uint8_t>
+RandomBitset(size_t num_bits, int64_t filtered_percent) {
+    std::mt19937 rng(1);
+    std::vector<uint8_t> bits((num_bits + 7) / 8, 0);
+    for (size_t i = 0; i < num_bits; i++) {
+        if (static_cast<int64_t>(rng() % 100) < filtered_percent) {
+            bits[i >> 3] |= (1 << (i & 7));
+        }
+    }
+    return bits;
+}
+
+constexpr size_t kBitsetBits = 1 << 20;
+
+void
+BitsetCount(benchmark::State& state) {
+    const auto bits = RandomBitset(kBitsetBits, state.range(0));
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(knowhere::BitsetView(bits.data(), kBitsetBits).with_filtered_out_num().count());
+        }
+    }
+    SetProcessed(state, kBitsetBits, bits.size());
+}
+
+void
+BitsetTest(benchmark::State& state) {
+    const auto bits = RandomBitset(kBitsetBits, state.range(0));
+    const knowhere::BitsetView bitset(bits.data(), kBitsetBits);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            size_t valid = 0;
+            for (size_t i = 0; i < kBitsetBits; i++) {
+                valid += !bitset.test(i);
+            }
+            benchmark::DoNotOptimize(valid);
+        }
+    }
+    SetProcessed(state, kBitsetBits, bits.size());
+}
+
+void
+BitsetForEachValid(benchmark::State& state) {
+    const auto bits = RandomBitset(kBitsetBits, state.range(0));
+    const knowhere::BitsetView bitset(bits.data(), kBitsetBits);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            size_t sum = 0;
+            bitset.for_each_valid_index(0, kBitsetBits, [&](size_t i) { sum += i; });
+            benchmark::DoNotOptimize(sum);
+        }
+    }
+    SetProcessed(state, kBitsetBits, bits.size());
+}
+
+/*****************************************************************************/
+// SQ / PQ decoders, range(0) is the dim
+
+void
+SqDecode(benchmark::State& state, faiss::ScalarQuantizer::QuantizerType qtype) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<float>(kNy, dim, 1);
+    faiss::ScalarQuantizer sq(dim, qtype);
+    sq.train(kNy, x.data());
+    std::vector<uint8_t> codes(kNy * sq.code_size);
+    sq.compute_codes(x.data(), codes.data(), kNy);
+    std::vector<float> decoded(kNy * dim);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            sq.decode(codes.data(), decoded.data(), kNy);
+            benchmark::DoNotOptimize(decoded.data());
+        }
+    }
+    SetProcessed(state, kNy, codes.size());
+}
+
+void
+SqDistance(benchmark::State& state, faiss::ScalarQuantizer::QuantizerType qtype) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<float>(kNy, dim, 1);
+    const auto q = RandomVectors<float>(1, dim, 2);
+    faiss::ScalarQuantizer sq(dim, qtype);
+    sq.train(kNy, x.data());
+    std::vector<uint8_t> codes(kNy * sq.code_size);
+    sq.compute_codes(x.data(), codes.data(), kNy);
+    std::unique_ptr<faiss::ScalarQuantizer::SQDistanceComputer> dc(sq.get_distance_computer(faiss::METRIC_L2));
+    dc->set_query(q.data());
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            for (size_t j = 0; j < kNy; j++) {
+                benchmark::DoNotOptimize(dc->query_to_code(codes.data() + j * sq.code_size));
+            }
+        }
+    }
+    SetProcessed(state, kNy, codes.size());
+}
+
+// the setup runs again for every run of a benchmark, a few iterations of the kmeans are enough for the codes
+constexpr size_t kPqTrain = 256 * 4;
+
+faiss::ProductQuantizer
+TrainedPq(size_t dim, const float* x) {
+    faiss::ProductQuantizer pq(dim, dim / 8, 8);
+    pq.cp.niter = 5;
+    pq.cp.min_points_per_centroid = 4;
+    pq.train(kPqTrain, x);
+    return pq;
+}
+
+void
+PqDecode(benchmark::State& state) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<float>(kPqTrain, dim, 1);
+    auto pq = TrainedPq(dim, x.data());
+    std::vector<uint8_t> codes(kNy * pq.code_size);
+    pq.compute_codes(x.data(), codes.data(), kNy);
+    std::vector<float> decoded(kNy * dim);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            pq.decode(codes.data(), decoded.data(), kNy);
+            benchmark::DoNotOptimize(decoded.data());
+        }
+    }
+    SetProcessed(state, kNy, codes.size());
+}
+
+void
+PqDistanceTable(benchmark::State& state) {
+    const size_t dim = state.range(0);
+    const auto x = RandomVectors<float>(kPqTrain, dim, 1);
+    auto pq = TrainedPq(dim, x.data());
+    std::vector<float> table(pq.M * pq.ksub);
+    {
+        ScopedPerfCounters perf(state);
+        for (auto _ : state) {
+            pq.compute_distance_table(x.data(), table.data());
+            benchmark::DoNotOptimize(table.data());
+        }
+    }
+    SetProcessed(state, 1, pq.M * pq.ksub * pq.dsub * sizeof(float));
+}
+
+/*****************************************************************************/
+
+// the kernels that depend on the ISA, their names are prefixed with it
+std::map<std::string, BenchmarkFn>
+IsaKernels() {
+    using knowhere::bf16;
+    using knowhere::fp16;
+    std::map<std::string, BenchmarkFn> kernels;
+    // fp32
+    kernels["fvec_inner_product"] = [](auto& s) {
+        OneToOne<float>(s, [](auto x, auto y, auto d) { return faiss::fvec_inner_product(x, y, d); });
+    };
+    kernels["fvec_L2sqr"] = [](auto& s) {
+        OneToOne<float>(s, [](auto x, auto y, auto d) { return faiss::fvec_L2sqr(x, y, d); });
+    };
+    kernels["fvec_L1"] = [](auto& s) {
+        OneToOne<float>(s, [](auto x, auto y, auto d) { return faiss::fvec_L1(x, y, d); });
+    };
+    kernels["fvec_Linf"] = [](auto& s) {
+        OneToOne<float>(s, [](auto x, auto y, auto d) { return faiss::fvec_Linf(x, y, d); });
+    };
+    kernels["fvec_norm_L2sqr"] = [](auto& s) {
+        Norm<float>(s, [](auto y, auto d) { return faiss::fvec_norm_L2sqr(y, d); });
+    };
+    kernels["fvec_inner_product_batch_4"] = [](auto& s) {
+        Batch4<float>(s, [](auto... a) { faiss::fvec_inner_product_batch_4(a...); });
+    };
+    kernels["fvec_L2sqr_batch_4"] = [](auto& s) {
+        Batch4<float>(s, [](auto... a) { faiss::fvec_L2sqr_batch_4(a...); });
+    };
+    kernels["fvec_inner_product_batch_8"] = [](auto& s) {
+        Batch8<float>(s, [](auto... a) { faiss::fvec_inner_product_batch_8(a...); });
+    };
+    kernels["fvec_L2sqr_batch_8"] = [](auto& s) {
+        Batch8<float>(s, [](auto... a) { faiss::fvec_L2sqr_batch_8(a...); });
+    };
+    kernels["fvec_L2sqr_ny"] = [](auto& s) {
+        OneToMany<float>(s, [](auto x, auto y, auto d, auto dis, auto) { faiss::fvec_L2sqr_ny(dis, x, y, d, kNy); });
+    };
+    kernels["fvec_inner_products_ny"] = [](auto& s) {
+        OneToMany<float>(
+            s, [](auto x, auto y, auto d, auto dis, auto) { faiss::fvec_inner_products_ny(dis, x, y, d, kNy); });
+    };
+    kernels["fvec_L2sqr_ny_nearest"] = [](auto& s) {
+        OneToMany<float>(s, [](auto x, auto y, auto d, auto dis, auto ids) {
+            ids[0] = faiss::fvec_L2sqr_ny_nearest(dis, x, y, d, kNy);
+        });
+    };
+    kernels["fvec_L2sqr_ny_transposed"] = [](auto& s) {
+        Transposed(s, [](auto... a) {
+            faiss::fvec_L2sqr_ny_transposed(a...);
+            return 0;
+        });
+    };
+    kernels["fvec_L2sqr_ny_nearest_y_transposed"] = [](auto& s) {
+        Transposed(s, [](auto... a) { return faiss::fvec_L2sqr_ny_nearest_y_transposed(a...); });
+    };
+    kernels["fvec_L2sqr_ny_topk"] = [](auto& s) {
+        OneToMany<float>(s,
+                         [](auto x, auto y, auto d, auto dis, auto ids) {
+                             faiss::fvec_L2sqr_ny_topk(x, y, d, kNy, kTopk, dis, ids);
+                         });
+    };
+    kernels["fvec_madd"] = [](auto& s) { Madd(s, false); };
+    kernels["fvec_madd_and_argmin"] = [](auto& s) { Madd(s, true); };
+    // fp16
+    kernels["fp16_vec_inner_product"] = [](auto& s) {
+        OneToOne<fp16>(s, [](auto x, auto y, auto d) { return faiss::fp16_vec_inner_product(x, y, d); });
+    };
+    kernels["fp16_vec_L2sqr"] = [](auto& s) {
+        OneToOne<fp16>(s, [](auto x, auto y, auto d) { return faiss::fp16_vec_L2sqr(x, y, d); });
+    };
+    kernels["fp16_vec_norm_L2sqr"] = [](auto& s) {
+        Norm<fp16>(s, [](auto y, auto d) { return faiss::fp16_vec_norm_L2sqr(y, d); });
+    };
+    kernels["fp16_vec_inner_product_batch_4"] = [](auto& s) {
+        Batch4<fp16>(s, [](auto... a) { faiss::fp16_vec_inner_product_batch_4(a...); });
+    };
+    kernels["fp16_vec_L2sqr_batch_4"] = [](auto& s) {
+        Batch4<fp16>(s, [](auto... a) { faiss::fp16_vec_L2sqr_batch_4(a...); });
+    };
+    kernels["fp16_vec_inner_product_batch_8"] = [](auto& s) {
+        Batch8<fp16>(s, [](auto... a) { faiss::fp16_vec_inner_product_batch_8(a...); });
+    };
+    kernels["fp16_vec_L2sqr_batch_8"] = [](auto& s) {
+        Batch8<fp16>(s, [](auto... a) { faiss::fp16_vec_L2sqr_batch_8(a...); });
+    };
+    kernels["fp16_vec_L2sqr_ny_topk"] = [](auto& s) {
+        OneToMany<fp16>(s, [](auto x, auto y, auto d, auto dis, auto ids) {
+            faiss::fp16_vec_L2sqr_ny_topk(x, y, d, kNy, kTopk, dis, ids);
+        });
+    };
+    // bf16
+    kernels["bf16_vec_inner_product"] = [](auto& s) {
+        OneToOne<bf16>(s, [](auto x, auto y, auto d) { return faiss::bf16_vec_inner_product(x, y, d); });
+    };
+    kernels["bf16_vec_L2sqr"] = [](auto& s) {
+        OneToOne<bf16>(s, [](auto x, auto y, auto d) { return faiss::bf16_vec_L2sqr(x, y, d); });
+    };
+    kernels["bf16_vec_norm_L2sqr"] = [](auto& s) {
+        Norm<bf16>(s, [](auto y, auto d) { return faiss::bf16_vec_norm_L2sqr(y, d); });
+    };
+    kernels["bf16_vec_inner_product_batch_4"] = [](auto& s) {
+        Batch4<bf16>(s, [](auto... a) { faiss::bf16_vec_inner_product_batch_4(a...); });
+    };
+    kernels["bf16_vec_L2sqr_batch_4"] = [](auto& s) {
+        Batch4<bf16>(s, [](auto... a) { faiss::bf16_vec_L2sqr_batch_4(a...); });
+    };
+    kernels["bf16_vec_inner_product_batch_8"] = [](auto& s) {
+        Batch8<bf16>(s, [](auto... a) { faiss::bf16_vec_inner_product_batch_8(a...); });
+    };
+    kernels["bf16_vec_L2sqr_batch_8"] = [](auto& s) {
+        Batch8<bf16>(s, [](auto... a) { faiss::bf16_vec_L2sqr_batch_8(a...); });
+    };
+    kernels["bf16_vec_L2sqr_ny_topk"] = [](auto& s) {
+        OneToMany<bf16>(s, [](auto x, auto y, auto d, auto dis, auto ids) {
+            faiss::bf16_vec_L2sqr_ny_topk(x, y, d, kNy, kTopk, dis, ids);
+        });
+    };
+    // int8
+    kernels["int8_vec_inner_product"] = [](auto& s) {
+        OneToOne<int8_t>(s, [](auto x, auto y, auto d) { return faiss::int8_vec_inner_product(x, y, d); });
+    };
+    kernels["int8_vec_L2sqr"] = [](auto& s) {
+        OneToOne<int8_t>(s, [](auto x, auto y, auto d) { return faiss::int8_vec_L2sqr(x, y, d); });
+    };
+    kernels["int8_vec_norm_L2sqr"] = [](auto& s) {
+        Norm<int8_t>(s, [](auto y, auto d) { return faiss::int8_vec_norm_L2sqr(y, d); });
+    };
+    kernels["int8_vec_inner_product_batch_4"] = [](auto& s) {
+        Batch4<int8_t>(s, [](auto... a) { faiss::int8_vec_inner_product_batch_4(a...); });
+    };
+    kernels["int8_vec_L2sqr_batch_4"] = [](auto& s) {
+        Batch4<int8_t>(s, [](auto... a) { faiss::int8_vec_L2sqr_batch_4(a...); });
+    };
+    kernels["int8_vec_inner_product_batch_8"] = [](auto& s) {
+        Batch8<int8_t>(s, [](auto... a) { faiss::int8_vec_inner_product_batch_8(a...); });
+    };
+    kernels["int8_vec_L2sqr_batch_8"] = [](auto& s) {
+        Batch8<int8_t>(s, [](auto... a) { faiss::int8_vec_L2sqr_batch_8(a...); });
+    };
+    kernels["ivec_inner_product"] = [](auto& s) {
+        OneToOne<int8_t>(s, [](auto x, auto y, auto d) { return faiss::ivec_inner_product(x, y, d); });
+    };
+    kernels["ivec_L2sqr"] = [](auto& s) {
+        OneToOne<int8_t>(s, [](auto x, auto y, auto d) { return faiss::ivec_L2sqr(x, y, d); });
+    };
+    // binary, minhash, rabitq, sparse and pq
+    kernels["u8_hamming_distance_ny"] = [](auto& s) {
+        BinaryNy<int32_t>(s, [](auto... a) { faiss::u8_hamming_distance_ny(a...); });
+    };
+    kernels["u8_jaccard_distance_ny"] = [](auto& s) {
+        BinaryNy<float>(s, [](auto... a) { faiss::u8_jaccard_distance_ny(a...); });
+    };
+    kernels["u32_jaccard_distance"] = [](auto& s) {
+        MinHashJaccard<uint32_t>(s, [](auto... a) { return faiss::u32_jaccard_distance(a...); });
+    };
+    kernels["u64_jaccard_distance"] = [](auto& s) {
+        MinHashJaccard<uint64_t>(s, [](auto... a) { return faiss::u64_jaccard_distance(a...); });
+    };
+    kernels["u64_binary_search_eq"] = [](auto& s) { BinarySearch(s, true); };
+    kernels["u64_binary_search_ge"] = [](auto& s) { BinarySearch(s, false); };
+    kernels["calculate_hash"] = Hash;
+    kernels["fvec_masked_sum"] = [](auto& s) { RaBitQ(s, false); };
+    kernels["rabitq_dp_popcnt"] = [](auto& s) { RaBitQ(s, true); };
+    kernels["u32_bitpacked_delta_decode"] = BitpackedDeltaDecode;
+    kernels["u32_sparse_intersect"] = SparseIntersect;
+    kernels["u8_pq4_fast_scan"] = Pq4FastScan;
+    // quantizers
+    for (auto [name, qtype] : std::map<std::string, faiss::ScalarQuantizer::QuantizerType>{
+             {"sq8", faiss::ScalarQuantizer::QT_8bit},
+             {"sq4", faiss::ScalarQuantizer::QT_4bit},
+             {"sq6", faiss::ScalarQuantizer::QT_6bit},
+             {"sq_fp16", faiss::ScalarQuantizer::QT_fp16},
+             {"sq_bf16", faiss::ScalarQuantizer::QT_bf16}}) {
+        kernels[name + "_decode"] = [qtype = qtype](auto& s) { SqDecode(s, qtype); };
+        kernels[name + "_distance"] = [qtype = qtype](auto& s) { SqDistance(s, qtype); };
+    }
+    kernels["pq8_decode"] = PqDecode;
+    kernels["pq8_distance_table"] = PqDistanceTable;
+    return kernels;
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+    // the ISAs the cpu supports, by the name of the hooks they select
+    std::map<std::string, SimdType> isas;
+    for (auto isa : {SimdType::AVX512, SimdType::AVX2, SimdType::SSE4_2, SimdType::GENERIC}) {
+        isas.emplace(knowhere::KnowhereConfig::SetSimdType(isa), isa);
+    }
+    const auto kernels = IsaKernels();
+    for (const auto& [isa_name, isa] : isas) {
+        for (const auto& [kernel_name, fn] : kernels) {
+            auto* b = benchmark::RegisterBenchmark((isa_name + "/" + kernel_name).c_str(),
+                                                   [isa = isa, fn = fn](benchmark::State& state) {
+                                                       UseIsa(isa);
+                                                       fn(state);
+                                                   });
+            b->ArgName(kernel_name.rfind("u64_binary_search", 0) == 0 ? "n" : "dim");
+            for (auto dim : kDims) {
+                b->Arg(dim);
+            }
+        }
+    }
+    benchmark::RegisterBenchmark("heap/maxheap_replace_top", HeapReplaceTop)->ArgName("k")->Arg(10)->Arg(100);
+    benchmark::RegisterBenchmark("heap/HeapBlockResultHandler", HeapBlockResultHandler)
+        ->ArgNames({"nq", "k"})
+        ->ArgsProduct({{1, 16, 128}, {10, 100}});
+    for (auto [name, fn] : std::map<std::string, void (*)(benchmark::State&)>{
+             {"bitset/count", BitsetCount},
+             {"bitset/test", BitsetTest},
+             {"bitset/for_each_valid_index", BitsetForEachValid}}) {
+        benchmark::RegisterBenchmark(name.c_str(), fn)->ArgName("filtered_percent")->Arg(1)->Arg(50)->Arg(99);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// The hardware counters of the calling thread, read with perf_event_open(2) as one group so that they count over
+// the same instructions. They read 0 where perf events are not available, e.g. in containers without
+// CAP_PERFMON or with kernel.perf_event_paranoid > 2.
+class PerfCounters {
+ public:
+    enum Event { CYCLES = 0, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+    static constexpr std::array<const char*, NUM_EVENTS> kNames = {"cycles", "instructions", "cache_misses",
+                                                                   "branch_misses"};
+
+    PerfCounters() {
+#if defined(__linux__)
+        constexpr std::array<uint64_t, NUM_EVENTS> configs = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                              PERF_COUNT_HW_CACHE_MISSES,
+                                                              PERF_COUNT_HW_BRANCH_MISSES};
+        for (size_t i = 0; i < NUM_EVENTS; i++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = (i == 0);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds_[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+            if (fds_[i] < 0) {
+                Close();
+                return;
+            }
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+        Close();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters&
+    operator=(const PerfCounters&) = delete;
+
+    bool
+    Available() const {
+        return fds_[0] >= 0;
+    }
+
+    void
+    Start() {
+#if defined(__linux__)
+        if (Available()) {
+            ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    // the counts since Start()
+    std::array<uint64_t, NUM_EVENTS>
+    Stop() {
+        std::array<uint64_t, NUM_EVENTS> counts{};
+#if defined(__linux__)
+        if (Available()) {
+            ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            // nr followed by the values of the group
+            std::array<uint64_t, NUM_EVENTS + 1> buf{};
+            if (read(fds_[0], buf.data(), sizeof(buf)) == static_cast<ssize_t>(sizeof(buf))) {
+                for (size_t i = 0; i < NUM_EVENTS; i++) {
+                    counts[i] = buf[i + 1];
+                }
+            }
+        }
+#endif
+        return counts;
+    }
+
+ private:
+    void
+    Close() {
+#if defined(__linux__)
+        for (auto& fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+#endif
+    }
+
+    std::array<long, NUM_EVENTS> fds_ = {-1, -1, -1, -1};
+};
+
+// Counts the hardware events of the timed loop of a benchmark and reports them per iteration, along with the
+// instructions per cycle. Created right before `for (auto _ : state)`, so that the setup is left out.
+class ScopedPerfCounters {
+ public:
+    explicit ScopedPerfCounters(benchmark::State& state) : state_(state) {
+        counters_.Start();
+    }
+
+    ~ScopedPerfCounters() {
+        const auto counts = counters_.Stop();
+        if (!counters_.Available()) {
+            return;
+        }
+        for (size_t i = 0; i < PerfCounters::NUM_EVENTS; i++) {
+            state_.counters[PerfCounters::kNames[i]] =
+                benchmark::Counter(static_cast<double>(counts[i]), benchmark::Counter::kAvgIterations);
+        }
+        if (counts[PerfCounters::CYCLES] > 0) {
+            state_.counters["ipc"] =
+                static_cast<double>(counts[PerfCounters::INSTRUCTIONS]) / counts[PerfCounters::CYCLES];
+        }
+    }
+
+ private:
+    benchmark::State& state_;
+    PerfCounters counters_;
+};
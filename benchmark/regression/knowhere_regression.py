@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+# Copyright (C) 2019-2024 Zilliz. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software distributed under the License
+# is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+# or implied. See the License for the specific language governing permissions and limitations under the License.
+
+"""Performance regression harness of the hdf5 benchmarks.
+
+  run      runs the benchmark matrix (tests x datasets) a few times and writes the results as JSON
+  parse    converts the logs of the benchmarks, e.g. the ones of ref_logs, to the same JSON
+  compare  compares results with a baseline and writes a report, exits with 1 on a regression
+
+The search points of a test (nprobe, ef, ... as the benchmarks sweep them) are parsed from their log lines, so the
+benchmarks are run unchanged:
+
+  ./knowhere_regression.py run --bin-dir ../../build/Release/benchmark --matrix matrix.json --out current.json
+  ./knowhere_regression.py compare --baseline baselines/v2.5.json --current current.json --report report.md
+"""
+
+import argparse
+import datetime
+import glob
+import json
+import math
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+
+# "[12.345 s] sift-128-euclidean | IVF_FLAT(fp32) | nlist=1024"
+HEADER_RE = re.compile(r"^\[\s*[\d.]+ s\] (?P<dataset>[^|]+?) \| (?P<index>[^(|]+)\((?P<dtype>[^)]*)\)"
+                       r"\s*(?:\|(?P<params>.*))?$")
+BUILD_RE = re.compile(r"^Build index (?P<index>\S+) time: (?P<seconds>[\d.]+)s")
+PAIR_RE = re.compile(r"([A-Za-z_][\w]*|[A-Z]@\d*)\s*=\s*(-?[\d.]+)(%|ms|s|MB)?")
+
+# the fields of a result line that are measured, the others are the params of its search point
+METRIC_FIELDS = {"elapse", "QPS", "VPS", "p50", "p90", "p99", "p999", "load"}
+HIGHER_IS_BETTER = {"qps": True, "recall": True, "build_time": False}
+
+
+def parse_log(text, test=""):
+    """the records of the log of a benchmark run, one per search point"""
+    records = []
+    header = None
+    build_time = {}
+    for line in text.splitlines():
+        m = BUILD_RE.match(line.strip())
+        if m:
+            build_time[m.group("index")] = float(m.group("seconds"))
+            continue
+        m = HEADER_RE.match(line.strip())
+        if m:
+            header = {
+                "dataset": m.group("dataset").strip(),
+                "index": m.group("index").strip(),
+                "data_type": m.group("dtype").strip(),
+                "index_params": {k: float(v) for k, v, _ in PAIR_RE.findall(m.group("params") or "")},
+            }
+            continue
+        if header is None or not line.startswith("  ") or "=" not in line:
+            continue
+        pairs = PAIR_RE.findall(line)
+        fields = {k: float(v) for k, v, _ in pairs}
+        if "elapse" not in fields and "QPS" not in fields:
+            continue
+        params = {k: v for k, v in fields.items() if k not in METRIC_FIELDS and "@" not in k}
+        # the non-numeric params, e.g. the config dumps of the pareto benchmark
+        prefix = line.strip().split(", ")[0]
+        if "=" not in prefix:
+            params["point"] = prefix
+        metrics = {}
+        if "QPS" in fields:
+            metrics["qps"] = fields["QPS"]
+        elif "VPS" in fields:
+            metrics["qps"] = fields["VPS"]
+        elif fields.get("elapse", 0) > 0 and "nq" in fields:
+            metrics["qps"] = fields["nq"] / fields["elapse"]
+        recall = [v for k, v in fields.items() if k.startswith("R@")]
+        if recall:
+            metrics["recall"] = recall[0]
+        for p in ("p50", "p99"):
+            if p in fields:
+                metrics[p + "_ms"] = fields[p]
+        if header["index"] in build_time:
+            metrics["build_time"] = build_time[header["index"]]
+        records.append({
+            "test": test,
+            "dataset": header["dataset"],
+            "index": header["index"],
+            "data_type": header["data_type"],
+            "index_params": header["index_params"],
+            "params": params,
+            "metrics": metrics,
+        })
+    return records
+
+
+def format_param(v):
+    return ("%g" % v) if isinstance(v, float) else v
+
+
+def record_key(record):
+    params = ",".join("%s=%s" % (k, format_param(record["params"][k])) for k in sorted(record["params"]))
+    index_params = ",".join("%s=%g" % (k, record["index_params"][k]) for k in sorted(record["index_params"]))
+    return "%s|%s|%s(%s)|%s|%s" % (record["test"], record["dataset"], record["index"], record["data_type"],
+                                   index_params, params)
+
+
+def aggregate(runs):
+    """merges the records of repeated runs, every metric keeps its samples, mean and stddev"""
+    merged = {}
+    for records in runs:
+        for record in records:
+            key = record_key(record)
+            entry = merged.setdefault(key, dict({k: v for k, v in record.items() if k != "metrics"}, metrics={}))
+            for name, value in record["metrics"].items():
+                entry["metrics"].setdefault(name, {"samples": []})["samples"].append(value)
+    for entry in merged.values():
+        for metric in entry["metrics"].values():
+            samples = metric["samples"]
+            metric["mean"] = statistics.fmean(samples)
+            metric["stddev"] = statistics.stdev(samples) if len(samples) > 1 else 0.0
+    return [dict(merged[k], key=k) for k in sorted(merged)]
+
+
+def environment():
+    env = {
+        "date": datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="seconds"),
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "cpu_count": os.cpu_count(),
+    }
+    try:
+        with open("/proc/cpuinfo") as f:
+            models = [line.split(":", 1)[1].strip() for line in f if line.startswith("model name")]
+        if models:
+            env["cpu"] = models[0]
+    except OSError:
+        pass
+    try:
+        env["commit"] = subprocess.check_output(["git", "rev-parse", "HEAD"], text=True,
+                                                stderr=subprocess.DEVNULL).strip()
+    except (OSError, subprocess.CalledProcessError):
+        pass
+    return env
+
+
+def run(args):
+    with open(args.matrix) as f:
+        matrix = json.load(f)
+    runs = []
+    for repeat in range(args.repeat):
+        records = []
+        for test in matrix["tests"]:
+            for dataset in test.get("datasets", matrix.get("datasets", [""])):
+                if args.rebuild and repeat == 0:
+                    # the benchmarks load the indexes they wrote before, their build is only timed without them
+                    for path in glob.glob(os.path.join(args.work_dir, "*.index")):
+                        os.remove(path)
+                env = dict(os.environ)
+                if dataset:
+                    env["KNOWHERE_BENCHMARK_DATASET"] = dataset
+                cmd = [os.path.join(args.bin_dir, test["binary"]), "--gtest_filter=" + test["filter"]]
+                print("[%d/%d] %s %s" % (repeat + 1, args.repeat, " ".join(cmd), dataset), file=sys.stderr)
+                proc = subprocess.run(cmd, cwd=args.work_dir, env=env, text=True, stdout=subprocess.PIPE,
+                                      stderr=subprocess.STDOUT)
+                if args.log_dir:
+                    os.makedirs(args.log_dir, exist_ok=True)
+                    name = "%s-%s-%d.log" % (test["name"], dataset or "default", repeat)
+                    with open(os.path.join(args.log_dir, name), "w") as f:
+                        f.write(proc.stdout)
+                if proc.returncode != 0:
+                    print("  failed with exit code %d" % proc.returncode, file=sys.stderr)
+                records += parse_log(proc.stdout, test["name"])
+        runs.append(records)
+    write_results(args.out, runs)
+
+
+def parse(args):
+    runs = []
+    for path in args.logs:
+        with open(path) as f:
+            test = os.path.splitext(os.path.basename(path))[0]
+            runs.append(parse_log(f.read(), args.test or test))
+    # every log is a run of its own test, not a repetition
+    write_results(args.out, [[r for records in runs for r in records]])
+
+
+def write_results(path, runs):
+    results = {"environment": environment(), "repeat": len(runs), "records": aggregate(runs)}
+    with open(path, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+    print("wrote %d records to %s" % (len(results["records"]), path), file=sys.stderr)
+
+
+def compare_metric(name, base, cur, args):
+    """the relative change of a metric and whether it is a significant regression"""
+    higher_is_better = HIGHER_IS_BETTER.get(name, False)
+    b, c = base["mean"], cur["mean"]
+    if name == "recall":
+        # recall is deterministic up to the threading of the builds, an absolute threshold
+        change = c - b
+        return change, (b - c if higher_is_better else c - b) > args.recall_threshold
+    if b == 0:
+        return 0.0, False
+    change = (c - b) / b
+    worse = -change if higher_is_better else change
+    threshold = args.build_threshold if name == "build_time" else args.qps_threshold
+    if worse <= threshold:
+        return change, False
+    # with repetitions, the change must also be out of the noise: Welch's t statistic against z
+    nb, nc = len(base["samples"]), len(cur["samples"])
+    if nb > 1 and nc > 1:
+        se = math.sqrt(base["stddev"] ** 2 / nb + cur["stddev"] ** 2 / nc)
+        if se > 0 and abs(c - b) / se < args.z:
+            return change, False
+    return change, True
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+    base_records = {r["key"]: r for r in baseline["records"]}
+    rows, regressions = [], []
+    # the build time of an index is the same for all its search points, it is compared once
+    builds = set()
+    for record in current["records"]:
+        base = base_records.pop(record["key"], None)
+        if base is None:
+            continue
+        for name in ("qps", "recall", "build_time"):
+            if name not in record["metrics"] or name not in base["metrics"]:
+                continue
+            if name == "build_time":
+                build = record["key"].rsplit("|", 1)[0]
+                if build in builds:
+                    continue
+                builds.add(build)
+            change, regressed = compare_metric(name, base["metrics"][name], record["metrics"][name], args)
+            row = (record["key"], name, base["metrics"][name]["mean"], record["metrics"][name]["mean"], change,
+                   regressed)
+            rows.append(row)
+            if regressed:
+                regressions.append(row)
+    missing = sorted(base_records)
+
+    def fmt(row):
+        key, name, b, c, change, regressed = row
+        change_str = ("%+.4f" % change) if name == "recall" else ("%+.1f%%" % (100 * change))
+        return "| %s | %s | %.4g | %.4g | %s | %s |" % (key, name, b, c, change_str,
+                                                         "**REGRESSION**" if regressed else "")
+
+    lines = ["# Knowhere performance regression report", "",
+             "baseline: %s (%s)" % (args.baseline, baseline["environment"].get("commit", "unknown commit")),
+             "current: %s (%s)" % (args.current, current["environment"].get("commit", "unknown commit")), "",
+             "thresholds: qps %.1f%%, build time %.1f%%, recall %.4f, z %.1f" %
+             (100 * args.qps_threshold, 100 * args.build_threshold, args.recall_threshold, args.z), "",
+             "%d comparisons, %d regressions, %d baseline points not run" % (len(rows), len(regressions),
+                                                                             len(missing)), ""]
+    header = ["| point | metric | baseline | current | change | |", "|---|---|---|---|---|---|"]
+    if regressions:
+        lines += ["## Regressions", ""] + header + [fmt(r) for r in regressions] + [""]
+    lines += ["## All points", ""] + header + [fmt(r) for r in rows] + [""]
+    if missing:
+        lines += ["## Baseline points not run", ""] + ["- " + k for k in missing] + [""]
+    report = "\n".join(lines)
+    if args.report:
+        with open(args.report, "w") as f:
+            f.write(report)
+    else:
+        print(report)
+    print("%d regressions" % len(regressions), file=sys.stderr)
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("run", help="run the benchmark matrix")
+    p.add_argument("--bin-dir", required=True, help="the directory of the benchmark binaries")
+    p.add_argument("--matrix", required=True, help="the JSON of the tests and datasets to run")
+    p.add_argument("--work-dir", default=".", help="where the hdf5 files are and the indexes are written")
+    p.add_argument("--repeat", type=int, default=3)
+    p.add_argument("--log-dir", help="keeps the logs of the runs")
+    p.add_argument("--rebuild", action="store_true",
+                   help="removes the index files of the work dir before the first run of a test to time its builds")
+    p.add_argument("--out", required=True)
+
+    p = sub.add_parser("parse", help="convert benchmark logs to results")
+    p.add_argument("logs", nargs="+")
+    p.add_argument("--test", help="the test of the logs, by default their file names")
+    p.add_argument("--out", required=True)
+
+    p = sub.add_parser("compare", help="compare results with a baseline")
+    p.add_argument("--baseline", required=True)
+    p.add_argument("--current", required=True)
+    p.add_argument("--qps-threshold", type=float, default=0.05, help="relative QPS drop flagged")
+    p.add_argument("--build-threshold", type=float, default=0.10, help="relative build time increase flagged")
+    p.add_argument("--recall-threshold", type=float, default=0.005, help="absolute recall drop flagged")
+    p.add_argument("--z", type=float, default=2.0, help="significance of a change between repeated runs")
+    p.add_argument("--report", help="the markdown report, printed by default")
+
+    args = parser.parse_args()
+    if args.command == "run":
+        run(args)
+    elif args.command == "parse":
+        parse(args)
+    else:
+        sys.exit(compare(args))
+
+
+if __name__ == "__main__":
+    main()
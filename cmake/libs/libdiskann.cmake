@@ -14,10 +14,12 @@ set(DISKANN_SOURCES
     thirdparty/DiskANN/src/distance.cpp
     thirdparty/DiskANN/src/index.cpp
     thirdparty/DiskANN/src/linux_aligned_file_reader.cpp
+    thirdparty/DiskANN/src/linux_uring_file_reader.cpp
     thirdparty/DiskANN/src/math_utils.cpp
     thirdparty/DiskANN/src/memory_mapper.cpp
     thirdparty/DiskANN/src/partition_and_pq.cpp
     thirdparty/DiskANN/src/pq_flash_index.cpp
+    thirdparty/DiskANN/src/remote_sector_reader.cpp
     thirdparty/DiskANN/src/logger.cpp
     thirdparty/DiskANN/src/utils.cpp)
 
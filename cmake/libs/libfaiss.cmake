@@ -32,23 +32,32 @@ if(__X86_64)
   set(UTILS_AVX_SRC src/simd/distances_avx.cc)
   set(UTILS_AVX512_SRC src/simd/distances_avx512.cc)
   set(UTILS_AVX512ICX_SRC src/simd/distances_avx512icx.cc)
+  set(UTILS_AVX512BF16_SRC src/simd/distances_avx512bf16.cc)
+  set(UTILS_AMX_SRC src/simd/distances_amx.cc)
 
   add_library(utils_sse OBJECT ${UTILS_SSE_SRC})
   add_library(utils_avx OBJECT ${UTILS_AVX_SRC})
   add_library(utils_avx512 OBJECT ${UTILS_AVX512_SRC})
   add_library(utils_avx512icx OBJECT ${UTILS_AVX512ICX_SRC})
+  add_library(utils_avx512bf16 OBJECT ${UTILS_AVX512BF16_SRC})
+  add_library(utils_amx OBJECT ${UTILS_AMX_SRC})
 
   target_compile_options(utils_sse PRIVATE -msse4.2 -mpopcnt)
   target_compile_options(utils_avx PRIVATE -mfma -mf16c -mavx2 -mpopcnt)
   target_compile_options(utils_avx512 PRIVATE -mfma -mf16c -mavx512f -mavx512dq
                                               -mavx512bw -mpopcnt -mavx512vl)
   target_compile_options(utils_avx512icx PRIVATE -mfma -mf16c -mavx512f -mavx512dq
-                                              -mavx512bw -mpopcnt -mavx512vl -mavx512vpopcntdq)
+                                              -mavx512bw -mpopcnt -mavx512vl -mavx512vpopcntdq
+                                              -mavx512vnni)
+  target_compile_options(utils_avx512bf16 PRIVATE -mfma -mf16c -mavx512f -mavx512dq
+                                              -mavx512bw -mavx512vl -mavx512bf16)
+  target_compile_options(utils_amx PRIVATE -mamx-tile -mamx-int8 -mamx-bf16)
 
   add_library(
     knowhere_utils STATIC
     ${UTILS_SRC} $<TARGET_OBJECTS:utils_sse> $<TARGET_OBJECTS:utils_avx>
-    $<TARGET_OBJECTS:utils_avx512> $<TARGET_OBJECTS:utils_avx512icx>)
+    $<TARGET_OBJECTS:utils_avx512> $<TARGET_OBJECTS:utils_avx512icx>
+    $<TARGET_OBJECTS:utils_avx512bf16> $<TARGET_OBJECTS:utils_amx>)
   target_link_libraries(knowhere_utils PUBLIC glog::glog)
   target_link_libraries(knowhere_utils PUBLIC xxHash::xxhash)
 endif()
@@ -133,6 +142,9 @@ endif()
 if(__RISCV64)
   set(UTILS_SRC src/simd/hook.cc src/simd/distances_ref.cc src/simd/distances_rvv.cc)
   add_library(knowhere_utils STATIC ${UTILS_SRC})
+  # the rest of knowhere_utils must run on the cores without the vector
+  # extension, which the hook checks at runtime
+  set_source_files_properties(src/simd/distances_rvv.cc PROPERTIES COMPILE_OPTIONS "-march=rv64gcv")
   target_link_libraries(knowhere_utils PUBLIC glog::glog)
   target_link_libraries(knowhere_utils PUBLIC xxHash::xxhash)
 endif()
@@ -118,6 +118,7 @@ class KnowhereConan(ConanFile):
         if self.options.with_benchmark:
             self.requires("gtest/1.13.0")
             self.requires("hdf5/1.14.0")
+            self.requires("benchmark/1.8.3")
         if self.options.with_faiss_tests:
             self.requires("gtest/1.13.0")
 
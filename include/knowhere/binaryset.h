@@ -20,14 +20,45 @@
 
 namespace knowhere {
 
+struct BinaryChunk {
+    std::shared_ptr<uint8_t[]> data;
+    int64_t size = 0;
+};
+
 struct Binary {
     std::shared_ptr<uint8_t[]> data;
     int64_t size = 0;
+    // the pieces of a binary kept as it was serialized, data is null while they are set
+    std::vector<BinaryChunk> chunks;
+
+    bool
+    IsChunked() const {
+        return data == nullptr && !chunks.empty();
+    }
+
+    // copies the chunks into data, each chunk is released once it is copied so that the peak memory stays close to
+    //   the size of the binary
+    void
+    Flatten() {
+        if (!IsChunked()) {
+            return;
+        }
+        std::shared_ptr<uint8_t[]> flat(new uint8_t[size]);
+        int64_t offset = 0;
+        for (auto& chunk : chunks) {
+            std::memcpy(flat.get() + offset, chunk.data.get(), chunk.size);
+            offset += chunk.size;
+            chunk.data.reset();
+        }
+        chunks.clear();
+        data = std::move(flat);
+    }
 };
 using BinaryPtr = std::shared_ptr<Binary>;
 
 inline uint8_t*
 CopyBinary(const BinaryPtr& bin) {
+    bin->Flatten();
     uint8_t* newdata = new uint8_t[bin->size];
     std::memcpy(newdata, bin->data.get(), bin->size);
     return newdata;
@@ -35,10 +66,13 @@ CopyBinary(const BinaryPtr& bin) {
 
 class BinarySet {
  public:
+    // a chunked binary is flattened here, the callers that can take the chunks read binary_map_
     BinaryPtr
     GetByName(const std::string& name) const {
         if (Contains(name)) {
-            return binary_map_.at(name);
+            const auto& binary = binary_map_.at(name);
+            binary->Flatten();
+            return binary;
         }
         return nullptr;
     }
@@ -49,7 +83,7 @@ class BinarySet {
     GetByNames(const std::vector<std::string>& names) const {
         for (auto& name : names) {
             if (Contains(name)) {
-                return binary_map_.at(name);
+                return GetByName(name);
             }
         }
         return nullptr;
@@ -68,6 +102,42 @@ class BinarySet {
         binary_map_[name] = std::move(binary);
     }
 
+    // the binary is kept in chunks if KeepChunks() is set, otherwise it is flattened
+    void
+    AppendChunks(const std::string& name, std::vector<BinaryChunk> chunks, int64_t size) {
+        auto binary = std::make_shared<Binary>();
+        binary->chunks = std::move(chunks);
+        binary->size = size;
+        if (!keep_chunks_) {
+            binary->Flatten();
+        }
+        binary_map_[name] = std::move(binary);
+    }
+
+    // whether the binaries serialized in chunks stay in chunks, for the callers that write binary_map_ out chunk by
+    //   chunk instead of reading data
+    void
+    SetKeepChunks(bool keep_chunks) {
+        keep_chunks_ = keep_chunks;
+    }
+
+    bool
+    KeepChunks() const {
+        return keep_chunks_;
+    }
+
+    // the zlib level Index::Serialize() compresses the binaries with, see CompressBinarySet(). 0, the default, leaves
+    //   them uncompressed. Index::Deserialize() restores compressed binaries whatever the level.
+    void
+    SetCompressionLevel(int level) {
+        compression_level_ = level;
+    }
+
+    int
+    CompressionLevel() const {
+        return compression_level_;
+    }
+
     BinaryPtr
     Erase(const std::string& name) {
         BinaryPtr result = nullptr;
@@ -103,6 +173,10 @@ class BinarySet {
 
  public:
     std::map<std::string, BinaryPtr> binary_map_;
+
+ private:
+    bool keep_chunks_ = false;
+    int compression_level_ = 0;
 };
 
 using BinarySetPtr = std::shared_ptr<BinarySet>;
@@ -12,12 +12,54 @@
 #ifndef BITSET_H
 #define BITSET_H
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace knowhere {
+// Statistics of a bitmap, computed once where the bitmap is built and shared by its views, so that the count, the first
+// and last valid rows and the fully filtered out blocks are not found again by every search of every segment.
+struct BitsetStats {
+    static constexpr size_t kBlockBits = 4096;
+
+    size_t filtered_out_num = 0;
+    // num_bits if every row is filtered out
+    size_t first_valid_index = 0;
+    size_t last_valid_index = 0;
+    // the filtered out rows of each block of kBlockBits rows, the last block may be shorter
+    std::vector<uint32_t> block_filtered_out;
+
+    static BitsetStats
+    Compute(const uint8_t* bits, size_t num_bits) {
+        BitsetStats stats;
+        stats.first_valid_index = num_bits;
+        stats.last_valid_index = num_bits;
+        stats.block_filtered_out.resize((num_bits + kBlockBits - 1) / kBlockBits, 0);
+        for (size_t i = 0; i < num_bits; i += 8) {
+            const size_t n = std::min<size_t>(8, num_bits - i);
+            const uint8_t byte = bits[i >> 3] & ((0x1u << n) - 1);
+            stats.block_filtered_out[i / kBlockBits] += __builtin_popcount(byte);
+            const uint8_t valid = ~byte & ((0x1u << n) - 1);
+            if (valid != 0) {
+                if (stats.first_valid_index == num_bits) {
+                    stats.first_valid_index = i + __builtin_ctz(valid);
+                }
+                stats.last_valid_index = i + 31 - __builtin_clz(valid);
+            }
+        }
+        for (const auto n : stats.block_filtered_out) {
+            stats.filtered_out_num += n;
+        }
+        return stats;
+    }
+};
+
+// A view of the rows a filter lets pass, by default a dense bitmap whose set bits are filtered out. For the filters
+// that let a few rows pass, or a few fail, it can view a sorted list of row ids instead, whose count() is known and
+// whose valid rows are iterated without scanning the whole bitmap.
 class BitsetView {
  public:
     BitsetView() = default;
@@ -30,6 +72,38 @@ class BitsetView {
     BitsetView(const std::nullptr_t) : BitsetView() {
     }
 
+    // the rows of ids[0..num_ids), sorted and unique, pass and the other rows of num_bits are filtered out
+    static BitsetView
+    FromValidIds(const int64_t* ids, size_t num_ids, size_t num_bits) {
+        return BitsetView(ids, num_ids, num_bits, true);
+    }
+
+    // the rows of ids[0..num_ids), sorted and unique, are filtered out
+    static BitsetView
+    FromFilteredOutIds(const int64_t* ids, size_t num_ids, size_t num_bits) {
+        return BitsetView(ids, num_ids, num_bits, false);
+    }
+
+    // a bitmap with the statistics of it, which must outlive the view
+    static BitsetView
+    WithStats(const uint8_t* data, size_t num_bits, const BitsetStats* stats) {
+        BitsetView view(data, num_bits, stats->filtered_out_num);
+        view.stats_ = stats;
+        return view;
+    }
+
+    // nullptr if none were supplied
+    const BitsetStats*
+    stats() const {
+        return stats_;
+    }
+
+    // whether data() holds the bits, they are nullptr for an id list
+    bool
+    is_bitmap() const {
+        return !id_list_;
+    }
+
     bool
     empty() const {
         return num_bits_ == 0;
@@ -52,10 +126,22 @@ class BitsetView {
 
     bool
     test(int64_t index) const {
+        if (id_list_) {
+            return (index >= static_cast<int64_t>(num_bits_)) ||
+                   (std::binary_search(ids_, ids_ + num_ids_, index) != ids_valid_);
+        }
         // when index is larger than the max_offset, ignore it
         return (index >= static_cast<int64_t>(num_bits_)) || (bits_[index >> 3] & (0x1 << (index & 0x7)));
     }
 
+    // a hint that test(index) follows, so that the tests of a batch of indices overlap their cache misses
+    void
+    prefetch(int64_t index) const {
+        if (!id_list_ && index < static_cast<int64_t>(num_bits_)) {
+            __builtin_prefetch(bits_ + (index >> 3));
+        }
+    }
+
     size_t
     count() const {
         return filtered_out_num_;
@@ -66,8 +152,20 @@ class BitsetView {
         return empty() ? 0.0f : ((float)filtered_out_num_ / num_bits_);
     }
 
+    // the view with count() computed from the bits, an id list knows its own
+    BitsetView
+    with_filtered_out_num() const {
+        return (is_bitmap() && stats_ == nullptr) ? BitsetView(bits_, num_bits_, get_filtered_out_num_()) : *this;
+    }
+
     size_t
     get_filtered_out_num_() const {
+        if (id_list_) {
+            return filtered_out_num_;
+        }
+        if (stats_ != nullptr) {
+            return stats_->filtered_out_num;
+        }
         size_t ret = 0;
         auto len_uint8 = byte_size();
         auto len_uint64 = len_uint8 >> 3;
@@ -97,6 +195,20 @@ class BitsetView {
 
     size_t
     get_first_valid_index() const {
+        if (id_list_ && ids_valid_) {
+            return num_ids_ > 0 ? std::min<size_t>(ids_[0], num_bits_) : num_bits_;
+        }
+        if (id_list_) {
+            // the first gap of the filtered out ids
+            size_t i = 0;
+            while (i < num_ids_ && ids_[i] == static_cast<int64_t>(i)) {
+                i++;
+            }
+            return std::min(i, num_bits_);
+        }
+        if (stats_ != nullptr) {
+            return stats_->first_valid_index;
+        }
         size_t ret = 0;
         auto len_uint8 = byte_size();
         auto len_uint64 = len_uint8 >> 3;
@@ -127,6 +239,63 @@ class BitsetView {
         return num_bits_;
     }
 
+    // calls f(index) for every index in [from, to) that is not filtered out, in increasing order. The bits are read
+    // 64 at a time, the words whose bits are all set are skipped without testing them one by one, and so are the
+    // blocks the statistics tell are filtered out. The valid ids of an id list are visited directly.
+    template <typename F>
+    void
+    for_each_valid_index(size_t from, size_t to, F&& f) const {
+        to = std::min<size_t>(to, num_bits_);
+        if (id_list_) {
+            const int64_t* it = std::lower_bound(ids_, ids_ + num_ids_, static_cast<int64_t>(from));
+            const int64_t* end = ids_ + num_ids_;
+            if (ids_valid_) {
+                for (; it != end && static_cast<size_t>(*it) < to; it++) {
+                    f(static_cast<size_t>(*it));
+                }
+                return;
+            }
+            for (size_t i = from; i < to; i++) {
+                if (it != end && static_cast<size_t>(*it) == i) {
+                    it++;
+                } else {
+                    f(i);
+                }
+            }
+            return;
+        }
+        if (stats_ != nullptr) {
+            to = std::min(to, stats_->last_valid_index + 1);
+        }
+        size_t i = from;
+        for (; i < to && (i & 63) != 0; i++) {
+            if (!test(i)) {
+                f(i);
+            }
+        }
+
+        const uint64_t* p_uint64 = (const uint64_t*)bits_;
+        for (; i + 64 <= to; i += 64) {
+            if (stats_ != nullptr && (i % BitsetStats::kBlockBits) == 0 &&
+                stats_->block_filtered_out[i / BitsetStats::kBlockBits] == BitsetStats::kBlockBits) {
+                i += BitsetStats::kBlockBits - 64;
+                continue;
+            }
+            uint64_t value = (~p_uint64[i >> 6]);
+            while (value != 0) {
+                f(i + __builtin_ctzll(value));
+                value &= value - 1;
+            }
+        }
+
+        // calculate remainder
+        for (; i < to; i++) {
+            if (!test(i)) {
+                f(i);
+            }
+        }
+    }
+
     std::string
     to_string(size_t from, size_t to) const {
         if (empty()) {
@@ -140,10 +309,45 @@ class BitsetView {
         return buf.str();
     }
 
+    // writes the bits of the view to out, byte_size() bytes, for the code that needs a bitmap
+    void
+    copy_bits(uint8_t* out) const {
+        if (!id_list_) {
+            std::copy_n(bits_, byte_size(), out);
+            return;
+        }
+        std::fill_n(out, byte_size(), ids_valid_ ? 0xFF : 0x00);
+        for (size_t i = 0; i < num_ids_; i++) {
+            const size_t id = ids_[i];
+            if (id < num_bits_) {
+                out[id >> 3] ^= (0x1 << (id & 0x7));
+            }
+        }
+        if (ids_valid_ && (num_bits_ & 0x7) != 0) {
+            out[byte_size() - 1] &= (0x1 << (num_bits_ & 0x7)) - 1;
+        }
+    }
+
  private:
+    BitsetView(const int64_t* ids, size_t num_ids, size_t num_bits, bool ids_valid)
+        : num_bits_(num_bits),
+          filtered_out_num_(ids_valid ? num_bits - std::min(num_ids, num_bits) : std::min(num_ids, num_bits)),
+          id_list_(true),
+          ids_(ids),
+          num_ids_(num_ids),
+          ids_valid_(ids_valid) {
+    }
+
     const uint8_t* bits_ = nullptr;
     size_t num_bits_ = 0;
     size_t filtered_out_num_ = 0;
+    // of bits_, not owned
+    const BitsetStats* stats_ = nullptr;
+    // a sorted id list instead of bits_, of the valid rows if ids_valid_, of the filtered out ones otherwise
+    bool id_list_ = false;
+    const int64_t* ids_ = nullptr;
+    size_t num_ids_ = 0;
+    bool ids_valid_ = false;
 };
 }  // namespace knowhere
 
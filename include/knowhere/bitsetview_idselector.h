@@ -30,6 +30,11 @@ struct BitsetViewIDSelector final : faiss::IDSelector {
         // it is by design that bitset_view.empty() is not tested here
         return (!bitset_view.test(id + id_offset));
     }
+
+    inline void
+    prefetch(faiss::idx_t id) const {
+        bitset_view.prefetch(id + id_offset);
+    }
 };
 
 struct BitsetViewWithMappingIDSelector final : faiss::IDSelector {
@@ -47,6 +52,12 @@ struct BitsetViewWithMappingIDSelector final : faiss::IDSelector {
         // it is by design that out_id_mapping == nullptr is not tested here
         return (!bitset_view.test(out_id_mapping[id + id_offset]));
     }
+
+    // the mapping is read right away, the loads of a batch of ids still overlap
+    inline void
+    prefetch(faiss::idx_t id) const {
+        bitset_view.prefetch(out_id_mapping[id + id_offset]);
+    }
 };
 
 }  // namespace knowhere
@@ -0,0 +1,37 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstddef>
+
+#include "knowhere/binaryset.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// The binaries of a serialized index are compressed in chunks of kCompressionChunkSize bytes, with zlib, in parallel on
+// the build thread pool. The chunks that do not shrink by an eighth, such as PQ codes, are stored raw, and so is a
+// binary none of whose chunks shrink.
+constexpr size_t kCompressionChunkSize = 4 * 1024 * 1024;
+
+// compresses the binaries of binset in place, level is the zlib level from 1 (fastest) to 9
+Status
+CompressBinarySet(BinarySet& binset, int level = 1);
+
+// restores the binaries CompressBinarySet() compressed, the others are left as they are
+Status
+DecompressBinarySet(BinarySet& binset);
+
+bool
+IsCompressedBinary(const Binary& binary);
+
+}  // namespace knowhere
@@ -9,10 +9,13 @@
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 #ifndef KNOWHERE_KNOWHERE_H
 #define KNOWHERE_KNOWHERE_H
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <type_traits>
 #include <vector>
 
 #include "io/memory_io.h"
@@ -116,5 +119,115 @@ class BloomFilter {
         return (result + bucket_i) % m;
     }
 };
+
+// A blocked bloom filter: the k = 8 bits of an element all fall in one 64-byte block, one bit in each of its 8 words,
+// so a lookup touches a single cache line and tests the 8 words independently. add() may be called concurrently.
+template <typename T>
+class BlockedBloomFilter {
+    static_assert(std::is_trivially_copyable_v<T>, "BlockedBloomFilter elements must be trivially copyable");
+
+ public:
+    static constexpr size_t kWordsPerBlock = 8;
+    static constexpr size_t kBitsPerBlock = kWordsPerBlock * 64;
+
+    explicit BlockedBloomFilter(size_t expected_elements, double false_positive_prob)
+        : n(expected_elements), p(false_positive_prob) {
+        size_t m = static_cast<size_t>(-(n * log(p)) / (log(2) * log(2)));
+        blocks_num = std::max<size_t>((m + kBitsPerBlock - 1) / kBitsPerBlock, 1);
+        blocks.resize(blocks_num);
+    }
+
+    void
+    add(const T& element) {
+        const uint64_t h = hash(element);
+        uint64_t* block = blocks[block_of(h)].words;
+        const uint32_t h_lo = static_cast<uint32_t>(h);
+        for (size_t i = 0; i < kWordsPerBlock; ++i) {
+            __atomic_fetch_or(block + i, bit_of(h_lo, i), __ATOMIC_RELAXED);
+        }
+    }
+
+    bool
+    contains(const T& element) const {
+        const uint64_t h = hash(element);
+        const uint64_t* block = blocks[block_of(h)].words;
+        const uint32_t h_lo = static_cast<uint32_t>(h);
+        // branchless, so that the 8 words are tested together
+        uint64_t missing = 0;
+        for (size_t i = 0; i < kWordsPerBlock; ++i) {
+            const uint64_t bit = bit_of(h_lo, i);
+            missing |= (block[i] & bit) ^ bit;
+        }
+        return missing == 0;
+    }
+
+    void
+    save(MemoryIOWriter& writer) const {
+        writeBinaryPOD(writer, blocks_num);
+        writeBinaryPOD(writer, n);
+        writeBinaryPOD(writer, p);
+        writer.write(blocks.data(), blocks.size() * sizeof(Block));
+    }
+
+    void
+    load(MemoryIOReader& reader) {
+        readBinaryPOD(reader, blocks_num);
+        readBinaryPOD(reader, n);
+        readBinaryPOD(reader, p);
+        blocks.assign(blocks_num, Block{});
+        reader.read(blocks.data(), blocks.size() * sizeof(Block));
+    }
+    size_t
+    size() const {
+        return n;
+    }
+    double
+    false_positive_rate() const {
+        return p;
+    }
+    size_t
+    memory_usage() const {
+        return blocks.size() * sizeof(Block);
+    }
+
+ private:
+    // odd multipliers that pick the bit of each word from the low half of the hash
+    static constexpr uint32_t kSalts[kWordsPerBlock] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+    struct alignas(64) Block {
+        uint64_t words[kWordsPerBlock] = {};
+    };
+    std::vector<Block> blocks;
+    size_t blocks_num = 0;
+    size_t n = 0;
+    double p = 0.0;
+
+    static uint64_t
+    hash(const T& element) {
+        const char* data = reinterpret_cast<const char*>(&element);
+        uint64_t h = 0;
+        for (size_t i = 0; i < sizeof(T); i += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, data + i, std::min(sizeof(uint64_t), sizeof(T) - i));
+            h ^= word;
+            // the finalizer of splitmix64
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+            h ^= h >> 31;
+        }
+        return h;
+    }
+
+    // maps the high half of the hash to [0, blocks_num) without a division
+    size_t
+    block_of(uint64_t h) const {
+        return static_cast<size_t>(((h >> 32) * blocks_num) >> 32);
+    }
+
+    static uint64_t
+    bit_of(uint32_t h_lo, size_t i) {
+        return uint64_t(1) << ((h_lo * kSalts[i]) >> 26);
+    }
+};
 }  // namespace knowhere
 #endif
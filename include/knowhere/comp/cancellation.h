@@ -0,0 +1,100 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef KNOWHERE_CANCELLATION_H
+#define KNOWHERE_CANCELLATION_H
+
+#include <atomic>
+#include <chrono>
+
+namespace knowhere {
+
+// Stops the searches it is passed to once it is cancelled or its deadline passes. The searches check it between
+// graph hops, inverted lists and beams, and stop with the results they have found so far.
+class CancellationToken {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken() = default;
+
+    explicit CancellationToken(Clock::time_point deadline) : deadline_(deadline) {
+    }
+
+    explicit CancellationToken(std::chrono::milliseconds timeout) : deadline_(Clock::now() + timeout) {
+    }
+
+    void
+    Cancel() {
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+
+    bool
+    IsCancelled() const {
+        return cancelled_.load(std::memory_order_relaxed) || IsTimeout();
+    }
+
+    // whether the deadline has passed, rather than Cancel() being called
+    bool
+    IsTimeout() const {
+        if (timeout_.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (deadline_ == Clock::time_point::max() || Clock::now() < deadline_) {
+            return false;
+        }
+        timeout_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    // the token of the search running on the calling thread, the thread pool passes it on to the tasks it pushes
+    static const CancellationToken*
+    Current() {
+        return current_;
+    }
+
+    static bool
+    CurrentIsCancelled() {
+        return current_ != nullptr && current_->IsCancelled();
+    }
+
+ private:
+    friend class ScopedCancellation;
+
+    std::atomic_bool cancelled_ = false;
+    // caches the expiry, so that the checks after it skip the clock
+    mutable std::atomic_bool timeout_ = false;
+    const Clock::time_point deadline_ = Clock::time_point::max();
+
+    inline static thread_local const CancellationToken* current_ = nullptr;
+};
+
+// Sets the token of the calling thread for its lifetime
+class ScopedCancellation {
+ public:
+    explicit ScopedCancellation(const CancellationToken* token) : token_before_(CancellationToken::current_) {
+        CancellationToken::current_ = token;
+    }
+
+    ScopedCancellation(const ScopedCancellation&) = delete;
+    ScopedCancellation&
+    operator=(const ScopedCancellation&) = delete;
+
+    ~ScopedCancellation() {
+        CancellationToken::current_ = token_before_;
+    }
+
+ private:
+    const CancellationToken* token_before_;
+};
+
+}  // namespace knowhere
+
+#endif /* KNOWHERE_CANCELLATION_H */
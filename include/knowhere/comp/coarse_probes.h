@@ -0,0 +1,33 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace knowhere {
+
+// The lists a batch of queries probes in the coarse quantizer shared by several IVF indexes, see
+// Index::SearchSegments(). A search given them as meta::COARSE_PROBES of its queries scans the lists without searching
+// the quantizer again, if its quantizer and its nprobe are the ones of the probes.
+struct CoarseProbes {
+    // the identity of the quantizer, see IndexNode::SharedCoarseQuantizer()
+    const void* quantizer = nullptr;
+    int64_t rows = 0;
+    int64_t nprobe = 0;
+    // rows * nprobe, the lists of each query with their distances to it, as faiss::Index::search() returns them
+    std::vector<int64_t> lists;
+    std::vector<float> distances;
+};
+
+}  // namespace knowhere
@@ -0,0 +1,47 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "knowhere/index/index_node.h"
+
+namespace knowhere {
+
+// Lists of embeddings, such as the token embeddings of the documents and the queries of late-interaction models. The
+//   offsets of n lists are n + 1 row numbers, list i is made of the rows [offsets[i], offsets[i + 1]). They come as a
+//   std::shared_ptr<const EmbListOffsets> in meta::EMB_LIST_OFFSET of a dataset.
+using EmbListOffsets = std::vector<size_t>;
+
+// whether offsets are the offsets of lists covering the rows of a dataset
+bool
+IsValidEmbListOffsets(const EmbListOffsets& offsets, int64_t rows);
+
+// the list of a row
+inline int64_t
+EmbListOfRow(const EmbListOffsets& offsets, int64_t row) {
+    return std::upper_bound(offsets.begin(), offsets.end(), static_cast<size_t>(row)) - offsets.begin() - 1;
+}
+
+// Searches the lists of the rows of node, see IndexNode::EmbListOffsets(), with the lists of embeddings of dataset.
+//   Each query embedding retrieves its k * emb_list_candidates_ratio nearest rows with node.Search(), the lists of
+//   those rows are the candidates of the query, and every candidate is scored exactly by the sum over the query
+//   embeddings of their best similarity with the embeddings of the candidate (MaxSim), with the raw vectors of node.
+// The rows are fp32 and the metric is IP or COSINE. The result has a row of k lists per query list. bitset filters
+//   out lists, not rows.
+expected<DataSetPtr>
+SearchEmbList(const IndexNode& node, const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset);
+
+}  // namespace knowhere
@@ -0,0 +1,37 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace knowhere {
+
+struct GpuDeviceUsage {
+    int64_t device_id = 0;
+    // the GPU indexes, or the shards of the sharded ones, on the device and their rows
+    int64_t indexes = 0;
+    int64_t rows = 0;
+    // as the CUDA runtime reports them, 0 without a GPU build
+    int64_t free_bytes = 0;
+    int64_t total_bytes = 0;
+};
+
+// counts an index of rows placed on device_id, negative counts remove it
+void
+AddGpuDeviceUsage(int64_t device_id, int64_t indexes, int64_t rows);
+
+// the usage of every device, in the order of their ids
+std::vector<GpuDeviceUsage>
+GetGpuDeviceUsage();
+
+}  // namespace knowhere
@@ -0,0 +1,157 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace knowhere {
+
+// The group key of every row of an index, e.g. a scalar field. A group-by search returns the k groups whose closest
+//   rows are the closest to a query, with their group_size closest rows each. The keys come as a
+//   std::shared_ptr<const GroupKeys> in meta::GROUP_BY_KEYS of the queries.
+using GroupKeys = std::vector<int64_t>;
+
+// Collects the rows of a group-by search in any order, and tells when no farther row can change the result. The
+//   distances are the smaller the closer, the rows of larger-is-closer metrics are added with negated distances.
+// Searches feed it from inside their traversal, so that they stop as soon as the groups are settled.
+class GroupByCollector {
+ public:
+    GroupByCollector(const GroupKeys& keys, size_t n_groups, size_t group_size)
+        : keys_(keys), n_groups_(n_groups), group_size_(group_size) {
+    }
+
+    // forgets the rows of the previous query
+    void
+    Reset() {
+        group_of_key_.clear();
+        groups_.clear();
+        n_full_ = 0;
+        dirty_ = false;
+        bound_ = std::numeric_limits<float>::infinity();
+    }
+
+    void
+    Add(int64_t row, float dis) {
+        if (row < 0 || static_cast<size_t>(row) >= keys_.size() || (!dirty_ && dis >= bound_)) {
+            return;
+        }
+        auto [it, inserted] = group_of_key_.try_emplace(keys_[row], groups_.size());
+        if (inserted) {
+            groups_.emplace_back();
+        }
+        Group& group = groups_[it->second];
+        if (group.rows.size() < group_size_) {
+            group.rows.emplace_back(dis, row);
+            std::push_heap(group.rows.begin(), group.rows.end());
+            n_full_ += group.rows.size() == group_size_;
+        } else if (dis < group.rows.front().first) {
+            std::pop_heap(group.rows.begin(), group.rows.end());
+            group.rows.back() = {dis, row};
+            std::push_heap(group.rows.begin(), group.rows.end());
+        } else {
+            return;
+        }
+        group.best = std::min(group.best, dis);
+        dirty_ = true;
+    }
+
+    // a row at Bound() or farther can not enter the result: the n_groups groups of the closest rows are full, and the
+    //   row is not closer than the farthest row they keep. +inf until then.
+    float
+    Bound() {
+        if (!dirty_) {
+            return bound_;
+        }
+        dirty_ = false;
+        bound_ = std::numeric_limits<float>::infinity();
+        if (n_full_ < n_groups_) {
+            return bound_;
+        }
+        const auto top = TopGroups();
+        float bound = -std::numeric_limits<float>::infinity();
+        for (size_t g : top) {
+            if (groups_[g].rows.size() < group_size_) {
+                return bound_;
+            }
+            bound = std::max(bound, groups_[g].rows.front().first);
+        }
+        bound_ = bound;
+        return bound_;
+    }
+
+    bool
+    Full() {
+        return Bound() < std::numeric_limits<float>::infinity();
+    }
+
+    // writes the n_groups * group_size rows of the result, the groups by their closest row and the rows of a group by
+    //   distance, padded with -1. negate restores the distances of larger-is-closer metrics.
+    void
+    Output(int64_t* ids, float* distances, bool negate) const {
+        const auto top = TopGroups();
+        size_t pos = 0;
+        for (size_t g : top) {
+            auto rows = groups_[g].rows;
+            std::sort_heap(rows.begin(), rows.end());
+            for (const auto& [dis, row] : rows) {
+                ids[pos] = row;
+                distances[pos++] = negate ? -dis : dis;
+            }
+            for (size_t i = rows.size(); i < group_size_; i++) {
+                ids[pos] = -1;
+                distances[pos++] = negate ? -std::numeric_limits<float>::max() : std::numeric_limits<float>::max();
+            }
+        }
+        for (; pos < n_groups_ * group_size_; pos++) {
+            ids[pos] = -1;
+            distances[pos] = negate ? -std::numeric_limits<float>::max() : std::numeric_limits<float>::max();
+        }
+    }
+
+ private:
+    struct Group {
+        // a max-heap of (distance, row)
+        std::vector<std::pair<float, int64_t>> rows;
+        float best = std::numeric_limits<float>::infinity();
+    };
+
+    // the up to n_groups groups of the closest rows, closest first
+    std::vector<size_t>
+    TopGroups() const {
+        std::vector<size_t> order(groups_.size());
+        for (size_t g = 0; g < order.size(); g++) {
+            order[g] = g;
+        }
+        const size_t n = std::min(n_groups_, order.size());
+        std::partial_sort(order.begin(), order.begin() + n, order.end(),
+                          [this](size_t a, size_t b) { return groups_[a].best < groups_[b].best; });
+        order.resize(n);
+        return order;
+    }
+
+    const GroupKeys& keys_;
+    const size_t n_groups_;
+    const size_t group_size_;
+    std::unordered_map<int64_t, size_t> group_of_key_;
+    std::vector<Group> groups_;
+    size_t n_full_ = 0;
+    bool dirty_ = false;
+    float bound_ = std::numeric_limits<float>::infinity();
+};
+
+}  // namespace knowhere
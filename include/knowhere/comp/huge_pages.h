@@ -0,0 +1,77 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "knowhere/comp/warm_up.h"
+
+namespace knowhere {
+
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr size_t kGiantPageSize = 1024 * 1024 * 1024;
+
+inline size_t
+HugePageRound(size_t size) {
+    return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+// An anonymous mapping backed by huge pages. It is taken from the hugetlbfs pool, 1GB pages first for the buffers
+//   that fill one, and falls back to a 2MB aligned mapping the kernel backs with transparent huge pages.
+class HugePageBuffer {
+ public:
+    // nullptr if no mapping could be made
+    static std::unique_ptr<HugePageBuffer>
+    Allocate(size_t size);
+
+    ~HugePageBuffer();
+
+    HugePageBuffer(const HugePageBuffer&) = delete;
+    HugePageBuffer&
+    operator=(const HugePageBuffer&) = delete;
+
+    uint8_t*
+    data() const {
+        return data_;
+    }
+
+    // the bytes mapped, size rounded up to the huge pages
+    size_t
+    capacity() const {
+        return capacity_;
+    }
+
+    // whether the pages are from the hugetlbfs pool, rather than transparent huge pages
+    bool
+    hugetlb() const {
+        return hugetlb_;
+    }
+
+ private:
+    HugePageBuffer(uint8_t* data, size_t capacity, bool hugetlb) : data_(data), capacity_(capacity), hugetlb_(hugetlb) {
+    }
+
+    uint8_t* const data_;
+    const size_t capacity_;
+    const bool hugetlb_;
+};
+
+// asks the kernel to back the file mappings of the regions with transparent huge pages, where the file system
+//   supports it. This is only advice, the regions are left as they are otherwise.
+void
+AdviseHugePages(const std::vector<MappedRegion>& regions);
+
+}  // namespace knowhere
@@ -0,0 +1,103 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "knowhere/binaryset.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// A file that holds the binaries of a serialized index as sections, one per binary of the BinarySet. The file starts
+// with a header and a table of contents, that give the name, the offset, the size and the checksum of every section.
+// The sections start on page boundaries, so that each of them can be mapped, read with direct IO or fetched on its
+// own, without parsing the ones before it.
+//
+// Layout, little endian:
+//   page 0..: ContainerHeader, then a ContainerSection per section
+//   then the sections, each at a multiple of page_size, padded with zeros
+struct ContainerHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t n_sections;
+    uint32_t reserved;
+    // of the header with this field set to 0, followed by the table of contents
+    uint64_t checksum;
+};
+
+struct ContainerSection {
+    static constexpr size_t kMaxNameLength = 63;
+
+    char name[kMaxNameLength + 1];
+    uint64_t offset;
+    uint64_t size;
+    // xxh3 of the bytes of the section
+    uint64_t checksum;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+constexpr uint32_t kContainerPageSize = 4096;
+
+// writes the binaries of binset to filename as a container, chunked binaries are written chunk by chunk
+Status
+WriteIndexContainer(const BinarySet& binset, const std::string& filename);
+
+class IndexContainerReader {
+ public:
+    // reads and checks the header and the table of contents of filename
+    static expected<std::unique_ptr<IndexContainerReader>>
+    Open(const std::string& filename);
+
+    ~IndexContainerReader();
+
+    IndexContainerReader(const IndexContainerReader&) = delete;
+    IndexContainerReader&
+    operator=(const IndexContainerReader&) = delete;
+
+    const std::vector<ContainerSection>&
+    Sections() const {
+        return sections_;
+    }
+
+    const ContainerSection*
+    Find(const std::string& name) const;
+
+    // reads a section into memory and checks its checksum
+    expected<BinaryPtr>
+    Read(const std::string& name) const;
+
+    // maps a section, the binary keeps the mapping alive. The checksum is checked only if verify is set, as that
+    //   touches every page.
+    expected<BinaryPtr>
+    Map(const std::string& name, bool verify = false) const;
+
+    // the sections in names, all of them if it is empty, into binset
+    Status
+    Load(BinarySet& binset, const std::vector<std::string>& names = {}, bool mmap = false) const;
+
+ private:
+    IndexContainerReader(int fd, std::string filename, std::vector<ContainerSection> sections)
+        : fd_(fd), filename_(std::move(filename)), sections_(std::move(sections)) {
+    }
+
+    int fd_;
+    const std::string filename_;
+    const std::vector<ContainerSection> sections_;
+};
+
+}  // namespace knowhere
@@ -24,8 +24,10 @@ constexpr const char* INVALID = "";
 
 constexpr const char* INDEX_FAISS_BIN_IDMAP = "BIN_FLAT";
 constexpr const char* INDEX_FAISS_BIN_IVFFLAT = "BIN_IVF_FLAT";
+constexpr const char* INDEX_FAISS_BIN_MIH = "BIN_MIH";
 
 constexpr const char* INDEX_FAISS_IDMAP = "FLAT";
+constexpr const char* INDEX_FAISS_BQ_FLAT = "BQ_FLAT";
 constexpr const char* INDEX_FAISS_IVFFLAT = "IVF_FLAT";
 constexpr const char* INDEX_FAISS_IVFFLAT_CC = "IVF_FLAT_CC";
 constexpr const char* INDEX_FAISS_IVFPQ = "IVF_PQ";
@@ -54,6 +56,19 @@ constexpr const char* INDEX_HNSW = "HNSW";
 constexpr const char* INDEX_HNSW_SQ = "HNSW_SQ";
 constexpr const char* INDEX_HNSW_PQ = "HNSW_PQ";
 constexpr const char* INDEX_HNSW_PRQ = "HNSW_PRQ";
+constexpr const char* INDEX_HNSW_RABITQ = "HNSW_RABITQ";
+
+// a single layer Vamana graph over the storage of HNSW, HNSW_SQ and HNSW_PQ
+constexpr const char* INDEX_VAMANA = "VAMANA";
+constexpr const char* INDEX_VAMANA_SQ = "VAMANA_SQ";
+constexpr const char* INDEX_VAMANA_PQ = "VAMANA_PQ";
+// an NN-Descent k-NN graph, optionally pruned, over the storage of HNSW, HNSW_SQ and HNSW_PQ
+constexpr const char* INDEX_NNDESCENT = "NNDESCENT";
+constexpr const char* INDEX_NNDESCENT_SQ = "NNDESCENT_SQ";
+constexpr const char* INDEX_NNDESCENT_PQ = "NNDESCENT_PQ";
+// the rows split into num_shards HNSW or HNSW_SQ indexes, built and searched concurrently
+constexpr const char* INDEX_HNSW_SHARDED = "HNSW_SHARDED";
+constexpr const char* INDEX_HNSW_SQ_SHARDED = "HNSW_SQ_SHARDED";
 
 constexpr const char* INDEX_DISKANN = "DISKANN";
 constexpr const char* INDEX_MINHASH_LSH = "MINHASH_LSH";
@@ -66,6 +81,8 @@ constexpr const char* INDEX_SPARSE_WAND_CC = "SPARSE_WAND_CC";
 
 namespace ClusterEnum {
 constexpr const char* CLUSTER_KMEANS = "KMEANS";
+constexpr const char* CLUSTER_MINIBATCH_KMEANS = "MINIBATCH_KMEANS";
+constexpr const char* CLUSTER_BALANCED_KMEANS = "BALANCED_KMEANS";
 }  // namespace ClusterEnum
 
 namespace meta {
@@ -102,6 +119,25 @@ constexpr const char* SCALAR_INFO = "scalar_info";
 constexpr const char* MATERIALIZED_VIEW_SEARCH_INFO = "materialized_view_search_info";
 constexpr const char* MATERIALIZED_VIEW_OPT_FIELDS_PATH = "opt_fields_path";
 constexpr const char* MAX_EMPTY_RESULT_BUCKETS = "max_empty_result_buckets";
+// the number of probed lists per query, output of IVF searches with adaptive nprobe
+constexpr const char* NPROBE_USED = "nprobe_used";
+// set on the results of a search stopped by its CancellationToken, with the results found until then
+constexpr const char* PARTIAL_RESULTS = "partial_results";
+// a SearchStatsVec with the work of every query, output of searches with the search_stats config
+constexpr const char* SEARCH_STATS = "search_stats";
+// a std::shared_ptr<const CoarseProbes> set on the queries of the IVF searches that reuse a coarse search
+constexpr const char* COARSE_PROBES = "coarse_probes";
+// the L2 norms of the rows of a base dataset, see DataSet::SetTensorNorms()
+constexpr const char* TENSOR_NORMS = "tensor_norms";
+// a std::shared_ptr<const std::vector<uint32_t>> with the neighbors of every row of a graph built elsewhere, such as
+//   a CAGRA graph, that the faiss HNSW indexes take as their base layer instead of building one
+constexpr const char* BASE_GRAPH = "base_graph";
+// a std::shared_ptr<const EmbListOffsets> with the offsets of the lists of embeddings the rows of a dataset are made
+//   of, see knowhere/comp/emb_list.h
+constexpr const char* EMB_LIST_OFFSET = "emb_list_offset";
+// a std::shared_ptr<const GroupKeys> with the group key of every row of an index, set on the queries of a group-by
+//   search, see knowhere/comp/group_by.h
+constexpr const char* GROUP_BY_KEYS = "group_by_keys";
 constexpr const char* BM25_K1 = "bm25_k1";
 constexpr const char* BM25_B = "bm25_b";
 // average document length
@@ -117,14 +153,39 @@ constexpr const char* USE_ELKAN = "use_elkan";
 constexpr const char* NBITS = "nbits";  // PQ/SQ
 constexpr const char* M = "m";          // PQ param for IVFPQ
 constexpr const char* SSIZE = "ssize";
+constexpr const char* MAX_LIST_SIZE = "max_list_size";  // IVF_CC lists split beyond it
 constexpr const char* REORDER_K = "reorder_k";
 constexpr const char* WITH_RAW_DATA = "with_raw_data";
 constexpr const char* ENSURE_TOPK_FULL = "ensure_topk_full";
 constexpr const char* CODE_SIZE = "code_size";
 constexpr const char* RAW_DATA_STORE_PREFIX = "raw_data_store_prefix";
 constexpr const char* SUB_DIM = "sub_dim";
+constexpr const char* ANISOTROPIC_THRESHOLD = "anisotropic_threshold";
 constexpr const char* REFINE_TYPE = "refine_type";
+constexpr const char* REFINE_K = "refine_k";
 constexpr const char* REFINE_WITH_QUANT = "refine_with_quant";
+constexpr const char* PRE_REFINE_TYPE = "pre_refine_type";
+constexpr const char* PRE_REFINE_RATIO = "pre_refine_ratio";
+constexpr const char* ADAPTIVE_NPROBE = "adaptive_nprobe";
+constexpr const char* MIN_NPROBE = "min_nprobe";
+constexpr const char* ADAPTIVE_NPROBE_RADIUS_SCALE = "adaptive_nprobe_radius_scale";
+constexpr const char* LIST_MAJOR_NQ = "list_major_nq";
+constexpr const char* COARSE_QUANTIZER = "coarse_quantizer";
+constexpr const char* COARSE_HNSW_M = "coarse_hnsw_m";
+constexpr const char* COARSE_EF_CONSTRUCTION = "coarse_ef_construction";
+constexpr const char* COARSE_EF = "coarse_ef";
+constexpr const char* GPU_TRAIN = "gpu_train";
+constexpr const char* GPU_ASSIGN = "gpu_assign";
+constexpr const char* BALANCED_KMEANS = "balanced_kmeans";
+
+// Cluster Params
+constexpr const char* NUM_CLUSTERS = "num_clusters";
+constexpr const char* KMEANS_BATCH_SIZE = "kmeans_batch_size";
+constexpr const char* BALANCED_KMEANS_RATIO = "balanced_kmeans_ratio";
+constexpr const char* ASSIGN_INDEX = "assign_index";
+constexpr const char* ASSIGN_HNSW_M = "assign_hnsw_m";
+constexpr const char* ASSIGN_EF_CONSTRUCTION = "assign_ef_construction";
+constexpr const char* ASSIGN_EF = "assign_ef";
 
 // cuVS Params
 constexpr const char* REFINE_RATIO = "refine_ratio";
@@ -158,6 +219,10 @@ constexpr const char* HASHMAP_MIN_BITLEN = "hashmap_min_bitlen";
 constexpr const char* HASHMAP_MAX_FILL_RATE = "hashmap_max_fill_rate";
 constexpr const char* NN_DESCENT_NITER = "nn_descent_niter";
 constexpr const char* ADAPT_FOR_CPU = "adapt_for_cpu";
+constexpr const char* CPU_INDEX_TYPE = "cpu_index_type";
+constexpr const char* CPU_INDEX_PARAMS = "cpu_index_params";
+constexpr const char* NUM_SHARDS = "num_shards";
+constexpr const char* FILTER_VERSION = "filter_version";
 
 // HNSW Params
 constexpr const char* EFCONSTRUCTION = "efConstruction";
@@ -172,21 +237,48 @@ constexpr const char* BUILD_DRAM_BUDGET_GB = "build_dram_budget_gb";
 constexpr const char* BEAMWIDTH = "beamwidth";
 constexpr const char* SEARCH_CACHE_BUDGET_GB = "search_cache_budget_gb";
 constexpr const char* SEARCH_LIST_SIZE = "search_list_size";
+constexpr const char* VAMANA_ALPHA = "alpha";
+
+// NNDESCENT Params
+constexpr const char* NNDESCENT_K = "nndescent_k";
+constexpr const char* NNDESCENT_ITER = "nndescent_iter";
+constexpr const char* GRAPH_PRUNING = "graph_pruning";
 
 // FAISS additional Params
 constexpr const char* HNSW_REFINE = "refine";
 constexpr const char* HNSW_REFINE_K = "refine_k";
 constexpr const char* HNSW_REFINE_TYPE = "refine_type";
-constexpr const char* SQ_TYPE = "sq_type";  // for IVF_SQ and HNSW_SQ
-constexpr const char* PRQ_NUM = "nrq";      // for PRQ, number of redisual quantizers
+constexpr const char* SQ_TYPE = "sq_type";          // for IVF_SQ and HNSW_SQ
+constexpr const char* SQ_ROTATION = "sq_rotation";  // for HNSW_SQ
+constexpr const char* SQ_INTERLEAVE = "sq_interleave";  // for IVF_SQ8
+constexpr const char* PRQ_NUM = "nrq";              // for PRQ, number of redisual quantizers
+constexpr const char* HNSW_PREFETCH_DEPTH = "prefetch_depth";
+constexpr const char* HNSW_QUERY_BATCH_SIZE = "query_batch_size";
+constexpr const char* HNSW_REORDER_TYPE = "reorder_type";
+constexpr const char* HNSW_TWO_HOP_EXPANSION = "two_hop_expansion";
+constexpr const char* HNSW_COMPRESS_GRAPH = "compress_graph";
+constexpr const char* HNSW_FAST_SCAN_NEIGHBORS = "fast_scan_neighbors";
+constexpr const char* HNSW_ENTRY_POINT_SEEDS = "entry_point_seeds";
+constexpr const char* HNSW_EARLY_STOP_PATIENCE = "early_stop_patience";
+constexpr const char* HNSW_EARLY_STOP_GAP = "early_stop_gap";
+constexpr const char* HNSW_CONCURRENT_INSERT = "concurrent_insert";
+constexpr const char* HNSW_ADD_BATCH_SIZE = "add_batch_size";
 
 // Sparse Inverted Index Params
 constexpr const char* INVERTED_INDEX_ALGO = "inverted_index_algo";
+constexpr const char* COMPRESS_POSTING_IDS = "compress_posting_ids";
+constexpr const char* REORDER_DOC_IDS = "reorder_doc_ids";
+constexpr const char* BM25_IMPACTS = "bm25_impacts";
+constexpr const char* DIRECT_LAYOUT = "direct_layout";
+constexpr const char* SEARCH_BATCH_SIZE = "search_batch_size";
+constexpr const char* SEARCH_POSTING_BUDGET = "search_posting_budget";
+constexpr const char* SEARCH_TIME_BUDGET_MS = "search_time_budget_ms";
 constexpr const char* DROP_RATIO_BUILD = "drop_ratio_build";
 constexpr const char* DROP_RATIO_SEARCH = "drop_ratio_search";
 
 // RaBitQ Params
 constexpr const char* RABITQ_QUERY_BITS = "rbq_bits_query";
+constexpr const char* RABITQ_DATA_BITS = "rbq_bits_data";
 
 // minhash meta Params
 constexpr const char* MH_ELEMENT_BIT_WIDTH = "mh_element_bit_width";
@@ -196,9 +288,16 @@ constexpr const char* MH_LSH_ALIGNED_BLOCK_SIZE = "mh_lsh_aligned_block_size";
 constexpr const char* MH_LSH_BAND = "mh_lsh_band";
 constexpr const char* MH_LSH_SHARED_BLOOM_FILTER = "mh_lsh_shared_bloom_filter";
 constexpr const char* MH_LSH_BLOOM_FALSE_POSITIVE_RPOB = "mh_lsh_bloom_false_positive_prob";
+constexpr const char* MH_LSH_BLOCKED_BLOOM_FILTER = "mh_lsh_blocked_bloom_filter";
 constexpr const char* MH_LSH_HASH_CODE_IN_MEM = "mh_lsh_code_in_mem";
 constexpr const char* MH_LSH_REFINE_K = "refine_k";
 constexpr const char* MH_LSH_BATCH_SEARCH = "mh_lsh_batch_search";
+constexpr const char* MH_LSH_PREFIX_KEY = "mh_lsh_prefix_key";
+constexpr const char* MH_LSH_MULTI_PROBE = "mh_lsh_multi_probe";
+
+// multi-index hashing Params
+constexpr const char* MIH_NHASH = "mih_nhash";
+constexpr const char* MIH_MAX_FLIP = "mih_max_flip";
 }  // namespace indexparam
 
 using MetricType = std::string;
@@ -229,6 +328,7 @@ enum RefineType {
     UINT8_QUANT,
     FLOAT16_QUANT,
     BFLOAT16_QUANT,
+    UINT4_QUANT,
 };
 
 }  // namespace knowhere
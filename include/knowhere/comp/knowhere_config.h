@@ -15,6 +15,9 @@
 #include <string>
 #include <vector>
 
+#include "knowhere/comp/numa.h"
+#include "knowhere/comp/search_planner.h"
+
 #ifdef KNOWHERE_WITH_DISKANN
 #include "diskann/aio_context_pool.h"
 #endif
@@ -95,6 +98,15 @@ class KnowhereConfig {
     static bool
     SetAioContextPool(size_t num_ctx);
 
+    /**
+     * Makes the DiskANN indexes loaded from then on read the disk through `num_ctx` io_uring rings instead of libaio,
+     * each with up to 128 reads in flight. With `sqpoll` a kernel thread polls the submission queues, which saves a
+     * syscall per submit but keeps a core busy while reads come in. Returns false if io_uring is not available, e.g. on
+     * kernels older than 5.6, then DiskANN stays on libaio.
+     */
+    static bool
+    SetUringContextPool(size_t num_ctx, bool sqpoll = false);
+
     static void
     SetBuildThreadPoolSize(size_t num_threads);
     static size_t
@@ -105,6 +117,56 @@ class KnowhereConfig {
     static size_t
     GetSearchThreadPoolSize();
 
+    /**
+     * Pins the threads of the build or the search thread pool to the cpus of `cpu_list`, a list of cpus and ranges
+     * such as "0-15,32-47", so that builds do not take the cores and the caches of the searches. An empty list unpins
+     * them. Busy threads move once their current task is done, and the threads of a later resize start on the new
+     * cpus. Returns false if the list is not valid.
+     */
+    static bool
+    SetBuildThreadPoolCpus(const std::string& cpu_list);
+    static bool
+    SetSearchThreadPoolCpus(const std::string& cpu_list);
+
+    /**
+     * The searches of at least `nq` queries are batch searches, their tasks run on the search thread pool after the
+     * pending tasks of the smaller searches and of the iterators.
+     */
+    static void
+    SetBatchSearchNq(size_t nq);
+
+    /**
+     * Sets the limits of the admission of the searches: a search is rejected with Status::overloaded once the search
+     * thread pool has max_pending_tasks pending tasks, or its tasks wait max_queue_wait_ms in the queue on average.
+     * Batch searches are shed at half the limits. 0 disables a limit, both are disabled by default.
+     */
+    static void
+    SetSearchAdmission(size_t max_pending_tasks, int64_t max_queue_wait_ms);
+
+    /**
+     * Sets how the memory of the indexes loaded from now on is placed over the NUMA nodes, see numa::NumaPolicy.
+     * LOCAL also creates a search thread pool per node, with an even part of the search threads, and the searches of
+     * an index run on the pool of its node.
+     */
+    static void
+    SetNumaPolicy(numa::NumaPolicy policy);
+
+    /**
+     * Makes the HNSW and DiskANN searches choose between the graph and a brute force with the cost model of
+     * SearchPlanner instead of their fixed filter thresholds. DiskANN keeps using filter_threshold when it is set.
+     * `model` can be calibrated from benchmark runs with SearchPlanner::Calibrate().
+     */
+    static void
+    SetSearchPlanner(bool enabled, const SearchCostModel& model = SearchCostModel());
+
+    /**
+     * Makes the concurrent searches of a GPU index with the same params and filter run as one batch of up to
+     * `max_batch_nq` queries, that waits for the others at most `max_wait_us` after its first request. Searches of
+     * `max_batch_nq` queries or more run on their own. 0 disables it, the default.
+     */
+    static void
+    SetGpuSearchCoalescing(size_t max_batch_nq, int64_t max_wait_us);
+
     /**
      * init GPU Resource
      */
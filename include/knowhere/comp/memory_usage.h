@@ -0,0 +1,98 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace prometheus {
+class Gauge;
+}  // namespace prometheus
+
+namespace knowhere {
+
+// the sections of the memory of an index, see IndexNode::MemoryBreakdown()
+namespace memory_section {
+constexpr const char* GRAPH = "graph";
+constexpr const char* CODES = "codes";
+constexpr const char* RAW_DATA = "raw_data";
+constexpr const char* IDS = "ids";
+constexpr const char* QUANTIZER = "quantizer";
+constexpr const char* CACHE = "cache";
+constexpr const char* OTHER = "other";
+}  // namespace memory_section
+
+// The bytes an index holds in memory by section: the capacity of the buffers it owns and the size of the ones it
+//   maps from a file.
+class MemoryUsage {
+ public:
+    void
+    Add(const std::string& section, int64_t bytes) {
+        if (bytes > 0) {
+            sections_[section] += bytes;
+        }
+    }
+
+    void
+    Add(const MemoryUsage& other) {
+        for (const auto& [section, bytes] : other.sections_) {
+            Add(section, bytes);
+        }
+    }
+
+    int64_t
+    Total() const {
+        int64_t total = 0;
+        for (const auto& [section, bytes] : sections_) {
+            total += bytes;
+        }
+        return total;
+    }
+
+    const std::map<std::string, int64_t>&
+    Sections() const {
+        return sections_;
+    }
+
+ private:
+    std::map<std::string, int64_t> sections_;
+};
+
+template <typename T>
+int64_t
+VectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// The gauges of index_memory_size_family of an index, one per section, labeled by an id of the index. They are
+//   removed with it.
+class IndexMemoryGauges {
+ public:
+    explicit IndexMemoryGauges(const std::string& index_type);
+
+    ~IndexMemoryGauges();
+
+    void
+    Update(const MemoryUsage& usage);
+
+ private:
+    std::string index_id_;
+    std::string index_type_;
+    std::mutex mutex_;
+    std::map<std::string, prometheus::Gauge*> gauges_;
+};
+
+}  // namespace knowhere
@@ -0,0 +1,36 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "knowhere/dataset.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// Generates the MinHash signatures of n sets of token hashes, e.g. the hashes of the shingles of n documents, as the
+//   rows of a MINHASH_LSH dataset. The offsets of the sets are n + 1 positions in tokens, set i is made of the token
+//   hashes [offsets[i], offsets[i + 1]).
+// A signature is num_perm elements of element_bit_width bits, 32 or 64. Element j is the least a_j * x + b_j
+//   (mod 2^64) over the tokens x of the set, or its high 32 bits, where the universal hash functions (a_j, b_j) are
+//   drawn from seed: only the signatures generated with the same seed and num_perm are comparable. An empty set has
+//   all the bits of its signature set.
+// The result has n rows of num_perm * element_bit_width bits, the dim of the binary vectors that MINHASH_LSH is built
+//   on with mh_element_bit_width = element_bit_width, which gives mh_vec_length = num_perm and
+//   mh_vec_element_size = element_bit_width / 8.
+expected<DataSetPtr>
+GenMinHashSignatures(const uint64_t* tokens, const std::vector<size_t>& offsets, size_t num_perm,
+                     size_t element_bit_width, uint64_t seed = 0);
+
+}  // namespace knowhere
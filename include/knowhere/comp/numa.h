@@ -0,0 +1,68 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace knowhere::numa {
+
+enum class NumaPolicy {
+    // the memory of an index goes wherever its pages are first touched
+    NONE,
+    // the memory of every loaded index is placed on a single node, picked round robin, and its searches run on the
+    // search thread pool of that node
+    LOCAL,
+    // the memory of every loaded index is interleaved over all nodes
+    INTERLEAVE,
+};
+
+// the number of NUMA nodes, 1 if it is not known
+int
+NodeCount();
+
+// the cpus of a NUMA node, empty if it is not known
+std::vector<int>
+NodeCpus(int node);
+
+// parses a cpulist, a list of cpus and ranges such as 0-15,32-47. Returns false if it is not valid.
+bool
+ParseCpuList(const std::string& cpu_list, std::vector<int>& cpus);
+
+void
+SetPolicy(NumaPolicy policy);
+
+NumaPolicy
+GetPolicy();
+
+// applies the policy to the memory the calling thread allocates in the scope, used while an index is loaded
+class ScopedIndexPlacement {
+ public:
+    ScopedIndexPlacement();
+    ~ScopedIndexPlacement();
+
+    ScopedIndexPlacement(const ScopedIndexPlacement&) = delete;
+    ScopedIndexPlacement&
+    operator=(const ScopedIndexPlacement&) = delete;
+
+    // the node the memory is placed on, -1 if it is not placed on a single node
+    int
+    Node() const {
+        return node_;
+    }
+
+ private:
+    int node_ = -1;
+    bool applied_ = false;
+};
+
+}  // namespace knowhere::numa
@@ -0,0 +1,49 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "knowhere/dataset.h"
+#include "knowhere/operands.h"
+
+namespace knowhere {
+
+// The distinct queries of a batch: only the representatives are searched, and query i takes the results of
+//   representatives[of[i]].
+struct QueryDedup {
+    std::vector<int64_t> representatives;
+    std::vector<int64_t> of;
+
+    bool
+    Collapsed() const {
+        return representatives.size() < of.size();
+    }
+};
+
+// Collapses the duplicate queries of a dense dataset of rows in format. With tolerance 0 only the queries of the
+//   same bytes are collapsed. Otherwise fp32 queries are bucketed by the SimHash of their signs against random
+//   hyperplanes, and a query joins the first representative of its bucket whose L2 distance to it is at most
+//   tolerance times its norm. Near-duplicates that fall into different buckets are searched on their own.
+QueryDedup
+DedupQueries(const DataSet& dataset, DataFormatEnum format, float tolerance);
+
+// the representatives of dataset, a dataset that owns a copy of their rows
+DataSetPtr
+RepresentativeQueries(const DataSet& dataset, DataFormatEnum format, const QueryDedup& dedup);
+
+// the results of the representatives fanned out to the queries of the batch
+DataSetPtr
+FanOutResults(const DataSet& result, const QueryDedup& dedup);
+
+}  // namespace knowhere
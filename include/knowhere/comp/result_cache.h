@@ -0,0 +1,112 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "knowhere/dataset.h"
+#include "knowhere/operands.h"
+
+namespace knowhere {
+
+// An LRU cache of the results of the searches of an index, bounded by the bytes of the queries and the results it
+//   keeps. A result is found again by the query bytes, the fingerprint of the search config, see Config::Fingerprint(),
+//   and the version of the bitset the caller passes with the searches that filter rows, see Index::EnableResultCache().
+// Clear() drops every result once the rows of the index change. A search that started before a Clear() does not put
+//   its result back: it gets the generation of the cache before it searches and puts its result with it.
+class SearchResultCache {
+ public:
+    struct Key {
+        uint64_t config_fingerprint;
+        int64_t bitset_version;
+        int64_t nq;
+        int64_t k;
+    };
+
+    SearchResultCache(size_t capacity_bytes, DataFormatEnum data_format)
+        : capacity_bytes_(capacity_bytes), data_format_(data_format) {
+    }
+
+    // the bytes of the nq queries of dim dimensions of a dataset, in the data format of the index
+    size_t
+    QueryBytes(int64_t nq, int64_t dim) const;
+
+    uint64_t
+    Generation() const {
+        return generation_.load(std::memory_order_acquire);
+    }
+
+    // a copy of the result of the queries with key, nullptr if it is not cached
+    DataSetPtr
+    Get(const Key& key, const void* queries, size_t query_bytes);
+
+    // keeps the nq * k ids and distances of result, unless the cache was cleared since generation
+    void
+    Put(const Key& key, const void* queries, size_t query_bytes, const DataSet& result, uint64_t generation);
+
+    void
+    Clear();
+
+    size_t
+    Bytes() const {
+        std::lock_guard lock(mutex_);
+        return bytes_;
+    }
+
+    uint64_t
+    Hits() const {
+        return hits_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t
+    Misses() const {
+        return misses_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    struct Entry {
+        uint64_t hash;
+        Key key;
+        // the query bytes, hashes only select the entries to compare
+        std::vector<char> queries;
+        std::unique_ptr<int64_t[]> ids;
+        std::unique_ptr<float[]> distances;
+        size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    static uint64_t
+    Hash(const Key& key, const void* queries, size_t query_bytes);
+
+    static bool
+    Matches(const Entry& entry, const Key& key, const void* queries, size_t query_bytes);
+
+    const size_t capacity_bytes_;
+    const DataFormatEnum data_format_;
+    mutable std::mutex mutex_;
+    // the most recently used first
+    EntryList lru_;
+    std::unordered_multimap<uint64_t, EntryList::iterator> entries_;
+    size_t bytes_ = 0;
+    std::atomic<uint64_t> generation_ = 0;
+    std::atomic<uint64_t> hits_ = 0;
+    std::atomic<uint64_t> misses_ = 0;
+};
+
+}  // namespace knowhere
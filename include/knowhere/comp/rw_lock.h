@@ -9,10 +9,14 @@
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 #ifndef KNOWHERE_RW_LOCK_H
 #define KNOWHERE_RW_LOCK_H
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+#include <thread>
 /*
 FairRWLock is a fair MultiRead-SingleWrite lock
 */
@@ -98,5 +102,179 @@ class FairWriteLockGuard {
  private:
     FairRWLock& lock_;
 };
+
+/*
+ReaderBiasedRWLock is a MultiRead-SingleWrite lock for read-mostly paths, a std::shared_mutex replacement. Readers
+count themselves in one of kSlots cache lines picked by thread, so that concurrent readers do not write to the same
+line. A writer enters once it observes no readers. While it waits, new readers hold back for up to kMaxReaderBackoff
+so that the readers drain, then come in anyway: a reader never waits for long on a writer that has not entered, so
+that the lock may be taken shared again while it is held, on the same thread or not.
+*/
+class ReaderBiasedRWLock {
+ public:
+    ReaderBiasedRWLock() = default;
+    ReaderBiasedRWLock(const ReaderBiasedRWLock&) = delete;
+    ReaderBiasedRWLock&
+    operator=(const ReaderBiasedRWLock&) = delete;
+
+    void
+    lock_shared() {
+        auto& readers = slots_[Slot()].readers;
+        // the thread holds the lock already, a waiting writer could not enter before it is released
+        bool backoff = !HeldShared();
+        const auto backoff_deadline = std::chrono::steady_clock::now() + kMaxReaderBackoff;
+        while (true) {
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            const bool writer = writer_.load(std::memory_order_seq_cst);
+            if (!writer && !(backoff && writer_waiting_.load(std::memory_order_seq_cst))) {
+                PushHeld();
+                return;
+            }
+            readers.fetch_sub(1, std::memory_order_seq_cst);
+            std::unique_lock<std::mutex> lk(mtx_);
+            if (writer) {
+                cv_.wait(lk, [this]() { return !writer_.load(std::memory_order_seq_cst); });
+            } else if (!cv_.wait_until(lk, backoff_deadline,
+                                       [this]() { return !writer_waiting_.load(std::memory_order_seq_cst); })) {
+                backoff = false;
+            }
+        }
+    }
+
+    bool
+    try_lock_shared() {
+        auto& readers = slots_[Slot()].readers;
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if (!writer_.load(std::memory_order_seq_cst)) {
+            PushHeld();
+            return true;
+        }
+        readers.fetch_sub(1, std::memory_order_seq_cst);
+        return false;
+    }
+
+    void
+    unlock_shared() {
+        PopHeld();
+        slots_[Slot()].readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void
+    lock() {
+        writer_mutex_.lock();
+        writer_waiting_.store(true, std::memory_order_seq_cst);
+        size_t spins = 0;
+        while (true) {
+            if (NoReaders()) {
+                writer_.store(true, std::memory_order_seq_cst);
+                // a reader may have come in between
+                if (NoReaders()) {
+                    break;
+                }
+                writer_.store(false, std::memory_order_seq_cst);
+                Notify();
+            }
+            if (++spins < kSpinsBeforeSleep) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        writer_waiting_.store(false, std::memory_order_seq_cst);
+    }
+
+    void
+    unlock() {
+        writer_.store(false, std::memory_order_seq_cst);
+        Notify();
+        writer_mutex_.unlock();
+    }
+
+ private:
+    bool
+    NoReaders() const {
+        for (const auto& slot : slots_) {
+            if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the readers check the flags under mtx_, taking it makes sure that none of them misses the notification
+    void
+    Notify() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        cv_.notify_all();
+    }
+
+    // the slot of the calling thread, threads take the slots in turn
+    static size_t
+    Slot() {
+        static std::atomic<size_t> next_slot{0};
+        thread_local const size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kSlots;
+        return slot;
+    }
+
+    // the locks the calling thread holds shared, the ones it takes beyond the first 8 are not tracked
+    struct HeldLocks {
+        std::array<const ReaderBiasedRWLock*, 8> locks;
+        size_t count = 0;
+    };
+
+    static HeldLocks&
+    Held() {
+        thread_local HeldLocks held;
+        return held;
+    }
+
+    bool
+    HeldShared() const {
+        const auto& held = Held();
+        return std::find(held.locks.begin(), held.locks.begin() + std::min(held.count, held.locks.size()), this) !=
+               held.locks.begin() + std::min(held.count, held.locks.size());
+    }
+
+    void
+    PushHeld() const {
+        auto& held = Held();
+        if (held.count < held.locks.size()) {
+            held.locks[held.count] = this;
+        }
+        held.count++;
+    }
+
+    void
+    PopHeld() const {
+        auto& held = Held();
+        // the untracked locks are the last ones taken
+        if (held.count-- > held.locks.size()) {
+            return;
+        }
+        for (size_t i = held.count + 1; i > 0; i--) {
+            if (held.locks[i - 1] == this) {
+                std::copy(held.locks.begin() + i, held.locks.begin() + held.count + 1, held.locks.begin() + i - 1);
+                return;
+            }
+        }
+    }
+
+    constexpr static size_t kSlots = 64;
+    constexpr static size_t kSpinsBeforeSleep = 64;
+    constexpr static std::chrono::milliseconds kMaxReaderBackoff{10};
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<int64_t> readers{0};
+    };
+
+    std::array<ReaderSlot, kSlots> slots_;
+    // set while a writer holds the lock
+    std::atomic<bool> writer_{false};
+    // set while a writer waits for the readers to drain
+    std::atomic<bool> writer_waiting_{false};
+    std::mutex writer_mutex_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
 }  // namespace knowhere
 #endif
@@ -0,0 +1,262 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef KNOWHERE_SEARCH_ARENA_H
+#define KNOWHERE_SEARCH_ARENA_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace knowhere {
+
+// The scratch memory of the searches running on a thread: a monotonic arena whose blocks are kept from a search to
+// the next, so that the query copies and buffers of a search neither go through malloc nor fault in new pages. The
+// memory is released by ScopedSearchArena, the thread pool opens one around every task.
+class SearchArena {
+ public:
+    SearchArena() = default;
+    SearchArena(const SearchArena&) = delete;
+    SearchArena&
+    operator=(const SearchArena&) = delete;
+
+    // n uninitialized elements, valid until the enclosing ScopedSearchArena ends
+    template <typename T>
+    T*
+    Allocate(size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "the arena does not run destructors");
+        return static_cast<T*>(AllocateBytes(n * sizeof(T), alignof(T)));
+    }
+
+    void*
+    AllocateBytes(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        align = std::max(align, alignof(std::max_align_t));
+        while (block_ < blocks_.size()) {
+            const size_t offset = (offset_ + align - 1) / align * align;
+            if (offset + bytes <= blocks_[block_].size) {
+                offset_ = offset + bytes;
+                return blocks_[block_].data.get() + offset;
+            }
+            block_++;
+            offset_ = 0;
+        }
+        // a new block, large allocations get a block of their own
+        const size_t size = std::max(kBlockSize, bytes + align);
+        blocks_.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+        capacity_ += size;
+        block_ = blocks_.size() - 1;
+        offset_ = 0;
+        return AllocateBytes(bytes, align);
+    }
+
+    // the bytes of the blocks held by the arena
+    size_t
+    Capacity() const {
+        return capacity_;
+    }
+
+    // the bytes in use, up to the current allocation
+    size_t
+    Used() const {
+        return block_ < blocks_.size() ? Position() : capacity_;
+    }
+
+    // the arena of the calling thread
+    static SearchArena&
+    Local() {
+        thread_local SearchArena arena;
+        return arena;
+    }
+
+ private:
+    friend class ScopedSearchArena;
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    Mark
+    GetMark() const {
+        return Mark{block_, offset_};
+    }
+
+    void
+    Rewind(const Mark& mark) {
+        block_ = mark.block;
+        offset_ = mark.offset;
+    }
+
+    // frees the blocks beyond kMaxRetainedBytes once the arena is empty, after a search with unusual sizes
+    void
+    Trim() {
+        size_t retained = 0;
+        size_t keep = 0;
+        while (keep < blocks_.size() && retained + blocks_[keep].size <= kMaxRetainedBytes) {
+            retained += blocks_[keep++].size;
+        }
+        blocks_.resize(keep);
+        capacity_ = retained;
+        block_ = 0;
+        offset_ = 0;
+    }
+
+    size_t
+    Position() const {
+        size_t position = offset_;
+        for (size_t i = 0; i < block_; i++) {
+            position += blocks_[i].size;
+        }
+        return position;
+    }
+
+    constexpr static size_t kBlockSize = 64 * 1024;
+    constexpr static size_t kMaxRetainedBytes = 4 * 1024 * 1024;
+
+    std::vector<Block> blocks_;
+    size_t block_ = 0;
+    size_t offset_ = 0;
+    size_t capacity_ = 0;
+    size_t depth_ = 0;
+};
+
+// Releases what the arena of the calling thread allocates during its lifetime. Scopes nest, the outermost one also
+// trims the arena.
+class ScopedSearchArena {
+ public:
+    ScopedSearchArena() : arena_(SearchArena::Local()), mark_(arena_.GetMark()) {
+        arena_.depth_++;
+    }
+
+    ScopedSearchArena(const ScopedSearchArena&) = delete;
+    ScopedSearchArena&
+    operator=(const ScopedSearchArena&) = delete;
+
+    ~ScopedSearchArena() {
+        if (--arena_.depth_ == 0) {
+            arena_.Trim();
+        } else {
+            arena_.Rewind(mark_);
+        }
+    }
+
+ private:
+    SearchArena& arena_;
+    const SearchArena::Mark mark_;
+};
+
+// The result buffers of the searches outlive them, so they are recycled through free lists by size class instead of
+// the arena. The buffers return to the lists when the DataSet that holds them is destroyed.
+class ResultBufferPool {
+ public:
+    // never destroyed, the DataSets of static objects may release their buffers after it
+    static ResultBufferPool&
+    GetInstance() {
+        static ResultBufferPool* pool = new ResultBufferPool();
+        return *pool;
+    }
+
+    void*
+    Acquire(size_t bytes) {
+        const size_t size_class = SizeClass(bytes);
+        if (size_class >= kNumSizeClasses) {
+            return ::operator new(bytes);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& list = free_lists_[size_class];
+            if (!list.empty()) {
+                void* ptr = list.back();
+                list.pop_back();
+                return ptr;
+            }
+        }
+        return ::operator new(kMinBufferBytes << size_class);
+    }
+
+    void
+    Release(void* ptr, size_t bytes) {
+        const size_t size_class = SizeClass(bytes);
+        if (size_class < kNumSizeClasses) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& list = free_lists_[size_class];
+            if (list.size() < kMaxBuffersPerClass) {
+                list.push_back(ptr);
+                return;
+            }
+        }
+        ::operator delete(ptr);
+    }
+
+ private:
+    ResultBufferPool() = default;
+
+    static size_t
+    SizeClass(size_t bytes) {
+        size_t size_class = 0;
+        while (size_class < kNumSizeClasses && (kMinBufferBytes << size_class) < bytes) {
+            size_class++;
+        }
+        return size_class;
+    }
+
+    constexpr static size_t kMinBufferBytes = 256;
+    // up to 16MB
+    constexpr static size_t kNumSizeClasses = 17;
+    constexpr static size_t kMaxBuffersPerClass = 64;
+
+    std::mutex mutex_;
+    std::array<std::vector<void*>, kNumSizeClasses> free_lists_;
+};
+
+template <typename T>
+struct ResultBufferDeleter {
+    size_t n = 0;
+    // false for the buffers of the caller, see MakeResultBuffer()
+    bool pooled = true;
+
+    void
+    operator()(T* ptr) const {
+        if (pooled) {
+            ResultBufferPool::GetInstance().Release(ptr, n * sizeof(T));
+        }
+    }
+};
+
+template <typename T>
+using ResultBuffer = std::unique_ptr<T[], ResultBufferDeleter<T>>;
+
+// n uninitialized elements from the pool, for the ids and distances of a search result. A search into the buffer of
+//   the caller passes it as `external`, it is then used as is and never released.
+template <typename T>
+ResultBuffer<T>
+MakeResultBuffer(size_t n, T* external = nullptr) {
+    static_assert(std::is_trivially_destructible_v<T>, "the pool does not run destructors");
+    if (external != nullptr) {
+        return ResultBuffer<T>(external, ResultBufferDeleter<T>{n, false});
+    }
+    return ResultBuffer<T>(static_cast<T*>(ResultBufferPool::GetInstance().Acquire(n * sizeof(T))),
+                           ResultBufferDeleter<T>{n});
+}
+
+}  // namespace knowhere
+
+#endif /* KNOWHERE_SEARCH_ARENA_H */
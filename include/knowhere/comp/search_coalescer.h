@@ -0,0 +1,83 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// Coalesces the concurrent searches of an index into batches, so that a GPU runs one kernel for many small requests.
+// A search joins the open batch of its key, only the requests that search with the same params and the same filter
+// share a key. The first request of a batch leads it: it waits until the batch holds max_batch_nq queries or max_wait
+// passed, runs one search of all the queries of the batch and scatters the results back to the other requests.
+// Coalescing is off by default, see KnowhereConfig::SetGpuSearchCoalescing().
+class SearchCoalescer {
+ public:
+    // searches the nq queries of a batch, stored one after another, into nq * k ids and distances
+    using BatchSearch = std::function<Status(const void* queries, int64_t nq, int64_t* ids, float* dists)>;
+
+    // max_batch_nq 0 disables coalescing
+    static void
+    SetLimits(size_t max_batch_nq, std::chrono::microseconds max_wait) {
+        max_wait_us_.store(max_wait.count());
+        max_batch_nq_.store(max_batch_nq);
+    }
+
+    static bool
+    Enabled() {
+        return max_batch_nq_.load() > 0;
+    }
+
+    // searches the nq queries of row_size bytes each with the others of key, requests of max_batch_nq queries or more
+    //   search on their own
+    Status
+    Search(const std::string& key, const void* queries, int64_t nq, size_t row_size, int64_t k, int64_t* ids,
+           float* dists, const BatchSearch& search);
+
+ private:
+    struct Request {
+        const void* queries;
+        int64_t nq;
+        int64_t* ids;
+        float* dists;
+    };
+
+    struct Batch {
+        std::vector<Request> requests;
+        int64_t nq = 0;
+        bool done = false;
+        Status status = Status::success;
+        std::condition_variable cv;
+    };
+
+    Status
+    RunBatch(Batch& batch, size_t row_size, int64_t k, const BatchSearch& search);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Batch>> open_batches_;
+
+    inline static std::atomic<size_t> max_batch_nq_ = 0;
+    inline static std::atomic<int64_t> max_wait_us_ = 0;
+};
+
+}  // namespace knowhere
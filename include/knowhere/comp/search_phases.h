@@ -0,0 +1,126 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "knowhere/comp/trace_span.h"
+
+namespace knowhere {
+
+enum class SearchPhase : uint8_t {
+    // the wait of the tasks of a search in the search thread pool
+    QUEUE = 0,
+    // the coarse quantizer of IVF indexes, the upper levels of graphs
+    COARSE,
+    // the scan of the lists, the traversal of the graph, or the brute force scan
+    SCAN,
+    REFINE,
+    // the merge of the partial results and the mapping of their ids
+    ASSEMBLE,
+};
+
+constexpr size_t kNumSearchPhases = 5;
+
+const char*
+SearchPhaseName(SearchPhase phase);
+
+// Accumulates the time the tasks of a search spend in its phases. Index<T>::Search sets one for the calling thread, the
+// search thread pool hands it to the tasks of the search along with their queue wait, and the indexes add the phases
+// they time with ScopedSearchPhase. Without a recorder on the thread the timers read no clock.
+class SearchPhaseRecorder {
+ public:
+    void
+    Add(SearchPhase phase, std::chrono::nanoseconds time) {
+        ns_[static_cast<size_t>(phase)].fetch_add(time.count(), std::memory_order_relaxed);
+        if (phase == SearchPhase::QUEUE) {
+            queued_tasks_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // in ms, summed over the tasks of the search, but for QUEUE, the mean wait of a task
+    double
+    Get(SearchPhase phase) const;
+
+    // observes the phases the search went through into the search_phase_latency histograms of index_type
+    void
+    Observe(const std::string& index_type) const;
+
+    static SearchPhaseRecorder*
+    Current() {
+        return current_;
+    }
+
+ private:
+    friend class ScopedSearchPhaseRecorder;
+
+    std::array<std::atomic<int64_t>, kNumSearchPhases> ns_{};
+    std::atomic<int64_t> queued_tasks_ = 0;
+
+    inline static thread_local SearchPhaseRecorder* current_ = nullptr;
+};
+
+// Sets the recorder of the calling thread for its lifetime
+class ScopedSearchPhaseRecorder {
+ public:
+    explicit ScopedSearchPhaseRecorder(SearchPhaseRecorder* recorder) : recorder_before_(SearchPhaseRecorder::current_) {
+        SearchPhaseRecorder::current_ = recorder;
+    }
+
+    ScopedSearchPhaseRecorder(const ScopedSearchPhaseRecorder&) = delete;
+    ScopedSearchPhaseRecorder&
+    operator=(const ScopedSearchPhaseRecorder&) = delete;
+
+    ~ScopedSearchPhaseRecorder() {
+        SearchPhaseRecorder::current_ = recorder_before_;
+    }
+
+ private:
+    SearchPhaseRecorder* const recorder_before_;
+};
+
+// Adds the time of its scope to a phase of the recorder of the calling thread, and traces it as a child span of a
+// sampled search
+class ScopedSearchPhase {
+    using Clock = std::chrono::steady_clock;
+
+ public:
+    explicit ScopedSearchPhase(SearchPhase phase)
+        : recorder_(SearchPhaseRecorder::Current()), phase_(phase), span_(SearchPhaseName(phase)) {
+        if (recorder_ != nullptr) {
+            start_ = Clock::now();
+        }
+    }
+
+    ScopedSearchPhase(const ScopedSearchPhase&) = delete;
+    ScopedSearchPhase&
+    operator=(const ScopedSearchPhase&) = delete;
+
+    ~ScopedSearchPhase() {
+        if (recorder_ != nullptr) {
+            recorder_->Add(phase_, Clock::now() - start_);
+        }
+    }
+
+ private:
+    SearchPhaseRecorder* const recorder_;
+    const SearchPhase phase_;
+    Clock::time_point start_;
+    ScopedTraceSpan span_;
+};
+
+}  // namespace knowhere
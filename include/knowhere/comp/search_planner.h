@@ -0,0 +1,106 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "knowhere/bitsetview.h"
+
+namespace knowhere {
+
+enum class SearchPlan {
+    GRAPH = 0,
+    IVF,
+    BRUTE_FORCE,
+};
+
+// What a search knows before it starts. ef is the candidate list size of a graph search and nlist/nprobe describe an
+// IVF index, a plan whose parameters are 0 is not available to the index.
+struct SearchPlanInput {
+    int64_t ntotal = 0;
+    int64_t dim = 0;
+    int64_t filtered_out_num = 0;
+    int64_t k = 0;
+    int64_t ef = 0;
+    int64_t nlist = 0;
+    int64_t nprobe = 0;
+
+    static SearchPlanInput
+    FromBitset(int64_t ntotal, int64_t dim, int64_t k, const BitsetView& bitset) {
+        SearchPlanInput input;
+        input.ntotal = ntotal;
+        input.dim = dim;
+        input.k = k;
+        input.filtered_out_num = bitset.empty() ? 0 : bitset.count();
+        return input;
+    }
+};
+
+// The cost of a plan is its coefficient times its work, in distance computations of one dimension:
+//   graph:       min(ntotal, max(ef, k) * (1 + log2(ntotal)) / valid ratio) visited rows
+//   ivf:         nlist centroids and nprobe / nlist of the rows
+//   brute force: the valid rows, and a dimension for every filtered out row to skip it
+// The coefficients carry the cost of the random accesses of the graph against the sequential scans, and are in
+// milliseconds once calibrated from benchmark runs with SearchPlanner::Calibrate().
+struct SearchCostModel {
+    double graph = 4.0;
+    double ivf = 1.0;
+    double brute_force = 1.0;
+};
+
+struct SearchPlanCost {
+    SearchPlan plan = SearchPlan::BRUTE_FORCE;
+    // negative for the plans that are not available
+    double graph = -1.0;
+    double ivf = -1.0;
+    double brute_force = -1.0;
+};
+
+// a measured search, for the calibration
+struct SearchPlanSample {
+    SearchPlanInput input;
+    SearchPlan plan;
+    double latency_ms;
+};
+
+// Picks the cheapest plan of a search from the size of the index, the density of the bitset, k and ef or nprobe. It
+// is off by default, then the indexes keep their fixed thresholds.
+class SearchPlanner {
+ public:
+    static void
+    SetEnabled(bool enabled);
+
+    static bool
+    Enabled();
+
+    static void
+    SetCostModel(const SearchCostModel& model);
+
+    static SearchCostModel
+    GetCostModel();
+
+    // the costs of the available plans and the cheapest of them, the choice is counted in the metrics
+    static SearchPlanCost
+    Plan(const SearchPlanInput& input);
+
+    // the costs with a given model, nothing is recorded
+    static SearchPlanCost
+    Estimate(const SearchPlanInput& input, const SearchCostModel& model);
+
+    // least squares fit of the coefficient of every plan to the measured latencies, the plans without samples keep
+    //   the coefficients of base, which should then be in milliseconds too
+    static SearchCostModel
+    Calibrate(const std::vector<SearchPlanSample>& samples, const SearchCostModel& base = SearchCostModel());
+};
+
+}  // namespace knowhere
@@ -0,0 +1,41 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace knowhere {
+
+// The work a search did for one of its queries. A search with the search_stats config returns a
+// std::vector<SearchStats>, one per query, as meta::SEARCH_STATS of its results. The counters that do not apply to an
+// index stay at 0.
+struct SearchStats {
+    // distances computed, for sparse indexes the postings of the probed lists
+    int64_t ndis = 0;
+    // graph nodes expanded
+    int64_t nhops = 0;
+    // IVF lists or sparse posting lists probed
+    int64_t nlist = 0;
+    // reads issued to the disk, of one or more sectors
+    int64_t n_ios = 0;
+    // candidates whose distances were recomputed by a refine
+    int64_t nrefine = 0;
+    // whether the filter made the search scan the valid rows instead of the index
+    bool bf_fallback = false;
+    // whether the search stopped at its budget before its results were known to be exact
+    bool early_terminated = false;
+};
+
+using SearchStatsVec = std::vector<SearchStats>;
+
+}  // namespace knowhere
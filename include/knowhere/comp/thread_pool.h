@@ -22,6 +22,7 @@
 #include <cblas.h>
 #endif
 
+#include <pthread.h>
 #include <sys/resource.h>
 #if __GLIBC__ == 2 && __GLIBC_MINOR__ < 30
 #include <sys/syscall.h>
@@ -29,15 +30,28 @@
 #endif
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "folly/executors/CPUThreadPoolExecutor.h"
+#include "folly/executors/task_queue/PriorityLifoSemMPMCQueue.h"
 #include "folly/executors/task_queue/UnboundedBlockingQueue.h"
 #include "folly/futures/Future.h"
+#include "knowhere/comp/cancellation.h"
+#include "knowhere/comp/numa.h"
+#include "knowhere/comp/search_arena.h"
+#include "knowhere/comp/search_phases.h"
+#include "knowhere/comp/trace_span.h"
 #include "knowhere/expected.h"
 #include "knowhere/log.h"
 
@@ -45,9 +59,50 @@ namespace knowhere {
 
 class ThreadPool {
  public:
-    enum class QueueType { LIFO, FIFO };
-#ifdef __linux__
+    // PRIORITY keeps a queue per TaskPriority, a worker takes the pending tasks of a higher priority first
+    enum class QueueType { LIFO, FIFO, PRIORITY };
+    // the classes of the search tasks, the values are folly priorities
+    enum class TaskPriority : int8_t { BATCH = -1, ITERATOR = 0, INTERACTIVE = 1 };
+
  private:
+    // the cpus the threads of a pool are pinned to, all of them if it is empty. The factory pins the new threads, the
+    // others pin themselves again when they start a task after a change.
+    struct CpuAffinity {
+        explicit CpuAffinity(std::vector<int> cpus) : cpus(std::move(cpus)) {
+        }
+        std::mutex mutex;
+        std::vector<int> cpus;
+        std::atomic<uint64_t> version = 0;
+    };
+
+    static void
+    PinCurrentThread(CpuAffinity& affinity) {
+        std::vector<int> cpus;
+        uint64_t version = 0;
+        {
+            std::lock_guard<std::mutex> lock(affinity.mutex);
+            cpus = affinity.cpus;
+            version = affinity.version.load();
+        }
+#ifdef __linux__
+        // the threads of a pool that was never pinned keep the affinity they inherit
+        if (!cpus.empty() || version != 0) {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (cpus.empty() || std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+                    CPU_SET(cpu, &cpu_set);
+                }
+            }
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+                LOG_KNOWHERE_WARNING_ << "Failed to set cpu affinity of knowhere thread.";
+            }
+        }
+#endif
+        applied_cpu_version_ = version;
+    }
+
+#ifdef __linux__
     class CustomPriorityThreadFactory : public folly::NamedThreadFactory {
      public:
         using folly::NamedThreadFactory::NamedThreadFactory;
@@ -67,50 +122,43 @@ class ThreadPool {
                 } else {
                     LOG_KNOWHERE_INFO_ << "Successfully set priority of knowhere thread.";
                 }
+                PinCurrentThread(*affinity_);
                 func();
             });
         }
 
-        explicit CustomPriorityThreadFactory(const std::string& thread_name_prefix, int thread_priority)
-            : folly::NamedThreadFactory(thread_name_prefix), thread_priority_(thread_priority) {
+        explicit CustomPriorityThreadFactory(const std::string& thread_name_prefix, int thread_priority,
+                                             std::shared_ptr<CpuAffinity> affinity)
+            : folly::NamedThreadFactory(thread_name_prefix),
+              thread_priority_(thread_priority),
+              affinity_(std::move(affinity)) {
             assert(thread_priority_ >= -20 && thread_priority_ < 20);
         }
 
      private:
         int thread_priority_;
+        std::shared_ptr<CpuAffinity> affinity_;
     };
 
  public:
+    // the threads are pinned to `cpus`, unless it is empty
     explicit ThreadPool(uint32_t num_threads, const std::string& thread_name_prefix, QueueType queueT = QueueType::LIFO,
-                        int thread_priority = 10)
-        : pool_(queueT == QueueType::LIFO
-                    ? folly::CPUThreadPoolExecutor(
-                          num_threads,
-                          std::make_unique<folly::LifoSemMPMCQueue<folly::CPUThreadPoolExecutor::CPUTask,
-                                                                   folly::QueueBehaviorIfFull::BLOCK>>(
-                              num_threads * kTaskQueueFactor),
-                          std::make_shared<CustomPriorityThreadFactory>(thread_name_prefix, thread_priority))
-                    : folly::CPUThreadPoolExecutor(
-                          num_threads,
-                          std::make_unique<folly::UnboundedBlockingQueue<folly::CPUThreadPoolExecutor::CPUTask>>(),
-                          std::make_shared<CustomPriorityThreadFactory>(thread_name_prefix, thread_priority))) {
+                        int thread_priority = 10, std::vector<int> cpus = {})
+        : queue_type_(queueT),
+          affinity_(std::make_shared<CpuAffinity>(std::move(cpus))),
+          pool_(num_threads, CreateTaskQueue(queueT, num_threads),
+                std::make_shared<CustomPriorityThreadFactory>(thread_name_prefix, thread_priority, affinity_)) {
     }
 #else
  public:
-    // `thread_priority` is linux only, the param is kept here to make signature same between linux & mac one
+    // `thread_priority` and `cpus` are linux only, the params are kept here to make signature same between linux & mac
+    // one
     explicit ThreadPool(uint32_t num_threads, const std::string& thread_name_prefix, QueueType queueT = QueueType::LIFO,
-                        int thread_priority = 10)
-        : pool_(queueT == QueueType::LIFO
-                    ? folly::CPUThreadPoolExecutor(
-                          num_threads,
-                          std::make_unique<folly::LifoSemMPMCQueue<folly::CPUThreadPoolExecutor::CPUTask,
-                                                                   folly::QueueBehaviorIfFull::BLOCK>>(
-                              num_threads * kTaskQueueFactor),
-                          std::make_shared<folly::NamedThreadFactory>(thread_name_prefix))
-                    : folly::CPUThreadPoolExecutor(
-                          num_threads,
-                          std::make_unique<folly::UnboundedBlockingQueue<folly::CPUThreadPoolExecutor::CPUTask>>(),
-                          std::make_shared<folly::NamedThreadFactory>(thread_name_prefix))) {
+                        int thread_priority = 10, std::vector<int> cpus = {})
+        : queue_type_(queueT),
+          affinity_(std::make_shared<CpuAffinity>(std::move(cpus))),
+          pool_(num_threads, CreateTaskQueue(queueT, num_threads),
+                std::make_shared<folly::NamedThreadFactory>(thread_name_prefix)) {
     }
 #endif
 
@@ -124,11 +172,42 @@ class ThreadPool {
     ThreadPool&
     operator=(ThreadPool&&) noexcept = delete;
 
+    // on a PRIORITY pool the task gets the priority of the ScopedTaskPriority of the calling thread. The task runs with
+    // the CancellationToken of the calling thread, and releases what it allocates from its SearchArena.
     template <typename Func, typename... Args>
     auto
     push(Func&& func, Args&&... args) {
+        auto cancellation = CancellationToken::Current();
+        auto phases = SearchPhaseRecorder::Current();
+        auto trace_parent = TraceParent::Current();
+        const auto enqueued = std::chrono::steady_clock::now();
+        if (queue_type_ == QueueType::PRIORITY) {
+            return folly::makeSemiFuture()
+                .via(folly::getKeepAliveToken(&pool_), static_cast<int8_t>(current_task_priority_))
+                .then([this, func = std::forward<Func>(func), cancellation, phases, trace_parent, enqueued,
+                       &args...](auto&&) mutable {
+                    RecordQueueWait(enqueued, phases);
+                    ApplyCpuAffinity();
+                    RunningTask running(this);
+                    ScopedCancellation scoped_cancellation(cancellation);
+                    ScopedSearchPhaseRecorder scoped_phases(phases);
+                    ScopedTraceParent scoped_trace(trace_parent);
+                    ScopedSearchArena scoped_arena;
+                    return func(std::forward<Args>(args)...);
+                });
+        }
         return folly::makeSemiFuture().via(&pool_).then(
-            [func = std::forward<Func>(func), &args...](auto&&) mutable { return func(std::forward<Args>(args)...); });
+            [this, func = std::forward<Func>(func), cancellation, phases, trace_parent, enqueued,
+             &args...](auto&&) mutable {
+                RecordQueueWait(enqueued, phases);
+                ApplyCpuAffinity();
+                RunningTask running(this);
+                ScopedCancellation scoped_cancellation(cancellation);
+                ScopedSearchPhaseRecorder scoped_phases(phases);
+                ScopedTraceParent scoped_trace(trace_parent);
+                ScopedSearchArena scoped_arena;
+                return func(std::forward<Args>(args)...);
+            });
     }
 
     [[nodiscard]] size_t
@@ -146,6 +225,76 @@ class ThreadPool {
         return pool_;
     }
 
+    // the moving average of the time the tasks wait in the queue
+    std::chrono::microseconds
+    GetQueueWait() const {
+        return std::chrono::microseconds(queue_wait_us_.load(std::memory_order_relaxed));
+    }
+
+    // Whether a search of `priority` may push its tasks, Status::overloaded once the pending tasks or the queue wait
+    // reach the limits of SetSearchAdmission(). BATCH searches are shed at half the limits, so that the room left goes
+    // to the interactive ones.
+    Status
+    Admit(TaskPriority priority) {
+        const size_t max_pending_tasks = max_pending_tasks_.load();
+        const int64_t max_queue_wait_us = max_queue_wait_us_.load();
+        if (max_pending_tasks == 0 && max_queue_wait_us == 0) {
+            return Status::success;
+        }
+        const size_t pending_tasks = GetPendingTaskCount();
+        // the wait is only measured when tasks are taken, an idle queue must not keep its last value
+        if (pending_tasks == 0) {
+            return Status::success;
+        }
+        const size_t shed = priority == TaskPriority::BATCH ? 2 : 1;
+        if ((max_pending_tasks > 0 && pending_tasks >= max_pending_tasks / shed) ||
+            (max_queue_wait_us > 0 && GetQueueWait().count() >= max_queue_wait_us / (int64_t)shed)) {
+            return Status::overloaded;
+        }
+        return Status::success;
+    }
+
+    // Into how many tasks a search splits each of its `nq` queries, with `work` rows to score per query. The idle
+    // workers are shared by the queries, so one large query uses many of them at low load, while under load, or with
+    // as many queries as workers, every query is a single task. A piece gets at least kMinSplitWork rows.
+    size_t
+    QuerySplits(size_t nq, size_t work) const {
+        const size_t busy = running_tasks_.load(std::memory_order_relaxed) + pool_.getPendingTaskCount();
+        const size_t threads = pool_.numThreads();
+        if (nq == 0 || busy + nq >= threads) {
+            return 1;
+        }
+        return std::clamp<size_t>(std::min((threads - busy) / nq, work / kMinSplitWork), 1, threads);
+    }
+
+    // the limits of Admit(), 0 disables one
+    static void
+    SetSearchAdmission(size_t max_pending_tasks, std::chrono::microseconds max_queue_wait) {
+        max_pending_tasks_.store(max_pending_tasks);
+        max_queue_wait_us_.store(max_queue_wait.count());
+    }
+
+    // pins the threads to `cpus`, or unpins them if it is empty. A busy thread moves once its task is done, the
+    //   threads of a later resize start on the new cpus.
+    void
+    SetCpus(std::vector<int> cpus) {
+        std::lock_guard<std::mutex> lock(affinity_->mutex);
+        affinity_->cpus = std::move(cpus);
+        affinity_->version++;
+    }
+
+    std::vector<int>
+    GetCpus() const {
+        std::lock_guard<std::mutex> lock(affinity_->mutex);
+        return affinity_->cpus;
+    }
+
+    // whether the calling thread runs a task of this pool
+    bool
+    IsWorkerThread() const {
+        return current_pool_ == this;
+    }
+
     void
     SetNumThreads(uint32_t num_threads) {
         if (num_threads == 0) {
@@ -179,7 +328,8 @@ class ThreadPool {
         if (build_pool_ == nullptr) {
             std::lock_guard<std::mutex> lock(build_pool_mutex_);
             if (build_pool_ == nullptr) {
-                build_pool_ = std::make_shared<ThreadPool>(num_threads, "knowhere_build");
+                build_pool_ = std::make_shared<ThreadPool>(num_threads, "knowhere_build", QueueType::LIFO, 10,
+                                                           build_pool_cpus_);
                 LOG_KNOWHERE_INFO_ << "Init global build thread pool with size " << num_threads;
                 return;
             }
@@ -199,7 +349,8 @@ class ThreadPool {
         if (search_pool_ == nullptr) {
             std::lock_guard<std::mutex> lock(search_pool_mutex_);
             if (search_pool_ == nullptr) {
-                search_pool_ = std::make_shared<ThreadPool>(num_threads, "knowhere_search");
+                search_pool_ = std::make_shared<ThreadPool>(num_threads, "knowhere_search", QueueType::PRIORITY, 10,
+                                                            search_pool_cpus_);
                 LOG_KNOWHERE_INFO_ << "Init global search thread pool with size " << num_threads;
                 return;
             }
@@ -238,6 +389,27 @@ class ThreadPool {
         }
     }
 
+    // the cpus of the global build thread pool, applied when it is created if it is not yet
+    static void
+    SetGlobalBuildThreadPoolCpus(std::vector<int> cpus) {
+        std::lock_guard<std::mutex> lock(build_pool_mutex_);
+        build_pool_cpus_ = cpus;
+        if (build_pool_ != nullptr) {
+            build_pool_->SetCpus(std::move(cpus));
+        }
+    }
+
+    // the cpus of the global search thread pool, applied when it is created if it is not yet. The NUMA search thread
+    //   pools stay on the cpus of their nodes.
+    static void
+    SetGlobalSearchThreadPoolCpus(std::vector<int> cpus) {
+        std::lock_guard<std::mutex> lock(search_pool_mutex_);
+        search_pool_cpus_ = cpus;
+        if (search_pool_ != nullptr) {
+            search_pool_->SetCpus(std::move(cpus));
+        }
+    }
+
     static size_t
     GetGlobalSearchThreadPoolSize() {
         return (search_pool_ == nullptr ? 0 : search_pool_->size());
@@ -261,14 +433,65 @@ class ThreadPool {
         return build_pool_;
     }
 
+    // runs the async searches of Index, which wait on the tasks they push to the search thread pool. Keeping them
+    // off the search thread pool keeps its workers from all waiting on tasks queued behind them.
+    static std::shared_ptr<ThreadPool>
+    GetGlobalAsyncSearchThreadPool() {
+        if (async_search_pool_ == nullptr) {
+            std::lock_guard<std::mutex> lock(async_search_pool_mutex_);
+            if (async_search_pool_ == nullptr) {
+                async_search_pool_ = std::make_shared<ThreadPool>(std::thread::hardware_concurrency(),
+                                                                  "knowhere_async", QueueType::FIFO);
+            }
+        }
+        return async_search_pool_;
+    }
+
+    // the search thread pool of the NUMA node of the ScopedNumaNode of the calling thread, when there are NUMA
+    // search thread pools, or else the global one
     static std::shared_ptr<ThreadPool>
     GetGlobalSearchThreadPool() {
+        if (current_numa_node_ >= 0) {
+            std::shared_lock lock(numa_search_pools_mutex_);
+            if ((size_t)current_numa_node_ < numa_search_pools_.size()) {
+                return numa_search_pools_[current_numa_node_];
+            }
+        }
         if (search_pool_ == nullptr) {
             InitGlobalSearchThreadPool(std::thread::hardware_concurrency());
         }
         return search_pool_;
     }
 
+    // creates a search thread pool for every NUMA node, pinned to its cpus, with an even part of `num_threads`
+    static void
+    InitNumaSearchThreadPools(uint32_t num_threads) {
+        const int node_count = numa::NodeCount();
+        std::vector<std::shared_ptr<ThreadPool>> pools;
+        for (int node = 0; node < node_count && node_count > 1; node++) {
+            pools.push_back(std::make_shared<ThreadPool>(std::max<uint32_t>(1, num_threads / node_count),
+                                                         "knowhere_search_n" + std::to_string(node),
+                                                         QueueType::PRIORITY, 10, numa::NodeCpus(node)));
+        }
+        std::unique_lock lock(numa_search_pools_mutex_);
+        numa_search_pools_ = std::move(pools);
+        LOG_KNOWHERE_INFO_ << "Init " << numa_search_pools_.size() << " NUMA search thread pools";
+    }
+
+    // routes the search tasks pushed by the calling thread to the search thread pool of `node`, if it is not -1
+    class ScopedNumaNode {
+        int node_before;
+
+     public:
+        explicit ScopedNumaNode(int node) {
+            node_before = current_numa_node_;
+            current_numa_node_ = node;
+        }
+        ~ScopedNumaNode() {
+            current_numa_node_ = node_before;
+        }
+    };
+
     class ScopedBuildOmpSetter {
         int omp_before;
 #ifdef OPENBLAS_OS_LINUX
@@ -292,6 +515,32 @@ class ThreadPool {
         }
     };
 
+    static void
+    SetBatchSearchNq(size_t nq) {
+        batch_search_nq_.store(nq);
+    }
+
+    // the searches of at least this many queries push their tasks with TaskPriority::BATCH
+    static size_t
+    GetBatchSearchNq() {
+        return batch_search_nq_.load();
+    }
+
+    // sets the priority of the tasks pushed by the current thread. It is not carried into the tasks, whatever they
+    // push is INTERACTIVE unless they set their own.
+    class ScopedTaskPriority {
+        TaskPriority priority_before;
+
+     public:
+        explicit ScopedTaskPriority(TaskPriority priority) {
+            priority_before = current_task_priority_;
+            current_task_priority_ = priority;
+        }
+        ~ScopedTaskPriority() {
+            current_task_priority_ = priority_before;
+        }
+    };
+
     class ScopedSearchOmpSetter {
         int omp_before;
 
@@ -306,15 +555,89 @@ class ThreadPool {
     };
 
  private:
+    static std::unique_ptr<folly::BlockingQueue<folly::CPUThreadPoolExecutor::CPUTask>>
+    CreateTaskQueue(QueueType queueT, uint32_t num_threads) {
+        using CPUTask = folly::CPUThreadPoolExecutor::CPUTask;
+        switch (queueT) {
+            case QueueType::LIFO:
+                return std::make_unique<folly::LifoSemMPMCQueue<CPUTask, folly::QueueBehaviorIfFull::BLOCK>>(
+                    num_threads * kTaskQueueFactor);
+            case QueueType::PRIORITY:
+                return std::make_unique<folly::PriorityLifoSemMPMCQueue<CPUTask, folly::QueueBehaviorIfFull::BLOCK>>(
+                    kNumTaskPriorities, num_threads * kTaskQueueFactor);
+            default:
+                return std::make_unique<folly::UnboundedBlockingQueue<CPUTask>>();
+        }
+    }
+
+    void
+    RecordQueueWait(std::chrono::steady_clock::time_point enqueued, SearchPhaseRecorder* phases) {
+        const auto wait = std::chrono::steady_clock::now() - enqueued;
+        if (phases != nullptr) {
+            phases->Add(SearchPhase::QUEUE, wait);
+        }
+        const int64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+        // racy updates only lose a sample
+        const int64_t avg = queue_wait_us_.load(std::memory_order_relaxed);
+        queue_wait_us_.store(avg + (wait_us - avg) / kQueueWaitSmoothing, std::memory_order_relaxed);
+    }
+
+    // counts the tasks being run, and marks the thread as running a task of pool
+    struct RunningTask {
+        explicit RunningTask(ThreadPool* pool) : pool_(pool), outer_pool_(current_pool_) {
+            pool_->running_tasks_.fetch_add(1, std::memory_order_relaxed);
+            current_pool_ = pool_;
+        }
+        ~RunningTask() {
+            current_pool_ = outer_pool_;
+            pool_->running_tasks_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        ThreadPool* pool_;
+        const ThreadPool* outer_pool_;
+    };
+
+    void
+    ApplyCpuAffinity() {
+        if (affinity_->version.load(std::memory_order_relaxed) != applied_cpu_version_) {
+            PinCurrentThread(*affinity_);
+        }
+    }
+
+    const QueueType queue_type_;
+    std::atomic<int64_t> queue_wait_us_ = 0;
+    std::atomic<size_t> running_tasks_ = 0;
+    // before pool_, its thread factory shares it
+    std::shared_ptr<CpuAffinity> affinity_;
     folly::CPUThreadPoolExecutor pool_;
 
     inline static std::mutex build_pool_mutex_;
     inline static std::shared_ptr<ThreadPool> build_pool_ = nullptr;
+    inline static std::vector<int> build_pool_cpus_;
 
     inline static std::mutex search_pool_mutex_;
     inline static std::shared_ptr<ThreadPool> search_pool_ = nullptr;
+    inline static std::vector<int> search_pool_cpus_;
+
+    inline static std::mutex async_search_pool_mutex_;
+    inline static std::shared_ptr<ThreadPool> async_search_pool_ = nullptr;
+
+    inline static std::shared_mutex numa_search_pools_mutex_;
+    inline static std::vector<std::shared_ptr<ThreadPool>> numa_search_pools_;
+
+    inline static thread_local TaskPriority current_task_priority_ = TaskPriority::INTERACTIVE;
+    inline static thread_local int current_numa_node_ = -1;
+    // the pool whose task the calling thread runs, if any
+    inline static thread_local const ThreadPool* current_pool_ = nullptr;
+    // the CpuAffinity version the calling worker thread is pinned to
+    inline static thread_local uint64_t applied_cpu_version_ = 0;
+    inline static std::atomic<size_t> batch_search_nq_ = 1024;
+    inline static std::atomic<size_t> max_pending_tasks_ = 0;
+    inline static std::atomic<int64_t> max_queue_wait_us_ = 0;
 
     constexpr static size_t kTaskQueueFactor = 16;
+    constexpr static uint8_t kNumTaskPriorities = 3;
+    constexpr static int64_t kQueueWaitSmoothing = 8;
+    constexpr static size_t kMinSplitWork = 16384;
 };
 
 // T is either folly::Unit or Status
@@ -364,4 +687,21 @@ class ThreadPoolWrapper {
     bool use_pool_;
 };
 
+// The build pool for the tasks pushed by a task of the build pool, that are then run inline. A task that waits for the
+//   tasks it pushed to its own pool holds a thread, the loads of Index::DeserializeAll() would hold all of them.
+inline ThreadPoolWrapper
+NestedBuildThreadPool() {
+    auto pool = ThreadPool::GetGlobalBuildThreadPool();
+    const bool use_pool = !pool->IsWorkerThread();
+    return ThreadPoolWrapper(pool, use_pool);
+}
+
+// The search pool counterpart of NestedBuildThreadPool()
+inline ThreadPoolWrapper
+NestedSearchThreadPool() {
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    const bool use_pool = !pool->IsWorkerThread();
+    return ThreadPoolWrapper(pool, use_pool);
+}
+
 }  // namespace knowhere
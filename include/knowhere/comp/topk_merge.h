@@ -0,0 +1,49 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// The top-k of a query in nq rows of k results each, sorted from the closest, as returned by a search. The rows may
+//   end with -1 ids.
+struct TopkSegment {
+    const int64_t* ids = nullptr;
+    const float* distances = nullptr;
+    int64_t k = 0;
+    // the group of every result, for TopkMergeOptions::group_size
+    const int64_t* group_ids = nullptr;
+};
+
+struct TopkMergeOptions {
+    // true for the similarities, such as IP, COSINE and BM25
+    bool larger_is_closer = false;
+    // keeps the closest result of every id only, for the ids that are primary keys found in several segments
+    bool dedup = false;
+    // keeps at most group_size results per group if > 0, every segment then needs group_ids
+    int64_t group_size = 0;
+    // the queries are merged in parallel on the search thread pool from this nq on
+    int64_t parallel_nq = 64;
+};
+
+// Merges the top-k of the segments into the k closest results per query, with a tournament tree over the rows of
+//   the segments: a result costs log2(segments) comparisons, not a pass over all the segments. The ties go to the
+//   segment that comes first. The rows with less than k results end with -1 ids and the worst distance.
+Status
+MergeTopk(const std::vector<TopkSegment>& segments, int64_t nq, int64_t k, const TopkMergeOptions& options,
+          int64_t* ids, float* distances);
+
+}  // namespace knowhere
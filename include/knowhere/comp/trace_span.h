@@ -0,0 +1,116 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+#include "knowhere/tracer.h"
+#endif
+
+namespace knowhere {
+
+// the most child spans a traced call starts, a search of many queries traces its first tasks only
+constexpr int64_t kMaxChildSpans = 256;
+
+// The span of a sampled Index<T> call, that the stages of the call start their child spans under. Index<T> sets it for
+// the calling thread, the search thread pool hands it to the tasks of the call.
+class TraceParent {
+ public:
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    explicit TraceParent(std::shared_ptr<tracer::trace::Span> span) : span_(std::move(span)) {
+    }
+
+    const std::shared_ptr<tracer::trace::Span>&
+    Span() const {
+        return span_;
+    }
+#endif
+
+    // whether one more child span may start
+    bool
+    TakeSpan() {
+        return spans_left_.fetch_sub(1, std::memory_order_relaxed) > 0;
+    }
+
+    static TraceParent*
+    Current() {
+        return current_;
+    }
+
+ private:
+    friend class ScopedTraceParent;
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    const std::shared_ptr<tracer::trace::Span> span_;
+#endif
+    std::atomic<int64_t> spans_left_ = kMaxChildSpans;
+
+    inline static thread_local TraceParent* current_ = nullptr;
+};
+
+// Sets the trace parent of the calling thread for its lifetime
+class ScopedTraceParent {
+ public:
+    explicit ScopedTraceParent(TraceParent* parent) : parent_before_(TraceParent::current_) {
+        TraceParent::current_ = parent;
+    }
+
+    ScopedTraceParent(const ScopedTraceParent&) = delete;
+    ScopedTraceParent&
+    operator=(const ScopedTraceParent&) = delete;
+
+    ~ScopedTraceParent() {
+        TraceParent::current_ = parent_before_;
+    }
+
+ private:
+    TraceParent* const parent_before_;
+};
+
+// A child span of the trace parent of the calling thread for the lifetime of its scope. The calls that are not sampled
+// have no parent, the span then only reads a thread local.
+class ScopedTraceSpan {
+ public:
+    explicit ScopedTraceSpan(const char* name) {
+        if (auto parent = TraceParent::Current(); parent != nullptr) {
+            Start(*parent, name);
+        }
+    }
+
+    ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+    ScopedTraceSpan&
+    operator=(const ScopedTraceSpan&) = delete;
+
+    ~ScopedTraceSpan() {
+        if (span_ != nullptr) {
+            End();
+        }
+    }
+
+    void
+    SetAttribute(const char* key, int64_t value);
+
+ private:
+    void
+    Start(TraceParent& parent, const char* name);
+
+    void
+    End();
+
+    // a tracer::trace::Span, opaque to keep opentelemetry out of the light builds
+    std::shared_ptr<void> span_;
+};
+
+}  // namespace knowhere
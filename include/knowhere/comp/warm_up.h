@@ -0,0 +1,51 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// A range of the memory of an index that is mapped from a file
+struct MappedRegion {
+    const void* data;
+    size_t size;
+    // the graph or the centroids a search starts from, rather than the bulk of the codes or the raw data
+    bool structure;
+};
+
+enum class WarmUpLevel {
+    NONE = 0,
+    // the structure regions only
+    STRUCTURE = 1,
+    ALL = 2,
+};
+
+// Pages in the regions of level, the structure regions first. The regions are split in chunks that are faulted in
+//   concurrently on the build thread pool, the bytes left are reported by the warm_up_pending_size gauge.
+Status
+WarmUpRegions(const std::vector<MappedRegion>& regions, WarmUpLevel level);
+
+// lets the kernel drop the pages of the regions, that are read from the file again on the next access
+Status
+CoolDownRegions(const std::vector<MappedRegion>& regions);
+
+// asks the kernel to read the pages of the regions ahead without waiting for them, e.g. the rows of a batch of a bulk
+//   read right before they are copied. The regions whose pages touch are advised together. Only a hint, it fails
+//   silently.
+void
+AdviseWillNeed(const std::vector<MappedRegion>& regions);
+
+}  // namespace knowhere
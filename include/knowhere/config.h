@@ -14,6 +14,7 @@
 
 #include <omp.h>
 
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <list>
@@ -550,6 +551,57 @@ class Config {
         return cfg.CheckAndAdjust(type, err_msg);
     }
 
+    // copies the values of src into the entries of the same names of dst, a config of the same class that has its own
+    //   entries. Nothing is parsed or checked again.
+    static void
+    CopyValues(const Config& src, Config& dst) {
+        for (const auto& it : src.__DICT__) {
+            auto dst_it = dst.__DICT__.find(it.first);
+            if (dst_it == dst.__DICT__.end()) {
+                continue;
+            }
+            std::visit(
+                [&dst_it](const auto& src_entry) {
+                    using EntryT = std::decay_t<decltype(src_entry)>;
+                    if (auto* dst_entry = std::get_if<EntryT>(&dst_it->second); dst_entry != nullptr) {
+                        *dst_entry->val = *src_entry.val;
+                    }
+                },
+                it.second);
+        }
+    }
+
+    // a hash of the values of cfg, equal for the configs of a class that hold the same values. The trace context is
+    //   left out, it does not change what a search returns, and so is the bitset version, which keys a result cache
+    //   on its own.
+    static uint64_t
+    Fingerprint(const Config& cfg) {
+        uint64_t fingerprint = 0;
+        for (const auto& it : cfg.__DICT__) {
+            if (it.first == "trace_id" || it.first == "span_id" || it.first == "trace_flags" ||
+                it.first == "bitset_version") {
+                continue;
+            }
+            const size_t value_hash = std::visit(
+                [](const auto& entry) -> size_t {
+                    using ValueT = typename std::decay_t<decltype(*entry.val)>::value_type;
+                    if (!entry.val->has_value()) {
+                        return 0;
+                    }
+                    if constexpr (std::is_same_v<ValueT, MaterializedViewSearchInfo>) {
+                        return std::hash<std::string>{}(Json(entry.val->value()).dump());
+                    } else {
+                        return std::hash<ValueT>{}(entry.val->value()) * 0x9e3779b97f4a7c15ULL + 1;
+                    }
+                },
+                it.second);
+            // a sum does not depend on the order of the entries
+            uint64_t h = (std::hash<std::string>{}(it.first) ^ value_hash) * 0xff51afd7ed558ccdULL;
+            fingerprint += h ^ (h >> 33);
+        }
+        return fingerprint;
+    }
+
     virtual ~Config() {
     }
 
@@ -604,6 +656,8 @@ class BaseConfig : public Config {
     CFG_BOOL trace_visit;
     CFG_BOOL enable_mmap;
     CFG_BOOL enable_mmap_pop;
+    CFG_BOOL lazy_load_raw_data;
+    CFG_BOOL use_huge_pages;
     CFG_BOOL shuffle_build;
     CFG_STRING trace_id;
     CFG_STRING span_id;
@@ -611,6 +665,20 @@ class BaseConfig : public Config {
     CFG_MATERIALIZED_VIEW_SEARCH_INFO_TYPE materialized_view_search_info;
     CFG_STRING opt_fields_path;
     CFG_FLOAT iterator_refine_ratio;
+    // whether a search stopped by its CancellationToken returns the results found so far rather than an error
+    CFG_BOOL partial_results;
+    // whether a search returns the stats of its queries as meta::SEARCH_STATS
+    CFG_BOOL search_stats;
+    // the number of nearest rows every query embedding of an embedding list search retrieves, as a multiple of k
+    CFG_FLOAT emb_list_candidates_ratio;
+    // the rows a group-by search returns per group, k being the number of groups
+    CFG_INT group_size;
+    // the version of the bitset of a search, which changes whenever the rows it filters out do. The results of a
+    //   search with a bitset are cached only with a version, see Index::EnableResultCache().
+    CFG_INT64 bitset_version;
+    // when set, the queries of a batch within this relative L2 distance of each other are searched once, 0 collapses
+    //   the identical ones only
+    CFG_FLOAT query_dedup_tolerance;
     /**
      * k1, b, avgdl are used by BM25 metric only.
      * - k1, b, avgdl must be provided at load time.
@@ -628,11 +696,17 @@ class BaseConfig : public Config {
      *    FLOAT16_QUANT, keep data as float16 vector in memory in refiner
      *    BFLOAT16_QUANT, keep data as bfloat16 vector in memory in refiner
      *    UINT8_QUANT, keep data as uint8 vector in memory in refiner
+     *    UINT4_QUANT, keep data as 4-bit vector in memory in refiner
      * - refine_with_quant, search parameter, whether to use quantized data to refine, faster but lost a little
      * precision
+     * - pre_refine_type, train parameter, a cheaper quant type that shrinks the candidates before the refine,
+     * DATA_VIEW for none
+     * - pre_refine_ratio, search parameter, the candidates kept by the pre refine, as a multiple of k
      */
     CFG_INT refine_type;
     CFG_BOOL refine_with_quant;
+    CFG_INT pre_refine_type;
+    CFG_FLOAT pre_refine_ratio;
     /*
      * mh_lsh_band is a special parameters of BF search and MinHash index node train.
      */
@@ -640,7 +714,11 @@ class BaseConfig : public Config {
     CFG_BOOL mh_search_with_jaccard;
     CFG_INT mh_element_bit_width;
     KNOHWERE_DECLARE_CONFIG(BaseConfig) {
-        KNOWHERE_CONFIG_DECLARE_FIELD(dim).allow_empty_without_default().description("vector dim").for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(dim)
+            .allow_empty_without_default()
+            .description("vector dim")
+            .for_train()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(metric_type)
             .set_default("L2")
             .description("metric type")
@@ -666,12 +744,23 @@ class BaseConfig : public Config {
         KNOWHERE_CONFIG_DECLARE_FIELD(vec_field_size_gb)
             .description("the size (in GB) of the raw vector data.")
             .set_default(0)
-            .for_train();
+            .for_train()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(k)
             .set_default(10)
             .description("search for top k similar vector.")
             .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
             .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(bitset_version)
+            .description("the version of the bitset of a search, for the result cache")
+            .allow_empty_without_default()
+            .set_range(0, std::numeric_limits<CFG_INT64::value_type>::max())
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(query_dedup_tolerance)
+            .description("the relative distance within which the queries of a batch are searched once")
+            .allow_empty_without_default()
+            .set_range(0.0f, 1.0f)
+            .for_search();
         KNOWHERE_CONFIG_DECLARE_FIELD(num_build_thread)
             .description("index thread limit for build.")
             .allow_empty_without_default()
@@ -711,6 +800,15 @@ class BaseConfig : public Config {
             .description("enable map_populate option for mmap")
             .for_deserialize()
             .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(lazy_load_raw_data)
+            .set_default(false)
+            .description("keep the raw data of a refine index mapped until it is read")
+            .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(use_huge_pages)
+            .set_default(false)
+            .description("back the large arrays of a loaded index with huge pages, rows cannot be added then")
+            .for_deserialize()
+            .for_deserialize_from_file();
         KNOWHERE_CONFIG_DECLARE_FIELD(shuffle_build)
             .set_default(true)
             .description("shuffle ids before index building")
@@ -719,17 +817,23 @@ class BaseConfig : public Config {
             .description("trace id")
             .allow_empty_without_default()
             .for_search()
-            .for_range_search();
+            .for_range_search()
+            .for_deserialize()
+            .for_deserialize_from_file();
         KNOWHERE_CONFIG_DECLARE_FIELD(span_id)
             .description("span id")
             .allow_empty_without_default()
             .for_search()
-            .for_range_search();
+            .for_range_search()
+            .for_deserialize()
+            .for_deserialize_from_file();
         KNOWHERE_CONFIG_DECLARE_FIELD(trace_flags)
             .set_default(0)
             .description("trace flags")
             .for_search()
-            .for_range_search();
+            .for_range_search()
+            .for_deserialize()
+            .for_deserialize_from_file();
         KNOWHERE_CONFIG_DECLARE_FIELD(materialized_view_search_info)
             .description("materialized view search info")
             .allow_empty_without_default()
@@ -745,6 +849,25 @@ class BaseConfig : public Config {
             .description("refine ratio for iterator")
             .for_iterator()
             .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(partial_results)
+            .set_default(false)
+            .description("whether a cancelled search returns the results found so far")
+            .for_search()
+            .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(search_stats)
+            .set_default(false)
+            .description("whether a search returns the stats of its queries")
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(emb_list_candidates_ratio)
+            .set_default(4.0f)
+            .description("the nearest rows of every query embedding of an embedding list search, as a multiple of k")
+            .set_range(1.0f, 1024.0f)
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(group_size)
+            .set_default(1)
+            .description("the rows a group-by search returns per group")
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_search();
         KNOWHERE_CONFIG_DECLARE_FIELD(retain_iterator_order)
             .set_default(false)
             .description("whether the result of iterator monotonically ordered")
@@ -787,6 +910,15 @@ class BaseConfig : public Config {
             .for_search()
             .for_range_search()
             .for_iterator();
+        KNOWHERE_CONFIG_DECLARE_FIELD(pre_refine_type)
+            .description("quant type of the pre refine, no pre refine by default")
+            .set_default(RefineType::DATA_VIEW)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(pre_refine_ratio)
+            .description("search parameters, the candidates kept by the pre refine as a multiple of k")
+            .set_default(2.0f)
+            .set_range(1.0f, std::numeric_limits<CFG_FLOAT::value_type>::max())
+            .for_search();
         KNOWHERE_CONFIG_DECLARE_FIELD(mh_lsh_band)
             .description("param of MinHashLSH")
             .set_default(1)
@@ -0,0 +1,243 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef DATA_SOURCE_H
+#define DATA_SOURCE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "knowhere/dataset.h"
+#include "knowhere/expected.h"
+#include "knowhere/operands.h"
+
+namespace knowhere {
+
+// the rows that a build from a DataSource reads at once, unless the source says otherwise
+constexpr int64_t kDefaultDataSourceChunkRows = 65536;
+// the rows of the sample that a build from a DataSource trains an index on by default
+constexpr int64_t kDefaultDataSourceTrainRows = 262144;
+
+// the bytes of a dense row of dim dimensions, the dim of binary vectors is in bits
+template <typename DataType>
+constexpr int64_t
+DenseRowBytes(int64_t dim) {
+    if constexpr (std::is_same_v<DataType, bin1>) {
+        return dim / 8;
+    } else {
+        return dim * static_cast<int64_t>(sizeof(DataType));
+    }
+}
+
+inline int64_t
+DenseRowBytes(DataFormatEnum format, int64_t dim) {
+    switch (format) {
+        case DataFormatEnum::fp16:
+            return DenseRowBytes<fp16>(dim);
+        case DataFormatEnum::bf16:
+            return DenseRowBytes<bf16>(dim);
+        case DataFormatEnum::int8:
+            return DenseRowBytes<int8>(dim);
+        case DataFormatEnum::bin1:
+            return DenseRowBytes<bin1>(dim);
+        default:
+            return DenseRowBytes<fp32>(dim);
+    }
+}
+
+// The rows of a dataset that is read chunk by chunk, so that an index can be built without holding all of them in
+//   memory along with itself, see Index::BuildFromSource(). Read() may be called from another thread than the one
+//   that builds the index, for the next chunk to be read while the current one is added.
+class DataSource {
+ public:
+    virtual ~DataSource() = default;
+
+    virtual int64_t
+    Rows() const = 0;
+
+    // as the dim of a DataSet, the number of columns of sparse rows
+    virtual int64_t
+    Dim() const = 0;
+
+    // whether the rows are sparse::SparseRow<float>, otherwise they are RowBytes() bytes each
+    virtual bool
+    IsSparse() const {
+        return false;
+    }
+
+    virtual int64_t
+    RowBytes() const = 0;
+
+    virtual int64_t
+    ChunkRows() const {
+        return kDefaultDataSourceChunkRows;
+    }
+
+    // the rows [begin, begin + n), in a dataset that owns them or borrows memory that outlives it
+    virtual expected<DataSetPtr>
+    Read(int64_t begin, int64_t n) const = 0;
+};
+
+// a source whose chunks are produced by a callback, e.g. from an iterator over the segments of a remote file
+class CallbackDataSource : public DataSource {
+ public:
+    using ReadFunc = std::function<expected<DataSetPtr>(int64_t begin, int64_t n)>;
+
+    // sparse rows have no row bytes
+    CallbackDataSource(int64_t rows, int64_t dim, int64_t row_bytes, ReadFunc read, bool is_sparse = false,
+                       int64_t chunk_rows = kDefaultDataSourceChunkRows)
+        : rows_(rows),
+          dim_(dim),
+          row_bytes_(row_bytes),
+          read_(std::move(read)),
+          is_sparse_(is_sparse),
+          chunk_rows_(chunk_rows) {
+    }
+
+    int64_t
+    Rows() const override {
+        return rows_;
+    }
+
+    int64_t
+    Dim() const override {
+        return dim_;
+    }
+
+    bool
+    IsSparse() const override {
+        return is_sparse_;
+    }
+
+    int64_t
+    RowBytes() const override {
+        return row_bytes_;
+    }
+
+    int64_t
+    ChunkRows() const override {
+        return chunk_rows_;
+    }
+
+    expected<DataSetPtr>
+    Read(int64_t begin, int64_t n) const override {
+        return read_(begin, n);
+    }
+
+ private:
+    int64_t rows_;
+    int64_t dim_;
+    int64_t row_bytes_;
+    ReadFunc read_;
+    bool is_sparse_;
+    int64_t chunk_rows_;
+};
+
+// The dense rows of a file in the .bin layout of DiskANN, the row count and the dim as int32 followed by the rows,
+//   mapped read-only. A chunk is a view of the mapping, whose pages are fetched ahead when it is read.
+class MmapDataSource : public DataSource {
+ public:
+    template <typename DataType>
+    static expected<std::unique_ptr<MmapDataSource>>
+    Open(const std::string& path, int64_t chunk_rows = kDefaultDataSourceChunkRows) {
+        using Ret = expected<std::unique_ptr<MmapDataSource>>;
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return Ret::Err(Status::disk_file_error, "failed to open " + path);
+        }
+        struct stat st;
+        int32_t header[2] = {0, 0};
+        if (fstat(fd, &st) != 0 || pread(fd, header, sizeof(header), 0) != sizeof(header)) {
+            close(fd);
+            return Ret::Err(Status::disk_file_error, "failed to read the header of " + path);
+        }
+        const int64_t rows = header[0];
+        const int64_t dim = header[1];
+        const int64_t row_bytes = DenseRowBytes<DataType>(dim);
+        const size_t size = static_cast<size_t>(st.st_size);
+        if (rows < 0 || dim <= 0 || sizeof(header) + rows * row_bytes > size) {
+            close(fd);
+            return Ret::Err(Status::invalid_args, path + " is not a file of " + std::to_string(rows) + " rows of dim " +
+                                                      std::to_string(dim));
+        }
+        void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return Ret::Err(Status::disk_file_error, "failed to map " + path);
+        }
+        return std::unique_ptr<MmapDataSource>(
+            new MmapDataSource(static_cast<const uint8_t*>(data), size, rows, dim, row_bytes, chunk_rows));
+    }
+
+    ~MmapDataSource() override {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+
+    int64_t
+    Rows() const override {
+        return rows_;
+    }
+
+    int64_t
+    Dim() const override {
+        return dim_;
+    }
+
+    int64_t
+    RowBytes() const override {
+        return row_bytes_;
+    }
+
+    int64_t
+    ChunkRows() const override {
+        return chunk_rows_;
+    }
+
+    expected<DataSetPtr>
+    Read(int64_t begin, int64_t n) const override {
+        if (begin < 0 || n < 0 || begin + n > rows_) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "rows out of the range of the file");
+        }
+        const uint8_t* rows = data_ + kHeaderBytes + begin * row_bytes_;
+        // madvise() takes a page aligned address
+        const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const auto first = reinterpret_cast<uintptr_t>(rows) / page * page;
+        madvise(reinterpret_cast<void*>(first), reinterpret_cast<uintptr_t>(rows) - first + n * row_bytes_,
+                MADV_WILLNEED);
+        return GenDataSet(n, dim_, rows);
+    }
+
+ private:
+    static constexpr int64_t kHeaderBytes = 2 * sizeof(int32_t);
+
+    MmapDataSource(const uint8_t* data, size_t size, int64_t rows, int64_t dim, int64_t row_bytes, int64_t chunk_rows)
+        : data_(data), size_(size), rows_(rows), dim_(dim), row_bytes_(row_bytes), chunk_rows_(chunk_rows) {
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    int64_t rows_;
+    int64_t dim_;
+    int64_t row_bytes_;
+    int64_t chunk_rows_;
+};
+
+}  // namespace knowhere
+
+#endif /* DATA_SOURCE_H */
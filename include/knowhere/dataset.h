@@ -21,6 +21,7 @@
 #include <variant>
 
 #include "comp/index_param.h"
+#include "knowhere/comp/search_arena.h"
 #include "knowhere/range_util.h"
 #include "knowhere/sparse_utils.h"
 
@@ -35,6 +36,10 @@ class DataSet : public std::enable_shared_from_this<const DataSet> {
             return;
         }
         for (auto&& x : this->data_) {
+            // released with pooled_
+            if (auto it = pooled_.find(x.first); it != pooled_.end() && it->second.get() == FindPtr(x.second)) {
+                continue;
+            }
             {
                 auto ptr = std::get_if<0>(&x.second);
                 if (ptr != nullptr) {
@@ -78,6 +83,13 @@ class DataSet : public std::enable_shared_from_this<const DataSet> {
         this->data_[meta::DISTANCE] = Var(std::in_place_index<0>, dis.release());
     }
 
+    void
+    SetDistance(ResultBuffer<float>&& dis) {
+        std::unique_lock lock(mutex_);
+        this->data_[meta::DISTANCE] = Var(std::in_place_index<0>, dis.get());
+        SetPooled(meta::DISTANCE, std::move(dis));
+    }
+
     void
     SetLims(const size_t* lims) {
         std::unique_lock lock(mutex_);
@@ -104,6 +116,13 @@ class DataSet : public std::enable_shared_from_this<const DataSet> {
         this->data_[meta::IDS] = Var(std::in_place_index<2>, reinterpret_cast<int64_t*>(ids.release()));
     }
 
+    void
+    SetIds(ResultBuffer<int64_t>&& ids) {
+        std::unique_lock lock(mutex_);
+        this->data_[meta::IDS] = Var(std::in_place_index<2>, ids.get());
+        SetPooled(meta::IDS, std::move(ids));
+    }
+
     void
     SetIds(std::unique_ptr<long long int[]>&& ids) {
         static_assert(sizeof(long long int) == sizeof(int64_t));
@@ -248,6 +267,30 @@ class DataSet : public std::enable_shared_from_this<const DataSet> {
         return "";
     }
 
+    // the L2 norms of the rows of the tensor, so that the COSINE searches on the same base compute them only once. They
+    // belong to the tensor and the rows they are set with, and are not returned once either changes.
+    void
+    SetTensorNorms(std::shared_ptr<const float[]> norms) {
+        std::unique_lock lock(mutex_);
+        TensorNorms tensor_norms{FindTensor(), FindInt(meta::ROWS), std::move(norms)};
+        this->data_[meta::TENSOR_NORMS] = Var(std::in_place_type<std::any>, std::move(tensor_norms));
+    }
+
+    std::shared_ptr<const float[]>
+    GetTensorNorms() const {
+        std::shared_lock lock(mutex_);
+        auto it = this->data_.find(meta::TENSOR_NORMS);
+        if (it == this->data_.end()) {
+            return nullptr;
+        }
+        auto tensor_norms = std::any_cast<TensorNorms>(std::get_if<std::any>(&it->second));
+        if (tensor_norms == nullptr || tensor_norms->tensor != FindTensor() ||
+            tensor_norms->rows != FindInt(meta::ROWS)) {
+            return nullptr;
+        }
+        return tensor_norms->norms;
+    }
+
     void
     SetIsOwner(bool is_owner) {
         std::unique_lock lock(mutex_);
@@ -297,8 +340,48 @@ class DataSet : public std::enable_shared_from_this<const DataSet> {
     }
 
  private:
+    struct TensorNorms {
+        const void* tensor;
+        int64_t rows;
+        std::shared_ptr<const float[]> norms;
+    };
+
+    // the buffers of the ResultBufferPool set by key, they return to the pool with the DataSet whether it owns its
+    //   data or not
+    template <typename T>
+    void
+    SetPooled(const std::string& key, ResultBuffer<T>&& buffer) {
+        auto deleter = buffer.get_deleter();
+        pooled_[key] = std::shared_ptr<void>(buffer.release(), [deleter](void* ptr) { deleter((T*)ptr); });
+    }
+
+    static const void*
+    FindPtr(const Var& var) {
+        if (auto ptr = std::get_if<0>(&var)) {
+            return *ptr;
+        }
+        if (auto ptr = std::get_if<2>(&var)) {
+            return *ptr;
+        }
+        return nullptr;
+    }
+
+    // the lookups of the getters, for callers that hold mutex_
+    const void*
+    FindTensor() const {
+        auto it = this->data_.find(meta::TENSOR);
+        return it != this->data_.end() ? *std::get_if<3>(&it->second) : nullptr;
+    }
+
+    int64_t
+    FindInt(const std::string& key) const {
+        auto it = this->data_.find(key);
+        return it != this->data_.end() ? *std::get_if<4>(&it->second) : 0;
+    }
+
     mutable std::shared_mutex mutex_;
     std::map<std::string, Var> data_;
+    std::map<std::string, std::shared_ptr<void>> pooled_;
     bool is_owner = true;
     bool is_sparse = false;
 };
@@ -395,6 +478,17 @@ GenResultDataSet(const int64_t nq, const int64_t topk, std::unique_ptr<long long
     return ret_ds;
 }
 
+inline DataSetPtr
+GenResultDataSet(const int64_t nq, const int64_t topk, ResultBuffer<int64_t>&& ids, ResultBuffer<float>&& distance) {
+    auto ret_ds = std::make_shared<DataSet>();
+    ret_ds->SetRows(nq);
+    ret_ds->SetDim(topk);
+    ret_ds->SetIds(std::move(ids));
+    ret_ds->SetDistance(std::move(distance));
+    ret_ds->SetIsOwner(true);
+    return ret_ds;
+}
+
 inline DataSetPtr
 #ifdef NOT_COMPILE_FOR_SWIG
 GenResultDataSet(const int64_t nq, const int64_t* ids, const float* distance, const size_t* lims) {
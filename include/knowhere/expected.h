@@ -50,6 +50,8 @@ enum class Status {
     invalid_serialized_index_type = 28,
     sparse_inner_error = 29,
     brute_force_inner_error = 30,
+    cancelled = 31,
+    overloaded = 32,
 };
 
 inline std::string
@@ -107,6 +109,12 @@ Status2String(knowhere::Status status) {
             return "sparse index inner error";
         case knowhere::Status::brute_force_inner_error:
             return "brute_force inner error";
+        case knowhere::Status::timeout:
+            return "timeout";
+        case knowhere::Status::cancelled:
+            return "cancelled";
+        case knowhere::Status::overloaded:
+            return "the search thread pool is overloaded";
         default:
             return "unexpected status";
     }
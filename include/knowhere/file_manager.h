@@ -11,11 +11,39 @@
 
 #ifndef FILEMANAGER_H
 #define FILEMANAGER_H
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 
 namespace knowhere {
 
+/**
+ * @brief Reads byte ranges of a file that stays where FileManager keeps it, e.g. with the ranged GETs of an object
+ * storage, instead of the whole file being loaded to the local disk.
+ */
+class FileRangeReader {
+ public:
+    /**
+     * @brief The size of the file in bytes.
+     *
+     * @return std::nullopt if any error, or return the size.
+     */
+    virtual std::optional<uint64_t>
+    Size() noexcept = 0;
+
+    /**
+     * @brief Read len bytes of the file at offset into buf. It is called by several threads at once.
+     *
+     * @return false if any error, or return true.
+     */
+    virtual bool
+    Read(uint64_t offset, uint64_t len, void* buf) noexcept = 0;
+
+    /// @brief A virtual destructor.
+    virtual ~FileRangeReader() = default;
+};
+
 /**
  * @brief This FileManager is used to manage file, including its replication, backup, ect.
  * It will act as a cloud-like client, and Knowhere need to call load/add to better support
@@ -62,6 +90,18 @@ class FileManager {
     virtual bool
     RemoveFile(const std::string& filename) noexcept = 0;
 
+    /**
+     * @brief Open a file for ranged reads where it is kept, for the indexes that read a large file a few sectors at
+     * a time.
+     *
+     * @param filename
+     * @return nullptr if the file is to be loaded with LoadFile(), which is the default.
+     */
+    virtual std::shared_ptr<FileRangeReader>
+    OpenRangeReader(const std::string& filename) noexcept {
+        return nullptr;
+    }
+
     /// @brief A virtual destructor.
     virtual ~FileManager() = default;
 };
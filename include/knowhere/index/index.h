@@ -13,13 +13,50 @@
 #define INDEX_H
 
 #include "knowhere/binaryset.h"
+#include "knowhere/comp/cancellation.h"
 #include "knowhere/config.h"
+#include "knowhere/data_source.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
+#include "knowhere/file_manager.h"
 #include "knowhere/index/index_node.h"
 #include "knowhere/index/interrupt.h"
 namespace knowhere {
 
+template <typename T1>
+class Index;
+
+// A search config parsed and checked once by Index::CompileSearchConfig(), that the searches of every index of the
+//   same type reuse instead of loading their json again. It is immutable and can be shared across threads.
+class CompiledSearchConfig {
+ public:
+    const std::string&
+    IndexType() const {
+        return index_type_;
+    }
+
+ private:
+    template <typename T1>
+    friend class Index;
+
+    CompiledSearchConfig(std::string index_type, std::shared_ptr<const BaseConfig> cfg)
+        : index_type_(std::move(index_type)), cfg_(std::move(cfg)) {
+    }
+
+    std::string index_type_;
+    std::shared_ptr<const BaseConfig> cfg_;
+};
+
+// The options of Index::HybridSearch()
+struct HybridSearchOptions {
+    int64_t k = 10;
+    // the fused score of a row is dense_weight * its dense score + sparse_weight * its sparse score, both >= 0
+    float dense_weight = 1.0f;
+    float sparse_weight = 1.0f;
+    // the candidates each index returns, as a multiple of k
+    float candidates_ratio = 2.0f;
+};
+
 template <typename T1>
 class Index {
  public:
@@ -157,15 +194,94 @@ class Index {
     Status
     Add(const DataSetPtr dataset, const Json& json, bool use_knowhere_build_pool = true);
 
+    Status
+    Merge(const std::vector<Index<T1>>& others, const Json& json);
+
+    // Builds the index from a source read chunk by chunk. An index that supports incremental adds is trained on an
+    // evenly spread sample of at most max_train_rows rows, then its chunks are added one by one while the next one is
+    // read, so that no more than two chunks are in memory at once. The other indexes are built from all the rows.
+    Status
+    BuildFromSource(const DataSource& source, const Json& json, int64_t max_train_rows = kDefaultDataSourceTrainRows);
+
+    Status
+    DeleteByIds(const DataSetPtr dataset);
+
+    // Caches the results of the searches in up to capacity_bytes, the rows being of data_format. A search is served
+    //   from the cache when the same queries were searched with the same config, and, for a search with a bitset,
+    //   with the same bitset_version config, the version the caller gives to the rows a bitset filters out. Searches
+    //   with a bitset and no version, into buffers, of embedding lists, by groups or of sparse rows are not cached.
+    //   Adding, deleting or loading rows clears the cache. capacity_bytes 0 disables it.
+    Status
+    EnableResultCache(size_t capacity_bytes, DataFormatEnum data_format = DataFormatEnum::fp32);
+
+    // A search stopped by `cancellation` fails with Status::timeout or Status::cancelled, or, with the partial_results
+    // config, returns the results found until then with meta::PARTIAL_RESULTS set.
     expected<DataSetPtr>
-    Search(const DataSetPtr dataset, const Json& json, const BitsetView& bitset) const;
+    Search(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+           std::shared_ptr<CancellationToken> cancellation = nullptr) const;
 
+    // the same with a config compiled by CompileSearchConfig() of an index of the same type
+    expected<DataSetPtr>
+    Search(const DataSetPtr dataset, const CompiledSearchConfig& config, const BitsetView& bitset,
+           std::shared_ptr<CancellationToken> cancellation = nullptr) const;
+
+    // checks and loads the search config json once, with the calibrated params of this index
+    expected<CompiledSearchConfig>
+    CompileSearchConfig(const Json& json) const;
+
+    // Searches the queries of dataset on every segment, segments[i] with bitsets[i], as Search() does. The coarse
+    //   search of the IVF segments that share a quantizer runs once for all of them, see IndexNode::CoarseSearch().
+    static std::vector<expected<DataSetPtr>>
+    SearchSegments(const std::vector<Index<T1>>& segments, const DataSetPtr dataset, const Json& json,
+                   const std::vector<BitsetView>& bitsets);
+
+    // Searches the same rows in a dense index and in a sparse one, the queries of dense_queries and sparse_queries
+    //   being the two sides of the same nq queries. Both indexes return their k * candidates_ratio best rows at once,
+    //   and the union of them is ranked by the fused score. The scores a candidate misses are searched for in the
+    //   other index, restricted to the candidates, unless the k-th bound of the other index already keeps them out of
+    //   the top-k. Both metrics are similarities, such as IP, COSINE and BM25.
+    static expected<DataSetPtr>
+    HybridSearch(const Index<T1>& dense, const DataSetPtr dense_queries, const Json& dense_json,
+                 const Index<T1>& sparse, const DataSetPtr sparse_queries, const Json& sparse_json,
+                 const BitsetView& bitset, const HybridSearchOptions& options);
+
+    // searches into the nq * k elements of `ids` and `dis`, see IndexNode::SearchWithBuf()
+    expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, const Json& json, const BitsetView& bitset, int64_t* ids, float* dis,
+                  std::shared_ptr<CancellationToken> cancellation = nullptr) const;
+
+    // `cancellation` covers the initial search of the iterators only
     expected<std::vector<IndexNode::IteratorPtr>>
     AnnIterator(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
-                bool use_knowhere_search_pool = true) const;
+                bool use_knowhere_search_pool = true, std::shared_ptr<CancellationToken> cancellation = nullptr) const;
 
     expected<DataSetPtr>
-    RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetView& bitset) const;
+    RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                std::shared_ptr<CancellationToken> cancellation = nullptr) const;
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    // The async versions run the call on the async search thread pool, so the caller does not block on it. The index
+    // is kept alive until the call is done, the data of the bitset must outlive it.
+    folly::SemiFuture<expected<DataSetPtr>>
+    SearchAsync(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                std::shared_ptr<CancellationToken> cancellation = nullptr) const;
+
+    folly::SemiFuture<expected<std::vector<IndexNode::IteratorPtr>>>
+    AnnIteratorAsync(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                     bool use_knowhere_search_pool = true,
+                     std::shared_ptr<CancellationToken> cancellation = nullptr) const;
+
+    folly::SemiFuture<expected<DataSetPtr>>
+    RangeSearchAsync(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                     std::shared_ptr<CancellationToken> cancellation = nullptr) const;
+#endif
+
+    // Picks the smallest value of the main search param of the index (nprobe, ef or search_list_size) whose results
+    //   on `queries` overlap by at least target_recall with the results at the largest value, and makes it the
+    //   default of the searches that do not set it. The queries are sampled from the raw data if null. The params are
+    //   kept by Serialize() and restored by Deserialize(). Call it before the index serves searches.
+    expected<Json>
+    Calibrate(const DataSetPtr queries, const Json& json, float target_recall);
 
     expected<DataSetPtr>
     GetVectorByIds(const DataSetPtr dataset) const;
@@ -185,9 +301,39 @@ class Index {
     Status
     Deserialize(const BinarySet& binset, const Json& json = {});
 
+    // writes the index to filename as it is serialized, DeserializeFromFile() loads it. The file is then added to
+    //   file_manager, if any.
+    Status
+    SerializeToFile(const std::string& filename, const std::shared_ptr<FileManager>& file_manager = nullptr) const;
+
     Status
     DeserializeFromFile(const std::string& filename, const Json& json = {});
 
+    // Loads the segments of a replica: indexes[i] from binsets[i] with jsons[i], or with jsons[0] if there is a single
+    //   json, concurrently on the build thread pool. A failed load does not stop the others, the status of each is
+    //   returned.
+    static std::vector<Status>
+    DeserializeAll(std::vector<Index<T1>>& indexes, const std::vector<BinarySet>& binsets,
+                   const std::vector<Json>& jsons);
+
+    // the same with DeserializeFromFile() of filenames[i]
+    static std::vector<Status>
+    DeserializeAllFromFile(std::vector<Index<T1>>& indexes, const std::vector<std::string>& filenames,
+                           const std::vector<Json>& jsons);
+
+    // pages in the memory mapped by DeserializeFromFile(), see IndexNode::WarmUp()
+    Status
+    WarmUp(WarmUpLevel level = WarmUpLevel::ALL) const;
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    // WarmUp() on the async search thread pool, so that a segment is warmed up before searches are routed to it
+    folly::SemiFuture<Status>
+    WarmUpAsync(WarmUpLevel level = WarmUpLevel::ALL) const;
+#endif
+
+    Status
+    CoolDown() const;
+
     int64_t
     Dim() const;
 
@@ -211,6 +357,16 @@ class Index {
     }
 
  private:
+    // searches into ids and dis if they are set, into new arrays otherwise
+    expected<DataSetPtr>
+    SearchImpl(const DataSetPtr dataset, const Json& json, const BitsetView& bitset, int64_t* ids, float* dis,
+               std::shared_ptr<CancellationToken> cancellation) const;
+
+    // the search with a loaded config
+    expected<DataSetPtr>
+    SearchLoaded(const DataSetPtr dataset, std::unique_ptr<BaseConfig> cfg, const BitsetView& bitset, int64_t* ids,
+                 float* dis, std::shared_ptr<CancellationToken> cancellation) const;
+
     Index(T1* node) : node(node) {
         static_assert(std::is_base_of<IndexNode, T1>::value);
     }
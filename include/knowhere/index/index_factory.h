@@ -163,6 +163,28 @@ class IndexFactory {
         },                                                                                            \
         data_type, typeCheck<data_type>(features), features)
 
+// register an index whose rows are split into the num_shards indexes of index_node of its config, see
+//   IndexNodeShardedWrapper
+#define KNOWHERE_SHARDED_REGISTER_GLOBAL(name, index_node, data_type, features, ...)                    \
+    KNOWHERE_REGISTER_STATIC(name, index_node, data_type, ##__VA_ARGS__)                                 \
+    KNOWHERE_REGISTER_GLOBAL(                                                                            \
+        name,                                                                                            \
+        [](const int32_t& version, const Object& object) {                                               \
+            return (Index<IndexNodeShardedWrapper<data_type>>::Create(                                   \
+                version,                                                                                 \
+                [version]() -> std::unique_ptr<IndexNode> {                                              \
+                    return std::make_unique<index_node<data_type, ##__VA_ARGS__>>(version, nullptr);     \
+                },                                                                                       \
+                #name));                                                                                 \
+        },                                                                                               \
+        data_type, typeCheck<data_type>(features), features)
+
+// register a sharded vector index supporting ALL_DENSE_FLOAT_TYPE(float32, bf16, fp16) data types
+#define KNOWHERE_SHARDED_REGISTER_DENSE_FLOAT_ALL_GLOBAL(name, index_node, features, ...)                          \
+    KNOWHERE_SHARDED_REGISTER_GLOBAL(name, index_node, bf16, (features | knowhere::feature::BF16), ##__VA_ARGS__); \
+    KNOWHERE_SHARDED_REGISTER_GLOBAL(name, index_node, fp16, (features | knowhere::feature::FP16), ##__VA_ARGS__); \
+    KNOWHERE_SHARDED_REGISTER_GLOBAL(name, index_node, fp32, (features | knowhere::feature::FLOAT32), ##__VA_ARGS__);
+
 #define KNOWHERE_SET_STATIC_GLOBAL_INDEX_TABLE(table_index, name, index_table)                      \
     static int name = []() -> int {                                                                 \
         auto& static_index_table = std::get<table_index>(IndexFactory::StaticIndexTableInstance()); \
@@ -12,13 +12,22 @@
 #ifndef INDEX_NODE_H
 #define INDEX_NODE_H
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <functional>
 #include <queue>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "knowhere/binaryset.h"
 #include "knowhere/bitsetview.h"
+#include "knowhere/comp/coarse_probes.h"
+#include "knowhere/comp/group_by.h"
+#include "knowhere/comp/memory_usage.h"
+#include "knowhere/comp/result_cache.h"
+#include "knowhere/comp/warm_up.h"
 #include "knowhere/config.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
@@ -120,6 +129,71 @@ class IndexNode : public Object {
     virtual Status
     Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool = true) = 0;
 
+    /**
+     * @brief Appends the data of other indexes of the same type to this index without a full rebuild.
+     *
+     * @param others Indexes to merge from, they are left untouched.
+     * @param cfg
+     * @return Status.
+     *
+     * @note Rows of others[0] follow the rows of this index, rows of others[1] follow the rows of others[0], etc.
+     * @note Not thread safe with search methods.
+     */
+    virtual Status
+    Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) {
+        return Status::not_implemented;
+    }
+
+    /**
+     * @brief Whether the rows of a trained index can be added by several `Add` calls, each appending its rows after
+     * the ones of the previous calls.
+     *
+     * @note A build from a DataSource adds the chunks of such indexes one by one after training them on a sample,
+     * the other indexes are built from all the rows at once.
+     */
+    virtual bool
+    IsIncrementalAddSupported() const {
+        return false;
+    }
+
+    /**
+     * @brief The identity of the coarse quantizer the index shares with other indexes of the same centroids, nullptr
+     * if it has none.
+     *
+     * @note The indexes with the same quantizer can search a batch with the probes of a single CoarseSearch().
+     */
+    virtual const void*
+    SharedCoarseQuantizer() const {
+        return nullptr;
+    }
+
+    /**
+     * @brief Searches the coarse quantizer of the index only, for the queries of a search on any index that shares it.
+     *
+     * @param dataset Query vectors.
+     * @param cfg The search config, for its nprobe and the params of the quantizer.
+     * @return The probes to set as meta::COARSE_PROBES on the queries of the searches.
+     */
+    virtual expected<std::shared_ptr<const CoarseProbes>>
+    CoarseSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg) const {
+        return expected<std::shared_ptr<const CoarseProbes>>::Err(Status::not_implemented,
+                                                                   "the index has no coarse quantizer");
+    }
+
+    /**
+     * @brief Soft-deletes rows of the index, deleted rows are never returned by search methods.
+     *
+     * @param dataset Ids of the rows to delete.
+     * @return Status.
+     *
+     * @note The index may repair its structure around the deleted rows in the background.
+     * @note Thread safe with search methods.
+     */
+    virtual Status
+    DeleteByIds(const DataSetPtr dataset) {
+        return Status::not_implemented;
+    }
+
     /**
      * @brief Performs a search operation on the index.
      *
@@ -133,6 +207,26 @@ class IndexNode : public Object {
     virtual expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const = 0;
 
+    /**
+     * @brief Performs a search like Search(), with the ids and the distances written to the nq * k elements of `ids`
+     * and `dis`, e.g. the slice of a merge buffer, instead of new arrays.
+     *
+     * @return The DataSet of the results, for their meta such as meta::PARTIAL_RESULTS. Its ids and distances are
+     * `ids` and `dis` for the indexes that search into them, and a copy otherwise.
+     * @note The default copies the results of Search().
+     */
+    virtual expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const {
+        auto res = Search(dataset, std::move(cfg), bitset);
+        if (res.has_value()) {
+            const size_t n = res.value()->GetRows() * res.value()->GetDim();
+            std::memcpy(ids, res.value()->GetIds(), n * sizeof(int64_t));
+            std::memcpy(dis, res.value()->GetDistance(), n * sizeof(float));
+        }
+        return res;
+    }
+
     // not thread safe.
     class iterator {
      public:
@@ -140,11 +234,60 @@ class IndexNode : public Object {
         Next() = 0;
         [[nodiscard]] virtual bool
         HasNext() = 0;
+        // writes up to n next results to ids and dists, returns how many, fewer than n only if the iterator is
+        //   exhausted. Overrides pay the virtual call and the thread pool hop once per batch instead of per result.
+        virtual size_t
+        NextBatch(size_t n, int64_t* ids, float* dists) {
+            size_t count = 0;
+            for (; count < n && HasNext(); count++) {
+                std::tie(ids[count], dists[count]) = Next();
+            }
+            return count;
+        }
         virtual ~iterator() {
         }
     };
     using IteratorPtr = std::shared_ptr<iterator>;
 
+    // reads an iterator through NextBatch() in batches that double from kMinBatch to kMaxBatch, so that a caller
+    //   that stops early does not make the iterator expand far beyond what it consumed
+    class IteratorBatchReader {
+     public:
+        explicit IteratorBatchReader(IteratorPtr it) : it_(std::move(it)) {
+        }
+
+        bool
+        Next(int64_t& id, float& dist) {
+            if (pos_ == size_) {
+                if (exhausted_) {
+                    return false;
+                }
+                size_ = it_->NextBatch(batch_, ids_.data(), dists_.data());
+                exhausted_ = size_ < batch_;
+                pos_ = 0;
+                batch_ = std::min(batch_ * 2, kMaxBatch);
+                if (size_ == 0) {
+                    return false;
+                }
+            }
+            id = ids_[pos_];
+            dist = dists_[pos_++];
+            return true;
+        }
+
+     private:
+        static constexpr size_t kMinBatch = 16;
+        static constexpr size_t kMaxBatch = 1024;
+
+        IteratorPtr it_;
+        std::array<int64_t, kMaxBatch> ids_;
+        std::array<float, kMaxBatch> dists_;
+        size_t batch_ = kMinBatch;
+        size_t size_ = 0;
+        size_t pos_ = 0;
+        bool exhausted_ = false;
+    };
+
     virtual expected<std::vector<IteratorPtr>>
     AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
                 bool use_knowhere_search_pool = true) const {
@@ -226,9 +369,10 @@ class IndexNode : public Object {
          * - terminate iterator if get enough results. (`range_search_k`)
          * */
         auto task_with_ordered_iterator = [&](size_t idx) {
-            auto it = its[idx];
-            while (it->HasNext()) {
-                auto [id, dist] = it->Next();
+            IteratorBatchReader reader(its[idx]);
+            int64_t id;
+            float dist;
+            while (reader.Next(id, dist)) {
                 if (has_closer_bound && too_close(dist)) {
                     continue;
                 }
@@ -254,15 +398,16 @@ class IndexNode : public Object {
             // max-heap, use top (the current kth-furthest dist) as the further_bound if size == range_search_k
             std::priority_queue<float, std::vector<float>, decltype(is_first_closer)> early_stop_further_bounds(
                 is_first_closer);
-            auto it = its[idx];
+            IteratorBatchReader reader(its[idx]);
             size_t num_next = 0;
             size_t num_consecutive_over_further_bound = 0;
             float tighter_further_bound = base_cfg.radius.value();
             auto same_or_too_far = [&is_first_closer, &tighter_further_bound](float dist) {
                 return !is_first_closer(dist, tighter_further_bound);
             };
-            while (it->HasNext()) {
-                auto [id, dist] = it->Next();
+            int64_t id;
+            float dist;
+            while (reader.Next(id, dist)) {
                 num_next++;
                 if (has_closer_bound && too_close(dist)) {
                     continue;
@@ -325,6 +470,75 @@ class IndexNode : public Object {
         return GenResultDataSet(nq, std::move(range_search_result));
     }
 
+    /**
+     * @brief Performs a group-by search: the k groups of rows with the same key whose closest rows are the closest,
+     * with up to group_size rows each, see GroupByCollector.
+     *
+     * This default implementation reads the `AnnIterator` until the groups are settled. Indexes override it to keep
+     * the groups inside their own traversal.
+     *
+     * @param dataset Query vectors, with the group key of every row of the index in meta::GROUP_BY_KEYS.
+     * @param cfg
+     * @param bitset A BitsetView object for filtering results.
+     * @return k * group_size results per query, the groups by their closest row, padded with -1.
+     */
+    virtual expected<DataSetPtr>
+    GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const {
+        const auto base_cfg = static_cast<const BaseConfig&>(*cfg);
+        const auto keys = dataset->Get<std::shared_ptr<const GroupKeys>>(meta::GROUP_BY_KEYS);
+        if (keys == nullptr) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "the group keys of the rows are missing");
+        }
+        const size_t n_groups = base_cfg.k.value();
+        const size_t group_size = base_cfg.group_size.value();
+        const bool the_larger_the_closer = IsMetricType(base_cfg.metric_type.value(), metric::IP) ||
+                                           IsMetricType(base_cfg.metric_type.value(), metric::COSINE) ||
+                                           IsMetricType(base_cfg.metric_type.value(), metric::BM25);
+
+        auto its_or = AnnIterator(dataset, std::move(cfg), bitset, false);
+        if (!its_or.has_value()) {
+            return expected<DataSetPtr>::Err(its_or.error(),
+                                             "GroupBySearch failed due to AnnIterator failure: " + its_or.what());
+        }
+        const auto its = its_or.value();
+        const auto nq = its.size();
+        const size_t n_res = n_groups * group_size;
+        auto ids = std::make_unique<int64_t[]>(nq * n_res);
+        auto distances = std::make_unique<float[]>(nq * n_res);
+
+        auto task = [&](size_t idx) {
+            GroupByCollector groups(*keys, n_groups, group_size);
+            IteratorBatchReader reader(its[idx]);
+            int64_t id;
+            float dist;
+            while (reader.Next(id, dist)) {
+                const float d = the_larger_the_closer ? -dist : dist;
+                // the iterator returns the rows roughly closest first
+                if (d >= groups.Bound()) {
+                    break;
+                }
+                groups.Add(id, d);
+            }
+            groups.Output(ids.get() + idx * n_res, distances.get() + idx * n_res, the_larger_the_closer);
+        };
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        std::vector<folly::Future<folly::Unit>> futs;
+        futs.reserve(nq);
+        for (size_t i = 0; i < nq; i++) {
+            futs.emplace_back(ThreadPool::GetGlobalSearchThreadPool()->push([&, idx = i]() {
+                ThreadPool::ScopedSearchOmpSetter setter(1);
+                task(idx);
+            }));
+        }
+        WaitAllSuccess(futs);
+#else
+        for (size_t i = 0; i < nq; i++) {
+            task(i);
+        }
+#endif
+        return GenResultDataSet(nq, n_res, std::move(ids), std::move(distances));
+    }
+
     /**
      * @brief Retrieves raw vectors by their IDs from the index.
      *
@@ -400,6 +614,50 @@ class IndexNode : public Object {
     virtual Status
     DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> config) = 0;
 
+    /**
+     * @brief Serializes the index to a file, in the format DeserializeFromFile() reads.
+     *
+     * Unlike Serialize(), the index is written out in chunks while it is serialized, so that the flush of a large
+     * index does not need a second copy of it in memory.
+     *
+     * @param filename Path of the file to write, it is truncated first.
+     * @return Status indicating success or failure of the serialization.
+     */
+    virtual Status
+    SerializeToFile(const std::string& filename) const {
+        return Status::not_implemented;
+    }
+
+    /**
+     * @brief Gets the memory of the index that is mapped from a file, by DeserializeFromFile() with mmap enabled.
+     *
+     * @return The mapped regions, none if the index is in memory.
+     */
+    virtual std::vector<MappedRegion>
+    MappedRegions() const {
+        return {};
+    }
+
+    /**
+     * @brief Pages in the mapped memory of the index, so that the first searches do not wait for page faults.
+     *
+     * @param level WarmUpLevel::STRUCTURE pages in the graph or the centroids, WarmUpLevel::ALL the codes and the raw
+     * data too, after them.
+     * @return Status indicating success or failure of the warm up.
+     */
+    virtual Status
+    WarmUp(WarmUpLevel level) const {
+        return WarmUpRegions(MappedRegions(), level);
+    }
+
+    /**
+     * @brief Lets the kernel drop the pages of the mapped memory of the index, the index stays searchable.
+     */
+    virtual Status
+    CoolDown() const {
+        return CoolDownRegions(MappedRegions());
+    }
+
     virtual std::unique_ptr<BaseConfig>
     CreateConfig() const = 0;
 
@@ -417,11 +675,20 @@ class IndexNode : public Object {
      * @brief Gets the memory usage of the index in bytes.
      *
      * @return The size of the index as an int64_t.
-     * @note This method doesn't have to be very accurate.
+     * @note The indexes that implement MemoryBreakdown() return its total, the others may only estimate it.
      */
     virtual int64_t
     Size() const = 0;
 
+    // the bytes the index holds in memory by section, see memory_section. The indexes that do not tell their sections
+    //   apart put all of Size() in memory_section::OTHER.
+    virtual MemoryUsage
+    MemoryBreakdown() const {
+        MemoryUsage usage;
+        usage.Add(memory_section::OTHER, Size());
+        return usage;
+    }
+
     /**
      * @brief Gets the number of vectors in the index.
      *
@@ -436,8 +703,81 @@ class IndexNode : public Object {
     virtual ~IndexNode() {
     }
 
+    // the NUMA node the memory of the index was placed on when it was loaded, -1 if none
+    int
+    NumaNode() const {
+        return numa_node_;
+    }
+
+    void
+    SetNumaNode(int node) {
+        numa_node_ = node;
+    }
+
+    // the format of the rows and the queries of the index, set by IndexFactory::Create()
+    DataFormatEnum
+    DataFormat() const {
+        return data_format_;
+    }
+
+    void
+    SetDataFormat(DataFormatEnum format) {
+        data_format_ = format;
+    }
+
+    // sets the gauges of the memory of the index to its MemoryBreakdown()
+    void
+    PublishMemoryUsage() {
+        auto gauges = std::atomic_load(&memory_gauges_);
+        if (gauges == nullptr) {
+            auto created = std::make_shared<IndexMemoryGauges>(Type());
+            gauges = std::atomic_compare_exchange_strong(&memory_gauges_, &gauges, created) ? created : gauges;
+        }
+        gauges->Update(MemoryBreakdown());
+    }
+
+    // the search params Index::Calibrate() picked, the defaults of the searches that do not set them
+    const Json&
+    CalibratedParams() const {
+        return calibrated_params_;
+    }
+
+    void
+    SetCalibratedParams(Json params) {
+        calibrated_params_ = std::move(params);
+    }
+
+    // the offsets of the lists of embeddings the rows are made of, nullptr if the rows are not lists, see
+    //   meta::EMB_LIST_OFFSET
+    const std::shared_ptr<const std::vector<size_t>>&
+    EmbListOffsets() const {
+        return emb_list_offsets_;
+    }
+
+    void
+    SetEmbListOffsets(std::shared_ptr<const std::vector<size_t>> offsets) {
+        emb_list_offsets_ = std::move(offsets);
+    }
+
+    // the cache of the search results, nullptr unless Index::EnableResultCache() enabled it
+    std::shared_ptr<SearchResultCache>
+    ResultCache() const {
+        return std::atomic_load(&result_cache_);
+    }
+
+    void
+    SetResultCache(std::shared_ptr<SearchResultCache> cache) {
+        std::atomic_store(&result_cache_, std::move(cache));
+    }
+
  protected:
     Version version_;
+    int numa_node_ = -1;
+    DataFormatEnum data_format_ = DataFormatEnum::fp32;
+    Json calibrated_params_ = Json::object();
+    std::shared_ptr<const std::vector<size_t>> emb_list_offsets_;
+    std::shared_ptr<SearchResultCache> result_cache_;
+    std::shared_ptr<IndexMemoryGauges> memory_gauges_;
 };
 
 // Common superclass for iterators that expand search range as needed. Subclasses need
@@ -468,42 +808,25 @@ class IndexIterator : public IndexNode::iterator {
         if (q.empty()) {
             throw std::runtime_error("No more elements");
         }
-        auto ret = q.top();
-        q.pop();
+        DistId ret;
+        RunUpdateTask([&]() { ret = PopNext(); });
+        return std::make_pair(ret.id, ret.val * sign_);
+    }
 
-        auto update_next_func = [&]() {
-            UpdateNext();
-            if (retain_iterator_order_) {
-                while (HasNext()) {
-                    auto& q = refined_res_.empty() ? res_ : refined_res_;
-                    auto next_ret = q.top();
-                    // with the help of `sign_`, both `res_` and `refine_res` are min-heap.
-                    //   such as `COSINE`, `-dist` will be inserted to `res_` or `refine_res`.
-                    // just make sure that the next value is greater than or equal to the current value.
-                    if (next_ret.val >= ret.val) {
-                        break;
-                    }
-                    q.pop();
-                    UpdateNext();
-                }
-            }
-        };
-        if (use_knowhere_search_pool_) {
-#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
-            std::vector<folly::Future<folly::Unit>> futs;
-            futs.emplace_back(ThreadPool::GetGlobalSearchThreadPool()->push([&]() {
-                ThreadPool::ScopedSearchOmpSetter setter(1);
-                update_next_func();
-            }));
-            WaitAllSuccess(futs);
-#else
-            update_next_func();
-#endif
-        } else {
-            update_next_func();
+    size_t
+    NextBatch(size_t n, int64_t* ids, float* dists) override {
+        if (!initialized_) {
+            initialize();
         }
-
-        return std::make_pair(ret.id, ret.val * sign_);
+        size_t count = 0;
+        RunUpdateTask([&]() {
+            for (; count < n && (!res_.empty() || !refined_res_.empty()); count++) {
+                auto ret = PopNext();
+                ids[count] = ret.id;
+                dists[count] = ret.val * sign_;
+            }
+        });
+        return count;
     }
 
     [[nodiscard]] bool
@@ -554,6 +877,50 @@ class IndexIterator : public IndexNode::iterator {
     std::priority_queue<DistId, std::vector<DistId>, std::greater<DistId>> refined_res_;
 
  private:
+    // pops the closest result and expands the search for the next ones
+    DistId
+    PopNext() {
+        auto& q = refined_res_.empty() ? res_ : refined_res_;
+        auto ret = q.top();
+        q.pop();
+        UpdateNext();
+        if (retain_iterator_order_) {
+            while (HasNext()) {
+                auto& q = refined_res_.empty() ? res_ : refined_res_;
+                auto next_ret = q.top();
+                // with the help of `sign_`, both `res_` and `refine_res` are min-heap.
+                //   such as `COSINE`, `-dist` will be inserted to `res_` or `refine_res`.
+                // just make sure that the next value is greater than or equal to the current value.
+                if (next_ret.val >= ret.val) {
+                    break;
+                }
+                q.pop();
+                UpdateNext();
+            }
+        }
+        return ret;
+    }
+
+    template <typename Func>
+    void
+    RunUpdateTask(Func&& func) {
+        if (use_knowhere_search_pool_) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+            std::vector<folly::Future<folly::Unit>> futs;
+            ThreadPool::ScopedTaskPriority priority(ThreadPool::TaskPriority::ITERATOR);
+            futs.emplace_back(ThreadPool::GetGlobalSearchThreadPool()->push([&]() {
+                ThreadPool::ScopedSearchOmpSetter setter(1);
+                func();
+            }));
+            WaitAllSuccess(futs);
+#else
+            func();
+#endif
+        } else {
+            func();
+        }
+    }
+
     void
     UpdateNext() {
         auto batch_handler = [this](const std::vector<DistId>& batch) {
@@ -614,6 +981,40 @@ class PrecomputedDistanceIterator : public IndexNode::iterator {
         return std::make_pair(result.id, result.val);
     }
 
+    size_t
+    NextBatch(size_t n, int64_t* ids, float* dists) override {
+        if (!initialized_) {
+            initialize();
+        }
+        size_t count = 0;
+        auto copy_next = [&]() {
+            while (count < n && HasNext()) {
+                sort_next();
+                // the sorted results are copied as a run, up to the first -1 id
+                const size_t end = std::min(sorted_, next_ + (n - count));
+                for (; next_ < end && results_[next_].id != -1; next_++, count++) {
+                    ids[count] = results_[next_].id;
+                    dists[count] = results_[next_].val;
+                }
+            }
+        };
+        if (use_knowhere_search_pool_) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.emplace_back(ThreadPool::GetGlobalSearchThreadPool()->push([&]() {
+                ThreadPool::ScopedSearchOmpSetter setter(1);
+                copy_next();
+            }));
+            WaitAllSuccess(futs);
+#else
+            copy_next();
+#endif
+        } else {
+            copy_next();
+        }
+        return count;
+    }
+
     [[nodiscard]] bool
     HasNext() override {
         if (!initialized_) {
@@ -641,18 +1042,15 @@ class PrecomputedDistanceIterator : public IndexNode::iterator {
         } else {
             results_ = compute_dist_func_();
         }
-        sort_size_ = get_sort_size(results_.size());
         sort_next();
         initialized_ = true;
     }
 
  private:
-    static inline size_t
-    get_sort_size(size_t rows) {
-        return std::max((size_t)50000, rows / 10);
-    }
+    static constexpr size_t kMinSortSize = 1024;
 
-    // sort the next sort_size_ elements
+    // sort the next sort_size_ elements: select them with nth_element, linear in the unsorted ones, then sort only
+    //   them. The window doubles every time, so that the cost follows the number of elements consumed.
     inline void
     sort_next() {
         if (next_ < sorted_) {
@@ -660,14 +1058,24 @@ class PrecomputedDistanceIterator : public IndexNode::iterator {
         }
         size_t current_end = std::min(results_.size(), sorted_ + sort_size_);
         if (larger_is_closer_) {
-            std::partial_sort(results_.begin() + sorted_, results_.begin() + current_end, results_.end(),
-                              std::greater<DistId>());
+            select_and_sort(current_end, std::greater<DistId>());
         } else {
-            std::partial_sort(results_.begin() + sorted_, results_.begin() + current_end, results_.end(),
-                              std::less<DistId>());
+            select_and_sort(current_end, std::less<DistId>());
         }
 
         sorted_ = current_end;
+        sort_size_ *= 2;
+    }
+
+    template <typename Compare>
+    inline void
+    select_and_sort(size_t end, Compare compare) {
+        const auto first = results_.begin() + sorted_;
+        const auto middle = results_.begin() + end;
+        if (middle != results_.end()) {
+            std::nth_element(first, middle, results_.end(), compare);
+        }
+        std::sort(first, middle, compare);
     }
 
     std::function<std::vector<DistId>()> compute_dist_func_;
@@ -677,7 +1085,7 @@ class PrecomputedDistanceIterator : public IndexNode::iterator {
     std::vector<DistId> results_;
     size_t next_ = 0;
     size_t sorted_ = 0;
-    size_t sort_size_ = 0;
+    size_t sort_size_ = kMinSortSize;
 };
 
 }  // namespace knowhere
@@ -35,12 +35,25 @@ class IndexNodeDataMockWrapper : public IndexNode {
     Status
     Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
 
+    Status
+    Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) override;
+
+    Status
+    DeleteByIds(const DataSetPtr dataset) override;
+
     expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
 
+    expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const override;
+
     expected<DataSetPtr>
     RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
 
+    expected<DataSetPtr>
+    GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+
     expected<std::vector<IteratorPtr>>
     AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
                 bool use_knowhere_search_pool) const override;
@@ -53,6 +66,19 @@ class IndexNodeDataMockWrapper : public IndexNode {
         return index_node_->HasRawData(metric_type);
     }
 
+    bool
+    IsIncrementalAddSupported() const override {
+        return index_node_->IsIncrementalAddSupported();
+    }
+
+    const void*
+    SharedCoarseQuantizer() const override {
+        return index_node_->SharedCoarseQuantizer();
+    }
+
+    expected<std::shared_ptr<const CoarseProbes>>
+    CoarseSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg) const override;
+
     expected<DataSetPtr>
     GetIndexMeta(std::unique_ptr<Config> cfg) const override {
         return index_node_->GetIndexMeta(std::move(cfg));
@@ -63,6 +89,26 @@ class IndexNodeDataMockWrapper : public IndexNode {
         return index_node_->Serialize(binset);
     }
 
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        return index_node_->SerializeToFile(filename);
+    }
+
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        return index_node_->MappedRegions();
+    }
+
+    Status
+    WarmUp(WarmUpLevel level) const override {
+        return index_node_->WarmUp(level);
+    }
+
+    Status
+    CoolDown() const override {
+        return index_node_->CoolDown();
+    }
+
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override {
         return index_node_->Deserialize(binset, std::move(cfg));
@@ -88,6 +134,11 @@ class IndexNodeDataMockWrapper : public IndexNode {
         return index_node_->Size();
     }
 
+    MemoryUsage
+    MemoryBreakdown() const override {
+        return index_node_->MemoryBreakdown();
+    }
+
     int64_t
     Count() const override {
         return index_node_->Count();
@@ -0,0 +1,132 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef INDEX_NODE_SHARDED_WRAPPER_H
+#define INDEX_NODE_SHARDED_WRAPPER_H
+
+#include <functional>
+
+#include "knowhere/index/index_node.h"
+
+namespace knowhere {
+
+// Splits the rows of an index into `num_shards` contiguous ranges, each indexed by its own node. The shards are
+//   trained, added to and loaded concurrently, every search runs on all of them at once and merges their results.
+// The ranges are a multiple of 64 rows long, so that the bitset of a shard is a view of the words of the bitset of
+//   the index. A single shard is the node itself, serialized as such.
+template <typename DataType>
+class IndexNodeShardedWrapper : public IndexNode {
+ public:
+    using ShardFactory = std::function<std::unique_ptr<IndexNode>()>;
+
+    IndexNodeShardedWrapper(const int32_t& version, ShardFactory shard_factory, std::string type);
+
+    Status
+    Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
+
+    // rows added to a non-empty index go to the last shard
+    Status
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
+
+    expected<DataSetPtr>
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+
+    expected<DataSetPtr>
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+
+    expected<DataSetPtr>
+    GetVectorByIds(const DataSetPtr dataset) const override;
+
+    bool
+    HasRawData(const std::string& metric_type) const override {
+        return shards_[0]->HasRawData(metric_type);
+    }
+
+    expected<DataSetPtr>
+    GetIndexMeta(std::unique_ptr<Config> cfg) const override {
+        return shards_[0]->GetIndexMeta(std::move(cfg));
+    }
+
+    Status
+    Serialize(BinarySet& binset) const override;
+
+    Status
+    Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override;
+
+    // a sharded index is never serialized to a file, so the file is the one of a single shard
+    Status
+    DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> cfg) override;
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return shards_[0]->CreateConfig();
+    }
+
+    int64_t
+    Dim() const override {
+        return shards_[0]->Dim();
+    }
+
+    int64_t
+    Size() const override;
+
+    MemoryUsage
+    MemoryBreakdown() const override;
+
+    int64_t
+    Count() const override {
+        return shard_offsets_.back();
+    }
+
+    std::string
+    Type() const override {
+        return type_;
+    }
+
+ private:
+    // the bits of the rows [shard_offsets_[i], shard_offsets_[i + 1]) of bitset, whose bitmap is bits. The shards
+    //   past the end of bitset are filtered out entirely, see ShardFilteredOut()
+    BitsetView
+    ShardBitset(const BitsetView& bitset, const uint8_t* bits, size_t i) const;
+
+    bool
+    ShardFilteredOut(const BitsetView& bitset, size_t i) const {
+        return !bitset.empty() && shard_offsets_[i] >= static_cast<int64_t>(bitset.size());
+    }
+
+    // a copy of cfg of the config class of shard i
+    std::unique_ptr<Config>
+    ShardConfig(const Config& cfg, size_t i) const;
+
+    void
+    SetShards(std::vector<std::unique_ptr<IndexNode>>&& shards);
+
+    std::string
+    ShardsBinaryName() const {
+        return type_ + "_shards";
+    }
+
+    // the prefix of the names of the binaries of shard i
+    std::string
+    ShardBinaryPrefix(size_t i) const {
+        return type_ + "_shard_" + std::to_string(i) + "/";
+    }
+
+    ShardFactory shard_factory_;
+    std::string type_;
+    std::vector<std::unique_ptr<IndexNode>> shards_;
+    // shard i holds the rows [shard_offsets_[i], shard_offsets_[i + 1])
+    std::vector<int64_t> shard_offsets_;
+};
+
+}  // namespace knowhere
+
+#endif /* INDEX_NODE_SHARDED_WRAPPER_H */
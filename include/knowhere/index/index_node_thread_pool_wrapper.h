@@ -33,12 +33,24 @@ class IndexNodeThreadPoolWrapper : public IndexNode {
         return index_node_->Add(dataset, std::move(cfg), use_knowhere_build_pool);
     }
 
+    Status
+    DeleteByIds(const DataSetPtr dataset) override {
+        return index_node_->DeleteByIds(dataset);
+    }
+
     expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
 
+    expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const override;
+
     expected<DataSetPtr>
     RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
 
+    expected<DataSetPtr>
+    GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+
     expected<DataSetPtr>
     GetVectorByIds(const DataSetPtr dataset) const override {
         return index_node_->GetVectorByIds(dataset);
@@ -49,6 +61,21 @@ class IndexNodeThreadPoolWrapper : public IndexNode {
         return index_node_->HasRawData(metric_type);
     }
 
+    bool
+    IsIncrementalAddSupported() const override {
+        return index_node_->IsIncrementalAddSupported();
+    }
+
+    const void*
+    SharedCoarseQuantizer() const override {
+        return index_node_->SharedCoarseQuantizer();
+    }
+
+    expected<std::shared_ptr<const CoarseProbes>>
+    CoarseSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg) const override {
+        return index_node_->CoarseSearch(dataset, std::move(cfg));
+    }
+
     expected<DataSetPtr>
     GetIndexMeta(std::unique_ptr<Config> cfg) const override {
         return index_node_->GetIndexMeta(std::move(cfg));
@@ -59,6 +86,26 @@ class IndexNodeThreadPoolWrapper : public IndexNode {
         return index_node_->Serialize(binset);
     }
 
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        return index_node_->SerializeToFile(filename);
+    }
+
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        return index_node_->MappedRegions();
+    }
+
+    Status
+    WarmUp(WarmUpLevel level) const override {
+        return index_node_->WarmUp(level);
+    }
+
+    Status
+    CoolDown() const override {
+        return index_node_->CoolDown();
+    }
+
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override {
         return index_node_->Deserialize(binset, std::move(cfg));
@@ -84,6 +131,11 @@ class IndexNodeThreadPoolWrapper : public IndexNode {
         return index_node_->Size();
     }
 
+    MemoryUsage
+    MemoryBreakdown() const override {
+        return index_node_->MemoryBreakdown();
+    }
+
     int64_t
     Count() const override {
         return index_node_->Count();
@@ -97,6 +97,11 @@ static std::set<std::pair<std::string, VecType>> legal_knowhere_index = {
     {IndexEnum::INDEX_HNSW_PRQ, VecType::VECTOR_BFLOAT16},
     {IndexEnum::INDEX_HNSW_PRQ, VecType::VECTOR_INT8},
 
+    {IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_FLOAT},
+    {IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_FLOAT16},
+    {IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_BFLOAT16},
+    {IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_INT8},
+
     // diskann
     {IndexEnum::INDEX_DISKANN, VecType::VECTOR_FLOAT},
     {IndexEnum::INDEX_DISKANN, VecType::VECTOR_FLOAT16},
@@ -128,6 +133,7 @@ static std::set<std::string> legal_support_mmap_knowhere_index = {
     IndexEnum::INDEX_HNSW_SQ,
     IndexEnum::INDEX_HNSW_PQ,
     IndexEnum::INDEX_HNSW_PRQ,
+    IndexEnum::INDEX_HNSW_RABITQ,
 
     // sparse index
     IndexEnum::INDEX_SPARSE_INVERTED_INDEX,
@@ -75,14 +75,24 @@ class Object {
 };
 
 using ViewDataOp = std::function<const void*(size_t)>;
+// writes the pointers of the vectors of the n ids to out in a single call
+using ViewDataBatchOp = std::function<void(const int64_t* ids, size_t n, const void** out)>;
+
+// a ViewDataOp, and optionally a ViewDataBatchOp that the refine of the data view indexes resolves its candidates with,
+// one call per batch of them rather than one per candidate
+struct ViewDataOps {
+    ViewDataOp view;
+    ViewDataBatchOp batch_view = nullptr;
+};
 
 template <typename T>
 class Pack : public Object {
     // Currently, DataViewIndex and DiskIndex are mutually exclusive, they can share one object.
     // todo: pack can hold more object
-    static_assert(std::is_same_v<T, std::shared_ptr<knowhere::FileManager>> || std::is_same_v<T, knowhere::ViewDataOp>,
-                  "IndexPack only support std::shared_ptr<knowhere::FileManager> or ViewDataOp == std::function<const "
-                  "void*(size_t)> by far.");
+    static_assert(std::is_same_v<T, std::shared_ptr<knowhere::FileManager>> || std::is_same_v<T, knowhere::ViewDataOp> ||
+                      std::is_same_v<T, knowhere::ViewDataOps>,
+                  "IndexPack only support std::shared_ptr<knowhere::FileManager>, ViewDataOp == std::function<const "
+                  "void*(size_t)> or ViewDataOps by far.");
 
  public:
     Pack() {
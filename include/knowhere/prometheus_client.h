@@ -19,13 +19,35 @@
 #include <prometheus/summary.h>
 #include <prometheus/text_serializer.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "knowhere/log.h"
 
 namespace knowhere {
 
+// A metric recorded into per-thread shards without locks and drained into the metrics of the registry when they are
+//   collected, see PrometheusClient::Flush().
+class ShardedMetric {
+ public:
+    virtual ~ShardedMetric() = default;
+
+    virtual void
+    Flush() = 0;
+};
+
+// the threads are spread over the shards round robin, the shards of the threads past it are shared
+constexpr size_t kMetricShards = 64;
+
+size_t
+ThisThreadMetricShard();
+
 class PrometheusClient {
  public:
     PrometheusClient() = default;
@@ -40,19 +62,112 @@ class PrometheusClient {
 
     std::string
     GetMetrics() {
+        Flush();
         std::ostringstream ss;
         prometheus::TextSerializer serializer;
         serializer.Serialize(ss, registry_->Collect());
         return ss.str();
     }
 
+    // drains the sharded metrics into the registry, the callers that collect GetRegistry() themselves call it first
+    void
+    Flush() {
+        std::lock_guard lock(sharded_mutex_);
+        for (auto* metric : sharded_) {
+            metric->Flush();
+        }
+    }
+
+    void
+    Register(ShardedMetric* metric) {
+        std::lock_guard lock(sharded_mutex_);
+        sharded_.insert(metric);
+    }
+
+    // once it returns, metric is not flushed anymore
+    void
+    Unregister(ShardedMetric* metric) {
+        std::lock_guard lock(sharded_mutex_);
+        sharded_.erase(metric);
+    }
+
  private:
     std::shared_ptr<prometheus::Registry> registry_ = std::make_shared<prometheus::Registry>();
+    std::mutex sharded_mutex_;
+    std::unordered_set<ShardedMetric*> sharded_;
+};
+
+// A counter of the registry incremented through per-thread shards.
+class ShardedCounter final : public ShardedMetric {
+ public:
+    explicit ShardedCounter(prometheus::Counter& counter);
+
+    ~ShardedCounter() override;
+
+    void
+    Increment(double value = 1.0) {
+        auto& shard = shards_[ThisThreadMetricShard()].value;
+        double current = shard.load(std::memory_order_relaxed);
+        while (!shard.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void
+    Flush() override;
+
+ private:
+    struct alignas(64) Shard {
+        std::atomic<double> value{0.0};
+    };
+
+    prometheus::Counter& counter_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+// A histogram of the registry observed through per-thread shards of bucket counts, so that the hot paths do not take
+//   the mutex of prometheus::Histogram::Observe(). A scrape may see the count of an observation before its sum.
+class ShardedHistogram final : public ShardedMetric {
+ public:
+    static constexpr size_t kMaxBuckets = 32;
+
+    ShardedHistogram(prometheus::Histogram& histogram, const prometheus::Histogram::BucketBoundaries& buckets);
+
+    ~ShardedHistogram() override;
+
+    void
+    Observe(double value) {
+        auto& shard = shards_[ThisThreadMetricShard()];
+        // the first bucket whose upper bound is not below value, the last one is +Inf
+        const size_t bucket = std::lower_bound(buckets_.begin(), buckets_.end(), value) - buckets_.begin();
+        shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        double current = shard.sum.load(std::memory_order_relaxed);
+        while (!shard.sum.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void
+    Flush() override;
+
+    prometheus::Histogram&
+    Target() {
+        return histogram_;
+    }
+
+ private:
+    struct alignas(64) Shard {
+        std::atomic<double> sum{0.0};
+        std::array<std::atomic<uint64_t>, kMaxBuckets> counts{};
+    };
+
+    prometheus::Histogram& histogram_;
+    const prometheus::Histogram::BucketBoundaries buckets_;
+    std::unique_ptr<Shard[]> shards_;
 };
 
 /*****************************************************************************/
 // prometheus metrics
 extern const prometheus::Histogram::BucketBoundaries defaultBuckets;
+extern const prometheus::Histogram::BucketBoundaries phaseLatencyBuckets;
 extern const std::unique_ptr<PrometheusClient> prometheusClient;
 
 #define CONCATENATE(x, y) x##_##y
@@ -71,20 +186,21 @@ extern const std::unique_ptr<PrometheusClient> prometheusClient;
         prometheus::BuildCounter().Name(#name).Help(desc).Register(knowhere::prometheusClient->GetRegistry());
 
 #define DEFINE_PROMETHEUS_COUNTER(name, module) \
-    prometheus::Counter& CONCATENATE(module, name) = CONCATENATE(name, family).Add({{"module", #module}});
+    knowhere::ShardedCounter CONCATENATE(module, name){CONCATENATE(name, family).Add({{"module", #module}})};
 
 #define DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(name, desc)                     \
     prometheus::Family<prometheus::Histogram>& CONCATENATE(name, family) = \
         prometheus::BuildHistogram().Name(#name).Help(desc).Register(knowhere::prometheusClient->GetRegistry());
 
-#define DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(name, module, buckets) \
-    prometheus::Histogram& CONCATENATE(module, name) = CONCATENATE(name, family).Add({{"module", #module}}, buckets);
+#define DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(name, module, buckets)                                        \
+    knowhere::ShardedHistogram CONCATENATE(module, name){CONCATENATE(name, family).Add({{"module", #module}}, buckets), \
+                                                         buckets};
 
 #define DEFINE_PROMETHEUS_HISTOGRAM(name, module) DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(name, module, defaultBuckets)
 
 #define DECLARE_PROMETHEUS_GAUGE(name, module) extern prometheus::Gauge& CONCATENATE(module, name);
-#define DECLARE_PROMETHEUS_COUNTER(name, module) extern prometheus::Counter& CONCATENATE(module, name);
-#define DECLARE_PROMETHEUS_HISTOGRAM(name, module) extern prometheus::Histogram& CONCATENATE(module, name);
+#define DECLARE_PROMETHEUS_COUNTER(name, module) extern knowhere::ShardedCounter CONCATENATE(module, name);
+#define DECLARE_PROMETHEUS_HISTOGRAM(name, module) extern knowhere::ShardedHistogram CONCATENATE(module, name);
 
 #define DECLARE_PROMETHEUS_GAUGE_FAMILY(name, module) \
     extern prometheus::Family<prometheus::Gauge>& CONCATENATE(name, family);
@@ -109,6 +225,19 @@ DECLARE_PROMETHEUS_HISTOGRAM(range_search_latency, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM(ann_iterator_init_latency, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM(ann_iterator_init_latency, PROMETHEUS_LABEL_CARDINAL);
 
+DECLARE_PROMETHEUS_GAUGE(search_pool_pending_tasks, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_GAUGE(search_pool_queue_wait, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(search_rejected, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(search_plan_graph, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(search_plan_ivf, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(search_plan_brute_force, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_GAUGE(warm_up_pending_size, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(search_cache_hits, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(search_cache_misses, PROMETHEUS_LABEL_KNOWHERE);
+
+// labeled by index_type and phase, see SearchPhaseRecorder
+DECLARE_PROMETHEUS_HISTOGRAM_FAMILY(search_phase_latency, PROMETHEUS_LABEL_KNOWHERE);
+
 DECLARE_PROMETHEUS_HISTOGRAM(search_topk, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM(search_topk, PROMETHEUS_LABEL_CARDINAL);
 
@@ -134,12 +263,18 @@ DECLARE_PROMETHEUS_HISTOGRAM(filter_mv_supplement_ep_bool_cnt, PROMETHEUS_LABEL_
 
 DECLARE_PROMETHEUS_HISTOGRAM(hnsw_bitset_ratio, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM(hnsw_search_hops, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(hnsw_deleted_rows, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_COUNTER(hnsw_reclaimed_rows, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_GAUGE(hnsw_tombstone_size, PROMETHEUS_LABEL_KNOWHERE);
 
 DECLARE_PROMETHEUS_HISTOGRAM(diskann_bitset_ratio, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM(diskann_search_hops, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM(diskann_range_search_iters, PROMETHEUS_LABEL_KNOWHERE);
+DECLARE_PROMETHEUS_HISTOGRAM(diskann_cache_hit_ratio, PROMETHEUS_LABEL_KNOWHERE);
 
 DECLARE_PROMETHEUS_HISTOGRAM_FAMILY(sparse_dataset_nnz_len, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_HISTOGRAM_FAMILY(sparse_inverted_index_posting_list_len, PROMETHEUS_LABEL_KNOWHERE);
 DECLARE_PROMETHEUS_GAUGE_FAMILY(sparse_inverted_index_size, PROMETHEUS_LABEL_KNOWHERE);
+// labeled by index_id, index_type and section, see IndexMemoryGauges
+DECLARE_PROMETHEUS_GAUGE_FAMILY(index_memory_size, PROMETHEUS_LABEL_KNOWHERE);
 }  // namespace knowhere
@@ -34,6 +34,10 @@ struct RangeSearchResult {
     std::unique_ptr<size_t[]> lims;
 };
 
+// GetRangeSearchResult() copies the results of the queries in parallel from this total on
+constexpr size_t kParallelRangeResultSize = 1 << 16;
+
+// flattens the results of every query into the lims, labels and distances of the dataset
 RangeSearchResult
 GetRangeSearchResult(const std::vector<std::vector<float>>& result_distances,
                      const std::vector<std::vector<int64_t>>& result_labels, const bool is_ip, const int64_t nq,
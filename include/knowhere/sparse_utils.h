@@ -345,6 +345,14 @@ class GrowableVectorView {
         mmap_element_count_ = 0;
     }
 
+    // views byte_size bytes of elements that are already at data, e.g. in a read only mapping, they must not be
+    // modified
+    void
+    initialize_with_elements(const void* data, size_type byte_size) {
+        initialize(const_cast<void*>(data), byte_size);
+        mmap_element_count_ = capacity();
+    }
+
     [[nodiscard]] size_type
     capacity() const {
         return mmap_byte_size_ / sizeof(T);
@@ -375,6 +383,16 @@ class GrowableVectorView {
         return reinterpret_cast<const T*>(mmap_data_)[i];
     }
 
+    T*
+    data() {
+        return reinterpret_cast<T*>(mmap_data_);
+    }
+
+    const T*
+    data() const {
+        return reinterpret_cast<const T*>(mmap_data_);
+    }
+
     T&
     at(size_type i) {
         if (i >= mmap_element_count_) {
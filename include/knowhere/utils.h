@@ -57,6 +57,11 @@ template <typename DataType>
 extern std::unique_ptr<DataType[]>
 CopyAndNormalizeVecs(const DataType* x, size_t rows, int32_t dim);
 
+// the normalized copy lives in the SearchArena of the calling thread
+template <typename DataType>
+extern const DataType*
+CopyAndNormalizeVecsInArena(const DataType* x, size_t rows, int32_t dim);
+
 template <typename DataType>
 extern void
 NormalizeDataset(const DataSetPtr dataset);
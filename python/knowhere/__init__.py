@@ -79,19 +79,12 @@ def ArrayToBinary(arr):
 def ArrayToDataSet(arr):
     if arr.ndim == 1:
         return swigknowhere.Array2DataSetIds(arr)
-    if arr.ndim == 2:
-        if arr.dtype == np.uint8:
-            return swigknowhere.Array2DataSetU(arr)
-        if arr.dtype == np.int8:
-            return swigknowhere.Array2DataSetI(arr)
-        if arr.dtype == np.float32:
-            return swigknowhere.Array2DataSetF(arr)
-        if arr.dtype == np.float16:
-            arr = arr.astype(np.float32)
-            return swigknowhere.Array2DataSetFP16(arr)
-        if arr.dtype == bfloat16:
-            arr = arr.astype(np.float32)
-            return swigknowhere.Array2DataSetBF16(arr)
+    if arr.ndim == 2 and arr.dtype in (np.uint8, np.int8, np.float32, np.float16, bfloat16):
+        # the dataset views the rows of the array and keeps it alive, rather than copying them
+        arr = np.ascontiguousarray(arr)
+        ds = swigknowhere.Array2DataSetView(arr, 8 if arr.dtype == np.uint8 else 1)
+        if ds is not None:
+            return ds
     raise ValueError(
         """
         ArrayToDataSet only support numpy array dtype float32,uint8,float16 and bfloat16.
@@ -122,6 +115,11 @@ def DataSetToArray(ans):
     return dis, ids
 
 
+def DataSetToArrayView(ans):
+    """the distances and the int64 ids of a search result as read-only arrays that view it, without a copy"""
+    return swigknowhere.DataSet2ArrayViews(ans)
+
+
 def RangeSearchDataSetToArray(ans):
     rows = swigknowhere.DataSet_Rows(ans)
     lims = np.zeros(
@@ -129,6 +129,71 @@ class GILReleaser {
     PyThreadState* save;
 };
 
+// the key of the Py_buffer a dataset viewing a python array holds
+constexpr const char* kPyBufferOwner = "py_buffer_owner";
+
+// a dataset of the rows of a C-contiguous 2d array viewed through the buffer protocol, without a copy. The buffer,
+//   and so the array, is released with the dataset, which may be on a thread of the engine. dim_scale is 8 for binary
+//   rows, whose dim is in bits. nullptr if the array can not be viewed.
+knowhere::DataSetPtr
+Array2DataSetView(PyObject* arr, int dim_scale) {
+    auto view = std::make_unique<Py_buffer>();
+    if (PyObject_GetBuffer(arr, view.get(), PyBUF_C_CONTIGUOUS) != 0) {
+        PyErr_Clear();
+        return nullptr;
+    }
+    std::shared_ptr<Py_buffer> owner(view.release(), [](Py_buffer* buffer) {
+        if (Py_IsInitialized()) {
+            auto state = PyGILState_Ensure();
+            PyBuffer_Release(buffer);
+            PyGILState_Release(state);
+        }
+        delete buffer;
+    });
+    if (owner->ndim != 2) {
+        return nullptr;
+    }
+    auto ds = std::make_shared<DataSet>();
+    ds->SetIsOwner(false);
+    ds->SetRows(owner->shape[0]);
+    ds->SetDim(owner->shape[1] * dim_scale);
+    ds->SetTensor(owner->buf);
+    ds->Set(kPyBufferOwner, std::move(owner));
+    return ds;
+}
+
+// a read-only array of rows * cols of the memory of result, which the array keeps alive
+PyObject*
+ResultArrayView(const knowhere::DataSetPtr& result, int64_t rows, int64_t cols, int type, const void* data) {
+    npy_intp dims[2] = {rows, cols};
+    PyObject* arr = PyArray_SimpleNewFromData(2, dims, type, const_cast<void*>(data));
+    if (arr == nullptr) {
+        return nullptr;
+    }
+    PyArray_CLEARFLAGS(reinterpret_cast<PyArrayObject*>(arr), NPY_ARRAY_WRITEABLE);
+    PyObject* owner = PyCapsule_New(new knowhere::DataSetPtr(result), nullptr, [](PyObject* capsule) {
+        delete static_cast<knowhere::DataSetPtr*>(PyCapsule_GetPointer(capsule, nullptr));
+    });
+    if (owner == nullptr || PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(arr), owner) != 0) {
+        Py_DECREF(arr);
+        return nullptr;
+    }
+    return arr;
+}
+
+// the distances and the int64 ids of a search result as arrays of nq * k that view it, without a copy
+PyObject*
+DataSet2ArrayViews(knowhere::DataSetPtr result) {
+    PyObject* dis = ResultArrayView(result, result->GetRows(), result->GetDim(), NPY_FLOAT32, result->GetDistance());
+    PyObject* ids = ResultArrayView(result, result->GetRows(), result->GetDim(), NPY_INT64, result->GetIds());
+    if (dis == nullptr || ids == nullptr) {
+        Py_XDECREF(dis);
+        Py_XDECREF(ids);
+        return nullptr;
+    }
+    return Py_BuildValue("(NN)", dis, ids);
+}
+
 class AnnIteratorWrap {
  public:
     AnnIteratorWrap(std::shared_ptr<IndexNode::iterator> it = nullptr) : it_(it) {
@@ -140,10 +205,12 @@ class AnnIteratorWrap {
     }
 
     bool HasNext() {
+        GILReleaser rel;
         return it_->HasNext();
     }
 
     std::pair<int64_t, float> Next() {
+        GILReleaser rel;
         return it_->Next();
     }
 
@@ -325,6 +392,7 @@ Array2DataSetF(float* xb, int nb, int dim) {
 
 knowhere::DataSetPtr
 Array2DataSetFP16(float* xb, int nb, int dim) {
+    GILReleaser rel;
     auto ds = std::make_shared<DataSet>();
     ds->SetIsOwner(true);
     ds->SetRows(nb);
@@ -342,6 +410,7 @@ Array2DataSetFP16(float* xb, int nb, int dim) {
 #pragma GCC optimize("O0")
 knowhere::DataSetPtr
 Array2DataSetBF16(float* xb, int nb, int dim) {
+    GILReleaser rel;
     using bf16 = knowhere::bf16;
     auto ds = std::make_shared<DataSet>();
     ds->SetIsOwner(true);
@@ -364,6 +433,7 @@ CurrentVersion() {
 
 knowhere::DataSetPtr
 Array2SparseDataSet(float* data, int nb1, int* ids, int nb2, int64_t* indptr, int nb3) {
+    GILReleaser rel;
     int rows = nb3 - 1;
     int cols = 0;
     for (auto i = 0; i < nb2; ++i) {
@@ -571,6 +641,7 @@ DumpRangeResultDis(knowhere::DataSetPtr result, float* dis, int len) {
 
 void
 Dump(knowhere::BinarySetPtr binset, const std::string& file_name) {
+    GILReleaser rel;
     auto binary_set = *binset;
     auto binary_map = binset -> binary_map_;
     std::ofstream outfile;
@@ -594,6 +665,7 @@ Dump(knowhere::BinarySetPtr binset, const std::string& file_name) {
 
 void
 Load(knowhere::BinarySetPtr binset, const std::string& file_name) {
+    GILReleaser rel;
     std::ifstream infile;
     infile.open(file_name, std::ios::in);
     if (infile.good()) {
@@ -621,6 +693,7 @@ Load(knowhere::BinarySetPtr binset, const std::string& file_name) {
 
 bool
 WriteIndexToDisk(const knowhere::BinarySetPtr binset, const std::string& index_type, const std::string& data_path) {
+    GILReleaser rel;
     auto bin = binset->GetByName(index_type);
     if (bin == nullptr) {
         return false;
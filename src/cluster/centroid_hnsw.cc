@@ -0,0 +1,37 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "cluster/centroid_hnsw.h"
+
+#include "cluster/kmeans/kmeans_assign_config.h"
+
+namespace knowhere {
+
+std::unique_ptr<faiss::IndexHNSWFlat>
+BuildCentroidHnsw(const float* centroids, int64_t k, int64_t dim, faiss::MetricType metric, int64_t m,
+                  int64_t ef_construction, int64_t ef_search) {
+    auto hnsw = std::make_unique<faiss::IndexHNSWFlat>(dim, m, metric);
+    hnsw->hnsw.efConstruction = ef_construction;
+    hnsw->hnsw.efSearch = ef_search;
+    hnsw->add(k, centroids);
+    return hnsw;
+}
+
+std::unique_ptr<faiss::IndexHNSWFlat>
+BuildAssignHnsw(const float* centroids, int64_t k, int64_t dim, const KmeansAssignConfig& cfg) {
+    if (cfg.assign_index.value() != "hnsw") {
+        return nullptr;
+    }
+    return BuildCentroidHnsw(centroids, k, dim, faiss::METRIC_L2, cfg.assign_hnsw_m.value(),
+                             cfg.assign_ef_construction.value(), cfg.assign_ef.value());
+}
+
+}  // namespace knowhere
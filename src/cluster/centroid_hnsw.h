@@ -0,0 +1,36 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef CENTROID_HNSW_H
+#define CENTROID_HNSW_H
+
+#include <cstdint>
+#include <memory>
+
+#include "faiss/IndexHNSW.h"
+
+namespace knowhere {
+
+class KmeansAssignConfig;
+
+// An HNSW graph over k centroids, for the coarse search of IVF indexes and for the assignment of rows to clusters once
+// a full scan over the centroids is too slow. ef_search is the ef of the searches that pass no parameters.
+std::unique_ptr<faiss::IndexHNSWFlat>
+BuildCentroidHnsw(const float* centroids, int64_t k, int64_t dim, faiss::MetricType metric, int64_t m,
+                  int64_t ef_construction, int64_t ef_search);
+
+// BuildCentroidHnsw() with the parameters of cfg if its assign_index is hnsw, nullptr for a full scan
+std::unique_ptr<faiss::IndexHNSWFlat>
+BuildAssignHnsw(const float* centroids, int64_t k, int64_t dim, const KmeansAssignConfig& cfg);
+
+}  // namespace knowhere
+
+#endif /* CENTROID_HNSW_H */
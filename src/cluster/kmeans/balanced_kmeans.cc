@@ -0,0 +1,304 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "cluster/kmeans/balanced_kmeans.h"
+
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cluster/centroid_hnsw.h"
+#include "cluster/kmeans/balanced_kmeans_config.h"
+#include "faiss/IndexFlat.h"
+#include "faiss/utils/distances.h"
+#include "knowhere/cluster/cluster_factory.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/log.h"
+#include "knowhere/utils.h"
+#include "simd/hook.h"
+
+namespace knowhere {
+
+namespace {
+constexpr uint64_t kBalancedKmeansSeed = 1234;
+// the nearest centroids a row is offered before all the centroids with room are scanned
+constexpr int64_t kBalancedKmeansCandidates = 8;
+}  // namespace
+
+int64_t
+BalancedClusterCapacity(int64_t rows, int64_t k, float max_cluster_ratio) {
+    const auto capacity = static_cast<int64_t>(std::ceil(std::max(1.0f, max_cluster_ratio) * rows / k));
+    // k clusters of this size always hold all the rows
+    return std::max(capacity, (rows + k - 1) / k);
+}
+
+void
+BalancedAssign(const float* x, int64_t rows, int64_t dim, const float* centroids, int64_t k, float max_cluster_ratio,
+               uint32_t* ids, const faiss::Index* index) {
+    if (k <= 0 || rows <= 0) {
+        return;
+    }
+    const int64_t m = std::min(k, kBalancedKmeansCandidates);
+    const int64_t capacity = BalancedClusterCapacity(rows, k, max_cluster_ratio);
+
+    std::vector<faiss::idx_t> labels(rows * m);
+    std::vector<float> distances(rows * m);
+    if (index != nullptr) {
+        index->search(rows, x, m, distances.data(), labels.data());
+    } else {
+        faiss::IndexFlatL2 quantizer(dim);
+        quantizer.add(k, centroids);
+        quantizer.search(rows, x, m, distances.data(), labels.data());
+    }
+
+    std::vector<int64_t> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    if (m > 1) {
+        std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+            return distances[a * m + 1] - distances[a * m] > distances[b * m + 1] - distances[b * m];
+        });
+    }
+
+    std::vector<int64_t> sizes(k, 0);
+    for (const int64_t i : order) {
+        int64_t assigned = -1;
+        for (int64_t c = 0; c < m; c++) {
+            const faiss::idx_t label = labels[i * m + c];
+            if (label >= 0 && sizes[label] < capacity) {
+                assigned = label;
+                break;
+            }
+        }
+        if (assigned < 0) {
+            // all of its candidates are full, the nearest centroid with room takes it
+            float best = std::numeric_limits<float>::max();
+            for (int64_t j = 0; j < k; j++) {
+                if (sizes[j] >= capacity) {
+                    continue;
+                }
+                const float d = faiss::fvec_L2sqr(x + i * dim, centroids + j * dim, dim);
+                if (assigned < 0 || d < best) {
+                    best = d;
+                    assigned = j;
+                }
+            }
+        }
+        ids[i] = static_cast<uint32_t>(assigned);
+        sizes[assigned]++;
+    }
+}
+
+void
+BalancedKmeans(const float* x, int64_t rows, int64_t dim, int64_t k, int64_t n_iters, float max_cluster_ratio,
+               bool spherical, float* centroids, uint32_t* ids) {
+    if (k <= 0 || rows < k) {
+        throw std::invalid_argument("can not train " + std::to_string(k) + " balanced clusters with " +
+                                    std::to_string(rows) + " rows");
+    }
+
+    // k distinct random rows are the initial centroids (Floyd's sampling)
+    std::mt19937_64 rng(kBalancedKmeansSeed);
+    std::unordered_set<int64_t> picked;
+    for (int64_t j = rows - k; j < rows; j++) {
+        const int64_t row = std::uniform_int_distribution<int64_t>(0, j)(rng);
+        picked.insert(picked.count(row) ? j : row);
+    }
+    int64_t c = 0;
+    for (const int64_t row : picked) {
+        std::memcpy(centroids + c * dim, x + row * dim, dim * sizeof(float));
+        c++;
+    }
+
+    std::vector<int64_t> offsets(k + 1);
+    std::vector<int64_t> order(rows);
+    for (int64_t iter = 0; iter < n_iters; iter++) {
+        BalancedAssign(x, rows, dim, centroids, k, max_cluster_ratio, ids);
+
+        // group the rows by their clusters
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (int64_t i = 0; i < rows; i++) {
+            offsets[ids[i] + 1]++;
+        }
+        for (int64_t j = 0; j < k; j++) {
+            offsets[j + 1] += offsets[j];
+        }
+        for (int64_t i = 0; i < rows; i++) {
+            order[offsets[ids[i]]++] = i;
+        }
+        for (int64_t j = k; j > 0; j--) {
+            offsets[j] = offsets[j - 1];
+        }
+        offsets[0] = 0;
+
+#pragma omp parallel for schedule(dynamic, 16)
+        for (int64_t j = 0; j < k; j++) {
+            if (offsets[j + 1] == offsets[j]) {
+                continue;
+            }
+            float* centroid = centroids + j * dim;
+            std::fill(centroid, centroid + dim, 0.0f);
+            for (int64_t p = offsets[j]; p < offsets[j + 1]; p++) {
+                const float* row = x + order[p] * dim;
+                for (int64_t d = 0; d < dim; d++) {
+                    centroid[d] += row[d];
+                }
+            }
+            const float scale = 1.0f / (offsets[j + 1] - offsets[j]);
+            for (int64_t d = 0; d < dim; d++) {
+                centroid[d] *= scale;
+            }
+        }
+
+        // clusters that got no row start over from random rows
+        for (int64_t j = 0; j < k; j++) {
+            if (offsets[j + 1] == offsets[j]) {
+                const int64_t row = std::uniform_int_distribution<int64_t>(0, rows - 1)(rng);
+                std::memcpy(centroids + j * dim, x + row * dim, dim * sizeof(float));
+            }
+        }
+        if (spherical) {
+            faiss::fvec_renorm_L2(dim, k, centroids);
+        }
+    }
+    BalancedAssign(x, rows, dim, centroids, k, max_cluster_ratio, ids);
+}
+
+// K-means whose clusters hold at most balanced_kmeans_ratio times the mean number of rows, see BalancedKmeans().
+// Assign() balances the rows it is given the same way.
+template <typename DataType>
+class BalancedKmeansClusterNode : public ClusterNode {
+ public:
+    BalancedKmeansClusterNode(const Object& object) {
+    }
+
+    expected<DataSetPtr>
+    Train(const DataSet& dataset, const Config& cfg) override;
+
+    expected<DataSetPtr>
+    Assign(const DataSet& dataset) override;
+
+    expected<DataSetPtr>
+    GetCentroids() const override;
+
+    std::unique_ptr<Config>
+    CreateConfig() const override {
+        return std::make_unique<BalancedKmeansConfig>();
+    }
+
+    std::string
+    Type() const override {
+        return ClusterEnum::CLUSTER_BALANCED_KMEANS;
+    }
+
+ private:
+    // the rows of 'dataset' as fp32, 'holder' keeps converted rows alive
+    static const float*
+    GetRows(const DataSet& dataset, DataSetPtr& holder) {
+        if constexpr (std::is_same_v<DataType, fp32>) {
+            return reinterpret_cast<const float*>(dataset.GetTensor());
+        } else {
+            holder = data_type_conversion<DataType, fp32>(dataset);
+            return reinterpret_cast<const float*>(holder->GetTensor());
+        }
+    }
+
+    std::vector<float> centroids_;
+    // the HNSW over the centroids the nearest ones of the rows are searched in, nullptr for a full scan
+    std::unique_ptr<faiss::IndexHNSWFlat> assign_hnsw_ = nullptr;
+    int64_t dim_ = 0;
+    float max_cluster_ratio_ = 1.0f;
+};
+
+template <typename DataType>
+expected<DataSetPtr>
+BalancedKmeansClusterNode<DataType>::Train(const DataSet& dataset, const Config& cfg) {
+    const BalancedKmeansConfig& kmeans_cfg = static_cast<const BalancedKmeansConfig&>(cfg);
+    const int64_t rows = dataset.GetRows();
+    const int64_t dim = dataset.GetDim();
+    const int64_t k = kmeans_cfg.num_clusters.value();
+    if (rows < k) {
+        LOG_KNOWHERE_ERROR_ << "can not train " << k << " clusters with " << rows << " rows";
+        return expected<DataSetPtr>::Err(Status::invalid_args, "num_clusters is larger than the number of rows");
+    }
+
+    ThreadPool::ScopedBuildOmpSetter setter;
+    try {
+        DataSetPtr holder;
+        const float* x = GetRows(dataset, holder);
+        std::vector<float> centroids(k * dim);
+        auto ids = std::make_unique<uint32_t[]>(rows);
+        BalancedKmeans(x, rows, dim, k, kmeans_cfg.kmeans_n_iters.value(), kmeans_cfg.balanced_kmeans_ratio.value(),
+                       false, centroids.data(), ids.get());
+        assign_hnsw_ = BuildAssignHnsw(centroids.data(), k, dim, kmeans_cfg);
+        centroids_ = std::move(centroids);
+        dim_ = dim;
+        max_cluster_ratio_ = kmeans_cfg.balanced_kmeans_ratio.value();
+        return GenResultDataSet(rows, 1, std::move(ids));
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "balanced kmeans inner error: " << e.what();
+        return expected<DataSetPtr>::Err(Status::cluster_inner_error, e.what());
+    }
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+BalancedKmeansClusterNode<DataType>::Assign(const DataSet& dataset) {
+    if (centroids_.empty()) {
+        LOG_KNOWHERE_WARNING_ << "assigning rows with untrained balanced kmeans";
+        return expected<DataSetPtr>::Err(Status::index_not_trained, "kmeans not trained");
+    }
+    if (dataset.GetDim() != dim_) {
+        LOG_KNOWHERE_WARNING_ << "dimension of rows " << dataset.GetDim() << " differs from " << dim_;
+        return expected<DataSetPtr>::Err(Status::invalid_args, "dimension mismatch");
+    }
+
+    const int64_t rows = dataset.GetRows();
+    ThreadPool::ScopedBuildOmpSetter setter;
+    try {
+        DataSetPtr holder;
+        const float* x = GetRows(dataset, holder);
+        auto ids = std::make_unique<uint32_t[]>(rows);
+        BalancedAssign(x, rows, dim_, centroids_.data(), centroids_.size() / dim_, max_cluster_ratio_, ids.get(),
+                       assign_hnsw_.get());
+        return GenResultDataSet(rows, 1, std::move(ids));
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "balanced kmeans inner error: " << e.what();
+        return expected<DataSetPtr>::Err(Status::cluster_inner_error, e.what());
+    }
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+BalancedKmeansClusterNode<DataType>::GetCentroids() const {
+    if (centroids_.empty()) {
+        LOG_KNOWHERE_WARNING_ << "getting centroids of untrained balanced kmeans";
+        return expected<DataSetPtr>::Err(Status::index_not_trained, "kmeans not trained");
+    }
+
+    auto centroids = std::make_unique<float[]>(centroids_.size());
+    std::copy(centroids_.begin(), centroids_.end(), centroids.get());
+    return GenResultDataSet(centroids_.size() / dim_, dim_, std::move(centroids));
+}
+
+KNOWHERE_CLUSTER_SIMPLE_REGISTER_GLOBAL(BALANCED_KMEANS, BalancedKmeansClusterNode, fp32);
+KNOWHERE_CLUSTER_SIMPLE_REGISTER_GLOBAL(BALANCED_KMEANS, BalancedKmeansClusterNode, fp16);
+KNOWHERE_CLUSTER_SIMPLE_REGISTER_GLOBAL(BALANCED_KMEANS, BalancedKmeansClusterNode, bf16);
+
+}  // namespace knowhere
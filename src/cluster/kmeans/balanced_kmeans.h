@@ -0,0 +1,42 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef BALANCED_KMEANS_H
+#define BALANCED_KMEANS_H
+
+#include <cstdint>
+
+namespace faiss {
+struct Index;
+}  // namespace faiss
+
+namespace knowhere {
+
+// the most rows a cluster of a balanced k-means may hold, max_cluster_ratio times the mean size
+int64_t
+BalancedClusterCapacity(int64_t rows, int64_t k, float max_cluster_ratio);
+
+// Assigns every row to the nearest of the k centroids that still has room for it, no cluster gets more than
+// BalancedClusterCapacity() rows. The rows that lose the most by missing their nearest centroid choose first. The
+// nearest centroids of the rows are searched in index if it is given, an index over the same centroids.
+void
+BalancedAssign(const float* x, int64_t rows, int64_t dim, const float* centroids, int64_t k, float max_cluster_ratio,
+               uint32_t* ids, const faiss::Index* index = nullptr);
+
+// Lloyd's k-means with the assignment step of BalancedAssign(), so that the clusters are of even sizes. The
+// centroids are L2 normalized after each update if spherical is set. Throws on errors.
+void
+BalancedKmeans(const float* x, int64_t rows, int64_t dim, int64_t k, int64_t n_iters, float max_cluster_ratio,
+               bool spherical, float* centroids, uint32_t* ids);
+
+}  // namespace knowhere
+
+#endif /* BALANCED_KMEANS_H */
@@ -0,0 +1,45 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef BALANCED_KMEANS_CONFIG_H
+#define BALANCED_KMEANS_CONFIG_H
+
+#include "cluster/kmeans/kmeans_assign_config.h"
+
+namespace knowhere {
+
+class BalancedKmeansConfig : public KmeansAssignConfig {
+ public:
+    CFG_INT num_clusters;
+    CFG_INT kmeans_n_iters;
+    CFG_FLOAT balanced_kmeans_ratio;
+    KNOHWERE_DECLARE_CONFIG(BalancedKmeansConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_clusters)
+            .description("number of clusters")
+            .set_default(8)
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(kmeans_n_iters)
+            .description("number of k-means iterations")
+            .set_default(10)
+            .set_range(1, 1024)
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(balanced_kmeans_ratio)
+            .description("the most rows a cluster may hold, relative to the mean size of the clusters")
+            .set_default(1.1)
+            .set_range(1.0, 1024.0)
+            .for_cluster();
+    }
+};
+
+}  // namespace knowhere
+
+#endif /* BALANCED_KMEANS_CONFIG_H */
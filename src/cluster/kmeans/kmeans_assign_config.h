@@ -0,0 +1,70 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef KMEANS_ASSIGN_CONFIG_H
+#define KMEANS_ASSIGN_CONFIG_H
+
+#include <string>
+
+#include "knowhere/config.h"
+#include "knowhere/tolower.h"
+
+namespace knowhere {
+
+// how the k-means cluster nodes assign rows to the trained centroids, in the last step of Train() and in Assign()
+class KmeansAssignConfig : public Config {
+ public:
+    // the index over the centroids, one of [flat, hnsw]. HNSW makes the assignment to a large number of clusters
+    //   much faster, at the cost of some rows going to a near but not the nearest centroid
+    CFG_STRING assign_index;
+    CFG_INT assign_hnsw_m;
+    CFG_INT assign_ef_construction;
+    // the ef of the HNSW search, higher is more accurate
+    CFG_INT assign_ef;
+    KNOHWERE_DECLARE_CONFIG(KmeansAssignConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(assign_index)
+            .description("the index the rows are assigned to the centroids with, one of [flat, hnsw]")
+            .set_default("flat")
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(assign_hnsw_m)
+            .description("number of neighbors of a centroid in the HNSW graph of the assignment")
+            .set_default(32)
+            .set_range(2, 2048)
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(assign_ef_construction)
+            .description("ef used to build the HNSW graph of the assignment")
+            .set_default(200)
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(assign_ef)
+            .description("ef of the HNSW search of the assignment")
+            .set_default(64)
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_cluster();
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        if (param_type == PARAM_TYPE::CLUSTER) {
+            const std::string index = str_to_lower(assign_index.value());
+            if (index != "flat" && index != "hnsw") {
+                std::string msg = "assign index " + assign_index.value() + " is not supported, supported: [flat hnsw]";
+                return HandleError(err_msg, msg, Status::invalid_args);
+            }
+            assign_index = index;
+        }
+        return Status::success;
+    }
+};
+
+}  // namespace knowhere
+
+#endif /* KMEANS_ASSIGN_CONFIG_H */
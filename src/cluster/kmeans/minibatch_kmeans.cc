@@ -0,0 +1,281 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "cluster/centroid_hnsw.h"
+#include "cluster/kmeans/minibatch_kmeans_config.h"
+#include "faiss/IndexFlat.h"
+#include "faiss/IndexFlatElkan.h"
+#include "knowhere/cluster/cluster_factory.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/log.h"
+#include "knowhere/utils.h"
+
+namespace knowhere {
+
+namespace {
+constexpr uint64_t kMiniBatchKmeansSeed = 1234;
+// the number of rows that are assigned to the trained centroids at once
+constexpr int64_t kMiniBatchKmeansAssignBatchSize = 65536;
+}  // namespace
+
+// Mini-batch k-means (Sculley, 2010) over a stream of row batches.
+// Only one batch is converted to fp32 at a time. The rows of a batch are assigned to the current centroids, then
+//   every centroid moves towards its rows with a learning rate of 1 / (number of rows it has absorbed so far).
+template <typename DataType>
+class MiniBatchKmeansClusterNode : public ClusterNode {
+ public:
+    MiniBatchKmeansClusterNode(const Object& object) {
+    }
+
+    expected<DataSetPtr>
+    Train(const DataSet& dataset, const Config& cfg) override;
+
+    expected<DataSetPtr>
+    Assign(const DataSet& dataset) override;
+
+    expected<DataSetPtr>
+    GetCentroids() const override;
+
+    std::unique_ptr<Config>
+    CreateConfig() const override {
+        return std::make_unique<MiniBatchKmeansConfig>();
+    }
+
+    std::string
+    Type() const override {
+        return ClusterEnum::CLUSTER_MINIBATCH_KMEANS;
+    }
+
+ private:
+    // rows [start, start + count) of 'dataset' as fp32, 'holder' keeps converted rows alive
+    static const float*
+    GetRows(const DataSet& dataset, const int64_t start, const int64_t count, DataSetPtr& holder);
+
+    // the nearest centroids of all the rows of 'dataset', batch by batch
+    static void
+    AssignRows(const DataSet& dataset, const faiss::Index& quantizer, const int64_t batch_size, uint32_t* ids);
+
+    std::unique_ptr<faiss::IndexFlatL2> centroids_ = nullptr;
+    // the HNSW over the centroids the rows are assigned with, nullptr for a full scan
+    std::unique_ptr<faiss::IndexHNSWFlat> assign_hnsw_ = nullptr;
+};
+
+template <typename DataType>
+const float*
+MiniBatchKmeansClusterNode<DataType>::GetRows(const DataSet& dataset, const int64_t start, const int64_t count,
+                                              DataSetPtr& holder) {
+    if constexpr (std::is_same_v<DataType, fp32>) {
+        return reinterpret_cast<const float*>(dataset.GetTensor()) + start * dataset.GetDim();
+    } else {
+        holder = data_type_conversion<DataType, fp32>(dataset, start, count);
+        return reinterpret_cast<const float*>(holder->GetTensor());
+    }
+}
+
+template <typename DataType>
+void
+MiniBatchKmeansClusterNode<DataType>::AssignRows(const DataSet& dataset, const faiss::Index& quantizer,
+                                                 const int64_t batch_size, uint32_t* ids) {
+    const int64_t rows = dataset.GetRows();
+    std::vector<faiss::idx_t> labels(batch_size);
+    std::vector<float> distances(batch_size);
+    for (int64_t i0 = 0; i0 < rows; i0 += batch_size) {
+        const int64_t n = std::min(batch_size, rows - i0);
+        DataSetPtr holder;
+        const float* x = GetRows(dataset, i0, n, holder);
+        quantizer.search(n, x, 1, distances.data(), labels.data());
+        for (int64_t i = 0; i < n; i++) {
+            ids[i0 + i] = static_cast<uint32_t>(labels[i]);
+        }
+    }
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+MiniBatchKmeansClusterNode<DataType>::Train(const DataSet& dataset, const Config& cfg) {
+    const MiniBatchKmeansConfig& kmeans_cfg = static_cast<const MiniBatchKmeansConfig&>(cfg);
+    const int64_t rows = dataset.GetRows();
+    const int64_t dim = dataset.GetDim();
+    const int64_t k = kmeans_cfg.num_clusters.value();
+    if (rows < k) {
+        LOG_KNOWHERE_ERROR_ << "can not train " << k << " clusters with " << rows << " rows";
+        return expected<DataSetPtr>::Err(Status::invalid_args, "num_clusters is larger than the number of rows");
+    }
+
+    const int64_t batch_size = std::min<int64_t>(kmeans_cfg.kmeans_batch_size.value(), rows);
+    const int64_t n_iters = kmeans_cfg.kmeans_n_iters.value();
+    const float fraction = kmeans_cfg.kmeans_trainset_fraction.value();
+    const bool use_elkan = kmeans_cfg.use_elkan.value();
+
+    ThreadPool::ScopedBuildOmpSetter setter;
+    try {
+        std::mt19937_64 rng(kMiniBatchKmeansSeed);
+        std::vector<float> centroids(k * dim);
+        auto copy_random_row = [&](float* dst) {
+            DataSetPtr holder;
+            const int64_t row = std::uniform_int_distribution<int64_t>(0, rows - 1)(rng);
+            std::memcpy(dst, GetRows(dataset, row, 1, holder), dim * sizeof(float));
+        };
+
+        // k distinct random rows are the initial centroids (Floyd's sampling)
+        std::unordered_set<int64_t> picked;
+        for (int64_t j = rows - k; j < rows; j++) {
+            const int64_t row = std::uniform_int_distribution<int64_t>(0, j)(rng);
+            picked.insert(picked.count(row) ? j : row);
+        }
+        int64_t c = 0;
+        for (const int64_t row : picked) {
+            DataSetPtr holder;
+            std::memcpy(centroids.data() + c * dim, GetRows(dataset, row, 1, holder), dim * sizeof(float));
+            c++;
+        }
+
+        std::vector<int64_t> counts(k, 0);
+        std::vector<float> sampled;
+        std::vector<faiss::idx_t> labels(batch_size);
+        std::vector<float> distances(batch_size);
+        std::vector<int64_t> offsets(k + 1);
+        std::vector<int64_t> order(batch_size);
+        std::bernoulli_distribution sample(fraction);
+        faiss::IndexFlatElkan quantizer(dim, faiss::METRIC_L2, false, use_elkan);
+
+        for (int64_t iter = 0; iter < n_iters; iter++) {
+            for (int64_t i0 = 0; i0 < rows; i0 += batch_size) {
+                const int64_t n = std::min(batch_size, rows - i0);
+                DataSetPtr holder;
+                const float* x = GetRows(dataset, i0, n, holder);
+                int64_t m = n;
+                if (fraction < 1.0f) {
+                    sampled.resize(batch_size * dim);
+                    m = 0;
+                    for (int64_t i = 0; i < n; i++) {
+                        if (sample(rng)) {
+                            std::memcpy(sampled.data() + m * dim, x + i * dim, dim * sizeof(float));
+                            m++;
+                        }
+                    }
+                    x = sampled.data();
+                }
+                if (m == 0) {
+                    continue;
+                }
+
+                quantizer.reset();
+                quantizer.add(k, centroids.data());
+                quantizer.search(m, x, 1, distances.data(), labels.data());
+
+                // group the rows of the batch by their centroids
+                std::fill(offsets.begin(), offsets.end(), 0);
+                for (int64_t i = 0; i < m; i++) {
+                    offsets[labels[i] + 1]++;
+                }
+                for (int64_t j = 0; j < k; j++) {
+                    offsets[j + 1] += offsets[j];
+                }
+                for (int64_t i = 0; i < m; i++) {
+                    order[offsets[labels[i]]++] = i;
+                }
+                for (int64_t j = k; j > 0; j--) {
+                    offsets[j] = offsets[j - 1];
+                }
+                offsets[0] = 0;
+
+#pragma omp parallel for schedule(dynamic, 64)
+                for (int64_t j = 0; j < k; j++) {
+                    float* centroid = centroids.data() + j * dim;
+                    for (int64_t p = offsets[j]; p < offsets[j + 1]; p++) {
+                        const float* row = x + order[p] * dim;
+                        counts[j]++;
+                        const float eta = 1.0f / counts[j];
+                        for (int64_t d = 0; d < dim; d++) {
+                            centroid[d] += eta * (row[d] - centroid[d]);
+                        }
+                    }
+                }
+            }
+
+            // centroids that have absorbed no row start over from random rows
+            for (int64_t j = 0; j < k; j++) {
+                if (counts[j] == 0) {
+                    copy_random_row(centroids.data() + j * dim);
+                }
+            }
+        }
+
+        auto index = std::make_unique<faiss::IndexFlatL2>(dim);
+        index->add(k, centroids.data());
+        auto assign_hnsw = BuildAssignHnsw(centroids.data(), k, dim, kmeans_cfg);
+        auto ids = std::make_unique<uint32_t[]>(rows);
+        AssignRows(dataset, assign_hnsw ? static_cast<const faiss::Index&>(*assign_hnsw) : *index, batch_size,
+                   ids.get());
+        centroids_ = std::move(index);
+        assign_hnsw_ = std::move(assign_hnsw);
+        return GenResultDataSet(rows, 1, std::move(ids));
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "kmeans inner error: " << e.what();
+        return expected<DataSetPtr>::Err(Status::cluster_inner_error, e.what());
+    }
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+MiniBatchKmeansClusterNode<DataType>::Assign(const DataSet& dataset) {
+    if (centroids_ == nullptr) {
+        LOG_KNOWHERE_WARNING_ << "assigning rows with untrained kmeans";
+        return expected<DataSetPtr>::Err(Status::index_not_trained, "kmeans not trained");
+    }
+    if (dataset.GetDim() != centroids_->d) {
+        LOG_KNOWHERE_WARNING_ << "dimension of rows " << dataset.GetDim() << " differs from " << centroids_->d;
+        return expected<DataSetPtr>::Err(Status::invalid_args, "dimension mismatch");
+    }
+
+    const int64_t rows = dataset.GetRows();
+    ThreadPool::ScopedBuildOmpSetter setter;
+    try {
+        auto ids = std::make_unique<uint32_t[]>(rows);
+        AssignRows(dataset, assign_hnsw_ ? static_cast<const faiss::Index&>(*assign_hnsw_) : *centroids_,
+                   kMiniBatchKmeansAssignBatchSize, ids.get());
+        return GenResultDataSet(rows, 1, std::move(ids));
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "kmeans inner error: " << e.what();
+        return expected<DataSetPtr>::Err(Status::cluster_inner_error, e.what());
+    }
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+MiniBatchKmeansClusterNode<DataType>::GetCentroids() const {
+    if (centroids_ == nullptr) {
+        LOG_KNOWHERE_WARNING_ << "getting centroids of untrained kmeans";
+        return expected<DataSetPtr>::Err(Status::index_not_trained, "kmeans not trained");
+    }
+
+    const int64_t k = centroids_->ntotal;
+    const int64_t dim = centroids_->d;
+    auto centroids = std::make_unique<float[]>(k * dim);
+    std::copy_n(centroids_->get_xb(), k * dim, centroids.get());
+    return GenResultDataSet(k, dim, std::move(centroids));
+}
+
+KNOWHERE_CLUSTER_SIMPLE_REGISTER_GLOBAL(MINIBATCH_KMEANS, MiniBatchKmeansClusterNode, fp32);
+KNOWHERE_CLUSTER_SIMPLE_REGISTER_GLOBAL(MINIBATCH_KMEANS, MiniBatchKmeansClusterNode, fp16);
+KNOWHERE_CLUSTER_SIMPLE_REGISTER_GLOBAL(MINIBATCH_KMEANS, MiniBatchKmeansClusterNode, bf16);
+
+}  // namespace knowhere
@@ -0,0 +1,56 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef MINIBATCH_KMEANS_CONFIG_H
+#define MINIBATCH_KMEANS_CONFIG_H
+
+#include "cluster/kmeans/kmeans_assign_config.h"
+
+namespace knowhere {
+
+class MiniBatchKmeansConfig : public KmeansAssignConfig {
+ public:
+    CFG_INT num_clusters;
+    CFG_INT kmeans_batch_size;
+    CFG_INT kmeans_n_iters;
+    CFG_FLOAT kmeans_trainset_fraction;
+    CFG_BOOL use_elkan;
+    KNOHWERE_DECLARE_CONFIG(MiniBatchKmeansConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_clusters)
+            .description("number of clusters")
+            .set_default(8)
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(kmeans_batch_size)
+            .description("number of rows the centroids are updated with at once")
+            .set_default(65536)
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(kmeans_n_iters)
+            .description("number of passes over the training rows")
+            .set_default(5)
+            .set_range(1, 1024)
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(kmeans_trainset_fraction)
+            .description("fraction of the rows of each batch that are used to update the centroids")
+            .set_default(1.0)
+            .set_range(0.0, 1.0, false, true)
+            .for_cluster();
+        KNOWHERE_CONFIG_DECLARE_FIELD(use_elkan)
+            .description("whether to use elkan algorithm to assign the rows of a batch")
+            .set_default(true)
+            .for_cluster();
+    }
+};
+
+}  // namespace knowhere
+
+#endif /* MINIBATCH_KMEANS_CONFIG_H */
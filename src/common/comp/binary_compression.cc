@@ -0,0 +1,236 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/binary_compression.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/log.h"
+
+namespace knowhere {
+
+namespace {
+
+constexpr char kMagic[8] = {'K', 'N', 'W', 'Z', 'L', 'I', 'B', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kChunkRaw = 1;
+
+// Layout: the header, a ChunkEntry per chunk, then the stored bytes of every chunk in order
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t n_chunks;
+    uint64_t raw_size;
+    uint64_t chunk_size;
+};
+
+struct ChunkEntry {
+    uint64_t stored_size;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+// the bytes [offset, offset + size) of a binary, without a copy when they lie in one buffer
+BinaryChunk
+ReadRange(const Binary& binary, const std::vector<int64_t>& chunk_offsets, int64_t offset, int64_t size) {
+    if (!binary.IsChunked()) {
+        return BinaryChunk{std::shared_ptr<uint8_t[]>(binary.data, binary.data.get() + offset), size};
+    }
+    size_t i = std::upper_bound(chunk_offsets.begin(), chunk_offsets.end(), offset) - chunk_offsets.begin() - 1;
+    const int64_t in_chunk = offset - chunk_offsets[i];
+    if (in_chunk + size <= binary.chunks[i].size) {
+        return BinaryChunk{std::shared_ptr<uint8_t[]>(binary.chunks[i].data, binary.chunks[i].data.get() + in_chunk),
+                           size};
+    }
+    std::shared_ptr<uint8_t[]> copy(new uint8_t[size]);
+    int64_t copied = 0;
+    for (int64_t pos = in_chunk; copied < size; i++, pos = 0) {
+        const int64_t n = std::min(size - copied, binary.chunks[i].size - pos);
+        std::memcpy(copy.get() + copied, binary.chunks[i].data.get() + pos, n);
+        copied += n;
+    }
+    return BinaryChunk{std::move(copy), size};
+}
+
+Status
+Compress(const Binary& binary, BinaryPtr& compressed, int level) {
+    const uint64_t raw_size = binary.size;
+    const uint32_t n_chunks = (raw_size + kCompressionChunkSize - 1) / kCompressionChunkSize;
+    std::vector<int64_t> chunk_offsets;
+    int64_t chunk_offset = 0;
+    for (const auto& chunk : binary.chunks) {
+        chunk_offsets.push_back(chunk_offset);
+        chunk_offset += chunk.size;
+    }
+
+    std::vector<BinaryChunk> stored(n_chunks);
+    std::vector<ChunkEntry> entries(n_chunks, ChunkEntry{0, 0, 0});
+    auto pool = NestedBuildThreadPool();
+    std::vector<folly::Future<Status>> futures;
+    futures.reserve(n_chunks);
+    for (uint32_t i = 0; i < n_chunks; i++) {
+        futures.emplace_back(pool.push([&, i]() {
+            const int64_t offset = static_cast<int64_t>(i) * kCompressionChunkSize;
+            const int64_t size = std::min<int64_t>(kCompressionChunkSize, raw_size - offset);
+            auto input = ReadRange(binary, chunk_offsets, offset, size);
+            uLongf bound = compressBound(size);
+            std::shared_ptr<uint8_t[]> output(new uint8_t[bound]);
+            const int rc = compress2(output.get(), &bound, input.data.get(), size, level);
+            if (rc != Z_OK) {
+                LOG_KNOWHERE_ERROR_ << "zlib failed to compress a chunk of a binary: " << rc;
+                return Status::internal_error;
+            }
+            if (static_cast<int64_t>(bound) < size - size / 8) {
+                stored[i] = BinaryChunk{std::move(output), static_cast<int64_t>(bound)};
+            } else {
+                stored[i] = std::move(input);
+                entries[i].flags = kChunkRaw;
+            }
+            entries[i].stored_size = stored[i].size;
+            return Status::success;
+        }));
+    }
+    RETURN_IF_ERROR(WaitAllSuccess(futures));
+
+    if (std::all_of(entries.begin(), entries.end(), [](const ChunkEntry& e) { return e.flags == kChunkRaw; })) {
+        compressed = nullptr;
+        return Status::success;
+    }
+
+    const int64_t meta_size = sizeof(Header) + n_chunks * sizeof(ChunkEntry);
+    std::shared_ptr<uint8_t[]> meta(new uint8_t[meta_size]);
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.n_chunks = n_chunks;
+    header.raw_size = raw_size;
+    header.chunk_size = kCompressionChunkSize;
+    std::memcpy(meta.get(), &header, sizeof(header));
+    std::memcpy(meta.get() + sizeof(header), entries.data(), n_chunks * sizeof(ChunkEntry));
+
+    compressed = std::make_shared<Binary>();
+    compressed->size = meta_size;
+    compressed->chunks.push_back(BinaryChunk{std::move(meta), meta_size});
+    for (auto& chunk : stored) {
+        compressed->size += chunk.size;
+        compressed->chunks.push_back(std::move(chunk));
+    }
+    return Status::success;
+}
+
+Status
+Decompress(const Binary& binary, BinaryPtr& decompressed) {
+    Header header;
+    std::memcpy(&header, binary.data.get(), sizeof(header));
+    const int64_t meta_size = sizeof(Header) + static_cast<int64_t>(header.n_chunks) * sizeof(ChunkEntry);
+    if (header.version != kVersion || header.chunk_size == 0 || binary.size < meta_size ||
+        header.n_chunks != (header.raw_size + header.chunk_size - 1) / header.chunk_size) {
+        LOG_KNOWHERE_ERROR_ << "Invalid compressed binary: version " << header.version << ", " << header.n_chunks
+                            << " chunks";
+        return Status::invalid_binary_set;
+    }
+    std::vector<ChunkEntry> entries(header.n_chunks);
+    std::memcpy(entries.data(), binary.data.get() + sizeof(header), header.n_chunks * sizeof(ChunkEntry));
+    std::vector<int64_t> stored_offsets(header.n_chunks);
+    int64_t stored_offset = meta_size;
+    for (uint32_t i = 0; i < header.n_chunks; i++) {
+        stored_offsets[i] = stored_offset;
+        stored_offset += entries[i].stored_size;
+    }
+    if (stored_offset != binary.size) {
+        LOG_KNOWHERE_ERROR_ << "Truncated compressed binary: " << binary.size << " bytes instead of " << stored_offset;
+        return Status::invalid_binary_set;
+    }
+
+    std::shared_ptr<uint8_t[]> data(new uint8_t[header.raw_size]);
+    auto pool = NestedBuildThreadPool();
+    std::vector<folly::Future<Status>> futures;
+    futures.reserve(header.n_chunks);
+    for (uint32_t i = 0; i < header.n_chunks; i++) {
+        futures.emplace_back(pool.push([&, i]() {
+            const uint64_t offset = i * header.chunk_size;
+            const uint64_t size = std::min(header.chunk_size, header.raw_size - offset);
+            const uint8_t* src = binary.data.get() + stored_offsets[i];
+            if (entries[i].flags & kChunkRaw) {
+                if (entries[i].stored_size != size) {
+                    return Status::invalid_binary_set;
+                }
+                std::memcpy(data.get() + offset, src, size);
+                return Status::success;
+            }
+            uLongf out_size = size;
+            const int rc = uncompress(data.get() + offset, &out_size, src, entries[i].stored_size);
+            if (rc != Z_OK || out_size != size) {
+                LOG_KNOWHERE_ERROR_ << "zlib failed to decompress a chunk of a binary: " << rc;
+                return Status::invalid_binary_set;
+            }
+            return Status::success;
+        }));
+    }
+    RETURN_IF_ERROR(WaitAllSuccess(futures));
+
+    decompressed = std::make_shared<Binary>();
+    decompressed->data = std::move(data);
+    decompressed->size = header.raw_size;
+    return Status::success;
+}
+
+}  // namespace
+
+bool
+IsCompressedBinary(const Binary& binary) {
+    const uint8_t* data = binary.IsChunked() ? binary.chunks[0].data.get() : binary.data.get();
+    const int64_t size = binary.IsChunked() ? binary.chunks[0].size : binary.size;
+    return data != nullptr && size >= static_cast<int64_t>(sizeof(Header)) &&
+           std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+Status
+CompressBinarySet(BinarySet& binset, int level) {
+    for (auto& [name, binary] : binset.binary_map_) {
+        if (binary == nullptr || binary->size == 0 || IsCompressedBinary(*binary)) {
+            continue;
+        }
+        BinaryPtr compressed;
+        RETURN_IF_ERROR(Compress(*binary, compressed, level));
+        if (compressed == nullptr) {
+            continue;
+        }
+        LOG_KNOWHERE_DEBUG_ << "compressed binary " << name << " from " << binary->size << " to " << compressed->size
+                            << " bytes";
+        if (!binset.KeepChunks()) {
+            compressed->Flatten();
+        }
+        binary = std::move(compressed);
+    }
+    return Status::success;
+}
+
+Status
+DecompressBinarySet(BinarySet& binset) {
+    for (auto& [name, binary] : binset.binary_map_) {
+        if (binary == nullptr || !IsCompressedBinary(*binary)) {
+            continue;
+        }
+        binary->Flatten();
+        BinaryPtr decompressed;
+        RETURN_IF_ERROR(Decompress(*binary, decompressed));
+        binary = std::move(decompressed);
+    }
+    return Status::success;
+}
+
+}  // namespace knowhere
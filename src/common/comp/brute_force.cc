@@ -11,6 +11,7 @@
 
 #include "knowhere/comp/brute_force.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "common/metric.h"
@@ -18,8 +19,11 @@
 #include "faiss/utils/binary_distances.h"
 #include "faiss/utils/distances.h"
 #include "faiss/utils/distances_typed.h"
+#include "faiss/utils/Heap.h"
 #include "index/minhash/minhash_util.h"
 #include "knowhere/bitsetview_idselector.h"
+#include "knowhere/comp/search_arena.h"
+#include "knowhere/comp/search_stats.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/config.h"
 #include "knowhere/expected.h"
@@ -65,8 +69,43 @@ GetDocValueComputer(const BruteForceConfig& cfg) {
     }
 }
 
+// calls f(j) for the rows j in [row_beg, row_end) that bitset lets pass, row j having the id j + id_offset in it. The
+// valid ids of a bitset are visited directly, so that a filter that lets a few rows pass costs as much as those rows.
+template <typename F>
+void
+ForEachValidRow(const BitsetView& bitset, int64_t row_beg, int64_t row_end, int64_t id_offset, F&& f) {
+    if (bitset.empty()) {
+        for (int64_t j = row_beg; j < row_end; ++j) {
+            f(j);
+        }
+        return;
+    }
+    bitset.for_each_valid_index(row_beg + id_offset, row_end + id_offset,
+                                [&](size_t id) { f(static_cast<int64_t>(id) - id_offset); });
+}
+
+// the same as query.dot(doc, computer, doc_sum), with the common dims found by the simd kernel. pos is a buffer that
+// is reused across calls.
+float
+SparseDot(const sparse::SparseRow<float>& query, const sparse::SparseRow<float>& doc,
+          const sparse::DocValueComputer<float>& computer, float doc_sum, std::vector<uint32_t>& pos) {
+    const size_t n = std::min(query.size(), doc.size());
+    if (pos.size() < 2 * n) {
+        pos.resize(2 * n);
+    }
+    const size_t n_common =
+        faiss::u32_sparse_intersect(static_cast<const uint32_t*>(query.data()), query.size(),
+                                    static_cast<const uint32_t*>(doc.data()), doc.size(), pos.data(), pos.data() + n);
+    float product_sum = 0.0f;
+    for (size_t i = 0; i < n_common; ++i) {
+        product_sum += query[pos[i]].val * computer(doc[pos[n + i]].val, doc_sum);
+    }
+    return product_sum;
+}
+
+// the L2 norms of the rows of the base, they are cached on the base for the next searches on it
 template <typename DataType>
-std::unique_ptr<float[]>
+std::shared_ptr<const float[]>
 GetVecNorms(const DataSetPtr& base) {
     using NormComputer = float (*)(const DataType*, size_t);
     NormComputer norm_computer;
@@ -76,13 +115,18 @@ GetVecNorms(const DataSetPtr& base) {
         norm_computer = faiss::fp16_vec_norm_L2sqr;
     } else if constexpr (std::is_same_v<DataType, knowhere::bf16>) {
         norm_computer = faiss::bf16_vec_norm_L2sqr;
+    } else if constexpr (std::is_same_v<DataType, knowhere::int8>) {
+        norm_computer = faiss::int8_vec_norm_L2sqr;
     } else {
         return nullptr;
     }
+    if (auto cached = base->GetTensorNorms(); cached != nullptr) {
+        return cached;
+    }
     auto xb = (DataType*)base->GetTensor();
     auto nb = base->GetRows();
     auto dim = base->GetDim();
-    auto norms = std::make_unique<float[]>(nb);
+    std::shared_ptr<float[]> norms(new float[nb]);
 
     // use build thread pool to compute norms
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
@@ -99,8 +143,34 @@ GetVecNorms(const DataSetPtr& base) {
         }));
     }
     WaitAllSuccess(futs);
+    base->SetTensorNorms(norms);
     return norms;
 }
+
+// the most queries that a search task scores together. The kernels read every block of the base once per tile of
+// queries instead of once per query.
+constexpr int64_t kQueryTile = 8;
+
+// the queries per search task, tiles are only used while there are enough of them for every search thread
+template <typename DataType>
+int64_t
+GetQueryTile(const faiss::MetricType metric_type, const int64_t nq, const size_t num_threads) {
+    if constexpr (std::is_same_v<DataType, knowhere::fp32> || KnowhereLowPrecisionTypeCheck<DataType>::value) {
+        if (metric_type == faiss::METRIC_L2 || metric_type == faiss::METRIC_INNER_PRODUCT) {
+            return std::clamp<int64_t>(nq / std::max<int64_t>(num_threads, 1), 1, kQueryTile);
+        }
+    }
+    return 1;
+}
+
+// every query of a brute force search computes the distances to all the valid rows
+SearchStatsVec
+BruteForceSearchStats(int64_t nq, int64_t n_valid) {
+    SearchStats stats;
+    stats.ndis = n_valid;
+    return SearchStatsVec(nq, stats);
+}
+
 }  // namespace
 
 template <typename DataType>
@@ -149,9 +219,9 @@ BruteForce::Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset
     bool is_cosine = IsMetricType(metric_str, metric::COSINE);
 
     int topk = cfg.k.value();
-    auto labels = std::make_unique<int64_t[]>(nq * topk);
-    auto distances = std::make_unique<float[]>(nq * topk);
-    std::unique_ptr<float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
+    auto labels = MakeResultBuffer<int64_t>(nq * topk);
+    auto distances = MakeResultBuffer<float>(nq * topk);
+    std::shared_ptr<const float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
     // some check for minhash metric
     if (faiss_metric_type == faiss::METRIC_MinHash_Jaccard) {
         auto mh_valid_stat =
@@ -162,120 +232,161 @@ BruteForce::Search(const DataSetPtr base_dataset, const DataSetPtr query_dataset
     }
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
     std::vector<folly::Future<Status>> futs;
-    futs.reserve(nq);
-    for (int i = 0; i < nq; ++i) {
-        futs.emplace_back(pool->push([&, index = i, labels_ptr = labels.get(), distances_ptr = distances.get()] {
-            ThreadPool::ScopedSearchOmpSetter setter(1);
-            auto cur_labels = labels_ptr + topk * index;
-            auto cur_distances = distances_ptr + topk * index;
+    const int64_t query_tile = GetQueryTile<DataType>(faiss_metric_type, nq, pool->size());
+    // the idle search threads split the rows of the L2 and IP queries, the top-k of the parts are merged
+    const bool is_split_metric =
+        faiss_metric_type == faiss::METRIC_L2 || faiss_metric_type == faiss::METRIC_INNER_PRODUCT;
+    const int64_t splits = is_split_metric ? pool->QuerySplits(nq, nb) : 1;
+    const int64_t split_rows = (nb + splits - 1) / splits;
+    ScopedSearchArena scoped_arena;
+    int64_t* split_labels = nullptr;
+    float* split_distances = nullptr;
+    if (splits > 1) {
+        split_labels = SearchArena::Local().Allocate<int64_t>(splits * nq * topk);
+        split_distances = SearchArena::Local().Allocate<float>(splits * nq * topk);
+    }
+    futs.reserve(splits * ((nq + query_tile - 1) / query_tile));
+    for (int64_t split = 0; split < splits; split++) {
+        const int64_t row_beg = split * split_rows;
+        const int64_t rows = std::min<int64_t>(split_rows, nb - row_beg);
+        auto labels_ptr = splits > 1 ? split_labels + split * nq * topk : labels.get();
+        auto distances_ptr = splits > 1 ? split_distances + split * nq * topk : distances.get();
+        for (int i = 0; i < nq; i += query_tile) {
+            futs.emplace_back(pool->push([&, index = i, n = std::min<int64_t>(query_tile, nq - i), row_beg, rows,
+                                          labels_ptr, distances_ptr] {
+                ThreadPool::ScopedSearchOmpSetter setter(1);
+                auto cur_labels = labels_ptr + topk * index;
+                auto cur_distances = distances_ptr + topk * index;
 
-            BitsetViewIDSelector bw_idselector(bitset, xb_id_offset);
-            faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
+                BitsetViewIDSelector bw_idselector(bitset, xb_id_offset + row_beg);
+                faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
+                // the rows of the task, all of them unless the queries are split
+                [[maybe_unused]] auto cur_xb = (const DataType*)xb + dim * row_beg;
+                [[maybe_unused]] auto cur_norms = norms != nullptr ? norms.get() + row_beg : nullptr;
 
-            switch (faiss_metric_type) {
-                case faiss::METRIC_L2: {
-                    [[maybe_unused]] auto cur_query = (const DataType*)xq + dim * index;
-                    if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                        faiss::knn_L2sqr(cur_query, (const float*)xb, dim, 1, nb, topk, cur_distances, cur_labels,
-                                         nullptr, id_selector);
-                    } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
-                        faiss::knn_L2sqr_typed(cur_query, (const DataType*)xb, dim, 1, nb, topk, cur_distances,
-                                               cur_labels, nullptr, id_selector);
-                    } else {
-                        LOG_KNOWHERE_ERROR_ << "Metric L2 not supported for current vector type";
-                        return Status::faiss_inner_error;
-                    }
-                    break;
-                }
-                case faiss::METRIC_INNER_PRODUCT: {
-                    [[maybe_unused]] auto cur_query = (const DataType*)xq + dim * index;
-                    if (is_cosine) {
+                switch (faiss_metric_type) {
+                    case faiss::METRIC_L2: {
+                        [[maybe_unused]] auto cur_query = (const DataType*)xq + dim * index;
                         if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                            auto copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                            faiss::knn_cosine(copied_query.get(), (const float*)xb, norms.get(), dim, 1, nb, topk,
-                                              cur_distances, cur_labels, id_selector);
+                            faiss::knn_L2sqr(cur_query, (const float*)cur_xb, dim, n, rows, topk, cur_distances,
+                                             cur_labels, nullptr, id_selector);
                         } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
-                            // normalize query vector may cause precision loss, so div query norms in apply function
-                            faiss::knn_cosine_typed(cur_query, (const DataType*)xb, norms.get(), dim, 1, nb, topk,
-                                                    cur_distances, cur_labels, id_selector);
+                            faiss::knn_L2sqr_typed(cur_query, cur_xb, dim, n, rows, topk, cur_distances, cur_labels,
+                                                   nullptr, id_selector);
                         } else {
-                            LOG_KNOWHERE_ERROR_ << "Metric COSINE not supported for current vector type";
+                            LOG_KNOWHERE_ERROR_ << "Metric L2 not supported for current vector type";
                             return Status::faiss_inner_error;
                         }
-                    } else {
-                        if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                            faiss::knn_inner_product(cur_query, (const float*)xb, dim, 1, nb, topk, cur_distances,
-                                                     cur_labels, id_selector);
-                        } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
-                            faiss::knn_inner_product_typed(cur_query, (const DataType*)xb, dim, 1, nb, topk,
-                                                           cur_distances, cur_labels, id_selector);
+                        break;
+                    }
+                    case faiss::METRIC_INNER_PRODUCT: {
+                        [[maybe_unused]] auto cur_query = (const DataType*)xq + dim * index;
+                        if (is_cosine) {
+                            if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
+                                // the cosine kernels divide by the query norms
+                                faiss::knn_cosine(cur_query, (const float*)cur_xb, cur_norms, dim, n, rows, topk,
+                                                  cur_distances, cur_labels, id_selector);
+                            } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
+                                // normalize query vector may cause precision loss, so div query norms in apply function
+                                faiss::knn_cosine_typed(cur_query, cur_xb, cur_norms, dim, n, rows, topk, cur_distances,
+                                                        cur_labels, id_selector);
+                            } else {
+                                LOG_KNOWHERE_ERROR_ << "Metric COSINE not supported for current vector type";
+                                return Status::faiss_inner_error;
+                            }
                         } else {
-                            LOG_KNOWHERE_ERROR_ << "Metric IP not supported for current vector type";
-                            return Status::faiss_inner_error;
+                            if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
+                                faiss::knn_inner_product(cur_query, (const float*)cur_xb, dim, n, rows, topk,
+                                                         cur_distances, cur_labels, id_selector);
+                            } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
+                                faiss::knn_inner_product_typed(cur_query, cur_xb, dim, n, rows, topk, cur_distances,
+                                                               cur_labels, id_selector);
+                            } else {
+                                LOG_KNOWHERE_ERROR_ << "Metric IP not supported for current vector type";
+                                return Status::faiss_inner_error;
+                            }
                         }
+                        break;
                     }
-                    break;
-                }
-                case faiss::METRIC_Jaccard: {
-                    auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
-                    faiss::float_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, cur_distances};
-                    binary_knn_hc(faiss::METRIC_Jaccard, &res, cur_query, (const uint8_t*)xb, nb, dim / 8, id_selector);
-                    break;
-                }
-                case faiss::METRIC_MinHash_Jaccard: {
-                    size_t mh_lsh_band = cfg.mh_lsh_band.value();
-                    bool mh_search_with_jaccard = cfg.mh_search_with_jaccard.value();
-                    if (mh_search_with_jaccard) {
-                        size_t hash_element_size = cfg.mh_element_bit_width.value() / 8;  // in bytes
-                        size_t hash_element_length = dim / (hash_element_size * 8);
-                        auto cur_query = (const char*)xq + (dim / 8) * index;
-                        minhash_jaccard_knn_ny(cur_query, (const char*)xb, hash_element_length, hash_element_size, nb,
-                                               topk, bitset, cur_distances, cur_labels);
-                    } else {
-                        size_t u8_dim = dim / 8;
-                        auto cur_query = (const char*)xq + u8_dim * index;
-                        minhash_lsh_hit_ny(cur_query, (const char*)xb, u8_dim, mh_lsh_band, nb, topk, bitset,
-                                           cur_distances, cur_labels);
+                    case faiss::METRIC_Jaccard: {
+                        auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
+                        faiss::float_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, cur_distances};
+                        binary_knn_hc(faiss::METRIC_Jaccard, &res, cur_query, (const uint8_t*)xb, nb, dim / 8,
+                                      id_selector);
+                        break;
                     }
-                    break;
-                }
-                case faiss::METRIC_Hamming: {
-                    auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
-                    std::vector<int32_t> int_distances(topk);
-                    faiss::int_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, int_distances.data()};
-                    binary_knn_hc(faiss::METRIC_Hamming, &res, (const uint8_t*)cur_query, (const uint8_t*)xb, nb,
-                                  dim / 8, id_selector);
-                    for (int i = 0; i < topk; ++i) {
-                        cur_distances[i] = int_distances[i];
+                    case faiss::METRIC_MinHash_Jaccard: {
+                        size_t mh_lsh_band = cfg.mh_lsh_band.value();
+                        bool mh_search_with_jaccard = cfg.mh_search_with_jaccard.value();
+                        if (mh_search_with_jaccard) {
+                            size_t hash_element_size = cfg.mh_element_bit_width.value() / 8;  // in bytes
+                            size_t hash_element_length = dim / (hash_element_size * 8);
+                            auto cur_query = (const char*)xq + (dim / 8) * index;
+                            minhash_jaccard_knn_ny(cur_query, (const char*)xb, hash_element_length, hash_element_size,
+                                                   nb, topk, bitset, cur_distances, cur_labels);
+                        } else {
+                            size_t u8_dim = dim / 8;
+                            auto cur_query = (const char*)xq + u8_dim * index;
+                            minhash_lsh_hit_ny(cur_query, (const char*)xb, u8_dim, mh_lsh_band, nb, topk, bitset,
+                                               cur_distances, cur_labels);
+                        }
+                        break;
+                    }
+                    case faiss::METRIC_Hamming: {
+                        auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
+                        auto int_distances = SearchArena::Local().Allocate<int32_t>(topk);
+                        faiss::int_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, int_distances};
+                        binary_knn_hc(faiss::METRIC_Hamming, &res, (const uint8_t*)cur_query, (const uint8_t*)xb, nb,
+                                      dim / 8, id_selector);
+                        for (int i = 0; i < topk; ++i) {
+                            cur_distances[i] = int_distances[i];
+                        }
+                        break;
+                    }
+                    case faiss::METRIC_Substructure:
+                    case faiss::METRIC_Superstructure: {
+                        // only matched ids will be chosen, not to use heap
+                        auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
+                        binary_knn_mc(faiss_metric_type, cur_query, (const uint8_t*)xb, 1, nb, topk, dim / 8,
+                                      cur_distances, cur_labels, id_selector);
+                        break;
+                    }
+                    default: {
+                        LOG_KNOWHERE_ERROR_ << "Invalid metric type: " << cfg.metric_type.value();
+                        return Status::invalid_metric_type;
                     }
-                    break;
-                }
-                case faiss::METRIC_Substructure:
-                case faiss::METRIC_Superstructure: {
-                    // only matched ids will be chosen, not to use heap
-                    auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
-                    binary_knn_mc(faiss_metric_type, cur_query, (const uint8_t*)xb, 1, nb, topk, dim / 8, cur_distances,
-                                  cur_labels, id_selector);
-                    break;
                 }
-                default: {
-                    LOG_KNOWHERE_ERROR_ << "Invalid metric type: " << cfg.metric_type.value();
-                    return Status::invalid_metric_type;
+                if (row_beg != 0) {
+                    for (int64_t j = 0; j < n * topk; j++) {
+                        cur_labels[j] = cur_labels[j] == -1 ? -1 : cur_labels[j] + row_beg;
+                    }
                 }
-            }
-            return Status::success;
-        }));
+                return Status::success;
+            }));
+        }
     }
     auto ret = WaitAllSuccess(futs);
     if (ret != Status::success) {
         return expected<DataSetPtr>::Err(ret, "failed to brute force search");
     }
+    if (splits > 1) {
+        if (faiss_metric_type == faiss::METRIC_L2) {
+            faiss::merge_knn_results<int64_t, faiss::CMin<float, int>>(nq, topk, splits, split_distances,
+                                                                       split_labels, distances.get(), labels.get());
+        } else {
+            faiss::merge_knn_results<int64_t, faiss::CMax<float, int>>(nq, topk, splits, split_distances,
+                                                                       split_labels, distances.get(), labels.get());
+        }
+    }
     if (xb_id_offset != 0) {
         for (auto i = 0; i < nq * topk; i++) {
             labels[i] = labels[i] == -1 ? -1 : labels[i] + xb_id_offset;
         }
     }
     auto res = GenResultDataSet(nq, cfg.k.value(), std::move(labels), std::move(distances));
+    if (cfg.search_stats.value()) {
+        res->Set(meta::SEARCH_STATS, BruteForceSearchStats(nq, nb - bitset.count()));
+    }
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     // LCOV_EXCL_START
@@ -341,12 +452,13 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
         }
     }
 
-    std::unique_ptr<float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
+    std::shared_ptr<const float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
     std::vector<folly::Future<Status>> futs;
-    futs.reserve(nq);
-    for (int i = 0; i < nq; ++i) {
-        futs.emplace_back(pool->push([&, index = i] {
+    const int64_t query_tile = GetQueryTile<DataType>(faiss_metric_type, nq, pool->size());
+    futs.reserve((nq + query_tile - 1) / query_tile);
+    for (int i = 0; i < nq; i += query_tile) {
+        futs.emplace_back(pool->push([&, index = i, n = std::min<int64_t>(query_tile, nq - i)] {
             ThreadPool::ScopedSearchOmpSetter setter(1);
             auto cur_labels = labels + topk * index;
             auto cur_distances = distances + topk * index;
@@ -357,10 +469,10 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
                 case faiss::METRIC_L2: {
                     [[maybe_unused]] auto cur_query = (const DataType*)xq + dim * index;
                     if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                        faiss::knn_L2sqr(cur_query, (const float*)xb, dim, 1, nb, topk, cur_distances, cur_labels,
+                        faiss::knn_L2sqr(cur_query, (const float*)xb, dim, n, nb, topk, cur_distances, cur_labels,
                                          nullptr, id_selector);
                     } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
-                        faiss::knn_L2sqr_typed(cur_query, (const DataType*)xb, dim, 1, nb, topk, cur_distances,
+                        faiss::knn_L2sqr_typed(cur_query, (const DataType*)xb, dim, n, nb, topk, cur_distances,
                                                cur_labels, nullptr, id_selector);
                     } else {
                         LOG_KNOWHERE_ERROR_ << "Metric L2 not supported for current vector type";
@@ -372,12 +484,12 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
                     [[maybe_unused]] auto cur_query = (const DataType*)xq + dim * index;
                     if (is_cosine) {
                         if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                            auto copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                            faiss::knn_cosine(copied_query.get(), (const float*)xb, norms.get(), dim, 1, nb, topk,
-                                              cur_distances, cur_labels, id_selector);
+                            // the cosine kernels divide by the query norms
+                            faiss::knn_cosine(cur_query, (const float*)xb, norms.get(), dim, n, nb, topk, cur_distances,
+                                              cur_labels, id_selector);
                         } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
                             // normalize query vector may cause precision loss, so div query norms in apply function
-                            faiss::knn_cosine_typed(cur_query, (const DataType*)xb, norms.get(), dim, 1, nb, topk,
+                            faiss::knn_cosine_typed(cur_query, (const DataType*)xb, norms.get(), dim, n, nb, topk,
                                                     cur_distances, cur_labels, id_selector);
                         } else {
                             LOG_KNOWHERE_ERROR_ << "Metric COSINE not supported for current vector type";
@@ -385,10 +497,10 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
                         }
                     } else {
                         if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                            faiss::knn_inner_product(cur_query, (const float*)xb, dim, 1, nb, topk, cur_distances,
+                            faiss::knn_inner_product(cur_query, (const float*)xb, dim, n, nb, topk, cur_distances,
                                                      cur_labels, id_selector);
                         } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
-                            faiss::knn_inner_product_typed(cur_query, (const DataType*)xb, dim, 1, nb, topk,
+                            faiss::knn_inner_product_typed(cur_query, (const DataType*)xb, dim, n, nb, topk,
                                                            cur_distances, cur_labels, id_selector);
                         } else {
                             LOG_KNOWHERE_ERROR_ << "Metric IP not supported for current vector type";
@@ -422,8 +534,8 @@ BruteForce::SearchWithBuf(const DataSetPtr base_dataset, const DataSetPtr query_
                 }
                 case faiss::METRIC_Hamming: {
                     auto cur_query = (const uint8_t*)xq + (dim / 8) * index;
-                    std::vector<int32_t> int_distances(topk);
-                    faiss::int_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, int_distances.data()};
+                    auto int_distances = SearchArena::Local().Allocate<int32_t>(topk);
+                    faiss::int_maxheap_array_t res = {size_t(1), size_t(topk), cur_labels, int_distances};
                     binary_knn_hc(faiss::METRIC_Hamming, &res, (const uint8_t*)cur_query, (const uint8_t*)xb, nb,
                                   dim / 8, id_selector);
                     for (int i = 0; i < topk; ++i) {
@@ -542,7 +654,7 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
     std::vector<std::vector<int64_t>> result_id_array(nq);
     std::vector<std::vector<float>> result_dist_array(nq);
 
-    std::unique_ptr<float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
+    std::shared_ptr<const float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
     std::vector<folly::Future<Status>> futs;
     futs.reserve(nq);
     for (int i = 0; i < nq; ++i) {
@@ -550,10 +662,8 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
             if constexpr (std::is_same_v<DataType, knowhere::sparse::SparseRow<float>>) {
                 auto cur_query = (const sparse::SparseRow<float>*)xq + index;
                 auto xb_sparse = (const sparse::SparseRow<float>*)xb;
-                for (int j = 0; j < nb; ++j) {
-                    if (!bitset.empty() && bitset.test(j)) {
-                        continue;
-                    }
+                std::vector<uint32_t> pos;
+                ForEachValidRow(bitset, 0, nb, 0, [&](int64_t j) {
                     float row_sum = 0;
                     if (is_bm25) {
                         for (size_t k = 0; k < xb_sparse[j].size(); ++k) {
@@ -561,12 +671,12 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
                             row_sum += v;
                         }
                     }
-                    auto dist = cur_query->dot(xb_sparse[j], sparse_computer, row_sum);
+                    auto dist = SparseDot(*cur_query, xb_sparse[j], sparse_computer, row_sum, pos);
                     if (dist > radius && dist <= range_filter) {
                         result_id_array[index].push_back(j);
                         result_dist_array[index].push_back(dist);
                     }
-                }
+                });
                 return Status::success;
             } else {
                 // else not sparse:
@@ -595,9 +705,9 @@ BruteForce::RangeSearch(const DataSetPtr base_dataset, const DataSetPtr query_da
                         is_ip = true;
                         if (is_cosine) {
                             if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                                auto copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                                faiss::range_search_cosine(copied_query.get(), (const float*)xb, norms.get(), dim, 1,
-                                                           nb, radius, &res, id_selector);
+                                // the cosine kernels divide by the query norms
+                                faiss::range_search_cosine(cur_query, (const float*)xb, norms.get(), dim, 1, nb, radius,
+                                                           &res, id_selector);
                             } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
                                 // normalize query vector may cause precision loss, so div query norms in apply function
                                 faiss::range_search_cosine_typed(cur_query, (const DataType*)xb, norms.get(), dim, 1,
@@ -725,44 +835,70 @@ BruteForce::SearchSparseWithBuf(const DataSetPtr base_dataset, const DataSetPtr
     std::fill(labels, labels + nq * topk, -1);
 
     auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    // the idle search threads split the rows of the queries, the top-k of the parts are merged
+    const int64_t splits = pool->QuerySplits(nq, rows);
+    const int64_t split_rows = (rows + splits - 1) / splits;
+    std::unique_ptr<sparse::label_t[]> split_labels = nullptr;
+    std::unique_ptr<float[]> split_distances = nullptr;
+    if (splits > 1) {
+        split_labels = std::make_unique<sparse::label_t[]>(splits * nq * topk);
+        split_distances = std::make_unique<float[]>(splits * nq * topk);
+        std::fill(split_distances.get(), split_distances.get() + splits * nq * topk,
+                  std::numeric_limits<float>::quiet_NaN());
+        std::fill(split_labels.get(), split_labels.get() + splits * nq * topk, -1);
+    }
     std::vector<folly::Future<folly::Unit>> futs;
-    futs.reserve(nq);
-    for (int64_t i = 0; i < nq; ++i) {
-        futs.emplace_back(pool->push([&, index = i] {
-            auto cur_labels = labels + topk * index;
-            auto cur_distances = distances + topk * index;
+    futs.reserve(splits * nq);
+    for (int64_t split = 0; split < splits; split++) {
+        const int64_t row_beg = split * split_rows;
+        const int64_t row_end = std::min(rows, row_beg + split_rows);
+        auto labels_ptr = splits > 1 ? split_labels.get() + split * nq * topk : labels;
+        auto distances_ptr = splits > 1 ? split_distances.get() + split * nq * topk : distances;
+        for (int64_t i = 0; i < nq; ++i) {
+            futs.emplace_back(pool->push([&, index = i, row_beg, row_end, labels_ptr, distances_ptr] {
+                auto cur_labels = labels_ptr + topk * index;
+                auto cur_distances = distances_ptr + topk * index;
 
-            const auto& row = xq[index];
-            if (row.size() == 0) {
-                return;
-            }
-            sparse::MaxMinHeap<float> heap(topk);
-            for (int64_t j = 0; j < rows; ++j) {
-                auto x_id = j + xb_id_offset;
-                if (!bitset.empty() && bitset.test(x_id)) {
-                    continue;
+                const auto& row = xq[index];
+                if (row.size() == 0) {
+                    return;
                 }
-                float row_sum = 0;
-                if (is_bm25) {
-                    for (size_t k = 0; k < base[j].size(); ++k) {
-                        auto [d, v] = base[j][k];
-                        row_sum += v;
+                sparse::MaxMinHeap<float> heap(topk);
+                std::vector<uint32_t> pos;
+                ForEachValidRow(bitset, row_beg, row_end, xb_id_offset, [&](int64_t j) {
+                    auto x_id = j + xb_id_offset;
+                    float row_sum = 0;
+                    if (is_bm25) {
+                        for (size_t k = 0; k < base[j].size(); ++k) {
+                            auto [d, v] = base[j][k];
+                            row_sum += v;
+                        }
                     }
+                    float dist = SparseDot(row, base[j], computer, row_sum, pos);
+                    if (dist > 0) {
+                        heap.push(x_id, dist);
+                    }
+                });
+                int result_size = heap.size();
+                for (int j = result_size - 1; j >= 0; --j) {
+                    cur_labels[j] = heap.top().id;
+                    cur_distances[j] = heap.top().val;
+                    heap.pop();
                 }
-                float dist = row.dot(base[j], computer, row_sum);
-                if (dist > 0) {
-                    heap.push(x_id, dist);
-                }
-            }
-            int result_size = heap.size();
-            for (int j = result_size - 1; j >= 0; --j) {
-                cur_labels[j] = heap.top().id;
-                cur_distances[j] = heap.top().val;
-                heap.pop();
-            }
-        }));
+            }));
+        }
     }
     WaitAllSuccess(futs);
+    if (splits > 1) {
+        faiss::merge_knn_results<sparse::label_t, faiss::CMax<float, int>>(
+            nq, topk, splits, split_distances.get(), split_labels.get(), distances, labels);
+        // the merge fills the missing results with the lowest distance instead of NaN
+        for (int64_t i = 0; i < nq * topk; i++) {
+            if (labels[i] == -1) {
+                distances[i] = std::numeric_limits<float>::quiet_NaN();
+            }
+        }
+    }
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     // LCOV_EXCL_START
@@ -791,7 +927,11 @@ BruteForce::SearchSparse(const DataSetPtr base_dataset, const DataSetPtr query_d
     auto distances = std::make_unique<float[]>(nq * topk);
 
     SearchSparseWithBuf(base_dataset, query_dataset, labels.get(), distances.get(), config, bitset);
-    return GenResultDataSet(nq, topk, std::move(labels), std::move(distances));
+    auto res = GenResultDataSet(nq, topk, std::move(labels), std::move(distances));
+    if (cfg.search_stats.value()) {
+        res->Set(meta::SEARCH_STATS, BruteForceSearchStats(nq, base_dataset->GetRows() - bitset.count()));
+    }
+    return res;
 }
 
 template <typename DataType>
@@ -839,7 +979,7 @@ BruteForce::AnnIterator(const DataSetPtr base_dataset, const DataSetPtr query_da
     bool is_cosine = IsMetricType(metric_str, metric::COSINE);
     auto larger_is_closer = faiss::is_similarity_metric(faiss_metric_type) || is_cosine;
     auto vec = std::vector<IndexNode::IteratorPtr>(nq, nullptr);
-    std::shared_ptr<float[]> norms = GetVecNorms<DataType>(base_dataset);
+    std::shared_ptr<const float[]> norms = is_cosine ? GetVecNorms<DataType>(base_dataset) : nullptr;
 
     try {
         for (int i = 0; i < nq; ++i) {
@@ -872,9 +1012,9 @@ BruteForce::AnnIterator(const DataSetPtr base_dataset, const DataSetPtr query_da
                     case faiss::METRIC_INNER_PRODUCT: {
                         if (is_cosine) {
                             if constexpr (std::is_same_v<DataType, knowhere::fp32>) {
-                                auto copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                                faiss::all_cosine(copied_query.get(), (const float*)xb, norms.get(), dim, 1, nb,
-                                                  distances_ids, id_selector);
+                                // the cosine kernels divide by the query norms
+                                faiss::all_cosine(cur_query, (const float*)xb, norms.get(), dim, 1, nb, distances_ids,
+                                                  id_selector);
                             } else if constexpr (KnowhereLowPrecisionTypeCheck<DataType>::value) {
                                 // normalize query vector may cause precision loss, so div query norms in apply function
                                 faiss::all_cosine_typed(cur_query, (const DataType*)xb, norms.get(), dim, 1, nb,
@@ -985,11 +1125,9 @@ BruteForce::AnnIterator<knowhere::sparse::SparseRow<float>>(const DataSetPtr bas
                 const auto& row = xq[i];
                 std::vector<DistId> distances_ids;
                 if (row.size() > 0) {
-                    for (int64_t j = 0; j < rows; ++j) {
+                    std::vector<uint32_t> pos;
+                    ForEachValidRow(bitset, 0, rows, xb_id_offset, [&](int64_t j) {
                         auto xb_id = j + xb_id_offset;
-                        if (!bitset.empty() && bitset.test(xb_id)) {
-                            continue;
-                        }
                         float row_sum = 0;
                         if (is_bm25) {
                             for (size_t k = 0; k < base[j].size(); ++k) {
@@ -997,11 +1135,11 @@ BruteForce::AnnIterator<knowhere::sparse::SparseRow<float>>(const DataSetPtr bas
                                 row_sum += v;
                             }
                         }
-                        auto dist = row.dot(base[j], computer, row_sum);
+                        auto dist = SparseDot(row, base[j], computer, row_sum, pos);
                         if (dist > 0) {
                             distances_ids.emplace_back(xb_id, dist);
                         }
-                    }
+                    });
                 }
                 return distances_ids;
             };
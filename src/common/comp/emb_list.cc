@@ -0,0 +1,198 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/emb_list.h"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/log.h"
+#include "knowhere/utils.h"
+#include "simd/hook.h"
+
+namespace knowhere {
+
+bool
+IsValidEmbListOffsets(const EmbListOffsets& offsets, int64_t rows) {
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != static_cast<size_t>(rows)) {
+        return false;
+    }
+    return std::is_sorted(offsets.begin(), offsets.end());
+}
+
+namespace {
+
+// the MaxSim scores of the candidate lists of one query list, whose n_query embeddings are query
+class MaxSimScorer {
+ public:
+    MaxSimScorer(const float* query, size_t n_query, size_t dim) : query_(query), n_query_(n_query), dim_(dim) {
+    }
+
+    // the score of a list of n embeddings
+    float
+    Score(const float* embs, size_t n) {
+        sims_.resize(n);
+        float score = 0.0f;
+        for (size_t i = 0; i < n_query_; i++) {
+            faiss::fvec_inner_products_ny(sims_.data(), query_ + i * dim_, embs, dim_, n);
+            score += *std::max_element(sims_.begin(), sims_.end());
+        }
+        return score;
+    }
+
+ private:
+    const float* query_;
+    size_t n_query_;
+    size_t dim_;
+    std::vector<float> sims_;
+};
+
+}  // namespace
+
+expected<DataSetPtr>
+SearchEmbList(const IndexNode& node, const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) {
+    auto& base_cfg = static_cast<BaseConfig&>(*cfg);
+    const auto& doc_offsets = node.EmbListOffsets();
+    if (doc_offsets == nullptr) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "the rows of the index are not embedding lists");
+    }
+    const auto query_offsets = dataset->Get<std::shared_ptr<const EmbListOffsets>>(meta::EMB_LIST_OFFSET);
+    if (query_offsets == nullptr || !IsValidEmbListOffsets(*query_offsets, dataset->GetRows())) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "invalid embedding list offsets of the queries");
+    }
+    const auto metric = base_cfg.metric_type.value();
+    const bool is_cosine = IsMetricType(metric, metric::COSINE);
+    if (!is_cosine && !IsMetricType(metric, metric::IP)) {
+        return expected<DataSetPtr>::Err(Status::invalid_metric_type,
+                                         "embedding lists are searched with IP or COSINE, not " + metric);
+    }
+    if (!node.HasRawData(metric)) {
+        return expected<DataSetPtr>::Err(Status::not_implemented,
+                                         "embedding lists are rescored with the raw vectors the index does not have");
+    }
+
+    const int64_t nq = query_offsets->size() - 1;
+    const int64_t k = base_cfg.k.value();
+    const int64_t dim = dataset->GetDim();
+    const int64_t n_docs = doc_offsets->size() - 1;
+    const int64_t rows_k = std::min<int64_t>(
+        node.Count(), std::max<int64_t>(k, std::ceil(k * base_cfg.emb_list_candidates_ratio.value())));
+
+    // the rows of the lists bitset filters out
+    std::vector<uint8_t> row_bits;
+    BitsetView row_bitset;
+    if (!bitset.empty()) {
+        row_bits.assign((node.Count() + 7) / 8, 0);
+        size_t filtered_out = 0;
+        for (int64_t doc = 0; doc < std::min<int64_t>(n_docs, bitset.size()); doc++) {
+            if (!bitset.test(doc)) {
+                continue;
+            }
+            for (size_t row = (*doc_offsets)[doc]; row < (*doc_offsets)[doc + 1]; row++) {
+                row_bits[row >> 3] |= (0x1 << (row & 0x7));
+            }
+            filtered_out += (*doc_offsets)[doc + 1] - (*doc_offsets)[doc];
+        }
+        row_bitset = BitsetView(row_bits.data(), node.Count(), filtered_out);
+    }
+
+    base_cfg.k = rows_k;
+    auto rows_res = node.Search(dataset, std::move(cfg), row_bitset);
+    if (!rows_res.has_value()) {
+        return rows_res;
+    }
+    const int64_t* row_ids = rows_res.value()->GetIds();
+
+    const float* queries = static_cast<const float*>(dataset->GetTensor());
+    std::unique_ptr<float[]> normalized_queries;
+    if (is_cosine) {
+        normalized_queries = CopyAndNormalizeVecs(queries, dataset->GetRows(), dim);
+        queries = normalized_queries.get();
+    }
+
+    auto ids = std::make_unique<int64_t[]>(nq * k);
+    auto distances = std::make_unique<float[]>(nq * k);
+    std::fill(ids.get(), ids.get() + nq * k, -1);
+    std::fill(distances.get(), distances.get() + nq * k, -std::numeric_limits<float>::infinity());
+
+    std::atomic<bool> fetch_failed{false};
+    auto search_list = [&](int64_t q) {
+        const size_t q_begin = (*query_offsets)[q], q_end = (*query_offsets)[q + 1];
+        std::vector<int64_t> docs;
+        for (size_t i = q_begin * rows_k; i < q_end * rows_k; i++) {
+            if (row_ids[i] >= 0) {
+                docs.push_back(EmbListOfRow(*doc_offsets, row_ids[i]));
+            }
+        }
+        std::sort(docs.begin(), docs.end());
+        docs.erase(std::unique(docs.begin(), docs.end()), docs.end());
+        if (docs.empty() || q_begin == q_end) {
+            return;
+        }
+
+        // the embeddings of all the candidates are fetched at once
+        std::vector<int64_t> doc_rows;
+        for (int64_t doc : docs) {
+            for (size_t row = (*doc_offsets)[doc]; row < (*doc_offsets)[doc + 1]; row++) {
+                doc_rows.push_back(row);
+            }
+        }
+        auto vectors = node.GetVectorByIds(GenIdsDataSet(doc_rows.size(), doc_rows.data()));
+        if (!vectors.has_value()) {
+            fetch_failed = true;
+            return;
+        }
+        const float* embs = static_cast<const float*>(vectors.value()->GetTensor());
+        std::unique_ptr<float[]> normalized_embs;
+        if (is_cosine) {
+            normalized_embs = CopyAndNormalizeVecs(embs, doc_rows.size(), dim);
+            embs = normalized_embs.get();
+        }
+
+        MaxSimScorer scorer(queries + q_begin * dim, q_end - q_begin, dim);
+        std::vector<std::pair<float, int64_t>> scores(docs.size());
+        size_t offset = 0;
+        for (size_t i = 0; i < docs.size(); i++) {
+            const size_t n = (*doc_offsets)[docs[i] + 1] - (*doc_offsets)[docs[i]];
+            scores[i] = {scorer.Score(embs + offset * dim, n), docs[i]};
+            offset += n;
+        }
+        const size_t n_res = std::min<size_t>(k, scores.size());
+        std::partial_sort(scores.begin(), scores.begin() + n_res, scores.end(),
+                          [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = 0; i < n_res; i++) {
+            distances[q * k + i] = scores[i].first;
+            ids[q * k + i] = scores[i].second;
+        }
+    };
+
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    std::vector<folly::Future<folly::Unit>> futures;
+    futures.reserve(nq);
+    for (int64_t q = 0; q < nq; q++) {
+        futures.emplace_back(pool->push([&, q]() {
+            ThreadPool::ScopedSearchOmpSetter setter(1);
+            search_list(q);
+        }));
+    }
+    WaitAllSuccess(futures);
+    if (fetch_failed.load()) {
+        return expected<DataSetPtr>::Err(Status::invalid_index_error, "failed to fetch the embeddings of a list");
+    }
+
+    return GenResultDataSet(nq, k, std::move(ids), std::move(distances));
+}
+
+}  // namespace knowhere
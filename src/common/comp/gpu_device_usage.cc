@@ -0,0 +1,73 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/gpu_device_usage.h"
+
+#include <map>
+#include <mutex>
+
+#include "knowhere/log.h"
+#ifdef KNOWHERE_WITH_CUVS
+#include "cuda_runtime_api.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+
+std::mutex usage_mutex;
+std::map<int64_t, GpuDeviceUsage> usage_by_device;
+
+}  // namespace
+
+void
+AddGpuDeviceUsage(int64_t device_id, int64_t indexes, int64_t rows) {
+    std::lock_guard lock(usage_mutex);
+    auto& usage = usage_by_device[device_id];
+    usage.device_id = device_id;
+    usage.indexes += indexes;
+    usage.rows += rows;
+}
+
+std::vector<GpuDeviceUsage>
+GetGpuDeviceUsage() {
+    std::map<int64_t, GpuDeviceUsage> usages;
+    {
+        std::lock_guard lock(usage_mutex);
+        usages = usage_by_device;
+    }
+#ifdef KNOWHERE_WITH_CUVS
+    int count = 0;
+    if (cudaGetDeviceCount(&count) == cudaSuccess) {
+        int current = 0;
+        cudaGetDevice(&current);
+        for (int i = 0; i < count; i++) {
+            size_t free = 0, total = 0;
+            if (cudaSetDevice(i) != cudaSuccess || cudaMemGetInfo(&free, &total) != cudaSuccess) {
+                LOG_KNOWHERE_WARNING_ << "failed to get the memory info of GPU " << i;
+                continue;
+            }
+            auto& usage = usages[i];
+            usage.device_id = i;
+            usage.free_bytes = free;
+            usage.total_bytes = total;
+        }
+        cudaSetDevice(current);
+    }
+#endif
+    std::vector<GpuDeviceUsage> result;
+    for (const auto& [device_id, usage] : usages) {
+        result.push_back(usage);
+    }
+    return result;
+}
+
+}  // namespace knowhere
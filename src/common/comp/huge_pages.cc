@@ -0,0 +1,121 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+
+#include "knowhere/comp/huge_pages.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "knowhere/log.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace knowhere {
+
+namespace {
+
+uint8_t*
+MapHugeTlb(size_t size, int page_flag) {
+#ifdef MAP_HUGETLB
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag;
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (map != MAP_FAILED) {
+        return static_cast<uint8_t*>(map);
+    }
+#endif
+    return nullptr;
+}
+
+// a mapping of size bytes at a huge page boundary, so that the kernel can back all of it with huge pages
+uint8_t*
+MapAligned(size_t size) {
+    void* map = mmap(nullptr, size + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return nullptr;
+    }
+    auto begin = reinterpret_cast<uintptr_t>(map);
+    auto aligned = (begin + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    if (aligned > begin) {
+        munmap(map, aligned - begin);
+    }
+    const size_t tail = begin + kHugePageSize - aligned;
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    return reinterpret_cast<uint8_t*>(aligned);
+}
+
+}  // namespace
+
+std::unique_ptr<HugePageBuffer>
+HugePageBuffer::Allocate(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    if (size >= kGiantPageSize) {
+        const size_t capacity = (size + kGiantPageSize - 1) / kGiantPageSize * kGiantPageSize;
+        if (auto data = MapHugeTlb(capacity, MAP_HUGE_1GB)) {
+            return std::unique_ptr<HugePageBuffer>(new HugePageBuffer(data, capacity, true));
+        }
+    }
+    const size_t capacity = HugePageRound(size);
+    if (auto data = MapHugeTlb(capacity, MAP_HUGE_2MB)) {
+        return std::unique_ptr<HugePageBuffer>(new HugePageBuffer(data, capacity, true));
+    }
+    auto data = MapAligned(capacity);
+    if (data == nullptr) {
+        LOG_KNOWHERE_WARNING_ << "Failed to map " << capacity << " bytes: " << strerror(errno);
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (madvise(data, capacity, MADV_HUGEPAGE) != 0) {
+        LOG_KNOWHERE_DEBUG_ << "Transparent huge pages are not available: " << strerror(errno);
+    }
+#endif
+    return std::unique_ptr<HugePageBuffer>(new HugePageBuffer(data, capacity, false));
+}
+
+HugePageBuffer::~HugePageBuffer() {
+    munmap(data_, capacity_);
+}
+
+void
+AdviseHugePages(const std::vector<MappedRegion>& regions) {
+#ifdef MADV_HUGEPAGE
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    for (const auto& region : regions) {
+        if (region.size < kHugePageSize) {
+            continue;
+        }
+        const auto begin = reinterpret_cast<uintptr_t>(region.data) / page * page;
+        const auto end = reinterpret_cast<uintptr_t>(region.data) + region.size;
+        if (madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) != 0) {
+            // file backed huge pages depend on the file system and the kernel
+            LOG_KNOWHERE_DEBUG_ << "Huge pages are not available for a mapped region: " << strerror(errno);
+            return;
+        }
+    }
+#endif
+}
+
+}  // namespace knowhere
@@ -0,0 +1,269 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/index_container.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "io/file_io.h"
+#include "knowhere/log.h"
+#include "xxhash.h"
+
+namespace knowhere {
+
+namespace {
+
+constexpr char kContainerMagic[8] = {'K', 'N', 'W', 'H', 'C', 'N', 'T', 'R'};
+constexpr uint32_t kContainerVersion = 1;
+
+uint64_t
+AlignToPage(uint64_t offset) {
+    return (offset + kContainerPageSize - 1) / kContainerPageSize * kContainerPageSize;
+}
+
+uint64_t
+BinaryChecksum(const Binary& binary) {
+    if (!binary.IsChunked()) {
+        return XXH3_64bits(binary.data.get(), binary.size);
+    }
+    XXH3_state_t* state = XXH3_createState();
+    XXH3_64bits_reset(state);
+    for (const auto& chunk : binary.chunks) {
+        XXH3_64bits_update(state, chunk.data.get(), chunk.size);
+    }
+    const uint64_t checksum = XXH3_64bits_digest(state);
+    XXH3_freeState(state);
+    return checksum;
+}
+
+uint64_t
+MetaChecksum(ContainerHeader header, const std::vector<ContainerSection>& sections) {
+    header.checksum = 0;
+    XXH3_state_t* state = XXH3_createState();
+    XXH3_64bits_reset(state);
+    XXH3_64bits_update(state, &header, sizeof(header));
+    XXH3_64bits_update(state, sections.data(), sections.size() * sizeof(ContainerSection));
+    const uint64_t checksum = XXH3_64bits_digest(state);
+    XXH3_freeState(state);
+    return checksum;
+}
+
+bool
+ReadAt(int fd, void* dst, size_t size, uint64_t offset) {
+    auto out = static_cast<char*>(dst);
+    while (size > 0) {
+        const ssize_t n = pread(fd, out, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+}  // namespace
+
+Status
+WriteIndexContainer(const BinarySet& binset, const std::string& filename) {
+    std::vector<ContainerSection> sections;
+    std::vector<BinaryPtr> binaries;
+    for (const auto& [name, binary] : binset.binary_map_) {
+        if (binary == nullptr) {
+            continue;
+        }
+        if (name.size() > ContainerSection::kMaxNameLength) {
+            LOG_KNOWHERE_ERROR_ << "The name of binary " << name << " is too long for an index container";
+            return Status::invalid_args;
+        }
+        ContainerSection section{};
+        std::memcpy(section.name, name.data(), name.size());
+        section.size = binary->size;
+        section.checksum = BinaryChecksum(*binary);
+        sections.push_back(section);
+        binaries.push_back(binary);
+    }
+
+    ContainerHeader header{};
+    std::memcpy(header.magic, kContainerMagic, sizeof(kContainerMagic));
+    header.version = kContainerVersion;
+    header.page_size = kContainerPageSize;
+    header.n_sections = sections.size();
+    uint64_t offset = AlignToPage(sizeof(ContainerHeader) + sections.size() * sizeof(ContainerSection));
+    for (auto& section : sections) {
+        section.offset = offset;
+        offset = AlignToPage(offset + section.size);
+    }
+    header.checksum = MetaChecksum(header, sections);
+
+    try {
+        FileWriter writer(filename);
+        const std::vector<char> zeros(kContainerPageSize, 0);
+        auto pad = [&writer, &zeros](uint64_t to) { writer(zeros.data(), 1, to - writer.tellg()); };
+        writer(&header, sizeof(header), 1);
+        writer(sections.data(), sizeof(ContainerSection), sections.size());
+        for (size_t i = 0; i < sections.size(); i++) {
+            pad(sections[i].offset);
+            const auto& binary = *binaries[i];
+            if (binary.IsChunked()) {
+                for (const auto& chunk : binary.chunks) {
+                    writer(chunk.data.get(), 1, chunk.size);
+                }
+            } else {
+                writer(binary.data.get(), 1, binary.size);
+            }
+        }
+        pad(offset);
+        writer.close();
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_ERROR_ << "Failed to write index container " << filename << ": " << e.what();
+        return Status::disk_file_error;
+    }
+    return Status::success;
+}
+
+expected<std::unique_ptr<IndexContainerReader>>
+IndexContainerReader::Open(const std::string& filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return expected<std::unique_ptr<IndexContainerReader>>::Err(
+            Status::disk_file_error, "cannot open index container " + filename + ": " + strerror(errno));
+    }
+    auto fail = [fd, &filename](Status status, const std::string& msg) {
+        close(fd);
+        return expected<std::unique_ptr<IndexContainerReader>>::Err(status, msg + " in index container " + filename);
+    };
+    const off_t file_size = lseek(fd, 0, SEEK_END);
+    ContainerHeader header{};
+    if (!ReadAt(fd, &header, sizeof(header), 0)) {
+        return fail(Status::invalid_binary_set, "truncated header");
+    }
+    if (std::memcmp(header.magic, kContainerMagic, sizeof(kContainerMagic)) != 0) {
+        return fail(Status::invalid_binary_set, "invalid magic");
+    }
+    if (header.version != kContainerVersion) {
+        return fail(Status::invalid_binary_set, "unsupported version " + std::to_string(header.version));
+    }
+    if (header.page_size == 0) {
+        return fail(Status::invalid_binary_set, "invalid page size");
+    }
+    if (sizeof(header) + static_cast<uint64_t>(header.n_sections) * sizeof(ContainerSection) >
+        static_cast<uint64_t>(file_size)) {
+        return fail(Status::invalid_binary_set, "truncated table of contents");
+    }
+    std::vector<ContainerSection> sections(header.n_sections);
+    if (!ReadAt(fd, sections.data(), sections.size() * sizeof(ContainerSection), sizeof(header))) {
+        return fail(Status::invalid_binary_set, "truncated table of contents");
+    }
+    if (MetaChecksum(header, sections) != header.checksum) {
+        return fail(Status::invalid_binary_set, "checksum mismatch of the table of contents");
+    }
+    for (auto& section : sections) {
+        section.name[ContainerSection::kMaxNameLength] = '\0';
+        if (section.offset % header.page_size != 0 ||
+            section.offset + section.size > static_cast<uint64_t>(file_size)) {
+            return fail(Status::invalid_binary_set, std::string("section ") + section.name + " out of the file");
+        }
+    }
+    return std::unique_ptr<IndexContainerReader>(new IndexContainerReader(fd, filename, std::move(sections)));
+}
+
+IndexContainerReader::~IndexContainerReader() {
+    close(fd_);
+}
+
+const ContainerSection*
+IndexContainerReader::Find(const std::string& name) const {
+    for (const auto& section : sections_) {
+        if (name == section.name) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
+
+expected<BinaryPtr>
+IndexContainerReader::Read(const std::string& name) const {
+    const auto* section = Find(name);
+    if (section == nullptr) {
+        return expected<BinaryPtr>::Err(Status::invalid_binary_set, "no section " + name + " in " + filename_);
+    }
+    auto binary = std::make_shared<Binary>();
+    binary->data = std::shared_ptr<uint8_t[]>(new uint8_t[section->size]);
+    binary->size = section->size;
+    if (!ReadAt(fd_, binary->data.get(), section->size, section->offset)) {
+        return expected<BinaryPtr>::Err(Status::disk_file_error, "cannot read section " + name + " of " + filename_);
+    }
+    if (XXH3_64bits(binary->data.get(), binary->size) != section->checksum) {
+        return expected<BinaryPtr>::Err(Status::invalid_binary_set,
+                                        "checksum mismatch of section " + name + " of " + filename_);
+    }
+    return binary;
+}
+
+expected<BinaryPtr>
+IndexContainerReader::Map(const std::string& name, bool verify) const {
+    const auto* section = Find(name);
+    if (section == nullptr) {
+        return expected<BinaryPtr>::Err(Status::invalid_binary_set, "no section " + name + " in " + filename_);
+    }
+    auto binary = std::make_shared<Binary>();
+    if (section->size == 0) {
+        return binary;
+    }
+    // the offsets are aligned to kContainerPageSize, the pages of the system may be larger
+    const uint64_t system_page = sysconf(_SC_PAGESIZE);
+    const uint64_t map_offset = section->offset / system_page * system_page;
+    const size_t map_size = section->offset - map_offset + section->size;
+    void* map = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd_, map_offset);
+    if (map == MAP_FAILED) {
+        return expected<BinaryPtr>::Err(Status::disk_file_error, "cannot map section " + name + " of " + filename_ +
+                                                                     ": " + strerror(errno));
+    }
+    auto data = static_cast<uint8_t*>(map) + (section->offset - map_offset);
+    binary->data = std::shared_ptr<uint8_t[]>(data, [map, map_size](uint8_t*) { munmap(map, map_size); });
+    binary->size = section->size;
+    if (verify && XXH3_64bits(data, section->size) != section->checksum) {
+        return expected<BinaryPtr>::Err(Status::invalid_binary_set,
+                                        "checksum mismatch of section " + name + " of " + filename_);
+    }
+    return binary;
+}
+
+Status
+IndexContainerReader::Load(BinarySet& binset, const std::vector<std::string>& names, bool mmap) const {
+    std::vector<std::string> to_load = names;
+    if (to_load.empty()) {
+        for (const auto& section : sections_) {
+            to_load.emplace_back(section.name);
+        }
+    }
+    for (const auto& name : to_load) {
+        auto binary = mmap ? Map(name) : Read(name);
+        if (!binary.has_value()) {
+            LOG_KNOWHERE_ERROR_ << binary.what();
+            return binary.error();
+        }
+        binset.Append(name, binary.value());
+    }
+    return Status::success;
+}
+
+}  // namespace knowhere
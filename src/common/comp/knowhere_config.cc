@@ -11,13 +11,16 @@
 
 #include "knowhere/comp/knowhere_config.h"
 
+#include <algorithm>
 #include <string>
 
 #ifdef KNOWHERE_WITH_DISKANN
 #include "diskann/aio_context_pool.h"
+#include "diskann/uring_context_pool.h"
 #endif
 #include "faiss/Clustering.h"
 #include "faiss/utils/distances.h"
+#include "knowhere/comp/search_coalescer.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/log.h"
 #ifdef KNOWHERE_WITH_GPU
@@ -146,6 +149,14 @@ KnowhereConfig::SetAioContextPool(size_t num_ctx) {
     return true;
 }
 
+bool
+KnowhereConfig::SetUringContextPool(size_t num_ctx, bool sqpoll) {
+#ifdef KNOWHERE_WITH_DISKANN
+    return UringContextPool::InitGlobalUringPool(num_ctx, default_max_events, sqpoll);
+#endif
+    return false;
+}
+
 void
 KnowhereConfig::SetBuildThreadPoolSize(size_t num_threads) {
     knowhere::ThreadPool::SetGlobalBuildThreadPoolSize(num_threads);
@@ -166,6 +177,69 @@ KnowhereConfig::GetSearchThreadPoolSize() {
     return knowhere::ThreadPool::GetGlobalSearchThreadPoolSize();
 }
 
+bool
+KnowhereConfig::SetBuildThreadPoolCpus(const std::string& cpu_list) {
+    std::vector<int> cpus;
+    if (!numa::ParseCpuList(cpu_list, cpus)) {
+        LOG_KNOWHERE_ERROR_ << "Invalid cpu list of the build thread pool: " << cpu_list;
+        return false;
+    }
+    LOG_KNOWHERE_INFO_ << "Set the cpus of the build thread pool to " << (cpu_list.empty() ? "all" : cpu_list);
+    knowhere::ThreadPool::SetGlobalBuildThreadPoolCpus(std::move(cpus));
+    return true;
+}
+
+bool
+KnowhereConfig::SetSearchThreadPoolCpus(const std::string& cpu_list) {
+    std::vector<int> cpus;
+    if (!numa::ParseCpuList(cpu_list, cpus)) {
+        LOG_KNOWHERE_ERROR_ << "Invalid cpu list of the search thread pool: " << cpu_list;
+        return false;
+    }
+    LOG_KNOWHERE_INFO_ << "Set the cpus of the search thread pool to " << (cpu_list.empty() ? "all" : cpu_list);
+    knowhere::ThreadPool::SetGlobalSearchThreadPoolCpus(std::move(cpus));
+    return true;
+}
+
+void
+KnowhereConfig::SetBatchSearchNq(size_t nq) {
+    LOG_KNOWHERE_INFO_ << "Set batch search nq to " << nq;
+    knowhere::ThreadPool::SetBatchSearchNq(nq);
+}
+
+void
+KnowhereConfig::SetSearchAdmission(size_t max_pending_tasks, int64_t max_queue_wait_ms) {
+    LOG_KNOWHERE_INFO_ << "Set search admission limits to " << max_pending_tasks << " pending tasks, "
+                       << max_queue_wait_ms << " ms queue wait";
+    knowhere::ThreadPool::SetSearchAdmission(max_pending_tasks, std::chrono::milliseconds(max_queue_wait_ms));
+}
+
+void
+KnowhereConfig::SetSearchPlanner(bool enabled, const SearchCostModel& model) {
+    LOG_KNOWHERE_INFO_ << (enabled ? "Enable" : "Disable") << " the search planner, cost coefficients: graph "
+                       << model.graph << ", ivf " << model.ivf << ", brute force " << model.brute_force;
+    SearchPlanner::SetCostModel(model);
+    SearchPlanner::SetEnabled(enabled);
+}
+
+void
+KnowhereConfig::SetGpuSearchCoalescing(size_t max_batch_nq, int64_t max_wait_us) {
+    LOG_KNOWHERE_INFO_ << "Set GPU search coalescing to batches of " << max_batch_nq << " queries, " << max_wait_us
+                       << " us wait";
+    SearchCoalescer::SetLimits(max_batch_nq, std::chrono::microseconds(max_wait_us));
+}
+
+void
+KnowhereConfig::SetNumaPolicy(numa::NumaPolicy policy) {
+    LOG_KNOWHERE_INFO_ << "Set NUMA policy to " << static_cast<int>(policy) << ", with " << numa::NodeCount()
+                       << " NUMA nodes";
+    if (policy == numa::NumaPolicy::LOCAL) {
+        knowhere::ThreadPool::InitNumaSearchThreadPools(
+            std::max<size_t>(1, knowhere::ThreadPool::GetGlobalSearchThreadPool()->size()));
+    }
+    numa::SetPolicy(policy);
+}
+
 void
 KnowhereConfig::InitGPUResource(int64_t gpu_id, int64_t res_num) {
 #ifdef KNOWHERE_WITH_GPU
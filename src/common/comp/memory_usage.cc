@@ -0,0 +1,59 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/memory_usage.h"
+
+#include <atomic>
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+
+std::atomic<uint64_t> next_index_id = 0;
+
+}  // namespace
+
+IndexMemoryGauges::IndexMemoryGauges(const std::string& index_type)
+    : index_id_(std::to_string(next_index_id.fetch_add(1))), index_type_(index_type) {
+}
+
+IndexMemoryGauges::~IndexMemoryGauges() {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    for (auto& [section, gauge] : gauges_) {
+        index_memory_size_family.Remove(gauge);
+    }
+#endif
+}
+
+void
+IndexMemoryGauges::Update(const MemoryUsage& usage) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    std::lock_guard lock(mutex_);
+    // the sections the index no longer has drop to 0
+    for (auto& [section, gauge] : gauges_) {
+        gauge->Set(0);
+    }
+    for (const auto& [section, bytes] : usage.Sections()) {
+        auto& gauge = gauges_[section];
+        if (gauge == nullptr) {
+            gauge = &index_memory_size_family.Add(
+                {{"index_id", index_id_}, {"index_type", index_type_}, {"section", section}});
+        }
+        gauge->Set(bytes / (1024.0 * 1024.0));
+    }
+#endif
+}
+
+}  // namespace knowhere
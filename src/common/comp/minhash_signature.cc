@@ -0,0 +1,100 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/minhash_signature.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "knowhere/comp/thread_pool.h"
+#include "simd/hook.h"
+
+namespace knowhere {
+
+namespace {
+
+// the sets of a task of the search thread pool
+constexpr size_t kMinHashSetsPerTask = 1024;
+
+}  // namespace
+
+expected<DataSetPtr>
+GenMinHashSignatures(const uint64_t* tokens, const std::vector<size_t>& offsets, size_t num_perm,
+                     size_t element_bit_width, uint64_t seed) {
+    if (offsets.empty() || offsets.front() != 0 || !std::is_sorted(offsets.begin(), offsets.end())) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "the offsets of the token sets are not sorted from 0");
+    }
+    if (tokens == nullptr && offsets.back() > 0) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "the tokens are null");
+    }
+    if (num_perm == 0) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "num_perm should be positive");
+    }
+    if (element_bit_width != 32 && element_bit_width != 64) {
+        return expected<DataSetPtr>::Err(Status::invalid_args,
+                                         "element_bit_width should be 32 or 64, got " +
+                                             std::to_string(element_bit_width));
+    }
+
+    // odd multipliers, so that every function is a permutation of the 64-bit token hashes
+    std::vector<uint64_t> a(num_perm), b(num_perm);
+    std::mt19937_64 rng(seed);
+    for (size_t j = 0; j < num_perm; j++) {
+        a[j] = rng() | 1;
+        b[j] = rng();
+    }
+
+    const size_t n = offsets.size() - 1;
+    const size_t element_size = element_bit_width / 8;
+    std::unique_ptr<uint8_t[]> signatures(new uint8_t[n * num_perm * element_size]);
+    auto generate = [&](size_t begin, size_t end) {
+        std::vector<uint64_t> sig(num_perm);
+        for (size_t i = begin; i < end; i++) {
+            std::fill(sig.begin(), sig.end(), std::numeric_limits<uint64_t>::max());
+            faiss::u64_minhash_update(tokens + offsets[i], offsets[i + 1] - offsets[i], a.data(), b.data(), num_perm,
+                                      sig.data());
+            auto row = signatures.get() + i * num_perm * element_size;
+            if (element_size == sizeof(uint64_t)) {
+                std::memcpy(row, sig.data(), num_perm * sizeof(uint64_t));
+            } else {
+                // the high half of the least hash is the least high half
+                auto row32 = reinterpret_cast<uint32_t*>(row);
+                for (size_t j = 0; j < num_perm; j++) {
+                    row32[j] = static_cast<uint32_t>(sig[j] >> 32);
+                }
+            }
+        }
+    };
+    if (n <= kMinHashSetsPerTask) {
+        generate(0, n);
+    } else {
+        auto pool = ThreadPool::GetGlobalSearchThreadPool();
+        std::vector<folly::Future<folly::Unit>> futs;
+        futs.reserve((n + kMinHashSetsPerTask - 1) / kMinHashSetsPerTask);
+        for (size_t begin = 0; begin < n; begin += kMinHashSetsPerTask) {
+            futs.emplace_back(pool->push([&, begin] {
+                ThreadPool::ScopedSearchOmpSetter setter(1);
+                generate(begin, std::min(begin + kMinHashSetsPerTask, n));
+            }));
+        }
+        auto status = WaitAllSuccess(futs);
+        if (status != Status::success) {
+            return expected<DataSetPtr>::Err(status, "failed to generate the minhash signatures");
+        }
+    }
+    return GenResultDataSet(n, num_perm * element_bit_width, std::move(signatures));
+}
+
+}  // namespace knowhere
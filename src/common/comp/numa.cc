@@ -0,0 +1,139 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/numa.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "knowhere/log.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace knowhere::numa {
+
+namespace {
+// the modes of set_mempolicy(2), numaif.h is part of libnuma
+constexpr int kMpolDefault = 0;
+constexpr int kMpolPreferred = 1;
+constexpr int kMpolInterleave = 3;
+constexpr int kMaxNodes = 64;
+
+std::atomic<NumaPolicy> policy_ = NumaPolicy::NONE;
+std::atomic<int> next_node_ = 0;
+
+bool
+SetMemoryPolicy(int mode, unsigned long nodemask) {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+    if (syscall(SYS_set_mempolicy, mode, mode == kMpolDefault ? nullptr : &nodemask, kMaxNodes + 1) != 0) {
+        LOG_KNOWHERE_WARNING_ << "Failed to set the memory policy: " << std::strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+}  // namespace
+
+int
+NodeCount() {
+    static const int count = [] {
+        int n = 0;
+        while (n < kMaxNodes && std::ifstream("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist")) {
+            n++;
+        }
+        return n == 0 ? 1 : n;
+    }();
+    return count;
+}
+
+std::vector<int>
+NodeCpus(int node) {
+    std::vector<int> cpus;
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string cpu_list;
+    if (!std::getline(file, cpu_list) || !ParseCpuList(cpu_list, cpus)) {
+        return {};
+    }
+    return cpus;
+}
+
+bool
+ParseCpuList(const std::string& cpu_list, std::vector<int>& cpus) {
+    cpus.clear();
+    std::istringstream list_stream(cpu_list);
+    std::string range;
+    while (std::getline(list_stream, range, ',')) {
+        int first = 0, last = 0;
+        char dash = 0;
+        std::istringstream range_stream(range);
+        if (!(range_stream >> first) || first < 0) {
+            return false;
+        }
+        if (range_stream >> dash) {
+            if (dash != '-' || !(range_stream >> last) || last < first) {
+                return false;
+            }
+        } else {
+            last = first;
+        }
+        range_stream >> std::ws;
+        if (!range_stream.eof()) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return true;
+}
+
+void
+SetPolicy(NumaPolicy policy) {
+    policy_.store(policy);
+}
+
+NumaPolicy
+GetPolicy() {
+    return policy_.load();
+}
+
+ScopedIndexPlacement::ScopedIndexPlacement() {
+    const auto policy = GetPolicy();
+    const int node_count = NodeCount();
+    if (policy == NumaPolicy::NONE || node_count <= 1) {
+        return;
+    }
+    if (policy == NumaPolicy::LOCAL) {
+        const int node = next_node_.fetch_add(1) % node_count;
+        // preferred rather than bound, a full node spills over instead of failing the load
+        applied_ = SetMemoryPolicy(kMpolPreferred, 1UL << node);
+        node_ = applied_ ? node : -1;
+    } else {
+        applied_ = SetMemoryPolicy(kMpolInterleave, node_count == kMaxNodes ? ~0UL : (1UL << node_count) - 1);
+    }
+}
+
+ScopedIndexPlacement::~ScopedIndexPlacement() {
+    if (applied_) {
+        SetMemoryPolicy(kMpolDefault, 0);
+    }
+}
+
+}  // namespace knowhere::numa
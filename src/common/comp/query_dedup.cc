@@ -0,0 +1,128 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/query_dedup.h"
+
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+#include "knowhere/data_source.h"
+#include "simd/hook.h"
+
+namespace knowhere {
+
+namespace {
+
+constexpr size_t kSimHashBits = 16;
+
+// kSimHashBits random hyperplanes of dim dimensions, the same for every batch
+std::vector<float>
+SimHashPlanes(int64_t dim) {
+    std::vector<float> planes(kSimHashBits * dim);
+    std::mt19937 rng(20240917);
+    std::normal_distribution<float> normal;
+    for (auto& v : planes) {
+        v = normal(rng);
+    }
+    return planes;
+}
+
+}  // namespace
+
+QueryDedup
+DedupQueries(const DataSet& dataset, DataFormatEnum format, float tolerance) {
+    const int64_t nq = dataset.GetRows();
+    const int64_t dim = dataset.GetDim();
+    const int64_t row_bytes = DenseRowBytes(format, dim);
+    const char* rows = static_cast<const char*>(dataset.GetTensor());
+    QueryDedup dedup;
+    dedup.of.resize(nq);
+    // the representatives of a bucket, exact hashes or SimHashes
+    std::unordered_map<uint64_t, std::vector<int64_t>> buckets;
+    if (tolerance > 0.0f && format == DataFormatEnum::fp32) {
+        const auto planes = SimHashPlanes(dim);
+        const float* vectors = reinterpret_cast<const float*>(rows);
+        for (int64_t i = 0; i < nq; i++) {
+            const float* q = vectors + i * dim;
+            uint64_t simhash = 0;
+            for (size_t b = 0; b < kSimHashBits; b++) {
+                simhash |= static_cast<uint64_t>(faiss::fvec_inner_product(q, planes.data() + b * dim, dim) >= 0.0f)
+                           << b;
+            }
+            const float max_dis = tolerance * tolerance * faiss::fvec_norm_L2sqr(q, dim);
+            auto& reps = buckets[simhash];
+            int64_t found = -1;
+            for (int64_t r : reps) {
+                if (faiss::fvec_L2sqr(q, vectors + dedup.representatives[r] * dim, dim) <= max_dis) {
+                    found = r;
+                    break;
+                }
+            }
+            if (found < 0) {
+                found = dedup.representatives.size();
+                dedup.representatives.push_back(i);
+                reps.push_back(found);
+            }
+            dedup.of[i] = found;
+        }
+        return dedup;
+    }
+    for (int64_t i = 0; i < nq; i++) {
+        const char* q = rows + i * row_bytes;
+        auto& reps = buckets[faiss::calculate_hash(q, row_bytes)];
+        int64_t found = -1;
+        for (int64_t r : reps) {
+            if (std::memcmp(q, rows + dedup.representatives[r] * row_bytes, row_bytes) == 0) {
+                found = r;
+                break;
+            }
+        }
+        if (found < 0) {
+            found = dedup.representatives.size();
+            dedup.representatives.push_back(i);
+            reps.push_back(found);
+        }
+        dedup.of[i] = found;
+    }
+    return dedup;
+}
+
+DataSetPtr
+RepresentativeQueries(const DataSet& dataset, DataFormatEnum format, const QueryDedup& dedup) {
+    const int64_t row_bytes = DenseRowBytes(format, dataset.GetDim());
+    const char* rows = static_cast<const char*>(dataset.GetTensor());
+    auto data = new char[dedup.representatives.size() * row_bytes];
+    for (size_t r = 0; r < dedup.representatives.size(); r++) {
+        std::memcpy(data + r * row_bytes, rows + dedup.representatives[r] * row_bytes, row_bytes);
+    }
+    auto queries = std::make_shared<DataSet>();
+    queries->SetRows(dedup.representatives.size());
+    queries->SetDim(dataset.GetDim());
+    queries->SetTensor(data);
+    queries->SetIsOwner(true);
+    return queries;
+}
+
+DataSetPtr
+FanOutResults(const DataSet& result, const QueryDedup& dedup) {
+    const int64_t nq = dedup.of.size();
+    const int64_t k = result.GetDim();
+    auto ids = std::make_unique<int64_t[]>(nq * k);
+    auto distances = std::make_unique<float[]>(nq * k);
+    for (int64_t i = 0; i < nq; i++) {
+        std::memcpy(ids.get() + i * k, result.GetIds() + dedup.of[i] * k, k * sizeof(int64_t));
+        std::memcpy(distances.get() + i * k, result.GetDistance() + dedup.of[i] * k, k * sizeof(float));
+    }
+    return GenResultDataSet(nq, k, std::move(ids), std::move(distances));
+}
+
+}  // namespace knowhere
@@ -0,0 +1,124 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/result_cache.h"
+
+#include <cstring>
+
+#include "knowhere/data_source.h"
+#include "simd/hook.h"
+
+namespace knowhere {
+
+size_t
+SearchResultCache::QueryBytes(int64_t nq, int64_t dim) const {
+    return nq * DenseRowBytes(data_format_, dim);
+}
+
+uint64_t
+SearchResultCache::Hash(const Key& key, const void* queries, size_t query_bytes) {
+    uint64_t hash = faiss::calculate_hash(static_cast<const char*>(queries), query_bytes);
+    for (uint64_t v : {key.config_fingerprint, static_cast<uint64_t>(key.bitset_version),
+                       static_cast<uint64_t>(key.nq), static_cast<uint64_t>(key.k)}) {
+        hash = (hash ^ v) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+bool
+SearchResultCache::Matches(const Entry& entry, const Key& key, const void* queries, size_t query_bytes) {
+    return entry.key.config_fingerprint == key.config_fingerprint && entry.key.bitset_version == key.bitset_version &&
+           entry.key.nq == key.nq && entry.key.k == key.k && entry.queries.size() == query_bytes &&
+           std::memcmp(entry.queries.data(), queries, query_bytes) == 0;
+}
+
+DataSetPtr
+SearchResultCache::Get(const Key& key, const void* queries, size_t query_bytes) {
+    const uint64_t hash = Hash(key, queries, query_bytes);
+    const size_t n = key.nq * key.k;
+    std::lock_guard lock(mutex_);
+    auto [begin, end] = entries_.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        if (!Matches(*it->second, key, queries, query_bytes)) {
+            continue;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        auto ids = std::make_unique<int64_t[]>(n);
+        auto distances = std::make_unique<float[]>(n);
+        std::memcpy(ids.get(), it->second->ids.get(), n * sizeof(int64_t));
+        std::memcpy(distances.get(), it->second->distances.get(), n * sizeof(float));
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return GenResultDataSet(key.nq, key.k, std::move(ids), std::move(distances));
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void
+SearchResultCache::Put(const Key& key, const void* queries, size_t query_bytes, const DataSet& result,
+                       uint64_t generation) {
+    if (result.GetIds() == nullptr || result.GetDistance() == nullptr || result.GetRows() != key.nq ||
+        result.GetDim() != key.k) {
+        return;
+    }
+    const size_t n = key.nq * key.k;
+    const size_t bytes = sizeof(Entry) + query_bytes + n * (sizeof(int64_t) + sizeof(float));
+    if (bytes > capacity_bytes_) {
+        return;
+    }
+    Entry entry{Hash(key, queries, query_bytes),
+                key,
+                std::vector<char>(static_cast<const char*>(queries), static_cast<const char*>(queries) + query_bytes),
+                std::make_unique<int64_t[]>(n),
+                std::make_unique<float[]>(n),
+                bytes};
+    std::memcpy(entry.ids.get(), result.GetIds(), n * sizeof(int64_t));
+    std::memcpy(entry.distances.get(), result.GetDistance(), n * sizeof(float));
+
+    std::lock_guard lock(mutex_);
+    if (generation != generation_.load(std::memory_order_acquire)) {
+        return;
+    }
+    auto [begin, end] = entries_.equal_range(entry.hash);
+    for (auto it = begin; it != end; ++it) {
+        if (Matches(*it->second, key, queries, query_bytes)) {
+            // a concurrent search of the same queries put it first
+            return;
+        }
+    }
+    while (!lru_.empty() && bytes_ + bytes > capacity_bytes_) {
+        const Entry& last = lru_.back();
+        auto [lbegin, lend] = entries_.equal_range(last.hash);
+        for (auto it = lbegin; it != lend; ++it) {
+            if (&*it->second == &last) {
+                entries_.erase(it);
+                break;
+            }
+        }
+        bytes_ -= last.bytes;
+        lru_.pop_back();
+    }
+    lru_.push_front(std::move(entry));
+    entries_.emplace(lru_.front().hash, lru_.begin());
+    bytes_ += bytes;
+}
+
+void
+SearchResultCache::Clear() {
+    std::lock_guard lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    entries_.clear();
+    lru_.clear();
+    bytes_ = 0;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,102 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/search_coalescer.h"
+
+#include <cstring>
+#include <vector>
+
+#include "knowhere/log.h"
+
+namespace knowhere {
+
+Status
+SearchCoalescer::Search(const std::string& key, const void* queries, int64_t nq, size_t row_size, int64_t k,
+                        int64_t* ids, float* dists, const BatchSearch& search) {
+    const size_t max_batch_nq = max_batch_nq_.load();
+    if (max_batch_nq == 0 || static_cast<size_t>(nq) >= max_batch_nq) {
+        return search(queries, nq, ids, dists);
+    }
+
+    std::unique_lock lock(mutex_);
+    auto& open = open_batches_[key];
+    if (open == nullptr) {
+        open = std::make_shared<Batch>();
+    }
+    auto batch = open;
+    const bool leader = batch->requests.empty();
+    batch->requests.push_back(Request{queries, nq, ids, dists});
+    batch->nq += nq;
+    const bool full = static_cast<size_t>(batch->nq) >= max_batch_nq;
+    if (full) {
+        // the batch is closed, later requests open a new one
+        open_batches_.erase(key);
+    }
+
+    if (!leader) {
+        if (full) {
+            batch->cv.notify_all();
+        }
+        batch->cv.wait(lock, [&batch]() { return batch->done; });
+        return batch->status;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(max_wait_us_.load());
+    batch->cv.wait_until(lock, deadline, [&batch, max_batch_nq]() {
+        return static_cast<size_t>(batch->nq) >= max_batch_nq;
+    });
+    auto it = open_batches_.find(key);
+    if (it != open_batches_.end() && it->second == batch) {
+        open_batches_.erase(it);
+    }
+    lock.unlock();
+
+    // the other requests wait for the batch until it is done, even if its search throws
+    Status status = Status::success;
+    try {
+        status = RunBatch(*batch, row_size, k, search);
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_ERROR_ << "coalesced search of " << batch->requests.size() << " requests failed: " << e.what();
+        status = Status::internal_error;
+    }
+
+    lock.lock();
+    batch->status = status;
+    batch->done = true;
+    batch->cv.notify_all();
+    return status;
+}
+
+Status
+SearchCoalescer::RunBatch(Batch& batch, size_t row_size, int64_t k, const BatchSearch& search) {
+    if (batch.requests.size() == 1) {
+        const auto& request = batch.requests[0];
+        return search(request.queries, request.nq, request.ids, request.dists);
+    }
+    std::vector<uint8_t> queries(batch.nq * row_size);
+    int64_t offset = 0;
+    for (const auto& request : batch.requests) {
+        std::memcpy(queries.data() + offset * row_size, request.queries, request.nq * row_size);
+        offset += request.nq;
+    }
+    std::vector<int64_t> ids(batch.nq * k);
+    std::vector<float> dists(batch.nq * k);
+    RETURN_IF_ERROR(search(queries.data(), batch.nq, ids.data(), dists.data()));
+    offset = 0;
+    for (const auto& request : batch.requests) {
+        std::memcpy(request.ids, ids.data() + offset * k, request.nq * k * sizeof(int64_t));
+        std::memcpy(request.dists, dists.data() + offset * k, request.nq * k * sizeof(float));
+        offset += request.nq;
+    }
+    return Status::success;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,90 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/search_phases.h"
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+
+constexpr const char* kSearchPhaseNames[kNumSearchPhases] = {"queue", "coarse", "scan", "refine", "assemble"};
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+using PhaseHistograms = std::array<std::unique_ptr<ShardedHistogram>, kNumSearchPhases>;
+
+// the histograms of an index type, the family is only searched the first time
+const PhaseHistograms&
+GetPhaseHistograms(const std::string& index_type) {
+    static std::shared_mutex mutex;
+    static std::unordered_map<std::string, PhaseHistograms> histograms;
+    {
+        std::shared_lock lock(mutex);
+        auto it = histograms.find(index_type);
+        if (it != histograms.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock lock(mutex);
+    auto [it, inserted] = histograms.try_emplace(index_type);
+    if (inserted) {
+        for (size_t i = 0; i < kNumSearchPhases; i++) {
+            it->second[i] = std::make_unique<ShardedHistogram>(
+                search_phase_latency_family.Add(
+                    {{"module", "knowhere"}, {"index_type", index_type}, {"phase", kSearchPhaseNames[i]}},
+                    phaseLatencyBuckets),
+                phaseLatencyBuckets);
+        }
+    }
+    return it->second;
+}
+#endif
+
+}  // namespace
+
+const char*
+SearchPhaseName(SearchPhase phase) {
+    return kSearchPhaseNames[static_cast<size_t>(phase)];
+}
+
+double
+SearchPhaseRecorder::Get(SearchPhase phase) const {
+    const double ms = ns_[static_cast<size_t>(phase)].load(std::memory_order_relaxed) * 1e-6;
+    if (phase == SearchPhase::QUEUE) {
+        const int64_t tasks = queued_tasks_.load(std::memory_order_relaxed);
+        return tasks > 0 ? ms / tasks : 0.0;
+    }
+    return ms;
+}
+
+void
+SearchPhaseRecorder::Observe(const std::string& index_type) const {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    const auto& histograms = GetPhaseHistograms(index_type);
+    for (size_t i = 0; i < kNumSearchPhases; i++) {
+        // the phases an index does not go through are left out
+        const auto phase = static_cast<SearchPhase>(i);
+        if (ns_[i].load(std::memory_order_relaxed) > 0 || (phase == SearchPhase::QUEUE && queued_tasks_.load() > 0)) {
+            histograms[i]->Observe(Get(phase));
+        }
+    }
+#endif
+}
+
+}  // namespace knowhere
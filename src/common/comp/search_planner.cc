@@ -0,0 +1,158 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/search_planner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+
+std::atomic<bool> planner_enabled{false};
+std::mutex model_mutex;
+SearchCostModel cost_model;
+
+double
+GraphWork(const SearchPlanInput& in) {
+    if (in.ef <= 0 || in.ntotal <= 0) {
+        return -1.0;
+    }
+    const double valid = std::max<double>(in.ntotal - in.filtered_out_num, 1.0);
+    const double visited = std::max(in.ef, in.k) * (1.0 + std::log2(static_cast<double>(in.ntotal))) *
+                           (in.ntotal / valid);
+    return std::min<double>(visited, in.ntotal) * in.dim;
+}
+
+double
+IvfWork(const SearchPlanInput& in) {
+    if (in.nlist <= 0 || in.nprobe <= 0) {
+        return -1.0;
+    }
+    const double scanned = std::min<double>(in.nprobe, in.nlist) / in.nlist * in.ntotal;
+    return (in.nlist + scanned) * in.dim;
+}
+
+double
+BruteForceWork(const SearchPlanInput& in) {
+    const double valid = std::max<int64_t>(in.ntotal - in.filtered_out_num, 0);
+    return valid * in.dim + in.filtered_out_num;
+}
+
+}  // namespace
+
+void
+SearchPlanner::SetEnabled(bool enabled) {
+    planner_enabled.store(enabled);
+}
+
+bool
+SearchPlanner::Enabled() {
+    return planner_enabled.load();
+}
+
+void
+SearchPlanner::SetCostModel(const SearchCostModel& model) {
+    std::lock_guard<std::mutex> lock(model_mutex);
+    cost_model = model;
+}
+
+SearchCostModel
+SearchPlanner::GetCostModel() {
+    std::lock_guard<std::mutex> lock(model_mutex);
+    return cost_model;
+}
+
+SearchPlanCost
+SearchPlanner::Estimate(const SearchPlanInput& input, const SearchCostModel& model) {
+    SearchPlanCost cost;
+    cost.brute_force = model.brute_force * BruteForceWork(input);
+    double best = cost.brute_force;
+    const double graph_work = GraphWork(input);
+    if (graph_work >= 0) {
+        cost.graph = model.graph * graph_work;
+        if (cost.graph < best) {
+            best = cost.graph;
+            cost.plan = SearchPlan::GRAPH;
+        }
+    }
+    const double ivf_work = IvfWork(input);
+    if (ivf_work >= 0) {
+        cost.ivf = model.ivf * ivf_work;
+        if (cost.ivf < best) {
+            cost.plan = SearchPlan::IVF;
+        }
+    }
+    return cost;
+}
+
+SearchPlanCost
+SearchPlanner::Plan(const SearchPlanInput& input) {
+    auto cost = Estimate(input, GetCostModel());
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    switch (cost.plan) {
+        case SearchPlan::GRAPH:
+            knowhere_search_plan_graph.Increment();
+            break;
+        case SearchPlan::IVF:
+            knowhere_search_plan_ivf.Increment();
+            break;
+        case SearchPlan::BRUTE_FORCE:
+            knowhere_search_plan_brute_force.Increment();
+            break;
+    }
+#endif
+    return cost;
+}
+
+SearchCostModel
+SearchPlanner::Calibrate(const std::vector<SearchPlanSample>& samples, const SearchCostModel& base) {
+    // sum of latency * work and of work^2 per plan
+    double tw[3] = {0, 0, 0};
+    double ww[3] = {0, 0, 0};
+    for (const auto& sample : samples) {
+        double work = -1.0;
+        switch (sample.plan) {
+            case SearchPlan::GRAPH:
+                work = GraphWork(sample.input);
+                break;
+            case SearchPlan::IVF:
+                work = IvfWork(sample.input);
+                break;
+            case SearchPlan::BRUTE_FORCE:
+                work = BruteForceWork(sample.input);
+                break;
+        }
+        if (work <= 0 || sample.latency_ms < 0) {
+            continue;
+        }
+        const auto p = static_cast<int>(sample.plan);
+        tw[p] += sample.latency_ms * work;
+        ww[p] += work * work;
+    }
+    SearchCostModel model = base;
+    double* coefs[3] = {&model.graph, &model.ivf, &model.brute_force};
+    for (int p = 0; p < 3; p++) {
+        if (ww[p] > 0 && tw[p] > 0) {
+            *coefs[p] = tw[p] / ww[p];
+        }
+    }
+    return model;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,176 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/topk_merge.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "knowhere/comp/thread_pool.h"
+
+namespace knowhere {
+
+namespace {
+
+// A winner tree over the heads of the rows of a query, leaf i is the head of segment i. An exhausted segment has the
+//   worst distance and loses to every other one.
+template <bool larger_is_closer>
+class TournamentTree {
+ public:
+    explicit TournamentTree(const std::vector<TopkSegment>& segments) : segments_(segments) {
+        leaves_ = 1;
+        while (leaves_ < segments.size()) {
+            leaves_ *= 2;
+        }
+        heads_.resize(leaves_);
+        positions_.resize(leaves_);
+        tree_.resize(2 * leaves_);
+    }
+
+    void
+    Reset(int64_t query) {
+        query_ = query;
+        for (size_t s = 0; s < leaves_; s++) {
+            positions_[s] = 0;
+            heads_[s] = Head(s);
+            tree_[leaves_ + s] = s;
+        }
+        for (size_t node = leaves_ - 1; node > 0; node--) {
+            tree_[node] = Winner(tree_[2 * node], tree_[2 * node + 1]);
+        }
+    }
+
+    bool
+    Empty() const {
+        return heads_[tree_[1]] == kWorst;
+    }
+
+    // the segment and the offset of the closest remaining result
+    size_t
+    Top(int64_t& offset) const {
+        const size_t s = tree_[1];
+        offset = query_ * segments_[s].k + positions_[s];
+        return s;
+    }
+
+    void
+    Pop() {
+        const size_t s = tree_[1];
+        positions_[s]++;
+        heads_[s] = Head(s);
+        for (size_t node = (leaves_ + s) / 2; node > 0; node /= 2) {
+            tree_[node] = Winner(tree_[2 * node], tree_[2 * node + 1]);
+        }
+    }
+
+    static constexpr float kWorst =
+        larger_is_closer ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+
+ private:
+    float
+    Head(size_t s) const {
+        if (s >= segments_.size() || positions_[s] >= segments_[s].k) {
+            return kWorst;
+        }
+        const int64_t offset = query_ * segments_[s].k + positions_[s];
+        return segments_[s].ids[offset] < 0 ? kWorst : segments_[s].distances[offset];
+    }
+
+    size_t
+    Winner(size_t a, size_t b) const {
+        if constexpr (larger_is_closer) {
+            return heads_[b] > heads_[a] ? b : a;
+        } else {
+            return heads_[b] < heads_[a] ? b : a;
+        }
+    }
+
+    const std::vector<TopkSegment>& segments_;
+    size_t leaves_;
+    int64_t query_ = 0;
+    std::vector<float> heads_;
+    std::vector<int64_t> positions_;
+    std::vector<size_t> tree_;
+};
+
+template <bool larger_is_closer>
+void
+MergeQueries(const std::vector<TopkSegment>& segments, int64_t begin, int64_t end, int64_t k,
+             const TopkMergeOptions& options, int64_t* ids, float* distances) {
+    using Tree = TournamentTree<larger_is_closer>;
+    Tree tree(segments);
+    std::unordered_set<int64_t> seen;
+    std::unordered_map<int64_t, int64_t> group_counts;
+    for (int64_t q = begin; q < end; q++) {
+        tree.Reset(q);
+        seen.clear();
+        group_counts.clear();
+        int64_t n = 0;
+        int64_t* out_ids = ids + q * k;
+        float* out_distances = distances + q * k;
+        for (; n < k && !tree.Empty(); tree.Pop()) {
+            int64_t offset;
+            const auto& segment = segments[tree.Top(offset)];
+            const int64_t id = segment.ids[offset];
+            if (options.dedup && !seen.insert(id).second) {
+                continue;
+            }
+            if (options.group_size > 0 && ++group_counts[segment.group_ids[offset]] > options.group_size) {
+                continue;
+            }
+            out_ids[n] = id;
+            out_distances[n] = segment.distances[offset];
+            n++;
+        }
+        std::fill(out_ids + n, out_ids + k, -1);
+        std::fill(out_distances + n, out_distances + k, Tree::kWorst);
+    }
+}
+
+}  // namespace
+
+Status
+MergeTopk(const std::vector<TopkSegment>& segments, int64_t nq, int64_t k, const TopkMergeOptions& options,
+          int64_t* ids, float* distances) {
+    if (nq < 0 || k <= 0 || ids == nullptr || distances == nullptr) {
+        return Status::invalid_args;
+    }
+    for (const auto& segment : segments) {
+        if (segment.k < 0 || (segment.k > 0 && (segment.ids == nullptr || segment.distances == nullptr)) ||
+            (options.group_size > 0 && segment.k > 0 && segment.group_ids == nullptr)) {
+            return Status::invalid_args;
+        }
+    }
+    auto merge = [&](int64_t begin, int64_t end) {
+        if (options.larger_is_closer) {
+            MergeQueries<true>(segments, begin, end, k, options, ids, distances);
+        } else {
+            MergeQueries<false>(segments, begin, end, k, options, ids, distances);
+        }
+    };
+    if (nq < std::max<int64_t>(options.parallel_nq, 2)) {
+        merge(0, nq);
+        return Status::success;
+    }
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    const int64_t num_tasks = std::min<int64_t>(nq, std::max<size_t>(pool->size(), 1));
+    std::vector<folly::Future<folly::Unit>> futures;
+    futures.reserve(num_tasks);
+    for (int64_t t = 0; t < num_tasks; t++) {
+        futures.emplace_back(pool->push([&, t]() { merge(nq * t / num_tasks, nq * (t + 1) / num_tasks); }));
+    }
+    WaitAllSuccess(futures);
+    return Status::success;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,44 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/trace_span.h"
+
+namespace knowhere {
+
+void
+ScopedTraceSpan::Start(TraceParent& parent, const char* name) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    if (!parent.TakeSpan()) {
+        return;
+    }
+    tracer::trace::StartSpanOptions opts;
+    opts.parent = parent.Span()->GetContext();
+    span_ = std::shared_ptr<tracer::trace::Span>(tracer::GetTracer()->StartSpan(name, opts));
+#endif
+}
+
+void
+ScopedTraceSpan::End() {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    std::static_pointer_cast<tracer::trace::Span>(span_)->End();
+#endif
+}
+
+void
+ScopedTraceSpan::SetAttribute(const char* key, int64_t value) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    if (span_ != nullptr) {
+        std::static_pointer_cast<tracer::trace::Span>(span_)->SetAttribute(key, value);
+    }
+#endif
+}
+
+}  // namespace knowhere
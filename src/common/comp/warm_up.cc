@@ -0,0 +1,161 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#include "knowhere/comp/warm_up.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/log.h"
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+#include "knowhere/prometheus_client.h"
+#endif
+
+namespace knowhere {
+
+namespace {
+
+constexpr size_t kWarmUpChunkSize = 64 * 1024 * 1024;
+
+// the pages a region lies in, a page holding a byte of a mapped region belongs to the same mapping
+struct PageRange {
+    uint8_t* begin;
+    size_t size;
+};
+
+PageRange
+PagesOf(const MappedRegion& region) {
+    static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    const auto begin = reinterpret_cast<uintptr_t>(region.data) / page_size * page_size;
+    const auto end = reinterpret_cast<uintptr_t>(region.data) + region.size;
+    return PageRange{reinterpret_cast<uint8_t*>(begin), end - begin};
+}
+
+void
+ReportPending(size_t bytes, bool done) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    if (done) {
+        knowhere_warm_up_pending_size.Decrement((double)bytes / 1024.0 / 1024.0);
+    } else {
+        knowhere_warm_up_pending_size.Increment((double)bytes / 1024.0 / 1024.0);
+    }
+#endif
+}
+
+// reads a byte of each page of [begin, begin + size)
+void
+FaultIn(const uint8_t* begin, size_t size) {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    uint8_t sum = 0;
+    for (size_t offset = 0; offset < size; offset += page_size) {
+        sum += *static_cast<const volatile uint8_t*>(begin + offset);
+    }
+    // keeps the reads
+    asm volatile("" : : "r"(sum));
+}
+
+Status
+WarmUpPass(const std::vector<MappedRegion>& regions, bool structure) {
+    std::vector<PageRange> chunks;
+    size_t total = 0;
+    for (const auto& region : regions) {
+        if (region.structure != structure || region.data == nullptr || region.size == 0) {
+            continue;
+        }
+        const auto pages = PagesOf(region);
+        // the read ahead of the kernel goes on while the chunks are faulted in
+        if (madvise(pages.begin, pages.size, MADV_WILLNEED) != 0) {
+            LOG_KNOWHERE_WARNING_ << "Failed to madvise a mapped region for warm up: " << strerror(errno);
+        }
+        for (size_t offset = 0; offset < pages.size; offset += kWarmUpChunkSize) {
+            chunks.push_back(PageRange{pages.begin + offset, std::min(kWarmUpChunkSize, pages.size - offset)});
+        }
+        total += pages.size;
+    }
+    if (chunks.empty()) {
+        return Status::success;
+    }
+
+    ReportPending(total, false);
+    auto pool = NestedBuildThreadPool();
+    std::vector<folly::Future<folly::Unit>> futures;
+    futures.reserve(chunks.size());
+    for (const auto& chunk : chunks) {
+        futures.emplace_back(pool.push([chunk]() {
+            FaultIn(chunk.begin, chunk.size);
+            ReportPending(chunk.size, true);
+        }));
+    }
+    WaitAllSuccess(futures);
+    LOG_KNOWHERE_INFO_ << "Warmed up " << total << " bytes of mapped " << (structure ? "structure" : "data");
+    return Status::success;
+}
+
+}  // namespace
+
+Status
+WarmUpRegions(const std::vector<MappedRegion>& regions, WarmUpLevel level) {
+    if (level == WarmUpLevel::NONE) {
+        return Status::success;
+    }
+    RETURN_IF_ERROR(WarmUpPass(regions, true));
+    if (level == WarmUpLevel::ALL) {
+        RETURN_IF_ERROR(WarmUpPass(regions, false));
+    }
+    return Status::success;
+}
+
+Status
+CoolDownRegions(const std::vector<MappedRegion>& regions) {
+    for (const auto& region : regions) {
+        if (region.data == nullptr || region.size == 0) {
+            continue;
+        }
+        const auto pages = PagesOf(region);
+        if (madvise(pages.begin, pages.size, MADV_DONTNEED) != 0) {
+            LOG_KNOWHERE_WARNING_ << "Failed to madvise a mapped region for cool down: " << strerror(errno);
+            return Status::disk_file_error;
+        }
+    }
+    return Status::success;
+}
+
+void
+AdviseWillNeed(const std::vector<MappedRegion>& regions) {
+    std::vector<PageRange> ranges;
+    ranges.reserve(regions.size());
+    for (const auto& region : regions) {
+        if (region.data != nullptr && region.size != 0) {
+            ranges.push_back(PagesOf(region));
+        }
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const PageRange& a, const PageRange& b) { return a.begin < b.begin; });
+    size_t n_merged = 0;
+    for (const auto& range : ranges) {
+        if (n_merged > 0 && range.begin <= ranges[n_merged - 1].begin + ranges[n_merged - 1].size) {
+            auto& last = ranges[n_merged - 1];
+            last.size = std::max(last.size, static_cast<size_t>(range.begin + range.size - last.begin));
+        } else {
+            ranges[n_merged++] = range;
+        }
+    }
+    for (size_t i = 0; i < n_merged; i++) {
+        madvise(ranges[i].begin, ranges[i].size, MADV_WILLNEED);
+    }
+}
+
+}  // namespace knowhere
@@ -0,0 +1,60 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "common/cuvs/integration/cuvs_brute_force_knn.hpp"
+
+#include <algorithm>
+#include <cuvs/neighbors/brute_force.hpp>
+#include <raft/core/copy.cuh>
+#include <raft/core/device_mdarray.hpp>
+#include <raft/core/device_resources_manager.hpp>
+#include <raft/core/host_mdspan.hpp>
+#include <raft/core/resource/cuda_stream.hpp>
+
+namespace cuvs_knowhere {
+
+namespace {
+constexpr int64_t kQueryBatch = 1 << 16;
+}
+
+void
+brute_force_knn(const float* base, int64_t n_base, const float* x, int64_t n, int64_t dim, int64_t k,
+                bool inner_product, float* distances, int64_t* labels) {
+    auto const& res = raft::device_resources_manager::get_device_resources();
+
+    auto device_base = raft::make_device_matrix<float, int64_t>(res, n_base, dim);
+    raft::copy(res, device_base.view(), raft::make_host_matrix_view<const float, int64_t>(base, n_base, dim));
+    auto index_params = cuvs::neighbors::brute_force::index_params{};
+    index_params.metric =
+        inner_product ? cuvs::distance::DistanceType::InnerProduct : cuvs::distance::DistanceType::L2Expanded;
+    auto index = cuvs::neighbors::brute_force::build(res, index_params, raft::make_const_mdspan(device_base.view()));
+    auto search_params = cuvs::neighbors::brute_force::search_params{};
+
+    const int64_t batch = std::min(n, kQueryBatch);
+    auto device_x = raft::make_device_matrix<float, int64_t>(res, batch, dim);
+    auto device_labels = raft::make_device_matrix<int64_t, int64_t>(res, batch, k);
+    auto device_distances = raft::make_device_matrix<float, int64_t>(res, batch, k);
+    for (int64_t begin = 0; begin < n; begin += batch) {
+        const int64_t rows = std::min(batch, n - begin);
+        auto x_view = raft::make_device_matrix_view<float, int64_t>(device_x.data_handle(), rows, dim);
+        auto labels_view = raft::make_device_matrix_view<int64_t, int64_t>(device_labels.data_handle(), rows, k);
+        auto distances_view = raft::make_device_matrix_view<float, int64_t>(device_distances.data_handle(), rows, k);
+        raft::copy(res, x_view, raft::make_host_matrix_view<const float, int64_t>(x + begin * dim, rows, dim));
+        cuvs::neighbors::brute_force::search(res, search_params, index, raft::make_const_mdspan(x_view), labels_view,
+                                             distances_view);
+        raft::copy(res, raft::make_host_matrix_view<int64_t, int64_t>(labels + begin * k, rows, k), labels_view);
+        raft::copy(res, raft::make_host_matrix_view<float, int64_t>(distances + begin * k, rows, k), distances_view);
+        // the host buffers are reused by the next batch
+        raft::resource::sync_stream(res);
+    }
+}
+
+}  // namespace cuvs_knowhere
@@ -0,0 +1,25 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace cuvs_knowhere {
+
+// the k nearest of the n_base rows of base for each of the n rows of x, by brute force on the current device. The
+//   distances are the squared L2 ones, or the inner products if inner_product is set, as faiss returns them. x is
+//   copied to the device in batches, so that it does not need to fit there.
+void
+brute_force_knn(const float* base, int64_t n_base, const float* x, int64_t n, int64_t dim, int64_t k,
+                bool inner_product, float* distances, int64_t* labels);
+
+}  // namespace cuvs_knowhere
@@ -15,12 +15,18 @@
  * limitations under the License.
  */
 #pragma once
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <type_traits>
 
 #include "common/cuvs/proto/cuvs_index_kind.hpp"
 
 namespace cuvs_knowhere {
+// the share of the rows a bitset filters out from which a search runs as a brute force over the others, the
+//   threshold HNSW uses on CPU
+inline constexpr float kBruteForceFilterThreshold = 0.93f;
+
 // This struct includes all parameters that may be passed to underlying cuVS
 // indexes. It is designed to not expose ANY cuVS types in order to cleanly
 // separate cuVS from knowhere headers.
@@ -34,6 +40,10 @@ struct cuvs_knowhere_config {
     bool add_data_on_build = true;
     bool cache_dataset_on_device = false;
     float refine_ratio = 1.0f;
+    // the rows are split into this many indexes, placed round-robin on the devices
+    std::optional<int> num_shards = std::nullopt;
+    // the version of the bitset of a search, the bitsets of the same version are uploaded to the device once
+    std::optional<std::int64_t> filter_version = std::nullopt;
 
     // Shared IVF Parameters
     std::optional<int> nlist = std::nullopt;
@@ -124,4 +134,45 @@ validate_cuvs_knowhere_config(cuvs_knowhere_config config) {
     return config;
 }
 
+// the params a search runs with, the searches with equal keys can run in one batch
+[[nodiscard]] inline auto
+search_params_key(cuvs_knowhere_config const& config) {
+    auto key = std::string{};
+    auto append = [&key](auto const& value) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::string>) {
+            key += value;
+        } else {
+            key += std::to_string(value);
+        }
+        key += ';';
+    };
+    auto append_optional = [&append, &key](auto const& value) {
+        if (value.has_value()) {
+            append(value.value());
+        } else {
+            key += "-;";
+        }
+    };
+    append(config.k);
+    append(config.metric_type);
+    append(config.refine_ratio);
+    append_optional(config.nprobe);
+    append_optional(config.lookup_table_dtype);
+    append_optional(config.internal_distance_dtype);
+    append_optional(config.preferred_shmem_carveout);
+    append_optional(config.itopk_size);
+    append_optional(config.max_queries);
+    append_optional(config.search_algo);
+    append_optional(config.team_size);
+    append_optional(config.search_width);
+    append_optional(config.min_iterations);
+    append_optional(config.max_iterations);
+    append_optional(config.thread_block_size);
+    append_optional(config.hashmap_mode);
+    append_optional(config.hashmap_min_bitlen);
+    append_optional(config.hashmap_max_fill_rate);
+    append_optional(config.persistent);
+    return key;
+}
+
 }  // namespace cuvs_knowhere
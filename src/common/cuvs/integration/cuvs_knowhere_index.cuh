@@ -23,6 +23,8 @@
 #include <cuvs/neighbors/ivf_pq.hpp>
 #include <istream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <raft/core/copy.cuh>
 #include <raft/core/device_resources_manager.hpp>
@@ -31,8 +33,10 @@
 #include <raft/core/resource/thrust_policy.hpp>
 #include <raft/core/serialize.hpp>
 #include <raft/linalg/normalize.cuh>
+#include <raft/matrix/gather.cuh>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include "common/cuvs/integration/cuvs_knowhere_index.hpp"
 #include "common/cuvs/proto/cuvs_index.hpp"
@@ -104,6 +108,23 @@ struct check_valid_entry {
     V max_id_;
 };
 
+// maps the ids a search over the rows a filter keeps returns back to the ids of the index
+template <typename V>
+struct map_subset_id {
+    __device__ __host__
+    map_subset_id(V const* ids, V size)
+        : ids_(ids), size_(size) {
+    }
+    __device__ V
+    operator()(V id) const {
+        return (id >= 0 && id < size_) ? ids_[id] : V{-1};
+    }
+
+ private:
+    V const* ids_;
+    V size_;
+};
+
 }  // namespace detail
 
 template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
@@ -390,6 +411,14 @@ struct cuvs_knowhere_index<IndexKind, DataType>::impl {
     impl() {
     }
 
+    explicit impl(int new_device_id) : device_id{new_device_id} {
+    }
+
+    auto
+    get_device_id() const {
+        return device_id;
+    }
+
     auto
     is_trained() const {
         return index_.has_value();
@@ -474,19 +503,13 @@ struct cuvs_knowhere_index<IndexKind, DataType>::impl {
                                         raft::linalg::NormType::L2Norm);
         }
 
-        auto device_bitset = std::optional<
-            cuvs::core::bitset<knowhere_bitset_internal_data_type, knowhere_bitset_internal_indexing_type>>{};
+        auto filter = std::shared_ptr<device_filter>{};
         if (bitset_data != nullptr && bitset_byte_size != 0) {
-            device_bitset =
-                cuvs::core::bitset<knowhere_bitset_internal_data_type, knowhere_bitset_internal_indexing_type>(
-                    res, bitset_size);
-            raft::copy(res,
-                       raft::make_device_vector_view<knowhere_bitset_data_type, knowhere_bitset_indexing_type>(
-                           reinterpret_cast<knowhere_bitset_data_type*>(device_bitset->data()), bitset_byte_size),
-                       raft::make_host_vector_view(bitset_data, bitset_byte_size));
-            if (device_bitset) {
-                device_bitset->flip(res);
-            }
+            filter = get_device_filter(res, config, bitset_data, bitset_byte_size, bitset_size);
+        }
+        RAFT_EXPECTS(index_, "Index has not yet been trained");
+        if (filter && filter->subset_index) {
+            return search_subset(res, *filter, raft::make_const_mdspan(device_data_storage.view()), k);
         }
 
         auto output_size = row_count * k;
@@ -502,15 +525,14 @@ struct cuvs_knowhere_index<IndexKind, DataType>::impl {
         auto device_ids = device_ids_storage.view();
         auto device_distances = device_distances_storage.view();
 
-        RAFT_EXPECTS(index_, "Index has not yet been trained");
         auto dataset_view = device_dataset_storage
                                 ? std::make_optional(device_dataset_storage->view())
                                 : std::optional<raft::device_matrix_view<const data_type, input_indexing_type>>{};
 
-        if (device_bitset) {
+        if (filter) {
             // cuVS is using uint32_t as filter datatype. Set the original nbits to knowhere's bitset data
             // type to make them compatible.
-            auto bitset_view = device_bitset->view();
+            auto bitset_view = filter->bitset.view();
             bitset_view.set_original_nbits(sizeof(knowhere_bitset_data_type) * 8);
             cuvs_index_type::search(
                 res, *index_, search_params, raft::make_const_mdspan(device_data_storage.view()), device_ids,
@@ -590,7 +612,26 @@ struct cuvs_knowhere_index<IndexKind, DataType>::impl {
         }
     }
 
-    auto static deserialize(std::istream& is) {
+    std::vector<std::uint32_t>
+    graph_to_host(std::int64_t& degree) const {
+        auto graph = std::vector<std::uint32_t>{};
+        degree = 0;
+        if constexpr (index_kind == cuvs_proto::cuvs_index_kind::cagra) {
+            auto scoped_device = raft::device_setter{device_id};
+            auto const& res = get_device_resources_without_mempool();
+            RAFT_EXPECTS(index_, "Index has not yet been trained");
+            auto device_graph = index_->get_vector_index().graph();
+            degree = device_graph.extent(1);
+            graph.resize(device_graph.size());
+            auto host_graph = raft::make_host_matrix_view<std::uint32_t, std::int64_t>(
+                graph.data(), device_graph.extent(0), device_graph.extent(1));
+            raft::copy(res, host_graph, device_graph);
+            res.sync_stream();
+        }
+        return graph;
+    }
+
+    auto static deserialize(std::istream& is, int device_id) {
         auto static device_count = []() {
             auto result = 0;
             RAFT_CUDA_TRY(cudaGetDeviceCount(&result));
@@ -598,15 +639,18 @@ struct cuvs_knowhere_index<IndexKind, DataType>::impl {
             return result;
         }();
         // The lazy allocation mode cannot completely eliminate uneven distribution, but it can alleviate it well.
-        int new_device_id = 0;
-        size_t free, total;
-        size_t max_free = 0;
-        for (int i = 0; i < device_count; ++i) {
-            auto scoped_device = raft::device_setter{i};
-            RAFT_CUDA_TRY(cudaMemGetInfo(&free, &total));
-            if (max_free < free) {
-                max_free = free;
-                new_device_id = i;
+        int new_device_id = device_id % device_count;
+        if (device_id < 0) {
+            new_device_id = 0;
+            size_t free, total;
+            size_t max_free = 0;
+            for (int i = 0; i < device_count; ++i) {
+                auto scoped_device = raft::device_setter{i};
+                RAFT_CUDA_TRY(cudaMemGetInfo(&free, &total));
+                if (max_free < free) {
+                    max_free = free;
+                    new_device_id = i;
+                }
             }
         }
         auto scoped_device = raft::device_setter{new_device_id};
@@ -646,9 +690,151 @@ struct cuvs_knowhere_index<IndexKind, DataType>::impl {
     }
 
  private:
+    using subset_index_type = cuvs_index_t<cuvs_proto::cuvs_index_kind::brute_force, data_type>;
+
+    // A bitset uploaded and flipped for cuVS. The searches with the filter_version of the cached one reuse it, as
+    //   the caller promises the bits of a version never change.
+    struct device_filter {
+        device_filter(raft::resources const& res, std::int64_t filter_version,
+                      knowhere_bitset_indexing_type bitset_size)
+            : version{filter_version}, size{bitset_size}, bitset{res, bitset_size} {
+        }
+        std::int64_t version;
+        knowhere_bitset_indexing_type size;
+        cuvs::core::bitset<knowhere_bitset_internal_data_type, knowhere_bitset_internal_indexing_type> bitset;
+        // when the filter keeps few rows, they are gathered from the cached dataset and searched by brute force
+        std::optional<raft::device_vector<knowhere_indexing_type, std::int64_t>> subset_ids = std::nullopt;
+        std::optional<raft::device_matrix<data_type, std::int64_t>> subset = std::nullopt;
+        std::optional<subset_index_type> subset_index = std::nullopt;
+    };
+
+    std::shared_ptr<device_filter>
+    get_device_filter(raft::resources const& res, cuvs_knowhere_config const& config,
+                      knowhere_bitset_data_type const* bitset_data, knowhere_bitset_indexing_type bitset_byte_size,
+                      knowhere_bitset_indexing_type bitset_size) const {
+        if (config.filter_version.has_value()) {
+            auto lock = std::lock_guard{filter_mutex};
+            if (cached_filter && cached_filter->version == *config.filter_version &&
+                cached_filter->size == bitset_size) {
+                return cached_filter;
+            }
+        }
+        auto filter = std::make_shared<device_filter>(res, config.filter_version.value_or(-1), bitset_size);
+        raft::copy(res,
+                   raft::make_device_vector_view<knowhere_bitset_data_type, knowhere_bitset_indexing_type>(
+                       reinterpret_cast<knowhere_bitset_data_type*>(filter->bitset.data()), bitset_byte_size),
+                   raft::make_host_vector_view(bitset_data, bitset_byte_size));
+        filter->bitset.flip(res);
+        compact_filter(res, config, *filter, bitset_data, bitset_size);
+        if (config.filter_version.has_value()) {
+            // the searches of other threads run on other streams
+            raft::resource::sync_stream(res);
+            auto lock = std::lock_guard{filter_mutex};
+            cached_filter = filter;
+        }
+        return filter;
+    }
+
+    // the same decision as WhetherPerformBruteForceSearch() on CPU: once nearly every row is filtered out, a brute
+    //   force over the rest is cheaper than a graph or IVF search that tests and drops candidates
+    void
+    compact_filter(raft::resources const& res, cuvs_knowhere_config const& config, device_filter& filter,
+                   knowhere_bitset_data_type const* bitset_data, knowhere_bitset_indexing_type bitset_size) const {
+        if constexpr (index_kind != cuvs_proto::cuvs_index_kind::brute_force &&
+                      (std::is_same_v<data_type, float> || std::is_same_v<data_type, half>)) {
+            if (!device_dataset_storage || bitset_size != size()) {
+                return;
+            }
+            auto valid_ids = std::vector<knowhere_indexing_type>{};
+            for (auto i = knowhere_bitset_indexing_type{}; i < bitset_size; ++i) {
+                if (!(bitset_data[i >> 3] & (1 << (i & 7)))) {
+                    valid_ids.push_back(i);
+                }
+                if (valid_ids.size() > bitset_size * (1.0f - kBruteForceFilterThreshold)) {
+                    return;
+                }
+            }
+            auto n_valid = std::int64_t(valid_ids.size());
+            if (n_valid == 0) {
+                return;
+            }
+            auto dim = std::int64_t(device_dataset_storage->extent(1));
+            filter.subset_ids = raft::make_device_vector<knowhere_indexing_type, std::int64_t>(res, n_valid);
+            raft::copy(res, filter.subset_ids->view(), raft::make_host_vector_view(valid_ids.data(), n_valid));
+            filter.subset = raft::make_device_matrix<data_type, std::int64_t>(res, n_valid, dim);
+            raft::matrix::gather(res,
+                                 raft::make_device_matrix_view<data_type const, std::int64_t>(
+                                     device_dataset_storage->data_handle(), std::int64_t(size()), dim),
+                                 raft::make_const_mdspan(filter.subset_ids->view()), filter.subset->view());
+            auto subset_config = config;
+            subset_config.index_type = cuvs_proto::cuvs_index_kind::brute_force;
+            filter.subset_index = subset_index_type::template build<data_type, std::int64_t, std::int64_t>(
+                res, config_to_index_params<cuvs_proto::cuvs_index_kind::brute_force>(subset_config),
+                raft::make_const_mdspan(filter.subset->view()));
+            // the copy from valid_ids is asynchronous
+            raft::resource::sync_stream(res);
+        }
+    }
+
+    auto
+    search_subset(raft::resources const& res, device_filter const& filter,
+                  raft::device_matrix_view<data_type const, input_indexing_type> queries,
+                  knowhere_indexing_type k) const {
+        auto row_count = std::int64_t(queries.extent(0));
+        auto n_valid = std::int64_t(filter.subset_ids->extent(0));
+        auto subset_k = std::min<std::int64_t>(k, n_valid);
+        auto max_distance =
+            std::nextafter(std::numeric_limits<knowhere_distance_type>::max(), knowhere_distance_type{0});
+
+        auto device_ids = raft::make_device_matrix<knowhere_indexing_type, std::int64_t>(res, row_count, k);
+        auto device_distances = raft::make_device_matrix<knowhere_distance_type, std::int64_t>(res, row_count, k);
+        auto subset_ids = raft::make_device_matrix<knowhere_indexing_type, std::int64_t>(res, row_count, subset_k);
+        auto subset_distances =
+            raft::make_device_matrix<knowhere_distance_type, std::int64_t>(res, row_count, subset_k);
+        subset_index_type::template search<data_type, knowhere_indexing_type, std::int64_t>(
+            res, *filter.subset_index, cuvs::neighbors::brute_force::search_params{},
+            raft::make_device_matrix_view<data_type const, std::int64_t>(queries.data_handle(), row_count,
+                                                                         queries.extent(1)),
+            subset_ids.view(), subset_distances.view());
+
+        auto policy = raft::resource::get_thrust_policy(res);
+        auto ids_begin = thrust::device_ptr<knowhere_indexing_type>(device_ids.data_handle());
+        auto distances_begin = thrust::device_ptr<knowhere_distance_type>(device_distances.data_handle());
+        thrust::fill(policy, ids_begin, ids_begin + device_ids.size(), knowhere_indexing_type{-1});
+        thrust::fill(policy, distances_begin, distances_begin + device_distances.size(), max_distance);
+        auto subset_ids_begin = thrust::device_ptr<knowhere_indexing_type>(subset_ids.data_handle());
+        thrust::transform(policy, subset_ids_begin, subset_ids_begin + subset_ids.size(), subset_ids_begin,
+                          detail::map_subset_id<knowhere_indexing_type>{filter.subset_ids->data_handle(), n_valid});
+        auto stream = raft::resource::get_cuda_stream(res);
+        RAFT_CUDA_TRY(cudaMemcpy2DAsync(device_ids.data_handle(), k * sizeof(knowhere_indexing_type),
+                                        subset_ids.data_handle(), subset_k * sizeof(knowhere_indexing_type),
+                                        subset_k * sizeof(knowhere_indexing_type), row_count,
+                                        cudaMemcpyDeviceToDevice, stream));
+        RAFT_CUDA_TRY(cudaMemcpy2DAsync(device_distances.data_handle(), k * sizeof(knowhere_distance_type),
+                                        subset_distances.data_handle(), subset_k * sizeof(knowhere_distance_type),
+                                        subset_k * sizeof(knowhere_distance_type), row_count,
+                                        cudaMemcpyDeviceToDevice, stream));
+
+        auto device_post_process = detail::check_valid_entry<knowhere_distance_type, knowhere_indexing_type>{
+            max_distance, knowhere_indexing_type(size())};
+        thrust::transform(policy, ids_begin, ids_begin + device_ids.size(), distances_begin,
+                          thrust::make_zip_iterator(thrust::make_tuple(ids_begin, distances_begin)),
+                          device_post_process);
+
+        auto output_size = row_count * k;
+        auto ids = std::unique_ptr<knowhere_indexing_type[]>(new knowhere_indexing_type[output_size]);
+        auto distances = std::unique_ptr<knowhere_distance_type[]>(new knowhere_distance_type[output_size]);
+        raft::copy(res, raft::make_host_matrix_view(ids.get(), row_count, std::int64_t(k)), device_ids.view());
+        raft::copy(res, raft::make_host_matrix_view(distances.get(), row_count, std::int64_t(k)),
+                   device_distances.view());
+        return std::make_tuple(ids.release(), distances.release());
+    }
+
     std::optional<cuvs_index_type> index_ = std::nullopt;
     int device_id = select_device_id();
     std::optional<raft::device_matrix<data_type, input_indexing_type>> device_dataset_storage = std::nullopt;
+    mutable std::mutex filter_mutex;
+    mutable std::shared_ptr<device_filter> cached_filter = nullptr;
 };
 
 template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
@@ -656,6 +842,11 @@ cuvs_knowhere_index<IndexKind, DataType>::cuvs_knowhere_index()
     : pimpl{new cuvs_knowhere_index<IndexKind, DataType>::impl()} {
 }
 
+template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
+cuvs_knowhere_index<IndexKind, DataType>::cuvs_knowhere_index(int device_id)
+    : pimpl{new cuvs_knowhere_index<IndexKind, DataType>::impl(device_id)} {
+}
+
 template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
 cuvs_knowhere_index<IndexKind, DataType>::~cuvs_knowhere_index<IndexKind, DataType>() = default;
 
@@ -689,6 +880,12 @@ cuvs_knowhere_index<IndexKind, DataType>::dim() const {
     return pimpl->dim();
 }
 
+template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
+int
+cuvs_knowhere_index<IndexKind, DataType>::device_id() const {
+    return pimpl->get_device_id();
+}
+
 template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
 void
 cuvs_knowhere_index<IndexKind, DataType>::train(cuvs_knowhere_config const& config, data_type const* data,
@@ -731,10 +928,17 @@ cuvs_knowhere_index<IndexKind, DataType>::serialize_to_hnswlib(std::ostream& os)
     return pimpl->serialize_to_hnswlib(os);
 }
 
+template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
+std::vector<std::uint32_t>
+cuvs_knowhere_index<IndexKind, DataType>::graph_to_host(std::int64_t& degree) const {
+    return pimpl->graph_to_host(degree);
+}
+
 template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
 cuvs_knowhere_index<IndexKind, DataType>
-cuvs_knowhere_index<IndexKind, DataType>::deserialize(std::istream& is) {
-    return cuvs_knowhere_index<IndexKind, DataType>(cuvs_knowhere_index<IndexKind, DataType>::impl::deserialize(is));
+cuvs_knowhere_index<IndexKind, DataType>::deserialize(std::istream& is, int device_id) {
+    return cuvs_knowhere_index<IndexKind, DataType>(
+        cuvs_knowhere_index<IndexKind, DataType>::impl::deserialize(is, device_id));
 }
 
 template <cuvs_proto::cuvs_index_kind IndexKind, typename DataType>
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "common/cuvs/integration/cuvs_knowhere_config.hpp"
 #include "common/cuvs/integration/type_mappers.hpp"
@@ -34,6 +35,8 @@ struct cuvs_knowhere_index {
     using input_indexing_type = cuvs_input_indexing_t<index_kind>;
 
     cuvs_knowhere_index();
+    // an index on the given device instead of the next one in round-robin
+    explicit cuvs_knowhere_index(int device_id);
     ~cuvs_knowhere_index();
 
     cuvs_knowhere_index(cuvs_knowhere_index&& other);
@@ -46,6 +49,8 @@ struct cuvs_knowhere_index {
     size() const;
     std::int64_t
     dim() const;
+    int
+    device_id() const;
     void
     train(cuvs_knowhere_config const&, data_type const*, knowhere_indexing_type, knowhere_indexing_type);
     std::tuple<knowhere_indexing_type*, knowhere_distance_type*>
@@ -61,8 +66,12 @@ struct cuvs_knowhere_index {
     serialize(std::ostream& os) const;
     void
     serialize_to_hnswlib(std::ostream& os) const;
+    // the neighbors of every row of a cagra graph, row by row, and the degree of the graph
+    std::vector<std::uint32_t>
+    graph_to_host(std::int64_t& degree) const;
+    // onto device_id, or the device with the most free memory if it is negative
     static cuvs_knowhere_index<IndexKind, DataType>
-    deserialize(std::istream& is);
+    deserialize(std::istream& is, int device_id = -1);
     void
     synchronize(bool is_without_mempool = false) const;
 
@@ -11,17 +11,85 @@
 
 #include "knowhere/prometheus_client.h"
 
+#include <stdexcept>
+
 namespace knowhere {
 
 const prometheus::Histogram::BucketBoundaries defaultBuckets = {1,     2,     4,     8,      16,     32,     64,
                                                                 128,   256,   512,   1024,   2048,   4096,   8192,
                                                                 16384, 32768, 65536, 131072, 262144, 524288, 1048576};
 
+// the phases of a search take from a few microseconds to seconds
+const prometheus::Histogram::BucketBoundaries phaseLatencyBuckets = {
+    0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 5000};
+
 const prometheus::Histogram::BucketBoundaries ratioBuckets = {
     0.0, 0.05, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35, 0.4, 0.45, 0.5, 0.55, 0.6, 0.65, 0.7, 0.75, 0.8, 0.85, 0.9, 0.95, 1.0};
 
 const std::unique_ptr<PrometheusClient> prometheusClient = std::make_unique<PrometheusClient>();
 
+size_t
+ThisThreadMetricShard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+ShardedCounter::ShardedCounter(prometheus::Counter& counter)
+    : counter_(counter), shards_(std::make_unique<Shard[]>(kMetricShards)) {
+    prometheusClient->Register(this);
+}
+
+ShardedCounter::~ShardedCounter() {
+    prometheusClient->Unregister(this);
+}
+
+void
+ShardedCounter::Flush() {
+    double value = 0.0;
+    for (size_t i = 0; i < kMetricShards; i++) {
+        value += shards_[i].value.exchange(0.0, std::memory_order_relaxed);
+    }
+    if (value != 0.0) {
+        counter_.Increment(value);
+    }
+}
+
+ShardedHistogram::ShardedHistogram(prometheus::Histogram& histogram,
+                                   const prometheus::Histogram::BucketBoundaries& buckets)
+    : histogram_(histogram), buckets_(buckets), shards_(std::make_unique<Shard[]>(kMetricShards)) {
+    if (buckets_.size() >= kMaxBuckets) {
+        throw std::invalid_argument("a sharded histogram has at most " + std::to_string(kMaxBuckets - 1) +
+                                    " bucket boundaries");
+    }
+    prometheusClient->Register(this);
+}
+
+ShardedHistogram::~ShardedHistogram() {
+    prometheusClient->Unregister(this);
+}
+
+void
+ShardedHistogram::Flush() {
+    // with the +Inf bucket
+    std::vector<double> increments(buckets_.size() + 1, 0.0);
+    double sum = 0.0;
+    uint64_t count = 0;
+    for (size_t i = 0; i < kMetricShards; i++) {
+        auto& shard = shards_[i];
+        for (size_t b = 0; b < increments.size(); b++) {
+            const uint64_t n = shard.counts[b].exchange(0, std::memory_order_relaxed);
+            increments[b] += n;
+            count += n;
+        }
+        sum += shard.sum.exchange(0.0, std::memory_order_relaxed);
+    }
+    // the sum of an observation whose count was drained by the previous flush is not dropped
+    if (count > 0 || sum != 0.0) {
+        histogram_.ObserveMultiple(increments, sum);
+    }
+}
+
 /*******************************************************************************
  * !!! NOT use SUMMARY metrics here, because when parse SUMMARY metrics in Milvus,
  *     see following error:
@@ -49,6 +117,32 @@ DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(ann_iterator_init_latency, "ann iterator init
 DEFINE_PROMETHEUS_HISTOGRAM(ann_iterator_init_latency, PROMETHEUS_LABEL_KNOWHERE)
 DEFINE_PROMETHEUS_HISTOGRAM(ann_iterator_init_latency, PROMETHEUS_LABEL_CARDINAL)
 
+DEFINE_PROMETHEUS_GAUGE_FAMILY(search_pool_pending_tasks, "pending tasks of the search thread pool")
+DEFINE_PROMETHEUS_GAUGE(search_pool_pending_tasks, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_GAUGE_FAMILY(search_pool_queue_wait, "average queue wait of the search thread pool tasks (ms)")
+DEFINE_PROMETHEUS_GAUGE(search_pool_queue_wait, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(search_phase_latency, "latency of the phases of a search by index type (ms)")
+
+DEFINE_PROMETHEUS_COUNTER_FAMILY(search_rejected, "number of searches rejected by an overloaded search thread pool")
+DEFINE_PROMETHEUS_COUNTER(search_rejected, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_COUNTER_FAMILY(search_plan_graph, "number of searches the search planner sent to a graph search")
+DEFINE_PROMETHEUS_COUNTER(search_plan_graph, PROMETHEUS_LABEL_KNOWHERE)
+DEFINE_PROMETHEUS_COUNTER_FAMILY(search_plan_ivf, "number of searches the search planner sent to an IVF scan")
+DEFINE_PROMETHEUS_COUNTER(search_plan_ivf, PROMETHEUS_LABEL_KNOWHERE)
+DEFINE_PROMETHEUS_COUNTER_FAMILY(search_plan_brute_force, "number of searches the search planner sent to a brute force")
+DEFINE_PROMETHEUS_COUNTER(search_plan_brute_force, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_GAUGE_FAMILY(warm_up_pending_size, "mapped index memory left to page in by the warm ups (MB)")
+DEFINE_PROMETHEUS_GAUGE(warm_up_pending_size, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_COUNTER_FAMILY(search_cache_hits, "number of searches served by the result cache of an index")
+DEFINE_PROMETHEUS_COUNTER(search_cache_hits, PROMETHEUS_LABEL_KNOWHERE)
+DEFINE_PROMETHEUS_COUNTER_FAMILY(search_cache_misses, "number of cacheable searches not found in the result cache")
+DEFINE_PROMETHEUS_COUNTER(search_cache_misses, PROMETHEUS_LABEL_KNOWHERE)
+
 DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(search_topk, "search topk")
 DEFINE_PROMETHEUS_HISTOGRAM(search_topk, PROMETHEUS_LABEL_KNOWHERE)
 DEFINE_PROMETHEUS_HISTOGRAM(search_topk, PROMETHEUS_LABEL_CARDINAL)
@@ -111,6 +205,15 @@ DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(hnsw_bitset_ratio, PROMETHEUS_LABEL_KNO
 DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(hnsw_search_hops, "HNSW search hops in layer 0")
 DEFINE_PROMETHEUS_HISTOGRAM(hnsw_search_hops, PROMETHEUS_LABEL_KNOWHERE)
 
+DEFINE_PROMETHEUS_COUNTER_FAMILY(hnsw_deleted_rows, "number of rows soft-deleted from HNSW indexes")
+DEFINE_PROMETHEUS_COUNTER(hnsw_deleted_rows, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_COUNTER_FAMILY(hnsw_reclaimed_rows, "number of deleted HNSW rows whose graph slots are reclaimed")
+DEFINE_PROMETHEUS_COUNTER(hnsw_reclaimed_rows, PROMETHEUS_LABEL_KNOWHERE)
+
+DEFINE_PROMETHEUS_GAUGE_FAMILY(hnsw_tombstone_size, "memory used by HNSW tombstones (MB)")
+DEFINE_PROMETHEUS_GAUGE(hnsw_tombstone_size, PROMETHEUS_LABEL_KNOWHERE)
+
 DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(diskann_bitset_ratio, "DISKANN bitset ratio for search and range search")
 DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(diskann_bitset_ratio, PROMETHEUS_LABEL_KNOWHERE, ratioBuckets)
 
@@ -122,7 +225,11 @@ DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(diskann_range_search_iters, "DISKANN range se
 DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(diskann_range_search_iters, PROMETHEUS_LABEL_KNOWHERE,
                                          diskannRangeSearchIterBuckets)
 
+DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(diskann_cache_hit_ratio, "DISKANN ratio of the visited nodes found in the cache")
+DEFINE_PROMETHEUS_HISTOGRAM_WITH_BUCKETS(diskann_cache_hit_ratio, PROMETHEUS_LABEL_KNOWHERE, ratioBuckets)
+
 DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(sparse_dataset_nnz_len, "sparse dataset nnz length")
 DEFINE_PROMETHEUS_HISTOGRAM_FAMILY(sparse_inverted_index_posting_list_len, "sparse inverted index posting list length")
 DEFINE_PROMETHEUS_GAUGE_FAMILY(sparse_inverted_index_size, "sparse inverted index size (MB)")
+DEFINE_PROMETHEUS_GAUGE_FAMILY(index_memory_size, "memory of an index by section (MB)")
 }  // namespace knowhere
@@ -18,6 +18,7 @@
 #include <tuple>
 #include <vector>
 
+#include "knowhere/comp/thread_pool.h"
 #include "knowhere/log.h"
 namespace knowhere {
 
@@ -65,12 +66,36 @@ GetRangeSearchResult(const std::vector<std::vector<float>>& result_distances,
     LOG_KNOWHERE_DEBUG_ << "Range search: is_ip " << (is_ip ? "True" : "False") << ", radius " << radius
                         << ", range_filter " << range_filter << ", total result num " << total_valid;
 
-    auto distances = std::make_unique<float[]>(total_valid);
-    auto labels = std::make_unique<int64_t[]>(total_valid);
+    // not value initialized, every element is written below
+    auto distances = std::unique_ptr<float[]>(new float[total_valid]);
+    auto labels = std::unique_ptr<int64_t[]>(new int64_t[total_valid]);
 
-    for (auto i = 0; i < nq; i++) {
-        std::copy_n(result_distances[i].data(), lims[i + 1] - lims[i], distances.get() + lims[i]);
-        std::copy_n(result_labels[i].data(), lims[i + 1] - lims[i], labels.get() + lims[i]);
+    auto copy_queries = [&](int64_t begin, int64_t end) {
+        for (auto i = begin; i < end; i++) {
+            std::copy_n(result_distances[i].data(), lims[i + 1] - lims[i], distances.get() + lims[i]);
+            std::copy_n(result_labels[i].data(), lims[i + 1] - lims[i], labels.get() + lims[i]);
+        }
+    };
+    if (total_valid < kParallelRangeResultSize || nq < 2) {
+        copy_queries(0, nq);
+    } else {
+        // the queries are split by the number of results they hold, not by count
+        auto pool = NestedSearchThreadPool();
+        const size_t num_tasks =
+            std::max<size_t>(1, std::min<size_t>({static_cast<size_t>(nq), ThreadPool::GetGlobalSearchThreadPoolSize(),
+                                                  total_valid / (kParallelRangeResultSize / 4)}));
+        std::vector<folly::Future<folly::Unit>> futs;
+        futs.reserve(num_tasks);
+        int64_t begin = 0;
+        for (size_t t = 1; t <= num_tasks; t++) {
+            const size_t until = total_valid * t / num_tasks;
+            const int64_t end = t == num_tasks ? nq : std::lower_bound(lims.get(), lims.get() + nq, until) - lims.get();
+            if (end > begin) {
+                futs.emplace_back(pool.push([&, begin, end]() { copy_queries(begin, end); }));
+                begin = end;
+            }
+        }
+        WaitAllSuccess(futs);
     }
 
     return RangeSearchResult{.distances = std::move(distances), .labels = std::move(labels), .lims = std::move(lims)};
@@ -19,6 +19,7 @@
 #include "faiss/impl/FaissException.h"
 #include "faiss/index_io.h"
 #include "io/memory_io.h"
+#include "knowhere/comp/search_arena.h"
 #include "knowhere/log.h"
 #include "simd/hook.h"
 
@@ -102,6 +103,17 @@ CopyAndNormalizeVecs(const DataType* x, size_t rows, int32_t dim) {
     return x_normalized;
 }
 
+template <typename DataType>
+const DataType*
+CopyAndNormalizeVecsInArena(const DataType* x, size_t rows, int32_t dim) {
+    auto x_normalized = SearchArena::Local().Allocate<DataType>(rows * dim);
+    std::copy_n(x, rows * dim, x_normalized);
+    for (size_t i = 0; i < rows; i++) {
+        NormalizeVec(x_normalized + i * dim, dim);
+    }
+    return x_normalized;
+}
+
 template <typename DataType>
 void
 NormalizeDataset(const DataSetPtr dataset) {
@@ -214,6 +226,13 @@ CopyAndNormalizeVecs(const fp16* x, size_t rows, int32_t dim);
 template std::unique_ptr<bf16[]>
 CopyAndNormalizeVecs(const bf16* x, size_t rows, int32_t dim);
 
+template const fp32*
+CopyAndNormalizeVecsInArena(const fp32* x, size_t rows, int32_t dim);
+template const fp16*
+CopyAndNormalizeVecsInArena(const fp16* x, size_t rows, int32_t dim);
+template const bf16*
+CopyAndNormalizeVecsInArena(const bf16* x, size_t rows, int32_t dim);
+
 template void
 NormalizeDataset<fp32>(const DataSetPtr dataset);
 template void
@@ -0,0 +1,55 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "knowhere/comp/thread_pool.h"
+
+namespace knowhere {
+
+// the rows of a batch of a bulk GetVectorByIds(), a request of at most this many rows is read on the calling thread
+constexpr int64_t kBulkGetVectorBatchSize = 256;
+
+// Reads the rows of a GetVectorByIds() in the order they are stored in rather than in the order they are requested
+//   in, so that the rows sharing a page are read together, and the batches of them in parallel on the search thread
+//   pool. positions[i] is where the i-th requested row is stored, in any type that orders the storage.
+//   read_batch(rows, n) reads the requested rows rows[0..n), which are in storage order, and writes every one to its
+//   place in the result, so that the result keeps the request order.
+template <typename Position, typename ReadBatch>
+void
+ReadRowsInStorageOrder(const std::vector<Position>& positions, ReadBatch&& read_batch) {
+    const int64_t rows = positions.size();
+    std::vector<int64_t> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) { return positions[a] < positions[b]; });
+    if (rows <= kBulkGetVectorBatchSize) {
+        read_batch(order.data(), rows);
+        return;
+    }
+
+    auto search_pool = ThreadPool::GetGlobalSearchThreadPool();
+    std::vector<folly::Future<folly::Unit>> futures;
+    futures.reserve((rows + kBulkGetVectorBatchSize - 1) / kBulkGetVectorBatchSize);
+    for (int64_t begin = 0; begin < rows; begin += kBulkGetVectorBatchSize) {
+        futures.emplace_back(search_pool->push([&, begin]() {
+            ThreadPool::ScopedSearchOmpSetter setter(1);
+            read_batch(order.data() + begin, std::min(kBulkGetVectorBatchSize, rows - begin));
+        }));
+    }
+    WaitAllSuccess(futures);
+}
+
+}  // namespace knowhere
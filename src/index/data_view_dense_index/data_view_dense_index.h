@@ -43,11 +43,13 @@ DataViewIndexBase only keep index meta and data codes(!= raw data) in memory.
 class DataViewIndexBase {
  public:
     DataViewIndexBase(idx_t d, DataFormatEnum data_type, MetricType metric_type, ViewDataOp view, bool is_cosine,
-                      RefineType refine_type, std::optional<int> build_thread_num)
+                      RefineType refine_type, std::optional<int> build_thread_num, ViewDataBatchOp batch_view = nullptr,
+                      RefineType pre_refine_type = RefineType::DATA_VIEW)
         : d_(d),
           data_type_(data_type),
           metric_type_(metric_type),
           view_data_(view),
+          batch_view_data_(batch_view),
           is_cosine_(is_cosine),
           refine_type_(refine_type),
           build_thread_num_(build_thread_num) {
@@ -74,6 +76,14 @@ class DataViewIndexBase {
         } else {
             quant_data_ = nullptr;
         }
+        if (pre_refine_type != RefineType::DATA_VIEW) {
+            if ((pre_refine_type == RefineType::BFLOAT16_QUANT && data_type == DataFormatEnum::fp16) ||
+                (pre_refine_type == RefineType::FLOAT16_QUANT && data_type == DataFormatEnum::bf16)) {
+                throw std::runtime_error(
+                    "Type fp16 can't use BFLOAT16_QUANT to pre refine or bf16 can't use FLOAT16_QUANT to pre refine.");
+            }
+            pre_quant_data_ = std::make_shared<QuantRefine>(d, data_type_, pre_refine_type, metric_type_);
+        }
     }
     virtual ~DataViewIndexBase(){};
 
@@ -102,6 +112,14 @@ class DataViewIndexBase {
                   const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist, idx_t* __restrict out_ids,
                   const bool use_quant) const = 0;
 
+    /** Knn Search on set of vectors with the pre refine quant data, which shrinks the candidates cheaply
+     * before SearchWithIds, the parameters are the same
+     */
+    virtual void
+    PreRefineSearchWithIds(const idx_t n, const void* __restrict x, const idx_t* __restrict ids_num_lims,
+                           const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist,
+                           idx_t* __restrict out_ids) const = 0;
+
     virtual RangeSearchResult
     RangeSearch(const idx_t n, const void* __restrict x, const float radius, const float range_filter,
                 const BitsetView& bitset, const bool use_quant) const = 0;
@@ -152,30 +170,40 @@ class DataViewIndexBase {
     GetQuantData() const {
         return quant_data_;
     }
+    bool
+    HasPreRefine() const {
+        return pre_quant_data_ != nullptr;
+    }
 
  protected:
     int d_;
     DataFormatEnum data_type_;
     MetricType metric_type_;
     ViewDataOp view_data_;
+    // null when the view has no batched op
+    ViewDataBatchOp batch_view_data_;
     bool is_cosine_;
     int code_size_;
     std::atomic<idx_t> ntotal_ = 0;
     RefineType refine_type_;
     std::shared_ptr<QuantRefine> quant_data_ = nullptr;
+    // a cheaper quant data scored before the refine, null without a pre refine
+    std::shared_ptr<QuantRefine> pre_quant_data_ = nullptr;
     std::optional<int> build_thread_num_ = std::nullopt;
 };
 
 class DataViewIndexFlat : public DataViewIndexBase {
  public:
     DataViewIndexFlat(idx_t d, DataFormatEnum data_type, MetricType metric_type, ViewDataOp view, bool is_cosine,
-                      RefineType refine_type, std::optional<int> build_thread_num = std::nullopt)
-        : DataViewIndexBase(d, data_type, metric_type, view, is_cosine, refine_type, build_thread_num) {
+                      RefineType refine_type, std::optional<int> build_thread_num = std::nullopt,
+                      ViewDataBatchOp batch_view = nullptr, RefineType pre_refine_type = RefineType::DATA_VIEW)
+        : DataViewIndexBase(d, data_type, metric_type, view, is_cosine, refine_type, build_thread_num, batch_view,
+                            pre_refine_type) {
         this->ntotal_.store(0);
     }
     void
     Train(idx_t n, const void* x, bool use_knowhere_build_pool) override {
-        if (quant_data_ != nullptr) {
+        if (quant_data_ != nullptr || pre_quant_data_ != nullptr) {
             auto build_pool_wrapper =
                 std::make_shared<ThreadPoolWrapper>(ThreadPool::GetGlobalBuildThreadPool(), use_knowhere_build_pool);
             auto task = build_pool_wrapper
@@ -187,7 +215,12 @@ class DataViewIndexFlat : public DataViewIndexBase {
                                 } else {
                                     setter = std::make_unique<ThreadPool::ScopedBuildOmpSetter>();
                                 }
-                                quant_data_->Train(x, n);
+                                if (quant_data_ != nullptr) {
+                                    quant_data_->Train(x, n);
+                                }
+                                if (pre_quant_data_ != nullptr) {
+                                    pre_quant_data_->Train(x, n);
+                                }
                             })
                             .getTry();
             if (task.hasException()) {
@@ -199,7 +232,7 @@ class DataViewIndexFlat : public DataViewIndexBase {
 
     void
     Add(idx_t n, const void* x, const float* __restrict in_norms, bool use_knowhere_build_pool) override {
-        if (quant_data_ != nullptr) {
+        if (quant_data_ != nullptr || pre_quant_data_ != nullptr) {
             auto build_pool_wrapper =
                 std::make_shared<ThreadPoolWrapper>(ThreadPool::GetGlobalBuildThreadPool(), use_knowhere_build_pool);
             auto task = build_pool_wrapper
@@ -213,7 +246,12 @@ class DataViewIndexFlat : public DataViewIndexBase {
                                 }
                                 std::vector<idx_t> ids(n);
                                 std::iota(ids.begin(), ids.end(), ntotal_.load());
-                                quant_data_->Add(x, ids.data(), n);
+                                if (quant_data_ != nullptr) {
+                                    quant_data_->Add(x, ids.data(), n);
+                                }
+                                if (pre_quant_data_ != nullptr) {
+                                    pre_quant_data_->Add(x, ids.data(), n);
+                                }
                             })
                             .getTry();
             if (task.hasException()) {
@@ -249,6 +287,11 @@ class DataViewIndexFlat : public DataViewIndexBase {
                   const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist, idx_t* __restrict out_ids,
                   const bool use_quant) const override;
 
+    void
+    PreRefineSearchWithIds(const idx_t n, const void* __restrict x, const idx_t* __restrict ids_num_lims,
+                           const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist,
+                           idx_t* __restrict out_ids) const override;
+
     RangeSearchResult
     RangeSearch(const idx_t n, const void* __restrict x, const float radius, const float range_filter,
                 const BitsetView& bitset, const bool use_quant) const override;
@@ -288,9 +331,15 @@ class DataViewIndexFlat : public DataViewIndexBase {
  protected:
     template <class SingleResultHandler, class SelectorHelper>
     void
-    exhaustive_search_in_one_query_impl(const std::unique_ptr<faiss::DistanceComputer>& computer, size_t ny,
+    exhaustive_search_in_one_query_impl(const std::unique_ptr<RefineDistanceComputer>& computer, size_t ny,
                                         SingleResultHandler& resi, const SelectorHelper& selector) const;
 
+    // the top k of the candidates of every query, scored with quant, or the raw data when it is null
+    void
+    search_with_ids_impl(const idx_t n, const void* __restrict x, const idx_t* __restrict ids_num_lims,
+                         const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist,
+                         idx_t* __restrict out_ids, const std::shared_ptr<QuantRefine>& quant) const;
+
  protected:
     std::vector<float> norms_;  // vector norms will be populated if is_cosine_ == true
     mutable std::shared_mutex norms_mutex_;
@@ -298,7 +347,7 @@ class DataViewIndexFlat : public DataViewIndexBase {
 
 template <class SingleResultHandler, class SelectorHelper>
 void
-DataViewIndexFlat::exhaustive_search_in_one_query_impl(const std::unique_ptr<faiss::DistanceComputer>& computer,
+DataViewIndexFlat::exhaustive_search_in_one_query_impl(const std::unique_ptr<RefineDistanceComputer>& computer,
                                                        size_t ny, SingleResultHandler& resi,
                                                        const SelectorHelper& selector) const {
     auto filter = [&selector](const size_t j) { return selector.is_member(j); };
@@ -411,6 +460,23 @@ void
 DataViewIndexFlat::SearchWithIds(const idx_t n, const void* __restrict x, const idx_t* __restrict ids_num_lims,
                                  const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist,
                                  idx_t* __restrict out_ids, const bool use_quant) const {
+    search_with_ids_impl(n, x, ids_num_lims, ids, k, out_dist, out_ids, use_quant ? quant_data_ : nullptr);
+}
+
+void
+DataViewIndexFlat::PreRefineSearchWithIds(const idx_t n, const void* __restrict x,
+                                          const idx_t* __restrict ids_num_lims, const idx_t* __restrict ids,
+                                          const idx_t k, float* __restrict out_dist, idx_t* __restrict out_ids) const {
+    if (pre_quant_data_ == nullptr) {
+        throw std::runtime_error("pre refine search on a data view index without pre refine.");
+    }
+    search_with_ids_impl(n, x, ids_num_lims, ids, k, out_dist, out_ids, pre_quant_data_);
+}
+
+void
+DataViewIndexFlat::search_with_ids_impl(const idx_t n, const void* __restrict x, const idx_t* __restrict ids_num_lims,
+                                        const idx_t* __restrict ids, const idx_t k, float* __restrict out_dist,
+                                        idx_t* __restrict out_ids, const std::shared_ptr<QuantRefine>& quant) const {
     const auto& search_pool = ThreadPool::GetGlobalSearchThreadPool();
     std::vector<folly::Future<folly::Unit>> futs;
     futs.reserve(n);
@@ -428,7 +494,10 @@ DataViewIndexFlat::SearchWithIds(const idx_t n, const void* __restrict x, const
             auto x_i = (const char*)x + code_size_ * i;
 
             assert(base_n >= k);
-            ComputeDistanceSubset(x_i, base_n, base_dist.get(), base_ids, use_quant);
+            auto computer =
+                SelectDataViewComputer(view_data_, data_type_, metric_type_, d_, is_cosine_, quant, batch_view_data_);
+            computer->set_query((const float*)(x_i));
+            computer->distances_by_ids(base_ids, base_n, base_dist.get());
             if (is_cosine_) {
                 std::shared_lock lock(norms_mutex_);
                 for (auto j = 0; j < base_n; j++) {
@@ -583,15 +652,10 @@ DataViewIndexFlat::RangeSearchWithIds(const idx_t n, const void* __restrict x, c
 void
 DataViewIndexFlat::ComputeDistanceSubset(const void* __restrict x, const idx_t sub_y_n, float* x_y_distances,
                                          const idx_t* __restrict x_y_labels, const bool use_quant) const {
-    auto computer =
-        SelectDataViewComputer(view_data_, data_type_, metric_type_, d_, is_cosine_, use_quant ? quant_data_ : nullptr);
+    auto computer = SelectDataViewComputer(view_data_, data_type_, metric_type_, d_, is_cosine_,
+                                           use_quant ? quant_data_ : nullptr, batch_view_data_);
 
     computer->set_query((const float*)(x));
-    const idx_t* __restrict idsj = x_y_labels;
-    float* __restrict disj = x_y_distances;
-
-    auto filter = [=](const size_t i) { return (idsj[i] >= 0); };
-    auto apply = [=](const float dis, const size_t i) { disj[i] = dis; };
-    distance_compute_by_idx_if(idsj, sub_y_n, computer.get(), filter, apply);
+    computer->distances_by_ids(x_y_labels, sub_y_n, x_y_distances);
 }
 }  // namespace knowhere
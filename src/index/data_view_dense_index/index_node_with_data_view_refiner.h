@@ -11,12 +11,18 @@
 #ifndef INDEX_NODE_WITH_DATA_VIEW_REFINER_H
 #define INDEX_NODE_WITH_DATA_VIEW_REFINER_H
 #include <atomic>
+#include <cmath>
+#include <cstring>
 #include <random>
 
 #include "faiss/utils/random.h"
+#include "index/bulk_get_vector.h"
 #include "index/data_view_dense_index/data_view_dense_index.h"
 #include "index/data_view_dense_index/data_view_index_config.h"
 #include "knowhere/comp/rw_lock.h"
+#include "knowhere/comp/search_phases.h"
+#include "knowhere/comp/time_recorder.h"
+#include "knowhere/comp/warm_up.h"
 #include "knowhere/index/index_node.h"
 namespace knowhere {
 struct DataViewIndexFlat;
@@ -26,6 +32,8 @@ This kind of index will not keep raw data anymore, so init it with a get raw dat
 And it maintain a basic index (code size < raw data size) and a refiner.
 If metric == Cosine, base index will normalize all vectors, and replaced with Inner product;
 refine_index will compute the IP distances, and divide by ||x|| and ||y||.
+With a pre_refine_type, the knn search scores the base candidates with that cheaper quant data first, and only
+the pre_refine_ratio * k best of them get the refine.
 
 todo: basic index use fp32, we should support more type later.
 */
@@ -35,9 +43,14 @@ class IndexNodeWithDataViewRefiner : public IndexNode {
 
  public:
     IndexNodeWithDataViewRefiner(const int32_t& version, const Object& object) {
-        auto data_view_index_pack = dynamic_cast<const Pack<ViewDataOp>*>(&object);
-        assert(data_view_index_pack != nullptr);
-        view_data_op_ = data_view_index_pack->GetPack();
+        if (auto data_view_ops_pack = dynamic_cast<const Pack<ViewDataOps>*>(&object)) {
+            view_data_op_ = data_view_ops_pack->GetPack().view;
+            view_data_batch_op_ = data_view_ops_pack->GetPack().batch_view;
+        } else {
+            auto data_view_index_pack = dynamic_cast<const Pack<ViewDataOp>*>(&object);
+            assert(data_view_index_pack != nullptr);
+            view_data_op_ = data_view_index_pack->GetPack();
+        }
         base_index_ = std::make_unique<BaseIndexNode>(version, nullptr);
         base_index_lock_ = std::make_unique<FairRWLock>();
     }
@@ -58,10 +71,9 @@ class IndexNodeWithDataViewRefiner : public IndexNode {
     AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
                 bool use_knowhere_search_pool) const override;
 
+    // copies the rows out of the data view, which still owns them, so HasRawData() stays false
     expected<DataSetPtr>
-    GetVectorByIds(const DataSetPtr dataset) const override {
-        return expected<DataSetPtr>::Err(Status::not_implemented, "Data View Index not maintain raw data.");
-    }
+    GetVectorByIds(const DataSetPtr dataset) const override;
 
     static Status
     StaticConfigCheck(const Config& cfg, PARAM_TYPE paramType, std::string& msg) {
@@ -214,6 +226,22 @@ class IndexNodeWithDataViewRefiner : public IndexNode {
             }
         }
 
+        // Next() is overridden, so IndexIterator::NextBatch() does not apply
+        size_t
+        NextBatch(size_t n, int64_t* ids, float* dists) override {
+            if (!initialized_) {
+                initialize();
+            }
+            if (!refine_) {
+                return base_workspace_->NextBatch(n, ids, dists);
+            }
+            size_t count = 0;
+            for (; count < n && HasNext(); count++) {
+                std::tie(ids[count], dists[count]) = Next();
+            }
+            return count;
+        }
+
         [[nodiscard]] bool
         HasNext() override {
             if (!initialized_) {
@@ -270,6 +298,7 @@ class IndexNodeWithDataViewRefiner : public IndexNode {
     };
     bool is_cosine_;
     ViewDataOp view_data_op_;
+    ViewDataBatchOp view_data_batch_op_ = nullptr;
     std::shared_ptr<DataViewIndexFlat>
         refine_offset_index_;                // a data view flat index to maintain raw data without extra memory
     std::unique_ptr<IndexNode> base_index_;  // base_index will hold data codes in memory, datatype is fp32
@@ -314,6 +343,7 @@ IndexNodeWithDataViewRefiner<DataType, BaseIndexNode>::Train(const DataSetPtr da
     auto train_rows = dataset->GetRows();
     auto data = dataset->GetTensor();
     auto refine_type = (knowhere::RefineType)(base_cfg.refine_type.value());
+    auto pre_refine_type = (knowhere::RefineType)(base_cfg.pre_refine_type.value());
     // construct refiner
     auto refine_metric = is_cosine_ ? metric::IP : base_cfg.metric_type.value();
     // construct quant index and train:
@@ -325,7 +355,8 @@ IndexNodeWithDataViewRefiner<DataType, BaseIndexNode>::Train(const DataSetPtr da
     auto [fp32_train_ds, _] =
         ConvertToBaseIndexFp32DataSet<DataType>(dataset, this->is_cosine_, 0, train_rows, base_index_dim);
     refine_offset_index_ = std::make_unique<DataViewIndexFlat>(
-        dim, datatype_v<DataType>, refine_metric, this->view_data_op_, is_cosine_, refine_type, build_thread_num);
+        dim, datatype_v<DataType>, refine_metric, this->view_data_op_, is_cosine_, refine_type, build_thread_num,
+        this->view_data_batch_op_, pre_refine_type);
     try {
         refine_offset_index_->Train(train_rows, data, use_knowhere_build_pool);
     } catch (const std::exception& e) {
@@ -381,6 +412,8 @@ IndexNodeWithDataViewRefiner<DataType, BaseIndexNode>::Search(const DataSetPtr d
     auto dim = dataset->GetDim();
     auto topk = base_cfg.k.value();
     auto refine_with_quant = base_cfg.refine_with_quant.value();
+    auto pre_refine_ratio = base_cfg.pre_refine_ratio.value();
+    TimeRecorder rc("data view refine search", 1);
     // basic search
     AdaptToBaseIndexConfig(cfg.get(), PARAM_TYPE::SEARCH, dim);
     auto base_index_ds = std::get<0>(
@@ -393,25 +426,94 @@ IndexNodeWithDataViewRefiner<DataType, BaseIndexNode>::Search(const DataSetPtr d
     if (!quant_res.has_value()) {
         return quant_res;
     }
-    // refine
-    auto queries_lims = std::vector<idx_t>(nq + 1);
     auto reorder_k = quant_res.value()->GetDim();
-    for (auto i = 0; i < nq + 1; i++) {
-        queries_lims[i] = reorder_k * i;
-    }
+    rc.RecordSection("base search, " + std::to_string(reorder_k) + " candidates per query");
+    // refine, in stages that each keep fewer candidates per query
+    auto queries_lims = std::vector<idx_t>(nq + 1);
     auto refine_ids = quant_res.value()->GetIds();
     auto labels = std::make_unique<int64_t[]>(nq * topk);
     auto distances = std::make_unique<float[]>(nq * topk);
     try {
+        ScopedSearchPhase phase(SearchPhase::REFINE);
+        auto pre_refine_k = std::max<int64_t>(topk, std::ceil(topk * pre_refine_ratio));
+        std::unique_ptr<int64_t[]> pre_refine_ids = nullptr;
+        if (refine_offset_index_->HasPreRefine() && pre_refine_k < reorder_k) {
+            for (auto i = 0; i < nq + 1; i++) {
+                queries_lims[i] = reorder_k * i;
+            }
+            pre_refine_ids = std::make_unique<int64_t[]>(nq * pre_refine_k);
+            auto pre_refine_dist = std::make_unique<float[]>(nq * pre_refine_k);
+            refine_offset_index_->PreRefineSearchWithIds(nq, dataset->GetTensor(), queries_lims.data(), refine_ids,
+                                                         pre_refine_k, pre_refine_dist.get(), pre_refine_ids.get());
+            rc.RecordSection("pre refine, " + std::to_string(pre_refine_k) + " candidates per query");
+            refine_ids = pre_refine_ids.get();
+            reorder_k = pre_refine_k;
+        }
+        for (auto i = 0; i < nq + 1; i++) {
+            queries_lims[i] = reorder_k * i;
+        }
         refine_offset_index_->SearchWithIds(nq, dataset->GetTensor(), queries_lims.data(), refine_ids, topk,
                                             distances.get(), labels.get(), refine_with_quant);
+        rc.RecordSection("refine, " + std::to_string(topk) + " results per query");
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "data view index inner error: " << e.what();
         return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
     }
+    rc.ElapseFromBegin("done, " + std::to_string(nq) + " queries");
     return GenResultDataSet(nq, topk, std::move(labels), std::move(distances));
 }
 
+template <typename DataType, typename BaseIndexNode>
+expected<DataSetPtr>
+IndexNodeWithDataViewRefiner<DataType, BaseIndexNode>::GetVectorByIds(const DataSetPtr dataset) const {
+    if (this->refine_offset_index_ == nullptr) {
+        return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+    }
+    auto dim = Dim();
+    auto rows = dataset->GetRows();
+    auto ids = dataset->GetIds();
+    const auto count = refine_offset_index_->Count();
+    for (int64_t i = 0; i < rows; i++) {
+        if (ids[i] < 0 || ids[i] >= count) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "GetVectorByIds failed: id out of range");
+        }
+    }
+
+    // the rows of the view are stored in the order of their ids, a batch resolves them with one call of the batched
+    // view if there is one, and asks the kernel for their pages before it copies them
+    auto data = std::make_unique<DataType[]>(dim * rows);
+    const size_t row_size = sizeof(DataType) * dim;
+    std::vector<int64_t> positions(ids, ids + rows);
+    try {
+        ReadRowsInStorageOrder(positions, [&](const int64_t* batch, const int64_t n) {
+            std::vector<int64_t> batch_ids(n);
+            for (int64_t j = 0; j < n; j++) {
+                batch_ids[j] = ids[batch[j]];
+            }
+            std::vector<const void*> rows_data(n);
+            if (view_data_batch_op_ != nullptr) {
+                view_data_batch_op_(batch_ids.data(), n, rows_data.data());
+            } else {
+                for (int64_t j = 0; j < n; j++) {
+                    rows_data[j] = view_data_op_(batch_ids[j]);
+                }
+            }
+            std::vector<MappedRegion> regions(n);
+            for (int64_t j = 0; j < n; j++) {
+                regions[j] = MappedRegion{rows_data[j], row_size, false};
+            }
+            AdviseWillNeed(regions);
+            for (int64_t j = 0; j < n; j++) {
+                std::memcpy(data.get() + batch[j] * dim, rows_data[j], row_size);
+            }
+        });
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "data view inner error: " << e.what();
+        return expected<DataSetPtr>::Err(Status::invalid_args, "GetVectorByIds failed: " + std::string(e.what()));
+    }
+    return GenResultDataSet(rows, dim, std::move(data));
+}
+
 template <typename DataType, typename BaseIndexNode>
 expected<DataSetPtr>
 IndexNodeWithDataViewRefiner<DataType, BaseIndexNode>::RangeSearch(const DataSetPtr dataset,
@@ -15,6 +15,8 @@
 #include "faiss/impl/DistanceComputer.h"
 #include "faiss/impl/ScalarQuantizer.h"
 #include "faiss/invlists/InvertedLists.h"
+#include "faiss/utils/distances_if.h"
+#include "faiss/utils/prefetch.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/object.h"
 #include "knowhere/operands.h"
@@ -65,6 +67,9 @@ struct QuantRefine {
             case RefineType::UINT8_QUANT:
                 quantizer = new faiss::ScalarQuantizer(d, faiss::ScalarQuantizer::QuantizerType::QT_8bit);
                 break;
+            case RefineType::UINT4_QUANT:
+                quantizer = new faiss::ScalarQuantizer(d, faiss::ScalarQuantizer::QuantizerType::QT_4bit);
+                break;
             case RefineType::BFLOAT16_QUANT:
                 quantizer = new faiss::ScalarQuantizer(d, faiss::ScalarQuantizer::QuantizerType::QT_bf16);
                 break;
@@ -90,20 +95,26 @@ struct QuantRefine {
         }
     }
 
+    // the batch is encoded in place in the storage, in parallel over its segments, and becomes visible at once.
+    // Adds must not run concurrently.
     void
     Add(const void* data, const idx_t* ids, const size_t n) {
-        auto codes = std::make_unique<uint8_t[]>(n * quantizer->code_size);
-        if (origin_data_type == DataFormatEnum::fp32) {
-            quantizer->compute_codes((const float*)data, codes.get(), n);
-            storage->add_entries(key, n, ids, codes.get());
-        } else {
-            auto fp32_x = std::unique_ptr<float[]>(new float[n * quantizer->d]);
-            if (convert_data(data, fp32_x.get(), origin_data_type, n, quantizer->d) != true) {
-                throw std::runtime_error("fail to convert data to fp32 type.");
+        const size_t d = quantizer->d;
+        const size_t data_size = origin_data_type == DataFormatEnum::fp32   ? sizeof(fp32)
+                                 : origin_data_type == DataFormatEnum::fp16 ? sizeof(fp16)
+                                                                            : sizeof(bf16);
+        auto encode = [&](size_t i0, size_t i1, uint8_t* codes) {
+            const auto x = (const char*)data + i0 * d * data_size;
+            if (origin_data_type == DataFormatEnum::fp32) {
+                quantizer->compute_codes((const float*)x, codes, i1 - i0);
+                return;
             }
-            quantizer->compute_codes(fp32_x.get(), codes.get(), n);
-            storage->add_entries(key, n, ids, codes.get());
-        }
+            // fp16 or bf16, the data view index rejects the other types. Nothing may throw in the parallel encode.
+            auto fp32_x = std::unique_ptr<float[]>(new float[(i1 - i0) * d]);
+            convert_data(x, fp32_x.get(), origin_data_type, i1 - i0, d);
+            quantizer->compute_codes(fp32_x.get(), codes, i1 - i0);
+        };
+        storage->append_entries(key, n, ids, encode);
     }
 
     const uint8_t*
@@ -138,15 +149,26 @@ struct QuantRefine {
     static constexpr size_t list_num = 1;
     static constexpr size_t segment_size = 48;
     faiss::ScalarQuantizer* quantizer = nullptr;
-    faiss::InvertedLists* storage = nullptr;
+    faiss::ConcurrentArrayInvertedLists* storage = nullptr;
     faiss::MetricType metric_type;
     DataFormatEnum origin_data_type;
     RefineType refine_type;
 };
 
+// the refine computers, which also score the candidates of a query all at once
+struct RefineDistanceComputer : faiss::DistanceComputer {
+    // writes the distances to the vectors of the n ids to dis, the negative ids are skipped
+    virtual void
+    distances_by_ids(const idx_t* ids, const size_t n, float* dis) {
+        auto filter = [ids](const size_t i) { return ids[i] >= 0; };
+        auto apply = [dis](const float d, const size_t i) { dis[i] = d; };
+        faiss::distance_compute_by_idx_if(ids, n, this, filter, apply);
+    }
+};
+
 // refine computer only use in single thread
 template <bool NeedNormalize = false>
-struct QuantDataDistanceComputer : faiss::DistanceComputer {
+struct QuantDataDistanceComputer : RefineDistanceComputer {
     std::vector<float> query_buf;
     std::shared_ptr<QuantRefine> quant_data;
     std::unique_ptr<faiss::ScalarQuantizer::SQDistanceComputer> qc;
@@ -218,17 +240,19 @@ struct QuantDataDistanceComputer : faiss::DistanceComputer {
 };
 
 template <typename DataType, typename Distance1, typename Distance4, bool NeedNormalize = false>
-struct DataViewDistanceComputer : faiss::DistanceComputer {
+struct DataViewDistanceComputer : RefineDistanceComputer {
     ViewDataOp view_data;
+    ViewDataBatchOp batch_view_data;
     size_t dim;
     const DataType* q;
     Distance1 dist1;
     Distance4 dist4;
     float q_norm;
 
-    DataViewDistanceComputer(const ViewDataOp& view_data, const size_t dim, Distance1 dist1, Distance4 dist4,
-                             const DataType* query = nullptr, std::optional<float> query_norm = std::nullopt)
-        : view_data(view_data), dim(dim), dist1(dist1), dist4(dist4) {
+    DataViewDistanceComputer(const ViewDataOp& view_data, const ViewDataBatchOp& batch_view_data, const size_t dim,
+                             Distance1 dist1, Distance4 dist4, const DataType* query = nullptr,
+                             std::optional<float> query_norm = std::nullopt)
+        : view_data(view_data), batch_view_data(batch_view_data), dim(dim), dist1(dist1), dist4(dist4) {
         if (query != nullptr) {
             this->set_query((const float*)query, query_norm);
         }
@@ -283,6 +307,58 @@ struct DataViewDistanceComputer : faiss::DistanceComputer {
         }
     }
 
+    // the vectors are resolved kBatch at a time, by a single call of batch_view_data when there is one, and
+    // prefetched kPrefetchAhead vectors before they are scored
+    void
+    distances_by_ids(const idx_t* ids, const size_t n, float* dis) override {
+        constexpr size_t kBatch = 64;
+        constexpr size_t kPrefetchAhead = 8;
+        idx_t batch_ids[kBatch];
+        size_t batch_pos[kBatch];
+        const void* vecs[kBatch];
+        for (size_t i0 = 0; i0 < n; i0 += kBatch) {
+            size_t m = 0;
+            for (size_t i = i0; i < std::min(n, i0 + kBatch); i++) {
+                if (ids[i] >= 0) {
+                    batch_ids[m] = ids[i];
+                    batch_pos[m++] = i;
+                }
+            }
+            if (batch_view_data) {
+                batch_view_data(batch_ids, m, vecs);
+            } else {
+                for (size_t j = 0; j < m; j++) {
+                    vecs[j] = view_data(batch_ids[j]);
+                }
+            }
+            for (size_t j = 0; j < std::min(m, kPrefetchAhead); j++) {
+                prefetch_vector(vecs[j]);
+            }
+            size_t j = 0;
+            for (; j + 4 <= m; j += 4) {
+                for (size_t p = j + kPrefetchAhead; p < std::min(m, j + kPrefetchAhead + 4); p++) {
+                    prefetch_vector(vecs[p]);
+                }
+                float dis0, dis1, dis2, dis3;
+                dist4(q, (const DataType*)vecs[j], (const DataType*)vecs[j + 1], (const DataType*)vecs[j + 2],
+                      (const DataType*)vecs[j + 3], dim, dis0, dis1, dis2, dis3);
+                if constexpr (NeedNormalize) {
+                    dis0 /= q_norm;
+                    dis1 /= q_norm;
+                    dis2 /= q_norm;
+                    dis3 /= q_norm;
+                }
+                dis[batch_pos[j]] = dis0;
+                dis[batch_pos[j + 1]] = dis1;
+                dis[batch_pos[j + 2]] = dis2;
+                dis[batch_pos[j + 3]] = dis3;
+            }
+            for (; j < m; j++) {
+                dis[batch_pos[j]] = distance_to_code(vecs[j]);
+            }
+        }
+    }
+
     /// compute distance between two stored vectors
     float
     symmetric_dis(idx_t i, idx_t j) override {
@@ -290,72 +366,86 @@ struct DataViewDistanceComputer : faiss::DistanceComputer {
         auto y = (DataType*)view_data(j);
         return dist1(x, y, dim);
     }
+
+ private:
+    void
+    prefetch_vector(const void* x) const {
+        const char* p = (const char*)x;
+        for (size_t offset = 0; offset < dim * sizeof(DataType); offset += 64) {
+            prefetch_L1(p + offset);
+        }
+    }
 };
 
-static std::unique_ptr<faiss::DistanceComputer>
+static std::unique_ptr<RefineDistanceComputer>
 SelectDataViewComputer(const ViewDataOp& view_data, const DataFormatEnum& data_type, const knowhere::MetricType& metric,
-                       const size_t dim, bool is_cosine, const std::shared_ptr<QuantRefine> quant = nullptr) {
+                       const size_t dim, bool is_cosine, const std::shared_ptr<QuantRefine> quant = nullptr,
+                       const ViewDataBatchOp& batch_view_data = nullptr) {
     if (quant) {
         if (is_cosine) {
-            return std::unique_ptr<faiss::DistanceComputer>(new QuantDataDistanceComputer<true>(quant, dim));
+            return std::unique_ptr<RefineDistanceComputer>(new QuantDataDistanceComputer<true>(quant, dim));
         } else {
-            return std::unique_ptr<faiss::DistanceComputer>(new QuantDataDistanceComputer<false>(quant, dim));
+            return std::unique_ptr<RefineDistanceComputer>(new QuantDataDistanceComputer<false>(quant, dim));
         }
     } else if (data_type == DataFormatEnum::fp16) {
         if (metric == metric::IP) {
             if (is_cosine) {
-                return std::unique_ptr<faiss::DistanceComputer>(
+                return std::unique_ptr<RefineDistanceComputer>(
                     new DataViewDistanceComputer<fp16, decltype(faiss::fp16_vec_inner_product),
                                                  decltype(faiss::fp16_vec_inner_product_batch_4), true>(
-                        view_data, dim, faiss::fp16_vec_inner_product, faiss::fp16_vec_inner_product_batch_4));
+                        view_data, batch_view_data, dim, faiss::fp16_vec_inner_product,
+                        faiss::fp16_vec_inner_product_batch_4));
             } else {
-                return std::unique_ptr<faiss::DistanceComputer>(
+                return std::unique_ptr<RefineDistanceComputer>(
                     new DataViewDistanceComputer<fp16, decltype(faiss::fp16_vec_inner_product),
                                                  decltype(faiss::fp16_vec_inner_product_batch_4), false>(
-                        view_data, dim, faiss::fp16_vec_inner_product, faiss::fp16_vec_inner_product_batch_4));
+                        view_data, batch_view_data, dim, faiss::fp16_vec_inner_product,
+                        faiss::fp16_vec_inner_product_batch_4));
             }
         } else {
-            return std::unique_ptr<faiss::DistanceComputer>(
+            return std::unique_ptr<RefineDistanceComputer>(
                 new DataViewDistanceComputer<fp16, decltype(faiss::fp16_vec_L2sqr),
                                              decltype(faiss::fp16_vec_L2sqr_batch_4)>(
-                    view_data, dim, faiss::fp16_vec_L2sqr, faiss::fp16_vec_L2sqr_batch_4));
+                    view_data, batch_view_data, dim, faiss::fp16_vec_L2sqr, faiss::fp16_vec_L2sqr_batch_4));
         }
     } else if (data_type == DataFormatEnum::bf16) {
         if (metric == metric::IP) {
             if (is_cosine) {
-                return std::unique_ptr<faiss::DistanceComputer>(
+                return std::unique_ptr<RefineDistanceComputer>(
                     new DataViewDistanceComputer<bf16, decltype(faiss::bf16_vec_inner_product),
                                                  decltype(faiss::bf16_vec_inner_product_batch_4), true>(
-                        view_data, dim, faiss::bf16_vec_inner_product, faiss::bf16_vec_inner_product_batch_4));
+                        view_data, batch_view_data, dim, faiss::bf16_vec_inner_product,
+                        faiss::bf16_vec_inner_product_batch_4));
             } else {
-                return std::unique_ptr<faiss::DistanceComputer>(
+                return std::unique_ptr<RefineDistanceComputer>(
                     new DataViewDistanceComputer<bf16, decltype(faiss::bf16_vec_inner_product),
                                                  decltype(faiss::bf16_vec_inner_product_batch_4), false>(
-                        view_data, dim, faiss::bf16_vec_inner_product, faiss::bf16_vec_inner_product_batch_4));
+                        view_data, batch_view_data, dim, faiss::bf16_vec_inner_product,
+                        faiss::bf16_vec_inner_product_batch_4));
             }
         } else {
-            return std::unique_ptr<faiss::DistanceComputer>(
+            return std::unique_ptr<RefineDistanceComputer>(
                 new DataViewDistanceComputer<bf16, decltype(faiss::bf16_vec_L2sqr),
                                              decltype(faiss::bf16_vec_L2sqr_batch_4)>(
-                    view_data, dim, faiss::bf16_vec_L2sqr, faiss::bf16_vec_L2sqr_batch_4));
+                    view_data, batch_view_data, dim, faiss::bf16_vec_L2sqr, faiss::bf16_vec_L2sqr_batch_4));
         }
     } else if (data_type == DataFormatEnum::fp32) {
         if (metric == metric::IP) {
             if (is_cosine) {
-                return std::unique_ptr<faiss::DistanceComputer>(
+                return std::unique_ptr<RefineDistanceComputer>(
                     new DataViewDistanceComputer<fp32, decltype(faiss::fvec_inner_product),
                                                  decltype(faiss::fvec_inner_product_batch_4), true>(
-                        view_data, dim, faiss::fvec_inner_product, faiss::fvec_inner_product_batch_4));
+                        view_data, batch_view_data, dim, faiss::fvec_inner_product, faiss::fvec_inner_product_batch_4));
             } else {
-                return std::unique_ptr<faiss::DistanceComputer>(
+                return std::unique_ptr<RefineDistanceComputer>(
                     new DataViewDistanceComputer<fp32, decltype(faiss::fvec_inner_product),
                                                  decltype(faiss::fvec_inner_product_batch_4), false>(
-                        view_data, dim, faiss::fvec_inner_product, faiss::fvec_inner_product_batch_4));
+                        view_data, batch_view_data, dim, faiss::fvec_inner_product, faiss::fvec_inner_product_batch_4));
             }
         } else {
-            return std::unique_ptr<faiss::DistanceComputer>(
+            return std::unique_ptr<RefineDistanceComputer>(
                 new DataViewDistanceComputer<fp32, decltype(faiss::fvec_L2sqr), decltype(faiss::fvec_L2sqr_batch_4)>(
-                    view_data, dim, faiss::fvec_L2sqr, faiss::fvec_L2sqr_batch_4));
+                    view_data, batch_view_data, dim, faiss::fvec_L2sqr, faiss::fvec_L2sqr_batch_4));
         }
     } else {
         return nullptr;
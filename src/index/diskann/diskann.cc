@@ -12,14 +12,24 @@
 #include "knowhere/feder/DiskANN.h"
 
 #include <cstdint>
+#include <shared_mutex>
+#include <thread>
 
 #include "diskann/aux_utils.h"
 #include "diskann/linux_aligned_file_reader.h"
+#include "diskann/linux_uring_file_reader.h"
 #include "diskann/pq_flash_index.h"
+#include "diskann/remote_sector_reader.h"
 #include "fmt/core.h"
 #include "index/diskann/diskann_config.h"
+#include "index/diskann/diskann_delta.h"
 #include "knowhere/comp/index_param.h"
+#include "knowhere/comp/rw_lock.h"
+#include "knowhere/comp/search_phases.h"
+#include "knowhere/comp/search_planner.h"
+#include "knowhere/comp/search_stats.h"
 #include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/trace_span.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
 #include "knowhere/feature.h"
@@ -45,6 +55,10 @@ class DiskANNIndexNode : public IndexNode {
         file_manager_ = diskann_index_pack->GetPack();
     }
 
+    ~DiskANNIndexNode() override {
+        WaitForMerge();
+    }
+
     Status
     Build(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
 
@@ -53,13 +67,30 @@ class DiskANNIndexNode : public IndexNode {
         return Status::not_implemented;
     }
 
+    // The rows are searchable at once, with the next ids. They are kept in memory until a merge in the background
+    //   appends them to the disk index, see ScheduleMerge().
     Status
-    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
-        return Status::not_implemented;
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
+
+    // The rows are filtered out of the searches at once, and cut out of the graph by the next merge.
+    Status
+    DeleteByIds(const DataSetPtr dataset) override;
+
+    expected<DataSetPtr>
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        return SearchInto(dataset, std::move(cfg), bitset, nullptr, nullptr);
     }
 
     expected<DataSetPtr>
-    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const override {
+        return SearchInto(dataset, std::move(cfg), bitset, ids, dis);
+    }
+
+    // One beam search per query whose list grows from min_k to max_k to hold the candidates within the radius,
+    //   instead of the iterator of the default one. It covers the rows of the disk index, as the iterators do.
+    expected<DataSetPtr>
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
 
     expected<DataSetPtr>
     GetVectorByIds(const DataSetPtr dataset) const override;
@@ -84,9 +115,18 @@ class DiskANNIndexNode : public IndexNode {
         return Status::success;
     }
 
+    // The graph and the full vectors stay on the disk, the PQ codes and the cached nodes are read into memory. The
+    //   budgets are resolved the way the build does, a quarter of the files is assumed for the PQ codes without them.
     static expected<Resource>
     StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
-        return Resource{file_size * 0.25f, file_size};
+        const DiskANNConfig& diskann_cfg = static_cast<const DiskANNConfig&>(config);
+        const float vec_field_size_gb = diskann_cfg.vec_field_size_gb.value_or(0.0f);
+        const float pq_code_gb = std::max(diskann_cfg.pq_code_budget_gb.value_or(0.0f),
+                                          diskann_cfg.pq_code_budget_gb_ratio.value_or(0.0f) * vec_field_size_gb);
+        const float cache_gb = std::max(diskann_cfg.search_cache_budget_gb.value_or(0.0f),
+                                        diskann_cfg.search_cache_budget_gb_ratio.value_or(0.0f) * vec_field_size_gb);
+        const float pq_memory = pq_code_gb > 0.0f ? std::min(pq_code_gb, file_size) : file_size * 0.25f;
+        return Resource{pq_memory + std::min(cache_gb, file_size), file_size};
     }
 
     Status
@@ -133,7 +173,14 @@ class DiskANNIndexNode : public IndexNode {
             LOG_KNOWHERE_ERROR_ << "Diskann not loaded.";
             return 0;
         }
-        return pq_flash_index_->cal_size();
+        std::shared_lock lock(streaming_mutex_);
+        int64_t size = pq_flash_index_->cal_size() + deleted_.size();
+        for (const auto& delta : {merging_delta_, delta_}) {
+            if (delta != nullptr) {
+                size += delta->Size();
+            }
+        }
+        return size;
     }
 
     int64_t
@@ -155,14 +202,21 @@ class DiskANNIndexNode : public IndexNode {
                 bool use_knowhere_search_pool) const override;
 
  private:
+    // the results go to ids_buf and dis_buf if they are set, to new buffers otherwise
+    expected<DataSetPtr>
+    SearchInto(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids_buf,
+               float* dis_buf) const;
+
     class iterator : public IndexIterator {
      public:
         iterator(const bool transform, const DataType* query_data, const uint64_t lsearch, const uint64_t beam_width,
-                 const float filter_ratio, const knowhere::BitsetView& bitset, diskann::PQFlashIndex<DataType>* index,
-                 bool use_knowhere_search_pool = true)
+                 const float filter_ratio, const knowhere::BitsetView& bitset,
+                 std::shared_ptr<diskann::PQFlashIndex<DataType>> index,
+                 std::shared_ptr<const std::vector<uint8_t>> filter_buffer, bool use_knowhere_search_pool = true)
             : IndexIterator(transform, use_knowhere_search_pool),
-              index_(index),
+              index_(std::move(index)),
               transform_(transform),
+              filter_buffer_(std::move(filter_buffer)),
               workspace_(index_->getIteratorWorkspace(query_data, lsearch, beam_width, filter_ratio, bitset)) {
         }
 
@@ -180,8 +234,10 @@ class DiskANNIndexNode : public IndexNode {
         }
 
      private:
-        diskann::PQFlashIndex<DataType>* index_;
+        std::shared_ptr<diskann::PQFlashIndex<DataType>> index_;
         const bool transform_;
+        // backs the bitset with the deleted rows, if any
+        std::shared_ptr<const std::vector<uint8_t>> filter_buffer_;
         std::unique_ptr<diskann::IteratorWorkspace<DataType>> workspace_;
     };
 
@@ -206,14 +262,66 @@ class DiskANNIndexNode : public IndexNode {
     uint64_t
     GetCachedNodeNum(const float cache_dram_budget, const uint64_t data_dim, const uint64_t max_degree);
 
+    // loads the disk index at index_prefix_, without its cache
+    expected<std::shared_ptr<diskann::PQFlashIndex<DataType>>>
+    LoadIndex() const;
+
+    // a merge is due once the rows added or deleted since the last one reach this share of the disk index, since
+    //   every merge rewrites the whole disk index
+    static constexpr float kStreamingMergeMinRatio = 0.05f;
+
+    bool
+    IsMergeNeeded() const;
+
+    // starts the merge on its own thread unless it is running already, the merge itself runs on the build pool
+    void
+    ScheduleMerge();
+
+    void
+    WaitForMerge();
+
+    // appends the rows of the active delta to the disk index and cuts the deleted rows out of it, then reloads it
+    Status
+    Merge();
+
     std::string index_prefix_;
     mutable std::mutex preparation_lock_;
     std::atomic_bool is_prepared_;
     std::shared_ptr<FileManager> file_manager_;
-    std::unique_ptr<diskann::PQFlashIndex<DataType>> pq_flash_index_;
+    // it is std::shared_ptr because searches and iterators keep the index a merge replaces
+    std::shared_ptr<diskann::PQFlashIndex<DataType>> pq_flash_index_;
     std::atomic_int64_t dim_;
     std::atomic_int64_t count_;
     std::shared_ptr<ThreadPool> search_pool_;
+    uint64_t interleave_queries_ = 1;
+    // what a merge needs to reload the index
+    diskann::Metric diskann_metric_ = diskann::Metric::L2;
+    std::vector<uint32_t> cached_node_list_;
+    uint64_t num_nodes_to_cache_ = 0;
+    bool use_adaptive_cache_ = false;
+    // set if the file manager reads the disk index in ranges instead of loading it
+    std::shared_ptr<FileRangeReader> remote_disk_index_;
+    SectorCacheConfig sector_cache_config_;
+
+    // the streaming state: pq_flash_index_, the rows added since the disk index was written and the deleted rows
+    mutable ReaderBiasedRWLock streaming_mutex_;
+    // takes the adds
+    std::shared_ptr<DiskANNDelta<DataType>> delta_;
+    // the rows the running merge appends to the disk index
+    std::shared_ptr<DiskANNDelta<DataType>> merging_delta_;
+    // one bit per deleted row
+    std::vector<uint8_t> deleted_;
+    size_t num_deleted_ = 0;
+    // the deleted rows the disk index has cut out already
+    size_t num_merged_deleted_ = 0;
+    // adds must not run concurrently, and not while a merge takes the active delta
+    std::mutex add_mutex_;
+    // L of the adds, the merge uses it too
+    std::atomic<unsigned> streaming_search_list_size_{0};
+
+    std::mutex merge_mutex_;
+    bool merge_running_ = false;
+    std::thread merge_thread_;
 };
 
 }  // namespace knowhere
@@ -221,6 +329,8 @@ class DiskANNIndexNode : public IndexNode {
 namespace knowhere {
 namespace {
 static constexpr float kCacheExpansionRate = 1.2;
+// the number of sampled searches between two refreshes of the adaptive cache
+static constexpr uint64_t kAdaptiveCacheRefreshInterval = 4096;
 
 Status
 TryDiskANNCall(std::function<void()>&& diskann_call) {
@@ -268,6 +378,13 @@ GetOptionalFilenames(const std::string& prefix) {
     filenames.push_back(diskann::get_disk_index_centroids_filename(disk_index_filename));
     filenames.push_back(diskann::get_disk_index_medoids_filename(disk_index_filename));
     filenames.push_back(diskann::get_cached_nodes_file(prefix));
+    filenames.push_back(diskann::get_disk_index_labels_filename(disk_index_filename));
+    filenames.push_back(diskann::get_disk_index_label_medoids_filename(disk_index_filename));
+    filenames.push_back(diskann::get_disk_index_sector_order_filename(disk_index_filename));
+    filenames.push_back(diskann::get_disk_index_deleted_ids_filename(disk_index_filename));
+    filenames.push_back(diskann::get_disk_index_nav_ids_filename(disk_index_filename));
+    filenames.push_back(diskann::get_disk_index_nav_data_filename(disk_index_filename));
+    filenames.push_back(diskann::get_disk_index_nav_graph_filename(disk_index_filename));
     return filenames;
 }
 
@@ -285,6 +402,30 @@ AnyIndexFileExist(const std::string& index_prefix) {
            file_exist(GetOptionalFilenames(index_prefix));
 }
 
+// a search bitset with the deleted rows filtered out as well, like HnswTombstones::filter()
+BitsetView
+FilterDeleted(const BitsetView& bitset, const std::vector<uint8_t>& deleted, const size_t ntotal,
+              std::vector<uint8_t>& buffer) {
+    // rows beyond the size of a non-empty bitset are filtered out anyway
+    const size_t num_bits = bitset.empty() ? ntotal : bitset.size();
+    const size_t num_bytes = (num_bits + 7) >> 3;
+
+    buffer.assign(num_bytes, 0);
+    if (!bitset.empty()) {
+        bitset.copy_bits(buffer.data());
+    }
+    const size_t n_common = std::min(num_bytes, deleted.size());
+    for (size_t i = 0; i < n_common; i++) {
+        buffer[i] |= deleted[i];
+    }
+    if ((num_bits & 0x7) != 0) {
+        buffer[num_bytes - 1] &= (0x1 << (num_bits & 0x7)) - 1;
+    }
+
+    const BitsetView combined(buffer.data(), num_bits);
+    return BitsetView(buffer.data(), num_bits, combined.get_filtered_out_num_());
+}
+
 inline bool
 CheckMetric(const std::string& diskann_metric) {
     if (diskann_metric != knowhere::metric::L2 && diskann_metric != knowhere::metric::IP &&
@@ -324,6 +465,11 @@ DiskANNIndexNode<DataType>::Build(const DataSetPtr dataset, std::shared_ptr<Conf
         return Status::disk_file_error;
     }
     auto data_path = build_conf.data_path.value();
+    std::string label_path = build_conf.label_path.value_or("");
+    if (!label_path.empty() && !LoadFile(label_path)) {
+        LOG_KNOWHERE_ERROR_ << "Failed load the labels before building." << std::endl;
+        return Status::disk_file_error;
+    }
 
     index_prefix_ = build_conf.index_prefix.value();
 
@@ -357,7 +503,12 @@ DiskANNIndexNode<DataType>::Build(const DataSetPtr dataset, std::shared_ptr<Conf
                                                        false,
                                                        build_conf.accelerate_build.value(),
                                                        static_cast<uint32_t>(num_nodes_to_cache),
-                                                       build_conf.shuffle_build.value()};
+                                                       build_conf.shuffle_build.value(),
+                                                       label_path,
+                                                       static_cast<uint32_t>(build_conf.build_parallel_shards.value()),
+                                                       build_conf.reorder_sectors.value(),
+                                                       static_cast<uint32_t>(build_conf.pq_code_nbits.value()),
+                                                       build_conf.nav_graph_ratio.value()};
     RETURN_IF_ERROR(TryDiskANNCall([&]() {
         int res = diskann::build_disk_index<DataType>(diskann_internal_build_config);
         if (res != 0)
@@ -399,6 +550,7 @@ DiskANNIndexNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr
         return Status::invalid_param_in_json;
     }
     index_prefix_ = prep_conf.index_prefix.value();
+    interleave_queries_ = static_cast<uint64_t>(prep_conf.interleave_queries.value());
     bool is_ip = IsMetricType(prep_conf.metric_type.value(), knowhere::metric::IP);
     bool need_norm = IsMetricType(prep_conf.metric_type.value(), knowhere::metric::IP) ||
                      IsMetricType(prep_conf.metric_type.value(), knowhere::metric::COSINE);
@@ -412,22 +564,44 @@ DiskANNIndexNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr
         }
     }();
 
-    // Load file from file manager.
-    for (auto& filename : GetNecessaryFilenames(
-             index_prefix_, need_norm, prep_conf.search_cache_budget_gb.value() > 0 && !prep_conf.use_bfs_cache.value(),
-             prep_conf.warm_up.value())) {
-        if (!LoadFile(filename)) {
-            return Status::disk_file_error;
+    // A disk index the file manager reads in ranges stays where it is, e.g. in an object storage, and is read through
+    //   a local sector cache. The other files are loaded still.
+    const auto disk_index_filename = diskann::get_disk_index_filename(index_prefix_);
+    remote_disk_index_ = file_manager_->OpenRangeReader(disk_index_filename);
+    if (remote_disk_index_ != nullptr) {
+        constexpr float kGB = 1024.0f * 1024 * 1024;
+        sector_cache_config_.dram_bytes = static_cast<uint64_t>(prep_conf.remote_cache_dram_gb.value() * kGB);
+        sector_cache_config_.ssd_bytes = static_cast<uint64_t>(prep_conf.remote_cache_ssd_gb.value() * kGB);
+        if (prep_conf.remote_cache_dir.has_value() && sector_cache_config_.ssd_bytes > 0) {
+            sector_cache_config_.ssd_path = prep_conf.remote_cache_dir.value() + "/" +
+                                            std::to_string(std::hash<std::string>{}(index_prefix_)) + "_sectors.cache";
         }
+        LOG_KNOWHERE_INFO_ << "Reading the disk index " << disk_index_filename << " remotely.";
     }
-    for (auto& filename : GetOptionalFilenames(index_prefix_)) {
-        auto is_exist_op = file_manager_->IsExisted(filename);
-        if (!is_exist_op.has_value()) {
-            LOG_KNOWHERE_ERROR_ << "Failed to check existence of file " << filename << ".";
-            return Status::disk_file_error;
+
+    // Load file from file manager.
+    {
+        ScopedTraceSpan span("fetch files");
+        for (auto& filename :
+             GetNecessaryFilenames(index_prefix_, need_norm,
+                                   prep_conf.search_cache_budget_gb.value() > 0 && !prep_conf.use_bfs_cache.value(),
+                                   prep_conf.warm_up.value())) {
+            if (remote_disk_index_ != nullptr && filename == disk_index_filename) {
+                continue;
+            }
+            if (!LoadFile(filename)) {
+                return Status::disk_file_error;
+            }
         }
-        if (is_exist_op.value() && !LoadFile(filename)) {
-            return Status::disk_file_error;
+        for (auto& filename : GetOptionalFilenames(index_prefix_)) {
+            auto is_exist_op = file_manager_->IsExisted(filename);
+            if (!is_exist_op.has_value()) {
+                LOG_KNOWHERE_ERROR_ << "Failed to check existence of file " << filename << ".";
+                return Status::disk_file_error;
+            }
+            if (is_exist_op.value() && !LoadFile(filename)) {
+                return Status::disk_file_error;
+            }
         }
     }
 
@@ -435,21 +609,35 @@ DiskANNIndexNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr
     search_pool_ = ThreadPool::GetGlobalSearchThreadPool();
 
     // load diskann pq code and meta info
-    std::shared_ptr<AlignedFileReader> reader = nullptr;
-
-    reader.reset(new LinuxAlignedFileReader());
-
-    pq_flash_index_ = std::make_unique<diskann::PQFlashIndex<DataType>>(reader, diskann_metric);
-    auto disk_ann_call = [&]() {
-        int res = pq_flash_index_->load(search_pool_->size(), index_prefix_.c_str());
-        if (res != 0) {
-            throw diskann::ANNException("pq_flash_index_->load returned non-zero value: " + std::to_string(res), -1);
+    diskann_metric_ = diskann_metric;
+    auto loaded_index = [this]() {
+        ScopedTraceSpan span("load index");
+        return LoadIndex();
+    }();
+    if (!loaded_index.has_value()) {
+        return loaded_index.error();
+    }
+    pq_flash_index_ = loaded_index.value();
+
+    // the rows deleted by the merges
+    auto deleted_ids_file =
+        diskann::get_disk_index_deleted_ids_filename(diskann::get_disk_index_filename(index_prefix_));
+    deleted_.assign((pq_flash_index_->get_num_points() + 7) / 8, 0);
+    num_deleted_ = 0;
+    if (file_exists(deleted_ids_file)) {
+        size_t num_ids, ids_dim;
+        std::unique_ptr<uint32_t[]> deleted_ids = nullptr;
+        if (TryDiskANNCall([&]() { diskann::load_bin<uint32_t>(deleted_ids_file, deleted_ids, num_ids, ids_dim); }) !=
+            Status::success) {
+            LOG_KNOWHERE_ERROR_ << "Failed to load the deleted rows of DiskANN.";
+            return Status::disk_file_error;
         }
-    };
-    if (TryDiskANNCall(disk_ann_call) != Status::success) {
-        LOG_KNOWHERE_ERROR_ << "Failed to load DiskANN.";
-        return Status::diskann_inner_error;
+        for (size_t i = 0; i < num_ids; i++) {
+            deleted_[deleted_ids[i] >> 3] |= (0x1 << (deleted_ids[i] & 0x7));
+        }
+        num_deleted_ = num_ids;
     }
+    num_merged_deleted_ = num_deleted_;
 
     count_.store(pq_flash_index_->get_num_points());
     // DiskANN will add one more dim for IP type.
@@ -477,6 +665,7 @@ DiskANNIndexNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr
                                 << ") is larger than 1/3 of the total data number.";
             return Status::invalid_args;
         }
+        num_nodes_to_cache_ = num_nodes_to_cache;
         if (num_nodes_to_cache > 0) {
             LOG_KNOWHERE_INFO_ << "Caching " << num_nodes_to_cache << " sample nodes around medoid(s).";
             if (prep_conf.use_bfs_cache.value()) {
@@ -501,14 +690,21 @@ DiskANNIndexNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr
     }
 
     if (node_list.size() > 0) {
+        ScopedTraceSpan span("load cache");
         if (TryDiskANNCall([&]() { pq_flash_index_->load_cache_list(node_list); }) != Status::success) {
             LOG_KNOWHERE_ERROR_ << "Failed to load cache for DiskANN.";
             return Status::diskann_inner_error;
         }
     }
+    cached_node_list_ = std::move(node_list);
+    use_adaptive_cache_ = prep_conf.use_adaptive_cache.value();
+    if (use_adaptive_cache_) {
+        pq_flash_index_->enable_adaptive_cache(kAdaptiveCacheRefreshInterval);
+    }
 
     // warmup
     if (prep_conf.warm_up.value()) {
+        ScopedTraceSpan span("warm up");
         LOG_KNOWHERE_INFO_ << "Warming up.";
         uint64_t warmup_L = 20;
         uint64_t warmup_num = 0;
@@ -552,11 +748,264 @@ DiskANNIndexNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr
     return Status::success;
 }
 
+template <typename DataType>
+expected<std::shared_ptr<diskann::PQFlashIndex<DataType>>>
+DiskANNIndexNode<DataType>::LoadIndex() const {
+    std::shared_ptr<AlignedFileReader> reader = nullptr;
+    if (remote_disk_index_ != nullptr) {
+        reader.reset(new RemoteSectorReader(remote_disk_index_, sector_cache_config_));
+    } else if (UringContextPool::GetGlobalUringPool() != nullptr) {
+        reader.reset(new LinuxUringFileReader());
+    } else {
+        reader.reset(new LinuxAlignedFileReader());
+    }
+
+    auto index = std::make_shared<diskann::PQFlashIndex<DataType>>(reader, diskann_metric_);
+    auto disk_ann_call = [&]() {
+        int res = index->load(search_pool_->size() * interleave_queries_, index_prefix_.c_str());
+        if (res != 0) {
+            throw diskann::ANNException("pq_flash_index_->load returned non-zero value: " + std::to_string(res), -1);
+        }
+    };
+    if (TryDiskANNCall(disk_ann_call) != Status::success) {
+        LOG_KNOWHERE_ERROR_ << "Failed to load DiskANN.";
+        return expected<std::shared_ptr<diskann::PQFlashIndex<DataType>>>::Err(Status::diskann_inner_error,
+                                                                               "failed to load DiskANN");
+    }
+    return index;
+}
+
+template <typename DataType>
+Status
+DiskANNIndexNode<DataType>::Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) {
+    if (!is_prepared_.load() || !pq_flash_index_) {
+        LOG_KNOWHERE_ERROR_ << "Can not add data to a DiskANN index that is not loaded.";
+        return Status::empty_index;
+    }
+    if (diskann_metric_ == diskann::Metric::INNER_PRODUCT || pq_flash_index_->has_labels() ||
+        file_exists(diskann::get_disk_index_filename(index_prefix_) + "_pq_pivots.bin")) {
+        LOG_KNOWHERE_ERROR_ << "DiskANN supports adds only for L2 and COSINE indexes without labels and disk PQ.";
+        return Status::not_implemented;
+    }
+    if (remote_disk_index_ != nullptr) {
+        LOG_KNOWHERE_ERROR_ << "DiskANN supports adds only for a disk index on the local disk.";
+        return Status::not_implemented;
+    }
+    if (dataset->GetDim() != Dim()) {
+        LOG_KNOWHERE_ERROR_ << "Can not add rows of dim " << dataset->GetDim() << " to an index of dim " << Dim();
+        return Status::invalid_args;
+    }
+    auto add_conf = static_cast<const DiskANNConfig&>(*cfg);
+    const auto rows = dataset->GetRows();
+    const auto* data = static_cast<const DataType*>(dataset->GetTensor());
+
+    std::lock_guard<std::mutex> add_lock(add_mutex_);
+    std::shared_ptr<DiskANNDelta<DataType>> delta;
+    {
+        std::unique_lock lock(streaming_mutex_);
+        if (delta_ == nullptr) {
+            streaming_search_list_size_.store(static_cast<unsigned>(add_conf.search_list_size.value()));
+            delta_ = std::make_shared<DiskANNDelta<DataType>>(diskann_metric_, Dim(), count_.load(),
+                                                              static_cast<unsigned>(pq_flash_index_->get_max_degree()),
+                                                              streaming_search_list_size_.load());
+        }
+        delta = delta_;
+    }
+    RETURN_IF_ERROR(TryDiskANNCall([&]() { delta->Add(data, rows); }));
+    count_.fetch_add(rows);
+
+    ScheduleMerge();
+    return Status::success;
+}
+
+template <typename DataType>
+Status
+DiskANNIndexNode<DataType>::DeleteByIds(const DataSetPtr dataset) {
+    if (!is_prepared_.load() || !pq_flash_index_) {
+        LOG_KNOWHERE_ERROR_ << "Can not delete data from a DiskANN index that is not loaded.";
+        return Status::empty_index;
+    }
+    const auto rows = dataset->GetRows();
+    const auto* ids = dataset->GetIds();
+    {
+        std::unique_lock lock(streaming_mutex_);
+        const int64_t count = Count();
+        for (int64_t i = 0; i < rows; i++) {
+            if (ids[i] < 0 || ids[i] >= count) {
+                LOG_KNOWHERE_ERROR_ << "can not delete row " << ids[i] << ", the index has " << count << " rows";
+                return Status::invalid_args;
+            }
+        }
+        if (deleted_.size() < static_cast<size_t>((count + 7) / 8)) {
+            deleted_.resize((count + 7) / 8, 0);
+        }
+        for (int64_t i = 0; i < rows; i++) {
+            const uint8_t bit = 0x1 << (ids[i] & 0x7);
+            if ((deleted_[ids[i] >> 3] & bit) == 0) {
+                deleted_[ids[i] >> 3] |= bit;
+                num_deleted_++;
+            }
+        }
+    }
+
+    ScheduleMerge();
+    return Status::success;
+}
+
+template <typename DataType>
+bool
+DiskANNIndexNode<DataType>::IsMergeNeeded() const {
+    // a merge rewrites the disk index, so the deleted rows of a remote one stay filtered out instead
+    if (remote_disk_index_ != nullptr) {
+        return false;
+    }
+    std::shared_lock lock(streaming_mutex_);
+    size_t n_pending = num_deleted_ - num_merged_deleted_;
+    for (const auto& delta : {merging_delta_, delta_}) {
+        if (delta != nullptr) {
+            n_pending += delta->Count();
+        }
+    }
+    return n_pending > 0 && (double)n_pending >= pq_flash_index_->get_num_points() * kStreamingMergeMinRatio;
+}
+
+template <typename DataType>
+void
+DiskANNIndexNode<DataType>::ScheduleMerge() {
+    std::lock_guard<std::mutex> lock(merge_mutex_);
+    if (merge_running_ || !IsMergeNeeded()) {
+        return;
+    }
+    if (merge_thread_.joinable()) {
+        merge_thread_.join();
+    }
+
+    merge_running_ = true;
+    merge_thread_ = std::thread([this] {
+        while (Merge() == Status::success) {
+            std::lock_guard<std::mutex> lock(merge_mutex_);
+            if (!IsMergeNeeded()) {
+                merge_running_ = false;
+                return;
+            }
+        }
+        // the rows stay in the deltas, the next add or delete retries
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        merge_running_ = false;
+    });
+}
+
+template <typename DataType>
+void
+DiskANNIndexNode<DataType>::WaitForMerge() {
+    std::thread merge;
+    {
+        std::lock_guard<std::mutex> lock(merge_mutex_);
+        merge = std::move(merge_thread_);
+    }
+    if (merge.joinable()) {
+        merge.join();
+    }
+}
+
+template <typename DataType>
+Status
+DiskANNIndexNode<DataType>::Merge() {
+    std::shared_ptr<diskann::PQFlashIndex<DataType>> index;
+    std::vector<bool> deleted;
+    size_t num_deleted = 0;
+    {
+        std::lock_guard<std::mutex> add_lock(add_mutex_);
+        std::unique_lock lock(streaming_mutex_);
+        if (merging_delta_ == nullptr) {
+            merging_delta_ = std::move(delta_);
+            delta_.reset();
+        }
+        index = pq_flash_index_;
+        const size_t n_merged = index->get_num_points() + (merging_delta_ != nullptr ? merging_delta_->Count() : 0);
+        deleted.resize(n_merged, false);
+        for (size_t id = 0; id < n_merged && (id >> 3) < deleted_.size(); id++) {
+            if (deleted_[id >> 3] & (0x1 << (id & 0x7))) {
+                deleted[id] = true;
+                num_deleted++;
+            }
+        }
+    }
+
+    const DataType* insert_data = nullptr;
+    std::vector<std::vector<unsigned>> insert_graph;
+    if (merging_delta_ != nullptr) {
+        insert_data = merging_delta_->Data();
+        insert_graph = merging_delta_->Graph();
+    }
+    diskann::MergeConfig merge_config{index_prefix_, streaming_search_list_size_.load()};
+    auto status = TryDiskANNCall([&]() {
+        int res = diskann::merge_disk_index<DataType>(merge_config, *index, insert_data, insert_graph, deleted);
+        if (res != 0) {
+            throw diskann::ANNException("diskann::merge_disk_index returned non-zero value: " + std::to_string(res),
+                                        -1);
+        }
+    });
+    if (status != Status::success) {
+        LOG_KNOWHERE_ERROR_ << "Failed to merge the added and deleted rows into the DiskANN index.";
+        return status;
+    }
+
+    auto merged_index = LoadIndex();
+    if (!merged_index.has_value()) {
+        return merged_index.error();
+    }
+    auto cache_call = [&]() {
+        std::vector<uint32_t> node_list = cached_node_list_;
+        if (node_list.empty() && num_nodes_to_cache_ > 0) {
+            merged_index.value()->cache_bfs_levels(num_nodes_to_cache_, node_list);
+        }
+        if (!node_list.empty()) {
+            merged_index.value()->load_cache_list(node_list);
+        }
+    };
+    if (TryDiskANNCall(cache_call) != Status::success) {
+        LOG_KNOWHERE_ERROR_ << "Failed to load cache for the merged DiskANN index.";
+        return Status::diskann_inner_error;
+    }
+    if (use_adaptive_cache_) {
+        merged_index.value()->enable_adaptive_cache(kAdaptiveCacheRefreshInterval);
+    }
+    for (auto& filename : GetNecessaryFilenames(index_prefix_, diskann_metric_ == diskann::Metric::COSINE, false,
+                                                false)) {
+        if (!AddFile(filename)) {
+            return Status::disk_file_error;
+        }
+    }
+    for (auto& filename : GetOptionalFilenames(index_prefix_)) {
+        if (file_exists(filename) && !AddFile(filename)) {
+            return Status::disk_file_error;
+        }
+    }
+
+    std::unique_lock lock(streaming_mutex_);
+    pq_flash_index_ = merged_index.value();
+    merging_delta_.reset();
+    num_merged_deleted_ = num_deleted;
+    return Status::success;
+}
+
 template <typename DataType>
 expected<std::vector<IndexNode::IteratorPtr>>
 DiskANNIndexNode<DataType>::AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
                                         bool use_knowhere_search_pool) const {
-    if (!is_prepared_.load() || !pq_flash_index_) {
+    // the iterators cover the rows of the disk index, not the ones added since it was written
+    std::shared_ptr<diskann::PQFlashIndex<DataType>> index;
+    auto filter_buffer = std::make_shared<std::vector<uint8_t>>();
+    BitsetView filter = bitset;
+    {
+        std::shared_lock lock(streaming_mutex_);
+        index = pq_flash_index_;
+        if (num_deleted_ > 0) {
+            filter = FilterDeleted(bitset, deleted_, Count(), *filter_buffer);
+        }
+    }
+    if (!is_prepared_.load() || !index) {
         LOG_KNOWHERE_ERROR_ << "Failed to load diskann.";
         return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::empty_index, "DiskANN not loaded");
     }
@@ -583,8 +1032,8 @@ DiskANNIndexNode<DataType>::AnnIterator(const DataSetPtr dataset, std::unique_pt
     try {
         for (int i = 0; i < nq; i++) {
             auto single_query = (DataType*)xq + i * dim;
-            auto it = std::make_shared<iterator>(transform, single_query, lsearch, beamwidth, filter_ratio, bitset,
-                                                 pq_flash_index_.get(), use_knowhere_search_pool);
+            auto it = std::make_shared<iterator>(transform, single_query, lsearch, beamwidth, filter_ratio, filter,
+                                                 index, filter_buffer, use_knowhere_search_pool);
             vec[i] = it;
         }
     } catch (const std::exception& e) {
@@ -596,9 +1045,25 @@ DiskANNIndexNode<DataType>::AnnIterator(const DataSetPtr dataset, std::unique_pt
 
 template <typename DataType>
 expected<DataSetPtr>
-DiskANNIndexNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
-                                   const BitsetView& bitset) const {
-    if (!is_prepared_.load() || !pq_flash_index_) {
+DiskANNIndexNode<DataType>::SearchInto(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                       const BitsetView& bitset, int64_t* ids_buf, float* dis_buf) const {
+    std::shared_ptr<diskann::PQFlashIndex<DataType>> index;
+    std::vector<std::shared_ptr<DiskANNDelta<DataType>>> deltas;
+    std::vector<uint8_t> filter_buffer;
+    BitsetView filter = bitset;
+    {
+        std::shared_lock lock(streaming_mutex_);
+        index = pq_flash_index_;
+        for (const auto& delta : {merging_delta_, delta_}) {
+            if (delta != nullptr && delta->Count() > 0) {
+                deltas.push_back(delta);
+            }
+        }
+        if (num_deleted_ > 0) {
+            filter = FilterDeleted(bitset, deleted_, Count(), filter_buffer);
+        }
+    }
+    if (!is_prepared_.load() || !index) {
         LOG_KNOWHERE_ERROR_ << "Failed to load diskann.";
         return expected<DataSetPtr>::Err(Status::empty_index, "DiskANN not loaded");
     }
@@ -611,11 +1076,22 @@ DiskANNIndexNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Con
     auto lsearch = static_cast<uint64_t>(search_conf.search_list_size.value());
     auto beamwidth = static_cast<uint64_t>(search_conf.beamwidth.value());
     auto filter_ratio = static_cast<float>(search_conf.filter_threshold.value());
+    auto filter_label = static_cast<int64_t>(search_conf.filter_label.value());
+    if (filter_label >= 0 && !index->has_labels()) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "the index was built without label_path");
+    }
 
     auto nq = dataset->GetRows();
     auto dim = dataset->GetDim();
     auto xq = static_cast<const DataType*>(dataset->GetTensor());
 
+    // the planner stands in for the dynamic threshold, a filter_threshold given by the caller still wins
+    if (filter_ratio < 0 && filter_label < 0 && !filter.empty() && SearchPlanner::Enabled()) {
+        auto input = SearchPlanInput::FromBitset(filter.size(), dim, k, filter);
+        input.ef = std::max<int64_t>(k, lsearch);
+        filter_ratio = SearchPlanner::Plan(input).plan == SearchPlan::BRUTE_FORCE ? 0.0f : 1.0f;
+    }
+
     feder::diskann::FederResultUniq feder_result;
     if (search_conf.trace_visit.value()) {
         if (nq != 1) {
@@ -626,27 +1102,118 @@ DiskANNIndexNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Con
                                                  search_conf.search_list_size.value());
     }
 
-    auto p_id = std::make_unique<int64_t[]>(k * nq);
-    auto p_dist = std::make_unique<DistType[]>(k * nq);
+    auto p_id = MakeResultBuffer<int64_t>(k * nq, ids_buf);
+    auto p_dist = MakeResultBuffer<DistType>(k * nq, dis_buf);
+
+    SearchStatsVec search_stats;
+    if (search_conf.search_stats.value()) {
+        search_stats.resize(nq);
+    }
+    auto record_stats = [&search_stats](int64_t row, const diskann::QueryStats& s) {
+        if (!search_stats.empty()) {
+            search_stats[row].ndis = s.n_cmps;
+            search_stats[row].nhops = s.n_hops;
+            search_stats[row].n_ios = s.n_ios;
+            search_stats[row].bf_fallback = s.brute_force;
+        }
+    };
 
     std::vector<folly::Future<folly::Unit>> futures;
-    futures.reserve(nq);
-    for (int64_t row = 0; row < nq; ++row) {
-        futures.emplace_back(search_pool_->push([&, index = row, p_id_ptr = p_id.get(), p_dist_ptr = p_dist.get()]() {
-            diskann::QueryStats stats;
-            pq_flash_index_->cached_beam_search(xq + (index * dim), k, lsearch, p_id_ptr + (index * k),
-                                                p_dist_ptr + (index * k), beamwidth, false, &stats, feder_result,
-                                                bitset, filter_ratio);
+    if (interleave_queries_ > 1 && feder_result == nullptr) {
+        // every task searches a chunk of queries with their beam searches interleaved
+        auto chunk = static_cast<int64_t>(interleave_queries_);
+        futures.reserve((nq + chunk - 1) / chunk);
+        for (int64_t row = 0; row < nq; row += chunk) {
+            futures.emplace_back(search_pool_->push([&, begin = row, end = std::min(row + chunk, nq),
+                                                     p_id_ptr = p_id.get(), p_dist_ptr = p_dist.get()]() {
+                ScopedSearchPhase phase(SearchPhase::SCAN);
+                std::vector<diskann::QueryStats> stats(end - begin);
+                index->cached_beam_search_interleaved(xq + (begin * dim), end - begin, dim, k, lsearch,
+                                                      p_id_ptr + (begin * k), p_dist_ptr + (begin * k), beamwidth,
+                                                      interleave_queries_, stats.data(), filter, filter_ratio,
+                                                      filter_label);
+                for (int64_t row = begin; row < end; row++) {
+                    record_stats(row, stats[row - begin]);
+                }
 #ifdef NOT_COMPILE_FOR_SWIG
-            knowhere_diskann_search_hops.Observe(stats.n_hops);
+                for (const auto& s : stats) {
+                    knowhere_diskann_search_hops.Observe(s.n_hops);
+                    if (s.n_cache_hits + s.n_ios > 0) {
+                        knowhere_diskann_cache_hit_ratio.Observe(static_cast<double>(s.n_cache_hits) /
+                                                                 (s.n_cache_hits + s.n_ios));
+                    }
+                }
 #endif
-        }));
+            }));
+        }
+    } else {
+        futures.reserve(nq);
+        for (int64_t row = 0; row < nq; ++row) {
+            futures.emplace_back(search_pool_->push([&, row_index = row, p_id_ptr = p_id.get(),
+                                                     p_dist_ptr = p_dist.get()]() {
+                ScopedSearchPhase phase(SearchPhase::SCAN);
+                diskann::QueryStats stats;
+                index->cached_beam_search(xq + (row_index * dim), k, lsearch, p_id_ptr + (row_index * k),
+                                          p_dist_ptr + (row_index * k), beamwidth, false, &stats, feder_result, filter,
+                                          filter_ratio, filter_label);
+                record_stats(row_index, stats);
+#ifdef NOT_COMPILE_FOR_SWIG
+                knowhere_diskann_search_hops.Observe(stats.n_hops);
+                if (stats.n_cache_hits + stats.n_ios > 0) {
+                    knowhere_diskann_cache_hit_ratio.Observe(static_cast<double>(stats.n_cache_hits) /
+                                                             (stats.n_cache_hits + stats.n_ios));
+                }
+#endif
+            }));
+        }
     }
 
     if (TryDiskANNCall([&]() { WaitAllSuccess(futures); }) != Status::success) {
         return expected<DataSetPtr>::Err(Status::diskann_inner_error, "some search failed");
     }
 
+    // the rows added since the disk index was written are searched in memory, then merged into the results
+    if (!deltas.empty()) {
+        const bool is_cosine = diskann_metric_ == diskann::Metric::COSINE;
+        futures.clear();
+        futures.reserve(nq);
+        for (int64_t row = 0; row < nq; ++row) {
+            futures.emplace_back(search_pool_->push([&, row_index = row, p_id_ptr = p_id.get(),
+                                                     p_dist_ptr = p_dist.get()]() {
+                ScopedSearchPhase phase(SearchPhase::SCAN);
+                int64_t* ids = p_id_ptr + row_index * k;
+                DistType* dists = p_dist_ptr + row_index * k;
+                std::vector<std::pair<DistType, int64_t>> candidates;
+                candidates.reserve(k * (deltas.size() + 1));
+                std::vector<int64_t> delta_ids(k);
+                std::vector<DistType> delta_dists(k);
+                for (uint64_t i = 0; i < k; i++) {
+                    if (ids[i] >= 0) {
+                        candidates.emplace_back(dists[i], ids[i]);
+                    }
+                }
+                for (const auto& delta : deltas) {
+                    delta->Search(xq + row_index * dim, k, lsearch, filter, delta_ids.data(), delta_dists.data());
+                    for (uint64_t i = 0; i < k && delta_ids[i] >= 0; i++) {
+                        candidates.emplace_back(delta_dists[i], delta_ids[i]);
+                    }
+                }
+                auto closer = [is_cosine](const auto& a, const auto& b) {
+                    return is_cosine ? a.first > b.first : a.first < b.first;
+                };
+                const size_t n = std::min<size_t>(k, candidates.size());
+                std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(), closer);
+                for (size_t i = 0; i < k; i++) {
+                    ids[i] = i < n ? candidates[i].second : -1;
+                    dists[i] = i < n ? candidates[i].first : dists[i];
+                }
+            }));
+        }
+        if (TryDiskANNCall([&]() { WaitAllSuccess(futures); }) != Status::success) {
+            return expected<DataSetPtr>::Err(Status::diskann_inner_error, "some search failed");
+        }
+    }
+
     auto res = GenResultDataSet(nq, k, std::move(p_id), std::move(p_dist));
 
     // set visit_info json string into result dataset
@@ -657,9 +1224,82 @@ DiskANNIndexNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Con
         res->SetJsonInfo(json_visit_info.dump());
         res->SetJsonIdSet(json_id_set.dump());
     }
+    if (!search_stats.empty()) {
+        res->Set(meta::SEARCH_STATS, std::move(search_stats));
+    }
     return res;
 }
 
+template <typename DataType>
+expected<DataSetPtr>
+DiskANNIndexNode<DataType>::RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                        const BitsetView& bitset) const {
+    std::shared_ptr<diskann::PQFlashIndex<DataType>> index;
+    std::vector<uint8_t> filter_buffer;
+    BitsetView filter = bitset;
+    {
+        std::shared_lock lock(streaming_mutex_);
+        index = pq_flash_index_;
+        if (num_deleted_ > 0) {
+            filter = FilterDeleted(bitset, deleted_, Count(), filter_buffer);
+        }
+    }
+    if (!is_prepared_.load() || !index) {
+        LOG_KNOWHERE_ERROR_ << "Failed to load diskann.";
+        return expected<DataSetPtr>::Err(Status::empty_index, "DiskANN not loaded");
+    }
+
+    auto search_conf = static_cast<const DiskANNConfig&>(*cfg);
+    if (!CheckMetric(search_conf.metric_type.value())) {
+        return expected<DataSetPtr>::Err(Status::invalid_metric_type, "unsupported metric type");
+    }
+    const bool is_ip = !IsMetricType(search_conf.metric_type.value(), metric::L2);
+    const float radius = search_conf.radius.value();
+    const float range_filter = search_conf.range_filter.value();
+    const int32_t range_search_k = search_conf.range_search_k.value();
+    auto min_l = static_cast<uint64_t>(search_conf.min_k.value());
+    auto max_l = static_cast<uint64_t>(search_conf.max_k.value());
+    auto beamwidth = static_cast<uint64_t>(search_conf.beamwidth.value());
+    auto filter_ratio = static_cast<float>(search_conf.filter_threshold.value());
+
+    auto nq = dataset->GetRows();
+    auto dim = dataset->GetDim();
+    auto xq = static_cast<const DataType*>(dataset->GetTensor());
+
+    std::vector<std::vector<int64_t>> result_id_array(nq);
+    std::vector<std::vector<float>> result_dist_array(nq);
+    if (range_search_k != 0) {
+        std::vector<folly::Future<folly::Unit>> futures;
+        futures.reserve(nq);
+        for (int64_t row = 0; row < nq; ++row) {
+            futures.emplace_back(search_pool_->push([&, row_index = row]() {
+                ScopedSearchPhase phase(SearchPhase::SCAN);
+                diskann::QueryStats stats;
+                auto& ids = result_id_array[row_index];
+                auto& dists = result_dist_array[row_index];
+                index->range_search(xq + (row_index * dim), radius, min_l, max_l, beamwidth, ids, dists, &stats,
+                                    filter, filter_ratio);
+                FilterRangeSearchResultForOneNq(dists, ids, is_ip, radius, range_filter);
+                // the results come closest first
+                if (range_search_k > 0 && ids.size() > static_cast<size_t>(range_search_k)) {
+                    ids.resize(range_search_k);
+                    dists.resize(range_search_k);
+                }
+#ifdef NOT_COMPILE_FOR_SWIG
+                knowhere_diskann_search_hops.Observe(stats.n_hops);
+#endif
+            }));
+        }
+        if (TryDiskANNCall([&]() { WaitAllSuccess(futures); }) != Status::success) {
+            return expected<DataSetPtr>::Err(Status::diskann_inner_error, "some range search failed");
+        }
+    }
+
+    auto range_search_result =
+        GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius, range_filter);
+    return GenResultDataSet(nq, std::move(range_search_result));
+}
+
 /*
  * Get raw vector data given their ids.
  * It first tries to get data from cache, if failed, it will try to get data from disk.
@@ -668,7 +1308,18 @@ DiskANNIndexNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Con
 template <typename DataType>
 expected<DataSetPtr>
 DiskANNIndexNode<DataType>::GetVectorByIds(const DataSetPtr dataset) const {
-    if (!is_prepared_.load() || !pq_flash_index_) {
+    std::shared_ptr<diskann::PQFlashIndex<DataType>> index;
+    std::vector<std::shared_ptr<DiskANNDelta<DataType>>> deltas;
+    {
+        std::shared_lock lock(streaming_mutex_);
+        index = pq_flash_index_;
+        for (const auto& delta : {merging_delta_, delta_}) {
+            if (delta != nullptr) {
+                deltas.push_back(delta);
+            }
+        }
+    }
+    if (!is_prepared_.load() || !index) {
         LOG_KNOWHERE_ERROR_ << "Failed to load diskann.";
         return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
     }
@@ -681,10 +1332,41 @@ DiskANNIndexNode<DataType>::GetVectorByIds(const DataSetPtr dataset) const {
         return expected<DataSetPtr>::Err(Status::malloc_error, "failed to allocate memory for data");
     }
 
-    if (TryDiskANNCall([&]() { pq_flash_index_->get_vector_by_ids(ids, rows, data); }) != Status::success) {
-        delete[] data;
-        return expected<DataSetPtr>::Err(Status::diskann_inner_error, "failed to get vector");
-    };
+    // the rows added since the disk index was written are read from memory
+    const int64_t num_disk_rows = index->get_num_points();
+    std::vector<int64_t> disk_ids;
+    std::vector<int64_t> disk_rows;
+    for (int64_t i = 0; i < rows; i++) {
+        if (ids[i] < num_disk_rows) {
+            disk_ids.push_back(ids[i]);
+            disk_rows.push_back(i);
+            continue;
+        }
+        auto delta = std::find_if(deltas.begin(), deltas.end(), [id = ids[i]](const auto& d) {
+            return id >= d->BaseId() && id < d->BaseId() + static_cast<int64_t>(d->Count());
+        });
+        if (delta == deltas.end()) {
+            delete[] data;
+            return expected<DataSetPtr>::Err(Status::invalid_args, "id " + std::to_string(ids[i]) + " is out of range");
+        }
+        (*delta)->GetVectorById(ids[i], data + i * dim);
+    }
+    if (disk_ids.size() == static_cast<size_t>(rows)) {
+        if (TryDiskANNCall([&]() { index->get_vector_by_ids(ids, rows, data); }) != Status::success) {
+            delete[] data;
+            return expected<DataSetPtr>::Err(Status::diskann_inner_error, "failed to get vector");
+        };
+    } else if (!disk_ids.empty()) {
+        std::vector<DataType> disk_data(disk_ids.size() * dim);
+        if (TryDiskANNCall([&]() { index->get_vector_by_ids(disk_ids.data(), disk_ids.size(), disk_data.data()); }) !=
+            Status::success) {
+            delete[] data;
+            return expected<DataSetPtr>::Err(Status::diskann_inner_error, "failed to get vector");
+        };
+        for (size_t i = 0; i < disk_ids.size(); i++) {
+            std::copy_n(disk_data.data() + i * dim, dim, data + disk_rows[i] * dim);
+        }
+    }
 
     return GenResultDataSet(rows, dim, data);
 }
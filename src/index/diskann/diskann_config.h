@@ -55,6 +55,24 @@ class DiskANNConfig : public BaseConfig {
     // This is the flag to enable fast build, in which we will not build vamana graph by full 2 round. This can
     // accelerate index build ~30% with an ~1% recall regression.
     CFG_BOOL accelerate_build;
+    // The path of a file with one uint32 label per row (e.g. the tenant), in the same bin format as the raw data. The
+    // graph then also gets the edges of a graph over the rows of every label, so that the searches filtered by a label
+    // only traverse the rows with that label.
+    CFG_STRING label_path;
+    // The number of sub-graphs built at once when the index does not fit in build_dram_budget_gb. The rows are
+    // split into smaller sub-graphs, so that that many of them fit in the budget together, and the builds keep more
+    // of the cores busy. An index that fits in the budget is still built in one pass.
+    CFG_INT build_parallel_shards;
+    // Packs the rows that are close in the graph into the same 4KB sectors of the disk index, so that a search finds
+    // more of the rows it visits in the sectors it has already read. Has no effect when a row takes a whole sector.
+    CFG_BOOL reorder_sectors;
+    // The bits of a PQ code of the in-memory PQ data, 8 or 4. The 4-bit codes are scored 32 at a time with SIMD table
+    // lookups, and pq_code_budget_gb then holds twice the chunks, so the searches spend less time on the PQ distances.
+    CFG_INT pq_code_nbits;
+    // The ratio of the rows sampled into a small graph that is kept in memory with their raw vectors. A search first
+    // searches it for the rows closest to the query and starts from them instead of from the medoid, so that it reads
+    // fewer sectors on the way to the neighborhood of the query. 0 for no such graph.
+    CFG_FLOAT nav_graph_ratio;
 
     // The ratio of the size reserved for the search cache to the size of the raw data (defined with vec_field_size_gb)
     // This parameter will replace pq_code_budget_gb to avoid calculating the actual size on the Milvus side.
@@ -70,19 +88,36 @@ class DiskANNConfig : public BaseConfig {
     // cached the nodes on the search paths; 2. do bfs from the entry point and cache them. The first method is suitable
     // for TopK query heavy circumstances and the second one performed better in range search.
     CFG_BOOL use_bfs_cache;
+    // Should the cache follow the queries after it is loaded. A sample of the searches counts the node visits, and the
+    // hottest uncached nodes replace the coldest cached ones from time to time within the same cache budget.
+    CFG_BOOL use_adaptive_cache;
+    // The number of queries each search thread works on at once. The beam search of one query goes on while the
+    // reads of the others are in flight, so the disk is kept busy with fewer threads. Each query of a thread uses one
+    // more search context and IO context, the thread falls back to fewer queries if there are none free.
+    CFG_INT interleave_queries;
+    // Used when the file manager reads the disk index in ranges where it is kept, e.g. in an object storage, instead
+    // of loading it to the local disk. The sectors read are cached in remote_cache_dram_gb of memory, the most
+    // recently used ones, and in a file of remote_cache_ssd_gb in remote_cache_dir on the local SSD.
+    CFG_FLOAT remote_cache_dram_gb;
+    CFG_FLOAT remote_cache_ssd_gb;
+    CFG_STRING remote_cache_dir;
     // The beamwidth to be used for search. This is the maximum number of IO requests each query will issue per
     // iteration of search code. Larger beamwidth will result in fewer IO round-trips per query but might result in
     // slightly higher total number of IO requests to SSD per query. For the highest query throughput with a fixed SSD
     // IOps rating, use W=1. For best latency, use W=4,8 or higher complexity search.
     CFG_INT beamwidth;
-    // DiskANN uses TopK search to simulate range search by double the K in every round. This is the start K.
+    // The size of the search list a range search starts with. Its closest candidates are expanded whatever their
+    //   distances, to lead the search towards the query.
     CFG_INT min_k;
-    // DiskANN uses TopK search to simulate range search by double the K in every round. This is the largest K.
+    // The size the search list of a range search may double up to, while it holds candidates within the radius.
     CFG_INT max_k;
     // The threshold which determines when to switch to PQ + Refine strategy based on the number of bits set. The
     // value should be in range of [0.0, 1.0] which means when greater or equal to x% of the bits are set,
     // use PQ + Refine. Default to -1.0f, negative vlaues will use dynamic threshold calculator given topk.
     CFG_FLOAT filter_threshold;
+    // Only search the rows with this label, -1 for all rows. Needs an index built with label_path. The bitset still
+    // applies on top of it.
+    CFG_INT filter_label;
     KNOHWERE_DECLARE_CONFIG(DiskANNConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(max_degree)
             .description("the degree of the graph index.")
@@ -101,12 +136,14 @@ class DiskANNConfig : public BaseConfig {
             .description("the size of PQ compared with vector field data")
             .set_default(0)
             .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
-            .for_train();
+            .for_train()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(pq_code_budget_gb)
             .description("the ratio of the size reserved for the pq code to the size of the raw data.")
             .set_default(0)
             .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
-            .for_train();
+            .for_train()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(build_dram_budget_gb)
             .description("limit on the memory allowed for building the index in GB.")
             .set_default(0)
@@ -116,6 +153,29 @@ class DiskANNConfig : public BaseConfig {
             .description("the dimension of compressed vectors stored on the ssd, use 0 to store uncompressed data.")
             .set_default(0)
             .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(label_path)
+            .description("the path of the labels of the rows.")
+            .allow_empty_without_default()
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(build_parallel_shards)
+            .description("the number of sub-graphs built at once when the index does not fit in the build budget.")
+            .set_default(1)
+            .set_range(1, 64)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(reorder_sectors)
+            .description("pack the rows that are close in the graph into the same sectors.")
+            .set_default(false)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(pq_code_nbits)
+            .description("the bits of a pq code, 8 or 4.")
+            .set_default(8)
+            .set_range(4, 8)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(nav_graph_ratio)
+            .description("the ratio of the rows in the in-memory graph that finds the entry points of a search.")
+            .set_default(0.0f)
+            .set_range(0.0f, 1.0f)
+            .for_train();
         KNOWHERE_CONFIG_DECLARE_FIELD(accelerate_build)
             .description("a flag to enbale fast build.")
             .set_default(false)
@@ -125,13 +185,15 @@ class DiskANNConfig : public BaseConfig {
             .set_default(0)
             .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
             .for_train()
-            .for_deserialize();
+            .for_deserialize()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(search_cache_budget_gb)
             .description("the size of cached nodes in GB.")
             .set_default(0)
             .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
             .for_train()
-            .for_deserialize();
+            .for_deserialize()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(warm_up)
             .description("should do warm up before search.")
             .set_default(false)
@@ -140,6 +202,29 @@ class DiskANNConfig : public BaseConfig {
             .description("should bfs strategy to cache nodes.")
             .set_default(false)
             .for_deserialize();
+        KNOWHERE_CONFIG_DECLARE_FIELD(use_adaptive_cache)
+            .description("should the cached nodes follow the access frequency of the queries.")
+            .set_default(false)
+            .for_deserialize();
+        KNOWHERE_CONFIG_DECLARE_FIELD(interleave_queries)
+            .description("the number of queries each search thread interleaves the beam searches of.")
+            .set_default(1)
+            .set_range(1, 16)
+            .for_deserialize();
+        KNOWHERE_CONFIG_DECLARE_FIELD(remote_cache_dram_gb)
+            .description("the memory for the sectors of a remote disk index in GB.")
+            .set_default(0)
+            .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
+            .for_deserialize();
+        KNOWHERE_CONFIG_DECLARE_FIELD(remote_cache_ssd_gb)
+            .description("the local SSD space for the sectors of a remote disk index in GB.")
+            .set_default(0)
+            .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
+            .for_deserialize();
+        KNOWHERE_CONFIG_DECLARE_FIELD(remote_cache_dir)
+            .description("the local directory of the sector cache file of a remote disk index.")
+            .allow_empty_without_default()
+            .for_deserialize();
         KNOWHERE_CONFIG_DECLARE_FIELD(beamwidth)
             .description("the maximum number of IO requests each query will issue per iteration of search code.")
             .set_default(8)
@@ -163,6 +248,11 @@ class DiskANNConfig : public BaseConfig {
             .set_range(-1.0f, 1.0f)
             .for_search()
             .for_iterator();
+        KNOWHERE_CONFIG_DECLARE_FIELD(filter_label)
+            .description("the label of the rows to search, -1 for all rows.")
+            .set_default(-1)
+            .set_range(-1, std::numeric_limits<uint32_t>::max())
+            .for_search();
     }
 
     Status
@@ -172,6 +262,10 @@ class DiskANNConfig : public BaseConfig {
                 if (!search_list_size.has_value()) {
                     search_list_size = kDefaultSearchListSizeForBuild;
                 }
+                if (pq_code_nbits.value() != 4 && pq_code_nbits.value() != 8) {
+                    std::string msg = "pq_code_nbits(" + std::to_string(pq_code_nbits.value()) + ") should be 4 or 8";
+                    return HandleError(err_msg, msg, Status::invalid_args);
+                }
                 pq_code_budget_gb =
                     std::max(pq_code_budget_gb.value(), pq_code_budget_gb_ratio.value() * vec_field_size_gb.value());
                 search_cache_budget_gb = std::max(search_cache_budget_gb.value(),
@@ -0,0 +1,180 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef DISKANN_DELTA_H
+#define DISKANN_DELTA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "diskann/index.h"
+#include "knowhere/bitsetview.h"
+#include "knowhere/comp/rw_lock.h"
+
+namespace knowhere {
+
+// The rows added to a DiskANN index since its disk index was written, until a streaming merge appends them to it,
+// see diskann::merge_disk_index(). They are kept in memory, in a Vamana graph that accepts inserts while it is
+// searched. The graph is built on the vectors the disk graph sees, normalized for cosine, with L2 distances.
+template <typename DataType>
+class DiskANNDelta {
+ public:
+    DiskANNDelta(const diskann::Metric metric, const size_t dim, const int64_t base_id, const unsigned max_degree,
+                 const unsigned search_list_size)
+        : metric_(metric), dim_(dim), base_id_(base_id), max_degree_(max_degree) {
+        diskann::Parameters params;
+        params.Set<unsigned>("L", search_list_size);
+        params.Set<unsigned>("R", max_degree);
+        params.Set<unsigned>("C", 750);
+        params.Set<float>("alpha", 1.2f);
+        params.Set<bool>("saturate_graph", false);
+        diskann::Parameters search_params;
+        search_params.Set<unsigned>("L", search_list_size);
+        graph_ = std::make_unique<diskann::Index<DataType>>(diskann::Metric::L2, false, dim, kInitialCapacity, true,
+                                                            params, search_params, true);
+    }
+
+    // the rows get the ids from BaseId() + Count() on, adds must not run concurrently
+    void
+    Add(const DataType* data, const size_t rows) {
+        std::vector<DataType> vec(dim_);
+        for (size_t i = 0; i < rows; i++) {
+            ToGraphSpace(data + i * dim_, vec.data());
+            if (graph_->insert_point(vec.data(), static_cast<uint32_t>(count_.load() + i)) != 0) {
+                throw diskann::ANNException("failed to insert a row into the delta graph", -1);
+            }
+        }
+        std::unique_lock lock(mutex_);
+        data_.insert(data_.end(), data, data + rows * dim_);
+        count_.fetch_add(rows);
+    }
+
+    // the top k of the rows, with the ids of the index and the distances of the disk index: L2, or the cosine
+    //   similarity. The rest of ids is -1.
+    void
+    Search(const DataType* query, const size_t k, const unsigned lsearch, const BitsetView& bitset, int64_t* ids,
+           float* dists) const {
+        std::fill(ids, ids + k, -1);
+        std::fill(dists, dists + k, metric_ == diskann::Metric::COSINE ? -std::numeric_limits<float>::max()
+                                                                       : std::numeric_limits<float>::max());
+        if (count_.load() == 0) {
+            return;
+        }
+        // rows whose insert has not returned yet are not visible
+        const size_t count = count_.load();
+        const unsigned l = std::max<unsigned>(lsearch, k);
+        std::vector<DataType> vec(dim_);
+        ToGraphSpace(query, vec.data());
+        std::vector<uint32_t> tags(l);
+        std::vector<float> tag_dists(l);
+        std::vector<DataType*> res_vectors;
+        const size_t n = graph_->search_with_tags(vec.data(), l, l, tags.data(), tag_dists.data(), res_vectors);
+        size_t pos = 0;
+        for (size_t i = 0; i < n && pos < k; i++) {
+            const int64_t id = base_id_ + tags[i];
+            if (tags[i] >= count || (!bitset.empty() && bitset.test(id))) {
+                continue;
+            }
+            ids[pos] = id;
+            dists[pos] = metric_ == diskann::Metric::COSINE ? 1.0f - tag_dists[i] / 2.0f : tag_dists[i];
+            pos++;
+        }
+    }
+
+    // the raw vector of a row of the delta
+    void
+    GetVectorById(const int64_t id, DataType* out) const {
+        std::shared_lock lock(mutex_);
+        std::memcpy(out, data_.data() + (id - base_id_) * dim_, dim_ * sizeof(DataType));
+    }
+
+    // the raw rows, must not be called while rows are added
+    const DataType*
+    Data() const {
+        return data_.data();
+    }
+
+    // the neighbors of every row among the rows, by their offset. Must not be called while rows are added.
+    std::vector<std::vector<unsigned>>
+    Graph() const {
+        const auto* locations = graph_->get_tags();
+        const auto* graph = graph_->get_graph();
+        std::vector<std::vector<unsigned>> nbrs(count_.load());
+        for (const auto& [location, tag] : *locations) {
+            if (tag >= nbrs.size()) {
+                continue;
+            }
+            for (const unsigned nbr : (*graph)[location]) {
+                auto it = locations->find(nbr);
+                if (it != locations->end()) {
+                    nbrs[tag].push_back(it->second);
+                }
+            }
+        }
+        return nbrs;
+    }
+
+    int64_t
+    BaseId() const {
+        return base_id_;
+    }
+
+    size_t
+    Count() const {
+        return count_.load();
+    }
+
+    size_t
+    Size() const {
+        // the raw rows, their copies in the graph and the edges
+        return count_.load() * (dim_ * sizeof(DataType) * 2 + max_degree_ * sizeof(unsigned));
+    }
+
+ private:
+    static constexpr size_t kInitialCapacity = 1024;
+
+    void
+    ToGraphSpace(const DataType* vec, DataType* out) const {
+        if (metric_ != diskann::Metric::COSINE) {
+            std::memcpy(out, vec, dim_ * sizeof(DataType));
+            return;
+        }
+        float norm = 0;
+        for (size_t d = 0; d < dim_; d++) {
+            norm += (float)vec[d] * (float)vec[d];
+        }
+        norm = norm == 0 ? 1.0f : std::sqrt(norm);
+        for (size_t d = 0; d < dim_; d++) {
+            out[d] = (DataType)((float)vec[d] / norm);
+        }
+    }
+
+    const diskann::Metric metric_;
+    const size_t dim_;
+    const int64_t base_id_;
+    const unsigned max_degree_;
+    std::unique_ptr<diskann::Index<DataType>> graph_;
+    // guards the growth of data_
+    mutable ReaderBiasedRWLock mutex_;
+    std::vector<DataType> data_;
+    std::atomic<size_t> count_{0};
+};
+
+}  // namespace knowhere
+
+#endif /* DISKANN_DELTA_H */
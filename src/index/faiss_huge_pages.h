@@ -0,0 +1,129 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "faiss/IndexBinaryFlat.h"
+#include "faiss/IndexBinaryIVF.h"
+#include "faiss/IndexFlatCodes.h"
+#include "faiss/IndexHNSW.h"
+#include "faiss/IndexIVF.h"
+#include "faiss/IndexRefine.h"
+#include "faiss/impl/maybe_owned_vector.h"
+#include "faiss/invlists/InvertedLists.h"
+#include "knowhere/comp/huge_pages.h"
+
+namespace knowhere {
+
+struct HugePageOwner : faiss::MaybeOwnedVectorOwner {
+    explicit HugePageOwner(std::unique_ptr<HugePageBuffer> buffer) : buffer(std::move(buffer)) {
+    }
+
+    std::unique_ptr<HugePageBuffer> buffer;
+};
+
+// whether v can be written in place, it is owned or a view of a huge page buffer rather than of a mapped file
+template <typename T>
+inline bool
+IsWritableInPlace(const faiss::MaybeOwnedVector<T>& v) {
+    return v.is_owned || dynamic_cast<const HugePageOwner*>(v.owner.get()) != nullptr;
+}
+
+// Moves the owned arrays of faiss indexes into one huge page buffer, each of them becomes a view of it. Like the views
+//   of a mapped file, the arrays cannot grow afterwards.
+class HugePagePacker {
+ public:
+    template <typename T>
+    void
+    Add(faiss::MaybeOwnedVector<T>& v) {
+        if (!v.is_owned || v.size() == 0) {
+            return;
+        }
+        size_ = (size_ + kAlignment - 1) / kAlignment * kAlignment;
+        const size_t offset = size_;
+        size_ += v.size() * sizeof(T);
+        moves_.emplace_back([&v, offset](uint8_t* base, const std::shared_ptr<faiss::MaybeOwnedVectorOwner>& owner) {
+            const size_t n = v.size();
+            std::memcpy(base + offset, v.data(), n * sizeof(T));
+            v = faiss::MaybeOwnedVector<T>::create_view(base + offset, n, owner);
+        });
+    }
+
+    void
+    Add(faiss::InvertedLists* invlists) {
+        if (auto array = dynamic_cast<faiss::ArrayInvertedLists*>(invlists)) {
+            for (size_t i = 0; i < array->nlist; i++) {
+                Add(array->codes[i]);
+                Add(array->ids[i]);
+            }
+        }
+    }
+
+    void
+    Add(faiss::Index* index) {
+        if (auto index_refine = dynamic_cast<faiss::IndexRefine*>(index)) {
+            Add(index_refine->base_index);
+            Add(index_refine->refine_index);
+        } else if (auto index_hnsw = dynamic_cast<faiss::IndexHNSW*>(index)) {
+            Add(index_hnsw->hnsw.levels);
+            Add(index_hnsw->hnsw.offsets);
+            Add(index_hnsw->hnsw.neighbors);
+            Add(index_hnsw->storage);
+        } else if (auto index_flat = dynamic_cast<faiss::IndexFlatCodes*>(index)) {
+            Add(index_flat->codes);
+        } else if (auto index_ivf = dynamic_cast<faiss::IndexIVF*>(index)) {
+            Add(index_ivf->quantizer);
+            Add(index_ivf->invlists);
+        }
+    }
+
+    void
+    Add(faiss::IndexBinary* index) {
+        if (auto index_flat = dynamic_cast<faiss::IndexBinaryFlat*>(index)) {
+            Add(index_flat->xb);
+        } else if (auto index_ivf = dynamic_cast<faiss::IndexBinaryIVF*>(index)) {
+            Add(index_ivf->invlists);
+        }
+    }
+
+    // returns the bytes the buffer holds beyond the arrays, 0 if the arrays are too small for a huge page or no buffer
+    //   could be mapped, in which case they are left as they are
+    size_t
+    Pack() {
+        if (size_ < kHugePageSize) {
+            return 0;
+        }
+        auto buffer = HugePageBuffer::Allocate(size_);
+        if (buffer == nullptr) {
+            return 0;
+        }
+        auto owner = std::make_shared<HugePageOwner>(std::move(buffer));
+        for (auto& move : moves_) {
+            move(owner->buffer->data(), owner);
+        }
+        moves_.clear();
+        return owner->buffer->capacity() - size_;
+    }
+
+ private:
+    static constexpr size_t kAlignment = 64;
+
+    size_t size_ = 0;
+    std::vector<std::function<void(uint8_t*, const std::shared_ptr<faiss::MaybeOwnedVectorOwner>&)>> moves_;
+};
+
+}  // namespace knowhere
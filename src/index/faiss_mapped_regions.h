@@ -0,0 +1,85 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License
+
+#pragma once
+
+#include <vector>
+
+#include "faiss/IndexBinaryFlat.h"
+#include "faiss/IndexBinaryIVF.h"
+#include "faiss/IndexFlatCodes.h"
+#include "faiss/IndexHNSW.h"
+#include "faiss/IndexIVF.h"
+#include "faiss/IndexRefine.h"
+#include "faiss/impl/maybe_owned_vector.h"
+#include "faiss/invlists/InvertedLists.h"
+#include "faiss/invlists/OnDiskInvertedLists.h"
+#include "knowhere/comp/warm_up.h"
+
+namespace knowhere {
+
+// The memory of faiss indexes that is mapped from a file, either the views that faiss::IO_FLAG_MMAP_IFC reads or the
+//   inverted lists that faiss::IO_FLAG_MMAP reads. The graphs and the centroids are the structure regions.
+template <typename T>
+inline void
+AppendMappedRegion(const faiss::MaybeOwnedVector<T>& v, bool structure, std::vector<MappedRegion>& regions) {
+    if (!v.is_owned && v.size() > 0) {
+        regions.push_back(MappedRegion{v.data(), v.size() * sizeof(T), structure});
+    }
+}
+
+inline void
+AppendMappedRegions(const faiss::InvertedLists* invlists, std::vector<MappedRegion>& regions) {
+    if (auto on_disk = dynamic_cast<const faiss::OnDiskInvertedLists*>(invlists)) {
+        if (on_disk->read_only && on_disk->ptr != nullptr) {
+            regions.push_back(MappedRegion{on_disk->ptr, on_disk->totsize, false});
+        }
+    } else if (auto array = dynamic_cast<const faiss::ArrayInvertedLists*>(invlists)) {
+        for (size_t i = 0; i < array->nlist; i++) {
+            AppendMappedRegion(array->codes[i], false, regions);
+            AppendMappedRegion(array->ids[i], false, regions);
+        }
+    }
+}
+
+inline void
+AppendMappedRegions(const faiss::Index* index, std::vector<MappedRegion>& regions) {
+    if (auto index_refine = dynamic_cast<const faiss::IndexRefine*>(index)) {
+        AppendMappedRegions(index_refine->base_index, regions);
+        AppendMappedRegions(index_refine->refine_index, regions);
+    } else if (auto index_hnsw = dynamic_cast<const faiss::IndexHNSW*>(index)) {
+        AppendMappedRegion(index_hnsw->hnsw.levels, true, regions);
+        AppendMappedRegion(index_hnsw->hnsw.offsets, true, regions);
+        AppendMappedRegion(index_hnsw->hnsw.neighbors, true, regions);
+        AppendMappedRegions(index_hnsw->storage, regions);
+    } else if (auto index_flat = dynamic_cast<const faiss::IndexFlatCodes*>(index)) {
+        AppendMappedRegion(index_flat->codes, false, regions);
+    } else if (auto index_ivf = dynamic_cast<const faiss::IndexIVF*>(index)) {
+        std::vector<MappedRegion> centroids;
+        AppendMappedRegions(index_ivf->quantizer, centroids);
+        for (auto& region : centroids) {
+            region.structure = true;
+            regions.push_back(region);
+        }
+        AppendMappedRegions(index_ivf->invlists, regions);
+    }
+}
+
+inline void
+AppendMappedRegions(const faiss::IndexBinary* index, std::vector<MappedRegion>& regions) {
+    if (auto index_flat = dynamic_cast<const faiss::IndexBinaryFlat*>(index)) {
+        AppendMappedRegion(index_flat->xb, false, regions);
+    } else if (auto index_ivf = dynamic_cast<const faiss::IndexBinaryIVF*>(index)) {
+        AppendMappedRegions(index_ivf->invlists, regions);
+    }
+}
+
+}  // namespace knowhere
@@ -0,0 +1,472 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "common/metric.h"
+#include "faiss/IndexBinaryFlat.h"
+#include "faiss/IndexBinaryHash.h"
+#include "faiss/index_io.h"
+#include "faiss/utils/hamming.h"
+#include "index/flat/flat_config.h"
+#include "io/memory_io.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/feature.h"
+#include "knowhere/index/index_factory.h"
+#include "knowhere/log.h"
+#include "knowhere/range_util.h"
+#include "knowhere/utils.h"
+
+namespace knowhere {
+
+namespace {
+
+// the longest substring, the key of a hash table
+constexpr int kMaxSubstringBits = 32;
+
+// the fewest substrings that split a code of dim bits evenly, with about log2(rows) bits each so that the buckets
+//   hold a few rows
+int
+AutoNumSubstrings(int64_t dim, int64_t rows) {
+    const int64_t bits =
+        std::clamp<int64_t>(std::llround(std::log2(std::max<int64_t>(rows, 2))), 8, kMaxSubstringBits);
+    for (int64_t nhash = 1; nhash < dim; nhash++) {
+        if (dim % nhash == 0 && dim / nhash <= bits) {
+            return nhash;
+        }
+    }
+    return dim;
+}
+
+// calls visit() on all the b-bit masks with exactly f bits set, with Gosper's hack
+template <typename Visit>
+void
+ForEachFlip(int b, int f, Visit visit) {
+    if (f == 0) {
+        visit(uint64_t{0});
+        return;
+    }
+    const uint64_t end = uint64_t{1} << b;
+    for (uint64_t x = (uint64_t{1} << f) - 1; x < end;) {
+        visit(x);
+        const uint64_t c = x & -x;
+        const uint64_t r = x + c;
+        x = (((r ^ x) >> 2) / c) | r;
+    }
+}
+
+}  // namespace
+
+// BIN_MIH (multi-index hashing) splits the codes into nhash substrings of b bits, each the key of a hash table of
+//   faiss::IndexBinaryMultiHash, which also keeps the codes. A row within hamming distance r of a query has a
+//   substring within r / nhash bits of the query one, so probing the buckets up to f bits away from the query
+//   substrings finds all the rows closer than nhash * (f + 1).
+// A kNN search probes with f = 0, 1, ..., mih_max_flip until the k closest candidates are closer than that bound,
+//   and scans all the codes when they are not. Either way the results are exact.
+template <typename DataType>
+class BinMihIndexNode : public IndexNode {
+ public:
+    BinMihIndexNode(const int32_t version, const Object& object) : IndexNode(version), index_(nullptr) {
+        search_pool_ = ThreadPool::GetGlobalSearchThreadPool();
+    }
+
+    Status
+    Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        const BinMihConfig& mih_cfg = static_cast<const BinMihConfig&>(*cfg);
+        if (!IsMetricType(mih_cfg.metric_type.value(), metric::HAMMING)) {
+            LOG_KNOWHERE_ERROR_ << "unsupported metric type: " << mih_cfg.metric_type.value();
+            return Status::invalid_metric_type;
+        }
+
+        auto dim = dataset->GetDim();
+        auto rows = dataset->GetRows();
+        int64_t nhash = mih_cfg.mih_nhash.value();
+        if (nhash == 0) {
+            nhash = AutoNumSubstrings(dim, rows);
+        }
+        if (nhash > dim || dim % nhash != 0 || dim / nhash > kMaxSubstringBits) {
+            LOG_KNOWHERE_ERROR_ << "mih_nhash " << nhash << " doesn't split a code of " << dim << " bits into "
+                                << "substrings of at most " << kMaxSubstringBits << " bits.";
+            return Status::invalid_args;
+        }
+        try {
+            index_ = std::make_unique<faiss::IndexBinaryMultiHash>(dim, nhash, dim / nhash);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+
+    Status
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not add data to empty BIN_MIH index.";
+            return Status::empty_index;
+        }
+        try {
+            index_->add(dataset->GetRows(), static_cast<const uint8_t*>(dataset->GetTensor()));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+
+    expected<DataSetPtr>
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_WARNING_ << "search on empty index";
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+
+        const BinMihConfig& mih_cfg = static_cast<const BinMihConfig&>(*cfg);
+        auto k = mih_cfg.k.value();
+        int max_flip = mih_cfg.mih_max_flip.value();
+        auto nq = dataset->GetRows();
+        auto x = static_cast<const uint8_t*>(dataset->GetTensor());
+
+        auto len = k * nq;
+        auto ids = std::make_unique<int64_t[]>(len);
+        auto distances = std::make_unique<float[]>(len);
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(nq);
+            for (int i = 0; i < nq; ++i) {
+                futs.emplace_back(search_pool_->push([&, index = i] {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+                    SearchOne(x + index * index_->code_size, k, max_flip, bitset, distances.get() + k * index,
+                              ids.get() + k * index);
+                }));
+            }
+            // wait for the completion
+            WaitAllSuccess(futs);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+        return GenResultDataSet(nq, k, std::move(ids), std::move(distances));
+    }
+
+    // the rows within radius are all in the buckets up to (radius - 1) / nhash bits away from the query substrings,
+    //   the codes are scanned when that is more than mih_max_flip
+    expected<DataSetPtr>
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_WARNING_ << "range search on empty index";
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+
+        const BinMihConfig& mih_cfg = static_cast<const BinMihConfig&>(*cfg);
+        auto nq = dataset->GetRows();
+        auto x = static_cast<const uint8_t*>(dataset->GetTensor());
+        float radius = mih_cfg.radius.value();
+        float range_filter = mih_cfg.range_filter.value();
+        int max_flip = mih_cfg.mih_max_flip.value();
+        auto range_search_k = mih_cfg.range_search_k.value();
+
+        std::vector<std::vector<int64_t>> result_id_array(nq);
+        std::vector<std::vector<float>> result_dist_array(nq);
+        RangeSearchResult range_search_result;
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(nq);
+            for (int i = 0; i < nq; ++i) {
+                futs.emplace_back(search_pool_->push([&, index = i] {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+                    auto& dists = result_dist_array[index];
+                    auto& labels = result_id_array[index];
+                    RangeSearchOne(x + index * index_->code_size, radius, range_filter, max_flip, bitset, dists,
+                                   labels);
+                    if (range_search_k >= 0 && labels.size() > static_cast<size_t>(range_search_k)) {
+                        TruncateToClosest(range_search_k, dists, labels);
+                    }
+                }));
+            }
+            // wait for the completion
+            WaitAllSuccess(futs);
+            range_search_result =
+                GetRangeSearchResult(result_dist_array, result_id_array, false, nq, radius, range_filter);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+        return GenResultDataSet(nq, std::move(range_search_result));
+    }
+
+    expected<DataSetPtr>
+    GetVectorByIds(const DataSetPtr dataset) const override {
+        if (!index_) {
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+        auto rows = dataset->GetRows();
+        auto ids = dataset->GetIds();
+        const size_t code_size = index_->code_size;
+        auto data = std::make_unique<uint8_t[]>(rows * code_size);
+        for (int64_t i = 0; i < rows; i++) {
+            if (ids[i] < 0 || ids[i] >= index_->ntotal) {
+                return expected<DataSetPtr>::Err(Status::invalid_args, "id out of range");
+            }
+            std::memcpy(data.get() + i * code_size, index_->storage->xb.data() + ids[i] * code_size, code_size);
+        }
+        return GenResultDataSet(rows, Dim(), std::move(data));
+    }
+
+    static bool
+    StaticHasRawData(const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return true;
+    }
+
+    bool
+    HasRawData(const std::string& metric_type) const override {
+        return true;
+    }
+
+    expected<DataSetPtr>
+    GetIndexMeta(std::unique_ptr<Config>) const override {
+        return expected<DataSetPtr>::Err(Status::not_implemented, "GetIndexMeta not implemented");
+    }
+
+    Status
+    Serialize(BinarySet& binset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not serialize empty index.";
+            return Status::empty_index;
+        }
+        try {
+            ChunkedMemoryIOWriter writer;
+            faiss::write_index_binary(index_.get(), &writer);
+            binset.AppendChunks(Type(), writer.Release(), writer.tellg());
+            return Status::success;
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+        }
+        return Status::faiss_inner_error;
+    }
+
+    Status
+    Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override {
+        auto binary = binset.GetByName(Type());
+        if (binary == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+        try {
+            MemoryIOReader reader(binary->data.get(), binary->size);
+            return ResetIndex(faiss::read_index_binary(&reader));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+        }
+        return Status::faiss_inner_error;
+    }
+
+    Status
+    DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> cfg) override {
+        try {
+            return ResetIndex(faiss::read_index_binary(filename.data()));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+        }
+        return Status::faiss_inner_error;
+    }
+
+    static std::unique_ptr<BaseConfig>
+    StaticCreateConfig() {
+        return std::make_unique<BinMihConfig>();
+    }
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return StaticCreateConfig();
+    }
+
+    int64_t
+    Dim() const override {
+        return index_ ? index_->d : 0;
+    }
+
+    // the codes and the ids in the buckets of every hash table
+    int64_t
+    Size() const override {
+        if (!index_) {
+            return 0;
+        }
+        return index_->ntotal * (index_->code_size + index_->nhash * sizeof(faiss::idx_t));
+    }
+
+    int64_t
+    Count() const override {
+        return index_ ? index_->ntotal : 0;
+    }
+
+    std::string
+    Type() const override {
+        return knowhere::IndexEnum::INDEX_FAISS_BIN_MIH;
+    }
+
+ private:
+    Status
+    ResetIndex(faiss::IndexBinary* index) {
+        auto mih = dynamic_cast<faiss::IndexBinaryMultiHash*>(index);
+        if (mih == nullptr) {
+            delete index;
+            LOG_KNOWHERE_ERROR_ << "Invalid BIN_MIH binary.";
+            return Status::invalid_binary_set;
+        }
+        index_.reset(mih);
+        return Status::success;
+    }
+
+    bool
+    Filtered(const BitsetView& bitset, int64_t id) const {
+        return !bitset.empty() && bitset.test(id);
+    }
+
+    // calls visit(id) once on every row in the buckets of the query substrings up to max_flip bits away
+    template <typename Visit>
+    void
+    ProbeBuckets(const uint8_t* q, int min_flip, int max_flip, std::unordered_set<int64_t>& seen, Visit visit) const {
+        for (int h = 0; h < index_->nhash; h++) {
+            const uint64_t qhash = index_->hash_of(q, h);
+            const auto& map = index_->maps[h];
+            for (int f = min_flip; f <= std::min(max_flip, index_->b); f++) {
+                ForEachFlip(index_->b, f, [&](uint64_t flip) {
+                    auto it = map.find(qhash ^ flip);
+                    if (it == map.end()) {
+                        return;
+                    }
+                    for (auto id : it->second) {
+                        if (seen.insert(id).second) {
+                            visit(id);
+                        }
+                    }
+                });
+            }
+        }
+    }
+
+    void
+    SearchOne(const uint8_t* q, int64_t k, int max_flip, const BitsetView& bitset, float* distances,
+              int64_t* ids) const {
+        const size_t code_size = index_->code_size;
+        const uint8_t* codes = index_->storage->xb.data();
+        faiss::HammingComputerDefault hc(q, code_size);
+        // a max-heap of the k closest candidates
+        std::priority_queue<std::pair<int32_t, int64_t>> heap;
+        auto push = [&](int64_t id) {
+            if (Filtered(bitset, id)) {
+                return;
+            }
+            const int32_t dis = hc.compute(codes + id * code_size);
+            if (static_cast<int64_t>(heap.size()) < k) {
+                heap.emplace(dis, id);
+            } else if (dis < heap.top().first) {
+                heap.pop();
+                heap.emplace(dis, id);
+            }
+        };
+
+        bool exact = false;
+        std::unordered_set<int64_t> seen;
+        for (int f = 0; f <= max_flip && !exact; f++) {
+            ProbeBuckets(q, f, f, seen, push);
+            // every row closer than nhash * (f + 1) has been seen, and so have all the rows once f reaches b
+            exact = (static_cast<int64_t>(heap.size()) == k && heap.top().first < index_->nhash * (f + 1)) ||
+                    f >= index_->b;
+        }
+        if (!exact) {
+            for (int64_t id = 0; id < index_->ntotal; id++) {
+                if (seen.count(id) == 0) {
+                    push(id);
+                }
+            }
+        }
+
+        for (int64_t j = k - 1; j >= 0; j--) {
+            if (j >= static_cast<int64_t>(heap.size())) {
+                ids[j] = -1;
+                distances[j] = std::numeric_limits<float>::max();
+                continue;
+            }
+            distances[j] = static_cast<float>(heap.top().first);
+            ids[j] = heap.top().second;
+            heap.pop();
+        }
+    }
+
+    void
+    RangeSearchOne(const uint8_t* q, float radius, float range_filter, int max_flip, const BitsetView& bitset,
+                   std::vector<float>& distances, std::vector<int64_t>& labels) const {
+        // the distances are integers, the closest ones are below radius
+        const int64_t max_dis = static_cast<int64_t>(std::ceil(radius)) - 1;
+        if (max_dis < 0) {
+            return;
+        }
+        const size_t code_size = index_->code_size;
+        const uint8_t* codes = index_->storage->xb.data();
+        faiss::HammingComputerDefault hc(q, code_size);
+        auto add = [&](int64_t id) {
+            if (Filtered(bitset, id)) {
+                return;
+            }
+            const float dis = hc.compute(codes + id * code_size);
+            if (distance_in_range(dis, radius, range_filter, false)) {
+                distances.push_back(dis);
+                labels.push_back(id);
+            }
+        };
+
+        const int64_t flip = max_dis / index_->nhash;
+        if (flip <= max_flip || flip >= index_->b) {
+            std::unordered_set<int64_t> seen;
+            ProbeBuckets(q, 0, static_cast<int>(std::min<int64_t>(flip, index_->b)), seen, add);
+        } else {
+            for (int64_t id = 0; id < index_->ntotal; id++) {
+                add(id);
+            }
+        }
+    }
+
+    // keeps the k closest of the results of a range search
+    static void
+    TruncateToClosest(int64_t k, std::vector<float>& distances, std::vector<int64_t>& labels) {
+        std::vector<size_t> order(labels.size());
+        for (size_t j = 0; j < order.size(); j++) {
+            order[j] = j;
+        }
+        std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                          [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+        std::vector<float> closest_distances(k);
+        std::vector<int64_t> closest_labels(k);
+        for (int64_t j = 0; j < k; j++) {
+            closest_distances[j] = distances[order[j]];
+            closest_labels[j] = labels[order[j]];
+        }
+        distances = std::move(closest_distances);
+        labels = std::move(closest_labels);
+    }
+
+    std::unique_ptr<faiss::IndexBinaryMultiHash> index_;
+    std::shared_ptr<ThreadPool> search_pool_;
+};
+
+KNOWHERE_SIMPLE_REGISTER_DENSE_BIN_GLOBAL(BIN_MIH, BinMihIndexNode, knowhere::feature::KNN)
+
+}  // namespace knowhere
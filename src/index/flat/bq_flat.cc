@@ -0,0 +1,337 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/metric.h"
+#include "faiss/IndexFlatCodes.h"
+#include "faiss/IndexLSH.h"
+#include "faiss/IndexRefine.h"
+#include "faiss/index_io.h"
+#include "index/faiss_mapped_regions.h"
+#include "index/flat/flat_config.h"
+#include "index/refine/refine_utils.h"
+#include "io/file_io.h"
+#include "io/memory_io.h"
+#include "knowhere/bitsetview_idselector.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/feature.h"
+#include "knowhere/index/index_factory.h"
+#include "knowhere/index/index_node_data_mock_wrapper.h"
+#include "knowhere/log.h"
+#include "knowhere/utils.h"
+
+namespace knowhere {
+
+// BQ_FLAT keeps the sign bit of every dimension of the rows in a faiss::IndexLSH and a copy of the rows in a refine
+//   index. A search scans the bits of all the rows with the popcount kernels for the refine_k * k closest in hamming
+//   distance to the bits of the query, then rescores them against the refine index with the float query.
+// The rows come as fp32, fp16 and bf16 ones are converted by IndexNodeDataMockWrapper.
+template <typename DataType>
+class BqFlatIndexNode : public IndexNode {
+ public:
+    BqFlatIndexNode(const int32_t version, const Object& object) : IndexNode(version), index_(nullptr) {
+        search_pool_ = ThreadPool::GetGlobalSearchThreadPool();
+    }
+
+    Status
+    Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        const BqFlatConfig& bq_cfg = static_cast<const BqFlatConfig&>(*cfg);
+
+        auto metric = Str2FaissMetricType(bq_cfg.metric_type.value());
+        if (!metric.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "unsupported metric type: " << bq_cfg.metric_type.value();
+            return metric.error();
+        }
+        if (metric.value() != faiss::METRIC_L2 && metric.value() != faiss::METRIC_INNER_PRODUCT) {
+            LOG_KNOWHERE_ERROR_ << "unsupported metric type: " << bq_cfg.metric_type.value();
+            return Status::invalid_metric_type;
+        }
+        is_cosine_ = IsMetricType(bq_cfg.metric_type.value(), knowhere::metric::COSINE);
+
+        auto dim = dataset->GetDim();
+        auto rows = dataset->GetRows();
+        try {
+            // a bit per dimension, taken from the sign of the component
+            auto lsh = std::make_unique<faiss::IndexLSH>(dim, dim, false, false);
+            // the refine index has to share the metric of its base
+            lsh->metric_type = metric.value();
+            auto refine = pick_refine_index(datatype_v<DataType>, bq_cfg.refine_type, std::move(lsh), dim,
+                                            metric.value());
+            if (!refine.has_value()) {
+                LOG_KNOWHERE_ERROR_ << "invalid refine type: " << bq_cfg.refine_type.value_or("");
+                return refine.error();
+            }
+
+            auto x = static_cast<const float*>(dataset->GetTensor());
+            std::unique_ptr<float[]> copied_data = nullptr;
+            if (is_cosine_) {
+                copied_data = CopyAndNormalizeVecs(x, rows, dim);
+                x = copied_data.get();
+            }
+            refine.value()->train(rows, x);
+            // pick_refine_index() gives either an IndexRefine or an IndexRefineFlat
+            index_.reset(static_cast<faiss::IndexRefine*>(refine.value().release()));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+
+    Status
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not add data to empty BQ_FLAT index.";
+            return Status::empty_index;
+        }
+        auto x = static_cast<const float*>(dataset->GetTensor());
+        auto rows = dataset->GetRows();
+        try {
+            std::unique_ptr<float[]> copied_data = nullptr;
+            if (is_cosine_) {
+                copied_data = CopyAndNormalizeVecs(x, rows, index_->d);
+                x = copied_data.get();
+            }
+            index_->add(rows, x);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+
+    expected<DataSetPtr>
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_WARNING_ << "search on empty index";
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+
+        const BqFlatConfig& bq_cfg = static_cast<const BqFlatConfig&>(*cfg);
+        bool is_cosine = IsMetricType(bq_cfg.metric_type.value(), knowhere::metric::COSINE);
+
+        auto k = bq_cfg.k.value();
+        auto refine_k = bq_cfg.refine_k.value();
+        auto nq = dataset->GetRows();
+        auto x = static_cast<const float*>(dataset->GetTensor());
+        auto dim = dataset->GetDim();
+
+        auto len = k * nq;
+        auto ids = std::make_unique<int64_t[]>(len);
+        auto distances = std::make_unique<float[]>(len);
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(nq);
+            for (int i = 0; i < nq; ++i) {
+                futs.emplace_back(search_pool_->push([&, index = i] {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+                    auto cur_query = x + dim * index;
+                    if (is_cosine) {
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
+                    }
+
+                    BitsetViewIDSelector bw_idselector(bitset);
+                    faiss::SearchParameters base_params;
+                    base_params.sel = (bitset.empty()) ? nullptr : &bw_idselector;
+
+                    faiss::IndexRefineSearchParameters search_params;
+                    search_params.k_factor = refine_k;
+                    search_params.base_index_params = &base_params;
+
+                    index_->search(1, cur_query, k, distances.get() + k * index, ids.get() + k * index,
+                                   &search_params);
+                }));
+            }
+            // wait for the completion
+            WaitAllSuccess(futs);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+        return GenResultDataSet(nq, k, std::move(ids), std::move(distances));
+    }
+
+    // a radius is given in the metric of the rows, the candidates come in hamming distances
+    expected<DataSetPtr>
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        return expected<DataSetPtr>::Err(Status::not_implemented, "BQ_FLAT does not support range search");
+    }
+
+    expected<DataSetPtr>
+    GetVectorByIds(const DataSetPtr dataset) const override {
+        if (!index_) {
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+        auto dim = Dim();
+        auto rows = dataset->GetRows();
+        auto ids = dataset->GetIds();
+        try {
+            auto data = std::make_unique<float[]>(rows * dim);
+            for (int64_t i = 0; i < rows; i++) {
+                index_->reconstruct(ids[i], data.get() + i * dim);
+            }
+            return GenResultDataSet(rows, dim, std::move(data));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+    }
+
+    // the rows are kept as they came only by a fp32 refine, and cosine rows are normalized
+    static bool
+    StaticHasRawData(const knowhere::BaseConfig& config, const IndexVersion& version) {
+        const BqFlatConfig& bq_cfg = static_cast<const BqFlatConfig&>(config);
+        if (IsMetricType(bq_cfg.metric_type.value(), metric::COSINE)) {
+            return false;
+        }
+        auto flat_refine = is_flat_refine(bq_cfg.refine_type);
+        return flat_refine.has_value() && flat_refine.value();
+    }
+
+    bool
+    HasRawData(const std::string& metric_type) const override {
+        if (!index_ || IsMetricType(metric_type, metric::COSINE)) {
+            return false;
+        }
+        return dynamic_cast<const faiss::IndexRefineFlat*>(index_.get()) != nullptr;
+    }
+
+    expected<DataSetPtr>
+    GetIndexMeta(std::unique_ptr<Config>) const override {
+        return expected<DataSetPtr>::Err(Status::not_implemented, "GetIndexMeta not implemented");
+    }
+
+    Status
+    Serialize(BinarySet& binset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not serialize empty index.";
+            return Status::empty_index;
+        }
+        try {
+            ChunkedMemoryIOWriter writer;
+            faiss::write_index(index_.get(), &writer);
+            binset.AppendChunks(Type(), writer.Release(), writer.tellg());
+            return Status::success;
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return Status::faiss_inner_error;
+        }
+    }
+
+    Status
+    Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override {
+        auto binary = binset.GetByName(Type());
+        if (binary == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+        try {
+            MemoryIOReader reader(binary->data.get(), binary->size);
+            RETURN_IF_ERROR(ResetIndex(faiss::read_index(&reader), *cfg));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+
+    Status
+    DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> cfg) override {
+        const auto& base_cfg = static_cast<const knowhere::BaseConfig&>(*cfg);
+        int io_flags = 0;
+        if (base_cfg.enable_mmap.value()) {
+            io_flags |= faiss::IO_FLAG_MMAP_IFC;
+        }
+        try {
+            RETURN_IF_ERROR(ResetIndex(faiss::read_index(filename.data(), io_flags), *cfg));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+
+    static std::unique_ptr<BaseConfig>
+    StaticCreateConfig() {
+        return std::make_unique<BqFlatConfig>();
+    }
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return StaticCreateConfig();
+    }
+
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        std::vector<MappedRegion> regions;
+        if (index_ != nullptr) {
+            AppendMappedRegions(index_->base_index, regions);
+            AppendMappedRegions(index_->refine_index, regions);
+        }
+        return regions;
+    }
+
+    int64_t
+    Dim() const override {
+        return index_ ? index_->d : 0;
+    }
+
+    int64_t
+    Size() const override {
+        if (!index_) {
+            return 0;
+        }
+        int64_t size = 0;
+        for (const faiss::Index* index : {index_->base_index, index_->refine_index}) {
+            if (auto index_codes = dynamic_cast<const faiss::IndexFlatCodes*>(index)) {
+                size += index_codes->ntotal * index_codes->code_size;
+            }
+        }
+        return size;
+    }
+
+    int64_t
+    Count() const override {
+        return index_ ? index_->ntotal : 0;
+    }
+
+    std::string
+    Type() const override {
+        return knowhere::IndexEnum::INDEX_FAISS_BQ_FLAT;
+    }
+
+ private:
+    Status
+    ResetIndex(faiss::Index* index, const Config& config) {
+        auto refine = dynamic_cast<faiss::IndexRefine*>(index);
+        if (refine == nullptr || dynamic_cast<const faiss::IndexLSH*>(refine->base_index) == nullptr) {
+            delete index;
+            LOG_KNOWHERE_ERROR_ << "Invalid BQ_FLAT binary.";
+            return Status::invalid_binary_set;
+        }
+        index_.reset(refine);
+        is_cosine_ = IsMetricType(static_cast<const BaseConfig&>(config).metric_type.value(), metric::COSINE);
+        return Status::success;
+    }
+
+    std::unique_ptr<faiss::IndexRefine> index_;
+    // the rows are normalized before they are added
+    bool is_cosine_ = false;
+    std::shared_ptr<ThreadPool> search_pool_;
+};
+
+KNOWHERE_MOCK_REGISTER_DENSE_FLOAT_ALL_GLOBAL(BQ_FLAT, BqFlatIndexNode,
+                                              knowhere::feature::KNN | knowhere::feature::MMAP)
+
+}  // namespace knowhere
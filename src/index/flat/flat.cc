@@ -9,21 +9,30 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <sys/mman.h>
+
+#include <cmath>
+#include <cstring>
+
 #include "common/metric.h"
 #include "faiss/IndexBinaryFlat.h"
 #include "faiss/IndexFlat.h"
 #include "faiss/impl/AuxIndexStructures.h"
 #include "faiss/index_io.h"
+#include "faiss/utils/distances_typed.h"
+#include "index/faiss_huge_pages.h"
+#include "index/faiss_mapped_regions.h"
 #include "index/flat/flat_config.h"
+#include "io/file_io.h"
 #include "io/memory_io.h"
 #include "knowhere/bitsetview_idselector.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/feature.h"
 #include "knowhere/index/index_factory.h"
-#include "knowhere/index/index_node_data_mock_wrapper.h"
 #include "knowhere/log.h"
 #include "knowhere/range_util.h"
 #include "knowhere/utils.h"
+#include "simd/hook.h"
 
 namespace knowhere {
 
@@ -55,6 +64,7 @@ class FlatIndexNode : public IndexNode {
             bool is_cosine = IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE);
             index_ = std::make_unique<faiss::IndexFlat>(dataset->GetDim(), metric.value(), is_cosine);
         }
+        huge_page_overhead_ = 0;
         return Status::success;
     }
 
@@ -66,6 +76,11 @@ class FlatIndexNode : public IndexNode {
         return Status::success;
     }
 
+    bool
+    IsIncrementalAddSupported() const override {
+        return true;
+    }
+
     expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
         if (!index_) {
@@ -102,7 +117,8 @@ class FlatIndexNode : public IndexNode {
                     if constexpr (std::is_same<IndexType, faiss::IndexFlat>::value) {
                         auto cur_query = (const DataType*)x + dim * index;
                         std::unique_ptr<DataType[]> copied_query = nullptr;
-                        if (is_cosine) {
+                        // indexes with the cosine flag divide by the query norms themselves
+                        if (is_cosine && !index_->is_cosine) {
                             copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
                             cur_query = copied_query.get();
                         }
@@ -177,7 +193,8 @@ class FlatIndexNode : public IndexNode {
                     if constexpr (std::is_same<IndexType, faiss::IndexFlat>::value) {
                         auto cur_query = (const DataType*)xq + dim * index;
                         std::unique_ptr<DataType[]> copied_query = nullptr;
-                        if (is_cosine) {
+                        // indexes with the cosine flag divide by the query norms themselves
+                        if (is_cosine && !index_->is_cosine) {
                             copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
                             cur_query = copied_query.get();
                         }
@@ -296,15 +313,14 @@ class FlatIndexNode : public IndexNode {
             return Status::empty_index;
         }
         try {
-            MemoryIOWriter writer;
+            ChunkedMemoryIOWriter writer;
             if constexpr (std::is_same<IndexType, faiss::IndexFlat>::value) {
                 faiss::write_index(index_.get(), &writer);
             }
             if constexpr (std::is_same<IndexType, faiss::IndexBinaryFlat>::value) {
                 faiss::write_index_binary(index_.get(), &writer);
             }
-            std::shared_ptr<uint8_t[]> data(writer.data());
-            binset.Append(Type(), data, writer.tellg());
+            binset.AppendChunks(Type(), writer.Release(), writer.tellg());
             return Status::success;
         } catch (const std::exception& e) {
             LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
@@ -313,7 +329,29 @@ class FlatIndexNode : public IndexNode {
     }
 
     Status
-    Deserialize(const BinarySet& binset, std::shared_ptr<Config>) override {
+    SerializeToFile(const std::string& filename) const override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not serialize empty index.";
+            return Status::empty_index;
+        }
+        try {
+            FileWriter writer(filename);
+            if constexpr (std::is_same<IndexType, faiss::IndexFlat>::value) {
+                faiss::write_index(index_.get(), &writer);
+            }
+            if constexpr (std::is_same<IndexType, faiss::IndexBinaryFlat>::value) {
+                faiss::write_index_binary(index_.get(), &writer);
+            }
+            writer.close();
+            return Status::success;
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "failed to serialize " << Type() << " to " << filename << ": " << e.what();
+            return Status::disk_file_error;
+        }
+    }
+
+    Status
+    Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override {
         std::vector<std::string> names = {"IVF",        // compatible with knowhere-1.x
                                           "BinaryIVF",  // compatible with knowhere-1.x
                                           Type()};
@@ -332,6 +370,7 @@ class FlatIndexNode : public IndexNode {
             faiss::IndexBinary* index = faiss::read_index_binary(&reader);
             index_.reset(static_cast<IndexType*>(index));
         }
+        huge_page_overhead_ = MoveToHugePagesIfRequested(*cfg);
         return Status::success;
     }
 
@@ -352,6 +391,7 @@ class FlatIndexNode : public IndexNode {
             faiss::IndexBinary* index = faiss::read_index_binary(filename.data(), io_flags);
             index_.reset(static_cast<IndexType*>(index));
         }
+        huge_page_overhead_ = flat_cfg.enable_mmap.value() ? 0 : MoveToHugePagesIfRequested(*cfg);
         return Status::success;
     }
 
@@ -365,6 +405,15 @@ class FlatIndexNode : public IndexNode {
         return StaticCreateConfig();
     }
 
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        std::vector<MappedRegion> regions;
+        if (index_ != nullptr) {
+            AppendMappedRegions(index_.get(), regions);
+        }
+        return regions;
+    }
+
     int64_t
     Dim() const override {
         return index_->d;
@@ -372,7 +421,24 @@ class FlatIndexNode : public IndexNode {
 
     int64_t
     Size() const override {
-        return index_->ntotal * index_->d * sizeof(DataType);
+        return MemoryBreakdown().Total();
+    }
+
+    MemoryUsage
+    MemoryBreakdown() const override {
+        MemoryUsage usage;
+        if (!index_) {
+            return usage;
+        }
+        const faiss::MaybeOwnedVector<uint8_t>* rows = nullptr;
+        if constexpr (std::is_same<IndexType, faiss::IndexBinaryFlat>::value) {
+            rows = &index_->xb;
+        } else {
+            rows = &index_->codes;
+        }
+        usage.Add(memory_section::RAW_DATA, rows->is_owned ? rows->owned_data.capacity() : rows->view_size);
+        usage.Add(memory_section::OTHER, huge_page_overhead_);
+        return usage;
     }
 
     int64_t
@@ -391,18 +457,521 @@ class FlatIndexNode : public IndexNode {
     }
 
  private:
+    // moves the codes of index_ into huge pages, returns the bytes of the buffer beyond them
+    size_t
+    MoveToHugePagesIfRequested(const Config& config) {
+        if (!static_cast<const BaseConfig&>(config).use_huge_pages.value()) {
+            return 0;
+        }
+        HugePagePacker packer;
+        packer.Add(index_.get());
+        return packer.Pack();
+    }
+
     std::unique_ptr<IndexType> index_;
+    // the bytes the huge page buffer of the codes holds beyond them, if requested during the load
+    size_t huge_page_overhead_ = 0;
     std::shared_ptr<ThreadPool> search_pool_;
 };
 
-KNOWHERE_MOCK_REGISTER_DENSE_FLOAT_ALL_GLOBAL(FLAT, FlatIndexNode,
-                                              knowhere::feature::NO_TRAIN | knowhere::feature::KNN |
-                                                  knowhere::feature::MMAP,
-                                              faiss::IndexFlat);
+// FLAT for fp16, bf16 and int8, the rows are kept in their own type and scored with the typed kernels. The binary
+// starts with kFlatTypedMagic, the binaries of the former fp32 FLAT are converted when they are loaded.
+template <typename DataType>
+class FlatTypedIndexNode : public IndexNode {
+    static_assert(KnowhereLowPrecisionTypeCheck<DataType>::value, "FlatTypedIndexNode only support fp16/bf16/int8");
+
+ public:
+    FlatTypedIndexNode(const int32_t version, const Object& object) : IndexNode(version) {
+        search_pool_ = ThreadPool::GetGlobalSearchThreadPool();
+    }
+
+    ~FlatTypedIndexNode() override {
+        ReleaseFileMap();
+    }
+
+    Status
+    Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        const FlatConfig& f_cfg = static_cast<const FlatConfig&>(*cfg);
+
+        auto metric = Str2FaissMetricType(f_cfg.metric_type.value());
+        if (!metric.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "unsupported metric type: " << f_cfg.metric_type.value();
+            return metric.error();
+        }
+        if (metric.value() != faiss::METRIC_L2 && metric.value() != faiss::METRIC_INNER_PRODUCT) {
+            LOG_KNOWHERE_ERROR_ << "unsupported metric type: " << f_cfg.metric_type.value();
+            return Status::invalid_metric_type;
+        }
+        ReleaseFileMap();
+        header_ = {kFlatTypedMagic, static_cast<int32_t>(metric.value()), dataset->GetDim(), 0,
+                   IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE)};
+        codes_.clear();
+        norms_.clear();
+        data_ = nullptr;
+        return Status::success;
+    }
+
+    Status
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        if (header_.magic != kFlatTypedMagic) {
+            LOG_KNOWHERE_WARNING_ << "add to an untrained index";
+            return Status::index_not_trained;
+        }
+        if (file_map_ != nullptr) {
+            LOG_KNOWHERE_WARNING_ << "can not add to an mmapped index";
+            return Status::not_implemented;
+        }
+        auto x = static_cast<const DataType*>(dataset->GetTensor());
+        auto n = dataset->GetRows();
+        codes_.insert(codes_.end(), x, x + n * header_.dim);
+        if (header_.is_cosine) {
+            AppendNorms(x, n);
+        }
+        header_.ntotal += n;
+        data_ = codes_.data();
+        return Status::success;
+    }
+
+    expected<DataSetPtr>
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (header_.magic != kFlatTypedMagic) {
+            LOG_KNOWHERE_WARNING_ << "search on empty index";
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+
+        const FlatConfig& f_cfg = static_cast<const FlatConfig&>(*cfg);
+        bool is_cosine = IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE);
+
+        auto k = f_cfg.k.value();
+        auto nq = dataset->GetRows();
+        auto x = static_cast<const DataType*>(dataset->GetTensor());
+        auto dim = header_.dim;
+        auto nb = header_.ntotal;
+
+        auto len = k * nq;
+        auto ids = std::make_unique<int64_t[]>(len);
+        auto distances = std::make_unique<float[]>(len);
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(nq);
+            for (int i = 0; i < nq; ++i) {
+                futs.emplace_back(search_pool_->push([&, index = i] {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+                    auto cur_query = x + dim * index;
+                    auto cur_ids = ids.get() + k * index;
+                    auto cur_dis = distances.get() + k * index;
+
+                    BitsetViewIDSelector bw_idselector(bitset);
+                    faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
+
+                    if (header_.metric_type == faiss::METRIC_L2) {
+                        faiss::knn_L2sqr_typed(cur_query, data_, dim, 1, nb, k, cur_dis, cur_ids, nullptr,
+                                               id_selector);
+                    } else if (is_cosine) {
+                        // the norm of the query is divided out by the kernel, the rows use theirs if they are kept
+                        faiss::knn_cosine_typed(cur_query, data_, Norms(), dim, 1, nb, k, cur_dis, cur_ids,
+                                                id_selector);
+                    } else {
+                        faiss::knn_inner_product_typed(cur_query, data_, dim, 1, nb, k, cur_dis, cur_ids, id_selector);
+                    }
+                }));
+            }
+            // wait for the completion
+            WaitAllSuccess(futs);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+        return GenResultDataSet(nq, k, std::move(ids), std::move(distances));
+    }
+
+    expected<DataSetPtr>
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (header_.magic != kFlatTypedMagic) {
+            LOG_KNOWHERE_WARNING_ << "range search on empty index";
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+
+        const FlatConfig& f_cfg = static_cast<const FlatConfig&>(*cfg);
+        bool is_cosine = IsMetricType(f_cfg.metric_type.value(), knowhere::metric::COSINE);
+
+        auto nq = dataset->GetRows();
+        auto xq = static_cast<const DataType*>(dataset->GetTensor());
+        auto dim = header_.dim;
+        auto nb = header_.ntotal;
+
+        float radius = f_cfg.radius.value();
+        float range_filter = f_cfg.range_filter.value();
+        bool is_ip = (header_.metric_type == faiss::METRIC_INNER_PRODUCT);
+
+        RangeSearchResult range_search_result;
+
+        std::vector<std::vector<int64_t>> result_id_array(nq);
+        std::vector<std::vector<float>> result_dist_array(nq);
+
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(nq);
+            for (int i = 0; i < nq; ++i) {
+                futs.emplace_back(search_pool_->push([&, index = i] {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+                    faiss::RangeSearchResult res(1);
+                    auto cur_query = xq + dim * index;
+
+                    BitsetViewIDSelector bw_idselector(bitset);
+                    faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
+
+                    if (!is_ip) {
+                        faiss::range_search_L2sqr_typed(cur_query, data_, dim, 1, nb, radius, &res, id_selector);
+                    } else if (is_cosine) {
+                        faiss::range_search_cosine_typed(cur_query, data_, Norms(), dim, 1, nb, radius, &res,
+                                                         id_selector);
+                    } else {
+                        faiss::range_search_inner_product_typed(cur_query, data_, dim, 1, nb, radius, &res,
+                                                                id_selector);
+                    }
+                    auto elem_cnt = res.lims[1];
+                    result_dist_array[index].resize(elem_cnt);
+                    result_id_array[index].resize(elem_cnt);
+                    for (size_t j = 0; j < elem_cnt; j++) {
+                        result_dist_array[index][j] = res.distances[j];
+                        result_id_array[index][j] = res.labels[j];
+                    }
+                    if (f_cfg.range_filter.value() != defaultRangeFilter) {
+                        FilterRangeSearchResultForOneNq(result_dist_array[index], result_id_array[index], is_ip, radius,
+                                                        range_filter);
+                    }
+                }));
+            }
+            // wait for the completion
+            WaitAllSuccess(futs);
+            range_search_result =
+                GetRangeSearchResult(result_dist_array, result_id_array, is_ip, nq, radius, range_filter);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+
+        return GenResultDataSet(nq, std::move(range_search_result));
+    }
+
+    expected<DataSetPtr>
+    GetVectorByIds(const DataSetPtr dataset) const override {
+        auto dim = header_.dim;
+        auto rows = dataset->GetRows();
+        auto ids = dataset->GetIds();
+        auto data = std::make_unique<DataType[]>(rows * dim);
+        for (int64_t i = 0; i < rows; i++) {
+            if (ids[i] < 0 || ids[i] >= header_.ntotal) {
+                LOG_KNOWHERE_WARNING_ << "invalid id " << ids[i];
+                return expected<DataSetPtr>::Err(Status::invalid_args, "invalid id");
+            }
+            std::copy_n(data_ + ids[i] * dim, dim, data.get() + i * dim);
+        }
+        return GenResultDataSet(rows, dim, std::move(data));
+    }
+
+    static bool
+    StaticHasRawData(const knowhere::BaseConfig& config, const IndexVersion& version) {
+        const FlatConfig& f_cfg = static_cast<const FlatConfig&>(config);
+        if (knowhere::Version(version) <= Version::GetMinimalVersion()) {
+            return !IsMetricType(f_cfg.metric_type.value(), metric::COSINE);
+        }
+        return true;
+    }
+
+    bool
+    HasRawData(const std::string& metric_type) const override {
+        if (this->version_ <= Version::GetMinimalVersion()) {
+            return !IsMetricType(metric_type, metric::COSINE);
+        }
+        return true;
+    }
+
+    expected<DataSetPtr>
+    GetIndexMeta(std::unique_ptr<Config>) const override {
+        return expected<DataSetPtr>::Err(Status::not_implemented, "GetIndexMeta not implemented");
+    }
+
+    Status
+    Serialize(BinarySet& binset) const override {
+        if (header_.magic != kFlatTypedMagic) {
+            LOG_KNOWHERE_ERROR_ << "Can not serialize empty index.";
+            return Status::empty_index;
+        }
+        ChunkedMemoryIOWriter writer;
+        writer(&header_, sizeof(header_), 1);
+        writer(data_, sizeof(DataType), header_.ntotal * header_.dim);
+        writer(norms_.data(), sizeof(float), norms_.size());
+        binset.AppendChunks(Type(), writer.Release(), writer.tellg());
+        return Status::success;
+    }
+
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        if (header_.magic != kFlatTypedMagic) {
+            LOG_KNOWHERE_ERROR_ << "Can not serialize empty index.";
+            return Status::empty_index;
+        }
+        try {
+            FileWriter writer(filename);
+            writer(&header_, sizeof(header_), 1);
+            writer(data_, sizeof(DataType), header_.ntotal * header_.dim);
+            writer(norms_.data(), sizeof(float), norms_.size());
+            writer.close();
+            return Status::success;
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "failed to serialize " << Type() << " to " << filename << ": " << e.what();
+            return Status::disk_file_error;
+        }
+    }
+
+    Status
+    Deserialize(const BinarySet& binset, std::shared_ptr<Config>) override {
+        std::vector<std::string> names = {"IVF",  // compatible with knowhere-1.x
+                                          Type()};
+        auto binary = binset.GetByNames(names);
+        if (binary == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+
+        ReleaseFileMap();
+        MemoryIOReader reader(binary->data.get(), binary->size);
+        return Load(reader, false);
+    }
+
+    Status
+    DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> cfg) override {
+        auto flat_cfg = static_cast<const knowhere::BaseConfig&>(*cfg);
+
+        ReleaseFileMap();
+        try {
+            auto file_reader = knowhere::FileReader(filename);
+            size_t map_size = file_reader.size();
+            int map_flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if (flat_cfg.enable_mmap_pop.has_value() && flat_cfg.enable_mmap_pop.value()) {
+                map_flags |= MAP_POPULATE;
+            }
+#endif
+            void* mapped_memory = mmap(nullptr, map_size, PROT_READ, map_flags, file_reader.descriptor(), 0);
+            if (mapped_memory == MAP_FAILED) {
+                LOG_KNOWHERE_ERROR_ << "Failed to mmap file " << filename << ": " << strerror(errno);
+                return Status::disk_file_error;
+            }
+            file_map_ = mapped_memory;
+            file_map_size_ = map_size;
+
+            MemoryIOReader reader(static_cast<uint8_t*>(mapped_memory), map_size);
+            bool use_mmap = flat_cfg.enable_mmap.value();
+            auto status = Load(reader, use_mmap);
+            if (status != Status::success || data_ != file_map_data()) {
+                // the rows were copied, or the binary is not valid
+                ReleaseFileMap();
+            }
+            return status;
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_ERROR_ << "Failed to read file " << filename << ": " << e.what();
+            ReleaseFileMap();
+            return Status::disk_file_error;
+        }
+    }
+
+    static std::unique_ptr<BaseConfig>
+    StaticCreateConfig() {
+        return std::make_unique<FlatConfig>();
+    }
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return StaticCreateConfig();
+    }
+
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        if (file_map_ == nullptr) {
+            return {};
+        }
+        return {MappedRegion{file_map_, file_map_size_, false}};
+    }
+
+    int64_t
+    Dim() const override {
+        return header_.dim;
+    }
+
+    int64_t
+    Size() const override {
+        return MemoryBreakdown().Total();
+    }
+
+    // the rows of a mmapped index are the size of their part of the file
+    MemoryUsage
+    MemoryBreakdown() const override {
+        MemoryUsage usage;
+        usage.Add(memory_section::RAW_DATA, file_map_ != nullptr ? header_.ntotal * header_.dim * sizeof(DataType)
+                                                                 : VectorBytes(codes_));
+        usage.Add(memory_section::CODES, VectorBytes(norms_));
+        return usage;
+    }
+
+    int64_t
+    Count() const override {
+        return header_.ntotal;
+    }
+
+    std::string
+    Type() const override {
+        return knowhere::IndexEnum::INDEX_FAISS_IDMAP;
+    }
+
+ private:
+    static constexpr uint32_t kFlatTypedMagic = 0x5446484b;  // "KHFT"
+
+    struct Header {
+        uint32_t magic = 0;
+        int32_t metric_type = faiss::METRIC_L2;
+        int64_t dim = 0;
+        int64_t ntotal = 0;
+        // the norms of the rows follow the rows
+        int64_t is_cosine = 0;
+    };
+
+    // reads a binary of this node, or of the fp32 FLAT, whose rows are converted. The rows are left in the reader if
+    // in_place is set.
+    Status
+    Load(MemoryIOReader& reader, const bool in_place) {
+        codes_.clear();
+        norms_.clear();
+        data_ = nullptr;
+        header_ = Header();
+        Header header;
+        if (reader.total_ < sizeof(header)) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+        std::memcpy(&header, reader.data(), sizeof(header));
+        if (header.magic != kFlatTypedMagic) {
+            return LoadFaissFlat(reader);
+        }
+        const size_t code_bytes = header.ntotal * header.dim * sizeof(DataType);
+        const size_t norm_bytes = header.is_cosine ? header.ntotal * sizeof(float) : 0;
+        if (reader.total_ < sizeof(header) + code_bytes + norm_bytes) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+        const auto codes = reinterpret_cast<const DataType*>(reader.data() + sizeof(header));
+        if (in_place) {
+            data_ = codes;
+        } else {
+            codes_.assign(codes, codes + header.ntotal * header.dim);
+            data_ = codes_.data();
+        }
+        norms_.resize(norm_bytes / sizeof(float));
+        std::memcpy(norms_.data(), reader.data() + sizeof(header) + code_bytes, norm_bytes);
+        header_ = header;
+        return Status::success;
+    }
+
+    Status
+    LoadFaissFlat(MemoryIOReader& reader) {
+        std::unique_ptr<faiss::Index> index;
+        try {
+            index.reset(faiss::read_index(&reader));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "error inner faiss: " << e.what();
+            return Status::faiss_inner_error;
+        }
+        auto flat = dynamic_cast<const faiss::IndexFlat*>(index.get());
+        if (flat == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_serialized_index_type;
+        }
+        // the rows were converted from this type, so they convert back without a loss
+        const float* xb = flat->get_xb();
+        codes_.resize(flat->ntotal * flat->d);
+        for (size_t i = 0; i < codes_.size(); i++) {
+            codes_[i] = static_cast<DataType>(xb[i]);
+        }
+        data_ = codes_.data();
+        header_ = {kFlatTypedMagic, static_cast<int32_t>(flat->metric_type), flat->d, flat->ntotal,
+                   !flat->code_norms.empty()};
+        if (header_.is_cosine) {
+            AppendNorms(data_, header_.ntotal);
+        }
+        return Status::success;
+    }
+
+    void
+    AppendNorms(const DataType* x, const int64_t n) {
+        float (*norm_computer)(const DataType*, size_t) = nullptr;
+        if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+            norm_computer = faiss::fp16_vec_norm_L2sqr;
+        } else if constexpr (std::is_same_v<DataType, knowhere::bf16>) {
+            norm_computer = faiss::bf16_vec_norm_L2sqr;
+        } else {
+            norm_computer = faiss::int8_vec_norm_L2sqr;
+        }
+        for (int64_t i = 0; i < n; i++) {
+            norms_.push_back(std::sqrt(norm_computer(x + i * header_.dim, header_.dim)));
+        }
+    }
+
+    // the norms of the rows, nullptr lets the kernels compute them
+    const float*
+    Norms() const {
+        return norms_.empty() ? nullptr : norms_.data();
+    }
+
+    const DataType*
+    file_map_data() const {
+        return file_map_ == nullptr ? nullptr
+                                    : reinterpret_cast<const DataType*>(static_cast<uint8_t*>(file_map_) +
+                                                                        sizeof(Header));
+    }
+
+    void
+    ReleaseFileMap() {
+        if (file_map_ == nullptr) {
+            return;
+        }
+        if (data_ == file_map_data()) {
+            data_ = nullptr;
+            header_ = Header();
+            norms_.clear();
+        }
+        if (munmap(file_map_, file_map_size_) != 0) {
+            LOG_KNOWHERE_ERROR_ << "Failed to munmap index file of " << Type() << ": " << strerror(errno);
+        }
+        file_map_ = nullptr;
+        file_map_size_ = 0;
+    }
+
+    Header header_;
+    // the rows, data_ points into them, or into file_map_ if the index is mmapped
+    std::vector<DataType> codes_;
+    const DataType* data_ = nullptr;
+    // the norms of the rows for cosine
+    std::vector<float> norms_;
+    void* file_map_ = nullptr;
+    size_t file_map_size_ = 0;
+    std::shared_ptr<ThreadPool> search_pool_;
+};
 
-KNOWHERE_MOCK_REGISTER_DENSE_INT_GLOBAL(FLAT, FlatIndexNode,
-                                        knowhere::feature::NO_TRAIN | knowhere::feature::KNN | knowhere::feature::MMAP,
-                                        faiss::IndexFlat);
+KNOWHERE_SIMPLE_REGISTER_GLOBAL(FLAT, FlatIndexNode, fp32,
+                                knowhere::feature::NO_TRAIN | knowhere::feature::KNN | knowhere::feature::MMAP |
+                                    knowhere::feature::FLOAT32,
+                                faiss::IndexFlat);
+KNOWHERE_SIMPLE_REGISTER_GLOBAL(FLAT, FlatTypedIndexNode, fp16,
+                                knowhere::feature::NO_TRAIN | knowhere::feature::KNN | knowhere::feature::MMAP |
+                                    knowhere::feature::FP16);
+KNOWHERE_SIMPLE_REGISTER_GLOBAL(FLAT, FlatTypedIndexNode, bf16,
+                                knowhere::feature::NO_TRAIN | knowhere::feature::KNN | knowhere::feature::MMAP |
+                                    knowhere::feature::BF16);
+KNOWHERE_SIMPLE_REGISTER_GLOBAL(FLAT, FlatTypedIndexNode, int8,
+                                knowhere::feature::NO_TRAIN | knowhere::feature::KNN | knowhere::feature::MMAP |
+                                    knowhere::feature::INT8);
 
 KNOWHERE_SIMPLE_REGISTER_DENSE_BIN_GLOBAL(BINFLAT, FlatIndexNode,
                                           knowhere::feature::NO_TRAIN | knowhere::feature::KNN |
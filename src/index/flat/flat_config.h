@@ -12,12 +12,79 @@
 #ifndef FLAT_CONFIG_H
 #define FLAT_CONFIG_H
 
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
 #include "knowhere/config.h"
+#include "knowhere/tolower.h"
 
 namespace knowhere {
 
 class FlatConfig : public BaseConfig {};
 
+// BQ_FLAT keeps the sign bit of every dimension and rescores the candidates with a refine index
+class BqFlatConfig : public BaseConfig {
+ public:
+    // the number of candidates that are rescored, as a multiple of k
+    CFG_FLOAT refine_k;
+    // the type of the refine index
+    CFG_STRING refine_type;
+
+    KNOHWERE_DECLARE_CONFIG(BqFlatConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(refine_k)
+            .description("the number of candidates that are rescored, as a multiple of k")
+            .set_default(4)
+            .set_range(1, std::numeric_limits<CFG_FLOAT::value_type>::max())
+            .for_search()
+            .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(refine_type)
+            .description("the type of the refine index")
+            .set_default("sq8")
+            .for_train()
+            .for_static();
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        if (param_type == PARAM_TYPE::TRAIN && refine_type.has_value()) {
+            const std::vector<std::string> allowed_list = {"sq6", "sq8", "fp16", "bf16", "fp32", "flat"};
+            const std::string refine_type_tolower = str_to_lower(refine_type.value());
+            if (std::find(allowed_list.begin(), allowed_list.end(), refine_type_tolower) == allowed_list.end()) {
+                std::string msg = "invalid refine type : " + refine_type.value() +
+                                  ", optional types are [sq6, sq8, fp16, bf16, fp32, flat]";
+                return HandleError(err_msg, msg, Status::invalid_args);
+            }
+        }
+        return Status::success;
+    }
+};
+
+// BIN_MIH splits the codes into mih_nhash substrings, each the key of a hash table
+class BinMihConfig : public BaseConfig {
+ public:
+    // the number of substrings of a code, 0 picks it from the number of rows
+    CFG_INT mih_nhash;
+    // a search probes the buckets of every substring up to mih_max_flip bits away from the query one, and scans all
+    //   the rows when they can't hold the exact results
+    CFG_INT mih_max_flip;
+
+    KNOHWERE_DECLARE_CONFIG(BinMihConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(mih_nhash)
+            .description("the number of substrings of a code, 0 picks it from the number of rows")
+            .set_default(0)
+            .set_range(0, 1024)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(mih_max_flip)
+            .description("the largest number of bits by which the probed buckets differ from the query substrings")
+            .set_default(2)
+            .set_range(0, 8)
+            .for_search()
+            .for_range_search();
+    }
+};
+
 }  // namespace knowhere
 
 #endif /* FLAT_CONFIG_H */
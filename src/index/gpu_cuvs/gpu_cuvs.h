@@ -17,11 +17,14 @@
 #ifndef GPU_CUVS_H
 #define GPU_CUVS_H
 
+#include <algorithm>
 #include <cstdint>
 #include <exception>
 #include <fstream>
+#include <future>
 #include <istream>
 #include <numeric>
+#include <stdexcept>
 #include <thread>
 #include <tuple>
 #include <vector>
@@ -30,11 +33,15 @@
 #include "common/cuvs/integration/cuvs_knowhere_index.hpp"
 #include "common/cuvs/integration/type_mappers.hpp"
 #include "common/cuvs/proto/cuvs_index_kind.hpp"
+#include "cuda_runtime_api.h"
 #include "index/gpu_cuvs/gpu_cuvs_brute_force_config.h"
 #include "index/gpu_cuvs/gpu_cuvs_cagra_config.h"
 #include "index/gpu_cuvs/gpu_cuvs_ivf_flat_config.h"
 #include "index/gpu_cuvs/gpu_cuvs_ivf_pq_config.h"
+#include "knowhere/comp/gpu_device_usage.h"
 #include "knowhere/comp/index_param.h"
+#include "knowhere/comp/search_coalescer.h"
+#include "knowhere/comp/topk_merge.h"
 #include "knowhere/expected.h"
 #include "knowhere/index/index_factory.h"
 #include "knowhere/log.h"
@@ -76,6 +83,12 @@ struct GpuCuvsIndexNode : public IndexNode {
     GpuCuvsIndexNode(int32_t, const Object& object) : index_{} {
     }
 
+    ~GpuCuvsIndexNode() override {
+        for (const auto& [device_id, rows] : device_usage_) {
+            AddGpuDeviceUsage(device_id, -1, -rows);
+        }
+    }
+
     Status
     Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
         auto result = Status::success;
@@ -86,9 +99,12 @@ struct GpuCuvsIndexNode : public IndexNode {
             LOG_KNOWHERE_ERROR_ << e.what();
             result = Status::invalid_args;
         }
-        if (index_.is_trained()) {
+        if (index_.is_trained() || !shards_.empty()) {
             result = Status::index_already_trained;
         }
+        if (result == Status::success && cuvs_cfg.num_shards.value_or(1) > 1) {
+            return TrainShards(cuvs_cfg, dataset);
+        }
         if (result == Status::success) {
             auto rows = dataset->GetRows();
             auto dim = dataset->GetDim();
@@ -96,6 +112,7 @@ struct GpuCuvsIndexNode : public IndexNode {
             try {
                 index_.train(cuvs_cfg, data, rows, dim);
                 index_.synchronize(true);
+                AddDeviceUsage(index_);
             } catch (const std::exception& e) {
                 LOG_KNOWHERE_ERROR_ << e.what();
                 result = Status::cuvs_inner_error;
@@ -126,8 +143,22 @@ struct GpuCuvsIndexNode : public IndexNode {
                 auto rows = dataset->GetRows();
                 auto dim = dataset->GetDim();
                 auto const* data = reinterpret_cast<const data_type*>(dataset->GetTensor());
+                // the device filter is a bitmap
+                std::vector<uint8_t> bits;
+                const uint8_t* bitset_data = bitset.data();
+                if (!bitset.is_bitmap()) {
+                    bits.resize(bitset.byte_size());
+                    bitset.copy_bits(bits.data());
+                    bitset_data = bits.data();
+                }
+                if (!shards_.empty()) {
+                    return SearchShards(cuvs_cfg, data, rows, dim, bitset_data, bitset);
+                }
+                if (SearchCoalescer::Enabled()) {
+                    return CoalescedSearch(cuvs_cfg, data, rows, dim, bitset_data, bitset);
+                }
                 auto search_result =
-                    index_.search(cuvs_cfg, data, rows, dim, bitset.data(), bitset.byte_size(), bitset.size());
+                    index_.search(cuvs_cfg, data, rows, dim, bitset_data, bitset.byte_size(), bitset.size());
                 std::this_thread::yield();
                 index_.synchronize();
                 return GenResultDataSet(rows, cuvs_cfg.k, std::get<0>(search_result), std::get<1>(search_result));
@@ -157,6 +188,9 @@ struct GpuCuvsIndexNode : public IndexNode {
 
     Status
     Serialize(BinarySet& binset) const override {
+        if (!shards_.empty()) {
+            return SerializeShards(binset);
+        }
         auto result = Status::success;
         std::stringbuf buf;
         if (!index_.is_trained()) {
@@ -183,6 +217,9 @@ struct GpuCuvsIndexNode : public IndexNode {
 
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config>) override {
+        if (binset.Contains(ShardsBinaryName())) {
+            return DeserializeShards(binset);
+        }
         auto result = Status::success;
         std::stringbuf buf;
         auto binary = binset.GetByName(this->Type());
@@ -219,7 +256,7 @@ struct GpuCuvsIndexNode : public IndexNode {
 
     int64_t
     Dim() const override {
-        return index_.dim();
+        return shards_.empty() ? index_.dim() : shards_[0].dim();
     }
 
     int64_t
@@ -229,6 +266,9 @@ struct GpuCuvsIndexNode : public IndexNode {
 
     int64_t
     Count() const override {
+        if (!shards_.empty()) {
+            return shard_offsets_.back();
+        }
         return index_.size();
     }
 
@@ -248,7 +288,240 @@ struct GpuCuvsIndexNode : public IndexNode {
     using cuvs_knowhere_index_type = typename cuvs_knowhere::cuvs_knowhere_index<K, DataType>;
 
  protected:
+    // searches the rows with the concurrent searches of the same params and filter in one batch
+    expected<DataSetPtr>
+    CoalescedSearch(cuvs_knowhere::cuvs_knowhere_config const& cuvs_cfg, data_type const* data, int64_t rows,
+                    int64_t dim, const uint8_t* bitset_data, const BitsetView& bitset) const {
+        const int64_t k = cuvs_cfg.k;
+        auto ids = std::make_unique<int64_t[]>(rows * k);
+        auto dists = std::make_unique<float[]>(rows * k);
+        auto key = cuvs_knowhere::search_params_key(cuvs_cfg);
+        key.append(reinterpret_cast<const char*>(bitset_data), bitset.byte_size());
+        const size_t row_size = std::is_same_v<DataType, bin1> ? dim / 8 : dim * sizeof(data_type);
+        auto search = [&](const void* queries, int64_t nq, int64_t* batch_ids, float* batch_dists) {
+            auto [res_ids, res_dists] = index_.search(cuvs_cfg, reinterpret_cast<data_type const*>(queries), nq, dim,
+                                                      bitset_data, bitset.byte_size(), bitset.size());
+            index_.synchronize();
+            std::unique_ptr<int64_t[]> owned_ids(res_ids);
+            std::unique_ptr<float[]> owned_dists(res_dists);
+            std::copy_n(owned_ids.get(), nq * k, batch_ids);
+            std::copy_n(owned_dists.get(), nq * k, batch_dists);
+            return Status::success;
+        };
+        auto status = coalescer_.Search(key, data, rows, row_size, k, ids.get(), dists.get(), search);
+        if (status != Status::success) {
+            return expected<DataSetPtr>::Err(status, "coalesced search failed");
+        }
+        return GenResultDataSet(rows, k, ids.release(), dists.release());
+    }
+
+    // the rows of a sharded index are split into contiguous ranges, a multiple of 8 rows long so that each shard
+    //   filters with whole bytes of the bitset
+    Status
+    TrainShards(cuvs_knowhere::cuvs_knowhere_config const& cuvs_cfg, const DataSetPtr dataset) {
+        const auto rows = dataset->GetRows();
+        const auto dim = dataset->GetDim();
+        const int64_t num_shards = cuvs_cfg.num_shards.value();
+        const int64_t shard_rows = ((rows + num_shards - 1) / num_shards + 7) / 8 * 8;
+        auto const* data = reinterpret_cast<const data_type*>(dataset->GetTensor());
+        std::vector<int64_t> offsets{0};
+        for (int64_t begin = 0; begin < rows; begin += shard_rows) {
+            offsets.push_back(std::min(rows, begin + shard_rows));
+        }
+        int device_count = 0;
+        try {
+            device_count = DeviceCount();
+            std::vector<cuvs_knowhere_index_type> shards;
+            shards.reserve(offsets.size() - 1);
+            for (size_t i = 0; i + 1 < offsets.size(); i++) {
+                shards.emplace_back(static_cast<int>(i % device_count));
+            }
+            // one task per shard, the shards on different devices train at the same time
+            std::vector<std::future<void>> futures;
+            for (size_t i = 0; i < shards.size(); i++) {
+                futures.push_back(std::async(std::launch::async, [&, i]() {
+                    shards[i].train(cuvs_cfg, data + offsets[i] * RowElements(dim), offsets[i + 1] - offsets[i], dim);
+                    shards[i].synchronize(true);
+                }));
+            }
+            RETURN_IF_ERROR(WaitShards(futures));
+            SetShards(std::move(shards));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_ERROR_ << e.what();
+            return Status::cuvs_inner_error;
+        }
+        LOG_KNOWHERE_INFO_ << "trained " << shards_.size() << " shards of " << shard_rows << " rows on "
+                           << std::min<int64_t>(device_count, shards_.size()) << " GPUs";
+        return Status::success;
+    }
+
+    // searches every shard concurrently, each on the stream of its own device, and merges their top-k
+    expected<DataSetPtr>
+    SearchShards(cuvs_knowhere::cuvs_knowhere_config const& cuvs_cfg, data_type const* data, int64_t rows,
+                 int64_t dim, const uint8_t* bitset_data, const BitsetView& bitset) const {
+        const int64_t k = cuvs_cfg.k;
+        std::vector<std::unique_ptr<int64_t[]>> shard_ids(shards_.size());
+        std::vector<std::unique_ptr<float[]>> shard_dists(shards_.size());
+        std::vector<std::future<void>> futures;
+        for (size_t i = 0; i < shards_.size(); i++) {
+            futures.push_back(std::async(std::launch::async, [&, i]() {
+                const int64_t offset = shard_offsets_[i];
+                const int64_t shard_rows = shard_offsets_[i + 1] - offset;
+                const uint8_t* shard_bits = bitset.empty() ? nullptr : bitset_data + offset / 8;
+                const int64_t shard_bytes = bitset.empty() ? 0 : (shard_rows + 7) / 8;
+                auto [ids, dists] = shards_[i].search(cuvs_cfg, data, rows, dim, shard_bits, shard_bytes,
+                                                      bitset.empty() ? 0 : shard_rows);
+                shards_[i].synchronize();
+                shard_ids[i].reset(ids);
+                shard_dists[i].reset(dists);
+                for (int64_t j = 0; j < rows * k; j++) {
+                    if (ids[j] >= 0) {
+                        ids[j] += offset;
+                    }
+                }
+            }));
+        }
+        auto status = WaitShards(futures);
+        if (status != Status::success) {
+            return expected<DataSetPtr>::Err(status, "search of a shard failed");
+        }
+
+        std::vector<TopkSegment> segments;
+        for (size_t i = 0; i < shards_.size(); i++) {
+            segments.push_back(TopkSegment{shard_ids[i].get(), shard_dists[i].get(), k});
+        }
+        TopkMergeOptions options;
+        options.larger_is_closer = IsMetricType(cuvs_cfg.metric_type, metric::IP) ||
+                                   IsMetricType(cuvs_cfg.metric_type, metric::COSINE);
+        auto ids = std::make_unique<int64_t[]>(rows * k);
+        auto dists = std::make_unique<float[]>(rows * k);
+        status = MergeTopk(segments, rows, k, options, ids.get(), dists.get());
+        if (status != Status::success) {
+            return expected<DataSetPtr>::Err(status, "failed to merge the results of the shards");
+        }
+        return GenResultDataSet(rows, k, ids.release(), dists.release());
+    }
+
+    Status
+    SerializeShards(BinarySet& binset) const {
+        for (size_t i = 0; i < shards_.size(); i++) {
+            std::stringbuf buf;
+            std::ostream os(&buf);
+            try {
+                shards_[i].serialize(os);
+                shards_[i].synchronize(true);
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_ERROR_ << e.what();
+                return Status::cuvs_inner_error;
+            }
+            os.flush();
+            const auto str = buf.str();
+            std::shared_ptr<uint8_t[]> shard_binary(new uint8_t[str.size()]);
+            memcpy(shard_binary.get(), str.data(), str.size());
+            binset.Append(ShardBinaryName(i), shard_binary, str.size());
+        }
+        const int64_t num_shards = shards_.size();
+        std::shared_ptr<uint8_t[]> meta(new uint8_t[sizeof(num_shards)]);
+        memcpy(meta.get(), &num_shards, sizeof(num_shards));
+        binset.Append(ShardsBinaryName(), meta, sizeof(num_shards));
+        return Status::success;
+    }
+
+    Status
+    DeserializeShards(const BinarySet& binset) {
+        auto meta = binset.GetByName(ShardsBinaryName());
+        int64_t num_shards = 0;
+        if (meta->size != sizeof(num_shards)) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set.";
+            return Status::invalid_binary_set;
+        }
+        memcpy(&num_shards, meta->data.get(), sizeof(num_shards));
+        try {
+            const int device_count = DeviceCount();
+            std::vector<cuvs_knowhere_index_type> shards;
+            for (int64_t i = 0; i < num_shards; i++) {
+                auto binary = binset.GetByName(ShardBinaryName(i));
+                if (binary == nullptr) {
+                    LOG_KNOWHERE_ERROR_ << "Invalid binary set, no shard " << i << " of " << num_shards;
+                    return Status::invalid_binary_set;
+                }
+                std::stringbuf buf;
+                buf.sputn((char*)binary->data.get(), binary->size);
+                std::istream is(&buf);
+                shards.push_back(cuvs_knowhere_index_type::deserialize(is, i % device_count));
+                shards.back().synchronize(true);
+            }
+            SetShards(std::move(shards));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_ERROR_ << e.what();
+            return Status::cuvs_inner_error;
+        }
+        return Status::success;
+    }
+
+    void
+    SetShards(std::vector<cuvs_knowhere_index_type>&& shards) {
+        shards_ = std::move(shards);
+        shard_offsets_.assign(1, 0);
+        for (const auto& shard : shards_) {
+            shard_offsets_.push_back(shard_offsets_.back() + shard.size());
+            AddDeviceUsage(shard);
+        }
+    }
+
+    void
+    AddDeviceUsage(const cuvs_knowhere_index_type& index) {
+        device_usage_.emplace_back(index.device_id(), index.size());
+        AddGpuDeviceUsage(index.device_id(), 1, index.size());
+    }
+
+    std::string
+    ShardsBinaryName() const {
+        return this->Type() + "_shards";
+    }
+
+    std::string
+    ShardBinaryName(size_t i) const {
+        return this->Type() + "_shard_" + std::to_string(i);
+    }
+
+    // the elements of data_type in a row of dim
+    static int64_t
+    RowElements(int64_t dim) {
+        return std::is_same_v<DataType, bin1> ? dim / 8 : dim;
+    }
+
+    static int
+    DeviceCount() {
+        int count = 0;
+        if (cudaGetDeviceCount(&count) != cudaSuccess || count == 0) {
+            throw std::runtime_error("No CUDA devices found");
+        }
+        return count;
+    }
+
+    // waits for every task, so that none is left running on the buffers of a failed one
+    static Status
+    WaitShards(std::vector<std::future<void>>& futures) {
+        auto status = Status::success;
+        for (auto& future : futures) {
+            try {
+                future.get();
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_ERROR_ << e.what();
+                status = Status::cuvs_inner_error;
+            }
+        }
+        return status;
+    }
+
     cuvs_knowhere_index_type index_;
+    mutable SearchCoalescer coalescer_;
+    // set instead of index_ for an index of num_shards > 1, shard i holds the rows from shard_offsets_[i]
+    std::vector<cuvs_knowhere_index_type> shards_;
+    std::vector<int64_t> shard_offsets_;
+    // the devices and rows counted in the GpuDeviceUsage
+    std::vector<std::pair<int, int64_t>> device_usage_;
 
     Status
     DeserializeFromStream(std::istream& stream) {
@@ -256,6 +529,7 @@ struct GpuCuvsIndexNode : public IndexNode {
         try {
             index_ = cuvs_knowhere_index_type::deserialize(stream);
             index_.synchronize(true);
+            AddDeviceUsage(index_);
         } catch (const std::exception& e) {
             LOG_KNOWHERE_ERROR_ << e.what();
             result = Status::cuvs_inner_error;
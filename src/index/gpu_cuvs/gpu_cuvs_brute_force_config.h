@@ -24,6 +24,21 @@
 namespace knowhere {
 
 struct GpuCuvsBruteForceConfig : public BaseConfig {
+    CFG_INT num_shards;
+    CFG_INT filter_version;
+
+    KNOHWERE_DECLARE_CONFIG(GpuCuvsBruteForceConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_shards)
+            .description("split the rows into this many shards, placed round-robin on the GPUs")
+            .set_default(1)
+            .set_range(1, 64)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(filter_version)
+            .description("version of the bitset, the device copy of a bitset is reused while the version is the same")
+            .allow_empty_without_default()
+            .for_search();
+    }
+
     Status
     CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
         if (param_type == PARAM_TYPE::TRAIN) {
@@ -44,6 +59,8 @@ to_cuvs_knowhere_config(GpuCuvsBruteForceConfig const& cfg) {
 
     result.metric_type = cfg.metric_type.value();
     result.k = cfg.k.value();
+    result.num_shards = cfg.num_shards;
+    result.filter_version = cfg.filter_version;
 
     return result;
 }
@@ -15,6 +15,8 @@
  * limitations under the License.
  */
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "common/cuvs/proto/cuvs_index_kind.hpp"
@@ -23,6 +25,7 @@
 #include "knowhere/dataset.h"
 #include "knowhere/index/index_factory.h"
 #include "knowhere/index/index_node_thread_pool_wrapper.h"
+#include "knowhere/version.h"
 #include "raft/core/device_resources.hpp"
 #include "raft/util/cuda_rt_essentials.hpp"
 namespace knowhere {
@@ -40,11 +43,18 @@ class GpuCuvsCagraHybridIndexNode : public GpuCuvsCagraIndexNode<DataType> {
         const GpuCuvsCagraConfig& cagra_cfg = static_cast<const GpuCuvsCagraConfig&>(*cfg);
         if (cagra_cfg.adapt_for_cpu.value())
             adapt_for_cpu = true;
-        return GpuCuvsCagraIndexNode<DataType>::Train(dataset, cfg, use_knowhere_build_pool);
+        RETURN_IF_ERROR(GpuCuvsCagraIndexNode<DataType>::Train(dataset, cfg, use_knowhere_build_pool));
+        if (adapt_for_cpu && cagra_cfg.cpu_index_type.has_value()) {
+            return BuildCpuIndex(dataset, cagra_cfg, use_knowhere_build_pool);
+        }
+        return Status::success;
     }
 
     expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (cpu_index_.Node() != nullptr) {
+            return SearchCpuIndex(dataset, static_cast<const GpuCuvsCagraConfig&>(*cfg), bitset);
+        }
         if (!adapt_for_cpu || hnsw_index_ == nullptr)
             return GpuCuvsCagraIndexNode<DataType>::Search(dataset, std::move(cfg), bitset);
         auto nq = dataset->GetRows();
@@ -87,6 +97,13 @@ class GpuCuvsCagraHybridIndexNode : public GpuCuvsCagraIndexNode<DataType> {
     Serialize(BinarySet& binset) const override {
         if (!adapt_for_cpu)
             return GpuCuvsCagraIndexNode<DataType>::Serialize(binset);
+        if (cpu_index_.Node() != nullptr) {
+            RETURN_IF_ERROR(cpu_index_.Serialize(binset));
+            std::shared_ptr<uint8_t[]> type_binary(new uint8_t[cpu_index_type_.size()]);
+            memcpy(type_binary.get(), cpu_index_type_.data(), cpu_index_type_.size());
+            binset.Append(CpuIndexTypeBinaryName(), type_binary, cpu_index_type_.size());
+            return Status::success;
+        }
         auto result = Status::success;
         std::stringbuf buf;
         if (!this->index_.is_trained()) {
@@ -115,6 +132,9 @@ class GpuCuvsCagraHybridIndexNode : public GpuCuvsCagraIndexNode<DataType> {
     Count() const override {
         if (!adapt_for_cpu)
             return GpuCuvsCagraIndexNode<DataType>::Count();
+        if (cpu_index_.Node() != nullptr) {
+            return cpu_index_.Count();
+        }
         if (!hnsw_index_) {
             return 0;
         }
@@ -123,6 +143,11 @@ class GpuCuvsCagraHybridIndexNode : public GpuCuvsCagraIndexNode<DataType> {
 
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override {
+        if (binset.Contains(CpuIndexTypeBinaryName())) {
+            this->adapt_for_cpu = true;
+            auto binary = binset.GetByName(CpuIndexTypeBinaryName());
+            return LoadCpuIndex(std::string(reinterpret_cast<const char*>(binary->data.get()), binary->size), binset);
+        }
         if (binset.Contains(std::string(this->Type()) + "_cpu")) {
             this->adapt_for_cpu = true;
             if constexpr (std::is_same_v<DataType, std::int8_t>) {
@@ -161,7 +186,81 @@ class GpuCuvsCagraHybridIndexNode : public GpuCuvsCagraIndexNode<DataType> {
     }
 
  private:
+    // the binary that records the type of the faiss HNSW index the graph was exported to
+    std::string
+    CpuIndexTypeBinaryName() const {
+        return std::string(this->Type()) + "_cpu_index_type";
+    }
+
+    Status
+    LoadCpuIndex(const std::string& type, const BinarySet& binset) {
+        auto cpu_index = IndexFactory::Instance().Create<DataType>(type, Version::GetCurrentVersion().VersionNumber());
+        if (!cpu_index.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "failed to create a " << type << " index for the CAGRA graph: " << cpu_index.what();
+            return cpu_index.error();
+        }
+        RETURN_IF_ERROR(cpu_index.value().Deserialize(binset));
+        cpu_index_ = cpu_index.value();
+        cpu_index_type_ = type;
+        return Status::success;
+    }
+
+    // adds the rows to a faiss HNSW index of cpu_index_type that takes the CAGRA graph as its base layer, so that the
+    //   graph is searched with quantized vectors and, if configured, refined
+    Status
+    BuildCpuIndex(const DataSetPtr dataset, const GpuCuvsCagraConfig& cagra_cfg, bool use_knowhere_build_pool) {
+        Json json = Json::parse(cagra_cfg.cpu_index_params.value(), nullptr, false);
+        if (!json.is_object()) {
+            LOG_KNOWHERE_ERROR_ << "cpu_index_params is not a json object: " << cagra_cfg.cpu_index_params.value();
+            return Status::invalid_args;
+        }
+        const auto& type = cagra_cfg.cpu_index_type.value();
+        auto cpu_index = IndexFactory::Instance().Create<DataType>(type, Version::GetCurrentVersion().VersionNumber());
+        if (!cpu_index.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "failed to create a " << type << " index for the CAGRA graph: " << cpu_index.what();
+            return cpu_index.error();
+        }
+
+        int64_t degree = 0;
+        std::shared_ptr<const std::vector<uint32_t>> graph;
+        try {
+            graph = std::make_shared<const std::vector<uint32_t>>(this->index_.graph_to_host(degree));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_ERROR_ << e.what();
+            return Status::cuvs_inner_error;
+        }
+        json[meta::METRIC_TYPE] = cagra_cfg.metric_type.value();
+        json[meta::DIM] = dataset->GetDim();
+        // the base layer of the faiss HNSW indexes holds 2 * M neighbors per row
+        if (!json.contains(indexparam::HNSW_M)) {
+            json[indexparam::HNSW_M] = (degree + 1) / 2;
+        }
+
+        auto base = GenDataSet(dataset->GetRows(), dataset->GetDim(), dataset->GetTensor());
+        base->Set(meta::BASE_GRAPH, graph);
+        RETURN_IF_ERROR(cpu_index.value().Build(base, json, use_knowhere_build_pool));
+        cpu_index_ = cpu_index.value();
+        cpu_index_type_ = type;
+        cpu_index_params_ = std::move(json);
+        return Status::success;
+    }
+
+    expected<DataSetPtr>
+    SearchCpuIndex(const DataSetPtr dataset, const GpuCuvsCagraConfig& cagra_cfg, const BitsetView& bitset) const {
+        Json json = cpu_index_params_;
+        json[meta::METRIC_TYPE] = cagra_cfg.metric_type.value();
+        json[meta::TOPK] = cagra_cfg.k.value();
+        if (cagra_cfg.ef.has_value()) {
+            json[indexparam::EF] = cagra_cfg.ef.value();
+        }
+        return cpu_index_.Search(dataset, json, bitset);
+    }
+
     bool adapt_for_cpu = false;
+    // the faiss HNSW index the graph was exported to with cpu_index_type, replaces hnsw_index_ if set
+    Index<IndexNode> cpu_index_;
+    std::string cpu_index_type_;
+    Json cpu_index_params_;
     std::unique_ptr<hnswlib::HierarchicalNSW<DataType, float, hnswlib::None>> hnsw_index_ = nullptr;
 };
 
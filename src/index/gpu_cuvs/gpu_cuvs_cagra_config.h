@@ -48,8 +48,12 @@ struct GpuCuvsCagraConfig : public BaseConfig {
     CFG_FLOAT hashmap_max_fill_rate;
     CFG_INT nn_descent_niter;
     CFG_BOOL adapt_for_cpu;
+    CFG_STRING cpu_index_type;
+    CFG_STRING cpu_index_params;
     CFG_INT ef;
     CFG_BOOL persistent;
+    CFG_INT num_shards;
+    CFG_INT filter_version;
 
     KNOHWERE_DECLARE_CONFIG(GpuCuvsCagraConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(cache_dataset_on_device)
@@ -114,6 +118,14 @@ struct GpuCuvsCagraConfig : public BaseConfig {
             .description("train on GPU search on CPU")
             .set_default(false)
             .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(cpu_index_type)
+            .description("the faiss HNSW index, HNSW_SQ, HNSW_PQ or HNSW_PRQ, to search the graph with on CPU")
+            .allow_empty_without_default()
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(cpu_index_params)
+            .description("a json object of the build and search params of the CPU index, such as sq_type or refine")
+            .set_default("{}")
+            .for_train();
         KNOWHERE_CONFIG_DECLARE_FIELD(ef)
             .description("hnsw ef")
             .allow_empty_without_default()
@@ -123,6 +135,15 @@ struct GpuCuvsCagraConfig : public BaseConfig {
             .description("use the persistent version of the search kernel (only supported with SINGLE_CTA)")
             .set_default(false)
             .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_shards)
+            .description("split the rows into this many shards, placed round-robin on the GPUs")
+            .set_default(1)
+            .set_range(1, 64)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(filter_version)
+            .description("version of the bitset, the device copy of a bitset is reused while the version is the same")
+            .allow_empty_without_default()
+            .for_search();
     }
 
     Status
@@ -137,6 +158,22 @@ struct GpuCuvsCagraConfig : public BaseConfig {
             }
         }
 
+        if (param_type == PARAM_TYPE::TRAIN && adapt_for_cpu.value() && num_shards.value() > 1) {
+            return HandleError(err_msg, "adapt_for_cpu does not support num_shards > 1", Status::invalid_args);
+        }
+        if (param_type == PARAM_TYPE::TRAIN && cpu_index_type.has_value()) {
+            constexpr std::array<std::string_view, 3> legal_cpu_index_list{"HNSW_SQ", "HNSW_PQ", "HNSW_PRQ"};
+            if (std::find(legal_cpu_index_list.begin(), legal_cpu_index_list.end(), cpu_index_type.value()) ==
+                legal_cpu_index_list.end()) {
+                std::string msg = "cpu index type " + cpu_index_type.value() +
+                                  " not supported, supported: [HNSW_SQ HNSW_PQ HNSW_PRQ]";
+                return HandleError(err_msg, msg, Status::invalid_args);
+            }
+            if (!adapt_for_cpu.value()) {
+                return HandleError(err_msg, "cpu_index_type requires adapt_for_cpu", Status::invalid_args);
+            }
+        }
+
         if (param_type == PARAM_TYPE::SEARCH) {
             // auto align itopk_size
             auto itopk_v = itopk_size.value_or(std::max(k.value(), kItopkSize));
@@ -180,6 +217,8 @@ to_cuvs_knowhere_config(GpuCuvsCagraConfig const& cfg) {
     result.hashmap_max_fill_rate = cfg.hashmap_max_fill_rate;
     result.nn_descent_niter = cfg.nn_descent_niter;
     result.persistent = cfg.persistent;
+    result.num_shards = cfg.num_shards;
+    result.filter_version = cfg.filter_version;
 
     return result;
 }
@@ -30,6 +30,8 @@ struct GpuCuvsIvfFlatConfig : public IvfFlatConfig {
     CFG_INT kmeans_n_iters;
     CFG_FLOAT kmeans_trainset_fraction;
     CFG_BOOL adaptive_centers;
+    CFG_INT num_shards;
+    CFG_INT filter_version;
     KNOHWERE_DECLARE_CONFIG(GpuCuvsIvfFlatConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(cache_dataset_on_device)
             .set_default(false)
@@ -56,6 +58,15 @@ struct GpuCuvsIvfFlatConfig : public IvfFlatConfig {
             .description("update centroids with new data")
             .set_default(false)
             .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_shards)
+            .description("split the rows into this many shards, placed round-robin on the GPUs")
+            .set_default(1)
+            .set_range(1, 64)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(filter_version)
+            .description("version of the bitset, the device copy of a bitset is reused while the version is the same")
+            .allow_empty_without_default()
+            .for_search();
     }
 
     Status
@@ -85,6 +96,8 @@ to_cuvs_knowhere_config(GpuCuvsIvfFlatConfig const& cfg) {
     result.kmeans_n_iters = cfg.kmeans_n_iters;
     result.kmeans_trainset_fraction = cfg.kmeans_trainset_fraction;
     result.adaptive_centers = cfg.adaptive_centers;
+    result.num_shards = cfg.num_shards;
+    result.filter_version = cfg.filter_version;
 
     return result;
 }
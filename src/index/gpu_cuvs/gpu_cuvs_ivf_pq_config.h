@@ -36,6 +36,8 @@ struct GpuCuvsIvfPqConfig : public IvfPqConfig {
     CFG_STRING lut_dtype;
     CFG_STRING internal_distance_dtype;
     CFG_FLOAT preferred_shmem_carveout;
+    CFG_INT num_shards;
+    CFG_INT filter_version;
 
     KNOHWERE_DECLARE_CONFIG(GpuCuvsIvfPqConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(cache_dataset_on_device)
@@ -91,6 +93,15 @@ struct GpuCuvsIvfPqConfig : public IvfPqConfig {
             .set_range(0.0f, 1.0f)
             .set_default(1.0f)
             .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_shards)
+            .description("split the rows into this many shards, placed round-robin on the GPUs")
+            .set_default(1)
+            .set_range(1, 64)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(filter_version)
+            .description("version of the bitset, the device copy of a bitset is reused while the version is the same")
+            .allow_empty_without_default()
+            .for_search();
     }
 
     Status
@@ -129,6 +140,8 @@ to_cuvs_knowhere_config(GpuCuvsIvfPqConfig const& cfg) {
     result.lookup_table_dtype = cfg.lut_dtype;
     result.internal_distance_dtype = cfg.internal_distance_dtype;
     result.preferred_shmem_carveout = cfg.preferred_shmem_carveout;
+    result.num_shards = cfg.num_shards;
+    result.filter_version = cfg.filter_version;
 
     return result;
 }
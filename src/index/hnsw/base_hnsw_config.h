@@ -32,7 +32,12 @@ class BaseHnswConfig : public BaseConfig {
     CFG_INT ef;
     CFG_INT overview_levels;
     KNOHWERE_DECLARE_CONFIG(BaseHnswConfig) {
-        KNOWHERE_CONFIG_DECLARE_FIELD(M).description("hnsw M").set_default(30).set_range(2, 2048).for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(M)
+            .description("hnsw M")
+            .set_default(30)
+            .set_range(2, 2048)
+            .for_train()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(efConstruction)
             .description("hnsw efConstruction")
             .set_default(360)
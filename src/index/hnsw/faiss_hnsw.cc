@@ -9,47 +9,77 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <faiss/cppcontrib/knowhere/impl/CompressedHnswGraph.h>
 #include <faiss/cppcontrib/knowhere/impl/CountSizeIOWriter.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswPublishedGraph.h>
 #include <faiss/cppcontrib/knowhere/impl/HnswSearcher.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswNeighborCodes.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswSeedTable.h>
 #include <faiss/cppcontrib/knowhere/utils/Bitset.h>
 #include <faiss/utils/Heap.h>
+#include <faiss/utils/distances.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/metric.h"
 #include "faiss/IndexBinaryHNSW.h"
 #include "faiss/IndexCosine.h"
 #include "faiss/IndexHNSW.h"
+#include "faiss/IndexPreTransform.h"
+#include "faiss/IndexRaBitQ.h"
 #include "faiss/IndexRefine.h"
+#include "faiss/VectorTransform.h"
 #include "faiss/impl/ScalarQuantizer.h"
 #include "faiss/impl/mapped_io.h"
 #include "faiss/index_io.h"
+#include "index/faiss_huge_pages.h"
+#include "index/bulk_get_vector.h"
+#include "index/faiss_mapped_regions.h"
 #include "index/hnsw/faiss_hnsw_config.h"
 #include "index/hnsw/hnsw.h"
 #include "index/hnsw/impl/DummyVisitor.h"
 #include "index/hnsw/impl/FederVisitor.h"
+#include "index/hnsw/impl/HnswConcurrentAdd.h"
+#include "index/hnsw/impl/HnswMerge.h"
+#include "index/hnsw/impl/HnswReorder.h"
+#include "index/hnsw/impl/HnswTombstones.h"
 #include "index/hnsw/impl/IndexBruteForceWrapper.h"
 #include "index/hnsw/impl/IndexConditionalWrapper.h"
 #include "index/hnsw/impl/IndexHNSWWrapper.h"
 #include "index/hnsw/impl/IndexWrapperCosine.h"
+#include "index/hnsw/impl/NNDescentGraph.h"
+#include "index/refine/refine_codes_reader.h"
 #include "index/refine/refine_utils.h"
+#include "io/file_io.h"
 #include "io/memory_io.h"
 #include "knowhere/bitsetview_idselector.h"
 #include "knowhere/comp/index_param.h"
+#include "knowhere/comp/rw_lock.h"
+#include "knowhere/comp/search_arena.h"
+#include "knowhere/comp/search_phases.h"
+#include "knowhere/comp/search_stats.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/comp/time_recorder.h"
 #include "knowhere/config.h"
 #include "knowhere/expected.h"
 #include "knowhere/index/index_factory.h"
 #include "knowhere/index/index_node_data_mock_wrapper.h"
+#include "knowhere/index/index_node_sharded_wrapper.h"
 #include "knowhere/log.h"
 #include "knowhere/range_util.h"
 #include "knowhere/utils.h"
@@ -58,8 +88,18 @@
 #include "knowhere/prometheus_client.h"
 #endif
 
+#ifdef KNOWHERE_WITH_DISKANN
+#include "diskann/index.h"
+#endif
+
 namespace knowhere {
 
+using faiss::cppcontrib::knowhere::CompressedHnswGraph;
+using faiss::cppcontrib::knowhere::HnswGraphPublisher;
+using faiss::cppcontrib::knowhere::HnswNeighborCodes;
+using faiss::cppcontrib::knowhere::HnswPublishedGraph;
+using faiss::cppcontrib::knowhere::HnswSeedTable;
+
 //
 class BaseFaissIndexNode : public IndexNode {
  public:
@@ -82,6 +122,21 @@ class BaseFaissIndexNode : public IndexNode {
         // config
         const BaseConfig& base_cfg = static_cast<const FaissHnswConfig&>(*cfg);
 
+        // fail early rather than after the graph is built
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(*cfg);
+        if (hnsw_cfg.reorder_type.has_value() && !parse_hnsw_reorder_type(hnsw_cfg.reorder_type.value()).has_value()) {
+            LOG_KNOWHERE_ERROR_ << "invalid reorder type: " << hnsw_cfg.reorder_type.value()
+                                << ", optional types are [none, bfs, rcm]";
+            return Status::invalid_args;
+        }
+        if (hnsw_cfg.concurrent_insert.value_or(false) &&
+            (parse_hnsw_reorder_type(hnsw_cfg.reorder_type.value_or("none")) != HnswReorderType::NONE ||
+             hnsw_cfg.entry_point_seeds.value_or(0) > 0 || hnsw_cfg.refine.value_or(false))) {
+            LOG_KNOWHERE_ERROR_ << "concurrent inserts are not compatible with a reorder, entry point seeds or "
+                                   "a refine";
+            return Status::invalid_args;
+        }
+
         // use build_pool_ to make sure the OMP threads spawned by index_->train etc
         // can inherit the low nice value of threads in build_pool_.
         auto tryObj =
@@ -120,7 +175,11 @@ class BaseFaissIndexNode : public IndexNode {
                     } else {
                         setter = std::make_unique<ThreadPool::ScopedBuildOmpSetter>();
                     }
-                    return AddInternal(dataset, *cfg);
+                    const Status status = AddInternal(dataset, *cfg);
+                    if (status != Status::success) {
+                        return status;
+                    }
+                    return PostAddInternal(*cfg);
                 })
                 .getTry();
 
@@ -149,6 +208,12 @@ class BaseFaissIndexNode : public IndexNode {
     // add impl
     virtual Status
     AddInternal(const DataSetPtr dataset, const Config& cfg) = 0;
+
+    // called once all the data is added
+    virtual Status
+    PostAddInternal(const Config& cfg) {
+        return Status::success;
+    }
 };
 
 // returns true if the text of FaissException is about non-recognizing fourcc
@@ -165,6 +230,82 @@ is_faiss_fourcc_error(const char* what) {
            (error_msg.find("not recognized") != std::string::npos);
 }
 
+template <typename T>
+int64_t
+MaybeOwnedBytes(const faiss::MaybeOwnedVector<T>& v) {
+    return (v.is_owned ? v.owned_data.capacity() : v.view_size) * sizeof(T);
+}
+
+// adds the memory of a faiss index of an HNSW node to usage, the codes of a flat index of fp32 rows being raw data
+void
+AddFaissIndexMemory(const faiss::Index* index, MemoryUsage& usage) {
+    if (index == nullptr) {
+        return;
+    }
+    if (const auto* hnsw_index = dynamic_cast<const faiss::IndexHNSW*>(index); hnsw_index != nullptr) {
+        const faiss::HNSW& hnsw = hnsw_index->hnsw;
+        usage.Add(memory_section::GRAPH, MaybeOwnedBytes(hnsw.neighbors) + MaybeOwnedBytes(hnsw.offsets) +
+                                             MaybeOwnedBytes(hnsw.levels) + VectorBytes(hnsw.assign_probas) +
+                                             VectorBytes(hnsw.cum_nneighbor_per_level));
+        AddFaissIndexMemory(hnsw_index->storage, usage);
+    } else if (const auto* refine = dynamic_cast<const faiss::IndexRefine*>(index); refine != nullptr) {
+        AddFaissIndexMemory(refine->base_index, usage);
+        AddFaissIndexMemory(refine->refine_index, usage);
+    } else if (const auto* flat = dynamic_cast<const faiss::IndexFlatCodes*>(index); flat != nullptr) {
+        usage.Add(dynamic_cast<const faiss::IndexFlat*>(index) != nullptr ? memory_section::RAW_DATA
+                                                                           : memory_section::CODES,
+                  MaybeOwnedBytes(flat->codes));
+    } else {
+        faiss::cppcontrib::knowhere::CountSizeIOWriter writer;
+        faiss::write_index(index, &writer);
+        usage.Add(memory_section::OTHER, writer.total_size);
+    }
+}
+
+// The state of an index that is modified while it is searched: concurrent inserts, see
+//   add_to_hnsw_concurrently(), and soft deletes, see HnswTombstones.
+// Searches and iterators hold the mutex shared, so that the index is never reallocated under them.
+class FaissHnswGrowingState {
+ public:
+    ~FaissHnswGrowingState() {
+        UpdateTombstoneSizeMetric(0);
+    }
+
+    // whether rows are added concurrently, stays enabled once the first such add starts
+    std::atomic<bool> enabled{false};
+    // held exclusively while the index grows or its graph is repaired
+    ReaderBiasedRWLock mutex;
+    // serializes concurrent adds, in-place modifications and graph repairs
+    std::mutex add_mutex;
+    // changes whenever node ids may change, guarded by add_mutex
+    uint64_t graph_version = 0;
+    // the visible part of the graph
+    HnswGraphPublisher publisher;
+    // soft-deleted rows, guarded by the mutex
+    HnswTombstones tombstones;
+
+    // reports the size of the tombstones, must be called after they change
+    void
+    UpdateTombstoneSizeMetric() {
+        UpdateTombstoneSizeMetric(tombstones.size_in_bytes());
+    }
+
+ private:
+    void
+    UpdateTombstoneSizeMetric(const size_t size) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        if (size >= reported_tombstone_size) {
+            knowhere_hnsw_tombstone_size.Increment((double)(size - reported_tombstone_size) / 1024.0 / 1024.0);
+        } else {
+            knowhere_hnsw_tombstone_size.Decrement((double)(reported_tombstone_size - size) / 1024.0 / 1024.0);
+        }
+#endif
+        reported_tombstone_size = size;
+    }
+
+    size_t reported_tombstone_size = 0;
+};
+
 //
 class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
  public:
@@ -172,6 +313,38 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
         : BaseFaissIndexNode(version, object), indexes(1, nullptr) {
     }
 
+    ~BaseFaissRegularIndexNode() override {
+        WaitForTombstoneRepair();
+    }
+
+    // writes the indexes in the format Deserialize() and DeserializeFromFile() read
+    void
+    WriteIndexes(MemoryIOWriter& writer) const {
+        // the graph is not repaired while it is written
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+        const HnswTombstones& tombstones = growing_state->tombstones;
+
+        // compressed graphs are written in the regular format
+        ScopedDecompressedGraphs decompressed(this);
+
+        // a reordered index needs its labels as well, so it is written in the MV format.
+        //   so is an index with deleted rows, they follow the indexes.
+        if (indexes.size() > 1 || !labels.empty() || !tombstones.empty()) {
+            // this is a hack for compatibility, faiss index has 4-byte header to indicate index category
+            // create a new one to distinguish MV faiss hnsw from faiss hnsw
+            faiss::write_mv(&writer);
+            writeHeader(&writer, tombstones.empty() ? kMvVersion : kMvVersionWithTombstones);
+            for (const auto& index : indexes) {
+                faiss::write_index(index.get(), &writer);
+            }
+            if (!tombstones.empty()) {
+                tombstones.write(&writer);
+            }
+        } else {
+            faiss::write_index(indexes[0].get(), &writer);
+        }
+    }
+
     Status
     Serialize(BinarySet& binset) const override {
         if (isIndexEmpty()) {
@@ -179,23 +352,9 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
         }
 
         try {
-            MemoryIOWriter writer;
-            if (indexes.size() > 1) {
-                // this is a hack for compatibility, faiss index has 4-byte header to indicate index category
-                // create a new one to distinguish MV faiss hnsw from faiss hnsw
-                faiss::write_mv(&writer);
-                writeHeader(&writer);
-                for (const auto& index : indexes) {
-                    faiss::write_index(index.get(), &writer);
-                }
-
-                std::shared_ptr<uint8_t[]> data(writer.data());
-                binset.Append(Type(), data, writer.tellg());
-            } else {
-                faiss::write_index(indexes[0].get(), &writer);
-                std::shared_ptr<uint8_t[]> data(writer.data());
-                binset.Append(Type(), data, writer.tellg());
-            }
+            ChunkedMemoryIOWriter writer;
+            WriteIndexes(writer);
+            binset.AppendChunks(Type(), writer.Release(), writer.tellg());
         } catch (const std::exception& e) {
             LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
             return Status::faiss_inner_error;
@@ -204,6 +363,24 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
         return Status::success;
     }
 
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        if (isIndexEmpty()) {
+            return Status::empty_index;
+        }
+
+        try {
+            FileWriter writer(filename);
+            WriteIndexes(writer);
+            writer.close();
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "failed to serialize " << Type() << " to " << filename << ": " << e.what();
+            return Status::disk_file_error;
+        }
+
+        return Status::success;
+    }
+
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config> config) override {
         auto binary = binset.GetByName(Type());
@@ -212,6 +389,14 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
             return Status::invalid_binary_set;
         }
 
+        WaitForTombstoneRepair();
+        compressed_graphs.clear();
+        seed_tables.clear();
+        neighbor_codes.clear();
+        refine_codes_readers.clear();
+        huge_page_overhead = 0;
+        growing_state = std::make_shared<FaissHnswGrowingState>();
+
         MemoryIOReader reader(binary->data.get(), binary->size);
         try {
             // this is a hack for compatibility, faiss index has 4-byte header to indicate index category
@@ -219,13 +404,18 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
             bool is_mv = faiss::read_is_mv(&reader);
             if (is_mv) {
                 LOG_KNOWHERE_INFO_ << "start to load index by mv";
-                uint32_t v = readHeader(&reader);
+                uint32_t mv_version = kMvVersion;
+                uint32_t v = readHeader(&reader, &mv_version);
                 indexes.resize(v);
                 LOG_KNOWHERE_INFO_ << "read " << v << " mvs";
                 for (auto i = 0; i < v; ++i) {
                     auto read_index = std::unique_ptr<faiss::Index>(faiss::read_index(&reader));
                     indexes[i].reset(read_index.release());
                 }
+                if (mv_version >= kMvVersionWithTombstones) {
+                    growing_state->tombstones.read(&reader);
+                    growing_state->UpdateTombstoneSizeMetric();
+                }
             } else {
                 reader.reset();
                 auto read_index = std::unique_ptr<faiss::Index>(faiss::read_index(&reader));
@@ -241,6 +431,21 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
             }
         }
 
+        auto status = BuildSeedTablesIfRequested(*config);
+        if (status != Status::success) {
+            return status;
+        }
+
+        status = BuildNeighborCodesIfRequested(*config);
+        if (status != Status::success) {
+            return status;
+        }
+
+        status = CompressGraphsIfRequested(*config);
+        if (status != Status::success) {
+            return status;
+        }
+        MoveToHugePagesIfRequested(*config);
         return Status::success;
     }
 
@@ -248,10 +453,26 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
     DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> config) override {
         auto cfg = static_cast<const knowhere::BaseConfig&>(*config);
 
+        WaitForTombstoneRepair();
+        compressed_graphs.clear();
+        seed_tables.clear();
+        neighbor_codes.clear();
+        refine_codes_readers.clear();
+        huge_page_overhead = 0;
+        growing_state = std::make_shared<FaissHnswGrowingState>();
+
         int io_flags = 0;
         if (cfg.enable_mmap.value()) {
             io_flags |= faiss::IO_FLAG_MMAP_IFC;
         }
+        // the whole file is mapped, and everything but the raw data of the refine index is copied out of it afterwards.
+        //   the refine reads that raw data from the file itself if it is left on disk.
+        const bool refine_on_disk =
+            static_cast<const FaissHnswConfig&>(*config).refine_on_disk.value() && !cfg.enable_mmap.value();
+        const bool lazy_raw_data = (cfg.lazy_load_raw_data.value() || refine_on_disk) && !cfg.enable_mmap.value();
+        if (lazy_raw_data) {
+            io_flags |= faiss::IO_FLAG_MMAP_IFC;
+        }
 
         try {
             // this is a hack for compatibility, faiss index has 4-byte header to indicate index category
@@ -261,13 +482,18 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
                 auto read_index = [&](faiss::IOReader* r) {
                     LOG_KNOWHERE_INFO_ << "start to load index by mv";
                     read_is_mv(r);
-                    uint32_t v = readHeader(r);
+                    uint32_t mv_version = kMvVersion;
+                    uint32_t v = readHeader(r, &mv_version);
                     LOG_KNOWHERE_INFO_ << "read " << v << " mvs";
                     indexes.resize(v);
                     for (auto i = 0; i < v; ++i) {
                         auto read_index = std::unique_ptr<faiss::Index>(faiss::read_index(r, io_flags));
                         indexes[i].reset(read_index.release());
                     }
+                    if (mv_version >= kMvVersionWithTombstones) {
+                        growing_state->tombstones.read(r);
+                        growing_state->UpdateTombstoneSizeMetric();
+                    }
                 };
                 if ((io_flags & faiss::IO_FLAG_MMAP_IFC) == faiss::IO_FLAG_MMAP_IFC) {
                     // enable mmap-supporting IOReader
@@ -282,6 +508,17 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
                 auto read_index = std::unique_ptr<faiss::Index>(faiss::read_index(filename.data(), io_flags));
                 indexes[0].reset(read_index.release());
             }
+            if (lazy_raw_data) {
+                for (auto& index : indexes) {
+                    own_all_but_refine_data(index.get());
+                }
+            }
+            if (refine_on_disk) {
+                auto status = OpenRefineCodesReaders(filename);
+                if (status != Status::success) {
+                    return status;
+                }
+            }
         } catch (const std::exception& e) {
             if (is_faiss_fourcc_error(e.what())) {
                 LOG_KNOWHERE_WARNING_ << "faiss does not recognize the input index: " << e.what();
@@ -292,9 +529,38 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
             }
         }
 
+        auto status = BuildSeedTablesIfRequested(*config);
+        if (status != Status::success) {
+            return status;
+        }
+
+        if (cfg.enable_mmap.value()) {
+            // neighbor lists are not kept in memory anyway
+            return Status::success;
+        }
+
+        status = BuildNeighborCodesIfRequested(*config);
+        if (status != Status::success) {
+            return status;
+        }
+
+        status = CompressGraphsIfRequested(*config);
+        if (status != Status::success) {
+            return status;
+        }
+        MoveToHugePagesIfRequested(*config);
         return Status::success;
     }
 
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        std::vector<MappedRegion> regions;
+        for (const auto& index : indexes) {
+            AppendMappedRegions(index.get(), regions);
+        }
+        return regions;
+    }
+
     //
     int64_t
     Dim() const override {
@@ -310,6 +576,11 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
         if (isIndexEmpty()) {
             return -1;
         }
+        if (growing_state->enabled.load()) {
+            // rows that are still being linked are not counted
+            return growing_state->publisher.ntotal();
+        }
+
         int64_t count = 0;
         for (const auto& index : indexes) {
             count += index->ntotal;
@@ -321,26 +592,107 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
 
     int64_t
     Size() const override {
+        return MemoryBreakdown().Total();
+    }
+
+    MemoryUsage
+    MemoryBreakdown() const override {
+        MemoryUsage usage;
         if (isIndexEmpty()) {
-            return 0;
+            return usage;
         }
-
-        // a temporary yet expensive workaround
-        faiss::cppcontrib::knowhere::CountSizeIOWriter writer;
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
         for (const auto& index : indexes) {
-            faiss::write_index(index.get(), &writer);
+            AddFaissIndexMemory(index.get(), usage);
+        }
+        // neighbor lists of compressed graphs, seed tables and neighbor codes are not a part of indexes
+        for (const auto& graph : compressed_graphs) {
+            usage.Add(memory_section::GRAPH, graph->size_in_bytes());
+        }
+        for (const auto& seed_table : seed_tables) {
+            usage.Add(memory_section::GRAPH, seed_table->size_in_bytes());
         }
+        for (const auto& codes : neighbor_codes) {
+            usage.Add(memory_section::CODES, codes->size_in_bytes());
+        }
+        for (const auto& index_labels : labels) {
+            usage.Add(memory_section::IDS, VectorBytes(*index_labels));
+        }
+        usage.Add(memory_section::IDS, VectorBytes(index_rows_sum) + VectorBytes(label_to_internal_offset) +
+                                           growing_state->tombstones.size_in_bytes());
+        usage.Add(memory_section::OTHER, huge_page_overhead);
+        return usage;
+    }
 
-        // todo
-        return writer.total_size;
+    Status
+    DeleteByIds(const DataSetPtr dataset) override {
+        if (isIndexEmpty()) {
+            LOG_KNOWHERE_ERROR_ << "Can not delete data from an empty index.";
+            return Status::empty_index;
+        }
+
+        const auto rows = dataset->GetRows();
+        const auto* ids = dataset->GetIds();
+
+        size_t n_deleted = 0;
+        {
+            std::unique_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+            const int64_t count = Count();
+            for (int64_t i = 0; i < rows; i++) {
+                if (ids[i] < 0 || ids[i] >= count) {
+                    LOG_KNOWHERE_ERROR_ << "can not delete row " << ids[i] << ", the index has " << count << " rows";
+                    return Status::invalid_args;
+                }
+            }
+
+            n_deleted = growing_state->tombstones.mark_deleted(ids, rows);
+            growing_state->UpdateTombstoneSizeMetric();
+        }
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        knowhere_hnsw_deleted_rows.Increment(n_deleted);
+#endif
+
+        ScheduleTombstoneRepair();
+        return Status::success;
     }
 
  protected:
+    // the version of the MV header
+    static constexpr uint32_t kMvVersion = 0;
+    // the MV format that has soft-deleted rows after the indexes
+    static constexpr uint32_t kMvVersionWithTombstones = 1;
+
+    // the graph is repaired once this share of rows is deleted and not reclaimed yet
+    static constexpr float kTombstoneRepairMinRatio = 0.01f;
+    // the number of nodes that are repaired while searches are blocked
+    static constexpr faiss::idx_t kTombstoneRepairBatchSize = 16384;
+
     // it is std::shared_ptr, not std::unique_ptr, because it can be
     //    shared with FaissHnswIterator
     std::vector<std::shared_ptr<faiss::Index>> indexes;
+    // compressed neighbor lists of each index, if requested during the load.
+    //   hnsw.neighbors of such indexes are released. Can be shared with FaissHnswIterator.
+    std::vector<std::shared_ptr<const CompressedHnswGraph>> compressed_graphs;
+    // additional level-0 entry points of each index, if requested
+    std::vector<std::shared_ptr<const HnswSeedTable>> seed_tables;
+    // the fast-scan codes of the level-0 neighbors of each index, if requested during the load.
+    //   dropped once the graph is modified.
+    std::vector<std::shared_ptr<const HnswNeighborCodes>> neighbor_codes;
+    // the readers of the refine codes of each index that are left in the file, if requested during the load
+    std::vector<std::shared_ptr<const RefineCodesReader>> refine_codes_readers;
+    // the bytes the huge page buffer of the arrays of indexes holds beyond them, if requested during the load
+    size_t huge_page_overhead = 0;
     // each index's out ids(label), can be shared with FaissHnswIterator
     std::vector<std::shared_ptr<std::vector<uint32_t>>> labels;
+    // concurrent inserts, can be shared with FaissHnswIterator
+    std::shared_ptr<FaissHnswGrowingState> growing_state = std::make_shared<FaissHnswGrowingState>();
+
+    // the background repair of the graph around deleted rows
+    std::mutex tombstone_repair_mutex;
+    bool tombstone_repair_running = false;
+    std::atomic<bool> tombstone_repair_stop{false};
+    std::optional<folly::Future<folly::Unit>> tombstone_repair;
 
     // index rows, help to locate index id by offset
     std::vector<uint32_t> index_rows_sum;
@@ -372,8 +724,7 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
     }
 
     void
-    writeHeader(faiss::IOWriter* f) const {
-        uint32_t version = 0;
+    writeHeader(faiss::IOWriter* f, const uint32_t version) const {
         faiss::write_value(version, f);
         uint32_t size = indexes.size();
         faiss::write_value(size, f);
@@ -387,8 +738,8 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
     }
 
     uint32_t
-    readHeader(faiss::IOReader* f) {
-        [[maybe_unused]] uint32_t version = faiss::read_value(f);
+    readHeader(faiss::IOReader* f, uint32_t* version) {
+        *version = faiss::read_value(f);
         uint32_t size = faiss::read_value(f);
         uint32_t cluster_size = faiss::read_value(f);
         labels.resize(cluster_size);
@@ -401,121 +752,513 @@ class BaseFaissRegularIndexNode : public BaseFaissIndexNode {
         return size;
     }
 
-    bool
-    isIndexEmpty() const {
-        if (indexes.empty()) {
-            return true;
-        }
-        for (const auto& index : indexes) {
-            if (index == nullptr) {
-                return true;
-            }
-        }
-        return false;
+    static faiss::IndexHNSW*
+    getIndexHNSW(faiss::Index* index) {
+        faiss::IndexRefine* index_refine = dynamic_cast<faiss::IndexRefine*>(index);
+        return dynamic_cast<faiss::IndexHNSW*>((index_refine != nullptr) ? index_refine->base_index : index);
     }
-};
 
-namespace {
+    const CompressedHnswGraph*
+    getCompressedGraph(const int index_id) const {
+        return compressed_graphs.empty() ? nullptr : compressed_graphs[index_id].get();
+    }
 
-bool
-convert_rows_to_fp32(const void* const __restrict src_in, float* const __restrict dst,
-                     const DataFormatEnum src_data_format, const uint32_t* const __restrict offsets, const size_t nrows,
-                     const size_t dim) {
-    if (src_data_format == DataFormatEnum::fp16) {
-        const knowhere::fp16* const src = reinterpret_cast<const knowhere::fp16*>(src_in);
-        for (size_t i = 0; i < nrows; i++) {
-            for (size_t j = 0; j < dim; ++j) {
-                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
-            }
+    const HnswNeighborCodes*
+    getNeighborCodes(const int index_id) const {
+        return neighbor_codes.empty() ? nullptr : neighbor_codes[index_id].get();
+    }
+
+    const HnswSeedTable*
+    getSeedTable(const int index_id) const {
+        return seed_tables.empty() ? nullptr : seed_tables[index_id].get();
+    }
+
+    const RefineCodesReader*
+    getRefineCodesReader(const int index_id) const {
+        return refine_codes_readers.empty() ? nullptr : refine_codes_readers[index_id].get();
+    }
+
+    // the visible part of a growing graph, std::nullopt if the whole graph is visible.
+    //   must be called while growing_state->mutex is held.
+    std::optional<HnswPublishedGraph>
+    getPublishedGraph() const {
+        if (!growing_state->enabled.load()) {
+            return std::nullopt;
         }
-        return true;
-    } else if (src_data_format == DataFormatEnum::bf16) {
-        const knowhere::bf16* const src = reinterpret_cast<const knowhere::bf16*>(src_in);
-        for (size_t i = 0; i < nrows; i++) {
-            for (size_t j = 0; j < dim; ++j) {
-                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+        return growing_state->publisher.load(getIndexHNSW(indexes[0].get())->hnsw);
+    }
+
+    // opens a reader of the refine codes in the file for every index with a flat codes refine, nullptr for the others
+    Status
+    OpenRefineCodesReaders(const std::string& filename) {
+        std::vector<std::shared_ptr<const RefineCodesReader>> readers(indexes.size());
+        for (size_t i = 0; i < indexes.size(); i++) {
+            auto index_refine = dynamic_cast<const faiss::IndexRefine*>(indexes[i].get());
+            if (index_refine == nullptr) {
+                continue;
             }
-        }
-        return true;
-    } else if (src_data_format == DataFormatEnum::fp32) {
-        const knowhere::fp32* const src = reinterpret_cast<const knowhere::fp32*>(src_in);
-        for (size_t i = 0; i < nrows; i++) {
-            for (size_t j = 0; j < dim; ++j) {
-                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+            auto refine_codes_index = dynamic_cast<const faiss::IndexFlatCodes*>(index_refine->refine_index);
+            if (refine_codes_index == nullptr) {
+                continue;
             }
-        }
-        return true;
-    } else if (src_data_format == DataFormatEnum::int8) {
-        const knowhere::int8* const src = reinterpret_cast<const knowhere::int8*>(src_in);
-        for (size_t i = 0; i < nrows; i++) {
-            for (size_t j = 0; j < dim; ++j) {
-                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+            auto reader = RefineCodesReader::Open(filename, *refine_codes_index);
+            if (!reader.has_value()) {
+                LOG_KNOWHERE_ERROR_ << "Failed to leave the refine codes on disk: " << reader.what();
+                return reader.error();
             }
+            readers[i] = reader.value();
         }
-        return true;
-    } else {
-        // unknown
-        return false;
+        refine_codes_readers = std::move(readers);
+        return Status::success;
     }
-}
 
-bool
-convert_rows_to_fp32(const void* const __restrict src_in, float* const __restrict dst,
-                     const DataFormatEnum src_data_format, const size_t start_row, const size_t nrows,
-                     const size_t dim) {
-    if (src_data_format == DataFormatEnum::fp16) {
-        const knowhere::fp16* const src = reinterpret_cast<const knowhere::fp16*>(src_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i] = (float)(src[i + start_row * dim]);
+    // moves the arrays of the indexes into huge pages, last so that compressed neighbor lists are not copied
+    void
+    MoveToHugePagesIfRequested(const Config& config) {
+        const auto& cfg = static_cast<const BaseConfig&>(config);
+        if (!cfg.use_huge_pages.value()) {
+            return;
         }
-        return true;
-    } else if (src_data_format == DataFormatEnum::bf16) {
-        const knowhere::bf16* const src = reinterpret_cast<const knowhere::bf16*>(src_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i] = (float)(src[i + start_row * dim]);
+        HugePagePacker packer;
+        for (auto& index : indexes) {
+            packer.Add(index.get());
         }
-        return true;
-    } else if (src_data_format == DataFormatEnum::fp32) {
-        const knowhere::fp32* const src = reinterpret_cast<const knowhere::fp32*>(src_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i] = src[i + start_row * dim];
+        huge_page_overhead = packer.Pack();
+    }
+
+    // clusters the data of every index to pick additional level-0 entry points
+    Status
+    BuildSeedTablesIfRequested(const Config& config) {
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
+        const int64_t n_centroids = hnsw_cfg.entry_point_seeds.value_or(0);
+        if (n_centroids <= 0) {
+            seed_tables.clear();
+            return Status::success;
         }
-        return true;
-    } else if (src_data_format == DataFormatEnum::int8) {
-        const knowhere::int8* const src = reinterpret_cast<const knowhere::int8*>(src_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i] = (float)(src[i + start_row * dim]);
+
+        try {
+            TimeRecorder rc("HNSW entry point seeds");
+
+            std::vector<std::shared_ptr<const HnswSeedTable>> tables(indexes.size());
+            // the indexes of a materialized view are independent
+            auto pool = NestedBuildThreadPool();
+            std::vector<faiss::IndexHNSW*> index_hnsws;
+            for (const auto& index : indexes) {
+                faiss::IndexHNSW* index_hnsw = getIndexHNSW(index.get());
+                if (index_hnsw == nullptr) {
+                    LOG_KNOWHERE_ERROR_ << "an input index seems to be unrelated to HNSW";
+                    return Status::invalid_index_error;
+                }
+                index_hnsws.push_back(index_hnsw);
+            }
+            std::vector<folly::Future<folly::Unit>> futures;
+            for (size_t i = 0; i < index_hnsws.size(); i++) {
+                futures.emplace_back(pool.push([&tables, i, index_hnsw = index_hnsws[i], n_centroids]() {
+                    tables[i] = std::make_shared<HnswSeedTable>(HnswSeedTable::build(*index_hnsw, n_centroids));
+                }));
+            }
+            WaitAllSuccess(futures);
+
+            seed_tables = std::move(tables);
+            rc.ElapseFromBegin("done");
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
         }
-        return true;
-    } else {
-        // unknown
-        return false;
+
+        return Status::success;
     }
-}
 
-bool
-convert_rows_from_fp32(const float* const __restrict src, void* const __restrict dst_in,
-                       const DataFormatEnum dst_data_format, const size_t start_row, const size_t nrows,
-                       const size_t dim) {
-    if (dst_data_format == DataFormatEnum::fp16) {
-        knowhere::fp16* const dst = reinterpret_cast<knowhere::fp16*>(dst_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i + start_row * dim] = (knowhere::fp16)src[i];
-        }
-        return true;
-    } else if (dst_data_format == DataFormatEnum::bf16) {
-        knowhere::bf16* const dst = reinterpret_cast<knowhere::bf16*>(dst_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i + start_row * dim] = (knowhere::bf16)src[i];
+    // lays the 4-bit PQ codes of the level-0 neighbors of every index out for the fast-scan
+    Status
+    BuildNeighborCodesIfRequested(const Config& config) {
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
+        if (!hnsw_cfg.fast_scan_neighbors.value_or(false)) {
+            return Status::success;
         }
-        return true;
-    } else if (dst_data_format == DataFormatEnum::fp32) {
-        knowhere::fp32* const dst = reinterpret_cast<knowhere::fp32*>(dst_in);
-        for (size_t i = 0; i < nrows * dim; i++) {
-            dst[i + start_row * dim] = src[i];
+        if (hnsw_cfg.compress_graph.value_or(false)) {
+            // compressed lists do not keep the order of the neighbors the codes follow
+            LOG_KNOWHERE_WARNING_ << "fast_scan_neighbors is ignored for compressed graphs";
+            return Status::success;
         }
-        return true;
-    } else if (dst_data_format == DataFormatEnum::int8) {
+
+        try {
+            std::vector<std::shared_ptr<const HnswNeighborCodes>> codes(indexes.size());
+            std::vector<const faiss::IndexHNSW*> index_hnsws;
+            for (const auto& index : indexes) {
+                const faiss::IndexHNSW* index_hnsw = getIndexHNSW(index.get());
+                if (index_hnsw == nullptr) {
+                    LOG_KNOWHERE_ERROR_ << "an input index seems to be unrelated to HNSW";
+                    return Status::invalid_index_error;
+                }
+                if (!HnswNeighborCodes::is_supported(index_hnsw->storage)) {
+                    LOG_KNOWHERE_WARNING_ << "fast_scan_neighbors is ignored, it needs a PQ storage with 4-bit codes";
+                    return Status::success;
+                }
+                index_hnsws.push_back(index_hnsw);
+            }
+
+            auto pool = NestedBuildThreadPool();
+            std::vector<folly::Future<folly::Unit>> futures;
+            for (size_t i = 0; i < index_hnsws.size(); i++) {
+                futures.emplace_back(pool.push([&codes, i, index_hnsw = index_hnsws[i]]() {
+                    const auto* storage = static_cast<const faiss::IndexPQ*>(index_hnsw->storage);
+                    codes[i] =
+                        std::make_shared<HnswNeighborCodes>(HnswNeighborCodes::build(index_hnsw->hnsw, *storage));
+                }));
+            }
+            WaitAllSuccess(futures);
+
+            size_t codes_size = 0;
+            for (const auto& c : codes) {
+                codes_size += c->size_in_bytes();
+            }
+            neighbor_codes = std::move(codes);
+            LOG_KNOWHERE_INFO_ << "HNSW neighbor codes are laid out for the fast-scan in " << codes_size << " bytes";
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+
+        return Status::success;
+    }
+
+    // replaces neighbor lists of every index with a compressed version
+    Status
+    CompressGraphsIfRequested(const Config& config) {
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
+        if (!hnsw_cfg.compress_graph.value_or(false)) {
+            return Status::success;
+        }
+
+        try {
+            std::vector<std::shared_ptr<const CompressedHnswGraph>> graphs(indexes.size());
+            auto pool = NestedBuildThreadPool();
+            std::vector<faiss::IndexHNSW*> index_hnsws;
+            for (const auto& index : indexes) {
+                faiss::IndexHNSW* index_hnsw = getIndexHNSW(index.get());
+                if (index_hnsw == nullptr) {
+                    LOG_KNOWHERE_ERROR_ << "an input index seems to be unrelated to HNSW";
+                    return Status::invalid_index_error;
+                }
+                index_hnsws.push_back(index_hnsw);
+            }
+            std::vector<folly::Future<folly::Unit>> futures;
+            for (size_t i = 0; i < index_hnsws.size(); i++) {
+                futures.emplace_back(pool.push([&graphs, i, index_hnsw = index_hnsws[i]]() {
+                    graphs[i] = std::make_shared<CompressedHnswGraph>(CompressedHnswGraph::build(index_hnsw->hnsw));
+                }));
+            }
+            WaitAllSuccess(futures);
+
+            // release the original neighbor lists
+            size_t original_size = 0;
+            size_t compressed_size = 0;
+            for (size_t i = 0; i < indexes.size(); i++) {
+                faiss::IndexHNSW* index_hnsw = getIndexHNSW(indexes[i].get());
+                original_size += index_hnsw->hnsw.neighbors.size() * sizeof(faiss::HNSW::storage_idx_t);
+                compressed_size += graphs[i]->size_in_bytes();
+
+                index_hnsw->hnsw.neighbors = faiss::MaybeOwnedVector<faiss::HNSW::storage_idx_t>();
+            }
+
+            compressed_graphs = std::move(graphs);
+            LOG_KNOWHERE_INFO_ << "HNSW neighbor lists are compressed from " << original_size << " to "
+                               << compressed_size << " bytes";
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+
+        return Status::success;
+    }
+
+    // temporarily restores neighbor lists of compressed graphs, for serialization
+    class ScopedDecompressedGraphs {
+     public:
+        explicit ScopedDecompressedGraphs(const BaseFaissRegularIndexNode* node_in) : node{node_in} {
+            for (size_t i = 0; i < node->compressed_graphs.size(); i++) {
+                node->compressed_graphs[i]->decompress_into(getIndexHNSW(node->indexes[i].get())->hnsw);
+            }
+        }
+
+        ~ScopedDecompressedGraphs() {
+            for (size_t i = 0; i < node->compressed_graphs.size(); i++) {
+                getIndexHNSW(node->indexes[i].get())->hnsw.neighbors =
+                    faiss::MaybeOwnedVector<faiss::HNSW::storage_idx_t>();
+            }
+        }
+
+     private:
+        const BaseFaissRegularIndexNode* node;
+    };
+
+    // Keeps the background repair of the graph away while the index is modified in place.
+    //   Node ids that the repair has collected are invalidated, and so are the neighbor codes.
+    std::unique_lock<std::mutex>
+    LockGraphForModification() {
+        std::unique_lock<std::mutex> lock(growing_state->add_mutex);
+        growing_state->graph_version += 1;
+        neighbor_codes.clear();
+        return lock;
+    }
+
+    // whether enough deleted rows wait for their graph slots to be reclaimed
+    bool
+    IsTombstoneRepairNeeded() const {
+        if (isIndexEmpty() || !compressed_graphs.empty() || !neighbor_codes.empty()) {
+            // compressed neighbor lists are read-only, and so are the lists neighbor codes follow
+            return false;
+        }
+        for (const auto& index : indexes) {
+            const faiss::IndexHNSW* index_hnsw = getIndexHNSW(index.get());
+            if (index_hnsw == nullptr || !IsWritableInPlace(index_hnsw->hnsw.neighbors)) {
+                // mmap'd neighbor lists are read-only
+                return false;
+            }
+        }
+
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+        const size_t n_pending = growing_state->tombstones.count_pending();
+        return n_pending > 0 && (double)n_pending >= Count() * kTombstoneRepairMinRatio;
+    }
+
+    // starts the background repair unless it is running already, it picks new deleted rows up then
+    void
+    ScheduleTombstoneRepair() {
+        std::lock_guard<std::mutex> lock(tombstone_repair_mutex);
+        if (tombstone_repair_running || tombstone_repair_stop.load() || !IsTombstoneRepairNeeded()) {
+            return;
+        }
+
+        tombstone_repair_running = true;
+        tombstone_repair = build_pool->push([this] {
+            ThreadPool::ScopedBuildOmpSetter setter;
+            while (!tombstone_repair_stop.load()) {
+                try {
+                    RepairTombstones();
+                } catch (const std::exception& e) {
+                    LOG_KNOWHERE_WARNING_ << "faiss inner error during the repair of deleted rows: " << e.what();
+                    break;
+                }
+
+                std::lock_guard<std::mutex> lock(tombstone_repair_mutex);
+                if (!IsTombstoneRepairNeeded()) {
+                    tombstone_repair_running = false;
+                    return;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(tombstone_repair_mutex);
+            tombstone_repair_running = false;
+        });
+    }
+
+    // stops the background repair, must not be called from the build pool
+    void
+    WaitForTombstoneRepair() {
+        std::optional<folly::Future<folly::Unit>> repair;
+        {
+            std::lock_guard<std::mutex> lock(tombstone_repair_mutex);
+            repair = std::move(tombstone_repair);
+            tombstone_repair.reset();
+            tombstone_repair_stop = true;
+        }
+        if (repair.has_value()) {
+            repair->wait();
+        }
+        tombstone_repair_stop = false;
+    }
+
+    // One repair pass per index: live nodes that refer to deleted ones are reconnected in batches,
+    //   then the graph slots of the deleted nodes are reclaimed. Searches are blocked only while a batch is repaired.
+    void
+    RepairTombstones() {
+        FaissHnswGrowingState& state = *growing_state;
+
+        for (size_t index_id = 0; index_id < indexes.size() && !tombstone_repair_stop.load(); index_id++) {
+            faiss::IndexHNSW* index_hnsw = nullptr;
+            uint64_t graph_version = 0;
+            // deleted nodes by node id, and the ones whose slots are not reclaimed yet
+            std::vector<bool> deleted;
+            std::vector<faiss::HNSW::storage_idx_t> pending_nodes;
+            std::vector<int64_t> pending_rows;
+            {
+                std::lock_guard<std::mutex> add_lock(state.add_mutex);
+                std::shared_lock<ReaderBiasedRWLock> growing_lock(state.mutex);
+                index_hnsw = getIndexHNSW(indexes[index_id].get());
+                graph_version = state.graph_version;
+
+                const faiss::idx_t ntotal = index_hnsw->ntotal;
+                deleted.resize(ntotal, false);
+                for (faiss::idx_t i = 0; i < ntotal; i++) {
+                    const int64_t row = labels.empty() ? i : labels[index_id]->operator[](i);
+                    if (state.tombstones.is_deleted(row)) {
+                        deleted[i] = true;
+                        if (!state.tombstones.is_reclaimed(row)) {
+                            pending_nodes.push_back((faiss::HNSW::storage_idx_t)i);
+                            pending_rows.push_back(row);
+                        }
+                    }
+                }
+            }
+            if (pending_nodes.empty()) {
+                continue;
+            }
+
+            for (faiss::idx_t begin = 0; !tombstone_repair_stop.load(); begin += kTombstoneRepairBatchSize) {
+                std::lock_guard<std::mutex> add_lock(state.add_mutex);
+                if (state.graph_version != graph_version) {
+                    // node ids have changed, the next pass starts over
+                    return;
+                }
+
+                std::unique_lock<ReaderBiasedRWLock> growing_lock(state.mutex);
+                // nodes that are added in the meantime are repaired as well
+                const faiss::idx_t ntotal = index_hnsw->ntotal;
+                const faiss::idx_t end = std::min(ntotal, begin + kTombstoneRepairBatchSize);
+                repair_hnsw_neighbors(index_hnsw, deleted, begin, end);
+                if (end < ntotal) {
+                    continue;
+                }
+
+                reclaim_hnsw_nodes(index_hnsw, deleted, pending_nodes);
+                state.tombstones.mark_reclaimed(pending_rows);
+                state.UpdateTombstoneSizeMetric();
+                if (state.enabled.load()) {
+                    // the entry point may have moved
+                    state.publisher.publish(index_hnsw->hnsw, ntotal);
+                }
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+                knowhere_hnsw_reclaimed_rows.Increment(pending_rows.size());
+#endif
+                break;
+            }
+        }
+    }
+
+    // the bitset of a search with the deleted rows filtered out as well, 'buffer' keeps the combined bits.
+    //   must be called while growing_state->mutex is held.
+    BitsetView
+    getBitsetWithTombstones(const BitsetView& bitset, std::vector<uint8_t>& buffer) const {
+        return growing_state->tombstones.filter(bitset, Count(), buffer);
+    }
+
+    bool
+    isIndexEmpty() const {
+        if (indexes.empty()) {
+            return true;
+        }
+        for (const auto& index : indexes) {
+            if (index == nullptr) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+namespace {
+
+bool
+convert_rows_to_fp32(const void* const __restrict src_in, float* const __restrict dst,
+                     const DataFormatEnum src_data_format, const uint32_t* const __restrict offsets, const size_t nrows,
+                     const size_t dim) {
+    if (src_data_format == DataFormatEnum::fp16) {
+        const knowhere::fp16* const src = reinterpret_cast<const knowhere::fp16*>(src_in);
+        for (size_t i = 0; i < nrows; i++) {
+            for (size_t j = 0; j < dim; ++j) {
+                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+            }
+        }
+        return true;
+    } else if (src_data_format == DataFormatEnum::bf16) {
+        const knowhere::bf16* const src = reinterpret_cast<const knowhere::bf16*>(src_in);
+        for (size_t i = 0; i < nrows; i++) {
+            for (size_t j = 0; j < dim; ++j) {
+                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+            }
+        }
+        return true;
+    } else if (src_data_format == DataFormatEnum::fp32) {
+        const knowhere::fp32* const src = reinterpret_cast<const knowhere::fp32*>(src_in);
+        for (size_t i = 0; i < nrows; i++) {
+            for (size_t j = 0; j < dim; ++j) {
+                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+            }
+        }
+        return true;
+    } else if (src_data_format == DataFormatEnum::int8) {
+        const knowhere::int8* const src = reinterpret_cast<const knowhere::int8*>(src_in);
+        for (size_t i = 0; i < nrows; i++) {
+            for (size_t j = 0; j < dim; ++j) {
+                dst[i * dim + j] = (float)(src[offsets[i] * dim + j]);
+            }
+        }
+        return true;
+    } else {
+        // unknown
+        return false;
+    }
+}
+
+bool
+convert_rows_to_fp32(const void* const __restrict src_in, float* const __restrict dst,
+                     const DataFormatEnum src_data_format, const size_t start_row, const size_t nrows,
+                     const size_t dim) {
+    if (src_data_format == DataFormatEnum::fp16) {
+        const knowhere::fp16* const src = reinterpret_cast<const knowhere::fp16*>(src_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i] = (float)(src[i + start_row * dim]);
+        }
+        return true;
+    } else if (src_data_format == DataFormatEnum::bf16) {
+        const knowhere::bf16* const src = reinterpret_cast<const knowhere::bf16*>(src_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i] = (float)(src[i + start_row * dim]);
+        }
+        return true;
+    } else if (src_data_format == DataFormatEnum::fp32) {
+        const knowhere::fp32* const src = reinterpret_cast<const knowhere::fp32*>(src_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i] = src[i + start_row * dim];
+        }
+        return true;
+    } else if (src_data_format == DataFormatEnum::int8) {
+        const knowhere::int8* const src = reinterpret_cast<const knowhere::int8*>(src_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i] = (float)(src[i + start_row * dim]);
+        }
+        return true;
+    } else {
+        // unknown
+        return false;
+    }
+}
+
+bool
+convert_rows_from_fp32(const float* const __restrict src, void* const __restrict dst_in,
+                       const DataFormatEnum dst_data_format, const size_t start_row, const size_t nrows,
+                       const size_t dim) {
+    if (dst_data_format == DataFormatEnum::fp16) {
+        knowhere::fp16* const dst = reinterpret_cast<knowhere::fp16*>(dst_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i + start_row * dim] = (knowhere::fp16)src[i];
+        }
+        return true;
+    } else if (dst_data_format == DataFormatEnum::bf16) {
+        knowhere::bf16* const dst = reinterpret_cast<knowhere::bf16*>(dst_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i + start_row * dim] = (knowhere::bf16)src[i];
+        }
+        return true;
+    } else if (dst_data_format == DataFormatEnum::fp32) {
+        knowhere::fp32* const dst = reinterpret_cast<knowhere::fp32*>(dst_in);
+        for (size_t i = 0; i < nrows * dim; i++) {
+            dst[i + start_row * dim] = src[i];
+        }
+        return true;
+    } else if (dst_data_format == DataFormatEnum::int8) {
         knowhere::int8* const dst = reinterpret_cast<knowhere::int8*>(dst_in);
         for (size_t i = 0; i < nrows * dim; i++) {
             KNOWHERE_THROW_IF_NOT_MSG(src[i] >= std::numeric_limits<knowhere::int8>::min() &&
@@ -545,15 +1288,45 @@ convert_ds_to_float(const DataSetPtr& src, DataFormatEnum data_format) {
     return nullptr;
 }
 
+// the quantizers of an index built from non-fp32 data are trained on at most this many rows, twice as many as the
+//   k-means of an 8-bit PQ samples
+constexpr int64_t kMaxConvertedTrainRows = 131072;
+
+// the rows to train the quantizers of an index on: the whole dataset if it is fp32, an evenly spread sample of at
+//   most kMaxConvertedTrainRows rows converted into buffer otherwise, so that no fp32 copy of the whole dataset is
+//   made. Returns nullptr for an unsupported data format.
+const float*
+convert_train_rows_to_float(const DataSetPtr& dataset, DataFormatEnum data_format, std::unique_ptr<float[]>& buffer,
+                            int64_t& n_train_rows) {
+    const auto rows = dataset->GetRows();
+    const auto dim = dataset->GetDim();
+    if (data_format == DataFormatEnum::fp32) {
+        n_train_rows = rows;
+        return reinterpret_cast<const float*>(dataset->GetTensor());
+    }
+    n_train_rows = std::min(rows, kMaxConvertedTrainRows);
+    std::vector<uint32_t> offsets(n_train_rows);
+    for (int64_t i = 0; i < n_train_rows; i++) {
+        offsets[i] = static_cast<uint32_t>(i * rows / n_train_rows);
+    }
+    buffer = std::make_unique<float[]>(n_train_rows * dim);
+    if (!convert_rows_to_fp32(dataset->GetTensor(), buffer.get(), data_format, offsets.data(), n_train_rows, dim)) {
+        return nullptr;
+    }
+    return buffer.get();
+}
+
+// passes the rows of a dataset to add_rows(n, x) as fp32
 Status
-add_to_index(faiss::Index* const __restrict index, const DataSetPtr& dataset, const DataFormatEnum data_format) {
+add_to_index(const DataSetPtr& dataset, const DataFormatEnum data_format,
+             const std::function<void(faiss::idx_t, const float*)>& add_rows) {
     const auto* data = dataset->GetTensor();
     const auto rows = dataset->GetRows();
     const auto dim = dataset->GetDim();
 
     if (data_format == DataFormatEnum::fp32) {
         // add as is
-        index->add(rows, reinterpret_cast<const float*>(data));
+        add_rows(rows, reinterpret_cast<const float*>(data));
     } else {
         // convert data into float in pieces and add to the index
         constexpr int64_t n_tmp_rows = 4096;
@@ -570,13 +1343,131 @@ add_to_index(faiss::Index* const __restrict index, const DataSetPtr& dataset, co
             }
 
             // add
-            index->add(count_rows, tmp.get());
+            add_rows(count_rows, tmp.get());
         }
     }
 
     return Status::success;
 }
 
+Status
+add_to_index(faiss::Index* const __restrict index, const DataSetPtr& dataset, const DataFormatEnum data_format) {
+    return add_to_index(dataset, data_format, [index](faiss::idx_t n, const float* x) { index->add(n, x); });
+}
+
+// adds the rows to the storage of an empty HNSW index, and to its refine storage, then takes graph, the neighbors of
+//   every row, as its only layer
+Status
+add_with_base_graph(faiss::Index* const index, const DataSetPtr& dataset, const DataFormatEnum data_format,
+                    const std::vector<uint32_t>& graph) {
+    auto* index_refine = dynamic_cast<faiss::IndexRefine*>(index);
+    auto* index_hnsw = dynamic_cast<faiss::IndexHNSW*>(index_refine != nullptr ? index_refine->base_index : index);
+    const auto rows = dataset->GetRows();
+    if (index_hnsw == nullptr || index->ntotal != 0 || rows <= 0 || graph.size() % rows != 0) {
+        LOG_KNOWHERE_ERROR_ << "a base graph of " << graph.size() << " neighbors can not be added with " << rows
+                            << " rows to a non-empty index";
+        return Status::invalid_args;
+    }
+    const size_t degree = graph.size() / rows;
+
+    RETURN_IF_ERROR(add_to_index(dataset, data_format, [&](faiss::idx_t n, const float* x) {
+        index_hnsw->storage->add(n, x);
+        if (index_refine != nullptr) {
+            index_refine->refine_index->add(n, x);
+        }
+    }));
+    index_hnsw->ntotal = index_hnsw->storage->ntotal;
+    index->ntotal = index_hnsw->ntotal;
+
+    auto& hnsw = index_hnsw->hnsw;
+    hnsw.levels.resize(rows, 1);
+    hnsw.prepare_level_tab(rows, true);
+    const size_t width = hnsw.nb_neighbors(0);
+    if (degree > width) {
+        LOG_KNOWHERE_INFO_ << "keeping the first " << width << " of the " << degree << " neighbors of the base graph";
+    }
+#pragma omp parallel for
+    for (int64_t i = 0; i < rows; i++) {
+        size_t begin, end;
+        hnsw.neighbor_range(i, 0, &begin, &end);
+        for (size_t j = 0; j < degree && begin < end; j++) {
+            const uint32_t neighbor = graph[i * degree + j];
+            if (neighbor != i && neighbor < rows) {
+                hnsw.neighbors[begin++] = neighbor;
+            }
+        }
+    }
+    // the same entry point as the hnswlib export of a CAGRA graph
+    hnsw.max_level = 0;
+    hnsw.entry_point = rows / 2;
+    return Status::success;
+}
+
+#ifdef KNOWHERE_WITH_DISKANN
+// builds a graph of at most max_degree neighbors per row with the Vamana builder of DiskANN, in the layout of
+//   meta::BASE_GRAPH with the missing neighbors set to rows, and returns its entry point.
+// The graph of an IP index is built in the L2 space of the rows scaled by the maximal norm and extended by one
+//   dimension, as for the SSD index, the one of a cosine index over the normalized rows.
+expected<int64_t>
+build_vamana_graph(const DataSetPtr& dataset, const DataFormatEnum data_format, const std::string& metric_type,
+                   const int64_t max_degree, const int64_t search_list_size, const float alpha,
+                   std::vector<uint32_t>& graph) {
+    auto float_ds_ptr = convert_ds_to_float(dataset, data_format);
+    if (float_ds_ptr == nullptr) {
+        return expected<int64_t>::Err(Status::invalid_args, "unsupported data format");
+    }
+    const auto rows = dataset->GetRows();
+    const auto dim = dataset->GetDim();
+    const float* data = reinterpret_cast<const float*>(float_ds_ptr->GetTensor());
+
+    const bool is_ip = IsMetricType(metric_type, metric::IP);
+    const bool is_cosine = IsMetricType(metric_type, metric::COSINE);
+    const int64_t build_dim = is_ip ? dim + 1 : dim;
+    std::vector<float> prepared;
+    if (is_ip || is_cosine) {
+        prepared.assign(rows * build_dim, 0.0f);
+        std::vector<float> norms(rows);
+        for (int64_t i = 0; i < rows; i++) {
+            norms[i] = std::sqrt(faiss::fvec_norm_L2sqr(data + i * dim, dim));
+        }
+        const float max_norm = rows > 0 ? *std::max_element(norms.begin(), norms.end()) : 0.0f;
+        for (int64_t i = 0; i < rows; i++) {
+            const float norm = is_ip ? max_norm : norms[i];
+            const float scale = norm > 0 ? 1.0f / norm : 0.0f;
+            for (int64_t j = 0; j < dim; j++) {
+                prepared[i * build_dim + j] = data[i * dim + j] * scale;
+            }
+            if (is_ip) {
+                const float r = norms[i] * scale;
+                prepared[i * build_dim + dim] = std::sqrt(std::max(0.0f, 1.0f - r * r));
+            }
+        }
+        data = prepared.data();
+    }
+
+    diskann::Parameters paras;
+    paras.Set<unsigned>("L", (unsigned)search_list_size);
+    paras.Set<unsigned>("R", (unsigned)max_degree);
+    paras.Set<unsigned>("C", 750);
+    paras.Set<float>("alpha", alpha);
+    paras.Set<unsigned>("num_rnds", 2);
+    paras.Set<bool>("saturate_graph", false);
+    paras.Set<bool>("accelerate_build", false);
+    paras.Set<bool>("shuffle_build", false);
+
+    diskann::Index<float> index(diskann::Metric::L2, is_ip, build_dim, rows, false, false);
+    index.build(data, rows, paras);
+
+    const auto& final_graph = *index.get_graph();
+    graph.assign(rows * max_degree, static_cast<uint32_t>(rows));
+    for (int64_t i = 0; i < rows; i++) {
+        const size_t n = std::min<size_t>(final_graph[i].size(), max_degree);
+        std::copy_n(final_graph[i].begin(), n, graph.begin() + i * max_degree);
+    }
+    return static_cast<int64_t>(index.get_entry_point());
+}
+#endif
+
 Status
 add_partial_dataset_to_index(faiss::Index* const __restrict index, const DataSetPtr& dataset,
                              const DataFormatEnum data_format, const std::vector<uint32_t>& ids) {
@@ -699,14 +1590,56 @@ combine_partitions(const std::vector<std::vector<uint32_t>>& scalar_info, const
 
 }  // namespace
 
-// Contains an iterator state
-struct FaissHnswIteratorWorkspace {
-    // hnsw.
-    // this pointer is not owned.
-    const faiss::HNSW* hnsw = nullptr;
+// Keeps visited bitsets of destroyed iterators, keyed by the number of nodes, so that short-lived iterators
+//   over the same index do not allocate them over and over again.
+class FaissHnswIteratorWorkspacePool {
+ public:
+    // returns a cleared bitset for an index with the given number of nodes
+    faiss::cppcontrib::knowhere::Bitset
+    AcquireVisitedNodes(const size_t ntotal) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = visited_nodes.find(ntotal);
+            if (it != visited_nodes.end() && !it->second.empty()) {
+                auto bitset = std::move(it->second.back());
+                it->second.pop_back();
+                bitset.clear();
+                return bitset;
+            }
+        }
 
-    // nodes that we've already visited
-    faiss::cppcontrib::knowhere::Bitset visited_nodes;
+        return faiss::cppcontrib::knowhere::Bitset::create_cleared(ntotal);
+    }
+
+    void
+    ReleaseVisitedNodes(faiss::cppcontrib::knowhere::Bitset&& bitset) {
+        if (bitset.bits == nullptr) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& pooled = visited_nodes[bitset.size];
+        if (pooled.size() < kMaxPooledPerSize) {
+            pooled.push_back(std::move(bitset));
+        }
+    }
+
+ private:
+    // bounds the memory held by the pool if a burst of iterators is created
+    static constexpr size_t kMaxPooledPerSize = 64;
+
+    std::mutex mtx;
+    std::unordered_map<size_t, std::vector<faiss::cppcontrib::knowhere::Bitset>> visited_nodes;
+};
+
+// Contains an iterator state
+struct FaissHnswIteratorWorkspace {
+    // hnsw.
+    // this pointer is not owned.
+    const faiss::HNSW* hnsw = nullptr;
+
+    // nodes that we've already visited
+    faiss::cppcontrib::knowhere::Bitset visited_nodes;
 
     // Computes distances.
     //   This needs to be wrapped with a sign change.
@@ -746,15 +1679,29 @@ struct FaissHnswIteratorWorkspace {
 class FaissHnswIterator : public IndexIterator {
  public:
     FaissHnswIterator(const std::shared_ptr<faiss::Index>& index_in,
-                      const std::shared_ptr<std::vector<uint32_t>>& labels_in, std::unique_ptr<float[]>&& query_in,
-                      const BitsetView& bitset_in, const int32_t ef_in, bool larger_is_closer,
-                      const float refine_ratio = 0.5f, const std::vector<uint32_t>& label_to_internal_offset_in = {},
+                      const std::shared_ptr<std::vector<uint32_t>>& labels_in,
+                      const std::shared_ptr<const CompressedHnswGraph>& compressed_graph_in,
+                      const std::shared_ptr<FaissHnswIteratorWorkspacePool>& workspace_pool_in,
+                      const std::shared_ptr<FaissHnswGrowingState>& growing_state_in,
+                      const std::shared_ptr<const std::vector<uint8_t>>& bitset_bits_in,
+                      std::unique_ptr<float[]>&& query_in, const BitsetView& bitset_in, const int32_t ef_in,
+                      bool larger_is_closer, const float refine_ratio = 0.5f,
+                      const std::vector<uint32_t>& label_to_internal_offset_in = {},
                       const uint32_t mv_base_offset_in = 0, bool use_knowhere_search_pool = true)
         : IndexIterator(larger_is_closer, use_knowhere_search_pool, refine_ratio),
           index{index_in},
           labels{labels_in},
+          compressed_graph{compressed_graph_in},
+          workspace_pool{workspace_pool_in},
+          growing_state{growing_state_in},
+          bitset_bits{bitset_bits_in},
           label_to_internal_offset(label_to_internal_offset_in),
           mv_base_offset(mv_base_offset_in) {
+        // the index does not grow while the iterator is alive
+        if (growing_state != nullptr) {
+            growing_lock = std::shared_lock<ReaderBiasedRWLock>(growing_state->mutex);
+        }
+
         workspace.accumulated_alpha =
             (bitset_in.count() >= (index->ntotal * HnswSearchThresholds::kHnswSearchKnnBFFilterThreshold))
                 ? std::numeric_limits<float>::max()
@@ -791,7 +1738,7 @@ class FaissHnswIterator : public IndexIterator {
                 //   this is a cosine index. But because refine always keeps original
                 //   data, then we need to use a wrapper over a distance computer
                 const faiss::HasInverseL2Norms* has_l2_norms =
-                    dynamic_cast<const faiss::HasInverseL2Norms*>(index_hnsw->storage);
+                    dynamic_cast<const faiss::HasInverseL2Norms*>(get_hnsw_codes_storage(index_hnsw->storage));
                 if (has_l2_norms != nullptr) {
                     // add a cosine wrapper over it
                     // DO NOT WRAP A SIGN, by design
@@ -823,6 +1770,11 @@ class FaissHnswIterator : public IndexIterator {
             workspace.qdis = std::unique_ptr<faiss::DistanceComputer>(storage_distance_computer(index_hnsw));
         }
 
+        // rows that are added concurrently are not iterated over
+        if (growing_state != nullptr && growing_state->enabled.load()) {
+            published_graph = growing_state->publisher.load(*workspace.hnsw);
+        }
+
         // set query
         workspace.qdis->set_query(query_in.get());
 
@@ -831,7 +1783,9 @@ class FaissHnswIterator : public IndexIterator {
         }
 
         // set up a buffer that tracks visited points
-        workspace.visited_nodes = faiss::cppcontrib::knowhere::Bitset::create_cleared(index->ntotal);
+        workspace.visited_nodes = (workspace_pool != nullptr)
+                                      ? workspace_pool->AcquireVisitedNodes(index->ntotal)
+                                      : faiss::cppcontrib::knowhere::Bitset::create_cleared(index->ntotal);
 
         workspace.search_params.efSearch = ef_in;
         // no need to set this one, use bitsetview directly
@@ -847,6 +1801,12 @@ class FaissHnswIterator : public IndexIterator {
         workspace.query = std::move(query_in);
     }
 
+    ~FaissHnswIterator() override {
+        if (workspace_pool != nullptr) {
+            workspace_pool->ReleaseVisitedNodes(std::move(workspace.visited_nodes));
+        }
+    }
+
  protected:
     template <typename FilterT>
     void
@@ -860,7 +1820,8 @@ class FaissHnswIterator : public IndexIterator {
         using idx_t = typename searcher_type::idx_t;
 
         searcher_type searcher(*workspace.hnsw, *workspace.qdis, workspace.graph_visitor, workspace.visited_nodes,
-                               filter, 1.0f, &workspace.search_params);
+                               filter, 1.0f, &workspace.search_params, 0, false, compressed_graph.get(), nullptr, 0,
+                               0.0f, published_graph.has_value() ? &published_graph.value() : nullptr);
 
         // whether to track hnsw stats
         constexpr bool track_hnsw_stats = true;
@@ -871,11 +1832,11 @@ class FaissHnswIterator : public IndexIterator {
             faiss::HNSWStats stats;
 
             // is the graph empty?
-            if (searcher.hnsw.entry_point != -1) {
+            if (searcher.get_entry_point() != -1) {
                 // not empty
 
                 // perform a search starting from the initial point
-                storage_idx_t nearest = searcher.hnsw.entry_point;
+                storage_idx_t nearest = searcher.get_entry_point();
                 float d_nearest = searcher.qdis(nearest);
 
                 // iterate through upper levels
@@ -1004,6 +1965,17 @@ class FaissHnswIterator : public IndexIterator {
  private:
     std::shared_ptr<faiss::Index> index;
     std::shared_ptr<std::vector<uint32_t>> labels;
+    // may be nullptr
+    std::shared_ptr<const CompressedHnswGraph> compressed_graph;
+    // may be nullptr
+    std::shared_ptr<FaissHnswIteratorWorkspacePool> workspace_pool;
+    // may be nullptr
+    std::shared_ptr<FaissHnswGrowingState> growing_state;
+    std::shared_lock<ReaderBiasedRWLock> growing_lock;
+    // the visible part of a growing graph
+    std::optional<HnswPublishedGraph> published_graph;
+    // may be nullptr, keeps the bits of the bitset if they are not owned by the caller
+    std::shared_ptr<const std::vector<uint8_t>> bitset_bits;
     const std::vector<uint32_t>& label_to_internal_offset;  // internal_offset = label_to_internal_offset[label_id];
     const uint32_t mv_base_offset;                          // mv_internal_offset = internal_offset - mv_base_offset;
 
@@ -1011,6 +1983,26 @@ class FaissHnswIterator : public IndexIterator {
 };
 
 //
+// A mapped index keeps its codes in the file, while the graph is read into memory: 2 * M neighbors at level 0, M per
+//   upper level with 1 / (M - 1) upper levels per row on average, plus an offset and a level per row. The rows come
+//   from vec_field_size_gb.
+template <typename DataType>
+expected<Resource>
+EstimateHnswLoadResource(const float file_size, const BaseConfig& config) {
+    const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
+    if (!hnsw_cfg.enable_mmap.value_or(false)) {
+        return Resource{file_size, 0.0f};
+    }
+    const float vec_field_size_gb = hnsw_cfg.vec_field_size_gb.value_or(0.0f);
+    if (!hnsw_cfg.dim.has_value() || hnsw_cfg.dim.value() <= 0 || vec_field_size_gb <= 0.0f) {
+        return Resource{0.0f, file_size};
+    }
+    const float m = hnsw_cfg.M.value();
+    const float graph_bytes = sizeof(faiss::HNSW::storage_idx_t) * (2 * m + m / (m - 1)) + sizeof(size_t) + sizeof(int);
+    const float graph_gb = vec_field_size_gb / (hnsw_cfg.dim.value() * sizeof(DataType)) * graph_bytes;
+    return Resource{std::min(graph_gb, file_size), file_size};
+}
+
 class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
  public:
     BaseFaissRegularIndexHNSWNode(const int32_t& version, const Object& object, DataFormatEnum data_format_in)
@@ -1030,6 +2022,9 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
 
     expected<DataSetPtr>
     GetVectorByIds(const DataSetPtr dataset) const override {
+        // a growing index is not reallocated while it is being read
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+
         if (indexes.empty()) {
             return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
         }
@@ -1061,85 +2056,81 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         auto rows = dataset->GetRows();
         auto ids = dataset->GetIds();
 
-        auto get_vector = [&](int64_t id, float* result) -> bool {
-            if (indexes.size() == 1) {
-                indexes_to_reconstruct_from[0]->reconstruct(id, result);
+        // the index and the offset in it of every row
+        std::vector<std::pair<int64_t, int64_t>> positions(rows);
+        for (int64_t i = 0; i < rows; i++) {
+            const int64_t id = ids[i];
+            assert(id >= 0 && id < Count());
+            if (label_to_internal_offset.empty()) {
+                positions[i] = {0, id};
             } else {
                 auto it =
                     std::lower_bound(index_rows_sum.begin(), index_rows_sum.end(), label_to_internal_offset[id] + 1);
                 if (it == index_rows_sum.end()) {
-                    return false;
+                    return expected<DataSetPtr>::Err(Status::invalid_index_error,
+                                                     "index inner error, cannot proceed with GetVectorByIds");
                 }
                 auto index_id = std::distance(index_rows_sum.begin(), it) - 1;
-                indexes_to_reconstruct_from[index_id]->reconstruct(
-                    label_to_internal_offset[id] - index_rows_sum[index_id], result);
+                positions[i] = {index_id, label_to_internal_offset[id] - index_rows_sum[index_id]};
             }
-            return true;
+        }
+
+        // the codes mapped from a file, which a batch asks the kernel for before it reconstructs them
+        std::vector<const faiss::IndexFlatCodes*> mapped_codes(indexes.size(), nullptr);
+        for (size_t i = 0; i < indexes.size(); i++) {
+            auto index_flat = dynamic_cast<const faiss::IndexFlatCodes*>(indexes_to_reconstruct_from[i]);
+            if (index_flat != nullptr && !index_flat->codes.is_owned) {
+                mapped_codes[i] = index_flat;
+            }
+        }
+        auto advise_batch = [&](const int64_t* batch, const int64_t n) {
+            std::vector<MappedRegion> regions;
+            for (int64_t j = 0; j < n; j++) {
+                const auto& [index_id, offset] = positions[batch[j]];
+                if (const auto* index_flat = mapped_codes[index_id]) {
+                    regions.push_back(MappedRegion{index_flat->codes.data() + offset * index_flat->code_size,
+                                                   index_flat->code_size, false});
+                }
+            }
+            AdviseWillNeed(regions);
+        };
+
+        // the rows are reconstructed in storage order into their places in the result
+        auto get_vectors = [&](auto* data) {
+            using OutT = std::remove_pointer_t<decltype(data)>;
+            ReadRowsInStorageOrder(positions, [&](const int64_t* batch, const int64_t n) {
+                advise_batch(batch, n);
+                // faiss produces fp32 data, the other formats are converted from a temporary fp32 buffer
+                std::vector<float> tmp(std::is_same_v<OutT, float> ? 0 : dim);
+                for (int64_t j = 0; j < n; j++) {
+                    const int64_t i = batch[j];
+                    const auto& [index_id, offset] = positions[i];
+                    if constexpr (std::is_same_v<OutT, float>) {
+                        indexes_to_reconstruct_from[index_id]->reconstruct(offset, data + i * dim);
+                    } else {
+                        indexes_to_reconstruct_from[index_id]->reconstruct(offset, tmp.data());
+                        convert_rows_from_fp32(tmp.data(), data, data_format, i, 1, dim);
+                    }
+                }
+            });
         };
 
         try {
             if (data_format == DataFormatEnum::fp32) {
-                // perform a direct reconstruction for fp32 data
                 auto data = std::make_unique<float[]>(dim * rows);
-                for (int64_t i = 0; i < rows; i++) {
-                    const int64_t id = ids[i];
-                    assert(id >= 0 && id < Count());
-                    if (!get_vector(id, data.get() + i * dim)) {
-                        return expected<DataSetPtr>::Err(Status::invalid_index_error,
-                                                         "index inner error, cannot proceed with GetVectorByIds");
-                    }
-                }
+                get_vectors(data.get());
                 return GenResultDataSet(rows, dim, std::move(data));
             } else if (data_format == DataFormatEnum::fp16) {
                 auto data = std::make_unique<knowhere::fp16[]>(dim * rows);
-                // faiss produces fp32 data format, we need some other format.
-                // Let's create a temporary fp32 buffer for this.
-                auto tmp = std::make_unique<float[]>(dim);
-                for (int64_t i = 0; i < rows; i++) {
-                    const int64_t id = ids[i];
-                    assert(id >= 0 && id < Count());
-                    if (!get_vector(id, tmp.get())) {
-                        return expected<DataSetPtr>::Err(Status::invalid_index_error,
-                                                         "index inner error, cannot proceed with GetVectorByIds");
-                    }
-                    if (!convert_rows_from_fp32(tmp.get(), data.get(), data_format, i, 1, dim)) {
-                        return expected<DataSetPtr>::Err(Status::invalid_args, "Unsupported data format");
-                    }
-                }
+                get_vectors(data.get());
                 return GenResultDataSet(rows, dim, std::move(data));
             } else if (data_format == DataFormatEnum::bf16) {
                 auto data = std::make_unique<knowhere::bf16[]>(dim * rows);
-                // faiss produces fp32 data format, we need some other format.
-                // Let's create a temporary fp32 buffer for this.
-                auto tmp = std::make_unique<float[]>(dim);
-                for (int64_t i = 0; i < rows; i++) {
-                    const int64_t id = ids[i];
-                    assert(id >= 0 && id < Count());
-                    if (!get_vector(id, tmp.get())) {
-                        return expected<DataSetPtr>::Err(Status::invalid_index_error,
-                                                         "index inner error, cannot proceed with GetVectorByIds");
-                    }
-                    if (!convert_rows_from_fp32(tmp.get(), data.get(), data_format, i, 1, dim)) {
-                        return expected<DataSetPtr>::Err(Status::invalid_args, "Unsupported data format");
-                    }
-                }
+                get_vectors(data.get());
                 return GenResultDataSet(rows, dim, std::move(data));
             } else if (data_format == DataFormatEnum::int8) {
                 auto data = std::make_unique<knowhere::int8[]>(dim * rows);
-                // faiss produces fp32 data format, we need some other format.
-                // Let's create a temporary fp32 buffer for this.
-                auto tmp = std::make_unique<float[]>(dim);
-                for (int64_t i = 0; i < rows; i++) {
-                    const int64_t id = ids[i];
-                    assert(id >= 0 && id < Count());
-                    if (!get_vector(id, tmp.get())) {
-                        return expected<DataSetPtr>::Err(Status::invalid_index_error,
-                                                         "index inner error, cannot proceed with GetVectorByIds");
-                    }
-                    if (!convert_rows_from_fp32(tmp.get(), data.get(), data_format, i, 1, dim)) {
-                        return expected<DataSetPtr>::Err(Status::invalid_args, "Unsupported data format");
-                    }
-                }
+                get_vectors(data.get());
                 return GenResultDataSet(rows, dim, std::move(data));
             } else {
                 return expected<DataSetPtr>::Err(Status::invalid_args, "Unsupported data format");
@@ -1151,7 +2142,113 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
     }
 
     expected<DataSetPtr>
-    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset_in) const override {
+        return SearchInto(dataset, std::move(cfg), bitset_in, nullptr, nullptr);
+    }
+
+    expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset_in, int64_t* ids_buf,
+                  float* dis_buf) const override {
+        return SearchInto(dataset, std::move(cfg), bitset_in, ids_buf, dis_buf);
+    }
+
+    // the groups are kept inside the traversal of the graph. Indexes that are partitioned by a scalar or refined are
+    //   searched through their iterators.
+    expected<DataSetPtr>
+    GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset_in) const override {
+        if (this->indexes.size() != 1 || !labels.empty() ||
+            dynamic_cast<faiss::IndexHNSW*>(this->indexes[0].get()) == nullptr) {
+            return IndexNode::GroupBySearch(dataset, std::move(cfg), bitset_in);
+        }
+        faiss::IndexHNSW* index_hnsw = static_cast<faiss::IndexHNSW*>(this->indexes[0].get());
+
+        // a growing index is not reallocated while it is being read
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+
+        // deleted rows are filtered out just like the ones of the bitset
+        std::vector<uint8_t> tombstone_bits;
+        const BitsetView bitset = getBitsetWithTombstones(bitset_in, tombstone_bits);
+
+        const auto keys = dataset->Get<std::shared_ptr<const GroupKeys>>(meta::GROUP_BY_KEYS);
+        if (keys == nullptr) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "the group keys of the rows are missing");
+        }
+
+        const auto dim = dataset->GetDim();
+        const auto rows = dataset->GetRows();
+        const auto* data = dataset->GetTensor();
+
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(*cfg);
+        const size_t n_groups = hnsw_cfg.k.value();
+        const size_t group_size = hnsw_cfg.group_size.value();
+        const size_t n_res = n_groups * group_size;
+
+        // set up faiss search parameters, same as a regular search
+        knowhere::SearchParametersHNSWWrapper hnsw_search_params;
+        if (hnsw_cfg.ef.has_value()) {
+            hnsw_search_params.efSearch = hnsw_cfg.ef.value();
+        }
+        hnsw_search_params.kAlpha = bitset.filter_ratio() * 0.7f;
+        hnsw_search_params.prefetch_depth = hnsw_cfg.prefetch_depth.value_or(0);
+        hnsw_search_params.two_hop_expansion =
+            hnsw_cfg.two_hop_expansion.value_or(false) &&
+            bitset.filter_ratio() >= HnswSearchThresholds::kHnswSearchTwoHopFilterThreshold;
+        hnsw_search_params.compressed_graph = getCompressedGraph(0);
+        hnsw_search_params.seed_table = getSeedTable(0);
+        hnsw_search_params.rabitq_query_bits = GetQueryQuantizationBits(*cfg);
+        // score the fp16 or bf16 queries in their type, if the codes are of it
+        hnsw_search_params.query_data_format = data_format;
+        const std::optional<HnswPublishedGraph> published_graph = getPublishedGraph();
+        hnsw_search_params.published_graph = published_graph.has_value() ? &published_graph.value() : nullptr;
+
+        BitsetViewIDSelector bw_idselector(bitset);
+        hnsw_search_params.sel = bitset.empty() ? nullptr : &bw_idselector;
+
+        IndexHNSWWrapper index_wrapper(index_hnsw);
+
+        auto ids = std::make_unique<faiss::idx_t[]>(rows * n_res);
+        auto distances = std::make_unique<float[]>(rows * n_res);
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(rows);
+            for (int64_t i = 0; i < rows; i++) {
+                futs.emplace_back(search_pool->push([&, idx = i]() {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+
+                    const float* cur_query = nullptr;
+                    if (data_format == DataFormatEnum::fp32) {
+                        cur_query = (const float*)data + idx * dim;
+                    } else {
+                        auto cur_query_tmp = SearchArena::Local().Allocate<float>(dim);
+                        convert_rows_to_fp32(data, cur_query_tmp, data_format, idx, 1, dim);
+                        cur_query = cur_query_tmp;
+                    }
+
+                    index_wrapper.search_group_by(1, cur_query, *keys, n_groups, group_size,
+                                                  distances.get() + idx * n_res, ids.get() + idx * n_res,
+                                                  &hnsw_search_params);
+                }));
+            }
+            WaitAllSuccess(futs);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+
+        return GenResultDataSet(rows, n_res, std::move(ids), std::move(distances));
+    }
+
+    // the results go to ids_buf and dis_buf if they are set, to new buffers otherwise
+    expected<DataSetPtr>
+    SearchInto(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset_in, int64_t* ids_buf,
+               float* dis_buf) const {
+        // a growing index is not reallocated while it is being read
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+
+        // deleted rows are filtered out just like the ones of the bitset
+        std::vector<uint8_t> tombstone_bits;
+        const BitsetView bitset = getBitsetWithTombstones(bitset_in, tombstone_bits);
+
         if (this->indexes.empty()) {
             return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
         }
@@ -1170,7 +2267,7 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
 
         const auto hnsw_cfg = static_cast<const FaissHnswConfig&>(*cfg);
         const auto k = hnsw_cfg.k.value();
-        auto index_id = getIndexToSearchByScalarInfo(hnsw_cfg, bitset);
+        auto index_id = getIndexToSearchByScalarInfo(hnsw_cfg, bitset_in);
         if (index_id < 0) {
             return expected<DataSetPtr>::Err(Status::invalid_args, "partition key value not correctly set");
         }
@@ -1193,8 +2290,9 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         const bool whether_to_enable_refine = hnsw_cfg.refine_k.has_value();
 
         // set up an index wrapper
-        auto [index_wrapper, is_refined] = create_conditional_hnsw_wrapper(
-            indexes[index_id].get(), hnsw_cfg, whether_bf_search.value_or(false), whether_to_enable_refine);
+        auto [index_wrapper, is_refined] =
+            create_conditional_hnsw_wrapper(indexes[index_id].get(), hnsw_cfg, whether_bf_search.value_or(false),
+                                            whether_to_enable_refine, getRefineCodesReader(index_id));
 
         if (index_wrapper == nullptr) {
             return expected<DataSetPtr>::Err(Status::invalid_args, "an input index seems to be unrelated to HNSW");
@@ -1205,7 +2303,8 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         faiss::Index* bf_index_wrapper_ptr = nullptr;
         if (!whether_bf_search.value_or(false)) {
             std::tie(bf_index_wrapper, is_refined) =
-                create_conditional_hnsw_wrapper(indexes[index_id].get(), hnsw_cfg, true, whether_to_enable_refine);
+                create_conditional_hnsw_wrapper(indexes[index_id].get(), hnsw_cfg, true, whether_to_enable_refine,
+                                                getRefineCodesReader(index_id));
             if (bf_index_wrapper == nullptr) {
                 return expected<DataSetPtr>::Err(Status::invalid_args, "an input index seems to be unrelated to HNSW");
             }
@@ -1226,6 +2325,28 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         hnsw_search_params.feder = feder_result.get();
         // set up kAlpha
         hnsw_search_params.kAlpha = bitset.filter_ratio() * 0.7f;
+        // set up the pipelined expansion
+        hnsw_search_params.prefetch_depth = hnsw_cfg.prefetch_depth.value_or(0);
+        // set up the two-hop expansion for highly selective filters
+        hnsw_search_params.two_hop_expansion =
+            hnsw_cfg.two_hop_expansion.value_or(false) &&
+            bitset.filter_ratio() >= HnswSearchThresholds::kHnswSearchTwoHopFilterThreshold;
+        // set up compressed neighbor lists
+        hnsw_search_params.compressed_graph = getCompressedGraph(index_id);
+        // set up additional entry points
+        hnsw_search_params.seed_table = getSeedTable(index_id);
+        // set up the fast-scan neighbor codes
+        hnsw_search_params.neighbor_codes = getNeighborCodes(index_id);
+        // set up the query quantization
+        hnsw_search_params.rabitq_query_bits = GetQueryQuantizationBits(*cfg);
+        // score the fp16 or bf16 queries in their type, if the codes are of it
+        hnsw_search_params.query_data_format = data_format;
+        // set up the adaptive early termination
+        hnsw_search_params.early_stop_patience = hnsw_cfg.early_stop_patience.value_or(0);
+        hnsw_search_params.early_stop_gap = hnsw_cfg.early_stop_gap.value_or(0.0f);
+        // rows that are being added concurrently are not visible
+        const std::optional<HnswPublishedGraph> published_graph = getPublishedGraph();
+        hnsw_search_params.published_graph = published_graph.has_value() ? &published_graph.value() : nullptr;
 
         // set up a selector
         BitsetViewIDSelector bw_idselector(bitset);
@@ -1241,41 +2362,53 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         }
         hnsw_search_params.sel = id_selector;
 
+        // set up the batched traversal
+        const int64_t query_batch_size = feder_result ? 1 : hnsw_cfg.query_batch_size.value_or(1);
+        hnsw_search_params.query_batch_size = query_batch_size;
+
+        // the valid rows a brute-force search scans
+        const int64_t n_valid_rows = static_cast<int64_t>(indexes[index_id]->ntotal) - bitset.count();
+        SearchStatsVec search_stats;
+        if (hnsw_cfg.search_stats.value()) {
+            search_stats.resize(rows);
+        }
+
         // run
-        auto ids = std::make_unique<faiss::idx_t[]>(rows * k);
-        auto distances = std::make_unique<float[]>(rows * k);
+        auto ids = MakeResultBuffer<faiss::idx_t>(rows * k, ids_buf);
+        auto distances = MakeResultBuffer<float>(rows * k, dis_buf);
 
         try {
             std::vector<folly::Future<folly::Unit>> futs;
-            futs.reserve(rows);
+            futs.reserve((rows + query_batch_size - 1) / query_batch_size);
 
-            for (int64_t i = 0; i < rows; ++i) {
-                futs.emplace_back(search_pool->push([&, idx = i, is_refined = is_refined,
-                                                     index_wrapper_ptr = index_wrapper_ptr,
+            for (int64_t i = 0; i < rows; i += query_batch_size) {
+                futs.emplace_back(search_pool->push([&, idx_start = i,
+                                                     nq = std::min<int64_t>(query_batch_size, rows - i),
+                                                     is_refined = is_refined, index_wrapper_ptr = index_wrapper_ptr,
                                                      bf_index_wrapper_ptr = bf_index_wrapper_ptr]() {
-                    // 1 thread per element
+                    // 1 thread per group of queries
                     ThreadPool::ScopedSearchOmpSetter setter(1);
 
-                    // set up a query
-                    const float* cur_query = nullptr;
+                    // set up queries
+                    const float* cur_queries = nullptr;
 
-                    std::vector<float> cur_query_tmp(dim);
                     if (data_format == DataFormatEnum::fp32) {
-                        cur_query = (const float*)data + idx * dim;
+                        cur_queries = (const float*)data + idx_start * dim;
                     } else {
-                        convert_rows_to_fp32(data, cur_query_tmp.data(), data_format, idx, 1, dim);
-                        cur_query = cur_query_tmp.data();
+                        auto cur_queries_tmp = SearchArena::Local().Allocate<float>(nq * dim);
+                        convert_rows_to_fp32(data, cur_queries_tmp, data_format, idx_start, nq, dim);
+                        cur_queries = cur_queries_tmp;
                     }
 
                     // set up local results
-                    faiss::idx_t* const __restrict local_ids = ids.get() + k * idx;
-                    float* const __restrict local_distances = distances.get() + k * idx;
+                    faiss::idx_t* const __restrict local_ids = ids.get() + k * idx_start;
+                    float* const __restrict local_distances = distances.get() + k * idx_start;
 
                     // check if we need to perform a brute-force search bcz of the lack of results
-                    auto bf_search_needed = [&]() -> bool {
+                    auto bf_search_needed = [&](const int64_t query_idx) -> bool {
                         size_t real_topk = 0;
                         for (auto j = 0; j < k; ++j) {
-                            if (local_ids[j] < 0) {
+                            if (local_ids[query_idx * k + j] < 0) {
                                 continue;
                             }
                             real_topk++;
@@ -1287,28 +2420,58 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
                         return false;
                     };
 
+                    // the stats of the queries of the group go to their own slots
+                    SearchParametersHNSWWrapper* base_params = &hnsw_search_params;
+                    SearchParametersHNSWWrapper stats_params;
+                    std::vector<faiss::HNSWStats> query_stats;
+                    if (!search_stats.empty()) {
+                        query_stats.resize(nq);
+                        stats_params = hnsw_search_params;
+                        stats_params.query_stats = query_stats.data();
+                        base_params = &stats_params;
+                    }
+
                     // perform the search
-                    if (is_refined) {
-                        faiss::IndexRefineSearchParameters refine_params;
-                        refine_params.k_factor = hnsw_cfg.refine_k.value_or(1);
-                        // a refine procedure itself does not need to care about filtering
-                        refine_params.sel = nullptr;
-                        refine_params.base_index_params = &hnsw_search_params;
+                    faiss::IndexRefineSearchParameters refine_params;
+                    refine_params.k_factor = hnsw_cfg.refine_k.value_or(1);
+                    // a refine procedure itself does not need to care about filtering
+                    refine_params.sel = nullptr;
+                    refine_params.base_index_params = base_params;
+
+                    const faiss::SearchParameters* search_params =
+                        is_refined ? static_cast<const faiss::SearchParameters*>(&refine_params)
+                                   : static_cast<const faiss::SearchParameters*>(base_params);
+
+                    std::vector<uint8_t> bf_searched(nq, whether_bf_search.value_or(false));
+                    {
+                        // the refine of a refined index is a part of its search
+                        ScopedSearchPhase phase(SearchPhase::SCAN);
+                        index_wrapper_ptr->search(nq, cur_queries, k, local_distances, local_ids, search_params);
+                        for (int64_t q = 0; q < nq; q++) {
+                            if (bf_search_needed(q)) {
+                                bf_index_wrapper_ptr->search(1, cur_queries + q * dim, k, local_distances + q * k,
+                                                             local_ids + q * k, search_params);
+                                bf_searched[q] = 1;
+                            }
+                        }
+                    }
 
-                        index_wrapper_ptr->search(1, cur_query, k, local_distances, local_ids, &refine_params);
-                        if (bf_search_needed()) {
-                            bf_index_wrapper_ptr->search(1, cur_query, k, local_distances, local_ids, &refine_params);
+                    for (int64_t q = 0; q < nq && !search_stats.empty(); q++) {
+                        SearchStats& stats = search_stats[idx_start + q];
+                        stats.ndis = query_stats[q].ndis;
+                        stats.nhops = query_stats[q].nhops;
+                        if (bf_searched[q]) {
+                            stats.ndis += n_valid_rows;
+                            stats.bf_fallback = true;
                         }
-                    } else {
-                        index_wrapper_ptr->search(1, cur_query, k, local_distances, local_ids, &hnsw_search_params);
-                        if (bf_search_needed()) {
-                            bf_index_wrapper_ptr->search(1, cur_query, k, local_distances, local_ids,
-                                                         &hnsw_search_params);
+                        if (is_refined) {
+                            stats.nrefine = k * refine_params.k_factor;
                         }
                     }
 
                     if (!labels.empty()) {
-                        for (auto j = 0; j < k; ++j) {
+                        ScopedSearchPhase phase(SearchPhase::ASSEMBLE);
+                        for (auto j = 0; j < nq * k; ++j) {
                             local_ids[j] = local_ids[j] < 0 ? local_ids[j] : labels[index_id]->operator[](local_ids[j]);
                         }
                     }
@@ -1332,16 +2495,27 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
             res->SetJsonInfo(json_visit_info.dump());
             res->SetJsonIdSet(json_id_set.dump());
         }
+        if (!search_stats.empty()) {
+            res->Set(meta::SEARCH_STATS, std::move(search_stats));
+        }
 
         return res;
     }
 
     expected<DataSetPtr>
-    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset_in) const override {
         // if support ann_iterator, use iterator-based range_search (IndexNode::RangeSearch)
         if (is_ann_iterator_supported()) {
-            return IndexNode::RangeSearch(dataset, std::move(cfg), bitset);
+            return IndexNode::RangeSearch(dataset, std::move(cfg), bitset_in);
         }
+
+        // a growing index is not reallocated while it is being read
+        std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+
+        // deleted rows are filtered out just like the ones of the bitset
+        std::vector<uint8_t> tombstone_bits;
+        const BitsetView bitset = getBitsetWithTombstones(bitset_in, tombstone_bits);
+
         if (this->indexes.empty()) {
             return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
         }
@@ -1359,7 +2533,7 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         const auto* data = dataset->GetTensor();
 
         const auto hnsw_cfg = static_cast<const FaissHnswConfig&>(*cfg);
-        auto index_id = getIndexToSearchByScalarInfo(hnsw_cfg, bitset);
+        auto index_id = getIndexToSearchByScalarInfo(hnsw_cfg, bitset_in);
         if (index_id < 0) {
             return expected<DataSetPtr>::Err(Status::invalid_args, "partition key value not correctly set");
         }
@@ -1388,8 +2562,9 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         const bool whether_to_enable_refine = true;
 
         // set up an index wrapper
-        auto [index_wrapper, is_refined] = create_conditional_hnsw_wrapper(
-            indexes[index_id].get(), hnsw_cfg, whether_bf_search.value_or(false), whether_to_enable_refine);
+        auto [index_wrapper, is_refined] =
+            create_conditional_hnsw_wrapper(indexes[index_id].get(), hnsw_cfg, whether_bf_search.value_or(false),
+                                            whether_to_enable_refine, getRefineCodesReader(index_id));
 
         if (index_wrapper == nullptr) {
             return expected<DataSetPtr>::Err(Status::invalid_args, "an input index seems to be unrelated to HNSW");
@@ -1410,6 +2585,23 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         hnsw_search_params.feder = feder_result.get();
         // set up kAlpha
         hnsw_search_params.kAlpha = bitset.filter_ratio() * 0.7f;
+        // set up the pipelined expansion
+        hnsw_search_params.prefetch_depth = hnsw_cfg.prefetch_depth.value_or(0);
+        // set up the two-hop expansion for highly selective filters
+        hnsw_search_params.two_hop_expansion =
+            hnsw_cfg.two_hop_expansion.value_or(false) &&
+            bitset.filter_ratio() >= HnswSearchThresholds::kHnswSearchTwoHopFilterThreshold;
+        // set up compressed neighbor lists
+        hnsw_search_params.compressed_graph = getCompressedGraph(index_id);
+        // set up additional entry points
+        hnsw_search_params.seed_table = getSeedTable(index_id);
+        // set up the query quantization
+        hnsw_search_params.rabitq_query_bits = GetQueryQuantizationBits(*cfg);
+        // score the fp16 or bf16 queries in their type, if the codes are of it
+        hnsw_search_params.query_data_format = data_format;
+        // rows that are being added concurrently are not visible
+        const std::optional<HnswPublishedGraph> published_graph = getPublishedGraph();
+        hnsw_search_params.published_graph = published_graph.has_value() ? &published_graph.value() : nullptr;
 
         // set up a selector
         BitsetViewIDSelector bw_idselector(bitset);
@@ -1505,13 +2697,105 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         return GenResultDataSet(rows, std::move(range_search_result));
     }
 
+    Status
+    Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) override {
+        if (isIndexEmpty()) {
+            LOG_KNOWHERE_ERROR_ << "Can not merge data to an empty index.";
+            return Status::empty_index;
+        }
+        if (indexes.size() > 1 || !compressed_graphs.empty() || getIndexHNSW(indexes[0].get()) != indexes[0].get()) {
+            LOG_KNOWHERE_ERROR_ << "Merge is not supported for HNSW indexes with a refine, a compressed graph or "
+                                   "multiple partitions";
+            return Status::not_implemented;
+        }
+        if (growing_state->enabled.load()) {
+            LOG_KNOWHERE_ERROR_ << "Merge is not supported for HNSW indexes with concurrent inserts";
+            return Status::not_implemented;
+        }
+
+        std::vector<const BaseFaissRegularIndexHNSWNode*> other_nodes;
+        for (const auto* other : others) {
+            auto other_node = dynamic_cast<const BaseFaissRegularIndexHNSWNode*>(other);
+            if (other_node == nullptr || other_node->Type() != Type()) {
+                LOG_KNOWHERE_ERROR_ << "can not merge indexes of different types";
+                return Status::invalid_args;
+            }
+            if (other_node->isIndexEmpty()) {
+                LOG_KNOWHERE_ERROR_ << "can not merge an empty index";
+                return Status::empty_index;
+            }
+            if (other_node->indexes.size() > 1 || !other_node->compressed_graphs.empty() ||
+                getIndexHNSW(other_node->indexes[0].get()) != other_node->indexes[0].get()) {
+                LOG_KNOWHERE_ERROR_ << "Merge is not supported for HNSW indexes with a refine, a compressed graph or "
+                                       "multiple partitions";
+                return Status::not_implemented;
+            }
+            if (other_node->growing_state->enabled.load()) {
+                LOG_KNOWHERE_ERROR_ << "Merge is not supported for HNSW indexes with concurrent inserts";
+                return Status::not_implemented;
+            }
+            std::shared_lock<ReaderBiasedRWLock> other_growing_lock(other_node->growing_state->mutex);
+            if (!other_node->growing_state->tombstones.empty()) {
+                LOG_KNOWHERE_ERROR_ << "can not merge an index with deleted rows";
+                return Status::not_implemented;
+            }
+            other_nodes.push_back(other_node);
+        }
+
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(*cfg);
+
+        // use build_pool_ to make sure the OMP threads spawned by the merge
+        // can inherit the low nice value of threads in build_pool_.
+        auto tryObj =
+            build_pool
+                ->push([&] {
+                    std::unique_ptr<ThreadPool::ScopedBuildOmpSetter> setter;
+                    if (hnsw_cfg.num_build_thread.has_value()) {
+                        setter = std::make_unique<ThreadPool::ScopedBuildOmpSetter>(hnsw_cfg.num_build_thread.value());
+                    } else {
+                        setter = std::make_unique<ThreadPool::ScopedBuildOmpSetter>();
+                    }
+
+                    TimeRecorder rc("HNSW merge");
+                    const int ef = hnsw_cfg.efConstruction.value();
+                    {
+                        auto graph_lock = LockGraphForModification();
+                        for (const auto* other_node : other_nodes) {
+                            MergeIndex(*other_node, ef);
+                        }
+                    }
+                    rc.ElapseFromBegin("done");
+
+                    // the merged graph is reordered and seeded just like a freshly built one
+                    return PostAddInternal(*cfg);
+                })
+                .getTry();
+
+        if (!tryObj.hasValue()) {
+            LOG_KNOWHERE_WARNING_ << "faiss internal error: " << tryObj.exception().what();
+            return Status::faiss_inner_error;
+        }
+
+        return tryObj.value();
+    }
+
  protected:
     DataFormatEnum data_format;
 
     std::vector<std::vector<int>> tmp_combined_scalar_ids;
 
+    // reusable buffers for iterators
+    std::shared_ptr<FaissHnswIteratorWorkspacePool> iterator_workspace_pool =
+        std::make_shared<FaissHnswIteratorWorkspacePool>();
+
+    // the number of bits to quantize a query with during the graph traversal, -1 keeps the storage default
+    virtual int
+    GetQueryQuantizationBits(const Config& cfg) const {
+        return -1;
+    }
+
     Status
-    AddInternal(const DataSetPtr dataset, const Config&) override {
+    AddInternal(const DataSetPtr dataset, const Config& cfg) override {
         if (isIndexEmpty()) {
             LOG_KNOWHERE_ERROR_ << "Can not add data to an empty index.";
             return Status::empty_index;
@@ -1519,13 +2803,34 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
 
         auto rows = dataset->GetRows();
 
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(cfg);
+        if (hnsw_cfg.concurrent_insert.value_or(false) || growing_state->enabled.load()) {
+            try {
+                LOG_KNOWHERE_INFO_ << "Adding " << rows << " rows to HNSW Index concurrently";
+                return AddConcurrently(dataset);
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return Status::faiss_inner_error;
+            }
+        }
+
+        // no graph repair runs in the middle of an add
+        auto graph_lock = LockGraphForModification();
+
         const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info_map =
             dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO);
         if (scalar_info_map.empty() || tmp_combined_scalar_ids.size() <= 1) {
             try {
                 LOG_KNOWHERE_INFO_ << "Adding " << rows << " rows to HNSW Index";
 
-                auto status = add_to_index(indexes[0].get(), dataset, data_format);
+                const faiss::idx_t ntotal_before = indexes[0]->ntotal;
+                const auto base_graph = dataset->Get<std::shared_ptr<const std::vector<uint32_t>>>(meta::BASE_GRAPH);
+                auto status = (base_graph != nullptr)
+                                  ? add_with_base_graph(indexes[0].get(), dataset, data_format, *base_graph)
+                                  : add_to_index(indexes[0].get(), dataset, data_format);
+                if (status == Status::success) {
+                    ExtendLabelsOfReorderedIndex(ntotal_before);
+                }
                 return status;
             } catch (const std::exception& e) {
                 LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
@@ -1563,6 +2868,152 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         return Status::success;
     }
 
+    Status
+    PostAddInternal(const Config& cfg) override {
+        // the graph of a growing index is searched while it is extended, so it is left as is
+        if (growing_state->enabled.load()) {
+            return Status::success;
+        }
+
+        const auto& hnsw_cfg = static_cast<const FaissHnswConfig&>(cfg);
+        const auto reorder_type = parse_hnsw_reorder_type(hnsw_cfg.reorder_type.value_or("none"));
+        if (!reorder_type.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "invalid reorder type: " << hnsw_cfg.reorder_type.value();
+            return Status::invalid_args;
+        }
+        if (reorder_type.value() != HnswReorderType::NONE) {
+            try {
+                auto graph_lock = LockGraphForModification();
+                auto status = ReorderIndexes(reorder_type.value());
+                if (status != Status::success) {
+                    return status;
+                }
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return Status::faiss_inner_error;
+            }
+        }
+
+        // seeds refer to node ids, so they are picked after the reordering
+        return BuildSeedTablesIfRequested(cfg);
+    }
+
+    // Permutes nodes of every index for a better memory locality.
+    // labels keep the original ids of the permuted nodes, so that ids in
+    //   search results and in bitsets remain unchanged for the caller.
+    Status
+    ReorderIndexes(const HnswReorderType reorder_type) {
+        TimeRecorder rc("HNSW reorder");
+
+        if (labels.empty()) {
+            // no MV partitions, nodes are identified by their insertion order
+            labels.resize(1);
+            labels[0] = std::make_shared<std::vector<uint32_t>>(indexes[0]->ntotal);
+            std::iota(labels[0]->begin(), labels[0]->end(), 0);
+            index_rows_sum = {0, static_cast<uint32_t>(indexes[0]->ntotal)};
+        }
+
+        for (size_t i = 0; i < indexes.size(); i++) {
+            const faiss::HNSW* hnsw = get_hnsw_to_reorder(indexes[i].get());
+            if (hnsw == nullptr) {
+                LOG_KNOWHERE_ERROR_ << "an input index seems to be unrelated to HNSW";
+                return Status::invalid_index_error;
+            }
+
+            const std::vector<faiss::idx_t> perm = compute_hnsw_reorder_permutation(*hnsw, reorder_type);
+            permute_hnsw_index(indexes[i].get(), perm.data());
+
+            // perm maps new positions to old ones
+            auto new_labels = std::make_shared<std::vector<uint32_t>>(perm.size());
+            for (size_t j = 0; j < perm.size(); j++) {
+                new_labels->operator[](j) = labels[i]->operator[](perm[j]);
+            }
+            labels[i] = std::move(new_labels);
+        }
+
+        // rebuild the reverse mapping
+        label_to_internal_offset.resize(index_rows_sum.back());
+        for (size_t i = 0; i < indexes.size(); i++) {
+            for (size_t j = 0; j < labels[i]->size(); j++) {
+                label_to_internal_offset[labels[i]->operator[](j)] = index_rows_sum[i] + j;
+            }
+        }
+
+        rc.ElapseFromBegin("done");
+        return Status::success;
+    }
+
+    // Appends the single partition of another node. Rows of the other node
+    //   follow the rows of this one, so their labels are shifted.
+    void
+    MergeIndex(const BaseFaissRegularIndexHNSWNode& other, const int ef) {
+        const faiss::idx_t ntotal_before = indexes[0]->ntotal;
+        const faiss::idx_t other_ntotal = other.indexes[0]->ntotal;
+
+        merge_hnsw_index(getIndexHNSW(indexes[0].get()), getIndexHNSW(other.indexes[0].get()), ef);
+
+        // labels of reordered indexes are kept, others are identities
+        if (labels.empty() && other.labels.empty()) {
+            return;
+        }
+
+        auto merged_labels = std::make_shared<std::vector<uint32_t>>(ntotal_before + other_ntotal);
+        for (faiss::idx_t j = 0; j < ntotal_before; j++) {
+            merged_labels->operator[](j) = labels.empty() ? j : labels[0]->operator[](j);
+        }
+        for (faiss::idx_t j = 0; j < other_ntotal; j++) {
+            merged_labels->operator[](ntotal_before + j) =
+                ntotal_before + (other.labels.empty() ? j : other.labels[0]->operator[](j));
+        }
+
+        labels = {std::move(merged_labels)};
+        index_rows_sum = {0, static_cast<uint32_t>(ntotal_before + other_ntotal)};
+        label_to_internal_offset.resize(ntotal_before + other_ntotal);
+        for (size_t j = 0; j < labels[0]->size(); j++) {
+            label_to_internal_offset[labels[0]->operator[](j)] = j;
+        }
+    }
+
+    // Adds rows to a single-partition index that may be searched at the same time.
+    // Searches see the new rows once they are linked into the graph.
+    Status
+    AddConcurrently(const DataSetPtr dataset) {
+        faiss::IndexHNSW* index_hnsw = getIndexHNSW(indexes[0].get());
+        if (indexes.size() > 1 || index_hnsw != indexes[0].get() || !labels.empty() || !compressed_graphs.empty() ||
+            !neighbor_codes.empty()) {
+            LOG_KNOWHERE_ERROR_ << "concurrent inserts are not supported for HNSW indexes with a refine, a reorder, "
+                                   "a compressed graph, neighbor codes or multiple partitions";
+            return Status::invalid_args;
+        }
+
+        FaissHnswGrowingState& state = *growing_state;
+        std::lock_guard<std::mutex> add_lock(state.add_mutex);
+        if (!state.enabled.load()) {
+            // the rows that are already in the graph stay visible
+            state.publisher.publish(index_hnsw->hnsw, index_hnsw->ntotal);
+            state.enabled.store(true);
+        }
+
+        return add_to_index(dataset, data_format, [&](faiss::idx_t n, const float* x) {
+            add_to_hnsw_concurrently(index_hnsw, n, x, state.mutex, state.publisher);
+        });
+    }
+
+    // newly added rows of a reordered index keep their insertion order
+    void
+    ExtendLabelsOfReorderedIndex(const faiss::idx_t ntotal_before) {
+        if (labels.size() != 1 || labels[0]->size() != static_cast<size_t>(ntotal_before)) {
+            return;
+        }
+
+        const faiss::idx_t ntotal_after = indexes[0]->ntotal;
+        for (faiss::idx_t j = ntotal_before; j < ntotal_after; j++) {
+            labels[0]->push_back(j);
+            label_to_internal_offset.push_back(j);
+        }
+        index_rows_sum.back() = ntotal_after;
+    }
+
     const faiss::Index*
     GetIndexToReconstructRawDataFrom(int i) const {
         if (indexes.size() <= i) {
@@ -1661,13 +3112,21 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
     }
 
     expected<std::vector<IndexNode::IteratorPtr>>
-    AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
+    AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset_in,
                 bool use_knowhere_search_pool) const override {
         if (isIndexEmpty()) {
             LOG_KNOWHERE_ERROR_ << "creating iterator on empty index";
             return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::empty_index, "index not loaded");
         }
 
+        // deleted rows are filtered out just like the ones of the bitset, iterators share the combined bits
+        auto tombstone_bits = std::make_shared<std::vector<uint8_t>>();
+        BitsetView bitset;
+        {
+            std::shared_lock<ReaderBiasedRWLock> growing_lock(growing_state->mutex);
+            bitset = getBitsetWithTombstones(bitset_in, *tombstone_bits);
+        }
+
         if (!is_ann_iterator_supported()) {
             LOG_KNOWHERE_ERROR_ << "Unsupported data format";
             return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::invalid_args, "unsupported data format");
@@ -1681,7 +3140,7 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
         auto vec = std::vector<IndexNode::IteratorPtr>(n_queries, nullptr);
 
         const FaissHnswConfig& hnsw_cfg = static_cast<const FaissHnswConfig&>(*cfg);
-        int index_id = getIndexToSearchByScalarInfo(hnsw_cfg, bitset);
+        int index_id = getIndexToSearchByScalarInfo(hnsw_cfg, bitset_in);
         if (index_id < 0) {
             return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::invalid_args,
                                                                       "partition key value not correctly set");
@@ -1723,9 +3182,10 @@ class BaseFaissRegularIndexHNSWNode : public BaseFaissRegularIndexNode {
                 uint32_t mv_base_offset = index_rows_sum.size() > index_id ? index_rows_sum[index_id] : 0;
 
                 auto it = std::make_shared<FaissHnswIterator>(
-                    indexes[index_id], labels.empty() ? nullptr : labels[index_id], std::move(cur_query), bitset, ef,
-                    larger_is_closer, iterator_refine_ratio, label_to_internal_offset, mv_base_offset,
-                    use_knowhere_search_pool);
+                    indexes[index_id], labels.empty() ? nullptr : labels[index_id],
+                    compressed_graphs.empty() ? nullptr : compressed_graphs[index_id], iterator_workspace_pool,
+                    growing_state, tombstone_bits, std::move(cur_query), bitset, ef, larger_is_closer,
+                    iterator_refine_ratio, label_to_internal_offset, mv_base_offset, use_knowhere_search_pool);
                 // store
                 vec[i] = it;
             }
@@ -1759,6 +3219,11 @@ class BaseFaissRegularIndexHNSWFlatNode : public BaseFaissRegularIndexHNSWNode {
         return knowhere::IndexEnum::INDEX_HNSW;
     }
 
+    bool
+    IsIncrementalAddSupported() const override {
+        return true;
+    }
+
  protected:
     Status
     TrainInternal(const DataSetPtr dataset, const Config& cfg) override {
@@ -1817,6 +3282,7 @@ class BaseFaissRegularIndexHNSWFlatNode : public BaseFaissRegularIndexHNSWNode {
                 }
             }
             hnsw_index->hnsw.efConstruction = hnsw_cfg.efConstruction.value();
+            hnsw_index->add_batch_size = hnsw_cfg.add_batch_size.value();
             // train
             LOG_KNOWHERE_INFO_ << "Training HNSW Index";
             // this function does nothing for the given parameters and indices.
@@ -1866,6 +3332,11 @@ class BaseFaissRegularIndexHNSWFlatNodeTemplate : public BaseFaissRegularIndexHN
     StaticHasRawData(const knowhere::BaseConfig& config, const IndexVersion& version) {
         return true;
     }
+
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return EstimateHnswLoadResource<DataType>(file_size, config);
+    }
 };
 
 // this is a regular node that can be initialized as some existing index type,
@@ -1910,12 +3381,50 @@ class HNSWIndexNodeWithFallback : public IndexNode {
         }
     }
 
-    expected<DataSetPtr>
-    GetIndexMeta(std::unique_ptr<Config> cfg) const override {
-        if (use_base_index) {
-            return base_index->GetIndexMeta(std::move(cfg));
-        } else {
-            return fallback_search_index->GetIndexMeta(std::move(cfg));
+    Status
+    Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) override {
+        std::vector<const IndexNode*> other_nodes;
+        for (const auto* other : others) {
+            auto other_wrapper = dynamic_cast<const HNSWIndexNodeWithFallback*>(other);
+            if (other_wrapper == nullptr || other_wrapper->use_base_index != use_base_index) {
+                LOG_KNOWHERE_ERROR_ << "can not merge indexes of different types";
+                return Status::invalid_args;
+            }
+            other_nodes.push_back(use_base_index ? other_wrapper->base_index.get()
+                                                 : other_wrapper->fallback_search_index.get());
+        }
+
+        if (use_base_index) {
+            return base_index->Merge(other_nodes, cfg);
+        } else {
+            return fallback_search_index->Merge(other_nodes, cfg);
+        }
+    }
+
+    Status
+    DeleteByIds(const DataSetPtr dataset) override {
+        if (use_base_index) {
+            return base_index->DeleteByIds(dataset);
+        } else {
+            return fallback_search_index->DeleteByIds(dataset);
+        }
+    }
+
+    bool
+    IsIncrementalAddSupported() const override {
+        if (use_base_index) {
+            return base_index->IsIncrementalAddSupported();
+        } else {
+            return fallback_search_index->IsIncrementalAddSupported();
+        }
+    }
+
+    expected<DataSetPtr>
+    GetIndexMeta(std::unique_ptr<Config> cfg) const override {
+        if (use_base_index) {
+            return base_index->GetIndexMeta(std::move(cfg));
+        } else {
+            return fallback_search_index->GetIndexMeta(std::move(cfg));
         }
     }
 
@@ -1946,6 +3455,24 @@ class HNSWIndexNodeWithFallback : public IndexNode {
         }
     }
 
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        if (use_base_index) {
+            return base_index->SerializeToFile(filename);
+        } else {
+            return fallback_search_index->SerializeToFile(filename);
+        }
+    }
+
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        if (use_base_index) {
+            return base_index->MappedRegions();
+        } else {
+            return fallback_search_index->MappedRegions();
+        }
+    }
+
     int64_t
     Dim() const override {
         if (use_base_index) {
@@ -1973,6 +3500,15 @@ class HNSWIndexNodeWithFallback : public IndexNode {
         }
     }
 
+    MemoryUsage
+    MemoryBreakdown() const override {
+        if (use_base_index) {
+            return base_index->MemoryBreakdown();
+        } else {
+            return fallback_search_index->MemoryBreakdown();
+        }
+    }
+
     std::string
     Type() const override {
         if (use_base_index) {
@@ -2009,6 +3545,16 @@ class HNSWIndexNodeWithFallback : public IndexNode {
         }
     }
 
+    expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const override {
+        if (use_base_index) {
+            return base_index->SearchWithBuf(dataset, std::move(cfg), bitset, ids, dis);
+        } else {
+            return fallback_search_index->SearchWithBuf(dataset, std::move(cfg), bitset, ids, dis);
+        }
+    }
+
     expected<DataSetPtr>
     RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
         if (use_base_index) {
@@ -2018,6 +3564,15 @@ class HNSWIndexNodeWithFallback : public IndexNode {
         }
     }
 
+    expected<DataSetPtr>
+    GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        if (use_base_index) {
+            return base_index->GroupBySearch(dataset, std::move(cfg), bitset);
+        } else {
+            return fallback_search_index->GroupBySearch(dataset, std::move(cfg), bitset);
+        }
+    }
+
     expected<std::vector<IndexNode::IteratorPtr>>
     AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
                 bool use_knowhere_search_pool) const override {
@@ -2049,6 +3604,11 @@ class BaseFaissRegularIndexHNSWFlatNodeTemplateWithSearchFallback : public HNSWI
         return true;
     }
 
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return EstimateHnswLoadResource<DataType>(file_size, config);
+    }
+
     static std::unique_ptr<BaseConfig>
     StaticCreateConfig() {
         return std::make_unique<FaissHnswFlatConfig>();
@@ -2060,6 +3620,40 @@ class BaseFaissRegularIndexHNSWFlatNodeTemplateWithSearchFallback : public HNSWI
     }
 };
 
+// wraps the storage of an HNSW index into a rotation that is trained along with it. The vectors are rotated before
+//   they are added to the storage, and the queries by the distance computer of the storage.
+Status
+rotate_hnsw_storage(faiss::IndexHNSW* index_hnsw, const std::string& rotation) {
+    const std::string rotation_tolower = str_to_lower(rotation);
+    if (rotation_tolower == "none") {
+        return Status::success;
+    }
+
+    const int d = index_hnsw->storage->d;
+    std::unique_ptr<faiss::VectorTransform> transform;
+    if (rotation_tolower == "random") {
+        transform = std::make_unique<faiss::RandomRotationMatrix>(d, d);
+    } else if (rotation_tolower == "opq") {
+        // subspaces of about 4 dimensions, the learned rotation balances the variance between them
+        int m = std::max(d / 4, 1);
+        while (d % m != 0) {
+            m--;
+        }
+        auto opq = std::make_unique<faiss::OPQMatrix>(d, m);
+        opq->niter = 10;
+        transform = std::move(opq);
+    } else {
+        LOG_KNOWHERE_ERROR_ << "Invalid sq rotation: " << rotation;
+        return Status::invalid_args;
+    }
+
+    auto storage = std::make_unique<faiss::IndexPreTransform>(transform.release(), index_hnsw->storage);
+    storage->own_fields = true;
+    index_hnsw->storage = storage.release();
+    index_hnsw->is_trained = false;
+    return Status::success;
+}
+
 //
 class BaseFaissRegularIndexHNSWSQNode : public BaseFaissRegularIndexHNSWNode {
  public:
@@ -2082,6 +3676,11 @@ class BaseFaissRegularIndexHNSWSQNode : public BaseFaissRegularIndexHNSWNode {
         return knowhere::IndexEnum::INDEX_HNSW_SQ;
     }
 
+    bool
+    IsIncrementalAddSupported() const override {
+        return true;
+    }
+
  protected:
     Status
     TrainInternal(const DataSetPtr dataset, const Config& cfg) override {
@@ -2108,6 +3707,13 @@ class BaseFaissRegularIndexHNSWSQNode : public BaseFaissRegularIndexHNSWNode {
             return Status::invalid_args;
         }
 
+        // rotated int8 vectors are no longer integers
+        const std::string sq_rotation = hnsw_cfg.sq_rotation.value_or("none");
+        if (str_to_lower(sq_rotation) != "none" && data_format == DataFormatEnum::int8) {
+            LOG_KNOWHERE_ERROR_ << "sq rotation is not supported for int8 data";
+            return Status::invalid_args;
+        }
+
         // create an index
         const bool is_cosine = IsMetricType(hnsw_cfg.metric_type.value(), metric::COSINE);
 
@@ -2122,8 +3728,10 @@ class BaseFaissRegularIndexHNSWSQNode : public BaseFaissRegularIndexHNSWNode {
                 hnsw_index =
                     std::make_unique<faiss::IndexHNSWSQ>(dim, sq_type.value(), hnsw_cfg.M.value(), metric.value());
             }
+            RETURN_IF_ERROR(rotate_hnsw_storage(hnsw_index.get(), sq_rotation));
 
             hnsw_index->hnsw.efConstruction = hnsw_cfg.efConstruction.value();
+            hnsw_index->add_batch_size = hnsw_cfg.add_batch_size.value();
 
             if (hnsw_cfg.refine.value_or(false) && hnsw_cfg.refine_type.has_value()) {
                 // yes
@@ -2166,13 +3774,14 @@ class BaseFaissRegularIndexHNSWSQNode : public BaseFaissRegularIndexHNSWNode {
         }
         // no scalar info or just one partition(after possible combination), build index on whole data
         if (scalar_info_map.empty() || tmp_combined_scalar_ids.size() <= 1) {
-            // we have to convert the data to float, unfortunately, which costs extra RAM
-            auto float_ds_ptr = convert_ds_to_float(dataset, data_format);
-            if (float_ds_ptr == nullptr) {
+            std::unique_ptr<float[]> train_buffer;
+            int64_t n_train_rows = 0;
+            auto train_data = convert_train_rows_to_float(dataset, data_format, train_buffer, n_train_rows);
+            if (train_data == nullptr) {
                 LOG_KNOWHERE_ERROR_ << "Unsupported data format";
                 return Status::invalid_args;
             }
-            return train_index(reinterpret_cast<const float*>(float_ds_ptr->GetTensor()), 0, rows);
+            return train_index(train_data, 0, n_train_rows);
         }
         LOG_KNOWHERE_INFO_ << "Train HNSWSQ Index with Scalar Info";
         for (const auto& [field_id, scalar_info] : scalar_info_map) {
@@ -2193,13 +3802,20 @@ class BaseFaissRegularIndexHNSWSQNodeTemplate : public BaseFaissRegularIndexHNSW
     StaticHasRawData(const knowhere::BaseConfig& config, const IndexVersion& version) {
         auto hnsw_sq_cfg = static_cast<const FaissHnswSqConfig&>(config);
 
+        // the vectors of a rotated storage can not be restored exactly
         auto sq_type = get_sq_quantizer_type(hnsw_sq_cfg.sq_type.value());
-        if (has_lossless_quant(sq_type, datatype_v<DataType>)) {
+        if (str_to_lower(hnsw_sq_cfg.sq_rotation.value_or("none")) == "none" &&
+            has_lossless_quant(sq_type, datatype_v<DataType>)) {
             return true;
         }
 
         return has_lossless_refine_index(hnsw_sq_cfg.refine, hnsw_sq_cfg.refine_type, datatype_v<DataType>);
     }
+
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return EstimateHnswLoadResource<DataType>(file_size, config);
+    }
 };
 
 // this index trains PQ and HNSW+FLAT separately, then constructs HNSW+PQ
@@ -2265,14 +3881,310 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
             }
 
             hnsw_index->hnsw.efConstruction = hnsw_cfg.efConstruction.value();
+            hnsw_index->add_batch_size = hnsw_cfg.add_batch_size.value();
+
+            // pq
+            std::unique_ptr<faiss::IndexPQ> pq_index;
+            if (is_cosine) {
+                pq_index = std::make_unique<faiss::IndexPQCosine>(dim, hnsw_cfg.m.value(), hnsw_cfg.nbits.value());
+            } else {
+                pq_index =
+                    std::make_unique<faiss::IndexPQ>(dim, hnsw_cfg.m.value(), hnsw_cfg.nbits.value(), metric.value());
+            }
+
+            // should refine be used?
+            std::unique_ptr<faiss::Index> final_index;
+            if (hnsw_cfg.refine.value_or(false) && hnsw_cfg.refine_type.has_value()) {
+                // yes
+                const auto hnsw_d = hnsw_index->storage->d;
+                const auto hnsw_metric_type = hnsw_index->storage->metric_type;
+                auto final_index_cnd = pick_refine_index(data_format, hnsw_cfg.refine_type, std::move(hnsw_index),
+                                                         hnsw_d, hnsw_metric_type);
+                if (!final_index_cnd.has_value()) {
+                    return Status::invalid_args;
+                }
+
+                // assign
+                final_index = std::move(final_index_cnd.value());
+            } else {
+                // no refine
+
+                // assign
+                final_index = std::move(hnsw_index);
+            }
+
+            // train hnswflat
+            LOG_KNOWHERE_INFO_ << "Training HNSW Index";
+
+            final_index->train(rows, data);
+
+            // train pq
+            LOG_KNOWHERE_INFO_ << "Training PQ Index";
+
+            pq_index->train(rows, data);
+            pq_index->pq.compute_sdc_table();
+
+            // done
+            indexes[i] = std::move(final_index);
+            tmp_index_pq[i] = std::move(pq_index);
+            return Status::success;
+        };
+
+        const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info_map =
+            dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO);
+        if (scalar_info_map.size() > 1) {
+            LOG_KNOWHERE_WARNING_ << "vector index build with multiple scalar info is not supported";
+            return Status::invalid_args;
+        }
+        for (const auto& [field_id, scalar_info] : scalar_info_map) {
+            tmp_combined_scalar_ids = scalar_info.size() > 1
+                                          ? combine_partitions(scalar_info, (1 << hnsw_cfg.nbits.value()))
+                                          : std::vector<std::vector<int>>();
+        }
+
+        // no scalar info or just one partition(after possible combination), build index on whole data
+        if (scalar_info_map.empty() || tmp_combined_scalar_ids.size() <= 1) {
+            tmp_index_pq.resize(1);
+            std::unique_ptr<float[]> train_buffer;
+            int64_t n_train_rows = 0;
+            auto train_data = convert_train_rows_to_float(dataset, data_format, train_buffer, n_train_rows);
+            if (train_data == nullptr) {
+                LOG_KNOWHERE_ERROR_ << "Unsupported data format";
+                return Status::invalid_args;
+            }
+            return train_index(train_data, 0, n_train_rows);
+        }
+
+        LOG_KNOWHERE_INFO_ << "Train HNSWPQ Index with Scalar Info";
+        tmp_index_pq.resize(tmp_combined_scalar_ids.size());
+        for (const auto& [field_id, scalar_info] : scalar_info_map) {
+            return TrainIndexByScalarInfo(train_index, scalar_info, data, rows, dim);
+        }
+        return Status::success;
+    }
+
+    Status
+    AddInternal(const DataSetPtr dataset, const Config&) override {
+        if (isIndexEmpty()) {
+            LOG_KNOWHERE_ERROR_ << "Can not add data to an empty index.";
+            return Status::empty_index;
+        }
+
+        auto rows = dataset->GetRows();
+
+        // no graph repair runs in the middle of an add
+        auto graph_lock = LockGraphForModification();
+
+        auto finalize_index = [&](int i) {
+            // we're done.
+            // throw away flat and replace it with pq
+
+            // check if we have a refine available.
+            faiss::IndexHNSW* index_hnsw = nullptr;
+
+            faiss::IndexRefine* const index_refine = dynamic_cast<faiss::IndexRefine*>(indexes[i].get());
+
+            if (index_refine != nullptr) {
+                index_hnsw = dynamic_cast<faiss::IndexHNSW*>(index_refine->base_index);
+            } else {
+                index_hnsw = dynamic_cast<faiss::IndexHNSW*>(indexes[i].get());
+            }
+
+            // recreate hnswpq
+            std::unique_ptr<faiss::IndexHNSW> index_hnsw_pq;
+
+            if (index_hnsw->storage->is_cosine) {
+                index_hnsw_pq = std::make_unique<faiss::IndexHNSWPQCosine>();
+            } else {
+                index_hnsw_pq = std::make_unique<faiss::IndexHNSWPQ>();
+            }
+
+            // C++ slicing.
+            // we can't use move, because faiss::IndexHNSW overrides a destructor.
+            static_cast<faiss::IndexHNSW&>(*index_hnsw_pq) = static_cast<faiss::IndexHNSW&>(*index_hnsw);
+
+            // clear out the storage
+            delete index_hnsw->storage;
+            index_hnsw->storage = nullptr;
+            index_hnsw_pq->storage = nullptr;
+
+            // replace storage
+            index_hnsw_pq->storage = tmp_index_pq[i].release();
+
+            // replace if refine
+            if (index_refine != nullptr) {
+                delete index_refine->base_index;
+                index_refine->base_index = index_hnsw_pq.release();
+            } else {
+                indexes[i] = std::move(index_hnsw_pq);
+            }
+            return Status::success;
+        };
+        try {
+            const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info_map =
+                dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO);
+
+            if (scalar_info_map.empty() || tmp_combined_scalar_ids.size() <= 1) {
+                // hnsw
+                LOG_KNOWHERE_INFO_ << "Adding " << rows << " to HNSW Index";
+
+                const auto base_graph = dataset->Get<std::shared_ptr<const std::vector<uint32_t>>>(meta::BASE_GRAPH);
+                auto status_reg = (base_graph != nullptr)
+                                      ? add_with_base_graph(indexes[0].get(), dataset, data_format, *base_graph)
+                                      : add_to_index(indexes[0].get(), dataset, data_format);
+                if (status_reg != Status::success) {
+                    return status_reg;
+                }
+
+                // pq
+                LOG_KNOWHERE_INFO_ << "Adding " << rows << " to PQ Index";
+
+                auto status_pq = add_to_index(tmp_index_pq[0].get(), dataset, data_format);
+                if (status_pq != Status::success) {
+                    return status_pq;
+                }
+                return finalize_index(0);
+            }
+            if (scalar_info_map.size() > 1) {
+                LOG_KNOWHERE_WARNING_ << "vector index build with multiple scalar info is not supported";
+                return Status::invalid_args;
+            }
+            LOG_KNOWHERE_INFO_ << "Add data to Index with Scalar Info";
+
+            for (const auto& [field_id, scalar_info] : scalar_info_map) {
+                for (auto i = 0; i < tmp_combined_scalar_ids.size(); ++i) {
+                    for (auto j = 0; j < tmp_combined_scalar_ids[i].size(); ++j) {
+                        auto id = tmp_combined_scalar_ids[i][j];
+                        // hnsw
+                        LOG_KNOWHERE_INFO_ << "Adding " << scalar_info[id].size() << " to HNSW Index";
+
+                        auto status_reg =
+                            add_partial_dataset_to_index(indexes[i].get(), dataset, data_format, scalar_info[id]);
+                        if (status_reg != Status::success) {
+                            return status_reg;
+                        }
+
+                        // pq
+                        LOG_KNOWHERE_INFO_ << "Adding " << scalar_info[id].size() << " to PQ Index";
+
+                        auto status_pq =
+                            add_partial_dataset_to_index(tmp_index_pq[i].get(), dataset, data_format, scalar_info[id]);
+
+                        if (status_pq != Status::success) {
+                            return status_pq;
+                        }
+                    }
+                    finalize_index(i);
+                }
+            }
+
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Status::faiss_inner_error;
+        }
+
+        return Status::success;
+    }
+};
+
+template <typename DataType>
+class BaseFaissRegularIndexHNSWPQNodeTemplate : public BaseFaissRegularIndexHNSWPQNode {
+ public:
+    BaseFaissRegularIndexHNSWPQNodeTemplate(const int32_t& version, const Object& object)
+        : BaseFaissRegularIndexHNSWPQNode(version, object, datatype_v<DataType>) {
+    }
+
+    static bool
+    StaticHasRawData(const knowhere::BaseConfig& config, const IndexVersion& version) {
+        auto hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
+        return has_lossless_refine_index(hnsw_cfg.refine, hnsw_cfg.refine_type, datatype_v<DataType>);
+    }
+
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return EstimateHnswLoadResource<DataType>(file_size, config);
+    }
+};
+
+// this index trains PRQ and HNSW+FLAT separately, then constructs HNSW+PRQ
+class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
+ public:
+    BaseFaissRegularIndexHNSWPRQNode(const int32_t& version, const Object& object, DataFormatEnum data_format)
+        : BaseFaissRegularIndexHNSWNode(version, object, data_format) {
+    }
+
+    static std::unique_ptr<BaseConfig>
+    StaticCreateConfig() {
+        return std::make_unique<FaissHnswPrqConfig>();
+    }
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return StaticCreateConfig();
+    }
+
+    std::string
+    Type() const override {
+        return knowhere::IndexEnum::INDEX_HNSW_PRQ;
+    }
+
+ protected:
+    std::vector<std::unique_ptr<faiss::IndexProductResidualQuantizer>> tmp_index_prq;
+
+    Status
+    TrainInternal(const DataSetPtr dataset, const Config& cfg) override {
+        // number of rows
+        auto rows = dataset->GetRows();
+        // dimensionality of the data
+        auto dim = dataset->GetDim();
+        // data
+        const void* data = dataset->GetTensor();
+
+        // config
+        auto hnsw_cfg = static_cast<const FaissHnswPrqConfig&>(cfg);
+
+        if (rows < (1 << hnsw_cfg.nbits.value())) {
+            LOG_KNOWHERE_ERROR_ << rows << " rows not enough, needs at least " << (1 << hnsw_cfg.nbits.value())
+                                << " rows";
+            return Status::faiss_inner_error;
+        }
+
+        auto metric = Str2FaissMetricType(hnsw_cfg.metric_type.value());
+        if (!metric.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "Invalid metric type: " << hnsw_cfg.metric_type.value();
+            return Status::invalid_metric_type;
+        }
+
+        // create an index
+        const bool is_cosine = IsMetricType(hnsw_cfg.metric_type.value(), metric::COSINE);
+
+        // HNSW + PRQ index yields BAD recall somewhy.
+        // Let's build HNSW+FLAT index, then replace FLAT with PRQ
+        auto train_index = [&](const float* data, const int i, const int64_t rows) {
+            std::unique_ptr<faiss::IndexHNSW> hnsw_index;
+            if (is_cosine) {
+                hnsw_index = std::make_unique<faiss::IndexHNSWFlatCosine>(dim, hnsw_cfg.M.value());
+            } else {
+                hnsw_index = std::make_unique<faiss::IndexHNSWFlat>(dim, hnsw_cfg.M.value(), metric.value());
+            }
+
+            hnsw_index->hnsw.efConstruction = hnsw_cfg.efConstruction.value();
+            hnsw_index->add_batch_size = hnsw_cfg.add_batch_size.value();
 
-            // pq
-            std::unique_ptr<faiss::IndexPQ> pq_index;
+            // prq
+            faiss::AdditiveQuantizer::Search_type_t prq_search_type =
+                (metric.value() == faiss::MetricType::METRIC_INNER_PRODUCT)
+                    ? faiss::AdditiveQuantizer::Search_type_t::ST_LUT_nonorm
+                    : faiss::AdditiveQuantizer::Search_type_t::ST_norm_float;
+
+            std::unique_ptr<faiss::IndexProductResidualQuantizer> prq_index;
             if (is_cosine) {
-                pq_index = std::make_unique<faiss::IndexPQCosine>(dim, hnsw_cfg.m.value(), hnsw_cfg.nbits.value());
+                prq_index = std::make_unique<faiss::IndexProductResidualQuantizerCosine>(
+                    dim, hnsw_cfg.m.value(), hnsw_cfg.nrq.value(), hnsw_cfg.nbits.value(), prq_search_type);
             } else {
-                pq_index =
-                    std::make_unique<faiss::IndexPQ>(dim, hnsw_cfg.m.value(), hnsw_cfg.nbits.value(), metric.value());
+                prq_index = std::make_unique<faiss::IndexProductResidualQuantizer>(
+                    dim, hnsw_cfg.m.value(), hnsw_cfg.nrq.value(), hnsw_cfg.nbits.value(), metric.value(),
+                    prq_search_type);
             }
 
             // should refine be used?
@@ -2301,18 +4213,17 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
 
             final_index->train(rows, data);
 
-            // train pq
-            LOG_KNOWHERE_INFO_ << "Training PQ Index";
+            // train prq
+            LOG_KNOWHERE_INFO_ << "Training ProductResidualQuantizer Index";
 
-            pq_index->train(rows, data);
-            pq_index->pq.compute_sdc_table();
+            prq_index->train(rows, data);
 
             // done
             indexes[i] = std::move(final_index);
-            tmp_index_pq[i] = std::move(pq_index);
+            tmp_index_prq[i] = std::move(prq_index);
+
             return Status::success;
         };
-
         const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info_map =
             dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO);
         if (scalar_info_map.size() > 1) {
@@ -2327,18 +4238,19 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
 
         // no scalar info or just one partition(after possible combination), build index on whole data
         if (scalar_info_map.empty() || tmp_combined_scalar_ids.size() <= 1) {
-            tmp_index_pq.resize(1);
-            // we have to convert the data to float, unfortunately, which costs extra RAM
-            auto float_ds_ptr = convert_ds_to_float(dataset, data_format);
-            if (float_ds_ptr == nullptr) {
+            tmp_index_prq.resize(1);
+            std::unique_ptr<float[]> train_buffer;
+            int64_t n_train_rows = 0;
+            auto train_data = convert_train_rows_to_float(dataset, data_format, train_buffer, n_train_rows);
+            if (train_data == nullptr) {
                 LOG_KNOWHERE_ERROR_ << "Unsupported data format";
                 return Status::invalid_args;
             }
-            return train_index((const float*)(float_ds_ptr->GetTensor()), 0, rows);
+            return train_index(train_data, 0, n_train_rows);
         }
 
-        LOG_KNOWHERE_INFO_ << "Train HNSWPQ Index with Scalar Info";
-        tmp_index_pq.resize(tmp_combined_scalar_ids.size());
+        LOG_KNOWHERE_INFO_ << "Train HNSWPRQ Index with Scalar Info";
+        tmp_index_prq.resize(tmp_combined_scalar_ids.size());
         for (const auto& [field_id, scalar_info] : scalar_info_map) {
             return TrainIndexByScalarInfo(train_index, scalar_info, data, rows, dim);
         }
@@ -2354,9 +4266,12 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
 
         auto rows = dataset->GetRows();
 
+        // no graph repair runs in the middle of an add
+        auto graph_lock = LockGraphForModification();
+
         auto finalize_index = [&](int i) {
             // we're done.
-            // throw away flat and replace it with pq
+            // throw away flat and replace it with prq
 
             // check if we have a refine available.
             faiss::IndexHNSW* index_hnsw = nullptr;
@@ -2369,33 +4284,33 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
                 index_hnsw = dynamic_cast<faiss::IndexHNSW*>(indexes[i].get());
             }
 
-            // recreate hnswpq
-            std::unique_ptr<faiss::IndexHNSW> index_hnsw_pq;
+            // recreate hnswprq
+            std::unique_ptr<faiss::IndexHNSW> index_hnsw_prq;
 
             if (index_hnsw->storage->is_cosine) {
-                index_hnsw_pq = std::make_unique<faiss::IndexHNSWPQCosine>();
+                index_hnsw_prq = std::make_unique<faiss::IndexHNSWProductResidualQuantizerCosine>();
             } else {
-                index_hnsw_pq = std::make_unique<faiss::IndexHNSWPQ>();
+                index_hnsw_prq = std::make_unique<faiss::IndexHNSWProductResidualQuantizer>();
             }
 
-            // C++ slicing.
+            // C++ slicing
             // we can't use move, because faiss::IndexHNSW overrides a destructor.
-            static_cast<faiss::IndexHNSW&>(*index_hnsw_pq) = static_cast<faiss::IndexHNSW&>(*index_hnsw);
+            static_cast<faiss::IndexHNSW&>(*index_hnsw_prq) = static_cast<faiss::IndexHNSW&>(*index_hnsw);
 
             // clear out the storage
             delete index_hnsw->storage;
             index_hnsw->storage = nullptr;
-            index_hnsw_pq->storage = nullptr;
+            index_hnsw_prq->storage = nullptr;
 
             // replace storage
-            index_hnsw_pq->storage = tmp_index_pq[i].release();
+            index_hnsw_prq->storage = tmp_index_prq[i].release();
 
             // replace if refine
             if (index_refine != nullptr) {
                 delete index_refine->base_index;
-                index_refine->base_index = index_hnsw_pq.release();
+                index_refine->base_index = index_hnsw_prq.release();
             } else {
-                indexes[i] = std::move(index_hnsw_pq);
+                indexes[i] = std::move(index_hnsw_prq);
             }
             return Status::success;
         };
@@ -2412,15 +4327,16 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
                     return status_reg;
                 }
 
-                // pq
-                LOG_KNOWHERE_INFO_ << "Adding " << rows << " to PQ Index";
+                // prq
+                LOG_KNOWHERE_INFO_ << "Adding " << rows << " to ProductResidualQuantizer Index";
 
-                auto status_pq = add_to_index(tmp_index_pq[0].get(), dataset, data_format);
-                if (status_pq != Status::success) {
-                    return status_pq;
+                auto status_prq = add_to_index(tmp_index_prq[0].get(), dataset, data_format);
+                if (status_prq != Status::success) {
+                    return status_prq;
                 }
                 return finalize_index(0);
             }
+
             if (scalar_info_map.size() > 1) {
                 LOG_KNOWHERE_WARNING_ << "vector index build with multiple scalar info is not supported";
                 return Status::invalid_args;
@@ -2440,14 +4356,14 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
                             return status_reg;
                         }
 
-                        // pq
+                        // prq
                         LOG_KNOWHERE_INFO_ << "Adding " << scalar_info[id].size() << " to PQ Index";
 
-                        auto status_pq =
-                            add_partial_dataset_to_index(tmp_index_pq[i].get(), dataset, data_format, scalar_info[id]);
+                        auto status_prq =
+                            add_partial_dataset_to_index(tmp_index_prq[i].get(), dataset, data_format, scalar_info[id]);
 
-                        if (status_pq != Status::success) {
-                            return status_pq;
+                        if (status_prq != Status::success) {
+                            return status_prq;
                         }
                     }
                     finalize_index(i);
@@ -2464,10 +4380,10 @@ class BaseFaissRegularIndexHNSWPQNode : public BaseFaissRegularIndexHNSWNode {
 };
 
 template <typename DataType>
-class BaseFaissRegularIndexHNSWPQNodeTemplate : public BaseFaissRegularIndexHNSWPQNode {
+class BaseFaissRegularIndexHNSWPRQNodeTemplate : public BaseFaissRegularIndexHNSWPRQNode {
  public:
-    BaseFaissRegularIndexHNSWPQNodeTemplate(const int32_t& version, const Object& object)
-        : BaseFaissRegularIndexHNSWPQNode(version, object, datatype_v<DataType>) {
+    BaseFaissRegularIndexHNSWPRQNodeTemplate(const int32_t& version, const Object& object)
+        : BaseFaissRegularIndexHNSWPRQNode(version, object, datatype_v<DataType>) {
     }
 
     static bool
@@ -2475,18 +4391,23 @@ class BaseFaissRegularIndexHNSWPQNodeTemplate : public BaseFaissRegularIndexHNSW
         auto hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
         return has_lossless_refine_index(hnsw_cfg.refine, hnsw_cfg.refine_type, datatype_v<DataType>);
     }
+
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return EstimateHnswLoadResource<DataType>(file_size, config);
+    }
 };
 
-// this index trains PRQ and HNSW+FLAT separately, then constructs HNSW+PRQ
-class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
+// this index trains RaBitQ and HNSW+FLAT separately, then constructs HNSW+RaBitQ
+class BaseFaissRegularIndexHNSWRaBitQNode : public BaseFaissRegularIndexHNSWNode {
  public:
-    BaseFaissRegularIndexHNSWPRQNode(const int32_t& version, const Object& object, DataFormatEnum data_format)
+    BaseFaissRegularIndexHNSWRaBitQNode(const int32_t& version, const Object& object, DataFormatEnum data_format)
         : BaseFaissRegularIndexHNSWNode(version, object, data_format) {
     }
 
     static std::unique_ptr<BaseConfig>
     StaticCreateConfig() {
-        return std::make_unique<FaissHnswPrqConfig>();
+        return std::make_unique<FaissHnswRaBitQConfig>();
     }
 
     std::unique_ptr<BaseConfig>
@@ -2496,11 +4417,16 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
 
     std::string
     Type() const override {
-        return knowhere::IndexEnum::INDEX_HNSW_PRQ;
+        return knowhere::IndexEnum::INDEX_HNSW_RABITQ;
     }
 
  protected:
-    std::vector<std::unique_ptr<faiss::IndexProductResidualQuantizer>> tmp_index_prq;
+    std::vector<std::unique_ptr<faiss::IndexRaBitQ>> tmp_index_rabitq;
+
+    int
+    GetQueryQuantizationBits(const Config& cfg) const override {
+        return static_cast<const FaissHnswRaBitQConfig&>(cfg).rbq_bits_query.value_or(0);
+    }
 
     Status
     TrainInternal(const DataSetPtr dataset, const Config& cfg) override {
@@ -2512,13 +4438,7 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
         const void* data = dataset->GetTensor();
 
         // config
-        auto hnsw_cfg = static_cast<const FaissHnswPrqConfig&>(cfg);
-
-        if (rows < (1 << hnsw_cfg.nbits.value())) {
-            LOG_KNOWHERE_ERROR_ << rows << " rows not enough, needs at least " << (1 << hnsw_cfg.nbits.value())
-                                << " rows";
-            return Status::faiss_inner_error;
-        }
+        auto hnsw_cfg = static_cast<const FaissHnswRaBitQConfig&>(cfg);
 
         auto metric = Str2FaissMetricType(hnsw_cfg.metric_type.value());
         if (!metric.has_value()) {
@@ -2529,8 +4449,8 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
         // create an index
         const bool is_cosine = IsMetricType(hnsw_cfg.metric_type.value(), metric::COSINE);
 
-        // HNSW + PRQ index yields BAD recall somewhy.
-        // Let's build HNSW+FLAT index, then replace FLAT with PRQ
+        // RaBitQ does not provide the distance between two codes that is accurate enough
+        //   for the graph construction. Let's build HNSW+FLAT index, then replace FLAT with RaBitQ
         auto train_index = [&](const float* data, const int i, const int64_t rows) {
             std::unique_ptr<faiss::IndexHNSW> hnsw_index;
             if (is_cosine) {
@@ -2540,21 +4460,14 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
             }
 
             hnsw_index->hnsw.efConstruction = hnsw_cfg.efConstruction.value();
+            hnsw_index->add_batch_size = hnsw_cfg.add_batch_size.value();
 
-            // prq
-            faiss::AdditiveQuantizer::Search_type_t prq_search_type =
-                (metric.value() == faiss::MetricType::METRIC_INNER_PRODUCT)
-                    ? faiss::AdditiveQuantizer::Search_type_t::ST_LUT_nonorm
-                    : faiss::AdditiveQuantizer::Search_type_t::ST_norm_float;
-
-            std::unique_ptr<faiss::IndexProductResidualQuantizer> prq_index;
+            // rabitq
+            std::unique_ptr<faiss::IndexRaBitQ> rabitq_index;
             if (is_cosine) {
-                prq_index = std::make_unique<faiss::IndexProductResidualQuantizerCosine>(
-                    dim, hnsw_cfg.m.value(), hnsw_cfg.nrq.value(), hnsw_cfg.nbits.value(), prq_search_type);
+                rabitq_index = std::make_unique<faiss::IndexRaBitQCosine>(dim);
             } else {
-                prq_index = std::make_unique<faiss::IndexProductResidualQuantizer>(
-                    dim, hnsw_cfg.m.value(), hnsw_cfg.nrq.value(), hnsw_cfg.nbits.value(), metric.value(),
-                    prq_search_type);
+                rabitq_index = std::make_unique<faiss::IndexRaBitQ>(dim, metric.value());
             }
 
             // should refine be used?
@@ -2583,17 +4496,17 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
 
             final_index->train(rows, data);
 
-            // train prq
-            LOG_KNOWHERE_INFO_ << "Training ProductResidualQuantizer Index";
+            // train rabitq
+            LOG_KNOWHERE_INFO_ << "Training RaBitQ Index";
 
-            prq_index->train(rows, data);
+            rabitq_index->train(rows, data);
 
             // done
             indexes[i] = std::move(final_index);
-            tmp_index_prq[i] = std::move(prq_index);
-
+            tmp_index_rabitq[i] = std::move(rabitq_index);
             return Status::success;
         };
+
         const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info_map =
             dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO);
         if (scalar_info_map.size() > 1) {
@@ -2601,26 +4514,25 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
             return Status::invalid_args;
         }
         for (const auto& [field_id, scalar_info] : scalar_info_map) {
-            tmp_combined_scalar_ids = scalar_info.size() > 1
-                                          ? combine_partitions(scalar_info, (1 << hnsw_cfg.nbits.value()))
-                                          : std::vector<std::vector<int>>();
+            tmp_combined_scalar_ids =
+                scalar_info.size() > 1 ? combine_partitions(scalar_info, 128) : std::vector<std::vector<int>>();
         }
 
         // no scalar info or just one partition(after possible combination), build index on whole data
         if (scalar_info_map.empty() || tmp_combined_scalar_ids.size() <= 1) {
-            tmp_index_prq.resize(1);
-            // we have to convert the data to float, unfortunately, which costs extra RAM
-            auto float_ds_ptr = convert_ds_to_float(dataset, data_format);
-
-            if (float_ds_ptr == nullptr) {
+            tmp_index_rabitq.resize(1);
+            std::unique_ptr<float[]> train_buffer;
+            int64_t n_train_rows = 0;
+            auto train_data = convert_train_rows_to_float(dataset, data_format, train_buffer, n_train_rows);
+            if (train_data == nullptr) {
                 LOG_KNOWHERE_ERROR_ << "Unsupported data format";
                 return Status::invalid_args;
             }
-            return train_index((const float*)(float_ds_ptr->GetTensor()), 0, rows);
+            return train_index(train_data, 0, n_train_rows);
         }
 
-        LOG_KNOWHERE_INFO_ << "Train HNSWPRQ Index with Scalar Info";
-        tmp_index_prq.resize(tmp_combined_scalar_ids.size());
+        LOG_KNOWHERE_INFO_ << "Train HNSWRaBitQ Index with Scalar Info";
+        tmp_index_rabitq.resize(tmp_combined_scalar_ids.size());
         for (const auto& [field_id, scalar_info] : scalar_info_map) {
             return TrainIndexByScalarInfo(train_index, scalar_info, data, rows, dim);
         }
@@ -2636,9 +4548,12 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
 
         auto rows = dataset->GetRows();
 
+        // no graph repair runs in the middle of an add
+        auto graph_lock = LockGraphForModification();
+
         auto finalize_index = [&](int i) {
             // we're done.
-            // throw away flat and replace it with prq
+            // throw away flat and replace it with rabitq
 
             // check if we have a refine available.
             faiss::IndexHNSW* index_hnsw = nullptr;
@@ -2651,33 +4566,33 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
                 index_hnsw = dynamic_cast<faiss::IndexHNSW*>(indexes[i].get());
             }
 
-            // recreate hnswprq
-            std::unique_ptr<faiss::IndexHNSW> index_hnsw_prq;
+            // recreate hnswrabitq
+            std::unique_ptr<faiss::IndexHNSW> index_hnsw_rabitq;
 
             if (index_hnsw->storage->is_cosine) {
-                index_hnsw_prq = std::make_unique<faiss::IndexHNSWProductResidualQuantizerCosine>();
+                index_hnsw_rabitq = std::make_unique<faiss::IndexHNSWRaBitQCosine>();
             } else {
-                index_hnsw_prq = std::make_unique<faiss::IndexHNSWProductResidualQuantizer>();
+                index_hnsw_rabitq = std::make_unique<faiss::IndexHNSWRaBitQ>();
             }
 
-            // C++ slicing
+            // C++ slicing.
             // we can't use move, because faiss::IndexHNSW overrides a destructor.
-            static_cast<faiss::IndexHNSW&>(*index_hnsw_prq) = static_cast<faiss::IndexHNSW&>(*index_hnsw);
+            static_cast<faiss::IndexHNSW&>(*index_hnsw_rabitq) = static_cast<faiss::IndexHNSW&>(*index_hnsw);
 
             // clear out the storage
             delete index_hnsw->storage;
             index_hnsw->storage = nullptr;
-            index_hnsw_prq->storage = nullptr;
+            index_hnsw_rabitq->storage = nullptr;
 
             // replace storage
-            index_hnsw_prq->storage = tmp_index_prq[i].release();
+            index_hnsw_rabitq->storage = tmp_index_rabitq[i].release();
 
             // replace if refine
             if (index_refine != nullptr) {
                 delete index_refine->base_index;
-                index_refine->base_index = index_hnsw_prq.release();
+                index_refine->base_index = index_hnsw_rabitq.release();
             } else {
-                indexes[i] = std::move(index_hnsw_prq);
+                indexes[i] = std::move(index_hnsw_rabitq);
             }
             return Status::success;
         };
@@ -2694,16 +4609,15 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
                     return status_reg;
                 }
 
-                // prq
-                LOG_KNOWHERE_INFO_ << "Adding " << rows << " to ProductResidualQuantizer Index";
+                // rabitq
+                LOG_KNOWHERE_INFO_ << "Adding " << rows << " to RaBitQ Index";
 
-                auto status_prq = add_to_index(tmp_index_prq[0].get(), dataset, data_format);
-                if (status_prq != Status::success) {
-                    return status_prq;
+                auto status_rabitq = add_to_index(tmp_index_rabitq[0].get(), dataset, data_format);
+                if (status_rabitq != Status::success) {
+                    return status_rabitq;
                 }
                 return finalize_index(0);
             }
-
             if (scalar_info_map.size() > 1) {
                 LOG_KNOWHERE_WARNING_ << "vector index build with multiple scalar info is not supported";
                 return Status::invalid_args;
@@ -2723,14 +4637,13 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
                             return status_reg;
                         }
 
-                        // prq
-                        LOG_KNOWHERE_INFO_ << "Adding " << scalar_info[id].size() << " to PQ Index";
-
-                        auto status_prq =
-                            add_partial_dataset_to_index(tmp_index_prq[i].get(), dataset, data_format, scalar_info[id]);
+                        // rabitq
+                        LOG_KNOWHERE_INFO_ << "Adding " << scalar_info[id].size() << " to RaBitQ Index";
 
-                        if (status_prq != Status::success) {
-                            return status_prq;
+                        auto status_rabitq = add_partial_dataset_to_index(tmp_index_rabitq[i].get(), dataset,
+                                                                          data_format, scalar_info[id]);
+                        if (status_rabitq != Status::success) {
+                            return status_rabitq;
                         }
                     }
                     finalize_index(i);
@@ -2747,10 +4660,10 @@ class BaseFaissRegularIndexHNSWPRQNode : public BaseFaissRegularIndexHNSWNode {
 };
 
 template <typename DataType>
-class BaseFaissRegularIndexHNSWPRQNodeTemplate : public BaseFaissRegularIndexHNSWPRQNode {
+class BaseFaissRegularIndexHNSWRaBitQNodeTemplate : public BaseFaissRegularIndexHNSWRaBitQNode {
  public:
-    BaseFaissRegularIndexHNSWPRQNodeTemplate(const int32_t& version, const Object& object)
-        : BaseFaissRegularIndexHNSWPRQNode(version, object, datatype_v<DataType>) {
+    BaseFaissRegularIndexHNSWRaBitQNodeTemplate(const int32_t& version, const Object& object)
+        : BaseFaissRegularIndexHNSWRaBitQNode(version, object, datatype_v<DataType>) {
     }
 
     static bool
@@ -2758,8 +4671,228 @@ class BaseFaissRegularIndexHNSWPRQNodeTemplate : public BaseFaissRegularIndexHNS
         auto hnsw_cfg = static_cast<const FaissHnswConfig&>(config);
         return has_lossless_refine_index(hnsw_cfg.refine, hnsw_cfg.refine_type, datatype_v<DataType>);
     }
+
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        return EstimateHnswLoadResource<DataType>(file_size, config);
+    }
+};
+
+// an HNSW index of the node HnswNodeTemplate whose only layer is a graph built by GraphBuilder over the rows before
+//   they are added. The storage, the refine, the search and the mmap are the ones of the HNSW index.
+// A GraphBuilder has the config template Config<HnswConfig>, the index type Type() of an HNSW index type, and
+//   Build<HnswConfig>(), which returns the entry point of the graph it writes in the layout of meta::BASE_GRAPH.
+template <typename DataType, template <typename> class HnswNodeTemplate, typename HnswConfig, typename GraphBuilder>
+class FaissBaseGraphIndexNode : public HnswNodeTemplate<DataType> {
+    using HnswNode = HnswNodeTemplate<DataType>;
+    using GraphConfig = typename GraphBuilder::template Config<HnswConfig>;
+
+ public:
+    FaissBaseGraphIndexNode(const int32_t& version, const Object& object) : HnswNode(version, object) {
+    }
+
+    static std::unique_ptr<BaseConfig>
+    StaticCreateConfig() {
+        return std::make_unique<GraphConfig>();
+    }
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return StaticCreateConfig();
+    }
+
+    std::string
+    Type() const override {
+        return GraphBuilder::Type(HnswNode::Type());
+    }
+
+    // the graph is built from all the rows at once
+    bool
+    IsIncrementalAddSupported() const override {
+        return false;
+    }
+
+    Status
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
+        if (!dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO)
+                 .empty()) {
+            LOG_KNOWHERE_ERROR_ << "a " << Type() << " index can not be built with scalar info";
+            return Status::invalid_args;
+        }
+        if constexpr (GraphBuilder::kBuildOutsideBuildPool) {
+            auto base = BuildGraph(dataset, *cfg);
+            if (!base.has_value()) {
+                return base.error();
+            }
+            return HnswNode::Add(base.value(), std::move(cfg), use_knowhere_build_pool);
+        }
+        return HnswNode::Add(dataset, std::move(cfg), use_knowhere_build_pool);
+    }
+
+ protected:
+    Status
+    AddInternal(const DataSetPtr dataset, const Config& cfg) override {
+        auto base = dataset;
+        if (dataset->Get<std::shared_ptr<const std::vector<uint32_t>>>(meta::BASE_GRAPH) == nullptr) {
+            auto with_graph = BuildGraph(dataset, cfg);
+            if (!with_graph.has_value()) {
+                return with_graph.error();
+            }
+            base = with_graph.value();
+        }
+        RETURN_IF_ERROR(HnswNode::AddInternal(base, cfg));
+
+        // the entry point of the builder instead of the middle row of a base graph
+        faiss::Index* index = this->indexes[0].get();
+        auto* index_refine = dynamic_cast<faiss::IndexRefine*>(index);
+        auto* index_hnsw = dynamic_cast<faiss::IndexHNSW*>(index_refine != nullptr ? index_refine->base_index : index);
+        if (index_hnsw != nullptr && graph_entry_point < index_hnsw->ntotal) {
+            index_hnsw->hnsw.entry_point = graph_entry_point;
+        }
+        return Status::success;
+    }
+
+ private:
+    int64_t graph_entry_point = 0;
+
+    // a view of the rows of a dataset with the graph built over them as its meta::BASE_GRAPH
+    expected<DataSetPtr>
+    BuildGraph(const DataSetPtr& dataset, const Config& cfg) {
+        auto graph = std::make_shared<std::vector<uint32_t>>();
+        TimeRecorder rc(Type() + " graph build");
+        auto entry_point = GraphBuilder::template Build<HnswConfig>(
+            dataset, this->data_format, static_cast<const GraphConfig&>(cfg), *graph);
+        if (!entry_point.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "failed to build the graph of a " << Type() << " index: " << entry_point.what();
+            return expected<DataSetPtr>::Err(entry_point.error(), entry_point.what());
+        }
+        rc.ElapseFromBegin("done");
+        graph_entry_point = entry_point.value();
+
+        auto base = GenDataSet(dataset->GetRows(), dataset->GetDim(), dataset->GetTensor());
+        base->Set(meta::BASE_GRAPH, std::shared_ptr<const std::vector<uint32_t>>(std::move(graph)));
+        return base;
+    }
+};
+
+#ifdef KNOWHERE_WITH_DISKANN
+// the Vamana graphs of DiskANN
+struct VamanaGraphBuilder {
+    template <typename HnswConfig>
+    using Config = FaissVamanaConfig<HnswConfig>;
+
+    // the builder of DiskANN waits for the tasks it pushes to the build pool
+    static constexpr bool kBuildOutsideBuildPool = true;
+
+    static std::string
+    Type(const std::string& hnsw_type) {
+        if (hnsw_type == IndexEnum::INDEX_HNSW_SQ) {
+            return IndexEnum::INDEX_VAMANA_SQ;
+        } else if (hnsw_type == IndexEnum::INDEX_HNSW_PQ) {
+            return IndexEnum::INDEX_VAMANA_PQ;
+        }
+        return IndexEnum::INDEX_VAMANA;
+    }
+
+    template <typename HnswConfig>
+    static expected<int64_t>
+    Build(const DataSetPtr& dataset, const DataFormatEnum data_format, const Config<HnswConfig>& cfg,
+          std::vector<uint32_t>& graph) {
+        try {
+            return build_vamana_graph(dataset, data_format, cfg.metric_type.value(), cfg.max_degree.value(),
+                                      cfg.search_list_size.value(), cfg.alpha.value(), graph);
+        } catch (const std::exception& e) {
+            return expected<int64_t>::Err(Status::diskann_inner_error, e.what());
+        }
+    }
+};
+
+template <typename DataType, template <typename> class HnswNodeTemplate, typename HnswConfig>
+using FaissVamanaIndexNode = FaissBaseGraphIndexNode<DataType, HnswNodeTemplate, HnswConfig, VamanaGraphBuilder>;
+
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(VAMANA, FaissVamanaIndexNode, knowhere::feature::MMAP,
+                                                BaseFaissRegularIndexHNSWFlatNodeTemplate, FaissHnswFlatConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(VAMANA, FaissVamanaIndexNode, knowhere::feature::MMAP,
+                                          BaseFaissRegularIndexHNSWFlatNodeTemplate, FaissHnswFlatConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(VAMANA_SQ, FaissVamanaIndexNode, knowhere::feature::MMAP,
+                                                BaseFaissRegularIndexHNSWSQNodeTemplate, FaissHnswSqConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(VAMANA_SQ, FaissVamanaIndexNode, knowhere::feature::MMAP,
+                                          BaseFaissRegularIndexHNSWSQNodeTemplate, FaissHnswSqConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(VAMANA_PQ, FaissVamanaIndexNode, knowhere::feature::MMAP,
+                                                BaseFaissRegularIndexHNSWPQNodeTemplate, FaissHnswPqConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(VAMANA_PQ, FaissVamanaIndexNode, knowhere::feature::MMAP,
+                                          BaseFaissRegularIndexHNSWPQNodeTemplate, FaissHnswPqConfig)
+#endif
+
+// the NN-Descent k-NN graphs, pruned by NSG, by the RNG rule or not at all
+struct NNDescentGraphBuilder {
+    template <typename HnswConfig>
+    using Config = FaissNNDescentConfig<HnswConfig>;
+
+    static constexpr bool kBuildOutsideBuildPool = false;
+
+    static std::string
+    Type(const std::string& hnsw_type) {
+        if (hnsw_type == IndexEnum::INDEX_HNSW_SQ) {
+            return IndexEnum::INDEX_NNDESCENT_SQ;
+        } else if (hnsw_type == IndexEnum::INDEX_HNSW_PQ) {
+            return IndexEnum::INDEX_NNDESCENT_PQ;
+        }
+        return IndexEnum::INDEX_NNDESCENT;
+    }
+
+    template <typename HnswConfig>
+    static expected<int64_t>
+    Build(const DataSetPtr& dataset, const DataFormatEnum data_format, const Config<HnswConfig>& cfg,
+          std::vector<uint32_t>& graph) {
+        auto pruning = parse_graph_pruning_type(cfg.graph_pruning.value());
+        if (!pruning.has_value()) {
+            return expected<int64_t>::Err(Status::invalid_args, "invalid graph pruning: " + cfg.graph_pruning.value());
+        }
+        auto float_ds_ptr = convert_ds_to_float(dataset, data_format);
+        if (float_ds_ptr == nullptr) {
+            return expected<int64_t>::Err(Status::invalid_args, "unsupported data format");
+        }
+        const auto rows = dataset->GetRows();
+        const auto dim = dataset->GetDim();
+        const float* data = reinterpret_cast<const float*>(float_ds_ptr->GetTensor());
+
+        // the cosine graph is the IP one of the normalized rows
+        auto metric = Str2FaissMetricType(cfg.metric_type.value());
+        if (!metric.has_value()) {
+            return expected<int64_t>::Err(Status::invalid_metric_type, "invalid metric type");
+        }
+        std::unique_ptr<float[]> normalized;
+        if (IsMetricType(cfg.metric_type.value(), metric::COSINE)) {
+            normalized = CopyAndNormalizeVecs(data, rows, dim);
+            data = normalized.get();
+        }
+
+        try {
+            return build_nndescent_graph(data, rows, dim, metric.value(), cfg.nndescent_k.value(),
+                                         cfg.nndescent_iter.value(), pruning.value(), cfg.max_degree.value(), graph);
+        } catch (const std::exception& e) {
+            return expected<int64_t>::Err(Status::faiss_inner_error, e.what());
+        }
+    }
 };
 
+template <typename DataType, template <typename> class HnswNodeTemplate, typename HnswConfig>
+using FaissNNDescentIndexNode = FaissBaseGraphIndexNode<DataType, HnswNodeTemplate, HnswConfig, NNDescentGraphBuilder>;
+
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(NNDESCENT, FaissNNDescentIndexNode, knowhere::feature::MMAP,
+                                                BaseFaissRegularIndexHNSWFlatNodeTemplate, FaissHnswFlatConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(NNDESCENT, FaissNNDescentIndexNode, knowhere::feature::MMAP,
+                                          BaseFaissRegularIndexHNSWFlatNodeTemplate, FaissHnswFlatConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(NNDESCENT_SQ, FaissNNDescentIndexNode, knowhere::feature::MMAP,
+                                                BaseFaissRegularIndexHNSWSQNodeTemplate, FaissHnswSqConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(NNDESCENT_SQ, FaissNNDescentIndexNode, knowhere::feature::MMAP,
+                                          BaseFaissRegularIndexHNSWSQNodeTemplate, FaissHnswSqConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(NNDESCENT_PQ, FaissNNDescentIndexNode, knowhere::feature::MMAP,
+                                                BaseFaissRegularIndexHNSWPQNodeTemplate, FaissHnswPqConfig)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(NNDESCENT_PQ, FaissNNDescentIndexNode, knowhere::feature::MMAP,
+                                          BaseFaissRegularIndexHNSWPQNodeTemplate, FaissHnswPqConfig)
+
 #ifdef KNOWHERE_WITH_CARDINAL
 KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(HNSW_DEPRECATED,
                                                 BaseFaissRegularIndexHNSWFlatNodeTemplateWithSearchFallback,
@@ -2783,5 +4916,34 @@ KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(HNSW_PRQ, BaseFaissRegularIndexH
                                                 knowhere::feature::MMAP | knowhere::feature::MV)
 KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(HNSW_PRQ, BaseFaissRegularIndexHNSWPRQNodeTemplate,
                                           knowhere::feature::MMAP | knowhere::feature::MV)
+KNOWHERE_SIMPLE_REGISTER_DENSE_FLOAT_ALL_GLOBAL(HNSW_RABITQ, BaseFaissRegularIndexHNSWRaBitQNodeTemplate,
+                                                knowhere::feature::MMAP | knowhere::feature::MV)
+KNOWHERE_SIMPLE_REGISTER_DENSE_INT_GLOBAL(HNSW_RABITQ, BaseFaissRegularIndexHNSWRaBitQNodeTemplate,
+                                          knowhere::feature::MMAP | knowhere::feature::MV)
+
+// a shard of an HNSW_SHARDED or HNSW_SQ_SHARDED index, the index of HnswNodeTemplate that parses num_shards
+template <typename DataType, template <typename> class HnswNodeTemplate, typename HnswConfig>
+class FaissHnswShardIndexNode : public HnswNodeTemplate<DataType> {
+ public:
+    FaissHnswShardIndexNode(const int32_t& version, const Object& object)
+        : HnswNodeTemplate<DataType>(version, object) {
+    }
+
+    static std::unique_ptr<BaseConfig>
+    StaticCreateConfig() {
+        return std::make_unique<FaissHnswShardedConfig<HnswConfig>>();
+    }
+
+    std::unique_ptr<BaseConfig>
+    CreateConfig() const override {
+        return StaticCreateConfig();
+    }
+};
+
+KNOWHERE_SHARDED_REGISTER_DENSE_FLOAT_ALL_GLOBAL(HNSW_SHARDED, FaissHnswShardIndexNode, knowhere::feature::NONE,
+                                                 BaseFaissRegularIndexHNSWFlatNodeTemplateWithSearchFallback,
+                                                 FaissHnswFlatConfig)
+KNOWHERE_SHARDED_REGISTER_DENSE_FLOAT_ALL_GLOBAL(HNSW_SQ_SHARDED, FaissHnswShardIndexNode, knowhere::feature::NONE,
+                                                 BaseFaissRegularIndexHNSWSQNodeTemplate, FaissHnswSqConfig)
 
 }  // namespace knowhere
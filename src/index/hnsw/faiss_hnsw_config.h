@@ -29,6 +29,36 @@ class FaissHnswConfig : public BaseHnswConfig {
     CFG_FLOAT refine_k;
     // type of refine
     CFG_STRING refine_type;
+    // the number of unvisited neighbors whose codes are prefetched ahead of
+    //   the distance evaluation. 0 disables the pipelined graph expansion.
+    CFG_INT prefetch_depth;
+    // the number of queries of a batch that traverse the graph together,
+    //   sharing the upper-level descent and interleaving level-0 expansions.
+    //   1 processes every query on its own.
+    CFG_INT query_batch_size;
+    // the ordering of graph nodes applied once the index is built,
+    //   one of [none, bfs, rcm]
+    CFG_STRING reorder_type;
+    // whether filtered out neighbors are expanded through their own
+    //   neighbors instead of being evaluated, for highly selective filters
+    CFG_BOOL two_hop_expansion;
+    // whether level-0 neighbor lists are kept in a compressed form after the load
+    CFG_BOOL compress_graph;
+    // whether the 4-bit PQ codes of the level-0 neighbors of every node are laid out for the fast-scan after the load
+    CFG_BOOL fast_scan_neighbors;
+    // the number of k-means centroids whose closest nodes are used as additional level-0 entry points
+    CFG_INT entry_point_seeds;
+    // the number of level-0 expansions in a row without improving the top-k results, after which the search stops
+    CFG_INT early_stop_patience;
+    // the minimal relative improvement of the k-th result for an expansion to count as an improvement
+    CFG_FLOAT early_stop_gap;
+    // whether rows can be added while the index is being searched
+    CFG_BOOL concurrent_insert;
+    // the maximal number of rows that are linked into the graph together during the build, searching the graph
+    //   without locks and merging their reverse links afterwards. 0 links the rows one at a time.
+    CFG_INT add_batch_size;
+    // whether the codes of a flat refine index are left in the file at the load and read for the final candidates only
+    CFG_BOOL refine_on_disk;
 
     KNOHWERE_DECLARE_CONFIG(FaissHnswConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(seed_ef)
@@ -51,6 +81,67 @@ class FaissHnswConfig : public BaseHnswConfig {
             .allow_empty_without_default()
             .for_train()
             .for_static();
+        KNOWHERE_CONFIG_DECLARE_FIELD(prefetch_depth)
+            .description("number of neighbors prefetched ahead during the graph expansion, 0 disables it")
+            .set_default(0)
+            .set_range(0, 64)
+            .for_search()
+            .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(query_batch_size)
+            .description("number of queries that traverse the graph together, 1 disables it")
+            .set_default(1)
+            .set_range(1, 256)
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(reorder_type)
+            .description("the ordering of graph nodes applied after the build")
+            .set_default("none")
+            .for_train()
+            .for_static();
+        KNOWHERE_CONFIG_DECLARE_FIELD(two_hop_expansion)
+            .description("whether filtered out nodes are expanded through their neighbors for selective filters")
+            .set_default(false)
+            .for_search()
+            .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(compress_graph)
+            .description("whether level-0 neighbor lists are delta-encoded in memory after the load")
+            .set_default(false)
+            .for_deserialize()
+            .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(fast_scan_neighbors)
+            .description("whether level-0 neighbors are scored with fast-scan 4-bit PQ codes, for HNSW_PQ with nbits 4")
+            .set_default(false)
+            .for_deserialize()
+            .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(early_stop_patience)
+            .description("stop the search after this many expansions that do not improve the top-k, 0 disables it")
+            .set_default(0)
+            .set_range(0, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(early_stop_gap)
+            .description("the minimal relative improvement of the k-th result that resets the early stop patience")
+            .set_default(0.0f)
+            .set_range(0.0f, 1.0f)
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(entry_point_seeds)
+            .description("the number of clusters used to pick additional level-0 entry points, 0 disables them")
+            .set_default(0)
+            .set_range(0, 1024)
+            .for_train()
+            .for_deserialize()
+            .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(concurrent_insert)
+            .description("whether rows are added to the graph while it is searched, for growing segments")
+            .set_default(false)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(add_batch_size)
+            .description("the maximal number of rows linked into the graph together, 0 links them one at a time")
+            .set_default(0)
+            .set_range(0, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(refine_on_disk)
+            .description("whether the refine reads the full precision vectors from the index file")
+            .set_default(false)
+            .for_deserialize_from_file();
     }
 
  protected:
@@ -97,12 +188,21 @@ class FaissHnswSqConfig : public FaissHnswConfig {
     // user can use quant_type to control quantizer type.
     // we have fp16, bf16, etc, so '8', '4' and '6' is insufficient
     CFG_STRING sq_type;
+    // the rotation applied to the vectors before they are quantized and to the queries, one of [none, random, opq].
+    //   A rotation spreads the variance over all the dimensions, so that fewer bits per dimension keep the recall.
+    //   A rotated index keeps no raw data, unless its refine does.
+    CFG_STRING sq_rotation;
     KNOHWERE_DECLARE_CONFIG(FaissHnswSqConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(sq_type)
             .set_default("SQ8")
             .description("scalar quantizer type")
             .for_train()
             .for_static();
+        KNOWHERE_CONFIG_DECLARE_FIELD(sq_rotation)
+            .set_default("none")
+            .description("the rotation applied before the scalar quantizer, one of [none, random, opq]")
+            .for_train()
+            .for_static();
     };
 
     Status
@@ -120,6 +220,11 @@ class FaissHnswSqConfig : public FaissHnswConfig {
                 std::string msg = "invalid scalar quantizer type";
                 return HandleError(err_msg, msg, Status::invalid_args);
             }
+            if (!WhetherAcceptableRotation(sq_rotation.value())) {
+                std::string msg = "invalid sq rotation : " + sq_rotation.value() +
+                                  ", optional types are [none, random, opq]";
+                return HandleError(err_msg, msg, Status::invalid_args);
+            }
 
             // check refine
             if (refine_type.has_value()) {
@@ -137,7 +242,7 @@ class FaissHnswSqConfig : public FaissHnswConfig {
     bool
     WhetherAcceptableQuantType(const std::string& sq_type) {
         // todo: add more
-        std::vector<std::string> allowed_list = {"sq6", "sq8", "fp16", "bf16"};
+        std::vector<std::string> allowed_list = {"sq4", "sq6", "sq8", "fp16", "bf16"};
         std::string sq_type_tolower = str_to_lower(sq_type);
 
         for (const auto& allowed : allowed_list) {
@@ -148,6 +253,20 @@ class FaissHnswSqConfig : public FaissHnswConfig {
 
         return false;
     }
+
+    bool
+    WhetherAcceptableRotation(const std::string& rotation) {
+        std::vector<std::string> allowed_list = {"none", "random", "opq"};
+        std::string rotation_tolower = str_to_lower(rotation);
+
+        for (const auto& allowed : allowed_list) {
+            if (rotation_tolower == allowed) {
+                return true;
+            }
+        }
+
+        return false;
+    }
 };
 
 class FaissHnswPqConfig : public FaissHnswConfig {
@@ -246,6 +365,178 @@ class FaissHnswPrqConfig : public FaissHnswConfig {
     }
 };
 
+class FaissHnswRaBitQConfig : public FaissHnswConfig {
+ public:
+    // the value `0` means that the query won't be quantized and will
+    //   be processed as is.
+    CFG_INT rbq_bits_query;
+    KNOHWERE_DECLARE_CONFIG(FaissHnswRaBitQConfig) {
+        // a quantized query lets the traversal use popcount-based distances
+        KNOWHERE_CONFIG_DECLARE_FIELD(rbq_bits_query)
+            .description("rbq_bits_query")
+            .set_default(8)
+            .set_range(0, 8)
+            .for_search()
+            .for_range_search();
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        // check the base class
+        const auto base_status = FaissHnswConfig::CheckAndAdjust(param_type, err_msg);
+        if (base_status != Status::success) {
+            return base_status;
+        }
+
+        if (param_type == PARAM_TYPE::TRAIN) {
+            // check refine
+            if (refine_type.has_value()) {
+                if (!WhetherAcceptableRefineType(refine_type.value())) {
+                    std::string msg = "invalid refine type : " + refine_type.value() +
+                                      ", optional types are [sq6, sq8, fp16, bf16, fp32, flat]";
+                    return HandleError(err_msg, msg, Status::invalid_args);
+                }
+            }
+        }
+        return Status::success;
+    }
+};
+
+// the config of a VAMANA index, the single layer graph built by the Vamana builder of DiskANN over the storage and
+//   the search of the HNSW index of HnswConfig
+template <typename HnswConfig>
+class FaissVamanaConfig : public HnswConfig {
+ public:
+    using HnswConfig::__DICT__;
+
+    // the maximal number of neighbors of a node, the level 0 of the HNSW index holds 2 * M of them
+    CFG_INT max_degree;
+    // the size of the candidate list of the searches of the build
+    CFG_INT search_list_size;
+    // the pruning of the last pass keeps a neighbor unless alpha times its distance to a kept neighbor is less than
+    //   its distance to the node. Larger values keep longer edges.
+    CFG_FLOAT alpha;
+    KNOHWERE_DECLARE_CONFIG(FaissVamanaConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(max_degree)
+            .description("the degree of the graph index.")
+            .set_default(64)
+            .set_range(2, 2048)
+            .for_train()
+            .for_static();
+        KNOWHERE_CONFIG_DECLARE_FIELD(search_list_size)
+            .description("the size of the search list during the index build.")
+            .set_default(100)
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(alpha)
+            .description("the pruning parameter of the graph build.")
+            .set_default(1.2f)
+            .set_range(1.0f, 2.0f)
+            .for_train();
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        const auto base_status = HnswConfig::CheckAndAdjust(param_type, err_msg);
+        if (base_status != Status::success) {
+            return base_status;
+        }
+
+        if (param_type == PARAM_TYPE::TRAIN) {
+            if (this->concurrent_insert.value_or(false)) {
+                std::string msg = "concurrent insert is not supported for a vamana index";
+                return this->HandleError(err_msg, msg, Status::invalid_args);
+            }
+            // the level 0 of the HNSW index is sized by M
+            this->M = (max_degree.value() + 1) / 2;
+        }
+        return Status::success;
+    }
+};
+
+// the config of an HNSW_SHARDED or HNSW_SQ_SHARDED index, whose rows are split into the num_shards indexes of
+//   HnswConfig
+template <typename HnswConfig>
+class FaissHnswShardedConfig : public HnswConfig {
+ public:
+    using HnswConfig::__DICT__;
+
+    CFG_INT num_shards;
+    KNOHWERE_DECLARE_CONFIG(FaissHnswShardedConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(num_shards)
+            .description("split the rows into this many shards, built and searched concurrently.")
+            .set_default(1)
+            .set_range(1, 64)
+            .for_train();
+    }
+};
+
+// the config of an NNDESCENT index, the NN-Descent k-NN graph of the rows, optionally pruned, over the storage and
+//   the search of the HNSW index of HnswConfig
+template <typename HnswConfig>
+class FaissNNDescentConfig : public HnswConfig {
+ public:
+    using HnswConfig::__DICT__;
+
+    // the number of neighbors of a row in the k-NN graph
+    CFG_INT nndescent_k;
+    // the number of NN-Descent iterations
+    CFG_INT nndescent_iter;
+    // the pruning of the k-NN graph, one of [none, nsg, rng]
+    CFG_STRING graph_pruning;
+    // the maximal number of neighbors of a node of a pruned graph
+    CFG_INT max_degree;
+    KNOHWERE_DECLARE_CONFIG(FaissNNDescentConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(nndescent_k)
+            .description("the number of neighbors of the k-NN graph.")
+            .set_default(64)
+            .set_range(2, 1024)
+            .for_train()
+            .for_static();
+        KNOWHERE_CONFIG_DECLARE_FIELD(nndescent_iter)
+            .description("the number of NN-Descent iterations.")
+            .set_default(10)
+            .set_range(1, 100)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(graph_pruning)
+            .description("the pruning of the k-NN graph, one of [none, nsg, rng].")
+            .set_default("rng")
+            .for_train()
+            .for_static();
+        KNOWHERE_CONFIG_DECLARE_FIELD(max_degree)
+            .description("the degree of a pruned graph.")
+            .set_default(32)
+            .set_range(2, 2048)
+            .for_train()
+            .for_static();
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        const auto base_status = HnswConfig::CheckAndAdjust(param_type, err_msg);
+        if (base_status != Status::success) {
+            return base_status;
+        }
+
+        if (param_type == PARAM_TYPE::TRAIN) {
+            if (this->concurrent_insert.value_or(false)) {
+                std::string msg = "concurrent insert is not supported for an nndescent index";
+                return this->HandleError(err_msg, msg, Status::invalid_args);
+            }
+            const std::string pruning = str_to_lower(graph_pruning.value());
+            if (pruning != "none" && pruning != "nsg" && pruning != "rng") {
+                std::string msg = "invalid graph pruning : " + graph_pruning.value() +
+                                  ", optional types are [none, nsg, rng]";
+                return this->HandleError(err_msg, msg, Status::invalid_args);
+            }
+            // the level 0 of the HNSW index is sized by M
+            const int64_t degree = (pruning == "none") ? nndescent_k.value() : max_degree.value();
+            this->M = (degree + 1) / 2;
+        }
+        return Status::success;
+    }
+};
+
 }  // namespace knowhere
 
 #endif /* FAISS_HNSW_CONFIG_H */
@@ -0,0 +1,132 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/HnswConcurrentAdd.h"
+
+#include <omp.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "faiss/impl/AuxIndexStructures.h"
+#include "faiss/impl/DistanceComputer.h"
+#include "faiss/impl/FaissAssert.h"
+#include "faiss/utils/random.h"
+
+namespace knowhere {
+
+namespace {
+
+using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+faiss::DistanceComputer*
+storage_distance_computer(const faiss::Index* storage) {
+    if (faiss::is_similarity_metric(storage->metric_type)) {
+        return new faiss::NegativeDistanceComputer(storage->get_distance_computer());
+    } else {
+        return storage->get_distance_computer();
+    }
+}
+
+// Links nodes [n0, n0 + n) into the graph, from the highest level to the
+//   lowest one, in the same order as faiss::IndexHNSW::add() does.
+// Neighbor lists and levels of the nodes must be allocated already.
+void
+link_new_nodes(faiss::IndexHNSW& index, const size_t n0, const size_t n, const float* x) {
+    faiss::HNSW& hnsw = index.hnsw;
+    const size_t ntotal = n0 + n;
+
+    std::vector<omp_lock_t> locks(ntotal);
+    for (size_t i = 0; i < ntotal; i++) {
+        omp_init_lock(&locks[i]);
+    }
+
+    // buckets of nodes of the same level
+    std::vector<std::vector<storage_idx_t>> order;
+    for (size_t i = 0; i < n; i++) {
+        const storage_idx_t pt_id = (storage_idx_t)(n0 + i);
+        const int pt_level = hnsw.levels[pt_id] - 1;
+        if (order.size() <= (size_t)pt_level) {
+            order.resize(pt_level + 1);
+        }
+        order[pt_level].push_back(pt_id);
+    }
+
+    faiss::RandomGenerator rng(789);
+    for (int pt_level = (int)order.size() - 1; pt_level >= 0; pt_level--) {
+        std::vector<storage_idx_t>& bucket = order[pt_level];
+
+        // random permutation to get rid of dataset order bias
+        for (size_t j = 0; j < bucket.size(); j++) {
+            std::swap(bucket[j], bucket[j + rng.rand_int(bucket.size() - j)]);
+        }
+
+#pragma omp parallel if (bucket.size() > 100)
+        {
+            faiss::VisitedTable vt(ntotal);
+            std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index.storage));
+
+#pragma omp for schedule(static)
+            for (size_t j = 0; j < bucket.size(); j++) {
+                const storage_idx_t pt_id = bucket[j];
+                dis->set_query(x + (pt_id - n0) * index.d);
+
+                hnsw.add_with_locks(*dis, pt_level, pt_id, locks, vt, index.keep_max_size_level0 && (pt_level == 0));
+            }
+        }
+    }
+
+    for (size_t i = 0; i < ntotal; i++) {
+        omp_destroy_lock(&locks[i]);
+    }
+}
+
+}  // namespace
+
+void
+add_to_hnsw_concurrently(faiss::IndexHNSW* index, const faiss::idx_t n, const float* x, ReaderBiasedRWLock& mutex,
+                         faiss::cppcontrib::knowhere::HnswGraphPublisher& publisher) {
+    FAISS_THROW_IF_NOT_MSG(index != nullptr && index->storage != nullptr,
+                           "an input index seems to be unrelated to HNSW");
+    FAISS_THROW_IF_NOT(index->is_trained);
+    FAISS_THROW_IF_NOT_MSG(index->ntotal + n <= std::numeric_limits<storage_idx_t>::max(), "too many vectors");
+    if (n == 0) {
+        return;
+    }
+
+    faiss::HNSW& hnsw = index->hnsw;
+    const faiss::idx_t n0 = index->ntotal;
+
+    // everything that may be reallocated grows while searches are blocked
+    {
+        std::unique_lock lock(mutex);
+
+        index->storage->add(n, x);
+        index->ntotal = index->storage->ntotal;
+
+        for (faiss::idx_t i = 0; i < n; i++) {
+            hnsw.levels.push_back(hnsw.random_level() + 1);
+        }
+        hnsw.prepare_level_tab(n, true);
+    }
+
+    // searches see the old nodes only, their neighbor lists may be rewritten
+    link_new_nodes(*index, n0, n, x);
+
+    publisher.publish(hnsw, index->ntotal);
+}
+
+}  // namespace knowhere
@@ -0,0 +1,33 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "faiss/IndexHNSW.h"
+#include "faiss/cppcontrib/knowhere/impl/HnswPublishedGraph.h"
+#include "knowhere/comp/rw_lock.h"
+
+namespace knowhere {
+
+// Appends n vectors to an IndexHNSW that is being searched at the same time.
+// * The storage and the per-node arrays of the graph grow while 'mutex' is
+//   held exclusively. Searches are expected to hold it shared.
+// * New nodes are linked without holding 'mutex', under per-node locks,
+//   just like faiss::IndexHNSW::add() does it.
+// * New nodes become visible to searches only once all of them are linked,
+//   by publishing the graph via 'publisher'.
+// Calls for the same index must not overlap.
+// Throws faiss::FaissException for unsupported indexes.
+void
+add_to_hnsw_concurrently(faiss::IndexHNSW* index, const faiss::idx_t n, const float* x, ReaderBiasedRWLock& mutex,
+                         faiss::cppcontrib::knowhere::HnswGraphPublisher& publisher);
+
+}  // namespace knowhere
@@ -0,0 +1,46 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/HnswFlatSearch.h"
+
+#include <typeinfo>
+
+#include "simd/hook.h"
+
+namespace knowhere {
+
+HnswFlatSearchFn
+hnsw_flat_search_for(const faiss::Index* storage) {
+#if defined(__x86_64__)
+    // subclasses such as IndexFlatCosine compute other distances over the same codes
+    if (storage == nullptr || (typeid(*storage) != typeid(faiss::IndexFlat) &&
+                               typeid(*storage) != typeid(faiss::IndexFlatL2) &&
+                               typeid(*storage) != typeid(faiss::IndexFlatIP))) {
+        return nullptr;
+    }
+    if (storage->metric_type != faiss::METRIC_L2 && storage->metric_type != faiss::METRIC_INNER_PRODUCT) {
+        return nullptr;
+    }
+
+    switch (faiss::fvec_simd_level()) {
+        case faiss::FvecSimdLevel::AVX512:
+            return hnsw_flat_search_avx512;
+        case faiss::FvecSimdLevel::AVX2:
+            return hnsw_flat_search_avx;
+        default:
+            return nullptr;
+    }
+#else
+    return nullptr;
+#endif
+}
+
+}  // namespace knowhere
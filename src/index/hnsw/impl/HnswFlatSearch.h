@@ -0,0 +1,69 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <faiss/Index.h>
+#include <faiss/IndexFlat.h>
+#include <faiss/cppcontrib/knowhere/impl/CompressedHnswGraph.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswNeighborCodes.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswPublishedGraph.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswSeedTable.h>
+#include <faiss/cppcontrib/knowhere/utils/Bitset.h>
+#include <faiss/impl/HNSW.h>
+#include <faiss/impl/IDSelector.h>
+
+#include <cstddef>
+
+namespace knowhere {
+
+// the state of the search of a query in an HNSW index over a fp32 IndexFlat, as passed to v2_hnsw_searcher
+struct HnswFlatSearchArgs {
+    const faiss::HNSW& hnsw;
+    const faiss::IndexFlat& storage;
+    faiss::cppcontrib::knowhere::Bitset& visited_nodes;
+    // a BitsetViewWithMappingIDSelector or a BitsetViewIDSelector, anything else searches all the nodes
+    const faiss::IDSelector* sel;
+    float kAlpha;
+    const faiss::SearchParametersHNSW* params;
+    size_t prefetch_depth;
+    bool two_hop_expansion;
+    const faiss::cppcontrib::knowhere::CompressedHnswGraph* compressed_graph;
+    const faiss::cppcontrib::knowhere::HnswSeedTable* seed_table;
+    size_t early_stop_patience;
+    float early_stop_gap;
+    const faiss::cppcontrib::knowhere::HnswPublishedGraph* published_graph;
+    faiss::cppcontrib::knowhere::HnswNeighborScanner* neighbor_scanner;
+};
+
+// searches the k nearest neighbors of the query x. The distances of the inner product are negated, as with
+//   faiss::NegativeDistanceComputer.
+using HnswFlatSearchFn = faiss::HNSWStats (*)(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k,
+                                              float* distances, faiss::idx_t* labels);
+
+// The search of a query compiled once per SIMD level, with the distance kernels inlined into the graph traversal
+//   instead of being called through the hooks for every batch of neighbors. nullptr when the storage is not a plain
+//   L2 or IP IndexFlat or the hooks are not the plain kernels of such a level, e.g. with the bf16 patch. Meant to be
+//   read once per search, as the hooks can be switched.
+HnswFlatSearchFn
+hnsw_flat_search_for(const faiss::Index* storage);
+
+#if defined(__x86_64__)
+faiss::HNSWStats
+hnsw_flat_search_avx(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k, float* distances,
+                     faiss::idx_t* labels);
+
+faiss::HNSWStats
+hnsw_flat_search_avx512(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k, float* distances,
+                        faiss::idx_t* labels);
+#endif
+
+}  // namespace knowhere
@@ -0,0 +1,146 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+// The search of HnswFlatSearch.h, included by the translation units of a SIMD level only. Everything here is
+//   instantiated with the kernels of that level, so that no code compiled for it leaks into the rest of the library.
+
+#pragma once
+
+#include <faiss/cppcontrib/knowhere/impl/HnswSearcher.h>
+#include <faiss/utils/prefetch.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "index/hnsw/impl/DummyVisitor.h"
+#include "index/hnsw/impl/HnswFlatSearch.h"
+#include "knowhere/bitsetview_idselector.h"
+
+namespace knowhere {
+
+// A distance computer of a fp32 IndexFlat whose calls are resolved at compile time. Kernels::distances<IP, N>(x, y,
+//   d, dis) writes the inner products or the squared L2 distances between x and the N vectors y to dis. The inner
+//   products are negated, so that the searcher keeps the smallest distances for both metrics.
+template <typename Kernels, bool IP>
+struct HnswFlatDistanceComputer {
+    const float* xb;
+    const size_t d;
+    const float* q = nullptr;
+
+    explicit HnswFlatDistanceComputer(const faiss::IndexFlat& storage) : xb(storage.get_xb()), d(storage.d) {
+    }
+
+    void
+    set_query(const float* x) {
+        q = x;
+    }
+
+    // the leading cache lines of a vector, as FlatCodesDistanceComputer::prefetch()
+    void
+    prefetch(const faiss::idx_t i) {
+        const auto* code = reinterpret_cast<const uint8_t*>(xb + i * d);
+        const size_t nbytes = std::min<size_t>(d * sizeof(float), 256);
+        for (size_t offset = 0; offset < nbytes; offset += 64) {
+            prefetch_L1(code + offset);
+        }
+    }
+
+    float
+    operator()(const faiss::idx_t i) {
+        const float* y = xb + i * d;
+        float dis;
+        Kernels::template distances<IP, 1>(q, &y, d, &dis);
+        return IP ? -dis : dis;
+    }
+
+    void
+    distances_batch_4(const faiss::idx_t idx0, const faiss::idx_t idx1, const faiss::idx_t idx2,
+                      const faiss::idx_t idx3, float& dis0, float& dis1, float& dis2, float& dis3) {
+        const float* y[4] = {xb + idx0 * d, xb + idx1 * d, xb + idx2 * d, xb + idx3 * d};
+        float dis[4];
+        Kernels::template distances<IP, 4>(q, y, d, dis);
+        dis0 = IP ? -dis[0] : dis[0];
+        dis1 = IP ? -dis[1] : dis[1];
+        dis2 = IP ? -dis[2] : dis[2];
+        dis3 = IP ? -dis[3] : dis[3];
+    }
+
+    void
+    distances_batch_8(const faiss::idx_t* idx, float* dis) {
+        const float* y[8];
+        for (size_t k = 0; k < 8; k++) {
+            y[k] = xb + idx[k] * d;
+        }
+        Kernels::template distances<IP, 8>(q, y, d, dis);
+        if constexpr (IP) {
+            for (size_t k = 0; k < 8; k++) {
+                dis[k] = -dis[k];
+            }
+        }
+    }
+};
+
+template <typename DistanceComputerT, typename FilterT>
+faiss::HNSWStats
+hnsw_flat_search_with_filter(const HnswFlatSearchArgs& args, const FilterT& filter, const float* x,
+                             const faiss::idx_t k, float* distances, faiss::idx_t* labels) {
+    DistanceComputerT qdis(args.storage);
+    qdis.set_query(x);
+    DummyVisitor graph_visitor;
+
+    using searcher_type = faiss::cppcontrib::knowhere::v2_hnsw_searcher<DistanceComputerT, DummyVisitor,
+                                                                        faiss::cppcontrib::knowhere::Bitset, FilterT>;
+    searcher_type searcher{args.hnsw,
+                           qdis,
+                           graph_visitor,
+                           args.visited_nodes,
+                           filter,
+                           args.kAlpha,
+                           args.params,
+                           args.prefetch_depth,
+                           args.two_hop_expansion,
+                           args.compressed_graph,
+                           args.seed_table,
+                           args.early_stop_patience,
+                           args.early_stop_gap,
+                           args.published_graph,
+                           args.neighbor_scanner};
+    return searcher.search(k, distances, labels);
+}
+
+// the filters are resolved as in IndexHNSWWrapper::search()
+template <typename DistanceComputerT>
+faiss::HNSWStats
+hnsw_flat_search_with_metric(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k, float* distances,
+                             faiss::idx_t* labels) {
+    if (const auto* bw_idselector = dynamic_cast<const knowhere::BitsetViewWithMappingIDSelector*>(args.sel);
+        bw_idselector && !bw_idselector->bitset_view.empty()) {
+        return hnsw_flat_search_with_filter<DistanceComputerT>(args, *bw_idselector, x, k, distances, labels);
+    }
+    if (const auto* bw_idselector = dynamic_cast<const knowhere::BitsetViewIDSelector*>(args.sel);
+        bw_idselector && !bw_idselector->bitset_view.empty()) {
+        return hnsw_flat_search_with_filter<DistanceComputerT>(args, *bw_idselector, x, k, distances, labels);
+    }
+    faiss::IDSelectorAll sel_all;
+    return hnsw_flat_search_with_filter<DistanceComputerT>(args, sel_all, x, k, distances, labels);
+}
+
+template <typename Kernels>
+faiss::HNSWStats
+hnsw_flat_search(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k, float* distances,
+                 faiss::idx_t* labels) {
+    if (args.storage.metric_type == faiss::METRIC_INNER_PRODUCT) {
+        return hnsw_flat_search_with_metric<HnswFlatDistanceComputer<Kernels, true>>(args, x, k, distances, labels);
+    }
+    return hnsw_flat_search_with_metric<HnswFlatDistanceComputer<Kernels, false>>(args, x, k, distances, labels);
+}
+
+}  // namespace knowhere
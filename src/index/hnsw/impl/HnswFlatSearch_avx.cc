@@ -0,0 +1,77 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#include "index/hnsw/impl/HnswFlatSearchImpl.h"
+
+namespace knowhere {
+
+namespace {
+
+inline float
+horizontal_sum(const __m256 v) {
+    const __m128 v0 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    const __m128 v1 = _mm_add_ps(v0, _mm_movehl_ps(v0, v0));
+    return _mm_cvtss_f32(_mm_add_ss(v1, _mm_movehdup_ps(v1)));
+}
+
+struct AvxKernels {
+    template <bool IP, size_t N>
+    static void
+    distances(const float* x, const float* const* y, size_t d, float* dis) {
+        __m256 acc[N];
+        for (size_t j = 0; j < N; j++) {
+            acc[j] = _mm256_setzero_ps();
+        }
+
+        size_t i = 0;
+        for (; i + 8 <= d; i += 8) {
+            const __m256 mx = _mm256_loadu_ps(x + i);
+            for (size_t j = 0; j < N; j++) {
+                const __m256 my = _mm256_loadu_ps(y[j] + i);
+                if constexpr (IP) {
+                    acc[j] = _mm256_fmadd_ps(mx, my, acc[j]);
+                } else {
+                    const __m256 diff = _mm256_sub_ps(mx, my);
+                    acc[j] = _mm256_fmadd_ps(diff, diff, acc[j]);
+                }
+            }
+        }
+
+        for (size_t j = 0; j < N; j++) {
+            float res = horizontal_sum(acc[j]);
+            for (size_t t = i; t < d; t++) {
+                if constexpr (IP) {
+                    res += x[t] * y[j][t];
+                } else {
+                    const float diff = x[t] - y[j][t];
+                    res += diff * diff;
+                }
+            }
+            dis[j] = res;
+        }
+    }
+};
+
+}  // namespace
+
+faiss::HNSWStats
+hnsw_flat_search_avx(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k, float* distances,
+                     faiss::idx_t* labels) {
+    return hnsw_flat_search<AvxKernels>(args, x, k, distances, labels);
+}
+
+}  // namespace knowhere
+
+#endif
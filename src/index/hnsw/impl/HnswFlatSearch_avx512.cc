@@ -0,0 +1,74 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#include "index/hnsw/impl/HnswFlatSearchImpl.h"
+
+namespace knowhere {
+
+namespace {
+
+struct Avx512Kernels {
+    template <bool IP, size_t N>
+    static void
+    distances(const float* x, const float* const* y, size_t d, float* dis) {
+        __m512 acc[N];
+        for (size_t j = 0; j < N; j++) {
+            acc[j] = _mm512_setzero_ps();
+        }
+
+        size_t i = 0;
+        for (; i + 16 <= d; i += 16) {
+            const __m512 mx = _mm512_loadu_ps(x + i);
+            for (size_t j = 0; j < N; j++) {
+                const __m512 my = _mm512_loadu_ps(y[j] + i);
+                if constexpr (IP) {
+                    acc[j] = _mm512_fmadd_ps(mx, my, acc[j]);
+                } else {
+                    const __m512 diff = _mm512_sub_ps(mx, my);
+                    acc[j] = _mm512_fmadd_ps(diff, diff, acc[j]);
+                }
+            }
+        }
+        if (i < d) {
+            const __mmask16 mask = (1U << (d - i)) - 1;
+            const __m512 mx = _mm512_maskz_loadu_ps(mask, x + i);
+            for (size_t j = 0; j < N; j++) {
+                const __m512 my = _mm512_maskz_loadu_ps(mask, y[j] + i);
+                if constexpr (IP) {
+                    acc[j] = _mm512_fmadd_ps(mx, my, acc[j]);
+                } else {
+                    const __m512 diff = _mm512_sub_ps(mx, my);
+                    acc[j] = _mm512_fmadd_ps(diff, diff, acc[j]);
+                }
+            }
+        }
+
+        for (size_t j = 0; j < N; j++) {
+            dis[j] = _mm512_reduce_add_ps(acc[j]);
+        }
+    }
+};
+
+}  // namespace
+
+faiss::HNSWStats
+hnsw_flat_search_avx512(const HnswFlatSearchArgs& args, const float* x, const faiss::idx_t k, float* distances,
+                        faiss::idx_t* labels) {
+    return hnsw_flat_search<Avx512Kernels>(args, x, k, distances, labels);
+}
+
+}  // namespace knowhere
+
+#endif
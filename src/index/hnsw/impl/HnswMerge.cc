@@ -0,0 +1,253 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/HnswMerge.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <typeinfo>
+#include <vector>
+
+#include "faiss/IndexCosine.h"
+#include "faiss/IndexFlat.h"
+#include "faiss/IndexFlatCodes.h"
+#include "faiss/IndexRaBitQ.h"
+#include "faiss/impl/DistanceComputer.h"
+#include "faiss/impl/FaissAssert.h"
+
+namespace knowhere {
+
+namespace {
+
+using storage_idx_t = faiss::HNSW::storage_idx_t;
+using NodeDistFarther = faiss::HNSW::NodeDistFarther;
+
+// the number of nodes that are searched for cross-graph candidates at once
+constexpr size_t kMergeSearchBatchSize = 4096;
+
+faiss::DistanceComputer*
+storage_distance_computer(const faiss::Index* storage) {
+    if (faiss::is_similarity_metric(storage->metric_type)) {
+        return new faiss::NegativeDistanceComputer(storage->get_distance_computer());
+    } else {
+        return storage->get_distance_computer();
+    }
+}
+
+// appends inverse L2 norms of 'src' if the storages are of the type T
+template <typename T>
+bool
+append_inverse_l2_norms(faiss::Index* dst, const faiss::Index* src) {
+    T* dst_cosine = dynamic_cast<T*>(dst);
+    const T* src_cosine = dynamic_cast<const T*>(src);
+    if (dst_cosine == nullptr || src_cosine == nullptr) {
+        return false;
+    }
+
+    auto& dst_norms = dst_cosine->inverse_norms_storage.inverse_l2_norms;
+    const auto& src_norms = src_cosine->inverse_norms_storage.inverse_l2_norms;
+    dst_norms.insert(dst_norms.end(), src_norms.begin(), src_norms.end());
+    return true;
+}
+
+// appends codes of 'src' to 'dst', together with everything derived from them
+void
+append_storage(faiss::Index* dst, const faiss::Index* src) {
+    faiss::IndexFlatCodes* dst_codes = dynamic_cast<faiss::IndexFlatCodes*>(dst);
+    const faiss::IndexFlatCodes* src_codes = dynamic_cast<const faiss::IndexFlatCodes*>(src);
+    FAISS_THROW_IF_NOT_MSG(dst_codes != nullptr && src_codes != nullptr, "don't know how to merge this storage");
+    FAISS_THROW_IF_NOT_MSG(typeid(*dst) == typeid(*src), "storages of different types cannot be merged");
+    FAISS_THROW_IF_NOT_MSG(dst->d == src->d && dst->metric_type == src->metric_type &&
+                               dst_codes->code_size == src_codes->code_size,
+                           "storages with different parameters cannot be merged");
+
+    // RaBitQ codes are relative to the center of a storage
+    const faiss::IndexRaBitQ* dst_rabitq = dynamic_cast<const faiss::IndexRaBitQ*>(dst);
+    const faiss::IndexRaBitQ* src_rabitq = dynamic_cast<const faiss::IndexRaBitQ*>(src);
+    FAISS_THROW_IF_NOT_MSG(dst_rabitq == nullptr || dst_rabitq->center == src_rabitq->center,
+                           "RaBitQ storages with different centers cannot be merged");
+
+    // a new buffer, because the codes of 'dst' may be a view of a mmap'd file
+    const size_t code_size = dst_codes->code_size;
+    std::vector<uint8_t> codes((dst->ntotal + src->ntotal) * code_size);
+    std::memcpy(codes.data(), dst_codes->codes.data(), dst->ntotal * code_size);
+    std::memcpy(codes.data() + dst->ntotal * code_size, src_codes->codes.data(), src->ntotal * code_size);
+    dst_codes->codes = faiss::MaybeOwnedVector<uint8_t>(std::move(codes));
+    dst->ntotal += src->ntotal;
+
+    append_inverse_l2_norms<faiss::IndexFlatCosine>(dst, src) ||
+        append_inverse_l2_norms<faiss::IndexScalarQuantizerCosine>(dst, src) ||
+        append_inverse_l2_norms<faiss::IndexPQCosine>(dst, src) ||
+        append_inverse_l2_norms<faiss::IndexProductResidualQuantizerCosine>(dst, src) ||
+        append_inverse_l2_norms<faiss::IndexRaBitQCosine>(dst, src);
+
+    faiss::IndexFlatL2* dst_l2 = dynamic_cast<faiss::IndexFlatL2*>(dst);
+    if (dst_l2 != nullptr && !dst_l2->cached_l2norms.empty()) {
+        dst_l2->sync_l2norms();
+    }
+}
+
+// appends the graph of 'src'; node ids of 'src' are shifted by the size of 'dst'
+void
+append_graph(faiss::HNSW& dst, const faiss::HNSW& src) {
+    FAISS_THROW_IF_NOT_MSG(dst.cum_nneighbor_per_level == src.cum_nneighbor_per_level,
+                           "graphs with different numbers of neighbors cannot be merged");
+
+    const size_t dst_ntotal = dst.levels.size();
+    const size_t src_ntotal = src.levels.size();
+    const size_t dst_slots = dst.offsets[dst_ntotal];
+    const size_t src_slots = src.offsets[src_ntotal];
+
+    std::vector<int> levels(dst_ntotal + src_ntotal);
+    std::copy(dst.levels.data(), dst.levels.data() + dst_ntotal, levels.begin());
+    std::copy(src.levels.data(), src.levels.data() + src_ntotal, levels.begin() + dst_ntotal);
+
+    std::vector<size_t> offsets(dst_ntotal + src_ntotal + 1);
+    std::copy(dst.offsets.data(), dst.offsets.data() + dst_ntotal + 1, offsets.begin());
+    for (size_t i = 1; i <= src_ntotal; i++) {
+        offsets[dst_ntotal + i] = dst_slots + src.offsets[i];
+    }
+
+    std::vector<storage_idx_t> neighbors(dst_slots + src_slots);
+    std::copy(dst.neighbors.data(), dst.neighbors.data() + dst_slots, neighbors.begin());
+    for (size_t j = 0; j < src_slots; j++) {
+        const storage_idx_t neighbor = src.neighbors[j];
+        neighbors[dst_slots + j] = (neighbor < 0) ? neighbor : neighbor + (storage_idx_t)dst_ntotal;
+    }
+
+    dst.levels = faiss::MaybeOwnedVector<int>(std::move(levels));
+    dst.offsets = faiss::MaybeOwnedVector<size_t>(std::move(offsets));
+    dst.neighbors = faiss::MaybeOwnedVector<storage_idx_t>(std::move(neighbors));
+
+    // the upper levels of the taller graph lead to either part via level 0
+    if (src.max_level > dst.max_level) {
+        dst.max_level = src.max_level;
+        dst.entry_point = src.entry_point + (storage_idx_t)dst_ntotal;
+    }
+}
+
+// Level-0 candidates from the other graph, per node of the merged graph.
+// Every node of 'src' is searched in 'dst', and the found nodes of 'dst'
+//   get the node of 'src' as a reverse candidate.
+std::vector<std::vector<storage_idx_t>>
+collect_cross_candidates(const faiss::IndexHNSW* dst, const faiss::IndexHNSW* src, const int ef) {
+    const size_t dst_ntotal = dst->ntotal;
+    const size_t src_ntotal = src->ntotal;
+    std::vector<std::vector<storage_idx_t>> candidates(dst_ntotal + src_ntotal);
+    if (dst_ntotal == 0) {
+        return candidates;
+    }
+
+    faiss::SearchParametersHNSW params;
+    params.efSearch = ef;
+
+    const size_t k = std::min<size_t>(ef, dst_ntotal);
+    const size_t batch_size = std::min(kMergeSearchBatchSize, src_ntotal);
+    std::vector<float> x(batch_size * dst->d);
+    std::vector<float> distances(batch_size * k);
+    std::vector<faiss::idx_t> ids(batch_size * k);
+
+    for (size_t i0 = 0; i0 < src_ntotal; i0 += batch_size) {
+        const size_t n = std::min(batch_size, src_ntotal - i0);
+        src->storage->reconstruct_n(i0, n, x.data());
+        dst->search(n, x.data(), k, distances.data(), ids.data(), &params);
+
+        for (size_t i = 0; i < n; i++) {
+            const storage_idx_t src_node = (storage_idx_t)(dst_ntotal + i0 + i);
+            for (size_t j = 0; j < k; j++) {
+                const faiss::idx_t dst_node = ids[i * k + j];
+                if (dst_node < 0) {
+                    break;
+                }
+                candidates[src_node].push_back((storage_idx_t)dst_node);
+                candidates[dst_node].push_back(src_node);
+            }
+        }
+    }
+
+    return candidates;
+}
+
+// selects the level-0 neighbors of a node among the current ones and the candidates
+void
+repair_level_0(faiss::HNSW& hnsw, faiss::DistanceComputer& dis, const storage_idx_t node,
+               std::vector<storage_idx_t>& candidates, const bool keep_max_size_level0) {
+    size_t begin = 0;
+    size_t end = 0;
+    hnsw.neighbor_range(node, 0, &begin, &end);
+
+    for (size_t j = begin; j < end; j++) {
+        if (hnsw.neighbors[j] < 0) {
+            break;
+        }
+        candidates.push_back(hnsw.neighbors[j]);
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::priority_queue<NodeDistFarther> input;
+    for (const storage_idx_t candidate : candidates) {
+        if (candidate != node) {
+            input.emplace(dis.symmetric_dis(node, candidate), candidate);
+        }
+    }
+
+    std::vector<NodeDistFarther> output;
+    faiss::HNSW::shrink_neighbor_list(dis, input, output, end - begin, keep_max_size_level0);
+
+    for (size_t j = begin; j < end; j++) {
+        const size_t idx = j - begin;
+        hnsw.neighbors[j] = (idx < output.size()) ? output[idx].id : -1;
+    }
+}
+
+}  // namespace
+
+void
+merge_hnsw_index(faiss::IndexHNSW* dst, const faiss::IndexHNSW* src, const int ef) {
+    FAISS_THROW_IF_NOT_MSG(dst != nullptr && src != nullptr, "an input index seems to be unrelated to HNSW");
+    FAISS_THROW_IF_NOT_MSG(dst->storage != nullptr && src->storage != nullptr, "an input index has no storage");
+    FAISS_THROW_IF_NOT_MSG(ef > 0, "ef must be positive");
+    if (src->ntotal == 0) {
+        return;
+    }
+
+    // the graph of 'dst' has to be searched before it is modified
+    std::vector<std::vector<storage_idx_t>> candidates = collect_cross_candidates(dst, src, ef);
+
+    append_storage(dst->storage, src->storage);
+    append_graph(dst->hnsw, src->hnsw);
+    dst->ntotal = dst->storage->ntotal;
+
+    const faiss::idx_t ntotal = dst->ntotal;
+    faiss::HNSW& hnsw = dst->hnsw;
+
+#pragma omp parallel
+    {
+        std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(dst->storage));
+
+#pragma omp for schedule(dynamic, 256)
+        for (faiss::idx_t i = 0; i < ntotal; i++) {
+            if (candidates[i].empty()) {
+                continue;
+            }
+            repair_level_0(hnsw, *dis, (storage_idx_t)i, candidates[i], dst->keep_max_size_level0);
+            std::vector<storage_idx_t>().swap(candidates[i]);
+        }
+    }
+}
+
+}  // namespace knowhere
@@ -0,0 +1,31 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "faiss/IndexHNSW.h"
+
+namespace knowhere {
+
+// Appends all nodes of 'src' to 'dst' without rebuilding the graph.
+// * Codes of 'src' are appended to the storage of 'dst', so node i of 'src'
+//   becomes node dst->ntotal + i.
+// * Neighbor lists of both graphs are kept. Every node of 'src' is searched
+//   in 'dst' with the given ef, and level-0 lists of the nodes on both sides
+//   are re-pruned with the found cross-graph candidates.
+// * Upper levels are concatenated as is, the entry point is taken from the
+//   graph with the higher max level.
+// 'src' is left untouched.
+// Throws faiss::FaissException for incompatible or unsupported indexes.
+void
+merge_hnsw_index(faiss::IndexHNSW* dst, const faiss::IndexHNSW* src, const int ef);
+
+}  // namespace knowhere
@@ -0,0 +1,210 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/HnswReorder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+
+#include "faiss/IndexFlatCodes.h"
+#include "faiss/IndexHNSW.h"
+#include "faiss/IndexPreTransform.h"
+#include "faiss/IndexRefine.h"
+#include "faiss/impl/FaissAssert.h"
+#include "knowhere/tolower.h"
+
+namespace knowhere {
+
+namespace {
+
+using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+// the number of valid level-0 neighbors of every node
+std::vector<size_t>
+level_0_degrees(const faiss::HNSW& hnsw, const size_t ntotal) {
+    std::vector<size_t> degrees(ntotal, 0);
+    for (size_t i = 0; i < ntotal; i++) {
+        size_t begin = 0;
+        size_t end = 0;
+        hnsw.neighbor_range(i, 0, &begin, &end);
+
+        for (size_t j = begin; j < end; j++) {
+            if (hnsw.neighbors[j] < 0) {
+                break;
+            }
+            degrees[i] += 1;
+        }
+    }
+
+    return degrees;
+}
+
+// Appends nodes reachable from 'start' to 'order' in a breadth-first manner.
+// Neighbors are enqueued either in their natural order or,
+//   if 'degrees' is provided, in the increasing order of their degrees.
+void
+bfs_from(const faiss::HNSW& hnsw, const storage_idx_t start, const std::vector<size_t>* degrees,
+         std::vector<bool>& visited, std::vector<faiss::idx_t>& order) {
+    std::vector<storage_idx_t> unvisited_neighbors;
+
+    size_t head = order.size();
+    order.push_back(start);
+    visited[start] = true;
+
+    while (head < order.size()) {
+        const storage_idx_t node = order[head++];
+
+        size_t begin = 0;
+        size_t end = 0;
+        hnsw.neighbor_range(node, 0, &begin, &end);
+
+        unvisited_neighbors.clear();
+        for (size_t j = begin; j < end; j++) {
+            const storage_idx_t neighbor = hnsw.neighbors[j];
+            if (neighbor < 0) {
+                break;
+            }
+            if (!visited[neighbor]) {
+                visited[neighbor] = true;
+                unvisited_neighbors.push_back(neighbor);
+            }
+        }
+
+        if (degrees != nullptr) {
+            std::stable_sort(unvisited_neighbors.begin(), unvisited_neighbors.end(),
+                             [degrees](const storage_idx_t a, const storage_idx_t b) {
+                                 return (*degrees)[a] < (*degrees)[b];
+                             });
+        }
+
+        order.insert(order.end(), unvisited_neighbors.begin(), unvisited_neighbors.end());
+    }
+}
+
+// hub nodes first, then every disconnected part in the order of node ids
+std::vector<faiss::idx_t>
+bfs_order(const faiss::HNSW& hnsw, const size_t ntotal) {
+    std::vector<faiss::idx_t> order;
+    order.reserve(ntotal);
+    std::vector<bool> visited(ntotal, false);
+
+    if (hnsw.entry_point >= 0) {
+        bfs_from(hnsw, hnsw.entry_point, nullptr, visited, order);
+    }
+
+    for (size_t i = 0; i < ntotal; i++) {
+        if (!visited[i]) {
+            bfs_from(hnsw, i, nullptr, visited, order);
+        }
+    }
+
+    return order;
+}
+
+// every disconnected part starts from its node with the lowest degree,
+//   the resulting order is reversed
+std::vector<faiss::idx_t>
+rcm_order(const faiss::HNSW& hnsw, const size_t ntotal) {
+    const std::vector<size_t> degrees = level_0_degrees(hnsw, ntotal);
+
+    std::vector<storage_idx_t> by_degree(ntotal);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(),
+                     [&degrees](const storage_idx_t a, const storage_idx_t b) { return degrees[a] < degrees[b]; });
+
+    std::vector<faiss::idx_t> order;
+    order.reserve(ntotal);
+    std::vector<bool> visited(ntotal, false);
+
+    for (const storage_idx_t start : by_degree) {
+        if (!visited[start]) {
+            bfs_from(hnsw, start, &degrees, visited, order);
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+}  // namespace
+
+std::optional<HnswReorderType>
+parse_hnsw_reorder_type(const std::string& name) {
+    const std::string name_tolower = str_to_lower(name);
+    if (name_tolower == "none") {
+        return HnswReorderType::NONE;
+    } else if (name_tolower == "bfs") {
+        return HnswReorderType::BFS;
+    } else if (name_tolower == "rcm") {
+        return HnswReorderType::RCM;
+    }
+
+    return std::nullopt;
+}
+
+std::vector<faiss::idx_t>
+compute_hnsw_reorder_permutation(const faiss::HNSW& hnsw, const HnswReorderType type) {
+    const size_t ntotal = hnsw.levels.size();
+
+    switch (type) {
+        case HnswReorderType::BFS:
+            return bfs_order(hnsw, ntotal);
+        case HnswReorderType::RCM:
+            return rcm_order(hnsw, ntotal);
+        default: {
+            std::vector<faiss::idx_t> identity(ntotal);
+            std::iota(identity.begin(), identity.end(), 0);
+            return identity;
+        }
+    }
+}
+
+const faiss::HNSW*
+get_hnsw_to_reorder(const faiss::Index* index) {
+    const faiss::IndexRefine* index_refine = dynamic_cast<const faiss::IndexRefine*>(index);
+    const faiss::IndexHNSW* index_hnsw = dynamic_cast<const faiss::IndexHNSW*>(
+        (index_refine != nullptr) ? index_refine->base_index : index);
+
+    return (index_hnsw != nullptr) ? &index_hnsw->hnsw : nullptr;
+}
+
+void
+permute_hnsw_index(faiss::Index* index, const faiss::idx_t* perm) {
+    faiss::IndexRefine* index_refine = dynamic_cast<faiss::IndexRefine*>(index);
+    faiss::IndexHNSW* index_hnsw =
+        dynamic_cast<faiss::IndexHNSW*>((index_refine != nullptr) ? index_refine->base_index : index);
+    FAISS_THROW_IF_NOT_MSG(index_hnsw, "an input index seems to be unrelated to HNSW");
+
+    if (index_refine != nullptr) {
+        faiss::IndexFlatCodes* refine_codes = dynamic_cast<faiss::IndexFlatCodes*>(index_refine->refine_index);
+        FAISS_THROW_IF_NOT_MSG(refine_codes, "don't know how to permute this refine index");
+
+        refine_codes->permute_entries(perm);
+    }
+
+    // the codes of a rotated storage are held by the index it wraps
+    faiss::IndexPreTransform* storage_pt = dynamic_cast<faiss::IndexPreTransform*>(index_hnsw->storage);
+    if (storage_pt != nullptr) {
+        faiss::IndexFlatCodes* storage_codes = dynamic_cast<faiss::IndexFlatCodes*>(storage_pt->index);
+        FAISS_THROW_IF_NOT_MSG(storage_codes, "don't know how to permute this storage");
+
+        storage_codes->permute_entries(perm);
+        index_hnsw->hnsw.permute_entries(perm);
+        return;
+    }
+
+    // permutes both the storage and the graph
+    index_hnsw->permute_entries(perm);
+}
+
+}  // namespace knowhere
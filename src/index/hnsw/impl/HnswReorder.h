@@ -0,0 +1,55 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "faiss/Index.h"
+#include "faiss/impl/HNSW.h"
+
+namespace knowhere {
+
+// Orderings of HNSW nodes that improve the memory locality of a search.
+enum class HnswReorderType {
+    // keep the insertion order
+    NONE,
+    // breadth-first traversal of the level-0 graph, starting from the entry point
+    BFS,
+    // reverse Cuthill-McKee ordering of the level-0 graph
+    RCM,
+};
+
+// returns std::nullopt for an unknown name
+std::optional<HnswReorderType>
+parse_hnsw_reorder_type(const std::string& name);
+
+// Computes a permutation of HNSW nodes according to the given ordering.
+// The returned permutation maps new positions to old ones and is
+//   suitable for faiss::IndexHNSW::permute_entries().
+std::vector<faiss::idx_t>
+compute_hnsw_reorder_permutation(const faiss::HNSW& hnsw, const HnswReorderType type);
+
+// Returns the HNSW graph of an index that was produced by faiss_hnsw.cc
+//   (either an IndexHNSW or an IndexRefine on top of IndexHNSW),
+//   or nullptr if the index is not supported.
+const faiss::HNSW*
+get_hnsw_to_reorder(const faiss::Index* index);
+
+// Permutes codes and neighbor lists of such an index in place,
+//   including the raw data of a refine index.
+// Throws faiss::FaissException for unsupported storages.
+void
+permute_hnsw_index(faiss::Index* index, const faiss::idx_t* perm);
+
+}  // namespace knowhere
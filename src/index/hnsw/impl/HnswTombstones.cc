@@ -0,0 +1,269 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/HnswTombstones.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "faiss/impl/DistanceComputer.h"
+#include "faiss/impl/FaissAssert.h"
+
+namespace knowhere {
+
+namespace {
+
+using storage_idx_t = faiss::HNSW::storage_idx_t;
+using NodeDistFarther = faiss::HNSW::NodeDistFarther;
+
+faiss::DistanceComputer*
+storage_distance_computer(const faiss::Index* storage) {
+    if (faiss::is_similarity_metric(storage->metric_type)) {
+        return new faiss::NegativeDistanceComputer(storage->get_distance_computer());
+    } else {
+        return storage->get_distance_computer();
+    }
+}
+
+size_t
+count_bits(const std::vector<uint8_t>& bits) {
+    size_t count = 0;
+    for (const uint8_t value : bits) {
+        count += __builtin_popcount(value);
+    }
+    return count;
+}
+
+void
+write_bits(const std::vector<uint8_t>& bits, faiss::IOWriter* f) {
+    const size_t size = bits.size();
+    FAISS_THROW_IF_NOT_MSG((*f)(&size, sizeof(size), 1) == 1, "write error");
+    FAISS_THROW_IF_NOT_MSG((*f)(bits.data(), 1, size) == size, "write error");
+}
+
+void
+read_bits(std::vector<uint8_t>& bits, faiss::IOReader* f) {
+    size_t size = 0;
+    FAISS_THROW_IF_NOT_MSG((*f)(&size, sizeof(size), 1) == 1, "read error");
+    bits.resize(size);
+    FAISS_THROW_IF_NOT_MSG((*f)(bits.data(), 1, size) == size, "read error");
+}
+
+// nodes beyond the mask were added after it was taken, so they are live
+bool
+is_deleted_node(const std::vector<bool>& deleted, const storage_idx_t node) {
+    return static_cast<size_t>(node) < deleted.size() && deleted[node];
+}
+
+// re-selects the neighbors of a live node on a level if any of them is deleted
+void
+repair_neighbor_list(faiss::HNSW& hnsw, faiss::DistanceComputer& dis, const std::vector<bool>& deleted,
+                     const storage_idx_t node, const int level, std::vector<storage_idx_t>& candidates,
+                     const bool keep_max_size) {
+    size_t begin = 0;
+    size_t end = 0;
+    hnsw.neighbor_range(node, level, &begin, &end);
+
+    bool has_deleted = false;
+    candidates.clear();
+    for (size_t j = begin; j < end; j++) {
+        const storage_idx_t neighbor = hnsw.neighbors[j];
+        if (neighbor < 0) {
+            break;
+        }
+        if (!is_deleted_node(deleted, neighbor)) {
+            candidates.push_back(neighbor);
+            continue;
+        }
+
+        // bypass the deleted node via its own neighbors
+        has_deleted = true;
+        size_t deleted_begin = 0;
+        size_t deleted_end = 0;
+        hnsw.neighbor_range(neighbor, level, &deleted_begin, &deleted_end);
+        for (size_t k = deleted_begin; k < deleted_end; k++) {
+            const storage_idx_t candidate = hnsw.neighbors[k];
+            if (candidate < 0) {
+                break;
+            }
+            if (candidate != node && !is_deleted_node(deleted, candidate)) {
+                candidates.push_back(candidate);
+            }
+        }
+    }
+
+    if (!has_deleted) {
+        return;
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::priority_queue<NodeDistFarther> input;
+    for (const storage_idx_t candidate : candidates) {
+        input.emplace(dis.symmetric_dis(node, candidate), candidate);
+    }
+
+    std::vector<NodeDistFarther> output;
+    faiss::HNSW::shrink_neighbor_list(dis, input, output, end - begin, keep_max_size);
+
+    for (size_t j = begin; j < end; j++) {
+        const size_t idx = j - begin;
+        hnsw.neighbors[j] = (idx < output.size()) ? output[idx].id : -1;
+    }
+}
+
+}  // namespace
+
+size_t
+HnswTombstones::mark_deleted(const int64_t* ids, const size_t n) {
+    size_t n_marked = 0;
+    for (size_t i = 0; i < n; i++) {
+        const int64_t id = ids[i];
+        const size_t byte_idx = id >> 3;
+        if (deleted.size() <= byte_idx) {
+            deleted.resize(byte_idx + 1, 0);
+        }
+        if (!test(deleted, id)) {
+            deleted[byte_idx] |= (0x1 << (id & 0x7));
+            n_marked += 1;
+        }
+    }
+
+    n_deleted += n_marked;
+    return n_marked;
+}
+
+void
+HnswTombstones::mark_reclaimed(const std::vector<int64_t>& ids) {
+    for (const int64_t id : ids) {
+        const size_t byte_idx = id >> 3;
+        if (!test(deleted, id) || test(reclaimed, id)) {
+            continue;
+        }
+        if (reclaimed.size() <= byte_idx) {
+            reclaimed.resize(byte_idx + 1, 0);
+        }
+        reclaimed[byte_idx] |= (0x1 << (id & 0x7));
+        n_reclaimed += 1;
+    }
+}
+
+BitsetView
+HnswTombstones::filter(const BitsetView& bitset, const size_t ntotal, std::vector<uint8_t>& buffer) const {
+    if (empty()) {
+        return bitset;
+    }
+
+    // rows beyond the size of a non-empty bitset are filtered out anyway
+    const size_t num_bits = bitset.empty() ? ntotal : bitset.size();
+    const size_t num_bytes = (num_bits + 7) >> 3;
+
+    buffer.assign(num_bytes, 0);
+    if (!bitset.empty()) {
+        bitset.copy_bits(buffer.data());
+    }
+    const size_t n_common = std::min(num_bytes, deleted.size());
+    for (size_t i = 0; i < n_common; i++) {
+        buffer[i] |= deleted[i];
+    }
+    if ((num_bits & 0x7) != 0) {
+        buffer[num_bytes - 1] &= (0x1 << (num_bits & 0x7)) - 1;
+    }
+
+    const BitsetView combined(buffer.data(), num_bits);
+    return BitsetView(buffer.data(), num_bits, combined.get_filtered_out_num_());
+}
+
+void
+HnswTombstones::write(faiss::IOWriter* f) const {
+    write_bits(deleted, f);
+    write_bits(reclaimed, f);
+}
+
+void
+HnswTombstones::read(faiss::IOReader* f) {
+    read_bits(deleted, f);
+    read_bits(reclaimed, f);
+    n_deleted = count_bits(deleted);
+    n_reclaimed = count_bits(reclaimed);
+}
+
+void
+repair_hnsw_neighbors(faiss::IndexHNSW* index, const std::vector<bool>& deleted, const faiss::idx_t begin,
+                      const faiss::idx_t end) {
+    FAISS_THROW_IF_NOT_MSG(index != nullptr && index->storage != nullptr,
+                           "an input index seems to be unrelated to HNSW");
+    FAISS_THROW_IF_NOT(begin >= 0 && begin <= end && end <= index->ntotal);
+
+    faiss::HNSW& hnsw = index->hnsw;
+
+    // lists of live nodes are written, lists of deleted nodes are only read
+#pragma omp parallel
+    {
+        std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index->storage));
+        std::vector<storage_idx_t> candidates;
+
+#pragma omp for schedule(dynamic, 256)
+        for (faiss::idx_t i = begin; i < end; i++) {
+            const storage_idx_t node = (storage_idx_t)i;
+            if (is_deleted_node(deleted, node)) {
+                continue;
+            }
+            for (int level = 0; level < hnsw.levels[node]; level++) {
+                repair_neighbor_list(hnsw, *dis, deleted, node, level, candidates,
+                                     index->keep_max_size_level0 && (level == 0));
+            }
+        }
+    }
+}
+
+void
+reclaim_hnsw_nodes(faiss::IndexHNSW* index, const std::vector<bool>& deleted,
+                   const std::vector<storage_idx_t>& nodes) {
+    FAISS_THROW_IF_NOT_MSG(index != nullptr, "an input index seems to be unrelated to HNSW");
+
+    faiss::HNSW& hnsw = index->hnsw;
+    for (const storage_idx_t node : nodes) {
+        for (int level = 0; level < hnsw.levels[node]; level++) {
+            size_t begin = 0;
+            size_t end = 0;
+            hnsw.neighbor_range(node, level, &begin, &end);
+            std::fill(hnsw.neighbors.data() + begin, hnsw.neighbors.data() + end, -1);
+        }
+    }
+
+    if (hnsw.entry_point < 0 || !is_deleted_node(deleted, hnsw.entry_point)) {
+        return;
+    }
+
+    // the new entry point is the first live node of the highest level
+    storage_idx_t entry_point = -1;
+    int max_level = -1;
+    for (size_t i = 0; i < hnsw.levels.size(); i++) {
+        if (hnsw.levels[i] - 1 > max_level && !is_deleted_node(deleted, (storage_idx_t)i)) {
+            entry_point = (storage_idx_t)i;
+            max_level = hnsw.levels[i] - 1;
+        }
+    }
+
+    // nothing is left to search from otherwise
+    if (entry_point >= 0) {
+        hnsw.entry_point = entry_point;
+        hnsw.max_level = max_level;
+    }
+}
+
+}  // namespace knowhere
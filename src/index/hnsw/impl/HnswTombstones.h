@@ -0,0 +1,108 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "faiss/IndexHNSW.h"
+#include "faiss/impl/io.h"
+#include "knowhere/bitsetview.h"
+
+namespace knowhere {
+
+// Soft-deleted rows of an index, by row id.
+// A deleted row stays in the graph and can be traversed, but is never returned.
+//   Its graph slots are reclaimed once no other node refers to it,
+//   see repair_hnsw_neighbors() and reclaim_hnsw_nodes().
+class HnswTombstones {
+ public:
+    // marks rows as deleted, returns the number of rows that were not deleted before
+    size_t
+    mark_deleted(const int64_t* ids, const size_t n);
+
+    // marks deleted rows as the ones whose graph slots are reclaimed
+    void
+    mark_reclaimed(const std::vector<int64_t>& ids);
+
+    bool
+    is_deleted(const int64_t id) const {
+        return test(deleted, id);
+    }
+
+    bool
+    is_reclaimed(const int64_t id) const {
+        return test(reclaimed, id);
+    }
+
+    // the number of deleted rows
+    size_t
+    count() const {
+        return n_deleted;
+    }
+
+    // the number of deleted rows whose graph slots are not reclaimed yet
+    size_t
+    count_pending() const {
+        return n_deleted - n_reclaimed;
+    }
+
+    bool
+    empty() const {
+        return n_deleted == 0;
+    }
+
+    // a search bitset with the deleted rows filtered out as well.
+    //   'buffer' keeps the combined bits, the input bitset is returned as is if nothing is deleted.
+    BitsetView
+    filter(const BitsetView& bitset, const size_t ntotal, std::vector<uint8_t>& buffer) const;
+
+    // the number of bytes used
+    size_t
+    size_in_bytes() const {
+        return deleted.size() + reclaimed.size();
+    }
+
+    void
+    write(faiss::IOWriter* f) const;
+
+    void
+    read(faiss::IOReader* f);
+
+ private:
+    static bool
+    test(const std::vector<uint8_t>& bits, const int64_t id) {
+        return static_cast<size_t>(id >> 3) < bits.size() && (bits[id >> 3] & (0x1 << (id & 0x7)));
+    }
+
+    std::vector<uint8_t> deleted;
+    std::vector<uint8_t> reclaimed;
+    size_t n_deleted = 0;
+    size_t n_reclaimed = 0;
+};
+
+// Replaces the references to deleted nodes in the neighbor lists of live nodes [begin, end) on all levels.
+// A reference to a deleted node is replaced with the closest candidates among the node's other neighbors
+//   and the live neighbors of the deleted node, pruned with the regular HNSW heuristic.
+// 'deleted' is indexed by node id and must cover the graph, lists of deleted nodes are left untouched.
+void
+repair_hnsw_neighbors(faiss::IndexHNSW* index, const std::vector<bool>& deleted, const faiss::idx_t begin,
+                      const faiss::idx_t end);
+
+// Clears the neighbor lists of deleted nodes that no live node refers to anymore.
+// The entry point is moved to a live node of the highest level if it is one of the nodes.
+void
+reclaim_hnsw_nodes(faiss::IndexHNSW* index, const std::vector<bool>& deleted,
+                   const std::vector<faiss::HNSW::storage_idx_t>& nodes);
+
+}  // namespace knowhere
@@ -11,15 +11,20 @@
 
 #include "IndexConditionalWrapper.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 
 #include "faiss/IndexCosine.h"
+#include "faiss/IndexFlatCodes.h"
 #include "faiss/IndexHNSW.h"
+#include "faiss/IndexPreTransform.h"
 #include "faiss/IndexRefine.h"
 #include "index/hnsw/impl/IndexBruteForceWrapper.h"
 #include "index/hnsw/impl/IndexHNSWWrapper.h"
+#include "index/hnsw/impl/IndexRefineOnDisk.h"
 #include "index/hnsw/impl/IndexWrapperCosine.h"
+#include "knowhere/comp/search_planner.h"
 #include "knowhere/utils.h"
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
@@ -32,7 +37,7 @@ namespace knowhere {
 // This may be applicable in case of very large topk values or
 //   extremely high filtering levels.
 std::optional<bool>
-WhetherPerformBruteForceSearch(const faiss::Index* index, const BaseConfig& cfg, const BitsetView& bitset) {
+WhetherPerformBruteForceSearch(const faiss::Index* index, const FaissHnswConfig& cfg, const BitsetView& bitset) {
     // check if parameters have all we need
     if (!cfg.k.has_value() || index == nullptr) {
         return std::nullopt;
@@ -41,6 +46,12 @@ WhetherPerformBruteForceSearch(const faiss::Index* index, const BaseConfig& cfg,
     // decide
     const auto k = cfg.k.value();
 
+    if (SearchPlanner::Enabled()) {
+        auto input = SearchPlanInput::FromBitset(index->ntotal, index->d, k, bitset);
+        input.ef = std::max<int64_t>(k, cfg.ef.value_or(k));
+        return SearchPlanner::Plan(input).plan == SearchPlan::BRUTE_FORCE;
+    }
+
     if (k >= (index->ntotal * HnswSearchThresholds::kHnswSearchBFTopkThreshold)) {
         return true;
     }
@@ -74,6 +85,13 @@ WhetherPerformBruteForceRangeSearch(const faiss::Index* index, const FaissHnswCo
     // decide
     const auto ef = cfg.ef.value();
 
+    if (SearchPlanner::Enabled()) {
+        // a range search keeps walking the graph while it finds rows within the radius, ef bounds its candidates
+        auto input = SearchPlanInput::FromBitset(index->ntotal, index->d, ef, bitset);
+        input.ef = ef;
+        return SearchPlanner::Plan(input).plan == SearchPlan::BRUTE_FORCE;
+    }
+
     if (ef >= (index->ntotal * HnswSearchThresholds::kHnswSearchBFTopkThreshold)) {
         return true;
     }
@@ -94,13 +112,20 @@ WhetherPerformBruteForceRangeSearch(const faiss::Index* index, const FaissHnswCo
     return false;
 }
 
+const faiss::Index*
+get_hnsw_codes_storage(const faiss::Index* storage) {
+    const faiss::IndexPreTransform* storage_pt = dynamic_cast<const faiss::IndexPreTransform*>(storage);
+    return (storage_pt != nullptr) ? storage_pt->index : storage;
+}
+
 // returns nullptr in case of invalid index.
 //
 // `whether_to_enable_refine` allows to enable the refine for the search if the
 //    index was trained with the refine.
 std::tuple<std::unique_ptr<faiss::Index>, bool>
 create_conditional_hnsw_wrapper(faiss::Index* index, const FaissHnswConfig& hnsw_cfg, const bool whether_bf_search,
-                                const bool whether_to_enable_refine) {
+                                const bool whether_to_enable_refine,
+                                const RefineCodesReader* refine_codes_reader) {
     const bool is_cosine = IsMetricType(hnsw_cfg.metric_type.value(), knowhere::metric::COSINE);
 
     // check if we have a refine available.
@@ -136,13 +161,39 @@ create_conditional_hnsw_wrapper(faiss::Index* index, const FaissHnswConfig& hnsw
             // thus, we need to define a new refine index and pass
             //   wrapper_searcher into its ownership
 
+            // are the codes of the refine index on disk?
+            if (refine_codes_reader != nullptr) {
+                faiss::IndexFlatCodes* const refine_codes_index =
+                    dynamic_cast<faiss::IndexFlatCodes*>(index_refine->refine_index);
+                if (refine_codes_index == nullptr) {
+                    // this is unexpected
+                    return {nullptr, false};
+                }
+
+                const faiss::Index* codes_storage = get_hnsw_codes_storage(index_hnsw->storage);
+                const float* inverse_l2_norms =
+                    (codes_storage->is_cosine && is_cosine)
+                        ? dynamic_cast<const faiss::HasInverseL2Norms*>(codes_storage)->get_inverse_l2_norms()
+                        : nullptr;
+                std::unique_ptr<IndexRefineOnDisk> refine_wrapper = std::make_unique<IndexRefineOnDisk>(
+                    base_wrapper.get(), refine_codes_index, refine_codes_reader, inverse_l2_norms);
+
+                // transfer ownership
+                refine_wrapper->own_fields = true;
+                base_wrapper.release();
+
+                // done
+                return {std::move(refine_wrapper), true};
+            }
+
             // is it a cosine index?
-            if (index_hnsw->storage->is_cosine && is_cosine) {
+            const faiss::Index* codes_storage = get_hnsw_codes_storage(index_hnsw->storage);
+            if (codes_storage->is_cosine && is_cosine) {
                 // yes, wrap both base and refine index
                 std::unique_ptr<knowhere::IndexWrapperCosine> cosine_wrapper =
                     std::make_unique<knowhere::IndexWrapperCosine>(
                         index_refine->refine_index,
-                        dynamic_cast<faiss::HasInverseL2Norms*>(index_hnsw->storage)->get_inverse_l2_norms());
+                        dynamic_cast<const faiss::HasInverseL2Norms*>(codes_storage)->get_inverse_l2_norms());
 
                 // create a temporary refine index
                 std::unique_ptr<faiss::IndexRefine> refine_wrapper =
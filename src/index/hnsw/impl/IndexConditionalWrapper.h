@@ -19,6 +19,7 @@
 
 #include "faiss/Index.h"
 #include "index/hnsw/faiss_hnsw_config.h"
+#include "index/refine/refine_codes_reader.h"
 #include "knowhere/bitsetview.h"
 
 namespace knowhere {
@@ -27,13 +28,15 @@ struct HnswSearchThresholds {
     static constexpr float kHnswSearchKnnBFFilterThreshold = 0.93f;
     static constexpr float kHnswSearchRangeBFFilterThreshold = 0.97f;
     static constexpr float kHnswSearchBFTopkThreshold = 0.5f;
+    // the two-hop expansion is used starting from this filter ratio, if enabled
+    static constexpr float kHnswSearchTwoHopFilterThreshold = 0.8f;
 };
 
 // Decides whether a brute force should be used instead of a regular HNSW search.
 // This may be applicable in case of very large topk values or
-//   extremely high filtering levels.
+//   extremely high filtering levels. SearchPlanner decides instead of the thresholds, if enabled.
 std::optional<bool>
-WhetherPerformBruteForceSearch(const faiss::Index* index, const BaseConfig& cfg, const BitsetView& bitset);
+WhetherPerformBruteForceSearch(const faiss::Index* index, const FaissHnswConfig& cfg, const BitsetView& bitset);
 
 // Decides whether a brute force should be used instead of a regular HNSW range search.
 // This may be applicable in case of very large topk values or
@@ -41,13 +44,20 @@ WhetherPerformBruteForceSearch(const faiss::Index* index, const BaseConfig& cfg,
 std::optional<bool>
 WhetherPerformBruteForceRangeSearch(const faiss::Index* index, const FaissHnswConfig& cfg, const BitsetView& bitset);
 
+// the index that holds the codes of an HNSW storage, the wrapped one for a storage under a rotation
+const faiss::Index*
+get_hnsw_codes_storage(const faiss::Index* storage);
+
 // first return arg: returns nullptr in case of invalid index
 // second return arg: returns whether an index does the refine
 //
 // `whether_to_enable_refine` allows to enable the refine for the search if the
 //    index was trained with the refine.
+// `refine_codes_reader` reads the codes of the refine index from the file, if
+//    they were left on disk during the load.
 std::tuple<std::unique_ptr<faiss::Index>, bool>
 create_conditional_hnsw_wrapper(faiss::Index* index, const FaissHnswConfig& hnsw_cfg, const bool whether_bf_search,
-                                const bool whether_to_enable_refine);
+                                const bool whether_to_enable_refine,
+                                const RefineCodesReader* refine_codes_reader = nullptr);
 
 }  // namespace knowhere
@@ -11,7 +11,10 @@
 
 #include "index/hnsw/impl/IndexHNSWWrapper.h"
 
+#include <faiss/IndexCosine.h>
 #include <faiss/IndexHNSW.h>
+#include <faiss/IndexRaBitQ.h>
+#include <faiss/IndexScalarQuantizer.h>
 #include <faiss/MetricType.h>
 #include <faiss/cppcontrib/knowhere/impl/Bruteforce.h>
 #include <faiss/cppcontrib/knowhere/impl/HnswSearcher.h>
@@ -26,11 +29,15 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <typeinfo>
+#include <vector>
 
 #include "index/hnsw/impl/DummyVisitor.h"
 #include "index/hnsw/impl/FederVisitor.h"
+#include "index/hnsw/impl/HnswFlatSearch.h"
 #include "knowhere/bitsetview.h"
 #include "knowhere/bitsetview_idselector.h"
+#include "knowhere/comp/group_by.h"
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
 #include "knowhere/prometheus_client.h"
@@ -42,15 +49,217 @@ namespace knowhere {
  * Utilities
  **************************************************************/
 
+using idx_t = faiss::idx_t;
+
 namespace {
 
+// a storage distance computer, quantizes a query for RaBitQ storages if requested
+faiss::DistanceComputer*
+storage_quantized_distance_computer(const faiss::Index* storage, const int rabitq_query_bits) {
+    if (rabitq_query_bits >= 0) {
+        if (const auto* rabitq_cosine = dynamic_cast<const faiss::IndexRaBitQCosine*>(storage)) {
+            return rabitq_cosine->get_quantized_cosine_distance_computer(rabitq_query_bits);
+        }
+        if (const auto* rabitq = dynamic_cast<const faiss::IndexRaBitQ*>(storage)) {
+            return rabitq->get_quantized_distance_computer(rabitq_query_bits);
+        }
+    }
+    return storage->get_distance_computer();
+}
+
+// a distance computer of a SQ storage of fp16 or bf16 codes that scores the queries of the same type in it,
+//   nullptr if the storage or the queries are of other types
+faiss::DistanceComputer*
+storage_half_precision_distance_computer(const faiss::Index* storage, const DataFormatEnum query_data_format) {
+    // subclasses such as IndexScalarQuantizerCosine compute other distances over the same codes
+    if (typeid(*storage) != typeid(faiss::IndexScalarQuantizer)) {
+        return nullptr;
+    }
+    const auto* index_sq = static_cast<const faiss::IndexScalarQuantizer*>(storage);
+    if ((query_data_format == DataFormatEnum::fp16 && index_sq->sq.qtype == faiss::ScalarQuantizer::QT_fp16) ||
+        (query_data_format == DataFormatEnum::bf16 && index_sq->sq.qtype == faiss::ScalarQuantizer::QT_bf16)) {
+        return index_sq->get_half_precision_distance_computer();
+    }
+    return nullptr;
+}
+
+faiss::DistanceComputer*
+storage_typed_distance_computer(const faiss::Index* storage, const SearchParametersHNSWWrapper* params) {
+    if (params != nullptr) {
+        if (auto* dis = storage_half_precision_distance_computer(storage, params->query_data_format)) {
+            return dis;
+        }
+    }
+    const int rabitq_query_bits = (params == nullptr) ? -1 : params->rabitq_query_bits;
+    return storage_quantized_distance_computer(storage, rabitq_query_bits);
+}
+
 // cloned from IndexHNSW.cpp
 faiss::DistanceComputer*
-storage_distance_computer(const faiss::Index* storage) {
+storage_distance_computer(const faiss::Index* storage, const SearchParametersHNSWWrapper* params) {
     if (faiss::is_similarity_metric(storage->metric_type)) {
-        return new faiss::NegativeDistanceComputer(storage->get_distance_computer());
+        return new faiss::NegativeDistanceComputer(storage_typed_distance_computer(storage, params));
     } else {
-        return storage->get_distance_computer();
+        return storage_typed_distance_computer(storage, params);
+    }
+}
+
+// search groups of queries that traverse the graph together
+template <typename FilterT>
+void
+search_batched_with_filter(const faiss::IndexHNSW* index_hnsw, const idx_t n, const float* __restrict x, const idx_t k,
+                           float* __restrict distances, idx_t* __restrict labels, const FilterT& filter,
+                           const float kAlpha, const SearchParametersHNSWWrapper* params, const size_t prefetch_depth,
+                           const bool two_hop_expansion, const size_t batch_size, faiss::HNSWStats* __restrict stats) {
+    using searcher_type =
+        faiss::cppcontrib::knowhere::v2_hnsw_searcher<faiss::DistanceComputer, DummyVisitor,
+                                                      faiss::cppcontrib::knowhere::Bitset, FilterT>;
+
+    const faiss::HNSW& hnsw = index_hnsw->hnsw;
+
+    // every query of a group needs its own state
+    std::vector<std::unique_ptr<faiss::DistanceComputer>> dis(batch_size);
+    std::vector<faiss::cppcontrib::knowhere::Bitset> bitset_visited_nodes;
+    std::vector<DummyVisitor> graph_visitors(batch_size);
+    std::vector<std::unique_ptr<searcher_type>> searchers(batch_size);
+    std::vector<searcher_type*> searcher_ptrs(batch_size);
+
+    bitset_visited_nodes.reserve(batch_size);
+    for (size_t q = 0; q < batch_size; q++) {
+        dis[q].reset(storage_distance_computer(index_hnsw->storage, params));
+        bitset_visited_nodes.emplace_back(
+            faiss::cppcontrib::knowhere::Bitset::create_uninitialized(index_hnsw->ntotal));
+    }
+
+    for (size_t q = 0; q < batch_size; q++) {
+        searchers[q] =
+            std::make_unique<searcher_type>(hnsw, *(dis[q].get()), graph_visitors[q], bitset_visited_nodes[q], filter,
+                                            kAlpha, params, prefetch_depth, two_hop_expansion,
+                                            params->compressed_graph, params->seed_table,
+                                            std::max(params->early_stop_patience, 0), params->early_stop_gap,
+                                            params->published_graph);
+        searcher_ptrs[q] = searchers[q].get();
+    }
+
+    for (idx_t group_start = 0; group_start < n; group_start += batch_size) {
+        const size_t group_size = std::min<size_t>(batch_size, n - group_start);
+
+        // prepare the queries
+        for (size_t q = 0; q < group_size; q++) {
+            dis[q]->set_query(x + (group_start + q) * index_hnsw->d);
+            bitset_visited_nodes[q].clear();
+        }
+
+        faiss::cppcontrib::knowhere::v2_hnsw_batch_search(searcher_ptrs.data(), group_size, k,
+                                                          distances + group_start * k, labels + group_start * k,
+                                                          stats + group_start);
+    }
+}
+
+// batched version of IndexHNSWWrapper::search(), feder is not supported
+void
+search_batched(const faiss::IndexHNSW* index_hnsw, const idx_t n, const float* __restrict x, const idx_t k,
+               float* __restrict distances, idx_t* __restrict labels, const SearchParametersHNSWWrapper* params,
+               const float kAlpha, const size_t prefetch_depth, const bool two_hop_expansion) {
+    const size_t batch_size = std::min<size_t>(params->query_batch_size, n);
+
+    // future results
+    std::vector<faiss::HNSWStats> local_stats(n);
+
+    // set up a filter
+    faiss::IDSelector* sel = params->sel;
+
+    // try knowhere-specific filter
+    if (const knowhere::BitsetViewWithMappingIDSelector* __restrict bw_idselector =
+            dynamic_cast<const knowhere::BitsetViewWithMappingIDSelector*>(sel);
+        bw_idselector && !bw_idselector->bitset_view.empty()) {
+        // with filter
+        search_batched_with_filter(index_hnsw, n, x, k, distances, labels, *bw_idselector, kAlpha, params,
+                                   prefetch_depth, two_hop_expansion, batch_size, local_stats.data());
+    } else if (const knowhere::BitsetViewIDSelector* __restrict bw_idselector =
+                   dynamic_cast<const knowhere::BitsetViewIDSelector*>(sel);
+               bw_idselector && !bw_idselector->bitset_view.empty()) {
+        // with filter, no mapping
+        search_batched_with_filter(index_hnsw, n, x, k, distances, labels, *bw_idselector, kAlpha, params,
+                                   prefetch_depth, two_hop_expansion, batch_size, local_stats.data());
+    } else {
+        // no filter
+        faiss::IDSelectorAll sel_all;
+        search_batched_with_filter(index_hnsw, n, x, k, distances, labels, sel_all, kAlpha, params, prefetch_depth,
+                                   false, batch_size, local_stats.data());
+    }
+
+    // record some statistics
+    faiss::HNSWStats total_stats;
+    for (idx_t i = 0; i < n; i++) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        knowhere::knowhere_hnsw_search_hops.Observe(local_stats[i].nhops);
+#endif
+        total_stats.combine(local_stats[i]);
+        if (params->query_stats != nullptr) {
+            params->query_stats[i].combine(local_stats[i]);
+        }
+    }
+
+    // update stats if possible
+    if (params->hnsw_stats != nullptr) {
+        params->hnsw_stats->combine(total_stats);
+    }
+
+    // done, update the results, if needed
+    if (is_similarity_metric(index_hnsw->metric_type)) {
+        // we need to revert the negated distances
+        for (idx_t i = 0; i < k * n; i++) {
+            distances[i] = -distances[i];
+        }
+    }
+}
+
+// group-by search of a single query at a time, the distances of similarity metrics stay negated
+template <typename FilterT>
+void
+search_group_by_with_filter(const faiss::IndexHNSW* index_hnsw, const idx_t n, const float* __restrict x,
+                            const GroupKeys& group_keys, const size_t n_groups, const size_t group_size,
+                            float* __restrict distances, idx_t* __restrict labels, const FilterT& filter,
+                            const SearchParametersHNSWWrapper* params, faiss::HNSWStats* __restrict stats) {
+    using searcher_type =
+        faiss::cppcontrib::knowhere::v2_hnsw_searcher<faiss::DistanceComputer, DummyVisitor,
+                                                      faiss::cppcontrib::knowhere::Bitset, FilterT>;
+
+    const float kAlpha = (params == nullptr) ? 0.0f : params->kAlpha;
+    const size_t prefetch_depth = (params == nullptr) ? 0 : std::max(params->prefetch_depth, 0);
+    const bool two_hop_expansion = (params != nullptr) && params->two_hop_expansion;
+
+    std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index_hnsw->storage, params));
+    faiss::cppcontrib::knowhere::Bitset bitset_visited_nodes =
+        faiss::cppcontrib::knowhere::Bitset::create_uninitialized(index_hnsw->ntotal);
+    DummyVisitor graph_visitor;
+
+    // the neighbor codes are tied to the bounded candidate list of a regular search
+    searcher_type searcher{index_hnsw->hnsw,
+                           *(dis.get()),
+                           graph_visitor,
+                           bitset_visited_nodes,
+                           filter,
+                           kAlpha,
+                           params,
+                           prefetch_depth,
+                           two_hop_expansion,
+                           (params == nullptr) ? nullptr : params->compressed_graph,
+                           (params == nullptr) ? nullptr : params->seed_table,
+                           0,
+                           0.0f,
+                           (params == nullptr) ? nullptr : params->published_graph};
+
+    GroupByCollector groups(group_keys, n_groups, group_size);
+    const bool negate = is_similarity_metric(index_hnsw->metric_type);
+    for (idx_t i = 0; i < n; i++) {
+        dis->set_query(x + i * index_hnsw->d);
+        bitset_visited_nodes.clear();
+        groups.Reset();
+
+        stats[i] = searcher.search_group_by(groups);
+        groups.Output(labels + i * n_groups * group_size, distances + i * n_groups * group_size, negate);
     }
 }
 
@@ -60,8 +269,6 @@ storage_distance_computer(const faiss::Index* storage) {
  * IndexHNSWWrapper implementation
  **************************************************************/
 
-using idx_t = faiss::idx_t;
-
 IndexHNSWWrapper::IndexHNSWWrapper(faiss::IndexHNSW* underlying_index)
     : faiss::cppcontrib::knowhere::IndexWrapper(underlying_index) {
 }
@@ -94,15 +301,39 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
     const faiss::HNSW& hnsw = index_hnsw->hnsw;
 
     float kAlpha = 0.0f;
+    size_t prefetch_depth = 0;
+    bool two_hop_expansion = false;
+    const faiss::cppcontrib::knowhere::CompressedHnswGraph* compressed_graph = nullptr;
+    const faiss::cppcontrib::knowhere::HnswSeedTable* seed_table = nullptr;
+    size_t early_stop_patience = 0;
+    float early_stop_gap = 0.0f;
+    const faiss::cppcontrib::knowhere::HnswPublishedGraph* published_graph = nullptr;
+    const faiss::cppcontrib::knowhere::HnswNeighborCodes* neighbor_codes = nullptr;
     if (params_in) {
         params = dynamic_cast<const SearchParametersHNSWWrapper*>(params_in);
         FAISS_THROW_IF_NOT_MSG(params, "params type invalid");
 
         kAlpha = params->kAlpha;
+        prefetch_depth = std::max(params->prefetch_depth, 0);
+        two_hop_expansion = params->two_hop_expansion;
+        compressed_graph = params->compressed_graph;
+        seed_table = params->seed_table;
+        early_stop_patience = std::max(params->early_stop_patience, 0);
+        early_stop_gap = params->early_stop_gap;
+        published_graph = params->published_graph;
+        neighbor_codes = params->neighbor_codes;
+
+        // let groups of queries traverse the graph together, if requested.
+        //   feder tracing is performed for a single query only, and so are the fast-scan neighbor codes.
+        if (params->query_batch_size > 1 && params->feder == nullptr && neighbor_codes == nullptr && n > 1) {
+            search_batched(index_hnsw, n, x, k, distances, labels, params, kAlpha, prefetch_depth, two_hop_expansion);
+            return;
+        }
     }
 
     // set up hnsw_stats
     faiss::HNSWStats* __restrict const hnsw_stats = (params == nullptr) ? nullptr : params->hnsw_stats;
+    faiss::HNSWStats* __restrict const query_stats = (params == nullptr) ? nullptr : params->query_stats;
 
     //
     size_t n1 = 0;
@@ -115,12 +346,24 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
         faiss::cppcontrib::knowhere::Bitset::create_uninitialized(index->ntotal);
 
     // create a distance computer
-    std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index_hnsw->storage));
+    std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index_hnsw->storage, params));
+    // and a scanner of the neighbor codes
+    std::unique_ptr<faiss::cppcontrib::knowhere::HnswNeighborScanner> neighbor_scanner;
+    if (neighbor_codes != nullptr) {
+        neighbor_scanner = std::make_unique<faiss::cppcontrib::knowhere::HnswNeighborScanner>(*neighbor_codes);
+    }
+    // or the search compiled for the SIMD level of the hooks, which has the distances of fp32 storage inlined
+    const HnswFlatSearchFn flat_search = (params == nullptr || params->feder == nullptr)
+                                             ? hnsw_flat_search_for(index_hnsw->storage)
+                                             : nullptr;
 
     // no parallelism by design
     for (idx_t i = 0; i < n; i++) {
         // prepare the query
         dis->set_query(x + i * index->d);
+        if (neighbor_scanner != nullptr) {
+            neighbor_scanner->set_query(x + i * index->d);
+        }
 
         // prepare the table of visited elements
         bitset_visited_nodes.clear();
@@ -134,11 +377,28 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
         // set up a filter
         faiss::IDSelector* sel = (params == nullptr) ? nullptr : params->sel;
 
-        // try knowhere-specific filter
-        if (const knowhere::BitsetViewWithMappingIDSelector* __restrict bw_idselector =
-                dynamic_cast<const knowhere::BitsetViewWithMappingIDSelector*>(sel);
-            bw_idselector && !bw_idselector->bitset_view.empty()) {
-            // with filter
+        if (flat_search != nullptr) {
+            // no feder, the filter is resolved by flat_search
+            const HnswFlatSearchArgs args{hnsw,
+                                          static_cast<const faiss::IndexFlat&>(*index_hnsw->storage),
+                                          bitset_visited_nodes,
+                                          sel,
+                                          kAlpha,
+                                          params,
+                                          prefetch_depth,
+                                          two_hop_expansion,
+                                          compressed_graph,
+                                          seed_table,
+                                          early_stop_patience,
+                                          early_stop_gap,
+                                          published_graph,
+                                          neighbor_scanner.get()};
+
+            local_stats = flat_search(args, x + i * index->d, k, distances + i * k, labels + i * k);
+        } else if (const knowhere::BitsetViewWithMappingIDSelector* __restrict bw_idselector =
+                       dynamic_cast<const knowhere::BitsetViewWithMappingIDSelector*>(sel);
+                   bw_idselector && !bw_idselector->bitset_view.empty()) {
+            // try knowhere-specific filter, with filter
             // feder templating is important, bcz it removes an unneeded 'CALL' instruction.
             if (feder == nullptr) {
                 // no feder
@@ -149,8 +409,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewWithMappingIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph,
+                                       neighbor_scanner.get()};
 
                 local_stats = searcher.search(k, distances + i * k, labels + i * k);
             } else {
@@ -162,8 +424,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewWithMappingIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph,
+                                       neighbor_scanner.get()};
 
                 local_stats = searcher.search(k, distances + i * k, labels + i * k);
             }
@@ -182,8 +446,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph,
+                                       neighbor_scanner.get()};
 
                 local_stats = searcher.search(k, distances + i * k, labels + i * k);
             } else {
@@ -195,8 +461,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph,
+                                       neighbor_scanner.get()};
 
                 local_stats = searcher.search(k, distances + i * k, labels + i * k);
             }
@@ -212,8 +480,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
                 using searcher_type = faiss::cppcontrib::knowhere::v2_hnsw_searcher<
                     faiss::DistanceComputer, DummyVisitor, faiss::cppcontrib::knowhere::Bitset, faiss::IDSelectorAll>;
 
-                searcher_type searcher{hnsw,    *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       sel_all, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, sel_all,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph,
+                                       neighbor_scanner.get()};
 
                 local_stats = searcher.search(k, distances + i * k, labels + i * k);
             } else {
@@ -223,8 +493,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
                 using searcher_type = faiss::cppcontrib::knowhere::v2_hnsw_searcher<
                     faiss::DistanceComputer, FederVisitor, faiss::cppcontrib::knowhere::Bitset, faiss::IDSelectorAll>;
 
-                searcher_type searcher{hnsw,    *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       sel_all, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, sel_all,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph,
+                                       neighbor_scanner.get()};
 
                 local_stats = searcher.search(k, distances + i * k, labels + i * k);
             }
@@ -235,6 +507,10 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
         knowhere::knowhere_hnsw_search_hops.Observe(local_stats.nhops);
 #endif
 
+        if (query_stats != nullptr) {
+            query_stats[i].combine(local_stats);
+        }
+
         // update stats if possible
         if (hnsw_stats != nullptr) {
             n1 += local_stats.n1;
@@ -258,6 +534,64 @@ IndexHNSWWrapper::search(idx_t n, const float* __restrict x, idx_t k, float* __r
     }
 }
 
+void
+IndexHNSWWrapper::search_group_by(idx_t n, const float* __restrict x, const GroupKeys& group_keys, size_t n_groups,
+                                  size_t group_size, float* __restrict distances, idx_t* __restrict labels,
+                                  const faiss::SearchParameters* __restrict params_in) const {
+    FAISS_THROW_IF_NOT(n_groups > 0 && group_size > 0);
+
+    const faiss::IndexHNSW* index_hnsw = dynamic_cast<const faiss::IndexHNSW*>(index);
+    FAISS_THROW_IF_NOT(index_hnsw);
+
+    FAISS_THROW_IF_NOT_MSG(index_hnsw->storage, "No storage index");
+
+    const SearchParametersHNSWWrapper* params = nullptr;
+    if (params_in) {
+        params = dynamic_cast<const SearchParametersHNSWWrapper*>(params_in);
+        FAISS_THROW_IF_NOT_MSG(params, "params type invalid");
+    }
+
+    std::vector<faiss::HNSWStats> local_stats(n);
+
+    // set up a filter
+    faiss::IDSelector* sel = (params == nullptr) ? nullptr : params->sel;
+
+    // try knowhere-specific filter
+    if (const knowhere::BitsetViewWithMappingIDSelector* __restrict bw_idselector =
+            dynamic_cast<const knowhere::BitsetViewWithMappingIDSelector*>(sel);
+        bw_idselector && !bw_idselector->bitset_view.empty()) {
+        // with filter
+        search_group_by_with_filter(index_hnsw, n, x, group_keys, n_groups, group_size, distances, labels,
+                                    *bw_idselector, params, local_stats.data());
+    } else if (const knowhere::BitsetViewIDSelector* __restrict bw_idselector =
+                   dynamic_cast<const knowhere::BitsetViewIDSelector*>(sel);
+               bw_idselector && !bw_idselector->bitset_view.empty()) {
+        // with filter, no mapping
+        search_group_by_with_filter(index_hnsw, n, x, group_keys, n_groups, group_size, distances, labels,
+                                    *bw_idselector, params, local_stats.data());
+    } else {
+        // no filter
+        faiss::IDSelectorAll sel_all;
+        search_group_by_with_filter(index_hnsw, n, x, group_keys, n_groups, group_size, distances, labels, sel_all,
+                                    params, local_stats.data());
+    }
+
+    // record some statistics
+    faiss::HNSWStats total_stats;
+    for (idx_t i = 0; i < n; i++) {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        knowhere::knowhere_hnsw_search_hops.Observe(local_stats[i].nhops);
+#endif
+        total_stats.combine(local_stats[i]);
+        if (params != nullptr && params->query_stats != nullptr) {
+            params->query_stats[i].combine(local_stats[i]);
+        }
+    }
+    if (params != nullptr && params->hnsw_stats != nullptr) {
+        params->hnsw_stats->combine(total_stats);
+    }
+}
+
 void
 IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_in,
                                faiss::RangeSearchResult* __restrict result,
@@ -277,11 +611,25 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
     const faiss::HNSW& hnsw = index_hnsw->hnsw;
 
     float kAlpha = 0.0f;
+    size_t prefetch_depth = 0;
+    bool two_hop_expansion = false;
+    const faiss::cppcontrib::knowhere::CompressedHnswGraph* compressed_graph = nullptr;
+    const faiss::cppcontrib::knowhere::HnswSeedTable* seed_table = nullptr;
+    size_t early_stop_patience = 0;
+    float early_stop_gap = 0.0f;
+    const faiss::cppcontrib::knowhere::HnswPublishedGraph* published_graph = nullptr;
     if (params_in) {
         params = dynamic_cast<const SearchParametersHNSWWrapper*>(params_in);
         FAISS_THROW_IF_NOT_MSG(params, "params type invalid");
 
         kAlpha = params->kAlpha;
+        prefetch_depth = std::max(params->prefetch_depth, 0);
+        two_hop_expansion = params->two_hop_expansion;
+        compressed_graph = params->compressed_graph;
+        seed_table = params->seed_table;
+        early_stop_patience = std::max(params->early_stop_patience, 0);
+        early_stop_gap = params->early_stop_gap;
+        published_graph = params->published_graph;
     }
 
     // set up hnsw_stats
@@ -298,7 +646,7 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
         faiss::cppcontrib::knowhere::Bitset::create_uninitialized(index->ntotal);
 
     // create a distance computer
-    std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index_hnsw->storage));
+    std::unique_ptr<faiss::DistanceComputer> dis(storage_distance_computer(index_hnsw->storage, params));
 
     // radius
     float radius = radius_in;
@@ -347,8 +695,9 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewWithMappingIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph};
 
                 local_stats = searcher.range_search(radius, &res_min);
             } else {
@@ -360,8 +709,9 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewWithMappingIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph};
 
                 local_stats = searcher.range_search(radius, &res_min);
             }
@@ -380,8 +730,9 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph};
 
                 local_stats = searcher.range_search(radius, &res_min);
             } else {
@@ -393,8 +744,9 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
                                                                   faiss::cppcontrib::knowhere::Bitset,
                                                                   knowhere::BitsetViewIDSelector>;
 
-                searcher_type searcher{hnsw,           *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       *bw_idselector, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, *bw_idselector,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph};
 
                 local_stats = searcher.range_search(radius, &res_min);
             }
@@ -410,8 +762,9 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
                 using searcher_type = faiss::cppcontrib::knowhere::v2_hnsw_searcher<
                     faiss::DistanceComputer, DummyVisitor, faiss::cppcontrib::knowhere::Bitset, faiss::IDSelectorAll>;
 
-                searcher_type searcher{hnsw,    *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       sel_all, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, sel_all,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph};
 
                 local_stats = searcher.range_search(radius, &res_min);
             } else {
@@ -421,8 +774,9 @@ IndexHNSWWrapper::range_search(idx_t n, const float* __restrict x, float radius_
                 using searcher_type = faiss::cppcontrib::knowhere::v2_hnsw_searcher<
                     faiss::DistanceComputer, FederVisitor, faiss::cppcontrib::knowhere::Bitset, faiss::IDSelectorAll>;
 
-                searcher_type searcher{hnsw,    *(dis.get()), graph_visitor, bitset_visited_nodes,
-                                       sel_all, kAlpha,       params};
+                searcher_type searcher{hnsw,   *(dis.get()), graph_visitor,  bitset_visited_nodes, sel_all,
+                                       kAlpha, params,       prefetch_depth, two_hop_expansion, compressed_graph,
+                                       seed_table, early_stop_patience, early_stop_gap, published_graph};
 
                 local_stats = searcher.range_search(radius, &res_min);
             }
@@ -13,10 +13,16 @@
 
 #include <faiss/IndexHNSW.h>
 #include <faiss/cppcontrib/knowhere/IndexWrapper.h>
+#include <faiss/cppcontrib/knowhere/impl/CompressedHnswGraph.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswNeighborCodes.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswPublishedGraph.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswSeedTable.h>
 
 #include <cstddef>
 #include <cstdint>
 
+#include "knowhere/comp/group_by.h"
+#include "knowhere/operands.h"
 #include "knowhere/feder/HNSW.h"
 
 namespace knowhere {
@@ -25,10 +31,43 @@ namespace knowhere {
 struct SearchParametersHNSWWrapper : public faiss::SearchParametersHNSW {
     // Stats will be updated if the object pointer is provided.
     faiss::HNSWStats* hnsw_stats = nullptr;
+    // the stats of the i-th query are added to query_stats[i] if the pointer is provided
+    faiss::HNSWStats* query_stats = nullptr;
     // feder will be updated if the object pointer is provided.
     knowhere::feder::hnsw::FederResult* feder = nullptr;
     // filtering parameter
     float kAlpha = 1.0f;
+    // the number of neighbors to prefetch ahead during the graph expansion,
+    //   0 disables the pipelined expansion
+    int prefetch_depth = 0;
+    // the number of queries that traverse the graph together,
+    //   1 processes queries one by one
+    int query_batch_size = 1;
+    // whether filtered out nodes are expanded through their neighbors
+    //   instead of being evaluated, for highly selective filters
+    bool two_hop_expansion = false;
+    // compressed neighbor lists, if hnsw.neighbors were replaced with them.
+    //   the pointer is not owned.
+    const faiss::cppcontrib::knowhere::CompressedHnswGraph* compressed_graph = nullptr;
+    // additional level-0 entry points, if available.
+    //   the pointer is not owned.
+    const faiss::cppcontrib::knowhere::HnswSeedTable* seed_table = nullptr;
+    // stop the level-0 search after this many expansions in a row that did not
+    //   improve the k-th result by more than early_stop_gap (relative), 0 disables it
+    int early_stop_patience = 0;
+    float early_stop_gap = 0.0f;
+    // the visible part of a graph that is being extended concurrently,
+    //   nullptr if the whole graph is visible. the pointer is not owned.
+    const faiss::cppcontrib::knowhere::HnswPublishedGraph* published_graph = nullptr;
+    // the fast-scan codes of the level-0 neighbors of every node, if available.
+    //   used by search() only, the pointer is not owned.
+    const faiss::cppcontrib::knowhere::HnswNeighborCodes* neighbor_codes = nullptr;
+    // the number of bits to quantize a query with for RaBitQ storages,
+    //   -1 keeps the default of the storage
+    int rabitq_query_bits = -1;
+    // the type the queries were converted to fp32 from. fp16 and bf16 queries are scored in that type
+    //   by the SQ storages of codes of the same type.
+    DataFormatEnum query_data_format = DataFormatEnum::fp32;
 
     inline ~SearchParametersHNSWWrapper() {
     }
@@ -47,6 +86,12 @@ struct IndexHNSWWrapper : public faiss::cppcontrib::knowhere::IndexWrapper {
     search(faiss::idx_t n, const float* x, faiss::idx_t k, float* distances, faiss::idx_t* labels,
            const faiss::SearchParameters* params) const override;
 
+    /// entry point for group-by search, see GroupByCollector.
+    /// distances and labels get n_groups * group_size slots per query.
+    void
+    search_group_by(faiss::idx_t n, const float* x, const GroupKeys& group_keys, size_t n_groups, size_t group_size,
+                    float* distances, faiss::idx_t* labels, const faiss::SearchParameters* params) const;
+
     /// entry point for range search
     void
     range_search(faiss::idx_t n, const float* x, float radius, faiss::RangeSearchResult* result,
@@ -0,0 +1,109 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/IndexRefineOnDisk.h"
+
+#include <faiss/impl/AuxIndexStructures.h>
+#include <faiss/impl/FaissAssert.h>
+#include <faiss/utils/Heap.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "simd/hook.h"
+
+namespace knowhere {
+
+IndexRefineOnDisk::IndexRefineOnDisk(faiss::Index* base_index, faiss::IndexFlatCodes* refine_index,
+                                     const RefineCodesReader* reader, const float* inverse_l2_norms_in)
+    : faiss::IndexRefine(base_index, refine_index),
+      refine_codes_index{refine_index},
+      codes_reader{reader},
+      inverse_l2_norms{inverse_l2_norms_in} {
+}
+
+void
+IndexRefineOnDisk::refine_distances(const float* x, const faiss::idx_t* labels, size_t n, float* distances) const {
+    size_t n_valid = 0;
+    while (n_valid < n && labels[n_valid] >= 0) {
+        n_valid++;
+    }
+    std::vector<uint8_t> codes(n_valid * codes_reader->code_size());
+    codes_reader->Read(labels, n_valid, codes.data());
+
+    std::unique_ptr<faiss::FlatCodesDistanceComputer> dc(refine_codes_index->get_FlatCodesDistanceComputer());
+    dc->set_query(x);
+    float inverse_query_norm = 1.0f;
+    if (inverse_l2_norms != nullptr) {
+        const float query_l2norm = faiss::fvec_norm_L2sqr(x, d);
+        inverse_query_norm = (query_l2norm <= 0) ? 1.0f : (1.0f / sqrtf(query_l2norm));
+    }
+    for (size_t j = 0; j < n_valid; j++) {
+        float dis = dc->distance_to_code(codes.data() + j * codes_reader->code_size());
+        if (inverse_l2_norms != nullptr) {
+            dis *= inverse_l2_norms[labels[j]] * inverse_query_norm;
+        }
+        distances[j] = dis;
+    }
+}
+
+void
+IndexRefineOnDisk::search(faiss::idx_t n, const float* x, faiss::idx_t k, float* distances, faiss::idx_t* labels,
+                          const faiss::SearchParameters* params_in) const {
+    const faiss::IndexRefineSearchParameters* params = nullptr;
+    if (params_in) {
+        params = dynamic_cast<const faiss::IndexRefineSearchParameters*>(params_in);
+        FAISS_THROW_IF_NOT_MSG(params, "IndexRefine params have incorrect type");
+    }
+    const faiss::idx_t k_base = (params != nullptr) ? faiss::idx_t(k * params->k_factor) : faiss::idx_t(k * k_factor);
+    faiss::SearchParameters* base_index_params = (params != nullptr) ? params->base_index_params : nullptr;
+    FAISS_THROW_IF_NOT(k > 0 && k_base >= k);
+
+    std::vector<faiss::idx_t> base_labels(n * k_base);
+    std::vector<float> base_distances(n * k_base);
+    base_index->search(n, x, k_base, base_distances.data(), base_labels.data(), base_index_params);
+
+#pragma omp parallel for if (n > 1)
+    for (faiss::idx_t i = 0; i < n; i++) {
+        refine_distances(x + i * d, base_labels.data() + i * k_base, k_base, base_distances.data() + i * k_base);
+    }
+
+    if (metric_type == faiss::METRIC_L2) {
+        faiss::reorder_2_heaps<faiss::CMax<float, faiss::idx_t>>(n, k, labels, distances, k_base, base_labels.data(),
+                                                                 base_distances.data());
+    } else if (metric_type == faiss::METRIC_INNER_PRODUCT) {
+        faiss::reorder_2_heaps<faiss::CMin<float, faiss::idx_t>>(n, k, labels, distances, k_base, base_labels.data(),
+                                                                 base_distances.data());
+    } else {
+        FAISS_THROW_MSG("Metric type not supported");
+    }
+}
+
+void
+IndexRefineOnDisk::range_search(faiss::idx_t n, const float* x, float radius, faiss::RangeSearchResult* result,
+                                const faiss::SearchParameters* params_in) const {
+    const faiss::IndexRefineSearchParameters* params = nullptr;
+    if (params_in) {
+        params = dynamic_cast<const faiss::IndexRefineSearchParameters*>(params_in);
+        FAISS_THROW_IF_NOT_MSG(params, "IndexRefine params have incorrect type");
+    }
+    faiss::SearchParameters* base_index_params = (params != nullptr) ? params->base_index_params : nullptr;
+    base_index->range_search(n, x, radius, result, base_index_params);
+
+#pragma omp parallel for if (n > 1)
+    for (faiss::idx_t i = 0; i < n; i++) {
+        const size_t begin = result->lims[i];
+        refine_distances(x + i * d, result->labels + begin, result->lims[i + 1] - begin, result->distances + begin);
+    }
+}
+
+}  // namespace knowhere
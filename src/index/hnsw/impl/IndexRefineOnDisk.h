@@ -0,0 +1,47 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <faiss/IndexFlatCodes.h>
+#include <faiss/IndexRefine.h>
+
+#include "index/refine/refine_codes_reader.h"
+
+namespace knowhere {
+
+// a refine that reads the codes of the candidates of each query from the file of the index in one batch, rather than
+//   from the memory of refine_index, which keeps only its parameters
+struct IndexRefineOnDisk : faiss::IndexRefine {
+    // non-owning pointers
+    const faiss::IndexFlatCodes* refine_codes_index;
+    const RefineCodesReader* codes_reader;
+    // of the rows of a cosine index, nullptr otherwise
+    const float* inverse_l2_norms;
+
+    IndexRefineOnDisk(faiss::Index* base_index, faiss::IndexFlatCodes* refine_index, const RefineCodesReader* reader,
+                      const float* inverse_l2_norms_in);
+
+    void
+    search(faiss::idx_t n, const float* x, faiss::idx_t k, float* distances, faiss::idx_t* labels,
+           const faiss::SearchParameters* params = nullptr) const override;
+
+    void
+    range_search(faiss::idx_t n, const float* x, float radius, faiss::RangeSearchResult* result,
+                 const faiss::SearchParameters* params = nullptr) const override;
+
+ private:
+    // the refined distances from x to labels[0..n), up to the first negative label
+    void
+    refine_distances(const float* x, const faiss::idx_t* labels, size_t n, float* distances) const;
+};
+
+}  // namespace knowhere
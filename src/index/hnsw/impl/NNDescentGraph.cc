@@ -0,0 +1,233 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/hnsw/impl/NNDescentGraph.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <queue>
+
+#include "faiss/IndexFlat.h"
+#include "faiss/impl/FaissAssert.h"
+#include "faiss/impl/HNSW.h"
+#include "faiss/impl/NNDescent.h"
+#include "faiss/impl/NSG.h"
+#include "knowhere/tolower.h"
+#include "simd/hook.h"
+
+namespace knowhere {
+
+namespace {
+
+using NodeDistFarther = faiss::HNSW::NodeDistFarther;
+
+// the rows up to which the k-NN graph is computed exactly
+constexpr faiss::idx_t kExactKnnMaxRows = 4096;
+
+// the extra candidates of the NN-Descent pool, as for faiss::IndexNSG
+constexpr int kNNDescentExtraPool = 50;
+
+// the k nearest neighbors of every row of a storage, the row itself excluded and the missing ones set to -1
+std::vector<int>
+exact_knn_graph(const faiss::IndexFlat& storage, const int k) {
+    const faiss::idx_t n = storage.ntotal;
+    const faiss::idx_t k1 = std::min<faiss::idx_t>(k + 1, n);
+    std::vector<faiss::idx_t> labels(n * k1);
+    std::vector<float> distances(n * k1);
+    storage.search(n, storage.get_xb(), k1, distances.data(), labels.data());
+
+    std::vector<int> knn(n * k, -1);
+    for (faiss::idx_t i = 0; i < n; i++) {
+        int count = 0;
+        for (faiss::idx_t j = 0; j < k1 && count < k; j++) {
+            const faiss::idx_t id = labels[i * k1 + j];
+            if (id >= 0 && id != i) {
+                knn[i * k + count++] = id;
+            }
+        }
+    }
+    return knn;
+}
+
+// the k-NN graph of the rows of a storage, with -1 for the missing neighbors
+std::vector<int>
+knn_graph(const faiss::IndexFlat& storage, const int k, const int n_iter) {
+    const faiss::idx_t n = storage.ntotal;
+    if (n <= std::max<faiss::idx_t>(kExactKnnMaxRows, 2 * (k + kNNDescentExtraPool))) {
+        return exact_knn_graph(storage, k);
+    }
+
+    faiss::NNDescent nndescent(storage.d, k);
+    nndescent.L = k + kNNDescentExtraPool;
+    nndescent.iter = n_iter;
+    std::unique_ptr<faiss::DistanceComputer> dis(faiss::nsg::storage_distance_computer(&storage));
+    nndescent.build(*dis, n, false);
+    return std::move(nndescent.final_graph);
+}
+
+// the candidates of row i kept by the HNSW heuristic, at most max_degree of them
+std::vector<int>
+rng_prune(faiss::DistanceComputer& dis, const int i, const std::vector<int>& candidates, const int max_degree) {
+    std::priority_queue<NodeDistFarther> input;
+    for (const int c : candidates) {
+        input.emplace(dis.symmetric_dis(i, c), c);
+    }
+    std::vector<NodeDistFarther> output;
+    faiss::HNSW::shrink_neighbor_list(dis, input, output, max_degree);
+
+    std::vector<int> kept;
+    kept.reserve(output.size());
+    for (const auto& node : output) {
+        kept.push_back(node.id);
+    }
+    return kept;
+}
+
+// the k-NN lists pruned by the HNSW heuristic, then extended with their reverse links and pruned again, so that
+//   the rows that are the neighbors of no other row stay reachable
+std::vector<std::vector<int>>
+rng_graph(const faiss::IndexFlat& storage, const std::vector<int>& knn, const int k, const int max_degree) {
+    const faiss::idx_t n = storage.ntotal;
+    std::vector<std::vector<int>> lists(n);
+#pragma omp parallel
+    {
+        std::unique_ptr<faiss::DistanceComputer> dis(faiss::nsg::storage_distance_computer(&storage));
+        std::vector<int> candidates;
+#pragma omp for schedule(dynamic, 256)
+        for (faiss::idx_t i = 0; i < n; i++) {
+            candidates.clear();
+            for (int j = 0; j < k; j++) {
+                if (knn[i * k + j] >= 0) {
+                    candidates.push_back(knn[i * k + j]);
+                }
+            }
+            lists[i] = rng_prune(*dis, i, candidates, max_degree);
+        }
+    }
+
+    std::vector<std::vector<int>> reverse_lists(n);
+    for (faiss::idx_t i = 0; i < n; i++) {
+        for (const int j : lists[i]) {
+            reverse_lists[j].push_back(i);
+        }
+    }
+
+#pragma omp parallel
+    {
+        std::unique_ptr<faiss::DistanceComputer> dis(faiss::nsg::storage_distance_computer(&storage));
+        std::vector<int> candidates;
+#pragma omp for schedule(dynamic, 256)
+        for (faiss::idx_t i = 0; i < n; i++) {
+            candidates = lists[i];
+            candidates.insert(candidates.end(), reverse_lists[i].begin(), reverse_lists[i].end());
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            lists[i] = rng_prune(*dis, i, candidates, max_degree);
+        }
+    }
+    return lists;
+}
+
+// the row closest to the mean of all the rows
+faiss::idx_t
+medoid(const float* x, const faiss::idx_t n, const size_t d) {
+    std::vector<float> center(d, 0.0f);
+    for (faiss::idx_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < d; j++) {
+            center[j] += x[i * d + j];
+        }
+    }
+    for (auto& v : center) {
+        v /= n;
+    }
+
+    faiss::idx_t best = 0;
+    float best_dis = std::numeric_limits<float>::max();
+    for (faiss::idx_t i = 0; i < n; i++) {
+        const float dis = faiss::fvec_L2sqr(x + i * d, center.data(), d);
+        if (dis < best_dis) {
+            best_dis = dis;
+            best = i;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+std::optional<GraphPruningType>
+parse_graph_pruning_type(const std::string& name) {
+    const std::string name_tolower = str_to_lower(name);
+    if (name_tolower == "none") {
+        return GraphPruningType::NONE;
+    } else if (name_tolower == "nsg") {
+        return GraphPruningType::NSG;
+    } else if (name_tolower == "rng") {
+        return GraphPruningType::RNG;
+    }
+
+    return std::nullopt;
+}
+
+faiss::idx_t
+build_nndescent_graph(const float* x, const faiss::idx_t n, const size_t d, const faiss::MetricType metric, const int k,
+                      const int n_iter, const GraphPruningType pruning, const int max_degree,
+                      std::vector<uint32_t>& graph) {
+    FAISS_THROW_IF_NOT_MSG(n > 1, "a graph needs at least 2 rows");
+
+    faiss::IndexFlat storage(d, metric);
+    storage.add(n, x);
+    const auto knn = knn_graph(storage, k, n_iter);
+
+    if (pruning == GraphPruningType::NONE) {
+        graph.assign(n * k, static_cast<uint32_t>(n));
+        for (faiss::idx_t i = 0; i < n * k; i++) {
+            if (knn[i] >= 0) {
+                graph[i] = knn[i];
+            }
+        }
+        return medoid(x, n, d);
+    }
+
+    graph.assign(n * max_degree, static_cast<uint32_t>(n));
+    if (pruning == GraphPruningType::NSG) {
+        std::vector<faiss::idx_t> knn_idx(knn.begin(), knn.end());
+        // the pruning of NSG expects full k-NN lists
+        for (faiss::idx_t i = 0; i < n; i++) {
+            for (int j = 0; j < k; j++) {
+                if (knn_idx[i * k + j] < 0) {
+                    knn_idx[i * k + j] = knn_idx[i * k];
+                }
+            }
+        }
+        faiss::NSG nsg(max_degree);
+        nsg.build(&storage, n, faiss::nsg::Graph<faiss::idx_t>(knn_idx.data(), n, k), false);
+        for (faiss::idx_t i = 0; i < n; i++) {
+            for (int j = 0; j < max_degree; j++) {
+                const int id = nsg.final_graph->at(i, j);
+                if (id < 0) {
+                    break;
+                }
+                graph[i * max_degree + j] = id;
+            }
+        }
+        return nsg.enterpoint;
+    }
+
+    const auto lists = rng_graph(storage, knn, k, max_degree);
+    for (faiss::idx_t i = 0; i < n; i++) {
+        std::copy(lists[i].begin(), lists[i].end(), graph.begin() + i * max_degree);
+    }
+    return medoid(x, n, d);
+}
+
+}  // namespace knowhere
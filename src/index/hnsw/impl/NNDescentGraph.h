@@ -0,0 +1,47 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "faiss/Index.h"
+
+namespace knowhere {
+
+// The prunings of an NN-Descent k-NN graph.
+enum class GraphPruningType {
+    // keep the k nearest neighbors of every row
+    NONE,
+    // the Navigating Spreading-out Graph built over the k-NN graph
+    NSG,
+    // the relative neighborhood rule of the HNSW heuristic, applied to the k-NN lists and their reverse links
+    RNG,
+};
+
+// returns std::nullopt for an unknown name
+std::optional<GraphPruningType>
+parse_graph_pruning_type(const std::string& name);
+
+// Builds the k-NN graph of the n rows of x with NN-Descent, then prunes it. The neighbors of row i are written to
+//   [i * degree, (i + 1) * degree) of graph, degree being k without a pruning and max_degree otherwise, and the
+//   missing ones are set to n, as in meta::BASE_GRAPH. Returns the entry point of the graph.
+// NN-Descent samples too few candidates in small datasets, whose k-NN graph is computed exactly instead.
+// Throws faiss::FaissException.
+faiss::idx_t
+build_nndescent_graph(const float* x, const faiss::idx_t n, const size_t d, const faiss::MetricType metric, const int k,
+                      const int n_iter, const GraphPruningType pruning, const int max_degree,
+                      std::vector<uint32_t>& graph);
+
+}  // namespace knowhere
@@ -11,13 +11,37 @@
 
 #include "knowhere/index/index.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "fmt/format.h"
 #include "folly/futures/Future.h"
+#include "knowhere/comp/binary_compression.h"
+#include "knowhere/comp/emb_list.h"
+#include "knowhere/comp/group_by.h"
+#include "knowhere/comp/huge_pages.h"
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/numa.h"
+#include "knowhere/comp/query_dedup.h"
+#include "knowhere/comp/result_cache.h"
+#include "knowhere/comp/search_arena.h"
+#include "knowhere/comp/search_phases.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/comp/time_recorder.h"
+#include "knowhere/comp/trace_span.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
 #include "knowhere/log.h"
+#include "knowhere/sparse_utils.h"
+#include "knowhere/utils.h"
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
 #include "knowhere/prometheus_client.h"
@@ -36,6 +60,123 @@ LoadConfig(BaseConfig* cfg, const Json& json, knowhere::PARAM_TYPE param_type, c
     return Config::Load(*cfg, json_, param_type, msg);
 }
 
+// the binary Serialize() keeps the params of Calibrate() in
+constexpr const char* kCalibratedParamsBinary = "knowhere_calibrated_params";
+// the search params Calibrate() tunes, the first one the config of an index has
+constexpr std::array<const char*, 3> kCalibratedParams = {indexparam::NPROBE, indexparam::EF,
+                                                          indexparam::SEARCH_LIST_SIZE};
+// the binary Serialize() keeps the offsets of the embedding lists of the rows in
+constexpr const char* kEmbListOffsetsBinary = "knowhere_emb_list_offsets";
+constexpr int32_t kCalibrateMaxValue = 4096;
+constexpr int64_t kCalibrateSampleNq = 100;
+
+// json with the calibrated params it does not set, json itself if there are none
+inline const Json&
+WithCalibratedParams(const Json& json, const Json& calibrated, Json& merged) {
+    if (calibrated.empty()) {
+        return json;
+    }
+    merged = json;
+    for (const auto& [key, value] : calibrated.items()) {
+        if (!merged.contains(key)) {
+            merged[key] = value;
+        }
+    }
+    return merged;
+}
+
+// the share of the ids of the reference results that res also returns
+inline float
+ResultOverlap(const DataSet& res, const DataSet& reference) {
+    const int64_t nq = reference.GetRows(), k = reference.GetDim();
+    int64_t hits = 0, total = 0;
+    for (int64_t i = 0; i < nq; i++) {
+        std::unordered_set<int64_t> ids(res.GetIds() + i * k, res.GetIds() + (i + 1) * k);
+        for (int64_t j = 0; j < k; j++) {
+            const int64_t id = reference.GetIds()[i * k + j];
+            if (id != -1) {
+                hits += ids.count(id);
+                total++;
+            }
+        }
+    }
+    return total == 0 ? 1.0f : static_cast<float>(hits) / total;
+}
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+// the parent of the child spans of the stages of a call, only if the span of the call is sampled
+inline std::unique_ptr<TraceParent>
+MakeTraceParent(const std::shared_ptr<tracer::trace::Span>& span) {
+    if (span == nullptr || !span->GetContext().IsSampled()) {
+        return nullptr;
+    }
+    return std::make_unique<TraceParent>(span);
+}
+
+// the span of a load with a trace id in its config, nullptr without one
+inline std::shared_ptr<tracer::trace::Span>
+StartLoadSpan(const BaseConfig& cfg, const std::string& name) {
+    if (!cfg.trace_id.has_value() || !cfg.span_id.has_value()) {
+        return nullptr;
+    }
+    auto trace_id_str = tracer::GetIDFromHexStr(cfg.trace_id.value());
+    auto span_id_str = tracer::GetIDFromHexStr(cfg.span_id.value());
+    auto ctx = tracer::TraceContext{(uint8_t*)trace_id_str.c_str(), (uint8_t*)span_id_str.c_str(),
+                                    (uint8_t)cfg.trace_flags.value()};
+    return tracer::StartSpan(name, &ctx);
+}
+#endif
+
+// whether the search thread pool of the calling thread takes a search of `priority`, see ThreadPool::Admit()
+inline Status
+AdmitSearch(ThreadPool::TaskPriority priority) {
+    auto pool = ThreadPool::GetGlobalSearchThreadPool();
+    const auto status = pool->Admit(priority);
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    knowhere_search_pool_pending_tasks.Set(pool->GetPendingTaskCount());
+    knowhere_search_pool_queue_wait.Set(pool->GetQueueWait().count() * 0.001);
+    if (status != Status::success) {
+        knowhere_search_rejected.Increment();
+    }
+#endif
+    return status;
+}
+
+// once the rows of an index changed, clears its result cache, see Index::EnableResultCache(), and updates the gauges
+//   of its memory
+class ScopedIndexChange {
+ public:
+    explicit ScopedIndexChange(IndexNode& node) : node_(node) {
+    }
+
+    ~ScopedIndexChange() {
+        if (auto cache = node_.ResultCache(); cache != nullptr) {
+            cache->Clear();
+        }
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        node_.PublishMemoryUsage();
+#endif
+    }
+
+ private:
+    IndexNode& node_;
+};
+
+// the result of a search run with `cancellation`. The search may also be complete if the token fired after it, it is
+// treated as stopped all the same.
+inline expected<DataSetPtr>
+CheckCancellation(expected<DataSetPtr>&& res, const CancellationToken* cancellation, bool partial_results) {
+    if (cancellation == nullptr || !res.has_value() || !cancellation->IsCancelled()) {
+        return std::move(res);
+    }
+    if (partial_results) {
+        res.value()->Set(meta::PARTIAL_RESULTS, true);
+        return std::move(res);
+    }
+    const auto status = cancellation->IsTimeout() ? Status::timeout : Status::cancelled;
+    return expected<DataSetPtr>::Err(status, "search stopped: " + Status2String(status));
+}
+
 #ifdef KNOWHERE_WITH_CARDINAL
 template <typename T>
 inline const std::shared_ptr<Interrupt>
@@ -75,6 +216,12 @@ inline Status
 Index<T>::Build(const DataSetPtr dataset, const Json& json, bool use_knowhere_build_pool) {
     auto cfg = this->node->CreateConfig();
     RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "Build"));
+    ScopedIndexChange change(*this->node);
+    const auto emb_list_offsets = dataset->Get<std::shared_ptr<const EmbListOffsets>>(meta::EMB_LIST_OFFSET);
+    if (emb_list_offsets != nullptr && !IsValidEmbListOffsets(*emb_list_offsets, dataset->GetRows())) {
+        LOG_KNOWHERE_ERROR_ << "invalid embedding list offsets of the rows";
+        return Status::invalid_args;
+    }
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     TimeRecorder rc("Build index", 2);
@@ -85,9 +232,20 @@ Index<T>::Build(const DataSetPtr dataset, const Json& json, bool use_knowhere_bu
 #else
     auto res = this->node->Build(dataset, std::move(cfg), use_knowhere_build_pool);
 #endif
+    if (res == Status::success) {
+        this->node->SetEmbListOffsets(emb_list_offsets);
+    }
     return res;
 }
 
+template <typename T>
+inline Status
+Index<T>::EnableResultCache(size_t capacity_bytes, DataFormatEnum data_format) {
+    this->node->SetResultCache(capacity_bytes == 0 ? nullptr
+                                                   : std::make_shared<SearchResultCache>(capacity_bytes, data_format));
+    return Status::success;
+}
+
 template <typename T>
 inline Status
 Index<T>::Train(const DataSetPtr dataset, const Json& json, bool use_knowhere_build_pool) {
@@ -103,18 +261,435 @@ Index<T>::Add(const DataSetPtr dataset, const Json& json, bool use_knowhere_buil
     auto cfg = this->node->CreateConfig();
     std::string msg;
     RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "Add", &msg));
+    ScopedIndexChange change(*this->node);
     return this->node->Add(dataset, std::move(cfg), use_knowhere_build_pool);
 }
 
+template <typename T>
+inline Status
+Index<T>::Merge(const std::vector<Index<T>>& others, const Json& json) {
+    auto cfg = this->node->CreateConfig();
+    std::string msg;
+    RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "Merge", &msg));
+
+    std::vector<const IndexNode*> other_nodes;
+    for (const auto& other : others) {
+        if (other.Node() == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "can not merge an empty index";
+            return Status::empty_index;
+        }
+        other_nodes.push_back(other.Node());
+    }
+
+    ScopedIndexChange change(*this->node);
+    return this->node->Merge(other_nodes, std::move(cfg));
+}
+
+namespace {
+
+// the rows of pieces, read from source, in one dataset. Sparse rows are views of the ones of the pieces, which must
+//   outlive it
+DataSetPtr
+ConcatRows(const DataSource& source, const std::vector<DataSetPtr>& pieces) {
+    int64_t rows = 0;
+    for (const auto& piece : pieces) {
+        rows += piece->GetRows();
+    }
+    auto dataset = std::make_shared<DataSet>();
+    dataset->SetRows(rows);
+    dataset->SetDim(source.Dim());
+    if (source.IsSparse()) {
+        auto data = new sparse::SparseRow<float>[rows];
+        int64_t i = 0;
+        for (const auto& piece : pieces) {
+            const auto* piece_rows = static_cast<const sparse::SparseRow<float>*>(piece->GetTensor());
+            for (int64_t j = 0; j < piece->GetRows(); ++j, ++i) {
+                auto row_data = static_cast<uint8_t*>(const_cast<void*>(piece_rows[j].data()));
+                data[i] = sparse::SparseRow<float>(piece_rows[j].size(), row_data, /*own_data=*/false);
+            }
+        }
+        dataset->SetIsSparse(true);
+        dataset->SetTensor(data);
+    } else {
+        const int64_t row_bytes = source.RowBytes();
+        auto data = new char[rows * row_bytes];
+        int64_t offset = 0;
+        for (const auto& piece : pieces) {
+            std::memcpy(data + offset, piece->GetTensor(), piece->GetRows() * row_bytes);
+            offset += piece->GetRows() * row_bytes;
+        }
+        dataset->SetTensor(data);
+    }
+    dataset->SetIsOwner(true);
+    return dataset;
+}
+
+// reads the rows [begin, end) of source chunk by chunk into pieces
+Status
+ReadPieces(const DataSource& source, int64_t begin, int64_t end, std::vector<DataSetPtr>& pieces) {
+    const int64_t chunk_rows = std::max<int64_t>(source.ChunkRows(), 1);
+    for (int64_t i = begin; i < end; i += chunk_rows) {
+        auto piece = source.Read(i, std::min(chunk_rows, end - i));
+        if (!piece.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "failed to read the rows from " << i << " of a data source: " << piece.what();
+            return piece.error();
+        }
+        pieces.push_back(piece.value());
+    }
+    return Status::success;
+}
+
+}  // namespace
+
+template <typename T>
+inline Status
+Index<T>::BuildFromSource(const DataSource& source, const Json& json, int64_t max_train_rows) {
+    auto cfg = this->node->CreateConfig();
+    RETURN_IF_ERROR(LoadConfig(cfg.get(), json, knowhere::TRAIN, "BuildFromSource"));
+    ScopedIndexChange change(*this->node);
+    std::shared_ptr<Config> shared_cfg = std::move(cfg);
+    const int64_t rows = source.Rows();
+    if (rows <= 0 || max_train_rows <= 0) {
+        LOG_KNOWHERE_ERROR_ << "can not build an index from " << rows << " rows trained on " << max_train_rows;
+        return Status::invalid_args;
+    }
+
+    if (!this->node->IsIncrementalAddSupported()) {
+        std::vector<DataSetPtr> pieces;
+        RETURN_IF_ERROR(ReadPieces(source, 0, rows, pieces));
+        return this->node->Build(pieces.size() == 1 ? pieces[0] : ConcatRows(source, pieces), shared_cfg);
+    }
+
+    // the sample is made of runs of rows evenly spread over the source, at most a chunk each
+    const int64_t chunk_rows = std::max<int64_t>(source.ChunkRows(), 1);
+    const int64_t train_rows = std::min(rows, max_train_rows);
+    const int64_t n_runs = (train_rows + chunk_rows - 1) / chunk_rows;
+    const int64_t run_rows = (train_rows + n_runs - 1) / n_runs;
+    {
+        std::vector<DataSetPtr> pieces;
+        for (int64_t i = 0; i < n_runs; ++i) {
+            const int64_t begin = i * rows / n_runs;
+            const int64_t end = std::min(begin + run_rows, (i + 1) * rows / n_runs);
+            RETURN_IF_ERROR(ReadPieces(source, begin, end, pieces));
+        }
+        auto sample = pieces.size() == 1 ? pieces[0] : ConcatRows(source, pieces);
+        RETURN_IF_ERROR(this->node->Train(sample, shared_cfg));
+    }
+
+    // the next chunk is read while the current one is added
+    auto read = [&source, rows, chunk_rows](int64_t begin) {
+        return source.Read(begin, std::min(chunk_rows, rows - begin));
+    };
+    auto next = std::async(std::launch::async, read, 0);
+    for (int64_t begin = 0; begin < rows; begin += chunk_rows) {
+        auto chunk = next.get();
+        if (!chunk.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "failed to read the rows from " << begin << " of a data source: " << chunk.what();
+            return chunk.error();
+        }
+        if (begin + chunk_rows < rows) {
+            next = std::async(std::launch::async, read, begin + chunk_rows);
+        }
+        // a pending read is waited for by the destructor of its future
+        RETURN_IF_ERROR(this->node->Add(chunk.value(), shared_cfg));
+    }
+    return Status::success;
+}
+
+namespace {
+
+// the scores of a candidate of a hybrid search
+struct HybridCandidate {
+    float dense = 0.0f;
+    float sparse = 0.0f;
+    bool has_dense = false;
+    bool has_sparse = false;
+};
+
+// query q of a dataset of fp32 or sparse rows, as a dataset of its own that views its row
+DataSetPtr
+QueryOfDataSet(const DataSetPtr& dataset, int64_t q) {
+    DataSetPtr query;
+    if (dataset->GetIsSparse()) {
+        const auto* rows = static_cast<const sparse::SparseRow<float>*>(dataset->GetTensor());
+        query = GenDataSet(1, dataset->GetDim(), rows + q);
+        query->SetIsSparse(true);
+    } else {
+        const auto* rows = static_cast<const float*>(dataset->GetTensor());
+        query = GenDataSet(1, dataset->GetDim(), rows + q * dataset->GetDim());
+    }
+    return query;
+}
+
+}  // namespace
+
 template <typename T>
 inline expected<DataSetPtr>
-Index<T>::Search(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_) const {
+Index<T>::HybridSearch(const Index<T>& dense, const DataSetPtr dense_queries, const Json& dense_json,
+                       const Index<T>& sparse, const DataSetPtr sparse_queries, const Json& sparse_json,
+                       const BitsetView& bitset, const HybridSearchOptions& options) {
+    const int64_t nq = dense_queries->GetRows();
+    const int64_t k = options.k;
+    if (sparse_queries->GetRows() != nq || k <= 0 || options.dense_weight < 0 || options.sparse_weight < 0 ||
+        options.candidates_ratio < 1.0f || dense.Count() != sparse.Count()) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "invalid hybrid search of " + std::to_string(nq) +
+                                                                   " queries on " + std::to_string(dense.Count()) +
+                                                                   " and " + std::to_string(sparse.Count()) + " rows");
+    }
+    for (const Json* json : {&dense_json, &sparse_json}) {
+        const std::string metric = json->value(meta::METRIC_TYPE, "");
+        if (!IsMetricType(metric, metric::IP) && !IsMetricType(metric, metric::COSINE) &&
+            !IsMetricType(metric, metric::BM25)) {
+            return expected<DataSetPtr>::Err(Status::invalid_metric_type,
+                                             "a hybrid search fuses similarities, not " + metric);
+        }
+    }
+
+    const int64_t candidates_k = std::max<int64_t>(k, std::ceil(k * options.candidates_ratio));
+    Json dense_cfg(dense_json), sparse_cfg(sparse_json);
+    dense_cfg[meta::TOPK] = candidates_k;
+    sparse_cfg[meta::TOPK] = candidates_k;
+
+    // both candidate generators run at once
+    auto dense_future =
+        std::async(std::launch::async, [&]() { return dense.Search(dense_queries, dense_cfg, bitset); });
+    auto sparse_res = sparse.Search(sparse_queries, sparse_cfg, bitset);
+    auto dense_res = dense_future.get();
+    if (!dense_res.has_value()) {
+        return dense_res;
+    }
+    if (!sparse_res.has_value()) {
+        return sparse_res;
+    }
+
+    auto ids = std::make_unique<int64_t[]>(nq * k);
+    auto distances = std::make_unique<float[]>(nq * k);
+    std::fill(ids.get(), ids.get() + nq * k, -1);
+    std::fill(distances.get(), distances.get() + nq * k, -std::numeric_limits<float>::infinity());
+    const float wd = options.dense_weight, ws = options.sparse_weight;
+
+    for (int64_t q = 0; q < nq; q++) {
+        std::unordered_map<int64_t, HybridCandidate> candidates;
+        // the score of the last candidate of a full list bounds the scores of the rows that are not in it
+        float dense_bound = -std::numeric_limits<float>::infinity();
+        float sparse_bound = -std::numeric_limits<float>::infinity();
+        auto collect = [&](const DataSet& res, bool is_dense, float& bound) {
+            for (int64_t i = 0; i < candidates_k; i++) {
+                const int64_t id = res.GetIds()[q * candidates_k + i];
+                if (id < 0) {
+                    return;
+                }
+                const float score = res.GetDistance()[q * candidates_k + i];
+                auto& candidate = candidates[id];
+                (is_dense ? candidate.dense : candidate.sparse) = score;
+                (is_dense ? candidate.has_dense : candidate.has_sparse) = true;
+                bound = score;
+            }
+        };
+        collect(*dense_res.value(), true, dense_bound);
+        collect(*sparse_res.value(), false, sparse_bound);
+
+        // the k-th best fused score of the candidates both indexes return is a lower bound of the k-th result
+        std::vector<float> exact;
+        for (const auto& [id, candidate] : candidates) {
+            if (candidate.has_dense && candidate.has_sparse) {
+                exact.push_back(wd * candidate.dense + ws * candidate.sparse);
+            }
+        }
+        float threshold = -std::numeric_limits<float>::infinity();
+        if (static_cast<int64_t>(exact.size()) >= k) {
+            std::nth_element(exact.begin(), exact.begin() + k - 1, exact.end(), std::greater<float>());
+            threshold = exact[k - 1];
+        }
+
+        // the candidates whose missing score may still bring them above the threshold
+        std::vector<int64_t> missing_dense, missing_sparse;
+        for (const auto& [id, candidate] : candidates) {
+            if (!candidate.has_dense && ws * candidate.sparse + wd * std::max(dense_bound, 0.0f) > threshold) {
+                missing_dense.push_back(id);
+            }
+            if (!candidate.has_sparse && wd * candidate.dense + ws * std::max(sparse_bound, 0.0f) > threshold) {
+                missing_sparse.push_back(id);
+            }
+        }
+        auto score_missing = [&](const Index<T>& index, const DataSetPtr& queries, const Json& json,
+                                 std::vector<int64_t>& missing, bool is_dense) -> Status {
+            if (missing.empty()) {
+                return Status::success;
+            }
+            std::sort(missing.begin(), missing.end());
+            Json cfg(json);
+            cfg[meta::TOPK] = missing.size();
+            auto res = index.Search(QueryOfDataSet(queries, q), cfg,
+                                    BitsetView::FromValidIds(missing.data(), missing.size(), index.Count()));
+            if (!res.has_value()) {
+                return res.error();
+            }
+            for (size_t i = 0; i < missing.size(); i++) {
+                const int64_t id = res.value()->GetIds()[i];
+                if (id < 0) {
+                    break;
+                }
+                // the candidates are only looked up here, the dense and the sparse scores are set concurrently
+                auto& candidate = candidates.at(id);
+                (is_dense ? candidate.dense : candidate.sparse) = res.value()->GetDistance()[i];
+                (is_dense ? candidate.has_dense : candidate.has_sparse) = true;
+            }
+            return Status::success;
+        };
+        auto dense_missing = std::async(std::launch::async, [&]() {
+            return score_missing(dense, dense_queries, dense_json, missing_dense, true);
+        });
+        const auto sparse_status = score_missing(sparse, sparse_queries, sparse_json, missing_sparse, false);
+        const auto dense_status = dense_missing.get();
+        if (dense_status != Status::success || sparse_status != Status::success) {
+            return expected<DataSetPtr>::Err(dense_status != Status::success ? dense_status : sparse_status,
+                                             "failed to score the candidates of a hybrid search");
+        }
+
+        // a candidate the other index still does not return shares nothing with the query there
+        std::vector<std::pair<float, int64_t>> fused;
+        fused.reserve(candidates.size());
+        for (const auto& [id, candidate] : candidates) {
+            fused.emplace_back(wd * candidate.dense + ws * candidate.sparse, id);
+        }
+        const size_t n_res = std::min<size_t>(k, fused.size());
+        std::partial_sort(fused.begin(), fused.begin() + n_res, fused.end(),
+                          [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = 0; i < n_res; i++) {
+            distances[q * k + i] = fused[i].first;
+            ids[q * k + i] = fused[i].second;
+        }
+    }
+
+    return GenResultDataSet(nq, k, std::move(ids), std::move(distances));
+}
+
+template <typename T>
+inline Status
+Index<T>::DeleteByIds(const DataSetPtr dataset) {
+    ScopedIndexChange change(*this->node);
+    return this->node->DeleteByIds(dataset);
+}
+
+template <typename T>
+inline expected<DataSetPtr>
+Index<T>::Search(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_,
+                 std::shared_ptr<CancellationToken> cancellation) const {
+    return SearchImpl(dataset, json, bitset_, nullptr, nullptr, std::move(cancellation));
+}
+
+template <typename T>
+inline std::vector<expected<DataSetPtr>>
+Index<T>::SearchSegments(const std::vector<Index<T>>& segments, const DataSetPtr dataset, const Json& json,
+                         const std::vector<BitsetView>& bitsets) {
+    std::vector<expected<DataSetPtr>> results;
+    results.reserve(segments.size());
+    if (bitsets.size() != segments.size()) {
+        for (size_t i = 0; i < segments.size(); i++) {
+            results.push_back(expected<DataSetPtr>::Err(Status::invalid_args, "a bitset per segment is expected"));
+        }
+        return results;
+    }
+
+    std::vector<const void*> quantizers(segments.size(), nullptr);
+    std::unordered_map<const void*, size_t> num_sharing;
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (segments[i].node != nullptr) {
+            quantizers[i] = segments[i].node->SharedCoarseQuantizer();
+        }
+        if (quantizers[i] != nullptr) {
+            num_sharing[quantizers[i]]++;
+        }
+    }
+    // the queries with the probes of their quantizer, computed on the first segment that shares it. The segments
+    //   whose coarse search fails, or whose search needs other probes, search the quantizer themselves.
+    std::unordered_map<const void*, DataSetPtr> queries_with_probes;
+    for (size_t i = 0; i < segments.size(); i++) {
+        DataSetPtr queries = dataset;
+        if (quantizers[i] != nullptr && num_sharing[quantizers[i]] > 1) {
+            auto it = queries_with_probes.find(quantizers[i]);
+            if (it == queries_with_probes.end()) {
+                DataSetPtr with_probes = nullptr;
+                auto cfg = segments[i].node->CreateConfig();
+                std::string msg;
+                Json merged;
+                if (LoadConfig(cfg.get(), WithCalibratedParams(json, segments[i].node->CalibratedParams(), merged),
+                               knowhere::SEARCH, "SearchSegments", &msg) == Status::success) {
+                    auto probes = segments[i].node->CoarseSearch(dataset, std::move(cfg));
+                    if (probes.has_value()) {
+                        with_probes = GenDataSet(dataset->GetRows(), dataset->GetDim(), dataset->GetTensor());
+                        with_probes->Set(meta::COARSE_PROBES, probes.value());
+                    }
+                }
+                it = queries_with_probes.emplace(quantizers[i], with_probes).first;
+            }
+            if (it->second != nullptr) {
+                queries = it->second;
+            }
+        }
+        results.push_back(segments[i].Search(queries, json, bitsets[i]));
+    }
+    return results;
+}
+
+template <typename T>
+inline expected<DataSetPtr>
+Index<T>::SearchWithBuf(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_, int64_t* ids,
+                        float* dis, std::shared_ptr<CancellationToken> cancellation) const {
+    if (ids == nullptr || dis == nullptr) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "the result buffers of SearchWithBuf are null");
+    }
+    return SearchImpl(dataset, json, bitset_, ids, dis, std::move(cancellation));
+}
+
+template <typename T>
+inline expected<DataSetPtr>
+Index<T>::SearchImpl(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_, int64_t* ids, float* dis,
+                     std::shared_ptr<CancellationToken> cancellation) const {
     auto cfg = this->node->CreateConfig();
     std::string msg;
-    const Status load_status = LoadConfig(cfg.get(), json, knowhere::SEARCH, "Search", &msg);
+    Json merged;
+    const Status load_status = LoadConfig(cfg.get(), WithCalibratedParams(json, this->node->CalibratedParams(), merged),
+                                          knowhere::SEARCH, "Search", &msg);
     if (load_status != Status::success) {
         return expected<DataSetPtr>::Err(load_status, msg);
     }
+    return SearchLoaded(dataset, std::move(cfg), bitset_, ids, dis, std::move(cancellation));
+}
+
+template <typename T>
+inline expected<DataSetPtr>
+Index<T>::Search(const DataSetPtr dataset, const CompiledSearchConfig& config, const BitsetView& bitset_,
+                 std::shared_ptr<CancellationToken> cancellation) const {
+    if (config.cfg_ == nullptr || config.IndexType() != this->Type()) {
+        return expected<DataSetPtr>::Err(Status::invalid_args, "the search config is compiled for " +
+                                                                   config.IndexType() + ", not " + this->Type());
+    }
+    auto cfg = this->node->CreateConfig();
+    Config::CopyValues(*config.cfg_, *cfg);
+    return SearchLoaded(dataset, std::move(cfg), bitset_, nullptr, nullptr, std::move(cancellation));
+}
+
+template <typename T>
+inline expected<CompiledSearchConfig>
+Index<T>::CompileSearchConfig(const Json& json) const {
+    auto cfg = this->node->CreateConfig();
+    std::string msg;
+    Json merged;
+    const Status status = LoadConfig(cfg.get(), WithCalibratedParams(json, this->node->CalibratedParams(), merged),
+                                     knowhere::SEARCH, "CompileSearchConfig", &msg);
+    if (status != Status::success) {
+        return expected<CompiledSearchConfig>::Err(status, msg);
+    }
+    return CompiledSearchConfig(this->Type(), std::shared_ptr<const BaseConfig>(std::move(cfg)));
+}
+
+template <typename T>
+inline expected<DataSetPtr>
+Index<T>::SearchLoaded(const DataSetPtr dataset, std::unique_ptr<BaseConfig> cfg, const BitsetView& bitset_,
+                       int64_t* ids, float* dis, std::shared_ptr<CancellationToken> cancellation) const {
+    std::string msg;
     // when index is immutable, bitset size should always equal to data count in index
     // when index is mutable, it could happen that data count larger than bitset size, see
     // https://github.com/zilliztech/knowhere/issues/70
@@ -126,7 +701,93 @@ Index<T>::Search(const DataSetPtr dataset, const Json& json, const BitsetView& b
         return expected<DataSetPtr>::Err(Status::invalid_args, msg);
     }
 
-    const auto bitset = BitsetView(bitset_.data(), bitset_.size(), bitset_.get_filtered_out_num_());
+    const auto bitset = bitset_.with_filtered_out_num();
+    const auto priority_class = (size_t)dataset->GetRows() >= ThreadPool::GetBatchSearchNq()
+                                    ? ThreadPool::TaskPriority::BATCH
+                                    : ThreadPool::TaskPriority::INTERACTIVE;
+    ThreadPool::ScopedTaskPriority priority(priority_class);
+    ThreadPool::ScopedNumaNode numa_node(this->node->NumaNode());
+    if (AdmitSearch(priority_class) != Status::success) {
+        return expected<DataSetPtr>::Err(Status::overloaded, "search rejected, the search thread pool is overloaded");
+    }
+    ScopedCancellation scoped_cancellation(cancellation.get());
+    // the scratch memory the search allocates on the calling thread
+    ScopedSearchArena scoped_arena;
+    const bool partial_results = cfg->partial_results.value_or(false);
+    // queries made of embedding lists are scored against the lists of the rows
+    const bool emb_list_search = dataset->Get<std::shared_ptr<const EmbListOffsets>>(meta::EMB_LIST_OFFSET) != nullptr;
+    if (emb_list_search && ids != nullptr) {
+        return expected<DataSetPtr>::Err(Status::not_implemented, "embedding lists can not be searched into buffers");
+    }
+    // queries with the group keys of the rows return the best rows of the best groups
+    const auto group_keys = dataset->Get<std::shared_ptr<const GroupKeys>>(meta::GROUP_BY_KEYS);
+    if (group_keys != nullptr) {
+        if (emb_list_search || ids != nullptr) {
+            return expected<DataSetPtr>::Err(Status::not_implemented,
+                                             "a group-by search searches neither embedding lists nor into buffers");
+        }
+        if (static_cast<int64_t>(group_keys->size()) < this->node->Count()) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "a row of the index has no group key");
+        }
+    }
+    // the same queries searched with the same config and filter are served from the result cache
+    auto result_cache = this->node->ResultCache();
+    const bool cacheable = result_cache != nullptr && ids == nullptr && !emb_list_search && group_keys == nullptr &&
+                           !dataset->GetIsSparse() && dataset->GetTensor() != nullptr &&
+                           (bitset.empty() || cfg->bitset_version.has_value()) && !cfg->search_stats.value() &&
+                           !cfg->trace_visit.value();
+    SearchResultCache::Key cache_key{};
+    size_t query_bytes = 0;
+    uint64_t cache_generation = 0;
+    if (cacheable) {
+        cache_key = SearchResultCache::Key{
+            Config::Fingerprint(*cfg),
+            bitset.empty() ? std::numeric_limits<int64_t>::min() : cfg->bitset_version.value(), dataset->GetRows(),
+            cfg->k.value()};
+        query_bytes = result_cache->QueryBytes(dataset->GetRows(), dataset->GetDim());
+        cache_generation = result_cache->Generation();
+        auto cached = result_cache->Get(cache_key, dataset->GetTensor(), query_bytes);
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        if (cached != nullptr) {
+            knowhere_search_cache_hits.Increment();
+        } else {
+            knowhere_search_cache_misses.Increment();
+        }
+#endif
+        if (cached != nullptr) {
+            return cached;
+        }
+    }
+    // the duplicate queries of a batch are searched once, and their results fanned out
+    QueryDedup dedup;
+    DataSetPtr queries = dataset;
+    if (cfg->query_dedup_tolerance.has_value() && dataset->GetRows() > 1 && ids == nullptr && !emb_list_search &&
+        !dataset->GetIsSparse() && dataset->GetTensor() != nullptr && !cfg->search_stats.value() &&
+        dataset->Get<std::shared_ptr<const CoarseProbes>>(meta::COARSE_PROBES) == nullptr) {
+        dedup = DedupQueries(*dataset, this->node->DataFormat(), cfg->query_dedup_tolerance.value());
+        if (dedup.Collapsed()) {
+            queries = RepresentativeQueries(*dataset, this->node->DataFormat(), dedup);
+            if (group_keys != nullptr) {
+                queries->Set(meta::GROUP_BY_KEYS, group_keys);
+            }
+        }
+    }
+    auto run_search = [&]() -> expected<DataSetPtr> {
+        auto res = [&]() {
+            if (emb_list_search) {
+                return SearchEmbList(*this->node, queries, std::move(cfg), bitset);
+            }
+            if (group_keys != nullptr) {
+                return this->node->GroupBySearch(queries, std::move(cfg), bitset);
+            }
+            return ids != nullptr ? this->node->SearchWithBuf(queries, std::move(cfg), bitset, ids, dis)
+                                  : this->node->Search(queries, std::move(cfg), bitset);
+        }();
+        if (!dedup.Collapsed() || !res.has_value()) {
+            return res;
+        }
+        return FanOutResults(*res.value(), dedup);
+    };
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     const BaseConfig& b_cfg = static_cast<const BaseConfig&>(*cfg);
@@ -145,15 +806,22 @@ Index<T>::Search(const DataSetPtr dataset, const Json& json, const BitsetView& b
         span->SetAttribute(meta::NQ, dataset->GetRows());
     }
     // LCOV_EXCL_STOP
+    auto trace_parent = MakeTraceParent(span);
+    ScopedTraceParent scoped_trace(trace_parent.get());
 
     TimeRecorder rc("Search");
     bool has_trace_id = b_cfg.trace_id.has_value();
     auto k = cfg->k.value();
-    auto res = this->node->Search(dataset, std::move(cfg), bitset);
+    SearchPhaseRecorder phases;
+    ScopedSearchPhaseRecorder scoped_phases(&phases);
+    auto res = run_search();
     auto time = rc.ElapseFromBegin("done");
     time *= 0.001;  // convert to ms
     knowhere_search_latency.Observe(time);
     knowhere_search_topk.Observe(k);
+    if (res.has_value()) {
+        phases.Observe(this->node->Type());
+    }
 
     // LCOV_EXCL_START
     if (has_trace_id) {
@@ -161,15 +829,20 @@ Index<T>::Search(const DataSetPtr dataset, const Json& json, const BitsetView& b
     }
     // LCOV_EXCL_STOP
 #else
-    auto res = this->node->Search(dataset, std::move(cfg), bitset);
+    auto res = run_search();
 #endif
-    return res;
+    const bool stopped = cancellation != nullptr && cancellation->IsCancelled();
+    auto checked = CheckCancellation(std::move(res), cancellation.get(), partial_results);
+    if (cacheable && !stopped && checked.has_value()) {
+        result_cache->Put(cache_key, dataset->GetTensor(), query_bytes, *checked.value(), cache_generation);
+    }
+    return checked;
 }
 
 template <typename T>
 inline expected<std::vector<std::shared_ptr<IndexNode::iterator>>>
 Index<T>::AnnIterator(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_,
-                      bool use_knowhere_search_pool) const {
+                      bool use_knowhere_search_pool, std::shared_ptr<CancellationToken> cancellation) const {
     auto cfg = this->node->CreateConfig();
     std::string msg;
     Status status = LoadConfig(cfg.get(), json, knowhere::ITERATOR, "Iterator", &msg);
@@ -187,7 +860,14 @@ Index<T>::AnnIterator(const DataSetPtr dataset, const Json& json, const BitsetVi
         return expected<std::vector<std::shared_ptr<IndexNode::iterator>>>::Err(Status::invalid_args, msg);
     }
 
-    const auto bitset = BitsetView(bitset_.data(), bitset_.size(), bitset_.get_filtered_out_num_());
+    const auto bitset = bitset_.with_filtered_out_num();
+    ThreadPool::ScopedTaskPriority priority(ThreadPool::TaskPriority::ITERATOR);
+    ThreadPool::ScopedNumaNode numa_node(this->node->NumaNode());
+    if (use_knowhere_search_pool && AdmitSearch(ThreadPool::TaskPriority::ITERATOR) != Status::success) {
+        return expected<std::vector<std::shared_ptr<IndexNode::iterator>>>::Err(
+            Status::overloaded, "iterator rejected, the search thread pool is overloaded");
+    }
+    ScopedCancellation scoped_cancellation(cancellation.get());
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     // note that this time includes only the initial search phase of iterator.
@@ -199,12 +879,18 @@ Index<T>::AnnIterator(const DataSetPtr dataset, const Json& json, const BitsetVi
 #else
     auto res = this->node->AnnIterator(dataset, std::move(cfg), bitset, use_knowhere_search_pool);
 #endif
+    if (cancellation != nullptr && res.has_value() && cancellation->IsCancelled()) {
+        const auto status = cancellation->IsTimeout() ? Status::timeout : Status::cancelled;
+        return expected<std::vector<std::shared_ptr<IndexNode::iterator>>>::Err(
+            status, "iterator search stopped: " + Status2String(status));
+    }
     return res;
 }
 
 template <typename T>
 inline expected<DataSetPtr>
-Index<T>::RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_) const {
+Index<T>::RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetView& bitset_,
+                      std::shared_ptr<CancellationToken> cancellation) const {
     auto cfg = this->node->CreateConfig();
     std::string msg;
     auto status = LoadConfig(cfg.get(), json, knowhere::RANGE_SEARCH, "RangeSearch", &msg);
@@ -222,7 +908,19 @@ Index<T>::RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetVi
         return expected<DataSetPtr>::Err(Status::invalid_args, msg);
     }
 
-    const auto bitset = BitsetView(bitset_.data(), bitset_.size(), bitset_.get_filtered_out_num_());
+    const auto bitset = bitset_.with_filtered_out_num();
+    const auto priority_class = (size_t)dataset->GetRows() >= ThreadPool::GetBatchSearchNq()
+                                    ? ThreadPool::TaskPriority::BATCH
+                                    : ThreadPool::TaskPriority::INTERACTIVE;
+    ThreadPool::ScopedTaskPriority priority(priority_class);
+    ThreadPool::ScopedNumaNode numa_node(this->node->NumaNode());
+    if (AdmitSearch(priority_class) != Status::success) {
+        return expected<DataSetPtr>::Err(Status::overloaded, "search rejected, the search thread pool is overloaded");
+    }
+    ScopedCancellation scoped_cancellation(cancellation.get());
+    // the scratch memory the search allocates on the calling thread
+    ScopedSearchArena scoped_arena;
+    const bool partial_results = cfg->partial_results.value_or(false);
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     const BaseConfig& b_cfg = static_cast<const BaseConfig&>(*cfg);
@@ -244,6 +942,8 @@ Index<T>::RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetVi
         span->SetAttribute(meta::NQ, dataset->GetRows());
     }
     // LCOV_EXCL_STOP
+    auto trace_parent = MakeTraceParent(span);
+    ScopedTraceParent scoped_trace(trace_parent.get());
 
     TimeRecorder rc("Range Search");
     bool has_trace_id = b_cfg.trace_id.has_value();
@@ -260,7 +960,117 @@ Index<T>::RangeSearch(const DataSetPtr dataset, const Json& json, const BitsetVi
 #else
     auto res = this->node->RangeSearch(dataset, std::move(cfg), bitset);
 #endif
-    return res;
+    return CheckCancellation(std::move(res), cancellation.get(), partial_results);
+}
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+template <typename T>
+inline folly::SemiFuture<expected<DataSetPtr>>
+Index<T>::SearchAsync(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                      std::shared_ptr<CancellationToken> cancellation) const {
+    return ThreadPool::GetGlobalAsyncSearchThreadPool()
+        ->push([index = *this, dataset, json, bitset, cancellation]() {
+            return index.Search(dataset, json, bitset, cancellation);
+        })
+        .semi();
+}
+
+template <typename T>
+inline folly::SemiFuture<expected<std::vector<IndexNode::IteratorPtr>>>
+Index<T>::AnnIteratorAsync(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                           bool use_knowhere_search_pool, std::shared_ptr<CancellationToken> cancellation) const {
+    return ThreadPool::GetGlobalAsyncSearchThreadPool()
+        ->push([index = *this, dataset, json, bitset, use_knowhere_search_pool, cancellation]() {
+            return index.AnnIterator(dataset, json, bitset, use_knowhere_search_pool, cancellation);
+        })
+        .semi();
+}
+
+template <typename T>
+inline folly::SemiFuture<expected<DataSetPtr>>
+Index<T>::RangeSearchAsync(const DataSetPtr dataset, const Json& json, const BitsetView& bitset,
+                           std::shared_ptr<CancellationToken> cancellation) const {
+    return ThreadPool::GetGlobalAsyncSearchThreadPool()
+        ->push([index = *this, dataset, json, bitset, cancellation]() {
+            return index.RangeSearch(dataset, json, bitset, cancellation);
+        })
+        .semi();
+}
+#endif
+
+template <typename T>
+inline expected<Json>
+Index<T>::Calibrate(const DataSetPtr queries, const Json& json, float target_recall) {
+    if (!(target_recall > 0.0f && target_recall <= 1.0f)) {
+        return expected<Json>::Err(Status::invalid_args, "the target recall should be in (0, 1]");
+    }
+    auto cfg = this->node->CreateConfig();
+    const char* param = nullptr;
+    int32_t max_value = kCalibrateMaxValue;
+    for (const char* name : kCalibratedParams) {
+        auto it = cfg->__DICT__.find(name);
+        const auto* entry = it == cfg->__DICT__.end() ? nullptr : std::get_if<Entry<CFG_INT>>(&it->second);
+        if (entry != nullptr && (entry->type & knowhere::SEARCH)) {
+            param = name;
+            if (entry->range.has_value()) {
+                max_value = std::min(max_value, entry->range->right);
+            }
+            break;
+        }
+    }
+    if (param == nullptr) {
+        return expected<Json>::Err(Status::not_implemented, this->Type() + " has no search param to calibrate");
+    }
+
+    DataSetPtr sample = queries;
+    if (sample == nullptr) {
+        const std::string metric = json.value(meta::METRIC_TYPE, std::string());
+        if (Count() == 0 || !HasRawData(metric)) {
+            return expected<Json>::Err(Status::invalid_args,
+                                       "no raw data in " + this->Type() + " to sample the queries from");
+        }
+        const int64_t nq = std::min(kCalibrateSampleNq, Count());
+        std::vector<int64_t> ids(nq);
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<int64_t> row(0, Count() - 1);
+        std::generate(ids.begin(), ids.end(), [&]() { return row(rng); });
+        auto vectors = GetVectorByIds(GenIdsDataSet(nq, ids.data()));
+        if (!vectors.has_value()) {
+            return expected<Json>::Err(vectors.error(), vectors.what());
+        }
+        sample = vectors.value();
+    }
+
+    Json conf = json;
+    conf[param] = max_value;
+    auto reference = Search(sample, conf, nullptr);
+    if (!reference.has_value()) {
+        return expected<Json>::Err(reference.error(), reference.what());
+    }
+    // a value the config rejects, such as ef < k, misses the target
+    auto meets_target = [&](int32_t value) {
+        conf[param] = value;
+        auto res = Search(sample, conf, nullptr);
+        return res.has_value() && ResultOverlap(*res.value(), *reference.value()) >= target_recall;
+    };
+    // doubles the value until it meets the target, then bisects for the smallest one that does
+    int32_t low = 0, high = max_value;
+    for (int32_t value = 1; value < max_value; value *= 2) {
+        if (meets_target(value)) {
+            high = value;
+            break;
+        }
+        low = value;
+    }
+    while (high - low > 1) {
+        const int32_t mid = low + (high - low) / 2;
+        (meets_target(mid) ? high : low) = mid;
+    }
+
+    Json params = {{param, high}};
+    LOG_KNOWHERE_INFO_ << "Calibrated " << this->Type() << " for recall " << target_recall << ": " << params.dump();
+    this->node->SetCalibratedParams(params);
+    return params;
 }
 
 template <typename T>
@@ -296,7 +1106,38 @@ Index<T>::GetIndexMeta(const Json& json) const {
 template <typename T>
 inline Status
 Index<T>::Serialize(BinarySet& binset) const {
-    return this->node->Serialize(binset);
+    auto res = this->node->Serialize(binset);
+    if (res == Status::success && !this->node->CalibratedParams().empty()) {
+        const std::string params = this->node->CalibratedParams().dump();
+        std::shared_ptr<uint8_t[]> data(new uint8_t[params.size()]);
+        std::memcpy(data.get(), params.data(), params.size());
+        binset.Append(kCalibratedParamsBinary, std::move(data), params.size());
+    }
+    if (res == Status::success && this->node->EmbListOffsets() != nullptr) {
+        const auto& offsets = *this->node->EmbListOffsets();
+        const size_t size = offsets.size() * sizeof(size_t);
+        std::shared_ptr<uint8_t[]> data(new uint8_t[size]);
+        std::memcpy(data.get(), offsets.data(), size);
+        binset.Append(kEmbListOffsetsBinary, std::move(data), size);
+    }
+    if (res != Status::success || binset.CompressionLevel() <= 0) {
+        return res;
+    }
+    return CompressBinarySet(binset, binset.CompressionLevel());
+}
+
+template <typename T>
+inline Status
+Index<T>::SerializeToFile(const std::string& filename, const std::shared_ptr<FileManager>& file_manager) const {
+    auto res = this->node->SerializeToFile(filename);
+    if (res != Status::success) {
+        return res;
+    }
+    if (file_manager != nullptr && !file_manager->AddFile(filename)) {
+        LOG_KNOWHERE_ERROR_ << "Failed to add file " << filename << " to the file manager";
+        return Status::disk_file_error;
+    }
+    return Status::success;
 }
 
 template <typename T>
@@ -316,15 +1157,72 @@ Index<T>::Deserialize(const BinarySet& binset, const Json& json) {
         return res;
     }
 
+    ScopedIndexChange change(*this->node);
+    // the memory the load allocates is placed by the NUMA policy
+    numa::ScopedIndexPlacement placement;
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     TimeRecorder rc("Load index", 2);
-    res = this->node->Deserialize(binset, std::move(cfg));
+    // LCOV_EXCL_START
+    auto span = StartLoadSpan(static_cast<const BaseConfig&>(*cfg), "knowhere load");
+    auto trace_parent = MakeTraceParent(span);
+    ScopedTraceParent scoped_trace(trace_parent.get());
+    // LCOV_EXCL_STOP
+#endif
+    const BinarySet* input = &binset;
+    BinarySet decompressed;
+    if (std::any_of(binset.binary_map_.begin(), binset.binary_map_.end(),
+                    [](const auto& it) { return it.second != nullptr && IsCompressedBinary(*it.second); })) {
+        ScopedTraceSpan decompress_span("decompress");
+        decompressed = binset;
+        res = DecompressBinarySet(decompressed);
+        if (res != Status::success) {
+            return res;
+        }
+        input = &decompressed;
+    }
+    Json calibrated = Json::object();
+    if (auto params = input->GetByName(kCalibratedParamsBinary); params != nullptr) {
+        calibrated = Json::parse(params->data.get(), params->data.get() + params->size, nullptr, false);
+        if (calibrated.is_discarded() || !calibrated.is_object()) {
+            LOG_KNOWHERE_ERROR_ << "Invalid calibrated search params in the binary set";
+            return Status::invalid_binary_set;
+        }
+        if (input != &decompressed) {
+            decompressed = binset;
+            input = &decompressed;
+        }
+        decompressed.Erase(kCalibratedParamsBinary);
+    }
+    std::shared_ptr<const EmbListOffsets> emb_list_offsets;
+    if (auto offsets = input->GetByName(kEmbListOffsetsBinary); offsets != nullptr) {
+        if (offsets->size % sizeof(size_t) != 0) {
+            LOG_KNOWHERE_ERROR_ << "Invalid embedding list offsets in the binary set";
+            return Status::invalid_binary_set;
+        }
+        const auto* begin = reinterpret_cast<const size_t*>(offsets->data.get());
+        emb_list_offsets = std::make_shared<const EmbListOffsets>(begin, begin + offsets->size / sizeof(size_t));
+        if (input != &decompressed) {
+            decompressed = binset;
+            input = &decompressed;
+        }
+        decompressed.Erase(kEmbListOffsetsBinary);
+    }
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    res = this->node->Deserialize(*input, std::move(cfg));
     auto time = rc.ElapseFromBegin("done");
     time *= 0.001;  // convert to ms
     knowhere_load_latency.Observe(time);
+    // LCOV_EXCL_START
+    if (span != nullptr) {
+        span->End();
+    }
+    // LCOV_EXCL_STOP
 #else
-    res = this->node->Deserialize(binset, std::move(cfg));
+    res = this->node->Deserialize(*input, std::move(cfg));
 #endif
+    this->node->SetNumaNode(placement.Node());
+    this->node->SetCalibratedParams(std::move(calibrated));
+    this->node->SetEmbListOffsets(std::move(emb_list_offsets));
     return res;
 }
 
@@ -344,19 +1242,124 @@ Index<T>::DeserializeFromFile(const std::string& filename, const Json& json) {
     if (res != Status::success) {
         return res;
     }
+    const BaseConfig& b_cfg = static_cast<const BaseConfig&>(*cfg);
+    const bool advise_huge_pages = b_cfg.use_huge_pages.value() && b_cfg.enable_mmap.value();
 
+    ScopedIndexChange change(*this->node);
+    // the memory the load allocates is placed by the NUMA policy
+    numa::ScopedIndexPlacement placement;
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     TimeRecorder rc("Load index from file", 2);
+    // LCOV_EXCL_START
+    auto span = StartLoadSpan(b_cfg, "knowhere load from file");
+    auto trace_parent = MakeTraceParent(span);
+    ScopedTraceParent scoped_trace(trace_parent.get());
+    // LCOV_EXCL_STOP
     res = this->node->DeserializeFromFile(filename, std::move(cfg));
     auto time = rc.ElapseFromBegin("done");
     time *= 0.001;  // convert to ms
     knowhere_load_latency.Observe(time);
+    // LCOV_EXCL_START
+    if (span != nullptr) {
+        span->End();
+    }
+    // LCOV_EXCL_STOP
 #else
     res = this->node->DeserializeFromFile(filename, std::move(cfg));
 #endif
+    this->node->SetNumaNode(placement.Node());
+    if (res == Status::success && advise_huge_pages) {
+        // the nodes move the arrays they read into memory to huge pages themselves
+        AdviseHugePages(this->node->MappedRegions());
+    }
     return res;
 }
 
+namespace {
+
+// runs load(i) for each of the n segments on the build thread pool
+std::vector<Status>
+LoadSegments(size_t n, size_t n_jsons, const std::function<Status(size_t)>& load) {
+    if (n_jsons != 1 && n_jsons != n) {
+        LOG_KNOWHERE_ERROR_ << "Got " << n_jsons << " configs to load " << n << " segments";
+        return std::vector<Status>(n, Status::invalid_args);
+    }
+    auto pool = ThreadPool::GetGlobalBuildThreadPool();
+    std::vector<folly::Future<Status>> futures;
+    futures.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        futures.emplace_back(pool->push([&load, i]() { return load(i); }));
+    }
+    std::vector<Status> statuses;
+    statuses.reserve(n);
+    for (auto& result : folly::collectAll(futures.begin(), futures.end()).get()) {
+        if (result.hasException()) {
+            LOG_KNOWHERE_ERROR_ << "Failed to load a segment: " << result.exception().what();
+            statuses.push_back(Status::internal_error);
+        } else {
+            statuses.push_back(result.value());
+        }
+    }
+    return statuses;
+}
+
+}  // namespace
+
+template <typename T>
+inline std::vector<Status>
+Index<T>::DeserializeAll(std::vector<Index<T>>& indexes, const std::vector<BinarySet>& binsets,
+                         const std::vector<Json>& jsons) {
+    if (binsets.size() != indexes.size()) {
+        LOG_KNOWHERE_ERROR_ << "Got " << binsets.size() << " binary sets to load " << indexes.size() << " indexes";
+        return std::vector<Status>(indexes.size(), Status::invalid_args);
+    }
+    return LoadSegments(indexes.size(), jsons.size(), [&](size_t i) {
+        return indexes[i].Deserialize(binsets[i], jsons.size() == 1 ? jsons[0] : jsons[i]);
+    });
+}
+
+template <typename T>
+inline std::vector<Status>
+Index<T>::DeserializeAllFromFile(std::vector<Index<T>>& indexes, const std::vector<std::string>& filenames,
+                                 const std::vector<Json>& jsons) {
+    if (filenames.size() != indexes.size()) {
+        LOG_KNOWHERE_ERROR_ << "Got " << filenames.size() << " files to load " << indexes.size() << " indexes";
+        return std::vector<Status>(indexes.size(), Status::invalid_args);
+    }
+    return LoadSegments(indexes.size(), jsons.size(), [&](size_t i) {
+        return indexes[i].DeserializeFromFile(filenames[i], jsons.size() == 1 ? jsons[0] : jsons[i]);
+    });
+}
+
+template <typename T>
+inline Status
+Index<T>::WarmUp(WarmUpLevel level) const {
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+    TimeRecorder rc("Warm up index", 2);
+    auto res = this->node->WarmUp(level);
+    rc.ElapseFromBegin("done");
+    return res;
+#else
+    return this->node->WarmUp(level);
+#endif
+}
+
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+template <typename T>
+inline folly::SemiFuture<Status>
+Index<T>::WarmUpAsync(WarmUpLevel level) const {
+    return ThreadPool::GetGlobalAsyncSearchThreadPool()
+        ->push([index = *this, level]() { return index.WarmUp(level); })
+        .semi();
+}
+#endif
+
+template <typename T>
+inline Status
+Index<T>::CoolDown() const {
+    return this->node->CoolDown();
+}
+
 template <typename T>
 inline int64_t
 Index<T>::Dim() const {
@@ -66,7 +66,11 @@ IndexFactory::Create(const std::string& name, const int32_t& version, const Obje
                                                "SCANN index is not supported on the current CPU model");
     }
 
-    return fun_map_v->fun_value(version, object);
+    auto index = fun_map_v->fun_value(version, object);
+    if (index.Node() != nullptr) {
+        index.Node()->SetDataFormat(datatype_v<DataType>);
+    }
+    return index;
 }
 
 template <typename DataType>
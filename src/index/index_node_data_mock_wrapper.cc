@@ -20,6 +20,34 @@
 
 namespace knowhere {
 
+namespace {
+
+// the converted queries keep the probes of a shared coarse search, see IndexNode::CoarseSearch()
+DataSetPtr
+WithCoarseProbes(DataSetPtr converted, const DataSetPtr& dataset) {
+    if (converted != dataset) {
+        auto probes = dataset->Get<std::shared_ptr<const CoarseProbes>>(meta::COARSE_PROBES);
+        if (probes != nullptr) {
+            converted->Set(meta::COARSE_PROBES, std::move(probes));
+        }
+    }
+    return converted;
+}
+
+// the converted queries keep the group keys of the rows, see IndexNode::GroupBySearch()
+DataSetPtr
+WithGroupKeys(DataSetPtr converted, const DataSetPtr& dataset) {
+    if (converted != dataset) {
+        auto keys = dataset->Get<std::shared_ptr<const GroupKeys>>(meta::GROUP_BY_KEYS);
+        if (keys != nullptr) {
+            converted->Set(meta::GROUP_BY_KEYS, std::move(keys));
+        }
+    }
+    return converted;
+}
+
+}  // namespace
+
 template <typename DataType>
 Status
 IndexNodeDataMockWrapper<DataType>::Build(const DataSetPtr dataset, std::shared_ptr<Config> cfg,
@@ -44,14 +72,51 @@ IndexNodeDataMockWrapper<DataType>::Add(const DataSetPtr dataset, std::shared_pt
     return index_node_->Add(ds_ptr, std::move(cfg), use_knowhere_build_pool);
 }
 
+template <typename DataType>
+Status
+IndexNodeDataMockWrapper<DataType>::Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) {
+    // the data of wrapped indexes is already converted
+    std::vector<const IndexNode*> other_nodes;
+    for (const auto* other : others) {
+        auto other_wrapper = dynamic_cast<const IndexNodeDataMockWrapper<DataType>*>(other);
+        if (other_wrapper == nullptr) {
+            LOG_KNOWHERE_ERROR_ << "can not merge indexes of different types";
+            return Status::invalid_args;
+        }
+        other_nodes.push_back(other_wrapper->index_node_.get());
+    }
+    return index_node_->Merge(other_nodes, std::move(cfg));
+}
+
+template <typename DataType>
+Status
+IndexNodeDataMockWrapper<DataType>::DeleteByIds(const DataSetPtr dataset) {
+    return index_node_->DeleteByIds(dataset);
+}
+
 template <typename DataType>
 expected<DataSetPtr>
 IndexNodeDataMockWrapper<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
                                            const BitsetView& bitset) const {
-    auto ds_ptr = ConvertFromDataTypeIfNeeded<DataType>(dataset);
+    auto ds_ptr = WithCoarseProbes(ConvertFromDataTypeIfNeeded<DataType>(dataset), dataset);
     return index_node_->Search(ds_ptr, std::move(cfg), bitset);
 }
 
+template <typename DataType>
+expected<DataSetPtr>
+IndexNodeDataMockWrapper<DataType>::SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                                  const BitsetView& bitset, int64_t* ids, float* dis) const {
+    auto ds_ptr = WithCoarseProbes(ConvertFromDataTypeIfNeeded<DataType>(dataset), dataset);
+    return index_node_->SearchWithBuf(ds_ptr, std::move(cfg), bitset, ids, dis);
+}
+
+template <typename DataType>
+expected<std::shared_ptr<const CoarseProbes>>
+IndexNodeDataMockWrapper<DataType>::CoarseSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg) const {
+    auto ds_ptr = ConvertFromDataTypeIfNeeded<DataType>(dataset);
+    return index_node_->CoarseSearch(ds_ptr, std::move(cfg));
+}
+
 template <typename DataType>
 expected<DataSetPtr>
 IndexNodeDataMockWrapper<DataType>::RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
@@ -60,6 +125,14 @@ IndexNodeDataMockWrapper<DataType>::RangeSearch(const DataSetPtr dataset, std::u
     return index_node_->RangeSearch(ds_ptr, std::move(cfg), bitset);
 }
 
+template <typename DataType>
+expected<DataSetPtr>
+IndexNodeDataMockWrapper<DataType>::GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                                  const BitsetView& bitset) const {
+    auto ds_ptr = WithGroupKeys(ConvertFromDataTypeIfNeeded<DataType>(dataset), dataset);
+    return index_node_->GroupBySearch(ds_ptr, std::move(cfg), bitset);
+}
+
 template <typename DataType>
 expected<std::vector<IndexNode::IteratorPtr>>
 IndexNodeDataMockWrapper<DataType>::AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
@@ -0,0 +1,468 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "knowhere/index/index_node_sharded_wrapper.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <numeric>
+
+#include "knowhere/comp/index_param.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/topk_merge.h"
+#include "knowhere/data_source.h"
+#include "knowhere/range_util.h"
+
+namespace knowhere {
+
+namespace {
+
+// the rows of a shard but the last one are a multiple of this
+constexpr int64_t kShardRowsAlignment = 64;
+
+// the num_shards of a config, 1 for the configs that do not have one
+int64_t
+NumShards(const Config& cfg) {
+    auto it = cfg.__DICT__.find(indexparam::NUM_SHARDS);
+    if (it == cfg.__DICT__.end()) {
+        return 1;
+    }
+    const auto* entry = std::get_if<Entry<CFG_INT>>(&it->second);
+    return (entry != nullptr && entry->val->has_value()) ? std::max(entry->val->value(), 1) : 1;
+}
+
+// the offsets of the shards of rows, at most num_shards of them
+std::vector<int64_t>
+SplitRows(int64_t rows, int64_t num_shards) {
+    const int64_t shard_rows =
+        std::max(((rows + num_shards - 1) / num_shards + kShardRowsAlignment - 1) / kShardRowsAlignment *
+                     kShardRowsAlignment,
+                 kShardRowsAlignment);
+    std::vector<int64_t> offsets{0};
+    for (int64_t begin = shard_rows; begin < rows; begin += shard_rows) {
+        offsets.push_back(begin);
+    }
+    offsets.push_back(rows);
+    return offsets;
+}
+
+template <typename DataType>
+DataSetPtr
+SliceRows(const DataSetPtr& dataset, int64_t begin, int64_t end) {
+    const auto dim = dataset->GetDim();
+    const auto* data = static_cast<const uint8_t*>(dataset->GetTensor());
+    return GenDataSet(end - begin, dim, data + begin * DenseRowBytes<DataType>(dim));
+}
+
+// the bitmap of bitset, written to buf if bitset is an id list
+const uint8_t*
+BitmapOf(const BitsetView& bitset, std::unique_ptr<uint8_t[]>& buf) {
+    if (bitset.empty() || bitset.is_bitmap()) {
+        return bitset.data();
+    }
+    buf = std::make_unique<uint8_t[]>(bitset.byte_size());
+    bitset.copy_bits(buf.get());
+    return buf.get();
+}
+
+// the build config of a shard, the build threads of the index are shared by its shards
+std::shared_ptr<Config>
+ShardBuildConfig(const IndexNode& shard, const Config& cfg, size_t num_shards) {
+    std::shared_ptr<Config> shard_cfg = shard.CreateConfig();
+    Config::CopyValues(cfg, *shard_cfg);
+    if (num_shards > 1) {
+        auto& base_cfg = static_cast<BaseConfig&>(*shard_cfg);
+        const int64_t num_threads =
+            base_cfg.num_build_thread.value_or(ThreadPool::GetGlobalBuildThreadPoolSize());
+        base_cfg.num_build_thread = std::max<int64_t>(num_threads / num_shards, 1);
+    }
+    return shard_cfg;
+}
+
+bool
+IsLargerCloser(const BaseConfig& cfg) {
+    return IsMetricType(cfg.metric_type.value(), metric::IP) || IsMetricType(cfg.metric_type.value(), metric::COSINE) ||
+           IsMetricType(cfg.metric_type.value(), metric::BM25);
+}
+
+// runs func(i) for every shard and returns the first error. The shards wait on the tasks they push to the build or
+//   the search thread pool, so they run in threads of their own, the first one in the calling thread.
+Status
+ForEachShard(size_t num_shards, const std::function<Status(size_t)>& func) {
+    auto run = [&func](size_t i) {
+        try {
+            return func(i);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_ERROR_ << "shard " << i << " failed: " << e.what();
+            return Status::internal_error;
+        }
+    };
+    std::vector<std::future<Status>> futures;
+    futures.reserve(num_shards);
+    for (size_t i = 1; i < num_shards; i++) {
+        futures.push_back(std::async(std::launch::async, run, i));
+    }
+    auto status = run(0);
+    for (auto& future : futures) {
+        const auto shard_status = future.get();
+        if (status == Status::success) {
+            status = shard_status;
+        }
+    }
+    return status;
+}
+
+}  // namespace
+
+template <typename DataType>
+IndexNodeShardedWrapper<DataType>::IndexNodeShardedWrapper(const int32_t& version, ShardFactory shard_factory,
+                                                           std::string type)
+    : IndexNode(version), shard_factory_(std::move(shard_factory)), type_(std::move(type)) {
+    std::vector<std::unique_ptr<IndexNode>> shards;
+    shards.push_back(shard_factory_());
+    SetShards(std::move(shards));
+}
+
+template <typename DataType>
+Status
+IndexNodeShardedWrapper<DataType>::Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg,
+                                         bool use_knowhere_build_pool) {
+    const auto offsets = SplitRows(dataset->GetRows(), NumShards(*cfg));
+    const size_t num_shards = offsets.size() - 1;
+    std::vector<std::unique_ptr<IndexNode>> shards(num_shards);
+    for (auto& shard : shards) {
+        shard = shard_factory_();
+    }
+    RETURN_IF_ERROR(ForEachShard(num_shards, [&](size_t i) {
+        auto shard_dataset = num_shards == 1 ? dataset : SliceRows<DataType>(dataset, offsets[i], offsets[i + 1]);
+        return shards[i]->Train(shard_dataset, ShardBuildConfig(*shards[i], *cfg, num_shards),
+                                use_knowhere_build_pool);
+    }));
+    SetShards(std::move(shards));
+    return Status::success;
+}
+
+template <typename DataType>
+Status
+IndexNodeShardedWrapper<DataType>::Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg,
+                                       bool use_knowhere_build_pool) {
+    const bool empty = Count() == 0;
+    const auto offsets = empty ? SplitRows(dataset->GetRows(), shards_.size())
+                               : std::vector<int64_t>{0, static_cast<int64_t>(dataset->GetRows())};
+    const size_t num_shards = offsets.size() - 1;
+    const size_t first = empty ? 0 : shards_.size() - 1;
+    auto status = ForEachShard(num_shards, [&](size_t i) {
+        auto& shard = shards_[first + i];
+        auto shard_dataset = num_shards == 1 ? dataset : SliceRows<DataType>(dataset, offsets[i], offsets[i + 1]);
+        return shard->Add(shard_dataset, ShardBuildConfig(*shard, *cfg, num_shards), use_knowhere_build_pool);
+    });
+    // the trained shards left without rows are dropped
+    auto shards = std::move(shards_);
+    if (status == Status::success && empty) {
+        shards.resize(num_shards);
+    }
+    SetShards(std::move(shards));
+    return status;
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+IndexNodeShardedWrapper<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                          const BitsetView& bitset) const {
+    if (shards_.size() == 1) {
+        return shards_[0]->Search(dataset, std::move(cfg), bitset);
+    }
+    const auto& base_cfg = static_cast<const BaseConfig&>(*cfg);
+    const int64_t nq = dataset->GetRows();
+    const int64_t k = base_cfg.k.value();
+    const size_t num_shards = shards_.size();
+    std::unique_ptr<uint8_t[]> bitmap;
+    const uint8_t* bits = BitmapOf(bitset, bitmap);
+
+    auto shard_ids = std::make_unique<int64_t[]>(num_shards * nq * k);
+    auto shard_dists = std::make_unique<float[]>(num_shards * nq * k);
+    auto status = ForEachShard(num_shards, [&](size_t i) {
+        int64_t* ids = shard_ids.get() + i * nq * k;
+        float* dists = shard_dists.get() + i * nq * k;
+        if (ShardFilteredOut(bitset, i)) {
+            std::fill_n(ids, nq * k, -1);
+            return Status::success;
+        }
+        auto res = shards_[i]->SearchWithBuf(dataset, ShardConfig(*cfg, i), ShardBitset(bitset, bits, i), ids, dists);
+        if (!res.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "search of shard " << i << " failed: " << res.what();
+            return res.error();
+        }
+        const int64_t offset = shard_offsets_[i];
+        for (int64_t j = 0; j < nq * k; j++) {
+            if (ids[j] >= 0) {
+                ids[j] += offset;
+            }
+        }
+        return Status::success;
+    });
+    if (status != Status::success) {
+        return expected<DataSetPtr>::Err(status, "search of a shard failed");
+    }
+
+    std::vector<TopkSegment> segments;
+    for (size_t i = 0; i < num_shards; i++) {
+        segments.push_back(TopkSegment{shard_ids.get() + i * nq * k, shard_dists.get() + i * nq * k, k});
+    }
+    TopkMergeOptions options;
+    options.larger_is_closer = IsLargerCloser(base_cfg);
+    auto ids = std::make_unique<int64_t[]>(nq * k);
+    auto dists = std::make_unique<float[]>(nq * k);
+    status = MergeTopk(segments, nq, k, options, ids.get(), dists.get());
+    if (status != Status::success) {
+        return expected<DataSetPtr>::Err(status, "failed to merge the results of the shards");
+    }
+    return GenResultDataSet(nq, k, std::move(ids), std::move(dists));
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+IndexNodeShardedWrapper<DataType>::RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                               const BitsetView& bitset) const {
+    if (shards_.size() == 1) {
+        return shards_[0]->RangeSearch(dataset, std::move(cfg), bitset);
+    }
+    const auto& base_cfg = static_cast<const BaseConfig&>(*cfg);
+    const int64_t nq = dataset->GetRows();
+    const size_t num_shards = shards_.size();
+    std::unique_ptr<uint8_t[]> bitmap;
+    const uint8_t* bits = BitmapOf(bitset, bitmap);
+
+    std::vector<DataSetPtr> results(num_shards);
+    auto status = ForEachShard(num_shards, [&](size_t i) {
+        if (ShardFilteredOut(bitset, i)) {
+            return Status::success;
+        }
+        auto res = shards_[i]->RangeSearch(dataset, ShardConfig(*cfg, i), ShardBitset(bitset, bits, i));
+        if (!res.has_value()) {
+            LOG_KNOWHERE_ERROR_ << "range search of shard " << i << " failed: " << res.what();
+            return res.error();
+        }
+        results[i] = res.value();
+        return Status::success;
+    });
+    if (status != Status::success) {
+        return expected<DataSetPtr>::Err(status, "range search of a shard failed");
+    }
+
+    const bool larger_is_closer = IsLargerCloser(base_cfg);
+    const int32_t range_search_k = base_cfg.range_search_k.value();
+    std::vector<std::vector<int64_t>> result_ids(nq);
+    std::vector<std::vector<float>> result_dists(nq);
+    for (int64_t q = 0; q < nq; q++) {
+        for (size_t i = 0; i < num_shards; i++) {
+            if (results[i] == nullptr) {
+                continue;
+            }
+            const auto* lims = results[i]->GetLims();
+            const auto* ids = results[i]->GetIds();
+            const auto* dists = results[i]->GetDistance();
+            for (size_t j = lims[q]; j < lims[q + 1]; j++) {
+                result_ids[q].push_back(ids[j] + shard_offsets_[i]);
+                result_dists[q].push_back(dists[j]);
+            }
+        }
+        // every shard returns up to range_search_k results
+        if (range_search_k > 0 && result_ids[q].size() > static_cast<size_t>(range_search_k)) {
+            std::vector<size_t> order(result_ids[q].size());
+            std::iota(order.begin(), order.end(), 0);
+            const auto& d = result_dists[q];
+            std::partial_sort(order.begin(), order.begin() + range_search_k, order.end(), [&](size_t a, size_t b) {
+                return larger_is_closer ? d[a] > d[b] : d[a] < d[b];
+            });
+            std::vector<int64_t> kept_ids(range_search_k);
+            std::vector<float> kept_dists(range_search_k);
+            for (int32_t j = 0; j < range_search_k; j++) {
+                kept_ids[j] = result_ids[q][order[j]];
+                kept_dists[j] = d[order[j]];
+            }
+            result_ids[q] = std::move(kept_ids);
+            result_dists[q] = std::move(kept_dists);
+        }
+    }
+    auto range_search_result = GetRangeSearchResult(result_dists, result_ids, larger_is_closer, nq,
+                                                    base_cfg.radius.value(), base_cfg.range_filter.value());
+    return GenResultDataSet(nq, std::move(range_search_result));
+}
+
+template <typename DataType>
+expected<DataSetPtr>
+IndexNodeShardedWrapper<DataType>::GetVectorByIds(const DataSetPtr dataset) const {
+    if (shards_.size() == 1) {
+        return shards_[0]->GetVectorByIds(dataset);
+    }
+    const int64_t rows = dataset->GetRows();
+    const auto* ids = dataset->GetIds();
+    const size_t num_shards = shards_.size();
+    std::vector<std::vector<int64_t>> shard_ids(num_shards);
+    std::vector<std::vector<int64_t>> shard_positions(num_shards);
+    for (int64_t j = 0; j < rows; j++) {
+        if (ids[j] < 0 || ids[j] >= Count()) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "invalid id " + std::to_string(ids[j]));
+        }
+        const size_t i = std::upper_bound(shard_offsets_.begin(), shard_offsets_.end(), ids[j]) -
+                         shard_offsets_.begin() - 1;
+        shard_ids[i].push_back(ids[j] - shard_offsets_[i]);
+        shard_positions[i].push_back(j);
+    }
+
+    const int64_t dim = Dim();
+    const int64_t row_bytes = DenseRowBytes<DataType>(dim);
+    auto data = std::make_unique<uint8_t[]>(rows * row_bytes);
+    for (size_t i = 0; i < num_shards; i++) {
+        if (shard_ids[i].empty()) {
+            continue;
+        }
+        auto res = shards_[i]->GetVectorByIds(GenIdsDataSet(shard_ids[i].size(), shard_ids[i].data()));
+        if (!res.has_value()) {
+            return res;
+        }
+        const auto* shard_data = static_cast<const uint8_t*>(res.value()->GetTensor());
+        for (size_t r = 0; r < shard_positions[i].size(); r++) {
+            std::memcpy(data.get() + shard_positions[i][r] * row_bytes, shard_data + r * row_bytes, row_bytes);
+        }
+    }
+    return GenResultDataSet(rows, dim, std::move(data));
+}
+
+template <typename DataType>
+Status
+IndexNodeShardedWrapper<DataType>::Serialize(BinarySet& binset) const {
+    if (shards_.size() == 1) {
+        return shards_[0]->Serialize(binset);
+    }
+    for (size_t i = 0; i < shards_.size(); i++) {
+        BinarySet shard_binset;
+        shard_binset.SetKeepChunks(binset.KeepChunks());
+        RETURN_IF_ERROR(shards_[i]->Serialize(shard_binset));
+        for (auto& [name, binary] : shard_binset.binary_map_) {
+            binset.Append(ShardBinaryPrefix(i) + name, binary);
+        }
+    }
+    const int64_t num_shards = shards_.size();
+    std::shared_ptr<uint8_t[]> meta(new uint8_t[sizeof(num_shards)]);
+    std::memcpy(meta.get(), &num_shards, sizeof(num_shards));
+    binset.Append(ShardsBinaryName(), meta, sizeof(num_shards));
+    return Status::success;
+}
+
+template <typename DataType>
+Status
+IndexNodeShardedWrapper<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) {
+    if (!binset.Contains(ShardsBinaryName())) {
+        std::vector<std::unique_ptr<IndexNode>> shards;
+        shards.push_back(shard_factory_());
+        RETURN_IF_ERROR(shards[0]->Deserialize(binset, std::move(cfg)));
+        SetShards(std::move(shards));
+        return Status::success;
+    }
+
+    auto meta = binset.GetByName(ShardsBinaryName());
+    int64_t num_shards = 0;
+    if (meta->size != sizeof(num_shards)) {
+        LOG_KNOWHERE_ERROR_ << "Invalid binary set, the " << ShardsBinaryName() << " binary is " << meta->size
+                            << " bytes";
+        return Status::invalid_binary_set;
+    }
+    std::memcpy(&num_shards, meta->data.get(), sizeof(num_shards));
+    std::vector<BinarySet> shard_binsets(std::max<int64_t>(num_shards, 0));
+    for (int64_t i = 0; i < num_shards; i++) {
+        const auto prefix = ShardBinaryPrefix(i);
+        for (auto it = binset.binary_map_.lower_bound(prefix);
+             it != binset.binary_map_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            shard_binsets[i].Append(it->first.substr(prefix.size()), it->second);
+        }
+        if (shard_binsets[i].binary_map_.empty()) {
+            LOG_KNOWHERE_ERROR_ << "Invalid binary set, no shard " << i << " of " << num_shards;
+            return Status::invalid_binary_set;
+        }
+    }
+
+    std::vector<std::unique_ptr<IndexNode>> shards(shard_binsets.size());
+    for (auto& shard : shards) {
+        shard = shard_factory_();
+    }
+    RETURN_IF_ERROR(
+        ForEachShard(shards.size(), [&](size_t i) { return shards[i]->Deserialize(shard_binsets[i], cfg); }));
+    SetShards(std::move(shards));
+    return Status::success;
+}
+
+template <typename DataType>
+Status
+IndexNodeShardedWrapper<DataType>::DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> cfg) {
+    std::vector<std::unique_ptr<IndexNode>> shards;
+    shards.push_back(shard_factory_());
+    RETURN_IF_ERROR(shards[0]->DeserializeFromFile(filename, std::move(cfg)));
+    SetShards(std::move(shards));
+    return Status::success;
+}
+
+template <typename DataType>
+int64_t
+IndexNodeShardedWrapper<DataType>::Size() const {
+    int64_t size = 0;
+    for (const auto& shard : shards_) {
+        size += shard->Size();
+    }
+    return size;
+}
+
+template <typename DataType>
+MemoryUsage
+IndexNodeShardedWrapper<DataType>::MemoryBreakdown() const {
+    MemoryUsage usage;
+    for (const auto& shard : shards_) {
+        usage.Add(shard->MemoryBreakdown());
+    }
+    return usage;
+}
+
+template <typename DataType>
+BitsetView
+IndexNodeShardedWrapper<DataType>::ShardBitset(const BitsetView& bitset, const uint8_t* bits, size_t i) const {
+    if (bitset.empty()) {
+        return bitset;
+    }
+    const int64_t offset = shard_offsets_[i];
+    const int64_t num_bits = std::min<int64_t>(shard_offsets_[i + 1], bitset.size()) - offset;
+    return BitsetView(bits + offset / 8, num_bits).with_filtered_out_num();
+}
+
+template <typename DataType>
+std::unique_ptr<Config>
+IndexNodeShardedWrapper<DataType>::ShardConfig(const Config& cfg, size_t i) const {
+    auto shard_cfg = shards_[i]->CreateConfig();
+    Config::CopyValues(cfg, *shard_cfg);
+    return shard_cfg;
+}
+
+template <typename DataType>
+void
+IndexNodeShardedWrapper<DataType>::SetShards(std::vector<std::unique_ptr<IndexNode>>&& shards) {
+    shards_ = std::move(shards);
+    shard_offsets_.assign(1, 0);
+    for (const auto& shard : shards_) {
+        shard_offsets_.push_back(shard_offsets_.back() + shard->Count());
+    }
+}
+
+template class knowhere::IndexNodeShardedWrapper<knowhere::fp32>;
+template class knowhere::IndexNodeShardedWrapper<knowhere::fp16>;
+template class knowhere::IndexNodeShardedWrapper<knowhere::bf16>;
+
+}  // namespace knowhere
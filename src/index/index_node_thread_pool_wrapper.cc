@@ -41,10 +41,25 @@ IndexNodeThreadPoolWrapper::Search(const DataSetPtr dataset, std::unique_ptr<Con
     return thread_pool_->push([&]() { return this->index_node_->Search(dataset, std::move(cfg), bitset); }).get();
 }
 
+expected<DataSetPtr>
+IndexNodeThreadPoolWrapper::SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                          const BitsetView& bitset, int64_t* ids, float* dis) const {
+    return thread_pool_
+        ->push([&]() { return this->index_node_->SearchWithBuf(dataset, std::move(cfg), bitset, ids, dis); })
+        .get();
+}
+
 expected<DataSetPtr>
 IndexNodeThreadPoolWrapper::RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
                                         const BitsetView& bitset) const {
     return thread_pool_->push([&]() { return this->index_node_->RangeSearch(dataset, std::move(cfg), bitset); }).get();
 }
 
+expected<DataSetPtr>
+IndexNodeThreadPoolWrapper::GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                          const BitsetView& bitset) const {
+    return thread_pool_->push([&]() { return this->index_node_->GroupBySearch(dataset, std::move(cfg), bitset); })
+        .get();
+}
+
 }  // namespace knowhere
@@ -9,11 +9,25 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <typeinfo>
+#include <vector>
+
+#include "cluster/centroid_hnsw.h"
+#include "cluster/kmeans/balanced_kmeans.h"
 #include "common/metric.h"
 #include "faiss/IndexBinaryFlat.h"
 #include "faiss/IndexBinaryIVF.h"
 #include "faiss/IndexFlat.h"
 #include "faiss/IndexFlatElkan.h"
+#include "faiss/IndexHNSW.h"
 #include "faiss/IndexIVFFlat.h"
 #include "faiss/IndexIVFPQ.h"
 #include "faiss/IndexIVFPQFastScan.h"
@@ -23,12 +37,30 @@
 #include "faiss/IndexScalarQuantizer.h"
 #include "faiss/VectorTransform.h"
 #include "faiss/index_io.h"
+#include "faiss/utils/Heap.h"
+#include "faiss/utils/random.h"
 #include "index/data_view_dense_index/index_node_with_data_view_refiner.h"
+#include "index/faiss_huge_pages.h"
+#include "index/faiss_mapped_regions.h"
 #include "index/ivf/ivf_config.h"
+#include "index/ivf/ivf_gpu_assign.h"
+#include "index/ivf/ivf_list_major.h"
+#include "index/ivf/ivf_list_split.h"
+#include "index/ivf/ivf_scalar_partition.h"
+#include "index/ivf/ivf_shared_quantizer.h"
+#include "index/ivf/ivf_tombstones.h"
 #include "index/ivf/ivfrbq_wrapper.h"
+#include "index/refine/refine_utils.h"
+#include "io/file_io.h"
 #include "io/memory_io.h"
 #include "knowhere/bitsetview_idselector.h"
+#include "knowhere/comp/rw_lock.h"
+#include "knowhere/comp/search_arena.h"
+#include "knowhere/comp/search_phases.h"
+#include "knowhere/comp/trace_span.h"
+#include "knowhere/comp/search_stats.h"
 #include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/time_recorder.h"
 #include "knowhere/dataset.h"
 #include "knowhere/expected.h"
 #include "knowhere/feature.h"
@@ -53,6 +85,15 @@ struct IndexDispatch<faiss::IndexIVFFlat> {
     using Tag = IVFFlatTag;
 };
 
+// bytes taken by the map from ids to their positions in the inverted lists
+template <class IndexType>
+size_t
+direct_map_size(const IndexType& index) {
+    const faiss::DirectMap& direct_map = index.direct_map;
+    return (direct_map.array.size() + direct_map.concurrentArray.size()) * sizeof(faiss::idx_t) +
+           direct_map.hashtable.size() * 2 * sizeof(faiss::idx_t);
+}
+
 template <typename DataType, typename IndexType>
 class IvfIndexNode : public IndexNode {
  public:
@@ -71,14 +112,35 @@ class IvfIndexNode : public IndexNode {
         search_pool_ = ThreadPool::GetGlobalSearchThreadPool();
         build_pool_ = ThreadPool::GetGlobalBuildThreadPool();
     }
+    ~IvfIndexNode() override {
+        WaitForCompaction();
+    }
     Status
     Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
     Status
     Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
+    Status
+    Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) override;
     expected<DataSetPtr>
-    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+    Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
+        return SearchInto(dataset, std::move(cfg), bitset, nullptr, nullptr);
+    }
+    expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const override {
+        return SearchInto(dataset, std::move(cfg), bitset, ids, dis);
+    }
     expected<DataSetPtr>
     RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+    expected<DataSetPtr>
+    GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
+    // the indexes whose lists are scanned by a group-by search directly, the others read their iterators
+    static constexpr bool
+    is_group_by_supported() {
+        return std::is_same_v<faiss::IndexIVFFlat, IndexType> || std::is_same_v<faiss::IndexIVFFlatCC, IndexType> ||
+               std::is_same_v<faiss::IndexIVFScalarQuantizer, IndexType> ||
+               std::is_same_v<faiss::IndexIVFScalarQuantizerCC, IndexType>;
+    }
     static constexpr bool
     is_ann_iterator_supported() {
         return (std::is_same<faiss::IndexIVFFlatCC, IndexType>::value ||
@@ -88,12 +150,64 @@ class IvfIndexNode : public IndexNode {
                 std::is_same<faiss::IndexScaNN, IndexType>::value ||
                 std::is_same<IndexIVFRaBitQWrapper, IndexType>::value);
     }
+    // the indexes whose lists hold codes of single rows, so that rows can be soft-deleted and their lists compacted
+    static constexpr bool
+    is_tombstone_supported() {
+        return !std::is_same_v<IndexType, faiss::IndexScaNN> && !std::is_same_v<IndexType, IndexIVFRaBitQWrapper>;
+    }
+    // the indexes searched with the generic faiss IVF search, which takes a list filter and list radii
+    static constexpr bool
+    is_list_filter_supported() {
+        return std::is_same_v<IndexType, faiss::IndexIVFFlat> || std::is_same_v<IndexType, faiss::IndexIVFPQ> ||
+               std::is_same_v<IndexType, faiss::IndexIVFScalarQuantizer>;
+    }
+    // the growing indexes whose large lists are split by Add(), see ivf_list_split.h
+    static constexpr bool
+    is_list_split_supported() {
+        return std::is_same_v<IndexType, faiss::IndexIVFFlatCC> ||
+               std::is_same_v<IndexType, faiss::IndexIVFScalarQuantizerCC>;
+    }
+    // the indexes with a flat quantizer that can be shared, whose searches scan the lists of CoarseProbes
+    static constexpr bool
+    is_coarse_probes_supported() {
+        return is_list_filter_supported() || std::is_same_v<IndexType, faiss::IndexIVFFlatCC> ||
+               std::is_same_v<IndexType, faiss::IndexIVFScalarQuantizerCC>;
+    }
     expected<std::vector<IndexNode::IteratorPtr>>
     AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset,
                 bool use_knowhere_search_pool) const override;
     expected<DataSetPtr>
     GetVectorByIds(const DataSetPtr dataset) const override;
 
+    // the quantizer of a deserialized index is shared with the indexes loaded with the same centroids
+    const void*
+    SharedCoarseQuantizer() const override {
+        if constexpr (is_coarse_probes_supported()) {
+            if (shared_quantizer_ != nullptr && index_ != nullptr && index_->quantizer == shared_quantizer_.get()) {
+                return shared_quantizer_.get();
+            }
+        }
+        return nullptr;
+    }
+
+    expected<std::shared_ptr<const CoarseProbes>>
+    CoarseSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg) const override;
+
+    // the lists are partitioned by the scalar info given to Add(), see IvfScalarPartition
+    bool
+    IsAdditionalScalarSupported(bool is_mv_only) const override {
+        return is_mv_only && is_list_filter_supported();
+    }
+
+    bool
+    IsIncrementalAddSupported() const override {
+        return true;
+    }
+
+    // the lists whose share of deleted entries crosses kCompactionMinDeadRatio are compacted in the background
+    Status
+    DeleteByIds(const DataSetPtr dataset) override;
+
     static Status
     StaticConfigCheck(const Config& cfg, PARAM_TYPE paramType, std::string& msg) {
         auto ivf_cfg = static_cast<const IvfConfig&>(cfg);
@@ -157,6 +271,30 @@ class IvfIndexNode : public IndexNode {
         return CommonHasRawData();
     }
 
+    // The centroids are read into memory even when the lists are mapped, and the indexes that hold the raw data add
+    //   a direct map of an id per row at the load, that is not part of the file. The rows come from vec_field_size_gb.
+    static expected<Resource>
+    StaticEstimateLoadResource(const float file_size, const knowhere::BaseConfig& config, const IndexVersion& version) {
+        const IvfConfig& ivf_cfg = static_cast<const IvfConfig&>(config);
+        const bool mmap = ivf_cfg.enable_mmap.value_or(false);
+        if (!ivf_cfg.dim.has_value() || ivf_cfg.dim.value() <= 0) {
+            return mmap ? Resource{0.0f, file_size} : Resource{file_size, 0.0f};
+        }
+        const float vector_bytes = std::is_same_v<DataType, bin1> ? ivf_cfg.dim.value() / 8.0f
+                                                                  : ivf_cfg.dim.value() * sizeof(DataType);
+        const float centroid_bytes =
+            std::is_same_v<DataType, bin1> ? ivf_cfg.dim.value() / 8.0f : ivf_cfg.dim.value() * sizeof(float);
+        const float centroids_gb = ivf_cfg.nlist.value() * centroid_bytes / (1024.0f * 1024.0f * 1024.0f);
+        float direct_map_gb = 0.0f;
+        if (StaticHasRawData(config, version) && !std::is_same_v<IndexType, faiss::IndexScaNN>) {
+            direct_map_gb = ivf_cfg.vec_field_size_gb.value_or(0.0f) / vector_bytes * sizeof(faiss::idx_t);
+        }
+        if (mmap) {
+            return Resource{std::min(centroids_gb, file_size) + direct_map_gb, file_size};
+        }
+        return Resource{file_size + direct_map_gb, 0.0f};
+    }
+
     bool
     HasRawData(const std::string& metric_type) const override {
         if (!index_) {
@@ -176,12 +314,22 @@ class IvfIndexNode : public IndexNode {
     }
     Status
     Serialize(BinarySet& binset) const override {
-        return this->SerializeImpl(binset, typename IndexDispatch<IndexType>::Tag{});
+        std::shared_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+        RETURN_IF_ERROR(this->SerializeImpl(binset, typename IndexDispatch<IndexType>::Tag{}));
+        if (scalar_partition_ != nullptr) {
+            scalar_partition_->Serialize(binset);
+        }
+        if (tombstones_ != nullptr) {
+            tombstones_->Serialize(binset);
+        }
+        return Status::success;
     }
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) override;
     Status
     DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> cfg) override;
+    Status
+    SerializeToFile(const std::string& filename) const override;
 
     static std::unique_ptr<BaseConfig>
     StaticCreateConfig() {
@@ -216,6 +364,15 @@ class IvfIndexNode : public IndexNode {
         return StaticCreateConfig();
     };
 
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        std::vector<MappedRegion> regions;
+        if (index_ != nullptr) {
+            AppendMappedRegions(index_.get(), regions);
+        }
+        return regions;
+    }
+
     int64_t
     Dim() const override {
         if (!index_) {
@@ -225,6 +382,69 @@ class IvfIndexNode : public IndexNode {
     };
     int64_t
     Size() const override {
+        return MemoryBreakdown().Total();
+    }
+    // the lists of an ArrayInvertedLists are counted exactly, the other lists are estimated
+    MemoryUsage
+    MemoryBreakdown() const override {
+        std::shared_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+        MemoryUsage usage;
+        if (!AddListsMemory(usage)) {
+            usage.Add(memory_section::CODES, EstimatedSize());
+        }
+        usage.Add(memory_section::OTHER, huge_page_overhead_ + (scalar_partition_ ? scalar_partition_->Size() : 0));
+        usage.Add(memory_section::IDS, tombstones_ ? tombstones_->Size() : 0);
+        {
+            std::lock_guard radii_lock(list_radii_mutex_);
+            usage.Add(memory_section::CACHE, list_radii_ ? VectorBytes(*list_radii_) : 0);
+        }
+        return usage;
+    }
+    // adds the codes, the ids, the direct map and the coarse quantizer of array lists to usage, false for other lists
+    bool
+    AddListsMemory(MemoryUsage& usage) const {
+        if constexpr (std::is_same<IndexType, faiss::IndexScaNN>::value ||
+                      std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
+            return false;
+        } else {
+            if (!index_) {
+                return true;
+            }
+            const auto* lists = dynamic_cast<const faiss::ArrayInvertedLists*>(index_->invlists);
+            if (lists == nullptr) {
+                return false;
+            }
+            auto bytes = [](const auto& v) {
+                using T = typename std::decay_t<decltype(v)>::value_type;
+                return static_cast<int64_t>((v.is_owned ? v.owned_data.capacity() : v.view_size) * sizeof(T));
+            };
+            for (size_t i = 0; i < lists->nlist; i++) {
+                usage.Add(memory_section::CODES, bytes(lists->codes[i]));
+                usage.Add(memory_section::IDS, bytes(lists->ids[i]));
+            }
+            for (const auto& norms : lists->code_norms) {
+                usage.Add(memory_section::CODES, VectorBytes(norms));
+            }
+            usage.Add(memory_section::IDS, direct_map_size(*index_));
+            if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
+                usage.Add(memory_section::QUANTIZER, index_->quantizer->ntotal * index_->quantizer->code_size);
+            } else {
+                const auto* flat = dynamic_cast<const faiss::IndexFlatCodes*>(index_->quantizer);
+                usage.Add(memory_section::QUANTIZER, flat != nullptr ? bytes(flat->codes)
+                                                                     : index_->quantizer->ntotal * index_->d *
+                                                                           static_cast<int64_t>(sizeof(float)));
+            }
+            if constexpr (std::is_same<IndexType, faiss::IndexIVFPQ>::value) {
+                const auto& pq = index_->pq;
+                usage.Add(memory_section::QUANTIZER, (pq.M * pq.ksub * pq.dsub + index_->precomputed_table.size()) *
+                                                         static_cast<int64_t>(sizeof(float)));
+            }
+            return true;
+        }
+    }
+    // of the codes, the ids and the centroids
+    int64_t
+    EstimatedSize() const {
         if (!index_) {
             return 0;
         }
@@ -232,13 +452,13 @@ class IvfIndexNode : public IndexNode {
             auto nb = index_->invlists->compute_ntotal();
             auto nlist = index_->nlist;
             auto code_size = index_->code_size;
-            return ((nb + nlist) * (code_size + sizeof(int64_t)));
+            return ((nb + nlist) * (code_size + sizeof(int64_t))) + direct_map_size(*index_);
         }
         if constexpr (std::is_same<IndexType, faiss::IndexIVFFlatCC>::value) {
             auto nb = index_->invlists->compute_ntotal();
             auto nlist = index_->nlist;
             auto code_size = index_->code_size;
-            return (nb * code_size + nb * sizeof(int64_t) + nlist * code_size);
+            return (nb * code_size + nb * sizeof(int64_t) + nlist * code_size) + direct_map_size(*index_);
         }
         if constexpr (std::is_same<IndexType, faiss::IndexIVFPQ>::value) {
             auto nb = index_->invlists->compute_ntotal();
@@ -250,7 +470,7 @@ class IvfIndexNode : public IndexNode {
             auto capacity = nb * code_size + nb * sizeof(int64_t) + nlist * d * sizeof(float);
             auto centroid_table = pq.M * pq.ksub * pq.dsub * sizeof(float);
             auto precomputed_table = nlist * pq.M * pq.ksub * sizeof(float);
-            return (capacity + centroid_table + precomputed_table);
+            return (capacity + centroid_table + precomputed_table) + direct_map_size(*index_);
         }
         if constexpr (std::is_same<IndexType, faiss::IndexScaNN>::value) {
             return index_->size();
@@ -259,19 +479,28 @@ class IvfIndexNode : public IndexNode {
             auto nb = index_->invlists->compute_ntotal();
             auto code_size = index_->code_size;
             auto nlist = index_->nlist;
-            return (nb * code_size + nb * sizeof(int64_t) + 2 * code_size + nlist * code_size);
+            // interleaved lists are padded to whole blocks
+            size_t codes_size = nb * code_size;
+            if (const size_t nvec = index_->interleaved_nvec(); nvec > 0) {
+                codes_size = 0;
+                for (size_t i = 0; i < nlist; i++) {
+                    codes_size += (index_->invlists->list_size(i) + nvec - 1) / nvec * nvec * code_size;
+                }
+            }
+            return (codes_size + nb * sizeof(int64_t) + 2 * code_size + nlist * code_size) + direct_map_size(*index_);
         }
         if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
             auto nb = index_->invlists->compute_ntotal();
             auto nlist = index_->nlist;
             auto code_size = index_->code_size;
-            return (nb * code_size + nb * sizeof(int64_t) + nlist * code_size);
+            return (nb * code_size + nb * sizeof(int64_t) + nlist * code_size) + direct_map_size(*index_);
         }
         if constexpr (std::is_same<IndexType, faiss::IndexIVFScalarQuantizerCC>::value) {
             auto nb = index_->invlists->compute_ntotal();
             auto code_size = index_->code_size;
             auto nlist = index_->nlist;
-            return (nb * code_size + nb * sizeof(int64_t) + 2 * code_size + nlist * sizeof(float));
+            return (nb * code_size + nb * sizeof(int64_t) + 2 * code_size + nlist * sizeof(float)) +
+                   direct_map_size(*index_);
         }
         if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
             return index_->size();
@@ -344,12 +573,14 @@ class IvfIndexNode : public IndexNode {
     // TODO: If SCANN support Iterator, raw_distance() function should be override.
     class iterator : public IndexIterator {
      public:
+        // hold keeps the bits of bitset alive, and the lists from being compacted while the iterator scans them
         iterator(const IndexType* index, std::unique_ptr<float[]>&& copied_query, const BitsetView& bitset,
                  size_t nprobe, bool larger_is_closer, const float refine_ratio = 0.5f,
-                 bool use_knowhere_search_pool = true)
+                 bool use_knowhere_search_pool = true, std::shared_ptr<const void> hold = nullptr)
             : IndexIterator(larger_is_closer, use_knowhere_search_pool, refine_ratio),
               index_(index),
-              copied_query_(std::move(copied_query)) {
+              copied_query_(std::move(copied_query)),
+              hold_(std::move(hold)) {
             if (!bitset.empty()) {
                 bw_idselector_ = std::make_unique<BitsetViewIDSelector>(bitset);
                 ivf_search_params_.sel = bw_idselector_.get();
@@ -357,13 +588,15 @@ class IvfIndexNode : public IndexNode {
 
             ivf_search_params_.nprobe = nprobe;
             ivf_search_params_.max_codes = 0;
-
-            workspace_ = index_->getIteratorWorkspace(copied_query_.get(), &ivf_search_params_);
         }
 
      protected:
         void
         next_batch(std::function<void(const std::vector<DistId>&)> batch_handler) override {
+            // created by the first Next(), so that AnnIterator() doesn't order the centroids of every query
+            if (workspace_ == nullptr) {
+                workspace_ = index_->getIteratorWorkspace(copied_query_.get(), &ivf_search_params_);
+            }
             index_->getIteratorNextBatch(workspace_.get(), this->res_.size());
             batch_handler(workspace_->dists);
             workspace_->dists.clear();
@@ -387,15 +620,122 @@ class IvfIndexNode : public IndexNode {
         std::unique_ptr<float[]> copied_query_ = nullptr;
         std::unique_ptr<BitsetViewIDSelector> bw_idselector_ = nullptr;
         faiss::IVFSearchParameters ivf_search_params_;
+        std::shared_ptr<const void> hold_;
     };
 
+    // the list radii of the current index for adaptive nprobe, computed on the first use and after rows are added
+    std::shared_ptr<const std::vector<float>>
+    GetListRadii() const;
+
+    // runs task(task_idx) for every task_idx in [0, num_tasks) on the search pool and waits for all of them
+    void
+    RunSearchTasks(const size_t num_tasks, const std::function<void(size_t)>& task) const;
+
+    // the vectors of every list that pass a selective bitset, so that the search skips the lists without any
+    //   and gathers the few ones of sparse lists
+    std::unique_ptr<faiss::IVFListFilter>
+    BuildListFilter(const BitsetView& bitset) const;
+
+    // the bitset of a search with the deleted rows filtered out as well, 'buffer' keeps the combined bits.
+    //   must be called while tombstone_mutex_ is held.
+    BitsetView
+    FilterTombstones(const BitsetView& bitset, std::vector<uint8_t>& buffer) const {
+        return tombstones_ != nullptr ? tombstones_->Filter(bitset, index_->ntotal, buffer) : bitset;
+    }
+
+    // starts the background compaction of the lists with many deleted entries, unless it runs already
+    void
+    ScheduleCompaction();
+
+    // stops the background compaction, must not be called from the build pool
+    void
+    WaitForCompaction();
+
+    // compacts the lists with many deleted entries one at a time, while searches are blocked. Returns false if it
+    //   stopped before it compacted all of them, because iterators scan the lists or the compaction is stopped.
+    bool
+    CompactLists();
+
+    // makes sure that ids map to their positions in the inverted lists in O(1). The map comes with deserialized
+    //   indexes that have raw data, and is built on first use otherwise
+    void
+    EnsureDirectMap() const;
+
+    // makes index_ hold the quantizer shared by the indexes with the same centroids, if it can be shared
+    void
+    ShareQuantizer();
+
+    // splits the lists with more than max_list_size rows in two, the 2-means run while searches go on and the entries
+    //   are moved while they are blocked. A list is split once per call, it is split again by the next ones if its
+    //   halves are still too large.
+    void
+    SplitLargeLists(int64_t max_list_size);
+
+    // searches a batch by the inverted lists instead of by the queries, see ivf_list_major.h. The lists of the
+    //   queries are the ones of probes if it is set.
+    void
+    SearchListMajor(const float* x, const int64_t rows, const int64_t k, const int64_t nprobe, const BitsetView& bitset,
+                    const faiss::SearchParameters* coarse_params, const CoarseProbes* probes, float* distances,
+                    int64_t* ids) const;
+
+    // searches each query with its probes split in splits tasks, for the small batches that leave search threads
+    //   idle. The top-k of the splits are merged.
+    void
+    SearchSplitProbes(const float* x, const int64_t rows, const int64_t k, const int64_t nprobe, const size_t splits,
+                      const BitsetView& bitset, const faiss::SearchParameters* coarse_params,
+                      const CoarseProbes* probes, float* distances, int64_t* ids) const;
+
+    // the results go to ids_buf and dis_buf if they are set, to new buffers otherwise
+    expected<DataSetPtr>
+    SearchInto(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset, int64_t* ids_buf,
+               float* dis_buf) const;
+
+    // moves the inverted lists and the centroids of index_ into huge pages, returns the bytes of the buffer beyond them
+    size_t
+    MoveToHugePagesIfRequested(const Config& config) {
+        if (!static_cast<const BaseConfig&>(config).use_huge_pages.value()) {
+            return 0;
+        }
+        HugePagePacker packer;
+        packer.Add(index_.get());
+        return packer.Pack();
+    }
+
+    // the quantizer of index_ if it is shared with other indexes, which then does not own it
+    std::shared_ptr<faiss::Index> shared_quantizer_ = nullptr;
     std::unique_ptr<IndexType> index_;
+    // the bytes the huge page buffer of the inverted lists holds beyond them, if requested during the load
+    size_t huge_page_overhead_ = 0;
+    // the rows of the lists grouped by the category of the partition key, if Add() was given scalar info
+    std::unique_ptr<IvfScalarPartition> scalar_partition_ = nullptr;
     std::shared_ptr<ThreadPool> search_pool_;
     // Faiss uses OpenMP for training/building the index and we have no control
     // over those threads. build_pool_ is used to make sure the OMP threads
     // spawded during index training/building can inherit the low nice value of
     // threads in build_pool_.
     std::shared_ptr<ThreadPool> build_pool_;
+    mutable std::mutex list_radii_mutex_;
+    mutable std::shared_ptr<const std::vector<float>> list_radii_ = nullptr;
+    mutable const IndexType* list_radii_index_ = nullptr;
+    mutable int64_t list_radii_ntotal_ = -1;
+    mutable std::mutex direct_map_mutex_;
+
+    // a list is compacted once this share of its entries is deleted
+    static constexpr float kCompactionMinDeadRatio = 0.2f;
+    // the entries of the lists that are compacted while searches are blocked
+    static constexpr size_t kCompactionBatchSize = 262144;
+    // the soft-deleted rows, nullptr if none. Searches and adds hold tombstone_mutex_ shared, deletes and the
+    //   compaction of a list exclusively.
+    std::unique_ptr<IvfTombstones> tombstones_ = nullptr;
+    mutable ReaderBiasedRWLock tombstone_mutex_;
+    // shared with the live iterators, the lists are not compacted while they scan them
+    std::shared_ptr<const char> iterator_pin_ = std::make_shared<const char>(0);
+    std::mutex compaction_mutex_;
+    bool compaction_running_ = false;
+    std::atomic<bool> compaction_stop_{false};
+    std::optional<folly::Future<folly::Unit>> compaction_;
+    // one split of the large lists at a time
+    std::mutex split_mutex_;
 };
 
 }  // namespace knowhere
@@ -443,6 +783,86 @@ to_index_flat(std::unique_ptr<faiss::IndexFlat>&& index) {
     return std::make_unique<faiss::IndexFlat>(std::move(*index));
 }
 
+// the quantizer the k-means of the training assigns the vectors with, to_index_flat() turns it into an IndexFlat
+std::unique_ptr<faiss::IndexFlat>
+training_quantizer(int64_t dim, faiss::MetricType metric, bool use_elkan, bool gpu_train) {
+    if (gpu_train) {
+        return std::make_unique<GpuAssignIndexFlat>(dim, metric, true);
+    }
+    return std::make_unique<faiss::IndexFlatElkan>(dim, metric, false, use_elkan);
+}
+
+// adds the rows to index, with the assignments to the lists on the GPU if gpu_assign is set and the quantizer of index
+//   is a flat one
+template <typename IndexType>
+void
+add_with_gpu_assign(IndexType* index, int64_t rows, const float* data, bool gpu_assign) {
+    auto ivf = dynamic_cast<faiss::IndexIVF*>(static_cast<faiss::Index*>(index));
+    if (!gpu_assign || rows < GpuAssignIndexFlat::kMinGpuQueries || ivf == nullptr || ivf->quantizer == nullptr ||
+        typeid(*ivf->quantizer) != typeid(faiss::IndexFlat)) {
+        index->add(rows, data);
+        return;
+    }
+    faiss::Index* quantizer = ivf->quantizer;
+    GpuAssignIndexFlat gpu_quantizer(static_cast<const faiss::IndexFlat&>(*quantizer));
+    ivf->quantizer = &gpu_quantizer;
+    try {
+        index->add(rows, data);
+    } catch (...) {
+        ivf->quantizer = quantizer;
+        throw;
+    }
+    ivf->quantizer = quantizer;
+}
+
+// trains index, with the assignments of the k-means of the PQ codebooks on the GPU if gpu_train is set
+template <typename IndexType>
+void
+train_with_gpu_pq(IndexType* index, faiss::ProductQuantizer& pq, int64_t rows, const float* data, bool gpu_train) {
+    std::unique_ptr<GpuAssignIndexFlat> pq_assign;
+    if (gpu_train) {
+        pq_assign = std::make_unique<GpuAssignIndexFlat>(pq.dsub, faiss::METRIC_L2);
+        pq.assign_index = pq_assign.get();
+    }
+    try {
+        index->train(rows, data);
+    } catch (...) {
+        pq.assign_index = nullptr;
+        throw;
+    }
+    pq.assign_index = nullptr;
+}
+
+// fills the quantizer of ivf with the centroids of a balanced k-means if cfg.balanced_kmeans is set, the training of
+//   ivf then keeps them. Like the faiss k-means, it runs on at most max_points_per_centroid rows per list.
+void
+train_balanced_quantizer(faiss::IndexIVF& ivf, int64_t rows, const float* data, const IvfConfig& cfg) {
+    if (!cfg.balanced_kmeans.value()) {
+        return;
+    }
+    const int64_t dim = ivf.d;
+    const int64_t nlist = ivf.nlist;
+    const int64_t max_rows = static_cast<int64_t>(ivf.cp.max_points_per_centroid) * nlist;
+    std::vector<float> sampled;
+    if (rows > max_rows) {
+        std::vector<int> perm(rows);
+        faiss::rand_perm(perm.data(), rows, ivf.cp.seed);
+        sampled.resize(max_rows * dim);
+        for (int64_t i = 0; i < max_rows; i++) {
+            std::copy_n(data + static_cast<int64_t>(perm[i]) * dim, dim, sampled.data() + i * dim);
+        }
+        data = sampled.data();
+        rows = max_rows;
+    }
+    std::vector<float> centroids(nlist * dim);
+    std::vector<uint32_t> ids(rows);
+    BalancedKmeans(data, rows, dim, nlist, ivf.cp.niter, cfg.balanced_kmeans_ratio.value(), ivf.cp.spherical,
+                   centroids.data(), ids.data());
+    ivf.quantizer->reset();
+    ivf.quantizer->add(nlist, centroids.data());
+    ivf.quantizer->is_trained = true;
+}
+
 expected<faiss::ScalarQuantizer::QuantizerType>
 get_ivf_sq_quantizer_type(int code_size) {
     switch (code_size) {
@@ -459,12 +879,486 @@ get_ivf_sq_quantizer_type(int code_size) {
                 Status::invalid_args, fmt::format("current code size {} not in (4, 6, 8, 16)", code_size));
     }
 }
+
+// the filter ratio of a bitset above which the vectors that pass it are collected per list before a search
+constexpr float kIvfListFilterThreshold = 0.9f;
+// lists with at most 1 / kIvfListGatherRatio of their vectors passing the bitset are scanned by gathering them
+constexpr size_t kIvfListGatherRatio = 8;
+
+// replaces the trained flat quantizer of an IVF index with an HNSW graph over the same centroids
+void
+use_hnsw_quantizer(faiss::IndexIVF* index, const IvfConfig& cfg) {
+    std::vector<float> centroids(index->nlist * index->d);
+    index->quantizer->reconstruct_n(0, index->nlist, centroids.data());
+    // the ef of the search is used by the assignment during the build
+    auto hnsw = BuildCentroidHnsw(centroids.data(), index->nlist, index->d, index->metric_type,
+                                  cfg.coarse_hnsw_m.value(), cfg.coarse_ef_construction.value(), cfg.coarse_ef.value());
+
+    if (index->own_fields) {
+        delete index->quantizer;
+    }
+    index->quantizer = hnsw.release();
+    index->own_fields = true;
+}
+
+// the parameters of the coarse search, nullptr for a flat quantizer
+faiss::SearchParameters*
+coarse_search_params(const faiss::IndexIVF& index, const IvfConfig& cfg, const int64_t nprobe,
+                     faiss::SearchParametersHNSW& hnsw_params) {
+    if (dynamic_cast<const faiss::IndexHNSW*>(index.quantizer) == nullptr) {
+        return nullptr;
+    }
+    hnsw_params.efSearch = std::max<int64_t>(cfg.coarse_ef.value(), nprobe);
+    return &hnsw_params;
+}
+
+// per list, the max distance between the centroid and the vectors of the list, as they are searched
+template <typename IndexType>
+std::vector<float>
+compute_list_radii(const IndexType& index) {
+    std::vector<float> radii(index.nlist, 0.0f);
+#pragma omp parallel
+    {
+        std::vector<float> centroid(index.d);
+        std::vector<float> recons(index.d);
+#pragma omp for schedule(dynamic)
+        for (int64_t list_no = 0; list_no < (int64_t)index.nlist; list_no++) {
+            const size_t list_size = index.invlists->list_size(list_no);
+            if (list_size == 0) {
+                continue;
+            }
+            index.quantizer->reconstruct(list_no, centroid.data());
+            float max_dis = 0.0f;
+            for (size_t offset = 0; offset < list_size; offset++) {
+                index.reconstruct_from_offset(list_no, offset, recons.data());
+                // IVF_FLAT keeps the raw vectors for COSINE and normalizes the distances instead
+                if constexpr (std::is_same_v<IndexType, faiss::IndexIVFFlat>) {
+                    if (index.is_cosine) {
+                        NormalizeVec(recons.data(), index.d);
+                    }
+                }
+                max_dis = std::max(max_dis, faiss::fvec_L2sqr(centroid.data(), recons.data(), index.d));
+            }
+            radii[list_no] = std::sqrt(max_dis);
+        }
+    }
+    return radii;
+}
+
+// whether the codes of other can be appended to the lists of index as they are, which takes the same coarse
+//   centroids and the same fine quantizer
+template <class IndexType>
+bool
+is_ivf_merge_compatible(const IndexType& index, const IndexType& other) {
+    if (index.d != other.d || index.nlist != other.nlist || index.code_size != other.code_size ||
+        index.metric_type != other.metric_type || index.quantizer->ntotal != other.quantizer->ntotal) {
+        return false;
+    }
+    if constexpr (std::is_same_v<IndexType, faiss::IndexBinaryIVF>) {
+        std::vector<uint8_t> c(index.code_size), other_c(index.code_size);
+        for (size_t i = 0; i < index.nlist; i++) {
+            index.quantizer->reconstruct(i, c.data());
+            other.quantizer->reconstruct(i, other_c.data());
+            if (c != other_c) {
+                return false;
+            }
+        }
+        return true;
+    } else {
+        std::vector<float> c(index.d), other_c(index.d);
+        for (size_t i = 0; i < index.nlist; i++) {
+            index.quantizer->reconstruct(i, c.data());
+            other.quantizer->reconstruct(i, other_c.data());
+            if (c != other_c) {
+                return false;
+            }
+        }
+        if (index.is_cosine != other.is_cosine || index.by_residual != other.by_residual) {
+            return false;
+        }
+        if constexpr (std::is_same_v<IndexType, faiss::IndexIVFPQ>) {
+            return index.pq.M == other.pq.M && index.pq.nbits == other.pq.nbits &&
+                   index.pq.centroids == other.pq.centroids;
+        }
+        if constexpr (std::is_base_of_v<faiss::IndexIVFScalarQuantizer, IndexType>) {
+            return index.sq.qtype == other.sq.qtype && index.sq.trained == other.sq.trained &&
+                   index.interleaved_nvec() == other.interleaved_nvec();
+        }
+        return true;
+    }
+}
+
+// appends the entries of every list of src to the same list of dst, with their ids shifted by id_offset. The codes
+//   are copied by segments, in the layout of the lists
+void
+append_inverted_lists(faiss::InvertedLists* dst, const faiss::InvertedLists* src, faiss::idx_t id_offset) {
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t list_no = 0; list_no < (int64_t)src->nlist; list_no++) {
+        std::vector<faiss::idx_t> ids;
+        for (size_t segment_no = 0; segment_no < src->get_segment_num(list_no); segment_no++) {
+            const size_t size = src->get_segment_size(list_no, segment_no);
+            if (size == 0) {
+                continue;
+            }
+            const size_t offset = src->get_segment_offset(list_no, segment_no);
+            const faiss::idx_t* src_ids = src->get_ids(list_no, offset);
+            ids.resize(size);
+            for (size_t j = 0; j < size; j++) {
+                ids[j] = src_ids[j] + id_offset;
+            }
+            src->release_ids(list_no, src_ids);
+            const uint8_t* codes = src->get_codes(list_no, offset);
+            const float* code_norms = src->get_code_norms(list_no, offset);
+            dst->add_entries(list_no, size, ids.data(), codes, code_norms);
+            src->release_code_norms(list_no, code_norms);
+            src->release_codes(list_no, codes);
+        }
+    }
+}
 }  // namespace
 
+template <typename DataType, typename IndexType>
+std::shared_ptr<const std::vector<float>>
+IvfIndexNode<DataType, IndexType>::GetListRadii() const {
+    std::lock_guard<std::mutex> lock(list_radii_mutex_);
+    if (list_radii_ == nullptr || list_radii_index_ != index_.get() || list_radii_ntotal_ != index_->ntotal) {
+        list_radii_ = std::make_shared<const std::vector<float>>(compute_list_radii(*index_));
+        list_radii_index_ = index_.get();
+        list_radii_ntotal_ = index_->ntotal;
+    }
+    return list_radii_;
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::ShareQuantizer() {
+    shared_quantizer_ = nullptr;
+    if constexpr (is_coarse_probes_supported()) {
+        if (!index_->own_fields) {
+            return;
+        }
+        std::unique_ptr<faiss::Index> quantizer(index_->quantizer);
+        auto shared = IvfSharedQuantizers::Share(quantizer);
+        if (shared == nullptr) {
+            quantizer.release();
+            return;
+        }
+        // the own quantizer is freed if an identical one is shared already
+        index_->quantizer = shared.get();
+        index_->own_fields = false;
+        shared_quantizer_ = std::move(shared);
+    }
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::SplitLargeLists(int64_t max_list_size) {
+    if constexpr (is_list_split_supported()) {
+        std::lock_guard<std::mutex> split_lock(split_mutex_);
+        std::vector<size_t> lists;
+        std::vector<std::vector<float>> centroids;
+        {
+            std::shared_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+            if (!IsIvfListSplitSupported(*index_)) {
+                return;
+            }
+            for (size_t list_no = 0; list_no < index_->nlist; list_no++) {
+                if (index_->invlists->list_size(list_no) <= static_cast<size_t>(max_list_size)) {
+                    continue;
+                }
+                auto list_centroids = TrainIvfListSplit(*index_, list_no);
+                if (!list_centroids.empty()) {
+                    lists.push_back(list_no);
+                    centroids.push_back(std::move(list_centroids));
+                }
+            }
+        }
+        if (lists.empty()) {
+            return;
+        }
+
+        std::unique_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+        // iterators scan the lists, the next add splits them
+        if (iterator_pin_.use_count() > 1) {
+            return;
+        }
+        TimeRecorder rc("IVF list split");
+        size_t n_split = 0;
+        for (size_t i = 0; i < lists.size(); i++) {
+            n_split += ApplyIvfListSplit(*index_, lists[i], centroids[i]);
+        }
+        if (n_split == 0) {
+            return;
+        }
+        // the split lists have a quantizer of their own
+        shared_quantizer_ = nullptr;
+        if (!index_->direct_map.no()) {
+            std::lock_guard<std::mutex> direct_map_lock(direct_map_mutex_);
+            const auto type = index_->direct_map.type;
+            index_->make_direct_map(false);
+            index_->make_direct_map(true, type);
+        }
+        if (tombstones_ != nullptr) {
+            tombstones_->Refresh(index_->invlists);
+        }
+        LOG_KNOWHERE_INFO_ << "split " << n_split << " lists of " << Type() << " into " << index_->nlist << " lists";
+        rc.ElapseFromBegin("done");
+    }
+}
+
+template <typename DataType, typename IndexType>
+expected<std::shared_ptr<const CoarseProbes>>
+IvfIndexNode<DataType, IndexType>::CoarseSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg) const {
+    using Ret = expected<std::shared_ptr<const CoarseProbes>>;
+    if constexpr (!is_coarse_probes_supported()) {
+        return Ret::Err(Status::not_implemented, "CoarseSearch is not supported for " + Type());
+    } else {
+        if (!index_ || !index_->is_trained) {
+            return Ret::Err(Status::empty_index, "index not loaded");
+        }
+        const IvfConfig& ivf_cfg = static_cast<const IvfConfig&>(*cfg);
+        const int64_t rows = dataset->GetRows();
+        const int64_t dim = dataset->GetDim();
+        auto x = static_cast<const float*>(dataset->GetTensor());
+        std::unique_ptr<float[]> copied_data = nullptr;
+        if (IsMetricType(ivf_cfg.metric_type.value(), knowhere::metric::COSINE)) {
+            copied_data = CopyAndNormalizeVecs(x, rows, dim);
+            x = copied_data.get();
+        }
+
+        auto probes = std::make_shared<CoarseProbes>();
+        probes->quantizer = index_->quantizer;
+        probes->rows = rows;
+        probes->nprobe = std::min<int64_t>(ivf_cfg.nprobe.value(), index_->nlist);
+        probes->lists.resize(rows * probes->nprobe);
+        probes->distances.resize(rows * probes->nprobe);
+        faiss::SearchParametersHNSW coarse_hnsw_params;
+        const faiss::SearchParameters* coarse_params =
+            coarse_search_params(*index_, ivf_cfg, probes->nprobe, coarse_hnsw_params);
+        try {
+            // a chunk of queries per task, as the coarse search of a list-major search
+            const size_t num_tasks = std::min<size_t>(std::max<size_t>(search_pool_->size(), 1), rows);
+            RunSearchTasks(num_tasks, [&](const size_t task_idx) {
+                const size_t i0 = rows * task_idx / num_tasks;
+                const size_t i1 = rows * (task_idx + 1) / num_tasks;
+                if (i1 > i0) {
+                    index_->quantizer->search(i1 - i0, x + i0 * dim, probes->nprobe,
+                                              probes->distances.data() + i0 * probes->nprobe,
+                                              probes->lists.data() + i0 * probes->nprobe, coarse_params);
+                }
+            });
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return Ret::Err(Status::faiss_inner_error, e.what());
+        }
+        return std::shared_ptr<const CoarseProbes>(std::move(probes));
+    }
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::RunSearchTasks(const size_t num_tasks,
+                                                  const std::function<void(size_t)>& task) const {
+    std::vector<folly::Future<folly::Unit>> futs;
+    futs.reserve(num_tasks);
+    for (size_t i = 0; i < num_tasks; i++) {
+        futs.emplace_back(search_pool_->push([&, task_idx = i] {
+            ThreadPool::ScopedSearchOmpSetter setter(1);
+            task(task_idx);
+        }));
+    }
+    WaitAllSuccess(futs);
+}
+
+template <typename DataType, typename IndexType>
+std::unique_ptr<faiss::IVFListFilter>
+IvfIndexNode<DataType, IndexType>::BuildListFilter(const BitsetView& bitset) const {
+    const size_t nlist = index_->nlist;
+    const size_t num_tasks = std::max<size_t>(search_pool_->size(), 1);
+    const BitsetViewIDSelector bw_idselector(bitset);
+
+    auto filter = std::make_unique<faiss::IVFListFilter>();
+    filter->valid_counts.assign(nlist, 0);
+    std::vector<std::vector<size_t>> list_offsets(nlist);
+    const auto valid_categories =
+        scalar_partition_ != nullptr ? scalar_partition_->ValidCategories(bitset) : std::vector<uint8_t>();
+    RunSearchTasks(num_tasks, [&](const size_t task_idx) {
+        for (size_t list_no = nlist * task_idx / num_tasks; list_no < nlist * (task_idx + 1) / num_tasks; list_no++) {
+            const size_t list_size = index_->invlists->list_size(list_no);
+            if (list_size == 0) {
+                continue;
+            }
+            std::vector<size_t>& offsets = list_offsets[list_no];
+            if (scalar_partition_ != nullptr) {
+                scalar_partition_->ValidOffsets(list_no, valid_categories, bitset, offsets);
+            } else {
+                faiss::InvertedLists::ScopedIds sids(index_->invlists, list_no);
+                for (size_t offset = 0; offset < list_size; offset++) {
+                    if (bw_idselector.is_member(sids[offset])) {
+                        offsets.push_back(offset);
+                    }
+                }
+            }
+            filter->valid_counts[list_no] = offsets.size();
+            // the other lists are scanned as usual
+            if (offsets.size() * kIvfListGatherRatio > list_size) {
+                std::vector<size_t>().swap(offsets);
+            }
+        }
+    });
+
+    filter->lims.assign(nlist + 1, 0);
+    for (size_t list_no = 0; list_no < nlist; list_no++) {
+        filter->lims[list_no + 1] = filter->lims[list_no] + list_offsets[list_no].size();
+    }
+    filter->offsets.reserve(filter->lims[nlist]);
+    for (auto& offsets : list_offsets) {
+        filter->offsets.insert(filter->offsets.end(), offsets.begin(), offsets.end());
+    }
+    return filter;
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::SearchListMajor(const float* x, const int64_t rows, const int64_t k,
+                                                   const int64_t nprobe, const BitsetView& bitset,
+                                                   const faiss::SearchParameters* coarse_params,
+                                                   const CoarseProbes* probes, float* distances, int64_t* ids) const {
+    if constexpr (std::is_same_v<IndexType, faiss::IndexIVFFlat> || std::is_same_v<IndexType, faiss::IndexIVFPQ>) {
+        const size_t dim = index_->d;
+        const size_t nprobe_used = std::min<size_t>(nprobe, index_->nlist);
+        const bool is_similarity = faiss::is_similarity_metric(index_->metric_type);
+        const size_t num_tasks = std::max<size_t>(search_pool_->size(), 1);
+
+        BitsetViewIDSelector bw_idselector(bitset);
+        const faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
+
+        for (int64_t q0 = 0; q0 < rows; q0 += kIvfListMajorBatchSize) {
+            const size_t n = std::min(kIvfListMajorBatchSize, rows - q0);
+            const float* xb = x + q0 * dim;
+
+            std::vector<faiss::idx_t> keys(n * nprobe_used);
+            std::vector<float> coarse_dis(n * nprobe_used);
+            std::unique_ptr<IvfPqQueryTables> tables = nullptr;
+            if constexpr (std::is_same_v<IndexType, faiss::IndexIVFPQ>) {
+                tables = std::make_unique<IvfPqQueryTables>(*index_, n);
+            }
+
+            // all query-to-list assignments first, a chunk of queries per task
+            RunSearchTasks(num_tasks, [&](const size_t task_idx) {
+                const size_t i0 = n * task_idx / num_tasks;
+                const size_t i1 = n * (task_idx + 1) / num_tasks;
+                if (i1 == i0) {
+                    return;
+                }
+                ScopedSearchPhase phase(SearchPhase::COARSE);
+                if (probes != nullptr) {
+                    const size_t beg = (q0 + i0) * nprobe_used;
+                    const size_t end = (q0 + i1) * nprobe_used;
+                    std::copy(probes->lists.begin() + beg, probes->lists.begin() + end,
+                              keys.begin() + i0 * nprobe_used);
+                    std::copy(probes->distances.begin() + beg, probes->distances.begin() + end,
+                              coarse_dis.begin() + i0 * nprobe_used);
+                } else {
+                    index_->quantizer->search(i1 - i0, xb + i0 * dim, nprobe_used,
+                                              coarse_dis.data() + i0 * nprobe_used, keys.data() + i0 * nprobe_used,
+                                              coarse_params);
+                }
+                if (tables != nullptr) {
+                    tables->Compute(xb, i0, i1);
+                }
+            });
+
+            const IvfListAssignment assignment =
+                AssignQueriesToLists(index_->nlist, n, nprobe_used, keys.data(), coarse_dis.data());
+            IvfListMajorResults results(n, k, is_similarity, distances + q0 * k, ids + q0 * k);
+
+            // then every probed list once against all of its queries
+            std::atomic<size_t> next_list{0};
+            RunSearchTasks(num_tasks, [&](const size_t) {
+                ScopedSearchPhase phase(SearchPhase::SCAN);
+                for (size_t i = next_list++; i < assignment.lists.size(); i = next_list++) {
+                    if constexpr (std::is_same_v<IndexType, faiss::IndexIVFFlat>) {
+                        ScanListMajorIvfFlat(*index_, assignment.lists[i], assignment, xb, id_selector, results);
+                    } else {
+                        ScanListMajorIvfPq(*index_, assignment.lists[i], assignment, *tables, id_selector, results);
+                    }
+                }
+            });
+            ScopedSearchPhase phase(SearchPhase::ASSEMBLE);
+            results.Finalize();
+        }
+    } else {
+        throw std::runtime_error("list-major search is not supported by the index");
+    }
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::SearchSplitProbes(const float* x, const int64_t rows, const int64_t k,
+                                                     const int64_t nprobe, const size_t splits,
+                                                     const BitsetView& bitset,
+                                                     const faiss::SearchParameters* coarse_params,
+                                                     const CoarseProbes* probes, float* distances,
+                                                     int64_t* ids) const {
+    if constexpr (std::is_same_v<IndexType, faiss::IndexIVFFlat> || std::is_same_v<IndexType, faiss::IndexIVFPQ> ||
+                  std::is_same_v<IndexType, faiss::IndexIVFScalarQuantizer>) {
+        const size_t dim = index_->d;
+        const size_t nprobe_used = std::min<size_t>(nprobe, index_->nlist);
+
+        std::vector<faiss::idx_t> keys;
+        std::vector<float> coarse_dis;
+        if (probes != nullptr) {
+            keys.assign(probes->lists.begin(), probes->lists.end());
+            coarse_dis.assign(probes->distances.begin(), probes->distances.end());
+        } else {
+            keys.resize(rows * nprobe_used);
+            coarse_dis.resize(rows * nprobe_used);
+            RunSearchTasks(rows, [&](const size_t i) {
+                ScopedSearchPhase phase(SearchPhase::COARSE);
+                index_->quantizer->search(1, x + i * dim, nprobe_used, coarse_dis.data() + i * nprobe_used,
+                                          keys.data() + i * nprobe_used, coarse_params);
+            });
+        }
+
+        BitsetViewIDSelector bw_idselector(bitset);
+        faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
+        std::vector<float> split_distances(splits * rows * k);
+        std::vector<int64_t> split_ids(splits * rows * k);
+        RunSearchTasks(splits * rows, [&](const size_t task_idx) {
+            ScopedSearchPhase phase(SearchPhase::SCAN);
+            const size_t split = task_idx / rows;
+            const size_t i = task_idx % rows;
+            const size_t beg = nprobe_used * split / splits;
+            const size_t end = nprobe_used * (split + 1) / splits;
+            faiss::IVFSearchParameters ivf_search_params;
+            ivf_search_params.nprobe = end - beg;
+            ivf_search_params.max_codes = 0;
+            ivf_search_params.sel = id_selector;
+            const size_t offset = (split * rows + i) * k;
+            index_->search_preassigned(1, x + i * dim, k, keys.data() + i * nprobe_used + beg,
+                                       coarse_dis.data() + i * nprobe_used + beg, split_distances.data() + offset,
+                                       split_ids.data() + offset, false, &ivf_search_params);
+        });
+
+        ScopedSearchPhase phase(SearchPhase::ASSEMBLE);
+        if (faiss::is_similarity_metric(index_->metric_type)) {
+            faiss::merge_knn_results<int64_t, faiss::CMax<float, int>>(rows, k, splits, split_distances.data(),
+                                                                       split_ids.data(), distances, ids);
+        } else {
+            faiss::merge_knn_results<int64_t, faiss::CMin<float, int>>(rows, k, splits, split_distances.data(),
+                                                                       split_ids.data(), distances, ids);
+        }
+    } else {
+        throw std::runtime_error("split-probe search is not supported by the index");
+    }
+}
+
 template <typename DataType, typename IndexType>
 Status
 IvfIndexNode<DataType, IndexType>::Train(const DataSetPtr dataset, std::shared_ptr<Config> cfg,
                                          bool use_knowhere_build_pool) {
+    WaitForCompaction();
     // use build_pool_ to make sure the OMP threads spawded by index_->train etc
     // can inherit the low nice value of threads in build_pool_.
     auto build_pool_wrapper = std::make_shared<ThreadPoolWrapper>(build_pool_, use_knowhere_build_pool);
@@ -517,6 +1411,9 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         }
     }
 
+    const IvfConfig& ivf_cfg = static_cast<const IvfConfig&>(*cfg);
+    const bool gpu_train = ivf_cfg.gpu_train.value();
+
     std::unique_ptr<IndexType> index;
     // if cfg.use_elkan is used, then we'll use a temporary instance of
     //  IndexFlatElkan for the training.
@@ -527,17 +1424,20 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         const bool use_elkan = ivf_flat_cfg.use_elkan.value_or(true);
 
         // create quantizer for the training
-        std::unique_ptr<faiss::IndexFlat> qzr =
-            std::make_unique<faiss::IndexFlatElkan>(dim, metric.value(), false, use_elkan);
+        std::unique_ptr<faiss::IndexFlat> qzr = training_quantizer(dim, metric.value(), use_elkan, gpu_train);
         // create index. Index does not own qzr
         index = std::make_unique<faiss::IndexIVFFlat>(qzr.get(), dim, nlist, metric.value(), is_cosine);
         // train
+        train_balanced_quantizer(*index, rows, (const float*)data, ivf_cfg);
         index->train(rows, (const float*)data);
         // replace quantizer with a regular IndexFlat
         qzr = to_index_flat(std::move(qzr));
         // transfer ownership of qzr to index
         index->quantizer = qzr.release();
         index->own_fields = true;
+        if (ivf_flat_cfg.coarse_quantizer.value() == "hnsw") {
+            use_hnsw_quantizer(index.get(), ivf_flat_cfg);
+        }
     }
     if constexpr (std::is_same<faiss::IndexIVFFlatCC, IndexType>::value) {
         const IvfFlatCcConfig& ivf_flat_cc_cfg = static_cast<const IvfFlatCcConfig&>(*cfg);
@@ -546,12 +1446,12 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         const bool use_elkan = ivf_flat_cc_cfg.use_elkan.value_or(true);
 
         // create quantizer for the training
-        std::unique_ptr<faiss::IndexFlat> qzr =
-            std::make_unique<faiss::IndexFlatElkan>(dim, metric.value(), false, use_elkan);
+        std::unique_ptr<faiss::IndexFlat> qzr = training_quantizer(dim, metric.value(), use_elkan, gpu_train);
         // create index. Index does not own qzr
         index = std::make_unique<faiss::IndexIVFFlatCC>(qzr.get(), dim, nlist, ivf_flat_cc_cfg.ssize.value(),
                                                         metric.value(), is_cosine);
         // train
+        train_balanced_quantizer(*index, rows, (const float*)data, ivf_cfg);
         index->train(rows, (const float*)data);
         // replace quantizer with a regular IndexFlat
         qzr = to_index_flat(std::move(qzr));
@@ -569,17 +1469,20 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         const bool use_elkan = ivf_pq_cfg.use_elkan.value_or(true);
 
         // create quantizer for the training
-        std::unique_ptr<faiss::IndexFlat> qzr =
-            std::make_unique<faiss::IndexFlatElkan>(dim, metric.value(), false, use_elkan);
+        std::unique_ptr<faiss::IndexFlat> qzr = training_quantizer(dim, metric.value(), use_elkan, gpu_train);
         // create index. Index does not own qzr
         index = std::make_unique<faiss::IndexIVFPQ>(qzr.get(), dim, nlist, ivf_pq_cfg.m.value(), nbits, metric.value());
         // train
-        index->train(rows, (const float*)data);
+        train_balanced_quantizer(*index, rows, (const float*)data, ivf_cfg);
+        train_with_gpu_pq(index.get(), index->pq, rows, (const float*)data, gpu_train);
         // replace quantizer with a regular IndexFlat
         qzr = to_index_flat(std::move(qzr));
         // transfer ownership of qzr to index
         index->quantizer = qzr.release();
         index->own_fields = true;
+        if (ivf_pq_cfg.coarse_quantizer.value() == "hnsw") {
+            use_hnsw_quantizer(index.get(), ivf_pq_cfg);
+        }
     }
     if constexpr (std::is_same<faiss::IndexScaNN, IndexType>::value) {
         const ScannConfig& scann_cfg = static_cast<const ScannConfig&>(*cfg);
@@ -589,11 +1492,12 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         const bool use_elkan = scann_cfg.use_elkan.value_or(true);
         const int sub_dim = scann_cfg.sub_dim.value_or(2);
         // create quantizer for the training
-        std::unique_ptr<faiss::IndexFlat> qzr =
-            std::make_unique<faiss::IndexFlatElkan>(dim, metric.value(), false, use_elkan);
+        std::unique_ptr<faiss::IndexFlat> qzr = training_quantizer(dim, metric.value(), use_elkan, gpu_train);
         // create base index. it does not own qzr
         auto base_index = std::make_unique<faiss::IndexIVFPQFastScan>(
             qzr.get(), dim, nlist, (dim + sub_dim - 1) / sub_dim, 4, is_cosine, metric.value());
+        // only used by the inner product metrics
+        base_index->anisotropic_threshold = scann_cfg.anisotropic_threshold.value();
         // create scann index, which does not base_index by default,
         //    but owns the refine index by default omg
         if (scann_cfg.with_raw_data.value()) {
@@ -602,7 +1506,8 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
             index = std::make_unique<faiss::IndexScaNN>(base_index.get(), nullptr);
         }
         // train
-        index->train(rows, (const float*)data);
+        train_balanced_quantizer(*base_index, rows, (const float*)data, ivf_cfg);
+        train_with_gpu_pq(index.get(), base_index->pq, rows, (const float*)data, gpu_train);
         // at this moment, we still own qzr.
         // replace quantizer with a regular IndexFlat
         qzr = to_index_flat(std::move(qzr));
@@ -620,18 +1525,24 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         const bool use_elkan = ivf_sq_cfg.use_elkan.value_or(true);
 
         // create quantizer for the training
-        std::unique_ptr<faiss::IndexFlat> qzr =
-            std::make_unique<faiss::IndexFlatElkan>(dim, metric.value(), false, use_elkan);
+        std::unique_ptr<faiss::IndexFlat> qzr = training_quantizer(dim, metric.value(), use_elkan, gpu_train);
         // create index. Index does not own qzr
         index = std::make_unique<faiss::IndexIVFScalarQuantizer>(
             qzr.get(), dim, nlist, faiss::ScalarQuantizer::QuantizerType::QT_8bit, metric.value());
         // train
+        train_balanced_quantizer(*index, rows, (const float*)data, ivf_cfg);
         index->train(rows, (const float*)data);
         // replace quantizer with a regular IndexFlat
         qzr = to_index_flat(std::move(qzr));
         // transfer ownership of qzr to index
         index->quantizer = qzr.release();
         index->own_fields = true;
+        if (ivf_sq_cfg.coarse_quantizer.value() == "hnsw") {
+            use_hnsw_quantizer(index.get(), ivf_sq_cfg);
+        }
+        if (ivf_sq_cfg.sq_interleave.value() > 0) {
+            index->set_interleaved(ivf_sq_cfg.sq_interleave.value());
+        }
     }
     if constexpr (std::is_same<faiss::IndexBinaryIVF, IndexType>::value) {
         const IvfBinConfig& ivf_bin_cfg = static_cast<const IvfBinConfig&>(*cfg);
@@ -655,8 +1566,7 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         const bool use_elkan = ivf_sq_cc_cfg.use_elkan.value_or(true);
 
         // create quantizer for the training
-        std::unique_ptr<faiss::IndexFlat> qzr =
-            std::make_unique<faiss::IndexFlatElkan>(dim, metric.value(), false, use_elkan);
+        std::unique_ptr<faiss::IndexFlat> qzr = training_quantizer(dim, metric.value(), use_elkan, gpu_train);
         // create index. Index does not own qzr
         auto qzr_type = get_ivf_sq_quantizer_type(ivf_sq_cc_cfg.code_size.value());
         if (!qzr_type.has_value()) {
@@ -667,6 +1577,7 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
                                                                    metric.value(), is_cosine, false,
                                                                    ivf_sq_cc_cfg.raw_data_store_prefix);
         // train
+        train_balanced_quantizer(*index, rows, (const float*)data, ivf_cfg);
         index->train(rows, (const float*)data);
         // replace quantizer with a regular IndexFlat
         qzr = to_index_flat(std::move(qzr));
@@ -690,6 +1601,10 @@ IvfIndexNode<DataType, IndexType>::TrainInternal(const DataSetPtr dataset, std::
         index->train(rows, (const float*)data);
     }
     index_ = std::move(index);
+    shared_quantizer_ = nullptr;
+    huge_page_overhead_ = 0;
+    scalar_partition_ = nullptr;
+    tombstones_ = nullptr;
 
     return Status::success;
 }
@@ -702,9 +1617,12 @@ IvfIndexNode<DataType, IndexType>::Add(const DataSetPtr dataset, std::shared_ptr
         LOG_KNOWHERE_ERROR_ << "Can not add data to empty IVF index.";
         return Status::empty_index;
     }
+    // the lists are not compacted while rows are appended to them
+    std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
     auto data = dataset->GetTensor();
     auto rows = dataset->GetRows();
     const BaseConfig& base_cfg = static_cast<const IvfConfig&>(*cfg);
+    const size_t ntotal_before = index_->ntotal;
     // use build_pool_ to make sure the OMP threads spawded by index_->add
     // can inherit the low nice value of threads in build_pool_.
     auto build_pool_wrapper = std::make_shared<ThreadPoolWrapper>(build_pool_, use_knowhere_build_pool);
@@ -720,7 +1638,8 @@ IvfIndexNode<DataType, IndexType>::Add(const DataSetPtr dataset, std::shared_ptr
                           if constexpr (std::is_same<faiss::IndexBinaryIVF, IndexType>::value) {
                               index_->add(rows, (const uint8_t*)data);
                           } else {
-                              index_->add(rows, (const float*)data);
+                              add_with_gpu_assign(index_.get(), rows, (const float*)data,
+                                                  static_cast<const IvfConfig&>(*cfg).gpu_assign.value());
                           }
                       })
                       .getTry();
@@ -728,13 +1647,253 @@ IvfIndexNode<DataType, IndexType>::Add(const DataSetPtr dataset, std::shared_ptr
         LOG_KNOWHERE_WARNING_ << "faiss internal error: " << tryObj.exception().what();
         return Status::faiss_inner_error;
     }
+    if constexpr (is_list_filter_supported()) {
+        const auto& scalar_info =
+            dataset->Get<std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>>(meta::SCALAR_INFO);
+        if (!scalar_info.empty() || scalar_partition_ != nullptr) {
+            try {
+                scalar_partition_ = IvfScalarPartition::FromScalarInfo(
+                    scalar_info, scalar_partition_.get(), ntotal_before, index_->ntotal, index_->invlists);
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return Status::faiss_inner_error;
+            }
+        }
+    }
+    if constexpr (is_list_split_supported()) {
+        const int64_t max_list_size = static_cast<const IvfFlatCcConfig&>(*cfg).max_list_size.value();
+        if (max_list_size > 0) {
+            tombstone_lock.unlock();
+            try {
+                SplitLargeLists(max_list_size);
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return Status::faiss_inner_error;
+            }
+        }
+    }
     return Status::success;
 }
 
+template <typename DataType, typename IndexType>
+Status
+IvfIndexNode<DataType, IndexType>::Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> cfg) {
+    // the RaBitQ and ScaNN codes come with a random rotation or a refine index of their own
+    if constexpr (std::is_same_v<IndexType, faiss::IndexScaNN> || std::is_same_v<IndexType, IndexIVFRaBitQWrapper>) {
+        LOG_KNOWHERE_ERROR_ << "Merge is not supported for " << Type();
+        return Status::not_implemented;
+    } else {
+        if (!this->index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not merge data to empty IVF index.";
+            return Status::empty_index;
+        }
+        std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
+        auto has_raw_data_backup = [](const IndexType& index) {
+            if constexpr (std::is_same_v<IndexType, faiss::IndexIVFScalarQuantizerCC>) {
+                return index.raw_data_backup_ != nullptr;
+            }
+            return false;
+        };
+        if (scalar_partition_ != nullptr || tombstones_ != nullptr || has_raw_data_backup(*index_) ||
+            index_->invlists->is_readonly()) {
+            LOG_KNOWHERE_ERROR_ << "Merge is not supported for IVF indexes with scalar partitions, deleted rows, a raw "
+                                   "data backup or read-only lists";
+            return Status::not_implemented;
+        }
+        std::vector<const IndexType*> other_indexes;
+        for (const auto* other : others) {
+            auto other_node = dynamic_cast<const IvfIndexNode*>(other);
+            if (other_node == nullptr) {
+                LOG_KNOWHERE_ERROR_ << "can not merge indexes of different types";
+                return Status::invalid_args;
+            }
+            if (!other_node->index_) {
+                LOG_KNOWHERE_ERROR_ << "can not merge an empty index";
+                return Status::empty_index;
+            }
+            if (other_node->scalar_partition_ != nullptr || other_node->tombstones_ != nullptr ||
+                has_raw_data_backup(*other_node->index_)) {
+                LOG_KNOWHERE_ERROR_ << "Merge is not supported for IVF indexes with scalar partitions, deleted rows or "
+                                       "a raw data backup";
+                return Status::not_implemented;
+            }
+            if (!is_ivf_merge_compatible(*index_, *other_node->index_)) {
+                LOG_KNOWHERE_ERROR_ << "can not merge IVF indexes with different centroids or quantizers";
+                return Status::invalid_args;
+            }
+            other_indexes.push_back(other_node->index_.get());
+        }
+
+        const BaseConfig& base_cfg = static_cast<const IvfConfig&>(*cfg);
+        auto tryObj = build_pool_
+                          ->push([&] {
+                              std::unique_ptr<ThreadPool::ScopedBuildOmpSetter> setter;
+                              if (base_cfg.num_build_thread.has_value()) {
+                                  setter = std::make_unique<ThreadPool::ScopedBuildOmpSetter>(
+                                      base_cfg.num_build_thread.value());
+                              } else {
+                                  setter = std::make_unique<ThreadPool::ScopedBuildOmpSetter>();
+                              }
+                              TimeRecorder rc("IVF merge");
+                              for (const auto* other : other_indexes) {
+                                  append_inverted_lists(index_->invlists, other->invlists, index_->ntotal);
+                                  index_->ntotal += other->ntotal;
+                              }
+                              // the map from the ids to the lists is built again with the appended entries
+                              if (!index_->direct_map.no()) {
+                                  std::lock_guard<std::mutex> lock(direct_map_mutex_);
+                                  const auto type = index_->direct_map.type;
+                                  index_->make_direct_map(false);
+                                  index_->make_direct_map(true, type);
+                              }
+                              rc.ElapseFromBegin("done");
+                          })
+                          .getTry();
+        if (tryObj.hasException()) {
+            LOG_KNOWHERE_WARNING_ << "faiss internal error: " << tryObj.exception().what();
+            return Status::faiss_inner_error;
+        }
+        return Status::success;
+    }
+}
+
+template <typename DataType, typename IndexType>
+Status
+IvfIndexNode<DataType, IndexType>::DeleteByIds(const DataSetPtr dataset) {
+    if constexpr (!is_tombstone_supported()) {
+        LOG_KNOWHERE_ERROR_ << "DeleteByIds is not supported for " << Type();
+        return Status::not_implemented;
+    } else {
+        if (!this->index_) {
+            LOG_KNOWHERE_ERROR_ << "Can not delete data from an empty IVF index.";
+            return Status::empty_index;
+        }
+        const auto rows = dataset->GetRows();
+        const auto* ids = dataset->GetIds();
+        {
+            std::unique_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+            const int64_t count = Count();
+            for (int64_t i = 0; i < rows; i++) {
+                if (ids[i] < 0 || ids[i] >= count) {
+                    LOG_KNOWHERE_ERROR_ << "can not delete row " << ids[i] << ", the index has " << count << " rows";
+                    return Status::invalid_args;
+                }
+            }
+            if (tombstones_ == nullptr) {
+                tombstones_ = std::make_unique<IvfTombstones>();
+            }
+            try {
+                tombstones_->MarkDeleted(ids, rows, index_->invlists);
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return Status::faiss_inner_error;
+            }
+        }
+        ScheduleCompaction();
+        return Status::success;
+    }
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::ScheduleCompaction() {
+    auto needed = [this] {
+        std::shared_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+        // the scalar partition refers to the offsets of the entries
+        return index_ != nullptr && tombstones_ != nullptr && scalar_partition_ == nullptr &&
+               !tombstones_->ListsToCompact(index_->invlists, kCompactionMinDeadRatio).empty();
+    };
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    if (compaction_running_ || compaction_stop_.load() || !needed()) {
+        return;
+    }
+    compaction_running_ = true;
+    compaction_ = build_pool_->push([this, needed] {
+        while (!compaction_stop_.load()) {
+            bool complete = false;
+            try {
+                complete = CompactLists();
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error during the compaction of IVF lists: " << e.what();
+            }
+            // rows may have been deleted since the lists to compact were looked up
+            std::lock_guard<std::mutex> lock(compaction_mutex_);
+            if (!complete || !needed()) {
+                compaction_running_ = false;
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(compaction_mutex_);
+        compaction_running_ = false;
+    });
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::WaitForCompaction() {
+    std::optional<folly::Future<folly::Unit>> compaction;
+    {
+        std::lock_guard<std::mutex> lock(compaction_mutex_);
+        compaction = std::move(compaction_);
+        compaction_.reset();
+        compaction_stop_ = true;
+    }
+    if (compaction.has_value()) {
+        compaction->wait();
+    }
+    compaction_stop_ = false;
+}
+
+template <typename DataType, typename IndexType>
+bool
+IvfIndexNode<DataType, IndexType>::CompactLists() {
+    std::vector<size_t> lists;
+    {
+        std::shared_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+        if (index_ == nullptr || tombstones_ == nullptr || scalar_partition_ != nullptr) {
+            return true;
+        }
+        lists = tombstones_->ListsToCompact(index_->invlists, kCompactionMinDeadRatio);
+    }
+    TimeRecorder rc("IVF compaction");
+    size_t n_removed = 0;
+    for (size_t i = 0; i < lists.size();) {
+        if (compaction_stop_.load()) {
+            return false;
+        }
+        // the lists of a batch of about kCompactionBatchSize entries are compacted, and the direct map built
+        //   again, while searches are blocked
+        std::unique_lock<ReaderBiasedRWLock> lock(tombstone_mutex_);
+        if (iterator_pin_.use_count() > 1) {
+            return false;
+        }
+        size_t n_batch = 0;
+        size_t n_batch_removed = 0;
+        for (; i < lists.size() && n_batch < kCompactionBatchSize; i++) {
+            n_batch += index_->invlists->list_size(lists[i]);
+            n_batch_removed += tombstones_->CompactList(index_->invlists, lists[i]);
+        }
+        if (n_batch_removed > 0 && !index_->direct_map.no()) {
+            std::lock_guard<std::mutex> direct_map_lock(direct_map_mutex_);
+            const auto type = index_->direct_map.type;
+            index_->make_direct_map(false);
+            index_->make_direct_map(true, type);
+        }
+        n_removed += n_batch_removed;
+    }
+    if (n_removed > 0) {
+        std::lock_guard<std::mutex> lock(list_radii_mutex_);
+        list_radii_ntotal_ = -1;
+    }
+    rc.ElapseFromBegin("removed " + std::to_string(n_removed) + " entries from " + std::to_string(lists.size()) +
+                       " lists");
+    return true;
+}
+
 template <typename DataType, typename IndexType>
 expected<DataSetPtr>
-IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
-                                          const BitsetView& bitset) const {
+IvfIndexNode<DataType, IndexType>::SearchInto(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                              const BitsetView& input_bitset, int64_t* ids_buf, float* dis_buf) const {
     if (!this->index_) {
         LOG_KNOWHERE_WARNING_ << "search on empty index";
         return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
@@ -743,6 +1902,9 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
         LOG_KNOWHERE_WARNING_ << "index not trained";
         return expected<DataSetPtr>::Err(Status::index_not_trained, "index not trained");
     }
+    std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
+    std::vector<uint8_t> tombstone_bits;
+    const BitsetView bitset = FilterTombstones(input_bitset, tombstone_bits);
 
     auto dim = dataset->GetDim();
     auto rows = dataset->GetRows();
@@ -754,8 +1916,119 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
     auto k = ivf_cfg.k.value();
     auto nprobe = ivf_cfg.nprobe.value();
 
-    auto ids = std::make_unique<int64_t[]>(rows * k);
-    auto distances = std::make_unique<float[]>(rows * k);
+    auto ids = MakeResultBuffer<int64_t>(rows * k, ids_buf);
+    auto distances = MakeResultBuffer<float>(rows * k, dis_buf);
+
+    // adaptive nprobe is supported by the indexes searched with the generic faiss IVF search
+    constexpr bool support_adaptive_nprobe = is_list_filter_supported();
+    std::shared_ptr<const std::vector<float>> list_radii = nullptr;
+    std::vector<int64_t> nprobe_used;
+    if constexpr (support_adaptive_nprobe) {
+        if (ivf_cfg.adaptive_nprobe.value()) {
+            try {
+                list_radii = GetListRadii();
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+            }
+            nprobe_used.resize(rows, 0);
+        }
+    }
+
+    // the probes of a coarse search shared with other indexes, if they are the ones the search would find
+    std::shared_ptr<const CoarseProbes> probes = nullptr;
+    if constexpr (is_coarse_probes_supported()) {
+        probes = dataset->Get<std::shared_ptr<const CoarseProbes>>(meta::COARSE_PROBES);
+        if (probes != nullptr && (probes->quantizer != index_->quantizer || probes->rows != rows ||
+                                  probes->nprobe != std::min<int64_t>(nprobe, index_->nlist))) {
+            probes = nullptr;
+        }
+    }
+
+    // the queries are searched one by one then, for the stats of each of them
+    SearchStatsVec search_stats;
+    if (ivf_cfg.search_stats.value()) {
+        search_stats.resize(rows);
+    }
+
+    constexpr bool support_list_major =
+        std::is_same_v<IndexType, faiss::IndexIVFFlat> || std::is_same_v<IndexType, faiss::IndexIVFPQ>;
+    if constexpr (support_list_major) {
+        const int64_t list_major_nq = ivf_cfg.list_major_nq.value();
+        bool use_list_major = list_major_nq > 0 && rows >= list_major_nq && list_radii == nullptr &&
+                              search_stats.empty() && !index_->invlists->use_iterator;
+        if constexpr (std::is_same_v<IndexType, faiss::IndexIVFPQ>) {
+            use_list_major = use_list_major && IvfPqQueryTables::IsSupported(*index_);
+        }
+        if (use_list_major) {
+            try {
+                std::unique_ptr<float[]> copied_data = nullptr;
+                auto x = (const float*)data;
+                if (is_cosine) {
+                    copied_data = CopyAndNormalizeVecs(x, rows, dim);
+                    x = copied_data.get();
+                }
+                faiss::SearchParametersHNSW coarse_hnsw_params;
+                const faiss::SearchParameters* coarse_params =
+                    coarse_search_params(*index_, ivf_cfg, nprobe, coarse_hnsw_params);
+                SearchListMajor(x, rows, k, nprobe, bitset, coarse_params, probes.get(), distances.get(), ids.get());
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+            }
+            return GenResultDataSet(rows, k, std::move(ids), std::move(distances));
+        }
+    }
+
+    // lists without vectors passing a selective bitset are skipped, and their probes are given to the next lists.
+    //   With a scalar partition the valid vectors are found from the sub-lists of the valid categories.
+    std::unique_ptr<faiss::IVFListFilter> list_filter = nullptr;
+    int64_t filtered_nprobe = nprobe;
+    if constexpr (support_adaptive_nprobe) {
+        if (!bitset.empty() && (scalar_partition_ != nullptr || bitset.filter_ratio() >= kIvfListFilterThreshold) &&
+            !index_->invlists->use_iterator) {
+            try {
+                list_filter = BuildListFilter(bitset);
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+            }
+            const int64_t n_empty_lists =
+                std::count(list_filter->valid_counts.begin(), list_filter->valid_counts.end(), 0);
+            // with ensure_topk_full, any list may be needed to fill the top-k
+            filtered_nprobe = ivf_cfg.ensure_topk_full.value()
+                                  ? index_->nlist
+                                  : std::min<int64_t>(index_->nlist, nprobe + n_empty_lists);
+        }
+    }
+
+    // a small batch leaves search threads idle, they then split the probes of every query
+    if constexpr (support_adaptive_nprobe) {
+        const int64_t list_rows = index_->ntotal / std::max<int64_t>(index_->nlist, 1);
+        const size_t splits =
+            std::min<size_t>(search_pool_->QuerySplits(rows, nprobe * list_rows), std::max<int64_t>(nprobe, 1));
+        if (splits > 1 && list_radii == nullptr && list_filter == nullptr && search_stats.empty() &&
+            !index_->invlists->use_iterator) {
+            try {
+                std::unique_ptr<float[]> copied_data = nullptr;
+                auto x = (const float*)data;
+                if (is_cosine) {
+                    copied_data = CopyAndNormalizeVecs(x, rows, dim);
+                    x = copied_data.get();
+                }
+                faiss::SearchParametersHNSW coarse_hnsw_params;
+                const faiss::SearchParameters* coarse_params =
+                    coarse_search_params(*index_, ivf_cfg, nprobe, coarse_hnsw_params);
+                SearchSplitProbes(x, rows, k, nprobe, splits, bitset, coarse_params, probes.get(), distances.get(),
+                                  ids.get());
+            } catch (const std::exception& e) {
+                LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+                return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+            }
+            return GenResultDataSet(rows, k, std::move(ids), std::move(distances));
+        }
+    }
+
     try {
         std::vector<folly::Future<folly::Unit>> futs;
         futs.reserve(rows);
@@ -763,11 +2036,21 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
             futs.emplace_back(search_pool_->push([&, index = i] {
                 ThreadPool::ScopedSearchOmpSetter setter(1);
                 auto offset = k * index;
-                std::unique_ptr<float[]> copied_query = nullptr;
 
                 BitsetViewIDSelector bw_idselector(bitset);
                 faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
 
+                // the coarse search is timed by faiss, the phases are the same stats
+                SearchPhaseRecorder* const phases = SearchPhaseRecorder::Current();
+                const auto search_start = phases != nullptr ? std::chrono::steady_clock::now()
+                                                            : std::chrono::steady_clock::time_point();
+                // the coarse search and the list scans of a query run in one faiss call
+                ScopedTraceSpan span("query");
+                faiss::IndexIVFStats ivf_stats;
+                faiss::IndexIVFStats* const ivf_stats_ptr =
+                    search_stats.empty() && phases == nullptr ? nullptr : &ivf_stats;
+                int64_t nrefine = 0;
+
                 if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
                     auto cur_data = (const uint8_t*)data + index * ((dim + 7) / 8);
 
@@ -776,6 +2059,7 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                     faiss::IVFSearchParameters ivf_search_params;
                     ivf_search_params.nprobe = nprobe;
                     ivf_search_params.sel = id_selector;
+                    ivf_search_params.stats = ivf_stats_ptr;
                     index_->search(1, cur_data, k, i_distances + offset, ids.get() + offset, &ivf_search_params);
 
                     if (index_->metric_type == faiss::METRIC_Hamming) {
@@ -788,8 +2072,7 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                                      std::is_same<IndexType, faiss::IndexIVFScalarQuantizerCC>::value) {
                     auto cur_query = (const float*)data + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     faiss::IVFSearchParameters ivf_search_params;
@@ -806,13 +2089,23 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                         ivf_search_params.max_codes = 0;
                     }
 
-                    index_->search(1, cur_query, k, distances.get() + offset, ids.get() + offset, &ivf_search_params);
+                    if (probes != nullptr && !ivf_search_params.ensure_topk_full) {
+                        const int64_t* lists = probes->lists.data() + index * probes->nprobe;
+                        index_->invlists->prefetch_lists(lists, probes->nprobe);
+                        index_->search_preassigned(1, cur_query, k, lists,
+                                                   probes->distances.data() + index * probes->nprobe,
+                                                   distances.get() + offset, ids.get() + offset, false,
+                                                   &ivf_search_params, ivf_stats_ptr);
+                    } else {
+                        ivf_search_params.stats = ivf_stats_ptr;
+                        index_->search(1, cur_query, k, distances.get() + offset, ids.get() + offset,
+                                       &ivf_search_params);
+                    }
                 } else if constexpr (std::is_same<IndexType, faiss::IndexScaNN>::value) {
                     auto cur_query = (const float*)data + index * dim;
                     const ScannConfig& scann_cfg = static_cast<const ScannConfig&>(*cfg);
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     // todo aguzhva: this is somewhat alogical. Refactor?
@@ -838,13 +2131,16 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                     faiss::IndexScaNNSearchParameters scann_search_params;
                     scann_search_params.base_index_params = &base_search_params;
                     scann_search_params.reorder_k = scann_cfg.reorder_k.value();
+                    base_search_params.stats = ivf_stats_ptr;
+                    if (index_->with_raw_data()) {
+                        nrefine = scann_search_params.reorder_k;
+                    }
 
                     index_->search(1, cur_query, k, distances.get() + offset, ids.get() + offset, &scann_search_params);
                 } else if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
                     auto cur_query = (const float*)data + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     const IvfRaBitQConfig& ivf_rabitq_cfg = static_cast<const IvfRaBitQConfig&>(*cfg);
@@ -864,6 +2160,7 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                     ivf_search_params.max_codes = 0;
                     ivf_search_params.sel = id_selector;
                     ivf_search_params.qb = ivf_rabitq_cfg.rbq_bits_query.value_or(0);
+                    ivf_search_params.stats = ivf_stats_ptr;
 
                     if (use_refine && whether_to_enable_refine) {
                         // yes, use refine
@@ -871,6 +2168,7 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                         refine_search_params.sel = id_selector;
                         refine_search_params.k_factor = ivf_rabitq_cfg.refine_k.value_or(1);
                         refine_search_params.base_index_params = &ivf_search_params;
+                        nrefine = k * refine_search_params.k_factor;
 
                         index_->search(1, cur_query, k, distances.get() + offset, ids.get() + offset,
                                        &refine_search_params);
@@ -882,8 +2180,7 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                 } else {
                     auto cur_query = (const float*)data + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     faiss::IVFSearchParameters ivf_search_params;
@@ -891,7 +2188,56 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
                     ivf_search_params.max_codes = 0;
                     ivf_search_params.sel = id_selector;
 
-                    index_->search(1, cur_query, k, distances.get() + offset, ids.get() + offset, &ivf_search_params);
+                    if (list_filter != nullptr) {
+                        ivf_search_params.list_filter = list_filter.get();
+                        ivf_search_params.nprobe = filtered_nprobe;
+                        ivf_search_params.max_lists_num = nprobe;
+                        ivf_search_params.ensure_topk_full = ivf_cfg.ensure_topk_full.value();
+                    }
+
+                    faiss::SearchParametersHNSW coarse_hnsw_params;
+                    ivf_search_params.quantizer_params =
+                        coarse_search_params(*index_, ivf_cfg, ivf_search_params.nprobe, coarse_hnsw_params);
+
+                    size_t cur_nprobe_used = 0;
+                    if (list_radii != nullptr) {
+                        ivf_search_params.list_radii = list_radii->data();
+                        ivf_search_params.list_radius_scale = ivf_cfg.adaptive_nprobe_radius_scale.value();
+                        ivf_search_params.min_nprobe = ivf_cfg.min_nprobe.value();
+                        ivf_search_params.nprobe_used = &cur_nprobe_used;
+                    }
+                    if (probes != nullptr && list_filter == nullptr && list_radii == nullptr) {
+                        const int64_t* lists = probes->lists.data() + index * probes->nprobe;
+                        index_->invlists->prefetch_lists(lists, probes->nprobe);
+                        index_->search_preassigned(1, cur_query, k, lists,
+                                                   probes->distances.data() + index * probes->nprobe,
+                                                   distances.get() + offset, ids.get() + offset, false,
+                                                   &ivf_search_params, ivf_stats_ptr);
+                    } else {
+                        ivf_search_params.stats = ivf_stats_ptr;
+                        index_->search(1, cur_query, k, distances.get() + offset, ids.get() + offset,
+                                       &ivf_search_params);
+                    }
+
+                    if (list_radii != nullptr) {
+                        nprobe_used[index] = cur_nprobe_used;
+                    }
+                }
+
+                if (phases != nullptr) {
+                    // the fast scan and binary indexes do not time their coarse search apart
+                    const auto coarse = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::duration<double, std::milli>(ivf_stats.quantization_time));
+                    phases->Add(SearchPhase::COARSE, coarse);
+                    phases->Add(SearchPhase::SCAN, std::chrono::steady_clock::now() - search_start - coarse);
+                }
+                span.SetAttribute("ndis", ivf_stats.ndis);
+                span.SetAttribute("nlist", ivf_stats.nq > 0 ? ivf_stats.nlist : nprobe);
+                if (!search_stats.empty()) {
+                    // the fast scan and binary indexes do not count their lists
+                    search_stats[index].nlist = ivf_stats.nq > 0 ? ivf_stats.nlist : nprobe;
+                    search_stats[index].ndis = ivf_stats.ndis;
+                    search_stats[index].nrefine = nrefine;
                 }
             }));
         }
@@ -903,6 +2249,12 @@ IvfIndexNode<DataType, IndexType>::Search(const DataSetPtr dataset, std::unique_
     }
 
     auto res = GenResultDataSet(rows, k, std::move(ids), std::move(distances));
+    if (list_radii != nullptr) {
+        res->Set(meta::NPROBE_USED, std::move(nprobe_used));
+    }
+    if (!search_stats.empty()) {
+        res->Set(meta::SEARCH_STATS, std::move(search_stats));
+    }
     return res;
 }
 
@@ -950,7 +2302,6 @@ IvfIndexNode<DataType, IndexType>::RangeSearch(const DataSetPtr dataset, std::un
             futs.emplace_back(search_pool_->push([&, index = i] {
                 ThreadPool::ScopedSearchOmpSetter setter(1);
                 faiss::RangeSearchResult res(1);
-                std::unique_ptr<float[]> copied_query = nullptr;
 
                 BitsetViewIDSelector bw_idselector(bitset);
                 faiss::IDSelector* id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
@@ -967,8 +2318,7 @@ IvfIndexNode<DataType, IndexType>::RangeSearch(const DataSetPtr dataset, std::un
                 } else if constexpr (std::is_same<IndexType, faiss::IndexIVFFlat>::value) {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     faiss::IVFSearchParameters ivf_search_params;
@@ -981,8 +2331,7 @@ IvfIndexNode<DataType, IndexType>::RangeSearch(const DataSetPtr dataset, std::un
                 } else if constexpr (std::is_same<IndexType, faiss::IndexScaNN>::value) {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     // todo aguzhva: this is somewhat alogical. Refactor?
@@ -994,8 +2343,7 @@ IvfIndexNode<DataType, IndexType>::RangeSearch(const DataSetPtr dataset, std::un
                 } else if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     const IvfRaBitQConfig& ivf_rabitq_cfg = static_cast<const IvfRaBitQConfig&>(*cfg);
@@ -1033,8 +2381,7 @@ IvfIndexNode<DataType, IndexType>::RangeSearch(const DataSetPtr dataset, std::un
                 } else {
                     auto cur_query = (const float*)xq + index * dim;
                     if (is_cosine) {
-                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
-                        cur_query = copied_query.get();
+                        cur_query = CopyAndNormalizeVecsInArena(cur_query, 1, dim);
                     }
 
                     faiss::IVFSearchParameters ivf_search_params;
@@ -1072,7 +2419,7 @@ IvfIndexNode<DataType, IndexType>::RangeSearch(const DataSetPtr dataset, std::un
 template <typename DataType, typename IndexType>
 expected<std::vector<IndexNode::IteratorPtr>>
 IvfIndexNode<DataType, IndexType>::AnnIterator(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
-                                               const BitsetView& bitset, bool use_knowhere_search_pool) const {
+                                               const BitsetView& input_bitset, bool use_knowhere_search_pool) const {
     if (!index_) {
         LOG_KNOWHERE_WARNING_ << "creating iterator on empty index";
         return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::empty_index, "index not loaded");
@@ -1086,6 +2433,13 @@ IvfIndexNode<DataType, IndexType>::AnnIterator(const DataSetPtr dataset, std::un
                               << ", only IVFFlat, IVFFlatCC, IVF_SQ8, IVF_SQ_CC, SCANN and IVFRABITQ support Iterator.";
         return expected<std::vector<IndexNode::IteratorPtr>>::Err(Status::not_implemented, "index not supported");
     } else {
+        std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
+        auto tombstone_bits = std::make_shared<std::vector<uint8_t>>();
+        const BitsetView bitset = FilterTombstones(input_bitset, *tombstone_bits);
+        // the iterators keep the combined bits, and pin the lists
+        std::shared_ptr<const void> hold =
+            std::make_shared<std::pair<std::shared_ptr<const char>, std::shared_ptr<std::vector<uint8_t>>>>(
+                iterator_pin_, tombstone_bits);
         auto dim = dataset->GetDim();
         auto rows = dataset->GetRows();
         auto data = dataset->GetTensor();
@@ -1118,7 +2472,8 @@ IvfIndexNode<DataType, IndexType>::AnnIterator(const DataSetPtr dataset, std::un
 
                 // iterator only own the copied_query.
                 auto it = std::make_shared<iterator>(index_.get(), std::move(copied_query), bitset, nprobe,
-                                                     larger_is_closer, iterator_refine_ratio, use_knowhere_search_pool);
+                                                     larger_is_closer, iterator_refine_ratio, use_knowhere_search_pool,
+                                                     hold);
                 vec[i] = it;
             }
 
@@ -1130,6 +2485,104 @@ IvfIndexNode<DataType, IndexType>::AnnIterator(const DataSetPtr dataset, std::un
     }
 }
 
+// The lists are scanned in the order of their centroids, all the rows of a list go to the groups at once. The closest
+//   nprobe lists are scanned, and the next ones until the groups are full.
+template <typename DataType, typename IndexType>
+expected<DataSetPtr>
+IvfIndexNode<DataType, IndexType>::GroupBySearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
+                                                 const BitsetView& input_bitset) const {
+    if constexpr (!is_group_by_supported()) {
+        return IndexNode::GroupBySearch(dataset, std::move(cfg), input_bitset);
+    } else {
+        if (!index_) {
+            LOG_KNOWHERE_WARNING_ << "search on empty index";
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+        if (!index_->is_trained) {
+            LOG_KNOWHERE_WARNING_ << "index not trained";
+            return expected<DataSetPtr>::Err(Status::index_not_trained, "index not trained");
+        }
+        const auto keys = dataset->Get<std::shared_ptr<const GroupKeys>>(meta::GROUP_BY_KEYS);
+        if (keys == nullptr) {
+            return expected<DataSetPtr>::Err(Status::invalid_args, "the group keys of the rows are missing");
+        }
+
+        std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
+        std::vector<uint8_t> tombstone_bits;
+        const BitsetView bitset = FilterTombstones(input_bitset, tombstone_bits);
+
+        const auto dim = dataset->GetDim();
+        const auto rows = dataset->GetRows();
+        const auto* data = static_cast<const float*>(dataset->GetTensor());
+
+        const IvfConfig& ivf_cfg = static_cast<const IvfConfig&>(*cfg);
+        const bool is_cosine = IsMetricType(ivf_cfg.metric_type.value(), knowhere::metric::COSINE);
+        const bool larger_is_closer = IsMetricType(ivf_cfg.metric_type.value(), knowhere::metric::IP) || is_cosine;
+        const size_t n_groups = ivf_cfg.k.value();
+        const size_t group_size = ivf_cfg.group_size.value();
+        const size_t n_res = n_groups * group_size;
+
+        BitsetViewIDSelector bw_idselector(bitset);
+        faiss::IVFSearchParameters ivf_search_params;
+        ivf_search_params.nprobe = ivf_cfg.nprobe.value();
+        ivf_search_params.max_codes = 0;
+        ivf_search_params.sel = bitset.empty() ? nullptr : &bw_idselector;
+
+        auto ids = std::make_unique<int64_t[]>(rows * n_res);
+        auto distances = std::make_unique<float[]>(rows * n_res);
+        try {
+            std::vector<folly::Future<folly::Unit>> futs;
+            futs.reserve(rows);
+            for (int64_t i = 0; i < rows; i++) {
+                futs.emplace_back(search_pool_->push([&, idx = i]() {
+                    ThreadPool::ScopedSearchOmpSetter setter(1);
+                    const float* cur_query = data + idx * dim;
+                    std::unique_ptr<float[]> copied_query = nullptr;
+                    if (is_cosine) {
+                        copied_query = CopyAndNormalizeVecs(cur_query, 1, dim);
+                        cur_query = copied_query.get();
+                    }
+
+                    auto workspace = index_->getIteratorWorkspace(cur_query, &ivf_search_params);
+                    // the first batch scans about nprobe lists, the next ones scan lists of as many rows
+                    workspace->backup_count_threshold = std::max<size_t>(workspace->backup_count_threshold, 1);
+
+                    GroupByCollector groups(*keys, n_groups, group_size);
+                    while (true) {
+                        const size_t visited_lists = workspace->next_visit_coarse_list_idx;
+                        index_->getIteratorNextBatch(workspace.get(), 0);
+                        for (const auto& dist_id : workspace->dists) {
+                            groups.Add(dist_id.id, larger_is_closer ? -dist_id.val : dist_id.val);
+                        }
+                        const bool exhausted =
+                            workspace->dists.empty() && workspace->next_visit_coarse_list_idx == visited_lists;
+                        workspace->dists.clear();
+                        if (exhausted || groups.Full()) {
+                            break;
+                        }
+                    }
+                    groups.Output(ids.get() + idx * n_res, distances.get() + idx * n_res, larger_is_closer);
+                }));
+            }
+            WaitAllSuccess(futs);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
+            return expected<DataSetPtr>::Err(Status::faiss_inner_error, e.what());
+        }
+
+        return GenResultDataSet(rows, n_res, std::move(ids), std::move(distances));
+    }
+}
+
+template <typename DataType, typename IndexType>
+void
+IvfIndexNode<DataType, IndexType>::EnsureDirectMap() const {
+    std::lock_guard<std::mutex> lock(direct_map_mutex_);
+    if (index_->direct_map.no()) {
+        index_->make_direct_map(true);
+    }
+}
+
 template <typename DataType, typename IndexType>
 expected<DataSetPtr>
 IvfIndexNode<DataType, IndexType>::GetVectorByIds(const DataSetPtr dataset) const {
@@ -1139,12 +2592,15 @@ IvfIndexNode<DataType, IndexType>::GetVectorByIds(const DataSetPtr dataset) cons
     if (!this->index_->is_trained) {
         return expected<DataSetPtr>::Err(Status::index_not_trained, "index not trained");
     }
+    // the direct map is built again once lists are compacted
+    std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
     if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
         auto dim = Dim();
         auto rows = dataset->GetRows();
         auto ids = dataset->GetIds();
 
         try {
+            EnsureDirectMap();
             auto data = std::make_unique<uint8_t[]>(rows * ((dim + 7) / 8));
             for (int64_t i = 0; i < rows; i++) {
                 int64_t id = ids[i];
@@ -1163,6 +2619,7 @@ IvfIndexNode<DataType, IndexType>::GetVectorByIds(const DataSetPtr dataset) cons
         auto ids = dataset->GetIds();
 
         try {
+            EnsureDirectMap();
             auto data = std::make_unique<float[]>(dim * rows);
             for (int64_t i = 0; i < rows; i++) {
                 int64_t id = ids[i];
@@ -1210,7 +2667,6 @@ IvfIndexNode<DataType, IndexType>::GetIndexMetaImpl(std::unique_ptr<Config>, IVF
     }
 
     auto ivf_index = dynamic_cast<faiss::IndexIVF*>(index_.get());
-    auto ivf_quantizer = dynamic_cast<faiss::IndexFlat*>(ivf_index->quantizer);
 
     int64_t dim = ivf_index->d;
     int64_t nlist = ivf_index->nlist;
@@ -1218,6 +2674,8 @@ IvfIndexNode<DataType, IndexType>::GetIndexMetaImpl(std::unique_ptr<Config>, IVF
 
     feder::ivfflat::IVFFlatMeta meta(nlist, dim, ntotal);
     std::unordered_set<int64_t> id_set;
+    // the quantizer is not necessarily a flat one
+    std::vector<float> centroid_vec(dim);
 
     for (int32_t i = 0; i < nlist; i++) {
         // copy from IndexIVF::search_preassigned
@@ -1229,9 +2687,9 @@ IvfIndexNode<DataType, IndexType>::GetIndexMetaImpl(std::unique_ptr<Config>, IVF
         auto node_id_codes = sids->get();
 
         // centroid vector
-        auto centroid_vec = ivf_quantizer->get_xb() + i * dim;
+        ivf_index->quantizer->reconstruct(i, centroid_vec.data());
 
-        meta.AddCluster(i, node_id_codes, node_num, centroid_vec, dim);
+        meta.AddCluster(i, node_id_codes, node_num, centroid_vec.data(), dim);
     }
 
     Json json_meta, json_id_set;
@@ -1248,7 +2706,7 @@ IvfIndexNode<DataType, IndexType>::SerializeImpl(BinarySet& binset, IVFBaseTag)
             LOG_KNOWHERE_WARNING_ << "index can not be serialized for empty index";
             return Status::empty_index;
         }
-        MemoryIOWriter writer;
+        ChunkedMemoryIOWriter writer;
         if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
             faiss::write_index_binary(index_.get(), &writer);
         } else if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
@@ -1256,8 +2714,7 @@ IvfIndexNode<DataType, IndexType>::SerializeImpl(BinarySet& binset, IVFBaseTag)
         } else {
             faiss::write_index(index_.get(), &writer);
         }
-        std::shared_ptr<uint8_t[]> data(writer.data());
-        binset.Append(Type(), data, writer.tellg());
+        binset.AppendChunks(Type(), writer.Release(), writer.tellg());
         return Status::success;
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
@@ -1273,7 +2730,7 @@ IvfIndexNode<DataType, IndexType>::SerializeImpl(BinarySet& binset, IVFFlatTag)
             LOG_KNOWHERE_WARNING_ << "index can not be serialized for empty index";
             return Status::empty_index;
         }
-        MemoryIOWriter writer;
+        ChunkedMemoryIOWriter writer;
         LOG_KNOWHERE_INFO_ << "request version " << this->version_.VersionNumber();
         if (this->version_ <= Version::GetMinimalVersion()) {
             faiss::write_index_nm(index_.get(), &writer);
@@ -1282,8 +2739,7 @@ IvfIndexNode<DataType, IndexType>::SerializeImpl(BinarySet& binset, IVFFlatTag)
             faiss::write_index(index_.get(), &writer);
             LOG_KNOWHERE_INFO_ << "write IVF_FLAT, file size " << writer.tellg();
         }
-        std::shared_ptr<uint8_t[]> index_data_ptr(writer.data());
-        binset.Append(Type(), index_data_ptr, writer.tellg());
+        binset.AppendChunks(Type(), writer.Release(), writer.tellg());
 
         // append raw data for backward compatible
         if (this->version_ <= Version::GetMinimalVersion()) {
@@ -1324,7 +2780,11 @@ IvfIndexNode<DataType, IndexType>::Deserialize(const BinarySet& binset, std::sha
         return Status::invalid_binary_set;
     }
 
+    WaitForCompaction();
     MemoryIOReader reader(binary->data.get(), binary->size);
+    huge_page_overhead_ = 0;
+    scalar_partition_ = nullptr;
+    tombstones_ = nullptr;
     try {
         if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
             // a special case for IVFRaBitQ, bcz a wrapper is involved.
@@ -1341,20 +2801,23 @@ IvfIndexNode<DataType, IndexType>::Deserialize(const BinarySet& binset, std::sha
             index_ = std::move(index_wr);
         } else {
             // the default case for a regular index
-            if constexpr (std::is_same<IndexType, faiss::IndexIVFFlat>::value) {
-                if (this->version_ <= Version::GetMinimalVersion()) {
-                    auto raw_binary = binset.GetByName("RAW_DATA");
-                    const BaseConfig& base_cfg = static_cast<const BaseConfig&>(*cfg);
-                    ConvertIVFFlat(binset, base_cfg.metric_type.value(), raw_binary->data.get(), raw_binary->size);
-                    // after conversion, binary size and data will be updated
-                    reader.data_ = binary->data.get();
-                    reader.total_ = binary->size;
+            {
+                ScopedTraceSpan span("read index");
+                if constexpr (std::is_same<IndexType, faiss::IndexIVFFlat>::value) {
+                    if (this->version_ <= Version::GetMinimalVersion()) {
+                        auto raw_binary = binset.GetByName("RAW_DATA");
+                        const BaseConfig& base_cfg = static_cast<const BaseConfig&>(*cfg);
+                        ConvertIVFFlat(binset, base_cfg.metric_type.value(), raw_binary->data.get(), raw_binary->size);
+                        // after conversion, binary size and data will be updated
+                        reader.data_ = binary->data.get();
+                        reader.total_ = binary->size;
+                    }
+                    index_.reset(static_cast<faiss::IndexIVFFlat*>(faiss::read_index(&reader)));
+                } else if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
+                    index_.reset(static_cast<IndexType*>(faiss::read_index_binary(&reader)));
+                } else {
+                    index_.reset(static_cast<IndexType*>(faiss::read_index(&reader)));
                 }
-                index_.reset(static_cast<faiss::IndexIVFFlat*>(faiss::read_index(&reader)));
-            } else if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
-                index_.reset(static_cast<IndexType*>(faiss::read_index_binary(&reader)));
-            } else {
-                index_.reset(static_cast<IndexType*>(faiss::read_index(&reader)));
             }
 
             if constexpr (!std::is_same_v<IndexType, faiss::IndexScaNN> &&
@@ -1364,6 +2827,15 @@ IvfIndexNode<DataType, IndexType>::Deserialize(const BinarySet& binset, std::sha
                     index_->make_direct_map(true);
                 }
             }
+            huge_page_overhead_ = MoveToHugePagesIfRequested(*cfg);
+            ShareQuantizer();
+            if constexpr (is_list_filter_supported()) {
+                ScopedTraceSpan span("scalar partition");
+                scalar_partition_ = IvfScalarPartition::Deserialize(binset, index_->ntotal, index_->invlists);
+            }
+            if constexpr (is_tombstone_supported()) {
+                tombstones_ = IvfTombstones::Deserialize(binset, index_->invlists);
+            }
         }
     } catch (const std::exception& e) {
         LOG_KNOWHERE_WARNING_ << "faiss inner error: " << e.what();
@@ -1372,6 +2844,36 @@ IvfIndexNode<DataType, IndexType>::Deserialize(const BinarySet& binset, std::sha
     return Status::success;
 }
 
+template <typename DataType, typename IndexType>
+Status
+IvfIndexNode<DataType, IndexType>::SerializeToFile(const std::string& filename) const {
+    if (!this->index_) {
+        LOG_KNOWHERE_WARNING_ << "index can not be serialized for empty index";
+        return Status::empty_index;
+    }
+    std::shared_lock<ReaderBiasedRWLock> tombstone_lock(tombstone_mutex_);
+    if (tombstones_ != nullptr) {
+        LOG_KNOWHERE_WARNING_ << "the deleted rows of " << Type() << " can not be serialized to a file";
+        return Status::not_implemented;
+    }
+    try {
+        // the file carries the codes of IVF_FLAT itself, DeserializeFromFile() reads no separate raw data
+        FileWriter writer(filename);
+        if constexpr (std::is_same<IndexType, faiss::IndexBinaryIVF>::value) {
+            faiss::write_index_binary(index_.get(), &writer);
+        } else if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
+            faiss::write_index(index_->index.get(), &writer);
+        } else {
+            faiss::write_index(index_.get(), &writer);
+        }
+        writer.close();
+        return Status::success;
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_WARNING_ << "failed to serialize " << Type() << " to " << filename << ": " << e.what();
+        return Status::disk_file_error;
+    }
+}
+
 template <typename DataType, typename IndexType>
 Status
 IvfIndexNode<DataType, IndexType>::DeserializeFromFile(const std::string& filename, std::shared_ptr<Config> config) {
@@ -1381,6 +2883,19 @@ IvfIndexNode<DataType, IndexType>::DeserializeFromFile(const std::string& filena
     if (cfg.enable_mmap.value()) {
         io_flags |= faiss::IO_FLAG_MMAP;
     }
+    // the raw data of SCANN is needed by GetVectorByIds() and refine only, the rest is copied out of the mapping
+    bool lazy_raw_data = false;
+    if constexpr (std::is_same_v<IndexType, faiss::IndexScaNN>) {
+        lazy_raw_data = cfg.lazy_load_raw_data.value() && !cfg.enable_mmap.value();
+        if (lazy_raw_data) {
+            io_flags |= faiss::IO_FLAG_MMAP_IFC;
+        }
+    }
+    WaitForCompaction();
+    huge_page_overhead_ = 0;
+    // a single index file carries no scalar partition or deleted rows
+    scalar_partition_ = nullptr;
+    tombstones_ = nullptr;
     try {
         if constexpr (std::is_same<IndexType, IndexIVFRaBitQWrapper>::value) {
             // a special case for IVFRaBitQ, bcz a wrapper is involved.
@@ -1402,6 +2917,15 @@ IvfIndexNode<DataType, IndexType>::DeserializeFromFile(const std::string& filena
             } else {
                 index_.reset(static_cast<IndexType*>(faiss::read_index(filename.data(), io_flags)));
             }
+            if constexpr (std::is_same_v<IndexType, faiss::IndexScaNN>) {
+                if (lazy_raw_data) {
+                    own_all_but_refine_data(index_.get());
+                }
+            }
+            if (!cfg.enable_mmap.value()) {
+                huge_page_overhead_ = MoveToHugePagesIfRequested(*config);
+            }
+            ShareQuantizer();
 
             if constexpr (!std::is_same_v<IndexType, faiss::IndexScaNN>) {
                 const BaseConfig& base_cfg = static_cast<const BaseConfig&>(*config);
@@ -29,11 +29,39 @@ class IvfConfig : public BaseConfig {
     CFG_BOOL use_elkan;
     CFG_BOOL ensure_topk_full;  // internal config, used for temp index
     CFG_INT max_empty_result_buckets;
+    // whether nprobe is the maximal number of probes, and probing stops once the remaining lists
+    //   can't hold a better result than the current k-th one. IVF_FLAT, IVF_PQ and IVF_SQ8 only
+    CFG_BOOL adaptive_nprobe;
+    // the number of lists that are always probed with adaptive_nprobe
+    CFG_INT min_nprobe;
+    // scales the list radii used by adaptive_nprobe, values < 1 stop earlier at the cost of recall
+    CFG_FLOAT adaptive_nprobe_radius_scale;
+    // the minimal number of queries in a batch for the batch to be searched list by list:
+    //   every probed list is scanned once against all of its queries. IVF_FLAT and IVF_PQ only, 0 disables it
+    CFG_INT list_major_nq;
+    // the index over the centroids, one of [flat, hnsw]. HNSW speeds up the coarse search with a large nlist,
+    //   both for the assignment during the build and for the probing. IVF_FLAT, IVF_PQ and IVF_SQ8 only
+    CFG_STRING coarse_quantizer;
+    CFG_INT coarse_hnsw_m;
+    CFG_INT coarse_ef_construction;
+    // the ef of the coarse HNSW search, at least nprobe is used
+    CFG_INT coarse_ef;
+    // whether the k-means of the coarse quantizer and of the PQ codebooks run their assignments on a GPU with cuVS.
+    //   The index stays a CPU one. IVF_FLAT, IVF_FLAT_CC, IVF_PQ, IVF_SQ8, IVF_SQ_CC and SCANN only
+    CFG_BOOL gpu_train;
+    // whether the vectors are also assigned to their lists on the GPU while they are added, flat quantizers only
+    CFG_BOOL gpu_assign;
+    // whether the centroids come from a k-means whose clusters hold at most balanced_kmeans_ratio times the mean
+    //   number of rows, which evens out the sizes of the lists. IVF_FLAT, IVF_FLAT_CC, IVF_PQ, IVF_SQ8, IVF_SQ_CC and
+    //   SCANN only
+    CFG_BOOL balanced_kmeans;
+    CFG_FLOAT balanced_kmeans_ratio;
     KNOHWERE_DECLARE_CONFIG(IvfConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(nlist)
             .description("number of inverted lists.")
             .set_default(128)
             .for_train()
+            .for_static()
             .set_range(1, 65536);
         KNOWHERE_CONFIG_DECLARE_FIELD(nprobe)
             .set_default(8)
@@ -55,6 +83,84 @@ class IvfConfig : public BaseConfig {
             .description("the maximum of continuous buckets with empty result")
             .for_range_search()
             .set_range(1, 65536);
+        KNOWHERE_CONFIG_DECLARE_FIELD(adaptive_nprobe)
+            .set_default(false)
+            .description("whether probing stops early once the remaining lists can't improve the top-k")
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(min_nprobe)
+            .set_default(1)
+            .description("number of lists that are always probed with adaptive nprobe.")
+            .for_search()
+            .set_range(1, 65536);
+        KNOWHERE_CONFIG_DECLARE_FIELD(adaptive_nprobe_radius_scale)
+            .set_default(1.0f)
+            .description("scale of the list radii used by adaptive nprobe, smaller values stop earlier")
+            .for_search()
+            .set_range(0.0f, 1.0f);
+        KNOWHERE_CONFIG_DECLARE_FIELD(list_major_nq)
+            .set_default(0)
+            .description("minimal number of queries for a batch to be searched list by list, 0 disables it")
+            .for_search()
+            .set_range(0, std::numeric_limits<CFG_INT::value_type>::max());
+        KNOWHERE_CONFIG_DECLARE_FIELD(coarse_quantizer)
+            .set_default("flat")
+            .description("the index over the centroids, one of [flat, hnsw]")
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(coarse_hnsw_m)
+            .set_default(32)
+            .description("number of neighbors of a centroid in the coarse HNSW graph")
+            .for_train()
+            .set_range(2, 2048);
+        KNOWHERE_CONFIG_DECLARE_FIELD(coarse_ef_construction)
+            .set_default(200)
+            .description("ef used to build the coarse HNSW graph")
+            .for_train()
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max());
+        KNOWHERE_CONFIG_DECLARE_FIELD(coarse_ef)
+            .set_default(64)
+            .description("ef of the coarse HNSW search, at least nprobe is used")
+            .for_train()
+            .for_search()
+            .set_range(1, std::numeric_limits<CFG_INT::value_type>::max());
+        KNOWHERE_CONFIG_DECLARE_FIELD(gpu_train)
+            .set_default(false)
+            .description("whether the k-means of the training runs on a GPU, the index stays a CPU one")
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(gpu_assign)
+            .set_default(false)
+            .description("whether the vectors are assigned to their lists on a GPU while they are added")
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(balanced_kmeans)
+            .set_default(false)
+            .description("whether the k-means of the training bounds the sizes of the clusters")
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(balanced_kmeans_ratio)
+            .set_default(1.1f)
+            .description("the most rows a cluster of the balanced k-means holds, relative to the mean size")
+            .for_train()
+            .set_range(1.0f, 1024.0f);
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        if (param_type == PARAM_TYPE::TRAIN) {
+            const std::string quantizer = str_to_lower(coarse_quantizer.value());
+            if (quantizer != "flat" && quantizer != "hnsw") {
+                std::string msg =
+                    "coarse quantizer " + coarse_quantizer.value() + " is not supported, supported: [flat hnsw]";
+                return HandleError(err_msg, msg, Status::invalid_args);
+            }
+            coarse_quantizer = quantizer;
+#ifndef KNOWHERE_WITH_CUVS
+            // the same build parameters may reach the nodes without GPUs, they train on the CPU
+            if (gpu_train.value() || gpu_assign.value()) {
+                LOG_KNOWHERE_WARNING_ << "knowhere is built without cuVS, gpu_train and gpu_assign are ignored";
+                gpu_train = false;
+                gpu_assign = false;
+            }
+#endif
+        }
+        return Status::success;
     }
 };
 
@@ -63,12 +169,19 @@ class IvfFlatConfig : public IvfConfig {};
 class IvfFlatCcConfig : public IvfFlatConfig {
  public:
     CFG_INT ssize;
+    // the lists of a growing index that hold more rows after an add are split in two, see ivf_list_split.h
+    CFG_INT max_list_size;
     KNOHWERE_DECLARE_CONFIG(IvfFlatCcConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(ssize)
             .description("segment size")
             .set_default(48)
             .for_train()
             .set_range(32, 2048);
+        KNOWHERE_CONFIG_DECLARE_FIELD(max_list_size)
+            .description("the rows of a list beyond which an add splits it, 0 for never")
+            .set_default(0)
+            .for_train()
+            .set_range(0, std::numeric_limits<CFG_INT::value_type>::max());
     }
 };
 
@@ -84,6 +197,10 @@ class IvfPqConfig : public IvfConfig {
 
     Status
     CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        const auto base_status = IvfConfig::CheckAndAdjust(param_type, err_msg);
+        if (base_status != Status::success) {
+            return base_status;
+        }
         switch (param_type) {
             case PARAM_TYPE::TRAIN: {
                 if (dim.has_value() && m.has_value()) {
@@ -111,6 +228,7 @@ class ScannConfig : public IvfFlatConfig {
     CFG_BOOL with_raw_data;
     CFG_INT sub_dim;
     CFG_BOOL ensure_topk_full;
+    CFG_FLOAT anisotropic_threshold;
     KNOHWERE_DECLARE_CONFIG(ScannConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(reorder_k)
             .description("reorder k used for refining")
@@ -131,6 +249,11 @@ class ScannConfig : public IvfFlatConfig {
             .set_default(false)
             .description("whether to make sure topk results full")
             .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(anisotropic_threshold)
+            .description("relative inner product threshold of the anisotropic quantization loss, 0 disables it")
+            .set_default(0.0)
+            .set_range(0.0, 1.0, true, false)
+            .for_train();
     }
 
     Status
@@ -181,7 +304,36 @@ class ScannConfig : public IvfFlatConfig {
     }
 };
 
-class IvfSqConfig : public IvfConfig {};
+class IvfSqConfig : public IvfConfig {
+ public:
+    // the number of vectors whose codes are interleaved in the lists, 16 or 32, so that a query is scored against
+    //   a whole block of codes at once. 0 keeps the codes of a vector together
+    CFG_INT sq_interleave;
+    KNOHWERE_DECLARE_CONFIG(IvfSqConfig) {
+        KNOWHERE_CONFIG_DECLARE_FIELD(sq_interleave)
+            .set_default(0)
+            .description("number of vectors whose codes are interleaved in the lists, one of [0, 16, 32]")
+            .for_train()
+            .for_static()
+            .set_range(0, 32);
+    }
+
+    Status
+    CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
+        const auto base_status = IvfConfig::CheckAndAdjust(param_type, err_msg);
+        if (base_status != Status::success) {
+            return base_status;
+        }
+        if (param_type == PARAM_TYPE::TRAIN) {
+            const auto interleave = sq_interleave.value();
+            if (interleave != 0 && interleave != 16 && interleave != 32) {
+                std::string msg = "sq_interleave should be one of [0, 16, 32], got " + std::to_string(interleave);
+                return HandleError(err_msg, msg, Status::invalid_args);
+            }
+        }
+        return Status::success;
+    }
+};
 
 class IvfBinConfig : public IvfConfig {
     Status
@@ -245,6 +397,9 @@ class IvfRaBitQConfig : public IvfConfig {
     // the value `0` means that the query won't be quantized and will
     //   be processed as is.
     CFG_INT rbq_bits_query;
+    // the bits per dimension of the codes. The values above `1` add the bits of the extended RaBitQ, that are read
+    //   only for the candidates that the sign bits can not rule out.
+    CFG_INT rbq_bits_data;
     KNOHWERE_DECLARE_CONFIG(IvfRaBitQConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(rbq_bits_query)
             .description("rbq_bits_query")
@@ -252,6 +407,12 @@ class IvfRaBitQConfig : public IvfConfig {
             .set_range(0, 8)
             .for_search()
             .for_range_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(rbq_bits_data)
+            .description("the bits per dimension of the codes")
+            .set_default(1)
+            .set_range(1, 9)
+            .for_train()
+            .for_static();
         KNOWHERE_CONFIG_DECLARE_FIELD(refine)
             .description("whether the refine is used during the train")
             .set_default(false)
@@ -0,0 +1,50 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/ivf_gpu_assign.h"
+
+#include "faiss/utils/distances.h"
+
+#ifdef KNOWHERE_WITH_CUVS
+#include "common/cuvs/integration/cuvs_brute_force_knn.hpp"
+#endif
+
+namespace knowhere {
+
+void
+GpuAssignIndexFlat::search(faiss::idx_t n, const float* x, faiss::idx_t k, float* distances, faiss::idx_t* labels,
+                           const faiss::SearchParameters* params) const {
+    const bool by_l2 = l2_assignment || metric_type == faiss::METRIC_L2;
+#ifdef KNOWHERE_WITH_CUVS
+    const bool supported_metric = by_l2 || metric_type == faiss::METRIC_INNER_PRODUCT;
+    if (n >= kMinGpuQueries && params == nullptr && supported_metric && !is_cosine && k <= ntotal) {
+        cuvs_knowhere::brute_force_knn(get_xb(), ntotal, x, n, d, k, !by_l2, distances, labels);
+        return;
+    }
+#endif
+    if (l2_assignment && metric_type != faiss::METRIC_L2) {
+        faiss::float_maxheap_array_t res = {size_t(n), size_t(k), labels, distances};
+        faiss::knn_L2sqr(x, get_xb(), d, n, ntotal, &res, nullptr, params ? params->sel : nullptr);
+        return;
+    }
+    faiss::IndexFlat::search(n, x, k, distances, labels, params);
+}
+
+bool
+GpuAssignIndexFlat::Available() {
+#ifdef KNOWHERE_WITH_CUVS
+    return true;
+#else
+    return false;
+#endif
+}
+
+}  // namespace knowhere
@@ -0,0 +1,46 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include "faiss/IndexFlat.h"
+
+namespace knowhere {
+
+// An IndexFlat whose searches of many queries without parameters run by brute force on a GPU with cuVS. It is the
+//   assignment index of the k-means of the coarse quantizer and of the PQ codebooks with gpu_train, and the quantizer
+//   of the additions with gpu_assign; the index that is serialized keeps a regular IndexFlat. Without cuVS it is a
+//   plain IndexFlat.
+struct GpuAssignIndexFlat : faiss::IndexFlat {
+    // fewer queries are searched on the CPU, the copies to the device would dominate
+    static constexpr faiss::idx_t kMinGpuQueries = 1024;
+
+    // l2_assignment searches by L2 whatever the metric, as IndexFlatElkan does for the k-means
+    GpuAssignIndexFlat(faiss::idx_t d, faiss::MetricType metric, bool l2_assignment = false)
+        : faiss::IndexFlat(d, metric), l2_assignment(l2_assignment) {
+    }
+
+    // a copy of the centroids of flat
+    explicit GpuAssignIndexFlat(const faiss::IndexFlat& flat) : faiss::IndexFlat(flat) {
+    }
+
+    void
+    search(faiss::idx_t n, const float* x, faiss::idx_t k, float* distances, faiss::idx_t* labels,
+           const faiss::SearchParameters* params = nullptr) const override;
+
+    // whether knowhere is built with cuVS
+    static bool
+    Available();
+
+    bool l2_assignment = false;
+};
+
+}  // namespace knowhere
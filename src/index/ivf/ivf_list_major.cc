@@ -0,0 +1,368 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/ivf_list_major.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "faiss/impl/FaissAssert.h"
+#include "faiss/impl/ProductQuantizer.h"
+#include "faiss/impl/code_distance/code_distance.h"
+#include "faiss/utils/Heap.h"
+#include "simd/hook.h"
+
+#ifndef FINTEGER
+#define FINTEGER long
+#endif
+
+extern "C" {
+int
+sgemm_(const char* transa, const char* transb, FINTEGER* m, FINTEGER* n, FINTEGER* k, const float* alpha,
+       const float* a, FINTEGER* lda, const float* b, FINTEGER* ldb, float* beta, float* c, FINTEGER* ldc);
+}
+
+namespace knowhere {
+
+namespace {
+
+using HeapForIP = faiss::CMin<float, faiss::idx_t>;
+using HeapForL2 = faiss::CMax<float, faiss::idx_t>;
+
+// the number of vectors of a list that are scored at once
+constexpr size_t kListTileSize = 1024;
+// the number of queries that are scored against a tile of a list at once
+constexpr size_t kQueryTileSize = 256;
+
+// the local result heaps of a tile of queries
+struct LocalHeaps {
+    std::vector<float> dis;
+    std::vector<faiss::idx_t> ids;
+
+    template <typename C>
+    void
+    init(const size_t m, const size_t k) {
+        dis.resize(m * k);
+        ids.resize(m * k);
+        for (size_t i = 0; i < m; i++) {
+            faiss::heap_heapify<C>(k, dis.data() + i * k, ids.data() + i * k);
+        }
+    }
+
+    template <typename C>
+    void
+    push(const size_t i, const size_t k, const float value, const faiss::idx_t id) {
+        float* heap_dis = dis.data() + i * k;
+        faiss::idx_t* heap_ids = ids.data() + i * k;
+        if (C::cmp(heap_dis[0], value)) {
+            faiss::heap_replace_top<C>(k, heap_dis, heap_ids, value, id);
+        }
+    }
+
+    void
+    merge(const IvfListAssignment& assignment, const size_t q0, const size_t m, const size_t k,
+          IvfListMajorResults& results) const {
+        for (size_t i = 0; i < m; i++) {
+            results.Merge(assignment.queries[q0 + i], dis.data() + i * k, ids.data() + i * k);
+        }
+    }
+};
+
+template <typename C>
+void
+scan_ivf_flat(const faiss::IndexIVFFlat& index, const int64_t list_no, const IvfListAssignment& assignment,
+              const float* x, const faiss::IDSelector* sel, IvfListMajorResults& results) {
+    const size_t begin = assignment.offsets[list_no];
+    const size_t end = assignment.offsets[list_no + 1];
+    const size_t d = index.d;
+    const size_t k = results.k();
+    const bool is_ip = (index.metric_type == faiss::METRIC_INNER_PRODUCT);
+
+    std::vector<float> xq(std::min(kQueryTileSize, end - begin) * d);
+    std::vector<float> xq_norms(std::min(kQueryTileSize, end - begin));
+    std::vector<float> y_norms(kListTileSize);
+    std::vector<float> ip(xq_norms.size() * kListTileSize);
+    LocalHeaps heaps;
+
+    const faiss::InvertedLists* invlists = index.invlists;
+    const size_t segment_num = invlists->get_segment_num(list_no);
+
+    for (size_t q0 = begin; q0 < end; q0 += kQueryTileSize) {
+        const size_t m = std::min(kQueryTileSize, end - q0);
+        for (size_t i = 0; i < m; i++) {
+            const float* query = x + assignment.queries[q0 + i] * d;
+            std::memcpy(xq.data() + i * d, query, d * sizeof(float));
+            xq_norms[i] = is_ip ? 0.0f : faiss::fvec_norm_L2sqr(query, d);
+        }
+        heaps.init<C>(m, k);
+
+        for (size_t segment_idx = 0; segment_idx < segment_num; segment_idx++) {
+            const size_t segment_size = invlists->get_segment_size(list_no, segment_idx);
+            const size_t segment_offset = invlists->get_segment_offset(list_no, segment_idx);
+            faiss::InvertedLists::ScopedCodes scodes(invlists, list_no, segment_offset);
+            faiss::InvertedLists::ScopedIds sids(invlists, list_no, segment_offset);
+            faiss::InvertedLists::ScopedCodeNorms scode_norms(invlists, list_no, segment_offset);
+            const float* y = reinterpret_cast<const float*>(scodes.get());
+            const faiss::idx_t* ids = sids.get();
+            // the norms of the raw vectors for COSINE
+            const float* code_norms = scode_norms.get();
+
+            for (size_t j0 = 0; j0 < segment_size; j0 += kListTileSize) {
+                const size_t ny = std::min(kListTileSize, segment_size - j0);
+                const float* y_tile = y + j0 * d;
+                if (!is_ip) {
+                    for (size_t j = 0; j < ny; j++) {
+                        y_norms[j] = faiss::fvec_norm_L2sqr(y_tile + j * d, d);
+                    }
+                }
+
+                // ip[i * ny + j] = <xq_i, y_j>
+                {
+                    float one = 1, zero = 0;
+                    FINTEGER nyi = ny, nxi = m, di = d;
+                    sgemm_("Transposed", "Not transposed", &nyi, &nxi, &di, &one, y_tile, &di, xq.data(), &di, &zero,
+                           ip.data(), &nyi);
+                }
+
+                for (size_t j = 0; j < ny; j++) {
+                    const faiss::idx_t id = ids[j0 + j];
+                    if (sel != nullptr && !sel->is_member(id)) {
+                        continue;
+                    }
+                    for (size_t i = 0; i < m; i++) {
+                        float dis = ip[i * ny + j];
+                        if (!is_ip) {
+                            dis = std::max(xq_norms[i] + y_norms[j] - 2 * dis, 0.0f);
+                        } else if (code_norms != nullptr) {
+                            dis /= code_norms[j0 + j];
+                        }
+                        heaps.push<C>(i, k, dis, id);
+                    }
+                }
+            }
+        }
+
+        heaps.merge(assignment, q0, m, k, results);
+    }
+}
+
+template <typename C, typename PQDecoder>
+void
+scan_ivf_pq(const faiss::IndexIVFPQ& index, const int64_t list_no, const IvfListAssignment& assignment,
+            const IvfPqQueryTables& tables, const faiss::IDSelector* sel, IvfListMajorResults& results) {
+    const size_t begin = assignment.offsets[list_no];
+    const size_t end = assignment.offsets[list_no + 1];
+    const size_t k = results.k();
+    const faiss::ProductQuantizer& pq = index.pq;
+    const size_t table_size = pq.M * pq.ksub;
+    // only the L2 tables of residuals depend on the list
+    const bool has_list_tables = index.by_residual && index.metric_type == faiss::METRIC_L2;
+
+    std::vector<float> list_tables(has_list_tables ? std::min(kQueryTileSize, end - begin) * table_size : 0);
+    std::vector<const float*> luts(std::min(kQueryTileSize, end - begin));
+    std::vector<float> dis0(luts.size());
+    LocalHeaps heaps;
+
+    const faiss::InvertedLists* invlists = index.invlists;
+    const size_t code_size = invlists->code_size;
+    const size_t segment_num = invlists->get_segment_num(list_no);
+
+    for (size_t q0 = begin; q0 < end; q0 += kQueryTileSize) {
+        const size_t m = std::min(kQueryTileSize, end - q0);
+        for (size_t i = 0; i < m; i++) {
+            const float* query_table = tables.get(assignment.queries[q0 + i]);
+            dis0[i] = index.by_residual ? assignment.coarse_dis[q0 + i] : 0.0f;
+            if (has_list_tables) {
+                // same as the precomputed table path of the regular IVF_PQ scanner
+                float* lut = list_tables.data() + i * table_size;
+                faiss::fvec_madd(table_size, index.precomputed_table.data() + list_no * table_size, -2.0,
+                                 query_table, lut);
+                luts[i] = lut;
+            } else {
+                luts[i] = query_table;
+            }
+        }
+        heaps.init<C>(m, k);
+
+        for (size_t segment_idx = 0; segment_idx < segment_num; segment_idx++) {
+            const size_t segment_size = invlists->get_segment_size(list_no, segment_idx);
+            const size_t segment_offset = invlists->get_segment_offset(list_no, segment_idx);
+            faiss::InvertedLists::ScopedCodes scodes(invlists, list_no, segment_offset);
+            faiss::InvertedLists::ScopedIds sids(invlists, list_no, segment_offset);
+            const uint8_t* codes = scodes.get();
+            const faiss::idx_t* ids = sids.get();
+
+            // a tile of codes stays in the cache while all the queries are scored against it
+            for (size_t j0 = 0; j0 < segment_size; j0 += kListTileSize) {
+                const size_t j1 = std::min(j0 + kListTileSize, segment_size);
+                for (size_t i = 0; i < m; i++) {
+                    for (size_t j = j0; j < j1; j++) {
+                        const faiss::idx_t id = ids[j];
+                        if (sel != nullptr && !sel->is_member(id)) {
+                            continue;
+                        }
+                        const float dis = dis0[i] + faiss::distance_single_code<PQDecoder>(
+                                                        pq.M, pq.nbits, luts[i], codes + j * code_size);
+                        heaps.push<C>(i, k, dis, id);
+                    }
+                }
+            }
+        }
+
+        heaps.merge(assignment, q0, m, k, results);
+    }
+}
+
+template <typename C>
+void
+scan_ivf_pq_dispatch(const faiss::IndexIVFPQ& index, const int64_t list_no, const IvfListAssignment& assignment,
+                     const IvfPqQueryTables& tables, const faiss::IDSelector* sel, IvfListMajorResults& results) {
+    switch (index.pq.nbits) {
+        case 8:
+            scan_ivf_pq<C, faiss::PQDecoder8>(index, list_no, assignment, tables, sel, results);
+            break;
+        case 16:
+            scan_ivf_pq<C, faiss::PQDecoder16>(index, list_no, assignment, tables, sel, results);
+            break;
+        default:
+            scan_ivf_pq<C, faiss::PQDecoderGeneric>(index, list_no, assignment, tables, sel, results);
+            break;
+    }
+}
+
+}  // namespace
+
+IvfListAssignment
+AssignQueriesToLists(const size_t nlist, const size_t n, const size_t nprobe, const faiss::idx_t* keys,
+                     const float* coarse_dis) {
+    IvfListAssignment assignment;
+    assignment.offsets.assign(nlist + 1, 0);
+    for (size_t i = 0; i < n * nprobe; i++) {
+        // not enough centroids for multiprobe
+        if (keys[i] >= 0) {
+            assignment.offsets[keys[i] + 1]++;
+        }
+    }
+    std::partial_sum(assignment.offsets.begin(), assignment.offsets.end(), assignment.offsets.begin());
+
+    const size_t nprobes = assignment.offsets[nlist];
+    assignment.queries.resize(nprobes);
+    assignment.coarse_dis.resize(nprobes);
+    std::vector<size_t> cursors(assignment.offsets.begin(), assignment.offsets.end() - 1);
+    for (size_t i = 0; i < n * nprobe; i++) {
+        if (keys[i] < 0) {
+            continue;
+        }
+        const size_t pos = cursors[keys[i]]++;
+        assignment.queries[pos] = i / nprobe;
+        assignment.coarse_dis[pos] = coarse_dis[i];
+    }
+
+    for (size_t list_no = 0; list_no < nlist; list_no++) {
+        if (assignment.offsets[list_no + 1] > assignment.offsets[list_no]) {
+            assignment.lists.push_back(list_no);
+        }
+    }
+    // the most expensive lists are taken first for a better balance between threads
+    std::stable_sort(assignment.lists.begin(), assignment.lists.end(), [&](const int64_t a, const int64_t b) {
+        return assignment.offsets[a + 1] - assignment.offsets[a] > assignment.offsets[b + 1] - assignment.offsets[b];
+    });
+    return assignment;
+}
+
+IvfListMajorResults::IvfListMajorResults(const size_t n, const size_t k, const bool is_similarity, float* distances,
+                                         int64_t* labels)
+    : n_(n),
+      k_(k),
+      is_similarity_(is_similarity),
+      distances_(distances),
+      labels_(labels),
+      locks_(std::make_unique<std::mutex[]>(n)) {
+    for (size_t i = 0; i < n_; i++) {
+        if (is_similarity_) {
+            faiss::heap_heapify<HeapForIP>(k_, distances_ + i * k_, labels_ + i * k_);
+        } else {
+            faiss::heap_heapify<HeapForL2>(k_, distances_ + i * k_, labels_ + i * k_);
+        }
+    }
+}
+
+void
+IvfListMajorResults::Merge(const int64_t query, const float* local_dis, const faiss::idx_t* local_ids) {
+    std::lock_guard<std::mutex> lock(locks_[query]);
+    if (is_similarity_) {
+        faiss::heap_addn<HeapForIP>(k_, distances_ + query * k_, labels_ + query * k_, local_dis, local_ids, k_);
+    } else {
+        faiss::heap_addn<HeapForL2>(k_, distances_ + query * k_, labels_ + query * k_, local_dis, local_ids, k_);
+    }
+}
+
+void
+IvfListMajorResults::Finalize() {
+    for (size_t i = 0; i < n_; i++) {
+        if (is_similarity_) {
+            faiss::heap_reorder<HeapForIP>(k_, distances_ + i * k_, labels_ + i * k_);
+        } else {
+            faiss::heap_reorder<HeapForL2>(k_, distances_ + i * k_, labels_ + i * k_);
+        }
+    }
+}
+
+void
+ScanListMajorIvfFlat(const faiss::IndexIVFFlat& index, const int64_t list_no, const IvfListAssignment& assignment,
+                     const float* x, const faiss::IDSelector* sel, IvfListMajorResults& results) {
+    if (results.is_similarity()) {
+        scan_ivf_flat<HeapForIP>(index, list_no, assignment, x, sel, results);
+    } else {
+        scan_ivf_flat<HeapForL2>(index, list_no, assignment, x, sel, results);
+    }
+}
+
+bool
+IvfPqQueryTables::IsSupported(const faiss::IndexIVFPQ& index) {
+    if (index.polysemous_ht != 0) {
+        return false;
+    }
+    if (index.metric_type == faiss::METRIC_INNER_PRODUCT) {
+        return true;
+    }
+    // L2 tables of residuals are derived from the inner products via the precomputed table
+    return index.metric_type == faiss::METRIC_L2 && (!index.by_residual || index.use_precomputed_table == 1);
+}
+
+IvfPqQueryTables::IvfPqQueryTables(const faiss::IndexIVFPQ& index, const size_t n)
+    : index_(index), table_size_(index.pq.M * index.pq.ksub), tables_(n * table_size_) {
+    FAISS_THROW_IF_NOT_MSG(IsSupported(index), "the index doesn't support list-major search");
+}
+
+void
+IvfPqQueryTables::Compute(const float* x, const size_t i0, const size_t i1) {
+    const float* xi = x + i0 * index_.d;
+    float* tables = tables_.data() + i0 * table_size_;
+    if (index_.metric_type == faiss::METRIC_L2 && !index_.by_residual) {
+        index_.pq.compute_distance_tables(i1 - i0, xi, tables);
+    } else {
+        index_.pq.compute_inner_prod_tables(i1 - i0, xi, tables);
+    }
+}
+
+void
+ScanListMajorIvfPq(const faiss::IndexIVFPQ& index, const int64_t list_no, const IvfListAssignment& assignment,
+                   const IvfPqQueryTables& tables, const faiss::IDSelector* sel, IvfListMajorResults& results) {
+    if (results.is_similarity()) {
+        scan_ivf_pq_dispatch<HeapForIP>(index, list_no, assignment, tables, sel, results);
+    } else {
+        scan_ivf_pq_dispatch<HeapForL2>(index, list_no, assignment, tables, sel, results);
+    }
+}
+
+}  // namespace knowhere
@@ -0,0 +1,115 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "faiss/IndexIVFFlat.h"
+#include "faiss/IndexIVFPQ.h"
+#include "faiss/impl/IDSelector.h"
+
+// List-major execution of a batch of IVF queries.
+// All query-to-list assignments of a batch are computed first, then every probed list is scanned once
+//   against all the queries that probe it, so a popular list is streamed from memory once per batch
+//   instead of once per query. Lists can be scanned concurrently, results are merged per query.
+
+namespace knowhere {
+
+// the number of queries that are searched list by list at once, bounds the memory of IVF_PQ query tables
+constexpr int64_t kIvfListMajorBatchSize = 1024;
+
+// The probes of a batch grouped by the inverted lists.
+struct IvfListAssignment {
+    // the probes of list i are [offsets[i], offsets[i + 1])
+    std::vector<size_t> offsets;
+    // per probe, the query and the distance between the query and the centroid
+    std::vector<int64_t> queries;
+    std::vector<float> coarse_dis;
+    // the lists with at least one probe, the most probed ones first
+    std::vector<int64_t> lists;
+};
+
+// groups the probes 'keys' of n queries, nprobe per query, by the lists
+IvfListAssignment
+AssignQueriesToLists(const size_t nlist, const size_t n, const size_t nprobe, const faiss::idx_t* keys,
+                     const float* coarse_dis);
+
+// Top-k results of a batch that several lists are merged into concurrently.
+class IvfListMajorResults {
+ public:
+    IvfListMajorResults(const size_t n, const size_t k, const bool is_similarity, float* distances, int64_t* labels);
+
+    // merges the heap of local results of a query
+    void
+    Merge(const int64_t query, const float* local_dis, const faiss::idx_t* local_ids);
+
+    // sorts the results, no merges are allowed after that
+    void
+    Finalize();
+
+    size_t
+    k() const {
+        return k_;
+    }
+
+    bool
+    is_similarity() const {
+        return is_similarity_;
+    }
+
+ private:
+    size_t n_;
+    size_t k_;
+    bool is_similarity_;
+    float* distances_;
+    int64_t* labels_;
+    std::unique_ptr<std::mutex[]> locks_;
+};
+
+// scans list_no against all of its queries. 'x' are the queries of the batch
+void
+ScanListMajorIvfFlat(const faiss::IndexIVFFlat& index, const int64_t list_no, const IvfListAssignment& assignment,
+                     const float* x, const faiss::IDSelector* sel, IvfListMajorResults& results);
+
+// Look-up tables of IVF_PQ queries that don't depend on the list, computed for a batch at once.
+class IvfPqQueryTables {
+ public:
+    // whether the list tables of the index can be derived from the query tables
+    static bool
+    IsSupported(const faiss::IndexIVFPQ& index);
+
+    IvfPqQueryTables(const faiss::IndexIVFPQ& index, const size_t n);
+
+    // computes the tables of the queries [i0, i1) of the batch 'x'
+    void
+    Compute(const float* x, const size_t i0, const size_t i1);
+
+    const float*
+    get(const int64_t query) const {
+        return tables_.data() + query * table_size_;
+    }
+
+ private:
+    const faiss::IndexIVFPQ& index_;
+    size_t table_size_;
+    std::vector<float> tables_;
+};
+
+void
+ScanListMajorIvfPq(const faiss::IndexIVFPQ& index, const int64_t list_no, const IvfListAssignment& assignment,
+                   const IvfPqQueryTables& tables, const faiss::IDSelector* sel, IvfListMajorResults& results);
+
+}  // namespace knowhere
@@ -0,0 +1,129 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/ivf_list_split.h"
+
+#include <algorithm>
+#include <memory>
+#include <typeinfo>
+
+#include "faiss/Clustering.h"
+#include "faiss/IndexFlat.h"
+#include "faiss/invlists/InvertedLists.h"
+#include "knowhere/utils.h"
+
+namespace knowhere {
+
+namespace {
+
+// the vectors of a list the 2-means of a split is trained on at most, evenly spaced in the list
+constexpr size_t kSplitTrainRows = 1024;
+
+// the vector of an entry as the quantizer assigns it, normalized for cosine
+void
+entry_vector(const faiss::IndexIVF& index, size_t list_no, size_t offset, float* x) {
+    index.reconstruct_from_offset(list_no, offset, x);
+    if (index.is_cosine) {
+        NormalizeVecs(x, 1, index.d);
+    }
+}
+
+}  // namespace
+
+bool
+IsIvfListSplitSupported(const faiss::IndexIVF& index) {
+    return dynamic_cast<const faiss::ConcurrentArrayInvertedLists*>(index.invlists) != nullptr &&
+           typeid(*index.quantizer) == typeid(faiss::IndexFlat) && !index.by_residual;
+}
+
+std::vector<float>
+TrainIvfListSplit(const faiss::IndexIVF& index, size_t list_no) {
+    const size_t list_size = index.invlists->list_size(list_no);
+    if (list_size < 2) {
+        return {};
+    }
+    const size_t d = index.d;
+    const size_t n = std::min(list_size, kSplitTrainRows);
+    std::vector<float> x(n * d);
+    for (size_t i = 0; i < n; i++) {
+        entry_vector(index, list_no, i * list_size / n, x.data() + i * d);
+    }
+
+    faiss::ClusteringParameters cp;
+    cp.min_points_per_centroid = 1;
+    cp.spherical = index.metric_type == faiss::METRIC_INNER_PRODUCT;
+    faiss::Clustering clustering(d, 2, cp);
+    faiss::IndexFlat assigner(d, index.metric_type);
+    clustering.train(n, x.data(), assigner);
+    return clustering.centroids;
+}
+
+bool
+ApplyIvfListSplit(faiss::IndexIVF& index, size_t list_no, const std::vector<float>& centroids) {
+    auto* invlists = dynamic_cast<faiss::ConcurrentArrayInvertedLists*>(index.invlists);
+    const auto* quantizer = dynamic_cast<const faiss::IndexFlat*>(index.quantizer);
+    const size_t d = index.d;
+    const size_t list_size = index.invlists->list_size(list_no);
+    if (invlists == nullptr || quantizer == nullptr || centroids.size() != 2 * d || list_size < 2) {
+        return false;
+    }
+
+    // the entries added since the training of the centroids are assigned as well
+    std::vector<float> x(list_size * d);
+    for (size_t offset = 0; offset < list_size; offset++) {
+        entry_vector(index, list_no, offset, x.data() + offset * d);
+    }
+    faiss::IndexFlat assigner(d, index.metric_type);
+    assigner.add(2, centroids.data());
+    std::vector<faiss::idx_t> halves(list_size);
+    assigner.assign(list_size, x.data(), halves.data());
+    const size_t n_moved = std::count(halves.begin(), halves.end(), 1);
+    if (n_moved == 0 || n_moved == list_size) {
+        return false;
+    }
+
+    const size_t code_size = invlists->code_size;
+    std::vector<faiss::idx_t> ids[2];
+    std::vector<uint8_t> codes[2];
+    std::vector<float> norms[2];
+    for (size_t offset = 0; offset < list_size; offset++) {
+        const size_t half = halves[offset];
+        ids[half].push_back(invlists->get_single_id(list_no, offset));
+        faiss::InvertedLists::ScopedCodes code(invlists, list_no, offset);
+        codes[half].insert(codes[half].end(), code.get(), code.get() + code_size);
+        if (invlists->save_norm) {
+            norms[half].push_back(*invlists->get_code_norms(list_no, offset));
+        }
+    }
+
+    // a quantizer of its own with the centroids of both halves, the current one may be shared or a view of a buffer
+    std::vector<float> all_centroids(quantizer->get_xb(), quantizer->get_xb() + quantizer->ntotal * d);
+    std::copy(centroids.begin(), centroids.begin() + d, all_centroids.begin() + list_no * d);
+    all_centroids.insert(all_centroids.end(), centroids.begin() + d, centroids.end());
+    auto new_quantizer = std::make_unique<faiss::IndexFlat>(d, quantizer->metric_type, quantizer->is_cosine);
+    new_quantizer->add(quantizer->ntotal + 1, all_centroids.data());
+    if (index.own_fields) {
+        delete index.quantizer;
+    }
+    index.quantizer = new_quantizer.release();
+    index.own_fields = true;
+
+    const size_t new_list_no = invlists->add_list();
+    index.nlist = invlists->nlist;
+    invlists->resize(list_no, 0);
+    invlists->add_entries(list_no, ids[0].size(), ids[0].data(), codes[0].data(),
+                          invlists->save_norm ? norms[0].data() : nullptr);
+    invlists->add_entries(new_list_no, ids[1].size(), ids[1].data(), codes[1].data(),
+                          invlists->save_norm ? norms[1].data() : nullptr);
+    return true;
+}
+
+}  // namespace knowhere
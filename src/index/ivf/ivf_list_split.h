@@ -0,0 +1,42 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "faiss/IndexIVF.h"
+
+// The split of an inverted list that grew much larger than the others, e.g. by the drift of the rows added to a
+//   growing segment after its training, into two lists with the centroids of a 2-means over its vectors. A probe of
+//   either list then scans about half of its rows, without a retraining of the index. The split list keeps its number
+//   with the first centroid, the other half becomes a new last list.
+
+namespace knowhere {
+
+// whether the lists of index can be split: concurrent lists, a flat quantizer and codes that do not depend on their
+//   centroid
+bool
+IsIvfListSplitSupported(const faiss::IndexIVF& index);
+
+// the two centroids of the split of list_no, trained on a sample of its vectors. Empty if the list is too small.
+//   Thread safe with searches and adds.
+std::vector<float>
+TrainIvfListSplit(const faiss::IndexIVF& index, size_t list_no);
+
+// moves the entries of list_no nearer to the second of the centroids to a new list, returns false and leaves the index
+//   as is if all of them are nearer to one centroid. The direct map of index is not updated. Must not run concurrently
+//   with any reader or writer of the index.
+bool
+ApplyIvfListSplit(faiss::IndexIVF& index, size_t list_no, const std::vector<float>& centroids);
+
+}  // namespace knowhere
@@ -0,0 +1,155 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/ivf_scalar_partition.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "knowhere/log.h"
+
+namespace knowhere {
+
+IvfScalarPartition::IvfScalarPartition(std::vector<uint32_t> row_category, const faiss::InvertedLists* invlists)
+    : row_category_(std::move(row_category)), invlists_(invlists) {
+    for (const auto category : row_category_) {
+        if (category != kNoCategory) {
+            num_categories_ = std::max<size_t>(num_categories_, category + 1);
+        }
+    }
+    const size_t nlist = invlists_->nlist;
+    list_offsets_.resize(nlist);
+    sub_lists_.resize(nlist);
+    for (size_t list_no = 0; list_no < nlist; list_no++) {
+        const size_t list_size = invlists_->list_size(list_no);
+        if (list_size == 0) {
+            continue;
+        }
+        faiss::InvertedLists::ScopedIds sids(invlists_, list_no);
+        auto& offsets = list_offsets_[list_no];
+        offsets.resize(list_size);
+        for (size_t offset = 0; offset < list_size; offset++) {
+            offsets[offset] = offset;
+        }
+        auto category_of = [&](uint32_t offset) { return CategoryIndex(row_category_[sids[offset]]); };
+        std::stable_sort(offsets.begin(), offsets.end(),
+                         [&](uint32_t a, uint32_t b) { return category_of(a) < category_of(b); });
+        for (uint32_t begin = 0; begin < list_size;) {
+            const uint32_t category = row_category_[sids[offsets[begin]]];
+            uint32_t end = begin + 1;
+            while (end < list_size && row_category_[sids[offsets[end]]] == category) {
+                end++;
+            }
+            sub_lists_[list_no].push_back(SubList{category, begin, end});
+            begin = end;
+        }
+    }
+}
+
+std::unique_ptr<IvfScalarPartition>
+IvfScalarPartition::FromScalarInfo(
+    const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info,
+    const IvfScalarPartition* previous, size_t first_id, size_t ntotal, const faiss::InvertedLists* invlists) {
+    if (scalar_info.size() > 1) {
+        LOG_KNOWHERE_WARNING_ << "IVF partition by multiple scalar fields is not supported";
+        return nullptr;
+    }
+    if (scalar_info.empty() && previous == nullptr) {
+        return nullptr;
+    }
+    std::vector<uint32_t> row_category(ntotal, kNoCategory);
+    if (previous != nullptr) {
+        std::copy_n(previous->row_category_.begin(), std::min(first_id, previous->row_category_.size()),
+                    row_category.begin());
+    }
+    // the rows of an add without scalar info have no category
+    if (!scalar_info.empty()) {
+        const auto& categories = scalar_info.begin()->second;
+        for (uint32_t category = 0; category < categories.size(); category++) {
+            for (const auto offset : categories[category]) {
+                if (first_id + offset < ntotal) {
+                    row_category[first_id + offset] = category;
+                }
+            }
+        }
+    }
+    return std::make_unique<IvfScalarPartition>(std::move(row_category), invlists);
+}
+
+std::vector<uint8_t>
+IvfScalarPartition::ValidCategories(const BitsetView& bitset) const {
+    std::vector<uint8_t> valid(num_categories_ + 1, 0);
+    const size_t n = std::min(bitset.size(), row_category_.size());
+    bitset.for_each_valid_index(0, n, [&](size_t id) { valid[CategoryIndex(row_category_[id])] = 1; });
+    // the rows beyond the bitset are valid
+    for (size_t id = n; id < row_category_.size(); id++) {
+        valid[CategoryIndex(row_category_[id])] = 1;
+    }
+    return valid;
+}
+
+void
+IvfScalarPartition::ValidOffsets(size_t list_no, const std::vector<uint8_t>& valid_categories,
+                                 const BitsetView& bitset, std::vector<size_t>& offsets) const {
+    if (sub_lists_[list_no].empty()) {
+        return;
+    }
+    faiss::InvertedLists::ScopedIds sids(invlists_, list_no);
+    const auto& list_offsets = list_offsets_[list_no];
+    for (const auto& sub_list : sub_lists_[list_no]) {
+        if (!valid_categories[CategoryIndex(sub_list.category)]) {
+            continue;
+        }
+        for (uint32_t i = sub_list.begin; i < sub_list.end; i++) {
+            const auto id = sids[list_offsets[i]];
+            if (static_cast<size_t>(id) >= bitset.size() || !bitset.test(id)) {
+                offsets.push_back(list_offsets[i]);
+            }
+        }
+    }
+    // the gathered rows are scanned in the order of the list
+    std::sort(offsets.begin(), offsets.end());
+}
+
+size_t
+IvfScalarPartition::Size() const {
+    size_t size = row_category_.size() * sizeof(uint32_t);
+    for (size_t list_no = 0; list_no < list_offsets_.size(); list_no++) {
+        size += list_offsets_[list_no].size() * sizeof(uint32_t) + sub_lists_[list_no].size() * sizeof(SubList);
+    }
+    return size;
+}
+
+void
+IvfScalarPartition::Serialize(BinarySet& binset) const {
+    const size_t size = row_category_.size() * sizeof(uint32_t);
+    std::shared_ptr<uint8_t[]> data(new uint8_t[size]);
+    std::memcpy(data.get(), row_category_.data(), size);
+    binset.Append(kBinaryName, std::move(data), size);
+}
+
+std::unique_ptr<IvfScalarPartition>
+IvfScalarPartition::Deserialize(const BinarySet& binset, size_t ntotal, const faiss::InvertedLists* invlists) {
+    auto binary = binset.GetByName(kBinaryName);
+    if (binary == nullptr) {
+        return nullptr;
+    }
+    if (static_cast<size_t>(binary->size) != ntotal * sizeof(uint32_t)) {
+        LOG_KNOWHERE_WARNING_ << "the scalar partition of " << binary->size / sizeof(uint32_t) << " rows does not fit "
+                              << ntotal << " rows of an IVF index";
+        return nullptr;
+    }
+    std::vector<uint32_t> row_category(ntotal);
+    std::memcpy(row_category.data(), binary->data.get(), binary->size);
+    return std::make_unique<IvfScalarPartition>(std::move(row_category), invlists);
+}
+
+}  // namespace knowhere
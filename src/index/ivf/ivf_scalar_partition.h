@@ -0,0 +1,87 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "faiss/invlists/InvertedLists.h"
+#include "knowhere/binaryset.h"
+#include "knowhere/bitsetview.h"
+
+// The rows of every inverted list grouped by the category of a scalar field, the partition key of the build.
+// A filter on the partition key, e.g. `color == red` at 99.9% filtering, has valid rows in a few categories only,
+//   and a probed list is then scanned over the sub-lists of these categories instead of over all its codes.
+
+namespace knowhere {
+
+class IvfScalarPartition {
+ public:
+    // the category of the rows that are not in the scalar info
+    static constexpr uint32_t kNoCategory = UINT32_MAX;
+    static constexpr const char* kBinaryName = "IVF_SCALAR_PARTITION";
+
+    // row_category[id] is the category of the row id
+    IvfScalarPartition(std::vector<uint32_t> row_category, const faiss::InvertedLists* invlists);
+
+    // the partition by the single field of scalar_info, whose ids are offsets from first_id, the rows before first_id
+    //   keep their categories in previous. nullptr if scalar_info has several fields, or none and there is no previous.
+    static std::unique_ptr<IvfScalarPartition>
+    FromScalarInfo(const std::unordered_map<int64_t, std::vector<std::vector<uint32_t>>>& scalar_info,
+                   const IvfScalarPartition* previous, size_t first_id, size_t ntotal,
+                   const faiss::InvertedLists* invlists);
+
+    // per category (kNoCategory last), whether it has a valid row in bitset
+    std::vector<uint8_t>
+    ValidCategories(const BitsetView& bitset) const;
+
+    // the offsets of the valid rows of a list, looked up in the sub-lists of the valid categories only
+    void
+    ValidOffsets(size_t list_no, const std::vector<uint8_t>& valid_categories, const BitsetView& bitset,
+                 std::vector<size_t>& offsets) const;
+
+    size_t
+    Size() const;
+
+    void
+    Serialize(BinarySet& binset) const;
+
+    // nullptr if binset has no partition, or one of another number of rows
+    static std::unique_ptr<IvfScalarPartition>
+    Deserialize(const BinarySet& binset, size_t ntotal, const faiss::InvertedLists* invlists);
+
+ private:
+    struct SubList {
+        uint32_t category;
+        // the sub-list is list_offsets_[list_no][begin, end)
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    size_t
+    CategoryIndex(uint32_t category) const {
+        return category == kNoCategory ? num_categories_ : category;
+    }
+
+    std::vector<uint32_t> row_category_;
+    // kNoCategory excluded
+    size_t num_categories_ = 0;
+    const faiss::InvertedLists* invlists_;
+    // per list, its offsets grouped by category
+    std::vector<std::vector<uint32_t>> list_offsets_;
+    std::vector<std::vector<SubList>> sub_lists_;
+};
+
+}  // namespace knowhere
@@ -0,0 +1,62 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/ivf_shared_quantizer.h"
+
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+
+#include "faiss/IndexFlat.h"
+#include "xxhash.h"
+
+namespace knowhere {
+
+namespace {
+
+bool
+same_centroids(const faiss::IndexFlat& a, const faiss::IndexFlat& b) {
+    return typeid(a) == typeid(b) && a.d == b.d && a.metric_type == b.metric_type && a.ntotal == b.ntotal &&
+           a.codes.size() == b.codes.size() && std::memcmp(a.codes.data(), b.codes.data(), a.codes.size()) == 0;
+}
+
+}  // namespace
+
+std::shared_ptr<faiss::Index>
+IvfSharedQuantizers::Share(std::unique_ptr<faiss::Index>& quantizer) {
+    const auto* flat = dynamic_cast<const faiss::IndexFlat*>(quantizer.get());
+    if (flat == nullptr || flat->ntotal == 0) {
+        return nullptr;
+    }
+    // the quantizers by the hash of their centroids, dropped once no index holds them
+    static std::mutex mutex;
+    static std::unordered_multimap<uint64_t, std::weak_ptr<faiss::Index>> quantizers;
+
+    const uint64_t hash = XXH3_64bits(flat->codes.data(), flat->codes.size());
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = quantizers.begin(); it != quantizers.end();) {
+        it = it->second.expired() ? quantizers.erase(it) : std::next(it);
+    }
+    auto [begin, end] = quantizers.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        auto shared = it->second.lock();
+        if (shared != nullptr && same_centroids(*flat, static_cast<const faiss::IndexFlat&>(*shared))) {
+            return shared;
+        }
+    }
+    std::shared_ptr<faiss::Index> shared(quantizer.release());
+    quantizers.emplace(hash, shared);
+    return shared;
+}
+
+}  // namespace knowhere
@@ -0,0 +1,33 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <memory>
+
+#include "faiss/Index.h"
+
+// The coarse quantizers of the IVF indexes with the same centroids, e.g. the segments loaded from the serialization of
+//   one trained index, are a single quantizer held by all of them. Besides the memory of the copies, a batch searched
+//   on such segments then searches the quantizer once for all of them, see Index::SearchSegments().
+
+namespace knowhere {
+
+class IvfSharedQuantizers {
+ public:
+    // the live quantizer with the same centroids as quantizer if there is one, otherwise quantizer itself, taken from
+    //   the caller and registered for the next ones. Only flat quantizers are shared, nullptr is returned for the
+    //   others.
+    static std::shared_ptr<faiss::Index>
+    Share(std::unique_ptr<faiss::Index>& quantizer);
+};
+
+}  // namespace knowhere
@@ -0,0 +1,187 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/ivf/ivf_tombstones.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace knowhere {
+
+size_t
+IvfTombstones::MarkDeleted(const int64_t* ids, size_t n, const faiss::InvertedLists* invlists) {
+    for (size_t i = 0; i < n; i++) {
+        if (static_cast<size_t>(ids[i]) >= list_of_row_.size()) {
+            UpdateListOfRow(invlists);
+            break;
+        }
+    }
+    size_t n_marked = 0;
+    for (size_t i = 0; i < n; i++) {
+        const int64_t id = ids[i];
+        const size_t byte_idx = id >> 3;
+        if (deleted_.size() <= byte_idx) {
+            deleted_.resize(byte_idx + 1, 0);
+        }
+        if (IsDeleted(id)) {
+            continue;
+        }
+        deleted_[byte_idx] |= (0x1 << (id & 0x7));
+        n_marked++;
+        if (static_cast<size_t>(id) < list_of_row_.size() && list_of_row_[id] >= 0) {
+            list_dead_[list_of_row_[id]]++;
+        }
+    }
+    n_deleted_ += n_marked;
+    return n_marked;
+}
+
+std::vector<size_t>
+IvfTombstones::ListsToCompact(const faiss::InvertedLists* invlists, float min_ratio) const {
+    std::vector<size_t> lists;
+    for (size_t list_no = 0; list_no < list_dead_.size(); list_no++) {
+        const size_t dead = list_dead_[list_no];
+        if (dead > 0 && dead >= min_ratio * invlists->list_size(list_no) && IsCompactable(invlists, list_no)) {
+            lists.push_back(list_no);
+        }
+    }
+    return lists;
+}
+
+size_t
+IvfTombstones::CompactList(faiss::InvertedLists* invlists, size_t list_no) {
+    const size_t list_size = invlists->list_size(list_no);
+    if (list_size == 0 || !IsCompactable(invlists, list_no)) {
+        return 0;
+    }
+    // the norms of an array list are a single array, the ones of a concurrent list a pointer per entry
+    const auto* concurrent = dynamic_cast<const faiss::ConcurrentArrayInvertedLists*>(invlists);
+    const float* array_norms = concurrent == nullptr ? invlists->get_code_norms(list_no, 0) : nullptr;
+    const bool with_norms = concurrent != nullptr ? concurrent->save_norm : array_norms != nullptr;
+
+    const size_t code_size = invlists->code_size;
+    std::vector<faiss::idx_t> ids;
+    std::vector<uint8_t> codes;
+    std::vector<float> norms;
+    ids.reserve(list_size);
+    codes.reserve(list_size * code_size);
+    for (size_t offset = 0; offset < list_size; offset++) {
+        const faiss::idx_t id = invlists->get_single_id(list_no, offset);
+        if (IsDeleted(id)) {
+            if (static_cast<size_t>(id) < list_of_row_.size()) {
+                list_of_row_[id] = -1;
+            }
+            continue;
+        }
+        ids.push_back(id);
+        faiss::InvertedLists::ScopedCodes code(invlists, list_no, offset);
+        codes.insert(codes.end(), code.get(), code.get() + code_size);
+        if (with_norms) {
+            norms.push_back(concurrent != nullptr ? *concurrent->get_code_norms(list_no, offset) : array_norms[offset]);
+        }
+    }
+    invlists->resize(list_no, 0);
+    invlists->add_entries(list_no, ids.size(), ids.data(), codes.data(), with_norms ? norms.data() : nullptr);
+    list_dead_[list_no] = 0;
+    return list_size - ids.size();
+}
+
+BitsetView
+IvfTombstones::Filter(const BitsetView& bitset, size_t ntotal, std::vector<uint8_t>& buffer) const {
+    if (Empty()) {
+        return bitset;
+    }
+    // rows beyond the size of a non-empty bitset are filtered out anyway
+    const size_t num_bits = bitset.empty() ? ntotal : bitset.size();
+    const size_t num_bytes = (num_bits + 7) >> 3;
+
+    buffer.assign(num_bytes, 0);
+    if (!bitset.empty()) {
+        bitset.copy_bits(buffer.data());
+    }
+    const size_t n_common = std::min(num_bytes, deleted_.size());
+    for (size_t i = 0; i < n_common; i++) {
+        buffer[i] |= deleted_[i];
+    }
+    if ((num_bits & 0x7) != 0) {
+        buffer[num_bytes - 1] &= (0x1 << (num_bits & 0x7)) - 1;
+    }
+
+    const BitsetView combined(buffer.data(), num_bits);
+    return BitsetView(buffer.data(), num_bits, combined.get_filtered_out_num_());
+}
+
+void
+IvfTombstones::Serialize(BinarySet& binset) const {
+    const size_t size = deleted_.size();
+    std::shared_ptr<uint8_t[]> data(new uint8_t[size]);
+    std::memcpy(data.get(), deleted_.data(), size);
+    binset.Append(kBinaryName, std::move(data), size);
+}
+
+std::unique_ptr<IvfTombstones>
+IvfTombstones::Deserialize(const BinarySet& binset, const faiss::InvertedLists* invlists) {
+    auto binary = binset.GetByName(kBinaryName);
+    if (binary == nullptr) {
+        return nullptr;
+    }
+    auto tombstones = std::make_unique<IvfTombstones>();
+    tombstones->deleted_.assign(binary->data.get(), binary->data.get() + binary->size);
+    for (const uint8_t value : tombstones->deleted_) {
+        tombstones->n_deleted_ += __builtin_popcount(value);
+    }
+    // the entries of the deleted rows that were not compacted before the serialization
+    tombstones->Refresh(invlists);
+    return tombstones;
+}
+
+void
+IvfTombstones::Refresh(const faiss::InvertedLists* invlists) {
+    list_dead_.assign(invlists->nlist, 0);
+    UpdateListOfRow(invlists);
+    for (size_t id = 0; id < list_of_row_.size(); id++) {
+        const int32_t list_no = list_of_row_[id];
+        if (list_no >= 0 && IsDeleted(id)) {
+            list_dead_[list_no]++;
+        }
+    }
+}
+
+bool
+IvfTombstones::IsCompactable(const faiss::InvertedLists* invlists, size_t list_no) {
+    if (dynamic_cast<const faiss::ConcurrentArrayInvertedLists*>(invlists) != nullptr) {
+        return true;
+    }
+    const auto* array = dynamic_cast<const faiss::ArrayInvertedLists*>(invlists);
+    return array != nullptr && array->codes[list_no].is_owned && array->ids[list_no].is_owned;
+}
+
+void
+IvfTombstones::UpdateListOfRow(const faiss::InvertedLists* invlists) {
+    const size_t nlist = invlists->nlist;
+    list_dead_.resize(nlist, 0);
+    std::fill(list_of_row_.begin(), list_of_row_.end(), -1);
+    for (size_t list_no = 0; list_no < nlist; list_no++) {
+        const size_t list_size = invlists->list_size(list_no);
+        for (size_t offset = 0; offset < list_size; offset++) {
+            const faiss::idx_t id = invlists->get_single_id(list_no, offset);
+            if (id < 0) {
+                continue;
+            }
+            if (static_cast<size_t>(id) >= list_of_row_.size()) {
+                list_of_row_.resize(id + 1, -1);
+            }
+            list_of_row_[id] = static_cast<int32_t>(list_no);
+        }
+    }
+}
+
+}  // namespace knowhere
@@ -0,0 +1,100 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "faiss/invlists/InvertedLists.h"
+#include "knowhere/binaryset.h"
+#include "knowhere/bitsetview.h"
+
+// The soft-deleted rows of an IVF index, and per inverted list the number of deleted entries it still holds.
+// A deleted entry is filtered out by the search bitset until its list is compacted, i.e. rewritten without the
+//   deleted entries, so that the scans of an index with many deletes do not grow with the dead rows.
+
+namespace knowhere {
+
+class IvfTombstones {
+ public:
+    static constexpr const char* kBinaryName = "IVF_TOMBSTONES";
+
+    // marks rows as deleted, returns the number of rows that were not deleted before. The row ids are the ids of the
+    //   entries of invlists.
+    size_t
+    MarkDeleted(const int64_t* ids, size_t n, const faiss::InvertedLists* invlists);
+
+    bool
+    IsDeleted(int64_t id) const {
+        return static_cast<size_t>(id >> 3) < deleted_.size() && (deleted_[id >> 3] & (0x1 << (id & 0x7)));
+    }
+
+    size_t
+    Count() const {
+        return n_deleted_;
+    }
+
+    bool
+    Empty() const {
+        return n_deleted_ == 0;
+    }
+
+    // the lists that can be compacted and whose share of deleted entries is at least min_ratio
+    std::vector<size_t>
+    ListsToCompact(const faiss::InvertedLists* invlists, float min_ratio) const;
+
+    // rewrites a list of invlists without its deleted entries, returns the number of entries removed.
+    //   Must not run concurrently with any reader of the list.
+    size_t
+    CompactList(faiss::InvertedLists* invlists, size_t list_no);
+
+    // a search bitset with the deleted rows filtered out as well. 'buffer' keeps the combined bits, the input bitset
+    //   is returned as is if nothing is deleted.
+    BitsetView
+    Filter(const BitsetView& bitset, size_t ntotal, std::vector<uint8_t>& buffer) const;
+
+    size_t
+    Size() const {
+        return deleted_.size() + list_of_row_.size() * sizeof(int32_t) + list_dead_.size() * sizeof(size_t);
+    }
+
+    // looks the list of every row up again, after entries moved between the lists of invlists
+    void
+    Refresh(const faiss::InvertedLists* invlists);
+
+    void
+    Serialize(BinarySet& binset) const;
+
+    // nullptr if binset has no deleted rows
+    static std::unique_ptr<IvfTombstones>
+    Deserialize(const BinarySet& binset, const faiss::InvertedLists* invlists);
+
+ private:
+    // whether a list can be rewritten in place, i.e. is not read-only or a view of memory it does not own
+    static bool
+    IsCompactable(const faiss::InvertedLists* invlists, size_t list_no);
+
+    // the list of every row, looked up again when rows were added since the last time
+    void
+    UpdateListOfRow(const faiss::InvertedLists* invlists);
+
+    std::vector<uint8_t> deleted_;
+    size_t n_deleted_ = 0;
+    // the list of each row, -1 for the rows without an entry
+    std::vector<int32_t> list_of_row_;
+    // per list, the deleted entries that it still holds
+    std::vector<size_t> list_dead_;
+};
+
+}  // namespace knowhere
@@ -32,7 +32,8 @@ IndexIVFRaBitQWrapper::create(const faiss::idx_t d, const size_t nlist, const Iv
     auto qb = ivf_rabitq_cfg.rbq_bits_query.value();
 
     auto idx_flat = std::make_unique<faiss::IndexFlat>(d, metric, false);
-    auto idx_ivfrbq = std::make_unique<faiss::IndexIVFRaBitQ>(idx_flat.release(), d, nlist, metric);
+    auto idx_ivfrbq = std::make_unique<faiss::IndexIVFRaBitQ>(idx_flat.release(), d, nlist, metric,
+                                                              ivf_rabitq_cfg.rbq_bits_data.value());
     idx_ivfrbq->own_fields = true;
     idx_ivfrbq->qb = qb;
 
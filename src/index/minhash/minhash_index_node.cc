@@ -13,6 +13,7 @@
 
 #include "index/minhash/minhash_lsh.h"
 #include "index/minhash/minhash_lsh_config.h"
+#include "index/minhash/minhash_lsh_growing.h"
 #include "index/minhash/minhash_util.h"
 #include "knowhere/bitsetview_idselector.h"
 #include "knowhere/comp/index_param.h"
@@ -48,16 +49,25 @@ class MinHashLSHNode : public IndexNode {
         return Status::not_implemented;
     }
 
+    // adds the rows to an in-memory growing index, which can be searched while rows are added. The first Add
+    // creates it, an index loaded from a file can't be added to.
     Status
-    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override {
-        return Status::not_implemented;
-    }
+    Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) override;
 
     expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override;
 
     expected<DataSetPtr>
     GetVectorByIds(const DataSetPtr dataset) const override {
+        if (growing_lsh_ != nullptr) {
+            auto rows = dataset->GetRows();
+            auto data = std::make_unique<char[]>(rows * growing_lsh_->GetVectorSize());
+            auto stat = growing_lsh_->GetDataByIds(dataset->GetIds(), rows, data.get());
+            if (stat != Status::success) {
+                return expected<DataSetPtr>::Err(stat, "failed to get vectors of the growing minhash index.");
+            }
+            return GenResultDataSet(rows, this->Dim(), std::move(data));
+        }
         if (minhash_lsh_ == nullptr) {
             return expected<DataSetPtr>::Err(Status::empty_index,
                                              "plz build and load index before calling GetVectorByIds.");
@@ -82,6 +92,9 @@ class MinHashLSHNode : public IndexNode {
 
     bool
     HasRawData(const std::string& metric_type) const override {
+        if (growing_lsh_ != nullptr) {
+            return true;
+        }
         if (minhash_lsh_ == nullptr) {
             return false;
         } else {
@@ -121,6 +134,13 @@ class MinHashLSHNode : public IndexNode {
         return Status::not_implemented;
     }
 
+    // the built index is already in the files of the FileManager, and a growing index is not serialized
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        LOG_KNOWHERE_ERROR_ << "minhash index doesn't support Serialization to file.";
+        return Status::not_implemented;
+    }
+
     static std::unique_ptr<BaseConfig>
     StaticCreateConfig() {
         return std::make_unique<MinHashLSHConfig>();
@@ -141,8 +161,19 @@ class MinHashLSHNode : public IndexNode {
         return Status::success;
     }
 
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        if (minhash_lsh_ == nullptr) {
+            return {};
+        }
+        return minhash_lsh_->MappedRegions();
+    }
+
     int64_t
     Dim() const override {
+        if (growing_lsh_ != nullptr) {
+            return growing_lsh_->GetVectorSize() * 8;
+        }
         if (minhash_lsh_ == nullptr) {
             return -1;
         } else {
@@ -152,6 +183,9 @@ class MinHashLSHNode : public IndexNode {
 
     int64_t
     Size() const override {
+        if (growing_lsh_ != nullptr) {
+            return growing_lsh_->Size();
+        }
         if (minhash_lsh_ == nullptr) {
             return 0;
         } else {
@@ -161,6 +195,9 @@ class MinHashLSHNode : public IndexNode {
 
     int64_t
     Count() const override {
+        if (growing_lsh_ != nullptr) {
+            return growing_lsh_->Count();
+        }
         if (minhash_lsh_ == nullptr) {
             return 0;
         } else {
@@ -201,6 +238,7 @@ class MinHashLSHNode : public IndexNode {
     std::string index_prefix_;
     std::shared_ptr<FileManager> file_manager_ = nullptr;
     std::unique_ptr<minhash::MinHashLSH> minhash_lsh_ = nullptr;
+    std::unique_ptr<minhash::MinHashLSHGrowing> growing_lsh_ = nullptr;
     std::shared_ptr<ThreadPool> search_pool_;
     bool is_loaded_ = false;
     const std::string fname_ = "minhash_lsh_index";
@@ -233,7 +271,8 @@ MinHashLSHNode<DataType>::Build(const DataSetPtr dataset, std::shared_ptr<Config
             .block_size = size_t(build_conf.mh_lsh_aligned_block_size.value()),
             .with_raw_data = build_conf.with_raw_data.value(),
             .mh_vec_element_size = mh_vec_element_size,
-            .mh_vec_length = mh_vec_length};
+            .mh_vec_length = mh_vec_length,
+            .prefix_key = build_conf.mh_lsh_prefix_key.value()};
 
         auto build_stat = minhash::MinHashLSH::BuildAndSave(&index_params);
         if (build_stat != Status::success) {
@@ -250,6 +289,39 @@ MinHashLSHNode<DataType>::Build(const DataSetPtr dataset, std::shared_ptr<Config
     return Status::success;
 }
 
+template <typename DataType>
+Status
+MinHashLSHNode<DataType>::Add(const DataSetPtr dataset, std::shared_ptr<Config> cfg, bool use_knowhere_build_pool) {
+    if (minhash_lsh_ != nullptr) {
+        LOG_KNOWHERE_ERROR_ << "Can't add rows to a minhash index loaded from file.";
+        return Status::not_implemented;
+    }
+    auto add_conf = static_cast<const MinHashLSHConfig&>(*cfg);
+    size_t dim = dataset->GetDim();
+    size_t bit_width = add_conf.mh_element_bit_width.value();
+    if (dim % 8 != 0 || bit_width % 8 != 0) {
+        LOG_KNOWHERE_ERROR_ << "Expecting (dim % 8 == 0) and (mh_element_bit_width % 8 == 0)";
+        return Status::invalid_args;
+    }
+    try {
+        if (growing_lsh_ == nullptr) {
+            size_t band = add_conf.mh_lsh_band.value();
+            if ((dim / bit_width) % band != 0) {
+                LOG_KNOWHERE_ERROR_ << "Expecting (dim / mh_element_bit_width) % mh_lsh_band == 0";
+                return Status::invalid_args;
+            }
+            growing_lsh_ = std::make_unique<minhash::MinHashLSHGrowing>(band, bit_width / 8, dim / bit_width);
+        } else if ((int64_t)dim != this->Dim()) {
+            LOG_KNOWHERE_ERROR_ << "Expecting dim " << this->Dim() << " to add to the growing index, got " << dim;
+            return Status::invalid_args;
+        }
+        return growing_lsh_->Add(static_cast<const char*>(dataset->GetTensor()), dataset->GetRows());
+    } catch (const std::exception& e) {
+        LOG_KNOWHERE_ERROR_ << "minhash lsh inner error: " << e.what();
+        return Status::internal_error;
+    }
+}
+
 template <typename DataType>
 Status
 MinHashLSHNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr<Config> cfg) {
@@ -259,6 +331,7 @@ MinHashLSHNode<DataType>::Deserialize(const BinarySet& binset, std::shared_ptr<C
     index_params_ptr->hash_code_in_memory = load_conf.mh_lsh_code_in_mem.value();
     index_params_ptr->global_bloom_filter = load_conf.mh_lsh_shared_bloom_filter.value();
     index_params_ptr->false_positive_prob = load_conf.mh_lsh_bloom_false_positive_prob.value();
+    index_params_ptr->blocked_bloom_filter = load_conf.mh_lsh_blocked_bloom_filter.value();
     if (!LoadFile(index_params_ptr->index_file_path)) {
         LOG_KNOWHERE_ERROR_ << "Failed load the raw data before building.";
         return Status::disk_file_error;
@@ -281,7 +354,7 @@ template <typename DataType>
 expected<DataSetPtr>
 MinHashLSHNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg,
                                  const BitsetView& bitset) const {
-    if (!is_loaded_ || !minhash_lsh_) {
+    if ((!is_loaded_ || !minhash_lsh_) && !growing_lsh_) {
         LOG_KNOWHERE_ERROR_ << "Failed to load minhash index.";
         return expected<DataSetPtr>::Err(Status::empty_index, "Minhash index not loaded");
     }
@@ -300,10 +373,31 @@ MinHashLSHNode<DataType>::Search(const DataSetPtr dataset, std::unique_ptr<Confi
     search_params.k = topk;
     search_params.search_with_jaccard = search_conf.mh_search_with_jaccard.value();
     search_params.refine_k = search_conf.refine_k.value_or(topk);
+    search_params.multi_probe = search_conf.mh_lsh_multi_probe.value();
     BitsetViewIDSelector bw_idselector(bitset);
     search_params.id_selector = (bitset.empty()) ? nullptr : &bw_idselector;
     try {
-        if (search_conf.mh_lsh_batch_search.value() == true) {
+        if (growing_lsh_ != nullptr) {
+            std::vector<folly::Future<Status>> futures;
+            constexpr size_t batch_size = 64;
+            size_t run_time = (nq + batch_size - 1) / batch_size;
+            futures.reserve(run_time);
+            for (size_t row = 0; row < run_time; ++row) {
+                futures.emplace_back(
+                    search_pool_->push([&, beg = row * batch_size, end = std::min(int64_t((row + 1) * batch_size), nq),
+                                        p_id_ptr = p_id.get(), p_dist_ptr = p_dist.get()]() {
+                        for (size_t index = beg; index < (size_t)end; index++) {
+                            RETURN_IF_ERROR(growing_lsh_->Search(xq + (index * dim), p_dist_ptr + index * topk,
+                                                                 p_id_ptr + index * topk, &search_params));
+                        }
+                        return Status::success;
+                    }));
+            }
+            auto search_stat = WaitAllSuccess(futures);
+            if (search_stat != Status::success) {
+                return expected<DataSetPtr>::Err(search_stat, "failed to search the growing minhash index.");
+            }
+        } else if (search_conf.mh_lsh_batch_search.value() == true) {
             minhash_lsh_->BatchSearch(xq, nq, p_dist.get(), p_id.get(), search_pool_, &search_params);
         } else {
             std::vector<folly::Future<folly::Unit>> futures;
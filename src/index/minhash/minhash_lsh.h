@@ -11,6 +11,11 @@
 
 #ifndef MINHASH_LSH_H
 #define MINHASH_LSH_H
+#include <unistd.h>
+
+#include <array>
+#include <cstring>
+
 #include "faiss/impl/io.h"
 #include "index/minhash/minhash_util.h"
 #include "io/file_io.h"
@@ -18,6 +23,7 @@
 #include "knowhere/bitsetview_idselector.h"
 #include "knowhere/comp/bloomfilter.h"
 #include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/warm_up.h"
 #include "knowhere/expected.h"
 #include "knowhere/log.h"
 #include "knowhere/utils.h"
@@ -35,6 +41,8 @@ struct MinHashLSHBuildParams {
     bool with_raw_data = false;
     size_t mh_vec_element_size = 8;
     size_t mh_vec_length = 0;
+    // band keys whose high half only hashes the first half of the band, see get_prefix_hash_key
+    bool prefix_key = false;
 };
 
 struct MinHashLSHLoadParams {
@@ -42,12 +50,16 @@ struct MinHashLSHLoadParams {
     bool hash_code_in_memory = false;
     bool global_bloom_filter = false;
     float false_positive_prob = 0.01;
+    // use BlockedBloomFilter, a lookup touches one cache line
+    bool blocked_bloom_filter = false;
 };
 
 struct MinHashLSHSearchParams {
     size_t k = 1;
     size_t refine_k = 1;
     bool search_with_jaccard = false;
+    // also probe the first half of each band if the index has prefix keys, after the exact probes
+    bool multi_probe = false;
     faiss::IDSelector* id_selector = nullptr;
 };
 
@@ -58,36 +70,44 @@ struct KVPair {
 // index of each band
 class MinHashBandIndex {
  public:
+    // the number of bytes FormatAndSave writes for a band of rows
     static size_t
-    FormatAndSave(faiss::BlockFileIOWriter& writer, const KVPair* sorted_kv, const size_t block_size,
-                  const size_t rows);
+    FormattedSize(const size_t block_size, const size_t rows);
+
+    // writes the band at offset of the file fd, index_meta_pos is set to the offset of its meta. Bands at different
+    // offsets may be written concurrently.
+    static Status
+    FormatAndSave(int fd, size_t offset, const KVPair* sorted_kv, const size_t block_size, const size_t rows,
+                  size_t& index_meta_pos);
 
+    // with_prefix also adds the prefix probe keys of the rows to bloom_filter, see prefix_probe_key
+    template <typename Filter>
     Status
-    Load(FileReader& reader, size_t rows, char* mmap_data, BloomFilter<KeyType>& bloom_filter);
+    Load(FileReader& reader, size_t rows, char* mmap_data, Filter& bloom_filter, bool with_prefix = false);
 
     void
     Search(KeyType key, MinHashLSHResultHandler* res, faiss::IDSelector* id_selector) const;
 
-    Status
-    WarmUp() const {
-        if (mmap_enable_) {
-            if (madvise(data_, block_size_ * blocks_num_, MADV_WILLNEED) == -1) {
-                LOG_KNOWHERE_WARNING_ << "Failed to warmup band data : " << strerror(errno);
-                return Status::disk_file_error;
-            }
-        }
-        return Status::success;
-    }
+    // pushes the rows whose keys are in [lo, hi]
+    void
+    SearchRange(KeyType lo, KeyType hi, MinHashLSHResultHandler* res, faiss::IDSelector* id_selector) const;
 
-    Status
-    CoolDown() const {
+    // searches n keys sorted by Key in one sweep over the blocks, the hits of a key go to all_res[Value]
+    void
+    SearchSorted(const KVPair* sorted_keys, size_t n, MinHashLSHResultHandler* all_res,
+                 faiss::IDSelector* id_selector) const;
+
+    // in mmap mode, asks the kernel to read ahead the blocks that the n keys sorted by Key may be in, without waiting
+    // for them. Adjacent blocks are requested together.
+    void
+    Prefetch(const KVPair* sorted_keys, size_t n) const;
+
+    // the blocks are the structure of the index, a probe binary searches them
+    void
+    AppendMappedRegions(std::vector<MappedRegion>& regions) const {
         if (mmap_enable_) {
-            if (madvise(data_, block_size_ * blocks_num_, MADV_DONTNEED) == -1) {
-                LOG_KNOWHERE_WARNING_ << "Failed to cooldown band data : " << strerror(errno);
-                return Status::disk_file_error;
-            }
+            regions.push_back(MappedRegion{data_, block_size_ * blocks_num_, true});
         }
-        return Status::success;
     }
 
  private:
@@ -105,8 +125,9 @@ class MinHashBandIndex {
 class MinHashLSH {
  public:
     MinHashLSH(){};
+    // builds from the rows of params->data_path, or from the rows of data if it is not null
     static Status
-    BuildAndSave(MinHashLSHBuildParams* params);
+    BuildAndSave(MinHashLSHBuildParams* params, const char* data = nullptr, size_t rows = 0);
     Status
     Load(MinHashLSHLoadParams* params);
     Status
@@ -132,6 +153,18 @@ class MinHashLSH {
     GetVectorSize() const {
         return this->mh_vec_length_ * this->mh_vec_elememt_size_;
     }
+    // the mapped band blocks, then the raw data that is read only for a search with jaccard and GetDataByIds()
+    std::vector<MappedRegion>
+    MappedRegions() const {
+        std::vector<MappedRegion> regions;
+        for (size_t i = 0; band_index_ != nullptr && i < band_; i++) {
+            band_index_[i].AppendMappedRegions(regions);
+        }
+        if (raw_data_ != nullptr) {
+            regions.push_back(MappedRegion{raw_data_, ntotal_ * GetVectorSize(), false});
+        }
+        return regions;
+    }
 
     ~MinHashLSH() {
         if (mmap_data_) {
@@ -148,16 +181,39 @@ class MinHashLSH {
     size_t file_size_ = 0;
     bool with_raw_data_ = false;
     char* raw_data_ = nullptr;  // mmap mode, use IO object later
+    // only one of them is filled, by MinHashLSHLoadParams::blocked_bloom_filter
     std::vector<BloomFilter<KeyType>> bloom_;
+    std::vector<BlockedBloomFilter<KeyType>> blocked_bloom_;
     size_t mh_vec_elememt_size_ = 0;
     size_t mh_vec_length_ = 0;
     size_t ntotal_ = 0;
+    bool prefix_key_ = false;
+
+    KeyType
+    BandKey(const char* query, size_t i) const;
+
+    // exact probes run first, the prefix probes of the bands only for the queries that are not full yet
+    void
+    SearchPrefix(const char* query, MinHashLSHResultHandler* res, faiss::IDSelector* id_selector) const;
+
+    // whether the bloom filter of band i may contain hash
+    bool
+    BandMayContain(size_t i, KeyType hash) const {
+        if (!blocked_bloom_.empty()) {
+            return blocked_bloom_[i % blocked_bloom_.size()].contains(hash);
+        }
+        return bloom_[i % bloom_.size()].contains(hash);
+    }
 };
 
 namespace {
 constexpr int kBatch = 4096;
 constexpr int kQueryBatch = 64;
 constexpr int kQueryBandBatch = 4;
+// the radix sort splits the pairs into chunks of at least this many, one per thread
+constexpr size_t kRadixSortMinChunk = 65536;
+// FormatAndSave writes the blocks of a band about this many bytes at a time
+constexpr size_t kFormatWriteBytes = 1 << 20;
 
 inline KeyType
 get_hash_key(const char* data, size_t size /*in bytes*/, size_t band, size_t band_i) {
@@ -166,8 +222,27 @@ get_hash_key(const char* data, size_t size /*in bytes*/, size_t band, size_t ban
     return faiss::calculate_hash((const char*)band_i_data, r);
 }
 
+// the high 32 bits hash the first half of the elements of the band and the low 32 bits the rest, so the keys of the
+// rows that share the first half are adjacent in a band and can be probed as a range
+inline KeyType
+get_prefix_hash_key(const char* data, size_t size /*in bytes*/, size_t band, size_t band_i, size_t element_size) {
+    const size_t r = size / band;
+    const size_t half = r / element_size / 2 * element_size;
+    auto band_i_data = data + r * band_i;
+    return (faiss::calculate_hash(band_i_data, half) << 32) |
+           (faiss::calculate_hash(band_i_data + half, r - half) & 0xffffffffULL);
+}
+
+constexpr KeyType kPrefixKeyMask = 0xffffffff00000000ULL;
+
+// the key that stands for the prefix of key in the bloom filters, the prefixes are added with the keys
+inline KeyType
+prefix_probe_key(KeyType key) {
+    return key | ~kPrefixKeyMask;
+}
+
 inline std::shared_ptr<KVPair[]>
-gen_transposed_hash_kv(const char* data, size_t rows, size_t data_size, size_t band) {
+gen_transposed_hash_kv(const char* data, size_t rows, size_t data_size, size_t band, size_t element_size = 0) {
     auto res_kv = std::shared_ptr<KVPair[]>(new KVPair[band * rows]);
     auto batch_num = (rows + kBatch - 1) / kBatch;
     auto build_pool = ThreadPool::GetGlobalBuildThreadPool();
@@ -179,7 +254,9 @@ gen_transposed_hash_kv(const char* data, size_t rows, size_t data_size, size_t b
             for (size_t j = beg_id; j < end_id; j++) {
                 const char* data_j = data + data_size * j;
                 for (size_t b = 0; b < band; b++) {
-                    KVPair kv = {get_hash_key(data_j, data_size, band, b), ValueType(j)};
+                    auto key = element_size == 0 ? get_hash_key(data_j, data_size, band, b)
+                                                 : get_prefix_hash_key(data_j, data_size, band, b, element_size);
+                    KVPair kv = {key, ValueType(j)};
                     res_kv.get()[b * rows + j] = kv;
                 }
             }
@@ -189,63 +266,157 @@ gen_transposed_hash_kv(const char* data, size_t rows, size_t data_size, size_t b
     return res_kv;
 }
 
+// stable LSD radix sort of kv by key, 8 bits at a time. Every pass counts the digits of each chunk of kv, then
+// scatters the chunks in parallel to their offsets in buf, which must hold n pairs.
 void
-sort_kv(const std::shared_ptr<KVPair[]> kv_code, size_t rows, size_t band) {
+radix_sort_kv(KVPair* kv, KVPair* buf, size_t n) {
+    constexpr size_t kRadixBits = 8;
+    constexpr size_t kRadix = 1 << kRadixBits;
     auto build_pool = ThreadPool::GetGlobalBuildThreadPool();
-    std::vector<folly::Future<folly::Unit>> futures;
+    const size_t n_chunks = std::max<size_t>(1, std::min<size_t>(build_pool->size(), n / kRadixSortMinChunk));
+    const size_t chunk_size = (n + n_chunks - 1) / n_chunks;
+    std::vector<std::array<size_t, kRadix>> offsets(n_chunks);
+    KVPair* src = kv;
+    KVPair* dst = buf;
+    auto for_each_chunk = [&](auto&& func) {
+        std::vector<folly::Future<folly::Unit>> futures;
+        futures.reserve(n_chunks);
+        for (size_t c = 0; c < n_chunks; c++) {
+            futures.emplace_back(build_pool->push([&, c = c]() {
+                func(c, c * chunk_size, std::min((c + 1) * chunk_size, n));
+            }));
+        }
+        WaitAllSuccess(futures);
+    };
+    for (size_t shift = 0; shift < sizeof(KeyType) * 8; shift += kRadixBits) {
+        for_each_chunk([&](size_t c, size_t beg, size_t end) {
+            offsets[c].fill(0);
+            for (size_t i = beg; i < end; i++) {
+                offsets[c][(src[i].Key >> shift) & (kRadix - 1)]++;
+            }
+        });
+        // the chunks of a digit are placed in order, which keeps the sort stable
+        size_t pos = 0;
+        bool single_digit = false;
+        for (size_t d = 0; d < kRadix; d++) {
+            size_t count = 0;
+            for (size_t c = 0; c < n_chunks; c++) {
+                count += offsets[c][d];
+                offsets[c][d] = pos + count - offsets[c][d];
+            }
+            single_digit |= count == n;
+            pos += count;
+        }
+        if (single_digit) {
+            continue;
+        }
+        for_each_chunk([&](size_t c, size_t beg, size_t end) {
+            for (size_t i = beg; i < end; i++) {
+                dst[offsets[c][(src[i].Key >> shift) & (kRadix - 1)]++] = src[i];
+            }
+        });
+        std::swap(src, dst);
+    }
+    if (src != kv) {
+        for_each_chunk([&](size_t, size_t beg, size_t end) { std::copy(src + beg, src + end, kv + beg); });
+    }
+}
+
+// the bands are sorted one after another, each by all the threads, so that a single band sized buffer is needed
+void
+sort_kv(const std::shared_ptr<KVPair[]> kv_code, size_t rows, size_t band) {
+    auto buf = std::unique_ptr<KVPair[]>(new KVPair[rows]);
     for (size_t i = 0; i < band; i++) {
-        futures.emplace_back(build_pool->push([&, idx = i]() {
-            std::sort(kv_code.get() + rows * idx, kv_code.get() + rows * (idx + 1),
-                      [](const KVPair& a, const KVPair& b) { return a.Key < b.Key; });
-        }));
+        radix_sort_kv(kv_code.get() + rows * i, buf.get(), rows);
     }
-    WaitAllSuccess(futures);
+}
+
+Status
+pwrite_all(int fd, const char* data, size_t size, size_t offset) {
+    while (size > 0) {
+        auto written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_KNOWHERE_ERROR_ << "Failed to write band index: " << strerror(errno);
+            return Status::disk_file_error;
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return Status::success;
+}
+
+inline size_t
+band_blocks_num(const size_t block_size, const size_t rows) {
+    const size_t max_num_of_a_block = block_size / sizeof(KVPair);
+    return (rows + max_num_of_a_block - 1) / max_num_of_a_block;
+}
+
+// blocks_num, block_size and data_pos, then the mins, maxs and sizes of the blocks
+inline size_t
+band_meta_size(const size_t blocks_num) {
+    return 3 * sizeof(size_t) + blocks_num * (2 * sizeof(KeyType) + sizeof(size_t));
 }
 }  // namespace
 
 size_t
-MinHashBandIndex::FormatAndSave(faiss::BlockFileIOWriter& writer, const KVPair* sorted_kv, const size_t block_size,
-                                const size_t rows) {
-    size_t max_num_of_a_block = block_size / sizeof(KVPair);
-    size_t blocks_num = (rows + max_num_of_a_block - 1) / max_num_of_a_block;
-    std::vector<KeyType> mins;
-    std::vector<KeyType> maxs;
-    std::vector<size_t> num_in_a_blk;
-    mins.resize(blocks_num);
-    maxs.resize(blocks_num);
-    num_in_a_blk.resize(blocks_num);
-    std::unique_ptr<KeyType[]> block_key_buf = std::make_unique<KeyType[]>(max_num_of_a_block);
-    std::unique_ptr<ValueType[]> block_val_buf = std::make_unique<ValueType[]>(max_num_of_a_block);
-    writer.flush();
-    size_t data_pos = writer.tellg();
-    for (size_t i = 0; i < blocks_num; i++) {
-        writer.flush();
-        auto beg = i * max_num_of_a_block;
-        auto end = std::min((i + 1) * max_num_of_a_block, rows);
-        num_in_a_blk[i] = end - beg;
-        mins[i] = sorted_kv[beg].Key;
-        maxs[i] = sorted_kv[end - 1].Key;
-        for (size_t j = 0; j < num_in_a_blk[i]; j++) {
-            block_key_buf[j] = sorted_kv[beg + j].Key;
-            block_val_buf[j] = sorted_kv[beg + j].Value;
-        }
-        writer.write((const char*)block_key_buf.get(), num_in_a_blk[i] * sizeof(KeyType));
-        writer.write((const char*)block_val_buf.get(), num_in_a_blk[i] * sizeof(ValueType));
-    }
-    writer.flush();
-    auto index_meta_pos = writer.tellg();
-    writeBinaryPOD(writer, blocks_num);
-    writeBinaryPOD(writer, block_size);
-    writeBinaryPOD(writer, data_pos);
-    writer.write((const char*)mins.data(), mins.size() * sizeof(KeyType));
-    writer.write((const char*)maxs.data(), maxs.size() * sizeof(KeyType));
-    writer.write((const char*)num_in_a_blk.data(), num_in_a_blk.size() * sizeof(size_t));
-    writer.flush();
-    return index_meta_pos;
+MinHashBandIndex::FormattedSize(const size_t block_size, const size_t rows) {
+    const size_t blocks_num = band_blocks_num(block_size, rows);
+    return blocks_num * block_size + ROUND_UP(band_meta_size(blocks_num), block_size);
 }
 
 Status
-MinHashBandIndex::Load(FileReader& reader, size_t rows, char* mmap_data, BloomFilter<KeyType>& bloom_filter) {
+MinHashBandIndex::FormatAndSave(int fd, size_t offset, const KVPair* sorted_kv, const size_t block_size,
+                                const size_t rows, size_t& index_meta_pos) {
+    const size_t max_num_of_a_block = block_size / sizeof(KVPair);
+    const size_t blocks_num = band_blocks_num(block_size, rows);
+    std::vector<KeyType> mins(blocks_num);
+    std::vector<KeyType> maxs(blocks_num);
+    std::vector<size_t> num_in_a_blk(blocks_num);
+    // the keys of a block, then its values
+    const size_t blocks_per_write = std::max<size_t>(1, kFormatWriteBytes / block_size);
+    std::vector<char> buf(std::min(blocks_num, blocks_per_write) * block_size);
+    for (size_t i = 0; i < blocks_num; i += blocks_per_write) {
+        const size_t n_blocks = std::min(blocks_per_write, blocks_num - i);
+        std::fill(buf.begin(), buf.begin() + n_blocks * block_size, 0);
+        for (size_t blk = i; blk < i + n_blocks; blk++) {
+            auto beg = blk * max_num_of_a_block;
+            auto end = std::min((blk + 1) * max_num_of_a_block, rows);
+            num_in_a_blk[blk] = end - beg;
+            mins[blk] = sorted_kv[beg].Key;
+            maxs[blk] = sorted_kv[end - 1].Key;
+            auto blk_k = reinterpret_cast<KeyType*>(buf.data() + (blk - i) * block_size);
+            auto blk_v = reinterpret_cast<ValueType*>(blk_k + num_in_a_blk[blk]);
+            for (size_t j = 0; j < num_in_a_blk[blk]; j++) {
+                blk_k[j] = sorted_kv[beg + j].Key;
+                blk_v[j] = sorted_kv[beg + j].Value;
+            }
+        }
+        RETURN_IF_ERROR(pwrite_all(fd, buf.data(), n_blocks * block_size, offset + i * block_size));
+    }
+
+    index_meta_pos = offset + blocks_num * block_size;
+    std::vector<char> meta(ROUND_UP(band_meta_size(blocks_num), block_size), 0);
+    char* meta_ptr = meta.data();
+    auto append = [&](const void* data, size_t size) {
+        std::memcpy(meta_ptr, data, size);
+        meta_ptr += size;
+    };
+    append(&blocks_num, sizeof(blocks_num));
+    append(&block_size, sizeof(block_size));
+    append(&offset, sizeof(offset));
+    append(mins.data(), mins.size() * sizeof(KeyType));
+    append(maxs.data(), maxs.size() * sizeof(KeyType));
+    append(num_in_a_blk.data(), num_in_a_blk.size() * sizeof(size_t));
+    return pwrite_all(fd, meta.data(), meta.size(), index_meta_pos);
+}
+
+template <typename Filter>
+Status
+MinHashBandIndex::Load(FileReader& reader, size_t rows, char* mmap_data, Filter& bloom_filter, bool with_prefix) {
     size_t data_pos;
     readBinaryPOD(reader, this->blocks_num_);
     readBinaryPOD(reader, this->block_size_);
@@ -267,13 +438,16 @@ MinHashBandIndex::Load(FileReader& reader, size_t rows, char* mmap_data, BloomFi
         mmap_enable_ = false;
     }
 
-    auto build_pool = ThreadPool::GetGlobalBuildThreadPool();
+    auto build_pool = NestedBuildThreadPool();
     std::vector<folly::Future<folly::Unit>> futures;
     for (size_t i = 0; i < blocks_num_; i++) {
-        futures.emplace_back(build_pool->push([&, idx = i]() {
+        futures.emplace_back(build_pool.push([&, idx = i]() {
             KeyType* blk_i = reinterpret_cast<KeyType*>(data_ + block_size_ * idx);
             for (size_t j = 0; j < num_in_a_blk_[idx]; j++) {
                 bloom_filter.add(blk_i[j]);
+                if (with_prefix) {
+                    bloom_filter.add(prefix_probe_key(blk_i[j]));
+                }
             }
         }));
     }
@@ -288,13 +462,13 @@ MinHashBandIndex::Search(KeyType key, MinHashLSHResultHandler* res, faiss::IDSel
     if (block_id == -1 || key < mins_[block_id]) {
         return;
     }
-    while ((size_t)block_id < mins_.size() && key >= mins_[block_id]) {
+    while ((size_t)block_id < mins_.size() && key >= mins_[block_id] && !res->full()) {
         size_t rows = num_in_a_blk_[block_id];
         KeyType* blk_k = reinterpret_cast<KeyType*>(data_ + block_size_ * block_id);
         ValueType* blk_v = reinterpret_cast<ValueType*>(data_ + block_size_ * block_id + rows * sizeof(KeyType));
         int inner_id = faiss::u64_binary_search_eq(blk_k, rows, key);
         if (inner_id != -1) {
-            for (; key == blk_k[inner_id] && (size_t)inner_id < rows; inner_id++) {
+            for (; (size_t)inner_id < rows && key == blk_k[inner_id]; inner_id++) {
                 if (id_selector == nullptr || id_selector->is_member(blk_v[inner_id])) {
                     res->push(blk_v[inner_id], 1.0);
                 }
@@ -307,8 +481,117 @@ MinHashBandIndex::Search(KeyType key, MinHashLSHResultHandler* res, faiss::IDSel
     return;
 }
 
+void
+MinHashBandIndex::SearchRange(KeyType lo, KeyType hi, MinHashLSHResultHandler* res,
+                              faiss::IDSelector* id_selector) const {
+    auto block_id = faiss::u64_binary_search_ge(maxs_.data(), maxs_.size(), lo);
+    if (block_id == -1) {
+        return;
+    }
+    for (size_t b = block_id; b < blocks_num_ && mins_[b] <= hi && !res->full(); b++) {
+        size_t rows = num_in_a_blk_[b];
+        KeyType* blk_k = reinterpret_cast<KeyType*>(data_ + block_size_ * b);
+        ValueType* blk_v = reinterpret_cast<ValueType*>(data_ + block_size_ * b + rows * sizeof(KeyType));
+        for (size_t j = std::lower_bound(blk_k, blk_k + rows, lo) - blk_k; j < rows && blk_k[j] <= hi && !res->full();
+             j++) {
+            if (id_selector == nullptr || id_selector->is_member(blk_v[j])) {
+                res->push(blk_v[j], 1.0);
+            }
+        }
+    }
+}
+
+void
+MinHashBandIndex::Prefetch(const KVPair* sorted_keys, size_t n) const {
+    if (!mmap_enable_ || blocks_num_ == 0) {
+        return;
+    }
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    // the blocks [range_beg, range_end) are not requested yet
+    size_t range_beg = 0;
+    size_t range_end = 0;
+    auto advise = [&]() {
+        if (range_beg == range_end) {
+            return;
+        }
+        auto beg = reinterpret_cast<uintptr_t>(data_ + block_size_ * range_beg) / page_size * page_size;
+        auto end = reinterpret_cast<uintptr_t>(data_ + block_size_ * range_end);
+        if (madvise(reinterpret_cast<void*>(beg), end - beg, MADV_WILLNEED) == -1) {
+            LOG_KNOWHERE_WARNING_ << "Failed to prefetch band data : " << strerror(errno);
+        }
+    };
+    size_t block_id = 0;
+    for (size_t i = 0; i < n; i++) {
+        const KeyType key = sorted_keys[i].Key;
+        if (maxs_[block_id] < key) {
+            auto next = faiss::u64_binary_search_ge(maxs_.data() + block_id, blocks_num_ - block_id, key);
+            if (next == -1) {
+                break;
+            }
+            block_id += next;
+        }
+        size_t last = block_id;
+        while (last < blocks_num_ && key >= mins_[last]) {
+            last++;
+        }
+        if (last == block_id) {
+            continue;
+        }
+        if (block_id <= range_end) {
+            range_end = std::max(range_end, last);
+        } else {
+            advise();
+            range_beg = block_id;
+            range_end = last;
+        }
+    }
+    advise();
+}
+
+void
+MinHashBandIndex::SearchSorted(const KVPair* sorted_keys, size_t n, MinHashLSHResultHandler* all_res,
+                               faiss::IDSelector* id_selector) const {
+    if (blocks_num_ == 0) {
+        return;
+    }
+    // the blocks before block_id, and the keys of block_id before inner_beg, are less than the current key
+    size_t block_id = 0;
+    size_t inner_beg = 0;
+    for (size_t i = 0; i < n; i++) {
+        const KeyType key = sorted_keys[i].Key;
+        auto& res = all_res[sorted_keys[i].Value];
+        if (maxs_[block_id] < key) {
+            auto next = faiss::u64_binary_search_ge(maxs_.data() + block_id, blocks_num_ - block_id, key);
+            if (next == -1) {
+                return;
+            }
+            block_id += next;
+            inner_beg = 0;
+        }
+        for (size_t b = block_id; b < blocks_num_ && key >= mins_[b] && !res.full(); b++) {
+            size_t rows = num_in_a_blk_[b];
+            size_t beg = b == block_id ? inner_beg : 0;
+            KeyType* blk_k = reinterpret_cast<KeyType*>(data_ + block_size_ * b);
+            ValueType* blk_v = reinterpret_cast<ValueType*>(data_ + block_size_ * b + rows * sizeof(KeyType));
+            int inner_id = faiss::u64_binary_search_eq(blk_k + beg, rows - beg, key);
+            if (inner_id == -1) {
+                continue;
+            }
+            size_t j = beg + inner_id;
+            if (b == block_id) {
+                inner_beg = j;
+            }
+            for (; j < rows && blk_k[j] == key && !res.full(); j++) {
+                if (id_selector == nullptr || id_selector->is_member(blk_v[j])) {
+                    res.push(blk_v[j], 1.0);
+                }
+            }
+        }
+    }
+}
+
 Status
-MinHashLSH::BuildAndSave(MinHashLSHBuildParams* params) {
+MinHashLSH::BuildAndSave(MinHashLSHBuildParams* params, const char* data, size_t rows) {
     if (params == nullptr) {
         LOG_KNOWHERE_ERROR_ << "build parameters is null.";
         return Status::invalid_args;
@@ -329,21 +612,31 @@ MinHashLSH::BuildAndSave(MinHashLSHBuildParams* params) {
     faiss::BlockFileIOWriter writer(params->index_file_path.c_str(), block_size, header_size);
     // load raw data, generate hash kv for each band and save raw data
     {
-        std::unique_ptr<char[]> data = nullptr;
-        // raw data save like binary vector format
-        load_vec_data<bin1>(params->data_path, data, ntotal, bin_vec_dim);
-        if (bin_vec_dim != mh_vec_element_size * mh_vec_length * 8) {
-            LOG_KNOWHERE_ERROR_ << "fail to load binary file, dim in file(" << bin_vec_dim
-                                << ") not equal to mh_vec_element_size * mh_vec_length * 8:"
-                                << params->mh_vec_element_size * params->mh_vec_length * 8;
-            return Status::disk_file_error;
+        std::unique_ptr<char[]> loaded_data = nullptr;
+        if (data == nullptr) {
+            // raw data save like binary vector format
+            load_vec_data<bin1>(params->data_path, loaded_data, ntotal, bin_vec_dim);
+            if (bin_vec_dim != mh_vec_element_size * mh_vec_length * 8) {
+                LOG_KNOWHERE_ERROR_ << "fail to load binary file, dim in file(" << bin_vec_dim
+                                    << ") not equal to mh_vec_element_size * mh_vec_length * 8:"
+                                    << params->mh_vec_element_size * params->mh_vec_length * 8;
+                return Status::disk_file_error;
+            }
+            data = loaded_data.get();
+        } else {
+            ntotal = rows;
         }
         if (mh_vec_length % band_index_n != 0) {
             LOG_KNOWHERE_ERROR_ << "params->mh_vec_length % params.band != 0";
             return Status::invalid_args;
         }
+        if (params->prefix_key && mh_vec_length / band_index_n < 2) {
+            LOG_KNOWHERE_ERROR_ << "prefix keys need at least 2 elements in a band.";
+            return Status::invalid_args;
+        }
 
-        total_kv_pair = gen_transposed_hash_kv(data.get(), ntotal, data_size, band_index_n);
+        total_kv_pair = gen_transposed_hash_kv(data, ntotal, data_size, band_index_n,
+                                               params->prefix_key ? mh_vec_element_size : 0);
         if (params->with_raw_data) {
             data_pos = writer.tellg();
             // todo: @cqy123456 format raw data if use disk index
@@ -351,20 +644,29 @@ MinHashLSH::BuildAndSave(MinHashLSHBuildParams* params) {
 
             for (size_t i = 0; i < ntotal; i += vec_num_a_blk) {
                 auto num = std::min(ntotal - i, vec_num_a_blk);
-                writer.flush_and_write((char*)(data.get() + i * data_size), num * data_size);
+                writer.flush_and_write((char*)(data + i * data_size), num * data_size);
             }
         }
     }
 
-    // save hash kv as MinHashBandIndex format
+    // save hash kv as MinHashBandIndex format, the bands are written concurrently at their precomputed offsets
     std::vector<size_t> band_index_ofs(band_index_n);
     {
         sort_kv(total_kv_pair, ntotal, band_index_n);
 
+        const size_t band_bytes = MinHashBandIndex::FormattedSize(block_size, ntotal);
+        const size_t band_pos = writer.reserve_blocks(band_index_n * band_bytes / block_size);
+        auto build_pool = ThreadPool::GetGlobalBuildThreadPool();
+        std::vector<folly::Future<Status>> futures;
+        futures.reserve(band_index_n);
         for (size_t index_i = 0; index_i < band_index_n; index_i++) {
-            band_index_ofs[index_i] =
-                MinHashBandIndex::FormatAndSave(writer, total_kv_pair.get() + index_i * ntotal, block_size, ntotal);
+            futures.emplace_back(build_pool->push([&, index_i = index_i]() {
+                return MinHashBandIndex::FormatAndSave(writer.filedescriptor(), band_pos + index_i * band_bytes,
+                                                       total_kv_pair.get() + index_i * ntotal, block_size, ntotal,
+                                                       band_index_ofs[index_i]);
+            }));
         }
+        RETURN_IF_ERROR(WaitAllSuccess(futures));
     }
 
     // write file header
@@ -377,6 +679,9 @@ MinHashLSH::BuildAndSave(MinHashLSHBuildParams* params) {
         writeBinaryPOD(header_writer, band_index_n);
         writeBinaryPOD(header_writer, data_pos);
         header_writer.write((char*)band_index_ofs.data(), band_index_ofs.size() * sizeof(size_t));
+        // the header is zero padded, older files read as plain keys
+        size_t prefix_key = params->prefix_key;
+        writeBinaryPOD(header_writer, prefix_key);
         writer.write_header((char*)header_writer.data_, header_writer.rp_);
         if (header_writer.data_) {
             delete[] header_writer.data_;
@@ -428,15 +733,32 @@ MinHashLSH::Load(MinHashLSHLoadParams* params) {
     band_index_ = std::make_unique<MinHashBandIndex[]>(band_);
     std::vector<size_t> band_index_ofs(band_);
     reader.read((char*)band_index_ofs.data(), band_index_ofs.size() * sizeof(size_t));
+    size_t prefix_key;
+    readBinaryPOD(reader, prefix_key);
+    this->prefix_key_ = prefix_key != 0;
+    // the bloom filters also hold the prefix probe keys of the rows with prefix keys
+    size_t bloom_capacity = prefix_key_ ? 2 * this->ntotal_ : this->ntotal_;
     size_t bloom_filter_num = params->global_bloom_filter ? 1 : this->band_;
-    bloom_.reserve(bloom_filter_num);
-    for (size_t i = 0; i < bloom_filter_num; i++) {
-        bloom_.emplace_back(this->ntotal_, params->false_positive_prob);
+    if (params->blocked_bloom_filter) {
+        blocked_bloom_.reserve(bloom_filter_num);
+        for (size_t i = 0; i < bloom_filter_num; i++) {
+            blocked_bloom_.emplace_back(bloom_capacity, params->false_positive_prob);
+        }
+    } else {
+        bloom_.reserve(bloom_filter_num);
+        for (size_t i = 0; i < bloom_filter_num; i++) {
+            bloom_.emplace_back(bloom_capacity, params->false_positive_prob);
+        }
     }
     auto band_mmap_addr = params->hash_code_in_memory ? nullptr : this->mmap_data_;
     for (size_t i = 0; i < band_; i++) {
         reader.seek(band_index_ofs[i]);
-        band_index_[i].Load(reader, this->ntotal_, band_mmap_addr, bloom_[i % bloom_.size()]);
+        if (params->blocked_bloom_filter) {
+            band_index_[i].Load(reader, this->ntotal_, band_mmap_addr, blocked_bloom_[i % blocked_bloom_.size()],
+                                prefix_key_);
+        } else {
+            band_index_[i].Load(reader, this->ntotal_, band_mmap_addr, bloom_[i % bloom_.size()], prefix_key_);
+        }
     }
     is_loaded_ = true;
     return Status::success;
@@ -468,16 +790,25 @@ MinHashLSH::Search(const char* query, float* distances, idx_t* labels, MinHashLS
     } else {
         res = std::shared_ptr<MinHashLSHResultHandler>(new MinHashLSHResultHandler(labels, distances, topk));
     }
+    // the blocks of all the bands are requested before any of them is probed
+    std::vector<KVPair> band_keys(band_);
+    for (size_t i = 0; i < band_; i++) {
+        const auto hash = BandKey(query, i);
+        band_keys[i] = {hash, BandMayContain(i, hash) ? 0 : -1};
+        if (band_keys[i].Value != -1) {
+            band_index_[i].Prefetch(&band_keys[i], 1);
+        }
+    }
     for (size_t i = 0; i < band_; i++) {
-        const auto hash = get_hash_key(query, this->mh_vec_elememt_size_ * this->mh_vec_length_, band_, i);
-        auto& band = band_index_[i];
-        auto& bloom = bloom_[i % bloom_.size()];
-        if (bloom.contains(hash)) {
-            band.Search(hash, res.get(), id_selector);
+        if (band_keys[i].Value != -1) {
+            band_index_[i].Search(band_keys[i].Key, res.get(), id_selector);
         }
         if (res->full())
             break;
     }
+    if (params->multi_probe && !res->full()) {
+        SearchPrefix(query, res.get(), id_selector);
+    }
     if (search_with_jaccard) {
         minhash_jaccard_knn_ny_by_ids(query, this->raw_data_, reorder_ids.get(), this->mh_vec_length_,
                                       this->mh_vec_elememt_size_, res->topk_, topk, distances, labels);
@@ -517,47 +848,66 @@ MinHashLSH::BatchSearch(const char* query, size_t nq, float* distances, idx_t* l
             all_res.emplace_back(labels + i * topk, distances + i * topk, topk);
         }
     }
-    // search bands
-    auto search_bands_list = [&](const char* query, size_t beg, size_t end, MinHashLSHResultHandler* res) {
-        for (auto i = beg; i < end; i++) {
-            const auto hash = get_hash_key(query, this->mh_vec_elememt_size_ * this->mh_vec_length_, band_, i);
-            auto& band = band_index_[i];
-            auto& bloom = bloom_[i % bloom_.size()];
-            if (bloom.contains(hash)) {
-                band.Search(hash, res, id_selector);
-            }
-            if (res->full())
-                break;
-        }
-    };
+    // search bands, the keys of the queries are sorted per band so that its blocks are swept once in order
+    const size_t vec_size = mh_vec_elememt_size_ * mh_vec_length_;
     std::vector<folly::Future<folly::Unit>> futures;
     std::vector<size_t> access_list(nq);
     for (size_t i = 0; i < nq; i++) {
         access_list[i] = i;
     }
+    std::vector<KVPair> band_keys;
     size_t band_ofs = 0;
     while (access_list.size() && band_ofs < this->band_) {
         size_t band_beg = band_ofs;
         size_t bend_end = std::min(band_beg + kQueryBandBatch, band_);
-        for (size_t i = band_beg; i < bend_end; i++) {
-            band_index_[i].WarmUp();
-        }
+        size_t band_num = bend_end - band_beg;
+        // the keys of the queries in the access list, band by band. Value is -1 if the bloom filter rules it out.
         size_t access_num = access_list.size();
+        band_keys.resize(band_num * access_num);
         size_t run_time = (access_num + kQueryBatch - 1) / kQueryBatch;
         futures.reserve(run_time);
         for (size_t row = 0; row < run_time; ++row) {
-            futures.emplace_back(
-                pool->push([&, beg = row * kQueryBatch, end = std::min((size_t)((row + 1) * kQueryBatch), access_num),
-                            p_id_ptr = labels, p_dist_ptr = distances]() {
+            futures.emplace_back(pool->push(
+                [&, beg = row * kQueryBatch, end = std::min((size_t)((row + 1) * kQueryBatch), access_num)]() {
                     for (size_t index = beg; index < end; index++) {
                         auto query_id = access_list[index];
-                        search_bands_list(query + mh_vec_elememt_size_ * mh_vec_length_ * query_id, beg, end,
-                                          &all_res[query_id]);
+                        for (size_t b = 0; b < band_num; b++) {
+                            auto hash = BandKey(query + vec_size * query_id, band_beg + b);
+                            auto valid = BandMayContain(band_beg + b, hash);
+                            band_keys[b * access_num + index] = {hash, valid ? ValueType(query_id) : -1};
+                        }
                     }
                 }));
         }
         WaitAllSuccess(futures);
         futures.clear();
+        // the blocks of all the bands in the batch are requested before any of them is probed
+        std::vector<size_t> band_keys_num(band_num);
+        for (size_t b = 0; b < band_num; b++) {
+            auto keys_beg = band_keys.begin() + b * access_num;
+            auto keys_end =
+                std::remove_if(keys_beg, keys_beg + access_num, [](const KVPair& kv) { return kv.Value == -1; });
+            std::sort(keys_beg, keys_end, [](const KVPair& a, const KVPair& b) { return a.Key < b.Key; });
+            band_keys_num[b] = keys_end - keys_beg;
+            band_index_[band_beg + b].Prefetch(band_keys.data() + b * access_num, band_keys_num[b]);
+        }
+        for (size_t b = 0; b < band_num; b++) {
+            auto keys = band_keys.data() + b * access_num;
+            size_t keys_num = std::remove_if(keys, keys + band_keys_num[b],
+                                           [&](const KVPair& kv) { return all_res[kv.Value].full(); }) -
+                            keys;
+            // a query has one key in a band, so the chunks write to different results
+            size_t chunk_num = (keys_num + kQueryBatch - 1) / kQueryBatch;
+            futures.reserve(chunk_num);
+            for (size_t chunk = 0; chunk < chunk_num; ++chunk) {
+                futures.emplace_back(pool->push([&, band_i = band_beg + b, beg = keys + chunk * kQueryBatch,
+                                                 n = std::min((size_t)kQueryBatch, keys_num - chunk * kQueryBatch)]() {
+                    band_index_[band_i].SearchSorted(beg, n, all_res.data(), id_selector);
+                }));
+            }
+            WaitAllSuccess(futures);
+            futures.clear();
+        }
         std::vector<size_t> new_access_list;
         for (auto q_i : access_list) {
             if (!all_res[q_i].full()) {
@@ -567,6 +917,21 @@ MinHashLSH::BatchSearch(const char* query, size_t nq, float* distances, idx_t* l
         band_ofs += kQueryBandBatch;
         access_list = new_access_list;
     }
+    if (params->multi_probe && prefix_key_ && access_list.size()) {
+        size_t run_time = (access_list.size() + kQueryBatch - 1) / kQueryBatch;
+        futures.reserve(run_time);
+        for (size_t row = 0; row < run_time; ++row) {
+            futures.emplace_back(pool->push(
+                [&, beg = row * kQueryBatch, end = std::min((size_t)((row + 1) * kQueryBatch), access_list.size())]() {
+                    for (size_t index = beg; index < end; index++) {
+                        auto query_id = access_list[index];
+                        SearchPrefix(query + vec_size * query_id, &all_res[query_id], id_selector);
+                    }
+                }));
+        }
+        WaitAllSuccess(futures);
+        futures.clear();
+    }
     // reorder by jaccard distance
     if (search_with_jaccard) {
         futures.reserve(nq);
@@ -587,6 +952,26 @@ MinHashLSH::BatchSearch(const char* query, size_t nq, float* distances, idx_t* l
     return Status::success;
 }
 
+KeyType
+MinHashLSH::BandKey(const char* query, size_t i) const {
+    const size_t vec_size = mh_vec_elememt_size_ * mh_vec_length_;
+    return prefix_key_ ? get_prefix_hash_key(query, vec_size, band_, i, mh_vec_elememt_size_)
+                       : get_hash_key(query, vec_size, band_, i);
+}
+
+void
+MinHashLSH::SearchPrefix(const char* query, MinHashLSHResultHandler* res, faiss::IDSelector* id_selector) const {
+    if (!prefix_key_) {
+        return;
+    }
+    for (size_t i = 0; i < band_ && !res->full(); i++) {
+        const auto prefix = BandKey(query, i) & kPrefixKeyMask;
+        if (BandMayContain(i, prefix_probe_key(prefix))) {
+            band_index_[i].SearchRange(prefix, prefix_probe_key(prefix), res, id_selector);
+        }
+    }
+}
+
 Status
 MinHashLSH::GetDataByIds(const idx_t* ids, size_t n, char* data) const {
     if (this->with_raw_data_) {
@@ -22,9 +22,12 @@ class MinHashLSHConfig : public BaseConfig {
     CFG_BOOL mh_lsh_code_in_mem;
     CFG_BOOL mh_lsh_shared_bloom_filter;
     CFG_FLOAT mh_lsh_bloom_false_positive_prob;
+    CFG_BOOL mh_lsh_blocked_bloom_filter;
     CFG_BOOL with_raw_data;
     CFG_INT refine_k;
     CFG_BOOL mh_lsh_batch_search;
+    CFG_BOOL mh_lsh_prefix_key;
+    CFG_BOOL mh_lsh_multi_probe;
     KNOHWERE_DECLARE_CONFIG(MinHashLSHConfig) {
         KNOWHERE_CONFIG_DECLARE_FIELD(mh_lsh_aligned_block_size)
             .description("decide the data format in file")
@@ -44,6 +47,10 @@ class MinHashLSHConfig : public BaseConfig {
             .set_default(0.01)
             .set_range(0.0, 1.0)
             .for_deserialize();
+        KNOWHERE_CONFIG_DECLARE_FIELD(mh_lsh_blocked_bloom_filter)
+            .description("whether to use cache-line blocked bloom filters, faster to probe than the plain ones")
+            .set_default(false)
+            .for_deserialize();
         KNOWHERE_CONFIG_DECLARE_FIELD(refine_k)
             .description("only useful in mh_search_with_jaccard, the search topk of minhash lsh.")
             .set_default(1)
@@ -57,6 +64,15 @@ class MinHashLSHConfig : public BaseConfig {
             .description("search query in batch, useful in limit cpu and mh_lsh_code_in_mem = false.")
             .set_default(false)
             .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(mh_lsh_prefix_key)
+            .description("build band keys that let mh_lsh_multi_probe also probe the first half of each band.")
+            .set_default(false)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(mh_lsh_multi_probe)
+            .description("also probe the first half of each band when an index with mh_lsh_prefix_key has "
+                         "fewer than k hits, no effect on other indexes.")
+            .set_default(false)
+            .for_search();
     }
 };
 }  // namespace knowhere
@@ -0,0 +1,168 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef MINHASH_LSH_GROWING_H
+#define MINHASH_LSH_GROWING_H
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "index/minhash/minhash_lsh.h"
+#include "knowhere/comp/rw_lock.h"
+
+namespace knowhere::minhash {
+
+// An in-memory MinHashLSH that rows can be added to while it is searched. Each band is a hash table from the band
+// key to the ids of its rows, in the order they were added, which is the order the sealed index returns them in.
+// Rows are hashed before the write lock is taken, so searches only wait for the inserts.
+class MinHashLSHGrowing {
+ public:
+    MinHashLSHGrowing(size_t band, size_t mh_vec_element_size, size_t mh_vec_length)
+        : band_(band), mh_vec_element_size_(mh_vec_element_size), mh_vec_length_(mh_vec_length), bands_(band) {
+    }
+
+    // the rows get the ids from Count() on
+    Status
+    Add(const char* data, size_t rows);
+
+    Status
+    Search(const char* query, float* distances, idx_t* labels, MinHashLSHSearchParams* params) const;
+
+    Status
+    GetDataByIds(const idx_t* ids, size_t n, char* data) const;
+
+    // writes the rows in the block file format that MinHashLSH::Load reads. The band and vector sizes of params
+    // are taken from this index. Adds wait until it is done.
+    Status
+    Seal(MinHashLSHBuildParams* params) const;
+
+    size_t
+    Size() const {
+        std::shared_lock lock(mutex_);
+        return ntotal_ * band_ * (sizeof(KeyType) + sizeof(ValueType)) + data_.size();
+    }
+
+    size_t
+    Count() const {
+        std::shared_lock lock(mutex_);
+        return ntotal_;
+    }
+
+    size_t
+    GetVectorSize() const {
+        return mh_vec_length_ * mh_vec_element_size_;
+    }
+
+ private:
+    const size_t band_;
+    const size_t mh_vec_element_size_;
+    const size_t mh_vec_length_;
+    mutable ReaderBiasedRWLock mutex_;
+    std::vector<std::unordered_map<KeyType, std::vector<ValueType>>> bands_;
+    std::vector<char> data_;
+    size_t ntotal_ = 0;
+};
+
+Status
+MinHashLSHGrowing::Add(const char* data, size_t rows) {
+    if (rows == 0) {
+        return Status::success;
+    }
+    if (mh_vec_length_ % band_ != 0) {
+        LOG_KNOWHERE_ERROR_ << "mh_vec_length % band != 0";
+        return Status::invalid_args;
+    }
+    const size_t vec_size = GetVectorSize();
+    auto kv = gen_transposed_hash_kv(data, rows, vec_size, band_);
+    std::unique_lock lock(mutex_);
+    const size_t id_base = ntotal_;
+    for (size_t b = 0; b < band_; b++) {
+        auto& band = bands_[b];
+        for (size_t j = 0; j < rows; j++) {
+            band[kv[b * rows + j].Key].push_back(ValueType(id_base + j));
+        }
+    }
+    data_.insert(data_.end(), data, data + rows * vec_size);
+    ntotal_ += rows;
+    return Status::success;
+}
+
+Status
+MinHashLSHGrowing::Search(const char* query, float* distances, idx_t* labels, MinHashLSHSearchParams* params) const {
+    if (params == nullptr) {
+        LOG_KNOWHERE_ERROR_ << "search parameters is null.";
+        return Status::invalid_args;
+    }
+    auto topk = params->k;
+    auto id_selector = params->id_selector;
+    auto search_with_jaccard = params->search_with_jaccard;
+    auto refine_k = search_with_jaccard ? std::max(params->refine_k, topk) : topk;
+    std::unique_ptr<idx_t[]> reorder_ids = nullptr;
+    std::unique_ptr<float[]> reorder_dis = nullptr;
+    if (search_with_jaccard) {
+        reorder_ids = std::make_unique<idx_t[]>(refine_k);
+        reorder_dis = std::make_unique<float[]>(refine_k);
+    }
+    MinHashLSHResultHandler res(search_with_jaccard ? reorder_ids.get() : labels,
+                                search_with_jaccard ? reorder_dis.get() : distances, refine_k);
+    std::shared_lock lock(mutex_);
+    for (size_t i = 0; i < band_ && !res.full(); i++) {
+        const auto hash = get_hash_key(query, GetVectorSize(), band_, i);
+        auto it = bands_[i].find(hash);
+        if (it == bands_[i].end()) {
+            continue;
+        }
+        for (size_t j = 0; j < it->second.size() && !res.full(); j++) {
+            if (id_selector == nullptr || id_selector->is_member(it->second[j])) {
+                res.push(it->second[j], 1.0);
+            }
+        }
+    }
+    if (search_with_jaccard) {
+        minhash_jaccard_knn_ny_by_ids(query, data_.data(), reorder_ids.get(), mh_vec_length_, mh_vec_element_size_,
+                                      refine_k, topk, distances, labels);
+    }
+    return Status::success;
+}
+
+Status
+MinHashLSHGrowing::GetDataByIds(const idx_t* ids, size_t n, char* data) const {
+    const size_t vec_size = GetVectorSize();
+    std::shared_lock lock(mutex_);
+    for (size_t i = 0; i < n; i++) {
+        if (ids[i] < 0 || (size_t)ids[i] >= ntotal_) {
+            LOG_KNOWHERE_ERROR_ << "id " << ids[i] << " is out of range [0, " << ntotal_ << ").";
+            return Status::invalid_args;
+        }
+        std::memcpy(data + i * vec_size, data_.data() + ids[i] * vec_size, vec_size);
+    }
+    return Status::success;
+}
+
+Status
+MinHashLSHGrowing::Seal(MinHashLSHBuildParams* params) const {
+    if (params == nullptr) {
+        LOG_KNOWHERE_ERROR_ << "build parameters is null.";
+        return Status::invalid_args;
+    }
+    MinHashLSHBuildParams build_params = *params;
+    build_params.band = band_;
+    build_params.mh_vec_element_size = mh_vec_element_size_;
+    build_params.mh_vec_length = mh_vec_length_;
+    std::shared_lock lock(mutex_);
+    return MinHashLSH::BuildAndSave(&build_params, data_.data(), ntotal_);
+}
+
+}  // namespace knowhere::minhash
+
+#endif /* MINHASH_LSH_GROWING_H */
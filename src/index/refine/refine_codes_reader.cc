@@ -0,0 +1,153 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#include "index/refine/refine_codes_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef KNOWHERE_WITH_DISKANN
+#include "diskann/linux_aligned_file_reader.h"
+#include "diskann/linux_uring_file_reader.h"
+#include "diskann/uring_context_pool.h"
+#endif
+#include "faiss/impl/FaissAssert.h"
+#include "faiss/impl/mapped_io.h"
+#include "knowhere/log.h"
+
+namespace knowhere {
+
+namespace {
+
+constexpr uint64_t kSectorSize = 512;
+
+struct AlignedFree {
+    void
+    operator()(uint8_t* p) const {
+        std::free(p);
+    }
+};
+
+}  // namespace
+
+expected<std::shared_ptr<RefineCodesReader>>
+RefineCodesReader::Open(const std::string& filename, const faiss::IndexFlatCodes& refine_index) {
+    auto mapping = dynamic_cast<const faiss::MmappedFileMappingOwner*>(refine_index.codes.owner.get());
+    if (refine_index.codes.is_owned || mapping == nullptr) {
+        return expected<std::shared_ptr<RefineCodesReader>>::Err(Status::invalid_args,
+                                                                  "the codes of the refine index are not mapped");
+    }
+    const uint64_t offset =
+        reinterpret_cast<const uint8_t*>(refine_index.codes.data()) - static_cast<const uint8_t*>(mapping->data());
+
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return expected<std::shared_ptr<RefineCodesReader>>::Err(
+            Status::disk_file_error, "cannot open " + filename + ": " + strerror(errno));
+    }
+    std::shared_ptr<RefineCodesReader> reader(
+        new RefineCodesReader(fd, offset, refine_index.code_size, refine_index.ntotal));
+#ifdef KNOWHERE_WITH_DISKANN
+    // the reader of DiskANN asserts that the file opens with O_DIRECT, which tmpfs does not support
+    const int direct_fd = open(filename.c_str(), O_RDONLY | O_DIRECT);
+    if (direct_fd >= 0) {
+        close(direct_fd);
+        if (UringContextPool::GetGlobalUringPool() != nullptr) {
+            reader->aligned_reader_ = std::make_unique<LinuxUringFileReader>();
+        } else {
+            reader->aligned_reader_ = std::make_unique<LinuxAlignedFileReader>();
+        }
+        reader->aligned_reader_->open(filename);
+    } else {
+        LOG_KNOWHERE_INFO_ << "direct IO is not supported for " << filename << ", the refine reads it with pread";
+    }
+#endif
+    return reader;
+}
+
+RefineCodesReader::~RefineCodesReader() {
+#ifdef KNOWHERE_WITH_DISKANN
+    if (aligned_reader_ != nullptr) {
+        aligned_reader_->close();
+    }
+#endif
+    close(fd_);
+}
+
+void
+RefineCodesReader::Read(const faiss::idx_t* ids, size_t n, uint8_t* out) const {
+    // the sector range around every code, and where the code starts in it
+    std::vector<uint64_t> begins;
+    std::vector<uint64_t> lens;
+    uint64_t total = 0;
+    for (size_t i = 0; i < n && ids[i] >= 0; i++) {
+        FAISS_THROW_IF_NOT_FMT(static_cast<size_t>(ids[i]) < ntotal_, "refine id %ld out of range", (long)ids[i]);
+        const uint64_t begin = offset_ + ids[i] * code_size_;
+        const uint64_t aligned_begin = begin / kSectorSize * kSectorSize;
+        const uint64_t aligned_end = (begin + code_size_ + kSectorSize - 1) / kSectorSize * kSectorSize;
+        begins.push_back(aligned_begin);
+        lens.push_back(aligned_end - aligned_begin);
+        total += aligned_end - aligned_begin;
+    }
+    if (begins.empty()) {
+        return;
+    }
+    std::unique_ptr<uint8_t, AlignedFree> buffer(static_cast<uint8_t*>(std::aligned_alloc(kSectorSize, total)));
+    FAISS_THROW_IF_NOT_MSG(buffer != nullptr, "cannot allocate the buffer of a refine read");
+
+#ifdef KNOWHERE_WITH_DISKANN
+    if (aligned_reader_ != nullptr) {
+        std::vector<AlignedRead> reqs;
+        reqs.reserve(begins.size());
+        uint64_t pos = 0;
+        for (size_t i = 0; i < begins.size(); i++) {
+            reqs.emplace_back(begins[i], lens[i], buffer.get() + pos);
+            pos += lens[i];
+        }
+        auto ctx = aligned_reader_->get_ctx();
+        try {
+            aligned_reader_->read(reqs, ctx);
+        } catch (...) {
+            aligned_reader_->put_ctx(ctx);
+            throw;
+        }
+        aligned_reader_->put_ctx(ctx);
+    }
+    const bool use_pread = aligned_reader_ == nullptr;
+#else
+    const bool use_pread = true;
+#endif
+    if (use_pread) {
+        uint64_t pos = 0;
+        for (size_t i = 0; i < begins.size(); i++) {
+            // the last sector of the file may be short
+            const ssize_t size = pread(fd_, buffer.get() + pos, lens[i], begins[i]);
+            const uint64_t needed = offset_ + ids[i] * code_size_ + code_size_ - begins[i];
+            FAISS_THROW_IF_NOT_FMT(size >= 0 && static_cast<uint64_t>(size) >= needed,
+                                   "cannot read the refine codes: %s", strerror(errno));
+            pos += lens[i];
+        }
+    }
+
+    uint64_t pos = 0;
+    for (size_t i = 0; i < begins.size(); i++) {
+        std::memcpy(out + i * code_size_, buffer.get() + pos + (offset_ + ids[i] * code_size_ - begins[i]),
+                    code_size_);
+        pos += lens[i];
+    }
+}
+
+}  // namespace knowhere
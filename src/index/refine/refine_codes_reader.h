@@ -0,0 +1,69 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifdef KNOWHERE_WITH_DISKANN
+#include "diskann/aligned_file_reader.h"
+#endif
+#include "faiss/IndexFlatCodes.h"
+#include "knowhere/expected.h"
+
+namespace knowhere {
+
+// Reads the codes of the refine index of an index from its file, for the final candidates of a search only, so that
+//   the full precision vectors are not kept in memory. Every code is read as the 512-byte aligned range around it,
+//   a batch at a time, through the aio reader of DiskANN when it is built in and the file allows direct IO, with
+//   pread otherwise.
+class RefineCodesReader {
+ public:
+    // refine_index holds the view of the mapped file that faiss::IO_FLAG_MMAP_IFC reads, it gives the offset of the
+    //   codes in the file
+    static expected<std::shared_ptr<RefineCodesReader>>
+    Open(const std::string& filename, const faiss::IndexFlatCodes& refine_index);
+
+    ~RefineCodesReader();
+
+    RefineCodesReader(const RefineCodesReader&) = delete;
+    RefineCodesReader&
+    operator=(const RefineCodesReader&) = delete;
+
+    size_t
+    code_size() const {
+        return code_size_;
+    }
+
+    // reads the codes of ids[0..n) into out, code_size() bytes each, a negative id ends the batch. Throws on an IO
+    //   error, like the faiss search that calls it.
+    void
+    Read(const faiss::idx_t* ids, size_t n, uint8_t* out) const;
+
+ private:
+    RefineCodesReader(int fd, uint64_t offset, size_t code_size, size_t ntotal)
+        : fd_(fd), offset_(offset), code_size_(code_size), ntotal_(ntotal) {
+    }
+
+    const int fd_;
+    const uint64_t offset_;
+    const size_t code_size_;
+    const size_t ntotal_;
+#ifdef KNOWHERE_WITH_DISKANN
+    // nullptr if the reads go through pread
+    std::unique_ptr<AlignedFileReader> aligned_reader_;
+#endif
+};
+
+}  // namespace knowhere
@@ -6,7 +6,11 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
+#include "faiss/IndexFlatCodes.h"
+#include "faiss/IndexHNSW.h"
+#include "faiss/IndexIVF.h"
 #include "faiss/IndexRefine.h"
 #include "faiss/IndexScalarQuantizer.h"
 #include "fmt/format.h"
@@ -19,6 +23,7 @@ namespace knowhere {
 expected<faiss::ScalarQuantizer::QuantizerType>
 get_sq_quantizer_type(const std::string& sq_type) {
     std::map<std::string, faiss::ScalarQuantizer::QuantizerType> sq_types = {
+        {"sq4", faiss::ScalarQuantizer::QT_4bit},
         {"sq6", faiss::ScalarQuantizer::QT_6bit},
         {"sq8", faiss::ScalarQuantizer::QT_8bit},
         {"fp16", faiss::ScalarQuantizer::QT_fp16},
@@ -174,4 +179,46 @@ pick_refine_index(const DataFormatEnum data_format, const std::optional<std::str
     }
 }
 
+namespace {
+
+template <typename T>
+void
+own_vector(faiss::MaybeOwnedVector<T>& v) {
+    if (!v.is_owned) {
+        v = faiss::MaybeOwnedVector<T>(std::vector<T>(v.data(), v.data() + v.size()));
+    }
+}
+
+void
+own_index_data(faiss::Index* index) {
+    if (auto index_hnsw = dynamic_cast<faiss::IndexHNSW*>(index)) {
+        own_vector(index_hnsw->hnsw.levels);
+        own_vector(index_hnsw->hnsw.offsets);
+        own_vector(index_hnsw->hnsw.neighbors);
+        index = index_hnsw->storage;
+    }
+    if (auto index_flat = dynamic_cast<faiss::IndexFlatCodes*>(index)) {
+        own_vector(index_flat->codes);
+    } else if (auto index_ivf = dynamic_cast<faiss::IndexIVF*>(index)) {
+        own_index_data(index_ivf->quantizer);
+        if (auto invlists = dynamic_cast<faiss::ArrayInvertedLists*>(index_ivf->invlists)) {
+            for (size_t i = 0; i < invlists->nlist; i++) {
+                own_vector(invlists->codes[i]);
+                own_vector(invlists->ids[i]);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void
+own_all_but_refine_data(faiss::Index* index) {
+    if (auto index_refine = dynamic_cast<faiss::IndexRefine*>(index)) {
+        own_index_data(index_refine->base_index);
+        return;
+    }
+    own_index_data(index);
+}
+
 }  // namespace knowhere
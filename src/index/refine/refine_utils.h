@@ -33,4 +33,10 @@ pick_refine_index(const DataFormatEnum data_format, const std::optional<std::str
                   //   So, let's provide these externally
                   const size_t base_d, const faiss::MetricType base_metric_type);
 
+// Copies the parts of an index that were read with faiss::IO_FLAG_MMAP_IFC into owned memory, except for the raw data
+//   of a refine index. So a search touches memory only, while the mapped raw data is paged in by the first
+//   GetVectorByIds() or refine that needs it.
+void
+own_all_but_refine_data(faiss::Index* index);
+
 }  // namespace knowhere
@@ -0,0 +1,263 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SPARSE_DIM_MAP_H
+#define SPARSE_DIM_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "knowhere/sparse_utils.h"
+
+namespace knowhere::sparse {
+
+// Maps the raw dims of a sparse index to their dim ids, with the interface of the std::unordered_map it replaces.
+// The entries are kept in a single array of slots probed linearly, at most half full, so a lookup touches one or
+// two adjacent slots instead of chasing the nodes of a bucket. freeze() additionally indexes the ids by dim in a
+// direct array when the dims are dense enough, e.g. the 30522 dims of a SPLADE vocabulary, which lookup() reads
+// with a single load. Any insertion drops the direct array until the next freeze().
+class DimMap {
+ public:
+    using key_type = table_t;
+    using mapped_type = uint32_t;
+    using value_type = std::pair<table_t, uint32_t>;
+
+    // the id of the dims that are not in the map, never a dim id
+    static constexpr uint32_t kNotFound = std::numeric_limits<uint32_t>::max();
+
+    template <typename Slot>
+    class Iterator {
+     public:
+        Iterator(Slot* slot, Slot* end) : slot_(slot), end_(end) {
+            skip_empty();
+        }
+
+        Slot&
+        operator*() const {
+            return *slot_;
+        }
+
+        Slot*
+        operator->() const {
+            return slot_;
+        }
+
+        Iterator&
+        operator++() {
+            ++slot_;
+            skip_empty();
+            return *this;
+        }
+
+        bool
+        operator==(const Iterator& other) const {
+            return slot_ == other.slot_;
+        }
+
+        bool
+        operator!=(const Iterator& other) const {
+            return slot_ != other.slot_;
+        }
+
+     private:
+        void
+        skip_empty() {
+            while (slot_ != end_ && slot_->second == kNotFound) {
+                ++slot_;
+            }
+        }
+
+        Slot* slot_;
+        Slot* end_;
+    };
+
+    using iterator = Iterator<value_type>;
+    using const_iterator = Iterator<const value_type>;
+
+    iterator
+    begin() {
+        return iterator(slots_.data(), slots_.data() + slots_.size());
+    }
+
+    iterator
+    end() {
+        return iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+    }
+
+    const_iterator
+    begin() const {
+        return const_iterator(slots_.data(), slots_.data() + slots_.size());
+    }
+
+    const_iterator
+    end() const {
+        return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+    }
+
+    const_iterator
+    cend() const {
+        return end();
+    }
+
+    [[nodiscard]] size_t
+    size() const {
+        return size_;
+    }
+
+    [[nodiscard]] bool
+    empty() const {
+        return size_ == 0;
+    }
+
+    // the dim id of dim, kNotFound if it is not in the map
+    uint32_t
+    lookup(table_t dim) const {
+        if (!direct_.empty()) {
+            return dim < direct_.size() ? direct_[dim] : kNotFound;
+        }
+        const size_t slot = find_slot(dim);
+        return slot == slots_.size() ? kNotFound : slots_[slot].second;
+    }
+
+    iterator
+    find(table_t dim) {
+        const size_t slot = find_slot(dim);
+        return iterator(slots_.data() + slot, slots_.data() + slots_.size());
+    }
+
+    const_iterator
+    find(table_t dim) const {
+        const size_t slot = find_slot(dim);
+        return const_iterator(slots_.data() + slot, slots_.data() + slots_.size());
+    }
+
+    [[nodiscard]] size_t
+    count(table_t dim) const {
+        return lookup(dim) == kNotFound ? 0 : 1;
+    }
+
+    // keeps the id of dim if it is in the map already, as std::unordered_map::insert() does
+    std::pair<iterator, bool>
+    insert(const value_type& entry) {
+        if ((size_ + 1) * 2 > slots_.size()) {
+            rehash(std::max<size_t>(kMinSlots, slots_.size() * 2));
+        }
+        direct_.clear();
+        size_t slot = hash(entry.first);
+        while (slots_[slot].second != kNotFound) {
+            if (slots_[slot].first == entry.first) {
+                return {iterator(slots_.data() + slot, slots_.data() + slots_.size()), false};
+            }
+            slot = (slot + 1) & (slots_.size() - 1);
+        }
+        slots_[slot] = entry;
+        ++size_;
+        return {iterator(slots_.data() + slot, slots_.data() + slots_.size()), true};
+    }
+
+    std::pair<iterator, bool>
+    emplace(table_t dim, uint32_t dim_id) {
+        return insert({dim, dim_id});
+    }
+
+    void
+    clear() {
+        slots_.clear();
+        direct_.clear();
+        size_ = 0;
+    }
+
+    // indexes the ids by dim in a direct array if it is at most kMaxDirectRatio times as large as the map
+    void
+    freeze() {
+        direct_.clear();
+        if (size_ == 0) {
+            return;
+        }
+        table_t max_dim = 0;
+        for (const auto& [dim, dim_id] : *this) {
+            max_dim = std::max(max_dim, dim);
+        }
+        if (static_cast<size_t>(max_dim) + 1 > size_ * kMaxDirectRatio) {
+            return;
+        }
+        direct_.assign(static_cast<size_t>(max_dim) + 1, kNotFound);
+        for (const auto& [dim, dim_id] : *this) {
+            direct_[dim] = dim_id;
+        }
+    }
+
+    [[nodiscard]] size_t
+    size_in_bytes() const {
+        return slots_.size() * sizeof(value_type) + direct_.size() * sizeof(uint32_t);
+    }
+
+ private:
+    static constexpr size_t kMinSlots = 16;
+    static constexpr size_t kMaxDirectRatio = 4;
+
+    // the first slot probed for dim, the top bits of a multiplicative hash that spreads consecutive dims
+    size_t
+    hash(table_t dim) const {
+        return static_cast<size_t>((static_cast<uint64_t>(dim) * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    // the slot of dim, slots_.size() if it is not in the map
+    size_t
+    find_slot(table_t dim) const {
+        if (slots_.empty()) {
+            return 0;
+        }
+        for (size_t slot = hash(dim);; slot = (slot + 1) & (slots_.size() - 1)) {
+            if (slots_[slot].second == kNotFound) {
+                return slots_.size();
+            }
+            if (slots_[slot].first == dim) {
+                return slot;
+            }
+        }
+    }
+
+    void
+    rehash(size_t n_slots) {
+        std::vector<value_type> old(n_slots, value_type{0, kNotFound});
+        old.swap(slots_);
+        shift_ = 64;
+        for (size_t n = n_slots; n > 1; n >>= 1) {
+            --shift_;
+        }
+        for (const auto& entry : old) {
+            if (entry.second == kNotFound) {
+                continue;
+            }
+            size_t slot = hash(entry.first);
+            while (slots_[slot].second != kNotFound) {
+                slot = (slot + 1) & (slots_.size() - 1);
+            }
+            slots_[slot] = entry;
+        }
+    }
+
+    // a power of 2 of slots, the empty ones have the id kNotFound
+    std::vector<value_type> slots_;
+    // 64 - log2(slots_.size())
+    int shift_ = 64;
+    size_t size_ = 0;
+    // the dim id of every dim up to the largest one after freeze(), empty otherwise
+    std::vector<uint32_t> direct_;
+};
+
+}  // namespace knowhere::sparse
+
+#endif  // SPARSE_DIM_MAP_H
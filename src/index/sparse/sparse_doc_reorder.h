@@ -0,0 +1,157 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SPARSE_DOC_REORDER_H
+#define SPARSE_DOC_REORDER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "knowhere/sparse_utils.h"
+
+namespace knowhere::sparse {
+
+// partitions with no more rows than this are not bisected any further
+constexpr size_t kDocReorderLeafSize = 16;
+// the max number of swap rounds of each bisection
+constexpr size_t kDocReorderMaxIterations = 20;
+// the gains of smaller partitions are computed by a single thread
+constexpr size_t kDocReorderParallelSize = 4096;
+
+// Recursive graph bisection (Dhulipala et al., 2016) of the bipartite graph between rows and dims.
+// Every partition is split in two halves, then rows are swapped between the halves as long as that lowers the
+//   estimated cost of the delta-encoded posting lists, before both halves are bisected in turn. Rows that share
+//   many dims end up close to each other.
+// Returns the order of the rows: the i-th row of the new order is rows[order[i]].
+template <typename T>
+std::vector<table_t>
+RecursiveGraphBisection(const SparseRow<T>* rows, const size_t n) {
+    std::vector<table_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (n <= kDocReorderLeafSize) {
+        return order;
+    }
+
+    // dims that appear in a single row don't change the cost and are left out
+    std::unordered_map<table_t, size_t> dim_counts;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < rows[i].size(); ++j) {
+            dim_counts[rows[i][j].id]++;
+        }
+    }
+    std::unordered_map<table_t, table_t> dim_map;
+    for (const auto& [dim, count] : dim_counts) {
+        if (count > 1) {
+            dim_map.emplace(dim, dim_map.size());
+        }
+    }
+    // the dims of each row, as offsets into dims
+    std::vector<size_t> offsets(n + 1, 0);
+    std::vector<table_t> dims;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < rows[i].size(); ++j) {
+            auto it = dim_map.find(rows[i][j].id);
+            if (it != dim_map.end()) {
+                dims.push_back(it->second);
+            }
+        }
+        offsets[i + 1] = dims.size();
+    }
+
+    std::vector<float> log2_table(n + 2);
+    for (size_t i = 1; i < log2_table.size(); ++i) {
+        log2_table[i] = std::log2(static_cast<float>(i));
+    }
+    // the estimated number of bits of the gaps of a dim with degrees d1 and d2 in partitions of n1 and n2 rows
+    auto cost = [&](size_t n1, size_t n2, int64_t d1, int64_t d2) {
+        return d1 * (log2_table[n1] - log2_table[d1 + 1]) + d2 * (log2_table[n2] - log2_table[d2 + 1]);
+    };
+
+    std::vector<int64_t> left_degrees(dim_map.size(), 0);
+    std::vector<int64_t> right_degrees(dim_map.size(), 0);
+    std::vector<std::pair<float, table_t>> gains(n);
+
+    auto bisect = [&](auto&& self, size_t begin, size_t end) -> void {
+        if (end - begin <= kDocReorderLeafSize) {
+            return;
+        }
+        const size_t mid = begin + (end - begin) / 2;
+        const size_t n1 = mid - begin;
+        const size_t n2 = end - mid;
+        auto update_degrees = [&](table_t row, int64_t left_delta) {
+            for (size_t j = offsets[row]; j < offsets[row + 1]; ++j) {
+                left_degrees[dims[j]] += left_delta;
+                right_degrees[dims[j]] -= left_delta;
+            }
+        };
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t j = offsets[order[i]]; j < offsets[order[i] + 1]; ++j) {
+                (i < mid ? left_degrees : right_degrees)[dims[j]]++;
+            }
+        }
+
+        for (size_t iter = 0; iter < kDocReorderMaxIterations; ++iter) {
+            // the decrease of the cost when a row moves to the other half
+#pragma omp parallel for schedule(static) if (end - begin > kDocReorderParallelSize)
+            for (size_t i = begin; i < end; ++i) {
+                const table_t row = order[i];
+                const int64_t move = i < mid ? 1 : -1;
+                float gain = 0;
+                for (size_t j = offsets[row]; j < offsets[row + 1]; ++j) {
+                    const int64_t d1 = left_degrees[dims[j]];
+                    const int64_t d2 = right_degrees[dims[j]];
+                    gain += cost(n1, n2, d1, d2) - cost(n1, n2, d1 - move, d2 + move);
+                }
+                gains[i] = {gain, row};
+            }
+            auto by_gain = [](const auto& a, const auto& b) { return a.first > b.first; };
+            std::sort(gains.begin() + begin, gains.begin() + mid, by_gain);
+            std::sort(gains.begin() + mid, gains.begin() + end, by_gain);
+
+            size_t swapped = 0;
+            for (size_t i = 0; i < n1 && i < n2; ++i) {
+                if (gains[begin + i].first + gains[mid + i].first <= 0) {
+                    break;
+                }
+                update_degrees(gains[begin + i].second, -1);
+                update_degrees(gains[mid + i].second, 1);
+                std::swap(gains[begin + i].second, gains[mid + i].second);
+                ++swapped;
+            }
+            for (size_t i = begin; i < end; ++i) {
+                order[i] = gains[i].second;
+            }
+            if (swapped == 0) {
+                break;
+            }
+        }
+
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t j = offsets[order[i]]; j < offsets[order[i] + 1]; ++j) {
+                left_degrees[dims[j]] = 0;
+                right_degrees[dims[j]] = 0;
+            }
+        }
+        self(self, begin, mid);
+        self(self, mid, end);
+    };
+    bisect(bisect, 0, n);
+    return order;
+}
+
+}  // namespace knowhere::sparse
+
+#endif  // SPARSE_DOC_REORDER_H
@@ -12,12 +12,17 @@
 #include <sys/mman.h>
 
 #include <exception>
+#include <numeric>
+#include <shared_mutex>
 
+#include "index/sparse/sparse_doc_reorder.h"
 #include "index/sparse/sparse_inverted_index.h"
 #include "index/sparse/sparse_inverted_index_config.h"
 #include "io/file_io.h"
 #include "io/memory_io.h"
 #include "knowhere/comp/index_param.h"
+#include "knowhere/comp/rw_lock.h"
+#include "knowhere/comp/search_phases.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/config.h"
 #include "knowhere/dataset.h"
@@ -25,17 +30,23 @@
 #include "knowhere/index/index_factory.h"
 #include "knowhere/index/index_node.h"
 #include "knowhere/log.h"
+#include "knowhere/range_util.h"
 #include "knowhere/sparse_utils.h"
 #include "knowhere/utils.h"
 
 namespace knowhere {
 
+namespace {
+// a query is only split into shards of at least this many rows
+constexpr size_t kSparseSearchShardMinRows = 100000;
+}  // namespace
+
 // Inverted Index impl for sparse vectors.
 //
-// Not overriding RangeSearch, will use the default implementation in IndexNode.
+// RangeSearch uses the radius as the threshold of the search, the vectors that can't score above it are pruned.
 //
 // Thread safety: not thread safe.
-template <typename T, bool use_wand>
+template <typename T, bool use_wand, bool concurrent = false>
 class SparseInvertedIndexNode : public IndexNode {
     static_assert(std::is_same_v<T, fp32>, "SparseInvertedIndexNode only support float");
 
@@ -76,11 +87,33 @@ class SparseInvertedIndexNode : public IndexNode {
             LOG_KNOWHERE_ERROR_ << "Could not add data to empty " << Type();
             return Status::empty_index;
         }
+        auto cfg = static_cast<const SparseInvertedIndexConfig&>(*config);
         auto build_pool_wrapper = std::make_shared<ThreadPoolWrapper>(build_pool_, use_knowhere_build_pool);
         auto tryObj = build_pool_wrapper
                           ->push([&] {
-                              return index_->Add(static_cast<const sparse::SparseRow<T>*>(dataset->GetTensor()),
-                                                 dataset->GetRows(), dataset->GetDim());
+                              // the rows are indexed and reordered by as many threads as the build pool has
+                              ThreadPool::ScopedBuildOmpSetter setter;
+                              auto data = static_cast<const sparse::SparseRow<T>*>(dataset->GetTensor());
+                              const size_t rows = dataset->GetRows();
+                              const size_t n_rows = index_->n_rows();
+                              // only the first batch is reordered, later rows keep their ids. The ids of a concurrent
+                              // index are never reordered, the searches run while rows are added.
+                              if (concurrent || !cfg.reorder_doc_ids.value() || n_rows != 0) {
+                                  for (size_t i = 0; !doc_ids_.empty() && i < rows; ++i) {
+                                      doc_ids_.push_back(n_rows + i);
+                                  }
+                                  return index_->Add(data, rows, dataset->GetDim());
+                              }
+                              auto order = sparse::RecursiveGraphBisection(data, rows);
+                              std::vector<sparse::SparseRow<T>> reordered;
+                              reordered.reserve(rows);
+                              // the reordered rows are views of the rows of the dataset
+                              for (const auto row : order) {
+                                  auto row_data = static_cast<uint8_t*>(const_cast<void*>(data[row].data()));
+                                  reordered.emplace_back(data[row].size(), row_data, /*own_data=*/false);
+                              }
+                              doc_ids_.assign(order.begin(), order.end());
+                              return index_->Add(reordered.data(), rows, dataset->GetDim());
                           })
                           .getTry();
         if (!tryObj.hasValue()) {
@@ -90,8 +123,43 @@ class SparseInvertedIndexNode : public IndexNode {
         return tryObj.value();
     }
 
+    Status
+    Merge(const std::vector<const IndexNode*>& others, std::shared_ptr<Config> config) override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Could not merge data to empty " << Type();
+            return Status::empty_index;
+        }
+        for (const auto* other : others) {
+            Status status = Status::invalid_args;
+            if (auto p = dynamic_cast<const SparseInvertedIndexNode<T, use_wand, false>*>(other)) {
+                status = MergeFrom(*p);
+            } else if (auto p = dynamic_cast<const SparseInvertedIndexNode<T, use_wand, true>*>(other)) {
+                status = MergeFrom(*p);
+            } else {
+                LOG_KNOWHERE_ERROR_ << "can not merge indexes of different types into " << Type();
+            }
+            if (status != Status::success) {
+                return status;
+            }
+        }
+        return Status::success;
+    }
+
     [[nodiscard]] expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> config, const BitsetView& bitset) const override {
+        return SearchInto(dataset, std::move(config), bitset, nullptr, nullptr);
+    }
+
+    [[nodiscard]] expected<DataSetPtr>
+    SearchWithBuf(const DataSetPtr dataset, std::unique_ptr<Config> config, const BitsetView& bitset, int64_t* ids,
+                  float* dis) const override {
+        return SearchInto(dataset, std::move(config), bitset, ids, dis);
+    }
+
+    // the results go to ids_buf and dis_buf if they are set, to new buffers otherwise
+    [[nodiscard]] expected<DataSetPtr>
+    SearchInto(const DataSetPtr dataset, std::unique_ptr<Config> config, const BitsetView& bitset, int64_t* ids_buf,
+               float* dis_buf) const {
         if (!index_) {
             LOG_KNOWHERE_ERROR_ << "Could not search empty " << Type();
             return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
@@ -116,23 +184,146 @@ class SparseInvertedIndexNode : public IndexNode {
             .refine_factor = refine_factor,
             .drop_ratio_search = drop_ratio_search,
             .dim_max_score_ratio = dim_max_score_ratio,
+            .posting_budget = cfg.search_posting_budget.value(),
+            .time_budget_ms = cfg.search_time_budget_ms.value(),
         };
 
         auto queries = static_cast<const sparse::SparseRow<T>*>(dataset->GetTensor());
         auto nq = dataset->GetRows();
         auto k = cfg.k.value();
-        auto p_id = std::make_unique<sparse::label_t[]>(nq * k);
-        auto p_dist = std::make_unique<float[]>(nq * k);
+        auto p_id = MakeResultBuffer<sparse::label_t>(nq * k, ids_buf);
+        auto p_dist = MakeResultBuffer<float>(nq * k, dis_buf);
+
+        std::vector<uint8_t> internal_bitset_data;
+        auto internal_bitset = ToInternalBitset(bitset, internal_bitset_data);
+        const size_t n_rows = SearchRows(internal_bitset);
+        const int64_t batch_size = cfg.search_batch_size.value();
+        const size_t n_shards = batch_size > 1 ? 1 : SearchShards(nq, n_rows);
+        SearchStatsVec search_stats;
+        if (cfg.search_stats.value()) {
+            search_stats.resize(nq);
+        }
+        // the params of the searches of the queries from idx on
+        auto query_params = [&](int64_t idx) {
+            auto params = approx_params;
+            params.stats = search_stats.empty() ? nullptr : search_stats.data() + idx;
+            return params;
+        };
+        std::vector<folly::Future<folly::Unit>> futs;
+        if (batch_size > 1) {
+            // every batch of queries is searched together in one pass over their posting lists
+            futs.reserve((nq + batch_size - 1) / batch_size);
+            for (int64_t begin = 0; begin < nq; begin += batch_size) {
+                futs.emplace_back(search_pool_->push([&, begin = begin, p_id = p_id.get(), p_dist = p_dist.get()]() {
+                    ScopedSearchPhase phase(SearchPhase::SCAN);
+                    auto params = query_params(begin);
+                    index_->SearchBatch(queries + begin, std::min(batch_size, nq - begin), k, p_dist + begin * k,
+                                        p_id + begin * k, internal_bitset, computer, params, n_rows);
+                }));
+            }
+            WaitAllSuccess(futs);
+        } else if (n_shards == 1) {
+            futs.reserve(nq);
+            for (int64_t idx = 0; idx < nq; ++idx) {
+                futs.emplace_back(search_pool_->push([&, idx = idx, p_id = p_id.get(), p_dist = p_dist.get()]() {
+                    ScopedSearchPhase phase(SearchPhase::SCAN);
+                    auto params = query_params(idx);
+                    index_->Search(queries[idx], k, p_dist + idx * k, p_id + idx * k, internal_bitset, computer,
+                                   params, 0, n_rows);
+                }));
+            }
+            WaitAllSuccess(futs);
+        } else {
+            // every shard searches a range of the ids, the top-k of the shards are merged per query
+            const size_t shard_size = (n_rows + n_shards - 1) / n_shards;
+            auto shard_ids = std::make_unique<sparse::label_t[]>(nq * n_shards * k);
+            auto shard_dists = std::make_unique<float[]>(nq * n_shards * k);
+            futs.reserve(nq * n_shards);
+            for (int64_t idx = 0; idx < nq; ++idx) {
+                for (size_t shard = 0; shard < n_shards; ++shard) {
+                    const size_t offset = (idx * n_shards + shard) * k;
+                    futs.emplace_back(search_pool_->push([&, idx = idx, shard = shard, offset = offset]() {
+                        // the stats count whole posting lists, the first shard records them
+                        ScopedSearchPhase phase(SearchPhase::SCAN);
+                        auto params = shard == 0 ? query_params(idx) : approx_params;
+                        index_->Search(queries[idx], k, shard_dists.get() + offset, shard_ids.get() + offset,
+                                       internal_bitset, computer, params, shard * shard_size,
+                                       (shard + 1) * shard_size);
+                    }));
+                }
+            }
+            WaitAllSuccess(futs);
+            ScopedSearchPhase phase(SearchPhase::ASSEMBLE);
+            for (int64_t idx = 0; idx < nq; ++idx) {
+                MergeShardResults(shard_ids.get() + idx * n_shards * k, shard_dists.get() + idx * n_shards * k,
+                                  n_shards * k, k, p_id.get() + idx * k, p_dist.get() + idx * k);
+            }
+        }
+        if (!doc_ids_.empty()) {
+            for (int64_t i = 0; i < nq * k; ++i) {
+                if (p_id[i] != -1) {
+                    p_id[i] = doc_ids_[p_id[i]];
+                }
+            }
+        }
+        auto res = GenResultDataSet(nq, k, std::move(p_id), std::move(p_dist));
+        if (!search_stats.empty()) {
+            res->Set(meta::SEARCH_STATS, std::move(search_stats));
+        }
+        return res;
+    }
 
+    [[nodiscard]] expected<DataSetPtr>
+    RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> config, const BitsetView& bitset) const override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Could not range search empty " << Type();
+            return expected<DataSetPtr>::Err(Status::empty_index, "index not loaded");
+        }
+
+        auto cfg = static_cast<const SparseInvertedIndexConfig&>(*config);
+        auto computer_or = index_->GetDocValueComputer(cfg);
+        if (!computer_or.has_value()) {
+            return expected<DataSetPtr>::Err(computer_or.error(), computer_or.what());
+        }
+        auto computer = computer_or.value();
+        auto dim_max_score_ratio = cfg.dim_max_score_ratio.value();
+        const float radius = cfg.radius.value();
+        const float range_filter = cfg.range_filter.value();
+        const int32_t range_search_k = cfg.range_search_k.value();
+
+        auto queries = static_cast<const sparse::SparseRow<T>*>(dataset->GetTensor());
+        auto nq = dataset->GetRows();
+        std::vector<std::vector<int64_t>> result_id_array(nq);
+        std::vector<std::vector<float>> result_dist_array(nq);
+
+        std::vector<uint8_t> internal_bitset_data;
+        auto internal_bitset = ToInternalBitset(bitset, internal_bitset_data);
+        const size_t n_rows = SearchRows(internal_bitset);
         std::vector<folly::Future<folly::Unit>> futs;
         futs.reserve(nq);
         for (int64_t idx = 0; idx < nq; ++idx) {
-            futs.emplace_back(search_pool_->push([&, idx = idx, p_id = p_id.get(), p_dist = p_dist.get()]() {
-                index_->Search(queries[idx], k, p_dist + idx * k, p_id + idx * k, bitset, computer, approx_params);
+            futs.emplace_back(search_pool_->push([&, idx = idx]() {
+                auto& ids = result_id_array[idx];
+                index_->RangeSearch(queries[idx], radius, range_filter, range_search_k, internal_bitset, computer,
+                                    dim_max_score_ratio, ids, result_dist_array[idx], n_rows);
+                if (!doc_ids_.empty()) {
+                    for (auto& id : ids) {
+                        id = doc_ids_[id];
+                    }
+                }
             }));
         }
         WaitAllSuccess(futs);
-        return GenResultDataSet(nq, k, p_id.release(), p_dist.release());
+
+        RangeSearchResult range_search_result;
+        try {
+            range_search_result =
+                GetRangeSearchResult(result_dist_array, result_id_array, true, nq, radius, range_filter);
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "Failed to range search " << Type() << ": " << e.what();
+            return expected<DataSetPtr>::Err(Status::sparse_inner_error, e.what());
+        }
+        return GenResultDataSet(nq, std::move(range_search_result));
     }
 
  private:
@@ -153,14 +344,17 @@ class SparseInvertedIndexNode : public IndexNode {
         // returns n_rows / 10 DistId for the first time to create a large enough window for refinement.
         void
         next_batch(std::function<void(const std::vector<DistId>&)> batch_handler) override {
-            std::vector<DistId> dists;
             size_t num = first_return_ ? (std::max(index_->n_rows() / 10, static_cast<size_t>(20))) : 1;
             first_return_ = false;
-            for (size_t i = 0; i < num && precomputed_it_->HasNext(); ++i) {
-                auto [id, dist] = precomputed_it_->Next();
-                dists.emplace_back(id, dist);
+            ids_.resize(num);
+            dists_.resize(num);
+            num = precomputed_it_->NextBatch(num, ids_.data(), dists_.data());
+            std::vector<DistId> batch;
+            batch.reserve(num);
+            for (size_t i = 0; i < num; ++i) {
+                batch.emplace_back(ids_[i], dists_[i]);
             }
-            batch_handler(dists);
+            batch_handler(batch);
         }
 
         float
@@ -174,6 +368,8 @@ class SparseInvertedIndexNode : public IndexNode {
         const sparse::DocValueComputer<float> computer_;
         std::shared_ptr<PrecomputedDistanceIterator> precomputed_it_;
         bool first_return_ = true;
+        std::vector<int64_t> ids_;
+        std::vector<float> dists_;
     };
 
  public:
@@ -199,17 +395,21 @@ class SparseInvertedIndexNode : public IndexNode {
         auto drop_ratio_search = cfg.drop_ratio_search.value_or(0.0f);
 
         // TODO: set approximated to false for now since the refinement is too slow after forward index is removed.
+        // the refinement works on internal ids, so it is not used with reordered ids either.
         const bool approximated = false;
 
         auto vec = std::vector<std::shared_ptr<IndexNode::iterator>>(nq, nullptr);
         try {
+            // shared by the iterators, which may compute the distances after this returns
+            auto internal_bitset_data = std::make_shared<std::vector<uint8_t>>();
+            auto internal_bitset = ToInternalBitset(bitset, *internal_bitset_data);
             for (int i = 0; i < nq; ++i) {
                 // Heavy computations with `compute_dist_func` will be deferred until the first call to
                 // 'Iterator->Next()'.
                 auto compute_dist_func = [=]() -> std::vector<DistId> {
                     auto queries = static_cast<const sparse::SparseRow<T>*>(dataset->GetTensor());
                     std::vector<float> distances =
-                        index_->GetAllDistances(queries[i], drop_ratio_search, bitset, computer);
+                        index_->GetAllDistances(queries[i], drop_ratio_search, internal_bitset, computer);
                     std::vector<DistId> distances_ids;
                     // 30% is a ratio guesstimate of non-zero distances: probability of 2 random sparse splade
                     // vectors(100 non zero dims out of 30000 total dims) sharing at least 1 common non-zero
@@ -217,12 +417,12 @@ class SparseInvertedIndexNode : public IndexNode {
                     distances_ids.reserve(distances.size() * 0.3);
                     for (size_t i = 0; i < distances.size(); i++) {
                         if (distances[i] != 0) {
-                            distances_ids.emplace_back((int64_t)i, distances[i]);
+                            distances_ids.emplace_back(doc_ids_.empty() ? (int64_t)i : doc_ids_[i], distances[i]);
                         }
                     }
                     return distances_ids;
                 };
-                if (!approximated || queries[i].size() == 0) {
+                if (!approximated || queries[i].size() == 0 || !doc_ids_.empty()) {
                     auto it = std::make_shared<PrecomputedDistanceIterator>(compute_dist_func, true,
                                                                             use_knowhere_search_pool);
                     vec[i] = it;
@@ -255,6 +455,12 @@ class SparseInvertedIndexNode : public IndexNode {
         return false;
     }
 
+    // only the rows of the first Add() are reordered by reorder_doc_ids
+    [[nodiscard]] bool
+    IsIncrementalAddSupported() const override {
+        return true;
+    }
+
     [[nodiscard]] expected<DataSetPtr>
     GetIndexMeta(std::unique_ptr<Config> cfg) const override {
         return expected<DataSetPtr>::Err(Status::not_implemented, "GetIndexMeta not supported for current index type");
@@ -266,13 +472,31 @@ class SparseInvertedIndexNode : public IndexNode {
             LOG_KNOWHERE_ERROR_ << "Could not serialize empty " << Type();
             return Status::empty_index;
         }
-        MemoryIOWriter writer;
+        ChunkedMemoryIOWriter writer;
         RETURN_IF_ERROR(index_->Save(writer));
-        std::shared_ptr<uint8_t[]> data(writer.data());
-        binset.Append(Type(), data, writer.tellg());
+        SaveDocIds(writer);
+        binset.AppendChunks(Type(), writer.Release(), writer.tellg());
         return Status::success;
     }
 
+    Status
+    SerializeToFile(const std::string& filename) const override {
+        if (!index_) {
+            LOG_KNOWHERE_ERROR_ << "Could not serialize empty " << Type();
+            return Status::empty_index;
+        }
+        try {
+            FileWriter writer(filename);
+            RETURN_IF_ERROR(index_->Save(writer));
+            SaveDocIds(writer);
+            writer.close();
+            return Status::success;
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_ERROR_ << "Failed to serialize " << Type() << " to " << filename << ": " << e.what();
+            return Status::disk_file_error;
+        }
+    }
+
     Status
     Deserialize(const BinarySet& binset, std::shared_ptr<Config> config) override {
         if (index_ != nullptr) {
@@ -291,7 +515,8 @@ class SparseInvertedIndexNode : public IndexNode {
             return index_or.error();
         }
         index_ = index_or.value();
-        return index_->Load(reader, 0, "");
+        RETURN_IF_ERROR(index_->Load(reader, 0, ""));
+        return LoadDocIds(reader);
     }
 
     Status
@@ -331,7 +556,14 @@ class SparseInvertedIndexNode : public IndexNode {
 
         MemoryIOReader map_reader(reinterpret_cast<uint8_t*>(mapped_memory), map_size);
         auto supplement_target_filename = filename + ".knowhere_sparse_index_supplement";
-        return index_->Load(map_reader, map_flags, supplement_target_filename);
+        auto load_status = index_->Load(map_reader, map_flags, supplement_target_filename);
+        if (index_->references_loaded_data()) {
+            // the posting lists of the direct layout are not copied, the file stays mapped as long as the index
+            file_map_ = mmap_guard.release();
+            file_map_size_ = map_size;
+        }
+        RETURN_IF_ERROR(load_status);
+        return LoadDocIds(map_reader);
     }
 
     static std::unique_ptr<BaseConfig>
@@ -344,6 +576,19 @@ class SparseInvertedIndexNode : public IndexNode {
         return StaticCreateConfig();
     }
 
+    // the supplement file of a mmapped index is the structure, the posting lists of the direct layout the bulk
+    std::vector<MappedRegion>
+    MappedRegions() const override {
+        std::vector<MappedRegion> regions;
+        if (index_ != nullptr) {
+            regions = index_->mapped_regions();
+        }
+        if (file_map_ != nullptr) {
+            regions.push_back(MappedRegion{file_map_, file_map_size_, false});
+        }
+        return regions;
+    }
+
     // note that the Dim of a sparse vector index may change as new vectors are added
     [[nodiscard]] int64_t
     Dim() const override {
@@ -352,7 +597,18 @@ class SparseInvertedIndexNode : public IndexNode {
 
     [[nodiscard]] int64_t
     Size() const override {
-        return index_ ? index_->size() : 0;
+        return MemoryBreakdown().Total();
+    }
+
+    // the posting lists are counted by their capacity, or by the size of the file they are mapped from
+    [[nodiscard]] MemoryUsage
+    MemoryBreakdown() const override {
+        MemoryUsage usage;
+        if (index_) {
+            usage.Add(memory_section::CODES, index_->size());
+            usage.Add(memory_section::IDS, VectorBytes(doc_ids_));
+        }
+        return usage;
     }
 
     [[nodiscard]] int64_t
@@ -366,9 +622,15 @@ class SparseInvertedIndexNode : public IndexNode {
     }
 
  private:
+    // the index of a concurrent node is searched while rows are added, it is never mmapped
+    template <typename DType, typename QType, sparse::InvertedIndexAlgo algo, bool mmapped>
+    using InvertedIndex = sparse::InvertedIndex<DType, QType, algo, mmapped, concurrent && !mmapped>;
+
     template <bool mmapped>
     expected<sparse::BaseInvertedIndex<T>*>
     CreateIndex(const SparseInvertedIndexConfig& cfg) const {
+        const bool compress_posting_ids = cfg.compress_posting_ids.value();
+        const bool direct_layout = cfg.direct_layout.value();
         if (IsMetricType(cfg.metric_type.value(), metric::BM25)) {
             if (!cfg.bm25_k1.has_value() || !cfg.bm25_b.has_value() || !cfg.bm25_avgdl.has_value()) {
                 return expected<sparse::BaseInvertedIndex<T>*>::Err(
@@ -381,37 +643,65 @@ class SparseInvertedIndexNode : public IndexNode {
             // so it should be at least 1.0 to avoid division by zero.
             avgdl = std::max(avgdl, 1.0f);
 
-            if (use_wand || cfg.inverted_index_algo.value() == "DAAT_WAND") {
-                auto index = new sparse::InvertedIndex<T, uint16_t, sparse::InvertedIndexAlgo::DAAT_WAND, mmapped>(
-                    sparse::SparseMetricType::METRIC_BM25);
-                index->SetBM25Params(k1, b, avgdl);
-                return index;
-            } else if (cfg.inverted_index_algo.value() == "DAAT_MAXSCORE") {
-                auto index = new sparse::InvertedIndex<T, uint16_t, sparse::InvertedIndexAlgo::DAAT_MAXSCORE, mmapped>(
-                    sparse::SparseMetricType::METRIC_BM25);
-                index->SetBM25Params(k1, b, avgdl);
-                return index;
-            } else if (cfg.inverted_index_algo.value() == "TAAT_NAIVE") {
-                auto index = new sparse::InvertedIndex<T, uint16_t, sparse::InvertedIndexAlgo::TAAT_NAIVE, mmapped>(
-                    sparse::SparseMetricType::METRIC_BM25);
-                index->SetBM25Params(k1, b, avgdl);
-                return index;
-            } else {
-                return expected<sparse::BaseInvertedIndex<T>*>::Err(Status::invalid_args,
-                                                                    "Invalid search algorithm for SparseInvertedIndex");
+            // the postings hold term frequencies, or precomputed impacts
+            auto create_bm25_index = [&](auto quant_type) -> expected<sparse::BaseInvertedIndex<T>*> {
+                using QType = decltype(quant_type);
+                sparse::BaseInvertedIndex<T>* base_index = nullptr;
+                if (use_wand || cfg.inverted_index_algo.value() == "DAAT_WAND") {
+                    auto index = new InvertedIndex<T, QType, sparse::InvertedIndexAlgo::DAAT_WAND, mmapped>(
+                        sparse::SparseMetricType::METRIC_BM25, compress_posting_ids, direct_layout);
+                    index->SetBM25Params(k1, b, avgdl);
+                    base_index = index;
+                } else if (cfg.inverted_index_algo.value() == "DAAT_MAXSCORE") {
+                    auto index = new InvertedIndex<T, QType, sparse::InvertedIndexAlgo::DAAT_MAXSCORE, mmapped>(
+                            sparse::SparseMetricType::METRIC_BM25, compress_posting_ids, direct_layout);
+                    index->SetBM25Params(k1, b, avgdl);
+                    base_index = index;
+                } else if (cfg.inverted_index_algo.value() == "DAAT_BLOCK_MAX_WAND") {
+                    auto index = new InvertedIndex<T, QType, sparse::InvertedIndexAlgo::DAAT_BLOCK_MAX_WAND, mmapped>(
+                            sparse::SparseMetricType::METRIC_BM25, compress_posting_ids, direct_layout);
+                    index->SetBM25Params(k1, b, avgdl);
+                    base_index = index;
+                } else if (cfg.inverted_index_algo.value() == "SAAT_ANYTIME") {
+                    auto index = new InvertedIndex<T, QType, sparse::InvertedIndexAlgo::SAAT_ANYTIME, mmapped>(
+                        sparse::SparseMetricType::METRIC_BM25, compress_posting_ids, direct_layout);
+                    index->SetBM25Params(k1, b, avgdl);
+                    base_index = index;
+                } else if (cfg.inverted_index_algo.value() == "TAAT_NAIVE") {
+                    auto index = new InvertedIndex<T, QType, sparse::InvertedIndexAlgo::TAAT_NAIVE, mmapped>(
+                        sparse::SparseMetricType::METRIC_BM25, compress_posting_ids, direct_layout);
+                    index->SetBM25Params(k1, b, avgdl);
+                    base_index = index;
+                } else {
+                    return expected<sparse::BaseInvertedIndex<T>*>::Err(
+                        Status::invalid_args, "Invalid search algorithm for SparseInvertedIndex");
+                }
+                return base_index;
+            };
+            if (cfg.bm25_impacts.value()) {
+                return create_bm25_index(sparse::bm25_impact_t{});
             }
+            return create_bm25_index(uint16_t{});
         } else {
             if (use_wand || cfg.inverted_index_algo.value() == "DAAT_WAND") {
-                auto index = new sparse::InvertedIndex<T, T, sparse::InvertedIndexAlgo::DAAT_WAND, mmapped>(
-                    sparse::SparseMetricType::METRIC_IP);
+                auto index = new InvertedIndex<T, T, sparse::InvertedIndexAlgo::DAAT_WAND, mmapped>(
+                    sparse::SparseMetricType::METRIC_IP, compress_posting_ids, direct_layout);
                 return index;
             } else if (cfg.inverted_index_algo.value() == "DAAT_MAXSCORE") {
-                auto index = new sparse::InvertedIndex<T, T, sparse::InvertedIndexAlgo::DAAT_MAXSCORE, mmapped>(
-                    sparse::SparseMetricType::METRIC_IP);
+                auto index = new InvertedIndex<T, T, sparse::InvertedIndexAlgo::DAAT_MAXSCORE, mmapped>(
+                    sparse::SparseMetricType::METRIC_IP, compress_posting_ids, direct_layout);
+                return index;
+            } else if (cfg.inverted_index_algo.value() == "DAAT_BLOCK_MAX_WAND") {
+                auto index = new InvertedIndex<T, T, sparse::InvertedIndexAlgo::DAAT_BLOCK_MAX_WAND, mmapped>(
+                    sparse::SparseMetricType::METRIC_IP, compress_posting_ids, direct_layout);
+                return index;
+            } else if (cfg.inverted_index_algo.value() == "SAAT_ANYTIME") {
+                auto index = new InvertedIndex<T, T, sparse::InvertedIndexAlgo::SAAT_ANYTIME, mmapped>(
+                    sparse::SparseMetricType::METRIC_IP, compress_posting_ids, direct_layout);
                 return index;
             } else if (cfg.inverted_index_algo.value() == "TAAT_NAIVE") {
-                auto index = new sparse::InvertedIndex<T, T, sparse::InvertedIndexAlgo::TAAT_NAIVE, mmapped>(
-                    sparse::SparseMetricType::METRIC_IP);
+                auto index = new InvertedIndex<T, T, sparse::InvertedIndexAlgo::TAAT_NAIVE, mmapped>(
+                    sparse::SparseMetricType::METRIC_IP, compress_posting_ids, direct_layout);
                 return index;
             } else {
                 return expected<sparse::BaseInvertedIndex<T>*>::Err(Status::invalid_args,
@@ -420,15 +710,145 @@ class SparseInvertedIndexNode : public IndexNode {
         }
     }
 
+    // the rows that all the queries of a search call search, even if rows are added meanwhile. The rows that the
+    // bitset doesn't cover are not searched.
+    size_t
+    SearchRows(const BitsetView& internal_bitset) const {
+        size_t n_rows = index_->n_rows();
+        if (!internal_bitset.empty()) {
+            n_rows = std::min(n_rows, internal_bitset.size());
+        }
+        return n_rows;
+    }
+
+    // the number of shards of the id space that each query is searched in. A small batch searched while the pool is
+    // idle is split, so that the latency of a query on a large index is not bound by a single thread.
+    size_t
+    SearchShards(const int64_t nq, const size_t n_rows) const {
+        const size_t pool_size = search_pool_->size();
+        if (n_rows < 2 * kSparseSearchShardMinRows || static_cast<size_t>(nq) * 2 > pool_size ||
+            search_pool_->GetPendingTaskCount() >= pool_size) {
+            return 1;
+        }
+        return std::min(pool_size / nq, n_rows / kSparseSearchShardMinRows);
+    }
+
+    // the top k of n results of the shards of a query, missing results have -1 ids
+    static void
+    MergeShardResults(const sparse::label_t* ids, const float* dists, const size_t n, const size_t k,
+                      sparse::label_t* out_ids, float* out_dists) {
+        std::vector<std::pair<float, sparse::label_t>> results;
+        results.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (ids[i] != -1) {
+                results.emplace_back(dists[i], ids[i]);
+            }
+        }
+        const size_t m = std::min(k, results.size());
+        std::partial_sort(results.begin(), results.begin() + m, results.end(),
+                          [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = 0; i < k; ++i) {
+            out_ids[i] = i < m ? results[i].second : -1;
+            out_dists[i] = i < m ? results[i].first : std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    // the bitset of the internal ids, the same view if the ids are not reordered
+    BitsetView
+    ToInternalBitset(const BitsetView& bitset, std::vector<uint8_t>& data) const {
+        if (doc_ids_.empty() || bitset.empty()) {
+            return bitset;
+        }
+        data.assign((doc_ids_.size() + 7) / 8, 0);
+        size_t filtered_out_num = 0;
+        for (size_t i = 0; i < doc_ids_.size(); ++i) {
+            if (bitset.test(doc_ids_[i])) {
+                data[i >> 3] |= 0x1 << (i & 0x7);
+                ++filtered_out_num;
+            }
+        }
+        return BitsetView(data.data(), doc_ids_.size(), filtered_out_num);
+    }
+
+    // the ids are appended after the rows of the index, only when they are reordered
+    void
+    SaveDocIds(MemoryIOWriter& writer) const {
+        if (doc_ids_.empty()) {
+            return;
+        }
+        writeBinaryPOD(writer, doc_ids_.size());
+        writer.write(doc_ids_.data(), doc_ids_.size() * sizeof(sparse::label_t));
+    }
+
+    Status
+    LoadDocIds(MemoryIOReader& reader) {
+        if (reader.remaining() == 0) {
+            return Status::success;
+        }
+        size_t n;
+        readBinaryPOD(reader, n);
+        if (n != index_->n_rows() || reader.remaining() < n * sizeof(sparse::label_t)) {
+            LOG_KNOWHERE_ERROR_ << "Invalid doc ids of " << Type() << ": " << n << " ids for " << index_->n_rows()
+                                << " rows";
+            return Status::invalid_binary_set;
+        }
+        doc_ids_.resize(n);
+        reader.read(doc_ids_.data(), n * sizeof(sparse::label_t));
+        return Status::success;
+    }
+
     void
     DeleteExistingIndex() {
         if (index_ != nullptr) {
             delete index_;
             index_ = nullptr;
         }
+        if (file_map_ != nullptr) {
+            if (munmap(file_map_, file_map_size_) != 0) {
+                LOG_KNOWHERE_ERROR_ << "Failed to munmap index file of " << Type() << ": " << strerror(errno);
+            }
+            file_map_ = nullptr;
+            file_map_size_ = 0;
+        }
+        doc_ids_.clear();
+    }
+
+    template <typename, bool, bool>
+    friend class SparseInvertedIndexNode;
+
+    // the rows of other follow the rows of this index, in the order of their ids in other
+    template <bool other_concurrent>
+    Status
+    MergeFrom(const SparseInvertedIndexNode<T, use_wand, other_concurrent>& other) {
+        if (!other.index_) {
+            LOG_KNOWHERE_ERROR_ << "can not merge an empty index";
+            return Status::empty_index;
+        }
+        const size_t n_rows = index_->n_rows();
+        const size_t other_rows = other.index_->n_rows();
+        try {
+            RETURN_IF_ERROR(index_->Merge(*other.index_));
+        } catch (const std::exception& e) {
+            LOG_KNOWHERE_WARNING_ << "failed to merge data to index " << Type() << ": " << e.what();
+            return Status::sparse_inner_error;
+        }
+        // the postings of other are merged with its internal ids, which map to its external ones
+        if (doc_ids_.empty() && !other.doc_ids_.empty()) {
+            doc_ids_.resize(n_rows);
+            std::iota(doc_ids_.begin(), doc_ids_.end(), 0);
+        }
+        for (size_t i = 0; !doc_ids_.empty() && i < other_rows; ++i) {
+            doc_ids_.push_back(n_rows + (other.doc_ids_.empty() ? i : other.doc_ids_[i]));
+        }
+        return Status::success;
     }
 
     sparse::BaseInvertedIndex<T>* index_{};
+    // the external id of each internal id when the rows are reordered, empty otherwise
+    std::vector<sparse::label_t> doc_ids_;
+    // the index file that index_ points into, when it is mmapped in the direct layout
+    void* file_map_ = nullptr;
+    size_t file_map_size_ = 0;
     std::shared_ptr<ThreadPool> search_pool_;
     std::shared_ptr<ThreadPool> build_pool_;
 };  // class SparseInvertedIndexNode
@@ -437,22 +857,19 @@ class SparseInvertedIndexNode : public IndexNode {
 //
 // Thread safety: only the overridden methods are allowed to be called concurrently.
 template <typename T, bool use_wand>
-class SparseInvertedIndexNodeCC : public SparseInvertedIndexNode<T, use_wand> {
+class SparseInvertedIndexNodeCC : public SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true> {
  public:
     explicit SparseInvertedIndexNodeCC(const int32_t& version, const Object& object)
-        : SparseInvertedIndexNode<T, use_wand>(version, object) {
+        : SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>(version, object) {
     }
 
     Status
     Add(const DataSetPtr dataset, std::shared_ptr<Config> config, bool use_knowhere_build_pool) override {
-        std::unique_lock<std::mutex> lock(mutex_);
-        uint64_t task_id = next_task_id_++;
-        add_tasks_.push(task_id);
+        // add task is allowed to run only once no read task is running, searches are not read tasks.
+        std::unique_lock<ReaderBiasedRWLock> lock(rw_lock_);
 
-        // add task is allowed to run only after all search tasks that come before it have finished.
-        cv_.wait(lock, [this, task_id]() { return current_task_id_ == task_id && active_readers_ == 0; });
-
-        auto res = SparseInvertedIndexNode<T, use_wand>::Add(dataset, config, use_knowhere_build_pool);
+        auto res =
+            SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::Add(dataset, config, use_knowhere_build_pool);
 
         auto cfg = static_cast<const SparseInvertedIndexConfig&>(*config);
         if (IsMetricType(cfg.metric_type.value(), metric::IP)) {
@@ -461,18 +878,13 @@ class SparseInvertedIndexNodeCC : public SparseInvertedIndexNode<T, use_wand> {
             auto rows = dataset->GetRows();
             raw_data_.insert(raw_data_.end(), data, data + rows);
         }
-
-        add_tasks_.pop();
-        current_task_id_++;
-        lock.unlock();
-        cv_.notify_all();
         return res;
     }
 
     expected<DataSetPtr>
     Search(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
-        ReadPermission permission(*this);
-        return SparseInvertedIndexNode<T, use_wand>::Search(dataset, std::move(cfg), bitset);
+        // searches don't wait for adds, they see the rows that have been added when they start
+        return SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::Search(dataset, std::move(cfg), bitset);
     }
 
     expected<std::vector<IndexNode::IteratorPtr>>
@@ -484,32 +896,38 @@ class SparseInvertedIndexNodeCC : public SparseInvertedIndexNode<T, use_wand> {
         // index_->GetRawDistance(). If an Add task is added in between, there will be a deadlock.
         auto config = static_cast<const knowhere::SparseInvertedIndexConfig&>(*cfg);
         config.drop_ratio_search = 0.0f;
-        return SparseInvertedIndexNode<T, use_wand>::AnnIterator(dataset, std::move(cfg), bitset,
+        return SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::AnnIterator(dataset, std::move(cfg), bitset,
                                                                  use_knowhere_search_pool);
     }
 
     expected<DataSetPtr>
     RangeSearch(const DataSetPtr dataset, std::unique_ptr<Config> cfg, const BitsetView& bitset) const override {
-        ReadPermission permission(*this);
-        return SparseInvertedIndexNode<T, use_wand>::RangeSearch(dataset, std::move(cfg), bitset);
+        // like Search, it doesn't wait for adds
+        return SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::RangeSearch(dataset, std::move(cfg), bitset);
     }
 
     int64_t
     Dim() const override {
         ReadPermission permission(*this);
-        return SparseInvertedIndexNode<T, use_wand>::Dim();
+        return SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::Dim();
     }
 
     int64_t
     Size() const override {
+        // MemoryBreakdown() holds the permission
+        return MemoryBreakdown().Total();
+    }
+
+    MemoryUsage
+    MemoryBreakdown() const override {
         ReadPermission permission(*this);
-        return SparseInvertedIndexNode<T, use_wand>::Size();
+        return SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::MemoryBreakdown();
     }
 
     int64_t
     Count() const override {
         ReadPermission permission(*this);
-        return SparseInvertedIndexNode<T, use_wand>::Count();
+        return SparseInvertedIndexNode<T, use_wand, /*concurrent=*/true>::Count();
     }
 
     std::string
@@ -571,33 +989,12 @@ class SparseInvertedIndexNodeCC : public SparseInvertedIndexNode<T, use_wand> {
 
  private:
     struct ReadPermission {
-        ReadPermission(const SparseInvertedIndexNodeCC& node) : node_(node) {
-            std::unique_lock<std::mutex> lock(node_.mutex_);
-            uint64_t task_id = node_.next_task_id_++;
-            // read task may execute only after all add tasks that come before it have finished.
-            if (!node_.add_tasks_.empty() && task_id > node_.add_tasks_.front()) {
-                node_.cv_.wait(
-                    lock, [this, task_id]() { return node_.add_tasks_.empty() || task_id < node_.add_tasks_.front(); });
-            }
-            // read task is allowed to run, block all add tasks
-            node_.active_readers_++;
-        }
-
-        ~ReadPermission() {
-            std::unique_lock<std::mutex> lock(node_.mutex_);
-            node_.active_readers_--;
-            node_.current_task_id_++;
-            node_.cv_.notify_all();
+        ReadPermission(const SparseInvertedIndexNodeCC& node) : lock_(node.rw_lock_) {
         }
-        const SparseInvertedIndexNodeCC& node_;
+        std::shared_lock<ReaderBiasedRWLock> lock_;
     };
 
-    mutable std::mutex mutex_;
-    mutable std::condition_variable cv_;
-    mutable int64_t active_readers_ = 0;
-    mutable std::queue<uint64_t> add_tasks_;
-    mutable uint64_t next_task_id_ = 0;
-    mutable uint64_t current_task_id_ = 0;
+    mutable ReaderBiasedRWLock rw_lock_;
     mutable std::vector<sparse::SparseRow<T>> raw_data_ = {};
 };  // class SparseInvertedIndexNodeCC
 
@@ -16,18 +16,28 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <queue>
 #include <unordered_map>
 #include <vector>
 
+#include "index/sparse/sparse_dim_map.h"
 #include "index/sparse/sparse_inverted_index_config.h"
+#include "index/sparse/sparse_posting_codec.h"
+#include "index/sparse/sparse_snapshot.h"
 #include "io/memory_io.h"
 #include "knowhere/bitsetview.h"
 #include "knowhere/comp/index_param.h"
+#include "knowhere/comp/search_stats.h"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/warm_up.h"
 #include "knowhere/expected.h"
 #include "knowhere/log.h"
 #include "knowhere/prometheus_client.h"
@@ -40,12 +50,78 @@ enum class InvertedIndexAlgo {
     TAAT_NAIVE,
     DAAT_WAND,
     DAAT_MAXSCORE,
+    DAAT_BLOCK_MAX_WAND,
+    SAAT_ANYTIME,
+};
+
+// whether the algorithm prunes the candidates with the max scores of the dimensions
+constexpr bool
+UseDimMaxScore(InvertedIndexAlgo algo) {
+    return algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE ||
+           algo == InvertedIndexAlgo::DAAT_BLOCK_MAX_WAND || algo == InvertedIndexAlgo::SAAT_ANYTIME;
+}
+
+// whether the algorithm bounds the scores of the blocks of the posting lists with their max scores
+constexpr bool
+UseBlockMaxScore(InvertedIndexAlgo algo) {
+    return algo == InvertedIndexAlgo::DAAT_BLOCK_MAX_WAND || algo == InvertedIndexAlgo::SAAT_ANYTIME;
+}
+
+// BM25 postings quantized to this type hold precomputed impacts, i.e. the BM25 scores of the terms in units of
+// (k1 + 1) / 255, instead of term frequencies. Scoring them needs neither the doc lengths nor the computer.
+using bm25_impact_t = uint8_t;
+
+// the number of docs whose scores are accumulated at once by TAAT, the scores of a range stay in L2 cache
+constexpr size_t kTaatRangeSize = 65536;
+
+// Add() indexes the rows by shards of at least this many rows in parallel, when there are two shards or more
+constexpr size_t kAddShardMinRows = 16384;
+
+// the first 8 bytes of an index saved in the direct layout, in place of the row count of the raw layout
+constexpr int64_t kDirectLayoutMagic = 0x5053544345524944;  // "DIRECTSP"
+constexpr uint32_t kDirectLayoutVersion = 1;
+// the sections of the direct layout start at multiples of the page size from the magic
+constexpr size_t kDirectLayoutAlignment = 4096;
+
+// The header of the direct layout, which follows the magic. The sections are arrays indexed by the dim id:
+//   dims (table_t, the raw dim of each dim id), plist_offsets (size_t, n_dims + 1 prefix sums of the posting list
+//   sizes), ids (table_t) and vals (QType) of all the posting lists, max_scores (float, per posting list),
+//   block_max (float, per block of each posting list) and row_sums (float, per row, BM25 only).
+struct DirectLayoutHeader {
+    uint32_t version;
+    uint32_t qtype_size;
+    uint32_t metric_type;
+    uint32_t has_row_sums;
+    uint64_t n_rows;
+    uint64_t max_dim;
+    uint64_t n_dims;
+    uint64_t nnz;
+    uint64_t n_blocks;
+    // the BM25 params that the max scores are computed with
+    float bm25_k1;
+    float bm25_b;
+    float bm25_avgdl;
+    uint32_t reserved;
+    // the offsets of the sections from the magic, and the size of the whole index
+    uint64_t dims_offset;
+    uint64_t plist_offsets_offset;
+    uint64_t ids_offset;
+    uint64_t vals_offset;
+    uint64_t max_scores_offset;
+    uint64_t block_max_offset;
+    uint64_t row_sums_offset;
+    uint64_t byte_size;
 };
 
 struct InvertedIndexApproxSearchParams {
     int refine_factor;
     float drop_ratio_search;
     float dim_max_score_ratio;
+    // SAAT_ANYTIME only: the postings and milliseconds a query may spend before its search stops, 0 for no limit
+    int64_t posting_budget = 0;
+    float time_budget_ms = 0;
+    // if set, the stats of the queries of a Search() or SearchBatch() call, one per query
+    SearchStats* stats = nullptr;
 };
 
 template <typename T>
@@ -58,6 +134,7 @@ class BaseInvertedIndex {
 
     // supplement_target_filename: when in mmap mode, we need an extra file to store the mmapped index data structure.
     // this file will be created during loading and deleted in the destructor.
+    // an index saved in the direct layout needs no such file, see references_loaded_data().
     virtual Status
     Load(MemoryIOReader& reader, int map_flags, const std::string& supplement_target_filename) = 0;
 
@@ -67,9 +144,33 @@ class BaseInvertedIndex {
     virtual Status
     Add(const SparseRow<T>* data, size_t rows, int64_t dim) = 0;
 
+    // appends the postings of other to the ones of this index, the internal id i of other becomes n_rows() + i.
+    // other must have the same metric, value type and search algorithm.
+    virtual Status
+    Merge(const BaseInvertedIndex<T>& other) = 0;
+
+    // only the vectors with internal ids in [doc_begin, doc_end) are searched, so that a query can be split into
+    // shards of the id space
     virtual void
     Search(const SparseRow<T>& query, size_t k, float* distances, label_t* labels, const BitsetView& bitset,
-           const DocValueComputer<T>& computer, InvertedIndexApproxSearchParams& approx_params) const = 0;
+           const DocValueComputer<T>& computer, InvertedIndexApproxSearchParams& approx_params, size_t doc_begin = 0,
+           size_t doc_end = std::numeric_limits<size_t>::max()) const = 0;
+
+    // searches the nq queries together, the results of the i-th query start at distances + i * k and labels + i * k
+    virtual void
+    SearchBatch(const SparseRow<T>* queries, size_t nq, size_t k, float* distances, label_t* labels,
+                const BitsetView& bitset, const DocValueComputer<T>& computer,
+                InvertedIndexApproxSearchParams& approx_params,
+                size_t doc_end = std::numeric_limits<size_t>::max()) const = 0;
+
+    // the vectors with internal ids below doc_end that score above radius and at most range_filter, best first. If
+    // range_search_k is positive, only that many of the best of them are returned. The radius is the initial
+    // threshold of the search, so that the vectors that can't score above it are skipped.
+    virtual void
+    RangeSearch(const SparseRow<T>& query, float radius, float range_filter, int32_t range_search_k,
+                const BitsetView& bitset, const DocValueComputer<T>& computer, float dim_max_score_ratio,
+                std::vector<label_t>& ids, std::vector<float>& distances,
+                size_t doc_end = std::numeric_limits<size_t>::max()) const = 0;
 
     virtual std::vector<float>
     GetAllDistances(const SparseRow<T>& query, float drop_ratio_search, const BitsetView& bitset,
@@ -89,12 +190,37 @@ class BaseInvertedIndex {
 
     [[nodiscard]] virtual size_t
     n_cols() const = 0;
+
+    // whether the index points into the memory it was loaded from, which must then outlive the index
+    [[nodiscard]] virtual bool
+    references_loaded_data() const = 0;
+
+    // the file mapped memory of a mmapped index, besides the loaded data it references
+    [[nodiscard]] virtual std::vector<MappedRegion>
+    mapped_regions() const {
+        return {};
+    }
 };
 
-template <typename DType, typename QType, InvertedIndexAlgo algo, bool mmapped = false>
+// A concurrent index may be searched while rows are added to it by a single writer. The searches see the rows up to
+// the n_rows() they start with: the posting lists and the dim map are published before the row count, and the
+// memory they replace is only freed once the searches that may still read it are done.
+template <typename DType, typename QType, InvertedIndexAlgo algo, bool mmapped = false, bool concurrent = false>
 class InvertedIndex : public BaseInvertedIndex<DType> {
+    static_assert(!mmapped || !concurrent, "mmapped InvertedIndex can't be concurrent");
+
  public:
-    explicit InvertedIndex(SparseMetricType metric_type) : metric_type_(metric_type) {
+    // compress_posting_ids is ignored in mmap and concurrent mode, direct_layout selects the layout that Save writes
+    explicit InvertedIndex(SparseMetricType metric_type, bool compress_posting_ids = false, bool direct_layout = false)
+        : metric_type_(metric_type),
+          compress_posting_ids_(compress_posting_ids && !mmapped && !concurrent),
+          direct_layout_(direct_layout) {
+        if constexpr (concurrent) {
+            inverted_index_ids_.set_reclaimer(&reclaimer_);
+            inverted_index_vals_.set_reclaimer(&reclaimer_);
+            max_score_in_dim_.set_reclaimer(&reclaimer_);
+            block_max_scores_.set_reclaimer(&reclaimer_);
+        }
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
         // for now, use timestamp as index_id
         index_id_ = std::to_string(
@@ -102,14 +228,22 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
                 .count());
         index_size_gauge_ =
             &sparse_inverted_index_size_family.Add({{"index_id", index_id_}, {"index_type", "inverted"}});
-        index_dataset_nnz_len_histogram_ =
-            &sparse_dataset_nnz_len_family.Add({{"index_id", index_id_}, {"index_type", "inverted"}}, defaultBuckets);
-        index_posting_list_len_histogram_ = &sparse_inverted_index_posting_list_len_family.Add(
-            {{"index_id", index_id_}, {"index_type", "inverted"}}, defaultBuckets);
+        index_dataset_nnz_len_histogram_ = std::make_unique<ShardedHistogram>(
+            sparse_dataset_nnz_len_family.Add({{"index_id", index_id_}, {"index_type", "inverted"}}, defaultBuckets),
+            defaultBuckets);
+        index_posting_list_len_histogram_ = std::make_unique<ShardedHistogram>(
+            sparse_inverted_index_posting_list_len_family.Add({{"index_id", index_id_}, {"index_type", "inverted"}},
+                                                              defaultBuckets),
+            defaultBuckets);
 #endif
     }
 
     ~InvertedIndex() override {
+        if constexpr (concurrent) {
+            if (dim_map_snapshot_.load() != &dim_map_) {
+                delete dim_map_snapshot_.load();
+            }
+        }
         if constexpr (mmapped) {
             if (map_ != nullptr) {
                 auto res = munmap(map_, map_byte_size_);
@@ -129,21 +263,32 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         if (index_size_gauge_ != nullptr) {
             sparse_inverted_index_size_family.Remove(index_size_gauge_);
         }
+        // unregistered from the flushes before the histograms of the registry go
         if (index_dataset_nnz_len_histogram_ != nullptr) {
-            sparse_dataset_nnz_len_family.Remove(index_dataset_nnz_len_histogram_);
+            auto& histogram = index_dataset_nnz_len_histogram_->Target();
+            index_dataset_nnz_len_histogram_.reset();
+            sparse_dataset_nnz_len_family.Remove(&histogram);
         }
         if (index_posting_list_len_histogram_ != nullptr) {
-            sparse_inverted_index_posting_list_len_family.Remove(index_posting_list_len_histogram_);
+            auto& histogram = index_posting_list_len_histogram_->Target();
+            index_posting_list_len_histogram_.reset();
+            sparse_inverted_index_posting_list_len_family.Remove(&histogram);
         }
 #endif
     }
 
     template <typename U>
-    using Vector = std::conditional_t<mmapped, GrowableVectorView<U>, std::vector<U>>;
+    using Vector = std::conditional_t<mmapped, GrowableVectorView<U>,
+                                      std::conditional_t<concurrent, SnapshotVector<U>, std::vector<U>>>;
+
+    static constexpr bool kBM25Impacts = std::is_same_v<QType, bm25_impact_t>;
 
     void
     SetBM25Params(float k1, float b, float avgdl) {
         bm25_params_ = std::make_unique<BM25Params>(k1, b, avgdl);
+        if constexpr (concurrent) {
+            bm25_params_->row_sums.set_reclaimer(&reclaimer_);
+        }
     }
 
     expected<DocValueComputer<float>>
@@ -163,6 +308,16 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
                 "metric type not match, expected: " + std::string(metric::BM25) + ", got: " + metric_type.value();
             return expected<DocValueComputer<float>>::Err(Status::invalid_metric_type, msg);
         }
+        if constexpr (kBM25Impacts) {
+            // the impacts are computed with the build time k1, b and avgdl, the computer is not used.
+            if ((cfg.bm25_k1.has_value() && cfg.bm25_k1.value() != bm25_params_->k1) ||
+                ((cfg.bm25_b.has_value() && cfg.bm25_b.value() != bm25_params_->b))) {
+                return expected<DocValueComputer<float>>::Err(Status::invalid_args,
+                                                              "search time k1/b must equal load time config for BM25 "
+                                                              "impacts.");
+            }
+            return GetDocValueOriginalComputer<float>();
+        }
         // avgdl must be supplied during search
         if (!cfg.bm25_avgdl.has_value()) {
             return expected<DocValueComputer<float>>::Err(Status::invalid_args,
@@ -170,13 +325,14 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         }
         auto avgdl = cfg.bm25_avgdl.value();
         avgdl = std::max(avgdl, 1.0f);
-        if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
-            // daat_wand and daat_maxscore: search time k1/b must equal load time config.
+        if constexpr (UseDimMaxScore(algo)) {
+            // daat algorithms: search time k1/b must equal load time config.
             if ((cfg.bm25_k1.has_value() && cfg.bm25_k1.value() != bm25_params_->k1) ||
                 ((cfg.bm25_b.has_value() && cfg.bm25_b.value() != bm25_params_->b))) {
                 return expected<DocValueComputer<float>>::Err(
                     Status::invalid_args,
-                    "search time k1/b must equal load time config for DAAT_WAND or DAAT_MAXSCORE algorithm.");
+                    "search time k1/b must equal load time config for DAAT_WAND, DAAT_MAXSCORE or "
+                    "DAAT_BLOCK_MAX_WAND algorithm.");
             }
             return GetDocValueBM25Computer<float>(bm25_params_->k1, bm25_params_->b, avgdl);
         } else {
@@ -202,46 +358,54 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
          *        2. DType val (when QType is different from DType, the QType value of val is stored as a DType with
          *           precision loss)
          *
-         * inverted_index_ids_, inverted_index_vals_ and max_score_in_dim_ are
-         * not serialized, they will be constructed dynamically during
-         * deserialization.
+         * inverted_index_ids_, inverted_index_vals_, max_score_in_dim_ and
+         * block_max_scores_ are not serialized, they will be constructed
+         * dynamically during deserialization.
          *
          * Data are densely packed in serialized bytes and no padding is added.
+         *
+         * With direct_layout_, the posting lists are saved as they are searched instead, see DirectLayoutHeader.
          */
+        if (direct_layout_) {
+            return SaveDirect(writer);
+        }
         DType deprecated_value_threshold = 0;
-        writeBinaryPOD(writer, n_rows_internal_);
+        const size_t n_rows = n_rows_internal_;
+        writeBinaryPOD(writer, n_rows);
         writeBinaryPOD(writer, max_dim_);
         writeBinaryPOD(writer, deprecated_value_threshold);
         BitsetView bitset(nullptr, 0);
 
         auto dim_map_reverse = std::unordered_map<uint32_t, table_t>();
-        for (const auto& [dim, dim_id] : dim_map_) {
+        for (const auto& [dim, dim_id] : dim_map()) {
             dim_map_reverse[dim_id] = dim;
         }
 
-        std::vector<size_t> row_sizes(n_rows_internal_, 0);
+        std::vector<size_t> row_sizes(n_rows, 0);
+        std::vector<table_t> decoded_ids;
         for (size_t i = 0; i < inverted_index_ids_.size(); ++i) {
-            for (const auto& id : inverted_index_ids_[i]) {
-                row_sizes[id]++;
+            const table_t* ids = get_plist_ids(i, decoded_ids);
+            for (size_t j = 0; j < get_plist_size(i); ++j) {
+                row_sizes[ids[j]]++;
             }
         }
 
-        std::vector<SparseRow<DType>> raw_rows(n_rows_internal_);
-        for (size_t i = 0; i < n_rows_internal_; ++i) {
+        std::vector<SparseRow<DType>> raw_rows(n_rows);
+        for (size_t i = 0; i < n_rows; ++i) {
             raw_rows[i] = std::move(SparseRow<DType>(row_sizes[i]));
         }
 
         for (size_t i = 0; i < inverted_index_ids_.size(); ++i) {
-            const auto& ids = inverted_index_ids_[i];
+            const table_t* ids = get_plist_ids(i, decoded_ids);
             const auto& vals = inverted_index_vals_[i];
             const auto dim = dim_map_reverse[i];
-            for (size_t j = 0; j < ids.size(); ++j) {
+            for (size_t j = 0; j < get_plist_size(i); ++j) {
                 raw_rows[ids[j]].set_at(raw_rows[ids[j]].size() - row_sizes[ids[j]], dim, vals[j]);
                 --row_sizes[ids[j]];
             }
         }
 
-        for (table_t vec_id = 0; vec_id < n_rows_internal_; ++vec_id) {
+        for (table_t vec_id = 0; vec_id < n_rows; ++vec_id) {
             writeBinaryPOD(writer, raw_rows[vec_id].size());
             if (raw_rows[vec_id].size() > 0) {
                 writer.write(raw_rows[vec_id].data(), raw_rows[vec_id].size() * SparseRow<DType>::element_size());
@@ -253,9 +417,17 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
 
     Status
     Load(MemoryIOReader& reader, int map_flags, const std::string& supplement_target_filename) override {
+        if constexpr (concurrent) {
+            return Status::not_implemented;
+        }
         DType deprecated_value_threshold;
         int64_t rows;
+        const size_t start = reader.tellg();
         readBinaryPOD(reader, rows);
+        if (rows == kDirectLayoutMagic) {
+            direct_layout_ = true;
+            return LoadDirect(reader, start);
+        }
         // previous versions used the signness of rows to indicate whether to
         // use wand. now we use a template parameter to control this thus simply
         // take the absolute value of rows.
@@ -266,7 +438,7 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         if constexpr (mmapped) {
             RETURN_IF_ERROR(PrepareMmap(reader, rows, map_flags, supplement_target_filename));
         } else {
-            if (metric_type_ == SparseMetricType::METRIC_BM25) {
+            if (use_row_sums()) {
                 bm25_params_->row_sums.reserve(rows);
             }
         }
@@ -296,10 +468,17 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
 #endif
         }
         LOG_KNOWHERE_INFO_ << "Sparse Inverted Index loading progress: 100%";
+        dim_map_.freeze();
+
+        if constexpr (!mmapped && !concurrent) {
+            if (compress_posting_ids_) {
+                compress_plist_ids();
+            }
+        }
 
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
         for (size_t i = 0; i < dim_map_.size(); ++i) {
-            index_posting_list_len_histogram_->Observe(inverted_index_ids_[i].size());
+            index_posting_list_len_histogram_->Observe(get_plist_size(i));
         }
         index_size_gauge_->Set((double)size() / 1024.0 / 1024.0);
 #endif
@@ -313,7 +492,8 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
     Status
     PrepareMmap(MemoryIOReader& reader, size_t rows, int map_flags, const std::string& supplement_target_filename) {
         const auto initial_reader_location = reader.tellg();
-        const auto nnz = (reader.remaining() - (rows * sizeof(size_t))) / SparseRow<DType>::element_size();
+        // the rows may be followed by other data, nnz is counted instead of derived from the remaining bytes
+        size_t nnz = 0;
 
         // count raw vector idx occurrences
         std::unordered_map<table_t, size_t> idx_counts;
@@ -323,6 +503,7 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
             if (row_nnz == 0) {
                 continue;
             }
+            nnz += row_nnz;
             for (size_t j = 0; j < row_nnz; ++j) {
                 table_t idx;
                 readBinaryPOD(reader, idx);
@@ -341,14 +522,22 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         auto plists_ids_byte_size = nnz * sizeof(typename decltype(inverted_index_ids_)::value_type::value_type);
         auto plists_vals_byte_size = nnz * sizeof(typename decltype(inverted_index_vals_)::value_type::value_type);
         auto max_score_in_dim_byte_size = idx_counts.size() * sizeof(typename decltype(max_score_in_dim_)::value_type);
+        auto block_max_scores_byte_size =
+            idx_counts.size() * sizeof(typename decltype(block_max_scores_)::value_type);
+        for (const auto& [idx, count] : idx_counts) {
+            block_max_scores_byte_size += num_blocks(count) * sizeof(float);
+        }
         size_t row_sums_byte_size = 0;
 
         map_byte_size_ =
             inverted_index_ids_byte_size + inverted_index_vals_byte_size + plists_ids_byte_size + plists_vals_byte_size;
-        if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
+        if constexpr (UseDimMaxScore(algo)) {
             map_byte_size_ += max_score_in_dim_byte_size;
         }
-        if (metric_type_ == SparseMetricType::METRIC_BM25) {
+        if constexpr (UseBlockMaxScore(algo)) {
+            map_byte_size_ += block_max_scores_byte_size;
+        }
+        if (use_row_sums()) {
             row_sums_byte_size = rows * sizeof(typename decltype(bm25_params_->row_sums)::value_type);
             map_byte_size_ += row_sums_byte_size;
         }
@@ -399,12 +588,24 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         inverted_index_vals_.initialize(ptr, inverted_index_vals_byte_size);
         ptr += inverted_index_vals_byte_size;
 
-        if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
+        if constexpr (UseDimMaxScore(algo)) {
             max_score_in_dim_.initialize(ptr, max_score_in_dim_byte_size);
             ptr += max_score_in_dim_byte_size;
         }
 
-        if (metric_type_ == SparseMetricType::METRIC_BM25) {
+        if constexpr (UseBlockMaxScore(algo)) {
+            auto outer_byte_size = idx_counts.size() * sizeof(typename decltype(block_max_scores_)::value_type);
+            block_max_scores_.initialize(ptr, outer_byte_size);
+            ptr += outer_byte_size;
+            for (const auto& [idx, count] : idx_counts) {
+                auto& block_max = block_max_scores_.emplace_back();
+                auto block_max_byte_size = num_blocks(count) * sizeof(float);
+                block_max.initialize(ptr, block_max_byte_size);
+                ptr += block_max_byte_size;
+            }
+        }
+
+        if (use_row_sums()) {
             bm25_params_->row_sums.initialize(ptr, row_sums_byte_size);
             ptr += row_sums_byte_size;
         }
@@ -423,18 +624,285 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         }
         size_t dim_id = 0;
         for (const auto& [idx, count] : idx_counts) {
-            dim_map_[idx] = dim_id;
-            if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
+            dim_map_.emplace(idx, dim_id);
+            if constexpr (UseDimMaxScore(algo)) {
                 max_score_in_dim_.emplace_back(0.0f);
             }
             ++dim_id;
         }
+        dim_map_.freeze();
         // in mmap mode, next_dim_id_ should never be used, but still assigning for consistency.
         next_dim_id_ = dim_id;
 
         return Status::success;
     }
 
+    // saves the posting lists as they are searched, so that loading them is a header parse and, in mmap mode,
+    //   views into the saved sections
+    Status
+    SaveDirect(MemoryIOWriter& writer) {
+        const size_t start = writer.tellg();
+        const size_t n_dims = dim_map().size();
+        std::vector<table_t> dims(n_dims);
+        for (const auto& [dim, dim_id] : dim_map()) {
+            dims[dim_id] = dim;
+        }
+        std::vector<size_t> plist_offsets(n_dims + 1, 0);
+        std::vector<size_t> block_offsets(n_dims + 1, 0);
+        for (size_t i = 0; i < n_dims; ++i) {
+            plist_offsets[i + 1] = plist_offsets[i] + get_plist_size(i);
+            block_offsets[i + 1] = block_offsets[i] + num_blocks(get_plist_size(i));
+        }
+        // the max scores are saved whatever the algorithm, so that the index can be loaded with any of them
+        std::vector<float> max_scores(n_dims);
+        std::vector<float> block_max(block_offsets[n_dims]);
+        std::vector<table_t> decoded_ids;
+        for (size_t i = 0; i < n_dims; ++i) {
+            max_scores[i] = plist_max_scores(i, block_max.data() + block_offsets[i], decoded_ids);
+        }
+
+        DirectLayoutHeader header{};
+        header.version = kDirectLayoutVersion;
+        header.qtype_size = sizeof(QType);
+        header.metric_type = static_cast<uint32_t>(metric_type_);
+        header.has_row_sums = use_row_sums();
+        header.n_rows = n_rows_internal_;
+        header.max_dim = max_dim_;
+        header.n_dims = n_dims;
+        header.nnz = plist_offsets[n_dims];
+        header.n_blocks = block_offsets[n_dims];
+        if (bm25_params_ != nullptr) {
+            header.bm25_k1 = bm25_params_->k1;
+            header.bm25_b = bm25_params_->b;
+            header.bm25_avgdl = bm25_params_->avgdl;
+        }
+        size_t offset = sizeof(kDirectLayoutMagic) + sizeof(header);
+        auto next_section = [&offset](size_t byte_size) {
+            const size_t section =
+                (offset + kDirectLayoutAlignment - 1) / kDirectLayoutAlignment * kDirectLayoutAlignment;
+            offset = section + byte_size;
+            return section;
+        };
+        header.dims_offset = next_section(n_dims * sizeof(table_t));
+        header.plist_offsets_offset = next_section((n_dims + 1) * sizeof(size_t));
+        header.ids_offset = next_section(header.nnz * sizeof(table_t));
+        header.vals_offset = next_section(header.nnz * sizeof(QType));
+        header.max_scores_offset = next_section(n_dims * sizeof(float));
+        header.block_max_offset = next_section(header.n_blocks * sizeof(float));
+        header.row_sums_offset = next_section(use_row_sums() ? n_rows_internal_ * sizeof(float) : 0);
+        header.byte_size = offset;
+
+        writeBinaryPOD(writer, kDirectLayoutMagic);
+        writeBinaryPOD(writer, header);
+        const std::vector<uint8_t> padding(kDirectLayoutAlignment, 0);
+        auto pad_to = [&](size_t section_offset) {
+            writer.write(padding.data(), section_offset - (writer.tellg() - start));
+        };
+        pad_to(header.dims_offset);
+        writer.write(dims.data(), n_dims * sizeof(table_t));
+        pad_to(header.plist_offsets_offset);
+        writer.write(plist_offsets.data(), (n_dims + 1) * sizeof(size_t));
+        pad_to(header.ids_offset);
+        for (size_t i = 0; i < n_dims; ++i) {
+            writer.write(get_plist_ids(i, decoded_ids), get_plist_size(i) * sizeof(table_t));
+        }
+        pad_to(header.vals_offset);
+        for (size_t i = 0; i < n_dims; ++i) {
+            writer.write(inverted_index_vals_[i].data(), get_plist_size(i) * sizeof(QType));
+        }
+        pad_to(header.max_scores_offset);
+        writer.write(max_scores.data(), n_dims * sizeof(float));
+        pad_to(header.block_max_offset);
+        writer.write(block_max.data(), header.n_blocks * sizeof(float));
+        pad_to(header.row_sums_offset);
+        if (use_row_sums()) {
+            writer.write(bm25_params_->row_sums.data(), n_rows_internal_ * sizeof(float));
+        }
+        return Status::success;
+    }
+
+    // start is the position of the magic in reader. In mmap mode the views point into reader, that must stay valid as
+    //   long as the index, otherwise the sections are copied.
+    Status
+    LoadDirect(MemoryIOReader& reader, size_t start) {
+        DirectLayoutHeader header{};
+        if (reader.remaining() < sizeof(header)) {
+            LOG_KNOWHERE_ERROR_ << "Truncated direct layout of sparse InvertedIndex";
+            return Status::invalid_binary_set;
+        }
+        readBinaryPOD(reader, header);
+        if (header.version != kDirectLayoutVersion || header.qtype_size != sizeof(QType) ||
+            header.metric_type != static_cast<uint32_t>(metric_type_) ||
+            static_cast<bool>(header.has_row_sums) != use_row_sums() ||
+            start + header.byte_size > reader.tellg() + reader.remaining()) {
+            LOG_KNOWHERE_ERROR_ << "Invalid direct layout of sparse InvertedIndex: version " << header.version
+                                << ", value size " << header.qtype_size << ", metric " << header.metric_type
+                                << ", byte size " << header.byte_size;
+            return Status::invalid_binary_set;
+        }
+        const uint8_t* base = reader.data() + start;
+        reader.seekg(start + header.byte_size);
+        if constexpr (mmapped) {
+            if (reinterpret_cast<uintptr_t>(base) % alignof(size_t) != 0) {
+                LOG_KNOWHERE_ERROR_ << "Direct layout of sparse InvertedIndex is not aligned in memory";
+                return Status::invalid_binary_set;
+            }
+        }
+
+        const size_t n_dims = header.n_dims;
+        std::vector<table_t> dims(n_dims);
+        std::memcpy(dims.data(), base + header.dims_offset, n_dims * sizeof(table_t));
+        std::vector<size_t> plist_offsets(n_dims + 1);
+        std::memcpy(plist_offsets.data(), base + header.plist_offsets_offset, (n_dims + 1) * sizeof(size_t));
+        std::vector<size_t> block_offsets(n_dims + 1, 0);
+        for (size_t i = 0; i < n_dims; ++i) {
+            block_offsets[i + 1] = block_offsets[i] + num_blocks(plist_offsets[i + 1] - plist_offsets[i]);
+        }
+        if (plist_offsets[n_dims] != header.nnz || block_offsets[n_dims] != header.n_blocks) {
+            LOG_KNOWHERE_ERROR_ << "Invalid posting lists in direct layout of sparse InvertedIndex";
+            return Status::invalid_binary_set;
+        }
+        for (size_t i = 0; i < n_dims; ++i) {
+            dim_map_.emplace(dims[i], i);
+        }
+        dim_map_.freeze();
+        const auto* ids = reinterpret_cast<const table_t*>(base + header.ids_offset);
+        const auto* vals = reinterpret_cast<const QType*>(base + header.vals_offset);
+        const auto* max_scores = reinterpret_cast<const float*>(base + header.max_scores_offset);
+        const auto* block_max = reinterpret_cast<const float*>(base + header.block_max_offset);
+        const auto* row_sums = reinterpret_cast<const float*>(base + header.row_sums_offset);
+        // the saved max scores are not upper bounds of the BM25 scores with other params
+        const bool rescore = UseDimMaxScore(algo) && metric_type_ == SparseMetricType::METRIC_BM25 &&
+                             (header.bm25_k1 != bm25_params_->k1 || header.bm25_b != bm25_params_->b ||
+                              header.bm25_avgdl != bm25_params_->avgdl);
+
+        if constexpr (mmapped) {
+            // only the outer arrays of the views, and the max scores that are computed again, are in memory
+            map_byte_size_ = n_dims * (sizeof(Vector<table_t>) + sizeof(Vector<QType>));
+            if constexpr (UseBlockMaxScore(algo)) {
+                map_byte_size_ += n_dims * sizeof(Vector<float>);
+            }
+            if (rescore) {
+                map_byte_size_ += (n_dims + header.n_blocks) * sizeof(float);
+            }
+            if (map_byte_size_ > 0) {
+                map_ = static_cast<char*>(
+                    mmap(nullptr, map_byte_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+                if (map_ == MAP_FAILED) {
+                    LOG_KNOWHERE_ERROR_ << "Failed to create mmap when loading sparse InvertedIndex: "
+                                        << strerror(errno) << ", size: " << map_byte_size_;
+                    map_ = nullptr;
+                    map_byte_size_ = 0;
+                    return Status::malloc_error;
+                }
+            }
+            char* ptr = map_;
+            inverted_index_ids_.initialize(ptr, n_dims * sizeof(Vector<table_t>));
+            ptr += n_dims * sizeof(Vector<table_t>);
+            inverted_index_vals_.initialize(ptr, n_dims * sizeof(Vector<QType>));
+            ptr += n_dims * sizeof(Vector<QType>);
+            for (size_t i = 0; i < n_dims; ++i) {
+                const size_t size = plist_offsets[i + 1] - plist_offsets[i];
+                inverted_index_ids_.emplace_back().initialize_with_elements(ids + plist_offsets[i],
+                                                                            size * sizeof(table_t));
+                inverted_index_vals_.emplace_back().initialize_with_elements(vals + plist_offsets[i],
+                                                                             size * sizeof(QType));
+            }
+            char* block_max_views = ptr;
+            if constexpr (UseBlockMaxScore(algo)) {
+                ptr += n_dims * sizeof(Vector<float>);
+            }
+            if (use_row_sums()) {
+                bm25_params_->row_sums.initialize_with_elements(row_sums, header.n_rows * sizeof(float));
+            }
+            if (rescore) {
+                auto* rescored_max = reinterpret_cast<float*>(ptr);
+                auto* rescored_block_max = rescored_max + n_dims;
+                parallel_for_dims(n_dims, [&](size_t begin, size_t end) {
+                    std::vector<table_t> buffer;
+                    for (size_t i = begin; i < end; ++i) {
+                        rescored_max[i] = plist_max_scores(i, rescored_block_max + block_offsets[i], buffer);
+                    }
+                });
+                max_scores = rescored_max;
+                block_max = rescored_block_max;
+            }
+            if constexpr (UseDimMaxScore(algo)) {
+                max_score_in_dim_.initialize_with_elements(max_scores, n_dims * sizeof(float));
+            }
+            if constexpr (UseBlockMaxScore(algo)) {
+                block_max_scores_.initialize(block_max_views, n_dims * sizeof(Vector<float>));
+                for (size_t i = 0; i < n_dims; ++i) {
+                    block_max_scores_.emplace_back().initialize_with_elements(
+                        block_max + block_offsets[i], (block_offsets[i + 1] - block_offsets[i]) * sizeof(float));
+                }
+            }
+            direct_data_ = base;
+            direct_byte_size_ = header.byte_size;
+        } else {
+            inverted_index_ids_.resize(n_dims);
+            inverted_index_vals_.resize(n_dims);
+            // the posting lists are independent sections, they are copied in parallel
+            parallel_for_dims(n_dims, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const size_t size = plist_offsets[i + 1] - plist_offsets[i];
+                    inverted_index_ids_[i].resize(size);
+                    std::memcpy(inverted_index_ids_[i].data(), ids + plist_offsets[i], size * sizeof(table_t));
+                    inverted_index_vals_[i].resize(size);
+                    std::memcpy(inverted_index_vals_[i].data(), vals + plist_offsets[i], size * sizeof(QType));
+                }
+            });
+            if (use_row_sums()) {
+                bm25_params_->row_sums.resize(header.n_rows);
+                std::memcpy(bm25_params_->row_sums.data(), row_sums, header.n_rows * sizeof(float));
+            }
+            if constexpr (UseDimMaxScore(algo)) {
+                max_score_in_dim_.resize(n_dims);
+                std::memcpy(max_score_in_dim_.data(), max_scores, n_dims * sizeof(float));
+            }
+            if constexpr (UseBlockMaxScore(algo)) {
+                block_max_scores_.resize(n_dims);
+                for (size_t i = 0; i < n_dims; ++i) {
+                    block_max_scores_[i].resize(block_offsets[i + 1] - block_offsets[i]);
+                    std::memcpy(block_max_scores_[i].data(), block_max + block_offsets[i],
+                                block_max_scores_[i].size() * sizeof(float));
+                }
+            }
+            if (rescore) {
+                std::vector<float> rescored_block_max(header.n_blocks);
+                parallel_for_dims(n_dims, [&](size_t begin, size_t end) {
+                    std::vector<table_t> buffer;
+                    for (size_t i = begin; i < end; ++i) {
+                        max_score_in_dim_[i] =
+                            plist_max_scores(i, rescored_block_max.data() + block_offsets[i], buffer);
+                    }
+                });
+                if constexpr (UseBlockMaxScore(algo)) {
+                    for (size_t i = 0; i < n_dims; ++i) {
+                        std::copy(rescored_block_max.begin() + block_offsets[i],
+                                  rescored_block_max.begin() + block_offsets[i + 1], block_max_scores_[i].begin());
+                    }
+                }
+            }
+        }
+
+        n_rows_internal_ = header.n_rows;
+        max_dim_ = header.max_dim;
+        next_dim_id_ = n_dims;
+        if constexpr (!mmapped && !concurrent) {
+            if (compress_posting_ids_) {
+                compress_plist_ids();
+            }
+        }
+#if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
+        for (size_t i = 0; i < n_dims; ++i) {
+            index_posting_list_len_histogram_->Observe(get_plist_size(i));
+        }
+        index_size_gauge_->Set((double)size() / 1024.0 / 1024.0);
+#endif
+        return Status::success;
+    }
+
     // Non zero drop ratio is only supported for static index, i.e. data should
     // include all rows that'll be added to the index.
     Status
@@ -451,30 +919,80 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         if constexpr (mmapped) {
             throw std::invalid_argument("mmapped InvertedIndex does not support Add");
         } else {
-            auto current_rows = n_rows_internal_;
+            const size_t current_rows = n_rows_internal_;
             if ((size_t)dim > max_dim_) {
                 max_dim_ = dim;
             }
 
-            if (metric_type_ == SparseMetricType::METRIC_BM25) {
+            if (use_row_sums()) {
                 bm25_params_->row_sums.reserve(current_rows + rows);
             }
-            for (size_t i = 0; i < rows; ++i) {
-                add_row_to_index(data[i], current_rows + i);
+            if constexpr (concurrent) {
+                register_new_dims(data, rows);
+            } else if (!compressed_ids_.empty()) {
+                // the compressed lists can't be appended to, they are compressed again after the rows are added
+                decompress_plist_ids();
+            }
+            // the posting lists of a concurrent index grow while they are searched, its rows are added one by one
+            const size_t n_shards = std::min<size_t>(omp_get_max_threads(), rows / kAddShardMinRows);
+            if constexpr (!concurrent) {
+                if (n_shards > 1) {
+                    add_rows_in_parallel(data, rows, n_shards);
+                }
             }
+            for (size_t i = 0; (concurrent || n_shards <= 1) && i < rows; ++i) {
+                if constexpr (kBM25Impacts) {
+                    add_row_to_index(to_bm25_impacts(data[i]), current_rows + i);
+                } else {
+                    add_row_to_index(data[i], current_rows + i);
+                }
+            }
+            // publishes the rows to the searches that start from now on
             n_rows_internal_ += rows;
+            if constexpr (concurrent) {
+                reclaimer_.reclaim();
+            } else {
+                dim_map_.freeze();
+                if (compress_posting_ids_) {
+                    compress_plist_ids();
+                }
+            }
 
             return Status::success;
         }
     }
 
+    Status
+    Merge(const BaseInvertedIndex<DType>& other) override {
+        if constexpr (mmapped || concurrent) {
+            LOG_KNOWHERE_ERROR_ << "a mmapped or concurrent InvertedIndex can not be merged into";
+            return Status::not_implemented;
+        } else {
+            // the index to merge from may be of any mode
+            if (auto p = dynamic_cast<const InvertedIndex<DType, QType, algo, false, false>*>(&other)) {
+                return merge_from(*p);
+            }
+            if (auto p = dynamic_cast<const InvertedIndex<DType, QType, algo, true, false>*>(&other)) {
+                return merge_from(*p);
+            }
+            if (auto p = dynamic_cast<const InvertedIndex<DType, QType, algo, false, true>*>(&other)) {
+                return merge_from(*p);
+            }
+            LOG_KNOWHERE_ERROR_ << "can not merge sparse inverted indexes of different value types or algorithms";
+            return Status::invalid_args;
+        }
+    }
+
     void
     Search(const SparseRow<DType>& query, size_t k, float* distances, label_t* labels, const BitsetView& bitset,
-           const DocValueComputer<float>& computer, InvertedIndexApproxSearchParams& approx_params) const override {
+           const DocValueComputer<float>& computer, InvertedIndexApproxSearchParams& approx_params,
+           size_t doc_begin = 0, size_t doc_end = std::numeric_limits<size_t>::max()) const override {
         // initially set result distances to NaN and labels to -1
         std::fill(distances, distances + k, std::numeric_limits<float>::quiet_NaN());
         std::fill(labels, labels + k, -1);
-        if (query.size() == 0) {
+        EpochReclaimer::ReadGuard guard(concurrent ? &reclaimer_ : nullptr);
+        doc_end = std::min<size_t>(doc_end, n_rows_internal_);
+        if (query.size() == 0 || doc_begin >= doc_end) {
             return;
         }
 
@@ -482,24 +1000,139 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         if (q_vec.empty()) {
             return;
         }
+        if (approx_params.stats != nullptr) {
+            add_query_stats(q_vec, k, approx_params, *approx_params.stats);
+        }
 
         MaxMinHeap<float> heap(k * approx_params.refine_factor);
-        // DAAT_WAND and DAAT_MAXSCORE are based on the implementation in PISA.
-        if constexpr (algo == InvertedIndexAlgo::DAAT_WAND) {
-            search_daat_wand(q_vec, heap, bitset, computer, approx_params.dim_max_score_ratio);
-        } else if constexpr (algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
-            search_daat_maxscore(q_vec, heap, bitset, computer, approx_params.dim_max_score_ratio);
+        if constexpr (algo == InvertedIndexAlgo::SAAT_ANYTIME) {
+            const bool early_terminated = search_saat_anytime(q_vec, heap, k * approx_params.refine_factor, bitset,
+                                                              computer, approx_params, doc_begin, doc_end);
+            if (approx_params.stats != nullptr) {
+                approx_params.stats->early_terminated |= early_terminated;
+            }
         } else {
-            search_taat_naive(q_vec, heap, bitset, computer);
+            search_with_algo(q_vec, heap, bitset, computer, approx_params.dim_max_score_ratio, doc_begin, doc_end);
         }
 
         if (approx_params.refine_factor == 1) {
             collect_result(heap, distances, labels);
         } else {
-            refine_and_collect(query, heap, k, distances, labels, computer, approx_params);
+            refine_and_collect(query, heap, k, distances, labels, computer, approx_params, doc_begin, doc_end);
+        }
+    }
+
+    // A single pass over the union of the posting lists of the queries, in doc id order, with a heap per query: a
+    // posting list that many queries share is read once for the batch instead of once per query. Every posting is
+    // scored, the lists are not pruned by the algorithm of the index.
+    void
+    SearchBatch(const SparseRow<DType>* queries, size_t nq, size_t k, float* distances, label_t* labels,
+                const BitsetView& bitset, const DocValueComputer<float>& computer,
+                InvertedIndexApproxSearchParams& approx_params,
+                size_t doc_end = std::numeric_limits<size_t>::max()) const override {
+        std::fill(distances, distances + nq * k, std::numeric_limits<float>::quiet_NaN());
+        std::fill(labels, labels + nq * k, -1);
+        EpochReclaimer::ReadGuard guard(concurrent ? &reclaimer_ : nullptr);
+        doc_end = std::min<size_t>(doc_end, n_rows_internal_);
+        if (doc_end == 0) {
+            return;
+        }
+
+        // the queries that have each dim of the union, with their values
+        std::unordered_map<size_t, size_t> union_dims;
+        std::vector<size_t> dims;
+        std::vector<std::vector<std::pair<uint32_t, DType>>> dim_queries;
+        for (size_t q = 0; q < nq; ++q) {
+            auto q_vec = parse_query(queries[q], approx_params.drop_ratio_search);
+            if (approx_params.stats != nullptr && !q_vec.empty()) {
+                add_query_stats(q_vec, k, approx_params, approx_params.stats[q]);
+            }
+            for (auto [dim, val] : q_vec) {
+                auto [it, inserted] = union_dims.try_emplace(dim, dims.size());
+                if (inserted) {
+                    dims.push_back(dim);
+                    dim_queries.emplace_back();
+                }
+                dim_queries[it->second].emplace_back(q, val);
+            }
+        }
+
+        // the cursors don't prune, they need no max scores
+        std::vector<Cursor<const BitsetView>> cursors;
+        cursors.reserve(dims.size());
+        for (auto dim : dims) {
+            cursors.emplace_back(inverted_index_ids_[dim], inverted_index_vals_[dim], doc_end, 0.0f, 1.0f, bitset,
+                                 get_compressed_plist_ids(dim));
+        }
+        using CursorPos = std::pair<table_t, uint32_t>;
+        std::priority_queue<CursorPos, std::vector<CursorPos>, std::greater<CursorPos>> next_cursors;
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            next_cursors.emplace(cursors[i].cur_vec_id_, i);
+        }
+        std::vector<MaxMinHeap<float>> heaps(nq, MaxMinHeap<float>(k * approx_params.refine_factor));
+        std::vector<float> scores(nq, 0.0f);
+        std::vector<uint8_t> scored(nq, 0);
+        std::vector<uint32_t> scored_queries;
+        while (!next_cursors.empty() && next_cursors.top().first < doc_end) {
+            const table_t vec_id = next_cursors.top().first;
+            const float len = doc_len(vec_id);
+            while (!next_cursors.empty() && next_cursors.top().first == vec_id) {
+                const uint32_t i = next_cursors.top().second;
+                next_cursors.pop();
+                auto& cursor = cursors[i];
+                const float score = doc_score(computer, cursor.cur_vec_val(), len);
+                for (auto [q, val] : dim_queries[i]) {
+                    if (!scored[q]) {
+                        scored[q] = 1;
+                        scored_queries.push_back(q);
+                    }
+                    scores[q] += val * score;
+                }
+                cursor.next();
+                next_cursors.emplace(cursor.cur_vec_id_, i);
+            }
+            for (auto q : scored_queries) {
+                heaps[q].push(vec_id, scores[q]);
+                scores[q] = 0.0f;
+                scored[q] = 0;
+            }
+            scored_queries.clear();
+        }
+
+        for (size_t q = 0; q < nq; ++q) {
+            if (approx_params.refine_factor == 1) {
+                collect_result(heaps[q], distances + q * k, labels + q * k);
+            } else {
+                refine_and_collect(queries[q], heaps[q], k, distances + q * k, labels + q * k, computer,
+                                   approx_params, 0, doc_end);
+            }
         }
     }
 
+    // The full query is used, so the returned distances are exact.
+    void
+    RangeSearch(const SparseRow<DType>& query, float radius, float range_filter, int32_t range_search_k,
+                const BitsetView& bitset, const DocValueComputer<float>& computer, float dim_max_score_ratio,
+                std::vector<label_t>& ids, std::vector<float>& distances,
+                size_t doc_end = std::numeric_limits<size_t>::max()) const override {
+        ids.clear();
+        distances.clear();
+        EpochReclaimer::ReadGuard guard(concurrent ? &reclaimer_ : nullptr);
+        doc_end = std::min<size_t>(doc_end, n_rows_internal_);
+        if (query.size() == 0 || doc_end == 0 || range_search_k == 0) {
+            return;
+        }
+
+        auto q_vec = parse_query(query, 0);
+        if (q_vec.empty()) {
+            return;
+        }
+
+        RangeCollector collector(radius, range_filter, range_search_k);
+        search_with_algo(q_vec, collector, bitset, computer, dim_max_score_ratio, 0, doc_end);
+        collector.collect(ids, distances);
+    }
+
     // Returned distances are inaccurate based on the drop_ratio.
     std::vector<float>
     GetAllDistances(const SparseRow<DType>& query, float drop_ratio_search, const BitsetView& bitset,
@@ -529,20 +1162,27 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
                    const DocValueComputer<float>& computer) const override {
         float distance = 0.0f;
 
+        const auto& dims = dim_map();
         for (size_t i = 0; i < query.size(); ++i) {
             auto [dim, val] = query[i];
-            auto dim_it = dim_map_.find(dim);
-            if (dim_it == dim_map_.cend()) {
+            const auto dim_id = dims.lookup(dim);
+            if (dim_id == DimMap::kNotFound) {
                 continue;
             }
-            auto& plist_ids = inverted_index_ids_[dim_it->second];
-            auto it = std::lower_bound(plist_ids.begin(), plist_ids.end(), vec_id,
-                                       [](const auto& x, table_t y) { return x < y; });
-            if (it != plist_ids.end() && *it == vec_id) {
-                distance +=
-                    val *
-                    computer(inverted_index_vals_[dim_it->second][it - plist_ids.begin()],
-                             metric_type_ == SparseMetricType::METRIC_BM25 ? bm25_params_->row_sums.at(vec_id) : 0);
+            int64_t pos = -1;
+            if (!compressed_ids_.empty()) {
+                pos = compressed_ids_[dim_id].find(vec_id);
+            } else {
+                const auto& plist_ids = inverted_index_ids_[dim_id];
+                const size_t n = plist_ids.size();
+                const table_t* ids = plist_ids.data();
+                auto it = std::lower_bound(ids, ids + n, vec_id, [](const auto& x, table_t y) { return x < y; });
+                if (it != ids + n && *it == vec_id) {
+                    pos = it - ids;
+                }
+            }
+            if (pos != -1) {
+                distance += val * doc_score(computer, inverted_index_vals_[dim_id][pos], doc_len(vec_id));
             }
         }
 
@@ -552,11 +1192,10 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
     [[nodiscard]] size_t
     size() const override {
         size_t res = sizeof(*this);
-        res += dim_map_.size() *
-               (sizeof(typename decltype(dim_map_)::key_type) + sizeof(typename decltype(dim_map_)::mapped_type));
+        res += dim_map().size_in_bytes();
 
         if constexpr (mmapped) {
-            return res + map_byte_size_;
+            return res + map_byte_size_ + direct_byte_size_;
         } else {
             res += sizeof(typename decltype(inverted_index_ids_)::value_type) * inverted_index_ids_.capacity();
             for (size_t i = 0; i < inverted_index_ids_.size(); ++i) {
@@ -568,9 +1207,18 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
                 res += sizeof(typename decltype(inverted_index_vals_)::value_type::value_type) *
                        inverted_index_vals_[i].capacity();
             }
-            if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
+            if constexpr (UseDimMaxScore(algo)) {
                 res += sizeof(typename decltype(max_score_in_dim_)::value_type) * max_score_in_dim_.capacity();
             }
+            if constexpr (UseBlockMaxScore(algo)) {
+                res += sizeof(typename decltype(block_max_scores_)::value_type) * block_max_scores_.capacity();
+                for (size_t i = 0; i < block_max_scores_.size(); ++i) {
+                    res += sizeof(float) * block_max_scores_[i].capacity();
+                }
+            }
+            for (const auto& compressed : compressed_ids_) {
+                res += compressed.byte_size();
+            }
             return res;
         }
     }
@@ -585,6 +1233,22 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         return max_dim_;
     }
 
+    [[nodiscard]] bool
+    references_loaded_data() const override {
+        return direct_data_ != nullptr;
+    }
+
+    [[nodiscard]] std::vector<MappedRegion>
+    mapped_regions() const override {
+        // the map of the direct layout holds copies only, not backed by a file
+        if constexpr (mmapped) {
+            if (map_ != nullptr && !direct_layout_) {
+                return {MappedRegion{map_, map_byte_size_, true}};
+            }
+        }
+        return {};
+    }
+
  private:
     // Given a vector of values, returns the threshold value.
     // All values strictly smaller than the threshold will be ignored.
@@ -602,19 +1266,147 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         return *pos;
     }
 
+    // runs func(begin, end) on ranges of [0, n_dims), concurrently on the build pool
+    template <typename Func>
+    static void
+    parallel_for_dims(size_t n_dims, Func&& func) {
+        constexpr size_t kDimsPerTask = 4096;
+        auto pool = NestedBuildThreadPool();
+        std::vector<folly::Future<folly::Unit>> futures;
+        for (size_t begin = 0; begin < n_dims; begin += kDimsPerTask) {
+            const size_t end = std::min(n_dims, begin + kDimsPerTask);
+            futures.emplace_back(pool.push([&func, begin, end]() { func(begin, end); }));
+        }
+        WaitAllSuccess(futures);
+    }
+
+    // the max score of the postings of dim_id, block_max receives the max score of each of their blocks
+    float
+    plist_max_scores(size_t dim_id, float* block_max, std::vector<table_t>& buffer) const {
+        const table_t* ids = get_plist_ids(dim_id, buffer);
+        const auto& vals = inverted_index_vals_[dim_id];
+        float max_score = 0;
+        std::fill(block_max, block_max + num_blocks(get_plist_size(dim_id)), 0.0f);
+        for (size_t j = 0; j < get_plist_size(dim_id); ++j) {
+            auto score = static_cast<float>(vals[j]);
+            if constexpr (kBM25Impacts) {
+                score = vals[j] * bm25_params_->impact_scale;
+            } else if (metric_type_ == SparseMetricType::METRIC_BM25) {
+                score = bm25_params_->max_score_computer(vals[j], bm25_params_->row_sums[ids[j]]);
+            }
+            max_score = std::max(max_score, score);
+            block_max[j / kPostingBlockSize] = std::max(block_max[j / kPostingBlockSize], score);
+        }
+        return max_score;
+    }
+
+    static inline size_t
+    num_blocks(size_t plist_size) {
+        return (plist_size + kPostingBlockSize - 1) / kPostingBlockSize;
+    }
+
+    [[nodiscard]] size_t
+    get_plist_size(size_t dim_id) const {
+        return compressed_ids_.empty() ? inverted_index_ids_[dim_id].size() : compressed_ids_[dim_id].size();
+    }
+
+    // the ids of the posting list of dim_id, decoded into buffer if they are compressed
+    const table_t*
+    get_plist_ids(size_t dim_id, std::vector<table_t>& buffer) const {
+        if (compressed_ids_.empty()) {
+            return inverted_index_ids_[dim_id].data();
+        }
+        buffer.resize(compressed_ids_[dim_id].size());
+        compressed_ids_[dim_id].decode(buffer.data());
+        return buffer.data();
+    }
+
+    const CompressedPostingIds*
+    get_compressed_plist_ids(size_t dim_id) const {
+        return compressed_ids_.empty() ? nullptr : &compressed_ids_[dim_id];
+    }
+
+    // the position of the first id of the posting list of dim_id that is not less than id
+    size_t
+    plist_lower_bound(size_t dim_id, table_t id) const {
+        if (!compressed_ids_.empty()) {
+            return compressed_ids_[dim_id].lower_bound(id);
+        }
+        // the size is loaded before the data, which holds at least as many ids in concurrent mode
+        const auto& plist_ids = inverted_index_ids_[dim_id];
+        const size_t n = plist_ids.size();
+        const table_t* ids = plist_ids.data();
+        return std::lower_bound(ids, ids + n, id) - ids;
+    }
+
+    void
+    compress_plist_ids() {
+        compressed_ids_.resize(inverted_index_ids_.size());
+        for (size_t i = 0; i < inverted_index_ids_.size(); ++i) {
+            compressed_ids_[i] = CompressedPostingIds(inverted_index_ids_[i].data(), inverted_index_ids_[i].size());
+            std::vector<table_t>().swap(inverted_index_ids_[i]);
+        }
+    }
+
+    void
+    decompress_plist_ids() {
+        for (size_t i = 0; i < inverted_index_ids_.size(); ++i) {
+            inverted_index_ids_[i].resize(compressed_ids_[i].size());
+            compressed_ids_[i].decode(inverted_index_ids_[i].data());
+        }
+        compressed_ids_.clear();
+    }
+
+    // adds the scores of the docs in [begin, end) to scores, which holds the scores of the range only. locs are
+    // the positions in the posting lists of q_vec, they are moved past the docs of the range.
+    void
+    accumulate_range_scores(const std::vector<std::pair<size_t, DType>>& q_vec, std::vector<size_t>& locs,
+                            size_t begin, size_t end, float* scores, const DocValueComputer<float>& computer) const {
+        table_t block_ids[kPostingBlockSize];
+        for (size_t i = 0; i < q_vec.size(); ++i) {
+            const auto& plist_vals = inverted_index_vals_[q_vec[i].first];
+            // returns the number of postings that are in the range
+            auto add_scores = [&](const table_t* ids, size_t n, const QType* vals) {
+                size_t j = 0;
+                for (; j < n && ids[j] < end; ++j) {
+                    auto doc_id = ids[j];
+                    scores[doc_id - begin] += q_vec[i].second * doc_score(computer, vals[j], doc_len(doc_id));
+                }
+                return j;
+            };
+            size_t& loc = locs[i];
+            if (compressed_ids_.empty()) {
+                // the ids are appended before the vals, both hold at least n postings
+                const size_t n = plist_vals.size();
+                const auto& plist_ids = inverted_index_ids_[q_vec[i].first];
+                loc += add_scores(plist_ids.data() + loc, n - loc, plist_vals.data() + loc);
+                continue;
+            }
+            // the block that crosses the end of the range is decoded again for the next range
+            const auto& compressed = compressed_ids_[q_vec[i].first];
+            while (loc < compressed.size()) {
+                const size_t offset = loc % kPostingBlockSize;
+                const size_t n = compressed.decode_block(loc / kPostingBlockSize, block_ids);
+                const size_t added = add_scores(block_ids + offset, n - offset, plist_vals.data() + loc);
+                loc += added;
+                if (offset + added < n) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // the scores are accumulated range by range, so that a range stays in cache while all the posting lists are
+    // scattered into it.
     std::vector<float>
     compute_all_distances(const std::vector<std::pair<size_t, DType>>& q_vec,
                           const DocValueComputer<float>& computer) const {
-        std::vector<float> scores(n_rows_internal_, 0.0f);
-        for (size_t i = 0; i < q_vec.size(); ++i) {
-            auto& plist_ids = inverted_index_ids_[q_vec[i].first];
-            auto& plist_vals = inverted_index_vals_[q_vec[i].first];
-            // TODO: improve with SIMD
-            for (size_t j = 0; j < plist_ids.size(); ++j) {
-                auto doc_id = plist_ids[j];
-                float val_sum = metric_type_ == SparseMetricType::METRIC_BM25 ? bm25_params_->row_sums.at(doc_id) : 0;
-                scores[doc_id] += q_vec[i].second * computer(plist_vals[j], val_sum);
-            }
+        const size_t n_rows = n_rows_internal_;
+        std::vector<float> scores(n_rows, 0.0f);
+        std::vector<size_t> locs(q_vec.size(), 0);
+        for (size_t begin = 0; begin < n_rows; begin += kTaatRangeSize) {
+            const size_t end = std::min(begin + kTaatRangeSize, n_rows);
+            accumulate_range_scores(q_vec, locs, begin, end, scores.data() + begin, computer);
         }
         return scores;
     }
@@ -622,15 +1414,21 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
     template <typename DocIdFilter>
     struct Cursor {
      public:
+        // compressed_ids replaces plist_ids if the ids are compressed, block_max_scores and block_score_ratio are
+        // only used by the block-max algorithms
         Cursor(const Vector<table_t>& plist_ids, const Vector<QType>& plist_vals, size_t num_vec, float max_score,
-               float q_value, DocIdFilter filter)
+               float q_value, DocIdFilter filter, const CompressedPostingIds* compressed_ids = nullptr,
+               const Vector<float>* block_max_scores = nullptr, float block_score_ratio = 0.0f)
             : plist_ids_(plist_ids),
               plist_vals_(plist_vals),
-              plist_size_(plist_ids.size()),
+              plist_size_(compressed_ids != nullptr ? compressed_ids->size() : visible_plist_size(plist_ids, num_vec)),
               total_num_vec_(num_vec),
               max_score_(max_score),
               q_value_(q_value),
-              filter_(filter) {
+              filter_(filter),
+              compressed_ids_(compressed_ids),
+              block_max_scores_(block_max_scores),
+              block_score_ratio_(block_score_ratio) {
             skip_filtered_ids();
             update_cur_vec_id();
         }
@@ -646,7 +1444,14 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
 
         void
         seek(table_t vec_id) {
-            while (loc_ < plist_size_ && plist_ids_[loc_] < vec_id) {
+            if (compressed_ids_ != nullptr) {
+                // skips the blocks that end before vec_id without decoding them
+                size_t block = loc_ / kPostingBlockSize;
+                while (block < compressed_ids_->num_blocks() && compressed_ids_->block_last_id(block) < vec_id) {
+                    loc_ = ++block * kPostingBlockSize;
+                }
+            }
+            while (loc_ < plist_size_ && plist_id(loc_) < vec_id) {
                 ++loc_;
             }
             skip_filtered_ids();
@@ -658,6 +1463,26 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
             return plist_vals_[loc_];
         }
 
+        // moves the current block to the first one that may contain vec_id, without moving the cursor
+        void
+        shallow_seek(table_t vec_id) {
+            size_t n_blocks = num_blocks(plist_size_);
+            while (block_ < n_blocks && block_last_vec_id(block_) < vec_id) {
+                ++block_;
+            }
+        }
+
+        // the largest vec id of the current block, total_num_vec_ if there is no block left
+        table_t
+        cur_block_last_vec_id() const {
+            return block_ < num_blocks(plist_size_) ? block_last_vec_id(block_) : total_num_vec_;
+        }
+
+        float
+        cur_block_max_score() const {
+            return block_ < num_blocks(plist_size_) ? (*block_max_scores_)[block_] * block_score_ratio_ : 0.0f;
+        }
+
         const Vector<table_t>& plist_ids_;
         const Vector<QType>& plist_vals_;
         const size_t plist_size_;
@@ -669,14 +1494,57 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         table_t cur_vec_id_ = 0;
 
      private:
+        // the number of postings with ids below num_vec. The lists of a concurrent index may already hold the
+        // postings of rows that are being added, whose vals and block max scores may not be there yet.
+        static size_t
+        visible_plist_size(const Vector<table_t>& plist_ids, size_t num_vec) {
+            const size_t n = plist_ids.size();
+            const table_t* ids = plist_ids.data();
+            if (n == 0 || ids[n - 1] < num_vec) {
+                return n;
+            }
+            return std::lower_bound(ids, ids + n, num_vec) - ids;
+        }
+
+        const CompressedPostingIds* compressed_ids_ = nullptr;
+        // the ids of the block decoded_block_ of compressed_ids_
+        table_t decoded_ids_[kPostingBlockSize];
+        size_t decoded_block_ = std::numeric_limits<size_t>::max();
+        const Vector<float>* block_max_scores_ = nullptr;
+        float block_score_ratio_ = 0.0f;
+        size_t block_ = 0;
+
+        inline table_t
+        block_last_vec_id(size_t block) const {
+            if (compressed_ids_ != nullptr) {
+                return compressed_ids_->block_last_id(block);
+            }
+            return plist_ids_[std::min((block + 1) * kPostingBlockSize, plist_size_) - 1];
+        }
+
+        inline table_t
+        plist_id(size_t loc) {
+            if (compressed_ids_ == nullptr) {
+                return plist_ids_[loc];
+            }
+            size_t block = loc / kPostingBlockSize;
+            if (block != decoded_block_) {
+                compressed_ids_->decode_block(block, decoded_ids_);
+                decoded_block_ = block;
+            }
+            return decoded_ids_[loc % kPostingBlockSize];
+        }
+
+        // the ids from total_num_vec_ on are out of the searched range, the cursor ends there
         inline void
         update_cur_vec_id() {
-            cur_vec_id_ = (loc_ >= plist_size_) ? total_num_vec_ : plist_ids_[loc_];
+            cur_vec_id_ = (loc_ >= plist_size_) ? total_num_vec_ : std::min<table_t>(plist_id(loc_), total_num_vec_);
         }
 
         inline void
         skip_filtered_ids() {
-            while (loc_ < plist_size_ && !filter_.empty() && filter_.test(plist_ids_[loc_])) {
+            while (loc_ < plist_size_ && !filter_.empty() && plist_id(loc_) < total_num_vec_ &&
+                   filter_.test(plist_id(loc_))) {
                 ++loc_;
             }
         }
@@ -694,30 +1562,52 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         }
 
         std::vector<std::pair<size_t, DType>> filtered_query;
+        const auto& dims = dim_map();
         for (size_t i = 0; i < query.size(); ++i) {
             auto [dim, val] = query[i];
-            auto dim_it = dim_map_.find(dim);
-            if (dim_it == dim_map_.cend() || std::abs(val) < q_threshold) {
+            const auto dim_id = dims.lookup(dim);
+            if (dim_id == DimMap::kNotFound || std::abs(val) < q_threshold) {
                 continue;
             }
-            filtered_query.emplace_back(dim_it->second, val);
+            filtered_query.emplace_back(dim_id, val);
         }
 
         return filtered_query;
     }
 
+    // the posting lists of the query and their postings, which the pruning algorithms score only a part of
+    void
+    add_query_stats(const std::vector<std::pair<size_t, DType>>& q_vec, size_t k,
+                    const InvertedIndexApproxSearchParams& approx_params, SearchStats& stats) const {
+        stats.nlist += q_vec.size();
+        for (const auto& term : q_vec) {
+            stats.ndis += get_plist_size(term.first);
+        }
+        if (approx_params.refine_factor > 1) {
+            stats.nrefine += k * approx_params.refine_factor;
+        }
+    }
+
     template <typename DocIdFilter>
     std::vector<Cursor<DocIdFilter>>
     make_cursors(const std::vector<std::pair<size_t, DType>>& q_vec, const DocValueComputer<float>& computer,
-                 DocIdFilter& filter, float dim_max_score_ratio) const {
+                 DocIdFilter& filter, float dim_max_score_ratio, size_t doc_begin, size_t doc_end) const {
         std::vector<Cursor<DocIdFilter>> cursors;
         cursors.reserve(q_vec.size());
         for (auto q_dim : q_vec) {
             auto& plist_ids = inverted_index_ids_[q_dim.first];
             auto& plist_vals = inverted_index_vals_[q_dim.first];
-            cursors.emplace_back(plist_ids, plist_vals, n_rows_internal_,
+            const Vector<float>* block_max_scores = nullptr;
+            if constexpr (UseBlockMaxScore(algo)) {
+                block_max_scores = &block_max_scores_[q_dim.first];
+            }
+            cursors.emplace_back(plist_ids, plist_vals, doc_end,
                                  max_score_in_dim_[q_dim.first] * q_dim.second * dim_max_score_ratio, q_dim.second,
-                                 filter);
+                                 filter, get_compressed_plist_ids(q_dim.first), block_max_scores,
+                                 q_dim.second * dim_max_score_ratio);
+            if (doc_begin > 0) {
+                cursors.back().seek(doc_begin);
+            }
         }
         return cursors;
     }
@@ -725,23 +1615,36 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
     // find the top-k candidates using brute force search, k as specified by the capacity of the heap.
     // any value in q_vec that is smaller than q_threshold and any value with dimension >= n_cols() will be ignored.
     // TODO: may switch to row-wise brute force if filter rate is high. Benchmark needed.
-    template <typename DocIdFilter>
+    // the scores are accumulated into a buffer of kTaatRangeSize docs, which is pushed to the heap and cleared
+    // range by range.
+    template <typename DocIdFilter, typename HeapType>
     void
-    search_taat_naive(const std::vector<std::pair<size_t, DType>>& q_vec, MaxMinHeap<float>& heap, DocIdFilter& filter,
-                      const DocValueComputer<float>& computer) const {
-        auto scores = compute_all_distances(q_vec, computer);
-        for (size_t i = 0; i < n_rows_internal_; ++i) {
-            if ((filter.empty() || !filter.test(i)) && scores[i] != 0) {
-                heap.push(i, scores[i]);
+    search_taat_naive(const std::vector<std::pair<size_t, DType>>& q_vec, HeapType& heap, DocIdFilter& filter,
+                      const DocValueComputer<float>& computer, size_t doc_begin, size_t doc_end) const {
+        std::vector<float> scores(std::min(kTaatRangeSize, doc_end - doc_begin));
+        std::vector<size_t> locs(q_vec.size(), 0);
+        for (size_t i = 0; doc_begin > 0 && i < q_vec.size(); ++i) {
+            locs[i] = plist_lower_bound(q_vec[i].first, doc_begin);
+        }
+        for (size_t begin = doc_begin; begin < doc_end; begin += kTaatRangeSize) {
+            const size_t end = std::min(begin + kTaatRangeSize, doc_end);
+            std::fill(scores.begin(), scores.begin() + (end - begin), 0.0f);
+            accumulate_range_scores(q_vec, locs, begin, end, scores.data(), computer);
+            for (size_t i = begin; i < end; ++i) {
+                if (scores[i - begin] != 0 && (filter.empty() || !filter.test(i))) {
+                    heap.push(i, scores[i - begin]);
+                }
             }
         }
     }
 
-    template <typename DocIdFilter>
+    template <typename DocIdFilter, typename HeapType>
     void
-    search_daat_wand(const std::vector<std::pair<size_t, DType>>& q_vec, MaxMinHeap<float>& heap, DocIdFilter& filter,
-                     const DocValueComputer<float>& computer, float dim_max_score_ratio) const {
-        std::vector<Cursor<DocIdFilter>> cursors = make_cursors(q_vec, computer, filter, dim_max_score_ratio);
+    search_daat_wand(const std::vector<std::pair<size_t, DType>>& q_vec, HeapType& heap, DocIdFilter& filter,
+                     const DocValueComputer<float>& computer, float dim_max_score_ratio, size_t doc_begin,
+                     size_t doc_end) const {
+        std::vector<Cursor<DocIdFilter>> cursors =
+            make_cursors(q_vec, computer, filter, dim_max_score_ratio, doc_begin, doc_end);
         std::vector<Cursor<DocIdFilter>*> cursor_ptrs(cursors.size());
         for (size_t i = 0; i < cursors.size(); ++i) {
             cursor_ptrs[i] = &cursors[i];
@@ -760,7 +1663,7 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
 
             bool found_pivot = false;
             for (pivot = 0; pivot < q_vec.size(); ++pivot) {
-                if (cursor_ptrs[pivot]->cur_vec_id_ >= n_rows_internal_) {
+                if (cursor_ptrs[pivot]->cur_vec_id_ >= doc_end) {
                     break;
                 }
                 upper_bound += cursor_ptrs[pivot]->max_score_;
@@ -776,13 +1679,12 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
             table_t pivot_id = cursor_ptrs[pivot]->cur_vec_id_;
             if (pivot_id == cursor_ptrs[0]->cur_vec_id_) {
                 float score = 0;
-                float cur_vec_sum =
-                    metric_type_ == SparseMetricType::METRIC_BM25 ? bm25_params_->row_sums.at(pivot_id) : 0;
+                float cur_vec_sum = doc_len(pivot_id);
                 for (auto& cursor_ptr : cursor_ptrs) {
                     if (cursor_ptr->cur_vec_id_ != pivot_id) {
                         break;
                     }
-                    score += cursor_ptr->q_value_ * computer(cursor_ptr->cur_vec_val(), cur_vec_sum);
+                    score += cursor_ptr->q_value_ * doc_score(computer, cursor_ptr->cur_vec_val(), cur_vec_sum);
                     cursor_ptr->next();
                 }
                 heap.push(pivot_id, score);
@@ -802,15 +1704,17 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         }
     }
 
-    template <typename DocIdFilter>
+    template <typename DocIdFilter, typename HeapType>
     void
-    search_daat_maxscore(std::vector<std::pair<size_t, DType>>& q_vec, MaxMinHeap<float>& heap, DocIdFilter& filter,
-                         const DocValueComputer<float>& computer, float dim_max_score_ratio) const {
+    search_daat_maxscore(std::vector<std::pair<size_t, DType>>& q_vec, HeapType& heap, DocIdFilter& filter,
+                         const DocValueComputer<float>& computer, float dim_max_score_ratio, size_t doc_begin,
+                         size_t doc_end) const {
         std::sort(q_vec.begin(), q_vec.end(), [this](auto& a, auto& b) {
             return a.second * max_score_in_dim_[a.first] > b.second * max_score_in_dim_[b.first];
         });
 
-        std::vector<Cursor<DocIdFilter>> cursors = make_cursors(q_vec, computer, filter, dim_max_score_ratio);
+        std::vector<Cursor<DocIdFilter>> cursors =
+            make_cursors(q_vec, computer, filter, dim_max_score_ratio, doc_begin, doc_end);
 
         float threshold = heap.full() ? heap.top().val : 0;
 
@@ -821,7 +1725,7 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
             upper_bounds[i] = bound_sum;
         }
 
-        table_t next_cand_vec_id = n_rows_internal_;
+        table_t next_cand_vec_id = doc_end;
         for (size_t i = 0; i < cursors.size(); ++i) {
             if (cursors[i].cur_vec_id_ < next_cand_vec_id) {
                 next_cand_vec_id = cursors[i].cur_vec_id_;
@@ -841,24 +1745,24 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         float curr_cand_score = 0.0f;
         table_t curr_cand_vec_id = 0;
 
-        while (curr_cand_vec_id < n_rows_internal_) {
+        while (curr_cand_vec_id < doc_end) {
             auto found_cand = false;
             while (found_cand == false) {
                 // start find from next_vec_id
-                if (next_cand_vec_id >= n_rows_internal_) {
+                if (next_cand_vec_id >= doc_end) {
                     return;
                 }
                 // get current candidate vector
                 curr_cand_vec_id = next_cand_vec_id;
                 curr_cand_score = 0.0f;
                 // update next_cand_vec_id
-                next_cand_vec_id = n_rows_internal_;
-                float cur_vec_sum =
-                    metric_type_ == SparseMetricType::METRIC_BM25 ? bm25_params_->row_sums.at(curr_cand_vec_id) : 0;
+                next_cand_vec_id = doc_end;
+                float cur_vec_sum = doc_len(curr_cand_vec_id);
 
                 for (size_t i = 0; i < first_ne_idx; ++i) {
                     if (cursors[i].cur_vec_id_ == curr_cand_vec_id) {
-                        curr_cand_score += cursors[i].q_value_ * computer(cursors[i].cur_vec_val(), cur_vec_sum);
+                        curr_cand_score +=
+                            cursors[i].q_value_ * doc_score(computer, cursors[i].cur_vec_val(), cur_vec_sum);
                         cursors[i].next();
                     }
                     if (cursors[i].cur_vec_id_ < next_cand_vec_id) {
@@ -874,7 +1778,8 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
                     }
                     cursors[i].seek(curr_cand_vec_id);
                     if (cursors[i].cur_vec_id_ == curr_cand_vec_id) {
-                        curr_cand_score += cursors[i].q_value_ * computer(cursors[i].cur_vec_val(), cur_vec_sum);
+                        curr_cand_score +=
+                            cursors[i].q_value_ * doc_score(computer, cursors[i].cur_vec_val(), cur_vec_sum);
                     }
                 }
             }
@@ -892,10 +1797,276 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         }
     }
 
+    // Block-Max WAND (Ding and Suel, 2011). A pivot found with the max scores of the dimensions is only evaluated if
+    // the max scores of the posting blocks it falls into can still beat the threshold, otherwise all the vectors up
+    // to the end of the shallowest of these blocks are skipped at once.
+    template <typename DocIdFilter, typename HeapType>
+    void
+    search_daat_block_max_wand(const std::vector<std::pair<size_t, DType>>& q_vec, HeapType& heap,
+                               DocIdFilter& filter, const DocValueComputer<float>& computer,
+                               float dim_max_score_ratio, size_t doc_begin, size_t doc_end) const {
+        std::vector<Cursor<DocIdFilter>> cursors =
+            make_cursors(q_vec, computer, filter, dim_max_score_ratio, doc_begin, doc_end);
+        std::vector<Cursor<DocIdFilter>*> cursor_ptrs(cursors.size());
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            cursor_ptrs[i] = &cursors[i];
+        }
+
+        auto sort_cursors = [&cursor_ptrs] {
+            std::sort(cursor_ptrs.begin(), cursor_ptrs.end(),
+                      [](auto& x, auto& y) { return x->cur_vec_id_ < y->cur_vec_id_; });
+        };
+        // restores the order after cursor_ptrs[i] moved forward
+        auto bubble_down = [&cursor_ptrs](size_t i) {
+            for (; i + 1 < cursor_ptrs.size(); ++i) {
+                if (cursor_ptrs[i + 1]->cur_vec_id_ >= cursor_ptrs[i]->cur_vec_id_) {
+                    break;
+                }
+                std::swap(cursor_ptrs[i], cursor_ptrs[i + 1]);
+            }
+        };
+        sort_cursors();
+
+        while (true) {
+            float threshold = heap.full() ? heap.top().val : 0;
+            float upper_bound = 0;
+            size_t pivot;
+
+            bool found_pivot = false;
+            for (pivot = 0; pivot < q_vec.size(); ++pivot) {
+                if (cursor_ptrs[pivot]->cur_vec_id_ >= doc_end) {
+                    break;
+                }
+                upper_bound += cursor_ptrs[pivot]->max_score_;
+                if (upper_bound > threshold) {
+                    found_pivot = true;
+                    break;
+                }
+            }
+            if (!found_pivot) {
+                break;
+            }
+
+            table_t pivot_id = cursor_ptrs[pivot]->cur_vec_id_;
+            // the cursors on the pivot right after it contribute to its score as well
+            while (pivot + 1 < q_vec.size() && cursor_ptrs[pivot + 1]->cur_vec_id_ == pivot_id) {
+                ++pivot;
+            }
+
+            float block_upper_bound = 0;
+            for (size_t i = 0; i <= pivot; ++i) {
+                cursor_ptrs[i]->shallow_seek(pivot_id);
+                block_upper_bound += cursor_ptrs[i]->cur_block_max_score();
+            }
+
+            if (block_upper_bound > threshold) {
+                if (pivot_id == cursor_ptrs[0]->cur_vec_id_) {
+                    float score = 0;
+                    float cur_vec_sum = doc_len(pivot_id);
+                    for (auto& cursor_ptr : cursor_ptrs) {
+                        if (cursor_ptr->cur_vec_id_ != pivot_id) {
+                            break;
+                        }
+                        score += cursor_ptr->q_value_ * doc_score(computer, cursor_ptr->cur_vec_val(), cur_vec_sum);
+                        cursor_ptr->next();
+                    }
+                    heap.push(pivot_id, score);
+                    sort_cursors();
+                } else {
+                    size_t next_list = pivot;
+                    for (; cursor_ptrs[next_list]->cur_vec_id_ == pivot_id; --next_list) {
+                    }
+                    cursor_ptrs[next_list]->seek(pivot_id);
+                    bubble_down(next_list);
+                }
+            } else {
+                // no vector before the end of the current blocks, nor before the next cursor, can enter the heap
+                table_t next_vec_id = doc_end;
+                size_t next_list = 0;
+                for (size_t i = 0; i <= pivot; ++i) {
+                    next_vec_id = std::min<table_t>(next_vec_id, cursor_ptrs[i]->cur_block_last_vec_id() + 1);
+                    if (cursor_ptrs[i]->max_score_ > cursor_ptrs[next_list]->max_score_) {
+                        next_list = i;
+                    }
+                }
+                if (pivot + 1 < q_vec.size()) {
+                    next_vec_id = std::min(next_vec_id, cursor_ptrs[pivot + 1]->cur_vec_id_);
+                }
+                next_vec_id = std::max<table_t>(next_vec_id, pivot_id + 1);
+                cursor_ptrs[next_list]->seek(next_vec_id);
+                bubble_down(next_list);
+            }
+        }
+    }
+
+    // Score-at-a-time search of the top-k candidates, k as given: the blocks of postings of the query dims in the
+    // doc range are scored in the decreasing order of their bounds, their block max scores times the query values,
+    // into a partial score per doc. The remaining bound, the sum over the dims of the bounds of their next blocks,
+    // caps what any doc can still gain, so the top-k is exact once the k-th best partial score is at least the
+    // (k + 1)-th one plus the remaining bound, checked after geometrically growing numbers of postings. The search
+    // also stops when the posting or time budget of approx_params runs out, the top-k partial scores are then
+    // rescored exactly. Returns whether a budget stopped the search before its top-k was exact.
+    template <typename HeapType>
+    bool
+    search_saat_anytime(const std::vector<std::pair<size_t, DType>>& q_vec, HeapType& heap, size_t k,
+                        const BitsetView& filter, const DocValueComputer<float>& computer,
+                        const InvertedIndexApproxSearchParams& approx_params, size_t doc_begin, size_t doc_end) const {
+        if (k == 0) {
+            return false;
+        }
+        using Clock = std::chrono::steady_clock;
+        const auto deadline =
+            Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<float, std::milli>(approx_params.time_budget_ms));
+
+        // the blocks of each dim, clipped to the doc range and sorted by decreasing bound
+        struct Segment {
+            float bound;
+            uint32_t begin;
+            uint32_t end;
+        };
+        std::vector<std::vector<table_t>> buffers(q_vec.size());
+        std::vector<const table_t*> dim_ids(q_vec.size());
+        std::vector<size_t> dim_sizes(q_vec.size());
+        std::vector<std::vector<Segment>> segments(q_vec.size());
+        std::vector<size_t> next_segment(q_vec.size(), 0);
+        // the dims by the bound of their next segment
+        std::priority_queue<std::pair<float, size_t>> next_dims;
+        for (size_t i = 0; i < q_vec.size(); ++i) {
+            const auto [dim_id, q_val] = q_vec[i];
+            const size_t n = get_plist_size(dim_id);
+            const table_t* ids = get_plist_ids(dim_id, buffers[i]);
+            dim_ids[i] = ids;
+            dim_sizes[i] = n;
+            const size_t lo = doc_begin > 0 ? std::lower_bound(ids, ids + n, doc_begin) - ids : 0;
+            const size_t hi = std::lower_bound(ids + lo, ids + n, doc_end) - ids;
+            const auto& block_max = block_max_scores_[dim_id];
+            for (size_t b = lo / kPostingBlockSize; b * kPostingBlockSize < hi; ++b) {
+                // the postings added after the block max scores were read are bounded by the max score of the dim
+                const float block_score = b < block_max.size() ? block_max[b] : max_score_in_dim_[dim_id];
+                segments[i].push_back({block_score * q_val * approx_params.dim_max_score_ratio,
+                                       static_cast<uint32_t>(std::max(lo, b * kPostingBlockSize)),
+                                       static_cast<uint32_t>(std::min(hi, (b + 1) * kPostingBlockSize))});
+            }
+            std::sort(segments[i].begin(), segments[i].end(),
+                      [](const Segment& a, const Segment& b) { return a.bound > b.bound; });
+            if (!segments[i].empty()) {
+                next_dims.emplace(segments[i][0].bound, i);
+            }
+        }
+
+        // the partial scores are kept in an array over the doc range if it is small, in a hash map otherwise
+        const size_t range_size = doc_end - doc_begin;
+        const bool dense = range_size <= kTaatRangeSize * 16;
+        std::vector<float> dense_scores(dense ? range_size : 0, 0.0f);
+        std::vector<uint8_t> seen(dense ? range_size : 0, 0);
+        std::unordered_map<table_t, float> sparse_scores;
+        std::vector<table_t> candidates;
+        auto score_of = [&](table_t doc) -> float& {
+            if (dense) {
+                if (!seen[doc - doc_begin]) {
+                    seen[doc - doc_begin] = 1;
+                    candidates.push_back(doc);
+                }
+                return dense_scores[doc - doc_begin];
+            }
+            auto [it, inserted] = sparse_scores.try_emplace(doc, 0.0f);
+            if (inserted) {
+                candidates.push_back(doc);
+            }
+            return it->second;
+        };
+        // the candidates in decreasing order of partial score up to the (k + 1)-th one
+        std::vector<std::pair<float, table_t>> ranked;
+        auto rank_candidates = [&](size_t n) {
+            ranked.clear();
+            for (auto doc : candidates) {
+                ranked.emplace_back(score_of(doc), doc);
+            }
+            n = std::min(n, ranked.size());
+            std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(), std::greater<>());
+            ranked.resize(n);
+        };
+        auto top_k_is_exact = [&]() {
+            float remaining_bound = 0;
+            for (size_t i = 0; i < q_vec.size(); ++i) {
+                if (next_segment[i] < segments[i].size()) {
+                    remaining_bound += segments[i][next_segment[i]].bound;
+                }
+            }
+            if (candidates.size() < k) {
+                return false;
+            }
+            rank_candidates(k + 1);
+            const float next_score = ranked.size() > k ? ranked[k].first : 0.0f;
+            return ranked[k - 1].first >= next_score + remaining_bound;
+        };
+
+        const int64_t posting_budget = approx_params.posting_budget;
+        int64_t n_scored = 0;
+        int64_t next_check = 2 * kPostingBlockSize;
+        bool budget_exhausted = false;
+        while (!next_dims.empty()) {
+            const size_t i = next_dims.top().second;
+            next_dims.pop();
+            const auto [dim_id, q_val] = q_vec[i];
+            const Segment& segment = segments[i][next_segment[i]++];
+            const auto& vals = inverted_index_vals_[dim_id];
+            for (uint32_t j = segment.begin; j < segment.end; ++j) {
+                const table_t doc = dim_ids[i][j];
+                if (filter.empty() || !filter.test(doc)) {
+                    score_of(doc) += q_val * doc_score(computer, vals[j], doc_len(doc));
+                }
+            }
+            n_scored += segment.end - segment.begin;
+            if (next_segment[i] < segments[i].size()) {
+                next_dims.emplace(segments[i][next_segment[i]].bound, i);
+            }
+            if (next_dims.empty()) {
+                break;
+            }
+            if (n_scored >= next_check) {
+                next_check *= 2;
+                if (top_k_is_exact()) {
+                    break;
+                }
+            }
+            if ((posting_budget > 0 && n_scored >= posting_budget) ||
+                (approx_params.time_budget_ms > 0 && Clock::now() >= deadline)) {
+                budget_exhausted = !top_k_is_exact();
+                break;
+            }
+        }
+
+        rank_candidates(k);
+        if (next_dims.empty()) {
+            // every posting is scored, the partial scores are the exact ones
+            for (const auto& [score, doc] : ranked) {
+                heap.push(doc, score);
+            }
+            return false;
+        }
+        for (const auto& candidate : ranked) {
+            const table_t doc = candidate.second;
+            float score = 0.0f;
+            const float len = doc_len(doc);
+            for (size_t i = 0; i < q_vec.size(); ++i) {
+                const table_t* end = dim_ids[i] + dim_sizes[i];
+                const table_t* it = std::lower_bound(dim_ids[i], end, doc);
+                if (it != end && *it == doc) {
+                    const auto& vals = inverted_index_vals_[q_vec[i].first];
+                    score += q_vec[i].second * doc_score(computer, vals[it - dim_ids[i]], len);
+                }
+            }
+            heap.push(doc, score);
+        }
+        return budget_exhausted;
+    }
+
     void
     refine_and_collect(const SparseRow<DType>& query, MaxMinHeap<float>& inacc_heap, size_t k, float* distances,
                        label_t* labels, const DocValueComputer<float>& computer,
-                       InvertedIndexApproxSearchParams& approx_params) const {
+                       InvertedIndexApproxSearchParams& approx_params, size_t doc_begin, size_t doc_end) const {
         std::vector<table_t> docids;
         MaxMinHeap<float> heap(k);
 
@@ -914,16 +2085,90 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         float dim_max_score_ratio = std::max(approx_params.dim_max_score_ratio, 1.0f);
 
         DocIdFilterByVector filter(std::move(docids));
+        search_with_algo(q_vec, heap, filter, computer, dim_max_score_ratio, doc_begin, doc_end);
+        collect_result(heap, distances, labels);
+    }
+
+    // DAAT_WAND and DAAT_MAXSCORE are based on the implementation in PISA.
+    template <typename DocIdFilter, typename HeapType>
+    void
+    search_with_algo(std::vector<std::pair<size_t, DType>>& q_vec, HeapType& heap, DocIdFilter& filter,
+                     const DocValueComputer<float>& computer, float dim_max_score_ratio, size_t doc_begin,
+                     size_t doc_end) const {
         if constexpr (algo == InvertedIndexAlgo::DAAT_WAND) {
-            search_daat_wand(q_vec, heap, filter, computer, dim_max_score_ratio);
+            search_daat_wand(q_vec, heap, filter, computer, dim_max_score_ratio, doc_begin, doc_end);
         } else if constexpr (algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
-            search_daat_maxscore(q_vec, heap, filter, computer, dim_max_score_ratio);
+            search_daat_maxscore(q_vec, heap, filter, computer, dim_max_score_ratio, doc_begin, doc_end);
+        } else if constexpr (UseBlockMaxScore(algo)) {
+            // SAAT_ANYTIME searches the top-k with search_saat_anytime(), its exact searches are block-max WAND ones
+            search_daat_block_max_wand(q_vec, heap, filter, computer, dim_max_score_ratio, doc_begin, doc_end);
         } else {
-            search_taat_naive(q_vec, heap, filter, computer);
+            search_taat_naive(q_vec, heap, filter, computer, doc_begin, doc_end);
         }
-        collect_result(heap, distances, labels);
     }
 
+    // Collects the vectors that score above radius and at most range_filter. It stands in for a full heap whose top
+    // is the radius, or the range_search_k-th best score once that many are collected, so that the searches skip the
+    // vectors that can't score above it.
+    class RangeCollector {
+     public:
+        RangeCollector(float radius, float range_filter, int32_t range_search_k)
+            : radius_(radius),
+              range_filter_(range_filter),
+              limited_(range_search_k > 0),
+              heap_(std::max<int32_t>(range_search_k, 0)) {
+        }
+
+        [[nodiscard]] bool
+        full() const {
+            return true;
+        }
+
+        [[nodiscard]] SparseIdVal<float>
+        top() const {
+            if (limited_ && heap_.full()) {
+                return {heap_.top().id, std::max(radius_, heap_.top().val)};
+            }
+            return {0, radius_};
+        }
+
+        void
+        push(table_t id, float val) {
+            if (val <= radius_ || val > range_filter_) {
+                return;
+            }
+            if (limited_) {
+                heap_.push(id, val);
+            } else {
+                results_.emplace_back(id, val);
+            }
+        }
+
+        // best first
+        void
+        collect(std::vector<label_t>& ids, std::vector<float>& distances) {
+            while (!heap_.empty()) {
+                results_.push_back(heap_.top());
+                heap_.pop();
+            }
+            std::sort(results_.begin(), results_.end(),
+                      [](const auto& a, const auto& b) { return a.val > b.val || (a.val == b.val && a.id < b.id); });
+            ids.reserve(results_.size());
+            distances.reserve(results_.size());
+            for (const auto& r : results_) {
+                ids.push_back(r.id);
+                distances.push_back(r.val);
+            }
+        }
+
+     private:
+        float radius_;
+        float range_filter_;
+        bool limited_;
+        MaxMinHeap<float> heap_;
+        std::vector<SparseIdVal<float>> results_;
+    };
+
     template <typename HeapType>
     void
     collect_result(HeapType& heap, float* distances, label_t* labels) const {
@@ -935,12 +2180,261 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
         }
     }
 
+    template <typename, typename, InvertedIndexAlgo, bool, bool>
+    friend class InvertedIndex;
+
+    // the posting lists of other are appended to the ones of the same dims, so they stay sorted by id. The max
+    // scores of the dims are computed again, the blocks of the appended postings don't align with the ones of other.
+    template <bool other_mmapped, bool other_concurrent>
+    Status
+    merge_from(const InvertedIndex<DType, QType, algo, other_mmapped, other_concurrent>& other) {
+        if (other.metric_type_ != metric_type_) {
+            LOG_KNOWHERE_ERROR_ << "can not merge sparse inverted indexes of different metrics";
+            return Status::invalid_metric_type;
+        }
+        // the impacts of other are scored with its own BM25 parameters
+        if (kBM25Impacts && (other.bm25_params_->k1 != bm25_params_->k1 || other.bm25_params_->b != bm25_params_->b ||
+                             other.bm25_params_->avgdl != bm25_params_->avgdl)) {
+            LOG_KNOWHERE_ERROR_ << "can not merge sparse inverted indexes of BM25 impacts with different parameters";
+            return Status::invalid_args;
+        }
+
+        const size_t offset = n_rows_internal_;
+        const size_t other_rows = other.n_rows_internal_;
+        if (!compressed_ids_.empty()) {
+            decompress_plist_ids();
+        }
+        std::vector<uint32_t> merged_dims;
+        std::vector<table_t> buffer;
+        for (const auto& [dim, other_dim_id] : other.dim_map()) {
+            auto dim_it = dim_map_.find(dim);
+            if (dim_it == dim_map_.end()) {
+                dim_it = insert_dim(dim);
+            }
+            const size_t n = other.get_plist_size(other_dim_id);
+            const table_t* ids = other.get_plist_ids(other_dim_id, buffer);
+            const auto& vals = other.inverted_index_vals_[other_dim_id];
+            auto& plist_ids = inverted_index_ids_[dim_it->second];
+            auto& plist_vals = inverted_index_vals_[dim_it->second];
+            plist_ids.reserve(plist_ids.size() + n);
+            plist_vals.reserve(plist_vals.size() + n);
+            for (size_t j = 0; j < n; ++j) {
+                plist_ids.emplace_back(ids[j] + offset);
+                plist_vals.emplace_back(vals[j]);
+            }
+            merged_dims.push_back(dim_it->second);
+        }
+        if (use_row_sums()) {
+            bm25_params_->row_sums.reserve(offset + other_rows);
+            for (size_t i = 0; i < other_rows; ++i) {
+                bm25_params_->row_sums.emplace_back(other.bm25_params_->row_sums[i]);
+            }
+        }
+        if constexpr (UseDimMaxScore(algo)) {
+            std::vector<float> block_max;
+            for (const auto dim_id : merged_dims) {
+                block_max.resize(num_blocks(get_plist_size(dim_id)));
+                max_score_in_dim_[dim_id] = plist_max_scores(dim_id, block_max.data(), buffer);
+                if constexpr (UseBlockMaxScore(algo)) {
+                    block_max_scores_[dim_id].assign(block_max.begin(), block_max.end());
+                }
+            }
+        }
+        max_dim_ = std::max(max_dim_, other.max_dim_);
+        n_rows_internal_ += other_rows;
+        dim_map_.freeze();
+        if (compress_posting_ids_) {
+            compress_plist_ids();
+        }
+        return Status::success;
+    }
+
+    // the doc length of vec_id in the BM25 formula, 0 if it is not needed
+    inline float
+    doc_len(table_t vec_id) const {
+        return use_row_sums() ? bm25_params_->row_sums.at(vec_id) : 0;
+    }
+
+    inline float
+    doc_score(const DocValueComputer<float>& computer, QType val, float doc_len) const {
+        if constexpr (kBM25Impacts) {
+            return val * bm25_params_->impact_scale;
+        } else {
+            return computer(val, doc_len);
+        }
+    }
+
+    // the doc lengths are kept for BM25, unless the postings are impacts already
+    [[nodiscard]] inline bool
+    use_row_sums() const {
+        return metric_type_ == SparseMetricType::METRIC_BM25 && !kBM25Impacts;
+    }
+
+    // the row with the term frequencies replaced by the quantized BM25 impacts, as computed with the build time avgdl
+    SparseRow<DType>
+    to_bm25_impacts(const SparseRow<DType>& row) const {
+        float row_sum = 0;
+        for (size_t j = 0; j < row.size(); ++j) {
+            row_sum += row[j].val;
+        }
+        SparseRow<DType> impacts(row.size());
+        for (size_t j = 0; j < row.size(); ++j) {
+            auto [dim, val] = row[j];
+            float impact = 0;
+            if (val != 0) {
+                // a non-zero term keeps a non-zero impact
+                impact = std::clamp(std::round(bm25_params_->max_score_computer(val, row_sum) /
+                                               bm25_params_->impact_scale),
+                                    1.0f, static_cast<float>(std::numeric_limits<bm25_impact_t>::max()));
+            }
+            impacts.set_at(j, dim, impact);
+        }
+        return impacts;
+    }
+
+    // a dim with empty posting lists, not for the mmapped and concurrent modes
+    typename DimMap::iterator
+    insert_dim(table_t dim) {
+        auto dim_it = dim_map_.insert({dim, next_dim_id_++}).first;
+        inverted_index_ids_.emplace_back();
+        inverted_index_vals_.emplace_back();
+        if constexpr (UseDimMaxScore(algo)) {
+            max_score_in_dim_.emplace_back(0.0f);
+        }
+        if constexpr (UseBlockMaxScore(algo)) {
+            block_max_scores_.emplace_back();
+        }
+        return dim_it;
+    }
+
+    // the postings of a range of rows, in local lists in the order of the first occurrence of their dims
+    struct PostingShard {
+        std::unordered_map<table_t, uint32_t> local_ids;
+        std::vector<table_t> dims;
+        std::vector<std::vector<table_t>> ids;
+        std::vector<std::vector<QType>> vals;
+        // the max scores of the postings, kept when the algorithm prunes with them
+        std::vector<std::vector<float>> scores;
+    };
+
+    // the same as add_row_to_index() on every row: each of the n_shards ranges of rows is indexed into a
+    // PostingShard by a thread, then the dims of the shards are registered in the order of the rows and the lists of
+    // every dim are concatenated to its posting lists, one dim per thread. The max scores and the doc lengths are
+    // computed by the first pass.
+    void
+    add_rows_in_parallel(const SparseRow<DType>* data, size_t rows, size_t n_shards) {
+        const size_t first_id = n_rows_internal_;
+        if (use_row_sums()) {
+            bm25_params_->row_sums.resize(first_id + rows);
+        }
+
+        std::vector<PostingShard> shards(n_shards);
+#pragma omp parallel for schedule(static, 1)
+        for (size_t s = 0; s < n_shards; ++s) {
+            auto& shard = shards[s];
+            SparseRow<DType> impacts;
+            for (size_t i = rows * s / n_shards; i < rows * (s + 1) / n_shards; ++i) {
+                const SparseRow<DType>* row = &data[i];
+                if constexpr (kBM25Impacts) {
+                    impacts = to_bm25_impacts(data[i]);
+                    row = &impacts;
+                }
+                [[maybe_unused]] float row_sum = 0;
+                if (use_row_sums()) {
+                    for (size_t j = 0; j < row->size(); ++j) {
+                        row_sum += (*row)[j].val;
+                    }
+                    bm25_params_->row_sums[first_id + i] = row_sum;
+                }
+                for (size_t j = 0; j < row->size(); ++j) {
+                    auto [dim, val] = (*row)[j];
+                    if (val == 0) {
+                        continue;
+                    }
+                    auto [it, inserted] = shard.local_ids.emplace(dim, shard.dims.size());
+                    if (inserted) {
+                        shard.dims.push_back(dim);
+                        shard.ids.emplace_back();
+                        shard.vals.emplace_back();
+                        if constexpr (UseDimMaxScore(algo)) {
+                            shard.scores.emplace_back();
+                        }
+                    }
+                    shard.ids[it->second].push_back(first_id + i);
+                    shard.vals[it->second].push_back(get_quant_val(val));
+                    if constexpr (UseDimMaxScore(algo)) {
+                        auto score = static_cast<float>(val);
+                        if constexpr (kBM25Impacts) {
+                            score = get_quant_val(val) * bm25_params_->impact_scale;
+                        } else if (metric_type_ == SparseMetricType::METRIC_BM25) {
+                            score = bm25_params_->max_score_computer(val, row_sum);
+                        }
+                        shard.scores[it->second].push_back(score);
+                    }
+                }
+            }
+        }
+
+        // the parts of the posting lists of every dim id, as (shard, local list) in the order of the shards
+        std::vector<std::vector<std::pair<uint32_t, uint32_t>>> parts;
+        for (size_t s = 0; s < n_shards; ++s) {
+            for (size_t local = 0; local < shards[s].dims.size(); ++local) {
+                auto dim_it = dim_map_.find(shards[s].dims[local]);
+                if (dim_it == dim_map_.end()) {
+                    dim_it = insert_dim(shards[s].dims[local]);
+                }
+                if (dim_it->second >= parts.size()) {
+                    parts.resize(next_dim_id_);
+                }
+                parts[dim_it->second].emplace_back(s, local);
+            }
+        }
+
+#pragma omp parallel for schedule(dynamic, 64)
+        for (size_t dim_id = 0; dim_id < parts.size(); ++dim_id) {
+            if (parts[dim_id].empty()) {
+                continue;
+            }
+            auto& plist_ids = inverted_index_ids_[dim_id];
+            auto& plist_vals = inverted_index_vals_[dim_id];
+            size_t n = plist_ids.size();
+            for (const auto& [s, local] : parts[dim_id]) {
+                n += shards[s].ids[local].size();
+            }
+            plist_ids.reserve(n);
+            plist_vals.reserve(n);
+            if constexpr (UseBlockMaxScore(algo)) {
+                block_max_scores_[dim_id].resize(num_blocks(n), 0.0f);
+            }
+            for (const auto& [s, local] : parts[dim_id]) {
+                auto& shard = shards[s];
+                if constexpr (UseDimMaxScore(algo)) {
+                    const auto& scores = shard.scores[local];
+                    for (size_t j = 0; j < scores.size(); ++j) {
+                        max_score_in_dim_[dim_id] = std::max(max_score_in_dim_[dim_id], scores[j]);
+                        if constexpr (UseBlockMaxScore(algo)) {
+                            auto& block_max = block_max_scores_[dim_id][(plist_ids.size() + j) / kPostingBlockSize];
+                            block_max = std::max(block_max, scores[j]);
+                        }
+                    }
+                    std::vector<float>().swap(shard.scores[local]);
+                }
+                plist_ids.insert(plist_ids.end(), shard.ids[local].begin(), shard.ids[local].end());
+                plist_vals.insert(plist_vals.end(), shard.vals[local].begin(), shard.vals[local].end());
+                // the lists of a shard are only read by the thread of their dim
+                std::vector<table_t>().swap(shard.ids[local]);
+                std::vector<QType>().swap(shard.vals[local]);
+            }
+        }
+    }
+
     inline void
     add_row_to_index(const SparseRow<DType>& row, table_t vec_id) {
         [[maybe_unused]] float row_sum = 0;
+        const auto& dims = dim_map();
         for (size_t j = 0; j < row.size(); ++j) {
             auto [dim, val] = row[j];
-            if (metric_type_ == SparseMetricType::METRIC_BM25) {
+            if (use_row_sums()) {
                 row_sum += val;
             }
             // Skip values equals to or close enough to zero(which contributes
@@ -948,44 +2442,98 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
             if (val == 0) {
                 continue;
             }
-            auto dim_it = dim_map_.find(dim);
-            if (dim_it == dim_map_.cend()) {
+            auto dim_id = dims.lookup(dim);
+            if (dim_id == DimMap::kNotFound) {
                 if constexpr (mmapped) {
                     throw std::runtime_error("unexpected vector dimension in mmapped InvertedIndex");
+                } else if constexpr (concurrent) {
+                    throw std::runtime_error("unregistered vector dimension in concurrent InvertedIndex");
                 }
-                dim_it = dim_map_.insert({dim, next_dim_id_++}).first;
-                inverted_index_ids_.emplace_back();
-                inverted_index_vals_.emplace_back();
-                if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
-                    max_score_in_dim_.emplace_back(0.0f);
-                }
+                dim_id = insert_dim(dim)->second;
             }
-            inverted_index_ids_[dim_it->second].emplace_back(vec_id);
-            inverted_index_vals_[dim_it->second].emplace_back(get_quant_val(val));
+            inverted_index_ids_[dim_id].emplace_back(vec_id);
+            inverted_index_vals_[dim_id].emplace_back(get_quant_val(val));
         }
-        // update max_score_in_dim_
-        if constexpr (algo == InvertedIndexAlgo::DAAT_WAND || algo == InvertedIndexAlgo::DAAT_MAXSCORE) {
+        // update max_score_in_dim_ and block_max_scores_
+        if constexpr (UseDimMaxScore(algo)) {
             for (size_t j = 0; j < row.size(); ++j) {
                 auto [dim, val] = row[j];
                 if (val == 0) {
                     continue;
                 }
-                auto dim_it = dim_map_.find(dim);
-                if (dim_it == dim_map_.cend()) {
+                const auto dim_id = dims.lookup(dim);
+                if (dim_id == DimMap::kNotFound) {
                     throw std::runtime_error("unexpected vector dimension in InvertedIndex");
                 }
                 auto score = static_cast<float>(val);
-                if (metric_type_ == SparseMetricType::METRIC_BM25) {
+                if constexpr (kBM25Impacts) {
+                    score = get_quant_val(val) * bm25_params_->impact_scale;
+                } else if (metric_type_ == SparseMetricType::METRIC_BM25) {
                     score = bm25_params_->max_score_computer(val, row_sum);
                 }
-                max_score_in_dim_[dim_it->second] = std::max(max_score_in_dim_[dim_it->second], score);
+                max_score_in_dim_[dim_id] = std::max(max_score_in_dim_[dim_id], score);
+                if constexpr (UseBlockMaxScore(algo)) {
+                    // the posting of vec_id is the last one of its list
+                    auto& block_max = block_max_scores_[dim_id];
+                    size_t block = (inverted_index_ids_[dim_id].size() - 1) / kPostingBlockSize;
+                    if (block == block_max.size()) {
+                        block_max.emplace_back(0.0f);
+                    }
+                    block_max[block] = std::max(block_max[block], score);
+                }
             }
         }
-        if (metric_type_ == SparseMetricType::METRIC_BM25) {
+        if (use_row_sums()) {
             bm25_params_->row_sums.emplace_back(row_sum);
         }
     }
 
+    // the dim map that the searches look up, which is replaced by a copy when dims are added in concurrent mode
+    const DimMap&
+    dim_map() const {
+        if constexpr (concurrent) {
+            return *dim_map_snapshot_.load(std::memory_order_acquire);
+        } else {
+            return dim_map_;
+        }
+    }
+
+    // the posting lists of the dims that are new in data are appended first, then the dim map is replaced by a copy
+    // that includes them, so a search never finds a dim without its lists
+    void
+    register_new_dims(const SparseRow<DType>* data, size_t rows) {
+        const DimMap* current = dim_map_snapshot_.load(std::memory_order_relaxed);
+        DimMap* next = nullptr;
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < data[i].size(); ++j) {
+                auto [dim, val] = data[i][j];
+                if (val == 0 || (next != nullptr ? next : current)->count(dim) != 0) {
+                    continue;
+                }
+                if (next == nullptr) {
+                    next = new DimMap(*current);
+                }
+                next->emplace(dim, next_dim_id_++);
+                inverted_index_ids_.emplace_back(&reclaimer_);
+                inverted_index_vals_.emplace_back(&reclaimer_);
+                if constexpr (UseDimMaxScore(algo)) {
+                    max_score_in_dim_.emplace_back(0.0f);
+                }
+                if constexpr (UseBlockMaxScore(algo)) {
+                    block_max_scores_.emplace_back(&reclaimer_);
+                }
+            }
+        }
+        if (next == nullptr) {
+            return;
+        }
+        next->freeze();
+        dim_map_snapshot_.store(next, std::memory_order_release);
+        if (current != &dim_map_) {
+            reclaimer_.retire(const_cast<DimMap*>(current), [](void* ptr) { delete static_cast<DimMap*>(ptr); });
+        }
+    }
+
     inline QType
     get_quant_val(DType val) const {
         if constexpr (!std::is_same_v<QType, DType>) {
@@ -1003,34 +2551,55 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
     }
 
     // key is raw sparse vector dim/idx, value is the mapped dim/idx id in the index.
-    std::unordered_map<table_t, uint32_t> dim_map_;
+    DimMap dim_map_;
+    // concurrent mode only, the current dim map; dim_map_ stays empty and is the initial one
+    std::atomic<const DimMap*> dim_map_snapshot_{&dim_map_};
+    // concurrent mode only, frees the buffers and dim maps that are replaced once no search can see them
+    EpochReclaimer reclaimer_;
 
     // reserve, [], size, emplace_back
     Vector<Vector<table_t>> inverted_index_ids_;
     Vector<Vector<QType>> inverted_index_vals_;
     Vector<float> max_score_in_dim_;
+    // per dimension, the max score of each kPostingBlockSize consecutive postings
+    Vector<Vector<float>> block_max_scores_;
 
     SparseMetricType metric_type_;
+    bool compress_posting_ids_ = false;
+    bool direct_layout_ = false;
+    // the compressed ids of the posting lists, the lists of inverted_index_ids_ are empty if it is not empty
+    std::vector<CompressedPostingIds> compressed_ids_;
 
-    size_t n_rows_internal_ = 0;
+    // the rows below it are visible to the searches
+    std::atomic<size_t> n_rows_internal_ = 0;
     size_t max_dim_ = 0;
     uint32_t next_dim_id_ = 0;
 
     char* map_ = nullptr;
     size_t map_byte_size_ = 0;
     int map_fd_ = -1;
+    // the direct layout that the views point into, when loaded in mmap mode
+    const uint8_t* direct_data_ = nullptr;
+    size_t direct_byte_size_ = 0;
 
     struct BM25Params {
         float k1;
         float b;
+        float avgdl;
         // row_sums is used to cache the sum of values of each row, which
         // corresponds to the document length of each doc in the BM25 formula.
         Vector<float> row_sums;
 
         DocValueComputer<float> max_score_computer;
+        // the score of an impact of 1, the BM25 score of a term is less than k1 + 1
+        float impact_scale;
 
         BM25Params(float k1, float b, float avgdl)
-            : k1(k1), b(b), max_score_computer(GetDocValueBM25Computer<float>(k1, b, avgdl)) {
+            : k1(k1),
+              b(b),
+              avgdl(avgdl),
+              max_score_computer(GetDocValueBM25Computer<float>(k1, b, avgdl)),
+              impact_scale((k1 + 1) / std::numeric_limits<bm25_impact_t>::max()) {
         }
     };  // struct BM25Params
 
@@ -1039,8 +2608,8 @@ class InvertedIndex : public BaseInvertedIndex<DType> {
 #if defined(NOT_COMPILE_FOR_SWIG) && !defined(KNOWHERE_WITH_LIGHT)
     std::string index_id_{};
     prometheus::Gauge* index_size_gauge_{nullptr};
-    prometheus::Histogram* index_dataset_nnz_len_histogram_{nullptr};
-    prometheus::Histogram* index_posting_list_len_histogram_{nullptr};
+    std::unique_ptr<ShardedHistogram> index_dataset_nnz_len_histogram_;
+    std::unique_ptr<ShardedHistogram> index_posting_list_len_histogram_;
 #endif
 };  // class InvertedIndex
 
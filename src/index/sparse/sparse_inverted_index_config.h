@@ -24,6 +24,13 @@ class SparseInvertedIndexConfig : public BaseConfig {
     CFG_INT refine_factor;
     CFG_FLOAT dim_max_score_ratio;
     CFG_STRING inverted_index_algo;
+    CFG_BOOL compress_posting_ids;
+    CFG_BOOL reorder_doc_ids;
+    CFG_BOOL bm25_impacts;
+    CFG_BOOL direct_layout;
+    CFG_INT search_batch_size;
+    CFG_INT search_posting_budget;
+    CFG_FLOAT search_time_budget_ms;
     KNOHWERE_DECLARE_CONFIG(SparseInvertedIndexConfig) {
         // NOTE: drop_ratio_build has been deprecated, it won't change anything
         KNOWHERE_CONFIG_DECLARE_FIELD(drop_ratio_build)
@@ -87,18 +94,70 @@ class SparseInvertedIndexConfig : public BaseConfig {
             .for_train()
             .for_deserialize()
             .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(compress_posting_ids)
+            .description("whether to keep the ids of the posting lists compressed in memory, ignored with mmap")
+            .set_default(false)
+            .for_train()
+            .for_deserialize()
+            .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(reorder_doc_ids)
+            .description("whether to reorder the rows of the first added batch so that similar rows get close ids")
+            .set_default(false)
+            .for_train();
+        KNOWHERE_CONFIG_DECLARE_FIELD(bm25_impacts)
+            .description("whether to store quantized BM25 scores computed with the build time k1, b and avgdl "
+                         "instead of term frequencies, must be the same when loading")
+            .set_default(false)
+            .for_train()
+            .for_deserialize()
+            .for_deserialize_from_file();
+        KNOWHERE_CONFIG_DECLARE_FIELD(direct_layout)
+            .description("whether to serialize the posting lists as they are searched, so that they are mmapped as is "
+                         "instead of being built again when loading, both layouts can be loaded")
+            .set_default(false)
+            .for_train()
+            .for_deserialize()
+            .for_deserialize_from_file();
+        /**
+         * search_batch_size > 1 searches the queries in batches of that many,
+         * each with a single pass over the union of their posting lists
+         * instead of a pass per query. Since the postings are not pruned, it
+         * pays off for large batches of queries that share many dims.
+         */
+        KNOWHERE_CONFIG_DECLARE_FIELD(search_batch_size)
+            .description("the number of queries that are searched together in one pass over their posting lists")
+            .set_default(1)
+            .set_range(1, 65536)
+            .for_search();
+        /**
+         * The budgets of a SAAT_ANYTIME search, which scores the postings in
+         * decreasing order of their bounds and stops once its top-k is exact.
+         * A query that runs out of its budget first returns the best results
+         * found so far, and reports early_terminated in its search stats.
+         */
+        KNOWHERE_CONFIG_DECLARE_FIELD(search_posting_budget)
+            .description("the number of postings a SAAT_ANYTIME query may score, 0 for no limit")
+            .set_default(0)
+            .set_range(0, std::numeric_limits<CFG_INT::value_type>::max())
+            .for_search();
+        KNOWHERE_CONFIG_DECLARE_FIELD(search_time_budget_ms)
+            .description("the milliseconds a SAAT_ANYTIME query may spend scoring postings, 0 for no limit")
+            .set_default(0)
+            .set_range(0, std::numeric_limits<CFG_FLOAT::value_type>::max())
+            .for_search();
     }
 
     Status
     CheckAndAdjust(PARAM_TYPE param_type, std::string* err_msg) override {
         if (param_type == PARAM_TYPE::TRAIN) {
-            constexpr std::array<std::string_view, 3> legal_inverted_index_algo_list{"TAAT_NAIVE", "DAAT_WAND",
-                                                                                     "DAAT_MAXSCORE"};
+            constexpr std::array<std::string_view, 5> legal_inverted_index_algo_list{
+                "TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND", "SAAT_ANYTIME"};
             std::string inverted_index_algo_str = inverted_index_algo.value_or("");
             if (std::find(legal_inverted_index_algo_list.begin(), legal_inverted_index_algo_list.end(),
                           inverted_index_algo_str) == legal_inverted_index_algo_list.end()) {
                 std::string msg = "sparse inverted index algo " + inverted_index_algo_str +
-                                  " not found or not supported, supported: [TAAT_NAIVE DAAT_WAND DAAT_MAXSCORE]";
+                                  " not found or not supported, supported: [TAAT_NAIVE DAAT_WAND DAAT_MAXSCORE "
+                                  "DAAT_BLOCK_MAX_WAND SAAT_ANYTIME]";
                 return HandleError(err_msg, msg, Status::invalid_args);
             }
         }
@@ -0,0 +1,151 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SPARSE_POSTING_CODEC_H
+#define SPARSE_POSTING_CODEC_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "knowhere/sparse_utils.h"
+#include "simd/hook.h"
+
+namespace knowhere::sparse {
+
+// the number of consecutive postings that are compressed together, and that share a max score in the block-max
+// layout
+constexpr size_t kPostingBlockSize = 64;
+
+// The sorted ids of a posting list, compressed block by block: each block stores the deltas between consecutive
+// ids, bit-packed with the width of its largest delta. The last id of each block is kept uncompressed, so that
+// blocks can be skipped and decoded independently.
+class CompressedPostingIds {
+ public:
+    CompressedPostingIds() = default;
+
+    CompressedPostingIds(const table_t* ids, size_t n) : size_(n) {
+        const size_t n_blocks = (n + kPostingBlockSize - 1) / kPostingBlockSize;
+        last_ids_.reserve(n_blocks);
+        offsets_.reserve(n_blocks);
+        bits_.reserve(n_blocks);
+        for (size_t b = 0; b < n_blocks; ++b) {
+            const size_t begin = b * kPostingBlockSize;
+            const size_t end = std::min(begin + kPostingBlockSize, n);
+            table_t prev = block_base(b);
+            table_t max_delta = 0;
+            for (size_t i = begin; i < end; ++i) {
+                max_delta = std::max<table_t>(max_delta, ids[i] - (i == begin ? prev : ids[i - 1]));
+            }
+            const size_t bits = max_delta == 0 ? 0 : 32 - __builtin_clz(max_delta);
+            const size_t offset = data_.size() - (data_.empty() ? 0 : sizeof(uint64_t));
+            // the decoder reads 8 bytes at a time, the tail of the data stays zero padded
+            data_.resize(offset + ((end - begin) * bits + 7) / 8 + sizeof(uint64_t), 0);
+            for (size_t i = begin; i < end; ++i) {
+                const size_t bit = (i - begin) * bits;
+                uint64_t word;
+                std::memcpy(&word, data_.data() + offset + bit / 8, sizeof(word));
+                word |= static_cast<uint64_t>(ids[i] - prev) << (bit % 8);
+                std::memcpy(data_.data() + offset + bit / 8, &word, sizeof(word));
+                prev = ids[i];
+            }
+            last_ids_.push_back(ids[end - 1]);
+            offsets_.push_back(offset);
+            bits_.push_back(bits);
+        }
+    }
+
+    [[nodiscard]] size_t
+    size() const {
+        return size_;
+    }
+
+    [[nodiscard]] size_t
+    num_blocks() const {
+        return last_ids_.size();
+    }
+
+    [[nodiscard]] table_t
+    block_last_id(size_t block) const {
+        return last_ids_[block];
+    }
+
+    // decodes the ids of a block into out, which must hold kPostingBlockSize ids
+    size_t
+    decode_block(size_t block, table_t* out) const {
+        const size_t n = std::min(kPostingBlockSize, size_ - block * kPostingBlockSize);
+        faiss::u32_bitpacked_delta_decode(data_.data() + offsets_[block], bits_[block], n, block_base(block), out);
+        return n;
+    }
+
+    // decodes all the ids into out, which must hold size() ids
+    void
+    decode(table_t* out) const {
+        for (size_t b = 0; b < num_blocks(); ++b) {
+            decode_block(b, out + b * kPostingBlockSize);
+        }
+    }
+
+    // the position of the first id that is not less than id, size() if there is none
+    [[nodiscard]] size_t
+    lower_bound(table_t id) const {
+        auto it = std::lower_bound(last_ids_.begin(), last_ids_.end(), id);
+        if (it == last_ids_.end()) {
+            return size_;
+        }
+        const size_t block = it - last_ids_.begin();
+        table_t block_ids[kPostingBlockSize];
+        const size_t n = decode_block(block, block_ids);
+        return block * kPostingBlockSize + (std::lower_bound(block_ids, block_ids + n, id) - block_ids);
+    }
+
+    // the position of id in the list, -1 if it is not there
+    [[nodiscard]] int64_t
+    find(table_t id) const {
+        auto it = std::lower_bound(last_ids_.begin(), last_ids_.end(), id);
+        if (it == last_ids_.end()) {
+            return -1;
+        }
+        const size_t block = it - last_ids_.begin();
+        table_t block_ids[kPostingBlockSize];
+        const size_t n = decode_block(block, block_ids);
+        auto pos = std::lower_bound(block_ids, block_ids + n, id);
+        if (pos == block_ids + n || *pos != id) {
+            return -1;
+        }
+        return block * kPostingBlockSize + (pos - block_ids);
+    }
+
+    [[nodiscard]] size_t
+    byte_size() const {
+        return sizeof(*this) + last_ids_.capacity() * sizeof(table_t) + offsets_.capacity() * sizeof(uint32_t) +
+               bits_.capacity() * sizeof(uint8_t) + data_.capacity() * sizeof(uint8_t);
+    }
+
+ private:
+    // the ids of a block are encoded as deltas from the last id of the previous block
+    [[nodiscard]] table_t
+    block_base(size_t block) const {
+        return block == 0 ? 0 : last_ids_[block - 1];
+    }
+
+    size_t size_ = 0;
+    std::vector<table_t> last_ids_;
+    // the byte offset of each block in data_
+    std::vector<uint32_t> offsets_;
+    std::vector<uint8_t> bits_;
+    std::vector<uint8_t> data_;
+};
+
+}  // namespace knowhere::sparse
+
+#endif  // SPARSE_POSTING_CODEC_H
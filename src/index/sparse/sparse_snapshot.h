@@ -0,0 +1,295 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#ifndef SPARSE_SNAPSHOT_H
+#define SPARSE_SNAPSHOT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace knowhere::sparse {
+
+// Epoch based reclamation for a single writer and many readers. The writer retires the memory that it has
+// unlinked, which is only freed once no reader that may still see it is left. Readers only count themselves in
+// and out of the current epoch, they never wait.
+class EpochReclaimer {
+ public:
+    using Deleter = void (*)(void*);
+
+    EpochReclaimer() = default;
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer&
+    operator=(const EpochReclaimer&) = delete;
+
+    ~EpochReclaimer() {
+        for (const auto& retired : retired_) {
+            retired.deleter(retired.ptr);
+        }
+    }
+
+    // keeps the memory that the reader sees alive while it exists, does nothing if reclaimer is null
+    class ReadGuard {
+     public:
+        explicit ReadGuard(const EpochReclaimer* reclaimer) : reclaimer_(reclaimer) {
+            if (reclaimer_ != nullptr) {
+                slot_ = reclaimer_->enter();
+            }
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard&
+        operator=(const ReadGuard&) = delete;
+
+        ~ReadGuard() {
+            if (reclaimer_ != nullptr) {
+                reclaimer_->readers_[slot_].fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+     private:
+        const EpochReclaimer* reclaimer_;
+        size_t slot_ = 0;
+    };
+
+    // ptr must not be reachable by the readers that come after, it is freed with deleter later. Writer only.
+    void
+    retire(void* ptr, Deleter deleter) {
+        retired_.push_back({ptr, deleter, epoch_.load(std::memory_order_relaxed)});
+    }
+
+    // advances the epoch if the readers of the previous one are gone, and frees what no reader can see anymore.
+    // Never blocks, what can't be freed yet is tried again by the next call. Writer only.
+    void
+    reclaim() {
+        const uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+        if (readers_[(epoch + 1) % 2].load() != 0) {
+            return;
+        }
+        epoch_.store(epoch + 1);
+        // the readers that entered before the epoch became epoch are all gone
+        auto it = std::find_if(retired_.begin(), retired_.end(), [&](const auto& r) { return r.epoch >= epoch; });
+        for (auto r = retired_.begin(); r != it; ++r) {
+            r->deleter(r->ptr);
+        }
+        retired_.erase(retired_.begin(), it);
+    }
+
+ private:
+    struct Retired {
+        void* ptr;
+        Deleter deleter;
+        uint64_t epoch;
+    };
+
+    // returns the slot of the epoch the reader counted itself in
+    size_t
+    enter() const {
+        while (true) {
+            const uint64_t epoch = epoch_.load();
+            readers_[epoch % 2].fetch_add(1);
+            if (epoch_.load() == epoch) {
+                return epoch % 2;
+            }
+            readers_[epoch % 2].fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    std::atomic<uint64_t> epoch_{0};
+    // the number of readers of the epochs by parity, only the current and the previous epoch can have readers
+    mutable std::atomic<int64_t> readers_[2] = {0, 0};
+    // in the order they were retired
+    std::vector<Retired> retired_;
+};
+
+// passed to the constructor of a SnapshotVector that takes over the elements of another one
+struct SnapshotRelocate {};
+
+// A vector with a single writer that readers may read while it grows. A full buffer is copied into a larger one;
+// the old one is retired to the reclaimer (freed at once if there is none) instead of being freed, so a reader keeps
+// reading what it has loaded. A reader must load size() before data(), the elements below size() are all there.
+// Elements are relocated bitwise, or by SnapshotRelocate for nested SnapshotVectors: the relocated elements are left
+// as they are, readers of the old buffer still see their contents. The writer may overwrite elements in place,
+// which readers see before or after the write, e.g. max scores that only go up.
+template <typename T>
+class SnapshotVector {
+    static_assert(std::is_trivially_copyable_v<T> || std::is_constructible_v<T, const T&, SnapshotRelocate>,
+                  "SnapshotVector elements must be relocatable");
+
+ public:
+    using value_type = T;
+    using size_type = size_t;
+
+    SnapshotVector() = default;
+
+    explicit SnapshotVector(EpochReclaimer* reclaimer) : reclaimer_(reclaimer) {
+    }
+
+    SnapshotVector(const SnapshotVector& other, SnapshotRelocate)
+        : data_(other.data_.load(std::memory_order_relaxed)),
+          size_(other.size_.load(std::memory_order_relaxed)),
+          capacity_(other.capacity_),
+          reclaimer_(other.reclaimer_) {
+    }
+
+    SnapshotVector(const SnapshotVector&) = delete;
+    SnapshotVector&
+    operator=(const SnapshotVector&) = delete;
+
+    ~SnapshotVector() {
+        T* data = data_.load(std::memory_order_relaxed);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < size(); ++i) {
+                data[i].~T();
+            }
+        }
+        ::operator delete(data);
+    }
+
+    void
+    set_reclaimer(EpochReclaimer* reclaimer) {
+        reclaimer_ = reclaimer;
+    }
+
+    [[nodiscard]] size_type
+    size() const {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool
+    empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type
+    capacity() const {
+        return capacity_;
+    }
+
+    void
+    reserve(size_type n) {
+        if (n > capacity_) {
+            grow(n);
+        }
+    }
+
+    // must not shrink while it is being read
+    void
+    resize(size_type n) {
+        reserve(n);
+        T* data = data_.load(std::memory_order_relaxed);
+        const size_t old_size = size_.load(std::memory_order_relaxed);
+        for (size_t i = old_size; i < n; ++i) {
+            new (data + i) T();
+        }
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = n; i < old_size; ++i) {
+                data[i].~T();
+            }
+        }
+        size_.store(n, std::memory_order_release);
+    }
+
+    template <typename... Args>
+    T&
+    emplace_back(Args&&... args) {
+        const size_t n = size_.load(std::memory_order_relaxed);
+        if (n == capacity_) {
+            grow(std::max<size_t>(2 * capacity_, 1));
+        }
+        T* elem = new (data_.load(std::memory_order_relaxed) + n) T(std::forward<Args>(args)...);
+        size_.store(n + 1, std::memory_order_release);
+        return *elem;
+    }
+
+    T&
+    operator[](size_type i) {
+        return data_.load(std::memory_order_relaxed)[i];
+    }
+
+    const T&
+    operator[](size_type i) const {
+        return data_.load(std::memory_order_acquire)[i];
+    }
+
+    T*
+    data() {
+        return data_.load(std::memory_order_relaxed);
+    }
+
+    const T*
+    data() const {
+        return data_.load(std::memory_order_acquire);
+    }
+
+    const T&
+    at(size_type i) const {
+        if (i >= size()) {
+            throw std::out_of_range("SnapshotVector index out of range");
+        }
+        return data()[i];
+    }
+
+    // for the writer, begin() and end() of readers may come from different buffers
+    T*
+    begin() {
+        return data();
+    }
+
+    T*
+    end() {
+        return data() + size();
+    }
+
+ private:
+    void
+    grow(size_t capacity) {
+        T* old_data = data_.load(std::memory_order_relaxed);
+        T* new_data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        const size_t n = size_.load(std::memory_order_relaxed);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (n > 0) {
+                std::memcpy(new_data, old_data, n * sizeof(T));
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                new (new_data + i) T(old_data[i], SnapshotRelocate{});
+            }
+        }
+        data_.store(new_data, std::memory_order_release);
+        capacity_ = capacity;
+        if (old_data == nullptr) {
+            return;
+        }
+        // the elements in the old buffer are not destroyed, they live on in the new one
+        auto deleter = [](void* ptr) { ::operator delete(ptr); };
+        if (reclaimer_ != nullptr) {
+            reclaimer_->retire(old_data, deleter);
+        } else {
+            deleter(old_data);
+        }
+    }
+
+    std::atomic<T*> data_{nullptr};
+    std::atomic<size_t> size_{0};
+    // only read by the writer
+    size_t capacity_ = 0;
+    EpochReclaimer* reclaimer_ = nullptr;
+};
+
+}  // namespace knowhere::sparse
+
+#endif  // SPARSE_SNAPSHOT_H
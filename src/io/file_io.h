@@ -13,8 +13,13 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+#include "io/memory_io.h"
 
 namespace knowhere {
 struct FileReader {
@@ -73,4 +78,79 @@ struct FileReader {
     int fd_ = -1;
     size_t size_;
 };
+
+// Writes what a MemoryIOWriter would hold to a file, through a buffer of chunk_size bytes, so that an index is
+// serialized without a copy of it in memory. tellg() is the number of bytes written so far.
+struct FileWriter : public MemoryIOWriter {
+    explicit FileWriter(const std::string& filename, size_t chunk_size = 4 * 1024 * 1024) : chunk_size_(chunk_size) {
+        fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Cannot open file " + filename + ": " + strerror(errno));
+        }
+        buffer_.reserve(chunk_size_);
+    }
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter&
+    operator=(const FileWriter&) = delete;
+
+    ~FileWriter() override {
+        if (fd_ != -1) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    size_t
+    operator()(const void* ptr, size_t size, size_t nitems) override {
+        const size_t bytes = size * nitems;
+        if (buffer_.size() + bytes > chunk_size_) {
+            flush();
+        }
+        if (bytes >= chunk_size_) {
+            writeAll(static_cast<const char*>(ptr), bytes);
+        } else {
+            buffer_.insert(buffer_.end(), static_cast<const char*>(ptr), static_cast<const char*>(ptr) + bytes);
+        }
+        rp_ += bytes;
+        return nitems;
+    }
+
+    void
+    flush() {
+        writeAll(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+    // flushes and closes the file, throws if any of the writes failed
+    void
+    close() {
+        flush();
+        const int fd = fd_;
+        fd_ = -1;
+        if (::close(fd) != 0) {
+            throw std::runtime_error(std::string("Cannot close file: ") + strerror(errno));
+        }
+    }
+
+ private:
+    void
+    writeAll(const char* data, size_t n) {
+        while (n > 0) {
+            const ssize_t written = ::write(fd_, data, n);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("Cannot write file: ") + strerror(errno));
+            }
+            data += written;
+            n -= written;
+        }
+    }
+
+    int fd_ = -1;
+    const size_t chunk_size_;
+    std::vector<char> buffer_;
+};
 }  // namespace knowhere
@@ -11,6 +11,7 @@
 
 #include "io/memory_io.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace knowhere {
@@ -47,6 +48,34 @@ MemoryIOWriter::operator()(const void* ptr, size_t size, size_t nitems) {
     return nitems;
 }
 
+size_t
+ChunkedMemoryIOWriter::operator()(const void* ptr, size_t size, size_t nitems) {
+    auto src = static_cast<const uint8_t*>(ptr);
+    size_t bytes = size * nitems;
+    while (bytes > 0) {
+        if (chunks_.empty() || static_cast<size_t>(chunks_.back().size) == capacity_) {
+            capacity_ = chunks_.empty() ? kFirstChunkSize : std::min(capacity_ * 2, kMaxChunkSize);
+            chunks_.push_back(BinaryChunk{std::shared_ptr<uint8_t[]>(new uint8_t[capacity_]), 0});
+        }
+        auto& chunk = chunks_.back();
+        const size_t n = std::min(bytes, capacity_ - static_cast<size_t>(chunk.size));
+        memcpy(chunk.data.get() + chunk.size, src, n);
+        chunk.size += n;
+        src += n;
+        bytes -= n;
+    }
+    rp_ += size * nitems;
+    return nitems;
+}
+
+std::vector<BinaryChunk>
+ChunkedMemoryIOWriter::Release() {
+    std::vector<BinaryChunk> chunks;
+    chunks.swap(chunks_);
+    capacity_ = 0;
+    return chunks;
+}
+
 size_t
 MemoryIOReader::operator()(void* ptr, size_t size, size_t nitems) {
     if (rp_ >= total_) {
@@ -13,6 +13,10 @@
 
 #include <faiss/impl/io.h>
 
+#include <vector>
+
+#include "knowhere/binaryset.h"
+
 namespace knowhere {
 
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -102,6 +106,24 @@ struct MemoryIOWriter : public faiss::IOWriter {
     }
 };
 
+// Serializes into a list of blocks instead of one buffer that is reallocated as it grows, the blocks double in size
+//   up to kMaxChunkSize. The result is taken with Release(), data() stays null. tellg() is the number of bytes written.
+struct ChunkedMemoryIOWriter : public MemoryIOWriter {
+    static constexpr size_t kFirstChunkSize = 1024 * 1024;
+    static constexpr size_t kMaxChunkSize = 64 * 1024 * 1024;
+
+    size_t
+    operator()(const void* ptr, size_t size, size_t nitems) override;
+
+    // the binary of what was written, for BinarySet::AppendChunks()
+    std::vector<BinaryChunk>
+    Release();
+
+ private:
+    std::vector<BinaryChunk> chunks_;
+    size_t capacity_ = 0;
+};
+
 struct MemoryIOReader : public faiss::IOReader {
     uint8_t* data_;
     size_t rp_ = 0;
@@ -0,0 +1,175 @@
+// Copyright (C) 2019-2025 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#if defined(__x86_64__)
+
+#include "distances_amx.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace faiss {
+
+namespace {
+
+// the rows of a tile, the rows of y multiplied at once and the most queries of a tile
+constexpr size_t kTileRows = 16;
+// the bytes of a tile row, the dims multiplied at once
+constexpr size_t kTileBytes = 64;
+
+struct TileConfig {
+    uint8_t palette_id = 1;
+    uint8_t start_row = 0;
+    uint8_t reserved[14] = {};
+    uint16_t colsb[16] = {};
+    uint8_t rows[16] = {};
+};
+
+}  // namespace
+
+// The rows of y are the A tiles and the queries the B tile, so that y is read in place and only the queries are
+// packed: a B tile holds 4 consecutive dims of every query by row. The dims past the last full tile and the rows past
+// the last full 16 of y are copied to a zero padded buffer.
+void
+int8_vec_inner_products_nx_ny_amx(float* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny) {
+    const size_t d_tiles = (d + kTileBytes - 1) / kTileBytes;
+    const size_t d_full = d / kTileBytes;
+    const size_t padded_d = d_tiles * kTileBytes;
+    thread_local std::vector<int8_t> x_packed;
+    thread_local std::vector<int8_t> y_padded;
+    x_packed.resize(d_tiles * kTileRows * kTileBytes);
+    y_padded.resize(kTileRows * padded_d);
+    int32_t res[kTileRows][kTileRows];
+
+    for (size_t i0 = 0; i0 < nx; i0 += kTileRows) {
+        const size_t nq = std::min(kTileRows, nx - i0);
+        std::fill(x_packed.begin(), x_packed.end(), 0);
+        for (size_t q = 0; q < nq; q++) {
+            const int8_t* x_q = x + (i0 + q) * d;
+            for (size_t k = 0; k < d; k++) {
+                x_packed[k / 4 * kTileBytes + q * 4 + k % 4] = x_q[k];
+            }
+        }
+
+        // tile 0 accumulates, tile 1 holds 16 rows of y and tile 2 the queries
+        TileConfig cfg;
+        cfg.rows[0] = kTileRows;
+        cfg.colsb[0] = nq * 4;
+        cfg.rows[1] = kTileRows;
+        cfg.colsb[1] = kTileBytes;
+        cfg.rows[2] = kTileBytes / 4;
+        cfg.colsb[2] = nq * 4;
+        _tile_loadconfig(&cfg);
+
+        for (size_t j0 = 0; j0 < ny; j0 += kTileRows) {
+            const size_t rows = std::min(kTileRows, ny - j0);
+            const int8_t* y_j0 = y + j0 * d;
+            if (rows < kTileRows || d_full < d_tiles) {
+                std::fill(y_padded.begin(), y_padded.end(), 0);
+                for (size_t r = 0; r < rows; r++) {
+                    std::memcpy(y_padded.data() + r * padded_d, y_j0 + r * d, d);
+                }
+            }
+
+            _tile_zero(0);
+            for (size_t t = 0; t < d_tiles; t++) {
+                if (rows == kTileRows && t < d_full) {
+                    _tile_loadd(1, y_j0 + t * kTileBytes, d);
+                } else {
+                    _tile_loadd(1, y_padded.data() + t * kTileBytes, padded_d);
+                }
+                _tile_loadd(2, x_packed.data() + t * kTileRows * kTileBytes, kTileBytes);
+                _tile_dpbssd(0, 1, 2);
+            }
+            _tile_stored(0, res, kTileRows * sizeof(int32_t));
+
+            for (size_t q = 0; q < nq; q++) {
+                float* ip_q = ip + (i0 + q) * ny + j0;
+                for (size_t r = 0; r < rows; r++) {
+                    ip_q[r] = (float)res[r][q];
+                }
+            }
+        }
+    }
+    _tile_release();
+}
+
+// The same layout as for int8, a B tile row holds 2 consecutive dims of every query and a tile covers 32 dims.
+void
+bf16_vec_inner_products_nx_ny_amx(float* ip, const knowhere::bf16* x, const knowhere::bf16* y, size_t d, size_t nx,
+                                  size_t ny) {
+    constexpr size_t kTileDims = kTileBytes / sizeof(knowhere::bf16);
+    const size_t d_tiles = (d + kTileDims - 1) / kTileDims;
+    const size_t d_full = d / kTileDims;
+    const size_t padded_d = d_tiles * kTileDims;
+    thread_local std::vector<uint16_t> x_packed;
+    thread_local std::vector<uint16_t> y_padded;
+    x_packed.resize(d_tiles * kTileRows * kTileDims);
+    y_padded.resize(kTileRows * padded_d);
+    float res[kTileRows][kTileRows];
+
+    for (size_t i0 = 0; i0 < nx; i0 += kTileRows) {
+        const size_t nq = std::min(kTileRows, nx - i0);
+        std::fill(x_packed.begin(), x_packed.end(), 0);
+        for (size_t q = 0; q < nq; q++) {
+            const knowhere::bf16* x_q = x + (i0 + q) * d;
+            for (size_t k = 0; k < d; k++) {
+                std::memcpy(&x_packed[k / 2 * kTileDims + q * 2 + k % 2], x_q + k, sizeof(uint16_t));
+            }
+        }
+
+        TileConfig cfg;
+        cfg.rows[0] = kTileRows;
+        cfg.colsb[0] = nq * 4;
+        cfg.rows[1] = kTileRows;
+        cfg.colsb[1] = kTileBytes;
+        cfg.rows[2] = kTileDims / 2;
+        cfg.colsb[2] = nq * 4;
+        _tile_loadconfig(&cfg);
+
+        for (size_t j0 = 0; j0 < ny; j0 += kTileRows) {
+            const size_t rows = std::min(kTileRows, ny - j0);
+            const knowhere::bf16* y_j0 = y + j0 * d;
+            if (rows < kTileRows || d_full < d_tiles) {
+                std::fill(y_padded.begin(), y_padded.end(), 0);
+                for (size_t r = 0; r < rows; r++) {
+                    std::memcpy(y_padded.data() + r * padded_d, y_j0 + r * d, d * sizeof(knowhere::bf16));
+                }
+            }
+
+            _tile_zero(0);
+            for (size_t t = 0; t < d_tiles; t++) {
+                if (rows == kTileRows && t < d_full) {
+                    _tile_loadd(1, y_j0 + t * kTileDims, d * sizeof(knowhere::bf16));
+                } else {
+                    _tile_loadd(1, y_padded.data() + t * kTileDims, padded_d * sizeof(knowhere::bf16));
+                }
+                _tile_loadd(2, x_packed.data() + t * kTileRows * kTileDims, kTileBytes);
+                _tile_dpbf16ps(0, 1, 2);
+            }
+            _tile_stored(0, res, kTileRows * sizeof(float));
+
+            for (size_t q = 0; q < nq; q++) {
+                float* ip_q = ip + (i0 + q) * ny + j0;
+                for (size_t r = 0; r < rows; r++) {
+                    ip_q[r] = res[r][q];
+                }
+            }
+        }
+    }
+    _tile_release();
+}
+
+}  // namespace faiss
+#endif
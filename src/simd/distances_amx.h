@@ -0,0 +1,34 @@
+// Copyright (C) 2019-2025 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "knowhere/operands.h"
+
+namespace faiss {
+
+///////////////////////////////////////////////////////////////////////////////
+// int8, with amx tiles
+
+void
+int8_vec_inner_products_nx_ny_amx(float* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny);
+
+///////////////////////////////////////////////////////////////////////////////
+// bf16, with amx tiles
+
+void
+bf16_vec_inner_products_nx_ny_amx(float* ip, const knowhere::bf16* x, const knowhere::bf16* y, size_t d, size_t nx,
+                                  size_t ny);
+
+}  // namespace faiss
@@ -15,9 +15,15 @@
 
 #include <immintrin.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
 
 #include "faiss/impl/platform_macros.h"
+#include "hook.h"
 #include "xxhash.h"
 
 namespace faiss {
@@ -966,6 +972,156 @@ int8_vec_L2sqr_batch_4_avx(const int8_t* x, const int8_t* y0, const int8_t* y1,
 }
 FAISS_PRAGMA_IMPRECISE_FUNCTION_END
 
+///////////////////////////////////////////////////////////////////////////////
+// batch_8
+
+namespace {
+// the query stays in a register while it is scored against the 8 vectors y, the dims past the last 8 are summed
+// one by one
+template <bool L2>
+inline __m256
+fvec_batch_8_step(const __m256 res, const __m256 mx, const float* y) {
+    __m256 my = _mm256_loadu_ps(y);
+    if constexpr (L2) {
+        my = _mm256_sub_ps(mx, my);
+        return _mm256_fmadd_ps(my, my, res);
+    } else {
+        return _mm256_fmadd_ps(mx, my, res);
+    }
+}
+
+template <bool L2>
+inline void
+fvec_batch_8_avx(const float* x, const float* const* y, const size_t d, float* dis) {
+    const float *y0 = y[0], *y1 = y[1], *y2 = y[2], *y3 = y[3], *y4 = y[4], *y5 = y[5], *y6 = y[6], *y7 = y[7];
+    __m256 res0 = _mm256_setzero_ps(), res1 = _mm256_setzero_ps(), res2 = _mm256_setzero_ps(),
+           res3 = _mm256_setzero_ps(), res4 = _mm256_setzero_ps(), res5 = _mm256_setzero_ps(),
+           res6 = _mm256_setzero_ps(), res7 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= d; i += 8) {
+        const __m256 mx = _mm256_loadu_ps(x + i);
+        res0 = fvec_batch_8_step<L2>(res0, mx, y0 + i);
+        res1 = fvec_batch_8_step<L2>(res1, mx, y1 + i);
+        res2 = fvec_batch_8_step<L2>(res2, mx, y2 + i);
+        res3 = fvec_batch_8_step<L2>(res3, mx, y3 + i);
+        res4 = fvec_batch_8_step<L2>(res4, mx, y4 + i);
+        res5 = fvec_batch_8_step<L2>(res5, mx, y5 + i);
+        res6 = fvec_batch_8_step<L2>(res6, mx, y6 + i);
+        res7 = fvec_batch_8_step<L2>(res7, mx, y7 + i);
+    }
+    const __m256 res[8] = {res0, res1, res2, res3, res4, res5, res6, res7};
+    for (size_t k = 0; k < 8; k++) {
+        float tail = 0;
+        for (size_t j = i; j < d; j++) {
+            if constexpr (L2) {
+                const float q = x[j] - y[k][j];
+                tail += q * q;
+            } else {
+                tail += x[j] * y[k][j];
+            }
+        }
+        dis[k] = _mm256_reduce_add_ps(res[k]) + tail;
+    }
+}
+}  // namespace
+
+void
+fvec_inner_product_batch_8_avx(const float* x, const float* const* y, const size_t d, float* dis) {
+    fvec_batch_8_avx<false>(x, y, d, dis);
+}
+
+void
+fvec_L2sqr_batch_8_avx(const float* x, const float* const* y, const size_t d, float* dis) {
+    fvec_batch_8_avx<true>(x, y, d, dis);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fixed dims
+
+namespace {
+// calls f with the steps 0, 1, ..., unrolled at compile time
+template <typename F, size_t... Steps>
+inline void
+unroll_steps(F&& f, std::index_sequence<Steps...>) {
+    (f(std::integral_constant<size_t, Steps>{}), ...);
+}
+
+// 4 accumulators of 8 dims hide the latency of the fma, D is a multiple of 32 so there is no tail
+template <bool L2, size_t D>
+inline float
+fvec_dim_avx(const float* x, const float* y) {
+    static_assert(D % 32 == 0, "the dims of a fixed dim kernel are a multiple of 32");
+    __m256 res[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    unroll_steps(
+        [&](auto step) {
+            constexpr size_t i = step * 8;
+            res[step % 4] = fvec_batch_8_step<L2>(res[step % 4], _mm256_loadu_ps(x + i), y + i);
+        },
+        std::make_index_sequence<D / 8>{});
+    return _mm256_reduce_add_ps(_mm256_add_ps(_mm256_add_ps(res[0], res[1]), _mm256_add_ps(res[2], res[3])));
+}
+
+template <bool L2, size_t D>
+inline void
+fvec_dim_batch_4_avx(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                     float& dis0, float& dis1, float& dis2, float& dis3) {
+    static_assert(D % 32 == 0, "the dims of a fixed dim kernel are a multiple of 32");
+    __m256 res0 = _mm256_setzero_ps(), res1 = _mm256_setzero_ps(), res2 = _mm256_setzero_ps(),
+           res3 = _mm256_setzero_ps();
+    unroll_steps(
+        [&](auto step) {
+            constexpr size_t i = step * 8;
+            const __m256 mx = _mm256_loadu_ps(x + i);
+            res0 = fvec_batch_8_step<L2>(res0, mx, y0 + i);
+            res1 = fvec_batch_8_step<L2>(res1, mx, y1 + i);
+            res2 = fvec_batch_8_step<L2>(res2, mx, y2 + i);
+            res3 = fvec_batch_8_step<L2>(res3, mx, y3 + i);
+        },
+        std::make_index_sequence<D / 8>{});
+    dis0 = _mm256_reduce_add_ps(res0);
+    dis1 = _mm256_reduce_add_ps(res1);
+    dis2 = _mm256_reduce_add_ps(res2);
+    dis3 = _mm256_reduce_add_ps(res3);
+}
+}  // namespace
+
+template <size_t D>
+float
+fvec_L2sqr_avx_dim(const float* x, const float* y, size_t) {
+    return fvec_dim_avx<true, D>(x, y);
+}
+
+template <size_t D>
+float
+fvec_inner_product_avx_dim(const float* x, const float* y, size_t) {
+    return fvec_dim_avx<false, D>(x, y);
+}
+
+template <size_t D>
+void
+fvec_L2sqr_batch_4_avx_dim(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                           const size_t, float& dis0, float& dis1, float& dis2, float& dis3) {
+    fvec_dim_batch_4_avx<true, D>(x, y0, y1, y2, y3, dis0, dis1, dis2, dis3);
+}
+
+template <size_t D>
+void
+fvec_inner_product_batch_4_avx_dim(const float* x, const float* y0, const float* y1, const float* y2,
+                                   const float* y3, const size_t, float& dis0, float& dis1, float& dis2,
+                                   float& dis3) {
+    fvec_dim_batch_4_avx<false, D>(x, y0, y1, y2, y3, dis0, dis1, dis2, dis3);
+}
+
+#define INSTANTIATE_FVEC_DIM_AVX(D)                                                                                    \
+    template float fvec_L2sqr_avx_dim<D>(const float*, const float*, size_t);                                          \
+    template float fvec_inner_product_avx_dim<D>(const float*, const float*, size_t);                                  \
+    template void fvec_L2sqr_batch_4_avx_dim<D>(const float*, const float*, const float*, const float*, const float*,  \
+                                                const size_t, float&, float&, float&, float&);                      \
+    template void fvec_inner_product_batch_4_avx_dim<D>(const float*, const float*, const float*, const float*,        \
+                                                        const float*, const size_t, float&, float&, float&, float&);
+FVEC_UNROLLED_DIMS(INSTANTIATE_FVEC_DIM_AVX)
+#undef INSTANTIATE_FVEC_DIM_AVX
+
 ///////////////////////////////////////////////////////////////////////////////
 // for cardinal
 
@@ -1109,6 +1265,28 @@ fvec_masked_sum_avx(const float* q, const uint8_t* x, const size_t d) {
     return horizontal_sum(sum_0);
 }
 
+size_t
+fvec_threshold_filter_avx(const float* dis, const size_t n, const float threshold, const bool greater,
+                          uint32_t* out) {
+    const __m256 thr = _mm256_set1_ps(threshold);
+    size_t m = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(dis + i);
+        uint32_t mask = _mm256_movemask_ps(greater ? _mm256_cmp_ps(v, thr, _CMP_GT_OQ)
+                                                   : _mm256_cmp_ps(v, thr, _CMP_LT_OQ));
+        while (mask != 0) {
+            out[m++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    for (; i < n; i++) {
+        out[m] = i;
+        m += greater ? (dis[i] > threshold) : (dis[i] < threshold);
+    }
+    return m;
+}
+
 int
 rabitq_dp_popcnt_avx(const uint8_t* q, const uint8_t* x, const size_t d, const size_t nb) {
     // this is the scheme for popcount
@@ -1145,5 +1323,321 @@ calculate_hash_avx2(const char* data, size_t size) {
     return XXH3_64bits(data, size);
 }
 
+void
+u64_minhash_update_avx(const uint64_t* tokens, const size_t n, const uint64_t* a, const uint64_t* b,
+                       const size_t num_perm, uint64_t* sig) {
+    // avx2 has neither a 64-bit multiply nor an unsigned 64-bit min. a * x (mod 2^64) is
+    //   lo(a) * lo(x) + ((hi(a) * lo(x) + lo(a) * hi(x)) << 32), and the unsigned order is the signed order of the
+    //   values with their sign bits flipped.
+    const __m256i sign = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+    size_t j = 0;
+    for (; j + 4 <= num_perm; j += 4) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + j));
+        const __m256i va_hi = _mm256_srli_epi64(va, 32);
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+        __m256i vsig = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sig + j)), sign);
+        for (size_t i = 0; i < n; i++) {
+            const __m256i x = _mm256_set1_epi64x(tokens[i]);
+            const __m256i x_hi = _mm256_set1_epi64x(tokens[i] >> 32);
+            const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(va_hi, x), _mm256_mul_epu32(va, x_hi));
+            const __m256i h = _mm256_add_epi64(
+                _mm256_add_epi64(_mm256_mul_epu32(va, x), _mm256_slli_epi64(cross, 32)), vb);
+            const __m256i h_signed = _mm256_xor_si256(h, sign);
+            vsig = _mm256_blendv_epi8(vsig, h_signed, _mm256_cmpgt_epi64(vsig, h_signed));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(sig + j), _mm256_xor_si256(vsig, sign));
+    }
+    for (; j < num_perm; j++) {
+        for (size_t i = 0; i < n; i++) {
+            sig[j] = std::min(sig[j], a[j] * tokens[i] + b[j]);
+        }
+    }
+}
+
+void
+u32_bitpacked_delta_decode_avx(const uint8_t* data, const size_t bits, const size_t n, const uint32_t base,
+                               uint32_t* out) {
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    for (size_t i = 0; i < n; i++) {
+        const size_t bit = i * bits;
+        uint64_t word;
+        memcpy(&word, data + bit / 8, sizeof(word));
+        out[i] = static_cast<uint32_t>((word >> (bit % 8)) & mask);
+    }
+
+    // prefix sums of 8 deltas at once
+    __m256i carry = _mm256_set1_epi32(base);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(out + i));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        // adds the sum of the low 128-bit lane to the high one
+        const __m256i low_sum = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(3));
+        x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_setzero_si256(), low_sum, 0xF0));
+        x = _mm256_add_epi32(x, carry);
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+        carry = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+    }
+    uint32_t prev = static_cast<uint32_t>(_mm256_cvtsi256_si32(carry));
+    for (; i < n; i++) {
+        prev += out[i];
+        out[i] = prev;
+    }
+}
+
+// the ids of 8 elements of 8 bytes that start with a u32 id
+static inline __m256i
+load_sparse_ids_8(const uint32_t* p) {
+    const __m256 lo = _mm256_loadu_ps((const float*)p);
+    const __m256 hi = _mm256_loadu_ps((const float*)(p + 8));
+    // ids 0 1 4 5 2 3 6 7
+    const __m256i ids = _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    return _mm256_permute4x64_epi64(ids, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+size_t
+u32_sparse_intersect_avx(const uint32_t* a, const size_t na, const uint32_t* b, const size_t nb, uint32_t* a_pos,
+                         uint32_t* b_pos) {
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    size_t i = 0, j = 0, n = 0;
+    // compares all the pairs of a block of 8 ids of a and of b, then moves past the block that ends first
+    while (i + 8 <= na && j + 8 <= nb) {
+        const __m256i va = load_sparse_ids_8(a + 2 * i);
+        __m256i vb = load_sparse_ids_8(b + 2 * j);
+        uint32_t a_mask = 0, b_mask = 0;
+        for (uint32_t r = 0; r < 8; r++) {
+            // bit k of m is set if a[i + k] == b[j + (k + r) % 8]
+            const uint32_t m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(va, vb)));
+            a_mask |= m;
+            b_mask |= ((m << r) | (m >> (8 - r))) & 0xFF;
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+        }
+        // the common ids are in the same order in both blocks
+        for (; a_mask != 0; a_mask &= a_mask - 1, b_mask &= b_mask - 1) {
+            a_pos[n] = i + __builtin_ctz(a_mask);
+            b_pos[n++] = j + __builtin_ctz(b_mask);
+        }
+        const uint32_t a_last = a[2 * (i + 7)];
+        const uint32_t b_last = b[2 * (j + 7)];
+        i += a_last <= b_last ? 8 : 0;
+        j += b_last <= a_last ? 8 : 0;
+    }
+    for (; i < na && j < nb;) {
+        const uint32_t x = a[2 * i];
+        const uint32_t y = b[2 * j];
+        if (x == y) {
+            a_pos[n] = i++;
+            b_pos[n++] = j++;
+        } else if (x < y) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return n;
+}
+
+namespace {
+// transposes the 16 bytes at offset j of the 32 codes of a block, plane k then holds byte j + k of codes 0-15 in the
+// low lane and of codes 16-31 in the high lane
+inline void
+transpose_pq4_codes_16(const uint8_t* block, const size_t stride, __m256i* planes) {
+    __m256i a[16], b[16];
+    for (size_t i = 0; i < 16; i++) {
+        a[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(block + i * stride))),
+                                       _mm_loadu_si128((const __m128i*)(block + (i + 16) * stride)), 1);
+    }
+    // each step interleaves elements of twice the size from pairs of the previous step
+    for (size_t p = 0; p < 8; p++) {
+        b[2 * p] = _mm256_unpacklo_epi8(a[2 * p], a[2 * p + 1]);
+        b[2 * p + 1] = _mm256_unpackhi_epi8(a[2 * p], a[2 * p + 1]);
+    }
+    for (size_t q = 0; q < 4; q++) {
+        for (size_t h = 0; h < 2; h++) {
+            a[4 * q + 2 * h] = _mm256_unpacklo_epi16(b[4 * q + h], b[4 * q + 2 + h]);
+            a[4 * q + 2 * h + 1] = _mm256_unpackhi_epi16(b[4 * q + h], b[4 * q + 2 + h]);
+        }
+    }
+    for (size_t o = 0; o < 2; o++) {
+        for (size_t g = 0; g < 4; g++) {
+            b[8 * o + 2 * g] = _mm256_unpacklo_epi32(a[8 * o + g], a[8 * o + 4 + g]);
+            b[8 * o + 2 * g + 1] = _mm256_unpackhi_epi32(a[8 * o + g], a[8 * o + 4 + g]);
+        }
+    }
+    for (size_t f = 0; f < 8; f++) {
+        planes[2 * f] = _mm256_unpacklo_epi64(b[f], b[8 + f]);
+        planes[2 * f + 1] = _mm256_unpackhi_epi64(b[f], b[8 + f]);
+    }
+}
+}  // namespace
+
+void
+u8_pq4_fast_scan_avx(const uint8_t* codes, const size_t nb, const size_t nbytes, const uint8_t* lut, uint16_t* out) {
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    const __m256i low_byte = _mm256_set1_epi16(0x00ff);
+    __m256i planes[16];
+    for (size_t b = 0; b < nb; b++) {
+        const uint8_t* block = codes + b * 32 * nbytes;
+        // the sums of the even and of the odd codes of each lane
+        __m256i even = _mm256_setzero_si256();
+        __m256i odd = _mm256_setzero_si256();
+        for (size_t j = 0; j < nbytes; j += 16) {
+            // the planes past the last byte are not used
+            const size_t n = std::min<size_t>(16, nbytes - j);
+            transpose_pq4_codes_16(block + j, nbytes, planes);
+            for (size_t k = 0; k < n; k++) {
+                const uint8_t* l = lut + (j + k) * 32;
+                const __m256i c = planes[k];
+                const __m256i lut_lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)l));
+                const __m256i lut_hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(l + 16)));
+                const __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(c, low_nibble));
+                const __m256i hi = _mm256_shuffle_epi8(lut_hi, _mm256_and_si256(_mm256_srli_epi16(c, 4), low_nibble));
+                even = _mm256_add_epi16(
+                    even, _mm256_add_epi16(_mm256_and_si256(lo, low_byte), _mm256_and_si256(hi, low_byte)));
+                odd = _mm256_add_epi16(odd, _mm256_add_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+            }
+        }
+        // interleaves the codes back within each lane, then puts the lanes in order
+        const __m256i r_lo = _mm256_unpacklo_epi16(even, odd);
+        const __m256i r_hi = _mm256_unpackhi_epi16(even, odd);
+        _mm256_storeu_si256((__m256i*)(out + b * 32), _mm256_permute2x128_si256(r_lo, r_hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + b * 32 + 16), _mm256_permute2x128_si256(r_lo, r_hi, 0x31));
+    }
+}
+
+namespace {
+
+struct U8XorOp {
+    __m256i
+    operator()(const __m256i a, const __m256i b) const {
+        return _mm256_xor_si256(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a ^ b;
+    }
+};
+
+struct U8AndOp {
+    __m256i
+    operator()(const __m256i a, const __m256i b) const {
+        return _mm256_and_si256(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a & b;
+    }
+};
+
+struct U8OrOp {
+    __m256i
+    operator()(const __m256i a, const __m256i b) const {
+        return _mm256_or_si256(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a | b;
+    }
+};
+
+// the popcounts of the 4 u64 of v, with the nibble lookup of Mula et al.
+inline __m256i
+popcnt_epi64_avx(const __m256i v) {
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2,
+                                         3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low_mask));
+    const __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+// writes the popcounts of op(x, y_r) for the N contiguous codes y_r to res, the codes share the loads of x
+template <size_t N, typename Op>
+inline void
+u8_popcnt_batch_avx(const uint8_t* x, const uint8_t* y, const size_t code_size, const Op op, int32_t* res) {
+    for (size_t r = 0; r < N; r++) {
+        res[r] = 0;
+    }
+    size_t i = 0;
+    if (code_size >= 32) {
+        __m256i acc[N];
+        for (size_t r = 0; r < N; r++) {
+            acc[r] = _mm256_setzero_si256();
+        }
+        for (; i + 32 <= code_size; i += 32) {
+            const __m256i mx = _mm256_loadu_si256((const __m256i*)(x + i));
+            for (size_t r = 0; r < N; r++) {
+                const __m256i my = _mm256_loadu_si256((const __m256i*)(y + r * code_size + i));
+                acc[r] = _mm256_add_epi64(acc[r], popcnt_epi64_avx(op(mx, my)));
+            }
+        }
+        for (size_t r = 0; r < N; r++) {
+            const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc[r]), _mm256_extracti128_si256(acc[r], 1));
+            res[r] = (int32_t)(_mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1));
+        }
+    }
+    for (; i + 8 <= code_size; i += 8) {
+        uint64_t a;
+        std::memcpy(&a, x + i, 8);
+        for (size_t r = 0; r < N; r++) {
+            uint64_t b;
+            std::memcpy(&b, y + r * code_size + i, 8);
+            res[r] += __builtin_popcountll(op(a, b));
+        }
+    }
+    if (i + 4 <= code_size) {
+        uint32_t a;
+        std::memcpy(&a, x + i, 4);
+        for (size_t r = 0; r < N; r++) {
+            uint32_t b;
+            std::memcpy(&b, y + r * code_size + i, 4);
+            res[r] += __builtin_popcountll(op((uint64_t)a, (uint64_t)b));
+        }
+        i += 4;
+    }
+    for (; i < code_size; i++) {
+        for (size_t r = 0; r < N; r++) {
+            res[r] += __builtin_popcountll(op((uint64_t)x[i], (uint64_t)y[r * code_size + i]));
+        }
+    }
+}
+
+}  // namespace
+
+void
+u8_hamming_distance_ny_avx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                           int32_t* dis) {
+    size_t j = 0;
+    for (; j + 4 <= ny; j += 4) {
+        u8_popcnt_batch_avx<4>(x, y + j * code_size, code_size, U8XorOp{}, dis + j);
+    }
+    for (; j < ny; j++) {
+        u8_popcnt_batch_avx<1>(x, y + j * code_size, code_size, U8XorOp{}, dis + j);
+    }
+}
+
+void
+u8_jaccard_distance_ny_avx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis) {
+    int32_t num[4];
+    int32_t den[4];
+    for (size_t j = 0; j < ny; j += 4) {
+        const size_t n = std::min<size_t>(4, ny - j);
+        const uint8_t* y_j = y + j * code_size;
+        if (n == 4) {
+            u8_popcnt_batch_avx<4>(x, y_j, code_size, U8AndOp{}, num);
+            u8_popcnt_batch_avx<4>(x, y_j, code_size, U8OrOp{}, den);
+        } else {
+            for (size_t r = 0; r < n; r++) {
+                u8_popcnt_batch_avx<1>(x, y_j + r * code_size, code_size, U8AndOp{}, num + r);
+                u8_popcnt_batch_avx<1>(x, y_j + r * code_size, code_size, U8OrOp{}, den + r);
+            }
+        }
+        for (size_t r = 0; r < n; r++) {
+            dis[j + r] = den[r] == 0 ? 1.0f : (float)(den[r] - num[r]) / (float)den[r];
+        }
+    }
+}
+
 }  // namespace faiss
 #endif
@@ -127,6 +127,38 @@ void
 int8_vec_L2sqr_batch_4_avx(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2, const int8_t* y3,
                            const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
 
+///////////////////////////////////////////////////////////////////////////////
+// batch_8
+
+void
+fvec_inner_product_batch_8_avx(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fvec_L2sqr_batch_8_avx(const float* x, const float* const* y, const size_t d, float* dis);
+
+///////////////////////////////////////////////////////////////////////////////
+// fixed dims
+// unrolled for vectors of D dims, see fvec_dim_kernels(). d is ignored, it is there to match the hooks.
+
+template <size_t D>
+float
+fvec_L2sqr_avx_dim(const float* x, const float* y, size_t d);
+
+template <size_t D>
+float
+fvec_inner_product_avx_dim(const float* x, const float* y, size_t d);
+
+template <size_t D>
+void
+fvec_L2sqr_batch_4_avx_dim(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                           const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
+
+template <size_t D>
+void
+fvec_inner_product_batch_4_avx_dim(const float* x, const float* y0, const float* y1, const float* y2,
+                                   const float* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                   float& dis3);
+
 ///////////////////////////////////////////////////////////////////////////////
 // for cardinal
 
@@ -145,6 +177,12 @@ void
 fvec_L2sqr_batch_4_bf16_patch_avx(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
                                   const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
 
+///////////////////////////////////////////////////////////////////////////////
+// threshold filter
+size_t
+fvec_threshold_filter_avx(const float* dis, const size_t n, const float threshold, const bool greater,
+                          uint32_t* out);
+
 ///////////////////////////////////////////////////////////////////////////////
 // rabitq
 float
@@ -156,5 +194,29 @@ rabitq_dp_popcnt_avx(const uint8_t* q, const uint8_t* x, const size_t d, const s
 // minhash
 uint64_t
 calculate_hash_avx2(const char* data, size_t size);
+void
+u64_minhash_update_avx(const uint64_t* tokens, const size_t n, const uint64_t* a, const uint64_t* b,
+                       const size_t num_perm, uint64_t* sig);
+
+///////////////////////////////////////////////////////////////////////////////
+// sparse
+void
+u32_bitpacked_delta_decode_avx(const uint8_t* data, const size_t bits, const size_t n, const uint32_t base,
+                               uint32_t* out);
+size_t
+u32_sparse_intersect_avx(const uint32_t* a, const size_t na, const uint32_t* b, const size_t nb, uint32_t* a_pos,
+                         uint32_t* b_pos);
+
+///////////////////////////////////////////////////////////////////////////////
+// pq
+void
+u8_pq4_fast_scan_avx(const uint8_t* codes, const size_t nb, const size_t nbytes, const uint8_t* lut, uint16_t* out);
+
+///////////////////////////////////////////////////////////////////////////////
+// binary
+void
+u8_hamming_distance_ny_avx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, int32_t* dis);
+void
+u8_jaccard_distance_ny_avx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis);
 
 }  // namespace faiss
@@ -17,10 +17,14 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 #include "faiss/impl/platform_macros.h"
+#include "hook.h"
 #include "xxhash.h"
 
 namespace faiss {
@@ -47,6 +51,124 @@ inline __m512
 _mm512_bf16_to_fp32(const __m256i& x) {
     return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(x), 16));
 }
+
+// accumulates the inner product or the squared L2 distance of 16 dims
+template <bool L2>
+inline __m512
+batch_8_step(const __m512 res, const __m512 mx, __m512 my) {
+    if constexpr (L2) {
+        my = _mm512_sub_ps(mx, my);
+        return _mm512_fmadd_ps(my, my, res);
+    } else {
+        return _mm512_fmadd_ps(mx, my, res);
+    }
+}
+
+// Load reads the 16 values at p whose bits are set in mask as fp32. The query stays in a register while it is scored
+// against the 8 vectors y.
+template <bool L2, typename Load, typename T>
+inline void
+batch_8_avx512(const T* x, const T* const* y, const size_t d, float* dis) {
+    const T *y0 = y[0], *y1 = y[1], *y2 = y[2], *y3 = y[3], *y4 = y[4], *y5 = y[5], *y6 = y[6], *y7 = y[7];
+    __m512 res0 = _mm512_setzero_ps(), res1 = _mm512_setzero_ps(), res2 = _mm512_setzero_ps(),
+           res3 = _mm512_setzero_ps(), res4 = _mm512_setzero_ps(), res5 = _mm512_setzero_ps(),
+           res6 = _mm512_setzero_ps(), res7 = _mm512_setzero_ps();
+    auto step = [&](const size_t i, const __mmask16 mask) {
+        const __m512 mx = Load::load(x + i, mask);
+        res0 = batch_8_step<L2>(res0, mx, Load::load(y0 + i, mask));
+        res1 = batch_8_step<L2>(res1, mx, Load::load(y1 + i, mask));
+        res2 = batch_8_step<L2>(res2, mx, Load::load(y2 + i, mask));
+        res3 = batch_8_step<L2>(res3, mx, Load::load(y3 + i, mask));
+        res4 = batch_8_step<L2>(res4, mx, Load::load(y4 + i, mask));
+        res5 = batch_8_step<L2>(res5, mx, Load::load(y5 + i, mask));
+        res6 = batch_8_step<L2>(res6, mx, Load::load(y6 + i, mask));
+        res7 = batch_8_step<L2>(res7, mx, Load::load(y7 + i, mask));
+    };
+    size_t i = 0;
+    for (; i + 16 <= d; i += 16) {
+        step(i, 0xFFFF);
+    }
+    if (i < d) {
+        step(i, (__mmask16)((1U << (d - i)) - 1U));
+    }
+    dis[0] = _mm512_reduce_add_ps(res0);
+    dis[1] = _mm512_reduce_add_ps(res1);
+    dis[2] = _mm512_reduce_add_ps(res2);
+    dis[3] = _mm512_reduce_add_ps(res3);
+    dis[4] = _mm512_reduce_add_ps(res4);
+    dis[5] = _mm512_reduce_add_ps(res5);
+    dis[6] = _mm512_reduce_add_ps(res6);
+    dis[7] = _mm512_reduce_add_ps(res7);
+}
+
+struct LoadFp32 {
+    static inline __m512
+    load(const float* x, const __mmask16 mask) {
+        return _mm512_maskz_loadu_ps(mask, x);
+    }
+};
+
+struct LoadFp16 {
+    static inline __m512
+    load(const knowhere::fp16* x, const __mmask16 mask) {
+        return _mm512_cvtph_ps(_mm256_maskz_loadu_epi16(mask, x));
+    }
+};
+
+struct LoadBf16 {
+    static inline __m512
+    load(const knowhere::bf16* x, const __mmask16 mask) {
+        return _mm512_bf16_to_fp32(_mm256_maskz_loadu_epi16(mask, x));
+    }
+};
+
+// the int8 products of 32 dims are summed in int32, exact as in the kernels of a single vector
+template <bool L2>
+inline __m512i
+int8_batch_8_step(const __m512i res, const __m512i mx, const int8_t* y, const __mmask32 mask) {
+    __m512i my = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, y));
+    if constexpr (L2) {
+        my = _mm512_sub_epi16(mx, my);
+        return _mm512_add_epi32(res, _mm512_madd_epi16(my, my));
+    } else {
+        return _mm512_add_epi32(res, _mm512_madd_epi16(mx, my));
+    }
+}
+
+template <bool L2>
+inline void
+int8_batch_8_avx512(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    const int8_t *y0 = y[0], *y1 = y[1], *y2 = y[2], *y3 = y[3], *y4 = y[4], *y5 = y[5], *y6 = y[6], *y7 = y[7];
+    __m512i res0 = _mm512_setzero_si512(), res1 = _mm512_setzero_si512(), res2 = _mm512_setzero_si512(),
+            res3 = _mm512_setzero_si512(), res4 = _mm512_setzero_si512(), res5 = _mm512_setzero_si512(),
+            res6 = _mm512_setzero_si512(), res7 = _mm512_setzero_si512();
+    auto step = [&](const size_t i, const __mmask32 mask) {
+        const __m512i mx = _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, x + i));
+        res0 = int8_batch_8_step<L2>(res0, mx, y0 + i, mask);
+        res1 = int8_batch_8_step<L2>(res1, mx, y1 + i, mask);
+        res2 = int8_batch_8_step<L2>(res2, mx, y2 + i, mask);
+        res3 = int8_batch_8_step<L2>(res3, mx, y3 + i, mask);
+        res4 = int8_batch_8_step<L2>(res4, mx, y4 + i, mask);
+        res5 = int8_batch_8_step<L2>(res5, mx, y5 + i, mask);
+        res6 = int8_batch_8_step<L2>(res6, mx, y6 + i, mask);
+        res7 = int8_batch_8_step<L2>(res7, mx, y7 + i, mask);
+    };
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        step(i, 0xFFFFFFFF);
+    }
+    if (i < d) {
+        step(i, (__mmask32)((1ULL << (d - i)) - 1ULL));
+    }
+    dis[0] = (float)_mm512_reduce_add_epi32(res0);
+    dis[1] = (float)_mm512_reduce_add_epi32(res1);
+    dis[2] = (float)_mm512_reduce_add_epi32(res2);
+    dis[3] = (float)_mm512_reduce_add_epi32(res3);
+    dis[4] = (float)_mm512_reduce_add_epi32(res4);
+    dis[5] = (float)_mm512_reduce_add_epi32(res5);
+    dis[6] = (float)_mm512_reduce_add_epi32(res6);
+    dis[7] = (float)_mm512_reduce_add_epi32(res7);
+}
 }  // namespace
 
 // trust the compiler to unroll this properly
@@ -773,6 +895,139 @@ int8_vec_L2sqr_batch_4_avx512(const int8_t* x, const int8_t* y0, const int8_t* y
 }
 FAISS_PRAGMA_IMPRECISE_FUNCTION_END
 
+///////////////////////////////////////////////////////////////////////////////
+// batch_8
+
+void
+fvec_inner_product_batch_8_avx512(const float* x, const float* const* y, const size_t d, float* dis) {
+    batch_8_avx512<false, LoadFp32>(x, y, d, dis);
+}
+
+void
+fvec_L2sqr_batch_8_avx512(const float* x, const float* const* y, const size_t d, float* dis) {
+    batch_8_avx512<true, LoadFp32>(x, y, d, dis);
+}
+
+void
+fp16_vec_inner_product_batch_8_avx512(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                      float* dis) {
+    batch_8_avx512<false, LoadFp16>(x, y, d, dis);
+}
+
+void
+fp16_vec_L2sqr_batch_8_avx512(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis) {
+    batch_8_avx512<true, LoadFp16>(x, y, d, dis);
+}
+
+void
+bf16_vec_inner_product_batch_8_avx512(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d,
+                                      float* dis) {
+    batch_8_avx512<false, LoadBf16>(x, y, d, dis);
+}
+
+void
+bf16_vec_L2sqr_batch_8_avx512(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis) {
+    batch_8_avx512<true, LoadBf16>(x, y, d, dis);
+}
+
+void
+int8_vec_inner_product_batch_8_avx512(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    int8_batch_8_avx512<false>(x, y, d, dis);
+}
+
+void
+int8_vec_L2sqr_batch_8_avx512(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    int8_batch_8_avx512<true>(x, y, d, dis);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// fixed dims
+
+namespace {
+// calls f with the steps 0, 1, ..., unrolled at compile time
+template <typename F, size_t... Steps>
+inline void
+unroll_steps(F&& f, std::index_sequence<Steps...>) {
+    (f(std::integral_constant<size_t, Steps>{}), ...);
+}
+
+// 4 accumulators of 16 dims hide the latency of the fma, D is a multiple of 64 so there is no tail to mask
+template <bool L2, size_t D>
+inline float
+fvec_dim_avx512(const float* x, const float* y) {
+    static_assert(D % 64 == 0, "the dims of a fixed dim kernel are a multiple of 64");
+    __m512 res[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+    unroll_steps(
+        [&](auto step) {
+            constexpr size_t i = step * 16;
+            res[step % 4] = batch_8_step<L2>(res[step % 4], _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i));
+        },
+        std::make_index_sequence<D / 16>{});
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(res[0], res[1]), _mm512_add_ps(res[2], res[3])));
+}
+
+template <bool L2, size_t D>
+inline void
+fvec_dim_batch_4_avx512(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                        float& dis0, float& dis1, float& dis2, float& dis3) {
+    static_assert(D % 64 == 0, "the dims of a fixed dim kernel are a multiple of 64");
+    __m512 res0 = _mm512_setzero_ps(), res1 = _mm512_setzero_ps(), res2 = _mm512_setzero_ps(),
+           res3 = _mm512_setzero_ps();
+    unroll_steps(
+        [&](auto step) {
+            constexpr size_t i = step * 16;
+            const __m512 mx = _mm512_loadu_ps(x + i);
+            res0 = batch_8_step<L2>(res0, mx, _mm512_loadu_ps(y0 + i));
+            res1 = batch_8_step<L2>(res1, mx, _mm512_loadu_ps(y1 + i));
+            res2 = batch_8_step<L2>(res2, mx, _mm512_loadu_ps(y2 + i));
+            res3 = batch_8_step<L2>(res3, mx, _mm512_loadu_ps(y3 + i));
+        },
+        std::make_index_sequence<D / 16>{});
+    dis0 = _mm512_reduce_add_ps(res0);
+    dis1 = _mm512_reduce_add_ps(res1);
+    dis2 = _mm512_reduce_add_ps(res2);
+    dis3 = _mm512_reduce_add_ps(res3);
+}
+}  // namespace
+
+template <size_t D>
+float
+fvec_L2sqr_avx512_dim(const float* x, const float* y, size_t) {
+    return fvec_dim_avx512<true, D>(x, y);
+}
+
+template <size_t D>
+float
+fvec_inner_product_avx512_dim(const float* x, const float* y, size_t) {
+    return fvec_dim_avx512<false, D>(x, y);
+}
+
+template <size_t D>
+void
+fvec_L2sqr_batch_4_avx512_dim(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                              const size_t, float& dis0, float& dis1, float& dis2, float& dis3) {
+    fvec_dim_batch_4_avx512<true, D>(x, y0, y1, y2, y3, dis0, dis1, dis2, dis3);
+}
+
+template <size_t D>
+void
+fvec_inner_product_batch_4_avx512_dim(const float* x, const float* y0, const float* y1, const float* y2,
+                                      const float* y3, const size_t, float& dis0, float& dis1, float& dis2,
+                                      float& dis3) {
+    fvec_dim_batch_4_avx512<false, D>(x, y0, y1, y2, y3, dis0, dis1, dis2, dis3);
+}
+
+#define INSTANTIATE_FVEC_DIM_AVX512(D)                                                                                 \
+    template float fvec_L2sqr_avx512_dim<D>(const float*, const float*, size_t);                                       \
+    template float fvec_inner_product_avx512_dim<D>(const float*, const float*, size_t);                               \
+    template void fvec_L2sqr_batch_4_avx512_dim<D>(const float*, const float*, const float*, const float*,             \
+                                                   const float*, const size_t, float&, float&, float&, float&);        \
+    template void fvec_inner_product_batch_4_avx512_dim<D>(const float*, const float*, const float*, const float*,     \
+                                                           const float*, const size_t, float&, float&, float&,         \
+                                                           float&);
+FVEC_UNROLLED_DIMS(INSTANTIATE_FVEC_DIM_AVX512)
+#undef INSTANTIATE_FVEC_DIM_AVX512
+
 ///////////////////////////////////////////////////////////////////////////////
 // for cardinal
 
@@ -849,6 +1104,28 @@ fvec_L2sqr_batch_4_bf16_patch_avx512(const float* x, const float* y0, const floa
 }
 FAISS_PRAGMA_IMPRECISE_FUNCTION_END
 
+///////////////////////////////////////////////////////////////////////////////
+// threshold filter
+size_t
+fvec_threshold_filter_avx512(const float* dis, const size_t n, const float threshold, const bool greater,
+                             uint32_t* out) {
+    const __m512 thr = _mm512_set1_ps(threshold);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i pos = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t m = 0;
+    for (size_t i = 0; i < n; i += 16) {
+        const __mmask16 valid = n - i >= 16 ? 0xffff : (1U << (n - i)) - 1U;
+        const __m512 v = _mm512_maskz_loadu_ps(valid, dis + i);
+        const __mmask16 mask = greater ? _mm512_mask_cmp_ps_mask(valid, v, thr, _CMP_GT_OQ)
+                                       : _mm512_mask_cmp_ps_mask(valid, v, thr, _CMP_LT_OQ);
+        // the positions of the survivors are packed to the front, branch free
+        _mm512_mask_compressstoreu_epi32(out + m, mask, pos);
+        m += __builtin_popcount(mask);
+        pos = _mm512_add_epi32(pos, step);
+    }
+    return m;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // rabitq
 float
@@ -1156,5 +1433,116 @@ u64_jaccard_distance_batch_4_avx512(const char* x, const char* y0, const char* y
     dis2 = float(d2) / element_length;
     dis3 = float(d3) / element_length;
 }
+
+void
+u64_minhash_update_avx512(const uint64_t* tokens, const size_t n, const uint64_t* a, const uint64_t* b,
+                          const size_t num_perm, uint64_t* sig) {
+    // 16 hash functions per pass over the tokens, two independent chains of 8 lanes
+    size_t j = 0;
+    for (; j + 16 <= num_perm; j += 16) {
+        const __m512i a0 = _mm512_loadu_si512(a + j);
+        const __m512i a1 = _mm512_loadu_si512(a + j + 8);
+        const __m512i b0 = _mm512_loadu_si512(b + j);
+        const __m512i b1 = _mm512_loadu_si512(b + j + 8);
+        __m512i sig0 = _mm512_loadu_si512(sig + j);
+        __m512i sig1 = _mm512_loadu_si512(sig + j + 8);
+        for (size_t i = 0; i < n; i++) {
+            const __m512i x = _mm512_set1_epi64(tokens[i]);
+            sig0 = _mm512_min_epu64(sig0, _mm512_add_epi64(_mm512_mullo_epi64(a0, x), b0));
+            sig1 = _mm512_min_epu64(sig1, _mm512_add_epi64(_mm512_mullo_epi64(a1, x), b1));
+        }
+        _mm512_storeu_si512(sig + j, sig0);
+        _mm512_storeu_si512(sig + j + 8, sig1);
+    }
+    for (; j < num_perm; j += 8) {
+        const __mmask8 mask = num_perm - j >= 8 ? 0xff : (1U << (num_perm - j)) - 1U;
+        const __m512i va = _mm512_maskz_loadu_epi64(mask, a + j);
+        const __m512i vb = _mm512_maskz_loadu_epi64(mask, b + j);
+        __m512i vsig = _mm512_maskz_loadu_epi64(mask, sig + j);
+        for (size_t i = 0; i < n; i++) {
+            const __m512i x = _mm512_set1_epi64(tokens[i]);
+            vsig = _mm512_min_epu64(vsig, _mm512_add_epi64(_mm512_mullo_epi64(va, x), vb));
+        }
+        _mm512_mask_storeu_epi64(sig + j, mask, vsig);
+    }
+}
+
+void
+u32_bitpacked_delta_decode_avx512(const uint8_t* data, const size_t bits, const size_t n, const uint32_t base,
+                                  uint32_t* out) {
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    for (size_t i = 0; i < n; i++) {
+        const size_t bit = i * bits;
+        uint64_t word;
+        memcpy(&word, data + bit / 8, sizeof(word));
+        out[i] = static_cast<uint32_t>((word >> (bit % 8)) & mask);
+    }
+
+    // prefix sums of 16 deltas at once, alignr shifts the elements up with zeros
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i carry = _mm512_set1_epi32(base);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(out + i);
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 15));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 14));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 12));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 8));
+        x = _mm512_add_epi32(x, carry);
+        _mm512_storeu_si512(out + i, x);
+        carry = _mm512_permutexvar_epi32(_mm512_set1_epi32(15), x);
+    }
+    uint32_t prev = static_cast<uint32_t>(_mm512_cvtsi512_si32(carry));
+    for (; i < n; i++) {
+        prev += out[i];
+        out[i] = prev;
+    }
+}
+
+size_t
+u32_sparse_intersect_avx512(const uint32_t* a, const size_t na, const uint32_t* b, const size_t nb, uint32_t* a_pos,
+                            uint32_t* b_pos) {
+    // the ids of 16 elements of 8 bytes that start with a u32 id
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    auto load_ids = [&](const uint32_t* p) {
+        return _mm512_permutex2var_epi32(_mm512_loadu_si512(p), even, _mm512_loadu_si512(p + 16));
+    };
+    size_t i = 0, j = 0, n = 0;
+    // compares all the pairs of a block of 16 ids of a and of b, then moves past the block that ends first
+    while (i + 16 <= na && j + 16 <= nb) {
+        const __m512i va = load_ids(a + 2 * i);
+        __m512i vb = load_ids(b + 2 * j);
+        uint32_t a_mask = 0, b_mask = 0;
+        for (uint32_t r = 0; r < 16; r++) {
+            // bit k of m is set if a[i + k] == b[j + (k + r) % 16]
+            const uint32_t m = _mm512_cmpeq_epi32_mask(va, vb);
+            a_mask |= m;
+            b_mask |= ((m << r) | (m >> (16 - r))) & 0xFFFF;
+            vb = _mm512_alignr_epi32(vb, vb, 1);
+        }
+        // the common ids are in the same order in both blocks
+        for (; a_mask != 0; a_mask &= a_mask - 1, b_mask &= b_mask - 1) {
+            a_pos[n] = i + __builtin_ctz(a_mask);
+            b_pos[n++] = j + __builtin_ctz(b_mask);
+        }
+        const uint32_t a_last = a[2 * (i + 15)];
+        const uint32_t b_last = b[2 * (j + 15)];
+        i += a_last <= b_last ? 16 : 0;
+        j += b_last <= a_last ? 16 : 0;
+    }
+    for (; i < na && j < nb;) {
+        const uint32_t x = a[2 * i];
+        const uint32_t y = b[2 * j];
+        if (x == y) {
+            a_pos[n] = i++;
+            b_pos[n++] = j++;
+        } else if (x < y) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return n;
+}
 }  // namespace faiss
 #endif
@@ -121,6 +121,58 @@ void
 int8_vec_L2sqr_batch_4_avx512(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2, const int8_t* y3,
                               const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
 
+///////////////////////////////////////////////////////////////////////////////
+// batch_8
+
+void
+fvec_inner_product_batch_8_avx512(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fvec_L2sqr_batch_8_avx512(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fp16_vec_inner_product_batch_8_avx512(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                      float* dis);
+
+void
+fp16_vec_L2sqr_batch_8_avx512(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis);
+
+void
+bf16_vec_inner_product_batch_8_avx512(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d,
+                                      float* dis);
+
+void
+bf16_vec_L2sqr_batch_8_avx512(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis);
+
+void
+int8_vec_inner_product_batch_8_avx512(const int8_t* x, const int8_t* const* y, const size_t d, float* dis);
+
+void
+int8_vec_L2sqr_batch_8_avx512(const int8_t* x, const int8_t* const* y, const size_t d, float* dis);
+
+///////////////////////////////////////////////////////////////////////////////
+// fixed dims
+// unrolled for vectors of D dims, see fvec_dim_kernels(). d is ignored, it is there to match the hooks.
+
+template <size_t D>
+float
+fvec_L2sqr_avx512_dim(const float* x, const float* y, size_t d);
+
+template <size_t D>
+float
+fvec_inner_product_avx512_dim(const float* x, const float* y, size_t d);
+
+template <size_t D>
+void
+fvec_L2sqr_batch_4_avx512_dim(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                              const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
+
+template <size_t D>
+void
+fvec_inner_product_batch_4_avx512_dim(const float* x, const float* y0, const float* y1, const float* y2,
+                                      const float* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                      float& dis3);
+
 ///////////////////////////////////////////////////////////////////////////////
 // for cardinal
 
@@ -139,6 +191,12 @@ void
 fvec_L2sqr_batch_4_bf16_patch_avx512(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
                                      const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
 
+///////////////////////////////////////////////////////////////////////////////
+// threshold filter
+size_t
+fvec_threshold_filter_avx512(const float* dis, const size_t n, const float threshold, const bool greater,
+                             uint32_t* out);
+
 ///////////////////////////////////////////////////////////////////////////////
 // rabitq
 float
@@ -165,4 +223,16 @@ u64_jaccard_distance_avx512(const char*, const char*, size_t size, size_t);
 void
 u64_jaccard_distance_batch_4_avx512(const char*, const char*, const char*, const char*, const char*, size_t, size_t,
                                     float&, float&, float&, float&);
+void
+u64_minhash_update_avx512(const uint64_t* tokens, const size_t n, const uint64_t* a, const uint64_t* b,
+                          const size_t num_perm, uint64_t* sig);
+
+///////////////////////////////////////////////////////////////////////////////
+// sparse
+void
+u32_bitpacked_delta_decode_avx512(const uint8_t* data, const size_t bits, const size_t n, const uint32_t base,
+                                  uint32_t* out);
+size_t
+u32_sparse_intersect_avx512(const uint32_t* a, const size_t na, const uint32_t* b, const size_t nb, uint32_t* a_pos,
+                            uint32_t* b_pos);
 }  // namespace faiss
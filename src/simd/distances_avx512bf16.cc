@@ -0,0 +1,125 @@
+// Copyright (C) 2019-2025 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License
+// is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing permissions and limitations under the License.
+
+#if defined(__x86_64__)
+
+#include "distances_avx512bf16.h"
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace faiss {
+
+namespace {
+
+// 32 bf16 values, a vdpbf16ps operand
+inline __m512bh
+load_bf16x32(const knowhere::bf16* x) {
+    return (__m512bh)_mm512_loadu_si512((const void*)x);
+}
+
+inline __m512bh
+load_bf16x32(const knowhere::bf16* x, const size_t d) {
+    const __mmask32 mask = (__mmask32)((1ULL << d) - 1ULL);
+    return (__m512bh)_mm512_maskz_loadu_epi16(mask, (const void*)x);
+}
+
+}  // namespace
+
+float
+bf16_vec_inner_product_avx512bf16(const knowhere::bf16* x, const knowhere::bf16* y, size_t d) {
+    __m512 m512_res = _mm512_setzero_ps();
+    __m512 m512_res_0 = _mm512_setzero_ps();
+    while (d >= 64) {
+        m512_res = _mm512_dpbf16_ps(m512_res, load_bf16x32(x), load_bf16x32(y));
+        m512_res_0 = _mm512_dpbf16_ps(m512_res_0, load_bf16x32(x + 32), load_bf16x32(y + 32));
+        x += 64;
+        y += 64;
+        d -= 64;
+    }
+    m512_res = m512_res + m512_res_0;
+    if (d >= 32) {
+        m512_res = _mm512_dpbf16_ps(m512_res, load_bf16x32(x), load_bf16x32(y));
+        x += 32;
+        y += 32;
+        d -= 32;
+    }
+    if (d > 0) {
+        m512_res = _mm512_dpbf16_ps(m512_res, load_bf16x32(x, d), load_bf16x32(y, d));
+    }
+    return _mm512_reduce_add_ps(m512_res);
+}
+
+float
+bf16_vec_norm_L2sqr_avx512bf16(const knowhere::bf16* x, size_t d) {
+    __m512 m512_res = _mm512_setzero_ps();
+    __m512 m512_res_0 = _mm512_setzero_ps();
+    while (d >= 64) {
+        auto mx = load_bf16x32(x);
+        auto mx_0 = load_bf16x32(x + 32);
+        m512_res = _mm512_dpbf16_ps(m512_res, mx, mx);
+        m512_res_0 = _mm512_dpbf16_ps(m512_res_0, mx_0, mx_0);
+        x += 64;
+        d -= 64;
+    }
+    m512_res = m512_res + m512_res_0;
+    if (d >= 32) {
+        auto mx = load_bf16x32(x);
+        m512_res = _mm512_dpbf16_ps(m512_res, mx, mx);
+        x += 32;
+        d -= 32;
+    }
+    if (d > 0) {
+        auto mx = load_bf16x32(x, d);
+        m512_res = _mm512_dpbf16_ps(m512_res, mx, mx);
+    }
+    return _mm512_reduce_add_ps(m512_res);
+}
+
+void
+bf16_vec_inner_product_batch_4_avx512bf16(const knowhere::bf16* x, const knowhere::bf16* y0, const knowhere::bf16* y1,
+                                          const knowhere::bf16* y2, const knowhere::bf16* y3, const size_t d,
+                                          float& dis0, float& dis1, float& dis2, float& dis3) {
+    __m512 m512_res_0 = _mm512_setzero_ps();
+    __m512 m512_res_1 = _mm512_setzero_ps();
+    __m512 m512_res_2 = _mm512_setzero_ps();
+    __m512 m512_res_3 = _mm512_setzero_ps();
+    size_t cur_d = d;
+    while (cur_d >= 32) {
+        auto mx = load_bf16x32(x);
+        m512_res_0 = _mm512_dpbf16_ps(m512_res_0, mx, load_bf16x32(y0));
+        m512_res_1 = _mm512_dpbf16_ps(m512_res_1, mx, load_bf16x32(y1));
+        m512_res_2 = _mm512_dpbf16_ps(m512_res_2, mx, load_bf16x32(y2));
+        m512_res_3 = _mm512_dpbf16_ps(m512_res_3, mx, load_bf16x32(y3));
+        x += 32;
+        y0 += 32;
+        y1 += 32;
+        y2 += 32;
+        y3 += 32;
+        cur_d -= 32;
+    }
+    if (cur_d > 0) {
+        auto mx = load_bf16x32(x, cur_d);
+        m512_res_0 = _mm512_dpbf16_ps(m512_res_0, mx, load_bf16x32(y0, cur_d));
+        m512_res_1 = _mm512_dpbf16_ps(m512_res_1, mx, load_bf16x32(y1, cur_d));
+        m512_res_2 = _mm512_dpbf16_ps(m512_res_2, mx, load_bf16x32(y2, cur_d));
+        m512_res_3 = _mm512_dpbf16_ps(m512_res_3, mx, load_bf16x32(y3, cur_d));
+    }
+    dis0 = _mm512_reduce_add_ps(m512_res_0);
+    dis1 = _mm512_reduce_add_ps(m512_res_1);
+    dis2 = _mm512_reduce_add_ps(m512_res_2);
+    dis3 = _mm512_reduce_add_ps(m512_res_3);
+}
+
+}  // namespace faiss
+#endif
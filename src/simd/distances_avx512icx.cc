@@ -13,10 +13,13 @@
 
 #include <immintrin.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "distances_avx512.h"
+#include "distances_avx512icx.h"
 
 namespace faiss {
 
@@ -89,6 +92,30 @@ rabitq_dp_q(const uint8_t* q, const uint8_t* x, const size_t d) {
     return sum_64le;
 }
 
+// vpdpbusd multiplies unsigned bytes by signed ones, so x * y is computed as (x + 128) * y - 128 * y. The sum of y
+// is accumulated with vpdpbusd too, against bytes of 1.
+inline void
+int8_dp_vnni(const __m512i x_u, const __m512i y, __m512i& dp, __m512i& y_sum) {
+    dp = _mm512_dpbusd_epi32(dp, x_u, y);
+    y_sum = _mm512_dpbusd_epi32(y_sum, _mm512_set1_epi8(1), y);
+}
+
+inline float
+int8_dp_vnni_reduce(const __m512i dp, const __m512i y_sum) {
+    return (float)(_mm512_reduce_add_epi32(dp) - 128 * _mm512_reduce_add_epi32(y_sum));
+}
+
+// the differences of int8 need 9 bits, so L2 is computed on int16 with vpdpwssd
+inline __m512i
+int8_load_epi16(const int8_t* x) {
+    return _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)x));
+}
+
+inline __m512i
+int8_maskz_load_epi16(const __mmask32 mask, const int8_t* x) {
+    return _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8(mask, x));
+}
+
 }  // namespace
 
 int
@@ -115,5 +142,357 @@ rabitq_dp_popcnt_avx512icx(const uint8_t* q, const uint8_t* x, const size_t d, c
     return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// int8, with vnni
+
+float
+int8_vec_inner_product_avx512icx(const int8_t* x, const int8_t* y, size_t d) {
+    const __m512i sign = _mm512_set1_epi8(-128);
+    __m512i dp = _mm512_setzero_si512();
+    __m512i y_sum = _mm512_setzero_si512();
+    while (d >= 64) {
+        const __m512i mx = _mm512_xor_si512(_mm512_loadu_si512(x), sign);
+        int8_dp_vnni(mx, _mm512_loadu_si512(y), dp, y_sum);
+        x += 64;
+        y += 64;
+        d -= 64;
+    }
+    if (d > 0) {
+        // the masked out bytes of y are 0, whatever x is
+        const __mmask64 mask = (1ULL << d) - 1ULL;
+        const __m512i mx = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, x), sign);
+        int8_dp_vnni(mx, _mm512_maskz_loadu_epi8(mask, y), dp, y_sum);
+    }
+    return int8_dp_vnni_reduce(dp, y_sum);
+}
+
+float
+int8_vec_L2sqr_avx512icx(const int8_t* x, const int8_t* y, size_t d) {
+    __m512i res = _mm512_setzero_si512();
+    while (d >= 32) {
+        const __m512i diff = _mm512_sub_epi16(int8_load_epi16(x), int8_load_epi16(y));
+        res = _mm512_dpwssd_epi32(res, diff, diff);
+        x += 32;
+        y += 32;
+        d -= 32;
+    }
+    if (d > 0) {
+        const __mmask32 mask = (1U << d) - 1U;
+        const __m512i diff = _mm512_sub_epi16(int8_maskz_load_epi16(mask, x), int8_maskz_load_epi16(mask, y));
+        res = _mm512_dpwssd_epi32(res, diff, diff);
+    }
+    return (float)_mm512_reduce_add_epi32(res);
+}
+
+float
+int8_vec_norm_L2sqr_avx512icx(const int8_t* x, size_t d) {
+    __m512i res = _mm512_setzero_si512();
+    while (d >= 32) {
+        const __m512i mx = int8_load_epi16(x);
+        res = _mm512_dpwssd_epi32(res, mx, mx);
+        x += 32;
+        d -= 32;
+    }
+    if (d > 0) {
+        const __mmask32 mask = (1U << d) - 1U;
+        const __m512i mx = int8_maskz_load_epi16(mask, x);
+        res = _mm512_dpwssd_epi32(res, mx, mx);
+    }
+    return (float)_mm512_reduce_add_epi32(res);
+}
+
+void
+int8_vec_inner_product_batch_4_avx512icx(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2,
+                                         const int8_t* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                         float& dis3) {
+    const __m512i sign = _mm512_set1_epi8(-128);
+    __m512i dp0 = _mm512_setzero_si512(), dp1 = _mm512_setzero_si512();
+    __m512i dp2 = _mm512_setzero_si512(), dp3 = _mm512_setzero_si512();
+    __m512i y_sum0 = _mm512_setzero_si512(), y_sum1 = _mm512_setzero_si512();
+    __m512i y_sum2 = _mm512_setzero_si512(), y_sum3 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= d; i += 64) {
+        const __m512i mx = _mm512_xor_si512(_mm512_loadu_si512(x + i), sign);
+        int8_dp_vnni(mx, _mm512_loadu_si512(y0 + i), dp0, y_sum0);
+        int8_dp_vnni(mx, _mm512_loadu_si512(y1 + i), dp1, y_sum1);
+        int8_dp_vnni(mx, _mm512_loadu_si512(y2 + i), dp2, y_sum2);
+        int8_dp_vnni(mx, _mm512_loadu_si512(y3 + i), dp3, y_sum3);
+    }
+    if (i < d) {
+        const __mmask64 mask = (1ULL << (d - i)) - 1ULL;
+        const __m512i mx = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, x + i), sign);
+        int8_dp_vnni(mx, _mm512_maskz_loadu_epi8(mask, y0 + i), dp0, y_sum0);
+        int8_dp_vnni(mx, _mm512_maskz_loadu_epi8(mask, y1 + i), dp1, y_sum1);
+        int8_dp_vnni(mx, _mm512_maskz_loadu_epi8(mask, y2 + i), dp2, y_sum2);
+        int8_dp_vnni(mx, _mm512_maskz_loadu_epi8(mask, y3 + i), dp3, y_sum3);
+    }
+    dis0 = int8_dp_vnni_reduce(dp0, y_sum0);
+    dis1 = int8_dp_vnni_reduce(dp1, y_sum1);
+    dis2 = int8_dp_vnni_reduce(dp2, y_sum2);
+    dis3 = int8_dp_vnni_reduce(dp3, y_sum3);
+}
+
+void
+int8_vec_L2sqr_batch_4_avx512icx(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2,
+                                 const int8_t* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                 float& dis3) {
+    __m512i res0 = _mm512_setzero_si512(), res1 = _mm512_setzero_si512();
+    __m512i res2 = _mm512_setzero_si512(), res3 = _mm512_setzero_si512();
+    auto accumulate = [](__m512i& res, const __m512i mx, const __m512i my) {
+        const __m512i diff = _mm512_sub_epi16(mx, my);
+        res = _mm512_dpwssd_epi32(res, diff, diff);
+    };
+    size_t i = 0;
+    for (; i + 32 <= d; i += 32) {
+        const __m512i mx = int8_load_epi16(x + i);
+        accumulate(res0, mx, int8_load_epi16(y0 + i));
+        accumulate(res1, mx, int8_load_epi16(y1 + i));
+        accumulate(res2, mx, int8_load_epi16(y2 + i));
+        accumulate(res3, mx, int8_load_epi16(y3 + i));
+    }
+    if (i < d) {
+        const __mmask32 mask = (1U << (d - i)) - 1U;
+        const __m512i mx = int8_maskz_load_epi16(mask, x + i);
+        accumulate(res0, mx, int8_maskz_load_epi16(mask, y0 + i));
+        accumulate(res1, mx, int8_maskz_load_epi16(mask, y1 + i));
+        accumulate(res2, mx, int8_maskz_load_epi16(mask, y2 + i));
+        accumulate(res3, mx, int8_maskz_load_epi16(mask, y3 + i));
+    }
+    dis0 = (float)_mm512_reduce_add_epi32(res0);
+    dis1 = (float)_mm512_reduce_add_epi32(res1);
+    dis2 = (float)_mm512_reduce_add_epi32(res2);
+    dis3 = (float)_mm512_reduce_add_epi32(res3);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// binary, with vpopcntdq
+
+namespace {
+
+struct U8XorOp {
+    __m512i
+    operator()(const __m512i a, const __m512i b) const {
+        return _mm512_xor_si512(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a ^ b;
+    }
+};
+
+struct U8AndOp {
+    __m512i
+    operator()(const __m512i a, const __m512i b) const {
+        return _mm512_and_si512(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a & b;
+    }
+};
+
+struct U8OrOp {
+    __m512i
+    operator()(const __m512i a, const __m512i b) const {
+        return _mm512_or_si512(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a | b;
+    }
+};
+
+// the popcounts of op(x, y_r) for the N contiguous codes y_r, the codes share the loads of x
+template <size_t N, typename Op>
+inline void
+u8_popcnt_batch_avx512icx(const uint8_t* x, const uint8_t* y, const size_t code_size, const Op op, int32_t* res) {
+    for (size_t r = 0; r < N; r++) {
+        res[r] = 0;
+    }
+    size_t i = 0;
+    if (code_size >= 64) {
+        __m512i acc[N];
+        for (size_t r = 0; r < N; r++) {
+            acc[r] = _mm512_setzero_si512();
+        }
+        for (; i + 64 <= code_size; i += 64) {
+            const __m512i mx = _mm512_loadu_si512(x + i);
+            for (size_t r = 0; r < N; r++) {
+                const __m512i my = _mm512_loadu_si512(y + r * code_size + i);
+                acc[r] = _mm512_add_epi64(acc[r], _mm512_popcnt_epi64(op(mx, my)));
+            }
+        }
+        if (i < code_size) {
+            // the masked out bytes are 0 for both codes, which op keeps at 0
+            const __mmask64 mask = (1ULL << (code_size - i)) - 1ULL;
+            const __m512i mx = _mm512_maskz_loadu_epi8(mask, x + i);
+            for (size_t r = 0; r < N; r++) {
+                const __m512i my = _mm512_maskz_loadu_epi8(mask, y + r * code_size + i);
+                acc[r] = _mm512_add_epi64(acc[r], _mm512_popcnt_epi64(op(mx, my)));
+            }
+            i = code_size;
+        }
+        for (size_t r = 0; r < N; r++) {
+            res[r] = (int32_t)_mm512_reduce_add_epi64(acc[r]);
+        }
+    }
+    // the reductions do not pay off on short codes
+    for (; i + 8 <= code_size; i += 8) {
+        uint64_t a;
+        std::memcpy(&a, x + i, 8);
+        for (size_t r = 0; r < N; r++) {
+            uint64_t b;
+            std::memcpy(&b, y + r * code_size + i, 8);
+            res[r] += __builtin_popcountll(op(a, b));
+        }
+    }
+    if (i + 4 <= code_size) {
+        uint32_t a;
+        std::memcpy(&a, x + i, 4);
+        for (size_t r = 0; r < N; r++) {
+            uint32_t b;
+            std::memcpy(&b, y + r * code_size + i, 4);
+            res[r] += __builtin_popcountll(op((uint64_t)a, (uint64_t)b));
+        }
+        i += 4;
+    }
+    for (; i < code_size; i++) {
+        for (size_t r = 0; r < N; r++) {
+            res[r] += __builtin_popcountll(op((uint64_t)x[i], (uint64_t)y[r * code_size + i]));
+        }
+    }
+}
+
+// the code x repeated over a register, for the codes of CS bytes
+template <size_t CS>
+inline __m512i
+u8_broadcast_code(const uint8_t* x) {
+    if constexpr (CS == 8) {
+        uint64_t a;
+        std::memcpy(&a, x, 8);
+        return _mm512_set1_epi64((long long)a);
+    } else if constexpr (CS == 16) {
+        return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)x));
+    } else {
+        return _mm512_broadcast_i64x4(_mm256_loadu_si256((const __m256i*)x));
+    }
+}
+
+// the popcounts of op(x, y_r) for 8 contiguous codes y_r of CS bytes, with several codes per register. mx is
+// u8_broadcast_code<CS>(x).
+template <size_t CS, typename Op>
+inline __m256i
+u8_popcnt_x8_avx512icx(const __m512i mx, const uint8_t* y, const Op op) {
+    auto popcnt = [&](const size_t r) { return _mm512_popcnt_epi64(op(mx, _mm512_loadu_si512(y + r * 64))); };
+    if constexpr (CS == 8) {
+        return _mm512_cvtepi64_epi32(popcnt(0));
+    } else if constexpr (CS == 16) {
+        // lane l of the registers holds the codes l and 4 + l
+        const __m512i c0 = popcnt(0);
+        const __m512i c1 = popcnt(1);
+        const __m512i sum = _mm512_add_epi64(_mm512_unpacklo_epi64(c0, c1), _mm512_unpackhi_epi64(c0, c1));
+        return _mm512_cvtepi64_epi32(_mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), sum));
+    } else {
+        // the halves of a code are summed first, c01 holds the codes 0, 2, 1, 3 and c23 the codes 4, 6, 5, 7
+        const __m512i c0 = popcnt(0);
+        const __m512i c1 = popcnt(1);
+        const __m512i c2 = popcnt(2);
+        const __m512i c3 = popcnt(3);
+        const __m512i c01 = _mm512_add_epi64(_mm512_unpacklo_epi64(c0, c1), _mm512_unpackhi_epi64(c0, c1));
+        const __m512i c23 = _mm512_add_epi64(_mm512_unpacklo_epi64(c2, c3), _mm512_unpackhi_epi64(c2, c3));
+        const __m512i sum = _mm512_add_epi64(_mm512_shuffle_i64x2(c01, c23, _MM_SHUFFLE(2, 0, 2, 0)),
+                                             _mm512_shuffle_i64x2(c01, c23, _MM_SHUFFLE(3, 1, 3, 1)));
+        return _mm512_cvtepi64_epi32(_mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 1, 3, 4, 6, 5, 7), sum));
+    }
+}
+
+// scores the codes 8 at a time and returns how many were scored
+template <size_t CS>
+inline size_t
+u8_hamming_distance_x8_avx512icx(const uint8_t* x, const uint8_t* y, const size_t ny, int32_t* dis) {
+    const __m512i mx = u8_broadcast_code<CS>(x);
+    size_t j = 0;
+    for (; j + 8 <= ny; j += 8) {
+        _mm256_storeu_si256((__m256i*)(dis + j), u8_popcnt_x8_avx512icx<CS>(mx, y + j * CS, U8XorOp{}));
+    }
+    return j;
+}
+
+template <size_t CS>
+inline size_t
+u8_jaccard_distance_x8_avx512icx(const uint8_t* x, const uint8_t* y, const size_t ny, float* dis) {
+    const __m512i mx = u8_broadcast_code<CS>(x);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t j = 0;
+    for (; j + 8 <= ny; j += 8) {
+        const __m256i num = u8_popcnt_x8_avx512icx<CS>(mx, y + j * CS, U8AndOp{});
+        const __m256i den = u8_popcnt_x8_avx512icx<CS>(mx, y + j * CS, U8OrOp{});
+        const __m256 res = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(den, num)), _mm256_cvtepi32_ps(den));
+        const __mmask8 empty = _mm256_cmpeq_epi32_mask(den, _mm256_setzero_si256());
+        _mm256_storeu_ps(dis + j, _mm256_mask_blend_ps(empty, res, one));
+    }
+    return j;
+}
+
+}  // namespace
+
+void
+u8_hamming_distance_ny_avx512icx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                                 int32_t* dis) {
+    size_t j = 0;
+    switch (code_size) {
+        case 8:
+            j = u8_hamming_distance_x8_avx512icx<8>(x, y, ny, dis);
+            break;
+        case 16:
+            j = u8_hamming_distance_x8_avx512icx<16>(x, y, ny, dis);
+            break;
+        case 32:
+            j = u8_hamming_distance_x8_avx512icx<32>(x, y, ny, dis);
+            break;
+    }
+    for (; j + 4 <= ny; j += 4) {
+        u8_popcnt_batch_avx512icx<4>(x, y + j * code_size, code_size, U8XorOp{}, dis + j);
+    }
+    for (; j < ny; j++) {
+        u8_popcnt_batch_avx512icx<1>(x, y + j * code_size, code_size, U8XorOp{}, dis + j);
+    }
+}
+
+void
+u8_jaccard_distance_ny_avx512icx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                                 float* dis) {
+    size_t j = 0;
+    switch (code_size) {
+        case 8:
+            j = u8_jaccard_distance_x8_avx512icx<8>(x, y, ny, dis);
+            break;
+        case 16:
+            j = u8_jaccard_distance_x8_avx512icx<16>(x, y, ny, dis);
+            break;
+        case 32:
+            j = u8_jaccard_distance_x8_avx512icx<32>(x, y, ny, dis);
+            break;
+    }
+    int32_t num[4];
+    int32_t den[4];
+    for (; j < ny; j += 4) {
+        const size_t n = std::min<size_t>(4, ny - j);
+        const uint8_t* y_j = y + j * code_size;
+        if (n == 4) {
+            u8_popcnt_batch_avx512icx<4>(x, y_j, code_size, U8AndOp{}, num);
+            u8_popcnt_batch_avx512icx<4>(x, y_j, code_size, U8OrOp{}, den);
+        } else {
+            for (size_t r = 0; r < n; r++) {
+                u8_popcnt_batch_avx512icx<1>(x, y_j + r * code_size, code_size, U8AndOp{}, num + r);
+                u8_popcnt_batch_avx512icx<1>(x, y_j + r * code_size, code_size, U8OrOp{}, den + r);
+            }
+        }
+        for (size_t r = 0; r < n; r++) {
+            dis[j + r] = den[r] == 0 ? 1.0f : (float)(den[r] - num[r]) / (float)den[r];
+        }
+    }
+}
+
 }  // namespace faiss
 #endif
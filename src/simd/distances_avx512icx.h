@@ -16,9 +16,40 @@
 
 namespace faiss {
 
+///////////////////////////////////////////////////////////////////////////////
+// int8, with vnni
+
+float
+int8_vec_inner_product_avx512icx(const int8_t* x, const int8_t* y, size_t d);
+
+float
+int8_vec_L2sqr_avx512icx(const int8_t* x, const int8_t* y, size_t d);
+
+float
+int8_vec_norm_L2sqr_avx512icx(const int8_t* x, size_t d);
+
+void
+int8_vec_inner_product_batch_4_avx512icx(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2,
+                                         const int8_t* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                         float& dis3);
+
+void
+int8_vec_L2sqr_batch_4_avx512icx(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2,
+                                 const int8_t* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                 float& dis3);
+
 ///////////////////////////////////////////////////////////////////////////////
 // rabitq
 int
 rabitq_dp_popcnt_avx512icx(const uint8_t* q, const uint8_t* x, const size_t d, const size_t nb);
 
+///////////////////////////////////////////////////////////////////////////////
+// binary
+void
+u8_hamming_distance_ny_avx512icx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                                 int32_t* dis);
+void
+u8_jaccard_distance_ny_avx512icx(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                                 float* dis);
+
 }  // namespace faiss
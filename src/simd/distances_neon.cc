@@ -17,6 +17,9 @@
 #include <arm_neon.h>
 #include <math.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace faiss {
 
 namespace {
@@ -3355,5 +3358,128 @@ fvec_L2sqr_batch_4_bf16_patch_neon(const float* x, const float* y0, const float*
     dis3 = vaddvq_f32(sum_.val[3]);
 }
 
+namespace {
+
+struct U8XorOp {
+    uint8x16_t
+    operator()(const uint8x16_t a, const uint8x16_t b) const {
+        return veorq_u8(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a ^ b;
+    }
+};
+
+struct U8AndOp {
+    uint8x16_t
+    operator()(const uint8x16_t a, const uint8x16_t b) const {
+        return vandq_u8(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a & b;
+    }
+};
+
+struct U8OrOp {
+    uint8x16_t
+    operator()(const uint8x16_t a, const uint8x16_t b) const {
+        return vorrq_u8(a, b);
+    }
+    uint64_t
+    operator()(const uint64_t a, const uint64_t b) const {
+        return a | b;
+    }
+};
+
+// writes the popcounts of op(x, y_r) for the N contiguous codes y_r to res, the codes share the loads of x
+template <size_t N, typename Op>
+inline void
+u8_popcnt_batch_neon(const uint8_t* x, const uint8_t* y, const size_t code_size, const Op op, int32_t* res) {
+    // a u16 lane takes the counts of 2 bytes per step, it is flushed before it overflows
+    constexpr size_t kFlushBytes = 16 * 2048;
+    for (size_t r = 0; r < N; r++) {
+        res[r] = 0;
+    }
+    size_t i = 0;
+    while (i + 16 <= code_size) {
+        const size_t end = std::min(code_size - code_size % 16, i + kFlushBytes);
+        uint16x8_t acc[N];
+        for (size_t r = 0; r < N; r++) {
+            acc[r] = vdupq_n_u16(0);
+        }
+        for (; i < end; i += 16) {
+            const uint8x16_t mx = vld1q_u8(x + i);
+            for (size_t r = 0; r < N; r++) {
+                acc[r] = vpadalq_u8(acc[r], vcntq_u8(op(mx, vld1q_u8(y + r * code_size + i))));
+            }
+        }
+        for (size_t r = 0; r < N; r++) {
+            res[r] += (int32_t)vaddlvq_u16(acc[r]);
+        }
+    }
+    for (; i + 8 <= code_size; i += 8) {
+        uint64_t a;
+        std::memcpy(&a, x + i, 8);
+        for (size_t r = 0; r < N; r++) {
+            uint64_t b;
+            std::memcpy(&b, y + r * code_size + i, 8);
+            res[r] += __builtin_popcountll(op(a, b));
+        }
+    }
+    if (i + 4 <= code_size) {
+        uint32_t a;
+        std::memcpy(&a, x + i, 4);
+        for (size_t r = 0; r < N; r++) {
+            uint32_t b;
+            std::memcpy(&b, y + r * code_size + i, 4);
+            res[r] += __builtin_popcountll(op((uint64_t)a, (uint64_t)b));
+        }
+        i += 4;
+    }
+    for (; i < code_size; i++) {
+        for (size_t r = 0; r < N; r++) {
+            res[r] += __builtin_popcountll(op((uint64_t)x[i], (uint64_t)y[r * code_size + i]));
+        }
+    }
+}
+
+}  // namespace
+
+void
+u8_hamming_distance_ny_neon(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                            int32_t* dis) {
+    size_t j = 0;
+    for (; j + 4 <= ny; j += 4) {
+        u8_popcnt_batch_neon<4>(x, y + j * code_size, code_size, U8XorOp{}, dis + j);
+    }
+    for (; j < ny; j++) {
+        u8_popcnt_batch_neon<1>(x, y + j * code_size, code_size, U8XorOp{}, dis + j);
+    }
+}
+
+void
+u8_jaccard_distance_ny_neon(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis) {
+    int32_t num[4];
+    int32_t den[4];
+    for (size_t j = 0; j < ny; j += 4) {
+        const size_t n = std::min<size_t>(4, ny - j);
+        const uint8_t* y_j = y + j * code_size;
+        if (n == 4) {
+            u8_popcnt_batch_neon<4>(x, y_j, code_size, U8AndOp{}, num);
+            u8_popcnt_batch_neon<4>(x, y_j, code_size, U8OrOp{}, den);
+        } else {
+            for (size_t r = 0; r < n; r++) {
+                u8_popcnt_batch_neon<1>(x, y_j + r * code_size, code_size, U8AndOp{}, num + r);
+                u8_popcnt_batch_neon<1>(x, y_j + r * code_size, code_size, U8OrOp{}, den + r);
+            }
+        }
+        for (size_t r = 0; r < n; r++) {
+            dis[j + r] = den[r] == 0 ? 1.0f : (float)(den[r] - num[r]) / (float)den[r];
+        }
+    }
+}
+
 }  // namespace faiss
 #endif
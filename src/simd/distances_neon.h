@@ -156,4 +156,11 @@ void
 fvec_L2sqr_batch_4_bf16_patch_neon(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
                                    const size_t dim, float& dis0, float& dis1, float& dis2, float& dis3);
 
+///////////////////////////////////////////////////////////////////////////////
+// binary
+void
+u8_hamming_distance_ny_neon(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, int32_t* dis);
+void
+u8_jaccard_distance_ny_neon(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis);
+
 }  // namespace faiss
@@ -11,7 +11,12 @@
 
 #include "distances_ref.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
 
 #include "knowhere/operands.h"
 #include "xxhash.h"
@@ -454,6 +459,137 @@ int8_vec_L2sqr_batch_4_ref(const int8_t* x, const int8_t* y0, const int8_t* y1,
     dis3 = (float)d3;
 }
 
+void
+int8_vec_inner_products_nx_ny_ref(float* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny) {
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < ny; j++) {
+            ip[i * ny + j] = int8_vec_inner_product_ref(x + i * d, y + j * d, d);
+        }
+    }
+}
+
+void
+bf16_vec_inner_products_nx_ny_ref(float* ip, const knowhere::bf16* x, const knowhere::bf16* y, size_t d, size_t nx,
+                                  size_t ny) {
+    for (size_t i = 0; i < nx; i++) {
+        for (size_t j = 0; j < ny; j++) {
+            ip[i * ny + j] = bf16_vec_inner_product_ref(x + i * d, y + j * d, d);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// batch_8
+
+void
+fvec_inner_product_batch_8_ref(const float* x, const float* const* y, const size_t d, float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = fvec_inner_product_ref(x, y[k], d);
+    }
+}
+
+void
+fvec_L2sqr_batch_8_ref(const float* x, const float* const* y, const size_t d, float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = fvec_L2sqr_ref(x, y[k], d);
+    }
+}
+
+void
+fp16_vec_inner_product_batch_8_ref(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                   float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = fp16_vec_inner_product_ref(x, y[k], d);
+    }
+}
+
+void
+fp16_vec_L2sqr_batch_8_ref(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = fp16_vec_L2sqr_ref(x, y[k], d);
+    }
+}
+
+void
+bf16_vec_inner_product_batch_8_ref(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d,
+                                   float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = bf16_vec_inner_product_ref(x, y[k], d);
+    }
+}
+
+void
+bf16_vec_L2sqr_batch_8_ref(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = bf16_vec_L2sqr_ref(x, y[k], d);
+    }
+}
+
+void
+int8_vec_inner_product_batch_8_ref(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = int8_vec_inner_product_ref(x, y[k], d);
+    }
+}
+
+void
+int8_vec_L2sqr_batch_8_ref(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = int8_vec_L2sqr_ref(x, y[k], d);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ny_topk
+
+namespace {
+template <typename T, typename F>
+void
+ny_topk_ref(const T* x, const T* y, size_t d, size_t ny, size_t k, float* dis, int64_t* ids, F&& l2sqr) {
+    std::vector<std::pair<float, int64_t>> all(ny);
+    for (size_t i = 0; i < ny; i++) {
+        all[i] = {l2sqr(x, y + i * d, d), i};
+    }
+    const size_t n = std::min(k, ny);
+    std::partial_sort(all.begin(), all.begin() + n, all.end());
+    for (size_t i = 0; i < k; i++) {
+        dis[i] = i < n ? all[i].first : std::numeric_limits<float>::max();
+        ids[i] = i < n ? all[i].second : -1;
+    }
+}
+}  // namespace
+
+void
+fvec_L2sqr_ny_topk_ref(const float* x, const float* y, size_t d, size_t ny, size_t k, float* dis, int64_t* ids) {
+    ny_topk_ref(x, y, d, ny, k, dis, ids, fvec_L2sqr_ref);
+}
+
+void
+fp16_vec_L2sqr_ny_topk_ref(const knowhere::fp16* x, const knowhere::fp16* y, size_t d, size_t ny, size_t k,
+                           float* dis, int64_t* ids) {
+    ny_topk_ref(x, y, d, ny, k, dis, ids, fp16_vec_L2sqr_ref);
+}
+
+void
+bf16_vec_L2sqr_ny_topk_ref(const knowhere::bf16* x, const knowhere::bf16* y, size_t d, size_t ny, size_t k,
+                           float* dis, int64_t* ids) {
+    ny_topk_ref(x, y, d, ny, k, dis, ids, bf16_vec_L2sqr_ref);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// threshold filter
+
+size_t
+fvec_threshold_filter_ref(const float* dis, const size_t n, const float threshold, const bool greater,
+                          uint32_t* out) {
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        out[m] = i;
+        m += greater ? (dis[i] > threshold) : (dis[i] < threshold);
+    }
+    return m;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // for cardinal
 
@@ -685,6 +821,17 @@ u32_jaccard_distance_batch_4_ref(const char* x, const char* y0, const char* y1,
     dis3 /= element_length;
     return;
 }
+
+void
+u64_minhash_update_ref(const uint64_t* tokens, const size_t n, const uint64_t* a, const uint64_t* b,
+                       const size_t num_perm, uint64_t* sig) {
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t x = tokens[i];
+        for (size_t j = 0; j < num_perm; j++) {
+            sig[j] = std::min(sig[j], a[j] * x + b[j]);
+        }
+    }
+}
 float
 u64_jaccard_distance_ref(const char* x, const char* y, size_t element_length, size_t element_size) {
     float res = 0.0;
@@ -718,4 +865,90 @@ u64_jaccard_distance_batch_4_ref(const char* x, const char* y0, const char* y1,
     return;
 }
 
+void
+u32_bitpacked_delta_decode_ref(const uint8_t* data, const size_t bits, const size_t n, const uint32_t base,
+                               uint32_t* out) {
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    uint32_t prev = base;
+    for (size_t i = 0; i < n; i++) {
+        const size_t bit = i * bits;
+        uint64_t word;
+        memcpy(&word, data + bit / 8, sizeof(word));
+        prev += static_cast<uint32_t>((word >> (bit % 8)) & mask);
+        out[i] = prev;
+    }
+}
+
+size_t
+u32_sparse_intersect_ref(const uint32_t* a, const size_t na, const uint32_t* b, const size_t nb, uint32_t* a_pos,
+                         uint32_t* b_pos) {
+    size_t i = 0, j = 0, n = 0;
+    for (; i < na && j < nb;) {
+        const uint32_t x = a[2 * i];
+        const uint32_t y = b[2 * j];
+        if (x == y) {
+            a_pos[n] = i++;
+            b_pos[n++] = j++;
+        } else if (x < y) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return n;
+}
+
+void
+u8_pq4_fast_scan_ref(const uint8_t* codes, const size_t nb, const size_t nbytes, const uint8_t* lut, uint16_t* out) {
+    for (size_t b = 0; b < nb; b++) {
+        const uint8_t* block = codes + b * 32 * nbytes;
+        for (size_t r = 0; r < 32; r++) {
+            uint16_t sum = 0;
+            for (size_t j = 0; j < nbytes; j++) {
+                const uint8_t c = block[r * nbytes + j];
+                sum += lut[j * 32 + (c & 0x0f)] + lut[j * 32 + 16 + (c >> 4)];
+            }
+            out[b * 32 + r] = sum;
+        }
+    }
+}
+
+namespace {
+
+template <typename Op>
+inline int32_t
+u8_popcnt_ref(const uint8_t* x, const uint8_t* y, const size_t code_size, Op op) {
+    int32_t res = 0;
+    size_t i = 0;
+    for (; i + 8 <= code_size; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, x + i, 8);
+        std::memcpy(&b, y + i, 8);
+        res += __builtin_popcountll(op(a, b));
+    }
+    for (; i < code_size; i++) {
+        res += __builtin_popcount(op(x[i], y[i]));
+    }
+    return res;
+}
+
+}  // namespace
+
+void
+u8_hamming_distance_ny_ref(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                           int32_t* dis) {
+    for (size_t j = 0; j < ny; j++, y += code_size) {
+        dis[j] = u8_popcnt_ref(x, y, code_size, [](auto a, auto b) { return a ^ b; });
+    }
+}
+
+void
+u8_jaccard_distance_ny_ref(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis) {
+    for (size_t j = 0; j < ny; j++, y += code_size) {
+        const int32_t num = u8_popcnt_ref(x, y, code_size, [](auto a, auto b) { return a & b; });
+        const int32_t den = u8_popcnt_ref(x, y, code_size, [](auto a, auto b) { return a | b; });
+        dis[j] = den == 0 ? 1.0f : (float)(den - num) / (float)den;
+    }
+}
+
 }  // namespace faiss
@@ -154,6 +154,60 @@ void
 int8_vec_L2sqr_batch_4_ref(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2, const int8_t* y3,
                            const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
 
+void
+int8_vec_inner_products_nx_ny_ref(float* ip, const int8_t* x, const int8_t* y, size_t d, size_t nx, size_t ny);
+
+void
+bf16_vec_inner_products_nx_ny_ref(float* ip, const knowhere::bf16* x, const knowhere::bf16* y, size_t d, size_t nx,
+                                  size_t ny);
+
+///////////////////////////////////////////////////////////////////////////////
+// batch_8, the distances between x and the 8 vectors y
+
+void
+fvec_inner_product_batch_8_ref(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fvec_L2sqr_batch_8_ref(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fp16_vec_inner_product_batch_8_ref(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis);
+
+void
+fp16_vec_L2sqr_batch_8_ref(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis);
+
+void
+bf16_vec_inner_product_batch_8_ref(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis);
+
+void
+bf16_vec_L2sqr_batch_8_ref(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis);
+
+void
+int8_vec_inner_product_batch_8_ref(const int8_t* x, const int8_t* const* y, const size_t d, float* dis);
+
+void
+int8_vec_L2sqr_batch_8_ref(const int8_t* x, const int8_t* const* y, const size_t d, float* dis);
+
+///////////////////////////////////////////////////////////////////////////////
+// ny_topk, the k smallest squared L2 distances between x and ny vectors y, in increasing order
+
+void
+fvec_L2sqr_ny_topk_ref(const float* x, const float* y, size_t d, size_t ny, size_t k, float* dis, int64_t* ids);
+
+void
+fp16_vec_L2sqr_ny_topk_ref(const knowhere::fp16* x, const knowhere::fp16* y, size_t d, size_t ny, size_t k,
+                           float* dis, int64_t* ids);
+
+void
+bf16_vec_L2sqr_ny_topk_ref(const knowhere::bf16* x, const knowhere::bf16* y, size_t d, size_t ny, size_t k,
+                           float* dis, int64_t* ids);
+
+///////////////////////////////////////////////////////////////////////////////
+// threshold filter
+size_t
+fvec_threshold_filter_ref(const float* dis, const size_t n, const float threshold, const bool greater,
+                          uint32_t* out);
+
 ///////////////////////////////////////////////////////////////////////////////
 // for cardinal
 float
@@ -198,5 +252,30 @@ u64_jaccard_distance_ref(const char*, const char*, size_t size, size_t);
 void
 u64_jaccard_distance_batch_4_ref(const char*, const char*, const char*, const char*, const char*, size_t, size_t,
                                  float&, float&, float&, float&);
+void
+u64_minhash_update_ref(const uint64_t* tokens, const size_t n, const uint64_t* a, const uint64_t* b,
+                       const size_t num_perm, uint64_t* sig);
+
+///////////////////////////////////////////////////////////////////////////////
+// sparse
+void
+u32_bitpacked_delta_decode_ref(const uint8_t* data, const size_t bits, const size_t n, const uint32_t base,
+                               uint32_t* out);
+size_t
+u32_sparse_intersect_ref(const uint32_t* a, const size_t na, const uint32_t* b, const size_t nb, uint32_t* a_pos,
+                         uint32_t* b_pos);
+
+///////////////////////////////////////////////////////////////////////////////
+// pq
+void
+u8_pq4_fast_scan_ref(const uint8_t* codes, const size_t nb, const size_t nbytes, const uint8_t* lut, uint16_t* out);
+
+///////////////////////////////////////////////////////////////////////////////
+// binary
+void
+u8_hamming_distance_ny_ref(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                           int32_t* dis);
+void
+u8_jaccard_distance_ny_ref(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis);
 
 }  // namespace faiss
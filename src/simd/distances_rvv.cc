@@ -16,8 +16,230 @@
 #include <math.h>
 #include <riscv_vector.h>
 
+#include <type_traits>
+
 namespace faiss {
 
+namespace {
+
+inline float
+reduce_sum(const vfloat32m2_t acc) {
+    const size_t vlmax = __riscv_vsetvlmax_e32m2();
+    const vfloat32m1_t zero = __riscv_vfmv_s_f_f32m1(0.0f, 1);
+    return __riscv_vfmv_f_s_f32m1_f32(__riscv_vfredusum_vs_f32m2_f32m1(acc, zero, vlmax));
+}
+
+inline int32_t
+reduce_sum(const vint32m2_t acc) {
+    const size_t vlmax = __riscv_vsetvlmax_e32m2();
+    const vint32m1_t zero = __riscv_vmv_s_x_i32m1(0, 1);
+    return __riscv_vmv_x_s_i32m1_i32(__riscv_vredsum_vs_i32m2_i32m1(acc, zero, vlmax));
+}
+
+inline vfloat32m2_t
+load_as_fp32(const float* x, const size_t vl) {
+    return __riscv_vle32_v_f32m2(x, vl);
+}
+
+// with integer ops, the fp16 loads and conversions of Zvfh are not part of RVV 1.0
+inline vfloat32m2_t
+load_as_fp32(const knowhere::fp16* x, const size_t vl) {
+    const vuint32m2_t h = __riscv_vzext_vf2_u32m2(__riscv_vle16_v_u16m1(reinterpret_cast<const uint16_t*>(x), vl), vl);
+    constexpr uint32_t kExpMask = 0x7c00 << 13;
+    vuint32m2_t o = __riscv_vsll_vx_u32m2(__riscv_vand_vx_u32m2(h, 0x7fff, vl), 13, vl);
+    const vuint32m2_t exp = __riscv_vand_vx_u32m2(o, kExpMask, vl);
+    o = __riscv_vadd_vx_u32m2(o, (127 - 15) << 23, vl);
+    // inf and nan keep an all-ones exponent
+    const vbool16_t inf_nan = __riscv_vmseq_vx_u32m2_b16(exp, kExpMask, vl);
+    o = __riscv_vadd_vx_u32m2_mu(inf_nan, o, o, (128 - 16) << 23, vl);
+    // zeros and subnormals are renormalized by a subtraction of 2^-14
+    const vbool16_t subnormal = __riscv_vmseq_vx_u32m2_b16(exp, 0, vl);
+    o = __riscv_vadd_vx_u32m2_mu(subnormal, o, o, 1 << 23, vl);
+    vfloat32m2_t f = __riscv_vreinterpret_v_u32m2_f32m2(o);
+    f = __riscv_vfsub_vf_f32m2_mu(subnormal, f, f, 6.103515625e-05f, vl);
+    const vuint32m2_t sign = __riscv_vsll_vx_u32m2(__riscv_vand_vx_u32m2(h, 0x8000, vl), 16, vl);
+    return __riscv_vreinterpret_v_u32m2_f32m2(__riscv_vor_vv_u32m2(__riscv_vreinterpret_v_f32m2_u32m2(f), sign, vl));
+}
+
+inline vfloat32m2_t
+load_as_fp32(const knowhere::bf16* x, const size_t vl) {
+    const vuint32m2_t h = __riscv_vzext_vf2_u32m2(__riscv_vle16_v_u16m1(reinterpret_cast<const uint16_t*>(x), vl), vl);
+    return __riscv_vreinterpret_v_u32m2_f32m2(__riscv_vsll_vx_u32m2(h, 16, vl));
+}
+
+// int8 is widened to int16, whose products are accumulated into int32 without a loss
+inline vint16m1_t
+load_as_int16(const int8_t* x, const size_t vl) {
+    return __riscv_vsext_vf2_i16m1(__riscv_vle8_v_i8mf2(x, vl), vl);
+}
+
+template <bool L2>
+inline vfloat32m2_t
+step(const vfloat32m2_t acc, const vfloat32m2_t a, const vfloat32m2_t b, const size_t vl) {
+    if constexpr (L2) {
+        const vfloat32m2_t diff = __riscv_vfsub_vv_f32m2(a, b, vl);
+        return __riscv_vfmacc_vv_f32m2_tu(acc, diff, diff, vl);
+    } else {
+        return __riscv_vfmacc_vv_f32m2_tu(acc, a, b, vl);
+    }
+}
+
+template <bool L2>
+inline vint32m2_t
+step(const vint32m2_t acc, const vint16m1_t a, const vint16m1_t b, const size_t vl) {
+    if constexpr (L2) {
+        const vint16m1_t diff = __riscv_vsub_vv_i16m1(a, b, vl);
+        return __riscv_vwmacc_vv_i32m2_tu(acc, diff, diff, vl);
+    } else {
+        return __riscv_vwmacc_vv_i32m2_tu(acc, a, b, vl);
+    }
+}
+
+template <typename T>
+inline auto
+load(const T* x, const size_t vl) {
+    if constexpr (std::is_same_v<T, int8_t>) {
+        return load_as_int16(x, vl);
+    } else {
+        return load_as_fp32(x, vl);
+    }
+}
+
+template <typename T>
+inline auto
+zero_acc(const size_t vlmax) {
+    if constexpr (std::is_same_v<T, int8_t>) {
+        return __riscv_vmv_v_x_i32m2(0, vlmax);
+    } else {
+        return __riscv_vfmv_v_f_f32m2(0.0f, vlmax);
+    }
+}
+
+// the vl of e32m2 fits the narrower loads of fp16, bf16 and int8 as well
+template <bool L2, typename T>
+auto
+distance_rvv(const T* x, const T* y, const size_t d) {
+    auto acc = zero_acc<T>(__riscv_vsetvlmax_e32m2());
+    for (size_t i = 0; i < d;) {
+        const size_t vl = __riscv_vsetvl_e32m2(d - i);
+        acc = step<L2>(acc, load(x + i, vl), load(y + i, vl), vl);
+        i += vl;
+    }
+    return reduce_sum(acc);
+}
+
+template <typename T>
+auto
+norm_rvv(const T* x, const size_t d) {
+    auto acc = zero_acc<T>(__riscv_vsetvlmax_e32m2());
+    for (size_t i = 0; i < d;) {
+        const size_t vl = __riscv_vsetvl_e32m2(d - i);
+        const auto a = load(x + i, vl);
+        acc = step<false>(acc, a, a, vl);
+        i += vl;
+    }
+    return reduce_sum(acc);
+}
+
+template <bool L2, typename T>
+void
+batch_4_rvv(const T* x, const T* y0, const T* y1, const T* y2, const T* y3, const size_t d, float& dis0, float& dis1,
+            float& dis2, float& dis3) {
+    const size_t vlmax = __riscv_vsetvlmax_e32m2();
+    auto acc0 = zero_acc<T>(vlmax);
+    auto acc1 = zero_acc<T>(vlmax);
+    auto acc2 = zero_acc<T>(vlmax);
+    auto acc3 = zero_acc<T>(vlmax);
+    for (size_t i = 0; i < d;) {
+        const size_t vl = __riscv_vsetvl_e32m2(d - i);
+        const auto a = load(x + i, vl);
+        acc0 = step<L2>(acc0, a, load(y0 + i, vl), vl);
+        acc1 = step<L2>(acc1, a, load(y1 + i, vl), vl);
+        acc2 = step<L2>(acc2, a, load(y2 + i, vl), vl);
+        acc3 = step<L2>(acc3, a, load(y3 + i, vl), vl);
+        i += vl;
+    }
+    dis0 = reduce_sum(acc0);
+    dis1 = reduce_sum(acc1);
+    dis2 = reduce_sum(acc2);
+    dis3 = reduce_sum(acc3);
+}
+
+template <bool L2, typename T>
+void
+batch_8_rvv(const T* x, const T* const* y, const size_t d, float* dis) {
+    const size_t vlmax = __riscv_vsetvlmax_e32m2();
+    auto acc0 = zero_acc<T>(vlmax);
+    auto acc1 = zero_acc<T>(vlmax);
+    auto acc2 = zero_acc<T>(vlmax);
+    auto acc3 = zero_acc<T>(vlmax);
+    auto acc4 = zero_acc<T>(vlmax);
+    auto acc5 = zero_acc<T>(vlmax);
+    auto acc6 = zero_acc<T>(vlmax);
+    auto acc7 = zero_acc<T>(vlmax);
+    for (size_t i = 0; i < d;) {
+        const size_t vl = __riscv_vsetvl_e32m2(d - i);
+        const auto a = load(x + i, vl);
+        acc0 = step<L2>(acc0, a, load(y[0] + i, vl), vl);
+        acc1 = step<L2>(acc1, a, load(y[1] + i, vl), vl);
+        acc2 = step<L2>(acc2, a, load(y[2] + i, vl), vl);
+        acc3 = step<L2>(acc3, a, load(y[3] + i, vl), vl);
+        acc4 = step<L2>(acc4, a, load(y[4] + i, vl), vl);
+        acc5 = step<L2>(acc5, a, load(y[5] + i, vl), vl);
+        acc6 = step<L2>(acc6, a, load(y[6] + i, vl), vl);
+        acc7 = step<L2>(acc7, a, load(y[7] + i, vl), vl);
+        i += vl;
+    }
+    dis[0] = reduce_sum(acc0);
+    dis[1] = reduce_sum(acc1);
+    dis[2] = reduce_sum(acc2);
+    dis[3] = reduce_sum(acc3);
+    dis[4] = reduce_sum(acc4);
+    dis[5] = reduce_sum(acc5);
+    dis[6] = reduce_sum(acc6);
+    dis[7] = reduce_sum(acc7);
+}
+
+size_t
+nearest(const float* dis, const size_t ny) {
+    size_t nearest_idx = 0;
+    float min_dis = HUGE_VALF;
+    for (size_t i = 0; i < ny; i++) {
+        if (dis[i] < min_dis) {
+            min_dis = dis[i];
+            nearest_idx = i;
+        }
+    }
+    return nearest_idx;
+}
+
+// the byte-wise popcount of Zvbb is not part of RVV 1.0
+inline vuint8m1_t
+popcount(vuint8m1_t v, const size_t vl) {
+    v = __riscv_vsub_vv_u8m1(v, __riscv_vand_vx_u8m1(__riscv_vsrl_vx_u8m1(v, 1, vl), 0x55, vl), vl);
+    v = __riscv_vadd_vv_u8m1(__riscv_vand_vx_u8m1(v, 0x33, vl),
+                             __riscv_vand_vx_u8m1(__riscv_vsrl_vx_u8m1(v, 2, vl), 0x33, vl), vl);
+    return __riscv_vand_vx_u8m1(__riscv_vadd_vv_u8m1(v, __riscv_vsrl_vx_u8m1(v, 4, vl), vl), 0x0f, vl);
+}
+
+// the popcounts of a byte are at most 8, the 16-bit lanes do not overflow below 8191 vectors
+template <typename Op>
+int32_t
+u8_popcnt_rvv(const uint8_t* x, const uint8_t* y, const size_t code_size, Op op) {
+    const size_t vlmax = __riscv_vsetvlmax_e8m1();
+    vuint16m2_t acc = __riscv_vmv_v_x_u16m2(0, vlmax);
+    for (size_t i = 0; i < code_size;) {
+        const size_t vl = __riscv_vsetvl_e8m1(code_size - i);
+        const vuint8m1_t bits = op(__riscv_vle8_v_u8m1(x + i, vl), __riscv_vle8_v_u8m1(y + i, vl), vl);
+        acc = __riscv_vwaddu_wv_u16m2_tu(acc, acc, popcount(bits, vl), vl);
+        i += vl;
+    }
+    const vuint32m1_t zero = __riscv_vmv_s_x_u32m1(0, 1);
+    return static_cast<int32_t>(__riscv_vmv_x_s_u32m1_u32(__riscv_vwredsumu_vs_u16m2_u32m1(acc, zero, vlmax)));
+}
+
+}  // namespace
+
 // =================== float distances ===================
 float
 fvec_inner_product_rvv(const float* x, const float* y, size_t d) {
@@ -253,7 +475,12 @@ fvec_norm_L2sqr_rvv(const float* x, size_t d) {
 
 void
 fvec_L2sqr_ny_rvv(float* dis, const float* x, const float* y, size_t d, size_t ny) {
-    for (size_t i = 0; i < ny; ++i) {
+    size_t i = 0;
+    for (; i + 4 <= ny; i += 4) {
+        fvec_L2sqr_batch_4_rvv(x, y, y + d, y + 2 * d, y + 3 * d, d, dis[i], dis[i + 1], dis[i + 2], dis[i + 3]);
+        y += 4 * d;
+    }
+    for (; i < ny; ++i) {
         dis[i] = fvec_L2sqr_rvv(x, y, d);
         y += d;
     }
@@ -261,12 +488,48 @@ fvec_L2sqr_ny_rvv(float* dis, const float* x, const float* y, size_t d, size_t n
 
 void
 fvec_inner_products_ny_rvv(float* ip, const float* x, const float* y, size_t d, size_t ny) {
-    for (size_t i = 0; i < ny; ++i) {
+    size_t i = 0;
+    for (; i + 4 <= ny; i += 4) {
+        fvec_inner_product_batch_4_rvv(x, y, y + d, y + 2 * d, y + 3 * d, d, ip[i], ip[i + 1], ip[i + 2], ip[i + 3]);
+        y += 4 * d;
+    }
+    for (; i < ny; ++i) {
         ip[i] = fvec_inner_product_rvv(x, y, d);
         y += d;
     }
 }
 
+size_t
+fvec_L2sqr_ny_nearest_rvv(float* distances_tmp_buffer, const float* x, const float* y, size_t d, size_t ny) {
+    fvec_L2sqr_ny_rvv(distances_tmp_buffer, x, y, d, ny);
+    return nearest(distances_tmp_buffer, ny);
+}
+
+// the lanes run over the vectors, y holds the j-th component of all of them at y + j * d_offset
+void
+fvec_L2sqr_ny_transposed_rvv(float* dis, const float* x, const float* y, const float* y_sqlen, size_t d,
+                             size_t d_offset, size_t ny) {
+    const float x_sqlen = fvec_norm_L2sqr_rvv(x, d);
+    for (size_t i = 0; i < ny;) {
+        const size_t vl = __riscv_vsetvl_e32m2(ny - i);
+        vfloat32m2_t dp = __riscv_vfmv_v_f_f32m2(0.0f, vl);
+        for (size_t j = 0; j < d; j++) {
+            dp = __riscv_vfmacc_vf_f32m2(dp, x[j], __riscv_vle32_v_f32m2(y + i + j * d_offset, vl), vl);
+        }
+        vfloat32m2_t res = __riscv_vfadd_vf_f32m2(__riscv_vle32_v_f32m2(y_sqlen + i, vl), x_sqlen, vl);
+        res = __riscv_vfmacc_vf_f32m2(res, -2.0f, dp, vl);
+        __riscv_vse32_v_f32m2(dis + i, res, vl);
+        i += vl;
+    }
+}
+
+size_t
+fvec_L2sqr_ny_nearest_y_transposed_rvv(float* distances_tmp_buffer, const float* x, const float* y,
+                                       const float* y_sqlen, size_t d, size_t d_offset, size_t ny) {
+    fvec_L2sqr_ny_transposed_rvv(distances_tmp_buffer, x, y, y_sqlen, d, d_offset, ny);
+    return nearest(distances_tmp_buffer, ny);
+}
+
 void
 fvec_madd_rvv(size_t n, const float* a, float bf, const float* b, float* c) {
     size_t offset = 0;
@@ -291,6 +554,275 @@ fvec_madd_rvv(size_t n, const float* a, float bf, const float* b, float* c) {
     }
 }
 
+int
+fvec_madd_and_argmin_rvv(size_t n, const float* a, float bf, const float* b, float* c) {
+    fvec_madd_rvv(n, a, bf, b, c);
+
+    float vmin = 1e20;
+    int imin = -1;
+    for (size_t i = 0; i < n; i++) {
+        if (c[i] < vmin) {
+            vmin = c[i];
+            imin = i;
+        }
+    }
+    return imin;
+}
+
+void
+fvec_inner_product_batch_4_rvv(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                               const size_t d, float& dis0, float& dis1, float& dis2, float& dis3) {
+    batch_4_rvv<false>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+void
+fvec_L2sqr_batch_4_rvv(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                       const size_t d, float& dis0, float& dis1, float& dis2, float& dis3) {
+    batch_4_rvv<true>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+int32_t
+ivec_inner_product_rvv(const int8_t* x, const int8_t* y, size_t d) {
+    return distance_rvv<false>(x, y, d);
+}
+
+int32_t
+ivec_L2sqr_rvv(const int8_t* x, const int8_t* y, size_t d) {
+    return distance_rvv<true>(x, y, d);
+}
+
+// =================== fp16 distances ===================
+float
+fp16_vec_inner_product_rvv(const knowhere::fp16* x, const knowhere::fp16* y, size_t d) {
+    return distance_rvv<false>(x, y, d);
+}
+
+float
+fp16_vec_L2sqr_rvv(const knowhere::fp16* x, const knowhere::fp16* y, size_t d) {
+    return distance_rvv<true>(x, y, d);
+}
+
+float
+fp16_vec_norm_L2sqr_rvv(const knowhere::fp16* x, size_t d) {
+    return norm_rvv(x, d);
+}
+
+void
+fp16_vec_inner_product_batch_4_rvv(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                                   const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0,
+                                   float& dis1, float& dis2, float& dis3) {
+    batch_4_rvv<false>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+void
+fp16_vec_L2sqr_batch_4_rvv(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                           const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0, float& dis1,
+                           float& dis2, float& dis3) {
+    batch_4_rvv<true>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+// =================== bf16 distances ===================
+float
+bf16_vec_inner_product_rvv(const knowhere::bf16* x, const knowhere::bf16* y, size_t d) {
+    return distance_rvv<false>(x, y, d);
+}
+
+float
+bf16_vec_L2sqr_rvv(const knowhere::bf16* x, const knowhere::bf16* y, size_t d) {
+    return distance_rvv<true>(x, y, d);
+}
+
+float
+bf16_vec_norm_L2sqr_rvv(const knowhere::bf16* x, size_t d) {
+    return norm_rvv(x, d);
+}
+
+void
+bf16_vec_inner_product_batch_4_rvv(const knowhere::bf16* x, const knowhere::bf16* y0, const knowhere::bf16* y1,
+                                   const knowhere::bf16* y2, const knowhere::bf16* y3, const size_t d, float& dis0,
+                                   float& dis1, float& dis2, float& dis3) {
+    batch_4_rvv<false>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+void
+bf16_vec_L2sqr_batch_4_rvv(const knowhere::bf16* x, const knowhere::bf16* y0, const knowhere::bf16* y1,
+                           const knowhere::bf16* y2, const knowhere::bf16* y3, const size_t d, float& dis0, float& dis1,
+                           float& dis2, float& dis3) {
+    batch_4_rvv<true>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+// =================== int8 distances ===================
+float
+int8_vec_inner_product_rvv(const int8_t* x, const int8_t* y, size_t d) {
+    return static_cast<float>(distance_rvv<false>(x, y, d));
+}
+
+float
+int8_vec_L2sqr_rvv(const int8_t* x, const int8_t* y, size_t d) {
+    return static_cast<float>(distance_rvv<true>(x, y, d));
+}
+
+float
+int8_vec_norm_L2sqr_rvv(const int8_t* x, size_t d) {
+    return static_cast<float>(norm_rvv(x, d));
+}
+
+void
+int8_vec_inner_product_batch_4_rvv(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2,
+                                   const int8_t* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                   float& dis3) {
+    batch_4_rvv<false>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+void
+int8_vec_L2sqr_batch_4_rvv(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2, const int8_t* y3,
+                           const size_t d, float& dis0, float& dis1, float& dis2, float& dis3) {
+    batch_4_rvv<true>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+// =================== batch_8 ===================
+void
+fvec_inner_product_batch_8_rvv(const float* x, const float* const* y, const size_t d, float* dis) {
+    batch_8_rvv<false>(x, y, d, dis);
+}
+
+void
+fvec_L2sqr_batch_8_rvv(const float* x, const float* const* y, const size_t d, float* dis) {
+    batch_8_rvv<true>(x, y, d, dis);
+}
+
+void
+fp16_vec_inner_product_batch_8_rvv(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                   float* dis) {
+    batch_8_rvv<false>(x, y, d, dis);
+}
+
+void
+fp16_vec_L2sqr_batch_8_rvv(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis) {
+    batch_8_rvv<true>(x, y, d, dis);
+}
+
+void
+bf16_vec_inner_product_batch_8_rvv(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d,
+                                   float* dis) {
+    batch_8_rvv<false>(x, y, d, dis);
+}
+
+void
+bf16_vec_L2sqr_batch_8_rvv(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis) {
+    batch_8_rvv<true>(x, y, d, dis);
+}
+
+void
+int8_vec_inner_product_batch_8_rvv(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    batch_8_rvv<false>(x, y, d, dis);
+}
+
+void
+int8_vec_L2sqr_batch_8_rvv(const int8_t* x, const int8_t* const* y, const size_t d, float* dis) {
+    batch_8_rvv<true>(x, y, d, dis);
+}
+
+// =================== binary distances ===================
+void
+u8_hamming_distance_ny_rvv(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                           int32_t* dis) {
+    const auto op_xor = [](vuint8m1_t a, vuint8m1_t b, size_t vl) { return __riscv_vxor_vv_u8m1(a, b, vl); };
+    for (size_t j = 0; j < ny; j++, y += code_size) {
+        dis[j] = u8_popcnt_rvv(x, y, code_size, op_xor);
+    }
+}
+
+void
+u8_jaccard_distance_ny_rvv(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis) {
+    const auto op_and = [](vuint8m1_t a, vuint8m1_t b, size_t vl) { return __riscv_vand_vv_u8m1(a, b, vl); };
+    const auto op_or = [](vuint8m1_t a, vuint8m1_t b, size_t vl) { return __riscv_vor_vv_u8m1(a, b, vl); };
+    for (size_t j = 0; j < ny; j++, y += code_size) {
+        const int32_t num = u8_popcnt_rvv(x, y, code_size, op_and);
+        const int32_t den = u8_popcnt_rvv(x, y, code_size, op_or);
+        dis[j] = den == 0 ? 1.0f : (float)(den - num) / (float)den;
+    }
+}
+
+// =================== minhash distances ===================
+float
+u32_jaccard_distance_rvv(const char* x, const char* y, size_t element_length, size_t element_size) {
+    auto u32_x = reinterpret_cast<const uint32_t*>(x);
+    auto u32_y = reinterpret_cast<const uint32_t*>(y);
+    size_t count = 0;
+    for (size_t i = 0; i < element_length;) {
+        const size_t vl = __riscv_vsetvl_e32m2(element_length - i);
+        const vuint32m2_t a = __riscv_vle32_v_u32m2(u32_x + i, vl);
+        count += __riscv_vcpop_m_b16(__riscv_vmseq_vv_u32m2_b16(a, __riscv_vle32_v_u32m2(u32_y + i, vl), vl), vl);
+        i += vl;
+    }
+    return static_cast<float>(count) / element_length;
+}
+
+void
+u32_jaccard_distance_batch_4_rvv(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3) {
+    auto u32_x = reinterpret_cast<const uint32_t*>(x);
+    auto u32_y0 = reinterpret_cast<const uint32_t*>(y0);
+    auto u32_y1 = reinterpret_cast<const uint32_t*>(y1);
+    auto u32_y2 = reinterpret_cast<const uint32_t*>(y2);
+    auto u32_y3 = reinterpret_cast<const uint32_t*>(y3);
+    size_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+    for (size_t i = 0; i < element_length;) {
+        const size_t vl = __riscv_vsetvl_e32m2(element_length - i);
+        const vuint32m2_t a = __riscv_vle32_v_u32m2(u32_x + i, vl);
+        count0 += __riscv_vcpop_m_b16(__riscv_vmseq_vv_u32m2_b16(a, __riscv_vle32_v_u32m2(u32_y0 + i, vl), vl), vl);
+        count1 += __riscv_vcpop_m_b16(__riscv_vmseq_vv_u32m2_b16(a, __riscv_vle32_v_u32m2(u32_y1 + i, vl), vl), vl);
+        count2 += __riscv_vcpop_m_b16(__riscv_vmseq_vv_u32m2_b16(a, __riscv_vle32_v_u32m2(u32_y2 + i, vl), vl), vl);
+        count3 += __riscv_vcpop_m_b16(__riscv_vmseq_vv_u32m2_b16(a, __riscv_vle32_v_u32m2(u32_y3 + i, vl), vl), vl);
+        i += vl;
+    }
+    dis0 = static_cast<float>(count0) / element_length;
+    dis1 = static_cast<float>(count1) / element_length;
+    dis2 = static_cast<float>(count2) / element_length;
+    dis3 = static_cast<float>(count3) / element_length;
+}
+
+float
+u64_jaccard_distance_rvv(const char* x, const char* y, size_t element_length, size_t element_size) {
+    auto u64_x = reinterpret_cast<const uint64_t*>(x);
+    auto u64_y = reinterpret_cast<const uint64_t*>(y);
+    size_t count = 0;
+    for (size_t i = 0; i < element_length;) {
+        const size_t vl = __riscv_vsetvl_e64m2(element_length - i);
+        const vuint64m2_t a = __riscv_vle64_v_u64m2(u64_x + i, vl);
+        count += __riscv_vcpop_m_b32(__riscv_vmseq_vv_u64m2_b32(a, __riscv_vle64_v_u64m2(u64_y + i, vl), vl), vl);
+        i += vl;
+    }
+    return static_cast<float>(count) / element_length;
+}
+
+void
+u64_jaccard_distance_batch_4_rvv(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3) {
+    auto u64_x = reinterpret_cast<const uint64_t*>(x);
+    auto u64_y0 = reinterpret_cast<const uint64_t*>(y0);
+    auto u64_y1 = reinterpret_cast<const uint64_t*>(y1);
+    auto u64_y2 = reinterpret_cast<const uint64_t*>(y2);
+    auto u64_y3 = reinterpret_cast<const uint64_t*>(y3);
+    size_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+    for (size_t i = 0; i < element_length;) {
+        const size_t vl = __riscv_vsetvl_e64m2(element_length - i);
+        const vuint64m2_t a = __riscv_vle64_v_u64m2(u64_x + i, vl);
+        count0 += __riscv_vcpop_m_b32(__riscv_vmseq_vv_u64m2_b32(a, __riscv_vle64_v_u64m2(u64_y0 + i, vl), vl), vl);
+        count1 += __riscv_vcpop_m_b32(__riscv_vmseq_vv_u64m2_b32(a, __riscv_vle64_v_u64m2(u64_y1 + i, vl), vl), vl);
+        count2 += __riscv_vcpop_m_b32(__riscv_vmseq_vv_u64m2_b32(a, __riscv_vle64_v_u64m2(u64_y2 + i, vl), vl), vl);
+        count3 += __riscv_vcpop_m_b32(__riscv_vmseq_vv_u64m2_b32(a, __riscv_vle64_v_u64m2(u64_y3 + i, vl), vl), vl);
+        i += vl;
+    }
+    dis0 = static_cast<float>(count0) / element_length;
+    dis1 = static_cast<float>(count1) / element_length;
+    dis2 = static_cast<float>(count2) / element_length;
+    dis3 = static_cast<float>(count3) / element_length;
+}
+
 }  // namespace faiss
 
 #endif
@@ -42,4 +42,137 @@ fvec_inner_products_ny_rvv(float* ip, const float* x, const float* y, size_t d,
 void
 fvec_madd_rvv(size_t n, const float* a, float bf, const float* b, float* c);
 
+int
+fvec_madd_and_argmin_rvv(size_t n, const float* a, float bf, const float* b, float* c);
+
+size_t
+fvec_L2sqr_ny_nearest_rvv(float* distances_tmp_buffer, const float* x, const float* y, size_t d, size_t ny);
+
+void
+fvec_L2sqr_ny_transposed_rvv(float* dis, const float* x, const float* y, const float* y_sqlen, size_t d,
+                             size_t d_offset, size_t ny);
+
+size_t
+fvec_L2sqr_ny_nearest_y_transposed_rvv(float* distances_tmp_buffer, const float* x, const float* y,
+                                       const float* y_sqlen, size_t d, size_t d_offset, size_t ny);
+
+void
+fvec_inner_product_batch_4_rvv(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                               const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
+
+void
+fvec_L2sqr_batch_4_rvv(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
+                       const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
+
+int32_t
+ivec_inner_product_rvv(const int8_t* x, const int8_t* y, size_t d);
+
+int32_t
+ivec_L2sqr_rvv(const int8_t* x, const int8_t* y, size_t d);
+
+float
+fp16_vec_inner_product_rvv(const knowhere::fp16* x, const knowhere::fp16* y, size_t d);
+
+float
+fp16_vec_L2sqr_rvv(const knowhere::fp16* x, const knowhere::fp16* y, size_t d);
+
+float
+fp16_vec_norm_L2sqr_rvv(const knowhere::fp16* x, size_t d);
+
+void
+fp16_vec_inner_product_batch_4_rvv(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                                   const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0,
+                                   float& dis1, float& dis2, float& dis3);
+
+void
+fp16_vec_L2sqr_batch_4_rvv(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                           const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0, float& dis1,
+                           float& dis2, float& dis3);
+
+float
+bf16_vec_inner_product_rvv(const knowhere::bf16* x, const knowhere::bf16* y, size_t d);
+
+float
+bf16_vec_L2sqr_rvv(const knowhere::bf16* x, const knowhere::bf16* y, size_t d);
+
+float
+bf16_vec_norm_L2sqr_rvv(const knowhere::bf16* x, size_t d);
+
+void
+bf16_vec_inner_product_batch_4_rvv(const knowhere::bf16* x, const knowhere::bf16* y0, const knowhere::bf16* y1,
+                                   const knowhere::bf16* y2, const knowhere::bf16* y3, const size_t d, float& dis0,
+                                   float& dis1, float& dis2, float& dis3);
+
+void
+bf16_vec_L2sqr_batch_4_rvv(const knowhere::bf16* x, const knowhere::bf16* y0, const knowhere::bf16* y1,
+                           const knowhere::bf16* y2, const knowhere::bf16* y3, const size_t d, float& dis0, float& dis1,
+                           float& dis2, float& dis3);
+
+float
+int8_vec_inner_product_rvv(const int8_t* x, const int8_t* y, size_t d);
+
+float
+int8_vec_L2sqr_rvv(const int8_t* x, const int8_t* y, size_t d);
+
+float
+int8_vec_norm_L2sqr_rvv(const int8_t* x, size_t d);
+
+void
+int8_vec_inner_product_batch_4_rvv(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2,
+                                   const int8_t* y3, const size_t d, float& dis0, float& dis1, float& dis2,
+                                   float& dis3);
+
+void
+int8_vec_L2sqr_batch_4_rvv(const int8_t* x, const int8_t* y0, const int8_t* y1, const int8_t* y2, const int8_t* y3,
+                           const size_t d, float& dis0, float& dis1, float& dis2, float& dis3);
+
+void
+fvec_inner_product_batch_8_rvv(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fvec_L2sqr_batch_8_rvv(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fp16_vec_inner_product_batch_8_rvv(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                   float* dis);
+
+void
+fp16_vec_L2sqr_batch_8_rvv(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis);
+
+void
+bf16_vec_inner_product_batch_8_rvv(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d,
+                                   float* dis);
+
+void
+bf16_vec_L2sqr_batch_8_rvv(const knowhere::bf16* x, const knowhere::bf16* const* y, const size_t d, float* dis);
+
+void
+int8_vec_inner_product_batch_8_rvv(const int8_t* x, const int8_t* const* y, const size_t d, float* dis);
+
+void
+int8_vec_L2sqr_batch_8_rvv(const int8_t* x, const int8_t* const* y, const size_t d, float* dis);
+
+void
+u8_hamming_distance_ny_rvv(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny,
+                           int32_t* dis);
+
+void
+u8_jaccard_distance_ny_rvv(const uint8_t* x, const uint8_t* y, const size_t code_size, const size_t ny, float* dis);
+
+float
+u32_jaccard_distance_rvv(const char* x, const char* y, size_t element_length, size_t element_size);
+
+void
+u32_jaccard_distance_batch_4_rvv(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3);
+
+float
+u64_jaccard_distance_rvv(const char* x, const char* y, size_t element_length, size_t element_size);
+
+void
+u64_jaccard_distance_batch_4_rvv(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3);
+
 }  // namespace faiss
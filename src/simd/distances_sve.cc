@@ -19,6 +19,119 @@
 #if defined(__ARM_FEATURE_SVE)
 namespace faiss {
 
+namespace {
+
+inline svfloat32_t
+load_as_fp32(const svbool_t pg, const float* x) {
+    return svld1_f32(pg, x);
+}
+
+// the widening load puts every fp16 in the low half of a 32-bit lane, where svcvt_f32_f16 reads it
+inline svfloat32_t
+load_as_fp32(const svbool_t pg, const knowhere::fp16* x) {
+    return svcvt_f32_f16_z(pg, svreinterpret_f16_u32(svld1uh_u32(pg, reinterpret_cast<const uint16_t*>(x))));
+}
+
+template <bool L2>
+inline svfloat32_t
+batch_step(const svbool_t pg, const svfloat32_t acc, const svfloat32_t a, const svfloat32_t b) {
+    if constexpr (L2) {
+        const svfloat32_t diff = svsub_f32_x(pg, a, b);
+        return svmla_f32_m(pg, acc, diff, diff);
+    } else {
+        return svmla_f32_m(pg, acc, a, b);
+    }
+}
+
+template <bool L2, typename T>
+void
+batch_4_sve(const T* x, const T* y0, const T* y1, const T* y2, const T* y3, const size_t d, float& dis0, float& dis1,
+            float& dis2, float& dis3) {
+    svfloat32_t acc0 = svdup_f32(0.0f);
+    svfloat32_t acc1 = svdup_f32(0.0f);
+    svfloat32_t acc2 = svdup_f32(0.0f);
+    svfloat32_t acc3 = svdup_f32(0.0f);
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b32();
+
+    while (i < d) {
+        if (d - i < svcntw())
+            pg = svwhilelt_b32(i, d);
+
+        const svfloat32_t vx = load_as_fp32(pg, x + i);
+        acc0 = batch_step<L2>(pg, acc0, vx, load_as_fp32(pg, y0 + i));
+        acc1 = batch_step<L2>(pg, acc1, vx, load_as_fp32(pg, y1 + i));
+        acc2 = batch_step<L2>(pg, acc2, vx, load_as_fp32(pg, y2 + i));
+        acc3 = batch_step<L2>(pg, acc3, vx, load_as_fp32(pg, y3 + i));
+
+        i += svcntw();
+    }
+
+    dis0 = svaddv_f32(svptrue_b32(), acc0);
+    dis1 = svaddv_f32(svptrue_b32(), acc1);
+    dis2 = svaddv_f32(svptrue_b32(), acc2);
+    dis3 = svaddv_f32(svptrue_b32(), acc3);
+}
+
+// sizeless vectors cannot be put in arrays, so the 8 accumulators are spelled out
+template <bool L2, typename T>
+void
+batch_8_sve(const T* x, const T* const* y, const size_t d, float* dis) {
+    svfloat32_t acc0 = svdup_f32(0.0f);
+    svfloat32_t acc1 = svdup_f32(0.0f);
+    svfloat32_t acc2 = svdup_f32(0.0f);
+    svfloat32_t acc3 = svdup_f32(0.0f);
+    svfloat32_t acc4 = svdup_f32(0.0f);
+    svfloat32_t acc5 = svdup_f32(0.0f);
+    svfloat32_t acc6 = svdup_f32(0.0f);
+    svfloat32_t acc7 = svdup_f32(0.0f);
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b32();
+
+    while (i < d) {
+        if (d - i < svcntw())
+            pg = svwhilelt_b32(i, d);
+
+        const svfloat32_t vx = load_as_fp32(pg, x + i);
+        acc0 = batch_step<L2>(pg, acc0, vx, load_as_fp32(pg, y[0] + i));
+        acc1 = batch_step<L2>(pg, acc1, vx, load_as_fp32(pg, y[1] + i));
+        acc2 = batch_step<L2>(pg, acc2, vx, load_as_fp32(pg, y[2] + i));
+        acc3 = batch_step<L2>(pg, acc3, vx, load_as_fp32(pg, y[3] + i));
+        acc4 = batch_step<L2>(pg, acc4, vx, load_as_fp32(pg, y[4] + i));
+        acc5 = batch_step<L2>(pg, acc5, vx, load_as_fp32(pg, y[5] + i));
+        acc6 = batch_step<L2>(pg, acc6, vx, load_as_fp32(pg, y[6] + i));
+        acc7 = batch_step<L2>(pg, acc7, vx, load_as_fp32(pg, y[7] + i));
+
+        i += svcntw();
+    }
+
+    dis[0] = svaddv_f32(svptrue_b32(), acc0);
+    dis[1] = svaddv_f32(svptrue_b32(), acc1);
+    dis[2] = svaddv_f32(svptrue_b32(), acc2);
+    dis[3] = svaddv_f32(svptrue_b32(), acc3);
+    dis[4] = svaddv_f32(svptrue_b32(), acc4);
+    dis[5] = svaddv_f32(svptrue_b32(), acc5);
+    dis[6] = svaddv_f32(svptrue_b32(), acc6);
+    dis[7] = svaddv_f32(svptrue_b32(), acc7);
+}
+
+size_t
+nearest(const float* dis, const size_t ny) {
+    size_t nearest_idx = 0;
+    float min_dis = HUGE_VALF;
+    for (size_t i = 0; i < ny; i++) {
+        if (dis[i] < min_dis) {
+            min_dis = dis[i];
+            nearest_idx = i;
+        }
+    }
+    return nearest_idx;
+}
+
+}  // namespace
+
 float
 fvec_L2sqr_sve(const float* x, const float* y, size_t d) {
     svfloat32_t sum = svdup_f32(0.0f);
@@ -309,31 +422,17 @@ fvec_inner_product_batch_4_sve(const float* x, const float* y0, const float* y1,
 void
 fvec_L2sqr_batch_4_sve(const float* x, const float* y0, const float* y1, const float* y2, const float* y3,
                        const size_t d, float& dis0, float& dis1, float& dis2, float& dis3) {
-    float d0 = 0;
-    float d1 = 0;
-    float d2 = 0;
-    float d3 = 0;
-
-    for (size_t i = 0; i < d; ++i) {
-        const float q0 = x[i] - y0[i];
-        const float q1 = x[i] - y1[i];
-        const float q2 = x[i] - y2[i];
-        const float q3 = x[i] - y3[i];
-        d0 += q0 * q0;
-        d1 += q1 * q1;
-        d2 += q2 * q2;
-        d3 += q3 * q3;
-    }
-
-    dis0 = d0;
-    dis1 = d1;
-    dis2 = d2;
-    dis3 = d3;
+    batch_4_sve<true>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
 }
 
 void
 fvec_L2sqr_ny_sve(float* dis, const float* x, const float* y, size_t d, size_t ny) {
-    for (size_t i = 0; i < ny; ++i) {
+    size_t i = 0;
+    for (; i + 4 <= ny; i += 4) {
+        fvec_L2sqr_batch_4_sve(x, y, y + d, y + 2 * d, y + 3 * d, d, dis[i], dis[i + 1], dis[i + 2], dis[i + 3]);
+        y += 4 * d;
+    }
+    for (; i < ny; ++i) {
         dis[i] = fvec_L2sqr_sve(x, y, d);
         y += d;
     }
@@ -341,12 +440,90 @@ fvec_L2sqr_ny_sve(float* dis, const float* x, const float* y, size_t d, size_t n
 
 void
 fvec_inner_products_ny_sve(float* ip, const float* x, const float* y, size_t d, size_t ny) {
-    for (size_t i = 0; i < ny; ++i) {
+    size_t i = 0;
+    for (; i + 4 <= ny; i += 4) {
+        fvec_inner_product_batch_4_sve(x, y, y + d, y + 2 * d, y + 3 * d, d, ip[i], ip[i + 1], ip[i + 2], ip[i + 3]);
+        y += 4 * d;
+    }
+    for (; i < ny; ++i) {
         ip[i] = fvec_inner_product_sve(x, y, d);
         y += d;
     }
 }
 
+size_t
+fvec_L2sqr_ny_nearest_sve(float* distances_tmp_buffer, const float* x, const float* y, size_t d, size_t ny) {
+    fvec_L2sqr_ny_sve(distances_tmp_buffer, x, y, d, ny);
+    return nearest(distances_tmp_buffer, ny);
+}
+
+// the lanes run over the vectors, y holds the j-th component of all of them at y + j * d_offset
+void
+fvec_L2sqr_ny_transposed_sve(float* dis, const float* x, const float* y, const float* y_sqlen, size_t d,
+                             size_t d_offset, size_t ny) {
+    const float x_sqlen = fvec_norm_L2sqr_sve(x, d);
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b32();
+
+    while (i < ny) {
+        if (ny - i < svcntw())
+            pg = svwhilelt_b32(i, ny);
+
+        svfloat32_t dp = svdup_f32(0.0f);
+        for (size_t j = 0; j < d; j++) {
+            dp = svmla_n_f32_m(pg, dp, svld1_f32(pg, y + i + j * d_offset), x[j]);
+        }
+        svfloat32_t res = svadd_n_f32_m(pg, svld1_f32(pg, y_sqlen + i), x_sqlen);
+        res = svmla_n_f32_m(pg, res, dp, -2.0f);
+        svst1_f32(pg, dis + i, res);
+
+        i += svcntw();
+    }
+}
+
+size_t
+fvec_L2sqr_ny_nearest_y_transposed_sve(float* distances_tmp_buffer, const float* x, const float* y,
+                                       const float* y_sqlen, size_t d, size_t d_offset, size_t ny) {
+    fvec_L2sqr_ny_transposed_sve(distances_tmp_buffer, x, y, y_sqlen, d, d_offset, ny);
+    return nearest(distances_tmp_buffer, ny);
+}
+
+void
+fp16_vec_inner_product_batch_4_sve(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                                   const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0,
+                                   float& dis1, float& dis2, float& dis3) {
+    batch_4_sve<false>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+void
+fp16_vec_L2sqr_batch_4_sve(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                           const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0, float& dis1,
+                           float& dis2, float& dis3) {
+    batch_4_sve<true>(x, y0, y1, y2, y3, d, dis0, dis1, dis2, dis3);
+}
+
+void
+fvec_inner_product_batch_8_sve(const float* x, const float* const* y, const size_t d, float* dis) {
+    batch_8_sve<false>(x, y, d, dis);
+}
+
+void
+fvec_L2sqr_batch_8_sve(const float* x, const float* const* y, const size_t d, float* dis) {
+    batch_8_sve<true>(x, y, d, dis);
+}
+
+void
+fp16_vec_inner_product_batch_8_sve(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                   float* dis) {
+    batch_8_sve<false>(x, y, d, dis);
+}
+
+void
+fp16_vec_L2sqr_batch_8_sve(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis) {
+    batch_8_sve<true>(x, y, d, dis);
+}
+
 float
 int8_vec_L2sqr_sve(const int8_t* x, const int8_t* y, size_t d) {
     int32_t scalar_sum = 0;
@@ -774,6 +951,147 @@ bf16_vec_inner_product_batch_4_sve(const knowhere::bf16* x, const knowhere::bf16
     dis3 = svaddv_f32(svptrue_b32(), acc3);
 }
 
+float
+u32_jaccard_distance_sve(const char* x, const char* y, size_t element_length, size_t element_size) {
+    auto u32_x = reinterpret_cast<const uint32_t*>(x);
+    auto u32_y = reinterpret_cast<const uint32_t*>(y);
+    uint64_t count = 0;
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b32();
+
+    while (i < element_length) {
+        if (element_length - i < svcntw())
+            pg = svwhilelt_b32(i, element_length);
+
+        const svuint32_t a = svld1_u32(pg, u32_x + i);
+        count += svcntp_b32(pg, svcmpeq_u32(pg, a, svld1_u32(pg, u32_y + i)));
+
+        i += svcntw();
+    }
+
+    return static_cast<float>(count) / element_length;
+}
+
+void
+u32_jaccard_distance_batch_4_sve(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3) {
+    auto u32_x = reinterpret_cast<const uint32_t*>(x);
+    auto u32_y0 = reinterpret_cast<const uint32_t*>(y0);
+    auto u32_y1 = reinterpret_cast<const uint32_t*>(y1);
+    auto u32_y2 = reinterpret_cast<const uint32_t*>(y2);
+    auto u32_y3 = reinterpret_cast<const uint32_t*>(y3);
+    uint64_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b32();
+
+    while (i < element_length) {
+        if (element_length - i < svcntw())
+            pg = svwhilelt_b32(i, element_length);
+
+        const svuint32_t a = svld1_u32(pg, u32_x + i);
+        count0 += svcntp_b32(pg, svcmpeq_u32(pg, a, svld1_u32(pg, u32_y0 + i)));
+        count1 += svcntp_b32(pg, svcmpeq_u32(pg, a, svld1_u32(pg, u32_y1 + i)));
+        count2 += svcntp_b32(pg, svcmpeq_u32(pg, a, svld1_u32(pg, u32_y2 + i)));
+        count3 += svcntp_b32(pg, svcmpeq_u32(pg, a, svld1_u32(pg, u32_y3 + i)));
+
+        i += svcntw();
+    }
+
+    dis0 = static_cast<float>(count0) / element_length;
+    dis1 = static_cast<float>(count1) / element_length;
+    dis2 = static_cast<float>(count2) / element_length;
+    dis3 = static_cast<float>(count3) / element_length;
+}
+
+float
+u64_jaccard_distance_sve(const char* x, const char* y, size_t element_length, size_t element_size) {
+    auto u64_x = reinterpret_cast<const uint64_t*>(x);
+    auto u64_y = reinterpret_cast<const uint64_t*>(y);
+    uint64_t count = 0;
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b64();
+
+    while (i < element_length) {
+        if (element_length - i < svcntd())
+            pg = svwhilelt_b64(i, element_length);
+
+        const svuint64_t a = svld1_u64(pg, u64_x + i);
+        count += svcntp_b64(pg, svcmpeq_u64(pg, a, svld1_u64(pg, u64_y + i)));
+
+        i += svcntd();
+    }
+
+    return static_cast<float>(count) / element_length;
+}
+
+void
+u64_jaccard_distance_batch_4_sve(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3) {
+    auto u64_x = reinterpret_cast<const uint64_t*>(x);
+    auto u64_y0 = reinterpret_cast<const uint64_t*>(y0);
+    auto u64_y1 = reinterpret_cast<const uint64_t*>(y1);
+    auto u64_y2 = reinterpret_cast<const uint64_t*>(y2);
+    auto u64_y3 = reinterpret_cast<const uint64_t*>(y3);
+    uint64_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+
+    size_t i = 0;
+    svbool_t pg = svptrue_b64();
+
+    while (i < element_length) {
+        if (element_length - i < svcntd())
+            pg = svwhilelt_b64(i, element_length);
+
+        const svuint64_t a = svld1_u64(pg, u64_x + i);
+        count0 += svcntp_b64(pg, svcmpeq_u64(pg, a, svld1_u64(pg, u64_y0 + i)));
+        count1 += svcntp_b64(pg, svcmpeq_u64(pg, a, svld1_u64(pg, u64_y1 + i)));
+        count2 += svcntp_b64(pg, svcmpeq_u64(pg, a, svld1_u64(pg, u64_y2 + i)));
+        count3 += svcntp_b64(pg, svcmpeq_u64(pg, a, svld1_u64(pg, u64_y3 + i)));
+
+        i += svcntd();
+    }
+
+    dis0 = static_cast<float>(count0) / element_length;
+    dis1 = static_cast<float>(count1) / element_length;
+    dis2 = static_cast<float>(count2) / element_length;
+    dis3 = static_cast<float>(count3) / element_length;
+}
+
+int
+rabitq_dp_popcnt_sve(const uint8_t* q, const uint8_t* x, const size_t d, const size_t nb) {
+    const size_t di_8b = (d + 7) / 8;
+    const svuint8_t ones = svdup_u8(1);
+
+    int dot = 0;
+    for (size_t j = 0; j < nb; j++) {
+        const uint8_t* q_j = q + j * di_8b;
+
+        // the byte popcounts are summed into 32-bit lanes by the dot product with ones
+        svuint32_t acc = svdup_u32(0);
+        size_t i = 0;
+        svbool_t pg = svptrue_b8();
+
+        while (i < di_8b) {
+            if (di_8b - i < svcntb())
+                pg = svwhilelt_b8(i, di_8b);
+
+            const svuint8_t qx = svand_u8_z(pg, svld1_u8(pg, q_j + i), svld1_u8(pg, x + i));
+            acc = svdot_u32(acc, svcnt_u8_z(pg, qx), ones);
+
+            i += svcntb();
+        }
+
+        const int count_dot = static_cast<int>(svaddv_u32(svptrue_b32(), acc));
+        dot += (count_dot << j);
+    }
+
+    return dot;
+}
+
 }  // namespace faiss
 
 #endif
@@ -66,6 +66,40 @@ fvec_L2sqr_ny_sve(float* dis, const float* x, const float* y, size_t d, size_t n
 void
 fvec_inner_products_ny_sve(float* ip, const float* x, const float* y, size_t d, size_t ny);
 
+size_t
+fvec_L2sqr_ny_nearest_sve(float* distances_tmp_buffer, const float* x, const float* y, size_t d, size_t ny);
+
+void
+fvec_L2sqr_ny_transposed_sve(float* dis, const float* x, const float* y, const float* y_sqlen, size_t d,
+                             size_t d_offset, size_t ny);
+
+size_t
+fvec_L2sqr_ny_nearest_y_transposed_sve(float* distances_tmp_buffer, const float* x, const float* y,
+                                       const float* y_sqlen, size_t d, size_t d_offset, size_t ny);
+
+void
+fp16_vec_inner_product_batch_4_sve(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                                   const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0,
+                                   float& dis1, float& dis2, float& dis3);
+
+void
+fp16_vec_L2sqr_batch_4_sve(const knowhere::fp16* x, const knowhere::fp16* y0, const knowhere::fp16* y1,
+                           const knowhere::fp16* y2, const knowhere::fp16* y3, const size_t d, float& dis0, float& dis1,
+                           float& dis2, float& dis3);
+
+void
+fvec_inner_product_batch_8_sve(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fvec_L2sqr_batch_8_sve(const float* x, const float* const* y, const size_t d, float* dis);
+
+void
+fp16_vec_inner_product_batch_8_sve(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d,
+                                   float* dis);
+
+void
+fp16_vec_L2sqr_batch_8_sve(const knowhere::fp16* x, const knowhere::fp16* const* y, const size_t d, float* dis);
+
 float
 int8_vec_L2sqr_sve(const int8_t* x, const int8_t* y, size_t d);
 
@@ -103,5 +137,24 @@ bf16_vec_inner_product_batch_4_sve(const knowhere::bf16* x, const knowhere::bf16
                                    const knowhere::bf16* y2, const knowhere::bf16* y3, const size_t d, float& dis0,
                                    float& dis1, float& dis2, float& dis3);
 
+float
+u32_jaccard_distance_sve(const char* x, const char* y, size_t element_length, size_t element_size);
+
+void
+u32_jaccard_distance_batch_4_sve(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3);
+
+float
+u64_jaccard_distance_sve(const char* x, const char* y, size_t element_length, size_t element_size);
+
+void
+u64_jaccard_distance_batch_4_sve(const char* x, const char* y0, const char* y1, const char* y2, const char* y3,
+                                 size_t element_length, size_t element_size, float& dis0, float& dis1, float& dis2,
+                                 float& dis3);
+
+int
+rabitq_dp_popcnt_sve(const uint8_t* q, const uint8_t* x, const size_t d, const size_t nb);
+
 }  // namespace faiss
 #endif
@@ -11,24 +11,34 @@
 
 #include "hook.h"
 
+#include <algorithm>
+#include <limits>
 #include <mutex>
 
 #include "faiss/FaissHook.h"
 
 #if defined(__x86_64__)
+#include "distances_amx.h"
 #include "distances_avx.h"
 #include "distances_avx512.h"
+#include "distances_avx512bf16.h"
 #include "distances_avx512icx.h"
 #include "distances_sse.h"
 #include "instruction_set.h"
 #endif
 
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #if defined(__ARM_NEON)
 #include "distances_neon.h"
 #endif
 
-#if defined(__riscv_vector)
+#if defined(__riscv)
 #include "distances_rvv.h"
+#include "instruction_set.h"
 #endif
 
 #if defined(__ARM_FEATURE_SVE)
@@ -96,6 +106,9 @@ decltype(bf16_vec_norm_L2sqr) bf16_vec_norm_L2sqr = bf16_vec_norm_L2sqr_ref;
 decltype(bf16_vec_inner_product_batch_4) bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_ref;
 decltype(bf16_vec_L2sqr_batch_4) bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_ref;
 
+decltype(bf16_vec_inner_products_nx_ny) bf16_vec_inner_products_nx_ny = bf16_vec_inner_products_nx_ny_ref;
+bool support_bf16_amx = false;
+
 // int8
 decltype(int8_vec_L2sqr) int8_vec_L2sqr = int8_vec_L2sqr_ref;
 decltype(int8_vec_inner_product) int8_vec_inner_product = int8_vec_inner_product_ref;
@@ -104,18 +117,51 @@ decltype(int8_vec_norm_L2sqr) int8_vec_norm_L2sqr = int8_vec_norm_L2sqr_ref;
 decltype(int8_vec_inner_product_batch_4) int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_ref;
 decltype(int8_vec_L2sqr_batch_4) int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_ref;
 
+decltype(int8_vec_inner_products_nx_ny) int8_vec_inner_products_nx_ny = int8_vec_inner_products_nx_ny_ref;
+bool support_int8_amx = false;
+
+// batch_8
+decltype(fvec_inner_product_batch_8) fvec_inner_product_batch_8 = fvec_inner_product_batch_8_ref;
+decltype(fvec_L2sqr_batch_8) fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_ref;
+decltype(fp16_vec_inner_product_batch_8) fp16_vec_inner_product_batch_8 = fp16_vec_inner_product_batch_8_ref;
+decltype(fp16_vec_L2sqr_batch_8) fp16_vec_L2sqr_batch_8 = fp16_vec_L2sqr_batch_8_ref;
+decltype(bf16_vec_inner_product_batch_8) bf16_vec_inner_product_batch_8 = bf16_vec_inner_product_batch_8_ref;
+decltype(bf16_vec_L2sqr_batch_8) bf16_vec_L2sqr_batch_8 = bf16_vec_L2sqr_batch_8_ref;
+decltype(int8_vec_inner_product_batch_8) int8_vec_inner_product_batch_8 = int8_vec_inner_product_batch_8_ref;
+decltype(int8_vec_L2sqr_batch_8) int8_vec_L2sqr_batch_8 = int8_vec_L2sqr_batch_8_ref;
+
+// ny_topk
+decltype(fvec_L2sqr_ny_topk) fvec_L2sqr_ny_topk = fvec_L2sqr_ny_topk_ref;
+decltype(fp16_vec_L2sqr_ny_topk) fp16_vec_L2sqr_ny_topk = fp16_vec_L2sqr_ny_topk_ref;
+decltype(bf16_vec_L2sqr_ny_topk) bf16_vec_L2sqr_ny_topk = bf16_vec_L2sqr_ny_topk_ref;
+
+// threshold filter
+decltype(fvec_threshold_filter) fvec_threshold_filter = fvec_threshold_filter_ref;
+
 // rabitq
 decltype(fvec_masked_sum) fvec_masked_sum = fvec_masked_sum_ref;
 decltype(rabitq_dp_popcnt) rabitq_dp_popcnt = rabitq_dp_popcnt_ref;
 
+// binary
+decltype(u8_hamming_distance_ny) u8_hamming_distance_ny = u8_hamming_distance_ny_ref;
+decltype(u8_jaccard_distance_ny) u8_jaccard_distance_ny = u8_jaccard_distance_ny_ref;
+
 // minhash
 decltype(u64_binary_search_eq) u64_binary_search_eq = u64_binary_search_eq_ref;
 decltype(u64_binary_search_ge) u64_binary_search_ge = u64_binary_search_ge_ref;
 decltype(calculate_hash) calculate_hash = calculate_hash_ref;
+decltype(u64_minhash_update) u64_minhash_update = u64_minhash_update_ref;
 decltype(u32_jaccard_distance) u32_jaccard_distance = u32_jaccard_distance_ref;
 decltype(u32_jaccard_distance_batch_4) u32_jaccard_distance_batch_4 = u32_jaccard_distance_batch_4_ref;
 decltype(u64_jaccard_distance) u64_jaccard_distance = u64_jaccard_distance_ref;
 decltype(u64_jaccard_distance_batch_4) u64_jaccard_distance_batch_4 = u64_jaccard_distance_batch_4_ref;
+
+// sparse
+decltype(u32_bitpacked_delta_decode) u32_bitpacked_delta_decode = u32_bitpacked_delta_decode_ref;
+decltype(u32_sparse_intersect) u32_sparse_intersect = u32_sparse_intersect_ref;
+
+// pq
+decltype(u8_pq4_fast_scan) u8_pq4_fast_scan = u8_pq4_fast_scan_ref;
 ///////////////////////////////////////////////////////////////////////////////
 #if defined(__x86_64__)
 bool
@@ -141,6 +187,32 @@ cpu_support_f16c() {
     InstructionSet& instruction_set_inst = InstructionSet::GetInstance();
     return (instruction_set_inst.F16C());
 }
+
+static bool
+amx_tiles_permitted() {
+    if (!InstructionSet::GetInstance().AMX_TILE()) {
+        return false;
+    }
+#if defined(__linux__)
+    // the tile data is an xsave state that linux only enables for the processes asking for it
+    constexpr int kArchReqXcompPerm = 0x1023;
+    constexpr int kXfeatureXtiledata = 18;
+    static const bool permitted = syscall(SYS_arch_prctl, kArchReqXcompPerm, kXfeatureXtiledata) == 0;
+    return permitted;
+#else
+    return false;
+#endif
+}
+
+bool
+cpu_support_amx_int8() {
+    return InstructionSet::GetInstance().AMX_INT8() && amx_tiles_permitted();
+}
+
+bool
+cpu_support_amx_bf16() {
+    return InstructionSet::GetInstance().AMX_BF16() && amx_tiles_permitted();
+}
 #endif
 
 #if defined(__aarch64__)
@@ -158,6 +230,134 @@ supports_sve() {
 #endif
 #endif
 
+#if defined(__riscv)
+// distances_rvv.cc alone is built for the vector extension, its kernels need VLEN >= 128 of RVV 1.0
+bool
+supports_rvv() {
+    return InstructionSet::GetInstance().RVV() && InstructionSet::GetInstance().VLEN() >= 128;
+}
+#endif
+
+namespace {
+// the batch_8 kernel of the SIMD levels without one of their own
+template <typename T, auto& batch_4>
+void
+batch_8_by_4(const T* x, const T* const* y, const size_t d, float* dis) {
+    batch_4(x, y[0], y[1], y[2], y[3], d, dis[0], dis[1], dis[2], dis[3]);
+    batch_4(x, y[4], y[5], y[6], y[7], d, dis[4], dis[5], dis[6], dis[7]);
+}
+
+void
+fvec_batch_8_by_4() {
+    fvec_inner_product_batch_8 = batch_8_by_4<float, fvec_inner_product_batch_4>;
+    fvec_L2sqr_batch_8 = batch_8_by_4<float, fvec_L2sqr_batch_4>;
+}
+
+void
+typed_batch_8_by_4() {
+    fp16_vec_inner_product_batch_8 = batch_8_by_4<knowhere::fp16, fp16_vec_inner_product_batch_4>;
+    fp16_vec_L2sqr_batch_8 = batch_8_by_4<knowhere::fp16, fp16_vec_L2sqr_batch_4>;
+    bf16_vec_inner_product_batch_8 = batch_8_by_4<knowhere::bf16, bf16_vec_inner_product_batch_4>;
+    bf16_vec_L2sqr_batch_8 = batch_8_by_4<knowhere::bf16, bf16_vec_L2sqr_batch_4>;
+    int8_vec_inner_product_batch_8 = batch_8_by_4<int8_t, int8_vec_inner_product_batch_4>;
+    int8_vec_L2sqr_batch_8 = batch_8_by_4<int8_t, int8_vec_L2sqr_batch_4>;
+}
+
+// the ny_topk kernel of every SIMD level: the rows are scored 8 at a time by the batch_8 hook and kept in a sorted
+// array of k while it is in L1. A row is only inserted when it beats the k-th distance, which most rows stop doing
+// after the first ones.
+template <typename T, auto& batch_8, auto& l2sqr>
+void
+ny_topk_by_batch_8(const T* x, const T* y, size_t d, size_t ny, size_t k, float* dis, int64_t* ids) {
+    std::fill(dis, dis + k, std::numeric_limits<float>::max());
+    std::fill(ids, ids + k, -1);
+    if (k == 0) {
+        return;
+    }
+    auto push = [dis, ids, k](const float v, const int64_t id) {
+        if (!(v < dis[k - 1])) {
+            return;
+        }
+        size_t pos = k - 1;
+        for (; pos > 0 && dis[pos - 1] > v; pos--) {
+            dis[pos] = dis[pos - 1];
+            ids[pos] = ids[pos - 1];
+        }
+        dis[pos] = v;
+        ids[pos] = id;
+    };
+    float batch[8];
+    const T* rows[8];
+    size_t j = 0;
+    for (; j + 8 <= ny; j += 8) {
+        for (size_t r = 0; r < 8; r++) {
+            rows[r] = y + (j + r) * d;
+        }
+        batch_8(x, rows, d, batch);
+        for (size_t r = 0; r < 8; r++) {
+            push(batch[r], j + r);
+        }
+    }
+    for (; j < ny; j++) {
+        push(l2sqr(x, y + j * d, d), j);
+    }
+}
+
+void
+ny_topk_by_batch_8() {
+    fvec_L2sqr_ny_topk = ny_topk_by_batch_8<float, fvec_L2sqr_batch_8, fvec_L2sqr>;
+    fp16_vec_L2sqr_ny_topk = ny_topk_by_batch_8<knowhere::fp16, fp16_vec_L2sqr_batch_8, fp16_vec_L2sqr>;
+    bf16_vec_L2sqr_ny_topk = ny_topk_by_batch_8<knowhere::bf16, bf16_vec_L2sqr_batch_8, bf16_vec_L2sqr>;
+}
+}  // namespace
+
+FvecSimdLevel
+fvec_simd_level() {
+#if defined(__x86_64__)
+    if (fvec_L2sqr == fvec_L2sqr_avx512 && fvec_inner_product == fvec_inner_product_avx512 &&
+        fvec_L2sqr_batch_4 == fvec_L2sqr_batch_4_avx512 &&
+        fvec_inner_product_batch_4 == fvec_inner_product_batch_4_avx512) {
+        return FvecSimdLevel::AVX512;
+    }
+    if (fvec_L2sqr == fvec_L2sqr_avx && fvec_inner_product == fvec_inner_product_avx &&
+        fvec_L2sqr_batch_4 == fvec_L2sqr_batch_4_avx && fvec_inner_product_batch_4 == fvec_inner_product_batch_4_avx) {
+        return FvecSimdLevel::AVX2;
+    }
+#endif
+    return FvecSimdLevel::NONE;
+}
+
+FvecDimKernels
+fvec_dim_kernels(size_t d) {
+#if defined(__x86_64__)
+    const FvecSimdLevel level = fvec_simd_level();
+    if (level == FvecSimdLevel::AVX512) {
+        switch (d) {
+#define FVEC_DIM_KERNELS_AVX512(D)                                                                                     \
+    case D:                                                                                                            \
+        return {fvec_L2sqr_avx512_dim<D>, fvec_inner_product_avx512_dim<D>, fvec_L2sqr_batch_4_avx512_dim<D>,          \
+                fvec_inner_product_batch_4_avx512_dim<D>};
+            FVEC_UNROLLED_DIMS(FVEC_DIM_KERNELS_AVX512)
+#undef FVEC_DIM_KERNELS_AVX512
+            default:
+                break;
+        }
+    } else if (level == FvecSimdLevel::AVX2) {
+        switch (d) {
+#define FVEC_DIM_KERNELS_AVX(D)                                                                                        \
+    case D:                                                                                                            \
+        return {fvec_L2sqr_avx_dim<D>, fvec_inner_product_avx_dim<D>, fvec_L2sqr_batch_4_avx_dim<D>,                   \
+                fvec_inner_product_batch_4_avx_dim<D>};
+            FVEC_UNROLLED_DIMS(FVEC_DIM_KERNELS_AVX)
+#undef FVEC_DIM_KERNELS_AVX
+            default:
+                break;
+        }
+    }
+#endif
+    return {fvec_L2sqr, fvec_inner_product, fvec_L2sqr_batch_4, fvec_inner_product_batch_4};
+}
+
 static std::mutex patch_bf16_mutex;
 
 void
@@ -186,6 +386,7 @@ enable_patch_for_fp32_bf16() {
         fvec_L2sqr = fvec_L2sqr_bf16_patch_ref;
         fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_bf16_patch_ref;
     }
+    fvec_batch_8_by_4();
 #endif
 
 #if defined(__aarch64__)
@@ -197,6 +398,7 @@ enable_patch_for_fp32_bf16() {
 
     fvec_L2sqr = fvec_L2sqr_bf16_patch_neon;
     fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_bf16_patch_neon;
+    fvec_batch_8_by_4();
 
 #endif
 
@@ -214,12 +416,18 @@ disable_patch_for_fp32_bf16() {
 
         fvec_L2sqr = fvec_L2sqr_avx512;
         fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_avx512;
+
+        fvec_inner_product_batch_8 = fvec_inner_product_batch_8_avx512;
+        fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_avx512;
     } else if (use_avx2 && cpu_support_avx2()) {
         fvec_inner_product = fvec_inner_product_avx;
         fvec_inner_product_batch_4 = fvec_inner_product_batch_4_avx;
 
         fvec_L2sqr = fvec_L2sqr_avx;
         fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_avx;
+
+        fvec_inner_product_batch_8 = fvec_inner_product_batch_8_avx;
+        fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_avx;
     } else if (use_sse4_2 && cpu_support_sse4_2()) {
         // The branch that can't be reached
     } else {
@@ -228,6 +436,7 @@ disable_patch_for_fp32_bf16() {
 
         fvec_L2sqr = fvec_L2sqr_ref;
         fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_ref;
+        fvec_batch_8_by_4();
     }
 #endif
 }
@@ -266,20 +475,53 @@ fvec_hook(std::string& simd_type) {
         fp16_vec_L2sqr_batch_4 = fp16_vec_L2sqr_batch_4_avx512;
 
         // bf16
-        bf16_vec_inner_product = bf16_vec_inner_product_avx512;
+        if (InstructionSet::GetInstance().AVX512_BF16()) {
+            bf16_vec_inner_product = bf16_vec_inner_product_avx512bf16;
+            bf16_vec_norm_L2sqr = bf16_vec_norm_L2sqr_avx512bf16;
+            bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_avx512bf16;
+        } else {
+            bf16_vec_inner_product = bf16_vec_inner_product_avx512;
+            bf16_vec_norm_L2sqr = bf16_vec_norm_L2sqr_avx512;
+            bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_avx512;
+        }
         bf16_vec_L2sqr = bf16_vec_L2sqr_avx512;
-        bf16_vec_norm_L2sqr = bf16_vec_norm_L2sqr_avx512;
-
-        bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_avx512;
         bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_avx512;
+        support_bf16_amx = cpu_support_amx_bf16();
+        bf16_vec_inner_products_nx_ny =
+            support_bf16_amx ? bf16_vec_inner_products_nx_ny_amx : bf16_vec_inner_products_nx_ny_ref;
 
         // int8
-        int8_vec_inner_product = int8_vec_inner_product_avx512;
-        int8_vec_L2sqr = int8_vec_L2sqr_avx512;
-        int8_vec_norm_L2sqr = int8_vec_norm_L2sqr_avx512;
+        if (InstructionSet::GetInstance().AVX512VNNI()) {
+            int8_vec_inner_product = int8_vec_inner_product_avx512icx;
+            int8_vec_L2sqr = int8_vec_L2sqr_avx512icx;
+            int8_vec_norm_L2sqr = int8_vec_norm_L2sqr_avx512icx;
+
+            int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_avx512icx;
+            int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_avx512icx;
+        } else {
+            int8_vec_inner_product = int8_vec_inner_product_avx512;
+            int8_vec_L2sqr = int8_vec_L2sqr_avx512;
+            int8_vec_norm_L2sqr = int8_vec_norm_L2sqr_avx512;
 
-        int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_avx512;
-        int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_avx512;
+            int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_avx512;
+            int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_avx512;
+        }
+        support_int8_amx = cpu_support_amx_int8();
+        int8_vec_inner_products_nx_ny =
+            support_int8_amx ? int8_vec_inner_products_nx_ny_amx : int8_vec_inner_products_nx_ny_ref;
+
+        // batch_8
+        fvec_inner_product_batch_8 = fvec_inner_product_batch_8_avx512;
+        fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_avx512;
+        fp16_vec_inner_product_batch_8 = fp16_vec_inner_product_batch_8_avx512;
+        fp16_vec_L2sqr_batch_8 = fp16_vec_L2sqr_batch_8_avx512;
+        bf16_vec_inner_product_batch_8 = bf16_vec_inner_product_batch_8_avx512;
+        bf16_vec_L2sqr_batch_8 = bf16_vec_L2sqr_batch_8_avx512;
+        int8_vec_inner_product_batch_8 = int8_vec_inner_product_batch_8_avx512;
+        int8_vec_L2sqr_batch_8 = int8_vec_L2sqr_batch_8_avx512;
+
+        // threshold filter
+        fvec_threshold_filter = fvec_threshold_filter_avx512;
 
         // rabitq
         fvec_masked_sum = fvec_masked_sum_avx512;
@@ -288,14 +530,32 @@ fvec_hook(std::string& simd_type) {
         } else {
             rabitq_dp_popcnt = rabitq_dp_popcnt_avx512;
         }
+
+        // binary
+        if (InstructionSet::GetInstance().AVX512VPOPCNTDQ()) {
+            u8_hamming_distance_ny = u8_hamming_distance_ny_avx512icx;
+            u8_jaccard_distance_ny = u8_jaccard_distance_ny_avx512icx;
+        } else {
+            u8_hamming_distance_ny = u8_hamming_distance_ny_avx;
+            u8_jaccard_distance_ny = u8_jaccard_distance_ny_avx;
+        }
+
         // minhash
         u64_binary_search_eq = u64_binary_search_eq_avx512;
         u64_binary_search_ge = u64_binary_search_ge_avx512;
         calculate_hash = calculate_hash_avx512;
+        u64_minhash_update = u64_minhash_update_avx512;
         u32_jaccard_distance = u32_jaccard_distance_ref;
         u32_jaccard_distance_batch_4 = u32_jaccard_distance_batch_4_ref;
         u64_jaccard_distance = u64_jaccard_distance_ref;
         u64_jaccard_distance_batch_4 = u64_jaccard_distance_batch_4_ref;
+
+        // sparse
+        u32_bitpacked_delta_decode = u32_bitpacked_delta_decode_avx512;
+        u32_sparse_intersect = u32_sparse_intersect_avx512;
+
+        // pq
+        u8_pq4_fast_scan = u8_pq4_fast_scan_avx;
         //
         simd_type = "AVX512";
         support_pq_fast_scan = true;
@@ -334,6 +594,8 @@ fvec_hook(std::string& simd_type) {
 
         bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_avx;
         bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_avx;
+        bf16_vec_inner_products_nx_ny = bf16_vec_inner_products_nx_ny_ref;
+        support_bf16_amx = false;
 
         // int8
         int8_vec_inner_product = int8_vec_inner_product_avx;
@@ -342,11 +604,35 @@ fvec_hook(std::string& simd_type) {
 
         int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_avx;
         int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_avx;
+        int8_vec_inner_products_nx_ny = int8_vec_inner_products_nx_ny_ref;
+        support_int8_amx = false;
+
+        // batch_8
+        fvec_inner_product_batch_8 = fvec_inner_product_batch_8_avx;
+        fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_avx;
+        typed_batch_8_by_4();
+
+        // threshold filter
+        fvec_threshold_filter = fvec_threshold_filter_avx;
 
         // rabitq
         fvec_masked_sum = fvec_masked_sum_avx;
         rabitq_dp_popcnt = rabitq_dp_popcnt_avx;
 
+        // binary
+        u8_hamming_distance_ny = u8_hamming_distance_ny_avx;
+        u8_jaccard_distance_ny = u8_jaccard_distance_ny_avx;
+
+        // minhash
+        u64_minhash_update = u64_minhash_update_avx;
+
+        // sparse
+        u32_bitpacked_delta_decode = u32_bitpacked_delta_decode_avx;
+        u32_sparse_intersect = u32_sparse_intersect_avx;
+
+        // pq
+        u8_pq4_fast_scan = u8_pq4_fast_scan_avx;
+
         //
         simd_type = "AVX2";
         support_pq_fast_scan = true;
@@ -384,6 +670,8 @@ fvec_hook(std::string& simd_type) {
 
         bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_ref;
         bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_ref;
+        bf16_vec_inner_products_nx_ny = bf16_vec_inner_products_nx_ny_ref;
+        support_bf16_amx = false;
 
         // int8
         int8_vec_inner_product = int8_vec_inner_product_sse;
@@ -392,11 +680,28 @@ fvec_hook(std::string& simd_type) {
 
         int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_ref;
         int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_ref;
+        int8_vec_inner_products_nx_ny = int8_vec_inner_products_nx_ny_ref;
+        support_int8_amx = false;
+
+        // batch_8
+        fvec_batch_8_by_4();
+        typed_batch_8_by_4();
 
         // rabitq
         fvec_masked_sum = fvec_masked_sum_sse;
         rabitq_dp_popcnt = rabitq_dp_popcnt_sse;
 
+        // binary
+        u8_hamming_distance_ny = u8_hamming_distance_ny_ref;
+        u8_jaccard_distance_ny = u8_jaccard_distance_ny_ref;
+
+        // sparse
+        u32_bitpacked_delta_decode = u32_bitpacked_delta_decode_ref;
+        u32_sparse_intersect = u32_sparse_intersect_ref;
+
+        // pq
+        u8_pq4_fast_scan = u8_pq4_fast_scan_ref;
+
         //
         simd_type = "SSE4_2";
         support_pq_fast_scan = false;
@@ -434,6 +739,8 @@ fvec_hook(std::string& simd_type) {
 
         bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_ref;
         bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_ref;
+        bf16_vec_inner_products_nx_ny = bf16_vec_inner_products_nx_ny_ref;
+        support_bf16_amx = false;
 
         // int8
         int8_vec_inner_product = int8_vec_inner_product_ref;
@@ -442,11 +749,28 @@ fvec_hook(std::string& simd_type) {
 
         int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_ref;
         int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_ref;
+        int8_vec_inner_products_nx_ny = int8_vec_inner_products_nx_ny_ref;
+        support_int8_amx = false;
+
+        // batch_8
+        fvec_batch_8_by_4();
+        typed_batch_8_by_4();
 
         // rabitq
         fvec_masked_sum = fvec_masked_sum_ref;
         rabitq_dp_popcnt = rabitq_dp_popcnt_ref;
 
+        // binary
+        u8_hamming_distance_ny = u8_hamming_distance_ny_ref;
+        u8_jaccard_distance_ny = u8_jaccard_distance_ny_ref;
+
+        // sparse
+        u32_bitpacked_delta_decode = u32_bitpacked_delta_decode_ref;
+        u32_sparse_intersect = u32_sparse_intersect_ref;
+
+        // pq
+        u8_pq4_fast_scan = u8_pq4_fast_scan_ref;
+
         //
         simd_type = "GENERIC";
         support_pq_fast_scan = false;
@@ -456,7 +780,6 @@ fvec_hook(std::string& simd_type) {
 #if defined(__aarch64__)
     if (supports_sve()) {
 #if defined(__ARM_FEATURE_SVE)
-        // ToDo: Enable remaining functions on SVE
         fvec_L2sqr = fvec_L2sqr_sve;
         fvec_L1 = fvec_L1_sve;
         fvec_Linf = fvec_Linf_sve;
@@ -467,6 +790,9 @@ fvec_hook(std::string& simd_type) {
         fvec_inner_product = fvec_inner_product_sve;
         fvec_L2sqr_ny = fvec_L2sqr_ny_sve;
         fvec_inner_products_ny = fvec_inner_products_ny_sve;
+        fvec_L2sqr_ny_nearest = fvec_L2sqr_ny_nearest_sve;
+        fvec_L2sqr_ny_transposed = fvec_L2sqr_ny_transposed_sve;
+        fvec_L2sqr_ny_nearest_y_transposed = fvec_L2sqr_ny_nearest_y_transposed_sve;
 
         ivec_inner_product = ivec_inner_product_neon;
         ivec_L2sqr = ivec_L2sqr_neon;
@@ -475,6 +801,8 @@ fvec_hook(std::string& simd_type) {
         fp16_vec_inner_product = fp16_vec_inner_product_sve;
         fp16_vec_L2sqr = fp16_vec_L2sqr_sve;
         fp16_vec_norm_L2sqr = fp16_vec_norm_L2sqr_sve;
+        fp16_vec_inner_product_batch_4 = fp16_vec_inner_product_batch_4_sve;
+        fp16_vec_L2sqr_batch_4 = fp16_vec_L2sqr_batch_4_sve;
 
         // bf16
         bf16_vec_inner_product = bf16_vec_inner_product_sve;
@@ -485,6 +813,8 @@ fvec_hook(std::string& simd_type) {
 
         bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_sve;
         bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_sve;
+        bf16_vec_inner_products_nx_ny = bf16_vec_inner_products_nx_ny_ref;
+        support_bf16_amx = false;
 
         // int8
         int8_vec_L2sqr = int8_vec_L2sqr_sve;
@@ -493,6 +823,26 @@ fvec_hook(std::string& simd_type) {
         int8_vec_inner_product = int8_vec_inner_product_sve;
         int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_sve;
 
+        // batch_8, bf16 and int8 run their batch_4 twice
+        typed_batch_8_by_4();
+        fvec_inner_product_batch_8 = fvec_inner_product_batch_8_sve;
+        fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_sve;
+        fp16_vec_inner_product_batch_8 = fp16_vec_inner_product_batch_8_sve;
+        fp16_vec_L2sqr_batch_8 = fp16_vec_L2sqr_batch_8_sve;
+
+        // rabitq
+        rabitq_dp_popcnt = rabitq_dp_popcnt_sve;
+
+        // binary
+        u8_hamming_distance_ny = u8_hamming_distance_ny_neon;
+        u8_jaccard_distance_ny = u8_jaccard_distance_ny_neon;
+
+        // minhash
+        u32_jaccard_distance = u32_jaccard_distance_sve;
+        u32_jaccard_distance_batch_4 = u32_jaccard_distance_batch_4_sve;
+        u64_jaccard_distance = u64_jaccard_distance_sve;
+        u64_jaccard_distance_batch_4 = u64_jaccard_distance_batch_4_sve;
+
         simd_type = "SVE";
         support_pq_fast_scan = true;
 #endif
@@ -533,6 +883,16 @@ fvec_hook(std::string& simd_type) {
 
         bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_neon;
         bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_neon;
+        bf16_vec_inner_products_nx_ny = bf16_vec_inner_products_nx_ny_ref;
+        support_bf16_amx = false;
+
+        // batch_8
+        fvec_batch_8_by_4();
+        typed_batch_8_by_4();
+
+        // binary
+        u8_hamming_distance_ny = u8_hamming_distance_ny_neon;
+        u8_jaccard_distance_ny = u8_jaccard_distance_ny_neon;
 
         //
         simd_type = "NEON";
@@ -541,19 +901,72 @@ fvec_hook(std::string& simd_type) {
     }
 #endif
 
-#if defined(__riscv_vector)
-    fvec_inner_product = fvec_inner_product_rvv;
-    fvec_L1 = fvec_L1_rvv;
-    fvec_Linf = fvec_Linf_rvv;
+#if defined(__riscv)
+    if (supports_rvv()) {
+        fvec_inner_product = fvec_inner_product_rvv;
+        fvec_L2sqr = fvec_L2sqr_rvv;
+        fvec_L1 = fvec_L1_rvv;
+        fvec_Linf = fvec_Linf_rvv;
+        fvec_norm_L2sqr = fvec_norm_L2sqr_rvv;
+        fvec_L2sqr_ny = fvec_L2sqr_ny_rvv;
+        fvec_inner_products_ny = fvec_inner_products_ny_rvv;
+        fvec_L2sqr_ny_nearest = fvec_L2sqr_ny_nearest_rvv;
+        fvec_L2sqr_ny_transposed = fvec_L2sqr_ny_transposed_rvv;
+        fvec_L2sqr_ny_nearest_y_transposed = fvec_L2sqr_ny_nearest_y_transposed_rvv;
+        fvec_madd = fvec_madd_rvv;
+        fvec_madd_and_argmin = fvec_madd_and_argmin_rvv;
+
+        fvec_inner_product_batch_4 = fvec_inner_product_batch_4_rvv;
+        fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_rvv;
+
+        ivec_inner_product = ivec_inner_product_rvv;
+        ivec_L2sqr = ivec_L2sqr_rvv;
 
-    fvec_L2sqr = fvec_L2sqr_rvv;
-    fvec_inner_products_ny = fvec_inner_products_ny_rvv;
+        // fp16
+        fp16_vec_inner_product = fp16_vec_inner_product_rvv;
+        fp16_vec_L2sqr = fp16_vec_L2sqr_rvv;
+        fp16_vec_norm_L2sqr = fp16_vec_norm_L2sqr_rvv;
+        fp16_vec_inner_product_batch_4 = fp16_vec_inner_product_batch_4_rvv;
+        fp16_vec_L2sqr_batch_4 = fp16_vec_L2sqr_batch_4_rvv;
 
-    fvec_norm_L2sqr = fvec_norm_L2sqr_rvv;
-    fvec_L2sqr_ny = fvec_L2sqr_ny_rvv;
-    fvec_madd = fvec_madd_rvv;
+        // bf16
+        bf16_vec_inner_product = bf16_vec_inner_product_rvv;
+        bf16_vec_L2sqr = bf16_vec_L2sqr_rvv;
+        bf16_vec_norm_L2sqr = bf16_vec_norm_L2sqr_rvv;
+        bf16_vec_inner_product_batch_4 = bf16_vec_inner_product_batch_4_rvv;
+        bf16_vec_L2sqr_batch_4 = bf16_vec_L2sqr_batch_4_rvv;
+
+        // int8
+        int8_vec_inner_product = int8_vec_inner_product_rvv;
+        int8_vec_L2sqr = int8_vec_L2sqr_rvv;
+        int8_vec_norm_L2sqr = int8_vec_norm_L2sqr_rvv;
+        int8_vec_inner_product_batch_4 = int8_vec_inner_product_batch_4_rvv;
+        int8_vec_L2sqr_batch_4 = int8_vec_L2sqr_batch_4_rvv;
+
+        // batch_8
+        fvec_inner_product_batch_8 = fvec_inner_product_batch_8_rvv;
+        fvec_L2sqr_batch_8 = fvec_L2sqr_batch_8_rvv;
+        fp16_vec_inner_product_batch_8 = fp16_vec_inner_product_batch_8_rvv;
+        fp16_vec_L2sqr_batch_8 = fp16_vec_L2sqr_batch_8_rvv;
+        bf16_vec_inner_product_batch_8 = bf16_vec_inner_product_batch_8_rvv;
+        bf16_vec_L2sqr_batch_8 = bf16_vec_L2sqr_batch_8_rvv;
+        int8_vec_inner_product_batch_8 = int8_vec_inner_product_batch_8_rvv;
+        int8_vec_L2sqr_batch_8 = int8_vec_L2sqr_batch_8_rvv;
+
+        // binary
+        u8_hamming_distance_ny = u8_hamming_distance_ny_rvv;
+        u8_jaccard_distance_ny = u8_jaccard_distance_ny_rvv;
 
-    simd_type = "RVV";
+        // minhash
+        u32_jaccard_distance = u32_jaccard_distance_rvv;
+        u32_jaccard_distance_batch_4 = u32_jaccard_distance_batch_4_rvv;
+        u64_jaccard_distance = u64_jaccard_distance_rvv;
+        u64_jaccard_distance_batch_4 = u64_jaccard_distance_batch_4_rvv;
+
+        simd_type = "RVV";
+    } else {
+        simd_type = "GENERIC";
+    }
     support_pq_fast_scan = false;
 #endif
 
@@ -569,6 +982,8 @@ fvec_hook(std::string& simd_type) {
     fvec_inner_products_ny = fvec_inner_products_ny_ppc;
     fvec_inner_product_batch_4 = fvec_inner_product_batch_4_ppc;
     fvec_L2sqr_batch_4 = fvec_L2sqr_batch_4_ppc;
+    fvec_batch_8_by_4();
+    typed_batch_8_by_4();
 
     fvec_norm_L2sqr = fvec_norm_L2sqr_ppc;
     fvec_L2sqr_ny = fvec_L2sqr_ny_ppc;
@@ -584,6 +999,9 @@ fvec_hook(std::string& simd_type) {
     simd_type = "PPC";
     support_pq_fast_scan = false;
 #endif
+
+    // follows the batch_8 hooks set above
+    ny_topk_by_batch_8();
 }
 
 static int init_hook_ = []() {
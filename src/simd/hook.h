@@ -108,6 +108,12 @@ extern void (*bf16_vec_inner_product_batch_4)(const knowhere::bf16*, const knowh
 extern void (*bf16_vec_L2sqr_batch_4)(const knowhere::bf16*, const knowhere::bf16*, const knowhere::bf16*,
                                       const knowhere::bf16*, const knowhere::bf16*, const size_t, float&, float&,
                                       float&, float&);
+
+/// writes the inner products between nx vectors x and ny vectors y of d dims to ip, row major by x. Pays off over
+/// the kernels above when support_bf16_amx is set.
+extern void (*bf16_vec_inner_products_nx_ny)(float*, const knowhere::bf16*, const knowhere::bf16*, size_t, size_t,
+                                             size_t);
+extern bool support_bf16_amx;
 // int8
 extern float (*int8_vec_inner_product)(const int8_t*, const int8_t*, size_t);
 extern float (*int8_vec_L2sqr)(const int8_t*, const int8_t*, size_t);
@@ -118,10 +124,50 @@ extern void (*int8_vec_inner_product_batch_4)(const int8_t*, const int8_t*, cons
 extern void (*int8_vec_L2sqr_batch_4)(const int8_t*, const int8_t*, const int8_t*, const int8_t*, const int8_t*,
                                       const size_t, float&, float&, float&, float&);
 
+/// writes the inner products between nx vectors x and ny vectors y of d dims to ip, row major by x. Pays off over
+/// the kernels above when support_int8_amx is set.
+extern void (*int8_vec_inner_products_nx_ny)(float*, const int8_t*, const int8_t*, size_t, size_t, size_t);
+extern bool support_int8_amx;
+
+// batch_8
+/// writes the distances between x and the 8 vectors y to dis, scoring more vectors per load of x than batch_4. The
+/// SIMD levels without kernels of their own call the batch_4 hooks twice.
+extern void (*fvec_inner_product_batch_8)(const float*, const float* const*, const size_t, float*);
+extern void (*fvec_L2sqr_batch_8)(const float*, const float* const*, const size_t, float*);
+extern void (*fp16_vec_inner_product_batch_8)(const knowhere::fp16*, const knowhere::fp16* const*, const size_t,
+                                              float*);
+extern void (*fp16_vec_L2sqr_batch_8)(const knowhere::fp16*, const knowhere::fp16* const*, const size_t, float*);
+extern void (*bf16_vec_inner_product_batch_8)(const knowhere::bf16*, const knowhere::bf16* const*, const size_t,
+                                              float*);
+extern void (*bf16_vec_L2sqr_batch_8)(const knowhere::bf16*, const knowhere::bf16* const*, const size_t, float*);
+extern void (*int8_vec_inner_product_batch_8)(const int8_t*, const int8_t* const*, const size_t, float*);
+extern void (*int8_vec_L2sqr_batch_8)(const int8_t*, const int8_t* const*, const size_t, float*);
+
+// ny_topk
+/// writes the k smallest squared L2 distances between x and ny contiguous vectors y of d dims to dis, in increasing
+/// order, and the indexes of their vectors to ids. The ny distances are not written out. Meant for the k of centroid
+/// and small list scans, up to 64. When ny < k, the rest of dis and ids is the max float and -1.
+extern void (*fvec_L2sqr_ny_topk)(const float*, const float*, size_t, size_t, size_t, float*, int64_t*);
+extern void (*fp16_vec_L2sqr_ny_topk)(const knowhere::fp16*, const knowhere::fp16*, size_t, size_t, size_t, float*,
+                                      int64_t*);
+extern void (*bf16_vec_L2sqr_ny_topk)(const knowhere::bf16*, const knowhere::bf16*, size_t, size_t, size_t, float*,
+                                      int64_t*);
+
+// threshold filter
+/// writes the positions of the distances of dis[0..n) that are greater than threshold, or less than it when greater
+/// is false, to out in increasing order and returns their number. out must hold n positions.
+extern size_t (*fvec_threshold_filter)(const float*, const size_t, const float, const bool, uint32_t*);
+
 // rabitq
 extern float (*fvec_masked_sum)(const float*, const uint8_t*, const size_t);
 extern int (*rabitq_dp_popcnt)(const uint8_t*, const uint8_t*, const size_t, const size_t);
 
+// binary
+/// writes the hamming distances between the code x and ny contiguous codes y of code_size bytes each to dis
+extern void (*u8_hamming_distance_ny)(const uint8_t*, const uint8_t*, const size_t, const size_t, int32_t*);
+/// writes the jaccard distances between the code x and ny contiguous codes y of code_size bytes each to dis
+extern void (*u8_jaccard_distance_ny)(const uint8_t*, const uint8_t*, const size_t, const size_t, float*);
+
 // minhash
 extern int (*u64_binary_search_eq)(const uint64_t*, const size_t, const uint64_t);
 extern int (*u64_binary_search_ge)(const uint64_t*, const size_t, const uint64_t);
@@ -132,6 +178,51 @@ extern float (*u64_jaccard_distance)(const char*, const char*, size_t size, size
 extern void (*u64_jaccard_distance_batch_4)(const char*, const char*, const char*, const char*, const char*, size_t,
                                             size_t, float&, float&, float&, float&);
 extern uint64_t (*calculate_hash)(const char*, size_t);
+/// lowers sig[j] to the least a[j] * x + b[j] (mod 2^64) over the n token hashes x, for the num_perm hash
+/// functions j, which min-hashes a set of tokens with num_perm universal hash functions at once.
+extern void (*u64_minhash_update)(const uint64_t*, const size_t, const uint64_t*, const uint64_t*, const size_t,
+                                  uint64_t*);
+
+// sparse
+/// decodes n deltas of `bits` bits packed from data and writes their prefix sums plus base to out.
+/// 8 bytes past the last packed delta must be readable.
+extern void (*u32_bitpacked_delta_decode)(const uint8_t*, const size_t, const size_t, const uint32_t, uint32_t*);
+/// writes the positions of the ids that a and b have in common to a_pos and b_pos and returns their number. a and b
+/// hold na and nb elements of 8 bytes that start with a u32 id, e.g. SparseRow elements, sorted by unique ids.
+/// a_pos and b_pos must hold min(na, nb) positions.
+extern size_t (*u32_sparse_intersect)(const uint32_t*, const size_t, const uint32_t*, const size_t, uint32_t*,
+                                      uint32_t*);
+
+// pq
+/// sums the 4-bit pq codes of nb blocks of 32 codes of nbytes bytes each, every byte packs 2 codes. The low nibble
+/// of byte j of a code is looked up in lut + 32 * j and its high nibble in lut + 32 * j + 16. Writes the 32 * nb
+/// sums to out. 16 bytes past the last code must be readable.
+extern void (*u8_pq4_fast_scan)(const uint8_t*, const size_t, const size_t, const uint8_t*, uint16_t*);
+// fixed dims
+/// the dims with kernels unrolled at compile time, common embedding sizes
+#define FVEC_UNROLLED_DIMS(X) X(128) X(256) X(384) X(512) X(768) X(1024) X(1536)
+
+/// the fp32 kernels of vectors of a given number of dims
+struct FvecDimKernels {
+    decltype(fvec_L2sqr) L2sqr;
+    decltype(fvec_inner_product) inner_product;
+    decltype(fvec_L2sqr_batch_4) L2sqr_batch_4;
+    decltype(fvec_inner_product_batch_4) inner_product_batch_4;
+};
+
+/// the SIMD levels with code compiled once per level
+enum class FvecSimdLevel { NONE, AVX2, AVX512 };
+
+/// the level of the fp32 kernels the hooks point to, for the code compiled once per level with its kernels inlined.
+/// NONE when they are not the plain kernels of such a level, e.g. after enable_patch_for_fp32_bf16().
+FvecSimdLevel
+fvec_simd_level();
+
+/// the kernels of d dims unrolled at compile time when d is one of FVEC_UNROLLED_DIMS and the hooks are the plain
+/// AVX512 or AVX2 ones, the hooks otherwise. Meant to be read once per distance computer, after which it keeps
+/// them, while the hooks can still be switched, e.g. by enable_patch_for_fp32_bf16().
+FvecDimKernels
+fvec_dim_kernels(size_t d);
 ///////////////////////////////////////////////////////////////////////////////
 #if defined(__x86_64__)
 bool
@@ -142,6 +233,10 @@ bool
 cpu_support_sse4_2();
 bool
 cpu_support_f16c();
+bool
+cpu_support_amx_int8();
+bool
+cpu_support_amx_bf16();
 #endif
 
 #if defined(__aarch64__)
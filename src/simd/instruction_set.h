@@ -12,8 +12,6 @@
 #ifndef INSTRUCTION_SET_H
 #define INSTRUCTION_SET_H
 
-#include <cpuid.h>
-
 #include <array>
 #include <bitset>
 #include <cstring>
@@ -21,8 +19,17 @@
 #include <string>
 #include <vector>
 
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+#if defined(__riscv) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
 namespace faiss {
 
+#if defined(__x86_64__)
 class InstructionSet {
  public:
     static InstructionSet&
@@ -41,6 +48,8 @@ class InstructionSet {
           f_1_EDX_{0},
           f_7_EBX_{0},
           f_7_ECX_{0},
+          f_7_EDX_{0},
+          f_7_1_EAX_{0},
           f_81_ECX_{0},
           f_81_EDX_{0},
           data_{},
@@ -80,6 +89,13 @@ class InstructionSet {
         if (nIds_ >= 7) {
             f_7_EBX_ = data_[7][1];
             f_7_ECX_ = data_[7][2];
+            f_7_EDX_ = data_[7][3];
+            // the flags of sub-leaf 1, if there is one
+            if (data_[7][0] >= 1) {
+                std::array<int, 4> cpui_7_1;
+                __cpuid_count(7, 1, cpui_7_1[0], cpui_7_1[1], cpui_7_1[2], cpui_7_1[3]);
+                f_7_1_EAX_ = cpui_7_1[0];
+            }
         }
 
         // Calling __cpuid with 0x80000000 as the function_id argument
@@ -352,6 +368,32 @@ class InstructionSet {
         return f_7_ECX_[14];
     }
 
+    bool
+    AVX512VNNI() {
+        return f_7_ECX_[11];
+    }
+
+    // the tiles also need the permission of the os, see cpu_support_amx_int8()
+    bool
+    AMX_TILE() {
+        return f_7_EDX_[24];
+    }
+
+    bool
+    AMX_INT8() {
+        return f_7_EDX_[25];
+    }
+
+    bool
+    AMX_BF16() {
+        return f_7_EDX_[22];
+    }
+
+    bool
+    AVX512_BF16() {
+        return f_7_1_EAX_[5];
+    }
+
  private:
     int nIds_;
     int nExIds_;
@@ -363,11 +405,57 @@ class InstructionSet {
     std::bitset<32> f_1_EDX_;
     std::bitset<32> f_7_EBX_;
     std::bitset<32> f_7_ECX_;
+    std::bitset<32> f_7_EDX_;
+    std::bitset<32> f_7_1_EAX_;
     std::bitset<32> f_81_ECX_;
     std::bitset<32> f_81_EDX_;
     std::vector<std::array<int, 4>> data_;
     std::vector<std::array<int, 4>> extdata_;
 };
+#endif
+
+#if defined(__riscv)
+// RISC-V has no cpuid, the extensions come from the hwcap of the kernel
+class InstructionSet {
+ public:
+    static InstructionSet&
+    GetInstance() {
+        static InstructionSet inst;
+        return inst;
+    }
+
+ private:
+    InstructionSet() {
+#if defined(__linux__)
+        // the single letter extensions are bits of AT_HWCAP, by their offset from 'A'
+        rvv_ = (getauxval(AT_HWCAP) & (1UL << ('V' - 'A'))) != 0;
+#endif
+        if (rvv_) {
+            // the vlenb csr, by number for the assemblers that do not know the vector extension
+            unsigned long vlenb = 0;
+            asm volatile("csrr %0, 0xc22" : "=r"(vlenb));
+            vlen_ = vlenb * 8;
+        }
+    }
+
+ public:
+    // the vector extension 1.0
+    bool
+    RVV() {
+        return rvv_;
+    }
+
+    // the width of the vector registers in bits, 0 without the vector extension
+    size_t
+    VLEN() {
+        return vlen_;
+    }
+
+ private:
+    bool rvv_ = false;
+    size_t vlen_ = 0;
+};
+#endif
 
 }  // namespace faiss
 
@@ -187,3 +187,33 @@ def test_bfloat16_index(gen_data_with_type, faiss_ans, recall, error, name, conf
     else:
         assert recall(f_ids, k_ids) >= 0.5
     assert error(f_dis, f_dis) <= 0.01
+
+
+def test_zero_copy_views(gen_data):
+    from concurrent.futures import ThreadPoolExecutor
+
+    version = knowhere.GetCurrentVersion()
+    idx = knowhere.CreateIndex("FLAT", version)
+    xb, xq = gen_data(2000, 16, 64)
+    config = {"dim": 64, "k": 10, "metric_type": "L2"}
+    idx.Build(knowhere.ArrayToDataSet(xb), json.dumps(config))
+
+    # the datasets keep the arrays they view alive
+    queries = knowhere.ArrayToDataSet(np.asfortranarray(xq))
+    del xb
+    ans, _ = idx.Search(queries, json.dumps(config), knowhere.GetNullBitSetView())
+    dis, ids = knowhere.DataSetToArray(ans)
+    view_dis, view_ids = knowhere.DataSetToArrayView(ans)
+    del ans
+    assert view_ids.dtype == np.int64 and not view_ids.flags.writeable
+    assert (view_ids == ids).all()
+    assert np.allclose(view_dis, dis)
+
+    # the searches of the threads run concurrently, without the GIL
+    def search(_):
+        res, _ = idx.Search(knowhere.ArrayToDataSet(xq), json.dumps(config), knowhere.GetNullBitSetView())
+        return knowhere.DataSetToArrayView(res)[1]
+
+    with ThreadPoolExecutor(4) as pool:
+        for res_ids in pool.map(search, range(8)):
+            assert (res_ids == ids).all()
@@ -187,6 +187,114 @@ TEST_CASE("Test Brute Force", "[float vector]") {
     }
 }
 
+template <typename T>
+void
+check_search_in_tiles(const knowhere::DataSetPtr train_ds, const knowhere::DataSetPtr query_ds, const int64_t k,
+                      const knowhere::Json& conf, const knowhere::BitsetView& bitset) {
+    auto base = knowhere::ConvertToDataTypeIfNeeded<T>(train_ds);
+    auto query = knowhere::ConvertToDataTypeIfNeeded<T>(query_ds);
+    auto nq = query->GetRows();
+    auto dim = query->GetDim();
+
+    auto res = knowhere::BruteForce::Search<T>(base, query, conf, bitset);
+    REQUIRE(res.has_value());
+    for (int64_t i = 0; i < nq; i++) {
+        // a single query is not tiled
+        auto single_query = knowhere::GenDataSet(1, dim, static_cast<const T*>(query->GetTensor()) + i * dim);
+        auto single_res = knowhere::BruteForce::Search<T>(base, single_query, conf, bitset);
+        REQUIRE(single_res.has_value());
+        for (int64_t j = 0; j < k; j++) {
+            REQUIRE(res.value()->GetIds()[i * k + j] == single_res.value()->GetIds()[j]);
+            REQUIRE(res.value()->GetDistance()[i * k + j] == single_res.value()->GetDistance()[j]);
+        }
+    }
+}
+
+TEST_CASE("Test Brute Force with queries searched in tiles", "[float vector]") {
+    // enough rows for several blocks of the base, and enough queries for several per search task
+    const int64_t nb = 5000;
+    const int64_t nq = 256;
+    const int64_t dim = 128;
+    const int64_t k = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    const knowhere::Json conf = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, k},
+    };
+    std::vector<uint8_t> bitset_data((nb + 7) / 8);
+    for (int64_t i = 0; i < nb; i += 3) {
+        bitset_data[i >> 3] |= 1 << (i & 7);
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+    for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+        check_search_in_tiles<knowhere::fp32>(train_ds, query_ds, k, conf, filter);
+        check_search_in_tiles<knowhere::fp16>(train_ds, query_ds, k, conf, filter);
+        check_search_in_tiles<knowhere::bf16>(train_ds, query_ds, k, conf, filter);
+    }
+}
+
+template <typename T>
+void
+check_search_with_sparse_bitset(const knowhere::DataSetPtr train_ds, const knowhere::DataSetPtr valid_ds,
+                                const std::vector<int64_t>& valid_ids, const knowhere::DataSetPtr query_ds,
+                                const int64_t k, const knowhere::Json& conf, const knowhere::BitsetView& bitset) {
+    using Catch::Approx;
+
+    auto res = knowhere::BruteForce::Search<T>(knowhere::ConvertToDataTypeIfNeeded<T>(train_ds),
+                                               knowhere::ConvertToDataTypeIfNeeded<T>(query_ds), conf, bitset);
+    REQUIRE(res.has_value());
+    // the rows left by the bitset, searched without it
+    auto ref = knowhere::BruteForce::Search<T>(knowhere::ConvertToDataTypeIfNeeded<T>(valid_ds),
+                                               knowhere::ConvertToDataTypeIfNeeded<T>(query_ds), conf, nullptr);
+    REQUIRE(ref.has_value());
+    for (int64_t i = 0; i < query_ds->GetRows() * k; i++) {
+        REQUIRE(res.value()->GetIds()[i] == valid_ids[ref.value()->GetIds()[i]]);
+        REQUIRE(res.value()->GetDistance()[i] == Approx(ref.value()->GetDistance()[i]));
+    }
+}
+
+TEST_CASE("Test Brute Force with a sparse bitset", "[float vector]") {
+    const int64_t nb = 5000;
+    const int64_t nq = 16;
+    const int64_t dim = 128;
+    const int64_t k = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    const knowhere::Json conf = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, k},
+    };
+
+    // about 95% of the rows are filtered out, with a run of valid rows that starts and ends within words
+    std::vector<uint8_t> bitset_data((nb + 7) / 8, 0xff);
+    std::vector<int64_t> valid_ids;
+    std::vector<float> valid_data;
+    const auto train = static_cast<const float*>(train_ds->GetTensor());
+    for (int64_t i = 0; i < nb; i++) {
+        if (i % 29 == 3 || (i >= 1000 && i < 1100)) {
+            bitset_data[i >> 3] &= ~(1 << (i & 7));
+            valid_ids.push_back(i);
+            valid_data.insert(valid_data.end(), train + i * dim, train + (i + 1) * dim);
+        }
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb, nb - valid_ids.size());
+    const auto valid_ds = knowhere::GenDataSet(valid_ids.size(), dim, valid_data.data());
+
+    check_search_with_sparse_bitset<knowhere::fp32>(train_ds, valid_ds, valid_ids, query_ds, k, conf, bitset);
+    check_search_with_sparse_bitset<knowhere::fp16>(train_ds, valid_ds, valid_ids, query_ds, k, conf, bitset);
+    check_search_with_sparse_bitset<knowhere::bf16>(train_ds, valid_ds, valid_ids, query_ds, k, conf, bitset);
+}
+
 TEST_CASE("Test Brute Force", "[binary vector]") {
     using Catch::Approx;
 
@@ -274,3 +382,92 @@ TEST_CASE("Test Brute Force with input ids", "[float vector]") {
     check_search_with_out_ids<knowhere::bf16>(nb, nq, dim, k, metric, conf);
     check_search_with_out_ids<knowhere::int8>(nb, nq, dim, k, metric, conf);
 }
+
+TEST_CASE("Test Brute Force with cached norms", "[float vector]") {
+    using Catch::Approx;
+
+    const int64_t nb = 1000;
+    const int64_t nq = 10;
+    const int64_t dim = 128;
+    const int64_t k = 5;
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    const knowhere::Json conf = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, knowhere::metric::COSINE},
+        {knowhere::meta::TOPK, k},
+    };
+
+    REQUIRE(train_ds->GetTensorNorms() == nullptr);
+    auto res = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(res.has_value());
+    auto norms = train_ds->GetTensorNorms();
+    REQUIRE(norms != nullptr);
+    auto xb = static_cast<const float*>(train_ds->GetTensor());
+    for (int64_t i = 0; i < nb; i++) {
+        REQUIRE(norms[i] == Approx(std::sqrt(faiss::fvec_norm_L2sqr(xb + i * dim, dim))));
+    }
+
+    // the norms that are set are used as they are
+    std::shared_ptr<float[]> doubled_norms(new float[nb]);
+    for (int64_t i = 0; i < nb; i++) {
+        doubled_norms[i] = norms[i] * 2;
+    }
+    train_ds->SetTensorNorms(doubled_norms);
+    auto doubled_res = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(doubled_res.has_value());
+    for (int64_t i = 0; i < nq * k; i++) {
+        REQUIRE(doubled_res.value()->GetIds()[i] == res.value()->GetIds()[i]);
+        REQUIRE(doubled_res.value()->GetDistance()[i] == Approx(res.value()->GetDistance()[i] / 2));
+    }
+
+    // the norms belong to the rows they were set with
+    train_ds->SetRows(nb / 2);
+    REQUIRE(train_ds->GetTensorNorms() == nullptr);
+    train_ds->SetRows(nb);
+    REQUIRE(train_ds->GetTensorNorms() != nullptr);
+}
+
+TEST_CASE("Test Brute Force with unnormalized cosine queries", "[float vector]") {
+    using Catch::Approx;
+
+    const int64_t nb = 1000;
+    const int64_t nq = 10;
+    const int64_t dim = 128;
+    const int64_t k = 5;
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    auto normalized = knowhere::CopyAndNormalizeVecs(static_cast<const float*>(query_ds->GetTensor()), nq, dim);
+    const auto normalized_ds = knowhere::GenDataSet(nq, dim, normalized.get());
+    const knowhere::Json conf = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, knowhere::metric::COSINE},
+        {knowhere::meta::TOPK, k},
+        {knowhere::meta::RADIUS, 0.8},
+    };
+
+    // the kernels divide by the query norms, the results match the ones of the normalized queries
+    auto res = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    auto ref = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, normalized_ds, conf, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(ref.has_value());
+    for (int64_t i = 0; i < nq * k; i++) {
+        REQUIRE(res.value()->GetIds()[i] == ref.value()->GetIds()[i]);
+        REQUIRE(res.value()->GetDistance()[i] == Approx(ref.value()->GetDistance()[i]));
+    }
+
+    auto range_res = knowhere::BruteForce::RangeSearch<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    auto range_ref = knowhere::BruteForce::RangeSearch<knowhere::fp32>(train_ds, normalized_ds, conf, nullptr);
+    REQUIRE(range_res.has_value());
+    REQUIRE(range_ref.has_value());
+    auto lims = range_res.value()->GetLims();
+    auto ref_lims = range_ref.value()->GetLims();
+    for (int64_t i = 0; i <= nq; i++) {
+        REQUIRE(lims[i] == ref_lims[i]);
+    }
+    for (size_t i = 0; i < lims[nq]; i++) {
+        REQUIRE(range_res.value()->GetDistance()[i] == Approx(range_ref.value()->GetDistance()[i]));
+    }
+}
@@ -9,6 +9,9 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <unordered_set>
 
 #include "catch2/catch_approx.hpp"
@@ -46,6 +49,20 @@ TEST_CASE("Test Kmeans With Float Vector", "[float metrics]") {
         return json;
     };
 
+    auto minibatch_gen = [base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::KMEANS_BATCH_SIZE] = 256;
+        json[knowhere::indexparam::KMEANS_N_ITERS] = 5;
+        return json;
+    };
+
+    auto balanced_gen = [base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::KMEANS_N_ITERS] = 10;
+        json[knowhere::indexparam::BALANCED_KMEANS_RATIO] = 1.5;
+        return json;
+    };
+
     const auto train_ds = GenDataSet(nb, dim);
     const auto query_ds = GenDataSet(nq, dim);
 
@@ -58,7 +75,9 @@ TEST_CASE("Test Kmeans With Float Vector", "[float metrics]") {
     SECTION("Test Kmeans result") {
         using std::make_tuple;
         auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
-            {make_tuple(knowhere::ClusterEnum::CLUSTER_KMEANS, base_gen)}));
+            {make_tuple(knowhere::ClusterEnum::CLUSTER_KMEANS, base_gen),
+             make_tuple(knowhere::ClusterEnum::CLUSTER_MINIBATCH_KMEANS, minibatch_gen),
+             make_tuple(knowhere::ClusterEnum::CLUSTER_BALANCED_KMEANS, balanced_gen)}));
         auto cluster = knowhere::ClusterFactory::Instance().Create<knowhere::fp32>(name).value();
         auto cfg_json = gen().dump();
         CAPTURE(name, cfg_json);
@@ -88,4 +107,58 @@ TEST_CASE("Test Kmeans With Float Vector", "[float metrics]") {
         LOG_KNOWHERE_INFO_ << "recall: " << recall;
         REQUIRE(recall > kKnnRecallThreshold);
     }
+
+    SECTION("Test Kmeans HNSW assignment") {
+        auto name = GENERATE(as<std::string>{}, knowhere::ClusterEnum::CLUSTER_MINIBATCH_KMEANS,
+                             knowhere::ClusterEnum::CLUSTER_BALANCED_KMEANS);
+        auto cluster = knowhere::ClusterFactory::Instance().Create<knowhere::fp32>(name).value();
+        knowhere::Json json = base_gen();
+        json[NUM_CLUSTERS] = 64;
+        json[knowhere::indexparam::ASSIGN_INDEX] = "HNSW";
+        json[knowhere::indexparam::ASSIGN_EF] = 128;
+        // the balanced k-means may move rows away from their nearest centroid, it does not here
+        json[knowhere::indexparam::BALANCED_KMEANS_RATIO] = 1000.0;
+        CAPTURE(name);
+        REQUIRE(cluster.Train(*train_ds, json).has_value());
+        auto assign_res = cluster.Assign(*query_ds);
+        REQUIRE(assign_res.has_value());
+
+        auto centroids = cluster.GetCentroids();
+        REQUIRE(centroids.has_value());
+        auto nearest = knowhere::BruteForce::Search<knowhere::fp32>(centroids.value(), query_ds, conf, nullptr);
+        REQUIRE(nearest.has_value());
+        int64_t hits = 0;
+        for (int64_t i = 0; i < nq; ++i) {
+            hits += reinterpret_cast<const uint32_t*>(assign_res.value()->GetTensor())[i] ==
+                    nearest.value()->GetIds()[i];
+        }
+        REQUIRE(hits >= nq * 0.9);
+
+        json[knowhere::indexparam::ASSIGN_INDEX] = "ivf";
+        REQUIRE(cluster.Train(*train_ds, json).error() == knowhere::Status::invalid_args);
+    }
+
+    SECTION("Test Balanced Kmeans cluster sizes") {
+        auto cluster =
+            knowhere::ClusterFactory::Instance().Create<knowhere::fp32>(knowhere::ClusterEnum::CLUSTER_BALANCED_KMEANS)
+                .value();
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::BALANCED_KMEANS_RATIO] = 1.1;
+        auto res = cluster.Train(*train_ds, json);
+        REQUIRE(res.has_value());
+        // every cluster holds at most 1.1 times the mean number of rows, and the rows assigned later too
+        const int64_t capacity = std::ceil(1.1 * nb / num_clusters);
+        std::vector<int64_t> sizes(num_clusters, 0);
+        for (int64_t i = 0; i < nb; ++i) {
+            sizes[reinterpret_cast<const uint32_t*>(res.value()->GetTensor())[i]]++;
+        }
+        REQUIRE(*std::max_element(sizes.begin(), sizes.end()) <= capacity);
+
+        auto assign_res = cluster.Assign(*train_ds);
+        REQUIRE(assign_res.has_value());
+        REQUIRE(std::memcmp(assign_res.value()->GetTensor(), res.value()->GetTensor(), nb * sizeof(uint32_t)) == 0);
+        auto centroids = cluster.GetCentroids();
+        REQUIRE(centroids.has_value());
+        REQUIRE(centroids.value()->GetRows() == num_clusters);
+    }
 }
@@ -9,6 +9,9 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <atomic>
+#include <cstring>
+
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
@@ -180,6 +183,75 @@ TEST_CASE("Test SCANN with data view refiner", "[float metrics]") {
             }
         }
     }
+
+    SECTION("Accuracy with a batched view") {
+        // the refine resolves its candidates with the batched op
+        std::atomic<size_t> batch_calls = 0;
+        knowhere::ViewDataBatchOp batch_view = [&](const int64_t* ids, size_t n, const void** out) {
+            batch_calls++;
+            for (size_t i = 0; i < n; i++) {
+                out[i] = data_view(ids[i]);
+            }
+        };
+        auto data_view_ops_pack = knowhere::Pack(knowhere::ViewDataOps{data_view, batch_view});
+        knowhere::Json json = scann_gen();
+
+        auto scann_with_dv_refiner =
+            knowhere::IndexFactory::Instance()
+                .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_SCANN_DVR, version, data_view_ops_pack)
+                .value();
+        REQUIRE(scann_with_dv_refiner.Build(train_ds, json, false) == knowhere::Status::success);
+        auto results = scann_with_dv_refiner.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+        REQUIRE(batch_calls > 0);
+    }
+
+    SECTION("Get vectors by ids from the view") {
+        knowhere::Json json = scann_gen();
+        auto scann_with_dv_refiner =
+            knowhere::IndexFactory::Instance()
+                .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_SCANN_DVR, version, data_view_pack)
+                .value();
+        REQUIRE(scann_with_dv_refiner.Build(train_ds, json, false) == knowhere::Status::success);
+
+        // in the reverse order of the view, so that the rows are put back in request order
+        auto ids = new int64_t[nb];
+        for (int64_t i = 0; i < nb; i++) {
+            ids[i] = nb - 1 - i;
+        }
+        auto ids_ds = knowhere::GenIdsDataSet(nb, ids);
+        ids_ds->SetIsOwner(true);
+        auto results = scann_with_dv_refiner.GetVectorByIds(ids_ds);
+        REQUIRE(results.has_value());
+        auto xb = (const float*)train_ds->GetTensor();
+        auto data = (const float*)results.value()->GetTensor();
+        for (int64_t i = 0; i < nb; i++) {
+            REQUIRE(std::memcmp(data + i * dim, xb + ids[i] * dim, dim * sizeof(float)) == 0);
+        }
+    }
+
+    SECTION("Accuracy with a pre refine") {
+        for (const bool refine_with_quant : {true, false}) {
+            knowhere::Json json = scann_gen();
+            json[knowhere::indexparam::REFINE_TYPE] = knowhere::RefineType::FLOAT16_QUANT;
+            json[knowhere::indexparam::REFINE_WITH_QUANT] = refine_with_quant;
+            json[knowhere::indexparam::PRE_REFINE_TYPE] = knowhere::RefineType::UINT4_QUANT;
+            json[knowhere::indexparam::PRE_REFINE_RATIO] = 2.0;
+
+            auto scann_with_dv_refiner =
+                knowhere::IndexFactory::Instance()
+                    .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_SCANN_DVR, version, data_view_pack)
+                    .value();
+            REQUIRE(scann_with_dv_refiner.Build(train_ds, json, false) == knowhere::Status::success);
+            auto results = scann_with_dv_refiner.Search(query_ds, json, nullptr);
+            REQUIRE(results.has_value());
+            REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+            if (metric == knowhere::metric::COSINE) {
+                REQUIRE(CheckDistanceInScope(*results.value(), topk, -1.00001, 1.00001));
+            }
+        }
+    }
 }
 
 TEST_CASE("Ensure topk test", "[float metrics]") {
@@ -9,6 +9,7 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <atomic>
 #include <string>
 
 #include "catch2/catch_approx.hpp"
@@ -34,8 +35,47 @@ error "Missing the <filesystem> header."
 #include <fstream>
 
 namespace {
+// serves the disk index in ranges, as an object storage would
+class RangeReadFileManager : public knowhere::LocalFileManager {
+ public:
+    class Reader : public knowhere::FileRangeReader {
+     public:
+        Reader(const std::string& filename, std::atomic<size_t>& num_reads)
+            : filename_(filename), num_reads_(num_reads) {
+        }
+
+        std::optional<uint64_t>
+        Size() noexcept override {
+            std::error_code ec;
+            auto size = fs::file_size(filename_, ec);
+            return ec ? std::nullopt : std::make_optional<uint64_t>(size);
+        }
+
+        bool
+        Read(uint64_t offset, uint64_t len, void* buf) noexcept override {
+            num_reads_++;
+            std::ifstream file(filename_, std::ios::binary);
+            file.seekg(offset);
+            file.read(static_cast<char*>(buf), len);
+            return file.good();
+        }
+
+     private:
+        std::string filename_;
+        std::atomic<size_t>& num_reads_;
+    };
+
+    std::shared_ptr<knowhere::FileRangeReader>
+    OpenRangeReader(const std::string& filename) noexcept override {
+        return std::make_shared<Reader>(filename, num_reads);
+    }
+
+    std::atomic<size_t> num_reads = 0;
+};
+
 std::string kDir = fs::current_path().string() + "/diskann_test";
 std::string kRawDataPath = kDir + "/raw_data";
+std::string kLabelPath = kDir + "/labels";
 std::string kL2IndexDir = kDir + "/l2_index";
 std::string kIPIndexDir = kDir + "/ip_index";
 std::string kCOSINEIndexDir = kDir + "/cosine_index";
@@ -320,6 +360,32 @@ base_search() {
                 REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
             }
 
+            // knn search with adaptive cache
+            {
+                knowhere::Json adaptive_json = deserialize_json;
+                adaptive_json["use_adaptive_cache"] = true;
+                auto diskann_tmp =
+                    knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+                diskann_tmp.Deserialize(binset, adaptive_json);
+                for (int i = 0; i < 3; i++) {
+                    auto res = diskann_tmp.Search(query_ds, knn_json, nullptr);
+                    REQUIRE(res.has_value());
+                    REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+                }
+            }
+
+            // knn search with interleaved queries
+            {
+                knowhere::Json interleave_json = deserialize_json;
+                interleave_json["interleave_queries"] = 4;
+                auto diskann_tmp =
+                    knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+                diskann_tmp.Deserialize(binset, interleave_json);
+                auto res = diskann_tmp.Search(query_ds, knn_json, nullptr);
+                REQUIRE(res.has_value());
+                REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+            }
+
             // knn search with bitset
             std::vector<std::function<std::vector<uint8_t>(size_t, size_t)>> gen_bitset_funcs = {
                 GenerateBitsetWithFirstTbitsSet, GenerateBitsetWithRandomTbitsSet};
@@ -351,6 +417,163 @@ base_search() {
             auto ap = GetRangeSearchRecall(*range_search_gt_ptr, *range_search_res.value());
             float standard_ap = metric_range_ap_map[metric_str];
             REQUIRE(ap > standard_ap);
+
+            // the results of a query come closest first, so range_search_k keeps the closest ones
+            range_json["range_search_k"] = 5;
+            auto range_search_k_res = diskann.RangeSearch(query_ds, range_json, nullptr);
+            REQUIRE(range_search_k_res.has_value());
+            auto lims = range_search_k_res.value()->GetLims();
+            auto dists = range_search_k_res.value()->GetDistance();
+            const bool larger_is_closer = metric_str != knowhere::metric::L2;
+            for (int64_t i = 0; i < kNumQueries; i++) {
+                REQUIRE(lims[i + 1] - lims[i] <= 5);
+                for (size_t j = lims[i] + 1; j < lims[i + 1]; j++) {
+                    REQUIRE((larger_is_closer ? dists[j - 1] >= dists[j] : dists[j - 1] <= dists[j]));
+                }
+            }
+        }
+    }
+
+    SECTION("Test build with sub-graphs built in parallel") {
+        std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+        auto diskann_index_pack = knowhere::Pack(file_manager);
+        knowhere::Json deserialize_json = knowhere::Json::parse(deserialize_gen().dump());
+        knowhere::BinarySet binset;
+
+        knowhere::Json json = knowhere::Json::parse(build_gen().dump());
+        // a budget below the size of the raw data, so that the rows are split into sub-graphs
+        json["build_dram_budget_gb"] = sizeof(float) * kDim * kNumRows * 0.4 / (1024 * 1024 * 1024);
+        json["build_parallel_shards"] = 2;
+        {
+            knowhere::DataSetPtr ds_ptr = nullptr;
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            REQUIRE(diskann.Build(ds_ptr, json) == knowhere::Status::success);
+            diskann.Serialize(binset);
+        }
+        {
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            diskann.Deserialize(binset, deserialize_json);
+            knowhere::Json knn_json = knowhere::Json::parse(knn_search_gen().dump());
+            knn_json["search_list_size"] = 128;
+            auto res = diskann.Search(query_ds, knn_json, nullptr);
+            REQUIRE(res.has_value());
+            REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+        }
+    }
+
+    SECTION("Test search with the sectors reordered by the graph") {
+        std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+        auto diskann_index_pack = knowhere::Pack(file_manager);
+        knowhere::Json deserialize_json = knowhere::Json::parse(deserialize_gen().dump());
+        knowhere::BinarySet binset;
+
+        knowhere::Json json = knowhere::Json::parse(build_gen().dump());
+        json["reorder_sectors"] = true;
+        {
+            knowhere::DataSetPtr ds_ptr = nullptr;
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            REQUIRE(diskann.Build(ds_ptr, json) == knowhere::Status::success);
+            diskann.Serialize(binset);
+        }
+        {
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            diskann.Deserialize(binset, deserialize_json);
+            knowhere::Json knn_json = knowhere::Json::parse(knn_search_gen().dump());
+            auto res = diskann.Search(query_ds, knn_json, nullptr);
+            REQUIRE(res.has_value());
+            REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+        }
+    }
+
+    SECTION("Test search with 4-bit pq codes") {
+        std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+        auto diskann_index_pack = knowhere::Pack(file_manager);
+        knowhere::Json deserialize_json = knowhere::Json::parse(deserialize_gen().dump());
+        knowhere::BinarySet binset;
+
+        knowhere::Json json = knowhere::Json::parse(build_gen().dump());
+        json["pq_code_nbits"] = 4;
+        {
+            knowhere::DataSetPtr ds_ptr = nullptr;
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            REQUIRE(diskann.Build(ds_ptr, json) == knowhere::Status::success);
+            diskann.Serialize(binset);
+        }
+        {
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            diskann.Deserialize(binset, deserialize_json);
+            knowhere::Json knn_json = knowhere::Json::parse(knn_search_gen().dump());
+            auto res = diskann.Search(query_ds, knn_json, nullptr);
+            REQUIRE(res.has_value());
+            REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+        }
+    }
+
+    SECTION("Test search from the entry points of the navigation graph") {
+        std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+        auto diskann_index_pack = knowhere::Pack(file_manager);
+        knowhere::Json deserialize_json = knowhere::Json::parse(deserialize_gen().dump());
+        knowhere::BinarySet binset;
+
+        knowhere::Json json = knowhere::Json::parse(build_gen().dump());
+        json["nav_graph_ratio"] = 0.1f;
+        {
+            knowhere::DataSetPtr ds_ptr = nullptr;
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            REQUIRE(diskann.Build(ds_ptr, json) == knowhere::Status::success);
+            diskann.Serialize(binset);
+        }
+        {
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            diskann.Deserialize(binset, deserialize_json);
+            knowhere::Json knn_json = knowhere::Json::parse(knn_search_gen().dump());
+            auto res = diskann.Search(query_ds, knn_json, nullptr);
+            REQUIRE(res.has_value());
+            REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+        }
+    }
+
+    SECTION("Test search with the disk index read in ranges") {
+        auto file_manager = std::make_shared<RangeReadFileManager>();
+        auto diskann_index_pack = knowhere::Pack(std::shared_ptr<knowhere::FileManager>(file_manager));
+        knowhere::Json deserialize_json = knowhere::Json::parse(deserialize_gen().dump());
+        deserialize_json["remote_cache_dram_gb"] = sizeof(float) * kDim * kNumRows * 0.05 / (1024 * 1024 * 1024);
+        deserialize_json["remote_cache_ssd_gb"] = sizeof(float) * kDim * kNumRows * 0.5 / (1024 * 1024 * 1024);
+        deserialize_json["remote_cache_dir"] = kDir;
+        knowhere::BinarySet binset;
+
+        knowhere::Json json = knowhere::Json::parse(build_gen().dump());
+        {
+            knowhere::DataSetPtr ds_ptr = nullptr;
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            REQUIRE(diskann.Build(ds_ptr, json) == knowhere::Status::success);
+            diskann.Serialize(binset);
+        }
+        {
+            auto diskann =
+                knowhere::IndexFactory::Instance().Create<DataType>("DISKANN", version, diskann_index_pack).value();
+            REQUIRE(diskann.Deserialize(binset, deserialize_json) == knowhere::Status::success);
+            knowhere::Json knn_json = knowhere::Json::parse(knn_search_gen().dump());
+            auto res = diskann.Search(query_ds, knn_json, nullptr);
+            REQUIRE(res.has_value());
+            REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+            const auto num_reads = file_manager->num_reads.load();
+            REQUIRE(num_reads > 0);
+
+            // the sectors are cached, so searching again reads little of the remote file
+            res = diskann.Search(query_ds, knn_json, nullptr);
+            REQUIRE(res.has_value());
+            REQUIRE(GetKNNRecall(*knn_gt_ptr, *res.value()) >= kKnnRecall);
+            REQUIRE(file_manager->num_reads.load() - num_reads < num_reads);
         }
     }
     fs::remove_all(kDir);
@@ -386,6 +609,8 @@ TEST_CASE("Test DiskANN GetVectorByIds", "[diskann]") {
             json["search_list_size"] = kK;
             json["pq_code_budget_gb"] = sizeof(float) * dim * kNumRows * 0.03125 / (1024 * 1024 * 1024);
             json["build_dram_budget_gb"] = 32.0;
+            // the rows of kDim share the sectors, so they are read through the reordered layout
+            json["reorder_sectors"] = true;
             return json;
         };
 
@@ -446,3 +671,178 @@ TEST_CASE("Test DiskANN GetVectorByIds", "[diskann]") {
     fs::remove_all(kDir);
     fs::remove(kDir);
 }
+
+// This test case only check L2
+TEST_CASE("Test DiskANN search filtered by label", "[diskann]") {
+    fs::remove_all(kDir);
+    fs::remove(kDir);
+    REQUIRE_NOTHROW(fs::create_directories(kL2IndexDir));
+    auto version = GenTestVersionList();
+    constexpr uint32_t kNumLabels = 10;
+
+    knowhere::Json json;
+    json["dim"] = kDim;
+    json["metric_type"] = knowhere::metric::L2;
+    json["k"] = kK;
+    json["index_prefix"] = kL2IndexPrefix;
+
+    auto query_ds = GenDataSet(kNumQueries, kDim, 42);
+    auto base_ds = GenDataSet(kNumRows, kDim, 30);
+    WriteRawDataToDisk<float>(kRawDataPath, static_cast<const float*>(base_ds->GetTensor()), kNumRows, kDim);
+    std::vector<uint32_t> labels(kNumRows);
+    for (uint32_t i = 0; i < kNumRows; ++i) {
+        labels[i] = i % kNumLabels;
+    }
+    WriteRawDataToDisk<uint32_t>(kLabelPath, labels.data(), kNumRows, 1);
+
+    std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+    auto diskann_index_pack = knowhere::Pack(file_manager);
+    knowhere::BinarySet binset;
+    {
+        knowhere::Json build_json = json;
+        build_json["data_path"] = kRawDataPath;
+        build_json["label_path"] = kLabelPath;
+        build_json["max_degree"] = 56;
+        build_json["search_list_size"] = 128;
+        build_json["pq_code_budget_gb"] = sizeof(float) * kDim * kNumRows * 0.125 / (1024 * 1024 * 1024);
+        build_json["build_dram_budget_gb"] = 32.0;
+        auto diskann =
+            knowhere::IndexFactory::Instance().Create<knowhere::fp32>("DISKANN", version, diskann_index_pack).value();
+        REQUIRE(diskann.Build(nullptr, build_json) == knowhere::Status::success);
+        diskann.Serialize(binset);
+    }
+    auto diskann =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>("DISKANN", version, diskann_index_pack).value();
+    REQUIRE(diskann.Deserialize(binset, json) == knowhere::Status::success);
+
+    knowhere::Json search_json = json;
+    search_json["search_list_size"] = 36;
+    for (uint32_t label : {0u, 7u}) {
+        search_json["filter_label"] = label;
+        auto res = diskann.Search(query_ds, search_json, nullptr);
+        REQUIRE(res.has_value());
+        auto ids = res.value()->GetIds();
+        for (uint32_t i = 0; i < kNumQueries * kK; ++i) {
+            REQUIRE((ids[i] == -1 || labels[ids[i]] == label));
+        }
+        std::vector<uint8_t> bitset_data(kNumRows / 8);
+        for (uint32_t i = 0; i < kNumRows; ++i) {
+            if (labels[i] != label) {
+                bitset_data[i >> 3] |= 1 << (i & 7);
+            }
+        }
+        knowhere::BitsetView bitset(bitset_data.data(), kNumRows);
+        auto gt = knowhere::BruteForce::Search<knowhere::fp32>(base_ds, query_ds, json, bitset);
+        REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= kKnnRecall);
+    }
+    fs::remove_all(kDir);
+    fs::remove(kDir);
+}
+
+TEST_CASE("Test DiskANN streaming inserts and deletes", "[diskann]") {
+    fs::remove_all(kDir);
+    fs::remove(kDir);
+    REQUIRE_NOTHROW(fs::create_directories(kL2IndexDir));
+    auto version = GenTestVersionList();
+    // enough rows for a merge in the background
+    constexpr uint32_t kNumAdded = 100;
+
+    knowhere::Json json;
+    json["dim"] = kDim;
+    json["metric_type"] = knowhere::metric::L2;
+    json["k"] = kK;
+    json["index_prefix"] = kL2IndexPrefix;
+
+    auto query_ds = GenDataSet(kNumQueries, kDim, 42);
+    auto base_ds = GenDataSet(kNumRows, kDim, 30);
+    auto added_ds = GenDataSet(kNumAdded, kDim, 31);
+    WriteRawDataToDisk<float>(kRawDataPath, static_cast<const float*>(base_ds->GetTensor()), kNumRows, kDim);
+    std::vector<float> all_rows(static_cast<const float*>(base_ds->GetTensor()),
+                                static_cast<const float*>(base_ds->GetTensor()) + kNumRows * kDim);
+    all_rows.insert(all_rows.end(), static_cast<const float*>(added_ds->GetTensor()),
+                    static_cast<const float*>(added_ds->GetTensor()) + kNumAdded * kDim);
+    auto all_ds = knowhere::GenDataSet(kNumRows + kNumAdded, kDim, all_rows.data());
+    // the added rows 10 to 19 as queries
+    auto added_query_ds = knowhere::GenDataSet(10, kDim, all_rows.data() + (kNumRows + 10) * kDim);
+
+    std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+    auto diskann_index_pack = knowhere::Pack(file_manager);
+    knowhere::BinarySet binset;
+    knowhere::Json build_json = json;
+    build_json["data_path"] = kRawDataPath;
+    build_json["max_degree"] = 56;
+    build_json["search_list_size"] = 128;
+    build_json["pq_code_budget_gb"] = sizeof(float) * kDim * kNumRows * 0.125 / (1024 * 1024 * 1024);
+    build_json["build_dram_budget_gb"] = 32.0;
+    {
+        auto diskann =
+            knowhere::IndexFactory::Instance().Create<knowhere::fp32>("DISKANN", version, diskann_index_pack).value();
+        REQUIRE(diskann.Build(nullptr, build_json) == knowhere::Status::success);
+        diskann.Serialize(binset);
+    }
+
+    knowhere::Json search_json = json;
+    search_json["search_list_size"] = 36;
+    std::vector<int64_t> merged_deleted_ids = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    std::vector<int64_t> deleted_ids = {kNumRows, kNumRows + 1, kNumRows + 2};
+    auto check_added_rows = [&](auto& diskann) {
+        auto res = diskann.Search(added_query_ds, search_json, nullptr);
+        REQUIRE(res.has_value());
+        for (uint32_t i = 0; i < 10; ++i) {
+            REQUIRE(res.value()->GetIds()[i * kK] == kNumRows + 10 + i);
+        }
+        std::vector<int64_t> ids = {kNumRows + 50};
+        auto vectors = diskann.GetVectorByIds(GenIdsDataSet(ids.size(), ids));
+        REQUIRE(vectors.has_value());
+        auto data = static_cast<const float*>(vectors.value()->GetTensor());
+        REQUIRE(std::equal(data, data + kDim, all_rows.data() + (kNumRows + 50) * kDim));
+    };
+    {
+        auto diskann =
+            knowhere::IndexFactory::Instance().Create<knowhere::fp32>("DISKANN", version, diskann_index_pack).value();
+        REQUIRE(diskann.Deserialize(binset, json) == knowhere::Status::success);
+        REQUIRE(diskann.DeleteByIds(GenIdsDataSet(merged_deleted_ids.size(), merged_deleted_ids)) ==
+                knowhere::Status::success);
+        // the adds go to memory and start the merge
+        REQUIRE(diskann.Add(added_ds, build_json) == knowhere::Status::success);
+        REQUIRE(diskann.Count() == kNumRows + kNumAdded);
+        REQUIRE(diskann.DeleteByIds(GenIdsDataSet(deleted_ids.size(), deleted_ids)) == knowhere::Status::success);
+        std::vector<int64_t> invalid_ids = {kNumRows + kNumAdded};
+        REQUIRE(diskann.DeleteByIds(GenIdsDataSet(invalid_ids.size(), invalid_ids)) ==
+                knowhere::Status::invalid_args);
+
+        check_added_rows(diskann);
+        auto res = diskann.Search(all_ds, search_json, nullptr);
+        REQUIRE(res.has_value());
+        for (uint32_t i = 0; i < (kNumRows + kNumAdded) * kK; ++i) {
+            auto id = res.value()->GetIds()[i];
+            REQUIRE((id >= 10 && (id < kNumRows || id >= kNumRows + 3)));
+        }
+        // the destructor waits for the merge
+    }
+
+    // the merged rows are read from the disk index
+    auto diskann =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>("DISKANN", version, diskann_index_pack).value();
+    REQUIRE(diskann.Deserialize(binset, json) == knowhere::Status::success);
+    REQUIRE(diskann.Count() == kNumRows + kNumAdded);
+    check_added_rows(diskann);
+
+    std::vector<uint8_t> bitset_data((kNumRows + kNumAdded + 7) / 8);
+    for (auto id : deleted_ids) {
+        bitset_data[id >> 3] |= 1 << (id & 7);
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), kNumRows + kNumAdded);
+    auto res = diskann.Search(query_ds, search_json, bitset);
+    REQUIRE(res.has_value());
+    for (uint32_t i = 0; i < kNumQueries * kK; ++i) {
+        REQUIRE(res.value()->GetIds()[i] >= 10);
+    }
+    for (auto id : merged_deleted_ids) {
+        bitset_data[id >> 3] |= 1 << (id & 7);
+    }
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(all_ds, query_ds, json, bitset);
+    REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= kKnnRecall);
+    fs::remove_all(kDir);
+    fs::remove(kDir);
+}
@@ -10,6 +10,7 @@
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -18,6 +19,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -302,13 +304,13 @@ test_hnsw(const knowhere::DataSetPtr& default_ds_ptr, const knowhere::DataSetPtr
             knowhere::IndexStaticFaced<T>::HasRawData(index_type,
                                                       knowhere::Version::GetCurrentVersion().VersionNumber(), conf));
 
-    // test GetVectorByIds()
+    // test GetVectorByIds(), in the reverse order of the storage, so that the rows are put back in request order
     if (index_loaded.HasRawData(metric_type)) {
         const auto rows = default_t_ds_ptr->GetRows();
 
         int64_t* ids = new int64_t[rows];
         for (int64_t i = 0; i < rows; i++) {
-            ids[i] = i;
+            ids[i] = rows - 1 - i;
         }
 
         auto ids_ds = knowhere::GenIdsDataSet(rows, ids);
@@ -2283,3 +2285,1002 @@ TEST_CASE("hnswlib to FAISS HNSW for HNSW_FLAT", "Check search fallback") {
         REQUIRE(recall == 1);
     }
 }
+
+TEST_CASE("FAISS HNSW pipelined expansion", "Check that prefetching does not change results") {
+    const int64_t nb = 2000, nq = 16;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto index_type =
+        GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW, knowhere::IndexEnum::INDEX_HNSW_SQ);
+    auto prefetch_depth = GENERATE(as<int32_t>{}, 1, 8, 64);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    std::vector<uint8_t> bitset_data(nb / 8);
+    for (int64_t i = 0; i < nb; i += 3) {
+        bitset_data[i / 8] |= (1 << (i % 8));
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+    for (const auto& cur_bitset : {knowhere::BitsetView(), bitset}) {
+        auto baseline = index.Search(query_ds, conf, cur_bitset);
+        REQUIRE(baseline.has_value());
+
+        knowhere::Json prefetch_conf = conf;
+        prefetch_conf[knowhere::indexparam::HNSW_PREFETCH_DEPTH] = prefetch_depth;
+        auto pipelined = index.Search(query_ds, prefetch_conf, cur_bitset);
+        REQUIRE(pipelined.has_value());
+
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(baseline.value()->GetIds()[i] == pipelined.value()->GetIds()[i]);
+            REQUIRE(baseline.value()->GetDistance()[i] == pipelined.value()->GetDistance()[i]);
+        }
+    }
+}
+
+TEST_CASE("FAISS HNSW batched traversal", "Check that batched queries produce the same results") {
+    const int64_t nb = 2000, nq = 37;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto index_type = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW, knowhere::IndexEnum::INDEX_HNSW_SQ);
+    auto query_batch_size = GENERATE(as<int32_t>{}, 2, 16, 64);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    std::vector<uint8_t> bitset_data(nb / 8);
+    for (int64_t i = 0; i < nb; i += 3) {
+        bitset_data[i / 8] |= (1 << (i % 8));
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+    for (const auto& cur_bitset : {knowhere::BitsetView(), bitset}) {
+        auto baseline = index.Search(query_ds, conf, cur_bitset);
+        REQUIRE(baseline.has_value());
+
+        knowhere::Json batched_conf = conf;
+        batched_conf[knowhere::indexparam::HNSW_QUERY_BATCH_SIZE] = query_batch_size;
+        auto batched = index.Search(query_ds, batched_conf, cur_bitset);
+        REQUIRE(batched.has_value());
+
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(baseline.value()->GetIds()[i] == batched.value()->GetIds()[i]);
+            REQUIRE(baseline.value()->GetDistance()[i] == batched.value()->GetDistance()[i]);
+        }
+    }
+}
+
+TEST_CASE("FAISS HNSW graph reordering", "Check that reordered indices keep external ids") {
+    const int64_t nb = 2000, nq = 100;
+    const int64_t dim = 16;
+    const int64_t topk = 1;
+
+    auto index_type = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW, knowhere::IndexEnum::INDEX_HNSW_SQ);
+    auto reorder_type = GENERATE(as<std::string>{}, "bfs", "rcm");
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::HNSW_REORDER_TYPE] = reorder_type;
+    if (index_type == knowhere::IndexEnum::INDEX_HNSW_SQ) {
+        conf[knowhere::indexparam::SQ_TYPE] = "fp16";
+        conf[knowhere::indexparam::HNSW_REFINE] = true;
+        conf[knowhere::indexparam::HNSW_REFINE_TYPE] = "fp32";
+    }
+
+    // queries are the first rows of the dataset, so every query should find itself
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = knowhere::GenDataSet(nq, dim, train_ds->GetTensor());
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+    auto index_loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index_loaded.Deserialize(binary_set, conf) == knowhere::Status::success);
+    REQUIRE(index_loaded.Count() == nb);
+
+    for (auto* cur_index : {&index, &index_loaded}) {
+        auto result = cur_index->Search(query_ds, conf, nullptr);
+        REQUIRE(result.has_value());
+
+        int64_t found = 0;
+        for (int64_t i = 0; i < nq; i++) {
+            found += (result.value()->GetIds()[i] == i) ? 1 : 0;
+        }
+        REQUIRE(found >= nq * 0.95);
+
+        // filter out even ids
+        std::vector<uint8_t> bitset_data(nb / 8, 0x55);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto filtered_result = cur_index->Search(query_ds, conf, bitset);
+        REQUIRE(filtered_result.has_value());
+        for (int64_t i = 0; i < nq; i++) {
+            REQUIRE(filtered_result.value()->GetIds()[i] % 2 == 1);
+        }
+    }
+
+    if (index_loaded.HasRawData(knowhere::metric::L2)) {
+        std::vector<int64_t> ids(nq);
+        for (int64_t i = 0; i < nq; i++) {
+            ids[i] = (i * 17) % nb;
+        }
+        auto ids_ds = knowhere::GenIdsDataSet(nq, ids.data());
+        auto vectors = index_loaded.GetVectorByIds(ids_ds);
+        REQUIRE(vectors.has_value());
+
+        const float* src = reinterpret_cast<const float*>(train_ds->GetTensor());
+        const float* dst = reinterpret_cast<const float*>(vectors.value()->GetTensor());
+        for (int64_t i = 0; i < nq; i++) {
+            for (int64_t j = 0; j < dim; j++) {
+                REQUIRE(dst[i * dim + j] == src[ids[i] * dim + j]);
+            }
+        }
+    }
+}
+
+TEST_CASE("FAISS HNSW two-hop expansion", "Check the search with highly selective filters") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    auto filter_ratio = GENERATE(as<float>{}, 0.8f, 0.9f);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    // randomly filter out rows
+    std::vector<uint8_t> bitset_data(nb / 8, 0);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> distrib(0.0f, 1.0f);
+    for (int64_t i = 0; i < nb; i++) {
+        if (distrib(rng) < filter_ratio) {
+            bitset_data[i / 8] |= (1 << (i % 8));
+        }
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, bitset);
+    REQUIRE(gt.has_value());
+
+    knowhere::Json two_hop_conf = conf;
+    two_hop_conf[knowhere::indexparam::HNSW_TWO_HOP_EXPANSION] = true;
+    auto result = index.Search(query_ds, two_hop_conf, bitset);
+    REQUIRE(result.has_value());
+
+    for (int64_t i = 0; i < nq * topk; i++) {
+        const auto id = result.value()->GetIds()[i];
+        REQUIRE(id >= 0);
+        REQUIRE(!bitset.test(id));
+    }
+
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+}
+
+TEST_CASE("FAISS HNSW compressed graph", "Check the search over delta-encoded neighbor lists") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    auto index_type = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW, knowhere::IndexEnum::INDEX_HNSW_SQ);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::SQ_TYPE] = "SQ8";
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+
+    knowhere::Json compressed_conf = conf;
+    compressed_conf[knowhere::indexparam::HNSW_COMPRESS_GRAPH] = true;
+    auto index_compressed = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index_compressed.Deserialize(binary_set, compressed_conf) == knowhere::Status::success);
+    REQUIRE(index_compressed.Count() == nb);
+
+    auto gt = index.Search(query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index_compressed.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+
+    // the order of neighbors differs, so the traversal may differ slightly
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+
+    // the compressed index serializes into the regular format
+    knowhere::BinarySet binary_set_compressed;
+    REQUIRE(index_compressed.Serialize(binary_set_compressed) == knowhere::Status::success);
+    auto index_reloaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index_reloaded.Deserialize(binary_set_compressed, conf) == knowhere::Status::success);
+
+    auto result_reloaded = index_reloaded.Search(query_ds, conf, nullptr);
+    REQUIRE(result_reloaded.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result_reloaded.value()) >= 0.9f);
+}
+
+TEST_CASE("FAISS HNSW fast-scan neighbor codes", "Check the search that scores neighbors with 4-bit PQ blocks") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::M] = 16;
+    conf[knowhere::indexparam::NBITS] = 4;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_PQ, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+
+    knowhere::Json fast_scan_conf = conf;
+    fast_scan_conf[knowhere::indexparam::HNSW_FAST_SCAN_NEIGHBORS] = true;
+    auto index_fast_scan =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_PQ, version).value();
+    REQUIRE(index_fast_scan.Deserialize(binary_set, fast_scan_conf) == knowhere::Status::success);
+    REQUIRE(index_fast_scan.Count() == nb);
+    // the neighbor codes take extra memory
+    REQUIRE(index_fast_scan.Size() > index.Size());
+
+    auto gt = index.Search(query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index_fast_scan.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+
+    // the distance tables are quantized, so the traversal may differ slightly
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.8f);
+}
+
+TEST_CASE("FAISS HNSW mmap load", "Check that a mapped index matches the one loaded into memory") {
+    const int64_t nb = 2000, nq = 20;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+    auto index_type = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW, knowhere::IndexEnum::INDEX_HNSW_SQ);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::SQ_TYPE] = "SQ8";
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+
+    const std::string filename = "/tmp/knowhere_faiss_hnsw_mmap_test";
+    {
+        auto binary = binary_set.GetByName(index.Type());
+        std::remove(filename.c_str());
+        std::ofstream out(filename, std::ios::binary);
+        out.write((const char*)binary->data.get(), binary->size);
+    }
+
+    knowhere::Json mmap_conf = conf;
+    mmap_conf["enable_mmap"] = true;
+    auto index_mmap = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version).value();
+    REQUIRE(index_mmap.DeserializeFromFile(filename, mmap_conf) == knowhere::Status::success);
+    REQUIRE(index_mmap.Count() == nb);
+
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    auto result_mmap = index_mmap.Search(query_ds, conf, nullptr);
+    REQUIRE(result_mmap.has_value());
+
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result.value()->GetIds()[i] == result_mmap.value()->GetIds()[i]);
+        REQUIRE(result.value()->GetDistance()[i] == result_mmap.value()->GetDistance()[i]);
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("FAISS HNSW iterator workspace reuse", "Check that iterators reusing pooled buffers return the same results") {
+    const int64_t nb = 2000, nq = 20;
+    const int64_t dim = 16;
+    const int64_t topk = 20;
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 32;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    auto collect = [&]() {
+        auto its = index.AnnIterator(query_ds, conf, nullptr);
+        REQUIRE(its.has_value());
+
+        std::vector<int64_t> ids;
+        for (auto& it : its.value()) {
+            for (int64_t j = 0; j < topk && it->HasNext(); j++) {
+                ids.push_back(it->Next().first);
+            }
+        }
+        return ids;
+    };
+
+    // iterators of the later rounds get the visited sets of the earlier ones
+    const auto ids = collect();
+    REQUIRE(ids.size() == nq * topk);
+    for (int round = 0; round < 3; round++) {
+        REQUIRE(collect() == ids);
+    }
+}
+
+TEST_CASE("FAISS HNSW entry point seeds", "Check the search with additional level-0 entry points") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 32;
+    conf[knowhere::indexparam::HNSW_ENTRY_POINT_SEEDS] = 32;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+
+    // seeds are not serialized, they are picked again during the load
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+    auto index_loaded =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index_loaded.Deserialize(binary_set, conf) == knowhere::Status::success);
+
+    auto result_loaded = index_loaded.Search(query_ds, conf, nullptr);
+    REQUIRE(result_loaded.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result.value()->GetIds()[i] == result_loaded.value()->GetIds()[i]);
+    }
+
+    auto range_conf = conf;
+    range_conf[knowhere::meta::RADIUS] = (metric == knowhere::metric::L2) ? 1.0f : 0.8f;
+    auto range_result = index_loaded.RangeSearch(query_ds, range_conf, nullptr);
+    REQUIRE(range_result.has_value());
+}
+
+TEST_CASE("FAISS HNSW adaptive early termination", "Check the search that stops once the top-k converges") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    auto query_batch_size = GENERATE(as<int32_t>{}, 1, 8);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 128;
+    conf[knowhere::indexparam::HNSW_QUERY_BATCH_SIZE] = query_batch_size;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+
+    // a patience that is never exhausted does not change the results
+    knowhere::Json patient_conf = conf;
+    patient_conf[knowhere::indexparam::HNSW_EARLY_STOP_PATIENCE] = nb;
+    auto result_patient = index.Search(query_ds, patient_conf, nullptr);
+    REQUIRE(result_patient.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result.value()->GetIds()[i] == result_patient.value()->GetIds()[i]);
+    }
+
+    knowhere::Json early_stop_conf = conf;
+    early_stop_conf[knowhere::indexparam::HNSW_EARLY_STOP_PATIENCE] = 16;
+    early_stop_conf[knowhere::indexparam::HNSW_EARLY_STOP_GAP] = 0.001f;
+    auto result_early_stop = index.Search(query_ds, early_stop_conf, nullptr);
+    REQUIRE(result_early_stop.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result_early_stop.value()->GetIds()[i] >= 0);
+    }
+    REQUIRE(GetKNNRecall(*gt.value(), *result_early_stop.value()) >= 0.8f);
+}
+
+TEST_CASE("FAISS HNSW merge", "Check the search over graphs merged without a rebuild") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+    auto reorder_type = GENERATE(as<std::string>{}, "none", "bfs");
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::HNSW_REORDER_TYPE] = reorder_type;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    // two segments over the halves of the data
+    const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+    auto first_ds = knowhere::GenDataSet(nb / 2, dim, data);
+    auto second_ds = knowhere::GenDataSet(nb - nb / 2, dim, data + (nb / 2) * dim);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    auto other =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(first_ds, conf) == knowhere::Status::success);
+    REQUIRE(other.Build(second_ds, conf) == knowhere::Status::success);
+
+    REQUIRE(index.Merge({other}, conf) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+    REQUIRE(other.Count() == nb - nb / 2);
+
+    // rows of the second segment follow the rows of the first one
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+
+    // the merged index is serialized as a regular one
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+    auto index_loaded =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index_loaded.Deserialize(binary_set, conf) == knowhere::Status::success);
+
+    auto result_loaded = index_loaded.Search(query_ds, conf, nullptr);
+    REQUIRE(result_loaded.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result.value()->GetIds()[i] == result_loaded.value()->GetIds()[i]);
+    }
+}
+
+TEST_CASE("FAISS HNSW batched build", "Check the recall of a graph built with batched insertions") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto add_batch_size = GENERATE(as<int64_t>{}, 64, 1024);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::HNSW_ADD_BATCH_SIZE] = add_batch_size;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+}
+
+TEST_CASE("FAISS HNSW concurrent insert", "Check the search over a graph that grows at the same time") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+    const int64_t chunk_rows = 500;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::HNSW_CONCURRENT_INSERT] = true;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+    const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(knowhere::GenDataSet(chunk_rows, dim, data), conf) == knowhere::Status::success);
+    REQUIRE(index.Count() == chunk_rows);
+
+    // the rest of the rows is added while the index is searched
+    std::atomic<bool> adding{true};
+    std::atomic<bool> add_failed{false};
+    std::thread writer([&]() {
+        for (int64_t i = chunk_rows; i < nb; i += chunk_rows) {
+            auto chunk_ds = knowhere::GenDataSet(std::min(chunk_rows, nb - i), dim, data + i * dim);
+            if (index.Add(chunk_ds, conf) != knowhere::Status::success) {
+                add_failed = true;
+            }
+        }
+        adding = false;
+    });
+
+    bool ids_valid = true;
+    while (adding.load()) {
+        auto result = index.Search(query_ds, conf, nullptr);
+        const int64_t count = index.Count();
+        if (!result.has_value()) {
+            ids_valid = false;
+            break;
+        }
+        for (int64_t i = 0; i < nq * topk; i++) {
+            const int64_t id = result.value()->GetIds()[i];
+            ids_valid = ids_valid && id >= -1 && id < count;
+        }
+    }
+    writer.join();
+
+    REQUIRE(!add_failed.load());
+    REQUIRE(ids_valid);
+    REQUIRE(index.Count() == nb);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+}
+
+TEST_CASE("FAISS HNSW soft delete", "Check the search over an index with deleted rows") {
+    const int64_t nb = 5000, nq = 50;
+    const int64_t dim = 16;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+    auto reorder_type = GENERATE(as<std::string>{}, "none", "bfs");
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::HNSW_REORDER_TYPE] = reorder_type;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    // every fifth row is deleted
+    std::vector<int64_t> deleted_ids;
+    std::vector<uint8_t> deleted_bits((nb + 7) / 8, 0);
+    for (int64_t i = 0; i < nb; i += 5) {
+        deleted_ids.push_back(i);
+        deleted_bits[i >> 3] |= (0x1 << (i & 0x7));
+    }
+    REQUIRE(index.DeleteByIds(GenIdsDataSet(deleted_ids.size(), deleted_ids)) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+
+    std::vector<int64_t> invalid_ids = {nb};
+    REQUIRE(index.DeleteByIds(GenIdsDataSet(invalid_ids.size(), invalid_ids)) == knowhere::Status::invalid_args);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf,
+                                                           knowhere::BitsetView(deleted_bits.data(), nb));
+    REQUIRE(gt.has_value());
+
+    auto check_result = [&](const auto& idx) {
+        auto result = idx.Search(query_ds, conf, nullptr);
+        REQUIRE(result.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            const int64_t id = result.value()->GetIds()[i];
+            REQUIRE(id >= 0);
+            REQUIRE(id % 5 != 0);
+        }
+        REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+    };
+    check_result(index);
+
+    // deleted rows are kept by the serialized index
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+    auto index_loaded =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index_loaded.Deserialize(binary_set, conf) == knowhere::Status::success);
+    check_result(index_loaded);
+}
+
+TEST_CASE("FAISS HNSW RaBitQ", "Check the search over RaBitQ codes with a refine") {
+    const int64_t nb = 3000, nq = 50;
+    const int64_t dim = 64;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto query_bits = GENERATE(0, 8);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 128;
+    conf[knowhere::indexparam::HNSW_REFINE] = true;
+    conf[knowhere::indexparam::HNSW_REFINE_TYPE] = "FLAT";
+    conf[knowhere::indexparam::HNSW_REFINE_K] = 8;
+    conf[knowhere::indexparam::RABITQ_QUERY_BITS] = query_bits;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance()
+                     .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_RABITQ, version)
+                     .value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+    REQUIRE(index.HasRawData(metric));
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+
+    // a serialized index keeps the codes and the refine data
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+    auto index_loaded = knowhere::IndexFactory::Instance()
+                            .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_RABITQ, version)
+                            .value();
+    REQUIRE(index_loaded.Deserialize(binary_set, conf) == knowhere::Status::success);
+
+    auto result_loaded = index_loaded.Search(query_ds, conf, nullptr);
+    REQUIRE(result_loaded.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result.value()->GetIds()[i] == result_loaded.value()->GetIds()[i]);
+    }
+}
+
+TEST_CASE("FAISS HNSW SQ rotation", "Check the search over rotated SQ codes with a refine") {
+    const int64_t nb = 3000, nq = 50;
+    const int64_t dim = 64;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+    auto rotation = GENERATE(as<std::string>{}, "random", "opq");
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 128;
+    conf[knowhere::indexparam::SQ_TYPE] = "sq4";
+    conf[knowhere::indexparam::SQ_ROTATION] = rotation;
+    conf[knowhere::indexparam::HNSW_REFINE] = true;
+    conf[knowhere::indexparam::HNSW_REFINE_TYPE] = "fp32";
+    conf[knowhere::indexparam::HNSW_REFINE_K] = 4;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_SQ, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+    REQUIRE(index.HasRawData(metric));
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+
+    // the rotation is serialized along with the codes
+    knowhere::BinarySet binary_set;
+    REQUIRE(index.Serialize(binary_set) == knowhere::Status::success);
+    auto index_loaded =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_SQ, version).value();
+    REQUIRE(index_loaded.Deserialize(binary_set, conf) == knowhere::Status::success);
+    auto result_loaded = index_loaded.Search(query_ds, conf, nullptr);
+    REQUIRE(result_loaded.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(result.value()->GetIds()[i] == result_loaded.value()->GetIds()[i]);
+    }
+
+    // rotated fp16 codes do not restore the vectors exactly
+    knowhere::Json fp16_conf = conf;
+    fp16_conf[knowhere::indexparam::SQ_TYPE] = "fp16";
+    fp16_conf.erase(knowhere::indexparam::HNSW_REFINE);
+    fp16_conf.erase(knowhere::indexparam::HNSW_REFINE_TYPE);
+    REQUIRE_FALSE(
+        knowhere::IndexStaticFaced<knowhere::fp32>::HasRawData(knowhere::IndexEnum::INDEX_HNSW_SQ, version, fp16_conf));
+}
+
+TEST_CASE("FAISS HNSW SIMD search", "Check the search compiled per SIMD level against the generic one") {
+    const int64_t nb = 2000, nq = 32;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    // with and without a tail of the SIMD width
+    auto dim = GENERATE(as<int64_t>{}, 37, 128);
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    std::vector<uint8_t> bitset_data(nb / 8);
+    for (int64_t i = 0; i < nb; i += 3) {
+        bitset_data[i / 8] |= (1 << (i % 8));
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+    for (const auto& cur_bitset : {knowhere::BitsetView(), bitset}) {
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::GENERIC);
+        auto generic = index.Search(query_ds, conf, cur_bitset);
+        knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AUTO);
+        auto simd = index.Search(query_ds, conf, cur_bitset);
+        REQUIRE(generic.has_value());
+        REQUIRE(simd.has_value());
+
+        // the sums are rounded in another order, which may swap close neighbors
+        REQUIRE(GetKNNRecall(*generic.value(), *simd.value()) >= 0.95f);
+        for (int64_t i = 0; i < nq * topk; i++) {
+            if (generic.value()->GetIds()[i] == simd.value()->GetIds()[i]) {
+                REQUIRE(simd.value()->GetDistance()[i] ==
+                        Catch::Approx(generic.value()->GetDistance()[i]).epsilon(1e-4).margin(1e-4));
+            }
+            if (!cur_bitset.empty() && simd.value()->GetIds()[i] >= 0) {
+                REQUIRE(!cur_bitset.test(simd.value()->GetIds()[i]));
+            }
+        }
+    }
+}
+
+TEST_CASE("FAISS HNSW filtered neighbor chunks", "Check the search over neighbor lists longer than a test chunk") {
+    const int64_t nb = 3000, nq = 32;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    auto filter_ratio = GENERATE(as<float>{}, 0.1f, 0.5f, 0.9f);
+    auto prefetch_depth = GENERATE(as<int32_t>{}, 0, 8);
+
+    // 64 neighbors on the level 0, which spans two chunks
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 32;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 128;
+    conf[knowhere::indexparam::HNSW_PREFETCH_DEPTH] = prefetch_depth;
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, static_cast<size_t>(nb * filter_ratio));
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, bitset);
+    REQUIRE(gt.has_value());
+    auto result = index.Search(query_ds, conf, bitset);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+    for (int64_t i = 0; i < nq * topk; i++) {
+        const auto id = result.value()->GetIds()[i];
+        REQUIRE((id == -1 || !bitset.test(id)));
+    }
+}
+
+template <typename T>
+void
+check_half_precision_sq_search(const std::string& sq_type, const std::string& metric, const bool lossless) {
+    const int64_t nb = 2000, nq = 32;
+    const int64_t dim = 100;
+    const int64_t topk = 10;
+
+    knowhere::Json conf;
+    conf[knowhere::meta::DIM] = dim;
+    conf[knowhere::meta::METRIC_TYPE] = metric;
+    conf[knowhere::meta::TOPK] = topk;
+    conf[knowhere::indexparam::HNSW_M] = 16;
+    conf[knowhere::indexparam::EFCONSTRUCTION] = 96;
+    conf[knowhere::indexparam::EF] = 64;
+    conf[knowhere::indexparam::SQ_TYPE] = sq_type;
+
+    auto train_ds = knowhere::ConvertToDataTypeIfNeeded<T>(GenDataSet(nb, dim, 42));
+    auto query_ds = knowhere::ConvertToDataTypeIfNeeded<T>(GenDataSet(nq, dim, 123));
+
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto index = knowhere::IndexFactory::Instance().Create<T>(knowhere::IndexEnum::INDEX_HNSW_SQ, version).value();
+    REQUIRE(index.Build(train_ds, conf) == knowhere::Status::success);
+
+    auto gt = knowhere::BruteForce::Search<T>(train_ds, query_ds, conf, nullptr);
+    REQUIRE(gt.has_value());
+    auto result = index.Search(query_ds, conf, nullptr);
+    REQUIRE(result.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *result.value()) >= 0.9f);
+
+    if (!lossless) {
+        return;
+    }
+
+    // the codes hold the vectors exactly, so the distances are those of the brute force
+    for (int64_t i = 0; i < nq; i++) {
+        for (int64_t j = 0; j < topk; j++) {
+            for (int64_t l = 0; l < topk; l++) {
+                if (gt.value()->GetIds()[i * topk + l] == result.value()->GetIds()[i * topk + j]) {
+                    REQUIRE(result.value()->GetDistance()[i * topk + j] ==
+                            Catch::Approx(gt.value()->GetDistance()[i * topk + l]).epsilon(1e-3).margin(1e-3));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("FAISS HNSW SQ half-precision queries", "Check fp16 and bf16 queries scored against codes of their type") {
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+
+    SECTION("fp16") {
+        check_half_precision_sq_search<knowhere::fp16>("fp16", metric, true);
+    }
+    SECTION("bf16") {
+        check_half_precision_sq_search<knowhere::bf16>("bf16", metric, true);
+    }
+    SECTION("fp16 data, bf16 codes") {
+        // not the type of the codes, scored in fp32
+        check_half_precision_sq_search<knowhere::fp16>("bf16", metric, false);
+    }
+}
@@ -246,4 +246,37 @@ TEST_CASE("Test Float Get Vector By Ids", "[Float GetVectorByIds]") {
             task.wait();
         }
     }
+
+    SECTION("Test IVF index without deserialization") {
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, version)
+                       .value();
+        knowhere::Json json = ivfflat_gen();
+        auto train_ds = GenDataSet(nb, dim);
+        auto train_ds_copy = CopyDataSet(train_ds, nb);
+        auto ids_ds = GenIdsDataSet(nb, nq);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        const auto size_before = idx.Size();
+
+        // the map from ids to the lists is built by the first of the concurrent calls
+        std::vector<std::future<void>> retrieve_task_list;
+        for (int i = 0; i < 8; i++) {
+            retrieve_task_list.push_back(std::async(std::launch::async, [&] {
+                auto results = idx.GetVectorByIds(ids_ds);
+                REQUIRE(results.has_value());
+                auto xb = (float*)train_ds_copy->GetTensor();
+                auto res_data = (float*)results.value()->GetTensor();
+                for (int q = 0; q < nq; ++q) {
+                    const auto id = ids_ds->GetIds()[q];
+                    for (int j = 0; j < dim; ++j) {
+                        REQUIRE(res_data[q * dim + j] == xb[id * dim + j]);
+                    }
+                }
+            }));
+        }
+        for (auto& task : retrieve_task_list) {
+            task.wait();
+        }
+        REQUIRE(idx.Size() == size_before + nb * (int64_t)sizeof(int64_t));
+    }
 }
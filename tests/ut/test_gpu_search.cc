@@ -15,6 +15,7 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
 #include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/gpu_device_usage.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/knowhere_check.h"
 #include "knowhere/comp/knowhere_config.h"
@@ -208,6 +209,73 @@ TEST_CASE("Test All GPU Index", "[search]") {
         }
     }
 
+    SECTION("Test Gpu Index Search With Filter Version") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_CUVS_IVFFLAT, refined_gen(ivfflat_gen)),
+            make_tuple(knowhere::IndexEnum::INDEX_CUVS_IVFPQ, refined_gen(ivfpq_gen)),
+            make_tuple(knowhere::IndexEnum::INDEX_CUVS_CAGRA, refined_gen(cagra_gen)),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name, json.dump());
+        auto train_ds = GenDataSet(nb, dim, seed);
+        auto query_ds = GenDataSet(nq, dim, seed);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        // 0.995 runs as a brute force over the rows left, 0.4 through the index with the cached bitset
+        int64_t filter_version = 0;
+        for (const float percentage : {0.995f, 0.4f}) {
+            auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, percentage * nb);
+            knowhere::BitsetView bitset(bitset_data.data(), nb);
+            json[knowhere::indexparam::FILTER_VERSION] = ++filter_version;
+            auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, bitset);
+            for (int i = 0; i < 2; i++) {
+                auto results = idx.Search(query_ds, json, bitset);
+                REQUIRE(results.has_value());
+                const auto* ids = results.value()->GetIds();
+                for (int64_t j = 0; j < nq * json[knowhere::meta::TOPK].get<int64_t>(); j++) {
+                    REQUIRE((ids[j] == -1 || !bitset.test(ids[j])));
+                }
+                REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= (percentage > 0.99f ? 0.99f : 0.7f));
+            }
+        }
+    }
+
+    SECTION("Test Gpu Index Sharded") {
+        using std::make_tuple;
+        auto [name, gen, min_recall] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>, float>({
+            make_tuple(knowhere::IndexEnum::INDEX_CUVS_BRUTEFORCE, bruteforce_gen, 0.999f),
+            make_tuple(knowhere::IndexEnum::INDEX_CUVS_IVFFLAT, ivfflat_gen, 0.7f),
+            make_tuple(knowhere::IndexEnum::INDEX_CUVS_CAGRA, cagra_gen, 0.7f),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        json[knowhere::indexparam::NUM_SHARDS] = 3;
+        CAPTURE(name, json.dump());
+        auto train_ds = GenDataSet(nb, dim, seed);
+        auto query_ds = GenDataSet(nq, dim, seed + 1);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        REQUIRE(idx.Count() == nb);
+        int64_t shard_rows = 0;
+        for (const auto& usage : knowhere::GetGpuDeviceUsage()) {
+            shard_rows += usage.rows;
+        }
+        REQUIRE(shard_rows >= nb);
+
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(loaded.Deserialize(bs) == knowhere::Status::success);
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, 0.4f * nb);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        for (const auto* index : {&idx, &loaded}) {
+            auto results = index->Search(query_ds, json, bitset);
+            REQUIRE(results.has_value());
+            auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, bitset);
+            REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= min_recall);
+        }
+    }
+
     SECTION("Test Gpu Index Search TopK") {
         using std::make_tuple;
         auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
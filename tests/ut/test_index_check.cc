@@ -118,6 +118,11 @@ TEST_CASE("Test index and data type check", "[IndexCheckTest]") {
         CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_HNSW_PRQ, VecType::VECTOR_BFLOAT16));
         CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_HNSW_PRQ, VecType::VECTOR_INT8));
 
+        CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_FLOAT));
+        CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_FLOAT16));
+        CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_BFLOAT16));
+        CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_HNSW_RABITQ, VecType::VECTOR_INT8));
+
         // diskann
         CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_DISKANN, VecType::VECTOR_FLOAT));
         CHECK(KnowhereCheck::IndexTypeAndDataTypeCheck(IndexEnum::INDEX_DISKANN, VecType::VECTOR_FLOAT16));
@@ -148,6 +153,7 @@ TEST_CASE("Test support mmap index", "[IndexCheckTest]") {
         CHECK(KnowhereCheck::SupportMmapIndexTypeCheck(IndexEnum::INDEX_HNSW_SQ));
         CHECK(KnowhereCheck::SupportMmapIndexTypeCheck(IndexEnum::INDEX_HNSW_PQ));
         CHECK(KnowhereCheck::SupportMmapIndexTypeCheck(IndexEnum::INDEX_HNSW_PRQ));
+        CHECK(KnowhereCheck::SupportMmapIndexTypeCheck(IndexEnum::INDEX_HNSW_RABITQ));
 
         // sparse index
         CHECK(KnowhereCheck::SupportMmapIndexTypeCheck(IndexEnum::INDEX_SPARSE_INVERTED_INDEX));
@@ -256,6 +262,58 @@ TEST_CASE("Test index has raw data", "[IndexHasRawData]") {
     }
 }
 
+TEST_CASE("Test estimate load resource", "[IndexEstimateLoadResource]") {
+    auto ver = Version::GetCurrentVersion().VersionNumber();
+    const float file_size = 1.0f;
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = 128;
+    json["vec_field_size_gb"] = 0.5;
+
+    SECTION("In memory load") {
+        auto res = knowhere::IndexStaticFaced<fp32>::EstimateLoadResource(IndexEnum::INDEX_FAISS_IVFSQ8, ver,
+                                                                           file_size, json);
+        REQUIRE(res.has_value());
+        CHECK(res.value().memoryCost == Catch::Approx(file_size));
+        CHECK(res.value().diskCost == 0.0f);
+
+        // the direct map of the ids is not part of the file
+        res = knowhere::IndexStaticFaced<fp32>::EstimateLoadResource(IndexEnum::INDEX_FAISS_IVFFLAT, ver, file_size,
+                                                                      json);
+        REQUIRE(res.has_value());
+        CHECK(res.value().memoryCost == Catch::Approx(file_size + 0.5f / (128 * sizeof(float)) * sizeof(int64_t)));
+    }
+
+    SECTION("Mmap load") {
+        json["enable_mmap"] = true;
+        json[knowhere::indexparam::NLIST] = 1024;
+        auto res = knowhere::IndexStaticFaced<fp32>::EstimateLoadResource(IndexEnum::INDEX_FAISS_IVFSQ8, ver,
+                                                                           file_size, json);
+        REQUIRE(res.has_value());
+        CHECK(res.value().memoryCost == Catch::Approx(1024 * 128 * sizeof(float) / (1024.0f * 1024.0f * 1024.0f)));
+        CHECK(res.value().diskCost == Catch::Approx(file_size));
+
+        // the graph is read into memory, the codes stay mapped
+        json[knowhere::indexparam::HNSW_M] = 16;
+        res = knowhere::IndexStaticFaced<fp32>::EstimateLoadResource(IndexEnum::INDEX_HNSW_SQ, ver, file_size, json);
+        REQUIRE(res.has_value());
+        CHECK(res.value().memoryCost > 0.0f);
+        CHECK(res.value().memoryCost < file_size);
+        CHECK(res.value().diskCost == Catch::Approx(file_size));
+    }
+
+#ifdef KNOWHERE_WITH_DISKANN
+    SECTION("DiskANN budgets") {
+        json[knowhere::indexparam::PQ_CODE_BUDGET_GB] = 0.1;
+        json[knowhere::indexparam::SEARCH_CACHE_BUDGET_GB] = 0.2;
+        auto res =
+            knowhere::IndexStaticFaced<fp32>::EstimateLoadResource(IndexEnum::INDEX_DISKANN, ver, file_size, json);
+        REQUIRE(res.has_value());
+        CHECK(res.value().memoryCost == Catch::Approx(0.3f));
+        CHECK(res.value().diskCost == Catch::Approx(file_size));
+    }
+#endif
+}
+
 TEST_CASE("Test index feature check", "[IndexFeatureCheck]") {
     SECTION("Check MMap") {
         REQUIRE(IndexFactory::Instance().FeatureCheck(IndexEnum::INDEX_FAISS_IDMAP, knowhere::feature::MMAP));
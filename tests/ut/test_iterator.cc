@@ -262,6 +262,71 @@ TEST_CASE("Test Iterator Mem Index With Float Vector", "[float metrics]") {
         REQUIRE(recall > kKnnRecallThreshold);
     }
 
+    SECTION("Test IVF iterator expanding probes on demand") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivf_base_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivf_base_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        // only the closest centroid is ordered up front
+        json[knowhere::indexparam::NPROBE] = 1;
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto its = idx.AnnIterator(query_ds, json, nullptr);
+        REQUIRE(its.has_value());
+
+        // iterating to the end visits every list once
+        for (auto& it : its.value()) {
+            std::unordered_set<int64_t> ids;
+            while (it->HasNext()) {
+                REQUIRE(ids.insert(it->Next().first).second);
+            }
+            REQUIRE(ids.size() == nb);
+        }
+    }
+
+    SECTION("Test NextBatch returns the same results as Next") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivf_base_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto its = idx.AnnIterator(query_ds, json, nullptr);
+        auto batch_its = idx.AnnIterator(query_ds, json, nullptr);
+        REQUIRE(its.has_value());
+        REQUIRE(batch_its.has_value());
+        auto bf_its = knowhere::BruteForce::AnnIterator<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+        auto bf_batch_its = knowhere::BruteForce::AnnIterator<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+        REQUIRE(bf_its.has_value());
+        REQUIRE(bf_batch_its.has_value());
+
+        auto check = [](const knowhere::IndexNode::IteratorPtr& it, const knowhere::IndexNode::IteratorPtr& batch_it) {
+            const size_t batch = 7;
+            std::vector<int64_t> ids(batch);
+            std::vector<float> dists(batch);
+            while (true) {
+                const size_t n = batch_it->NextBatch(batch, ids.data(), dists.data());
+                for (size_t i = 0; i < n; i++) {
+                    REQUIRE(it->HasNext());
+                    auto [id, dist] = it->Next();
+                    REQUIRE(id == ids[i]);
+                    REQUIRE(dist == dists[i]);
+                }
+                if (n < batch) {
+                    break;
+                }
+            }
+            REQUIRE(!it->HasNext());
+            REQUIRE(!batch_it->HasNext());
+        };
+        for (int64_t i = 0; i < nq; i++) {
+            check(its.value()[i], batch_its.value()[i]);
+            check(bf_its.value()[i], bf_batch_its.value()[i]);
+        }
+    }
+
 #ifdef KNOWHERE_WITH_CARDINAL
     // currently, only cardinal support iterator_retain_order
     SECTION("Test Search with ordered Iterator") {
@@ -590,6 +655,23 @@ TEST_CASE("Test Iterator BruteForce With Float Vector", "[float metrics]") {
     }
 }
 
+TEST_CASE("Test Iterator BruteForce Across Sort Windows", "[float metrics]") {
+    // many more vectors than the first window PrecomputedDistanceIterator sorts
+    const int64_t nb = 20000, nq = 2;
+    const int64_t dim = 4;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    const auto train_ds = GenDataSet(nb, dim, 1);
+    const auto query_ds = GenDataSet(nq, dim, 778);
+    const knowhere::Json conf = {
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, nb},
+    };
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, conf, nullptr);
+    auto iterators = knowhere::BruteForce::AnnIterator<knowhere::fp32>(train_ds, query_ds, conf, nullptr).value();
+    AssertBruteForceIteratorResultCorrect(nb, iterators, gt.value());
+}
+
 TEST_CASE("Test Iterator BruteForce With Sparse Float Vector", "[IP metric]") {
     using Catch::Approx;
 
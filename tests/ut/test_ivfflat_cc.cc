@@ -15,7 +15,11 @@
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
+#include "faiss/IndexFlat.h"
+#include "faiss/IndexIVFFlat.h"
+#include "faiss/index_io.h"
 #include "faiss/invlists/InvertedLists.h"
+#include "io/memory_io.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/knowhere_check.h"
 #include "knowhere/index/index_factory.h"
@@ -145,6 +149,126 @@ TEST_CASE("Test Build Search Concurrency", "[Concurrency]") {
         }
     }
 
+    SECTION("Test Concurrent Invlists Append") {
+        size_t code_size = 16;
+        size_t segment_size = 48;
+        auto add_list = std::make_unique<faiss::ConcurrentArrayInvertedLists>(1, code_size, segment_size, false);
+        auto append_list = std::make_unique<faiss::ConcurrentArrayInvertedLists>(1, code_size, segment_size, false);
+
+        size_t total = 0;
+        for (const size_t add_size : {5, 43, 48, 1, 300}) {
+            std::vector<faiss::idx_t> ids(add_size);
+            std::vector<uint8_t> codes(add_size * code_size);
+            for (size_t j = 0; j < add_size; j++) {
+                ids[j] = total + j;
+                std::fill(codes.begin() + j * code_size, codes.begin() + (j + 1) * code_size, (uint8_t)(total + j));
+            }
+            add_list->add_entries(0, add_size, ids.data(), codes.data());
+            auto offset = append_list->append_entries(0, add_size, ids.data(), [&](size_t i0, size_t i1, uint8_t* dst) {
+                std::memcpy(dst, codes.data() + i0 * code_size, (i1 - i0) * code_size);
+            });
+            REQUIRE(offset == total);
+            total += add_size;
+            REQUIRE(append_list->list_size(0) == total);
+        }
+        for (size_t j = 0; j < total; j++) {
+            CHECK(*(append_list->get_ids(0, j)) == *(add_list->get_ids(0, j)));
+            CHECK(std::memcmp(append_list->get_codes(0, j), add_list->get_codes(0, j), code_size) == 0);
+        }
+    }
+
+    SECTION("Test Concurrent Invlists Add By List") {
+        const size_t nlist = 16;
+        const int64_t n = 3000;
+        auto train_ds = GenDataSet(n, dim, seed);
+        const float* x = reinterpret_cast<const float*>(train_ds->GetTensor());
+        faiss::IndexFlatL2 quantizer(dim);
+        faiss::IndexIVFFlat ivf(&quantizer, dim, nlist);
+        ivf.train(n, x);
+        faiss::IndexIVFFlatCC ivf_cc(&quantizer, dim, nlist, 48);
+        ivf_cc.is_trained = true;
+
+        // the lists hold the entries in the order of the adds, as the ones of an entry by entry add
+        std::vector<faiss::idx_t> ids(n);
+        for (int64_t i = 0; i < n; i++) {
+            ids[i] = n - i;
+        }
+        for (const int64_t add_size : {1000, 7, 1993}) {
+            const int64_t begin = ivf.ntotal;
+            ivf.add_with_ids(add_size, x + begin * dim, ids.data() + begin);
+            ivf_cc.add_with_ids(add_size, x + begin * dim, ids.data() + begin);
+        }
+        REQUIRE(ivf_cc.ntotal == n);
+        for (size_t l = 0; l < nlist; l++) {
+            REQUIRE(ivf_cc.invlists->list_size(l) == ivf.invlists->list_size(l));
+            for (size_t j = 0; j < ivf.invlists->list_size(l); j++) {
+                CHECK(ivf_cc.invlists->get_single_id(l, j) == ivf.invlists->get_single_id(l, j));
+                CHECK(std::memcmp(ivf_cc.invlists->get_single_code(l, j), ivf.invlists->get_single_code(l, j),
+                                  ivf.code_size) == 0);
+            }
+        }
+    }
+
+    SECTION("Test Large Lists Split") {
+        const int64_t n_train = 1000, n_add = 300, n_adds = 4;
+        const int64_t max_list_size = 400;
+        for (const std::string name :
+             {knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, knowhere::IndexEnum::INDEX_FAISS_IVFSQ_CC}) {
+            CAPTURE(name);
+            knowhere::Json json = ivf_sq_8_cc_gen();
+            json[knowhere::indexparam::NLIST] = 4;
+            json[knowhere::indexparam::MAX_LIST_SIZE] = max_list_size;
+            auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+            auto train_ds = GenDataSet(n_train, dim, seed);
+            REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+            // the added rows drift to the region of a single row, so that its list grows
+            const float* center = reinterpret_cast<const float*>(train_ds->GetTensor());
+            std::vector<float> added(n_adds * n_add * dim);
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> noise(-5.0f, 5.0f);
+            for (size_t i = 0; i < added.size(); i++) {
+                added[i] = center[i % dim] + noise(rng);
+            }
+            for (int64_t i = 0; i < n_adds; i++) {
+                auto add_ds = knowhere::GenDataSet(n_add, dim, added.data() + i * n_add * dim);
+                REQUIRE(idx.Add(add_ds, json) == knowhere::Status::success);
+            }
+            const int64_t ntotal = n_train + n_adds * n_add;
+            REQUIRE(idx.Count() == ntotal);
+
+            // the lists hold every row once, with a centroid each
+            knowhere::BinarySet bs;
+            REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+            auto binary = bs.GetByName(name);
+            REQUIRE(binary != nullptr);
+            knowhere::MemoryIOReader reader(binary->data.get(), binary->size);
+            std::unique_ptr<faiss::IndexIVF> ivf(dynamic_cast<faiss::IndexIVF*>(faiss::read_index(&reader)));
+            REQUIRE(ivf != nullptr);
+            REQUIRE(ivf->nlist > 4);
+            REQUIRE(ivf->quantizer->ntotal == static_cast<faiss::idx_t>(ivf->nlist));
+            std::vector<bool> found(ntotal, false);
+            for (size_t l = 0; l < ivf->nlist; l++) {
+                for (size_t j = 0; j < ivf->invlists->list_size(l); j++) {
+                    const auto id = ivf->invlists->get_single_id(l, j);
+                    REQUIRE(!found[id]);
+                    found[id] = true;
+                }
+            }
+            REQUIRE(std::count(found.begin(), found.end(), true) == ntotal);
+
+            // the moved rows are found in their new lists
+            json[knowhere::indexparam::NPROBE] = ivf->nlist;
+            json[knowhere::meta::TOPK] = 1;
+            auto query_ds = knowhere::GenDataSet(nq / 10, dim, added.data());
+            auto results = idx.Search(query_ds, json, nullptr);
+            REQUIRE(results.has_value());
+            for (int64_t i = 0; i < nq / 10; i++) {
+                CHECK(results.value()->GetIds()[i] == n_train + i);
+            }
+        }
+    }
+
     SECTION("Test Add & Search & RangeSearch Serialized ") {
         using std::make_tuple;
         auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
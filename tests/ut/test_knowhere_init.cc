@@ -50,6 +50,7 @@ TEST_CASE("Knowhere global config", "[init]") {
 #ifdef KNOWHERE_WITH_DISKANN
     REQUIRE_FALSE(knowhere::KnowhereConfig::SetAioContextPool(0));
     REQUIRE(knowhere::KnowhereConfig::SetAioContextPool(16));
+    REQUIRE_FALSE(knowhere::KnowhereConfig::SetUringContextPool(0));
 #endif
 
 #ifdef KNOWHERE_WITH_CUVS
@@ -58,7 +59,7 @@ TEST_CASE("Knowhere global config", "[init]") {
 }
 
 TEST_CASE("Knowhere SIMD config", "[simd]") {
-    std::vector<std::string> v = {"AVX512", "AVX2", "SSE4_2", "GENERIC", "NEON", "SVE"};
+    std::vector<std::string> v = {"AVX512", "AVX2", "SSE4_2", "GENERIC", "NEON", "SVE", "RVV"};
     std::unordered_set<std::string> s(v.begin(), v.end());
 
     auto res = knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AVX512);
@@ -9,7 +9,10 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <cstring>
+#include <random>
 #include <string>
+#include <vector>
 
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
@@ -17,6 +20,7 @@
 #include "knowhere/comp/brute_force.h"
 #include "knowhere/comp/knowhere_check.h"
 #include "knowhere/comp/local_file_manager.h"
+#include "knowhere/comp/minhash_signature.h"
 #include "knowhere/expected.h"
 #include "knowhere/index/index_factory.h"
 #include "knowhere/utils.h"
@@ -56,6 +60,7 @@ TEST_CASE("Test MinHashLSHIndexNode with MinHashLSH hit", "[minhash_lsh_index]")
     auto use_mmap = GENERATE(as<bool>{}, true, false);
     auto batch_search_flag = GENERATE(as<bool>{}, true, false);
     auto mh_search_with_jaccard = GENERATE(as<bool>{}, true, false);
+    auto blocked_bloom_filter = GENERATE(as<bool>{}, true, false);
     size_t bin_vec_dim = kHashDim * hash_bit;
     auto base_gen = [&metric_str, &hash_bit, &mh_search_with_jaccard, &dim = bin_vec_dim]() {
         knowhere::Json json;
@@ -80,10 +85,11 @@ TEST_CASE("Test MinHashLSHIndexNode with MinHashLSH hit", "[minhash_lsh_index]")
         return json;
     };
 
-    auto deserialize_gen = [&base_gen, &metric_str, &use_mmap, &batch_search_flag]() {
+    auto deserialize_gen = [&base_gen, &metric_str, &use_mmap, &batch_search_flag, &blocked_bloom_filter]() {
         knowhere::Json json = base_gen();
         json["index_prefix"] = kIndexDir;
         json["mh_lsh_batch_search"] = batch_search_flag;
+        json["mh_lsh_blocked_bloom_filter"] = blocked_bloom_filter;
         json["hash_code_in_memory"] = !use_mmap;
         return json;
     };
@@ -145,6 +151,149 @@ TEST_CASE("Test MinHashLSHIndexNode with MinHashLSH hit", "[minhash_lsh_index]")
             }
         }
     }
+    SECTION("Test multi probe with prefix keys") {
+        std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+        auto minhash_index_index_pack = knowhere::Pack(file_manager);
+        knowhere::BinarySet binset;
+        knowhere::Json json = build_gen();
+        json["mh_lsh_prefix_key"] = true;
+        {
+            knowhere::DataSetPtr ds_ptr = nullptr;
+            auto minhash_index = knowhere::IndexFactory::Instance()
+                                     .Create<knowhere::bin1>("MINHASH_LSH", version, minhash_index_index_pack)
+                                     .value();
+            REQUIRE(minhash_index.Build(ds_ptr, json) == knowhere::Status::success);
+            minhash_index.Serialize(binset);
+        }
+        auto minhash_index = knowhere::IndexFactory::Instance()
+                                 .Create<knowhere::bin1>("MINHASH_LSH", version, minhash_index_index_pack)
+                                 .value();
+        minhash_index.Deserialize(binset, deserialize_gen());
+        knowhere::Json knn_json = knn_search_gen();
+        knn_json["mh_lsh_multi_probe"] = true;
+        auto res = minhash_index.Search(query_ds, knn_json, nullptr);
+        REQUIRE(res.has_value());
+        REQUIRE(GetKNNRecall(*lsh_gt_ptr, *res.value()) == 1.0);
+    }
     fs::remove_all(kDir);
     fs::remove(kDir);
 }
+
+TEST_CASE("Test MinHashLSHIndexNode growing index", "[minhash_lsh_index]") {
+    auto version = GenTestVersionList();
+    auto hash_bit = GENERATE(as<uint32_t>{}, 32, 64);
+    size_t bin_vec_dim = kHashDim * hash_bit;
+    knowhere::Json json;
+    json["dim"] = bin_vec_dim;
+    json["metric_type"] = knowhere::metric::MHJACCARD;
+    json["k"] = kK;
+    json["mh_lsh_band"] = 32;
+    json["mh_element_bit_width"] = hash_bit;
+    json["mh_search_with_jaccard"] = false;
+
+    auto base_ds = GenBinDataSet(kNumRows, bin_vec_dim, 22);
+    auto query_ds = GenBinDataSet(kNumQueries, bin_vec_dim, 22);
+    auto gt = knowhere::BruteForce::Search<knowhere::bin1>(base_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+    auto minhash_index = knowhere::IndexFactory::Instance()
+                             .Create<knowhere::bin1>("MINHASH_LSH", version, knowhere::Pack(file_manager))
+                             .value();
+    // rows are added in two parts, and searched after each of them
+    auto base = static_cast<const uint8_t*>(base_ds->GetTensor());
+    const size_t half = kNumRows / 2;
+    auto first_ds = knowhere::GenDataSet(half, bin_vec_dim, base);
+    auto second_ds = knowhere::GenDataSet(kNumRows - half, bin_vec_dim, base + half * bin_vec_dim / 8, half);
+    REQUIRE(minhash_index.Add(first_ds, json) == knowhere::Status::success);
+    REQUIRE(minhash_index.Count() == (int64_t)half);
+    auto res = minhash_index.Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(minhash_index.Add(second_ds, json) == knowhere::Status::success);
+    REQUIRE(minhash_index.Count() == kNumRows);
+    res = minhash_index.Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *res.value()) == 1.0);
+}
+
+TEST_CASE("Test MinHash signatures of token sets", "[minhash_lsh_index]") {
+    auto version = GenTestVersionList();
+    auto hash_bit = GENERATE(as<uint32_t>{}, 32, 64);
+    constexpr size_t kNumSets = 1000;
+    constexpr size_t kSetSize = 64;
+    constexpr size_t kNumPerm = 128;
+
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> tokens(kNumSets * kSetSize);
+    for (auto& token : tokens) {
+        token = rng();
+    }
+    std::vector<size_t> offsets(kNumSets + 1);
+    for (size_t i = 0; i <= kNumSets; i++) {
+        offsets[i] = i * kSetSize;
+    }
+    auto base = knowhere::GenMinHashSignatures(tokens.data(), offsets, kNumPerm, hash_bit);
+    REQUIRE(base.has_value());
+    REQUIRE(base.value()->GetRows() == (int64_t)kNumSets);
+    REQUIRE(base.value()->GetDim() == (int64_t)(kNumPerm * hash_bit));
+
+    // every query is a base set with an eighth of its tokens replaced, in reverse order, and a repeated token
+    std::vector<uint64_t> query_tokens;
+    std::vector<size_t> query_offsets = {0};
+    for (size_t q = 0; q < kNumQueries; q++) {
+        const size_t set = q * 97;
+        for (size_t t = kSetSize; t > 0; t--) {
+            query_tokens.push_back(t <= kSetSize / 8 ? rng() : tokens[set * kSetSize + t - 1]);
+        }
+        query_tokens.push_back(query_tokens.back());
+        query_offsets.push_back(query_tokens.size());
+    }
+    auto query = knowhere::GenMinHashSignatures(query_tokens.data(), query_offsets, kNumPerm, hash_bit);
+    REQUIRE(query.has_value());
+
+    SECTION("Test the signatures estimate the jaccard similarity") {
+        const size_t element_size = hash_bit / 8;
+        auto base_sig = static_cast<const char*>(base.value()->GetTensor());
+        auto query_sig = static_cast<const char*>(query.value()->GetTensor());
+        for (size_t q = 0; q < kNumQueries; q++) {
+            size_t equal = 0;
+            for (size_t j = 0; j < kNumPerm; j++) {
+                equal += std::memcmp(query_sig + (q * kNumPerm + j) * element_size,
+                                     base_sig + (q * 97 * kNumPerm + j) * element_size, element_size) == 0;
+            }
+            // 56 of the 72 tokens of the union are shared
+            REQUIRE(float(equal) / kNumPerm == Catch::Approx(56.0 / 72.0).margin(0.15));
+        }
+        auto again = knowhere::GenMinHashSignatures(tokens.data(), offsets, kNumPerm, hash_bit);
+        REQUIRE(std::memcmp(again.value()->GetTensor(), base_sig, kNumSets * kNumPerm * element_size) == 0);
+    }
+
+    SECTION("Test search MINHASH_LSH with the signatures") {
+        knowhere::Json json;
+        json["dim"] = kNumPerm * hash_bit;
+        json["metric_type"] = knowhere::metric::MHJACCARD;
+        json["k"] = 1;
+        json["mh_lsh_band"] = 32;
+        json["mh_element_bit_width"] = hash_bit;
+        json["mh_search_with_jaccard"] = false;
+        std::shared_ptr<knowhere::FileManager> file_manager = std::make_shared<knowhere::LocalFileManager>();
+        auto minhash_index = knowhere::IndexFactory::Instance()
+                                 .Create<knowhere::bin1>("MINHASH_LSH", version, knowhere::Pack(file_manager))
+                                 .value();
+        REQUIRE(minhash_index.Add(base.value(), json) == knowhere::Status::success);
+        auto res = minhash_index.Search(query.value(), json, nullptr);
+        REQUIRE(res.has_value());
+        for (size_t q = 0; q < kNumQueries; q++) {
+            REQUIRE(res.value()->GetIds()[q] == (int64_t)(q * 97));
+        }
+    }
+
+    SECTION("Test invalid arguments") {
+        REQUIRE(knowhere::GenMinHashSignatures(tokens.data(), offsets, kNumPerm, 16).error() ==
+                knowhere::Status::invalid_args);
+        REQUIRE(knowhere::GenMinHashSignatures(tokens.data(), offsets, 0, hash_bit).error() ==
+                knowhere::Status::invalid_args);
+        REQUIRE(knowhere::GenMinHashSignatures(tokens.data(), {0, 2, 1}, kNumPerm, hash_bit).error() ==
+                knowhere::Status::invalid_args);
+    }
+}
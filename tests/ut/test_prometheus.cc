@@ -11,6 +11,8 @@
 
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "catch2/catch_test_macros.hpp"
 #include "knowhere/prometheus_client.h"
@@ -21,4 +23,47 @@ TEST_CASE("Test prometheus client", "[prometheus client]") {
         std::cout << str << std::endl;
         CHECK(str.length() >= 0);
     }
+
+    SECTION("check sharded metrics") {
+        const prometheus::Histogram::BucketBoundaries buckets = {1, 10, 100};
+        auto& histogram_family = prometheus::BuildHistogram()
+                                     .Name("test_sharded_histogram")
+                                     .Help("test sharded histogram")
+                                     .Register(knowhere::prometheusClient->GetRegistry());
+        auto& counter_family = prometheus::BuildCounter()
+                                   .Name("test_sharded_counter")
+                                   .Help("test sharded counter")
+                                   .Register(knowhere::prometheusClient->GetRegistry());
+        auto& histogram = histogram_family.Add({}, buckets);
+        auto& counter = counter_family.Add({});
+        knowhere::ShardedHistogram sharded_histogram(histogram, buckets);
+        knowhere::ShardedCounter sharded_counter(counter);
+
+        const int n_threads = 8, n_per_thread = 1000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < n_threads; t++) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < n_per_thread; i++) {
+                    sharded_histogram.Observe(i % 200);
+                    sharded_counter.Increment();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // nothing reaches the registry before a flush
+        REQUIRE(histogram.Collect().histogram.sample_count == 0);
+        knowhere::prometheusClient->GetMetrics();
+
+        const auto metric = histogram.Collect().histogram;
+        REQUIRE(metric.sample_count == n_threads * n_per_thread);
+        // 0..199 five times per thread
+        REQUIRE(metric.sample_sum == n_threads * 5 * (199 * 200 / 2));
+        // the cumulative counts of the values up to 1, 10 and 100
+        REQUIRE(metric.bucket[0].cumulative_count == n_threads * 5 * 2);
+        REQUIRE(metric.bucket[1].cumulative_count == n_threads * 5 * 11);
+        REQUIRE(metric.bucket[2].cumulative_count == n_threads * 5 * 101);
+        REQUIRE(counter.Value() == n_threads * n_per_thread);
+    }
 }
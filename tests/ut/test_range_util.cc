@@ -112,6 +112,33 @@ TEST_CASE("Test GetRangeSearchResult for HNSW/DiskANN", "[range search]") {
     }
 }
 
+TEST_CASE("Test GetRangeSearchResult parallel copy", "[range search]") {
+    // skewed result sizes, above kParallelRangeResultSize in total
+    const int64_t nq = 200;
+    std::vector<std::vector<int64_t>> labels(nq);
+    std::vector<std::vector<float>> distances(nq);
+    size_t total = 0;
+    for (int64_t i = 0; i < nq; i++) {
+        const size_t num = (i % 10 == 0) ? 20000 : i % 7;
+        for (size_t j = 0; j < num; j++) {
+            labels[i].push_back(i * 100000 + j);
+            distances[i].push_back(static_cast<float>(j));
+        }
+        total += num;
+    }
+    REQUIRE(total >= knowhere::kParallelRangeResultSize);
+
+    auto result = knowhere::GetRangeSearchResult(distances, labels, false, nq, 1e9, -1.0);
+    REQUIRE(result.lims[nq] == total);
+    for (int64_t i = 0; i < nq; i++) {
+        REQUIRE(result.lims[i + 1] - result.lims[i] == labels[i].size());
+        for (size_t j = 0; j < labels[i].size(); j++) {
+            REQUIRE(result.labels[result.lims[i] + j] == labels[i][j]);
+            REQUIRE(result.distances[result.lims[i] + j] == distances[i][j]);
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 #if 0
 namespace {
@@ -9,6 +9,9 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <map>
+#include <thread>
+
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
@@ -16,9 +19,15 @@
 #include "hnswlib/hnswalg.h"
 #include "knowhere/bitsetview.h"
 #include "knowhere/comp/brute_force.h"
+#include "knowhere/comp/emb_list.h"
+#include "knowhere/comp/group_by.h"
+#include "knowhere/comp/huge_pages.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/knowhere_check.h"
 #include "knowhere/comp/knowhere_config.h"
+#include "knowhere/comp/memory_usage.h"
+#include "knowhere/comp/query_dedup.h"
+#include "knowhere/comp/search_stats.h"
 #include "knowhere/index/index_factory.h"
 #include "knowhere/log.h"
 #include "simd/hook.h"
@@ -441,6 +450,299 @@ TEST_CASE("Test Mem Index With Float Vector", "[float metrics]") {
         }
     }
 
+    SECTION("Test Search with IVF adaptive nprobe") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        auto fixed_results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(fixed_results.has_value());
+
+        const int64_t nprobe = json[knowhere::indexparam::NPROBE];
+        const int64_t min_nprobe = 2;
+        auto search_adaptive = [&](const float radius_scale, int64_t& total_nprobe) {
+            knowhere::Json adaptive_json = json;
+            adaptive_json[knowhere::indexparam::ADAPTIVE_NPROBE] = true;
+            adaptive_json[knowhere::indexparam::MIN_NPROBE] = min_nprobe;
+            adaptive_json[knowhere::indexparam::ADAPTIVE_NPROBE_RADIUS_SCALE] = radius_scale;
+            auto results = idx.Search(query_ds, adaptive_json, nullptr);
+            REQUIRE(results.has_value());
+
+            auto nprobe_used = results.value()->Get<std::vector<int64_t>>(knowhere::meta::NPROBE_USED);
+            REQUIRE(nprobe_used.size() == (size_t)nq);
+            total_nprobe = 0;
+            for (const int64_t used : nprobe_used) {
+                REQUIRE(used >= min_nprobe);
+                REQUIRE(used <= nprobe);
+                total_nprobe += used;
+            }
+            return results;
+        };
+
+        // exact radii never drop a result of the probed lists
+        int64_t exact_nprobe = 0;
+        auto exact_results = search_adaptive(1.0f, exact_nprobe);
+        REQUIRE(GetKNNRecall(*fixed_results.value(), *exact_results.value()) >= kBruteForceRecallThreshold);
+
+        // smaller radii only stop earlier
+        int64_t scaled_nprobe = 0;
+        search_adaptive(0.5f, scaled_nprobe);
+        REQUIRE(scaled_nprobe <= exact_nprobe);
+    }
+
+    SECTION("Test Search with search stats") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        // the stats are opt-in
+        auto results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        auto no_stats = results.value()->Get<knowhere::SearchStatsVec>(knowhere::meta::SEARCH_STATS);
+        REQUIRE(no_stats.empty());
+
+        json[knowhere::meta::SEARCH_STATS] = true;
+        results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        auto stats = results.value()->Get<knowhere::SearchStatsVec>(knowhere::meta::SEARCH_STATS);
+        REQUIRE(stats.size() == (size_t)nq);
+        for (const auto& s : stats) {
+            REQUIRE(s.ndis > 0);
+            REQUIRE(s.ndis <= nb);
+            REQUIRE(!s.bf_fallback);
+            if (name == knowhere::IndexEnum::INDEX_HNSW) {
+                REQUIRE(s.nhops > 0);
+            } else {
+                REQUIRE(s.nlist > 0);
+                REQUIRE(s.nlist <= json[knowhere::indexparam::NPROBE].get<int64_t>());
+            }
+        }
+
+        // a brute force search computes the distances to every valid row
+        const auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto bf_results = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, bitset);
+        REQUIRE(bf_results.has_value());
+        auto bf_stats = bf_results.value()->Get<knowhere::SearchStatsVec>(knowhere::meta::SEARCH_STATS);
+        REQUIRE(bf_stats.size() == (size_t)nq);
+        for (const auto& s : bf_stats) {
+            REQUIRE(s.ndis == nb - nb / 2);
+        }
+    }
+
+    SECTION("Test Search with IVF list-major batches") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        knowhere::Json list_major_json = json;
+        list_major_json[knowhere::indexparam::LIST_MAJOR_NQ] = 1;
+
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        const knowhere::BitsetView filter(bitset_data.data(), nb);
+        for (const knowhere::BitsetView bitset : {knowhere::BitsetView(), filter}) {
+            auto results = idx.Search(query_ds, json, bitset);
+            auto list_major_results = idx.Search(query_ds, list_major_json, bitset);
+            REQUIRE(results.has_value());
+            REQUIRE(list_major_results.has_value());
+            // the same lists are scanned, only in a different order
+            REQUIRE(GetKNNRecall(*results.value(), *list_major_results.value()) >= kBruteForceRecallThreshold);
+        }
+    }
+
+    SECTION("Test Search with IVF HNSW coarse quantizer") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+        }));
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        auto flat_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(flat_idx.Build(train_ds, json) == knowhere::Status::success);
+
+        knowhere::Json hnsw_json = json;
+        hnsw_json[knowhere::indexparam::COARSE_QUANTIZER] = "hnsw";
+        hnsw_json[knowhere::indexparam::COARSE_HNSW_M] = 8;
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, hnsw_json) == knowhere::Status::success);
+
+        // the graph over a few centroids is searched exhaustively
+        auto flat_results = flat_idx.Search(query_ds, json, nullptr);
+        auto results = idx.Search(query_ds, hnsw_json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*flat_results.value(), *results.value()) >= kBruteForceRecallThreshold);
+
+        // the graph is serialized along with the lists
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto idx_ = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx_.Deserialize(bs) == knowhere::Status::success);
+        auto deserialized_results = idx_.Search(query_ds, hnsw_json, nullptr);
+        REQUIRE(deserialized_results.has_value());
+        REQUIRE(GetKNNRecall(*results.value(), *deserialized_results.value()) == Approx(1.0f));
+
+        knowhere::Json invalid_json = json;
+        invalid_json[knowhere::indexparam::COARSE_QUANTIZER] = "ivf";
+        auto invalid_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(invalid_idx.Build(train_ds, invalid_json) == knowhere::Status::invalid_args);
+    }
+
+    SECTION("Test Search with IVF selective bitsets") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        // most lists have no valid rows, the rest of them only a few
+        const int64_t num_valid = nb / 20;
+        auto bitset_data = GenerateBitsetWithFirstTbitsSet(nb, nb - num_valid);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+        for (const bool ensure_topk_full : {true, false}) {
+            json[knowhere::indexparam::ENSURE_TOPK_FULL] = ensure_topk_full;
+            auto results = idx.Search(query_ds, json, bitset);
+            REQUIRE(results.has_value());
+
+            const int64_t* ids = results.value()->GetIds();
+            for (int64_t i = 0; i < nq; i++) {
+                int64_t num_found = 0;
+                for (int64_t j = 0; j < topk; j++) {
+                    const int64_t id = ids[i * topk + j];
+                    if (id >= 0) {
+                        REQUIRE(id >= nb - num_valid);
+                        num_found++;
+                    }
+                }
+                // the probes of the lists without valid rows go to the next lists
+                if (ensure_topk_full) {
+                    REQUIRE(num_found == std::min(topk, num_valid));
+                }
+            }
+        }
+    }
+
+    SECTION("Test Search with SCANN anisotropic quantization") {
+        if (!faiss::support_pq_fast_scan) {
+            return;
+        }
+        auto cfg_json = scann_gen().dump();
+        CAPTURE(cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        json[knowhere::indexparam::ANISOTROPIC_THRESHOLD] = 0.2;
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_SCANN, version)
+                       .value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+
+        json[knowhere::indexparam::ANISOTROPIC_THRESHOLD] = 1.0;
+        auto invalid_idx = knowhere::IndexFactory::Instance()
+                               .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_SCANN, version)
+                               .value();
+        REQUIRE(invalid_idx.Build(train_ds, json) == knowhere::Status::out_of_range_in_json);
+    }
+
+    SECTION("Test Async Search") {
+        knowhere::Json json = ivfflat_gen();
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, version)
+                       .value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto results = idx.Search(query_ds, json, nullptr);
+        auto range_results = idx.RangeSearch(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(range_results.has_value());
+
+        // fan out without waiting on each search
+        std::vector<folly::SemiFuture<knowhere::expected<knowhere::DataSetPtr>>> futs;
+        for (int i = 0; i < 4; i++) {
+            futs.push_back(idx.SearchAsync(query_ds, json, nullptr));
+        }
+        auto range_fut = idx.RangeSearchAsync(query_ds, json, nullptr);
+        auto iterator_fut = idx.AnnIteratorAsync(query_ds, json, nullptr);
+        for (auto& fut : futs) {
+            auto async_results = std::move(fut).get();
+            REQUIRE(async_results.has_value());
+            REQUIRE(std::equal(results.value()->GetIds(), results.value()->GetIds() + nq * topk,
+                               async_results.value()->GetIds()));
+        }
+        auto async_range_results = std::move(range_fut).get();
+        REQUIRE(async_range_results.has_value());
+        REQUIRE(std::equal(range_results.value()->GetLims(), range_results.value()->GetLims() + nq + 1,
+                           async_range_results.value()->GetLims()));
+        auto iterators = std::move(iterator_fut).get();
+        REQUIRE(iterators.has_value());
+        REQUIRE(iterators.value().size() == (size_t)nq);
+    }
+
+    SECTION("Test Search Cancellation") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+        }));
+        knowhere::Json json = gen();
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        auto token = std::make_shared<knowhere::CancellationToken>();
+        auto results = idx.Search(query_ds, json, nullptr, token);
+        REQUIRE(results.has_value());
+        REQUIRE_FALSE(results.value()->Get<bool>(knowhere::meta::PARTIAL_RESULTS));
+
+        token->Cancel();
+        results = idx.Search(query_ds, json, nullptr, token);
+        REQUIRE(results.error() == knowhere::Status::cancelled);
+        auto range_results = idx.RangeSearch(query_ds, json, nullptr, token);
+        REQUIRE(range_results.error() == knowhere::Status::cancelled);
+
+        auto expired = std::make_shared<knowhere::CancellationToken>(std::chrono::milliseconds(0));
+        REQUIRE(expired->IsTimeout());
+        results = idx.Search(query_ds, json, nullptr, expired);
+        REQUIRE(results.error() == knowhere::Status::timeout);
+
+        // the queries stop before their first hop or list, with nothing found
+        json[knowhere::meta::PARTIAL_RESULTS] = true;
+        results = idx.Search(query_ds, json, nullptr, expired);
+        REQUIRE(results.has_value());
+        REQUIRE(results.value()->Get<bool>(knowhere::meta::PARTIAL_RESULTS));
+        auto gt_recall = GetKNNRecall(*gt.value(), *results.value());
+        REQUIRE(gt_recall < kKnnRecallThreshold);
+    }
+
     SECTION("Test Search with Bitset") {
         using std::make_tuple;
         auto [name, gen, threshold] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>, float>({
@@ -513,139 +815,553 @@ TEST_CASE("Test Mem Index With Float Vector", "[float metrics]") {
         REQUIRE(results.has_value());
     }
 
-    SECTION("Test IVFPQ with invalid params") {
-        auto idx = knowhere::IndexFactory::Instance()
-                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, version)
-                       .value();
-        uint32_t nb = 1000;
-        uint32_t dim = 128;
-        auto ivf_pq_gen = [=]() {
-            knowhere::Json json;
-            json[knowhere::meta::DIM] = dim;
-            json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
-            json[knowhere::meta::TOPK] = 10;
-            json[knowhere::indexparam::M] = 15;
-            json[knowhere::indexparam::NLIST] = 128;
-            json[knowhere::indexparam::NBITS] = 8;
-            return json;
-        };
-        auto train_ds = GenDataSet(nb, dim);
-        auto res = idx.Build(train_ds, ivf_pq_gen());
-        REQUIRE(res == knowhere::Status::invalid_args);
-    }
-
-    SECTION("Test IVFPQ with invalid params") {
-        auto idx = knowhere::IndexFactory::Instance()
-                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFSQ_CC, version)
-                       .value();
-        uint32_t nb = 1000;
-        uint32_t dim = 128;
-        auto ivf_pq_gen = [=]() {
-            knowhere::Json json;
-            json[knowhere::meta::DIM] = dim;
-            json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
-            json[knowhere::meta::TOPK] = 10;
-            json[knowhere::indexparam::NLIST] = 128;
-            json[knowhere::indexparam::CODE_SIZE] = 7;
-            return json;
-        };
-        auto train_ds = GenDataSet(nb, dim);
-        auto res = idx.Build(train_ds, ivf_pq_gen());
-        REQUIRE(res == knowhere::Status::invalid_value_in_json);
-    }
-}
-
-TEST_CASE("Test Mem Index With Binary Vector", "[float metrics]") {
-    using Catch::Approx;
-
-    const int64_t nb = 1000, nq = 10;
-    const int64_t dim = 1024;
-
-    auto metric = GENERATE(as<std::string>{}, knowhere::metric::HAMMING, knowhere::metric::JACCARD);
-    auto topk = GENERATE(as<int64_t>{}, 5, 120);
-    auto version = GenTestVersionList();
-    auto base_gen = [=]() {
-        knowhere::Json json;
-        json[knowhere::meta::DIM] = dim;
-        json[knowhere::meta::METRIC_TYPE] = metric;
-        json[knowhere::meta::TOPK] = topk;
-        json[knowhere::meta::RADIUS] = knowhere::IsMetricType(metric, knowhere::metric::HAMMING) ? 10.0 : 0.1;
-        json[knowhere::meta::RANGE_FILTER] = 0.0;
-        return json;
-    };
-
-    auto flat_gen = base_gen;
-    auto ivfflat_gen = [base_gen]() {
-        knowhere::Json json = base_gen();
-        json[knowhere::indexparam::NLIST] = 16;
-        json[knowhere::indexparam::NPROBE] = 14;
-        return json;
-    };
-
-    auto hnsw_gen = [base_gen]() {
-        knowhere::Json json = base_gen();
-        json[knowhere::indexparam::HNSW_M] = 128;
-        json[knowhere::indexparam::EFCONSTRUCTION] = 200;
-        json[knowhere::indexparam::EF] = 200;
-        return json;
-    };
-
-    const auto train_ds = GenBinDataSet(nb, dim);
-    const auto query_ds = GenBinDataSet(nq, dim);
-    const knowhere::Json conf = {
-        {knowhere::meta::METRIC_TYPE, metric},
-        {knowhere::meta::TOPK, topk},
-    };
-
-    auto gt = knowhere::BruteForce::Search<knowhere::bin1>(train_ds, query_ds, conf, nullptr);
-    SECTION("Test Search") {
+    SECTION("Test SerializeToFile") {
         using std::make_tuple;
-        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
-            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IDMAP, flat_gen),
-            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IVFFLAT, ivfflat_gen),
-#ifdef KNOWHERE_WITH_CARDINAL
-            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
-#endif
-        }));
-        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version).value();
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
         auto cfg_json = gen().dump();
         CAPTURE(name, cfg_json);
         knowhere::Json json = knowhere::Json::parse(cfg_json);
-        REQUIRE(idx.Type() == name);
         REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
-        REQUIRE(idx.Size() > 0);
-        REQUIRE(idx.Count() == nb);
-        auto results = idx.Search(query_ds, json, nullptr);
+
+        // the file holds the bytes Serialize() puts in the binary set
+        std::remove(kMmapIndexPath);
+        REQUIRE(idx.SerializeToFile(kMmapIndexPath) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto binary = bs.GetByName(idx.Type());
+        std::ifstream in(kMmapIndexPath, std::ios::binary);
+        std::vector<char> file_data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        REQUIRE(file_data.size() == binary->size);
+        REQUIRE(std::memcmp(file_data.data(), binary->data.get(), binary->size) == 0);
+
+        auto idx_ = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx_.DeserializeFromFile(kMmapIndexPath, json) == knowhere::Status::success);
+        auto results = idx_.Search(query_ds, json, nullptr);
+        auto expected = idx.Search(query_ds, json, nullptr);
         REQUIRE(results.has_value());
-        float recall = GetKNNRecall(*gt.value(), *results.value());
-        REQUIRE(recall > kKnnRecallThreshold);
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+        std::remove(kMmapIndexPath);
     }
 
-    SECTION("Test Range Search") {
+    SECTION("Test Calibrate") {
         using std::make_tuple;
-        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
-            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IDMAP, flat_gen),
-            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IVFFLAT, ivfflat_gen),
-        }));
-        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version).value();
-        auto cfg_json = gen().dump();
-        CAPTURE(name, cfg_json);
-        knowhere::Json json = knowhere::Json::parse(cfg_json);
-        REQUIRE(idx.Type() == name);
+        auto [name, gen, param] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>, std::string>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen, knowhere::indexparam::NPROBE),
+             make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen, knowhere::indexparam::EF)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name, json.dump());
         REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
-        auto results = idx.RangeSearch(query_ds, json, nullptr);
+        json.erase(param);
+        auto params = idx.Calibrate(query_ds, json, 0.95f);
+        REQUIRE(params.has_value());
+        REQUIRE(params.value().contains(param));
+        REQUIRE(idx.Calibrate(query_ds, json, 1.5f).error() == knowhere::Status::invalid_args);
+
+        // the searches that do not set the param use the calibrated value, also after a reload
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto idx_ = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx_.Deserialize(bs) == knowhere::Status::success);
+        knowhere::Json explicit_json = json;
+        explicit_json[param] = params.value()[param];
+        auto expected = idx.Search(query_ds, explicit_json, nullptr);
+        auto results = idx_.Search(query_ds, json, nullptr);
+        REQUIRE(expected.has_value());
         REQUIRE(results.has_value());
-        auto ids = results.value()->GetIds();
-        auto lims = results.value()->GetLims();
-        for (int i = 0; i < nq; ++i) {
-            CHECK(ids[lims[i]] == i);
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+        if (idx.HasRawData(metric)) {
+            REQUIRE(idx.Calibrate(nullptr, json, 0.95f).has_value());
         }
     }
 
-    SECTION("Test Serialize/Deserialize") {
+    SECTION("Test compiled search config") {
         using std::make_tuple;
-        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
-            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IDMAP, flat_gen),
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name, json.dump());
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto compiled = idx.CompileSearchConfig(json);
+        REQUIRE(compiled.has_value());
+        REQUIRE(compiled.value().IndexType() == name);
+
+        auto expected = idx.Search(query_ds, json, nullptr);
+        for (int i = 0; i < 2; i++) {
+            auto results = idx.Search(query_ds, compiled.value(), nullptr);
+            REQUIRE(results.has_value());
+            REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) ==
+                    0);
+        }
+
+        knowhere::Json invalid = json;
+        invalid[knowhere::meta::TOPK] = -1;
+        REQUIRE(idx.CompileSearchConfig(invalid).error() != knowhere::Status::success);
+        auto other = knowhere::IndexFactory::Instance()
+                         .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP, version)
+                         .value();
+        REQUIRE(other.Build(train_ds, base_gen()) == knowhere::Status::success);
+        REQUIRE(other.Search(query_ds, compiled.value(), nullptr).error() == knowhere::Status::invalid_args);
+    }
+
+    SECTION("Test WarmUp and CoolDown") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        std::remove(kMmapIndexPath);
+        REQUIRE(idx.SerializeToFile(kMmapIndexPath) == knowhere::Status::success);
+
+        auto idx_ = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx_.WarmUp() == knowhere::Status::success);
+        knowhere::Json load_json = json;
+        load_json["enable_mmap"] = true;
+        REQUIRE(idx_.DeserializeFromFile(kMmapIndexPath, load_json) == knowhere::Status::success);
+        auto regions = idx_.Node()->MappedRegions();
+        REQUIRE(!regions.empty());
+        if (name == knowhere::IndexEnum::INDEX_HNSW) {
+            // the graph is warmed up before the codes
+            REQUIRE(std::any_of(regions.begin(), regions.end(), [](const auto& r) { return r.structure; }));
+        }
+        REQUIRE(idx_.WarmUp(knowhere::WarmUpLevel::STRUCTURE) == knowhere::Status::success);
+        REQUIRE(idx_.WarmUpAsync().get() == knowhere::Status::success);
+        REQUIRE(idx_.CoolDown() == knowhere::Status::success);
+
+        // the pages dropped by CoolDown() are read from the file again
+        auto results = idx_.Search(query_ds, json, nullptr);
+        auto expected = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+        std::remove(kMmapIndexPath);
+    }
+
+    SECTION("Test huge pages") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+
+        auto idx_ = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json load_json = json;
+        load_json["use_huge_pages"] = true;
+        REQUIRE(idx_.Deserialize(bs, load_json) == knowhere::Status::success);
+        // the buffer is rounded up to whole huge pages
+        REQUIRE(idx_.Size() >= idx.Size());
+        REQUIRE(idx_.Size() < idx.Size() + (int64_t)knowhere::kGiantPageSize);
+
+        auto results = idx_.Search(query_ds, json, nullptr);
+        auto expected = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+    }
+
+    SECTION("Test SearchWithBuf") {
+        using std::make_tuple;
+        // flat has no SearchWithBuf of its own, its results are copied
+        auto [name, gen, in_place] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>, bool>(
+            {make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen, true),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen, true),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IDMAP, flat_gen, false)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        knowhere::Json json = gen();
+        CAPTURE(name);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto expected = idx.Search(query_ds, json, nullptr);
+        REQUIRE(expected.has_value());
+
+        // the results of the segment go to the second slice of a merge buffer
+        std::vector<int64_t> ids(3 * nq * topk, -2);
+        std::vector<float> dis(3 * nq * topk, -2.0f);
+        {
+            auto res = idx.SearchWithBuf(query_ds, json, nullptr, ids.data() + nq * topk, dis.data() + nq * topk);
+            REQUIRE(res.has_value());
+            REQUIRE((res.value()->GetIds() == ids.data() + nq * topk) == in_place);
+        }
+        REQUIRE(std::memcmp(ids.data() + nq * topk, expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+        REQUIRE(std::memcmp(dis.data() + nq * topk, expected.value()->GetDistance(), nq * topk * sizeof(float)) == 0);
+        REQUIRE(ids[nq * topk - 1] == -2);
+        REQUIRE(ids[2 * nq * topk] == -2);
+        // the buffers stay with the caller once the DataSet is gone
+        REQUIRE(ids[nq * topk] == expected.value()->GetIds()[0]);
+    }
+
+    SECTION("Test IVF scalar partition") {
+        auto json = ivfflat_gen();
+        auto partitioned_ds = GenDataSet(nb, dim);
+        auto scalar_info = GenerateScalarInfo(nb);
+        partitioned_ds->Set(knowhere::meta::SCALAR_INFO, scalar_info);
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, version)
+                       .value();
+        REQUIRE(idx.IsAdditionalScalarSupported(true));
+        REQUIRE(idx.Build(partitioned_ds, json) == knowhere::Status::success);
+        auto plain = knowhere::IndexFactory::Instance()
+                         .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, version)
+                         .value();
+        REQUIRE(plain.Build(train_ds, json) == knowhere::Status::success);
+
+        // the rows of the first category and a part of the second one are filtered out
+        auto bitset_data = GenerateBitsetByScalarInfoAndFirstTBits(scalar_info[0][0], nb, nb / 4);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto expected = plain.Search(query_ds, json, bitset);
+        REQUIRE(expected.has_value());
+        auto check = [&](const knowhere::Index<knowhere::IndexNode>& index) {
+            auto results = index.Search(query_ds, json, bitset);
+            REQUIRE(results.has_value());
+            auto ids = results.value()->GetIds();
+            REQUIRE(std::memcmp(ids, expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+            for (int64_t i = 0; i < nq * topk; i++) {
+                REQUIRE((ids[i] == -1 || !bitset.test(ids[i])));
+            }
+        };
+        check(idx);
+
+        // the partition is kept by the serialization
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        REQUIRE(bs.GetByName("IVF_SCALAR_PARTITION") != nullptr);
+        auto idx_ = knowhere::IndexFactory::Instance()
+                        .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, version)
+                        .value();
+        REQUIRE(idx_.Deserialize(bs, json) == knowhere::Status::success);
+        check(idx_);
+    }
+
+    SECTION("Test IVF balanced_kmeans") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, ivfflat_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen)}));
+        auto json = gen();
+        json[knowhere::indexparam::BALANCED_KMEANS] = true;
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) > kKnnRecallThreshold);
+    }
+
+    SECTION("Test IVF gpu_train") {
+        // the rows are too few to leave the CPU, the options must not change the index
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, ivfpq_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, ivfsq_gen)}));
+        auto json = gen();
+        // the GPU quantizer searches like a plain IndexFlat
+        json[knowhere::indexparam::USE_ELKAN] = false;
+        auto plain = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(plain.Build(train_ds, json) == knowhere::Status::success);
+        json[knowhere::indexparam::GPU_TRAIN] = true;
+        json[knowhere::indexparam::GPU_ASSIGN] = true;
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto expected = plain.Search(query_ds, json, nullptr);
+        auto results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(expected.has_value());
+        REQUIRE(results.has_value());
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+    }
+
+    SECTION("Test HNSW_SQ with a base graph") {
+        // a knn graph stands in for a CAGRA one
+        const int64_t degree = 32;
+        knowhere::Json graph_conf = conf;
+        graph_conf[knowhere::meta::TOPK] = degree;
+        auto knn = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, train_ds, graph_conf, nullptr);
+        REQUIRE(knn.has_value());
+        const auto* knn_ids = knn.value()->GetIds();
+        auto graph = std::make_shared<std::vector<uint32_t>>(knn_ids, knn_ids + nb * degree);
+        auto base_ds = GenDataSet(nb, dim);
+        base_ds->Set(knowhere::meta::BASE_GRAPH, std::shared_ptr<const std::vector<uint32_t>>(graph));
+
+        auto json = hnsw_gen();
+        json[knowhere::indexparam::HNSW_M] = degree / 2;
+        json[knowhere::indexparam::SQ_TYPE] = "SQ8";
+        json[knowhere::indexparam::HNSW_REFINE] = true;
+        json[knowhere::indexparam::HNSW_REFINE_TYPE] = "FP16";
+        const auto name = knowhere::IndexEnum::INDEX_HNSW_SQ;
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(base_ds, json) == knowhere::Status::success);
+        REQUIRE(idx.Count() == nb);
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(loaded.Deserialize(bs, json) == knowhere::Status::success);
+        auto results = loaded.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= kKnnRecallThreshold);
+    }
+
+    SECTION("Test DeserializeAll") {
+        auto hnsw_json = hnsw_gen();
+        auto ivf_json = ivfflat_gen();
+        std::vector<knowhere::Index<knowhere::IndexNode>> built;
+        std::vector<knowhere::BinarySet> binsets;
+        std::vector<knowhere::Json> jsons;
+        for (int i = 0; i < 4; i++) {
+            const bool is_hnsw = i % 2 == 0;
+            auto idx = knowhere::IndexFactory::Instance()
+                           .Create<knowhere::fp32>(
+                               is_hnsw ? knowhere::IndexEnum::INDEX_HNSW : knowhere::IndexEnum::INDEX_FAISS_IVFFLAT,
+                               version)
+                           .value();
+            REQUIRE(idx.Build(train_ds, is_hnsw ? hnsw_json : ivf_json) == knowhere::Status::success);
+            knowhere::BinarySet bs;
+            REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+            built.push_back(idx);
+            binsets.push_back(bs);
+            jsons.push_back(is_hnsw ? hnsw_json : ivf_json);
+        }
+
+        std::vector<knowhere::Index<knowhere::IndexNode>> loaded;
+        for (const auto& idx : built) {
+            loaded.push_back(knowhere::IndexFactory::Instance().Create<knowhere::fp32>(idx.Type(), version).value());
+        }
+        auto statuses = knowhere::Index<knowhere::IndexNode>::DeserializeAll(loaded, binsets, jsons);
+        REQUIRE(statuses.size() == loaded.size());
+        for (size_t i = 0; i < loaded.size(); i++) {
+            REQUIRE(statuses[i] == knowhere::Status::success);
+            auto results = loaded[i].Search(query_ds, jsons[i], nullptr);
+            auto expected = built[i].Search(query_ds, jsons[i], nullptr);
+            REQUIRE(results.has_value());
+            REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(),
+                                nq * topk * sizeof(int64_t)) == 0);
+        }
+
+        // a count of configs that matches neither one nor the indexes is rejected for every index
+        jsons.pop_back();
+        statuses = knowhere::Index<knowhere::IndexNode>::DeserializeAll(loaded, binsets, jsons);
+        for (const auto& status : statuses) {
+            REQUIRE(status == knowhere::Status::invalid_args);
+        }
+    }
+
+    SECTION("Test lazy loading of raw data") {
+        auto hnsw_sq_refine_gen = [hnsw_gen]() {
+            knowhere::Json json = hnsw_gen();
+            json[knowhere::indexparam::SQ_TYPE] = "SQ8";
+            json[knowhere::indexparam::HNSW_REFINE] = true;
+            json[knowhere::indexparam::HNSW_REFINE_TYPE] = "FLAT";
+            return json;
+        };
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>(
+            {make_tuple(knowhere::IndexEnum::INDEX_HNSW_SQ, hnsw_sq_refine_gen),
+             make_tuple(knowhere::IndexEnum::INDEX_FAISS_SCANN, scann_gen)}));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        std::remove(kMmapIndexPath);
+        REQUIRE(idx.SerializeToFile(kMmapIndexPath) == knowhere::Status::success);
+
+        // the raw data stays mapped, search and GetVectorByIds() give what the index that was built gives
+        knowhere::Json load_json = json;
+        load_json["lazy_load_raw_data"] = true;
+        auto idx_ = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx_.DeserializeFromFile(kMmapIndexPath, load_json) == knowhere::Status::success);
+        auto results = idx_.Search(query_ds, json, nullptr);
+        auto expected = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+
+        auto ids_ds = GenIdsDataSet(nb, nq);
+        auto vectors = idx_.GetVectorByIds(ids_ds);
+        auto expected_vectors = idx.GetVectorByIds(ids_ds);
+        REQUIRE(vectors.has_value());
+        REQUIRE(std::memcmp(vectors.value()->GetTensor(), expected_vectors.value()->GetTensor(),
+                            nq * dim * sizeof(float)) == 0);
+        std::remove(kMmapIndexPath);
+    }
+
+    SECTION("Test refine on disk") {
+        auto refine_type = GENERATE(as<std::string>{}, "FLAT", "FP16");
+        auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+        knowhere::Json json = hnsw_gen();
+        json[knowhere::meta::METRIC_TYPE] = metric;
+        json[knowhere::indexparam::SQ_TYPE] = "SQ8";
+        json[knowhere::indexparam::HNSW_REFINE] = true;
+        json[knowhere::indexparam::HNSW_REFINE_TYPE] = refine_type;
+        json[knowhere::indexparam::HNSW_REFINE_K] = 4;
+        CAPTURE(refine_type, metric);
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_SQ, version)
+                       .value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        std::remove(kMmapIndexPath);
+        REQUIRE(idx.SerializeToFile(kMmapIndexPath) == knowhere::Status::success);
+
+        // the candidates are refined with the codes read from the file, as the index that was built refines them
+        knowhere::Json load_json = json;
+        load_json["refine_on_disk"] = true;
+        auto idx_ = knowhere::IndexFactory::Instance()
+                        .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_HNSW_SQ, version)
+                        .value();
+        REQUIRE(idx_.DeserializeFromFile(kMmapIndexPath, load_json) == knowhere::Status::success);
+        auto results = idx_.Search(query_ds, json, nullptr);
+        auto expected = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        REQUIRE(std::memcmp(results.value()->GetIds(), expected.value()->GetIds(), nq * topk * sizeof(int64_t)) == 0);
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(results.value()->GetDistance()[i] == Catch::Approx(expected.value()->GetDistance()[i]));
+        }
+        std::remove(kMmapIndexPath);
+    }
+
+    SECTION("Test IVFPQ with invalid params") {
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFPQ, version)
+                       .value();
+        uint32_t nb = 1000;
+        uint32_t dim = 128;
+        auto ivf_pq_gen = [=]() {
+            knowhere::Json json;
+            json[knowhere::meta::DIM] = dim;
+            json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+            json[knowhere::meta::TOPK] = 10;
+            json[knowhere::indexparam::M] = 15;
+            json[knowhere::indexparam::NLIST] = 128;
+            json[knowhere::indexparam::NBITS] = 8;
+            return json;
+        };
+        auto train_ds = GenDataSet(nb, dim);
+        auto res = idx.Build(train_ds, ivf_pq_gen());
+        REQUIRE(res == knowhere::Status::invalid_args);
+    }
+
+    SECTION("Test IVFPQ with invalid params") {
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFSQ_CC, version)
+                       .value();
+        uint32_t nb = 1000;
+        uint32_t dim = 128;
+        auto ivf_pq_gen = [=]() {
+            knowhere::Json json;
+            json[knowhere::meta::DIM] = dim;
+            json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+            json[knowhere::meta::TOPK] = 10;
+            json[knowhere::indexparam::NLIST] = 128;
+            json[knowhere::indexparam::CODE_SIZE] = 7;
+            return json;
+        };
+        auto train_ds = GenDataSet(nb, dim);
+        auto res = idx.Build(train_ds, ivf_pq_gen());
+        REQUIRE(res == knowhere::Status::invalid_value_in_json);
+    }
+}
+
+TEST_CASE("Test Mem Index With Binary Vector", "[float metrics]") {
+    using Catch::Approx;
+
+    const int64_t nb = 1000, nq = 10;
+    const int64_t dim = 1024;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::HAMMING, knowhere::metric::JACCARD);
+    auto topk = GENERATE(as<int64_t>{}, 5, 120);
+    auto version = GenTestVersionList();
+    auto base_gen = [=]() {
+        knowhere::Json json;
+        json[knowhere::meta::DIM] = dim;
+        json[knowhere::meta::METRIC_TYPE] = metric;
+        json[knowhere::meta::TOPK] = topk;
+        json[knowhere::meta::RADIUS] = knowhere::IsMetricType(metric, knowhere::metric::HAMMING) ? 10.0 : 0.1;
+        json[knowhere::meta::RANGE_FILTER] = 0.0;
+        return json;
+    };
+
+    auto flat_gen = base_gen;
+    auto ivfflat_gen = [base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::NLIST] = 16;
+        json[knowhere::indexparam::NPROBE] = 14;
+        return json;
+    };
+
+    auto hnsw_gen = [base_gen]() {
+        knowhere::Json json = base_gen();
+        json[knowhere::indexparam::HNSW_M] = 128;
+        json[knowhere::indexparam::EFCONSTRUCTION] = 200;
+        json[knowhere::indexparam::EF] = 200;
+        return json;
+    };
+
+    const auto train_ds = GenBinDataSet(nb, dim);
+    const auto query_ds = GenBinDataSet(nq, dim);
+    const knowhere::Json conf = {
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+    };
+
+    auto gt = knowhere::BruteForce::Search<knowhere::bin1>(train_ds, query_ds, conf, nullptr);
+    SECTION("Test Search") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IDMAP, flat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IVFFLAT, ivfflat_gen),
+#ifdef KNOWHERE_WITH_CARDINAL
+            make_tuple(knowhere::IndexEnum::INDEX_HNSW, hnsw_gen),
+#endif
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version).value();
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Type() == name);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        REQUIRE(idx.Size() > 0);
+        REQUIRE(idx.Count() == nb);
+        auto results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        float recall = GetKNNRecall(*gt.value(), *results.value());
+        REQUIRE(recall > kKnnRecallThreshold);
+    }
+
+    SECTION("Test Range Search") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IDMAP, flat_gen),
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IVFFLAT, ivfflat_gen),
+        }));
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version).value();
+        auto cfg_json = gen().dump();
+        CAPTURE(name, cfg_json);
+        knowhere::Json json = knowhere::Json::parse(cfg_json);
+        REQUIRE(idx.Type() == name);
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        auto results = idx.RangeSearch(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        auto ids = results.value()->GetIds();
+        auto lims = results.value()->GetLims();
+        for (int i = 0; i < nq; ++i) {
+            CHECK(ids[lims[i]] == i);
+        }
+    }
+
+    SECTION("Test Serialize/Deserialize") {
+        using std::make_tuple;
+        auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
+            make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IDMAP, flat_gen),
             make_tuple(knowhere::IndexEnum::INDEX_FAISS_BIN_IVFFLAT, ivfflat_gen),
         }));
 
@@ -834,3 +1550,1268 @@ TEST_CASE("Test Mem Index With Binary Vector", "[bool metrics]") {
     }
 #endif
 }
+
+template <typename T>
+void
+check_flat_native_storage(const knowhere::DataSetPtr train_ds, const knowhere::DataSetPtr query_ds,
+                          const knowhere::Json& json) {
+    using Catch::Approx;
+
+    auto version = GenTestVersionList();
+    auto base = knowhere::ConvertToDataTypeIfNeeded<T>(train_ds);
+    auto query = knowhere::ConvertToDataTypeIfNeeded<T>(query_ds);
+    const auto nb = base->GetRows(), nq = query->GetRows(), dim = base->GetDim();
+    const int64_t k = json[knowhere::meta::TOPK];
+    auto ids_ds = GenIdsDataSet(nb, nq);
+
+    auto check_index = [&](const knowhere::Index<knowhere::IndexNode>& idx) {
+        REQUIRE(idx.Size() >= nb * dim * static_cast<int64_t>(sizeof(T)));
+        REQUIRE(idx.Size() < nb * dim * static_cast<int64_t>(sizeof(float)));
+        auto res = idx.Search(query, json, nullptr);
+        REQUIRE(res.has_value());
+        auto gt = knowhere::BruteForce::Search<T>(base, query, json, nullptr);
+        REQUIRE(gt.has_value());
+        auto gt_dist = gt.value()->GetDistance();
+        for (int64_t i = 0; i < nq * k; i++) {
+            REQUIRE(res.value()->GetDistance()[i] == Approx(gt_dist[i]));
+            // rows at the same distance may come in any order
+            bool tie = (i % k > 0 && gt_dist[i - 1] == gt_dist[i]) || (i % k < k - 1 && gt_dist[i + 1] == gt_dist[i]);
+            if (!tie) {
+                REQUIRE(res.value()->GetIds()[i] == gt.value()->GetIds()[i]);
+            }
+        }
+        auto vectors = idx.GetVectorByIds(ids_ds);
+        REQUIRE(vectors.has_value());
+        auto xb = static_cast<const T*>(base->GetTensor());
+        auto data = static_cast<const T*>(vectors.value()->GetTensor());
+        for (int64_t i = 0; i < nq; i++) {
+            REQUIRE(std::memcmp(data + i * dim, xb + ids_ds->GetIds()[i] * dim, dim * sizeof(T)) == 0);
+        }
+    };
+
+    auto idx = knowhere::IndexFactory::Instance().Create<T>(knowhere::IndexEnum::INDEX_FAISS_IDMAP, version).value();
+    REQUIRE(idx.Build(base, json) == knowhere::Status::success);
+    check_index(idx);
+
+    knowhere::BinarySet bs;
+    REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+    auto binary = bs.GetByName(idx.Type());
+    std::remove(kMmapIndexPath);
+    std::ofstream out(kMmapIndexPath, std::ios::binary);
+    out.write((const char*)binary->data.get(), binary->size);
+    out.close();
+    auto mmap_json = json;
+    mmap_json["enable_mmap"] = true;
+    auto mmap_idx =
+        knowhere::IndexFactory::Instance().Create<T>(knowhere::IndexEnum::INDEX_FAISS_IDMAP, version).value();
+    REQUIRE(mmap_idx.DeserializeFromFile(kMmapIndexPath, mmap_json) == knowhere::Status::success);
+    check_index(mmap_idx);
+    std::remove(kMmapIndexPath);
+
+    // the binaries of the fp32 FLAT that the rows used to be converted to
+    auto fp32_idx =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP, version);
+    REQUIRE(fp32_idx.value().Build(knowhere::ConvertFromDataTypeIfNeeded<T>(base), json) == knowhere::Status::success);
+    knowhere::BinarySet fp32_bs;
+    REQUIRE(fp32_idx.value().Serialize(fp32_bs) == knowhere::Status::success);
+    auto legacy_idx =
+        knowhere::IndexFactory::Instance().Create<T>(knowhere::IndexEnum::INDEX_FAISS_IDMAP, version).value();
+    REQUIRE(legacy_idx.Deserialize(fp32_bs, json) == knowhere::Status::success);
+    check_index(legacy_idx);
+}
+
+TEST_CASE("Test FLAT with fp16, bf16 and int8 vectors", "[float metrics]") {
+    const int64_t nb = 1000, nq = 10;
+    const int64_t dim = 128;
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    const knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, 10},
+    };
+
+    check_flat_native_storage<knowhere::fp16>(train_ds, query_ds, json);
+    check_flat_native_storage<knowhere::bf16>(train_ds, query_ds, json);
+    check_flat_native_storage<knowhere::int8>(train_ds, query_ds, json);
+}
+
+TEST_CASE("Test BQ_FLAT", "[float metrics]") {
+    const int64_t nb = 2000, nq = 10;
+    const int64_t dim = 128;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+
+    // the sign bits of all-positive rows are the same
+    auto gen_centered = [dim](int64_t rows, int seed) {
+        auto ds = GenDataSet(rows, dim, seed);
+        auto x = const_cast<float*>(static_cast<const float*>(ds->GetTensor()));
+        for (int64_t i = 0; i < rows * dim; i++) {
+            x[i] -= 50.0f;
+        }
+        return ds;
+    };
+    const auto train_ds = gen_centered(nb, 42);
+    const auto query_ds = gen_centered(nq, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, 10},
+        {knowhere::indexparam::REFINE_TYPE, "fp32"},
+        {knowhere::indexparam::REFINE_K, 20},
+    };
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto idx = knowhere::IndexFactory::Instance()
+                   .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_BQ_FLAT, version)
+                   .value();
+    REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(idx.Count() == nb);
+    // a bit per dimension beyond the rows of the refine
+    REQUIRE(idx.Size() == nb * dim * static_cast<int64_t>(sizeof(float)) + nb * dim / 8);
+    REQUIRE(idx.HasRawData(metric) == (metric != knowhere::metric::COSINE));
+
+    knowhere::BinarySet bs;
+    REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance()
+                      .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_BQ_FLAT, version)
+                      .value();
+    REQUIRE(loaded.Deserialize(bs, json) == knowhere::Status::success);
+
+    auto res = loaded.Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= 0.7f);
+
+    // the bitset filters the rows before the hamming scan
+    std::vector<uint8_t> bitset_data(nb / 8, 0xFF);
+    bitset_data[0] = 0xFE;
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+    auto filtered = loaded.Search(query_ds, json, bitset);
+    REQUIRE(filtered.has_value());
+    for (int64_t i = 0; i < nq; i++) {
+        REQUIRE(filtered.value()->GetIds()[i * 10] == 0);
+    }
+
+    // the sq refines keep the rows at a lower precision
+    json[knowhere::indexparam::REFINE_TYPE] = "sq8";
+    auto sq_idx = knowhere::IndexFactory::Instance()
+                      .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_BQ_FLAT, version)
+                      .value();
+    REQUIRE(sq_idx.Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(!sq_idx.HasRawData(metric));
+    auto sq_res = sq_idx.Search(query_ds, json, nullptr);
+    REQUIRE(sq_res.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *sq_res.value()) >= 0.7f);
+}
+
+TEST_CASE("Test IVF_RABITQ with extended codes", "[float metrics]") {
+    const int64_t nb = 2000, nq = 10;
+    const int64_t dim = 128;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NLIST, 16},
+        {knowhere::indexparam::NPROBE, 16},
+    };
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto build = [&](int32_t bits_data) {
+        json[knowhere::indexparam::RABITQ_DATA_BITS] = bits_data;
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFRABITQ, version)
+                       .value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        return idx;
+    };
+
+    auto idx_1bit = build(1);
+    auto res_1bit = idx_1bit.Search(query_ds, json, nullptr);
+    REQUIRE(res_1bit.has_value());
+
+    auto idx = build(5);
+    REQUIRE(idx.Size() > idx_1bit.Size());
+    auto res = idx.Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    const float recall = GetKNNRecall(*gt.value(), *res.value());
+    REQUIRE(recall >= 0.85f);
+    REQUIRE(recall >= GetKNNRecall(*gt.value(), *res_1bit.value()));
+
+    // the bits per dimension are restored from the code size
+    knowhere::BinarySet bs;
+    REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance()
+                      .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFRABITQ, version)
+                      .value();
+    REQUIRE(loaded.Deserialize(bs, json) == knowhere::Status::success);
+    auto loaded_res = loaded.Search(query_ds, json, nullptr);
+    REQUIRE(loaded_res.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(loaded_res.value()->GetIds()[i] == res.value()->GetIds()[i]);
+    }
+}
+
+TEST_CASE("Test IVF_SQ8 with interleaved codes", "[float metrics]") {
+    const int64_t nb = 2000, nq = 10;
+    const int64_t dim = 100;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto interleave = GENERATE(as<int32_t>{}, 16, 32);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NLIST, 16},
+        {knowhere::indexparam::NPROBE, 4},
+    };
+
+    auto build = [&](int32_t sq_interleave) {
+        json[knowhere::indexparam::SQ_INTERLEAVE] = sq_interleave;
+        auto idx =
+            knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, version);
+        REQUIRE(idx.has_value());
+        REQUIRE(idx.value().Build(train_ds, json) == knowhere::Status::success);
+        return idx.value();
+    };
+    auto row_major = build(0);
+    auto idx = build(interleave);
+    REQUIRE(idx.Size() >= row_major.Size());
+
+    // the same codes are scored, only the order of the additions differs
+    auto require_same = [&](const knowhere::DataSetPtr& expected, const knowhere::DataSetPtr& actual) {
+        for (int64_t i = 0; i < nq * topk; i++) {
+            const float dis = expected->GetDistance()[i];
+            REQUIRE(std::abs(actual->GetDistance()[i] - dis) <= 1e-3f * std::max(1.0f, std::abs(dis)));
+        }
+    };
+
+    // the selective bitset gathers the valid vectors of the lists
+    const auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb * 19 / 20);
+    for (const knowhere::BitsetView bitset : {knowhere::BitsetView(), knowhere::BitsetView(bitset_data.data(), nb)}) {
+        auto expected = row_major.Search(query_ds, json, bitset);
+        auto res = idx.Search(query_ds, json, bitset);
+        REQUIRE(expected.has_value());
+        REQUIRE(res.has_value());
+        require_same(expected.value(), res.value());
+    }
+
+    knowhere::BinarySet bs;
+    REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+    auto loaded =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, version);
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded.value().Deserialize(bs, json) == knowhere::Status::success);
+    auto expected = row_major.Search(query_ds, json, nullptr);
+    auto loaded_res = loaded.value().Search(query_ds, json, nullptr);
+    REQUIRE(loaded_res.has_value());
+    require_same(expected.value(), loaded_res.value());
+
+    json[knowhere::indexparam::SQ_INTERLEAVE] = 8;
+    auto invalid =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, version);
+    REQUIRE(invalid.value().Build(train_ds, json) == knowhere::Status::invalid_args);
+}
+
+#ifdef KNOWHERE_WITH_DISKANN
+TEST_CASE("Test VAMANA indexes", "[float metrics]") {
+    const int64_t nb = 2000, nq = 10;
+    const int64_t dim = 64;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_VAMANA, knowhere::IndexEnum::INDEX_VAMANA_SQ,
+                         knowhere::IndexEnum::INDEX_VAMANA_PQ);
+    CAPTURE(metric, name);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::MAX_DEGREE, 32},
+        {knowhere::indexparam::SEARCH_LIST_SIZE, 64},
+        {knowhere::indexparam::VAMANA_ALPHA, 1.2},
+        {knowhere::indexparam::EF, 64},
+    };
+    if (name == knowhere::IndexEnum::INDEX_VAMANA_PQ) {
+        json[knowhere::indexparam::M] = 16;
+        json[knowhere::indexparam::NBITS] = 8;
+    }
+    if (name != knowhere::IndexEnum::INDEX_VAMANA) {
+        json[knowhere::indexparam::HNSW_REFINE] = true;
+        json[knowhere::indexparam::HNSW_REFINE_TYPE] = "fp32";
+        json[knowhere::indexparam::HNSW_REFINE_K] = 4;
+    }
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(idx.has_value());
+    REQUIRE(idx.value().Type() == name);
+    REQUIRE(idx.value().Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(idx.value().Count() == nb);
+    auto res = idx.value().Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= 0.9f);
+
+    // the graph is searched from a file mapped into memory as well
+    knowhere::BinarySet bs;
+    REQUIRE(idx.value().Serialize(bs) == knowhere::Status::success);
+    auto binary = bs.GetByName(name);
+    REQUIRE(binary != nullptr);
+    std::remove(kMmapIndexPath);
+    {
+        std::ofstream out(kMmapIndexPath, std::ios::binary);
+        out.write((const char*)binary->data.get(), binary->size);
+    }
+    auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    json["enable_mmap"] = true;
+    REQUIRE(loaded.value().DeserializeFromFile(kMmapIndexPath, json) == knowhere::Status::success);
+    auto loaded_res = loaded.value().Search(query_ds, json, nullptr);
+    REQUIRE(loaded_res.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(loaded_res.value()->GetIds()[i] == res.value()->GetIds()[i]);
+    }
+    std::remove(kMmapIndexPath);
+}
+#endif
+
+TEST_CASE("Test NNDESCENT indexes", "[float metrics]") {
+    // large enough for the graph to be built by nn-descent rather than an exact knn
+    const int64_t nb = 5000, nq = 10;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_NNDESCENT,
+                         knowhere::IndexEnum::INDEX_NNDESCENT_SQ, knowhere::IndexEnum::INDEX_NNDESCENT_PQ);
+    auto pruning = GENERATE(as<std::string>{}, "none", "nsg", "rng");
+    CAPTURE(metric, name, pruning);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NNDESCENT_K, 32},
+        {knowhere::indexparam::NNDESCENT_ITER, 10},
+        {knowhere::indexparam::GRAPH_PRUNING, pruning},
+        {knowhere::indexparam::MAX_DEGREE, 24},
+        {knowhere::indexparam::EF, 64},
+    };
+    if (name == knowhere::IndexEnum::INDEX_NNDESCENT_PQ) {
+        json[knowhere::indexparam::M] = 8;
+        json[knowhere::indexparam::NBITS] = 8;
+    }
+    if (name != knowhere::IndexEnum::INDEX_NNDESCENT) {
+        json[knowhere::indexparam::HNSW_REFINE] = true;
+        json[knowhere::indexparam::HNSW_REFINE_TYPE] = "fp32";
+        json[knowhere::indexparam::HNSW_REFINE_K] = 4;
+    }
+    auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(idx.has_value());
+    REQUIRE(idx.value().Type() == name);
+    REQUIRE(idx.value().Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(idx.value().Count() == nb);
+    auto res = idx.value().Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= 0.85f);
+
+    knowhere::BinarySet bs;
+    REQUIRE(idx.value().Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(loaded.value().Deserialize(bs, json) == knowhere::Status::success);
+    auto loaded_res = loaded.value().Search(query_ds, json, nullptr);
+    REQUIRE(loaded_res.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(loaded_res.value()->GetIds()[i] == res.value()->GetIds()[i]);
+    }
+
+    json[knowhere::indexparam::GRAPH_PRUNING] = "mst";
+    auto invalid = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(invalid.value().Build(train_ds, json) == knowhere::Status::invalid_args);
+}
+
+TEST_CASE("Test IVF indexes merge", "[float metrics]") {
+    const int64_t nb = 2000, nq = 10;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_FAISS_IVFFLAT,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, knowhere::IndexEnum::INDEX_FAISS_IVFPQ,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFSQ8, knowhere::IndexEnum::INDEX_FAISS_IVFSQ_CC);
+    CAPTURE(metric, name);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NLIST, 16},
+        {knowhere::indexparam::NPROBE, 4},
+        {knowhere::indexparam::M, 8},
+        {knowhere::indexparam::NBITS, 8},
+        {knowhere::indexparam::SSIZE, 48},
+    };
+
+    // the segments share the centroids of a trained index
+    const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+    auto first_ds = knowhere::GenDataSet(nb / 2, dim, data);
+    auto second_ds = knowhere::GenDataSet(nb - nb / 2, dim, data + (nb / 2) * dim);
+    auto trained = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(trained.Train(train_ds, json) == knowhere::Status::success);
+    knowhere::BinarySet bs;
+    REQUIRE(trained.Serialize(bs) == knowhere::Status::success);
+    auto segment = [&](const knowhere::DataSetPtr& ds) {
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Deserialize(bs, json) == knowhere::Status::success);
+        REQUIRE(idx.Add(ds, json) == knowhere::Status::success);
+        return idx;
+    };
+    auto full = segment(train_ds);
+    auto index = segment(first_ds);
+    auto other = segment(second_ds);
+
+    REQUIRE(index.Merge({other}, json) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+    REQUIRE(other.Count() == nb - nb / 2);
+
+    // the lists hold the same codes in the same order as the ones of the index over all the rows
+    auto expected = full.Search(query_ds, json, nullptr);
+    auto res = index.Search(query_ds, json, nullptr);
+    REQUIRE(expected.has_value());
+    REQUIRE(res.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(res.value()->GetIds()[i] == expected.value()->GetIds()[i]);
+    }
+
+    // an index trained on its own has other centroids
+    auto unrelated = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(unrelated.Build(second_ds, json) == knowhere::Status::success);
+    REQUIRE(index.Merge({unrelated}, json) == knowhere::Status::invalid_args);
+    REQUIRE(index.Count() == nb);
+}
+
+TEST_CASE("Test IVF segments sharing a quantizer", "[float metrics]") {
+    const int64_t nb = 3000, nq = 10;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_FAISS_IVFFLAT,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, knowhere::IndexEnum::INDEX_FAISS_IVFPQ,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFSQ8);
+    CAPTURE(metric, name);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NLIST, 16},
+        {knowhere::indexparam::NPROBE, 4},
+        {knowhere::indexparam::M, 8},
+        {knowhere::indexparam::NBITS, 8},
+    };
+
+    // three segments loaded from one trained index, and one trained on its own
+    const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+    auto trained = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(trained.Train(train_ds, json) == knowhere::Status::success);
+    knowhere::BinarySet bs;
+    REQUIRE(trained.Serialize(bs) == knowhere::Status::success);
+    const int64_t rows = nb / 3;
+    std::vector<knowhere::Index<knowhere::IndexNode>> segments;
+    for (int64_t s = 0; s < 3; s++) {
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Deserialize(bs, json) == knowhere::Status::success);
+        REQUIRE(idx.Add(knowhere::GenDataSet(rows, dim, data + s * rows * dim), json) == knowhere::Status::success);
+        segments.push_back(idx);
+    }
+    auto unrelated = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(unrelated.Build(knowhere::GenDataSet(rows, dim, data), json) == knowhere::Status::success);
+    segments.push_back(unrelated);
+
+    const void* quantizer = segments[0].Node()->SharedCoarseQuantizer();
+    REQUIRE(quantizer != nullptr);
+    REQUIRE(segments[1].Node()->SharedCoarseQuantizer() == quantizer);
+    REQUIRE(segments[2].Node()->SharedCoarseQuantizer() == quantizer);
+    REQUIRE(segments[3].Node()->SharedCoarseQuantizer() == nullptr);
+
+    // the results are the ones of the searches of each segment, with a filter on one of them
+    std::vector<uint8_t> bitset_data = GenerateBitsetWithFirstTbitsSet(rows, rows / 2);
+    const std::vector<knowhere::BitsetView> bitsets = {nullptr, knowhere::BitsetView(bitset_data.data(), rows),
+                                                       nullptr, nullptr};
+    auto results = knowhere::Index<knowhere::IndexNode>::SearchSegments(segments, query_ds, json, bitsets);
+    REQUIRE(results.size() == segments.size());
+    for (size_t s = 0; s < segments.size(); s++) {
+        auto expected = segments[s].Search(query_ds, json, bitsets[s]);
+        REQUIRE(expected.has_value());
+        REQUIRE(results[s].has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(results[s].value()->GetIds()[i] == expected.value()->GetIds()[i]);
+            REQUIRE(results[s].value()->GetDistance()[i] == Catch::Approx(expected.value()->GetDistance()[i]));
+        }
+    }
+
+    // probes computed with another nprobe are searched again
+    knowhere::Json probe_json = json;
+    probe_json[knowhere::indexparam::NPROBE] = 1;
+    auto cfg = segments[0].Node()->CreateConfig();
+    REQUIRE(knowhere::Config::Load(*cfg, probe_json, knowhere::SEARCH) == knowhere::Status::success);
+    auto probes = segments[0].Node()->CoarseSearch(query_ds, std::move(cfg));
+    REQUIRE(probes.has_value());
+    REQUIRE(probes.value()->nprobe == 1);
+    auto queries = knowhere::GenDataSet(nq, dim, query_ds->GetTensor());
+    queries->Set(knowhere::meta::COARSE_PROBES, probes.value());
+    auto res = segments[1].Search(queries, json, nullptr);
+    auto expected = segments[1].Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(expected.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(res.value()->GetIds()[i] == expected.value()->GetIds()[i]);
+    }
+}
+
+TEST_CASE("Test HNSW sharded indexes", "[float metrics]") {
+    const int64_t nb = 3000, nq = 10;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW_SHARDED,
+                         knowhere::IndexEnum::INDEX_HNSW_SQ_SHARDED);
+    CAPTURE(metric, name);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::HNSW_M, 16},
+        {knowhere::indexparam::EFCONSTRUCTION, 96},
+        {knowhere::indexparam::EF, 64},
+        {knowhere::indexparam::NUM_SHARDS, 4},
+    };
+    if (name == knowhere::IndexEnum::INDEX_HNSW_SQ_SHARDED) {
+        json[knowhere::indexparam::SQ_TYPE] = "SQ8";
+        json[knowhere::indexparam::HNSW_REFINE] = true;
+        json[knowhere::indexparam::HNSW_REFINE_TYPE] = "fp32";
+        json[knowhere::indexparam::HNSW_REFINE_K] = 4;
+    }
+
+    auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(idx.has_value());
+    REQUIRE(idx.value().Type() == name);
+    REQUIRE(idx.value().Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(idx.value().Count() == nb);
+
+    // the bitset of every shard is a slice of the one of the index
+    const auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+    const knowhere::BitsetView bitset(bitset_data.data(), nb, nb / 2);
+    for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+        auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, filter);
+        REQUIRE(gt.has_value());
+        auto res = idx.value().Search(query_ds, json, filter);
+        REQUIRE(res.has_value());
+        REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= 0.9f);
+        for (int64_t i = 0; i < nq * topk; i++) {
+            const auto id = res.value()->GetIds()[i];
+            REQUIRE(id >= 0);
+            REQUIRE(id < nb);
+            REQUIRE((filter.empty() || !filter.test(id)));
+        }
+    }
+
+    if (name == knowhere::IndexEnum::INDEX_HNSW_SHARDED) {
+        std::vector<int64_t> ids = {0, nb - 1, 1000, 5, 2999, 1500};
+        auto vectors = idx.value().GetVectorByIds(GenIdsDataSet(ids.size(), ids));
+        REQUIRE(vectors.has_value());
+        const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+        const float* got = reinterpret_cast<const float*>(vectors.value()->GetTensor());
+        for (size_t i = 0; i < ids.size(); i++) {
+            REQUIRE(std::memcmp(got + i * dim, data + ids[i] * dim, dim * sizeof(float)) == 0);
+        }
+    }
+
+    knowhere::BinarySet bs;
+    REQUIRE(idx.value().Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(loaded.value().Deserialize(bs, json) == knowhere::Status::success);
+    REQUIRE(loaded.value().Count() == nb);
+    auto res = idx.value().Search(query_ds, json, bitset);
+    auto loaded_res = loaded.value().Search(query_ds, json, bitset);
+    REQUIRE(res.has_value());
+    REQUIRE(loaded_res.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(loaded_res.value()->GetIds()[i] == res.value()->GetIds()[i]);
+    }
+
+    // a single shard is serialized as the index of the shard
+    json[knowhere::indexparam::NUM_SHARDS] = 1;
+    auto single = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version);
+    REQUIRE(single.value().Build(train_ds, json) == knowhere::Status::success);
+    knowhere::BinarySet single_bs;
+    REQUIRE(single.value().Serialize(single_bs) == knowhere::Status::success);
+    REQUIRE(!single_bs.Contains(name + "_shards"));
+    REQUIRE(single.value().Count() == nb);
+}
+
+TEST_CASE("Test BIN_MIH exact searches", "[binary metrics]") {
+    const int64_t nb = 5000, nq = 10;
+    const int64_t dim = 128;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+    const auto name = knowhere::IndexEnum::INDEX_FAISS_BIN_MIH;
+
+    // mih_max_flip 0 falls back to scanning the codes for most queries
+    auto max_flip = GENERATE(as<int>{}, 0, 2, 4);
+    CAPTURE(max_flip);
+
+    const auto train_ds = GenBinDataSet(nb, dim);
+    const auto query_ds = GenBinDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, knowhere::metric::HAMMING},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::meta::RADIUS, 30},
+        {knowhere::indexparam::MIH_MAX_FLIP, max_flip},
+    };
+
+    auto idx = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version);
+    REQUIRE(idx.has_value());
+    REQUIRE(idx.value().Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(idx.value().Count() == nb);
+
+    const auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+    const knowhere::BitsetView bitset(bitset_data.data(), nb, nb / 2);
+    for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+        auto gt = knowhere::BruteForce::Search<knowhere::bin1>(train_ds, query_ds, json, filter);
+        REQUIRE(gt.has_value());
+        auto res = idx.value().Search(query_ds, json, filter);
+        REQUIRE(res.has_value());
+        // ties may come in another order, the distances may not
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(res.value()->GetDistance()[i] == gt.value()->GetDistance()[i]);
+            REQUIRE((filter.empty() || !filter.test(res.value()->GetIds()[i])));
+        }
+
+        auto range_gt = knowhere::BruteForce::RangeSearch<knowhere::bin1>(train_ds, query_ds, json, filter);
+        REQUIRE(range_gt.has_value());
+        auto range_res = idx.value().RangeSearch(query_ds, json, filter);
+        REQUIRE(range_res.has_value());
+        for (int64_t i = 0; i <= nq; i++) {
+            REQUIRE(range_res.value()->GetLims()[i] == range_gt.value()->GetLims()[i]);
+        }
+        REQUIRE(GetRangeSearchRecall(*range_gt.value(), *range_res.value()) == 1.0f);
+    }
+
+    std::vector<int64_t> ids = {0, nb - 1, 17, 2500};
+    auto vectors = idx.value().GetVectorByIds(GenIdsDataSet(ids.size(), ids));
+    REQUIRE(vectors.has_value());
+    const auto code_size = dim / 8;
+    const auto data = reinterpret_cast<const uint8_t*>(train_ds->GetTensor());
+    const auto got = reinterpret_cast<const uint8_t*>(vectors.value()->GetTensor());
+    for (size_t i = 0; i < ids.size(); i++) {
+        REQUIRE(std::memcmp(got + i * code_size, data + ids[i] * code_size, code_size) == 0);
+    }
+
+    knowhere::BinarySet bs;
+    REQUIRE(idx.value().Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version);
+    REQUIRE(loaded.value().Deserialize(bs, json) == knowhere::Status::success);
+    REQUIRE(loaded.value().Count() == nb);
+    auto res = idx.value().Search(query_ds, json, bitset);
+    auto loaded_res = loaded.value().Search(query_ds, json, bitset);
+    REQUIRE(res.has_value());
+    REQUIRE(loaded_res.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        REQUIRE(loaded_res.value()->GetIds()[i] == res.value()->GetIds()[i]);
+    }
+
+    // the substrings have to split the codes evenly
+    json[knowhere::indexparam::MIH_NHASH] = 3;
+    auto invalid = knowhere::IndexFactory::Instance().Create<knowhere::bin1>(name, version);
+    REQUIRE(invalid.value().Build(train_ds, json) == knowhere::Status::invalid_args);
+}
+
+TEST_CASE("Test indexes built from a data source", "[float metrics]") {
+    const int64_t nb = 2000, nq = 10;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_FAISS_IDMAP,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, knowhere::IndexEnum::INDEX_HNSW,
+                         knowhere::IndexEnum::INDEX_HNSW_PQ);
+    CAPTURE(name);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, knowhere::metric::L2},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NLIST, 16},
+        {knowhere::indexparam::NPROBE, 16},
+        {knowhere::indexparam::HNSW_M, 16},
+        {knowhere::indexparam::EFCONSTRUCTION, 96},
+        {knowhere::indexparam::EF, 64},
+        {knowhere::indexparam::M, 8},
+        {knowhere::indexparam::NBITS, 8},
+    };
+    const auto gt = knowhere::BruteForce::Search<knowhere::fp32>(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    // chunks that do not divide the rows, read by a callback
+    const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+    int64_t reads = 0;
+    knowhere::CallbackDataSource source(
+        nb, dim, knowhere::DenseRowBytes<knowhere::fp32>(dim),
+        [&](int64_t begin, int64_t n) -> knowhere::expected<knowhere::DataSetPtr> {
+            reads++;
+            return knowhere::GenDataSet(n, dim, data + begin * dim);
+        },
+        false, 300);
+    auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(idx.BuildFromSource(source, json, 600) == knowhere::Status::success);
+    REQUIRE(idx.Count() == nb);
+    REQUIRE(reads > 1);
+    auto res = idx.Search(query_ds, json, nullptr);
+    REQUIRE(res.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *res.value()) >= (name == knowhere::IndexEnum::INDEX_HNSW_PQ ? 0.3f : 0.9f));
+
+    // the same rows mapped from a file
+    const std::string path = "/tmp/knowhere_data_source_test.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        const int32_t header[2] = {static_cast<int32_t>(nb), static_cast<int32_t>(dim)};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data), nb * dim * sizeof(float));
+    }
+    auto mmap_source = knowhere::MmapDataSource::Open<knowhere::fp32>(path, 512);
+    REQUIRE(mmap_source.has_value());
+    REQUIRE(mmap_source.value()->Rows() == nb);
+    auto mmap_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(mmap_idx.BuildFromSource(*mmap_source.value(), json) == knowhere::Status::success);
+    REQUIRE(mmap_idx.Count() == nb);
+    auto mmap_res = mmap_idx.Search(query_ds, json, nullptr);
+    REQUIRE(mmap_res.has_value());
+    if (name == knowhere::IndexEnum::INDEX_FAISS_IDMAP) {
+        for (int64_t i = 0; i < nq * topk; i++) {
+            REQUIRE(mmap_res.value()->GetIds()[i] == gt.value()->GetIds()[i]);
+        }
+    }
+    std::remove(path.c_str());
+
+    // a file shorter than its header says
+    {
+        std::ofstream out(path, std::ios::binary);
+        const int32_t header[2] = {static_cast<int32_t>(nb), static_cast<int32_t>(dim)};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+    REQUIRE(knowhere::MmapDataSource::Open<knowhere::fp32>(path).error() == knowhere::Status::invalid_args);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Test IVF indexes delete", "[float metrics]") {
+    const int64_t nb = 2000, nq = 20;
+    const int64_t dim = 32;
+    const int64_t topk = 10;
+    const auto version = GenTestVersionList();
+
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::COSINE);
+    auto name = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_FAISS_IVFFLAT,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFFLAT_CC, knowhere::IndexEnum::INDEX_FAISS_IVFSQ8,
+                         knowhere::IndexEnum::INDEX_FAISS_IVFPQ);
+    CAPTURE(metric, name);
+
+    const auto train_ds = GenDataSet(nb, dim);
+    const auto query_ds = GenDataSet(nq, dim, 7);
+    knowhere::Json json = {
+        {knowhere::meta::DIM, dim},
+        {knowhere::meta::METRIC_TYPE, metric},
+        {knowhere::meta::TOPK, topk},
+        {knowhere::indexparam::NLIST, 16},
+        {knowhere::indexparam::NPROBE, 16},
+        {knowhere::indexparam::M, 8},
+        {knowhere::indexparam::NBITS, 8},
+        {knowhere::indexparam::SSIZE, 48},
+    };
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(index.Build(train_ds, json) == knowhere::Status::success);
+    const int64_t size_before = index.Size();
+
+    // every fifth row is deleted, more than the share of a list that is compacted
+    std::vector<int64_t> deleted_ids;
+    for (int64_t i = 0; i < nb; i += 5) {
+        deleted_ids.push_back(i);
+    }
+    REQUIRE(index.DeleteByIds(GenIdsDataSet(deleted_ids.size(), deleted_ids)) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+    std::vector<int64_t> invalid_ids = {nb};
+    REQUIRE(index.DeleteByIds(GenIdsDataSet(invalid_ids.size(), invalid_ids)) == knowhere::Status::invalid_args);
+
+    auto check_result = [&](const auto& idx) {
+        auto result = idx.Search(query_ds, json, nullptr);
+        REQUIRE(result.has_value());
+        for (int64_t i = 0; i < nq * topk; i++) {
+            const int64_t id = result.value()->GetIds()[i];
+            REQUIRE(id >= 0);
+            REQUIRE(id % 5 != 0);
+        }
+    };
+    check_result(index);
+
+    // the lists are compacted in the background
+    bool compacted = false;
+    for (int i = 0; i < 200 && !compacted; i++) {
+        compacted = index.Size() < size_before;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(compacted);
+    check_result(index);
+
+    // deleted rows are kept by the serialized index, the ones that are not compacted yet as well
+    std::vector<int64_t> more_ids = {1, 2, 3};
+    REQUIRE(index.DeleteByIds(GenIdsDataSet(more_ids.size(), more_ids)) == knowhere::Status::success);
+    knowhere::BinarySet bs;
+    REQUIRE(index.Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+    REQUIRE(loaded.Deserialize(bs, json) == knowhere::Status::success);
+    check_result(loaded);
+    auto result = loaded.Search(query_ds, json, nullptr);
+    REQUIRE(result.has_value());
+    for (int64_t i = 0; i < nq * topk; i++) {
+        const int64_t id = result.value()->GetIds()[i];
+        REQUIRE((id < 1 || id > 3));
+    }
+
+    // the rows left after the compaction are still found by id
+    if (index.HasRawData(metric) && metric == knowhere::metric::L2) {
+        std::vector<int64_t> live_ids = {4, 6, 7};
+        auto vectors = index.GetVectorByIds(GenIdsDataSet(live_ids.size(), live_ids));
+        REQUIRE(vectors.has_value());
+        const float* data = reinterpret_cast<const float*>(train_ds->GetTensor());
+        const float* got = reinterpret_cast<const float*>(vectors.value()->GetTensor());
+        for (size_t i = 0; i < live_ids.size(); i++) {
+            for (int64_t j = 0; j < dim; j++) {
+                REQUIRE(got[i * dim + j] == data[live_ids[i] * dim + j]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test embedding list search", "[float metrics]") {
+    const int64_t n_docs = 300, dim = 16, topk = 5;
+    const int64_t nq = 4, query_len = 6;
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::IP, knowhere::metric::COSINE);
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+
+    // documents of 1 to 8 embeddings
+    auto doc_offsets = std::make_shared<knowhere::EmbListOffsets>(1, 0);
+    for (int64_t i = 0; i < n_docs; i++) {
+        doc_offsets->push_back(doc_offsets->back() + 1 + i % 8);
+    }
+    const int64_t nb = doc_offsets->back();
+    auto train_ds = GenDataSet(nb, dim, 42);
+    train_ds->Set(knowhere::meta::EMB_LIST_OFFSET, std::shared_ptr<const knowhere::EmbListOffsets>(doc_offsets));
+    auto query_offsets = std::make_shared<knowhere::EmbListOffsets>();
+    for (int64_t i = 0; i <= nq; i++) {
+        query_offsets->push_back(i * query_len);
+    }
+    auto query_ds = GenDataSet(nq * query_len, dim, 123);
+    query_ds->Set(knowhere::meta::EMB_LIST_OFFSET, std::shared_ptr<const knowhere::EmbListOffsets>(query_offsets));
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = metric;
+    json[knowhere::meta::TOPK] = topk;
+    // every row is a candidate, the results are exact
+    json["emb_list_candidates_ratio"] = 1024;
+
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP,
+                                                                           version);
+    REQUIRE(index.has_value());
+    REQUIRE(index.value().Build(train_ds, json) == knowhere::Status::success);
+
+    // the sum over the query embeddings of their best similarity with the ones of the document
+    const float* xb = reinterpret_cast<const float*>(train_ds->GetTensor());
+    const float* xq = reinterpret_cast<const float*>(query_ds->GetTensor());
+    auto similarity = [&](const float* a, const float* b) {
+        float ip = faiss::fvec_inner_product(a, b, dim);
+        if (metric == knowhere::metric::COSINE) {
+            ip /= std::sqrt(faiss::fvec_norm_L2sqr(a, dim) * faiss::fvec_norm_L2sqr(b, dim));
+        }
+        return ip;
+    };
+    auto max_sim = [&](int64_t q, int64_t doc) {
+        float score = 0.0f;
+        for (int64_t i = q * query_len; i < (q + 1) * query_len; i++) {
+            float best = -std::numeric_limits<float>::infinity();
+            for (size_t j = (*doc_offsets)[doc]; j < (*doc_offsets)[doc + 1]; j++) {
+                best = std::max(best, similarity(xq + i * dim, xb + j * dim));
+            }
+            score += best;
+        }
+        return score;
+    };
+
+    auto check_result = [&](const knowhere::DataSetPtr& result, const std::vector<uint8_t>& filtered_out) {
+        REQUIRE(result->GetRows() == nq);
+        REQUIRE(result->GetDim() == topk);
+        for (int64_t q = 0; q < nq; q++) {
+            std::vector<std::pair<float, int64_t>> scores;
+            for (int64_t doc = 0; doc < n_docs; doc++) {
+                if (filtered_out.empty() || !(filtered_out[doc >> 3] & (0x1 << (doc & 0x7)))) {
+                    scores.emplace_back(max_sim(q, doc), doc);
+                }
+            }
+            std::sort(scores.begin(), scores.end(), std::greater<>());
+            for (int64_t i = 0; i < topk; i++) {
+                REQUIRE(result->GetIds()[q * topk + i] == scores[i].second);
+                REQUIRE(result->GetDistance()[q * topk + i] == Catch::Approx(scores[i].first).epsilon(1e-4));
+            }
+        }
+    };
+
+    auto result = index.value().Search(query_ds, json, nullptr);
+    REQUIRE(result.has_value());
+    check_result(result.value(), {});
+
+    // the bitset filters out documents
+    std::vector<uint8_t> bitset_data((n_docs + 7) / 8, 0);
+    for (int64_t doc = 0; doc < n_docs; doc += 3) {
+        bitset_data[doc >> 3] |= (0x1 << (doc & 0x7));
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), n_docs);
+    result = index.value().Search(query_ds, json, bitset);
+    REQUIRE(result.has_value());
+    check_result(result.value(), bitset_data);
+
+    // the offsets of the documents are serialized with the index
+    knowhere::BinarySet bs;
+    REQUIRE(index.value().Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP,
+                                                                            version);
+    REQUIRE(loaded.value().Deserialize(bs, json) == knowhere::Status::success);
+    result = loaded.value().Search(query_ds, json, nullptr);
+    REQUIRE(result.has_value());
+    check_result(result.value(), {});
+
+    // offsets that do not cover the rows are rejected
+    auto bad_ds = GenDataSet(nb, dim, 42);
+    bad_ds->Set(knowhere::meta::EMB_LIST_OFFSET,
+                std::make_shared<const knowhere::EmbListOffsets>(knowhere::EmbListOffsets{0, 1, 2}));
+    auto other = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP,
+                                                                           version);
+    REQUIRE(other.value().Build(bad_ds, json) == knowhere::Status::invalid_args);
+}
+
+TEST_CASE("Test group-by search", "[float metrics]") {
+    const int64_t nb = 2000, nq = 5, dim = 16, n_groups = 4, group_size = 3, n_keys = 97;
+    auto metric = GENERATE(as<std::string>{}, knowhere::metric::L2, knowhere::metric::IP);
+    auto index_type = GENERATE(as<std::string>{}, knowhere::IndexEnum::INDEX_HNSW,
+                               knowhere::IndexEnum::INDEX_FAISS_IVFFLAT);
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+    auto keys = std::make_shared<knowhere::GroupKeys>(nb);
+    for (int64_t i = 0; i < nb; i++) {
+        (*keys)[i] = (i * 7) % n_keys;
+    }
+    query_ds->Set(knowhere::meta::GROUP_BY_KEYS, std::shared_ptr<const knowhere::GroupKeys>(keys));
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = metric;
+    json[knowhere::meta::TOPK] = n_groups;
+    json["group_size"] = group_size;
+    // every row is reached, the results are exact
+    json[knowhere::indexparam::HNSW_M] = 16;
+    json[knowhere::indexparam::EFCONSTRUCTION] = 200;
+    json[knowhere::indexparam::EF] = nb;
+    json[knowhere::indexparam::NLIST] = 16;
+    json[knowhere::indexparam::NPROBE] = 16;
+
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(index_type, version);
+    REQUIRE(index.has_value());
+    REQUIRE(index.value().Build(train_ds, json) == knowhere::Status::success);
+
+    const float* xb = reinterpret_cast<const float*>(train_ds->GetTensor());
+    const float* xq = reinterpret_cast<const float*>(query_ds->GetTensor());
+    const bool is_ip = metric == knowhere::metric::IP;
+
+    auto check_result = [&](const knowhere::DataSetPtr& result, const std::vector<uint8_t>& filtered_out) {
+        REQUIRE(result->GetRows() == nq);
+        REQUIRE(result->GetDim() == n_groups * group_size);
+        for (int64_t q = 0; q < nq; q++) {
+            // the rows closest first, the groups in the order of their closest row
+            std::vector<std::pair<float, int64_t>> rows;
+            for (int64_t i = 0; i < nb; i++) {
+                if (filtered_out.empty() || !(filtered_out[i >> 3] & (0x1 << (i & 0x7)))) {
+                    const float d = is_ip ? -faiss::fvec_inner_product(xq + q * dim, xb + i * dim, dim)
+                                          : faiss::fvec_L2sqr(xq + q * dim, xb + i * dim, dim);
+                    rows.emplace_back(d, i);
+                }
+            }
+            std::sort(rows.begin(), rows.end());
+            std::vector<int64_t> group_order;
+            std::map<int64_t, std::vector<int64_t>> group_rows;
+            for (const auto& [d, i] : rows) {
+                auto& members = group_rows[(*keys)[i]];
+                if (members.empty()) {
+                    group_order.push_back((*keys)[i]);
+                }
+                if (members.size() < group_size) {
+                    members.push_back(i);
+                }
+            }
+            const int64_t* ids = result->GetIds() + q * n_groups * group_size;
+            for (int64_t g = 0; g < n_groups; g++) {
+                for (int64_t j = 0; j < group_size; j++) {
+                    REQUIRE(ids[g * group_size + j] == group_rows[group_order[g]][j]);
+                }
+            }
+        }
+    };
+
+    auto result = index.value().Search(query_ds, json, nullptr);
+    REQUIRE(result.has_value());
+    check_result(result.value(), {});
+
+    // filtered out rows are not returned
+    std::vector<uint8_t> bitset_data((nb + 7) / 8, 0);
+    for (int64_t i = 0; i < nb; i += 3) {
+        bitset_data[i >> 3] |= (0x1 << (i & 0x7));
+    }
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+    result = index.value().Search(query_ds, json, bitset);
+    REQUIRE(result.has_value());
+    check_result(result.value(), bitset_data);
+
+    // every row needs a key
+    auto short_query_ds = GenDataSet(nq, dim, 123);
+    short_query_ds->Set(knowhere::meta::GROUP_BY_KEYS,
+                        std::make_shared<const knowhere::GroupKeys>(knowhere::GroupKeys(nb / 2, 0)));
+    REQUIRE(index.value().Search(short_query_ds, json, nullptr).error() == knowhere::Status::invalid_args);
+}
+
+TEST_CASE("Test search result cache", "[float metrics]") {
+    const int64_t nb = 1000, nq = 4, dim = 16, k = 5;
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto query_ds = GenDataSet(nq, dim, 123);
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+    json[knowhere::meta::TOPK] = k;
+
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP,
+                                                                            version);
+    REQUIRE(index.has_value());
+    REQUIRE(index.value().Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(index.value().EnableResultCache(1 << 20) == knowhere::Status::success);
+    auto cache = index.value().Node()->ResultCache();
+    REQUIRE(cache != nullptr);
+
+    auto first = index.value().Search(query_ds, json, nullptr);
+    REQUIRE(first.has_value());
+    REQUIRE(cache->Misses() == 1);
+    auto second = index.value().Search(query_ds, json, nullptr);
+    REQUIRE(second.has_value());
+    REQUIRE(cache->Hits() == 1);
+    REQUIRE(second.value()->GetRows() == nq);
+    REQUIRE(second.value()->GetDim() == k);
+    for (int64_t i = 0; i < nq * k; i++) {
+        REQUIRE(second.value()->GetIds()[i] == first.value()->GetIds()[i]);
+        REQUIRE(second.value()->GetDistance()[i] == first.value()->GetDistance()[i]);
+    }
+
+    SECTION("another config or other queries miss") {
+        auto other_json = json;
+        other_json[knowhere::meta::TOPK] = k + 1;
+        REQUIRE(index.value().Search(query_ds, other_json, nullptr).has_value());
+        REQUIRE(index.value().Search(GenDataSet(nq, dim, 7), json, nullptr).has_value());
+        REQUIRE(cache->Hits() == 1);
+        REQUIRE(cache->Misses() == 3);
+    }
+
+    SECTION("a bitset is cached by its version") {
+        std::vector<uint8_t> bitset_data(nb / 8, 0);
+        bitset_data[0] = 0xff;
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        // no version, no caching
+        REQUIRE(index.value().Search(query_ds, json, bitset).has_value());
+        REQUIRE(index.value().Search(query_ds, json, bitset).has_value());
+        REQUIRE(cache->Hits() == 1);
+        REQUIRE(cache->Misses() == 1);
+
+        auto versioned_json = json;
+        versioned_json["bitset_version"] = 1;
+        auto filtered = index.value().Search(query_ds, versioned_json, bitset);
+        REQUIRE(filtered.has_value());
+        REQUIRE(index.value().Search(query_ds, versioned_json, bitset).has_value());
+        REQUIRE(cache->Hits() == 2);
+        REQUIRE(cache->Misses() == 2);
+        for (int64_t i = 0; i < nq * k; i++) {
+            REQUIRE(filtered.value()->GetIds()[i] >= 8);
+        }
+        versioned_json["bitset_version"] = 2;
+        REQUIRE(index.value().Search(query_ds, versioned_json, bitset).has_value());
+        REQUIRE(cache->Misses() == 3);
+    }
+
+    SECTION("adding rows clears the cache") {
+        REQUIRE(index.value().Add(query_ds, json) == knowhere::Status::success);
+        REQUIRE(cache->Bytes() == 0);
+        auto after_add = index.value().Search(query_ds, json, nullptr);
+        REQUIRE(after_add.has_value());
+        REQUIRE(cache->Misses() == 2);
+        // the added copies of the queries are now their nearest rows
+        for (int64_t q = 0; q < nq; q++) {
+            REQUIRE(after_add.value()->GetIds()[q * k] == nb + q);
+        }
+    }
+
+    SECTION("results larger than the cache are not kept") {
+        REQUIRE(index.value().EnableResultCache(1) == knowhere::Status::success);
+        auto small_cache = index.value().Node()->ResultCache();
+        REQUIRE(index.value().Search(query_ds, json, nullptr).has_value());
+        REQUIRE(index.value().Search(query_ds, json, nullptr).has_value());
+        REQUIRE(small_cache->Hits() == 0);
+        REQUIRE(small_cache->Bytes() == 0);
+        REQUIRE(index.value().EnableResultCache(0) == knowhere::Status::success);
+        REQUIRE(index.value().Node()->ResultCache() == nullptr);
+    }
+}
+
+TEST_CASE("Test query dedup", "[float metrics]") {
+    const int64_t nb = 1000, n_distinct = 3, nq = 9, dim = 16, k = 5;
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto train_ds = GenDataSet(nb, dim, 42);
+    auto distinct_ds = GenDataSet(n_distinct, dim, 123);
+    const float* distinct = reinterpret_cast<const float*>(distinct_ds->GetTensor());
+    // query i repeats distinct query i % n_distinct, the ones past the first copies are slightly off
+    auto xq = new float[nq * dim];
+    for (int64_t i = 0; i < nq; i++) {
+        for (int64_t d = 0; d < dim; d++) {
+            xq[i * dim + d] = distinct[(i % n_distinct) * dim + d] * (i < n_distinct ? 1.0f : 1.0001f);
+        }
+    }
+    auto query_ds = knowhere::GenDataSet(nq, dim, xq);
+    query_ds->SetIsOwner(true);
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+    json[knowhere::meta::TOPK] = k;
+    auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP,
+                                                                            version);
+    REQUIRE(index.has_value());
+    REQUIRE(index.value().Build(train_ds, json) == knowhere::Status::success);
+
+    SECTION("identical queries") {
+        auto dedup = knowhere::DedupQueries(*query_ds, knowhere::DataFormatEnum::fp32, 0.0f);
+        // the originals and their off copies
+        REQUIRE(dedup.representatives.size() == 2 * n_distinct);
+
+        auto dedup_json = json;
+        dedup_json["query_dedup_tolerance"] = 0.0f;
+        auto expected = index.value().Search(query_ds, json, nullptr);
+        auto result = index.value().Search(query_ds, dedup_json, nullptr);
+        REQUIRE(expected.has_value());
+        REQUIRE(result.has_value());
+        REQUIRE(result.value()->GetRows() == nq);
+        for (int64_t i = 0; i < nq * k; i++) {
+            REQUIRE(result.value()->GetIds()[i] == expected.value()->GetIds()[i]);
+            REQUIRE(result.value()->GetDistance()[i] == expected.value()->GetDistance()[i]);
+        }
+    }
+
+    SECTION("near-duplicate queries") {
+        auto dedup = knowhere::DedupQueries(*query_ds, knowhere::DataFormatEnum::fp32, 0.01f);
+        REQUIRE(dedup.representatives.size() == n_distinct);
+
+        auto dedup_json = json;
+        dedup_json["query_dedup_tolerance"] = 0.01f;
+        auto result = index.value().Search(query_ds, dedup_json, nullptr);
+        REQUIRE(result.has_value());
+        REQUIRE(result.value()->GetRows() == nq);
+        for (int64_t i = n_distinct; i < nq; i++) {
+            for (int64_t j = 0; j < k; j++) {
+                REQUIRE(result.value()->GetIds()[i * k + j] ==
+                        result.value()->GetIds()[(i % n_distinct) * k + j]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test index memory breakdown", "[float metrics]") {
+    const int64_t nb = 1000, dim = 16;
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto train_ds = GenDataSet(nb, dim, 42);
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+    json[knowhere::indexparam::NLIST] = 16;
+
+    SECTION("flat") {
+        auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(
+            knowhere::IndexEnum::INDEX_FAISS_IDMAP, version);
+        REQUIRE(index.has_value());
+        REQUIRE(index.value().Build(train_ds, json) == knowhere::Status::success);
+        auto usage = index.value().Node()->MemoryBreakdown();
+        REQUIRE(usage.Sections().at(knowhere::memory_section::RAW_DATA) >=
+                static_cast<int64_t>(nb * dim * sizeof(float)));
+        REQUIRE(usage.Total() == index.value().Size());
+    }
+
+    SECTION("ivf flat") {
+        auto index = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(
+            knowhere::IndexEnum::INDEX_FAISS_IVFFLAT, version);
+        REQUIRE(index.has_value());
+        REQUIRE(index.value().Build(train_ds, json) == knowhere::Status::success);
+        auto usage = index.value().Node()->MemoryBreakdown();
+        const auto& sections = usage.Sections();
+        REQUIRE(sections.at(knowhere::memory_section::CODES) >= static_cast<int64_t>(nb * dim * sizeof(float)));
+        REQUIRE(sections.at(knowhere::memory_section::IDS) >= static_cast<int64_t>(nb * sizeof(int64_t)));
+        REQUIRE(sections.at(knowhere::memory_section::QUANTIZER) >= static_cast<int64_t>(16 * dim * sizeof(float)));
+        REQUIRE(usage.Total() == index.value().Size());
+    }
+}
@@ -91,6 +91,116 @@ TEST_CASE("Test minhash function") {
         CHECK_EQ(res_dis[3], gt_ids[3]);
     }
 }
+TEST_CASE("Test sparse function") {
+    constexpr size_t seed = 111;
+    SECTION("test bitpacked delta decode function") {
+        auto bits = GENERATE(as<size_t>{}, 0, 1, 7, 13, 32);
+        auto n = GENERATE(as<size_t>{}, 1, 7, 8, 16, 33, 64);
+        auto data = GenRandomVector<uint8_t>(n * 4 + 8, 1, seed);
+        std::vector<uint32_t> res(n), gt(n);
+        faiss::u32_bitpacked_delta_decode(data.get(), bits, n, 100, res.data());
+        faiss::u32_bitpacked_delta_decode_ref(data.get(), bits, n, 100, gt.data());
+        CHECK(res == gt);
+    }
+    SECTION("test sparse intersect function") {
+        auto na = GENERATE(as<size_t>{}, 0, 7, 8, 16, 33, 100);
+        auto nb = GENERATE(as<size_t>{}, 1, 8, 17, 64, 200);
+        std::mt19937 rng(seed);
+        // ids in a small range, so that a and b have many in common
+        auto gen_ids = [&](size_t n) {
+            std::set<uint32_t> ids;
+            while (ids.size() < n) {
+                ids.insert(rng() % 256);
+            }
+            std::vector<uint32_t> elems;
+            for (auto id : ids) {
+                elems.push_back(id);
+                elems.push_back(rng());
+            }
+            return elems;
+        };
+        auto a = gen_ids(na);
+        auto b = gen_ids(nb);
+        const size_t n = std::min(na, nb);
+        std::vector<uint32_t> a_pos(n), b_pos(n), a_pos_gt(n), b_pos_gt(n);
+        auto cnt = faiss::u32_sparse_intersect(a.data(), na, b.data(), nb, a_pos.data(), b_pos.data());
+        auto cnt_gt = faiss::u32_sparse_intersect_ref(a.data(), na, b.data(), nb, a_pos_gt.data(), b_pos_gt.data());
+        REQUIRE(cnt == cnt_gt);
+        a_pos.resize(cnt);
+        b_pos.resize(cnt);
+        a_pos_gt.resize(cnt);
+        b_pos_gt.resize(cnt);
+        CHECK(a_pos == a_pos_gt);
+        CHECK(b_pos == b_pos_gt);
+    }
+}
+
+TEST_CASE("Test pq function") {
+    constexpr size_t seed = 111;
+    SECTION("test pq4 fast scan function") {
+        auto nbytes = GENERATE(as<size_t>{}, 1, 3, 16, 64);
+        auto nb = GENERATE(as<size_t>{}, 1, 4);
+        // 16 bytes past the codes must be readable
+        auto codes = GenRandomVector<uint8_t>(32 * nbytes * nb + 16, 1, seed);
+        auto lut = GenRandomVector<uint8_t>(32 * nbytes, 1, seed + 1);
+        std::vector<uint16_t> res(32 * nb), gt(32 * nb);
+        faiss::u8_pq4_fast_scan(codes.get(), nb, nbytes, lut.get(), res.data());
+        faiss::u8_pq4_fast_scan_ref(codes.get(), nb, nbytes, lut.get(), gt.data());
+        CHECK(res == gt);
+    }
+}
+
+TEST_CASE("Test threshold filter function") {
+    auto simd_type = GENERATE(as<knowhere::KnowhereConfig::SimdType>{}, knowhere::KnowhereConfig::SimdType::AVX512,
+                              knowhere::KnowhereConfig::SimdType::AVX2, knowhere::KnowhereConfig::SimdType::GENERIC,
+                              knowhere::KnowhereConfig::SimdType::AUTO);
+    // around the 8 and 16 scores of a register
+    auto n = GENERATE(as<size_t>{}, 1, 7, 8, 15, 16, 17, 64, 100);
+    auto greater = GENERATE(true, false);
+    knowhere::KnowhereConfig::SetSimdType(simd_type);
+
+    auto dis = GenRandomVector<float>(1, n, 42);
+    const float threshold = dis[n / 2];
+    std::vector<uint32_t> out(n), gt(n);
+    auto cnt = faiss::fvec_threshold_filter(dis.get(), n, threshold, greater, out.data());
+    auto cnt_gt = faiss::fvec_threshold_filter_ref(dis.get(), n, threshold, greater, gt.data());
+    REQUIRE(cnt == cnt_gt);
+    out.resize(cnt);
+    gt.resize(cnt);
+    CHECK(out == gt);
+}
+
+TEST_CASE("Test binary function") {
+    using Catch::Approx;
+    auto simd_type = GENERATE(as<knowhere::KnowhereConfig::SimdType>{}, knowhere::KnowhereConfig::SimdType::AVX512,
+                              knowhere::KnowhereConfig::SimdType::AVX2, knowhere::KnowhereConfig::SimdType::GENERIC,
+                              knowhere::KnowhereConfig::SimdType::AUTO);
+    // around the codes that share a register and the chunks of 16 to 64 bytes
+    auto code_size = GENERATE(as<size_t>{}, 1, 3, 4, 8, 16, 20, 32, 33, 64, 100, 128, 256);
+    auto ny = GENERATE(as<size_t>{}, 1, 4, 9, 17);
+    knowhere::KnowhereConfig::SetSimdType(simd_type);
+
+    const auto x = GenRandomVector<uint8_t>(code_size, 1, 314);
+    auto y = GenRandomVector<uint8_t>(code_size, ny + 1, 271);
+    // an empty code, for the jaccard distance of two empty codes
+    std::fill(y.get() + ny * code_size, y.get() + (ny + 1) * code_size, 0);
+    std::vector<int32_t> hamming(ny), hamming_gt(ny);
+    faiss::u8_hamming_distance_ny(x.get(), y.get(), code_size, ny, hamming.data());
+    faiss::u8_hamming_distance_ny_ref(x.get(), y.get(), code_size, ny, hamming_gt.data());
+    CHECK(hamming == hamming_gt);
+
+    std::vector<float> jaccard(ny), jaccard_gt(ny);
+    faiss::u8_jaccard_distance_ny(x.get(), y.get(), code_size, ny, jaccard.data());
+    faiss::u8_jaccard_distance_ny_ref(x.get(), y.get(), code_size, ny, jaccard_gt.data());
+    for (size_t j = 0; j < ny; j++) {
+        CHECK(jaccard[j] == Approx(jaccard_gt[j]));
+    }
+
+    float empty;
+    faiss::u8_jaccard_distance_ny(y.get() + ny * code_size, y.get() + ny * code_size, code_size, 1, &empty);
+    CHECK(empty == 1.0f);
+}
+
 TEST_CASE("Test distance") {
     using Catch::Approx;
     auto simd_type = GENERATE(as<knowhere::KnowhereConfig::SimdType>{}, knowhere::KnowhereConfig::SimdType::AVX512,
@@ -351,6 +461,35 @@ TEST_CASE("Test distance") {
         }
     }
 
+    SECTION("test batch_8 distance calculation") {
+        // the 4 vectors of y twice, against the single distances of the ref kernels
+        auto check_batch_8 = [&](const auto* x_data, const auto* y_base, auto batch_8, auto ref, const float tol) {
+            std::vector<decltype(y_base)> y_data(8);
+            for (size_t k = 0; k < 8; k++) {
+                y_data[k] = y_base + (k % ny) * dim;
+            }
+            std::vector<float> dis(8);
+            batch_8(x_data, y_data.data(), dim, dis.data());
+            for (size_t k = 0; k < 8; k++) {
+                REQUIRE_THAT(dis[k], Catch::Matchers::WithinRel(ref(x_data, y_data[k], dim), tol));
+            }
+        };
+        check_batch_8(x.get(), y.get(), faiss::fvec_inner_product_batch_8, faiss::fvec_inner_product_ref, tolerance);
+        check_batch_8(x.get(), y.get(), faiss::fvec_L2sqr_batch_8, faiss::fvec_L2sqr_ref, tolerance);
+        check_batch_8(x_fp16.get(), y_fp16.get(), faiss::fp16_vec_inner_product_batch_8,
+                      faiss::fp16_vec_inner_product_ref, fp16_tolerance);
+        check_batch_8(x_fp16.get(), y_fp16.get(), faiss::fp16_vec_L2sqr_batch_8, faiss::fp16_vec_L2sqr_ref,
+                      fp16_tolerance);
+        check_batch_8(x_bf16.get(), y_bf16.get(), faiss::bf16_vec_inner_product_batch_8,
+                      faiss::bf16_vec_inner_product_ref, bf16_tolerance);
+        check_batch_8(x_bf16.get(), y_bf16.get(), faiss::bf16_vec_L2sqr_batch_8, faiss::bf16_vec_L2sqr_ref,
+                      bf16_tolerance);
+        check_batch_8(x_int8.get(), y_int8.get(), faiss::int8_vec_inner_product_batch_8,
+                      faiss::int8_vec_inner_product_ref, int8_tolerance);
+        check_batch_8(x_int8.get(), y_int8.get(), faiss::int8_vec_L2sqr_batch_8, faiss::int8_vec_L2sqr_ref,
+                      int8_tolerance);
+    }
+
     SECTION("test ny distance calculation") {
         // calculate the float result ref
         auto ref_ip = std::make_unique<float[]>(ny);
@@ -367,6 +506,59 @@ TEST_CASE("Test distance") {
             REQUIRE_THAT(ip_dis[i], Catch::Matchers::WithinRel(ref_ip[i], tolerance));
             REQUIRE_THAT(l2_dis[i], Catch::Matchers::WithinRel(ref_l2[i], tolerance));
         }
+
+        // the nearest may differ from the ref's on ties, its distance may not
+        const auto nearest = faiss::fvec_L2sqr_ny_nearest(l2_dis.get(), x.get(), y.get(), dim, ny);
+        REQUIRE_THAT(ref_l2[nearest], Catch::Matchers::WithinRel(*std::min_element(ref_l2.get(), ref_l2.get() + ny),
+                                                                 tolerance));
+
+        // y transposed, with the j-th component of every vector at j * ny
+        std::vector<float> y_t(dim * ny), y_sqlen(ny), ref_l2_t(ny), l2_t(ny);
+        for (size_t i = 0; i < ny; i++) {
+            for (size_t j = 0; j < dim; j++) {
+                y_t[j * ny + i] = y[i * dim + j];
+            }
+            y_sqlen[i] = faiss::fvec_norm_L2sqr_ref(y.get() + i * dim, dim);
+        }
+        faiss::fvec_L2sqr_ny_transposed_ref(ref_l2_t.data(), x.get(), y_t.data(), y_sqlen.data(), dim, ny, ny);
+        faiss::fvec_L2sqr_ny_transposed(l2_t.data(), x.get(), y_t.data(), y_sqlen.data(), dim, ny, ny);
+        for (size_t i = 0; i < ny; i++) {
+            REQUIRE_THAT(l2_t[i], Catch::Matchers::WithinAbs(ref_l2_t[i], tolerance * dim));
+        }
+    }
+
+    SECTION("test ny_topk distance calculation") {
+        // enough rows for batches of 8 and a tail, the distances are compared as ties may be ordered differently
+        const size_t rows = 100;
+        const auto y_rows = GenRandomVector<float>(dim, rows, 161);
+        const auto y_rows_fp16 = ConvertVector<knowhere::fp16>(y_rows.get(), rows, dim);
+        const auto y_rows_bf16 = ConvertVector<knowhere::bf16>(y_rows.get(), rows, dim);
+        auto check_topk = [&](const auto* x_data, const auto* y_data, auto topk, auto topk_ref, auto l2sqr_ref,
+                              const float tol) {
+            for (const size_t n : {size_t(0), size_t(5), rows}) {
+                for (const size_t k : {1, 10, 64}) {
+                    std::vector<float> dis(k), ref_dis(k);
+                    std::vector<int64_t> ids(k), ref_ids(k);
+                    topk(x_data, y_data, dim, n, k, dis.data(), ids.data());
+                    topk_ref(x_data, y_data, dim, n, k, ref_dis.data(), ref_ids.data());
+                    for (size_t i = 0; i < k; i++) {
+                        if (i >= n) {
+                            REQUIRE(ids[i] == -1);
+                            continue;
+                        }
+                        REQUIRE_THAT(dis[i], Catch::Matchers::WithinRel(ref_dis[i], tol));
+                        REQUIRE_THAT(dis[i], Catch::Matchers::WithinRel(l2sqr_ref(x_data, y_data + ids[i] * dim, dim),
+                                                                        tol));
+                    }
+                }
+            }
+        };
+        check_topk(x.get(), y_rows.get(), faiss::fvec_L2sqr_ny_topk, faiss::fvec_L2sqr_ny_topk_ref,
+                   faiss::fvec_L2sqr_ref, tolerance);
+        check_topk(x_fp16.get(), y_rows_fp16.get(), faiss::fp16_vec_L2sqr_ny_topk, faiss::fp16_vec_L2sqr_ny_topk_ref,
+                   faiss::fp16_vec_L2sqr_ref, fp16_tolerance);
+        check_topk(x_bf16.get(), y_rows_bf16.get(), faiss::bf16_vec_L2sqr_ny_topk, faiss::bf16_vec_L2sqr_ny_topk_ref,
+                   faiss::bf16_vec_L2sqr_ref, bf16_tolerance);
     }
 
     SECTION("test madd distance calculation") {
@@ -436,3 +628,79 @@ TEST_CASE("Test distance") {
         run_test();
     }
 }
+
+TEST_CASE("Test fixed dim distance") {
+    auto simd_type = GENERATE(as<knowhere::KnowhereConfig::SimdType>{}, knowhere::KnowhereConfig::SimdType::AVX512,
+                              knowhere::KnowhereConfig::SimdType::AVX2, knowhere::KnowhereConfig::SimdType::GENERIC,
+                              knowhere::KnowhereConfig::SimdType::AUTO);
+    // the unrolled dims, and ones without kernels of their own
+    auto dim = GENERATE(as<size_t>{}, 100, 128, 256, 384, 512, 768, 1000, 1024, 1536);
+    knowhere::KnowhereConfig::SetSimdType(simd_type);
+
+    // the sums of more dims are accumulated in a different order than the ref kernels
+    const float tolerance = 0.00005f;
+    const size_t ny = 4;
+    const auto x = GenRandomVector<float>(dim, 1, 314);
+    const auto y = GenRandomVector<float>(dim, ny, 271);
+    const float* y_data[ny] = {y.get(), y.get() + dim, y.get() + 2 * dim, y.get() + 3 * dim};
+
+    auto check = [&](const faiss::FvecDimKernels& kernels) {
+        std::vector<float> l2_batch_4(ny), ip_batch_4(ny);
+        kernels.L2sqr_batch_4(x.get(), y_data[0], y_data[1], y_data[2], y_data[3], dim, l2_batch_4[0], l2_batch_4[1],
+                              l2_batch_4[2], l2_batch_4[3]);
+        kernels.inner_product_batch_4(x.get(), y_data[0], y_data[1], y_data[2], y_data[3], dim, ip_batch_4[0],
+                                      ip_batch_4[1], ip_batch_4[2], ip_batch_4[3]);
+        for (size_t i = 0; i < ny; i++) {
+            const float ref_L2sqr = faiss::fvec_L2sqr_ref(x.get(), y_data[i], dim);
+            const float ref_ip = faiss::fvec_inner_product_ref(x.get(), y_data[i], dim);
+            REQUIRE_THAT(kernels.L2sqr(x.get(), y_data[i], dim), Catch::Matchers::WithinRel(ref_L2sqr, tolerance));
+            REQUIRE_THAT(kernels.inner_product(x.get(), y_data[i], dim), Catch::Matchers::WithinRel(ref_ip, tolerance));
+            REQUIRE_THAT(l2_batch_4[i], Catch::Matchers::WithinRel(ref_L2sqr, tolerance));
+            REQUIRE_THAT(ip_batch_4[i], Catch::Matchers::WithinRel(ref_ip, tolerance));
+        }
+    };
+    check(faiss::fvec_dim_kernels(dim));
+
+    // the bf16 patch keeps the kernels of the hooks
+    knowhere::KnowhereConfig::EnablePatchForComputeFP32AsBF16();
+    const auto patched = faiss::fvec_dim_kernels(dim);
+    REQUIRE(patched.L2sqr == faiss::fvec_L2sqr);
+    REQUIRE(patched.inner_product_batch_4 == faiss::fvec_inner_product_batch_4);
+    knowhere::KnowhereConfig::DisablePatchForComputeFP32AsBF16();
+}
+
+TEST_CASE("Test int8 inner products between blocks") {
+    knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AUTO);
+    LOG_KNOWHERE_INFO_ << "int8 amx: " << faiss::support_int8_amx;
+    // around the tiles of 16 vectors by 64 dims
+    auto dim = GENERATE(as<size_t>{}, 1, 4, 63, 64, 65, 128, 200);
+    auto nx = GENERATE(as<size_t>{}, 1, 8, 17);
+    auto ny = GENERATE(as<size_t>{}, 1, 16, 33);
+
+    const auto x = GenRandomVector<knowhere::int8>(dim, nx, 314);
+    const auto y = GenRandomVector<knowhere::int8>(dim, ny, 271);
+    std::vector<float> ip(nx * ny), ip_gt(nx * ny);
+    faiss::int8_vec_inner_products_nx_ny(ip.data(), x.get(), y.get(), dim, nx, ny);
+    faiss::int8_vec_inner_products_nx_ny_ref(ip_gt.data(), x.get(), y.get(), dim, nx, ny);
+    CHECK(ip == ip_gt);
+}
+
+TEST_CASE("Test bf16 inner products between blocks") {
+    knowhere::KnowhereConfig::SetSimdType(knowhere::KnowhereConfig::SimdType::AUTO);
+    LOG_KNOWHERE_INFO_ << "bf16 amx: " << faiss::support_bf16_amx;
+    // around the tiles of 16 vectors by 32 dims
+    auto dim = GENERATE(as<size_t>{}, 1, 4, 31, 32, 33, 128, 200);
+    auto nx = GENERATE(as<size_t>{}, 1, 8, 17);
+    auto ny = GENERATE(as<size_t>{}, 1, 16, 33);
+
+    const auto x = GenRandomVector<knowhere::bf16>(dim, nx, 314);
+    const auto y = GenRandomVector<knowhere::bf16>(dim, ny, 271);
+    std::vector<float> ip(nx * ny), ip_gt(nx * ny);
+    faiss::bf16_vec_inner_products_nx_ny(ip.data(), x.get(), y.get(), dim, nx, ny);
+    faiss::bf16_vec_inner_products_nx_ny_ref(ip_gt.data(), x.get(), y.get(), dim, nx, ny);
+    // the products are exact in fp32, only the order of the sums differs
+    const float tolerance = 1e-5f * dim * 128 * 128;
+    for (size_t i = 0; i < nx * ny; i++) {
+        REQUIRE_THAT(ip[i], Catch::Matchers::WithinAbs(ip_gt[i], tolerance));
+    }
+}
@@ -12,13 +12,16 @@
 #include <future>
 #include <thread>
 
+#include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include "knowhere/bitsetview.h"
 #include "knowhere/comp/brute_force.h"
 #include "knowhere/comp/index_param.h"
 #include "knowhere/comp/knowhere_check.h"
 #include "knowhere/comp/knowhere_config.h"
+#include "knowhere/comp/search_stats.h"
 #include "knowhere/index/index_factory.h"
 #include "utils.h"
 
@@ -47,7 +50,8 @@ TEST_CASE("Test Mem Sparse Index With Float Vector", "[float metrics]") {
 
     auto metric = GENERATE(knowhere::metric::IP, knowhere::metric::BM25);
 
-    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE");
+    auto inverted_index_algo =
+        GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND", "SAAT_ANYTIME");
 
     auto drop_ratio_search = metric == knowhere::metric::BM25 ? GENERATE(0.0, 0.1) : GENERATE(0.0, 0.3);
 
@@ -167,6 +171,162 @@ TEST_CASE("Test Mem Sparse Index With Float Vector", "[float metrics]") {
         }
     }
 
+    SECTION("Test Search with compressed posting ids") {
+        auto name = knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX;
+        knowhere::Json json = sparse_inverted_index_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        knowhere::Json compressed_json = json;
+        compressed_json[knowhere::indexparam::COMPRESS_POSTING_IDS] = true;
+        auto compressed_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(compressed_idx.Build(train_ds, compressed_json) == knowhere::Status::success);
+        REQUIRE(compressed_idx.Size() < idx.Size());
+
+        // the lists are compressed again when loaded
+        knowhere::BinarySet bs;
+        REQUIRE(compressed_idx.Serialize(bs) == knowhere::Status::success);
+        REQUIRE(compressed_idx.Deserialize(bs, compressed_json) == knowhere::Status::success);
+
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+            auto results = idx.Search(query_ds, json, filter);
+            auto compressed_results = compressed_idx.Search(query_ds, compressed_json, filter);
+            REQUIRE(results.has_value());
+            REQUIRE(compressed_results.has_value());
+            REQUIRE(GetKNNRecall(*results.value(), *compressed_results.value()) == 1);
+        }
+    }
+
+    SECTION("Test Search in batches") {
+        auto name = knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX;
+        knowhere::Json json = sparse_inverted_index_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        knowhere::Json batch_json = json;
+        batch_json[knowhere::indexparam::SEARCH_BATCH_SIZE] = 4;
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+            auto results = idx.Search(query_ds, json, filter);
+            auto batch_results = idx.Search(query_ds, batch_json, filter);
+            REQUIRE(results.has_value());
+            REQUIRE(batch_results.has_value());
+            check_distance_decreasing(*batch_results.value());
+            check_result_match_filter(*batch_results.value(), filter);
+            for (int i = 0; i < nq * topk; ++i) {
+                REQUIRE((batch_results.value()->GetIds()[i] == -1) == (results.value()->GetIds()[i] == -1));
+                if (results.value()->GetIds()[i] != -1) {
+                    REQUIRE_THAT(batch_results.value()->GetDistance()[i],
+                                 Catch::Matchers::WithinRel(results.value()->GetDistance()[i], 0.001f));
+                }
+            }
+        }
+    }
+
+    SECTION("Test Search with reordered doc ids") {
+        auto name = knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX;
+        knowhere::Json json = sparse_inverted_index_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        knowhere::Json reorder_json = json;
+        reorder_json[knowhere::indexparam::REORDER_DOC_IDS] = true;
+        auto reordered_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(reordered_idx.Build(train_ds, reorder_json) == knowhere::Status::success);
+
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+        auto check_results = [&]() {
+            for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+                auto results = idx.Search(query_ds, json, filter);
+                auto reordered_results = reordered_idx.Search(query_ds, json, filter);
+                REQUIRE(results.has_value());
+                REQUIRE(reordered_results.has_value());
+                check_result_match_filter(*reordered_results.value(), filter);
+                // ids may differ between ties, distances may not
+                auto distances = results.value()->GetDistance();
+                auto reordered_distances = reordered_results.value()->GetDistance();
+                for (int64_t i = 0; i < nq * topk; ++i) {
+                    REQUIRE_THAT(reordered_distances[i], Catch::Matchers::WithinRel(distances[i], 0.001f));
+                }
+            }
+        };
+        check_results();
+
+        // the ids are restored from the serialized index
+        knowhere::BinarySet bs;
+        REQUIRE(reordered_idx.Serialize(bs) == knowhere::Status::success);
+        reordered_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(reordered_idx.Deserialize(bs, json) == knowhere::Status::success);
+        check_results();
+    }
+
+    SECTION("Test Search with BM25 impacts") {
+        if (metric != knowhere::metric::BM25) {
+            return;
+        }
+        auto name = knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX;
+        knowhere::Json json = sparse_inverted_index_gen();
+        json[knowhere::indexparam::BM25_IMPACTS] = true;
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+        REQUIRE(idx.Deserialize(bs, json) == knowhere::Status::success);
+
+        auto gt = knowhere::BruteForce::SearchSparse(train_ds, query_ds, conf, nullptr);
+        auto results = idx.Search(query_ds, json, nullptr);
+        REQUIRE(results.has_value());
+        check_distance_decreasing(*results.value());
+        // the impacts are quantized BM25 scores
+        REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= 0.8);
+    }
+
+    SECTION("Test Search with direct layout") {
+        auto name = knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX;
+        knowhere::Json json = sparse_inverted_index_gen();
+        auto idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        knowhere::Json direct_json = json;
+        direct_json[knowhere::indexparam::DIRECT_LAYOUT] = true;
+        auto direct_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+        REQUIRE(direct_idx.Build(train_ds, direct_json) == knowhere::Status::success);
+        knowhere::BinarySet bs;
+        REQUIRE(direct_idx.Serialize(bs) == knowhere::Status::success);
+
+        // the layout is detected when loading, whatever the config
+        auto use_mmap = GENERATE(true, false);
+        auto tmp_file = "/tmp/knowhere_sparse_inverted_index_direct_layout_test";
+        {
+            auto loaded_idx = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(name, version).value();
+            if (use_mmap) {
+                WriteBinaryToFile(tmp_file, bs.GetByName(name));
+                REQUIRE(loaded_idx.DeserializeFromFile(tmp_file, json) == knowhere::Status::success);
+            } else {
+                REQUIRE(loaded_idx.Deserialize(bs, json) == knowhere::Status::success);
+            }
+            REQUIRE(loaded_idx.Count() == nb);
+
+            auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+            knowhere::BitsetView bitset(bitset_data.data(), nb);
+            for (const auto& filter : {knowhere::BitsetView(), bitset}) {
+                auto results = idx.Search(query_ds, json, filter);
+                auto loaded_results = loaded_idx.Search(query_ds, json, filter);
+                REQUIRE(results.has_value());
+                REQUIRE(loaded_results.has_value());
+                REQUIRE(GetKNNRecall(*results.value(), *loaded_results.value()) == 1);
+            }
+            // loaded_idx to destruct and munmap
+        }
+        if (use_mmap) {
+            REQUIRE(std::remove(tmp_file) == 0);
+        }
+    }
+
     SECTION("Test Search with Bitset") {
         using std::make_tuple;
         auto [name, gen] = GENERATE_REF(table<std::string, std::function<knowhere::Json()>>({
@@ -321,6 +481,48 @@ TEST_CASE("Test Mem Sparse Index With Float Vector", "[float metrics]") {
         // most above 0.95, only a few between 0.9 and 0.83
         REQUIRE(actual_count * 1.0f / gt_count >= 0.83);
     }
+
+    SECTION("Test Sparse Range Search with range_search_k and Bitset") {
+        auto idx = knowhere::IndexFactory::Instance()
+                       .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+                       .value();
+        knowhere::Json json = sparse_inverted_index_gen();
+        REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+        const float radius = metric == knowhere::metric::BM25 ? 80.0 : 0.5;
+        const int32_t range_search_k = 3;
+        json[knowhere::meta::RADIUS] = radius;
+        json[knowhere::meta::RANGE_SEARCH_K] = range_search_k;
+        auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+        knowhere::BitsetView bitset(bitset_data.data(), nb);
+
+        auto results = idx.RangeSearch(query_ds, json, bitset);
+        REQUIRE(results.has_value());
+        auto gt =
+            knowhere::BruteForce::RangeSearch<knowhere::sparse::SparseRow<float>>(train_ds, query_ds, json, bitset);
+        REQUIRE(gt.has_value());
+
+        auto lims = results.value()->GetLims();
+        auto ids = results.value()->GetIds();
+        auto distances = results.value()->GetDistance();
+        auto lims_gt = gt.value()->GetLims();
+        auto distances_gt = gt.value()->GetDistance();
+        // the best range_search_k of the vectors in range
+        for (int i = 0; i < nq; ++i) {
+            std::vector<float> best_gt(distances_gt + lims_gt[i], distances_gt + lims_gt[i + 1]);
+            std::sort(best_gt.rbegin(), best_gt.rend());
+            best_gt.resize(std::min<size_t>(best_gt.size(), range_search_k));
+            std::vector<float> best(distances + lims[i], distances + lims[i + 1]);
+            std::sort(best.rbegin(), best.rend());
+            REQUIRE(best.size() == best_gt.size());
+            for (size_t j = 0; j < best.size(); ++j) {
+                REQUIRE_THAT(best[j], Catch::Matchers::WithinRel(best_gt[j], 1e-3f));
+            }
+            for (size_t j = lims[i]; j < lims[i + 1]; ++j) {
+                REQUIRE(!bitset.test(ids[j]));
+            }
+        }
+    }
 }
 
 TEST_CASE("Test Mem Sparse Index Handle Empty Vector", "[float metrics]") {
@@ -468,7 +670,7 @@ TEST_CASE("Test Mem Sparse Index CC", "[float metrics]") {
 
     auto query_ds = doc_vector_gen(nq, dim);
 
-    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE");
+    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND");
 
     auto drop_ratio_search = GENERATE(0.0, 0.3);
 
@@ -562,6 +764,32 @@ TEST_CASE("Test Mem Sparse Index CC", "[float metrics]") {
         }
     }
 
+    SECTION("Test Search sees the rows added before it") {
+        // searches don't wait for adds, they see all the batches that were added before they started
+        auto snapshot_search_task = [&]() {
+            auto start = std::chrono::steady_clock::now();
+            while (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count() <
+                   test_time) {
+                auto count_before = idx.Count();
+                auto results = idx.Search(query_ds, json, nullptr);
+                auto count_after = idx.Count();
+                REQUIRE(results.has_value());
+                check_result(*results.value());
+                auto batch = results.value()->GetIds()[0] / nb;
+                REQUIRE(batch >= count_before / nb - 1);
+                REQUIRE(batch <= count_after / nb - 1);
+            }
+        };
+        std::vector<std::future<void>> task_list;
+        for (int thread = 0; thread < 5; thread++) {
+            task_list.push_back(std::async(std::launch::async, snapshot_search_task));
+        }
+        task_list.push_back(std::async(std::launch::async, add_task));
+        for (auto& task : task_list) {
+            task.wait();
+        }
+    }
+
     SECTION("Test GetVectorByIds") {
         std::vector<int64_t> ids = {0, 1, 2};
         REQUIRE(idx.HasRawData(metric) == knowhere::IndexStaticFaced<knowhere::fp32>::HasRawData(name, version, json));
@@ -579,3 +807,367 @@ TEST_CASE("Test Mem Sparse Index CC", "[float metrics]") {
         }
     }
 }
+
+TEST_CASE("Test Mem Sparse Index Search in Shards", "[float metrics]") {
+    // large enough for a single query to be split into shards of the ids
+    auto nb = 300000;
+    auto dim = 1000;
+    auto topk = 10;
+    int64_t nq = 1;
+
+    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND");
+    auto version = GenTestVersionList();
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = knowhere::metric::IP;
+    json[knowhere::meta::TOPK] = topk;
+    json[knowhere::indexparam::INVERTED_INDEX_ALGO] = inverted_index_algo;
+
+    auto train_ds = GenSparseDataSet(nb, dim, 0.99);
+    auto query_ds = GenSparseDataSet(nq, dim, 0.95);
+    auto gt = knowhere::BruteForce::SearchSparse(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    auto idx = knowhere::IndexFactory::Instance()
+                   .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+                   .value();
+    REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+
+    auto bitset_data = GenerateBitsetWithRandomTbitsSet(nb, nb / 2);
+    knowhere::BitsetView bitset(bitset_data.data(), nb);
+    auto filtered_gt = knowhere::BruteForce::SearchSparse(train_ds, query_ds, json, bitset);
+    REQUIRE(filtered_gt.has_value());
+
+    auto results = idx.Search(query_ds, json, nullptr);
+    REQUIRE(results.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *results.value()) == 1);
+    auto filtered_results = idx.Search(query_ds, json, bitset);
+    REQUIRE(filtered_results.has_value());
+    REQUIRE(GetKNNRecall(*filtered_gt.value(), *filtered_results.value()) == 1);
+}
+
+TEST_CASE("Test Mem Sparse Index Merge", "[float metrics]") {
+    auto nb = 2000;
+    auto dim = 1000;
+    auto topk = 10;
+    int64_t nq = 20;
+
+    auto metric = GENERATE(knowhere::metric::IP, knowhere::metric::BM25);
+    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND");
+    auto reorder_doc_ids = GENERATE(false, true);
+    auto version = GenTestVersionList();
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = metric;
+    json[knowhere::meta::TOPK] = topk;
+    json[knowhere::meta::BM25_K1] = 1.2;
+    json[knowhere::meta::BM25_B] = 0.75;
+    json[knowhere::meta::BM25_AVGDL] = 100;
+    json[knowhere::indexparam::INVERTED_INDEX_ALGO] = inverted_index_algo;
+    json[knowhere::indexparam::REORDER_DOC_IDS] = reorder_doc_ids;
+
+    auto train_ds = GenSparseDataSetWithMaxVal(nb, dim, 0.99, 10, metric == knowhere::metric::BM25);
+    auto query_ds = GenSparseDataSet(nq, dim, 0.95, 7);
+
+    // two segments over the halves of the data
+    auto rows = static_cast<const knowhere::sparse::SparseRow<float>*>(train_ds->GetTensor());
+    auto first_ds = knowhere::GenDataSet(nb / 2, dim, rows);
+    first_ds->SetIsSparse(true);
+    auto second_ds = knowhere::GenDataSet(nb - nb / 2, dim, rows + nb / 2);
+    second_ds->SetIsSparse(true);
+
+    auto create = [&]() {
+        return knowhere::IndexFactory::Instance()
+            .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+            .value();
+    };
+    auto full = create();
+    auto index = create();
+    auto other = create();
+    REQUIRE(full.Build(train_ds, json) == knowhere::Status::success);
+    REQUIRE(index.Build(first_ds, json) == knowhere::Status::success);
+    REQUIRE(other.Build(second_ds, json) == knowhere::Status::success);
+
+    REQUIRE(index.Merge({other}, json) == knowhere::Status::success);
+    REQUIRE(index.Count() == nb);
+    REQUIRE(other.Count() == nb - nb / 2);
+
+    // the merged index scores the rows like the one built over all of them
+    auto expected = full.Search(query_ds, json, nullptr);
+    REQUIRE(expected.has_value());
+    auto results = index.Search(query_ds, json, nullptr);
+    REQUIRE(results.has_value());
+    using Catch::Approx;
+    for (int64_t i = 0; i < nq * topk; ++i) {
+        REQUIRE(results.value()->GetDistance()[i] == Approx(expected.value()->GetDistance()[i]));
+    }
+
+    // the ids of the merged index survive a round trip
+    knowhere::BinarySet bs;
+    REQUIRE(index.Serialize(bs) == knowhere::Status::success);
+    auto loaded = create();
+    REQUIRE(loaded.Deserialize(bs, json) == knowhere::Status::success);
+    auto loaded_results = loaded.Search(query_ds, json, nullptr);
+    REQUIRE(loaded_results.has_value());
+    for (int64_t i = 0; i < nq * topk; ++i) {
+        REQUIRE(loaded_results.value()->GetIds()[i] == results.value()->GetIds()[i]);
+    }
+}
+
+TEST_CASE("Test Mem Sparse Index Parallel Add", "[float metrics]") {
+    // above kAddShardMinRows, the rows of an Add() are indexed by shards of rows in parallel
+    const int64_t nb = 80000;
+    const int64_t batch = 10000;
+    auto dim = 1000;
+    auto topk = 10;
+    int64_t nq = 20;
+
+    auto metric = GENERATE(knowhere::metric::IP, knowhere::metric::BM25);
+    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_WAND", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND");
+    auto version = GenTestVersionList();
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = metric;
+    json[knowhere::meta::TOPK] = topk;
+    json[knowhere::meta::BM25_K1] = 1.2;
+    json[knowhere::meta::BM25_B] = 0.75;
+    json[knowhere::meta::BM25_AVGDL] = 100;
+    json[knowhere::indexparam::INVERTED_INDEX_ALGO] = inverted_index_algo;
+
+    auto train_ds = GenSparseDataSetWithMaxVal(nb, dim, 0.99, 10, metric == knowhere::metric::BM25);
+    auto query_ds = GenSparseDataSet(nq, dim, 0.95, 7);
+    auto rows = static_cast<const knowhere::sparse::SparseRow<float>*>(train_ds->GetTensor());
+    auto slice = [&](int64_t begin, int64_t end) {
+        auto ds = knowhere::GenDataSet(end - begin, dim, rows + begin);
+        ds->SetIsSparse(true);
+        return ds;
+    };
+
+    auto create = [&]() {
+        return knowhere::IndexFactory::Instance()
+            .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+            .value();
+    };
+    // the second half goes to an index that has rows already
+    auto parallel = create();
+    REQUIRE(parallel.Build(slice(0, nb / 2), json) == knowhere::Status::success);
+    REQUIRE(parallel.Add(slice(nb / 2, nb), json) == knowhere::Status::success);
+    auto serial = create();
+    REQUIRE(serial.Train(slice(0, batch), json) == knowhere::Status::success);
+    for (int64_t begin = 0; begin < nb; begin += batch) {
+        REQUIRE(serial.Add(slice(begin, begin + batch), json) == knowhere::Status::success);
+    }
+    REQUIRE(parallel.Count() == nb);
+    REQUIRE(serial.Count() == nb);
+
+    // the posting lists, their max scores and the doc lengths are the same
+    auto expected = serial.Search(query_ds, json, nullptr);
+    REQUIRE(expected.has_value());
+    auto results = parallel.Search(query_ds, json, nullptr);
+    REQUIRE(results.has_value());
+    for (int64_t i = 0; i < nq * topk; ++i) {
+        REQUIRE(results.value()->GetIds()[i] == expected.value()->GetIds()[i]);
+        REQUIRE(results.value()->GetDistance()[i] == expected.value()->GetDistance()[i]);
+    }
+}
+
+TEST_CASE("Test Mem Sparse Index With Scattered Dims", "[float metrics]") {
+    // the dims of a sealed index are looked up in a direct array when they are dense, in the hash table otherwise
+    auto nb = 2000;
+    auto topk = 10;
+    int64_t nq = 20;
+
+    auto stride = GENERATE(1, 1000003);
+    auto inverted_index_algo = GENERATE("TAAT_NAIVE", "DAAT_MAXSCORE", "DAAT_BLOCK_MAX_WAND");
+    const int32_t dim = 1000 * stride;
+    auto version = GenTestVersionList();
+
+    auto scatter = [&](int32_t rows, int seed) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int32_t> dims(0, 999);
+        std::uniform_real_distribution<float> vals(0.1f, 1.0f);
+        std::vector<std::map<int32_t, float>> data(rows);
+        for (auto& row : data) {
+            for (int j = 0; j < 10; ++j) {
+                row[dims(rng) * stride] = vals(rng);
+            }
+        }
+        return GenSparseDataSet(data, dim);
+    };
+    auto train_ds = scatter(nb, 42);
+    auto query_ds = scatter(nq, 7);
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = knowhere::metric::IP;
+    json[knowhere::meta::TOPK] = topk;
+    json[knowhere::indexparam::INVERTED_INDEX_ALGO] = inverted_index_algo;
+
+    auto idx = knowhere::IndexFactory::Instance()
+                   .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+                   .value();
+    REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+    auto gt = knowhere::BruteForce::SearchSparse(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+    auto results = idx.Search(query_ds, json, nullptr);
+    REQUIRE(results.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= 0.99f);
+
+    // the dims of the loaded index are looked up like the ones of the built one
+    knowhere::BinarySet bs;
+    REQUIRE(idx.Serialize(bs) == knowhere::Status::success);
+    auto loaded = knowhere::IndexFactory::Instance()
+                      .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+                      .value();
+    REQUIRE(loaded.Deserialize(bs, json) == knowhere::Status::success);
+    auto loaded_results = loaded.Search(query_ds, json, nullptr);
+    REQUIRE(loaded_results.has_value());
+    for (int64_t i = 0; i < nq * topk; ++i) {
+        REQUIRE(loaded_results.value()->GetIds()[i] == results.value()->GetIds()[i]);
+    }
+}
+
+TEST_CASE("Test Mem Sparse Index SAAT Anytime Budget", "[float metrics]") {
+    auto nb = 5000;
+    auto dim = 1000;
+    auto topk = 10;
+    int64_t nq = 20;
+
+    auto metric = GENERATE(knowhere::metric::IP, knowhere::metric::BM25);
+    auto version = GenTestVersionList();
+
+    auto train_ds = metric == knowhere::metric::BM25 ? GenSparseDataSetWithMaxVal(nb, dim, 0.97, 256, true)
+                                                      : GenSparseDataSet(nb, dim, 0.97);
+    auto query_ds = metric == knowhere::metric::BM25 ? GenSparseDataSetWithMaxVal(nq, dim, 0.97, 256, true, 7)
+                                                      : GenSparseDataSet(nq, dim, 0.97, 7);
+
+    knowhere::Json json;
+    json[knowhere::meta::DIM] = dim;
+    json[knowhere::meta::METRIC_TYPE] = metric;
+    json[knowhere::meta::TOPK] = topk;
+    json[knowhere::meta::BM25_K1] = 1.2;
+    json[knowhere::meta::BM25_B] = 0.75;
+    json[knowhere::meta::BM25_AVGDL] = 100;
+    json[knowhere::indexparam::INVERTED_INDEX_ALGO] = "SAAT_ANYTIME";
+    json[knowhere::meta::SEARCH_STATS] = true;
+
+    auto idx = knowhere::IndexFactory::Instance()
+                   .Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version)
+                   .value();
+    REQUIRE(idx.Build(train_ds, json) == knowhere::Status::success);
+    auto gt = knowhere::BruteForce::SearchSparse(train_ds, query_ds, json, nullptr);
+    REQUIRE(gt.has_value());
+
+    // without a budget the search runs until its top-k is exact
+    auto results = idx.Search(query_ds, json, nullptr);
+    REQUIRE(results.has_value());
+    REQUIRE(GetKNNRecall(*gt.value(), *results.value()) >= 0.99f);
+    auto stats = results.value()->Get<knowhere::SearchStatsVec>(knowhere::meta::SEARCH_STATS);
+    REQUIRE(stats.size() == (size_t)nq);
+    for (const auto& s : stats) {
+        REQUIRE(!s.early_terminated);
+    }
+
+    // a budget of one posting stops every search after its first block of postings, the results are rescored exactly
+    json[knowhere::indexparam::SEARCH_POSTING_BUDGET] = 1;
+    auto budget_results = idx.Search(query_ds, json, nullptr);
+    REQUIRE(budget_results.has_value());
+    stats = budget_results.value()->Get<knowhere::SearchStatsVec>(knowhere::meta::SEARCH_STATS);
+    REQUIRE(stats.size() == (size_t)nq);
+    int64_t n_terminated = 0;
+    for (int64_t i = 0; i < nq; ++i) {
+        n_terminated += stats[i].early_terminated;
+        REQUIRE(budget_results.value()->GetIds()[i * topk] != -1);
+        for (int j = 0; j + 1 < topk && budget_results.value()->GetIds()[i * topk + j + 1] != -1; ++j) {
+            REQUIRE(budget_results.value()->GetDistance()[i * topk + j] >=
+                    budget_results.value()->GetDistance()[i * topk + j + 1]);
+        }
+    }
+    REQUIRE(n_terminated > 0);
+}
+
+TEST_CASE("Test hybrid dense and sparse search", "[float metrics]") {
+    const int64_t nb = 2000, nq = 20, dim = 16, sparse_dim = 200;
+    const int64_t topk = 10;
+    auto version = knowhere::Version::GetCurrentVersion().VersionNumber();
+    auto dense_weight = GENERATE(as<float>{}, 0.3f, 1.0f);
+
+    auto dense_ds = GenDataSet(nb, dim, 42);
+    auto dense_query_ds = GenDataSet(nq, dim, 123);
+    auto sparse_ds = GenSparseDataSet(nb, sparse_dim, 0.95f, 42);
+    auto sparse_query_ds = GenSparseDataSet(nq, sparse_dim, 0.9f, 123);
+
+    knowhere::Json dense_json;
+    dense_json[knowhere::meta::DIM] = dim;
+    dense_json[knowhere::meta::METRIC_TYPE] = knowhere::metric::IP;
+    dense_json[knowhere::meta::TOPK] = topk;
+    knowhere::Json sparse_json;
+    sparse_json[knowhere::meta::DIM] = sparse_dim;
+    sparse_json[knowhere::meta::METRIC_TYPE] = knowhere::metric::IP;
+    sparse_json[knowhere::meta::TOPK] = topk;
+
+    auto dense =
+        knowhere::IndexFactory::Instance().Create<knowhere::fp32>(knowhere::IndexEnum::INDEX_FAISS_IDMAP, version);
+    REQUIRE(dense.value().Build(dense_ds, dense_json) == knowhere::Status::success);
+    auto sparse = knowhere::IndexFactory::Instance().Create<knowhere::fp32>(
+        knowhere::IndexEnum::INDEX_SPARSE_INVERTED_INDEX, version);
+    REQUIRE(sparse.value().Build(sparse_ds, sparse_json) == knowhere::Status::success);
+
+    knowhere::HybridSearchOptions options;
+    options.k = topk;
+    options.dense_weight = dense_weight;
+    options.sparse_weight = 1.0f;
+    auto result = knowhere::Index<knowhere::IndexNode>::HybridSearch(
+        dense.value(), dense_query_ds, dense_json, sparse.value(), sparse_query_ds, sparse_json, nullptr, options);
+    REQUIRE(result.has_value());
+    REQUIRE(result.value()->GetRows() == nq);
+    REQUIRE(result.value()->GetDim() == topk);
+
+    // the fused scores of all the rows
+    const float* xb = reinterpret_cast<const float*>(dense_ds->GetTensor());
+    const float* xq = reinterpret_cast<const float*>(dense_query_ds->GetTensor());
+    const auto* sb = static_cast<const knowhere::sparse::SparseRow<float>*>(sparse_ds->GetTensor());
+    const auto* sq = static_cast<const knowhere::sparse::SparseRow<float>*>(sparse_query_ds->GetTensor());
+    int64_t hits = 0;
+    for (int64_t q = 0; q < nq; q++) {
+        std::vector<std::pair<float, int64_t>> fused(nb);
+        for (int64_t i = 0; i < nb; i++) {
+            float ip = 0.0f;
+            for (int64_t j = 0; j < dim; j++) {
+                ip += xq[q * dim + j] * xb[i * dim + j];
+            }
+            fused[i] = {dense_weight * ip + sq[q].dot(sb[i]), i};
+        }
+        std::partial_sort(fused.begin(), fused.begin() + topk, fused.end(), std::greater<>());
+        std::unordered_set<int64_t> expected_ids;
+        for (int64_t i = 0; i < topk; i++) {
+            expected_ids.insert(fused[i].second);
+        }
+        for (int64_t i = 0; i < topk; i++) {
+            const int64_t id = result.value()->GetIds()[q * topk + i];
+            hits += expected_ids.count(id);
+            if (i > 0) {
+                REQUIRE(result.value()->GetDistance()[q * topk + i] <= result.value()->GetDistance()[q * topk + i - 1]);
+            }
+            // the reported score is the fused one
+            if (id >= 0) {
+                float ip = 0.0f;
+                for (int64_t j = 0; j < dim; j++) {
+                    ip += xq[q * dim + j] * xb[id * dim + j];
+                }
+                REQUIRE(result.value()->GetDistance()[q * topk + i] ==
+                        Catch::Approx(dense_weight * ip + sq[q].dot(sb[id])).epsilon(1e-4));
+            }
+        }
+    }
+    REQUIRE(hits >= nq * topk * 0.9);
+
+    // the fused scores are similarities
+    dense_json[knowhere::meta::METRIC_TYPE] = knowhere::metric::L2;
+    result = knowhere::Index<knowhere::IndexNode>::HybridSearch(
+        dense.value(), dense_query_ds, dense_json, sparse.value(), sparse_query_ds, sparse_json, nullptr, options);
+    REQUIRE(result.error() == knowhere::Status::invalid_metric_type);
+}
@@ -16,6 +16,8 @@
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
+#include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/trace_span.h"
 #include "knowhere/tracer.h"
 
 using namespace knowhere::tracer;
@@ -81,3 +83,35 @@ TEST_CASE("Test Tracer span", "Span test") {
     delete[] ctx->traceID;
     delete[] ctx->spanID;
 }
+
+TEST_CASE("Test Tracer child spans", "Child span test") {
+    auto config = std::make_shared<TraceConfig>();
+    config->exporter = "stdout";
+    config->nodeID = 1;
+    initTelemetry(*config);
+
+    // without a parent the spans start nothing
+    REQUIRE(knowhere::TraceParent::Current() == nullptr);
+    {
+        knowhere::ScopedTraceSpan span("unsampled");
+        span.SetAttribute("rows", 1);
+    }
+
+    auto root = StartSpan("root");
+    knowhere::TraceParent parent(root);
+    {
+        knowhere::ScopedTraceParent scoped_parent(&parent);
+        // the tasks of the search thread pool start their spans under the same parent
+        auto pool = knowhere::ThreadPool::GetGlobalSearchThreadPool();
+        auto task_parent = pool->push([] { return knowhere::TraceParent::Current(); });
+        REQUIRE(std::move(task_parent).get() == &parent);
+        for (int64_t i = 0; i < knowhere::kMaxChildSpans; i++) {
+            knowhere::ScopedTraceSpan span("child");
+            span.SetAttribute("index", i);
+        }
+        // the spans past the budget are left out
+        REQUIRE_FALSE(parent.TakeSpan());
+    }
+    REQUIRE(knowhere::TraceParent::Current() == nullptr);
+    root->End();
+}
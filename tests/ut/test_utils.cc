@@ -9,14 +9,33 @@
 // is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
 // or implied. See the License for the specific language governing permissions and limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <shared_mutex>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 #include "catch2/catch_approx.hpp"
 #include "catch2/catch_test_macros.hpp"
+#include "io/memory_io.h"
+#include "knowhere/comp/binary_compression.h"
+#include "knowhere/comp/index_container.h"
+#include "knowhere/comp/numa.h"
+#include "knowhere/comp/rw_lock.h"
+#include "knowhere/comp/search_arena.h"
+#include "knowhere/comp/search_coalescer.h"
+#include "knowhere/comp/search_phases.h"
+#include "knowhere/comp/search_planner.h"
 #include "knowhere/comp/thread_pool.h"
 #include "knowhere/comp/time_recorder.h"
+#include "knowhere/comp/topk_merge.h"
+#include "knowhere/dataset.h"
 #include "knowhere/expected.h"
 #include "knowhere/heap.h"
 #include "knowhere/utils.h"
@@ -111,6 +130,60 @@ TEST_CASE("Test Bitset Generation", "[utils]") {
             }
         }
     }
+
+    SECTION("Id lists") {
+        for (const auto size : kBitsetSizes) {
+            for (size_t i = 0; i <= size; i += std::max<size_t>(1, size / 7)) {
+                auto bitset_data = GenerateBitsetWithRandomTbitsSet(size, i);
+                knowhere::BitsetView bitmap(bitset_data.data(), size);
+                std::vector<int64_t> valid_ids, filtered_out_ids;
+                for (size_t j = 0; j < size; ++j) {
+                    (bitmap.test(j) ? filtered_out_ids : valid_ids).push_back(j);
+                }
+                const auto valid = knowhere::BitsetView::FromValidIds(valid_ids.data(), valid_ids.size(), size);
+                const auto filtered_out =
+                    knowhere::BitsetView::FromFilteredOutIds(filtered_out_ids.data(), filtered_out_ids.size(), size);
+                for (const auto& bitset : {valid, filtered_out}) {
+                    REQUIRE(!bitset.is_bitmap());
+                    REQUIRE(bitset.count() == i);
+                    REQUIRE(bitset.get_filtered_out_num_() == i);
+                    REQUIRE(bitset.get_first_valid_index() == bitmap.get_first_valid_index());
+                    for (size_t j = 0; j < size + 2; ++j) {
+                        REQUIRE(bitset.test(j) == bitmap.test(j));
+                    }
+                    std::vector<size_t> visited;
+                    bitset.for_each_valid_index(1, size, [&](size_t j) { visited.push_back(j); });
+                    std::vector<size_t> expected;
+                    bitmap.for_each_valid_index(1, size, [&](size_t j) { expected.push_back(j); });
+                    REQUIRE(visited == expected);
+                    std::vector<uint8_t> bits(bitmap.byte_size());
+                    bitset.copy_bits(bits.data());
+                    REQUIRE(bits == bitset_data);
+                }
+            }
+        }
+    }
+
+    SECTION("Stats") {
+        const size_t size = 3 * knowhere::BitsetStats::kBlockBits + 100;
+        for (size_t i : {size_t(0), size_t(1), size / 2, size - 1, size}) {
+            // the first i bits are set, so the blocks before the i-th bit are skipped
+            auto bitset_data = GenerateBitsetWithFirstTbitsSet(size, i);
+            knowhere::BitsetView bitmap(bitset_data.data(), size, i);
+            const auto stats = knowhere::BitsetStats::Compute(bitset_data.data(), size);
+            const auto bitset = knowhere::BitsetView::WithStats(bitset_data.data(), size, &stats);
+            REQUIRE(stats.filtered_out_num == i);
+            REQUIRE(stats.first_valid_index == bitmap.get_first_valid_index());
+            REQUIRE(stats.last_valid_index == (i == size ? size : size - 1));
+            REQUIRE(bitset.count() == i);
+            REQUIRE(bitset.get_filtered_out_num_() == i);
+            REQUIRE(bitset.with_filtered_out_num().stats() == &stats);
+            std::vector<size_t> visited;
+            bitset.for_each_valid_index(0, size, [&](size_t j) { visited.push_back(j); });
+            REQUIRE(visited.size() == size - i);
+            REQUIRE((visited.empty() || visited[0] == i));
+        }
+    }
 }
 
 namespace {
@@ -145,6 +218,267 @@ TEST_CASE("Test Time Recorder") {
     REQUIRE(sum > 0);
 }
 
+TEST_CASE("Test ChunkedMemoryIOWriter") {
+    const size_t n = 3 * knowhere::ChunkedMemoryIOWriter::kFirstChunkSize + 17;
+    std::vector<uint8_t> bytes(n);
+    for (size_t i = 0; i < n; i++) {
+        bytes[i] = static_cast<uint8_t>(i * 31);
+    }
+    auto serialize = [&bytes, n](knowhere::BinarySet& binset) {
+        knowhere::ChunkedMemoryIOWriter writer;
+        writer(bytes.data(), 1, 1000);
+        writer(bytes.data() + 1000, 1, n - 1000);
+        REQUIRE(writer.tellg() == n);
+        binset.AppendChunks("index", writer.Release(), writer.tellg());
+    };
+
+    knowhere::BinarySet chunked;
+    chunked.SetKeepChunks(true);
+    serialize(chunked);
+    // 1MB, 2MB and 4MB blocks
+    const auto& binary = chunked.binary_map_.at("index");
+    REQUIRE(binary->IsChunked());
+    REQUIRE(binary->chunks.size() == 3);
+    REQUIRE(chunked.Size() == n);
+    auto flat = chunked.GetByName("index");
+    REQUIRE(!flat->IsChunked());
+    REQUIRE(std::memcmp(flat->data.get(), bytes.data(), n) == 0);
+
+    knowhere::BinarySet binset;
+    serialize(binset);
+    REQUIRE(!binset.binary_map_.at("index")->IsChunked());
+    REQUIRE(binset.GetByName("index")->size == static_cast<int64_t>(n));
+    REQUIRE(std::memcmp(binset.GetByName("index")->data.get(), bytes.data(), n) == 0);
+}
+
+TEST_CASE("Test BinarySet compression") {
+    // a compressible binary over several chunks, whose last chunk is random
+    const size_t n = 2 * knowhere::kCompressionChunkSize + 1000;
+    std::shared_ptr<uint8_t[]> ids(new uint8_t[n]);
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < n; i++) {
+        ids[i] = i < 2 * knowhere::kCompressionChunkSize ? static_cast<uint8_t>(i / 1024) : rng();
+    }
+    const size_t m = knowhere::kCompressionChunkSize;
+    std::shared_ptr<uint8_t[]> codes(new uint8_t[m]);
+    for (size_t i = 0; i < m; i++) {
+        codes[i] = rng();
+    }
+    auto check = [&](bool keep_chunks) {
+        knowhere::BinarySet binset;
+        binset.SetKeepChunks(keep_chunks);
+        binset.Append("ids", ids, n);
+        binset.Append("codes", codes, m);
+        REQUIRE(knowhere::CompressBinarySet(binset) == knowhere::Status::success);
+        REQUIRE(knowhere::IsCompressedBinary(*binset.binary_map_.at("ids")));
+        REQUIRE(binset.binary_map_.at("ids")->IsChunked() == keep_chunks);
+        REQUIRE(binset.binary_map_.at("ids")->size < static_cast<int64_t>(n / 4));
+        // nothing is gained on random bytes, they are left as they are
+        REQUIRE(binset.binary_map_.at("codes")->data == codes);
+
+        REQUIRE(knowhere::DecompressBinarySet(binset) == knowhere::Status::success);
+        auto binary = binset.GetByName("ids");
+        REQUIRE(binary->size == static_cast<int64_t>(n));
+        REQUIRE(std::memcmp(binary->data.get(), ids.get(), n) == 0);
+        REQUIRE(binset.GetByName("codes")->data == codes);
+    };
+    check(false);
+    check(true);
+
+    knowhere::BinarySet truncated;
+    truncated.Append("ids", ids, n);
+    REQUIRE(knowhere::CompressBinarySet(truncated) == knowhere::Status::success);
+    truncated.binary_map_.at("ids")->size -= 1;
+    REQUIRE(knowhere::DecompressBinarySet(truncated) == knowhere::Status::invalid_binary_set);
+}
+
+TEST_CASE("Test IndexContainer") {
+    constexpr const char* kContainerPath = "/tmp/knowhere_index_container_test";
+    const size_t n = 10000;
+    std::shared_ptr<uint8_t[]> graph(new uint8_t[n]);
+    for (size_t i = 0; i < n; i++) {
+        graph[i] = static_cast<uint8_t>(i * 7);
+    }
+    knowhere::BinarySet binset;
+    binset.Append("graph", graph, n);
+    std::shared_ptr<uint8_t[]> meta(new uint8_t[5]);
+    std::memcpy(meta.get(), "meta!", 5);
+    binset.Append("meta", meta, 5);
+    // a chunked binary is written chunk by chunk
+    auto codes = std::make_shared<knowhere::Binary>();
+    codes->size = n;
+    codes->chunks = {{graph, 3000}, {std::shared_ptr<uint8_t[]>(graph, graph.get() + 3000), n - 3000}};
+    binset.Append("codes", codes);
+    REQUIRE(knowhere::WriteIndexContainer(binset, kContainerPath) == knowhere::Status::success);
+
+    auto reader = knowhere::IndexContainerReader::Open(kContainerPath);
+    REQUIRE(reader.has_value());
+    REQUIRE(reader.value()->Sections().size() == 3);
+    for (const auto& section : reader.value()->Sections()) {
+        REQUIRE(section.offset % knowhere::kContainerPageSize == 0);
+    }
+    auto read = reader.value()->Read("graph");
+    REQUIRE(read.has_value());
+    REQUIRE(std::memcmp(read.value()->data.get(), graph.get(), n) == 0);
+    auto mapped = reader.value()->Map("codes", true);
+    REQUIRE(mapped.has_value());
+    REQUIRE(std::memcmp(mapped.value()->data.get(), graph.get(), n) == 0);
+
+    // only the sections asked for are loaded
+    knowhere::BinarySet loaded;
+    REQUIRE(reader.value()->Load(loaded, {"meta"}, true) == knowhere::Status::success);
+    REQUIRE(!loaded.Contains("graph"));
+    REQUIRE(std::memcmp(loaded.GetByName("meta")->data.get(), "meta!", 5) == 0);
+    REQUIRE(!reader.value()->Read("missing").has_value());
+
+    // a corrupted section fails its checksum
+    {
+        std::fstream file(kContainerPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(reader.value()->Find("graph")->offset + 5);
+        file.put(static_cast<char>(graph[5] + 1));
+    }
+    REQUIRE(reader.value()->Read("graph").error() == knowhere::Status::invalid_binary_set);
+    std::remove(kContainerPath);
+}
+
+TEST_CASE("Test SearchPlanner") {
+    knowhere::SearchPlanInput input;
+    input.ntotal = 1000000;
+    input.dim = 128;
+    input.k = 10;
+    input.ef = 64;
+    const knowhere::SearchCostModel model;
+    REQUIRE(knowhere::SearchPlanner::Estimate(input, model).plan == knowhere::SearchPlan::GRAPH);
+    REQUIRE(knowhere::SearchPlanner::Estimate(input, model).ivf < 0);
+
+    // few valid rows are cheaper to scan than to find in the graph
+    input.filtered_out_num = input.ntotal - 100;
+    REQUIRE(knowhere::SearchPlanner::Estimate(input, model).plan == knowhere::SearchPlan::BRUTE_FORCE);
+
+    input.filtered_out_num = 0;
+    input.ef = 0;
+    input.nlist = 1024;
+    input.nprobe = 16;
+    REQUIRE(knowhere::SearchPlanner::Estimate(input, model).plan == knowhere::SearchPlan::IVF);
+
+    SECTION("Calibration") {
+        std::vector<knowhere::SearchPlanSample> samples;
+        const auto brute_force = knowhere::SearchPlanner::Estimate(input, model).brute_force;
+        for (const double scale : {1.0, 2.0}) {
+            auto sample_input = input;
+            sample_input.ntotal *= scale;
+            samples.push_back({sample_input, knowhere::SearchPlan::BRUTE_FORCE, 50.0 * scale});
+        }
+        const auto calibrated = knowhere::SearchPlanner::Calibrate(samples, model);
+        REQUIRE(calibrated.brute_force == Catch::Approx(50.0 / brute_force));
+        REQUIRE(calibrated.graph == model.graph);
+        REQUIRE(calibrated.ivf == model.ivf);
+    }
+
+    SECTION("Global model") {
+        knowhere::SearchCostModel graph_only;
+        graph_only.brute_force = 1e9;
+        knowhere::SearchPlanner::SetCostModel(graph_only);
+        knowhere::SearchPlanner::SetEnabled(true);
+        input.ef = 64;
+        REQUIRE(knowhere::SearchPlanner::Enabled());
+        REQUIRE(knowhere::SearchPlanner::Plan(input).plan != knowhere::SearchPlan::BRUTE_FORCE);
+        knowhere::SearchPlanner::SetEnabled(false);
+        knowhere::SearchPlanner::SetCostModel(model);
+    }
+}
+
+TEST_CASE("Test SearchCoalescer") {
+    const int64_t k = 2;
+    const int64_t n_requests = 8;
+    knowhere::SearchCoalescer::SetLimits(n_requests, std::chrono::milliseconds(200));
+    knowhere::SearchCoalescer coalescer;
+    std::atomic<int64_t> n_searches = 0;
+    std::atomic<int64_t> n_queries = 0;
+    // the ids of a query are its value and the value + 1
+    auto search = [&](const void* queries, int64_t nq, int64_t* ids, float* dists) {
+        n_searches++;
+        n_queries += nq;
+        for (int64_t i = 0; i < nq; i++) {
+            const float query = static_cast<const float*>(queries)[i];
+            for (int64_t j = 0; j < k; j++) {
+                ids[i * k + j] = static_cast<int64_t>(query) + j;
+                dists[i * k + j] = query;
+            }
+        }
+        return knowhere::Status::success;
+    };
+
+    std::vector<int64_t> ids(n_requests * k);
+    std::vector<float> dists(n_requests * k);
+    std::vector<knowhere::Status> statuses(n_requests);
+    std::vector<std::thread> threads;
+    for (int64_t i = 0; i < n_requests; i++) {
+        threads.emplace_back([&, i]() {
+            const float query = i * 10;
+            const auto key = i % 2 == 0 ? "even" : "odd";
+            statuses[i] =
+                coalescer.Search(key, &query, 1, sizeof(float), k, ids.data() + i * k, dists.data() + i * k, search);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    knowhere::SearchCoalescer::SetLimits(0, std::chrono::microseconds(0));
+
+    REQUIRE(n_queries.load() == n_requests);
+    // the requests of a key share batches, the keys never do
+    REQUIRE(n_searches.load() >= 2);
+    REQUIRE(n_searches.load() < n_requests);
+    for (int64_t i = 0; i < n_requests; i++) {
+        REQUIRE(statuses[i] == knowhere::Status::success);
+        REQUIRE(ids[i * k] == i * 10);
+        REQUIRE(ids[i * k + 1] == i * 10 + 1);
+        REQUIRE(dists[i * k] == i * 10);
+    }
+}
+
+TEST_CASE("Test ReaderBiasedRWLock") {
+    knowhere::ReaderBiasedRWLock lock;
+    int64_t a = 0;
+    int64_t b = 0;
+    std::atomic<bool> stop = false;
+    std::atomic<int64_t> torn_reads = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 8; i++) {
+        readers.emplace_back([&]() {
+            while (!stop.load()) {
+                std::shared_lock<knowhere::ReaderBiasedRWLock> outer(lock);
+                // taking it shared again never waits for the writers
+                std::shared_lock<knowhere::ReaderBiasedRWLock> inner(lock);
+                if (a != b) {
+                    torn_reads++;
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 2; i++) {
+        writers.emplace_back([&]() {
+            for (int j = 0; j < 1000; j++) {
+                std::unique_lock<knowhere::ReaderBiasedRWLock> guard(lock);
+                a++;
+                b++;
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    stop.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    REQUIRE(torn_reads.load() == 0);
+    REQUIRE(a == 2000);
+    REQUIRE(b == 2000);
+}
+
 TEST_CASE("Test Version") {
     REQUIRE(knowhere::Version::VersionSupport(knowhere::Version::GetDefaultVersion()));
     REQUIRE(knowhere::Version::VersionSupport(knowhere::Version::GetMinimalVersion()));
@@ -228,6 +562,209 @@ TEST_CASE("Test ThreadPool") {
         auto thread_num_2 = omp_get_max_threads();
         REQUIRE(thread_num_2 == prev_num_threads);
     }
+
+    SECTION("Priority queue") {
+        knowhere::ThreadPool pool(1, "test_priority", knowhere::ThreadPool::QueueType::PRIORITY);
+        std::atomic<bool> release = false;
+        std::mutex order_mutex;
+        std::vector<int> order;
+        std::vector<folly::Future<folly::Unit>> futs;
+        // keeps the only worker busy until every task is queued
+        futs.emplace_back(pool.push([&]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const std::vector<knowhere::ThreadPool::TaskPriority> priorities = {
+            knowhere::ThreadPool::TaskPriority::BATCH, knowhere::ThreadPool::TaskPriority::ITERATOR,
+            knowhere::ThreadPool::TaskPriority::INTERACTIVE};
+        for (const auto priority : priorities) {
+            knowhere::ThreadPool::ScopedTaskPriority scoped_priority(priority);
+            futs.emplace_back(pool.push([&, priority]() {
+                std::lock_guard lock(order_mutex);
+                order.push_back((int)priority);
+            }));
+        }
+        release.store(true);
+        knowhere::WaitAllSuccess(futs);
+        REQUIRE(order == std::vector<int>{(int)knowhere::ThreadPool::TaskPriority::INTERACTIVE,
+                                          (int)knowhere::ThreadPool::TaskPriority::ITERATOR,
+                                          (int)knowhere::ThreadPool::TaskPriority::BATCH});
+    }
+
+    SECTION("Search admission") {
+        knowhere::ThreadPool pool(1, "test_admission", knowhere::ThreadPool::QueueType::PRIORITY);
+        REQUIRE(pool.Admit(knowhere::ThreadPool::TaskPriority::BATCH) == knowhere::Status::success);
+        knowhere::ThreadPool::SetSearchAdmission(4, std::chrono::microseconds(0));
+        std::atomic<bool> release = false;
+        std::vector<folly::Future<folly::Unit>> futs;
+        futs.emplace_back(pool.push([&]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        for (int i = 0; i < 2; i++) {
+            futs.emplace_back(pool.push([]() {}));
+        }
+        // the batch searches are shed first
+        REQUIRE(pool.Admit(knowhere::ThreadPool::TaskPriority::BATCH) == knowhere::Status::overloaded);
+        REQUIRE(pool.Admit(knowhere::ThreadPool::TaskPriority::INTERACTIVE) == knowhere::Status::success);
+        for (int i = 0; i < 2; i++) {
+            futs.emplace_back(pool.push([]() {}));
+        }
+        REQUIRE(pool.Admit(knowhere::ThreadPool::TaskPriority::INTERACTIVE) == knowhere::Status::overloaded);
+        release.store(true);
+        knowhere::WaitAllSuccess(futs);
+        // the queued tasks waited for the first one
+        REQUIRE(pool.GetQueueWait().count() > 0);
+        REQUIRE(pool.Admit(knowhere::ThreadPool::TaskPriority::INTERACTIVE) == knowhere::Status::success);
+        knowhere::ThreadPool::SetSearchAdmission(0, std::chrono::microseconds(0));
+    }
+
+    SECTION("Thread pool cpus") {
+        std::vector<int> cpus;
+        REQUIRE(knowhere::numa::ParseCpuList("0-2,5", cpus));
+        REQUIRE(cpus == std::vector<int>{0, 1, 2, 5});
+        REQUIRE(knowhere::numa::ParseCpuList("", cpus));
+        REQUIRE(cpus.empty());
+        REQUIRE(!knowhere::numa::ParseCpuList("3-1", cpus));
+        REQUIRE(!knowhere::numa::ParseCpuList("0,x", cpus));
+
+#ifdef __linux__
+        knowhere::ThreadPool pool(2, "test_cpus");
+        auto cpu_count = [&pool]() {
+            return pool
+                .push([]() {
+                    cpu_set_t cpu_set;
+                    CPU_ZERO(&cpu_set);
+                    pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+                    return CPU_COUNT(&cpu_set);
+                })
+                .get();
+        };
+        pool.SetCpus({0});
+        REQUIRE(pool.GetCpus() == std::vector<int>{0});
+        for (int i = 0; i < 4; i++) {
+            REQUIRE(cpu_count() == 1);
+        }
+        pool.SetCpus({});
+        cpu_set_t process_cpus;
+        CPU_ZERO(&process_cpus);
+        sched_getaffinity(0, sizeof(process_cpus), &process_cpus);
+        REQUIRE(cpu_count() == CPU_COUNT(&process_cpus));
+#endif
+    }
+
+    SECTION("Query splits") {
+        knowhere::ThreadPool pool(8, "test_splits");
+        // a single query over many rows gets the idle threads
+        REQUIRE(pool.QuerySplits(1, 1 << 20) > 1);
+        REQUIRE(pool.QuerySplits(1, 1 << 20) <= 8);
+        REQUIRE(pool.QuerySplits(2, 1 << 20) <= 4);
+        // a batch that fills the pool, or too few rows, is not split
+        REQUIRE(pool.QuerySplits(8, 1 << 20) == 1);
+        REQUIRE(pool.QuerySplits(1, 1000) == 1);
+        REQUIRE(pool.QuerySplits(0, 1 << 20) == 1);
+    }
+
+    SECTION("Search arena") {
+        auto& arena = knowhere::SearchArena::Local();
+        {
+            knowhere::ScopedSearchArena scoped_arena;
+            auto floats = arena.Allocate<float>(1000);
+            REQUIRE(reinterpret_cast<uintptr_t>(floats) % alignof(std::max_align_t) == 0);
+            const size_t used = arena.Used();
+            REQUIRE(used >= 1000 * sizeof(float));
+            {
+                knowhere::ScopedSearchArena nested;
+                arena.Allocate<int64_t>(1 << 20);
+                REQUIRE(arena.Used() > used);
+            }
+            // the nested scope gives back its memory only
+            REQUIRE(arena.Used() == used);
+        }
+        REQUIRE(arena.Used() == 0);
+        // the blocks are kept for the next searches
+        const size_t capacity = arena.Capacity();
+        REQUIRE(capacity > 0);
+        {
+            knowhere::ScopedSearchArena scoped_arena;
+            arena.Allocate<float>(1000);
+        }
+        REQUIRE(arena.Capacity() == capacity);
+
+        const int64_t* ids_ptr = nullptr;
+        {
+            auto ids = knowhere::MakeResultBuffer<int64_t>(100);
+            auto distances = knowhere::MakeResultBuffer<float>(100);
+            for (int i = 0; i < 100; i++) {
+                ids[i] = i;
+                distances[i] = i;
+            }
+            ids_ptr = ids.get();
+            auto ds = knowhere::GenResultDataSet(10, 10, std::move(ids), std::move(distances));
+            REQUIRE(ds->GetIds()[99] == 99);
+            REQUIRE(ds->GetDistance()[99] == 99.0f);
+        }
+        // the buffer went back to the pool with the DataSet
+        auto ids = knowhere::MakeResultBuffer<int64_t>(100);
+        REQUIRE(ids.get() == ids_ptr);
+    }
+
+    SECTION("Search phases") {
+        auto pool = knowhere::ThreadPool::GetGlobalSearchThreadPool();
+        knowhere::SearchPhaseRecorder phases;
+        {
+            knowhere::ScopedSearchPhaseRecorder scoped_phases(&phases);
+            std::vector<folly::Future<folly::Unit>> futures;
+            for (int i = 0; i < 4; i++) {
+                futures.emplace_back(pool->push([] {
+                    knowhere::ScopedSearchPhase phase(knowhere::SearchPhase::SCAN);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }));
+            }
+            knowhere::WaitAllSuccess(futures);
+        }
+        REQUIRE(knowhere::SearchPhaseRecorder::Current() == nullptr);
+        // the scan of every task is summed
+        REQUIRE(phases.Get(knowhere::SearchPhase::SCAN) >= 8.0);
+        REQUIRE(phases.Get(knowhere::SearchPhase::REFINE) == 0.0);
+        REQUIRE(phases.Get(knowhere::SearchPhase::QUEUE) >= 0.0);
+        REQUIRE(std::string(knowhere::SearchPhaseName(knowhere::SearchPhase::COARSE)) == "coarse");
+
+        // without a recorder the tasks record nothing
+        const double scan = phases.Get(knowhere::SearchPhase::SCAN);
+        auto fut = pool->push([] { knowhere::ScopedSearchPhase phase(knowhere::SearchPhase::SCAN); });
+        fut.wait();
+        REQUIRE(phases.Get(knowhere::SearchPhase::SCAN) == scan);
+    }
+
+    SECTION("NUMA search thread pools") {
+        const int node_count = knowhere::numa::NodeCount();
+        REQUIRE(node_count >= 1);
+        knowhere::numa::SetPolicy(knowhere::numa::NumaPolicy::LOCAL);
+        {
+            knowhere::numa::ScopedIndexPlacement placement;
+            REQUIRE(placement.Node() >= -1);
+            REQUIRE(placement.Node() < node_count);
+        }
+        knowhere::numa::SetPolicy(knowhere::numa::NumaPolicy::NONE);
+        {
+            knowhere::numa::ScopedIndexPlacement placement;
+            REQUIRE(placement.Node() == -1);
+        }
+
+        knowhere::ThreadPool::InitNumaSearchThreadPools(2 * node_count);
+        auto global_pool = knowhere::ThreadPool::GetGlobalSearchThreadPool();
+        {
+            knowhere::ThreadPool::ScopedNumaNode numa_node(0);
+            // a single node has no NUMA pools
+            REQUIRE((knowhere::ThreadPool::GetGlobalSearchThreadPool() == global_pool) == (node_count == 1));
+        }
+        REQUIRE(knowhere::ThreadPool::GetGlobalSearchThreadPool() == global_pool);
+    }
 }
 
 TEST_CASE("Test WaitAllSuccess with folly::Unit futures") {
@@ -309,3 +846,122 @@ TEST_CASE("Test WaitAllSuccess with knowhere::Status futures") {
         REQUIRE_THROWS_AS(knowhere::WaitAllSuccess(futures), std::runtime_error);
     }
 }
+
+TEST_CASE("Test MergeTopk") {
+    const int64_t nq = 100, k = 10;
+    const std::vector<int64_t> segment_ks{10, 5, 10, 1};
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    std::vector<std::vector<int64_t>> segment_ids, segment_groups;
+    std::vector<std::vector<float>> segment_distances;
+    for (size_t s = 0; s < segment_ks.size(); s++) {
+        const int64_t seg_k = segment_ks[s];
+        segment_ids.emplace_back(nq * seg_k);
+        segment_groups.emplace_back(nq * seg_k);
+        segment_distances.emplace_back(nq * seg_k);
+        for (int64_t q = 0; q < nq; q++) {
+            std::vector<float> row(seg_k);
+            for (auto& d : row) {
+                d = dis(rng);
+            }
+            std::sort(row.begin(), row.end());
+            // the last segment has no result for half of the queries
+            const int64_t valid = (s == 3 && q % 2 == 0) ? 0 : seg_k;
+            for (int64_t j = 0; j < seg_k; j++) {
+                // ids overlap across the segments for dedup
+                segment_ids[s][q * seg_k + j] = j < valid ? static_cast<int64_t>(rng() % 30) : -1;
+                segment_groups[s][q * seg_k + j] = segment_ids[s][q * seg_k + j] % 3;
+                segment_distances[s][q * seg_k + j] = row[j];
+            }
+        }
+    }
+    auto segments_of = [&](bool larger_is_closer) {
+        std::vector<knowhere::TopkSegment> segments;
+        for (size_t s = 0; s < segment_ks.size(); s++) {
+            if (larger_is_closer) {
+                for (auto& d : segment_distances[s]) {
+                    d = -d;
+                }
+            }
+            segments.push_back({segment_ids[s].data(), segment_distances[s].data(), segment_ks[s],
+                                segment_groups[s].data()});
+        }
+        return segments;
+    };
+    // a stable sort of all the results of a query, then the same filters
+    auto naive = [&](const knowhere::TopkMergeOptions& options, std::vector<int64_t>& ids,
+                     std::vector<float>& distances) {
+        for (int64_t q = 0; q < nq; q++) {
+            std::vector<std::tuple<float, int64_t, int64_t>> all;
+            for (size_t s = 0; s < segment_ks.size(); s++) {
+                for (int64_t j = 0; j < segment_ks[s]; j++) {
+                    const int64_t offset = q * segment_ks[s] + j;
+                    if (segment_ids[s][offset] >= 0) {
+                        all.emplace_back(segment_distances[s][offset], segment_ids[s][offset],
+                                         segment_groups[s][offset]);
+                    }
+                }
+            }
+            std::stable_sort(all.begin(), all.end(), [&](const auto& a, const auto& b) {
+                return options.larger_is_closer ? std::get<0>(a) > std::get<0>(b) : std::get<0>(a) < std::get<0>(b);
+            });
+            std::set<int64_t> seen;
+            std::map<int64_t, int64_t> groups;
+            int64_t n = 0;
+            for (const auto& [d, id, group] : all) {
+                if (n == k) {
+                    break;
+                }
+                if (options.dedup && !seen.insert(id).second) {
+                    continue;
+                }
+                if (options.group_size > 0 && ++groups[group] > options.group_size) {
+                    continue;
+                }
+                distances[q * k + n] = d;
+                ids[q * k + n++] = id;
+            }
+            for (; n < k; n++) {
+                ids[q * k + n] = -1;
+            }
+        }
+    };
+    auto check = [&](const knowhere::TopkMergeOptions& options) {
+        auto segments = segments_of(options.larger_is_closer);
+        std::vector<int64_t> ids(nq * k), expected_ids(nq * k);
+        std::vector<float> distances(nq * k), expected_distances(nq * k);
+        REQUIRE(knowhere::MergeTopk(segments, nq, k, options, ids.data(), distances.data()) ==
+                knowhere::Status::success);
+        naive(options, expected_ids, expected_distances);
+        for (int64_t i = 0; i < nq * k; i++) {
+            REQUIRE(ids[i] == expected_ids[i]);
+            if (ids[i] >= 0) {
+                REQUIRE(distances[i] == expected_distances[i]);
+            }
+        }
+    };
+
+    SECTION("L2 order") {
+        check({false, false, 0, 64});
+        // inline, no thread pool
+        check({false, false, 0, nq + 1});
+    }
+    SECTION("IP order") {
+        check({true, false, 0, 64});
+    }
+    SECTION("Dedup and group") {
+        check({false, true, 0, 64});
+        check({false, false, 2, 64});
+        check({false, true, 1, 64});
+    }
+    SECTION("Invalid args") {
+        auto segments = segments_of(false);
+        segments[1].group_ids = nullptr;
+        std::vector<int64_t> ids(nq * k);
+        std::vector<float> distances(nq * k);
+        REQUIRE(knowhere::MergeTopk(segments, nq, k, {false, false, 2, 64}, ids.data(), distances.data()) ==
+                knowhere::Status::invalid_args);
+        REQUIRE(knowhere::MergeTopk(segments, nq, 0, {}, ids.data(), distances.data()) ==
+                knowhere::Status::invalid_args);
+    }
+}
@@ -49,6 +49,17 @@ class AioContextPool {
     return ret;
   }
 
+  // nullptr if no context is free right now
+  io_context_t try_pop() {
+    std::scoped_lock lk(ctx_mtx_);
+    if (stop_ || ctx_q_.empty()) {
+      return nullptr;
+    }
+    auto ret = ctx_q_.front();
+    ctx_q_.pop();
+    return ret;
+  }
+
   static bool InitGlobalAioPool(size_t num_ctx, size_t max_events) {
     if (num_ctx <= 0) {
       LOG(ERROR) << "num_ctx should be bigger than 0";
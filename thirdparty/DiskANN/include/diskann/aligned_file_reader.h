@@ -14,6 +14,7 @@
 #include <malloc.h>
 #include <cstdio>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include "tsl/robin_map.h"
 #include "utils.h"
@@ -48,8 +49,20 @@ class AlignedFileReader {
 
   virtual IOContext get_ctx() = 0;
 
+  // like get_ctx, but returns nullptr instead of waiting for a free context
+  virtual IOContext try_get_ctx() = 0;
+
   virtual void put_ctx(IOContext) = 0;
 
+  // the most reads that one context can have in flight
+  virtual size_t max_events_per_ctx() = 0;
+
+  // the size of the open file if it is not on the local disk, which then can
+  // only be read through the reader
+  virtual std::optional<uint64_t> remote_file_size() {
+    return std::nullopt;
+  }
+
   // Open & close ops
   // Blocking calls
   virtual void open(const std::string& fname) = 0;
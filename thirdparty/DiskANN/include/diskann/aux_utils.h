@@ -91,6 +91,23 @@ namespace diskann {
       double ram_budget, std::string mem_index_path, std::string medoids_file,
       std::string centroids_file);
 
+  // adds label-aware edges to the graph in mem_index_path and saves the
+  // labels and the entry point of every label next to the disk index
+  template<typename T>
+  void stitch_label_graphs(const std::string &base_file,
+                           const std::string &label_file, bool ip_prepared,
+                           unsigned L, unsigned R, bool accelerate_build,
+                           const std::string &mem_index_path,
+                           const std::string &disk_index_path);
+
+  // builds a graph over a sample of sample_ratio of the points in base_file and
+  // saves it with its points and their vectors next to the disk index, for the
+  // searches to pick their entry points from in memory
+  template<typename T>
+  void build_nav_graph(const std::string &base_file, bool ip_prepared,
+                       unsigned L, unsigned R, bool accelerate_build,
+                       float sample_ratio, const std::string &disk_index_path);
+
   template<typename T>
   void generate_cache_list_from_graph_with_pq(
       _u64 num_nodes_to_cache, unsigned R, const diskann::Metric compare_metric,
@@ -129,6 +146,21 @@ namespace diskann {
     uint32_t num_nodes_to_cache = 0;
     // shuffle id to build index
     bool shuffle_build = false;
+    // one uint32 label per point in the bin format, empty for none. The graph
+    // gets label-aware edges for the searches filtered by a label.
+    std::string label_file_path = "";
+    // the number of shards built at once if the index does not fit in
+    // index_mem_gb, every shard then gets its part of the budget
+    uint32_t num_parallel_shards = 1;
+    // pack the nodes that are close in the graph into the same sectors, so
+    // that a sector read brings more of the nodes a search visits
+    bool reorder_sectors = false;
+    // 8, or 4 to score the in-memory pq codes with the fast scan kernels. The
+    // code size budget stays the same, so 4 bits gets twice the chunks.
+    uint32_t pq_code_nbits = 8;
+    // the ratio of the points sampled into an in-memory navigation graph, in
+    // which the searches find their entry points, 0 for none
+    float nav_graph_ratio = 0.0f;
   };
 
   template<typename T>
@@ -140,4 +172,37 @@ namespace diskann {
       const std::string output_file,
       const std::string reorder_data_file = std::string(""));
 
+  // rewrites the disk index in place with the nodes of every sector picked
+  // along the edges of the graph in mem_index_file, and saves the node of
+  // every disk position next to it. Indexes with a single node per sector
+  // are left as they are.
+  void reorder_disk_layout(const std::string &mem_index_file,
+                           const std::string &disk_index_file);
+
+  struct MergeConfig {
+    std::string index_file_path = "";
+    // L of the searches that find the neighbors of the inserted points
+    unsigned search_list_size = 0;
+    float    alpha = 1.2f;
+  };
+
+  // The streaming merge of FreshDiskANN: rewrites the disk index at
+  // config.index_file_path in a sequential pass, with the points of
+  // insert_data appended and the deleted points cut out of the graph.
+  // - insert_graph holds the neighbors of every inserted point among the
+  //   inserted ones, by their offset in insert_data. The inserted points also
+  //   get neighbors from searches on index, which must be loaded from the
+  //   files to merge, and the reverse edges of both.
+  // - deleted covers the points of the index and the inserted ones. Edges to
+  //   deleted points are replaced with the live neighbors of those points.
+  //   Deleted points keep their ids and vectors but lose their edges, except
+  //   for the medoids, and their ids are saved next to the index.
+  // Candidates are pruned with the distances of their PQ codes. Indexes with
+  // inner product, labels or disk PQ are not supported.
+  template<typename T>
+  int merge_disk_index(const MergeConfig &config, PQFlashIndex<T> &index,
+                       const T                                  *insert_data,
+                       const std::vector<std::vector<unsigned>> &insert_graph,
+                       const std::vector<bool>                  &deleted);
+
 }  // namespace diskann
@@ -136,6 +136,11 @@ namespace diskann {
     void build(const char *filename, const size_t num_points_to_load,
                Parameters &parameters, const char *tag_filename);
 
+    // builds the graph of num_points rows of _dim values that are already in
+    // memory, without going through a data file
+    void build(const T *data, const size_t num_points, Parameters &parameters,
+               const std::vector<TagT> &tags = std::vector<TagT>());
+
     // Added search overload that takes L as parameter, so that we
     // can customize L on a per-query basis without tampering with "Parameters"
     template<typename IDType>
@@ -244,6 +249,10 @@ namespace diskann {
 
     // generates one frozen point that will never get deleted from the
     // graph
+    // links the _nd points of _data, the common part of all the builds
+    void build_with_data_populated(Parameters              &parameters,
+                                   const std::vector<TagT> &tags);
+
     int generate_frozen_point();
 
     // determines navigating node of the graph by calculating medoid of data
@@ -21,10 +21,18 @@ class LinuxAlignedFileReader : public AlignedFileReader {
     return ctx_pool_->pop();
   }
 
+  io_context_t try_get_ctx() override {
+    return ctx_pool_->try_pop();
+  }
+
   void put_ctx(io_context_t ctx) override {
     ctx_pool_->push(ctx);
   }
 
+  size_t max_events_per_ctx() override {
+    return ctx_pool_->max_events_per_ctx();
+  }
+
   // Open & close ops
   // Blocking calls
   void open(const std::string &fname) override;
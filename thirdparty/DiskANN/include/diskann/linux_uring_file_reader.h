@@ -0,0 +1,51 @@
+#pragma once
+
+#include "aligned_file_reader.h"
+#include "uring_context_pool.h"
+
+// An AlignedFileReader on the rings of the global UringContextPool, which
+// must be initialized. The contexts it hands out are UringContext pointers.
+class LinuxUringFileReader : public AlignedFileReader {
+ private:
+  FileHandle                        file_desc;
+  std::shared_ptr<UringContextPool> ctx_pool_;
+
+  static UringContext *ring(io_context_t ctx) {
+    return reinterpret_cast<UringContext *>(ctx);
+  }
+
+ public:
+  LinuxUringFileReader();
+  ~LinuxUringFileReader();
+
+  io_context_t get_ctx() override {
+    return reinterpret_cast<io_context_t>(ctx_pool_->pop());
+  }
+
+  io_context_t try_get_ctx() override {
+    return reinterpret_cast<io_context_t>(ctx_pool_->try_pop());
+  }
+
+  void put_ctx(io_context_t ctx) override {
+    ctx_pool_->push(ring(ctx));
+  }
+
+  size_t max_events_per_ctx() override {
+    return ctx_pool_->max_events_per_ctx();
+  }
+
+  // Open & close ops
+  // Blocking calls
+  void open(const std::string &fname) override;
+  void close() override;
+
+  // process batch of aligned requests in parallel
+  // NOTE :: blocking call
+  void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx,
+            bool async = false) override;
+
+  // async reads
+  void get_submitted_req(io_context_t &ctx, size_t n_ops) override;
+  void submit_req(io_context_t             &ctx,
+                  std::vector<AlignedRead> &read_reqs) override;
+};
@@ -28,6 +28,7 @@ namespace diskann {
     unsigned n_cache_hits = 0;  // # cache_hits
     unsigned n_hops = 0;        // # search hops
     unsigned n_iters = 0;       // # range search iterations
+    bool     brute_force = false;  // whether the points were scanned instead
   };
 
   template<typename T>
@@ -2,9 +2,11 @@
 // Licensed under the MIT license.
 
 #pragma once
+#include <atomic>
 #include <cassert>
 #include <condition_variable>
 #include <future>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <sstream>
@@ -22,6 +24,7 @@
 #include "parameters.h"
 #include "percentile_stats.h"
 #include "pq_table.h"
+#include "timer.h"
 #include "utils.h"
 #include "diskann/distance.h"
 #include "knowhere/comp/thread_pool.h"
@@ -60,6 +63,11 @@ namespace diskann {
         nullptr;  // MUST BE AT LEAST diskann MAX_DEGREE
     _u8 *aligned_pq_coord_scratch =
         nullptr;  // MUST BE AT LEAST  [N_CHUNKS * MAX_DEGREE]
+    // for 4-bit pq codes: the 8-bit tables and the sums of the fast scan
+    _u8   *aligned_pq4_lut_scratch = nullptr;  // [32 * N_CHUNKS / 2]
+    _u16  *aligned_pq4_sum_scratch = nullptr;  // [MAX_DEGREE]
+    float  pq4_scale = 1.0f;
+    float  pq4_bias = 0.0f;
     T     *aligned_query_T = nullptr;
     float *aligned_query_float = nullptr;
 
@@ -192,13 +200,53 @@ namespace diskann {
     void cache_bfs_levels(_u64                   num_nodes_to_cache,
                           std::vector<uint32_t> &node_list);
 
+    // lets the cache loaded before follow the queries: one in
+    // kAdaptiveCacheSampleRate searches counts the visits of the nodes, and
+    // after refresh_interval sampled searches the hottest uncached nodes
+    // replace the coldest cached ones in the background. The number of cached
+    // nodes stays the same.
+    void enable_adaptive_cache(_u64 refresh_interval);
+
+    // swaps cold cached nodes for hot ones and halves the counted visits,
+    // returns the number of nodes swapped. Called by the background refresh.
+    _u64 refresh_adaptive_cache();
+
     void cached_beam_search(
         const T *query, const _u64 k_search, const _u64 l_search, _s64 *res_ids,
         float *res_dists, const _u64 beam_width,
         const bool use_reorder_data = false, QueryStats *stats = nullptr,
         const knowhere::feder::diskann::FederResultUniq &feder = nullptr,
         knowhere::BitsetView                             bitset_view = nullptr,
-        const float                                      filter_ratio = -1.0f);
+        const float                                      filter_ratio = -1.0f,
+        const _s64                                       filter_label = -1);
+
+    // searches the nq queries, query_dim apart, on the calling thread with up
+    // to num_interleave of them in flight: while the reads of a query are
+    // pending the thread works on the others. Each query in flight takes a
+    // thread data and an io context, the ones after the first only if both
+    // are free, so load() needs enough threads for the interleaving to
+    // happen. stats is nullptr or has nq elements.
+    void cached_beam_search_interleaved(
+        const T *queries, const _u64 nq, const _u64 query_dim,
+        const _u64 k_search, const _u64 l_search, _s64 *res_ids,
+        float *res_dists, const _u64 beam_width, const _u64 num_interleave,
+        QueryStats *stats = nullptr, knowhere::BitsetView bitset_view = nullptr,
+        const float filter_ratio = -1.0f, const _s64 filter_label = -1);
+
+    // the points within radius of the query, closest first, with their
+    // distances as cached_beam_search() returns them: the smaller the closer
+    // for L2, the larger for IP and COSINE. One beam search expands the
+    // min_l_search closest candidates as a top-k search would, and past them
+    // grows its list up to max_l_search to keep every candidate whose PQ
+    // distance may be within the radius, so that the nodes which cannot be are
+    // not read.
+    void range_search(const T *query, const float radius,
+                      const _u64 min_l_search, const _u64 max_l_search,
+                      const _u64 beam_width, std::vector<_s64> &indices,
+                      std::vector<float> &distances,
+                      QueryStats          *stats = nullptr,
+                      knowhere::BitsetView bitset_view = nullptr,
+                      const float          filter_ratio = -1.0f);
 
     void get_vector_by_ids(const int64_t *ids, const int64_t n,
                            T *const output_data);
@@ -217,6 +265,13 @@ namespace diskann {
 
     diskann::Metric get_metric() const noexcept;
 
+    // true if the index was built with labels, so that the searches can be
+    // filtered by one (filter_label >= 0). Such a search starts at the entry
+    // point of the label and only follows the edges to the same label.
+    bool has_labels() const noexcept {
+      return !labels.empty();
+    }
+
     void getIteratorNextBatch(IteratorWorkspace<T> *workspace);
 
     std::unique_ptr<IteratorWorkspace<T>> getIteratorWorkspace(
@@ -235,21 +290,48 @@ namespace diskann {
     _u64 get_thread_data_size();
 
    private:
+    // position of node_id among the nodes on disk
+    _u64 get_node_loc(_u64 node_id) {
+      return id_to_loc.empty() ? node_id : id_to_loc[node_id];
+    }
+
     // sector # on disk where node_id is present with in the graph part
     _u64 get_node_sector_offset(_u64 node_id) {
-      return long_node ? (node_id * nsectors_per_node + 1) * SECTOR_LEN
-                       : (node_id / nnodes_per_sector + 1) * SECTOR_LEN;
+      return long_node
+                 ? (node_id * nsectors_per_node + 1) * SECTOR_LEN
+                 : (get_node_loc(node_id) / nnodes_per_sector + 1) * SECTOR_LEN;
     }
 
     // obtains region of sector containing node
     char *get_offset_to_node(char *sector_buf, _u64 node_id) {
-      return long_node
-                 ? sector_buf
-                 : sector_buf + (node_id % nnodes_per_sector) * max_node_len;
+      return long_node ? sector_buf
+                       : sector_buf + (get_node_loc(node_id) %
+                                       nnodes_per_sector) * max_node_len;
     }
 
     inline void copy_vec_base_data(T *des, const int64_t des_idx, void *src);
 
+    // the distance of a result from the distance the search compares, which
+    // is an L2 one on the normalized vectors for IP and the negated cosine
+    // for COSINE, and the other way round
+    float to_result_dist(const float dist, const float query_norm) const;
+    float from_result_dist(const float dist, const float query_norm) const;
+
+    // loads the navigation graph saved next to the disk index, if any
+    void load_nav_graph(const std::string &disk_index_file);
+
+    // the points of the navigation graph closest to the query, at most
+    // n_entries of them, the closest first
+    void search_nav_graph(const float *query_float, const _u64 n_entries,
+                          std::vector<unsigned> &entries);
+
+    // fills the query <-> pq centers tables of the scratch
+    void populate_pq_dists(QueryScratch<T> &scratch, const float *query_float);
+
+    // pq distances of at most MAX_GRAPH_DEGREE points
+    void compute_pq_dists(QueryScratch<T> &scratch, const unsigned *ids,
+                          const _u64 n_ids, float *dists_out);
+
     // Init thread data and returns query norm if avaialble.
     // If there is no value, there is nothing to do with the given query
     std::optional<float> init_thread_data(ThreadData<T> &data, const T *query1);
@@ -271,9 +353,139 @@ namespace diskann {
     get_sectors_layout_and_write_data_from_cache(const int64_t *ids, int64_t n,
                                                  T *output_data);
 
+    // reads the <id, slot> nodes from disk into the cache
+    void load_nodes_into_cache(const std::vector<std::pair<_u32, _u64>> &nodes);
+
+    // the coords cached in the same slot as the cached nhood nbrs
+    T *get_cached_coords(const unsigned *nbrs) {
+      return coord_cache_buf +
+             (nbrs - nhood_cache_buf.get()) / (max_degree + 1) * aligned_dim;
+    }
+
+    // Searches that use cached nhoods after dropping cache_mtx count
+    // themselves in while the adaptive cache is on, so that a refresh can wait
+    // for the ones that may still read an evicted slot before reusing it.
+    class CacheReadGuard {
+     public:
+      explicit CacheReadGuard(PQFlashIndex<T> *index);
+      ~CacheReadGuard();
+
+     private:
+      PQFlashIndex<T> *index_;
+      _u64             slot_ = 0;
+    };
+
+    // counts a visit of a sampled search, saturating
+    void add_node_heat(_u32 id) {
+      auto &heat = node_heat[id];
+      auto  h = heat.load(std::memory_order_relaxed);
+      if (h < std::numeric_limits<_u8>::max()) {
+        heat.store(h + 1, std::memory_order_relaxed);
+      }
+    }
+
+    // waits until the searches that came before are out of the cache
+    void wait_for_cache_readers();
+
+    void schedule_adaptive_cache_refresh();
+
+    // The state of a cached_beam_search between its beams. A search starts
+    // with the medoid closest to the query and, until next_beam() returns
+    // false, reads the nodes of the beam (read_beam(), or submit_beam() and
+    // wait_beam() to do other work meanwhile) and process_beam()es them.
+    struct BeamSearch {
+      BeamSearch(PQFlashIndex<T> *index, ThreadData<T> &data, IOContext &ctx,
+                 const float query_norm, const _u64 k_search,
+                 const _u64 l_search, const _u64 beam_width, QueryStats *stats,
+                 const knowhere::feder::diskann::FederResultUniq &feder,
+                 knowhere::BitsetView bitset_view, const _s64 filter_label);
+
+      // picks the next beam and prepares the reads of its uncached nodes,
+      // false if the search is done
+      bool next_beam();
+      void read_beam();
+      void submit_beam();
+      void wait_beam();
+      void process_beam();
+      // writes the k_search results
+      void finish(_s64 *indices, float *distances, const bool use_reorder_data);
+
+      // turns the search into a range search: the list starts with l_search
+      // candidates and grows up to max_l to keep the ones whose PQ distance is
+      // at most pq_bound
+      void set_range(const float pq_bound, const _u64 max_l);
+      // appends the expanded points whose distance is at most bound
+      void finish_range(const float bound, std::vector<_s64> &indices,
+                        std::vector<float> &distances);
+
+      bool has_reads() const {
+        return !frontier_read_reqs.empty();
+      }
+
+     private:
+      void compute_dists(const unsigned *ids, const _u64 n_ids,
+                         float *dists_out);
+      std::pair<_u64, unsigned *> filter_nbrs(_u64 nnbrs, unsigned *node_nbrs);
+      void process_node(T *node_fp_coords_copy, unsigned node_id,
+                        unsigned n_nbr, unsigned *nbrs);
+      // expands the candidates that came along in the sector of node_id
+      void process_colocated(char *sector_buf, unsigned node_id);
+      // false if a range search drops a candidate of PQ distance dist, grows
+      // the list if it is full and still within the bound
+      bool admit_range_candidate(const float dist);
+      void record_finish();
+
+      PQFlashIndex<T>                                 *index;
+      ThreadData<T>                                    data;
+      IOContext                                        ctx;
+      const float                                      query_norm;
+      const _u64                                       k_search;
+      // grows in a range search
+      _u64                                             l_search;
+      const _u64                                       beam_width;
+      QueryStats                                      *stats;
+      const knowhere::feder::diskann::FederResultUniq &feder;
+      knowhere::BitsetView                             bitset_view;
+      const _s64                                       filter_label;
+      CacheReadGuard                                   cache_guard;
+      bool                                             sample_heat = false;
+
+      const T     *query = nullptr;
+      const float *query_float = nullptr;
+      T           *data_buf = nullptr;
+      char        *sector_scratch = nullptr;
+      float       *dist_scratch = nullptr;
+      Timer        io_timer, query_timer, cpu_timer;
+
+      // cleared every iteration
+      std::vector<unsigned>                    frontier;
+      std::vector<std::pair<unsigned, char *>> frontier_nhoods;
+      std::vector<AlignedRead>                 frontier_read_reqs;
+      std::vector<std::pair<unsigned, std::pair<unsigned, unsigned *>>>
+          cached_nhoods;
+
+      std::vector<Neighbor> retset;
+      std::vector<Neighbor> full_retset;
+      tsl::robin_set<_u64> &visited;
+      std::vector<unsigned> filtered_nbrs;
+      unsigned              cur_list_size = 0;
+      unsigned              cmps = 0;
+      unsigned              hops = 0;
+      unsigned              num_ios = 0;
+      unsigned              k = 0;
+      unsigned              nk = 0;
+      float                 accumulative_alpha = 0;
+
+      // the range search state, see set_range()
+      bool  range = false;
+      _u64  min_l_search = 0;
+      _u64  max_l_search = 0;
+      float range_pq_bound = 0;
+    };
+
     // index info
-    // nhood of node `i` is in sector: [i / nnodes_per_sector]
-    // offset in sector: [(i % nnodes_per_sector) * max_node_len]
+    // nhood of node `i` is in sector: [loc(i) / nnodes_per_sector]
+    // offset in sector: [(loc(i) % nnodes_per_sector) * max_node_len]
     // nnbrs of node `i`: *(unsigned*) (buf)
     // nbrs of node `i`: ((unsigned*)buf) + 1
     _u64 max_node_len = 0, nnodes_per_sector = 0, max_degree = 0;
@@ -315,11 +527,13 @@ namespace diskann {
 
     // PQ data
     // n_chunks = # of chunks ndims is split into
-    // data: _u8 * n_chunks
+    // data: _u8 * pq_code_size, a byte per chunk or two for 4-bit codes
     // chunk_size = chunk size of each dimension chunk
     // pq_tables = float* [[2^8 * [chunk_size]] * n_chunks]
     std::unique_ptr<_u8[]> data = nullptr;
     _u64                   n_chunks;
+    _u64                   pq_code_size = 0;
+    bool                   pq4 = false;
     FixedChunkPQTable      pq_table;
 
     // distance comparator
@@ -360,6 +574,25 @@ namespace diskann {
     // closest centroid as the starting point of search
     float *centroid_data = nullptr;
 
+    // the node at every disk position and the other way round, empty if the
+    // nodes are stored in id order
+    std::vector<_u32> loc_to_id;
+    std::vector<_u32> id_to_loc;
+
+    // the label of every point and the entry point of every label, empty if
+    // the index was built without labels
+    std::vector<_u32>          labels;
+    tsl::robin_map<_u32, _u32> label_medoids;
+
+    // the in-memory navigation graph over a sample of the points, its entry
+    // point first, empty if the index was built without one. A row of
+    // nav_graph is the degree and the neighbors, as positions in the sample.
+    std::vector<_u32>  nav_ids;
+    std::vector<float> nav_data;
+    std::vector<_u32>  nav_graph;
+    _u64               nav_width = 0;
+    std::vector<bool>  nav_deleted;
+
     // cache
     std::shared_mutex cache_mtx;
 
@@ -371,6 +604,19 @@ namespace diskann {
     // coord_cache
     T                        *coord_cache_buf = nullptr;
     tsl::robin_map<_u32, T *> coord_cache;
+    // number of slots in the cache bufs
+    _u64 cache_capacity = 0;
+
+    // adaptive cache
+    bool                                 adaptive_cache = false;
+    _u64                                 adaptive_cache_refresh_interval = 0;
+    std::unique_ptr<std::atomic<_u8>[]>  node_heat = nullptr;
+    std::atomic<_u64>                    sampled_searches = 0;
+    std::atomic<_u64>                    cache_epoch = 0;
+    std::atomic<_s64>                    cache_readers[2] = {0, 0};
+    std::mutex                           cache_refresh_mtx;
+    std::condition_variable              cache_refresh_cv;
+    bool                                 cache_refreshing = false;
 
     // thread-specific scratch
     ConcurrentQueue<ThreadData<T>> thread_data;
@@ -5,7 +5,9 @@
 
 #include "utils.h"
 #include "concurrent_queue.h"
+#include "simd/hook.h"
 #define NUM_PQ_CENTROIDS 256
+#define NUM_PQ4_CENTROIDS 16
 
 namespace diskann {
   inline void aggregate_coords(const unsigned* ids, const _u64 n_ids,
@@ -47,6 +49,60 @@ namespace diskann {
     }
   }
 
+  // 4-bit codes pack chunks 2j and 2j + 1 into the low and high nibble of byte
+  // j. They are scored 32 at a time, the codes of the candidates are gathered
+  // as for 8 bits and the last block is padded with zeros.
+  inline void aggregate_pq4_coords(const unsigned* ids, const _u64 n_ids,
+                                   const _u8* all_coords, const _u64 nbytes,
+                                   _u8* out) {
+    aggregate_coords(ids, n_ids, all_coords, nbytes, out);
+    memset(out + n_ids * nbytes, 0, (ROUND_UP(n_ids, 32) - n_ids) * nbytes);
+  }
+
+  // fills lut with the distances of each chunk, shifted by the chunk minimum
+  // and scaled to 8 bits, so that dist = bias + scale * sum of the lut entries.
+  // The scale leaves room to add up all the chunks in 16 bits.
+  inline void quantize_pq4_dists(const float* pq_dists, const _u64 n_chunks,
+                                 _u8* lut, float& scale, float& bias) {
+    const _u64 nbytes = DIV_ROUND_UP(n_chunks, 2);
+    bias = 0;
+    float max_span = 0;
+    for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
+      const float* chunk_dists = pq_dists + NUM_PQ4_CENTROIDS * chunk;
+      const float  lo =
+          *std::min_element(chunk_dists, chunk_dists + NUM_PQ4_CENTROIDS);
+      const float hi =
+          *std::max_element(chunk_dists, chunk_dists + NUM_PQ4_CENTROIDS);
+      bias += lo;
+      max_span = (std::max)(max_span, hi - lo);
+    }
+    const float qmax = (float) (std::min)(255UL, 65535UL / (2 * nbytes));
+    scale = max_span > 0 ? max_span / qmax : 1.0f;
+    memset(lut, 0, 32 * nbytes);
+    for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
+      const float* chunk_dists = pq_dists + NUM_PQ4_CENTROIDS * chunk;
+      const float  lo =
+          *std::min_element(chunk_dists, chunk_dists + NUM_PQ4_CENTROIDS);
+      for (_u64 c = 0; c < NUM_PQ4_CENTROIDS; c++) {
+        lut[chunk * NUM_PQ4_CENTROIDS + c] =
+            (_u8) std::lround((chunk_dists[c] - lo) / scale);
+      }
+    }
+  }
+
+  // pq4_coords holds the codes from aggregate_pq4_coords and 16 readable bytes
+  // past them, sums is a scratch of n_pts rounded up to 32
+  inline void pq4_dist_lookup(const _u8* pq4_coords, const _u64 n_pts,
+                              const _u64 nbytes, const _u8* lut,
+                              const float scale, const float bias,
+                              _u16* sums, float* dists_out) {
+    faiss::u8_pq4_fast_scan(pq4_coords, DIV_ROUND_UP(n_pts, 32), nbytes, lut,
+                            sums);
+    for (_u64 i = 0; i < n_pts; i++) {
+      dists_out[i] = bias + scale * sums[i];
+    }
+  }
+
   class FixedChunkPQTable {
     // data_dim = n_chunks * chunk_size;
     std::unique_ptr<float[]> tables =
@@ -55,6 +111,7 @@ namespace diskann {
     //    _u64   chunk_size;  // chunk_size = chunk size of each dimension chunk
     _u64   ndims = 0;  // ndims = chunk_size * n_chunks
     _u64   n_chunks = 0;
+    _u64   num_centers = NUM_PQ_CENTROIDS;
     std::unique_ptr<_u32[]>  chunk_offsets = nullptr;
     std::unique_ptr<_u32[]>  rearrangement = nullptr;
     std::unique_ptr<float[]> centroid = nullptr;
@@ -79,6 +136,7 @@ namespace diskann {
     size_t   npts_u64, ndims_u64;
       diskann::load_bin<float>(pq_table_file, tables, npts_u64, ndims_u64);
     this->ndims = ndims_u64;
+    this->num_centers = npts_u64;
 
     if (file_exists(chunk_offset_file)) {
         diskann::load_bin<_u32>(rearrangement_file, rearrangement, numr, numc);
@@ -89,15 +147,17 @@ namespace diskann {
       }
 
         diskann::load_bin<_u32>(chunk_offset_file, chunk_offsets, numr, numc);
-      if (numc != 1 || (numr != num_chunks + 1 && num_chunks != 0)) {
+      this->n_chunks = numr - 1;
+      // num_chunks is the code size, the bytes of two chunks for 4-bit codes
+      if (numc != 1 || (get_code_size() != num_chunks && num_chunks != 0)) {
         LOG(ERROR) << "Error loading chunk offsets file. numc: " << numc
-                   << " (should be 1). numr: " << numr << " (should be "
-                   << num_chunks + 1 << ")";
+                   << " (should be 1). numr: " << numr << " (should match "
+                   << num_chunks << " bytes per point)";
         throw diskann::ANNException("Error loading chunk offsets file", -1,
                                     __FUNCSIG__, __FILE__, __LINE__);
       }
-      LOG_KNOWHERE_DEBUG_ << "PQ data has " << numr - 1 << " bytes per point.";
-      this->n_chunks = numr - 1;
+      LOG_KNOWHERE_DEBUG_ << "PQ data has " << get_code_size()
+                          << " bytes per point.";
 
         diskann::load_bin<float>(centroid_file, centroid, numr, numc);
       if (numc != 1 || numr != ndims_u64) {
@@ -123,10 +183,10 @@ namespace diskann {
                        << ", #dims: " << ndims_u64 << ", #chunks: " << n_chunks;
     //      assert((_u64) ndims_u32 == n_chunks * chunk_size);
     // alloc and compute transpose
-    tables_T = std::make_unique<float[]>(256 * ndims_u64);
-    for (_u64 i = 0; i < 256; i++) {
+    tables_T = std::make_unique<float[]>(num_centers * ndims_u64);
+    for (_u64 i = 0; i < num_centers; i++) {
       for (_u64 j = 0; j < ndims_u64; j++) {
-        tables_T[j * 256 + i] = tables[i * ndims_u64 + j];
+        tables_T[j * num_centers + i] = tables[i * ndims_u64 + j];
       }
     }
   }
@@ -139,16 +199,32 @@ namespace diskann {
   get_total_dims() {
     return static_cast<_u32>(this->ndims);
   }
+  // 256, or 16 for 4-bit codes
+  _u32
+  get_num_centers() {
+    return static_cast<_u32>(this->num_centers);
+  }
+  _u64
+  get_code_size() {
+    return num_centers == NUM_PQ4_CENTROIDS ? DIV_ROUND_UP(n_chunks, 2)
+                                            : n_chunks;
+  }
+  _u8
+  get_code(const _u8* base_vec, _u64 chunk) {
+    return num_centers == NUM_PQ4_CENTROIDS
+               ? (base_vec[chunk / 2] >> (4 * (chunk % 2))) & 0x0f
+               : base_vec[chunk];
+  }
   void populate_chunk_distances(const float* query_vec, float* dist_vec) {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
       // sum (q-c)^2 for the dimensions associated with this chunk
-      float* chunk_dists = dist_vec + (256 * chunk);
+      float* chunk_dists = dist_vec + (num_centers * chunk);
       for (_u64 j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++) {
         _u64         permuted_dim_in_query = rearrangement[j];
-        const float* centers_dim_vec = tables_T.get() + (256 * j);
-        for (_u64 idx = 0; idx < 256; idx++) {
+        const float* centers_dim_vec = tables_T.get() + (num_centers * j);
+        for (_u64 idx = 0; idx < num_centers; idx++) {
           double diff =
               centers_dim_vec[idx] - (query_vec[permuted_dim_in_query] -
                                       centroid[permuted_dim_in_query]);
@@ -163,8 +239,8 @@ namespace diskann {
     for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
       for (_u64 j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++) {
         _u64         permuted_dim_in_query = rearrangement[j];
-        const float* centers_dim_vec = tables_T.get() + (256 * j);
-        float        diff = centers_dim_vec[base_vec[chunk]] -
+        const float* centers_dim_vec = tables_T.get() + (num_centers * j);
+        float        diff = centers_dim_vec[get_code(base_vec, chunk)] -
                      (query_vec[permuted_dim_in_query] -
                       centroid[permuted_dim_in_query]);
         res += diff * diff;
@@ -178,9 +254,9 @@ namespace diskann {
     for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
       for (_u64 j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++) {
         _u64         permuted_dim_in_query = rearrangement[j];
-        const float* centers_dim_vec = tables_T.get() + (256 * j);
+        const float* centers_dim_vec = tables_T.get() + (num_centers * j);
         float        diff =
-            centers_dim_vec[base_vec[chunk]] *
+            centers_dim_vec[get_code(base_vec, chunk)] *
             query_vec[permuted_dim_in_query];  // assumes centroid is 0 to
                                                // prevent translation errors
         res += diff;
@@ -194,23 +270,41 @@ namespace diskann {
     for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
       for (_u64 j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++) {
         _u64         original_dim = rearrangement[j];
-        const float* centers_dim_vec = tables_T.get() + (256 * j);
+        const float* centers_dim_vec = tables_T.get() + (num_centers * j);
         out_vec[original_dim] =
-            centers_dim_vec[base_vec[chunk]] + centroid[original_dim];
+            centers_dim_vec[get_code(base_vec, chunk)] + centroid[original_dim];
+      }
+    }
+  }
+
+  // the code of the closest centers, the inverse of inflate_vector
+  void encode_vector(const float* vec, _u8* code_out) {
+    std::vector<float> dists(num_centers * n_chunks);
+    populate_chunk_distances(vec, dists.data());
+    memset(code_out, 0, get_code_size());
+    for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
+      const float* chunk_dists = dists.data() + num_centers * chunk;
+      const _u8    code = (_u8) (std::min_element(chunk_dists,
+                                                  chunk_dists + num_centers) -
+                                 chunk_dists);
+      if (num_centers == NUM_PQ4_CENTROIDS) {
+        code_out[chunk / 2] |= code << (4 * (chunk % 2));
+      } else {
+        code_out[chunk] = code;
       }
     }
   }
 
   void populate_chunk_inner_products(const float* query_vec, float* dist_vec) {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (_u64 chunk = 0; chunk < n_chunks; chunk++) {
       // sum (q-c)^2 for the dimensions associated with this chunk
-      float* chunk_dists = dist_vec + (256 * chunk);
+      float* chunk_dists = dist_vec + (num_centers * chunk);
       for (_u64 j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++) {
         _u64         permuted_dim_in_query = rearrangement[j];
-        const float* centers_dim_vec = tables_T.get() + (256 * j);
-        for (_u64 idx = 0; idx < 256; idx++) {
+        const float* centers_dim_vec = tables_T.get() + (num_centers * j);
+        for (_u64 idx = 0; idx < num_centers; idx++) {
           double prod =
               centers_dim_vec[idx] *
               query_vec[permuted_dim_in_query];  // assumes that we are not
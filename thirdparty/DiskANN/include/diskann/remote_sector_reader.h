@@ -0,0 +1,125 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "aligned_file_reader.h"
+#include "knowhere/file_manager.h"
+
+struct SectorCacheConfig {
+  // the memory for the most recently used sectors
+  uint64_t dram_bytes = 0;
+  // a local file for the sectors fetched before, none if empty. It belongs to
+  // one reader, which truncates it when created and removes it when destroyed.
+  std::string ssd_path;
+  uint64_t    ssd_bytes = 0;
+  // the missing sectors of a batch at most this many sectors apart are
+  // fetched with one ranged read, and the ones in between are cached as well
+  uint64_t max_coalesce_gap = 4;
+  // the most ranged reads of a batch in flight at once
+  uint64_t max_parallel_reads = 8;
+};
+
+// The sectors of a remote file kept locally, in two tiers: the most recently
+// used ones in memory, and every fetched one on a local SSD file until its slot
+// is reused, in the order they were written. A sector found on the SSD moves
+// to the memory again. Thread safe.
+class SectorCache {
+ public:
+  static constexpr uint64_t kSectorLen = 4096;
+
+  explicit SectorCache(const SectorCacheConfig &config);
+  ~SectorCache();
+
+  // copies the sector into buf, false if it is not cached
+  bool get(uint64_t sector, char *buf);
+  void put(uint64_t sector, const char *buf);
+
+ private:
+  static constexpr uint64_t kNoSector = ~0ULL;
+
+  bool get_dram(uint64_t sector, char *buf);
+  void put_dram(uint64_t sector, const char *buf);
+  bool get_ssd(uint64_t sector, char *buf);
+  void put_ssd(uint64_t sector, const char *buf);
+
+  // <sector, slot>, the most recently used first
+  using DramList = std::list<std::pair<uint64_t, uint64_t>>;
+
+  std::mutex                                        dram_mtx_;
+  uint64_t                                          dram_slots_ = 0;
+  std::unique_ptr<char[]>                           dram_buf_;
+  DramList                                          dram_lru_;
+  std::unordered_map<uint64_t, DramList::iterator> dram_map_;
+
+  // A slot is reused in turn. Its generation changes before it is rewritten,
+  // so that a read of the slot that raced with the rewrite is dropped.
+  std::mutex                             ssd_mtx_;
+  std::string                            ssd_path_;
+  int                                    ssd_fd_ = -1;
+  uint64_t                               ssd_slots_ = 0;
+  uint64_t                               ssd_next_ = 0;
+  std::vector<uint64_t>                  ssd_slot_sector_;
+  std::vector<uint64_t>                  ssd_slot_gen_;
+  std::unordered_map<uint64_t, uint64_t> ssd_map_;
+};
+
+// An AlignedFileReader of a file that is not on the local disk, e.g. a disk
+// index in an object storage, read with the ranged reads of a
+// knowhere::FileRangeReader through a SectorCache. The sectors a batch misses
+// are coalesced into as few ranged reads as the gaps between them allow, which
+// are issued in parallel. The reads must be sector aligned. There is no
+// asynchronous IO, submit_req() reads at once and the contexts are dummies.
+class RemoteSectorReader : public AlignedFileReader {
+ public:
+  RemoteSectorReader(std::shared_ptr<knowhere::FileRangeReader> remote,
+                     const SectorCacheConfig                   &config);
+
+  io_context_t get_ctx() override {
+    return dummy_ctx();
+  }
+
+  io_context_t try_get_ctx() override {
+    return dummy_ctx();
+  }
+
+  void put_ctx(io_context_t) override {
+  }
+
+  size_t max_events_per_ctx() override {
+    return MAX_IO_DEPTH;
+  }
+
+  std::optional<uint64_t> remote_file_size() override {
+    return file_size_;
+  }
+
+  // the remote reader is bound to its file already, fname is only logged
+  void open(const std::string &fname) override;
+  void close() override;
+
+  void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx,
+            bool async = false) override;
+
+  void get_submitted_req(io_context_t &ctx, size_t n_ops) override;
+  void submit_req(io_context_t &ctx, std::vector<AlignedRead> &read_reqs) override;
+
+ private:
+  io_context_t dummy_ctx() {
+    return reinterpret_cast<io_context_t>(&dummy_ctx_);
+  }
+
+  // fetches the sectors into their destinations and the cache
+  void fetch(const std::unordered_map<uint64_t, std::vector<char *>> &missing);
+
+  std::shared_ptr<knowhere::FileRangeReader> remote_;
+  SectorCacheConfig                          config_;
+  SectorCache                                cache_;
+  uint64_t                                   file_size_ = 0;
+  char                                       dummy_ctx_ = 0;
+};
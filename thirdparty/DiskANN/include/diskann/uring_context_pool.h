@@ -0,0 +1,328 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include "aio_context_pool.h"
+
+// A single io_uring set up with the raw syscalls, so no liburing is needed.
+// Only one thread may use a ring at a time, which the pool below ensures.
+class UringContext {
+ public:
+  // wq_fd is a ring whose sq thread (for sqpoll) this ring shares, or -1
+  UringContext(unsigned entries, bool sqpoll, int wq_fd) {
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    if (sqpoll) {
+      p.flags |= IORING_SETUP_SQPOLL;
+      if (wq_fd >= 0) {
+        p.flags |= IORING_SETUP_ATTACH_WQ;
+        p.wq_fd = wq_fd;
+      }
+    }
+    int fd = (int) syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) {
+      err_ = errno;
+      return;
+    }
+    ring_fd_ = fd;
+    sqpoll_ = sqpoll;
+
+    sq_ring_sz_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_ring_sz_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    single_mmap_ = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap_) {
+      sq_ring_sz_ = cq_ring_sz_ = std::max(sq_ring_sz_, cq_ring_sz_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_sz_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      sq_ring_ = nullptr;
+      err_ = errno;
+      release();
+      return;
+    }
+    if (single_mmap_) {
+      cq_ring_ = sq_ring_;
+    } else {
+      cq_ring_ = mmap(nullptr, cq_ring_sz_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cq_ring_ == MAP_FAILED) {
+        cq_ring_ = nullptr;
+        err_ = errno;
+        release();
+        return;
+      }
+    }
+    sqes_sz_ = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_sz_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      err_ = errno;
+      release();
+      return;
+    }
+    sqes_ = (io_uring_sqe *) sqes;
+
+    char *sq = (char *) sq_ring_;
+    sq_head_ = (unsigned *) (sq + p.sq_off.head);
+    sq_tail_ = (unsigned *) (sq + p.sq_off.tail);
+    sq_mask_ = *(unsigned *) (sq + p.sq_off.ring_mask);
+    sq_flags_ = (unsigned *) (sq + p.sq_off.flags);
+    sq_array_ = (unsigned *) (sq + p.sq_off.array);
+    char *cq = (char *) cq_ring_;
+    cq_head_ = (unsigned *) (cq + p.cq_off.head);
+    cq_tail_ = (unsigned *) (cq + p.cq_off.tail);
+    cq_mask_ = *(unsigned *) (cq + p.cq_off.ring_mask);
+    cqes_ = (io_uring_cqe *) (cq + p.cq_off.cqes);
+    entries_ = p.sq_entries;
+    // the sqes always sit in the slot of the same index
+    for (unsigned i = 0; i < entries_; ++i) {
+      sq_array_[i] = i;
+    }
+  }
+
+  UringContext(const UringContext &) = delete;
+  UringContext &operator=(const UringContext &) = delete;
+
+  ~UringContext() {
+    release();
+  }
+
+  bool valid() const {
+    return ring_fd_ >= 0;
+  }
+
+  // errno of the failed setup
+  int error() const {
+    return err_;
+  }
+
+  int fd() const {
+    return ring_fd_;
+  }
+
+  unsigned entries() const {
+    return entries_;
+  }
+
+  // queues a read, at most entries() reads may be in flight
+  void prep_read(int fd, void *buf, unsigned len, uint64_t offset) {
+    unsigned      tail = *sq_tail_;
+    io_uring_sqe *sqe = &sqes_[tail & sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) buf;
+    sqe->len = len;
+    sqe->off = offset;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    queued_++;
+  }
+
+  // hands the queued reads to the kernel, returns 0 or -errno
+  int submit() {
+    if (sqpoll_) {
+      // the tail store must be visible before the flag is read
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (__atomic_load_n(sq_flags_, __ATOMIC_RELAXED) &
+          IORING_SQ_NEED_WAKEUP) {
+        if (enter(0, 0, IORING_ENTER_SQ_WAKEUP) < 0 && errno != EINTR) {
+          return -errno;
+        }
+      }
+      queued_ = 0;
+      return 0;
+    }
+    while (queued_ > 0) {
+      int ret = enter(queued_, 0, 0);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+          continue;
+        }
+        return -errno;
+      }
+      queued_ -= std::min<unsigned>(ret, queued_);
+    }
+    return 0;
+  }
+
+  // reaps n completions, returns 0 or the first -errno of the failed
+  // reads or of the wait
+  int wait(size_t n) {
+    int    err = 0;
+    size_t done = 0;
+    while (done < n) {
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail && done < n; ++head, ++done) {
+        int res = cqes_[head & cq_mask_].res;
+        if (res < 0 && err == 0) {
+          err = res;
+        }
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      if (done < n && enter(0, n - done, IORING_ENTER_GETEVENTS) < 0 &&
+          errno != EINTR && errno != EAGAIN) {
+        return -errno;
+      }
+    }
+    return err;
+  }
+
+ private:
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int) syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                         min_complete, flags, nullptr, 0);
+  }
+
+  void release() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_sz_);
+      sqes_ = nullptr;
+    }
+    if (cq_ring_ != nullptr && !single_mmap_) {
+      munmap(cq_ring_, cq_ring_sz_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_ring_sz_);
+      sq_ring_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+      ::close(ring_fd_);
+      ring_fd_ = -1;
+    }
+  }
+
+  int           ring_fd_ = -1;
+  int           err_ = 0;
+  bool          sqpoll_ = false;
+  bool          single_mmap_ = false;
+  void         *sq_ring_ = nullptr;
+  void         *cq_ring_ = nullptr;
+  size_t        sq_ring_sz_ = 0;
+  size_t        cq_ring_sz_ = 0;
+  size_t        sqes_sz_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  unsigned     *sq_head_ = nullptr;
+  unsigned     *sq_tail_ = nullptr;
+  unsigned     *sq_flags_ = nullptr;
+  unsigned     *sq_array_ = nullptr;
+  unsigned      sq_mask_ = 0;
+  unsigned     *cq_head_ = nullptr;
+  unsigned     *cq_tail_ = nullptr;
+  unsigned      cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+  unsigned      entries_ = 0;
+  unsigned      queued_ = 0;
+};
+
+// The io_uring counterpart of AioContextPool. Unlike that one it is only
+// created by InitGlobalUringPool, DiskANN stays on libaio without it.
+class UringContextPool {
+ public:
+  UringContextPool(const UringContextPool &) = delete;
+
+  UringContextPool &operator=(const UringContextPool &) = delete;
+
+  size_t max_events_per_ctx() {
+    return max_events_;
+  }
+
+  void push(UringContext *ctx) {
+    {
+      std::scoped_lock lk(ctx_mtx_);
+      ctx_q_.push(ctx);
+    }
+    ctx_cv_.notify_one();
+  }
+
+  UringContext *pop() {
+    std::unique_lock lk(ctx_mtx_);
+    ctx_cv_.wait(lk, [this] { return ctx_q_.size(); });
+    auto ret = ctx_q_.front();
+    ctx_q_.pop();
+    return ret;
+  }
+
+  // nullptr if no context is free right now
+  UringContext *try_pop() {
+    std::scoped_lock lk(ctx_mtx_);
+    if (ctx_q_.empty()) {
+      return nullptr;
+    }
+    auto ret = ctx_q_.front();
+    ctx_q_.pop();
+    return ret;
+  }
+
+  // sets the rings up at once, so it fails if io_uring is not available,
+  // e.g. on older kernels or when it is blocked by seccomp. With sqpoll
+  // the rings share one kernel thread that polls their submission queues.
+  static bool InitGlobalUringPool(size_t num_ctx, size_t max_events,
+                                  bool sqpoll) {
+    if (num_ctx <= 0) {
+      LOG(ERROR) << "num_ctx should be bigger than 0";
+      return false;
+    }
+    if (max_events > default_max_events) {
+      LOG(ERROR) << "max_events " << max_events
+                 << " should not be larger than " << default_max_events;
+      return false;
+    }
+    std::scoped_lock lk(global_uring_pool_mut);
+    if (global_uring_pool != nullptr) {
+      LOG(WARNING) << "Global UringContextPool has already been inialized "
+                      "with context num: "
+                   << global_uring_pool->ctx_bak_.size();
+      return true;
+    }
+    std::shared_ptr<UringContextPool> pool(
+        new UringContextPool(num_ctx, max_events, sqpoll));
+    if (pool->ctx_bak_.size() != num_ctx) {
+      return false;
+    }
+    global_uring_pool = pool;
+    return true;
+  }
+
+  // nullptr if the pool is not initialized
+  static std::shared_ptr<UringContextPool> GetGlobalUringPool() {
+    std::scoped_lock lk(global_uring_pool_mut);
+    return global_uring_pool;
+  }
+
+ private:
+  std::vector<std::unique_ptr<UringContext>> ctx_bak_;
+  std::queue<UringContext *>                 ctx_q_;
+  std::mutex                                 ctx_mtx_;
+  std::condition_variable                    ctx_cv_;
+  size_t                                     max_events_;
+  inline static std::shared_ptr<UringContextPool> global_uring_pool = nullptr;
+  inline static std::mutex                        global_uring_pool_mut;
+
+  UringContextPool(size_t num_ctx, size_t max_events, bool sqpoll)
+      : max_events_(max_events) {
+    for (size_t i = 0; i < num_ctx; ++i) {
+      int  wq_fd = ctx_bak_.empty() ? -1 : ctx_bak_.front()->fd();
+      auto ctx = std::make_unique<UringContext>(max_events, sqpoll, wq_fd);
+      if (!ctx->valid()) {
+        LOG(ERROR) << "io_uring_setup() failed, errno: " << ctx->error()
+                   << ", " << ::strerror(ctx->error());
+        return;
+      }
+      ctx_q_.push(ctx.get());
+      ctx_bak_.push_back(std::move(ctx));
+    }
+  }
+};
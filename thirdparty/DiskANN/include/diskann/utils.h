@@ -875,6 +875,41 @@ namespace diskann {
     return disk_index_filename + "_max_base_norm.bin";
   }
 
+  inline std::string get_disk_index_labels_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_labels.bin";
+  }
+
+  inline std::string get_disk_index_label_medoids_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_label_medoids.bin";
+  }
+
+  inline std::string get_disk_index_sector_order_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_sector_order.bin";
+  }
+
+  inline std::string get_disk_index_nav_ids_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_nav_ids.bin";
+  }
+
+  inline std::string get_disk_index_nav_data_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_nav_data.bin";
+  }
+
+  inline std::string get_disk_index_nav_graph_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_nav_graph.bin";
+  }
+
+  inline std::string get_disk_index_deleted_ids_filename(
+      const std::string& disk_index_filename) {
+    return disk_index_filename + "_deleted_ids.bin";
+  }
+
   inline std::string get_cached_nodes_file(
       const std::string& disk_index_filename) {
     return disk_index_filename + "_cached_nodes.bin";
@@ -4,10 +4,19 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
 #include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #if defined(RELEASE_UNUSED_TCMALLOC_MEMORY_AT_CHECKPOINTS) && \
@@ -25,6 +34,7 @@
 #include "diskann/percentile_stats.h"
 #include "diskann/pq_flash_index.h"
 #include "knowhere/comp/thread_pool.h"
+#include "tsl/robin_map.h"
 #include "tsl/robin_set.h"
 
 #include "diskann/utils.h"
@@ -478,7 +488,7 @@ namespace diskann {
       std::string base_file, bool ip_prepared, diskann::Metric compareMetric,
       unsigned L, unsigned R, bool accelerate_build, bool shuffle_build, double sampling_rate,
       double ram_budget, std::string mem_index_path, std::string medoids_file,
-      std::string centroids_file) {
+      std::string centroids_file, unsigned num_parallel_shards) {
     size_t base_num, base_dim;
     diskann::get_bin_metadata(base_file, base_num, base_dim);
 
@@ -511,14 +521,17 @@ namespace diskann {
       return _pvamanaIndex;
     }
     std::string merged_index_prefix = mem_index_path + "_tempFiles";
-    int         num_parts =
-        partition_with_ram_budget<T>(base_file, sampling_rate, ram_budget,
-                                     2 * R / 3, merged_index_prefix, 2);
+    // with parallel shards every shard gets its part of the budget, so that
+    // they fit in it together
+    num_parallel_shards = (std::max)(num_parallel_shards, 1u);
+    int num_parts = partition_with_ram_budget<T>(
+        base_file, sampling_rate, ram_budget / num_parallel_shards, 2 * R / 3,
+        merged_index_prefix, 2);
 
     std::string cur_centroid_filepath = merged_index_prefix + "_centroids.bin";
     std::rename(cur_centroid_filepath.c_str(), centroids_file.c_str());
 
-    for (int p = 0; p < num_parts; p++) {
+    auto build_shard = [&](int p) {
       std::string shard_base_file =
           merged_index_prefix + "_subshard-" + std::to_string(p) + ".bin";
 
@@ -540,6 +553,7 @@ namespace diskann {
       paras.Set<bool>("saturate_graph", 0);
       paras.Set<std::string>("save_path", shard_index_file);
       paras.Set<bool>("accelerate_build", accelerate_build);
+      paras.Set<bool>("shuffle_build", shuffle_build);
 
       _u64 shard_base_dim, shard_base_pts;
       get_bin_metadata(shard_base_file, shard_base_pts, shard_base_dim);
@@ -550,6 +564,66 @@ namespace diskann {
       _pvamanaIndex->build(shard_base_file.c_str(), shard_base_pts, paras);
       _pvamanaIndex->save(shard_index_file.c_str());
       std::remove(shard_base_file.c_str());
+    };
+
+    if (num_parallel_shards == 1) {
+      for (int p = 0; p < num_parts; p++) {
+        build_shard(p);
+      }
+    } else {
+      // The shards are built on their own threads, while the graph builds in
+      // them share the build pool. That keeps the pool busy through the
+      // serial parts of every build, like the data loads and the syncs
+      // between the passes. A shard starts once its estimated memory fits
+      // in what the running ones leave of the budget.
+      const double ram_budget_bytes = ram_budget * 1024 * 1024 * 1024;
+      double       ram_in_use = 0;
+      std::exception_ptr       error = nullptr;
+      std::mutex               mtx;
+      std::condition_variable  cv;
+      std::vector<std::thread> workers;
+      for (int p = 0; p < num_parts; p++) {
+        size_t shard_pts, shard_dim;
+        diskann::get_bin_metadata(merged_index_prefix + "_subshard-" +
+                                      std::to_string(p) + "_ids_uint32.bin",
+                                  shard_pts, shard_dim);
+        const double shard_ram =
+            estimate_ram_usage(shard_pts, base_dim, sizeof(T), 2 * (R / 3));
+        {
+          std::unique_lock lk(mtx);
+          cv.wait(lk, [&] {
+            return error != nullptr || ram_in_use == 0 ||
+                   ram_in_use + shard_ram <= ram_budget_bytes;
+          });
+          if (error != nullptr) {
+            break;
+          }
+          ram_in_use += shard_ram;
+        }
+        LOG_KNOWHERE_INFO_ << "Building shard " << p << " of " << num_parts
+                           << " with " << shard_pts << " points";
+        workers.emplace_back([&, p, shard_ram]() {
+          try {
+            build_shard(p);
+          } catch (...) {
+            std::scoped_lock lk(mtx);
+            if (error == nullptr) {
+              error = std::current_exception();
+            }
+          }
+          {
+            std::scoped_lock lk(mtx);
+            ram_in_use -= shard_ram;
+          }
+          cv.notify_all();
+        });
+      }
+      for (auto &worker : workers) {
+        worker.join();
+      }
+      if (error != nullptr) {
+        std::rethrow_exception(error);
+      }
     }
 
     diskann::merge_shards(merged_index_prefix + "_subshard-", "_mem.index",
@@ -583,6 +657,238 @@ namespace diskann {
     return nullptr;
   }
 
+  // Stitched-Vamana: a graph is built over the points of every label, its
+  // edges go first in the neighbor lists and the rest is filled up from the
+  // graph over all points. A search from the entry point of a label that only
+  // follows the edges within the label then stays connected, while the
+  // unfiltered searches still see the edges of the full graph.
+  template<typename T>
+  void stitch_label_graphs(const std::string &base_file,
+                           const std::string &label_file, bool ip_prepared,
+                           unsigned L, unsigned R, bool accelerate_build,
+                           const std::string &mem_index_path,
+                           const std::string &disk_index_path) {
+    size_t base_num, base_dim;
+    diskann::get_bin_metadata(base_file, base_num, base_dim);
+
+    std::unique_ptr<_u32[]> labels = nullptr;
+    size_t                  label_num, label_dim;
+    diskann::load_bin<_u32>(label_file, labels, label_num, label_dim);
+    if (label_num != base_num || label_dim != 1) {
+      std::stringstream stream;
+      stream << "Label file " << label_file << " has " << label_num << "x"
+             << label_dim << " labels, expected one for each of the "
+             << base_num << " points." << std::endl;
+      throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+
+    std::vector<std::vector<unsigned>> graph(base_num);
+    _u64                               index_size, frozen_pts;
+    unsigned                           width, medoid;
+    {
+      std::ifstream in(mem_index_path, std::ios::binary);
+      in.read((char *) &index_size, sizeof(_u64));
+      in.read((char *) &width, sizeof(unsigned));
+      in.read((char *) &medoid, sizeof(unsigned));
+      in.read((char *) &frozen_pts, sizeof(_u64));
+      for (auto &nbrs : graph) {
+        unsigned k;
+        in.read((char *) &k, sizeof(unsigned));
+        nbrs.resize(k);
+        in.read((char *) nbrs.data(), k * sizeof(unsigned));
+      }
+      if (!in) {
+        throw diskann::ANNException("Failed to read " + mem_index_path, -1,
+                                    __FUNCSIG__, __FILE__, __LINE__);
+      }
+    }
+
+    // ordered, so that the label medoids file is the same for every build
+    std::map<_u32, std::vector<_u32>> label_pts;
+    for (_u32 i = 0; i < base_num; i++) {
+      label_pts[labels[i]].push_back(i);
+    }
+    LOG_KNOWHERE_INFO_ << "Building the graphs of " << label_pts.size()
+                       << " labels";
+
+    const unsigned label_R = (std::max)(R / 2, 1u);
+    std::string    label_ids_file = mem_index_path + "_label_ids_uint32.bin";
+    std::string    label_data_file = mem_index_path + "_label_data.bin";
+    std::vector<std::vector<unsigned>> label_graph(base_num);
+    std::vector<_u32>                  label_medoids;
+    label_medoids.reserve(2 * label_pts.size());
+    for (auto &[label, pts] : label_pts) {
+      _u32 label_medoid = pts[0];
+      if (pts.size() <= label_R + 1) {
+        // too few points for a graph, they are all connected
+        for (auto p : pts) {
+          for (auto q : pts) {
+            if (p != q) {
+              label_graph[p].push_back(q);
+            }
+          }
+        }
+      } else {
+        diskann::save_bin<_u32>(label_ids_file, pts.data(), pts.size(), 1);
+        retrieve_shard_data_from_ids<T>(base_file, label_ids_file,
+                                        label_data_file);
+
+        diskann::Parameters paras;
+        paras.Set<unsigned>("L", L);
+        paras.Set<unsigned>("R", label_R);
+        paras.Set<unsigned>("C", 750);
+        paras.Set<float>("alpha", 1.2f);
+        paras.Set<unsigned>("num_rnds", 2);
+        paras.Set<bool>("saturate_graph", 0);
+        paras.Set<bool>("accelerate_build", accelerate_build);
+        paras.Set<bool>("shuffle_build", false);
+        diskann::Index<T> label_index(diskann::Metric::L2, ip_prepared,
+                                      base_dim, pts.size(), false, false);
+        label_index.build(label_data_file.c_str(), pts.size(), paras);
+        const auto *sub_graph = label_index.get_graph();
+        for (size_t j = 0; j < pts.size(); j++) {
+          for (auto nbr : (*sub_graph)[j]) {
+            label_graph[pts[j]].push_back(pts[nbr]);
+          }
+        }
+        label_medoid = pts[label_index.get_entry_point()];
+      }
+      label_medoids.push_back(label);
+      label_medoids.push_back(label_medoid);
+    }
+    std::remove(label_ids_file.c_str());
+    std::remove(label_data_file.c_str());
+
+    // the label edges first, then the edges of the full graph not in them
+    unsigned max_degree = 0;
+    index_size = 24;
+    for (_u64 i = 0; i < base_num; i++) {
+      auto &nbrs = label_graph[i];
+      for (auto nbr : graph[i]) {
+        if (nbrs.size() >= R) {
+          break;
+        }
+        if (std::find(nbrs.begin(), nbrs.end(), nbr) == nbrs.end()) {
+          nbrs.push_back(nbr);
+        }
+      }
+      if (nbrs.size() > R) {
+        nbrs.resize(R);
+      }
+      max_degree = (std::max)(max_degree, (unsigned) nbrs.size());
+      index_size += sizeof(unsigned) * (nbrs.size() + 1);
+    }
+    {
+      std::ofstream out(mem_index_path, std::ios::binary | std::ios::trunc);
+      out.write((char *) &index_size, sizeof(_u64));
+      out.write((char *) &max_degree, sizeof(unsigned));
+      out.write((char *) &medoid, sizeof(unsigned));
+      out.write((char *) &frozen_pts, sizeof(_u64));
+      for (auto &nbrs : label_graph) {
+        unsigned k = (unsigned) nbrs.size();
+        out.write((char *) &k, sizeof(unsigned));
+        out.write((char *) nbrs.data(), k * sizeof(unsigned));
+      }
+    }
+
+    diskann::save_bin<_u32>(
+        get_disk_index_labels_filename(disk_index_path), labels.get(),
+        base_num, 1);
+    diskann::save_bin<_u32>(
+        get_disk_index_label_medoids_filename(disk_index_path),
+        label_medoids.data(), label_pts.size(), 2);
+  }
+
+  // Starling: a Vamana graph over a random sample of the points, kept in memory
+  // with the vectors of the sample, so that a search finds the entry points
+  // near the query before it reads any sector. The sample is saved with the
+  // entry point of its graph first.
+  template<typename T>
+  void build_nav_graph(const std::string &base_file, bool ip_prepared,
+                       unsigned L, unsigned R, bool accelerate_build,
+                       float sample_ratio, const std::string &disk_index_path) {
+    size_t base_num, base_dim;
+    diskann::get_bin_metadata(base_file, base_num, base_dim);
+    const _u64 nav_num = (std::min)(
+        (_u64) base_num, (_u64) std::ceil(base_num * (double) sample_ratio));
+    if (nav_num <= R + 1) {
+      LOG_KNOWHERE_INFO_ << "Too few points for a navigation graph, the "
+                            "searches start from the medoids";
+      return;
+    }
+
+    // a fixed seed, so that rebuilding the same data gives the same sample
+    std::vector<_u32> nav_ids(base_num);
+    std::iota(nav_ids.begin(), nav_ids.end(), 0);
+    std::mt19937 rng(0x5eed);
+    std::shuffle(nav_ids.begin(), nav_ids.end(), rng);
+    nav_ids.resize(nav_num);
+    std::sort(nav_ids.begin(), nav_ids.end());
+
+    std::string nav_ids_file = get_disk_index_nav_ids_filename(disk_index_path);
+    std::string nav_data_file = disk_index_path + "_nav_data_tmp.bin";
+    diskann::save_bin<_u32>(nav_ids_file, nav_ids.data(), nav_num, 1);
+    retrieve_shard_data_from_ids<T>(base_file, nav_ids_file, nav_data_file);
+
+    diskann::Parameters paras;
+    paras.Set<unsigned>("L", L);
+    paras.Set<unsigned>("R", R);
+    paras.Set<unsigned>("C", 750);
+    paras.Set<float>("alpha", 1.2f);
+    paras.Set<unsigned>("num_rnds", 2);
+    paras.Set<bool>("saturate_graph", 0);
+    paras.Set<bool>("accelerate_build", accelerate_build);
+    paras.Set<bool>("shuffle_build", false);
+    diskann::Index<T> nav_index(diskann::Metric::L2, ip_prepared, base_dim,
+                                nav_num, false, false);
+    nav_index.build(nav_data_file.c_str(), nav_num, paras);
+    const auto *nav_graph = nav_index.get_graph();
+
+    // the entry point swaps places with the first point of the sample, the
+    // swap is its own inverse
+    const _u32        entry = nav_index.get_entry_point();
+    std::vector<_u32> order(nav_num);
+    std::iota(order.begin(), order.end(), 0);
+    std::swap(order[0], order[entry]);
+    std::swap(nav_ids[0], nav_ids[entry]);
+
+    unsigned width = 0;
+    for (const auto &nbrs : *nav_graph) {
+      width = (std::max)(width, (unsigned) nbrs.size());
+    }
+    // a row is the degree and the neighbors, padded to the widest
+    std::vector<_u32> rows(nav_num * (width + 1), 0);
+    for (_u64 i = 0; i < nav_num; i++) {
+      const auto &nbrs = (*nav_graph)[order[i]];
+      _u32       *row = rows.data() + i * (width + 1);
+      row[0] = nbrs.size();
+      for (size_t j = 0; j < nbrs.size(); j++) {
+        row[j + 1] = order[nbrs[j]];
+      }
+    }
+
+    std::unique_ptr<T[]> sample_data = nullptr;
+    size_t               npts, dim;
+    diskann::load_bin<T>(nav_data_file, sample_data, npts, dim);
+    std::vector<float> nav_data(nav_num * base_dim);
+    for (_u64 i = 0; i < nav_num; i++) {
+      for (_u64 d = 0; d < base_dim; d++) {
+        nav_data[i * base_dim + d] =
+            (float) sample_data[order[i] * base_dim + d];
+      }
+    }
+    std::remove(nav_data_file.c_str());
+
+    diskann::save_bin<_u32>(nav_ids_file, nav_ids.data(), nav_num, 1);
+    diskann::save_bin<float>(get_disk_index_nav_data_filename(disk_index_path),
+                             nav_data.data(), nav_num, base_dim);
+    diskann::save_bin<_u32>(get_disk_index_nav_graph_filename(disk_index_path),
+                            rows.data(), nav_num, width + 1);
+    LOG_KNOWHERE_INFO_ << "Built the navigation graph of " << nav_num
+                       << " points";
+  }
+
   template<typename T>
   void generate_cache_list_from_graph_with_pq(
       _u64 num_nodes_to_cache, unsigned R, const diskann::Metric compare_metric,
@@ -679,13 +985,32 @@ namespace diskann {
         auto pq_table_dists =
             std::shared_ptr<float[]>(new float[256 * aligned_dim]);
         auto scratch_dists = std::shared_ptr<float[]>(new float[R]);
-        auto scratch_ids = std::shared_ptr<_u8[]>(new _u8[R * aligned_dim]);
+        auto scratch_ids = std::shared_ptr<_u8[]>(
+            new _u8[ROUND_UP(R, 32) * aligned_dim]);
         pq_table.populate_chunk_distances(query_float.get(),
                                           pq_table_dists.get());
+        // pq_chunks is the code size, 4-bit codes use the fast scan
+        const bool pq4 = pq_table.get_num_centers() == NUM_PQ4_CENTROIDS;
+        std::unique_ptr<_u8[]>  pq4_lut;
+        std::unique_ptr<_u16[]> pq4_sums;
+        float                   pq4_scale = 1.0f, pq4_bias = 0.0f;
+        if (pq4) {
+          pq4_lut = std::make_unique<_u8[]>(32 * pq_chunks);
+          pq4_sums = std::make_unique<_u16[]>(ROUND_UP(R, 32));
+          quantize_pq4_dists(pq_table_dists.get(), pq_table.get_num_chunks(),
+                             pq4_lut.get(), pq4_scale, pq4_bias);
+        }
 
         auto compute_dists = [&, scratch_ids, pq_table_dists](
                                  const unsigned *ids, const _u64 n_ids,
                                  float *dists_out) {
+          if (pq4) {
+            aggregate_pq4_coords(ids, n_ids, pq_code.get(), pq_chunks,
+                                 scratch_ids.get());
+            pq4_dist_lookup(scratch_ids.get(), n_ids, pq_chunks, pq4_lut.get(),
+                            pq4_scale, pq4_bias, pq4_sums.get(), dists_out);
+            return;
+          }
           aggregate_coords(ids, n_ids, pq_code.get(), pq_chunks,
                            scratch_ids.get());
           pq_dist_lookup(scratch_ids.get(), n_ids, pq_chunks,
@@ -1061,6 +1386,137 @@ namespace diskann {
     LOG_KNOWHERE_DEBUG_ << "Output file written.";
   }
 
+  // The sectors are filled one after the other. Every sector starts with the
+  // first node not placed yet and then takes the node with the most edges
+  // from the nodes already in it, or the next node in id order once the
+  // sector has no edges left to follow.
+  static std::vector<_u32> pack_sectors_by_graph(
+      const std::string &mem_index_file, const _u64 npts,
+      const _u64 nnodes_per_sector) {
+    std::ifstream vamana_reader(mem_index_file, std::ios::binary);
+    _u64          index_file_size, vamana_frozen_num;
+    unsigned      width_u32, medoid_u32;
+    vamana_reader.read((char *) &index_file_size, sizeof(uint64_t));
+    vamana_reader.read((char *) &width_u32, sizeof(unsigned));
+    vamana_reader.read((char *) &medoid_u32, sizeof(unsigned));
+    vamana_reader.read((char *) &vamana_frozen_num, sizeof(_u64));
+
+    std::vector<_u64> offsets(npts + 1, 0);
+    std::vector<_u32> nbrs;
+    for (_u64 i = 0; i < npts; i++) {
+      unsigned nnbrs;
+      vamana_reader.read((char *) &nnbrs, sizeof(unsigned));
+      offsets[i + 1] = offsets[i] + nnbrs;
+      nbrs.resize(offsets[i + 1]);
+      vamana_reader.read((char *) (nbrs.data() + offsets[i]),
+                         nnbrs * sizeof(unsigned));
+    }
+
+    boost::dynamic_bitset<>    placed(npts);
+    std::vector<_u32>          loc_to_id;
+    tsl::robin_map<_u32, _u32> candidates;
+    loc_to_id.reserve(npts);
+    _u64 next_seed = 0;
+    auto place = [&](_u32 id) {
+      placed[id] = true;
+      loc_to_id.push_back(id);
+      candidates.erase(id);
+      for (_u64 j = offsets[id]; j < offsets[id + 1]; j++) {
+        if (!placed[nbrs[j]]) {
+          candidates[nbrs[j]]++;
+        }
+      }
+    };
+    auto place_next_seed = [&]() {
+      while (placed[next_seed]) {
+        next_seed++;
+      }
+      place((_u32) next_seed);
+    };
+
+    while (loc_to_id.size() < npts) {
+      candidates.clear();
+      place_next_seed();
+      for (_u64 n = 1; n < nnodes_per_sector && loc_to_id.size() < npts; n++) {
+        _u32 best = 0, best_edges = 0;
+        for (const auto &[id, edges] : candidates) {
+          if (edges > best_edges) {
+            best = id;
+            best_edges = edges;
+          }
+        }
+        if (best_edges == 0) {
+          place_next_seed();
+        } else {
+          place(best);
+        }
+      }
+    }
+    return loc_to_id;
+  }
+
+  void reorder_disk_layout(const std::string &mem_index_file,
+                           const std::string &disk_index_file) {
+    std::ifstream disk_reader(disk_index_file, std::ios::binary);
+    std::unique_ptr<char[]> sector_buf = std::make_unique<char[]>(SECTOR_LEN);
+    disk_reader.read(sector_buf.get(), SECTOR_LEN);
+    const _u64 disk_index_file_size = *(_u64 *) (sector_buf.get());
+    const _u64 npts = *(_u64 *) (sector_buf.get() + 1 * sizeof(_u64));
+    const _u64 max_node_len = *(_u64 *) (sector_buf.get() + 3 * sizeof(_u64));
+    const _u64 nnodes_per_sector =
+        *(_u64 *) (sector_buf.get() + 4 * sizeof(_u64));
+    if (max_node_len > SECTOR_LEN || nnodes_per_sector <= 1) {
+      LOG_KNOWHERE_INFO_ << "Every sector holds a single node, the disk layout "
+                            "is not reordered";
+      return;
+    }
+
+    auto s = std::chrono::high_resolution_clock::now();
+    auto loc_to_id =
+        pack_sectors_by_graph(mem_index_file, npts, nnodes_per_sector);
+
+    const std::string tmp_file = disk_index_file + "_reorder_tmp";
+    const _u64        n_sectors =
+        ROUND_UP(npts, nnodes_per_sector) / nnodes_per_sector;
+    {
+      cached_ofstream diskann_writer(tmp_file, 64 * 1024 * 1024);
+      diskann_writer.write(sector_buf.get(), SECTOR_LEN);
+      for (_u64 sector = 0; sector < n_sectors; sector++) {
+        memset(sector_buf.get(), 0, SECTOR_LEN);
+        for (_u64 loc = sector * nnodes_per_sector;
+             loc < (sector + 1) * nnodes_per_sector && loc < npts; loc++) {
+          const _u64 id = loc_to_id[loc];
+          disk_reader.seekg((id / nnodes_per_sector + 1) * SECTOR_LEN +
+                            (id % nnodes_per_sector) * max_node_len);
+          disk_reader.read(
+              sector_buf.get() + (loc % nnodes_per_sector) * max_node_len,
+              max_node_len);
+        }
+        diskann_writer.write(sector_buf.get(), SECTOR_LEN);
+      }
+      // the reorder data after the graph is not part of the nodes
+      disk_reader.seekg((n_sectors + 1) * SECTOR_LEN);
+      for (_u64 sector = n_sectors + 1;
+           sector * SECTOR_LEN < disk_index_file_size; sector++) {
+        disk_reader.read(sector_buf.get(), SECTOR_LEN);
+        diskann_writer.write(sector_buf.get(), SECTOR_LEN);
+      }
+    }
+    disk_reader.close();
+    if (std::rename(tmp_file.c_str(), disk_index_file.c_str()) != 0) {
+      throw diskann::ANNException("Failed to replace " + disk_index_file, -1,
+                                  __FUNCSIG__, __FILE__, __LINE__);
+    }
+    diskann::save_bin<_u32>(
+        get_disk_index_sector_order_filename(disk_index_file),
+        loc_to_id.data(), npts, 1);
+
+    std::chrono::duration<double> diff =
+        std::chrono::high_resolution_clock::now() - s;
+    LOG_KNOWHERE_INFO_ << "Reordered the disk layout by the graph in "
+                       << diff.count() << "s";
+  }
+
   template<typename T>
   int build_disk_index(const BuildConfig &config) {
     if (!knowhere::KnowhereFloatTypeCheck<T>::value &&
@@ -1163,14 +1619,23 @@ namespace diskann {
 
     diskann::get_bin_metadata(data_file_to_use.c_str(), points_num, dim);
 
-    size_t num_pq_chunks =
-        (size_t) (std::floor)(_u64(pq_code_size_limit / points_num));
+    if (config.pq_code_nbits != 8 && config.pq_code_nbits != 4) {
+      LOG(ERROR) << "pq_code_nbits should be 4 or 8, got "
+                 << config.pq_code_nbits;
+      return -1;
+    }
+    const bool     pq4 = config.pq_code_nbits == 4;
+    const unsigned num_pq_centers = pq4 ? NUM_PQ4_CENTROIDS : NUM_PQ_CENTROIDS;
 
-    num_pq_chunks = num_pq_chunks <= 0 ? 1 : num_pq_chunks;
+    size_t num_pq_bytes =
+        (size_t) (std::floor)(_u64(pq_code_size_limit / points_num));
+    num_pq_bytes = num_pq_bytes <= 0 ? 1 : num_pq_bytes;
+    size_t num_pq_chunks = pq4 ? 2 * num_pq_bytes : num_pq_bytes;
     num_pq_chunks = num_pq_chunks > dim ? dim : num_pq_chunks;
 
     LOG_KNOWHERE_INFO_ << "Compressing " << dim << "-dimensional data into "
-                       << num_pq_chunks << " bytes per vector.";
+                       << num_pq_chunks << " chunks of "
+                       << config.pq_code_nbits << " bits per vector.";
 
     size_t train_size, train_dim;
     std::unique_ptr<float[]> train_data = nullptr;
@@ -1211,12 +1676,12 @@ namespace diskann {
     auto pq_s = std::chrono::high_resolution_clock::now();
 
     LOG_KNOWHERE_INFO_ << "Generating PQ pivots";
-    generate_pq_pivots(train_data.get(), train_size, (uint32_t) dim, 256,
-                       (uint32_t) num_pq_chunks, NUM_KMEANS_REPS,
-                       pq_pivots_path, make_zero_mean);
+    generate_pq_pivots(train_data.get(), train_size, (uint32_t) dim,
+                       num_pq_centers, (uint32_t) num_pq_chunks,
+                       NUM_KMEANS_REPS, pq_pivots_path, make_zero_mean);
 
     LOG_KNOWHERE_INFO_ << "Encoding PQ data";
-    generate_pq_data_from_pivots<T>(data_file_to_use.c_str(), 256,
+    generate_pq_data_from_pivots<T>(data_file_to_use.c_str(), num_pq_centers,
                                     (uint32_t) num_pq_chunks, pq_pivots_path,
                                     pq_compressed_vectors_path);
     auto pq_e = std::chrono::high_resolution_clock::now();
@@ -1233,7 +1698,13 @@ namespace diskann {
     auto vamana_index = diskann::build_merged_vamana_index<T>(
         data_file_to_use.c_str(), ip_prepared, diskann::Metric::L2, L, R,
         config.accelerate_build, config.shuffle_build, p_val, indexing_ram_budget, mem_index_path,
-        medoids_path, centroids_path);
+        medoids_path, centroids_path, config.num_parallel_shards);
+    if (!config.label_file_path.empty()) {
+      diskann::stitch_label_graphs<T>(data_file_to_use, config.label_file_path,
+                                      ip_prepared, L, R,
+                                      config.accelerate_build, mem_index_path,
+                                      disk_index_path);
+    }
     auto graph_e = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> graph_diff = graph_e - graph_s;
     LOG_KNOWHERE_INFO_ << "Training graph cost: " << graph_diff.count() << "s";
@@ -1249,6 +1720,21 @@ namespace diskann {
                                          mem_index_path, disk_index_path,
                                          data_file_to_save.c_str());
     }
+    // an order or deletes left by an earlier build would not match the new
+    // layout
+    std::remove(get_disk_index_sector_order_filename(disk_index_path).c_str());
+    std::remove(get_disk_index_deleted_ids_filename(disk_index_path).c_str());
+    std::remove(get_disk_index_nav_ids_filename(disk_index_path).c_str());
+    std::remove(get_disk_index_nav_data_filename(disk_index_path).c_str());
+    std::remove(get_disk_index_nav_graph_filename(disk_index_path).c_str());
+    if (config.nav_graph_ratio > 0) {
+      diskann::build_nav_graph<T>(data_file_to_use, ip_prepared, L, R,
+                                  config.accelerate_build,
+                                  config.nav_graph_ratio, disk_index_path);
+    }
+    if (config.reorder_sectors) {
+      diskann::reorder_disk_layout(mem_index_path, disk_index_path);
+    }
 
     double ten_percent_points = std::ceil(points_num * 0.1);
     double num_sample_points = ten_percent_points > MAX_SAMPLE_POINTS_FOR_WARMUP
@@ -1290,6 +1776,394 @@ namespace diskann {
     return 0;
   }
 
+  namespace {
+    // the vector as the graph sees it, normalized for cosine
+    template<typename T>
+    void to_graph_space(const T *vec, const _u64 dim,
+                        const diskann::Metric metric, float *out,
+                        float *norm = nullptr) {
+      float sum = 0;
+      for (_u64 d = 0; d < dim; d++) {
+        out[d] = (float) vec[d];
+        sum += out[d] * out[d];
+      }
+      float vec_norm = sum == 0 ? 1.0f : std::sqrt(sum);
+      if (metric == diskann::Metric::COSINE) {
+        for (_u64 d = 0; d < dim; d++) {
+          out[d] /= vec_norm;
+        }
+      }
+      if (norm != nullptr) {
+        *norm = vec_norm;
+      }
+    }
+
+    // the robust prune of Vamana over candidates sorted by their distance to
+    // the node, vecs holds the vectors of the candidates in the same order
+    void prune_merge_candidates(const std::vector<Neighbor> &pool,
+                                const float *vecs, const _u64 dim,
+                                const unsigned R, const float alpha,
+                                std::vector<unsigned> &pruned) {
+      pruned.clear();
+      std::vector<float> occlude_factor(pool.size(), 0);
+      for (float cur_alpha = 1; cur_alpha <= alpha && pruned.size() < R;
+           cur_alpha *= 1.2f) {
+        for (size_t i = 0; i < pool.size() && pruned.size() < R; i++) {
+          if (occlude_factor[i] > cur_alpha) {
+            continue;
+          }
+          occlude_factor[i] = std::numeric_limits<float>::max();
+          pruned.push_back(pool[i].id);
+          for (size_t j = i + 1; j < pool.size(); j++) {
+            if (occlude_factor[j] > alpha) {
+              continue;
+            }
+            float djk = faiss::fvec_L2sqr(vecs + i * dim, vecs + j * dim, dim);
+            occlude_factor[j] =
+                djk == 0 ? std::numeric_limits<float>::max()
+                         : std::max(occlude_factor[j], pool[j].distance / djk);
+          }
+        }
+      }
+    }
+  }  // namespace
+
+  template<typename T>
+  int merge_disk_index(const MergeConfig &config, PQFlashIndex<T> &index,
+                       const T                                  *insert_data,
+                       const std::vector<std::vector<unsigned>> &insert_graph,
+                       const std::vector<bool>                  &deleted) {
+    const std::string prefix = config.index_file_path;
+    const std::string disk_index_file = get_disk_index_filename(prefix);
+    const std::string pq_pivots_file = get_pq_pivots_filename(prefix);
+    const std::string pq_compressed_file = get_pq_compressed_filename(prefix);
+    const std::string norm_file =
+        get_disk_index_max_base_norm_file(disk_index_file);
+    const std::string medoids_file =
+        get_disk_index_medoids_filename(disk_index_file);
+    const std::string sector_order_file =
+        get_disk_index_sector_order_filename(disk_index_file);
+    const diskann::Metric metric = index.get_metric();
+    if (metric == diskann::Metric::INNER_PRODUCT || index.has_labels() ||
+        file_exists(disk_index_file + "_pq_pivots.bin")) {
+      LOG(ERROR) << "Only L2 and cosine disk indexes without labels and disk "
+                    "PQ can be merged";
+      return -1;
+    }
+    auto s = std::chrono::high_resolution_clock::now();
+
+    std::ifstream disk_reader(disk_index_file, std::ios::binary);
+    std::unique_ptr<char[]> meta = std::make_unique<char[]>(SECTOR_LEN);
+    disk_reader.read(meta.get(), SECTOR_LEN);
+    const _u64 npts = *(_u64 *) (meta.get() + 1 * sizeof(_u64));
+    const _u64 medoid = *(_u64 *) (meta.get() + 2 * sizeof(_u64));
+    const _u64 max_node_len = *(_u64 *) (meta.get() + 3 * sizeof(_u64));
+    const _u64 nnodes_per_sector =
+        *(_u64 *) (meta.get() + 4 * sizeof(_u64));
+    if (*(_u64 *) (meta.get() + 7 * sizeof(_u64)) != 0) {
+      LOG(ERROR) << "Disk indexes with reorder data can not be merged";
+      return -1;
+    }
+    const _u64 n_insert = insert_graph.size();
+    const _u64 new_npts = npts + n_insert;
+    if (deleted.size() != new_npts || npts != index.get_num_points()) {
+      LOG(ERROR) << "The deleted points cover " << deleted.size()
+                 << " points, the merged index has " << new_npts;
+      return -1;
+    }
+    const _u64 dim = index.get_data_dim();
+    const _u64 data_len = dim * sizeof(T);
+    const _u64 R = (max_node_len - data_len) / sizeof(unsigned) - 1;
+    const _u64 L = std::max<_u64>(config.search_list_size, R);
+    // a unit is a sector of nodes, or the sectors of a long node
+    const bool long_node = max_node_len > SECTOR_LEN;
+    const _u64 unit_len =
+        long_node ? ROUND_UP(max_node_len, SECTOR_LEN) : SECTOR_LEN;
+    const _u64 nodes_per_unit = long_node ? 1 : nnodes_per_sector;
+    const _u64 n_units = DIV_ROUND_UP(npts, nodes_per_unit);
+    const _u64 new_n_units = DIV_ROUND_UP(new_npts, nodes_per_unit);
+
+    // the inserted points are appended in their order
+    std::vector<_u32> loc_to_id;
+    std::vector<_u32> id_to_loc;
+    if (!long_node && file_exists(sector_order_file)) {
+      std::unique_ptr<_u32[]> buf = nullptr;
+      size_t                  nr, nc;
+      diskann::load_bin<_u32>(sector_order_file, buf, nr, nc);
+      loc_to_id.assign(buf.get(), buf.get() + nr);
+      id_to_loc.resize(nr);
+      for (_u64 loc = 0; loc < nr; loc++) {
+        id_to_loc[loc_to_id[loc]] = loc;
+      }
+      for (_u64 id = npts; id < new_npts; id++) {
+        loc_to_id.push_back(id);
+      }
+    }
+    auto node_offset = [&](const _u64 id) {
+      const _u64 loc = id_to_loc.empty() ? id : id_to_loc[id];
+      return SECTOR_LEN + loc / nodes_per_unit * unit_len +
+             loc % nodes_per_unit * max_node_len;
+    };
+
+    std::set<_u64> medoids = {medoid};
+    if (file_exists(medoids_file)) {
+      std::unique_ptr<_u32[]> buf = nullptr;
+      size_t                  nr, nc;
+      diskann::load_bin<_u32>(medoids_file, buf, nr, nc);
+      medoids.insert(buf.get(), buf.get() + nr);
+    }
+
+    // the pq codes of the inserted points come from the same pivots
+    FixedChunkPQTable       pq_table;
+    std::unique_ptr<_u8[]>  old_codes = nullptr;
+    size_t                  code_npts, code_size;
+    diskann::load_bin<_u8>(pq_compressed_file, old_codes, code_npts,
+                           code_size);
+    pq_table.load_pq_centroid_bin(pq_pivots_file.c_str(), code_size);
+    std::vector<_u8> codes(new_npts * code_size);
+    std::memcpy(codes.data(), old_codes.get(), npts * code_size);
+    old_codes.reset();
+    std::vector<float> insert_vecs(n_insert * dim);
+    std::vector<float> insert_norms(n_insert);
+    for (_u64 i = 0; i < n_insert; i++) {
+      to_graph_space(insert_data + i * dim, dim, metric,
+                     insert_vecs.data() + i * dim, insert_norms.data() + i);
+      pq_table.encode_vector(insert_vecs.data() + i * dim,
+                             codes.data() + (npts + i) * code_size);
+    }
+    auto get_vec = [&](const unsigned id, float *out) {
+      if (id < npts) {
+        pq_table.inflate_vector(codes.data() + (_u64) id * code_size, out);
+      } else {
+        std::memcpy(out, insert_vecs.data() + (id - npts) * dim,
+                    dim * sizeof(float));
+      }
+    };
+    // the candidates of a node sorted and pruned to R
+    auto prune = [&](const float *node_vec, std::vector<unsigned> &cands,
+                     std::vector<unsigned> &pruned) {
+      std::sort(cands.begin(), cands.end());
+      cands.erase(std::unique(cands.begin(), cands.end()), cands.end());
+      if (cands.size() <= R) {
+        pruned = cands;
+        return;
+      }
+      std::vector<float>    vecs(cands.size() * dim);
+      std::vector<Neighbor> pool;
+      pool.reserve(cands.size());
+      for (size_t i = 0; i < cands.size(); i++) {
+        get_vec(cands[i], vecs.data() + i * dim);
+        pool.emplace_back(
+            i, faiss::fvec_L2sqr(node_vec, vecs.data() + i * dim, dim), true);
+      }
+      std::sort(pool.begin(), pool.end());
+      std::vector<float> sorted_vecs(cands.size() * dim);
+      for (size_t i = 0; i < pool.size(); i++) {
+        std::memcpy(sorted_vecs.data() + i * dim,
+                    vecs.data() + pool[i].id * dim, dim * sizeof(float));
+        pool[i].id = cands[pool[i].id];
+      }
+      prune_merge_candidates(pool, sorted_vecs.data(), dim, R, config.alpha,
+                             pruned);
+    };
+
+    // the live neighbors of the deleted points replace them
+    std::unordered_map<unsigned, std::vector<unsigned>> deleted_nbrs;
+    std::unique_ptr<char[]> node_buf = std::make_unique<char[]>(max_node_len);
+    for (_u64 id = 0; id < npts; id++) {
+      if (!deleted[id]) {
+        continue;
+      }
+      disk_reader.seekg(node_offset(id));
+      disk_reader.read(node_buf.get(), max_node_len);
+      const unsigned *nhood = (unsigned *) (node_buf.get() + data_len);
+      auto           &nbrs = deleted_nbrs[id];
+      for (unsigned j = 0; j < nhood[0]; j++) {
+        if (!deleted[nhood[1 + j]]) {
+          nbrs.push_back(nhood[1 + j]);
+        }
+      }
+    }
+
+    // the inserted points get their neighbors among the live points of the
+    // index and among each other
+    std::vector<uint8_t> deleted_bits(DIV_ROUND_UP(npts, 8), 0);
+    for (_u64 id = 0; id < npts; id++) {
+      if (deleted[id]) {
+        deleted_bits[id >> 3] |= 1 << (id & 0x7);
+      }
+    }
+    const knowhere::BitsetView deleted_view(deleted_bits.data(), npts);
+    std::vector<std::vector<unsigned>>      insert_nbrs(n_insert);
+    auto thread_pool = knowhere::ThreadPool::GetGlobalBuildThreadPool();
+    std::vector<folly::Future<folly::Unit>> futures;
+    futures.reserve(n_insert);
+    for (_u64 i = 0; i < n_insert; i++) {
+      if (deleted[npts + i]) {
+        continue;
+      }
+      futures.emplace_back(thread_pool->push([&, i]() {
+        std::vector<_s64>     ids(L);
+        std::vector<float>    dists(L);
+        std::vector<unsigned> cands;
+        index.cached_beam_search(insert_data + i * dim, L, L, ids.data(),
+                                 dists.data(), 4, false, nullptr, nullptr,
+                                 deleted_view);
+        for (const _s64 id : ids) {
+          if (id >= 0 && (_u64) id < npts && !deleted[id]) {
+            cands.push_back(id);
+          }
+        }
+        for (const unsigned j : insert_graph[i]) {
+          if (j != i && j < n_insert && !deleted[npts + j]) {
+            cands.push_back(npts + j);
+          }
+        }
+        prune(insert_vecs.data() + i * dim, cands, insert_nbrs[i]);
+      }));
+    }
+    knowhere::WaitAllSuccess(futures);
+    std::unordered_map<unsigned, std::vector<unsigned>> reverse_nbrs;
+    for (_u64 i = 0; i < n_insert; i++) {
+      for (const unsigned j : insert_nbrs[i]) {
+        reverse_nbrs[j].push_back(npts + i);
+      }
+    }
+
+    // the new neighbors of a node, false if they do not change
+    auto update_nbrs = [&](const _u64 id, const float *node_vec,
+                           const unsigned *nbrs, const unsigned nnbrs,
+                           std::vector<unsigned> &updated) {
+      std::vector<unsigned> cands;
+      bool                  changed = false;
+      for (unsigned j = 0; j < nnbrs; j++) {
+        if (!deleted[nbrs[j]]) {
+          cands.push_back(nbrs[j]);
+          continue;
+        }
+        changed = true;
+        auto it = deleted_nbrs.find(nbrs[j]);
+        if (it != deleted_nbrs.end()) {
+          cands.insert(cands.end(), it->second.begin(), it->second.end());
+        }
+      }
+      auto it = reverse_nbrs.find(id);
+      if (it != reverse_nbrs.end()) {
+        changed = true;
+        cands.insert(cands.end(), it->second.begin(), it->second.end());
+      }
+      if (!changed) {
+        return false;
+      }
+      cands.erase(std::remove(cands.begin(), cands.end(), (unsigned) id),
+                  cands.end());
+      prune(node_vec, cands, updated);
+      return true;
+    };
+
+    // rewrite the nodes unit by unit, the inserted ones start where the old
+    // ones end
+    const std::string tmp_file = disk_index_file + "_merge_tmp";
+    {
+      cached_ofstream diskann_writer(tmp_file, 64 * 1024 * 1024);
+      *(_u64 *) (meta.get() + 0 * sizeof(_u64)) =
+          new_n_units * unit_len + SECTOR_LEN;
+      *(_u64 *) (meta.get() + 1 * sizeof(_u64)) = new_npts;
+      diskann_writer.write(meta.get(), SECTOR_LEN);
+
+      const _u64 units_per_block =
+          std::max<_u64>(1, 64 * 1024 * 1024 / unit_len);
+      std::unique_ptr<char[]> block =
+          std::make_unique<char[]>(units_per_block * unit_len);
+      disk_reader.seekg(SECTOR_LEN);
+      for (_u64 begin = 0; begin < new_n_units; begin += units_per_block) {
+        const _u64 end = std::min(begin + units_per_block, new_n_units);
+        memset(block.get(), 0, (end - begin) * unit_len);
+        if (begin < n_units) {
+          disk_reader.read(block.get(),
+                           (std::min(end, n_units) - begin) * unit_len);
+        }
+        futures.clear();
+        for (_u64 unit = begin; unit < end; unit++) {
+          futures.emplace_back(thread_pool->push([&, unit]() {
+            std::vector<float>    node_vec(dim);
+            std::vector<unsigned> updated;
+            for (_u64 loc = unit * nodes_per_unit;
+                 loc < (unit + 1) * nodes_per_unit && loc < new_npts; loc++) {
+              const _u64 id = loc_to_id.empty() ? loc : loc_to_id[loc];
+              char *node = block.get() + (unit - begin) * unit_len +
+                           loc % nodes_per_unit * max_node_len;
+              unsigned *nhood = (unsigned *) (node + data_len);
+              if (id >= npts) {
+                std::memcpy(node, insert_data + (id - npts) * dim, data_len);
+                const auto &nbrs = insert_nbrs[id - npts];
+                nhood[0] = nbrs.size();
+                std::copy(nbrs.begin(), nbrs.end(), nhood + 1);
+              }
+              if (deleted[id] && medoids.count(id) == 0) {
+                nhood[0] = 0;
+                continue;
+              }
+              to_graph_space((const T *) node, dim, metric, node_vec.data());
+              if (update_nbrs(id, node_vec.data(), nhood + 1, nhood[0],
+                              updated)) {
+                nhood[0] = updated.size();
+                std::copy(updated.begin(), updated.end(), nhood + 1);
+              }
+            }
+          }));
+        }
+        knowhere::WaitAllSuccess(futures);
+        diskann_writer.write(block.get(), (end - begin) * unit_len);
+      }
+    }
+    disk_reader.close();
+
+    // the other files are saved next to theirs before any is replaced
+    std::vector<std::pair<std::string, std::string>> replaced;
+    auto save_tmp = [&](const std::string &file, auto *data, const _u64 nr,
+                        const _u64 nc) {
+      diskann::save_bin(file + "_merge_tmp", data, nr, nc);
+      replaced.emplace_back(file + "_merge_tmp", file);
+    };
+    replaced.emplace_back(tmp_file, disk_index_file);
+    save_tmp(pq_compressed_file, codes.data(), new_npts, code_size);
+    if (metric == diskann::Metric::COSINE && file_exists(norm_file)) {
+      std::unique_ptr<float[]> old_norms = nullptr;
+      size_t                   nr, nc;
+      diskann::load_bin<float>(norm_file, old_norms, nr, nc);
+      std::vector<float> norms(old_norms.get(), old_norms.get() + nr);
+      norms.insert(norms.end(), insert_norms.begin(), insert_norms.end());
+      save_tmp(norm_file, norms.data(), norms.size(), 1);
+    }
+    if (!loc_to_id.empty()) {
+      save_tmp(sector_order_file, loc_to_id.data(), new_npts, 1);
+    }
+    std::vector<_u32> deleted_ids;
+    for (_u64 id = 0; id < new_npts; id++) {
+      if (deleted[id]) {
+        deleted_ids.push_back(id);
+      }
+    }
+    if (!deleted_ids.empty()) {
+      save_tmp(get_disk_index_deleted_ids_filename(disk_index_file),
+               deleted_ids.data(), deleted_ids.size(), 1);
+    }
+    for (const auto &[from, to] : replaced) {
+      if (std::rename(from.c_str(), to.c_str()) != 0) {
+        throw diskann::ANNException("Failed to replace " + to, -1,
+                                    __FUNCSIG__, __FILE__, __LINE__);
+      }
+    }
+
+    std::chrono::duration<double> diff =
+        std::chrono::high_resolution_clock::now() - s;
+    LOG_KNOWHERE_INFO_ << "Merged " << n_insert << " inserted and "
+                       << deleted_ids.size() << " deleted points into "
+                       << disk_index_file << " in " << diff.count() << "s";
+    return 0;
+  }
+
   template void create_disk_layout<int8_t>(const std::string base_file,
                                            const std::string mem_index_file,
                                            const std::string output_file,
@@ -1360,36 +2234,57 @@ namespace diskann {
   template int build_disk_index<knowhere::fp16>(const BuildConfig &config);
   template int build_disk_index<knowhere::bf16>(const BuildConfig &config);
 
+  template int merge_disk_index<float>(
+      const MergeConfig &config, PQFlashIndex<float> &index,
+      const float *insert_data,
+      const std::vector<std::vector<unsigned>> &insert_graph,
+      const std::vector<bool>                  &deleted);
+  template int merge_disk_index<knowhere::fp16>(
+      const MergeConfig &config, PQFlashIndex<knowhere::fp16> &index,
+      const knowhere::fp16                     *insert_data,
+      const std::vector<std::vector<unsigned>> &insert_graph,
+      const std::vector<bool>                  &deleted);
+  template int merge_disk_index<knowhere::bf16>(
+      const MergeConfig &config, PQFlashIndex<knowhere::bf16> &index,
+      const knowhere::bf16                     *insert_data,
+      const std::vector<std::vector<unsigned>> &insert_graph,
+      const std::vector<bool>                  &deleted);
+
   template std::unique_ptr<diskann::Index<int8_t>>
   build_merged_vamana_index<int8_t>(
       std::string base_file, bool ip_prepared, diskann::Metric compareMetric,
       unsigned L, unsigned R, bool accelerate_build, bool shuffle_build,
       double sampling_rate, double ram_budget, std::string mem_index_path,
-      std::string medoids_path, std::string centroids_file);
+      std::string medoids_path, std::string centroids_file,
+      unsigned num_parallel_shards);
   template std::unique_ptr<diskann::Index<float>>
   build_merged_vamana_index<float>(
       std::string base_file, bool ip_prepared, diskann::Metric compareMetric,
       unsigned L, unsigned R, bool accelerate_build, bool shuffle_build,
       double sampling_rate, double ram_budget, std::string mem_index_path,
-      std::string medoids_path, std::string centroids_file);
+      std::string medoids_path, std::string centroids_file,
+      unsigned num_parallel_shards);
   template std::unique_ptr<diskann::Index<uint8_t>>
   build_merged_vamana_index<uint8_t>(
       std::string base_file, bool ip_prepared, diskann::Metric compareMetric,
       unsigned L, unsigned R, bool accelerate_build, bool shuffle_build,
       double sampling_rate, double ram_budget, std::string mem_index_path,
-      std::string medoids_path, std::string centroids_file);
+      std::string medoids_path, std::string centroids_file,
+      unsigned num_parallel_shards);
   template std::unique_ptr<diskann::Index<knowhere::fp16>>
   build_merged_vamana_index<knowhere::fp16>(
       std::string base_file, bool ip_prepared, diskann::Metric compareMetric,
       unsigned L, unsigned R, bool accelerate_build, bool shuffle_build,
       double sampling_rate, double ram_budget, std::string mem_index_path,
-      std::string medoids_path, std::string centroids_file);
+      std::string medoids_path, std::string centroids_file,
+      unsigned num_parallel_shards);
   template std::unique_ptr<diskann::Index<knowhere::bf16>>
   build_merged_vamana_index<knowhere::bf16>(
       std::string base_file, bool ip_prepared, diskann::Metric compareMetric,
       unsigned L, unsigned R, bool accelerate_build, bool shuffle_build,
       double sampling_rate, double ram_budget, std::string mem_index_path,
-      std::string medoids_path, std::string centroids_file);
+      std::string medoids_path, std::string centroids_file,
+      unsigned num_parallel_shards);
 
   template void generate_cache_list_from_graph_with_pq<int8_t>(
       _u64 num_nodes_to_cache, unsigned R, const diskann::Metric compare_metric,
@@ -1733,23 +1733,57 @@ namespace diskann {
       LOG_KNOWHERE_INFO_ << "Building start. Loading only first "
                          << num_points_to_load << " from file.. ";
       _nd = num_points_to_load;
+    }
 
-      if (_enable_tags && tags.size() != num_points_to_load) {
-        std::stringstream stream;
-        stream << "ERROR: Driver requests loading " << num_points_to_load
-               << " points from file,"
-               << "but tags vector is of size " << tags.size() << "."
-               << std::endl;
-        LOG(ERROR) << stream.str();
-        aligned_free(_data);
-        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
-                                    __LINE__);
+    build_with_data_populated(parameters, tags);
+  }
+
+  template<typename T, typename TagT>
+  void Index<T, TagT>::build(const T *data, const size_t num_points,
+                             Parameters              &parameters,
+                             const std::vector<TagT> &tags) {
+    if (num_points == 0 || num_points > _max_points) {
+      std::stringstream stream;
+      stream << "ERROR: Driver requests building with " << num_points
+             << " points, but index can support only " << _max_points
+             << " points as specified in constructor." << std::endl;
+      LOG(ERROR) << stream.str();
+      throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+
+    // the padding of every row stays zero since the constructor
+    for (size_t i = 0; i < num_points; i++) {
+      memcpy(_data + i * _aligned_dim, data + i * _dim, _dim * sizeof(T));
+      if (_normalize_vecs) {
+        normalize(_data + i * _aligned_dim, _aligned_dim);
       }
-      if (_enable_tags) {
-        for (size_t i = 0; i < tags.size(); ++i) {
-          _tag_to_location[tags[i]] = (unsigned) i;
-          _location_to_tag[(unsigned) i] = tags[i];
-        }
+    }
+
+    LOG_KNOWHERE_INFO_ << "Building start with " << num_points
+                       << " points in memory";
+    _nd = num_points;
+
+    build_with_data_populated(parameters, tags);
+  }
+
+  template<typename T, typename TagT>
+  void Index<T, TagT>::build_with_data_populated(
+      Parameters &parameters, const std::vector<TagT> &tags) {
+    if (_enable_tags && tags.size() != _nd) {
+      std::stringstream stream;
+      stream << "ERROR: Driver requests loading " << _nd << " points,"
+             << "but tags vector is of size " << tags.size() << "."
+             << std::endl;
+      LOG(ERROR) << stream.str();
+      aligned_free(_data);
+      throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+    if (_enable_tags) {
+      for (size_t i = 0; i < tags.size(); ++i) {
+        _tag_to_location[tags[i]] = (unsigned) i;
+        _location_to_tag[(unsigned) i] = tags[i];
       }
     }
 
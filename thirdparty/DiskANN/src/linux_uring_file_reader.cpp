@@ -0,0 +1,101 @@
+#include "diskann/linux_uring_file_reader.h"
+
+#include <cassert>
+#include <sstream>
+#include "diskann/utils.h"
+
+namespace {
+  void submit_reads(UringContext *ring, int fd, const AlignedRead *reqs,
+                    size_t n_ops) {
+    for (size_t j = 0; j < n_ops; j++) {
+      ring->prep_read(fd, reqs[j].buf, reqs[j].len, reqs[j].offset);
+    }
+    int ret = ring->submit();
+    if (ret < 0) {
+      std::stringstream err;
+      err << "Unknown error occur in io_uring_enter, errno: " << -ret << ", "
+          << strerror(-ret);
+      throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+  }
+
+  void wait_reads(UringContext *ring, size_t n_ops) {
+    int ret = ring->wait(n_ops);
+    if (ret < 0) {
+      std::stringstream err;
+      err << "io_uring read failed, errno: " << -ret << ", " << strerror(-ret);
+      throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+  }
+}  // namespace
+
+LinuxUringFileReader::LinuxUringFileReader() {
+  this->file_desc = -1;
+  this->ctx_pool_ = UringContextPool::GetGlobalUringPool();
+  if (this->ctx_pool_ == nullptr) {
+    throw diskann::ANNException("Global UringContextPool is not initialized",
+                                -1, __FUNCSIG__, __FILE__, __LINE__);
+  }
+}
+
+LinuxUringFileReader::~LinuxUringFileReader() {
+  if (this->file_desc != -1 && ::fcntl(this->file_desc, F_GETFD) != -1) {
+    std::cerr << "close() not called" << std::endl;
+    ::close(this->file_desc);
+  }
+}
+
+void LinuxUringFileReader::open(const std::string &fname) {
+  int flags = O_DIRECT | O_RDONLY | O_LARGEFILE;
+  this->file_desc = ::open(fname.c_str(), flags);
+  // error checks
+  assert(this->file_desc != -1);
+  LOG_KNOWHERE_DEBUG_ << "Opened file : " << fname;
+}
+
+void LinuxUringFileReader::close() {
+  ::close(this->file_desc);
+  this->file_desc = -1;
+}
+
+void LinuxUringFileReader::read(std::vector<AlignedRead> &read_reqs,
+                                io_context_t &ctx, bool async) {
+  if (async == true) {
+    diskann::cout << "Async currently not supported in linux." << std::endl;
+  }
+  assert(this->file_desc != -1);
+
+  // break-up requests into chunks the ring can hold
+  const size_t maxnr = this->ctx_pool_->max_events_per_ctx();
+  for (size_t i = 0; i < read_reqs.size(); i += maxnr) {
+    const size_t n_ops = std::min(read_reqs.size() - i, maxnr);
+    submit_reads(ring(ctx), this->file_desc, read_reqs.data() + i, n_ops);
+    wait_reads(ring(ctx), n_ops);
+  }
+}
+
+void LinuxUringFileReader::submit_req(io_context_t             &ctx,
+                                      std::vector<AlignedRead> &read_reqs) {
+  const auto maxnr = this->ctx_pool_->max_events_per_ctx();
+  if (read_reqs.size() > maxnr) {
+    std::stringstream err;
+    err << "Async does not support number of read requests ("
+        << read_reqs.size() << ") exceeds max number of events per context ("
+        << maxnr << ")";
+    throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+  }
+  submit_reads(ring(ctx), this->file_desc, read_reqs.data(), read_reqs.size());
+}
+
+void LinuxUringFileReader::get_submitted_req(io_context_t &ctx, size_t n_ops) {
+  if (n_ops > this->ctx_pool_->max_events_per_ctx()) {
+    std::stringstream err;
+    err << "Async does not support getting number of read requests (" << n_ops
+        << ") exceeds max number of events per context ("
+        << this->ctx_pool_->max_events_per_ctx() << ")";
+    throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+  }
+  wait_reads(ring(ctx), n_ops);
+}
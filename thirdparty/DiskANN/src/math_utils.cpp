@@ -42,8 +42,12 @@ namespace math_utils {
   void compute_vecs_l2sq(float* vecs_l2sq, const float* data, const size_t num_points,
                          const size_t dim) {
     for (int64_t n_iter = 0; n_iter < (_s64) num_points; n_iter++) {
-      vecs_l2sq[n_iter] =
-          calc_distance(data + (n_iter * dim), data + (n_iter * dim), dim);
+      const float* vec = data + (n_iter * dim);
+      float        norm = 0;
+      for (size_t j = 0; j < dim; j++) {
+        norm += vec[j] * vec[j];
+      }
+      vecs_l2sq[n_iter] = norm;
     }
   }
 
@@ -157,17 +161,19 @@ namespace math_utils {
       ones_b[i] = 1.0;
     }
 
+    // BLAS is column major, so the row major dist_matrix = A * B^T is
+    // computed as dist_matrix^T = B * A^T
     float    one = 1, zero = 0, minus_two = -2.0f;
     FINTEGER m = num_points, n = num_centers, finteger_one = 1,
              finteger_dim = dim;
-    sgemm_(kNoTranspose, kTranspose, &m, &n, &finteger_one, &one, docs_l2sq,
-           &finteger_one, ones_a.get(), &finteger_one, &zero, dist_matrix, &n);
+    sgemm_(kTranspose, kNoTranspose, &n, &m, &finteger_one, &one, ones_a.get(),
+           &finteger_one, docs_l2sq, &finteger_one, &zero, dist_matrix, &n);
 
-    sgemm_(kNoTranspose, kTranspose, &m, &n, &finteger_one, &one, ones_b.get(),
-           &finteger_one, centers_l2sq, &finteger_one, &one, dist_matrix, &n);
+    sgemm_(kTranspose, kNoTranspose, &n, &m, &finteger_one, &one, centers_l2sq,
+           &finteger_one, ones_b.get(), &finteger_one, &one, dist_matrix, &n);
 
-    sgemm_(kNoTranspose, kTranspose, &m, &n, &finteger_dim, &minus_two, data,
-           &finteger_dim, centers, &finteger_dim, &one, dist_matrix, &n);
+    sgemm_(kTranspose, kNoTranspose, &n, &m, &finteger_dim, &minus_two,
+           centers, &finteger_dim, data, &finteger_dim, &one, dist_matrix, &n);
 
     if (k == 1) {
       for (int64_t i = 0; i < (_s64) num_points; i++) {
@@ -220,7 +226,7 @@ namespace math_utils {
 
     bool is_norm_given_for_pts = (pts_norms_squared != NULL);
 
-    auto pivs_norms_squared = std::make_unique<float>(num_centers);
+    auto pivs_norms_squared = std::make_unique<float[]>(num_centers);
     std::unique_ptr<float[]> pts_norms_squared_deleter = nullptr;
     if (!is_norm_given_for_pts) {
       pts_norms_squared_deleter = std::make_unique<float[]>(num_points);
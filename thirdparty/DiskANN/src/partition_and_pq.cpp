@@ -44,6 +44,7 @@
 #include <cassert>
 #include "diskann/memory_mapper.h"
 #include "diskann/partition_and_pq.h"
+#include "diskann/pq_table.h"
 
 // block size for reading/ processing large files and matrices in blocks
 #define BLOCK_SIZE 1000000
@@ -384,7 +385,8 @@ int generate_pq_pivots(const float *passed_train_data, size_t num_train,
 // chunk to generate the compressed data_file and stores it in
 // pq_compressed_vectors_path.
 // If the numbber of centers is < 256, it stores as byte vector, else as 4-byte
-// vector in binary format.
+// vector in binary format. With 16 centers two chunks are packed per byte and
+// the header holds the number of bytes instead of chunks.
 template<typename T>
 int generate_pq_data_from_pivots(const std::string data_file,
                                  unsigned num_centers, unsigned num_pq_chunks,
@@ -469,7 +471,9 @@ int generate_pq_data_from_pivots(const std::string data_file,
 
   std::ofstream compressed_file_writer(pq_compressed_vectors_path,
                                        std::ios::binary);
-  _u32          num_pq_chunks_u32 = num_pq_chunks;
+  const bool    pq4 = num_centers == NUM_PQ4_CENTROIDS;
+  _u32          num_pq_chunks_u32 =
+      pq4 ? DIV_ROUND_UP(num_pq_chunks, 2) : num_pq_chunks;
 
   compressed_file_writer.write((char *) &num_points, sizeof(uint32_t));
   compressed_file_writer.write((char *) &num_pq_chunks_u32, sizeof(uint32_t));
@@ -582,7 +586,21 @@ int generate_pq_data_from_pivots(const std::string data_file,
     knowhere::WaitAllSuccess(futures);
     futures.clear();
 
-    if (num_centers > 256) {
+    if (pq4) {
+      const _u64                 nbytes = num_pq_chunks_u32;
+      std::unique_ptr<uint8_t[]> pVec =
+          std::make_unique<uint8_t[]>(cur_blk_size * nbytes);
+      std::memset(pVec.get(), 0, cur_blk_size * nbytes);
+      for (size_t j = 0; j < cur_blk_size; j++) {
+        for (size_t c = 0; c < num_pq_chunks; c++) {
+          pVec[j * nbytes + c / 2] |=
+              (uint8_t) (block_compressed_base[j * num_pq_chunks + c]
+                         << (4 * (c % 2)));
+        }
+      }
+      compressed_file_writer.write((char *) (pVec.get()),
+                                   cur_blk_size * nbytes * sizeof(uint8_t));
+    } else if (num_centers > 256) {
       compressed_file_writer.write(
           (char *) (block_compressed_base.get()),
           cur_blk_size * num_pq_chunks * sizeof(uint32_t));
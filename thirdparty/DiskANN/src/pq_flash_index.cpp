@@ -20,7 +20,9 @@
 #include "diskann/aux_utils.h"
 #include "diskann/timer.h"
 #include "diskann/utils.h"
+#include "knowhere/comp/cancellation.h"
 #include "knowhere/comp/thread_pool.h"
+#include "knowhere/comp/trace_span.h"
 #include "knowhere/heap.h"
 #include "knowhere/prometheus_client.h"
 #include "knowhere/utils.h"
@@ -55,6 +57,18 @@ namespace {
   constexpr _u64  kBruteForceTopkRefineExpansionFactor = 2;
   constexpr float kFilterThreshold = 0.93f;
   constexpr float kAlpha = 0.15f;
+  // how far past the radius the PQ distance of a candidate of a range search
+  // may be, see range_search()
+  constexpr float kRangeSearchPQSlack = 0.1f;
+  // one in this many searches counts its visits for the adaptive cache
+  constexpr _u32 kAdaptiveCacheSampleRate = 8;
+  // an uncached node must have been visited this many times more often than
+  // a cached one to replace it, so that the cache does not churn
+  constexpr _u32 kAdaptiveCacheSwapRatio = 2;
+  // the list size of the search of the navigation graph, and the most of its
+  // results a search starts from
+  constexpr _u64 kNavSearchListSize = 32;
+  constexpr _u64 kNavEntryPoints = 4;
 }  // namespace
 
 namespace diskann {
@@ -215,6 +229,10 @@ namespace diskann {
   template<typename T>
   PQFlashIndex<T>::~PQFlashIndex() {
     destroy_cache_async_task();
+    {
+      std::unique_lock<std::mutex> guard(cache_refresh_mtx);
+      cache_refresh_cv.wait(guard, [this] { return !cache_refreshing; });
+    }
 
     if (centroid_data != nullptr)
       aligned_free(centroid_data);
@@ -251,6 +269,13 @@ namespace diskann {
                              256);
       diskann::alloc_aligned((void **) &scratch.aligned_dist_scratch,
                              (_u64) MAX_GRAPH_DEGREE * sizeof(float), 256);
+      if (this->pq4) {
+        diskann::alloc_aligned((void **) &scratch.aligned_pq4_lut_scratch,
+                               32 * (_u64) this->aligned_dim * sizeof(_u8),
+                               256);
+        diskann::alloc_aligned((void **) &scratch.aligned_pq4_sum_scratch,
+                               (_u64) MAX_GRAPH_DEGREE * sizeof(_u16), 256);
+      }
       diskann::alloc_aligned((void **) &scratch.aligned_query_T,
                              this->aligned_dim * sizeof(T), 8 * sizeof(T));
       diskann::alloc_aligned((void **) &scratch.aligned_query_float,
@@ -281,12 +306,162 @@ namespace diskann {
     thread_data_size +=
         ROUND_UP(256 * (_u64) this->aligned_dim * sizeof(float), 256);
     thread_data_size += ROUND_UP((_u64) MAX_GRAPH_DEGREE * sizeof(float), 256);
+    if (this->pq4) {
+      thread_data_size += ROUND_UP(32 * (_u64) this->aligned_dim, 256);
+      thread_data_size += ROUND_UP((_u64) MAX_GRAPH_DEGREE * sizeof(_u16), 256);
+    }
     thread_data_size += ROUND_UP(this->aligned_dim * sizeof(T), 8 * sizeof(T));
     thread_data_size +=
         ROUND_UP(this->aligned_dim * sizeof(float), 8 * sizeof(float));
     return thread_data_size;
   }
 
+  template<typename T>
+  void PQFlashIndex<T>::load_nav_graph(const std::string &disk_index_file) {
+    std::string ids_file = get_disk_index_nav_ids_filename(disk_index_file);
+    std::string data_file = get_disk_index_nav_data_filename(disk_index_file);
+    std::string graph_file = get_disk_index_nav_graph_filename(disk_index_file);
+    if (!file_exists(ids_file) || !file_exists(data_file) ||
+        !file_exists(graph_file)) {
+      return;
+    }
+    std::unique_ptr<_u32[]>  ids = nullptr;
+    std::unique_ptr<float[]> vecs = nullptr;
+    std::unique_ptr<_u32[]>  rows = nullptr;
+    size_t                   n_ids, ids_dim, n_vecs, vecs_dim, n_rows, width;
+    diskann::load_bin<_u32>(ids_file, ids, n_ids, ids_dim);
+    diskann::load_bin<float>(data_file, vecs, n_vecs, vecs_dim);
+    diskann::load_bin<_u32>(graph_file, rows, n_rows, width);
+    if (ids_dim != 1 || n_vecs != n_ids || vecs_dim != data_dim ||
+        n_rows != n_ids || width < 1) {
+      std::stringstream stream;
+      stream << "Error loading the navigation graph. Expected " << n_ids
+             << " points of " << data_dim << " dimensions, got " << n_vecs
+             << " vectors of " << vecs_dim << " and " << n_rows << " rows."
+             << std::endl;
+      throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+    for (size_t i = 0; i < n_ids; i++) {
+      const _u32 *row = rows.get() + i * width;
+      bool        valid = ids[i] < num_points && row[0] < width;
+      for (_u32 j = 1; valid && j <= row[0]; j++) {
+        valid = row[j] < n_ids;
+      }
+      if (!valid) {
+        throw diskann::ANNException(
+            "Error loading the navigation graph. Point " + std::to_string(i) +
+                " is out of range.",
+            -1, __FUNCSIG__, __FILE__, __LINE__);
+      }
+    }
+    nav_ids.assign(ids.get(), ids.get() + n_ids);
+    nav_data.assign(vecs.get(), vecs.get() + n_vecs * vecs_dim);
+    nav_graph.assign(rows.get(), rows.get() + n_rows * width);
+    nav_width = width - 1;
+
+    // a merge clears the neighbors of the deleted points, which are still
+    // traversed in memory but are no entry points any more
+    nav_deleted.assign(n_ids, false);
+    std::string deleted_file =
+        get_disk_index_deleted_ids_filename(disk_index_file);
+    if (file_exists(deleted_file)) {
+      std::unique_ptr<_u32[]> deleted = nullptr;
+      size_t                  n_deleted, deleted_dim;
+      diskann::load_bin<_u32>(deleted_file, deleted, n_deleted, deleted_dim);
+      tsl::robin_set<_u32> deleted_set(deleted.get(),
+                                       deleted.get() + n_deleted);
+      for (size_t i = 0; i < n_ids; i++) {
+        nav_deleted[i] = deleted_set.count(nav_ids[i]) > 0;
+      }
+    }
+    LOG_KNOWHERE_INFO_ << "Loaded the navigation graph of " << n_ids
+                       << " points";
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::search_nav_graph(const float *query_float,
+                                         const _u64   n_entries,
+                                         std::vector<unsigned> &entries) {
+    entries.clear();
+    // a greedy search as in Index::iterate_to_fixed_point(), on the full
+    // precision vectors of the sample, positions in the sample until the end
+    const _u64            l_nav = (std::max)(kNavSearchListSize, n_entries);
+    std::vector<Neighbor> retset(l_nav + 1);
+    tsl::robin_set<_u32>  visited;
+    auto nav_dist = [&](const _u32 pos) {
+      return dist_cmp_float(query_float, nav_data.data() + pos * data_dim,
+                            data_dim);
+    };
+    retset[0] = Neighbor(0, nav_dist(0), true);
+    visited.insert(0);
+    _u64 cur_list_size = 1;
+    _u64 k = 0;
+    while (k < cur_list_size) {
+      _u64 nk = cur_list_size;
+      if (retset[k].flag) {
+        retset[k].flag = false;
+        const _u32 *row = nav_graph.data() + retset[k].id * (nav_width + 1);
+        for (_u32 j = 1; j <= row[0]; j++) {
+          const _u32 nbr = row[j];
+          if (!visited.insert(nbr).second) {
+            continue;
+          }
+          const float dist = nav_dist(nbr);
+          if (cur_list_size == l_nav &&
+              dist >= retset[cur_list_size - 1].distance) {
+            continue;
+          }
+          Neighbor nn(nbr, dist, true);
+          auto     r = InsertIntoPool(retset.data(), cur_list_size, nn);
+          if (cur_list_size < l_nav) {
+            ++cur_list_size;
+          }
+          if (r < nk) {
+            nk = r;
+          }
+        }
+      }
+      k = nk <= k ? nk : k + 1;
+    }
+    for (_u64 i = 0; i < cur_list_size && entries.size() < n_entries; i++) {
+      if (!nav_deleted[retset[i].id]) {
+        entries.push_back(nav_ids[retset[i].id]);
+      }
+    }
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::populate_pq_dists(QueryScratch<T> &scratch,
+                                          const float     *query_float) {
+    pq_table.populate_chunk_distances(query_float,
+                                      scratch.aligned_pqtable_dist_scratch);
+    if (pq4) {
+      quantize_pq4_dists(scratch.aligned_pqtable_dist_scratch, n_chunks,
+                         scratch.aligned_pq4_lut_scratch, scratch.pq4_scale,
+                         scratch.pq4_bias);
+    }
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::compute_pq_dists(QueryScratch<T> &scratch,
+                                         const unsigned *ids, const _u64 n_ids,
+                                         float *dists_out) {
+    if (pq4) {
+      aggregate_pq4_coords(ids, n_ids, data.get(), pq_code_size,
+                           scratch.aligned_pq_coord_scratch);
+      pq4_dist_lookup(scratch.aligned_pq_coord_scratch, n_ids, pq_code_size,
+                      scratch.aligned_pq4_lut_scratch, scratch.pq4_scale,
+                      scratch.pq4_bias, scratch.aligned_pq4_sum_scratch,
+                      dists_out);
+    } else {
+      aggregate_coords(ids, n_ids, data.get(), n_chunks,
+                       scratch.aligned_pq_coord_scratch);
+      pq_dist_lookup(scratch.aligned_pq_coord_scratch, n_ids, n_chunks,
+                     scratch.aligned_pqtable_dist_scratch, dists_out);
+    }
+  }
+
   template<typename T>
   void PQFlashIndex<T>::destroy_thread_data() {
     LOG_KNOWHERE_DEBUG_ << "Clearing scratch";
@@ -303,6 +478,8 @@ namespace diskann {
       diskann::aligned_free((void *) scratch.aligned_pq_coord_scratch);
       diskann::aligned_free((void *) scratch.aligned_pqtable_dist_scratch);
       diskann::aligned_free((void *) scratch.aligned_dist_scratch);
+      diskann::aligned_free((void *) scratch.aligned_pq4_lut_scratch);
+      diskann::aligned_free((void *) scratch.aligned_pq4_sum_scratch);
       diskann::aligned_free((void *) scratch.aligned_query_float);
       diskann::aligned_free((void *) scratch.aligned_query_T);
 
@@ -316,8 +493,6 @@ namespace diskann {
     LOG_KNOWHERE_DEBUG_ << "Loading the cache list(" << num_cached_nodes
                         << " points) into memory...";
 
-    auto ctx = this->reader->get_ctx();
-
     if (nhood_cache_buf == nullptr) {
       nhood_cache_buf =
           std::make_unique<unsigned[]>(num_cached_nodes * (max_degree + 1));
@@ -330,35 +505,45 @@ namespace diskann {
       diskann::alloc_aligned((void **) &coord_cache_buf,
                              coord_cache_buf_len * sizeof(T), 8 * sizeof(T));
       std::fill_n(coord_cache_buf, coord_cache_buf_len, T());
+      cache_capacity = num_cached_nodes;
+    }
+
+    std::vector<std::pair<_u32, _u64>> nodes(num_cached_nodes);
+    for (_u64 node_idx = 0; node_idx < num_cached_nodes; node_idx++) {
+      nodes[node_idx] = std::make_pair(node_list[node_idx], node_idx);
     }
+    load_nodes_into_cache(nodes);
+    LOG_KNOWHERE_DEBUG_ << "done.";
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::load_nodes_into_cache(
+      const std::vector<std::pair<_u32, _u64>> &nodes) {
+    auto ctx = this->reader->get_ctx();
 
     size_t BLOCK_SIZE = 32;
-    size_t num_blocks = DIV_ROUND_UP(num_cached_nodes, BLOCK_SIZE);
+    size_t num_blocks = DIV_ROUND_UP(nodes.size(), BLOCK_SIZE);
+    char  *buf = nullptr;
+    alloc_aligned((void **) &buf, BLOCK_SIZE * read_len_for_node, SECTOR_LEN);
 
     for (_u64 block = 0; block < num_blocks; block++) {
       _u64 start_idx = block * BLOCK_SIZE;
-      _u64 end_idx = (std::min)(num_cached_nodes, (block + 1) * BLOCK_SIZE);
-      std::vector<AlignedRead>             read_reqs;
-      std::vector<std::pair<_u32, char *>> nhoods;
-      for (_u64 node_idx = start_idx; node_idx < end_idx; node_idx++) {
-        AlignedRead read;
-        char       *buf = nullptr;
-        alloc_aligned((void **) &buf, read_len_for_node, SECTOR_LEN);
-        nhoods.push_back(std::make_pair(node_list[node_idx], buf));
-        read.len = read_len_for_node;
-        read.buf = buf;
-        read.offset = get_node_sector_offset(node_list[node_idx]);
-        read_reqs.push_back(read);
+      _u64 end_idx = (std::min)(nodes.size(), (block + 1) * BLOCK_SIZE);
+      std::vector<AlignedRead> read_reqs;
+      for (_u64 i = start_idx; i < end_idx; i++) {
+        read_reqs.emplace_back(get_node_sector_offset(nodes[i].first),
+                               read_len_for_node,
+                               buf + (i - start_idx) * read_len_for_node);
       }
 
       reader->read(read_reqs, ctx);
 
-      _u64 node_idx = start_idx;
-      for (_u32 i = 0; i < read_reqs.size(); i++) {
-        auto &nhood = nhoods[i];
-        char *node_buf = get_offset_to_node(nhood.second, nhood.first);
+      for (_u64 i = start_idx; i < end_idx; i++) {
+        const auto [id, slot] = nodes[i];
+        char *node_buf = get_offset_to_node(
+            buf + (i - start_idx) * read_len_for_node, id);
         T    *node_coords = OFFSET_TO_NODE_COORDS(node_buf);
-        T    *cached_coords = coord_cache_buf + node_idx * aligned_dim;
+        T    *cached_coords = coord_cache_buf + slot * aligned_dim;
         memcpy(cached_coords, node_coords, disk_bytes_per_point);
 
         // insert node nhood into nhood_cache
@@ -368,19 +553,17 @@ namespace diskann {
         unsigned                   *nbrs = node_nhood + 1;
         std::pair<_u32, unsigned *> cnhood;
         cnhood.first = nnbrs;
-        cnhood.second = nhood_cache_buf.get() + node_idx * (max_degree + 1);
+        cnhood.second = nhood_cache_buf.get() + slot * (max_degree + 1);
         memcpy(cnhood.second, nbrs, nnbrs * sizeof(unsigned));
         {
           std::unique_lock<std::shared_mutex> lock(this->cache_mtx);
-          coord_cache.insert(std::make_pair(nhood.first, cached_coords));
-          nhood_cache.insert(std::make_pair(nhood.first, cnhood));
+          coord_cache.insert(std::make_pair(id, cached_coords));
+          nhood_cache.insert(std::make_pair(id, cnhood));
         }
-        aligned_free(nhood.second);
-        node_idx++;
       }
     }
+    aligned_free(buf);
     this->reader->put_ctx(ctx);
-    LOG_KNOWHERE_DEBUG_ << "done.";
   }
 
   template<typename T>
@@ -410,6 +593,7 @@ namespace diskann {
       diskann::alloc_aligned((void **) &coord_cache_buf,
                              coord_cache_buf_len * sizeof(T), 8 * sizeof(T));
       std::fill_n(coord_cache_buf, coord_cache_buf_len, T());
+      cache_capacity = num_nodes_to_cache;
     }
 
     async_pool.push([&, state_controller = this->state_controller, sample_bin,
@@ -712,10 +896,12 @@ namespace diskann {
     get_bin_metadata(pq_table_bin, pq_file_num_centroids, pq_file_dim);
 
     this->disk_index_file = disk_index_file;
-    if (pq_file_num_centroids != 256) {
-      LOG(ERROR) << "Error. Number of PQ centroids is not 256. Exitting.";
+    if (pq_file_num_centroids != NUM_PQ_CENTROIDS &&
+        pq_file_num_centroids != NUM_PQ4_CENTROIDS) {
+      LOG(ERROR) << "Error. Number of PQ centroids is not 256 or 16. Exitting.";
       return -1;
     }
+    this->pq4 = pq_file_num_centroids == NUM_PQ4_CENTROIDS;
 
     this->data_dim = pq_file_dim;
     // will reset later if we use PQ on disk
@@ -730,9 +916,10 @@ namespace diskann {
                            nchunks_u64);
 
     this->num_points = npts_u64;
-    this->n_chunks = nchunks_u64;
+    this->pq_code_size = nchunks_u64;
 
     pq_table.load_pq_centroid_bin(pq_table_bin.c_str(), nchunks_u64);
+    this->n_chunks = pq_table.get_num_chunks();
 
     LOG(INFO)
         << "Loaded PQ centroids and in-memory compressed vectors. #points: "
@@ -753,11 +940,29 @@ namespace diskann {
                 << disk_pq_n_chunks << " bytes per point." << std::endl;
     }
 
-    // read index metadata
-    std::ifstream index_metadata(disk_index_file, std::ios::binary);
-
-    size_t actual_index_size = get_file_size(disk_index_file);
-    size_t expected_file_size;
+    // read index metadata, through the reader if the disk index is not local
+    std::unique_ptr<std::istream> metadata_stream;
+    size_t                        actual_index_size;
+    const bool                    remote = reader->remote_file_size().has_value();
+    if (remote) {
+      reader->open(disk_index_file);
+      actual_index_size = reader->remote_file_size().value();
+      char *sector_buf = nullptr;
+      alloc_aligned((void **) &sector_buf, SECTOR_LEN, SECTOR_LEN);
+      std::vector<AlignedRead> reqs{AlignedRead(0, SECTOR_LEN, sector_buf)};
+      auto                     ctx = reader->get_ctx();
+      reader->read(reqs, ctx);
+      reader->put_ctx(ctx);
+      metadata_stream = std::make_unique<std::istringstream>(
+          std::string(sector_buf, SECTOR_LEN));
+      aligned_free(sector_buf);
+    } else {
+      actual_index_size = get_file_size(disk_index_file);
+      metadata_stream =
+          std::make_unique<std::ifstream>(disk_index_file, std::ios::binary);
+    }
+    std::istream &index_metadata = *metadata_stream;
+    size_t        expected_file_size;
     READ_U64(index_metadata, expected_file_size);
     if (actual_index_size != expected_file_size) {
       LOG(ERROR) << "File size mismatch for " << disk_index_file
@@ -825,11 +1030,33 @@ namespace diskann {
               << ", max node len (bytes): " << max_node_len
               << ", max node degree: " << max_degree;
 
-    index_metadata.close();
+    metadata_stream.reset();
+
+    std::string sector_order_file =
+        get_disk_index_sector_order_filename(std::string(disk_index_file));
+    if (!long_node && file_exists(sector_order_file)) {
+      std::unique_ptr<_u32[]> buf = nullptr;
+      size_t                  npts, dim;
+      diskann::load_bin<_u32>(sector_order_file, buf, npts, dim);
+      if (npts != num_points || dim != 1) {
+        std::stringstream stream;
+        stream << "Error loading sector order file. Expected bin format of "
+               << num_points << " times 1 vector of uint32_t." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+      }
+      loc_to_id.assign(buf.get(), buf.get() + npts);
+      id_to_loc.resize(npts);
+      for (size_t loc = 0; loc < npts; loc++) {
+        id_to_loc[loc_to_id[loc]] = loc;
+      }
+      LOG_KNOWHERE_INFO_ << "Loaded the sector order of the nodes";
+    }
 
     // open AlignedFileReader handle to index_file
-    std::string index_fname(disk_index_file);
-    reader->open(index_fname);
+    if (!remote) {
+      reader->open(disk_index_file);
+    }
     this->setup_thread_data(num_threads);
     this->max_nthreads = num_threads;
 
@@ -873,6 +1100,40 @@ namespace diskann {
       use_medoids_data_as_centroids();
     }
 
+    std::string labels_file =
+        get_disk_index_labels_filename(std::string(disk_index_file));
+    std::string label_medoids_file =
+        get_disk_index_label_medoids_filename(std::string(disk_index_file));
+    if (file_exists(labels_file) && file_exists(label_medoids_file)) {
+      std::unique_ptr<_u32[]> buf = nullptr;
+      size_t                  npts, dim;
+      diskann::load_bin<_u32>(labels_file, buf, npts, dim);
+      if (npts != num_points || dim != 1) {
+        std::stringstream stream;
+        stream << "Error loading labels file. Expected bin format of "
+               << num_points << " times 1 vector of uint32_t." << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+      }
+      labels.assign(buf.get(), buf.get() + npts);
+      diskann::load_bin<_u32>(label_medoids_file, buf, npts, dim);
+      if (dim != 2) {
+        std::stringstream stream;
+        stream << "Error loading label medoids file. Expected bin format of "
+                  "m times 2 vector of uint32_t."
+               << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+      }
+      for (size_t i = 0; i < npts; i++) {
+        label_medoids[buf[2 * i]] = buf[2 * i + 1];
+      }
+      LOG_KNOWHERE_INFO_ << "Loaded the labels of " << label_medoids.size()
+                         << " label(s)";
+    }
+
+    load_nav_graph(std::string(disk_index_file));
+
     std::string norm_file =
         get_disk_index_max_base_norm_file(std::string(disk_index_file));
 
@@ -945,10 +1206,8 @@ namespace diskann {
     const T     *query = data.scratch.aligned_query_T;
     auto         beam_width = beam_width_param * kRefineBeamWidthFactor;
     const float *query_float = data.scratch.aligned_query_float;
-    float       *pq_dists = query_scratch->aligned_pqtable_dist_scratch;
-    pq_table.populate_chunk_distances(query_float, pq_dists);
+    populate_pq_dists(*query_scratch, query_float);
     float         *dist_scratch = query_scratch->aligned_dist_scratch;
-    _u8           *pq_coord_scratch = query_scratch->aligned_pq_coord_scratch;
     constexpr _u32 pq_batch_size = MAX_GRAPH_DEGREE;
     std::vector<unsigned> pq_batch_ids;
     pq_batch_ids.reserve(pq_batch_size);
@@ -971,10 +1230,8 @@ namespace diskann {
 
       if (pq_batch_ids.size() == pq_batch_size || id == num_points - 1) {
         const size_t sz = pq_batch_ids.size();
-        aggregate_coords(pq_batch_ids.data(), sz, this->data.get(),
-                         this->n_chunks, pq_coord_scratch);
-        pq_dist_lookup(pq_coord_scratch, sz, this->n_chunks, pq_dists,
-                       dist_scratch);
+        compute_pq_dists(*query_scratch, pq_batch_ids.data(), sz,
+                         dist_scratch);
         for (size_t i = 0; i < sz; ++i) {
           pq_max_heap.Push(dist_scratch[i], pq_batch_ids[i]);
         }
@@ -1018,7 +1275,10 @@ namespace diskann {
       if (frontier_read_reqs.size() == beam_width ||
           it == nodes_in_sectors_to_visit.cend()) {
         io_timer.reset();
-        reader->read(frontier_read_reqs, ctx);  // synchronous IO linux
+        {
+          knowhere::ScopedTraceSpan io_span("diskann io");
+          reader->read(frontier_read_reqs, ctx);  // synchronous IO linux
+        }
         if (stats != nullptr) {
           stats->io_us += (double) io_timer.elapsed();
         }
@@ -1057,15 +1317,7 @@ namespace diskann {
         const auto [dis, id] = op.value();
         indices[i] = id;
         if (distances != nullptr) {
-          distances[i] = dis;
-          if (metric == diskann::Metric::INNER_PRODUCT) {
-            distances[i] = 1.0 - distances[i] / 2.0;
-            if (max_base_norm != 0) {
-              distances[i] *= (max_base_norm * query_norm);
-            }
-          } else if (metric == diskann::Metric::COSINE) {
-            distances[i] = -distances[i];
-          }
+          distances[i] = to_result_dist(dis, query_norm);
         }
       } else {
         LOG(ERROR) << "Size is incorrect";
@@ -1073,6 +1325,7 @@ namespace diskann {
     }
     if (stats != nullptr) {
       stats->total_us = (double) query_timer.elapsed();
+      stats->brute_force = true;
     }
     return;
   }
@@ -1082,10 +1335,14 @@ namespace diskann {
       const T *query1, const _u64 k_search, const _u64 l_search, _s64 *indices,
       float *distances, const _u64 beam_width, const bool use_reorder_data,
       QueryStats *stats, const knowhere::feder::diskann::FederResultUniq &feder,
-      knowhere::BitsetView bitset_view, const float filter_ratio_in) {
+      knowhere::BitsetView bitset_view, const float filter_ratio_in,
+      const _s64 filter_label) {
     if (beam_width > MAX_N_SECTOR_READS)
       throw ANNException("Beamwidth can not be higher than MAX_N_SECTOR_READS",
                          -1, __FUNCSIG__, __FILE__, __LINE__);
+    if (filter_label >= 0 && !has_labels())
+      throw ANNException("The index was built without labels", -1,
+                         __FUNCSIG__, __FILE__, __LINE__);
 
     ThreadData<T> data = this->thread_data.pop();
     while (data.scratch.sector_scratch == nullptr) {
@@ -1119,10 +1376,14 @@ namespace diskann {
             distances[i] = -1;
           }
         }
+        this->thread_data.push(data);
+        this->thread_data.push_notify_all();
+        this->reader->put_ctx(ctx);
         return;
       }
 
-      if (bv_cnt >= bitset_view.size() * filter_threshold) {
+      // the label graph already skips the points of the other labels
+      if (filter_label < 0 && bv_cnt >= bitset_view.size() * filter_threshold) {
         brute_force_beam_search(data, query_norm, k_search, indices, distances,
                                 beam_width, ctx, stats, feder, bitset_view);
         this->thread_data.push(data);
@@ -1133,7 +1394,7 @@ namespace diskann {
     }
 
     // Turn to BF is k_search is too large
-    if (k_search > 0.5 * (num_points - bv_cnt)) {
+    if (filter_label < 0 && k_search > 0.5 * (num_points - bv_cnt)) {
       brute_force_beam_search(data, query_norm, k_search, indices, distances,
                               beam_width, ctx, stats, feder, bitset_view);
       this->thread_data.push(data);
@@ -1142,65 +1403,330 @@ namespace diskann {
       return;
     }
 
-    auto         query_scratch = &(data.scratch);
-    const T     *query = data.scratch.aligned_query_T;
-    const float *query_float = data.scratch.aligned_query_float;
+    BeamSearch search(this, data, ctx, query_norm, k_search, l_search,
+                      beam_width, stats, feder, bitset_view, filter_label);
+    while (search.next_beam()) {
+      search.read_beam();
+      search.process_beam();
+    }
+    search.finish(indices, distances, use_reorder_data);
 
-    // pointers to buffers for data
-    T *data_buf = query_scratch->coord_scratch;
+    this->thread_data.push(data);
+    this->thread_data.push_notify_all();
+    this->reader->put_ctx(ctx);
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::range_search(
+      const T *query1, const float radius, const _u64 min_l_search,
+      const _u64 max_l_search, const _u64 beam_width,
+      std::vector<_s64> &indices, std::vector<float> &distances,
+      QueryStats *stats, knowhere::BitsetView bitset_view,
+      const float filter_ratio_in) {
+    if (beam_width > MAX_N_SECTOR_READS)
+      throw ANNException("Beamwidth can not be higher than MAX_N_SECTOR_READS",
+                         -1, __FUNCSIG__, __FILE__, __LINE__);
 
+    ThreadData<T> data = this->thread_data.pop();
+    while (data.scratch.sector_scratch == nullptr) {
+      this->thread_data.wait_for_push_notify();
+      data = this->thread_data.pop();
+    }
+    auto query_norm_opt = init_thread_data(data, query1);
+    if (!query_norm_opt.has_value()) {
+      // nothing is in range of a zero point, like cached_beam_search
+      this->thread_data.push(data);
+      this->thread_data.push_notify_all();
+      return;
+    }
+    float query_norm = query_norm_opt.value();
+    auto  ctx = this->reader->get_ctx();
+    auto  release = [&]() {
+      this->thread_data.push(data);
+      this->thread_data.push_notify_all();
+      this->reader->put_ctx(ctx);
+    };
+
+    const knowhere::feder::diskann::FederResultUniq no_feder = nullptr;
+    const float bound = from_result_dist(radius, query_norm);
+    size_t      bv_cnt = bitset_view.empty() ? 0 : bitset_view.count();
+    if (bv_cnt > 0 && bv_cnt == bitset_view.size()) {
+      release();
+      return;
+    }
+    const auto filter_threshold =
+        filter_ratio_in < 0 ? kFilterThreshold : filter_ratio_in;
+    if (bv_cnt > 0 && bv_cnt >= bitset_view.size() * filter_threshold) {
+      // few points are left, all of them are compared
+      const _u64          n = num_points - bv_cnt;
+      std::vector<_s64>  bf_indices(n);
+      std::vector<float> bf_distances(n);
+      brute_force_beam_search(data, query_norm, n, bf_indices.data(),
+                              bf_distances.data(), beam_width, ctx, stats,
+                              no_feder, bitset_view);
+      for (_u64 i = 0; i < n && bf_indices[i] >= 0; i++) {
+        if (from_result_dist(bf_distances[i], query_norm) > bound) {
+          break;
+        }
+        indices.push_back(bf_indices[i]);
+        distances.push_back(bf_distances[i]);
+      }
+      release();
+      return;
+    }
+
+    // PQ distances are off from the full precision ones, so the candidates
+    // are kept a bit past the bound: relatively for L2, whose scale depends on
+    // the data, and by a share of the range of the distances of the
+    // normalized vectors for IP and COSINE
+    const float pq_bound =
+        metric == diskann::Metric::L2
+            ? bound + std::abs(bound) * kRangeSearchPQSlack
+            : bound + (metric == diskann::Metric::INNER_PRODUCT ? 4.0f : 2.0f) *
+                          kRangeSearchPQSlack;
+    BeamSearch search(this, data, ctx, query_norm, 0, min_l_search, beam_width,
+                      stats, no_feder, bitset_view, -1);
+    search.set_range(pq_bound, max_l_search);
+    while (search.next_beam()) {
+      search.read_beam();
+      search.process_beam();
+    }
+    search.finish_range(bound, indices, distances);
+    release();
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::cached_beam_search_interleaved(
+      const T *queries, const _u64 nq, const _u64 query_dim,
+      const _u64 k_search, const _u64 l_search, _s64 *indices,
+      float *distances, const _u64 beam_width, const _u64 num_interleave,
+      QueryStats *stats, knowhere::BitsetView bitset_view,
+      const float filter_ratio_in, const _s64 filter_label) {
+    if (beam_width > MAX_N_SECTOR_READS)
+      throw ANNException("Beamwidth can not be higher than MAX_N_SECTOR_READS",
+                         -1, __FUNCSIG__, __FILE__, __LINE__);
+    if (filter_label >= 0 && !has_labels())
+      throw ANNException("The index was built without labels", -1,
+                         __FUNCSIG__, __FILE__, __LINE__);
+
+    // the searches that don't walk the graph are done one by one
+    const size_t bv_cnt = bitset_view.empty() ? 0 : bitset_view.count();
+    const auto   filter_threshold =
+        filter_ratio_in < 0 ? kFilterThreshold : filter_ratio_in;
+    const bool brute_force =
+        filter_label < 0 &&
+        ((!bitset_view.empty() &&
+          bv_cnt >= bitset_view.size() * filter_threshold) ||
+         k_search > 0.5 * (num_points - bv_cnt));
+    if (num_interleave <= 1 || nq <= 1 ||
+        beam_width > this->reader->max_events_per_ctx() || brute_force ||
+        (!bitset_view.empty() && bv_cnt == bitset_view.size())) {
+      for (_u64 i = 0; i < nq; i++) {
+        cached_beam_search(queries + i * query_dim, k_search, l_search,
+                           indices + i * k_search,
+                           distances == nullptr ? nullptr
+                                                : distances + i * k_search,
+                           beam_width, false,
+                           stats == nullptr ? nullptr : stats + i, nullptr,
+                           bitset_view, filter_ratio_in, filter_label);
+      }
+      return;
+    }
+#ifdef NOT_COMPILE_FOR_SWIG
+    if (!bitset_view.empty()) {
+      double ratio = ((double) bv_cnt) / bitset_view.size();
+      for (_u64 i = 0; i < nq; i++) {
+        knowhere::knowhere_diskann_bitset_ratio.Observe(ratio);
+      }
+    }
+#endif
+
+    struct Slot {
+      ThreadData<T>               data;
+      IOContext                   ctx;
+      std::unique_ptr<BeamSearch> search = nullptr;
+      _u64                        query_id = 0;
+      bool                        pending = false;
+    };
+    std::vector<Slot> slots;
+    slots.reserve(std::min(num_interleave, nq));
+    // the first thread data is waited for like in a single search
+    ThreadData<T> first = this->thread_data.pop();
+    while (first.scratch.sector_scratch == nullptr) {
+      this->thread_data.wait_for_push_notify();
+      first = this->thread_data.pop();
+    }
+    slots.push_back(Slot{first, this->reader->get_ctx()});
+    // the others are only taken if free, so that the searches never wait
+    // on each other for the resources
+    while (slots.size() < std::min(num_interleave, nq)) {
+      ThreadData<T> data = this->thread_data.pop();
+      if (data.scratch.sector_scratch == nullptr) {
+        break;
+      }
+      IOContext ctx = this->reader->try_get_ctx();
+      if (ctx == nullptr) {
+        this->thread_data.push(data);
+        break;
+      }
+      slots.push_back(Slot{data, ctx});
+    }
+
+    const knowhere::feder::diskann::FederResultUniq no_feder = nullptr;
+    _u64                                            next_query = 0;
+    // runs the search of the slot until its reads are submitted, starting the
+    // next queries as the searches finish
+    auto advance = [&](Slot &slot) {
+      while (true) {
+        if (slot.search == nullptr) {
+          if (next_query >= nq) {
+            return;
+          }
+          slot.query_id = next_query++;
+          auto query_norm_opt = init_thread_data(
+              slot.data, queries + slot.query_id * query_dim);
+          if (!query_norm_opt.has_value()) {
+            // an empty answer for a zero point, like cached_beam_search
+            continue;
+          }
+          slot.search = std::make_unique<BeamSearch>(
+              this, slot.data, slot.ctx, query_norm_opt.value(), k_search,
+              l_search, beam_width,
+              stats == nullptr ? nullptr : stats + slot.query_id, no_feder,
+              bitset_view, filter_label);
+        }
+        if (!slot.search->next_beam()) {
+          slot.search->finish(indices + slot.query_id * k_search,
+                              distances == nullptr
+                                  ? nullptr
+                                  : distances + slot.query_id * k_search,
+                              false);
+          slot.search = nullptr;
+          continue;
+        }
+        if (slot.search->has_reads()) {
+          slot.search->submit_beam();
+          slot.pending = true;
+          return;
+        }
+        slot.search->process_beam();
+      }
+    };
+
+    auto release = [&]() {
+      for (auto &slot : slots) {
+        slot.search = nullptr;
+        this->thread_data.push(slot.data);
+        this->reader->put_ctx(slot.ctx);
+      }
+      this->thread_data.push_notify_all();
+    };
+
+    try {
+      for (auto &slot : slots) {
+        advance(slot);
+      }
+      bool active = true;
+      while (active) {
+        active = false;
+        for (auto &slot : slots) {
+          if (slot.search == nullptr) {
+            continue;
+          }
+          active = true;
+          slot.pending = false;
+          slot.search->wait_beam();
+          slot.search->process_beam();
+          advance(slot);
+        }
+      }
+    } catch (...) {
+      // a context must not go back to the pool with reads in flight
+      for (auto &slot : slots) {
+        if (slot.pending && slot.search != nullptr) {
+          try {
+            slot.search->wait_beam();
+          } catch (...) {
+          }
+        }
+      }
+      release();
+      throw;
+    }
+    release();
+  }
+
+  template<typename T>
+  PQFlashIndex<T>::BeamSearch::BeamSearch(
+      PQFlashIndex<T> *index, ThreadData<T> &data, IOContext &ctx,
+      const float query_norm, const _u64 k_search, const _u64 l_search,
+      const _u64 beam_width, QueryStats *stats,
+      const knowhere::feder::diskann::FederResultUniq &feder,
+      knowhere::BitsetView bitset_view, const _s64 filter_label)
+      : index(index), data(data), ctx(ctx), query_norm(query_norm),
+        k_search(k_search), l_search(l_search), beam_width(beam_width),
+        stats(stats), feder(feder), bitset_view(bitset_view),
+        filter_label(filter_label), cache_guard(index),
+        visited(*(data.scratch.visited)) {
+    thread_local _u32 num_searches = 0;
+    sample_heat = index->adaptive_cache &&
+                  num_searches++ % kAdaptiveCacheSampleRate == 0;
+
+    query = data.scratch.aligned_query_T;
+    query_float = data.scratch.aligned_query_float;
+    // pointers to buffers for data
+    data_buf = data.scratch.coord_scratch;
     // sector scratch
-    char *sector_scratch = query_scratch->sector_scratch;
-    _u64 &sector_scratch_idx = query_scratch->sector_idx;
+    sector_scratch = data.scratch.sector_scratch;
 
-    Timer io_timer, query_timer;
-    // cleared every iteration
-    std::vector<unsigned> frontier;
     frontier.reserve(2 * beam_width);
-    std::vector<std::pair<unsigned, char *>> frontier_nhoods;
     frontier_nhoods.reserve(2 * beam_width);
-    std::vector<AlignedRead> frontier_read_reqs;
     frontier_read_reqs.reserve(2 * beam_width);
-    std::vector<std::pair<unsigned, std::pair<unsigned, unsigned *>>>
-        cached_nhoods;
     cached_nhoods.reserve(2 * beam_width);
 
     // query <-> PQ chunk centers distances
-    float *pq_dists = query_scratch->aligned_pqtable_dist_scratch;
-    pq_table.populate_chunk_distances(query_float, pq_dists);
+    index->populate_pq_dists(data.scratch, query_float);
 
     // query <-> neighbor list
-    float *dist_scratch = query_scratch->aligned_dist_scratch;
-    _u8   *pq_coord_scratch = query_scratch->aligned_pq_coord_scratch;
+    dist_scratch = data.scratch.aligned_dist_scratch;
 
-    // lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const unsigned *ids,
-                                                            const _u64 n_ids,
-                                                            float *dists_out) {
-      aggregate_coords(ids, n_ids, this->data.get(), this->n_chunks,
-                       pq_coord_scratch);
-      pq_dist_lookup(pq_coord_scratch, n_ids, this->n_chunks, pq_dists,
-                     dists_out);
-    };
-    Timer                 cpu_timer;
-    std::vector<Neighbor> retset(l_search + 1);
-    tsl::robin_set<_u64> &visited = *(query_scratch->visited);
-
-    std::vector<Neighbor> full_retset;
+    retset.resize(l_search + 1);
     full_retset.reserve(4096);
-    // auto vec_hash = knowhere::hash_vec(query_float, data_dim);
-    _u32 best_medoid = 0;
-    // for tuning, do not use cache
+    filtered_nbrs.reserve(index->max_degree);
+
+    // the closest points of the navigation graph, if any, instead of a medoid
+    if (filter_label < 0 && !index->nav_ids.empty()) {
+      std::vector<unsigned> entries;
+      index->search_nav_graph(query_float,
+                              (std::min)(kNavEntryPoints, l_search), entries);
+      compute_dists(entries.data(), entries.size(), dist_scratch);
+      for (size_t i = 0; i < entries.size(); i++) {
+        Neighbor nn(entries[i], dist_scratch[i], true);
+        InsertIntoPool(retset.data(), cur_list_size++, nn);
+        visited.insert(entries[i]);
+      }
+      if (cur_list_size > 0) {
+        return;
+      }
+    }
 
+    _u32  best_medoid = 0;
     float best_dist = (std::numeric_limits<float>::max)();
-
-    std::vector<SimpleNeighbor> medoid_dists;
-    for (_u64 cur_m = 0; cur_m < num_medoids; cur_m++) {
-      float cur_expanded_dist =
-          dist_cmp_float_wrap(query_float, centroid_data + aligned_dim * cur_m,
-                              (size_t) aligned_dim, medoids[cur_m]);
+    if (filter_label >= 0) {
+      auto it = index->label_medoids.find((_u32) filter_label);
+      if (it == index->label_medoids.end()) {
+        // no point has the label, so nothing is found
+        return;
+      }
+      best_medoid = it->second;
+    }
+    for (_u64 cur_m = 0; filter_label < 0 && cur_m < index->num_medoids;
+         cur_m++) {
+      float cur_expanded_dist = index->dist_cmp_float_wrap(
+          query_float, index->centroid_data + index->aligned_dim * cur_m,
+          (size_t) index->aligned_dim, index->medoids[cur_m]);
       if (cur_expanded_dist < best_dist) {
-        best_medoid = medoids[cur_m];
+        best_medoid = index->medoids[cur_m];
         best_dist = cur_expanded_dist;
       }
     }
@@ -1210,220 +1736,324 @@ namespace diskann {
     retset[0].flag = true;
     retset[0].distance = dist_scratch[0];
     visited.insert(best_medoid);
+    cur_list_size = 1;
+  }
 
-    unsigned cur_list_size = 1;
-
-    std::sort(retset.begin(), retset.begin() + cur_list_size);
-
-    unsigned cmps = 0;
-    unsigned hops = 0;
-    unsigned num_ios = 0;
-    unsigned k = 0;
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::compute_dists(const unsigned *ids,
+                                                  const _u64      n_ids,
+                                                  float          *dists_out) {
+    index->compute_pq_dists(data.scratch, ids, n_ids, dists_out);
+  }
 
-    float                 accumulative_alpha = 0;
-    std::vector<unsigned> filtered_nbrs;
-    filtered_nbrs.reserve(this->max_degree);
-    auto filter_nbrs = [&](_u64      nnbrs,
-                           unsigned *node_nbrs) -> std::pair<_u64, unsigned *> {
-      filtered_nbrs.clear();
+  template<typename T>
+  std::pair<_u64, unsigned *> PQFlashIndex<T>::BeamSearch::filter_nbrs(
+      _u64 nnbrs, unsigned *node_nbrs) {
+    filtered_nbrs.clear();
+    // the filter bits of all the neighbors are requested at once, so that
+    // their cache misses overlap the lookups of the visited set below
+    if (!bitset_view.empty()) {
       for (_u64 m = 0; m < nnbrs; ++m) {
-        unsigned id = node_nbrs[m];
-        if (visited.find(id) != visited.end()) {
+        bitset_view.prefetch(node_nbrs[m]);
+      }
+    }
+    for (_u64 m = 0; m < nnbrs; ++m) {
+      unsigned id = node_nbrs[m];
+      if (visited.find(id) != visited.end()) {
+        continue;
+      }
+      visited.insert(id);
+      if (filter_label >= 0 && index->labels[id] != (_u32) filter_label) {
+        continue;
+      }
+      if (!bitset_view.empty() && bitset_view.test(id)) {
+        accumulative_alpha += kAlpha;
+        if (accumulative_alpha < 1.0f) {
           continue;
         }
-        visited.insert(id);
-        if (!bitset_view.empty() && bitset_view.test(id)) {
-          accumulative_alpha += kAlpha;
-          if (accumulative_alpha < 1.0f) {
-            continue;
-          }
-          accumulative_alpha -= 1.0f;
-        }
-        cmps++;
-        filtered_nbrs.push_back(id);
+        accumulative_alpha -= 1.0f;
       }
-      return {filtered_nbrs.size(), filtered_nbrs.data()};
-    };
+      cmps++;
+      filtered_nbrs.push_back(id);
+    }
+    return {filtered_nbrs.size(), filtered_nbrs.data()};
+  }
 
-    while (k < cur_list_size) {
-      auto nk = cur_list_size;
-      // clear iteration state
-      frontier.clear();
-      frontier_nhoods.clear();
-      frontier_read_reqs.clear();
-      cached_nhoods.clear();
-      sector_scratch_idx = 0;
-      // find new beam
-      _u32 marker = k;
-      _u32 num_seen = 0;
-      while (marker < cur_list_size && frontier.size() < beam_width &&
-             num_seen < beam_width) {
-        if (retset[marker].flag) {
-          num_seen++;
-          {
-            std::shared_lock<std::shared_mutex> lock(this->cache_mtx);
-            auto iter = nhood_cache.find(retset[marker].id);
-            if (iter != nhood_cache.end()) {
-              cached_nhoods.push_back(
-                  std::make_pair(retset[marker].id, iter->second));
-              if (stats != nullptr) {
-                stats->n_cache_hits++;
-              }
-            } else {
-              frontier.push_back(retset[marker].id);
-            }
-          }
-          retset[marker].flag = false;
-          {
-            std::shared_lock<std::shared_mutex> lock(
-                this->node_visit_counter_mtx);
-            if (this->count_visited_nodes) {
-              this->node_visit_counter[retset[marker].id].second->fetch_add(1);
+  template<typename T>
+  bool PQFlashIndex<T>::BeamSearch::next_beam() {
+    // a cancelled search finishes with the candidates found so far
+    if (k >= cur_list_size ||
+        knowhere::CancellationToken::CurrentIsCancelled()) {
+      return false;
+    }
+    // clear iteration state
+    frontier.clear();
+    frontier_nhoods.clear();
+    frontier_read_reqs.clear();
+    cached_nhoods.clear();
+    data.scratch.sector_idx = 0;
+    // find new beam
+    _u32 marker = k;
+    _u32 num_seen = 0;
+    while (marker < cur_list_size && frontier.size() < beam_width &&
+           num_seen < beam_width) {
+      if (retset[marker].flag) {
+        num_seen++;
+        {
+          std::shared_lock<std::shared_mutex> lock(index->cache_mtx);
+          auto iter = index->nhood_cache.find(retset[marker].id);
+          if (iter != index->nhood_cache.end()) {
+            cached_nhoods.push_back(
+                std::make_pair(retset[marker].id, iter->second));
+            if (stats != nullptr) {
+              stats->n_cache_hits++;
             }
-          }
-          if (!bitset_view.empty() && bitset_view.test(retset[marker].id)) {
-            std::memmove(&retset[marker], &retset[marker + 1],
-                         (cur_list_size - marker - 1) * sizeof(Neighbor));
-            cur_list_size--;
           } else {
-            marker++;
+            frontier.push_back(retset[marker].id);
+          }
+        }
+        retset[marker].flag = false;
+        {
+          std::shared_lock<std::shared_mutex> lock(
+              index->node_visit_counter_mtx);
+          if (index->count_visited_nodes) {
+            index->node_visit_counter[retset[marker].id].second->fetch_add(1);
           }
+        }
+        if (sample_heat) {
+          index->add_node_heat(retset[marker].id);
+        }
+        if (!bitset_view.empty() && bitset_view.test(retset[marker].id)) {
+          std::memmove(&retset[marker], &retset[marker + 1],
+                       (cur_list_size - marker - 1) * sizeof(Neighbor));
+          cur_list_size--;
         } else {
           marker++;
         }
+      } else {
+        marker++;
       }
+    }
 
-      // read nhoods of frontier ids
-      if (!frontier.empty()) {
-        if (stats != nullptr)
-          stats->n_hops++;
-        for (_u64 i = 0; i < frontier.size(); i++) {
-          auto                    id = frontier[i];
-          std::pair<_u32, char *> fnhood;
-          fnhood.first = id;
-          fnhood.second =
-              sector_scratch + sector_scratch_idx * read_len_for_node;
-          sector_scratch_idx++;
+    // read nhoods of frontier ids
+    if (!frontier.empty()) {
+      if (stats != nullptr)
+        stats->n_hops++;
+      _u64 &sector_scratch_idx = data.scratch.sector_idx;
+      for (_u64 i = 0; i < frontier.size(); i++) {
+        auto                    id = frontier[i];
+        _u64                    offset = index->get_node_sector_offset(id);
+        std::pair<_u32, char *> fnhood;
+        fnhood.first = id;
+        // nodes of the beam that share a sector share its read
+        auto same_sector = std::find_if(
+            frontier_read_reqs.begin(), frontier_read_reqs.end(),
+            [offset](const AlignedRead &req) { return req.offset == offset; });
+        if (same_sector != frontier_read_reqs.end()) {
+          fnhood.second = (char *) same_sector->buf;
           frontier_nhoods.push_back(fnhood);
-          frontier_read_reqs.emplace_back(get_node_sector_offset(((size_t) id)),
-                                          read_len_for_node, fnhood.second);
-          if (stats != nullptr) {
-            stats->n_4k++;
-            stats->n_ios++;
-          }
-          num_ios++;
+          continue;
         }
-        io_timer.reset();
-        reader->read(frontier_read_reqs, ctx);  // synchronous IO linux
+        fnhood.second =
+            sector_scratch + sector_scratch_idx * index->read_len_for_node;
+        sector_scratch_idx++;
+        frontier_nhoods.push_back(fnhood);
+        frontier_read_reqs.emplace_back(offset, index->read_len_for_node,
+                                        fnhood.second);
         if (stats != nullptr) {
-          stats->io_us += (double) io_timer.elapsed();
+          stats->n_4k++;
+          stats->n_ios++;
         }
+        num_ios++;
       }
+    }
+    return true;
+  }
 
-      auto process_node = [&](T *node_fp_coords_copy, auto node_id, auto n_nbr,
-                              auto *nbrs) {
-        if (bitset_view.empty() || !bitset_view.test(node_id)) {
-          float cur_expanded_dist;
-          if (!use_disk_index_pq) {
-            cur_expanded_dist = dist_cmp_wrap(query, node_fp_coords_copy,
-                                              (size_t) aligned_dim, node_id);
-          } else {
-            if (metric == diskann::Metric::INNER_PRODUCT ||
-                metric == diskann::Metric::COSINE)
-              cur_expanded_dist = disk_pq_table.inner_product(
-                  query_float, (_u8 *) node_fp_coords_copy);
-            else
-              cur_expanded_dist = disk_pq_table.l2_distance(
-                  query_float, (_u8 *) node_fp_coords_copy);
-          }
-          full_retset.push_back(
-              Neighbor((unsigned) node_id, cur_expanded_dist, true));
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::read_beam() {
+    if (frontier_read_reqs.empty()) {
+      return;
+    }
+    io_timer.reset();
+    knowhere::ScopedTraceSpan io_span("diskann io");
+    index->reader->read(frontier_read_reqs, ctx);  // synchronous IO linux
+    if (stats != nullptr) {
+      stats->io_us += (double) io_timer.elapsed();
+    }
+  }
 
-          // add top candidate info into feder result
-          if (feder != nullptr) {
-            feder->visit_info_.AddTopCandidateInfo(node_id, cur_expanded_dist);
-            feder->id_set_.insert(node_id);
-          }
-        }
-        auto [nnbrs, node_nbrs] = filter_nbrs(n_nbr, nbrs);
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::submit_beam() {
+    io_timer.reset();
+    index->reader->submit_req(ctx, frontier_read_reqs);
+  }
 
-        // compute node_nbrs <-> query dists in PQ space
-        cpu_timer.reset();
-        compute_dists(node_nbrs, nnbrs, dist_scratch);
-        if (stats != nullptr) {
-          stats->n_cmps += (double) nnbrs;
-          stats->cpu_us += (double) cpu_timer.elapsed();
-        }
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::wait_beam() {
+    knowhere::ScopedTraceSpan io_span("diskann io wait");
+    index->reader->get_submitted_req(ctx, frontier_read_reqs.size());
+    if (stats != nullptr) {
+      stats->io_us += (double) io_timer.elapsed();
+    }
+  }
 
-        cpu_timer.reset();
-        // process prefetched nhood
-        for (_u64 m = 0; m < nnbrs; ++m) {
-          unsigned id = node_nbrs[m];
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::process_node(T *node_fp_coords_copy,
+                                                 unsigned  node_id,
+                                                 unsigned  n_nbr,
+                                                 unsigned *nbrs) {
+    if (bitset_view.empty() || !bitset_view.test(node_id)) {
+      float cur_expanded_dist;
+      if (!index->use_disk_index_pq) {
+        cur_expanded_dist =
+            index->dist_cmp_wrap(query, node_fp_coords_copy,
+                                 (size_t) index->aligned_dim, node_id);
+      } else {
+        if (index->metric == diskann::Metric::INNER_PRODUCT ||
+            index->metric == diskann::Metric::COSINE)
+          cur_expanded_dist = index->disk_pq_table.inner_product(
+              query_float, (_u8 *) node_fp_coords_copy);
+        else
+          cur_expanded_dist = index->disk_pq_table.l2_distance(
+              query_float, (_u8 *) node_fp_coords_copy);
+      }
+      full_retset.push_back(
+          Neighbor((unsigned) node_id, cur_expanded_dist, true));
 
-          // add neighbor info into feder result
-          if (feder != nullptr) {
-            feder->visit_info_.AddTopCandidateNeighbor(node_id, id,
-                                                       dist_scratch[m]);
-            feder->id_set_.insert(id);
-          }
+      // add top candidate info into feder result
+      if (feder != nullptr) {
+        feder->visit_info_.AddTopCandidateInfo(node_id, cur_expanded_dist);
+        feder->id_set_.insert(node_id);
+      }
+    }
+    auto [nnbrs, node_nbrs] = filter_nbrs(n_nbr, nbrs);
 
-          float dist = dist_scratch[m];
-          if (stats != nullptr) {
-            stats->n_cmps++;
-          }
-          if (cur_list_size > 0 && dist >= retset[cur_list_size - 1].distance &&
-              (cur_list_size == l_search))
-            continue;
-          Neighbor nn(id, dist, true);
-          // Return position in sorted list where nn inserted.
-          auto r = InsertIntoPool(retset.data(), cur_list_size, nn);
-          if (cur_list_size < l_search)
-            ++cur_list_size;
-          if (r < nk)
-            // nk logs the best position in the retset that was
-            // updated due to neighbors of n.
-            nk = r;
-        }
-        if (stats != nullptr) {
-          stats->cpu_us += (double) cpu_timer.elapsed();
-        }
-      };
+    // compute node_nbrs <-> query dists in PQ space
+    cpu_timer.reset();
+    compute_dists(node_nbrs, nnbrs, dist_scratch);
+    if (stats != nullptr) {
+      stats->n_cmps += (double) nnbrs;
+      stats->cpu_us += (double) cpu_timer.elapsed();
+    }
 
-      // process cached nhoods
-      for (auto &cached_nhood : cached_nhoods) {
-        if (stats != nullptr) {
-          stats->n_hops++;
-        }
-        T *node_fp_coords_copy;
-        {
-          std::shared_lock<std::shared_mutex> lock(this->cache_mtx);
-          auto global_cache_iter = coord_cache.find(cached_nhood.first);
-          node_fp_coords_copy = global_cache_iter->second;
-        }
-        process_node(node_fp_coords_copy, cached_nhood.first,
-                     cached_nhood.second.first, cached_nhood.second.second);
+    cpu_timer.reset();
+    // process prefetched nhood
+    for (_u64 m = 0; m < nnbrs; ++m) {
+      unsigned id = node_nbrs[m];
+
+      // add neighbor info into feder result
+      if (feder != nullptr) {
+        feder->visit_info_.AddTopCandidateNeighbor(node_id, id,
+                                                   dist_scratch[m]);
+        feder->id_set_.insert(id);
       }
 
-      for (auto &frontier_nhood : frontier_nhoods) {
-        char *node_disk_buf =
-            get_offset_to_node(frontier_nhood.second, frontier_nhood.first);
-        unsigned *node_buf = OFFSET_TO_NODE_NHOOD(node_disk_buf);
-        T        *node_fp_coords = OFFSET_TO_NODE_COORDS(node_disk_buf);
-        T        *node_fp_coords_copy = data_buf;
-        memcpy(node_fp_coords_copy, node_fp_coords, disk_bytes_per_point);
-        process_node(node_fp_coords_copy, frontier_nhood.first, *node_buf,
-                     node_buf + 1);
+      float dist = dist_scratch[m];
+      if (stats != nullptr) {
+        stats->n_cmps++;
+      }
+      if (range && !admit_range_candidate(dist))
+        continue;
+      if (cur_list_size > 0 && dist >= retset[cur_list_size - 1].distance &&
+          (cur_list_size == l_search))
+        continue;
+      Neighbor nn(id, dist, true);
+      // Return position in sorted list where nn inserted.
+      auto r = InsertIntoPool(retset.data(), cur_list_size, nn);
+      if (cur_list_size < l_search)
+        ++cur_list_size;
+      if (r < nk)
+        // nk logs the best position in the retset that was
+        // updated due to neighbors of n.
+        nk = r;
+    }
+    if (stats != nullptr) {
+      stats->cpu_us += (double) cpu_timer.elapsed();
+    }
+  }
+
+  // With the nodes packed by the graph, the sector of a node mostly holds its
+  // neighbors, which process_node() just put into retset. They are expanded
+  // from the sector at hand instead of being read again in a later beam.
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::process_colocated(char    *sector_buf,
+                                                      unsigned node_id) {
+    // for the macros
+    const _u64 disk_bytes_per_point = index->disk_bytes_per_point;
+    const _u64 nnodes_per_sector = index->nnodes_per_sector;
+    const _u64 first_loc =
+        index->id_to_loc[node_id] / nnodes_per_sector * nnodes_per_sector;
+    for (_u64 loc = first_loc;
+         loc < first_loc + nnodes_per_sector && loc < index->num_points;
+         loc++) {
+      unsigned id = index->loc_to_id[loc];
+      unsigned pos = 0;
+      while (pos < cur_list_size && retset[pos].id != id) {
+        pos++;
+      }
+      if (pos == cur_list_size || !retset[pos].flag) {
+        continue;
+      }
+      if (!bitset_view.empty() && bitset_view.test(id)) {
+        std::memmove(&retset[pos], &retset[pos + 1],
+                     (cur_list_size - pos - 1) * sizeof(Neighbor));
+        cur_list_size--;
+      } else {
+        retset[pos].flag = false;
       }
+      char *node_disk_buf =
+          sector_buf + (loc % nnodes_per_sector) * index->max_node_len;
+      unsigned *node_buf = OFFSET_TO_NODE_NHOOD(node_disk_buf);
+      memcpy(data_buf, OFFSET_TO_NODE_COORDS(node_disk_buf),
+             disk_bytes_per_point);
+      process_node(data_buf, id, *node_buf, node_buf + 1);
+    }
+  }
 
-      // update best inserted position
-      if (nk <= k)
-        k = nk;  // k is the best position in retset updated in this round.
-      else
-        ++k;
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::process_beam() {
+    // for the macros
+    const _u64 disk_bytes_per_point = index->disk_bytes_per_point;
+    nk = cur_list_size;
 
-      hops++;
+    // process cached nhoods
+    for (auto &cached_nhood : cached_nhoods) {
+      if (stats != nullptr) {
+        stats->n_hops++;
+      }
+      T *node_fp_coords_copy =
+          index->get_cached_coords(cached_nhood.second.second);
+      process_node(node_fp_coords_copy, cached_nhood.first,
+                   cached_nhood.second.first, cached_nhood.second.second);
+    }
+
+    for (auto &frontier_nhood : frontier_nhoods) {
+      char *node_disk_buf = index->get_offset_to_node(frontier_nhood.second,
+                                                      frontier_nhood.first);
+      unsigned *node_buf = OFFSET_TO_NODE_NHOOD(node_disk_buf);
+      T        *node_fp_coords = OFFSET_TO_NODE_COORDS(node_disk_buf);
+      T        *node_fp_coords_copy = data_buf;
+      memcpy(node_fp_coords_copy, node_fp_coords, disk_bytes_per_point);
+      process_node(node_fp_coords_copy, frontier_nhood.first, *node_buf,
+                   node_buf + 1);
+      if (!index->loc_to_id.empty()) {
+        process_colocated(frontier_nhood.second, frontier_nhood.first);
+      }
     }
 
+    // update best inserted position
+    if (nk <= k)
+      k = nk;  // k is the best position in retset updated in this round.
+    else
+      ++k;
+
+    hops++;
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::finish(_s64 *indices, float *distances,
+                                           const bool use_reorder_data) {
     // re-sort by distance
     std::sort(full_retset.begin(), full_retset.end(),
               [](const Neighbor &left, const Neighbor &right) {
@@ -1431,13 +2061,18 @@ namespace diskann {
               });
 
     if (use_reorder_data) {
-      if (!(this->reorder_data_exists)) {
+      if (!(index->reorder_data_exists)) {
         throw ANNException(
             "Requested use of reordering data which does not exist in index "
             "file",
             -1, __FUNCSIG__, __FILE__, __LINE__);
       }
 
+      // for the macros
+      const _u64 nvecs_per_sector = index->nvecs_per_sector;
+      const _u64 reorder_data_start_sector = index->reorder_data_start_sector;
+      const _u64 data_dim = index->data_dim;
+
       std::vector<AlignedRead> vec_read_reqs;
 
       if (full_retset.size() > k_search * FULL_PRECISION_REORDER_MULTIPLIER)
@@ -1457,7 +2092,7 @@ namespace diskann {
       }
 
       io_timer.reset();
-      reader->read(vec_read_reqs, ctx);  // synchronous IO linux
+      index->reader->read(vec_read_reqs, ctx);  // synchronous IO linux
       if (stats != nullptr) {
         stats->io_us += io_timer.elapsed();
       }
@@ -1467,7 +2102,7 @@ namespace diskann {
         auto location =
             (sector_scratch + i * SECTOR_LEN) + VECTOR_SECTOR_OFFSET(id);
         full_retset[i].distance =
-            dist_cmp_wrap(query, (T *) location, this->data_dim, id);
+            index->dist_cmp_wrap(query, (T *) location, data_dim, id);
       }
 
       std::sort(full_retset.begin(), full_retset.end(),
@@ -1486,31 +2121,98 @@ namespace diskann {
       }
       indices[i] = full_retset[i].id;
       if (distances != nullptr) {
-        distances[i] = full_retset[i].distance;
-        if (metric == diskann::Metric::INNER_PRODUCT) {
-          // convert l2 distance to ip distance
-          distances[i] = 1.0 - distances[i] / 2.0;
-          // rescale to revert back to original norms (cancelling the effect of
-          // base and query pre-processing)
-          if (max_base_norm != 0)
-            distances[i] *= (max_base_norm * query_norm);
-        } else if (metric == diskann::Metric::COSINE) {
-          distances[i] = -distances[i];
-        }
+        distances[i] =
+            index->to_result_dist(full_retset[i].distance, query_norm);
       }
     }
+    record_finish();
+  }
 
-    this->thread_data.push(data);
-    this->thread_data.push_notify_all();
-    this->reader->put_ctx(ctx);
-    // std::cout << num_ios << " " <<stats << std::endl;
-
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::record_finish() {
     if (stats != nullptr) {
       stats->total_us = (double) query_timer.elapsed();
     }
-    if (this->count_visited_nodes) {
-      this->search_counter.fetch_add(1);
+    if (index->count_visited_nodes) {
+      index->search_counter.fetch_add(1);
+    }
+    if (sample_heat && (index->sampled_searches.fetch_add(1) + 1) %
+                               index->adaptive_cache_refresh_interval ==
+                           0) {
+      index->schedule_adaptive_cache_refresh();
+    }
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::set_range(const float pq_bound,
+                                              const _u64  max_l) {
+    range = true;
+    range_pq_bound = pq_bound;
+    min_l_search = l_search;
+    max_l_search = std::max(l_search, max_l);
+  }
+
+  // The first min_l_search candidates lead the search towards the query as in
+  // a top-k search, whatever their distances. Past them the list only takes
+  // the candidates that may be within the radius, and doubles while its last
+  // one still may be, so that none of them is dropped for the list being full.
+  template<typename T>
+  bool PQFlashIndex<T>::BeamSearch::admit_range_candidate(const float dist) {
+    if (dist > range_pq_bound && cur_list_size >= min_l_search &&
+        dist >= retset[min_l_search - 1].distance) {
+      return false;
+    }
+    if (cur_list_size == l_search && l_search < max_l_search &&
+        retset[cur_list_size - 1].distance <= range_pq_bound) {
+      l_search = std::min(l_search * 2, max_l_search);
+      retset.resize(l_search + 1);
+    }
+    return true;
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::BeamSearch::finish_range(const float         bound,
+                                                 std::vector<_s64>  &indices,
+                                                 std::vector<float> &distances) {
+    std::sort(full_retset.begin(), full_retset.end(),
+              [](const Neighbor &left, const Neighbor &right) {
+                return left.distance < right.distance;
+              });
+    for (const auto &nbr : full_retset) {
+      if (nbr.distance > bound) {
+        break;
+      }
+      indices.push_back(nbr.id);
+      distances.push_back(index->to_result_dist(nbr.distance, query_norm));
     }
+    record_finish();
+  }
+
+  template<typename T>
+  float PQFlashIndex<T>::to_result_dist(const float dist,
+                                        const float query_norm) const {
+    if (metric == diskann::Metric::INNER_PRODUCT) {
+      // convert l2 distance to ip distance, and rescale to revert back to
+      // original norms (cancelling the effect of base and query
+      // pre-processing)
+      float ip = 1.0 - dist / 2.0;
+      return max_base_norm != 0 ? ip * max_base_norm * query_norm : ip;
+    } else if (metric == diskann::Metric::COSINE) {
+      return -dist;
+    }
+    return dist;
+  }
+
+  template<typename T>
+  float PQFlashIndex<T>::from_result_dist(const float dist,
+                                          const float query_norm) const {
+    if (metric == diskann::Metric::INNER_PRODUCT) {
+      float ip = max_base_norm != 0 ? dist / (max_base_norm * query_norm) : dist;
+      return 2.0 * (1.0 - ip);
+    } else if (metric == diskann::Metric::COSINE) {
+      return -dist;
+    }
+    return dist;
   }
 
   template<typename T>
@@ -1565,7 +2267,7 @@ namespace diskann {
     }
 
     const size_t batch_size =
-        std::min(AioContextPool::GetGlobalAioPool()->max_events_per_ctx(),
+        std::min(this->reader->max_events_per_ctx(),
                  std::min(MAX_N_SECTOR_READS / 2UL, sectors_to_visit.size()));
     const size_t half_buf_idx = MAX_N_SECTOR_READS / 2 * read_len_for_node;
     char        *sector_scratch = data.scratch.sector_scratch;
@@ -1671,7 +2373,8 @@ namespace diskann {
       data = this->thread_data.pop();
     }
     data.scratch.reset();
-    auto ctx = this->reader->get_ctx();
+    auto           ctx = this->reader->get_ctx();
+    CacheReadGuard cache_guard(this);
 
     // todo: switch to quant-bf
 
@@ -1680,21 +2383,15 @@ namespace diskann {
     _u64 &sector_scratch_idx = data.scratch.sector_idx;
 
     // query <-> PQ chunk centers distances
-    float *pq_dists = data.scratch.aligned_pqtable_dist_scratch;
-    pq_table.populate_chunk_distances(workspace->aligned_query_float, pq_dists);
+    populate_pq_dists(data.scratch, workspace->aligned_query_float);
 
     // query <-> neighbor list
     float *dist_scratch = data.scratch.aligned_dist_scratch;
-    _u8   *pq_coord_scratch = data.scratch.aligned_pq_coord_scratch;
 
     // lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const unsigned *ids,
-                                                            const _u64 n_ids,
-                                                            float *dists_out) {
-      aggregate_coords(ids, n_ids, this->data.get(), this->n_chunks,
-                       pq_coord_scratch);
-      pq_dist_lookup(pq_coord_scratch, n_ids, this->n_chunks, pq_dists,
-                     dists_out);
+    auto compute_dists = [this, &data](const unsigned *ids, const _u64 n_ids,
+                                       float *dists_out) {
+      compute_pq_dists(data.scratch, ids, n_ids, dists_out);
     };
 
     if (!workspace->initialized) {
@@ -1839,12 +2536,8 @@ namespace diskann {
 
         // process cached nhoods
         for (auto &cached_nhood : workspace->cached_nhoods) {
-          T *node_fp_coords_copy;
-          {
-            std::shared_lock<std::shared_mutex> lock(this->cache_mtx);
-            auto global_cache_iter = coord_cache.find(cached_nhood.first);
-            node_fp_coords_copy = global_cache_iter->second;
-          }
+          T *node_fp_coords_copy =
+              get_cached_coords(cached_nhood.second.second);
           process_node(node_fp_coords_copy, cached_nhood.first,
                        cached_nhood.second.first, cached_nhood.second.second);
         }
@@ -1886,6 +2579,148 @@ namespace diskann {
         beam_width, filter_ratio, this->max_base_norm, bitset);
   }
 
+  template<typename T>
+  PQFlashIndex<T>::CacheReadGuard::CacheReadGuard(PQFlashIndex<T> *index)
+      : index_(index->adaptive_cache ? index : nullptr) {
+    if (index_ == nullptr) {
+      return;
+    }
+    while (true) {
+      const _u64 epoch = index_->cache_epoch.load();
+      index_->cache_readers[epoch % 2].fetch_add(1);
+      if (index_->cache_epoch.load() == epoch) {
+        slot_ = epoch % 2;
+        return;
+      }
+      index_->cache_readers[epoch % 2].fetch_sub(1);
+    }
+  }
+
+  template<typename T>
+  PQFlashIndex<T>::CacheReadGuard::~CacheReadGuard() {
+    if (index_ != nullptr) {
+      index_->cache_readers[slot_].fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::wait_for_cache_readers() {
+    // the readers of the epoch before are gone since the last wait
+    const _u64 epoch = cache_epoch.load();
+    cache_epoch.store(epoch + 1);
+    while (cache_readers[epoch % 2].load() != 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::enable_adaptive_cache(_u64 refresh_interval) {
+    if (cache_capacity == 0 || refresh_interval == 0) {
+      LOG(WARNING) << "No cache to adapt, adaptive cache is not enabled";
+      return;
+    }
+    node_heat = std::make_unique<std::atomic<_u8>[]>(num_points);
+    adaptive_cache_refresh_interval = refresh_interval;
+    adaptive_cache = true;
+  }
+
+  template<typename T>
+  void PQFlashIndex<T>::schedule_adaptive_cache_refresh() {
+    {
+      std::scoped_lock<std::mutex> guard(cache_refresh_mtx);
+      if (cache_refreshing) {
+        return;
+      }
+      cache_refreshing = true;
+    }
+    // on the cache making thread, so it never runs with the cache generation
+    async_pool.push([this]() {
+      try {
+        auto num_swapped = refresh_adaptive_cache();
+        LOG_KNOWHERE_DEBUG_ << "Adaptive cache swapped " << num_swapped
+                            << " nodes";
+      } catch (std::exception &e) {
+        LOG(WARNING) << "Can't refresh DiskANN adaptive cache: " << e.what();
+      }
+      std::scoped_lock<std::mutex> guard(cache_refresh_mtx);
+      cache_refreshing = false;
+      cache_refresh_cv.notify_all();
+    });
+  }
+
+  template<typename T>
+  _u64 PQFlashIndex<T>::refresh_adaptive_cache() {
+    if (!adaptive_cache) {
+      return 0;
+    }
+    // <heat, id> of the cached nodes from the coldest, the slots nothing is
+    // cached in and the uncached nodes visited since
+    std::vector<std::pair<_u8, _u32>> cold, hot;
+    std::vector<_u64>                 free_slots;
+    {
+      std::shared_lock<std::shared_mutex> lock(this->cache_mtx);
+      std::vector<bool> used(cache_capacity, false);
+      cold.reserve(nhood_cache.size());
+      for (const auto &[id, nhood] : nhood_cache) {
+        cold.emplace_back(node_heat[id].load(std::memory_order_relaxed), id);
+        used[(nhood.second - nhood_cache_buf.get()) / (max_degree + 1)] = true;
+      }
+      for (_u64 slot = 0; slot < cache_capacity; slot++) {
+        if (!used[slot]) {
+          free_slots.push_back(slot);
+        }
+      }
+      for (_u64 id = 0; id < num_points; id++) {
+        auto heat = node_heat[id].load(std::memory_order_relaxed);
+        if (heat > 0 && nhood_cache.find(id) == nhood_cache.end()) {
+          hot.emplace_back(heat, id);
+        }
+      }
+    }
+    std::sort(cold.begin(), cold.end());
+    const size_t max_hot = std::min(hot.size(), free_slots.size() + cold.size());
+    std::partial_sort(hot.begin(), hot.begin() + max_hot, hot.end(),
+                      std::greater<>());
+
+    std::vector<std::pair<_u32, _u64>> nodes;
+    std::vector<_u32>                  evicted;
+    for (size_t i = 0; i < max_hot; i++) {
+      if (!free_slots.empty()) {
+        nodes.emplace_back(hot[i].second, free_slots.back());
+        free_slots.pop_back();
+        continue;
+      }
+      const auto victim = cold[evicted.size()];
+      if (hot[i].first <= kAdaptiveCacheSwapRatio * victim.first) {
+        break;
+      }
+      evicted.push_back(victim.second);
+      nodes.emplace_back(hot[i].second, 0);
+    }
+    if (!evicted.empty()) {
+      std::unique_lock<std::shared_mutex> lock(this->cache_mtx);
+      for (size_t i = 0; i < evicted.size(); i++) {
+        auto iter = nhood_cache.find(evicted[i]);
+        nodes[nodes.size() - evicted.size() + i].second =
+            (iter->second.second - nhood_cache_buf.get()) / (max_degree + 1);
+        nhood_cache.erase(iter);
+        coord_cache.erase(evicted[i]);
+      }
+    }
+    if (!nodes.empty()) {
+      // the searches that found an evicted node may still read its slot
+      wait_for_cache_readers();
+      load_nodes_into_cache(nodes);
+    }
+
+    // decay, so that the nodes the queries moved away from cool off
+    for (_u64 id = 0; id < num_points; id++) {
+      auto heat = node_heat[id].load(std::memory_order_relaxed);
+      node_heat[id].store(heat / 2, std::memory_order_relaxed);
+    }
+    return nodes.size();
+  }
+
   template<typename T>
   _u64 PQFlashIndex<T>::cal_size() {
     _u64 index_mem_size = 0;
@@ -1904,8 +2739,9 @@ namespace diskann {
     index_mem_size += ROUND_UP(num_medoids * aligned_dim * sizeof(float), 32);
     index_mem_size += num_medoids * aligned_dim * sizeof(uint32_t);
     // get pq data and pq_table:
-    index_mem_size += this->num_points * this->n_chunks * sizeof(uint8_t);
-    index_mem_size += this->pq_table.get_total_dims() * 256 * sizeof(float) * 2;
+    index_mem_size += this->num_points * this->pq_code_size * sizeof(uint8_t);
+    index_mem_size += this->pq_table.get_total_dims() *
+                      this->pq_table.get_num_centers() * sizeof(float) * 2;
     index_mem_size +=
         this->pq_table.get_total_dims() * (sizeof(uint32_t) + sizeof(float));
     index_mem_size += (this->pq_table.get_num_chunks() + 1) * sizeof(uint32_t);
@@ -1913,6 +2749,15 @@ namespace diskann {
     if (this->metric == diskann::Metric::COSINE) {
       index_mem_size += sizeof(float) * this->num_points;
     }
+    if (adaptive_cache) {
+      index_mem_size += sizeof(_u8) * this->num_points;
+    }
+    index_mem_size += (loc_to_id.size() + id_to_loc.size()) * sizeof(_u32);
+    index_mem_size += labels.size() * sizeof(_u32);
+    index_mem_size += label_medoids.size() * sizeof(std::pair<_u32, _u32>);
+    index_mem_size += (nav_ids.size() + nav_graph.size()) * sizeof(_u32);
+    index_mem_size += nav_data.size() * sizeof(float);
+    index_mem_size += nav_deleted.size() / 8;
 
     return index_mem_size;
   }
@@ -0,0 +1,263 @@
+#include "diskann/remote_sector_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include "diskann/ann_exception.h"
+#include "diskann/logger.h"
+
+SectorCache::SectorCache(const SectorCacheConfig &config) {
+  dram_slots_ = config.dram_bytes / kSectorLen;
+  if (dram_slots_ > 0) {
+    dram_buf_.reset(new char[dram_slots_ * kSectorLen]);
+  }
+  ssd_slots_ = config.ssd_bytes / kSectorLen;
+  if (ssd_slots_ > 0 && !config.ssd_path.empty()) {
+    ssd_fd_ = ::open(config.ssd_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (ssd_fd_ == -1) {
+      LOG_KNOWHERE_WARNING_ << "Failed to open the sector cache file "
+                            << config.ssd_path << ", errno: " << errno
+                            << ", the sectors are cached in memory only";
+    } else {
+      ssd_path_ = config.ssd_path;
+      ssd_slot_sector_.assign(ssd_slots_, kNoSector);
+      ssd_slot_gen_.assign(ssd_slots_, 0);
+    }
+  }
+}
+
+SectorCache::~SectorCache() {
+  if (ssd_fd_ != -1) {
+    ::close(ssd_fd_);
+    ::unlink(ssd_path_.c_str());
+  }
+}
+
+bool SectorCache::get(uint64_t sector, char *buf) {
+  if (get_dram(sector, buf)) {
+    return true;
+  }
+  if (get_ssd(sector, buf)) {
+    put_dram(sector, buf);
+    return true;
+  }
+  return false;
+}
+
+void SectorCache::put(uint64_t sector, const char *buf) {
+  put_dram(sector, buf);
+  put_ssd(sector, buf);
+}
+
+bool SectorCache::get_dram(uint64_t sector, char *buf) {
+  if (dram_slots_ == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(dram_mtx_);
+  auto                        it = dram_map_.find(sector);
+  if (it == dram_map_.end()) {
+    return false;
+  }
+  dram_lru_.splice(dram_lru_.begin(), dram_lru_, it->second);
+  memcpy(buf, dram_buf_.get() + it->second->second * kSectorLen, kSectorLen);
+  return true;
+}
+
+void SectorCache::put_dram(uint64_t sector, const char *buf) {
+  if (dram_slots_ == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(dram_mtx_);
+  if (dram_map_.find(sector) != dram_map_.end()) {
+    return;
+  }
+  uint64_t slot;
+  if (dram_lru_.size() < dram_slots_) {
+    slot = dram_lru_.size();
+  } else {
+    slot = dram_lru_.back().second;
+    dram_map_.erase(dram_lru_.back().first);
+    dram_lru_.pop_back();
+  }
+  memcpy(dram_buf_.get() + slot * kSectorLen, buf, kSectorLen);
+  dram_lru_.emplace_front(sector, slot);
+  dram_map_[sector] = dram_lru_.begin();
+}
+
+bool SectorCache::get_ssd(uint64_t sector, char *buf) {
+  if (ssd_fd_ == -1) {
+    return false;
+  }
+  uint64_t slot, gen;
+  {
+    std::lock_guard<std::mutex> lock(ssd_mtx_);
+    auto                        it = ssd_map_.find(sector);
+    if (it == ssd_map_.end()) {
+      return false;
+    }
+    slot = it->second;
+    gen = ssd_slot_gen_[slot];
+  }
+  if (::pread(ssd_fd_, buf, kSectorLen, slot * kSectorLen) !=
+      (ssize_t) kSectorLen) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(ssd_mtx_);
+  return ssd_slot_gen_[slot] == gen;
+}
+
+void SectorCache::put_ssd(uint64_t sector, const char *buf) {
+  if (ssd_fd_ == -1) {
+    return;
+  }
+  uint64_t slot, gen;
+  {
+    std::lock_guard<std::mutex> lock(ssd_mtx_);
+    if (ssd_map_.find(sector) != ssd_map_.end()) {
+      return;
+    }
+    slot = ssd_next_;
+    ssd_next_ = (ssd_next_ + 1) % ssd_slots_;
+    if (ssd_slot_sector_[slot] != kNoSector) {
+      ssd_map_.erase(ssd_slot_sector_[slot]);
+    }
+    ssd_slot_sector_[slot] = kNoSector;
+    gen = ++ssd_slot_gen_[slot];
+  }
+  if (::pwrite(ssd_fd_, buf, kSectorLen, slot * kSectorLen) !=
+      (ssize_t) kSectorLen) {
+    return;
+  }
+  // the slot is found only once it is written, unless it was taken meanwhile
+  std::lock_guard<std::mutex> lock(ssd_mtx_);
+  if (ssd_slot_gen_[slot] == gen && ssd_map_.find(sector) == ssd_map_.end()) {
+    ssd_slot_sector_[slot] = sector;
+    ssd_map_[sector] = slot;
+  }
+}
+
+RemoteSectorReader::RemoteSectorReader(
+    std::shared_ptr<knowhere::FileRangeReader> remote,
+    const SectorCacheConfig                   &config)
+    : remote_(std::move(remote)), config_(config), cache_(config) {
+  if (remote_ == nullptr) {
+    throw diskann::ANNException("The remote file reader is null", -1,
+                                __FUNCSIG__, __FILE__, __LINE__);
+  }
+}
+
+void RemoteSectorReader::open(const std::string &fname) {
+  auto size = remote_->Size();
+  if (!size.has_value()) {
+    throw diskann::ANNException("Failed to get the size of " + fname, -1,
+                                __FUNCSIG__, __FILE__, __LINE__);
+  }
+  file_size_ = size.value();
+  LOG_KNOWHERE_DEBUG_ << "Opened remote file : " << fname;
+}
+
+void RemoteSectorReader::close() {
+}
+
+void RemoteSectorReader::read(std::vector<AlignedRead> &read_reqs,
+                              io_context_t &ctx, bool async) {
+  constexpr uint64_t kSectorLen = SectorCache::kSectorLen;
+  // the destinations of every missing sector, the reads of a beam may share
+  // sectors
+  std::unordered_map<uint64_t, std::vector<char *>> missing;
+  for (auto &req : read_reqs) {
+    if (req.offset % kSectorLen != 0 || req.len % kSectorLen != 0) {
+      std::stringstream err;
+      err << "Remote read at " << req.offset << " of " << req.len
+          << " bytes is not sector aligned";
+      throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+    for (uint64_t pos = 0; pos < req.len; pos += kSectorLen) {
+      const uint64_t sector = (req.offset + pos) / kSectorLen;
+      char          *dst = reinterpret_cast<char *>(req.buf) + pos;
+      if (!cache_.get(sector, dst)) {
+        missing[sector].push_back(dst);
+      }
+    }
+  }
+  if (!missing.empty()) {
+    fetch(missing);
+  }
+}
+
+void RemoteSectorReader::fetch(
+    const std::unordered_map<uint64_t, std::vector<char *>> &missing) {
+  constexpr uint64_t kSectorLen = SectorCache::kSectorLen;
+  std::vector<uint64_t> sectors;
+  sectors.reserve(missing.size());
+  for (const auto &m : missing) {
+    sectors.push_back(m.first);
+  }
+  std::sort(sectors.begin(), sectors.end());
+
+  // <first, last> sectors of every ranged read
+  std::vector<std::pair<uint64_t, uint64_t>> runs;
+  for (auto sector : sectors) {
+    if (!runs.empty() &&
+        sector - runs.back().second <= config_.max_coalesce_gap + 1) {
+      runs.back().second = sector;
+    } else {
+      runs.emplace_back(sector, sector);
+    }
+  }
+
+  auto fetch_run = [&](uint64_t first, uint64_t last) {
+    const uint64_t          n = last - first + 1;
+    const uint64_t          offset = first * kSectorLen;
+    std::unique_ptr<char[]> buf(new char[n * kSectorLen]());
+    // the last sector of the file may be short
+    const uint64_t len =
+        std::min(n * kSectorLen, file_size_ > offset ? file_size_ - offset : 0);
+    if (!remote_->Read(offset, len, buf.get())) {
+      std::stringstream err;
+      err << "Remote read at " << offset << " of " << len << " bytes failed";
+      throw diskann::ANNException(err.str(), -1, __FUNCSIG__, __FILE__,
+                                  __LINE__);
+    }
+    for (uint64_t sector = first; sector <= last; sector++) {
+      const char *src = buf.get() + (sector - first) * kSectorLen;
+      auto        it = missing.find(sector);
+      if (it != missing.end()) {
+        for (auto dst : it->second) {
+          memcpy(dst, src, kSectorLen);
+        }
+      }
+      cache_.put(sector, src);
+    }
+  };
+
+  // the calling thread takes the first run of every round
+  const size_t parallel =
+      std::max<uint64_t>(1, config_.max_parallel_reads);
+  for (size_t begin = 0; begin < runs.size(); begin += parallel) {
+    const size_t                   end = std::min(begin + parallel, runs.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(end - begin - 1);
+    for (size_t i = begin + 1; i < end; i++) {
+      futures.emplace_back(std::async(std::launch::async, fetch_run,
+                                      runs[i].first, runs[i].second));
+    }
+    fetch_run(runs[begin].first, runs[begin].second);
+    for (auto &future : futures) {
+      future.get();
+    }
+  }
+}
+
+void RemoteSectorReader::submit_req(io_context_t             &ctx,
+                                    std::vector<AlignedRead> &read_reqs) {
+  read(read_reqs, ctx);
+}
+
+void RemoteSectorReader::get_submitted_req(io_context_t &ctx, size_t n_ops) {
+}
@@ -16,6 +16,8 @@ sq_get_distance_computer_func_ptr sq_get_distance_computer =
 sq_sel_quantizer_func_ptr sq_sel_quantizer = sq_select_quantizer_ref;
 sq_sel_inv_list_scanner_func_ptr sq_sel_inv_list_scanner =
         sq_select_inverted_list_scanner_ref;
+sq_sel_interleaved_scanner_func_ptr sq_sel_interleaved_scanner =
+        sq_select_interleaved_scanner_ref;
 
 void sq_hook() {
     // SQ8 always hook best SIMD
@@ -28,16 +30,19 @@ void sq_hook() {
         sq_get_distance_computer = sq_get_distance_computer_avx512;
         sq_sel_quantizer = sq_select_quantizer_avx512;
         sq_sel_inv_list_scanner = sq_select_inverted_list_scanner_avx512;
+        sq_sel_interleaved_scanner = sq_select_interleaved_scanner_avx512;
     } else if (use_avx2 && cpu_support_avx2()) {
         /* for IVFSQ */
         sq_get_distance_computer = sq_get_distance_computer_avx;
         sq_sel_quantizer = sq_select_quantizer_avx;
         sq_sel_inv_list_scanner = sq_select_inverted_list_scanner_avx;
+        sq_sel_interleaved_scanner = sq_select_interleaved_scanner_avx;
     } else if (use_sse4_2 && cpu_support_sse4_2()) {
         /* for IVFSQ */
         sq_get_distance_computer = sq_get_distance_computer_ref;
         sq_sel_quantizer = sq_select_quantizer_ref;
         sq_sel_inv_list_scanner = sq_select_inverted_list_scanner_ref;
+        sq_sel_interleaved_scanner = sq_select_interleaved_scanner_ref;
     }
 #endif
 
@@ -49,6 +54,7 @@ void sq_hook() {
     sq_get_distance_computer = sq_get_distance_computer_neon;
     sq_sel_quantizer = sq_select_quantizer_neon;
     sq_sel_inv_list_scanner = sq_select_inverted_list_scanner_neon;
+    sq_sel_interleaved_scanner = sq_select_interleaved_scanner_neon;
 #endif
 }
 
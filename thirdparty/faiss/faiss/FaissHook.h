@@ -31,9 +31,20 @@ typedef InvertedListScanner* (*sq_sel_inv_list_scanner_func_ptr)(
         bool,
         const IDSelector*,
         bool);
+// the scanner of the lists interleaved by blocks of nvec codes, see
+// IndexIVFScalarQuantizer::set_interleaved()
+typedef InvertedListScanner* (*sq_sel_interleaved_scanner_func_ptr)(
+        MetricType,
+        const ScalarQuantizer*,
+        const Index*,
+        size_t,
+        bool,
+        const IDSelector*,
+        bool);
 
 extern sq_get_distance_computer_func_ptr sq_get_distance_computer;
 extern sq_sel_quantizer_func_ptr sq_sel_quantizer;
 extern sq_sel_inv_list_scanner_func_ptr sq_sel_inv_list_scanner;
+extern sq_sel_interleaved_scanner_func_ptr sq_sel_interleaved_scanner;
 void sq_hook();
 } // namespace faiss
@@ -9,8 +9,10 @@
 
 #include <faiss/IndexBinaryHash.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <unordered_set>
 
@@ -310,24 +312,28 @@ IndexBinaryMultiHash::~IndexBinaryMultiHash() {
 void IndexBinaryMultiHash::reset() {
     storage->reset();
     ntotal = 0;
-    for (auto map : maps) {
+    for (auto& map : maps) {
         map.clear();
     }
 }
 
+uint64_t IndexBinaryMultiHash::hash_of(const uint8_t* x, int h) const {
+    // never read past the end of the code, which may be the last one of an
+    //   array
+    const size_t ho = (size_t)h * b;
+    const size_t offset = ho >> 3;
+    uint64_t hash = 0;
+    memcpy(&hash, x + offset, std::min<size_t>(8, code_size - offset));
+    return (hash >> (ho & 7)) & (((uint64_t)1 << b) - 1);
+}
+
 void IndexBinaryMultiHash::add(idx_t n, const uint8_t* x) {
     storage->add(n, x);
     // populate maps
-    uint64_t mask = ((uint64_t)1 << b) - 1;
-
     for (idx_t i = 0; i < n; i++) {
         const uint8_t* xi = x + i * code_size;
-        int ho = 0;
         for (int h = 0; h < nhash; h++) {
-            uint64_t hash = *(uint64_t*)(xi + (ho >> 3)) >> (ho & 7);
-            hash &= mask;
-            maps[h][hash].push_back(i + ntotal);
-            ho += b;
+            maps[h][hash_of(xi, h)].push_back(i + ntotal);
         }
     }
     ntotal += n;
@@ -369,13 +375,8 @@ void search_1_query_multihash(
         size_t& nlist,
         size_t& ndis) {
     std::unordered_set<idx_t> shortlist;
-    int b = index.b;
-    uint64_t mask = ((uint64_t)1 << b) - 1;
-
-    int ho = 0;
     for (int h = 0; h < index.nhash; h++) {
-        uint64_t qhash = *(uint64_t*)(xi + (ho >> 3)) >> (ho & 7);
-        qhash &= mask;
+        uint64_t qhash = index.hash_of(xi, h);
         const IndexBinaryMultiHash::Map& map = index.maps[h];
 
         FlipEnumerator fe(index.b, index.nflip);
@@ -394,8 +395,6 @@ void search_1_query_multihash(
                 n0++;
             }
         } while (fe.next());
-
-        ho += b;
     }
     ndis += shortlist.size();
 
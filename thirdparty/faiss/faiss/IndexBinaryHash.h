@@ -121,6 +121,9 @@ struct IndexBinaryMultiHash : IndexBinary {
             const SearchParameters* params = nullptr) const override;
 
     size_t hashtable_size() const;
+
+    /// the value of the code x in map h: its bits [h * b, (h + 1) * b)
+    uint64_t hash_of(const uint8_t* x, int h) const;
 };
 
 } // namespace faiss
@@ -24,6 +24,7 @@
 #include <faiss/utils/hamming.h>
 #include <faiss/utils/sorting.h>
 #include <faiss/utils/utils.h>
+#include <simd/hook.h>
 
 namespace faiss {
 
@@ -363,10 +364,14 @@ void IndexBinaryIVF::replace_invlists(InvertedLists* il, bool own) {
 
 namespace {
 
+// the codes scored at once by the u8_*_distance_ny kernels
+constexpr size_t binary_scan_block_size = 256;
+
 // todo aguzhva: check whether templating store_pairs and use_sel makes sense
 template <class HammingComputer>
 struct IVFBinaryScannerL2 : BinaryInvertedListScanner {
     HammingComputer hc;
+    const uint8_t* query = nullptr;
     size_t code_size;
 
     IVFBinaryScannerL2(size_t code_size, bool store_pairs, const IDSelector* sel)
@@ -374,6 +379,7 @@ struct IVFBinaryScannerL2 : BinaryInvertedListScanner {
 
     void set_query(const uint8_t* query_vector) override {
         hc.set(query_vector, code_size);
+        query = query_vector;
     }
 
     idx_t list_no;
@@ -394,17 +400,21 @@ struct IVFBinaryScannerL2 : BinaryInvertedListScanner {
             size_t k) const override {
         using C = CMax<int32_t, idx_t>;
 
+        // the codes of the list are contiguous, they are scored in blocks
+        int32_t dis[binary_scan_block_size];
         size_t nup = 0;
-        for (size_t j = 0; j < n; j++) {
-            if (!this->sel || this->sel->is_member(ids[j])) {
-                auto dis = hc.compute(codes);
-                if (dis < simi[0]) {
+        for (size_t j0 = 0; j0 < n; j0 += binary_scan_block_size) {
+            const size_t j1 = std::min(j0 + binary_scan_block_size, n);
+            u8_hamming_distance_ny(
+                    query, codes + j0 * code_size, code_size, j1 - j0, dis);
+            for (size_t j = j0; j < j1; j++) {
+                if ((!this->sel || this->sel->is_member(ids[j])) &&
+                    dis[j - j0] < simi[0]) {
                     idx_t id = store_pairs ? lo_build(list_no, j) : ids[j];
-                    heap_replace_top<C>(k, simi, idxi, dis, id);
+                    heap_replace_top<C>(k, simi, idxi, dis[j - j0], id);
                     nup++;
                 }
             }
-            codes += code_size;
         }
         return nup;
     }
@@ -432,6 +442,7 @@ struct IVFBinaryScannerL2 : BinaryInvertedListScanner {
 template <class DistanceComputer>
 struct IVFBinaryScannerJaccard : BinaryInvertedListScanner {
     DistanceComputer hc;
+    const uint8_t* query = nullptr;
     size_t code_size;
 
     IVFBinaryScannerJaccard(size_t code_size, bool store_pairs, const IDSelector* sel)
@@ -439,6 +450,7 @@ struct IVFBinaryScannerJaccard : BinaryInvertedListScanner {
 
     void set_query(const uint8_t* query_vector) override {
         hc.set(query_vector, code_size);
+        query = query_vector;
     }
 
     idx_t list_no;
@@ -460,17 +472,20 @@ struct IVFBinaryScannerJaccard : BinaryInvertedListScanner {
         using C = CMax<float, idx_t>;
         // todo aguzhva: this is a dirty hack in the baseline
         float* psimi = (float*)simi;
+        float dis[binary_scan_block_size];
         size_t nup = 0;
-        for (size_t j = 0; j < n; j++) {
-            if (!this->sel || this->sel->is_member(ids[j])) {
-                float dis = hc.compute(codes);
-                if (dis < psimi[0]) {
+        for (size_t j0 = 0; j0 < n; j0 += binary_scan_block_size) {
+            const size_t j1 = std::min(j0 + binary_scan_block_size, n);
+            u8_jaccard_distance_ny(
+                    query, codes + j0 * code_size, code_size, j1 - j0, dis);
+            for (size_t j = j0; j < j1; j++) {
+                if ((!this->sel || this->sel->is_member(ids[j])) &&
+                    dis[j - j0] < psimi[0]) {
                     idx_t id = store_pairs ? lo_build(list_no, j) : ids[j];
-                    heap_replace_top<C>(k, psimi, idxi, dis, id);
+                    heap_replace_top<C>(k, psimi, idxi, dis[j - j0], id);
                     nup++;
                 }
             }
-            codes += code_size;
         }
         return nup;
     }
@@ -146,6 +146,22 @@ struct FlatCosineDis : FlatCodesDistanceComputer {
         dis2 = dp2 * inverse_code_norm2 * inverse_query_norm;
         dis3 = dp3 * inverse_code_norm3 * inverse_query_norm;
     }
+
+    // compute eight distances
+    void distances_batch_8(const idx_t* idx, float* dis) final override {
+        ndis += 8;
+
+        const float* y[8];
+        for (size_t k = 0; k < 8; k++) {
+            y[k] = reinterpret_cast<const float*>(codes + idx[k] * code_size);
+            prefetch_L2(inverse_l2_norms + idx[k]);
+        }
+
+        fvec_inner_product_batch_8(q, y, d, dis);
+        for (size_t k = 0; k < 8; k++) {
+            dis[k] = dis[k] * inverse_l2_norms[idx[k]] * inverse_query_norm;
+        }
+    }
 };
 
 
@@ -204,6 +220,20 @@ void WithCosineNormDistanceComputer::distances_batch_4(
     dis3 = dis3 * inverse_l2_norms[idx3] * inverse_query_norm;
 }
 
+void WithCosineNormDistanceComputer::distances_batch_8(
+        const idx_t* idx,
+        float* dis) {
+    for (size_t k = 0; k < 8; k++) {
+        prefetch_L2(inverse_l2_norms + idx[k]);
+    }
+
+    basedis->distances_batch_8(idx, dis);
+
+    for (size_t k = 0; k < 8; k++) {
+        dis[k] = dis[k] * inverse_l2_norms[idx[k]] * inverse_query_norm;
+    }
+}
+
 /// compute distance between two stored vectors
 float WithCosineNormDistanceComputer::symmetric_dis(idx_t i, idx_t j) {
     prefetch_L2(inverse_l2_norms + i);
@@ -215,6 +245,11 @@ float WithCosineNormDistanceComputer::symmetric_dis(idx_t i, idx_t j) {
     return v;
 }
 
+void WithCosineNormDistanceComputer::prefetch(idx_t i) {
+    prefetch_L2(inverse_l2_norms + i);
+    basedis->prefetch(i);
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////
 
@@ -249,6 +284,14 @@ void L2NormsStorage::reset() {
     inverse_l2_norms.clear();
 }
 
+void L2NormsStorage::permute(const idx_t* perm) {
+    std::vector<float> new_inverse_l2_norms(inverse_l2_norms.size());
+    for (size_t i = 0; i < inverse_l2_norms.size(); i++) {
+        new_inverse_l2_norms[i] = inverse_l2_norms[perm[i]];
+    }
+    std::swap(inverse_l2_norms, new_inverse_l2_norms);
+}
+
 std::vector<float> L2NormsStorage::as_l2_norms() const {
     std::vector<float> result(inverse_l2_norms.size());
     for (size_t i = 0; i < inverse_l2_norms.size(); i++) {
@@ -290,6 +333,11 @@ void IndexFlatCosine::reset() {
     inverse_norms_storage.reset();
 }
 
+void IndexFlatCosine::permute_entries(const idx_t* perm) {
+    IndexFlat::permute_entries(perm);
+    inverse_norms_storage.permute(perm);
+}
+
 const float* IndexFlatCosine::get_inverse_l2_norms() const {
     return inverse_norms_storage.inverse_l2_norms.data();
 }
@@ -333,6 +381,11 @@ void IndexScalarQuantizerCosine::reset() {
     inverse_norms_storage.reset();
 }
 
+void IndexScalarQuantizerCosine::permute_entries(const idx_t* perm) {
+    IndexScalarQuantizer::permute_entries(perm);
+    inverse_norms_storage.permute(perm);
+}
+
 const float* IndexScalarQuantizerCosine::get_inverse_l2_norms() const {
     return inverse_norms_storage.inverse_l2_norms.data();
 }
@@ -378,6 +431,11 @@ void IndexPQCosine::reset() {
     inverse_norms_storage.reset();
 }
 
+void IndexPQCosine::permute_entries(const idx_t* perm) {
+    IndexPQ::permute_entries(perm);
+    inverse_norms_storage.permute(perm);
+}
+
 const float* IndexPQCosine::get_inverse_l2_norms() const {
     return inverse_norms_storage.inverse_l2_norms.data();
 }
@@ -429,6 +487,11 @@ void IndexProductResidualQuantizerCosine::reset() {
     inverse_norms_storage.reset();
 }
 
+void IndexProductResidualQuantizerCosine::permute_entries(const idx_t* perm) {
+    IndexProductResidualQuantizer::permute_entries(perm);
+    inverse_norms_storage.permute(perm);
+}
+
 const float* IndexProductResidualQuantizerCosine::get_inverse_l2_norms() const {
     return inverse_norms_storage.inverse_l2_norms.data();
 }
@@ -442,6 +505,55 @@ DistanceComputer* IndexProductResidualQuantizerCosine::get_distance_computer() c
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////
+
+IndexRaBitQCosine::IndexRaBitQCosine(idx_t d) :
+    IndexRaBitQ(d, MetricType::METRIC_INNER_PRODUCT) {
+    is_cosine = true;
+}
+
+IndexRaBitQCosine::IndexRaBitQCosine() : IndexRaBitQ() {
+    metric_type = MetricType::METRIC_INNER_PRODUCT;
+    is_cosine = true;
+}
+
+void IndexRaBitQCosine::add(idx_t n, const float* x) {
+    FAISS_THROW_IF_NOT(is_trained);
+    if (n == 0) {
+        return;
+    }
+
+    IndexRaBitQ::add(n, x);
+    inverse_norms_storage.add(x, n, d);
+}
+
+void IndexRaBitQCosine::reset() {
+    IndexRaBitQ::reset();
+    inverse_norms_storage.reset();
+}
+
+void IndexRaBitQCosine::permute_entries(const idx_t* perm) {
+    IndexRaBitQ::permute_entries(perm);
+    inverse_norms_storage.permute(perm);
+}
+
+const float* IndexRaBitQCosine::get_inverse_l2_norms() const {
+    return inverse_norms_storage.inverse_l2_norms.data();
+}
+
+DistanceComputer* IndexRaBitQCosine::get_distance_computer() const {
+    return get_quantized_cosine_distance_computer(qb);
+}
+
+DistanceComputer* IndexRaBitQCosine::get_quantized_cosine_distance_computer(const uint8_t qb_in) const {
+    return new WithCosineNormDistanceComputer(
+        this->get_inverse_l2_norms(),
+        this->d,
+        std::unique_ptr<faiss::DistanceComputer>(IndexRaBitQ::get_quantized_distance_computer(qb_in))
+    );
+}
+
+
 //////////////////////////////////////////////////////////////////////////////////
 
 //
@@ -524,6 +636,13 @@ IndexHNSWProductResidualQuantizerCosine::IndexHNSWProductResidualQuantizerCosine
     is_cosine = true;
 }
 
+//
+IndexHNSWRaBitQ::IndexHNSWRaBitQ() = default;
 
+//
+IndexHNSWRaBitQCosine::IndexHNSWRaBitQCosine() {
+    is_cosine = true;
 }
 
+
+}
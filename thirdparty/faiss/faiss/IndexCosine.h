@@ -21,6 +21,7 @@
 #include <faiss/IndexHNSW.h>
 #include <faiss/IndexScalarQuantizer.h>
 #include <faiss/IndexPQ.h>
+#include <faiss/IndexRaBitQ.h>
 #include <faiss/impl/DistanceComputer.h>
 
 
@@ -60,8 +61,12 @@ struct WithCosineNormDistanceComputer : DistanceComputer {
             float& dis2,
             float& dis3) override;
 
+    void distances_batch_8(const idx_t* idx, float* dis) override;
+
     /// compute distance between two stored vectors
     float symmetric_dis(idx_t i, idx_t j) override;
+
+    void prefetch(idx_t i) override;
 };
 
 struct HasInverseL2Norms {
@@ -86,6 +91,9 @@ struct L2NormsStorage {
     // clear the storage
     void reset();
 
+    // perm of size ntotal maps new to old positions
+    void permute(const idx_t* perm);
+
     // produces a vector of L2 norms, effectively inverting inverse_l2_norms
     std::vector<float> as_l2_norms() const;
 };
@@ -99,6 +107,7 @@ struct IndexFlatCosine : IndexFlat, HasInverseL2Norms {
 
     void add(idx_t n, const float* x) override;
     void reset() override;
+    void permute_entries(const idx_t* perm) override;
 
     FlatCodesDistanceComputer* get_FlatCodesDistanceComputer() const override;
 
@@ -117,6 +126,7 @@ struct IndexScalarQuantizerCosine : IndexScalarQuantizer, HasInverseL2Norms {
 
     void add(idx_t n, const float* x) override;
     void reset() override;
+    void permute_entries(const idx_t* perm) override;
 
     DistanceComputer* get_distance_computer() const override;
 
@@ -133,6 +143,7 @@ struct IndexPQCosine : IndexPQ, HasInverseL2Norms {
 
     void add(idx_t n, const float* x) override;
     void reset() override;
+    void permute_entries(const idx_t* perm) override;
 
     DistanceComputer* get_distance_computer() const override;
 
@@ -154,12 +165,33 @@ struct IndexProductResidualQuantizerCosine : IndexProductResidualQuantizer, HasI
 
     void add(idx_t n, const float* x) override;
     void reset() override;
+    void permute_entries(const idx_t* perm) override;
 
     DistanceComputer* get_distance_computer() const override;
 
     const float* get_inverse_l2_norms() const override;
 };
 
+//
+struct IndexRaBitQCosine : IndexRaBitQ, HasInverseL2Norms {
+    L2NormsStorage inverse_norms_storage;
+
+    IndexRaBitQCosine(idx_t d);
+
+    IndexRaBitQCosine();
+
+    void add(idx_t n, const float* x) override;
+    void reset() override;
+    void permute_entries(const idx_t* perm) override;
+
+    DistanceComputer* get_distance_computer() const override;
+
+    // same as get_distance_computer(), but quantizes a query to qb_in bits
+    DistanceComputer* get_quantized_cosine_distance_computer(const uint8_t qb_in) const;
+
+    const float* get_inverse_l2_norms() const override;
+};
+
 //
 struct IndexHNSWFlatCosine : IndexHNSW {
     IndexHNSWFlatCosine();
@@ -213,5 +245,15 @@ struct IndexHNSWProductResidualQuantizerCosine : IndexHNSW {
     );
 };
 
+// the storage is expected to be replaced with a trained IndexRaBitQ
+struct IndexHNSWRaBitQ : IndexHNSW {
+    IndexHNSWRaBitQ();
+};
+
+// the storage is expected to be replaced with a trained IndexRaBitQCosine
+struct IndexHNSWRaBitQCosine : IndexHNSW {
+    IndexHNSWRaBitQCosine();
+};
+
 
 }
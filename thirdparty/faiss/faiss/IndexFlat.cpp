@@ -145,14 +145,16 @@ struct FlatL2Dis : FlatCodesDistanceComputer {
     const float* q;
     const float* b;
     size_t ndis;
+    // unrolled for d when it is a common embedding size
+    FvecDimKernels kernels;
 
     float distance_to_code(const uint8_t* code) final {
         ndis++;
-        return fvec_L2sqr(q, (float*)code, d);
+        return kernels.L2sqr(q, (float*)code, d);
     }
 
     float symmetric_dis(idx_t i, idx_t j) override {
-        return fvec_L2sqr(b + j * d, b + i * d, d);
+        return kernels.L2sqr(b + j * d, b + i * d, d);
     }
 
     explicit FlatL2Dis(const IndexFlat& storage, const float* q = nullptr)
@@ -163,7 +165,8 @@ struct FlatL2Dis : FlatCodesDistanceComputer {
               nb(storage.ntotal),
               q(q),
               b(storage.get_xb()),
-              ndis(0) {}
+              ndis(0),
+              kernels(fvec_dim_kernels(storage.d)) {}
 
     void set_query(const float* x) override {
         q = x;
@@ -195,12 +198,23 @@ struct FlatL2Dis : FlatCodesDistanceComputer {
         float dp1 = 0;
         float dp2 = 0;
         float dp3 = 0;
-        fvec_L2sqr_batch_4(q, y0, y1, y2, y3, d, dp0, dp1, dp2, dp3);
+        kernels.L2sqr_batch_4(q, y0, y1, y2, y3, d, dp0, dp1, dp2, dp3);
         dis0 = dp0;
         dis1 = dp1;
         dis2 = dp2;
         dis3 = dp3;
     }
+
+    // compute eight distances
+    void distances_batch_8(const idx_t* idx, float* dis) final override {
+        ndis += 8;
+
+        const float* y[8];
+        for (size_t k = 0; k < 8; k++) {
+            y[k] = reinterpret_cast<const float*>(codes + idx[k] * code_size);
+        }
+        fvec_L2sqr_batch_8(q, y, d, dis);
+    }
 };
 
 struct FlatIPDis : FlatCodesDistanceComputer {
@@ -209,14 +223,16 @@ struct FlatIPDis : FlatCodesDistanceComputer {
     const float* q;
     const float* b;
     size_t ndis;
+    // unrolled for d when it is a common embedding size
+    FvecDimKernels kernels;
 
     float symmetric_dis(idx_t i, idx_t j) final override {
-        return fvec_inner_product(b + j * d, b + i * d, d);
+        return kernels.inner_product(b + j * d, b + i * d, d);
     }
 
     float distance_to_code(const uint8_t* code) final override {
         ndis++;
-        return fvec_inner_product(q, (const float*)code, d);
+        return kernels.inner_product(q, (const float*)code, d);
     }
 
     explicit FlatIPDis(const IndexFlat& storage, const float* q = nullptr)
@@ -227,7 +243,8 @@ struct FlatIPDis : FlatCodesDistanceComputer {
               nb(storage.ntotal),
               q(q),
               b(storage.get_xb()),
-              ndis(0) {}
+              ndis(0),
+              kernels(fvec_dim_kernels(storage.d)) {}
 
     void set_query(const float* x) override {
         q = x;
@@ -259,12 +276,23 @@ struct FlatIPDis : FlatCodesDistanceComputer {
         float dp1 = 0;
         float dp2 = 0;
         float dp3 = 0;
-        fvec_inner_product_batch_4(q, y0, y1, y2, y3, d, dp0, dp1, dp2, dp3);
+        kernels.inner_product_batch_4(q, y0, y1, y2, y3, d, dp0, dp1, dp2, dp3);
         dis0 = dp0;
         dis1 = dp1;
         dis2 = dp2;
         dis3 = dp3;
     }
+
+    // compute eight distances
+    void distances_batch_8(const idx_t* idx, float* dis) final override {
+        ndis += 8;
+
+        const float* y[8];
+        for (size_t k = 0; k < 8; k++) {
+            y[k] = reinterpret_cast<const float*>(codes + idx[k] * code_size);
+        }
+        fvec_inner_product_batch_8(q, y, d, dis);
+    }
 };
 
 } // namespace
@@ -393,6 +421,22 @@ struct FlatL2WithNormsDis : FlatCodesDistanceComputer {
         dis2 = query_l2norm + l2norms[idx2] - 2 * dp2;
         dis3 = query_l2norm + l2norms[idx3] - 2 * dp3;
     }
+
+    // compute eight distances
+    void distances_batch_8(const idx_t* idx, float* dis) final override {
+        ndis += 8;
+
+        const float* y[8];
+        for (size_t k = 0; k < 8; k++) {
+            y[k] = reinterpret_cast<const float*>(codes + idx[k] * code_size);
+            prefetch_L2(l2norms + idx[k]);
+        }
+
+        fvec_inner_product_batch_8(q, y, d, dis);
+        for (size_t k = 0; k < 8; k++) {
+            dis[k] = query_l2norm + l2norms[idx[k]] - 2 * dis[k];
+        }
+    }
 };
 
 } // namespace
@@ -411,6 +455,18 @@ void IndexFlatL2::clear_l2norms() {
     cached_l2norms.shrink_to_fit();
 }
 
+void IndexFlatL2::permute_entries(const idx_t* perm) {
+    IndexFlatCodes::permute_entries(perm);
+
+    if (!cached_l2norms.empty()) {
+        std::vector<float> new_l2norms(ntotal);
+        for (idx_t i = 0; i < ntotal; i++) {
+            new_l2norms[i] = cached_l2norms[perm[i]];
+        }
+        std::swap(cached_l2norms, new_l2norms);
+    }
+}
+
 FlatCodesDistanceComputer* IndexFlatL2::get_FlatCodesDistanceComputer() const {
     if (metric_type == METRIC_L2) {
         if (!cached_l2norms.empty()) {
@@ -65,7 +65,7 @@ struct IndexFlatCodes : Index {
     virtual void merge_from(Index& otherIndex, idx_t add_id = 0) override;
 
     // permute_entries. perm of size ntotal maps new to old positions
-    void permute_entries(const idx_t* perm);
+    virtual void permute_entries(const idx_t* perm);
 };
 
 } // namespace faiss
@@ -15,10 +15,12 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <queue>
 #include <random>
+#include <tuple>
 #include <unordered_set>
 
 #include <sys/stat.h>
@@ -77,6 +79,125 @@ DistanceComputer* storage_distance_computer(const Index* storage) {
     }
 }
 
+/// add the points of order[i0:i1], which all have level pt_level, in
+/// batches (see IndexHNSW::add_batch_size)
+void hnsw_add_level_batched(
+        IndexHNSW& index_hnsw,
+        size_t n0,
+        const float* x,
+        const std::vector<int>& order,
+        int i0,
+        int i1,
+        int pt_level,
+        size_t ntotal) {
+    size_t d = index_hnsw.d;
+    HNSW& hnsw = index_hnsw.hnsw;
+    bool keep_max_size_level0 =
+            index_hnsw.keep_max_size_level0 && (pt_level == 0);
+
+    // (level, dest, src) for every reverse link of a batch
+    using ReverseLink = std::tuple<int, storage_idx_t, storage_idx_t>;
+    std::vector<ReverseLink> reverse_links;
+
+    int i = i0;
+    while (i < i1) {
+        if (hnsw.entry_point < 0) {
+            // the first point of the graph has nothing to link to
+            hnsw.entry_point = order[i];
+            hnsw.max_level = pt_level;
+            i++;
+            continue;
+        }
+
+        // batches grow with the graph so that few points of a batch
+        // miss each other
+        size_t n_linked = n0 + (order.size() - i1) + (i - i0);
+        int batch_size = std::min<size_t>(
+                std::max<size_t>(n_linked, 1), index_hnsw.add_batch_size);
+        int b1 = std::min(i + batch_size, i1);
+
+        // search the graph as it was before the batch
+#pragma omp parallel if (b1 - i > 100)
+        {
+            VisitedTable vt(ntotal);
+            std::unique_ptr<DistanceComputer> dis(
+                    storage_distance_computer(index_hnsw.storage));
+
+#pragma omp for schedule(dynamic, 16)
+            for (int j = i; j < b1; j++) {
+                storage_idx_t pt_id = order[j];
+                dis->set_query(x + (pt_id - n0) * d);
+                hnsw.add_links_from_snapshot(
+                        *dis, pt_level, pt_id, vt, keep_max_size_level0);
+            }
+        }
+
+        reverse_links.clear();
+        for (int j = i; j < b1; j++) {
+            storage_idx_t pt_id = order[j];
+            for (int level = std::min(pt_level, hnsw.max_level); level >= 0;
+                 level--) {
+                size_t begin, end;
+                hnsw.neighbor_range(pt_id, level, &begin, &end);
+                for (size_t k = begin; k < end; k++) {
+                    storage_idx_t other_id = hnsw.neighbors[k];
+                    if (other_id < 0) {
+                        break;
+                    }
+                    reverse_links.emplace_back(level, other_id, pt_id);
+                }
+            }
+        }
+        std::sort(reverse_links.begin(), reverse_links.end());
+
+        // one group of links per target node and level
+        std::vector<size_t> group_lims;
+        for (size_t k = 0; k < reverse_links.size(); k++) {
+            if (k == 0 ||
+                std::get<0>(reverse_links[k]) !=
+                        std::get<0>(reverse_links[k - 1]) ||
+                std::get<1>(reverse_links[k]) !=
+                        std::get<1>(reverse_links[k - 1])) {
+                group_lims.push_back(k);
+            }
+        }
+        group_lims.push_back(reverse_links.size());
+        int64_t n_groups = group_lims.size() - 1;
+
+        // merge the reverse links, no two threads touch the same list
+#pragma omp parallel if (n_groups > 100)
+        {
+            std::unique_ptr<DistanceComputer> dis(
+                    storage_distance_computer(index_hnsw.storage));
+            std::vector<storage_idx_t> srcs;
+
+#pragma omp for schedule(dynamic, 16)
+            for (int64_t g = 0; g < n_groups; g++) {
+                srcs.clear();
+                for (size_t k = group_lims[g]; k < group_lims[g + 1]; k++) {
+                    srcs.push_back(std::get<2>(reverse_links[k]));
+                }
+                const ReverseLink& link = reverse_links[group_lims[g]];
+                hnsw.add_reverse_links(
+                        *dis,
+                        std::get<1>(link),
+                        std::get<0>(link),
+                        srcs.data(),
+                        srcs.size(),
+                        keep_max_size_level0);
+            }
+        }
+
+        if (pt_level > hnsw.max_level) {
+            hnsw.max_level = pt_level;
+            hnsw.entry_point = order[i];
+        }
+
+        InterruptCallback::check();
+        i = b1;
+    }
+}
+
 void hnsw_add_vertices(
         IndexHNSW& index_hnsw,
         size_t n0,
@@ -160,6 +281,13 @@ void hnsw_add_vertices(
             for (int j = i0; j < i1; j++)
                 std::swap(order[j], order[j + rng2.rand_int(i1 - j)]);
 
+            if (index_hnsw.add_batch_size > 0) {
+                hnsw_add_level_batched(
+                        index_hnsw, n0, x, order, i0, i1, pt_level, ntotal);
+                i1 = i0;
+                continue;
+            }
+
             bool interrupt = false;
 
 #pragma omp parallel if (i1 > i0 + 100)
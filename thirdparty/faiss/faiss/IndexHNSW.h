@@ -46,6 +46,14 @@ struct IndexHNSW : Index {
     // used when GpuIndexCagra::copyFrom(IndexHNSWCagra*) is invoked.
     bool keep_max_size_level0 = false;
 
+    // When set to a positive value, points are added in batches of at most
+    // that many points. The points of a batch search the graph as it was
+    // before the batch without taking any lock, and their reverse links are
+    // then merged with one thread per target node. Batches grow from 1
+    // point to this size as the graph fills. 0 adds the points one at a
+    // time under per-node locks.
+    int add_batch_size = 0;
+
     explicit IndexHNSW(int d = 0, int M = 32, MetricType metric = METRIC_L2);
     explicit IndexHNSW(Index* storage, int M = 32);
 
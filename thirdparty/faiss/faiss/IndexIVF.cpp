@@ -15,7 +15,9 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <vector>
@@ -29,7 +31,9 @@
 #include <faiss/impl/FaissAssert.h>
 #include <faiss/impl/IDSelector.h>
 
+#include "knowhere/comp/cancellation.h"
 #include "knowhere/object.h"
+#include "simd/hook.h"
 
 namespace faiss {
 
@@ -293,6 +297,80 @@ void IndexIVF::add_core(
     ntotal += n;
 }
 
+void IndexIVF::add_core_by_list(
+        idx_t n,
+        const float* x_norms,
+        const idx_t* xids,
+        const idx_t* coarse_idx,
+        const encode_one_t& encode) {
+    FAISS_THROW_IF_NOT(coarse_idx);
+    FAISS_THROW_IF_NOT(is_trained);
+    direct_map.check_can_add(xids);
+
+    DirectMapAdd dm_adder(direct_map, n, xids);
+
+    // a counting sort of the vectors by list
+    std::vector<size_t> list_begin(nlist + 1, 0);
+    for (idx_t i = 0; i < n; i++) {
+        if (coarse_idx[i] >= 0) {
+            list_begin[coarse_idx[i] + 1]++;
+        } else {
+            dm_adder.add(i, -1, 0);
+        }
+    }
+    for (size_t list_no = 0; list_no < nlist; list_no++) {
+        list_begin[list_no + 1] += list_begin[list_no];
+    }
+    std::vector<idx_t> order(list_begin[nlist]);
+    {
+        std::vector<size_t> cur(list_begin.begin(), list_begin.end() - 1);
+        for (idx_t i = 0; i < n; i++) {
+            if (coarse_idx[i] >= 0) {
+                order[cur[coarse_idx[i]]++] = i;
+            }
+        }
+    }
+
+    // the lists are uneven, hence the dynamic schedule
+#pragma omp parallel
+    {
+        std::vector<idx_t> ids;
+        std::vector<uint8_t> codes;
+        std::vector<float> norms;
+        std::vector<float> scratch(d);
+#pragma omp for schedule(dynamic)
+        for (int64_t list_no = 0; list_no < (int64_t)nlist; list_no++) {
+            const size_t begin = list_begin[list_no];
+            const size_t m = list_begin[list_no + 1] - begin;
+            if (m == 0) {
+                continue;
+            }
+            ids.resize(m);
+            codes.assign(m * code_size, 0);
+            norms.resize(x_norms == nullptr ? 0 : m);
+            for (size_t j = 0; j < m; j++) {
+                const idx_t i = order[begin + j];
+                ids[j] = xids ? xids[i] : ntotal + i;
+                if (x_norms != nullptr) {
+                    norms[j] = x_norms[i];
+                }
+                encode(i, codes.data() + j * code_size, scratch.data());
+            }
+            const size_t ofs = invlists->add_entries(
+                    list_no,
+                    m,
+                    ids.data(),
+                    codes.data(),
+                    x_norms == nullptr ? nullptr : norms.data());
+            for (size_t j = 0; j < m; j++) {
+                dm_adder.add(order[begin + j], list_no, ofs + j);
+            }
+        }
+    }
+
+    ntotal += n;
+}
+
 void IndexIVF::to_readonly() {
     if (is_readonly())
         return;
@@ -380,6 +458,10 @@ void IndexIVF::search(
 
     if ((parallel_mode & ~PARALLEL_MODE_NO_HEAP_INIT) == 0) {
         int nt = std::min(omp_get_max_threads(), int(n));
+        // nprobe_used is indexed by the queries of a search_preassigned call
+        if (params && params->nprobe_used) {
+            nt = 1;
+        }
         std::vector<IndexIVFStats> stats(nt);
         std::mutex exception_mutex;
         std::string exception_string;
@@ -411,11 +493,19 @@ void IndexIVF::search(
         // collect stats
         for (idx_t slice = 0; slice < nt; slice++) {
             indexIVF_stats.add(stats[slice]);
+            if (params && params->stats) {
+                params->stats->add(stats[slice]);
+            }
         }
     } else {
         // handle parallelization at level below (or don't run in parallel at
         // all)
-        sub_search_func(n, x, distances, labels, &indexIVF_stats);
+        IndexIVFStats local_stats;
+        sub_search_func(n, x, distances, labels, &local_stats);
+        indexIVF_stats.add(local_stats);
+        if (params && params->stats) {
+            params->stats->add(local_stats);
+        }
     }
 }
 
@@ -477,6 +567,26 @@ void IndexIVF::search_preassigned(
         max_codes = unlimited_list_size;
     }
 
+    const float* list_radii = params ? params->list_radii : nullptr;
+    const float list_radius_scale = params ? params->list_radius_scale : 1.0f;
+    const size_t min_nprobe = params ? params->min_nprobe : 0;
+    size_t* nprobe_used = params ? params->nprobe_used : nullptr;
+    const IVFListFilter* list_filter = params ? params->list_filter : nullptr;
+    const size_t max_lists_num =
+            (params && params->max_lists_num > 0) ? params->max_lists_num
+                                                 : nlist;
+    FAISS_THROW_IF_NOT_MSG(
+            list_filter == nullptr ||
+                    ((pmode == 0 || pmode == 3) && !store_pairs &&
+                     !invlists->use_iterator),
+            "list_filter supported only for parallel_mode = 0 or 3");
+    FAISS_THROW_IF_NOT_MSG(
+            list_radii == nullptr ||
+                    ((pmode == 0 || pmode == 3) && do_heap_init &&
+                     (metric_type == METRIC_L2 ||
+                      metric_type == METRIC_INNER_PRODUCT)),
+            "list_radii supported only for L2 or IP, parallel_mode = 0 or 3");
+
     bool do_parallel = omp_get_max_threads() >= 2 &&
             (pmode == 0           ? false
                      : pmode == 3 ? n > 1
@@ -486,6 +596,10 @@ void IndexIVF::search_preassigned(
     void* inverted_list_context =
             params ? params->inverted_list_context : nullptr;
 
+    // the token of the calling thread, the omp threads don't have it
+    const knowhere::CancellationToken* cancellation =
+            knowhere::CancellationToken::Current();
+
 #pragma omp parallel if (do_parallel) reduction(+ : nlistv, ndis, nheap)
     {
         std::unique_ptr<InvertedListScanner> scanner(
@@ -614,6 +728,116 @@ void IndexIVF::search_preassigned(
          * Actual loops, depending on parallel_mode
          ****************************************************/
 
+        // scans only the accepted vectors of a list, gathered into a buffer
+        std::vector<uint8_t> gathered_codes;
+        std::vector<float> gathered_norms;
+        std::vector<idx_t> gathered_ids;
+        // the codes of block lists are gathered in their packed layout
+        std::unique_ptr<CodePacker> block_packer(
+                invlists->code_size == InvertedLists::INVALID_CODE_SIZE
+                        ? get_CodePacker()
+                        : nullptr);
+        std::vector<uint8_t> unpacked_code(block_packer ? code_size : 0);
+        auto scan_gathered_list = [&](idx_t key,
+                                      float coarse_dis_i,
+                                      float* simi,
+                                      idx_t* idxi) {
+            const size_t* begin =
+                    list_filter->offsets.data() + list_filter->lims[key];
+            const size_t* end =
+                    list_filter->offsets.data() + list_filter->lims[key + 1];
+            const size_t n_gathered = end - begin;
+            gathered_norms.resize(n_gathered);
+            gathered_ids.resize(n_gathered);
+            if (block_packer) {
+                const size_t nvec = block_packer->nvec;
+                gathered_codes.assign(
+                        (n_gathered + nvec - 1) / nvec *
+                                block_packer->block_size,
+                        0);
+                InvertedLists::ScopedCodes scodes(invlists, key);
+                for (size_t j = 0; j < n_gathered; j++) {
+                    block_packer->unpack_1(
+                            scodes.get(), begin[j], unpacked_code.data());
+                    block_packer->pack_1(
+                            unpacked_code.data(), j, gathered_codes.data());
+                }
+            } else {
+                gathered_codes.resize(n_gathered * code_size);
+            }
+            bool with_norms = false;
+            for (size_t j = 0; j < n_gathered; j++) {
+                InvertedLists::ScopedCodeNorms snorm(invlists, key, begin[j]);
+                if (!block_packer) {
+                    InvertedLists::ScopedCodes scode(invlists, key, begin[j]);
+                    std::memcpy(
+                            gathered_codes.data() + j * code_size,
+                            scode.get(),
+                            code_size);
+                }
+                with_norms = snorm.get() != nullptr;
+                gathered_norms[j] = with_norms ? snorm.get()[0] : 0;
+                gathered_ids[j] = invlists->get_single_id(key, begin[j]);
+            }
+
+            scanner->set_list(key, coarse_dis_i);
+            nlistv++;
+
+            size_t scan_cnt = 0;
+            try {
+                nheap += scanner->scan_codes(
+                        n_gathered,
+                        gathered_codes.data(),
+                        with_norms ? gathered_norms.data() : nullptr,
+                        gathered_ids.data(),
+                        simi,
+                        idxi,
+                        k,
+                        scan_cnt);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                exception_string =
+                        demangle_cpp_symbol(typeid(e).name()) + "  " + e.what();
+                interrupt = true;
+                return size_t(0);
+            }
+            return scan_cnt;
+        };
+
+        // best possible distance in probes [ik, nprobe) of query i, per ik
+        std::vector<float> probe_bounds;
+        auto compute_probe_bounds = [&](idx_t i) {
+            probe_bounds.resize(nprobe);
+            const bool is_ip = metric_type == METRIC_INNER_PRODUCT;
+            const float qnorm =
+                    is_ip ? std::sqrt(fvec_norm_L2sqr(x + i * d, d)) : 0;
+            for (size_t ik = 0; ik < nprobe; ik++) {
+                const idx_t key = keys[i * nprobe + ik];
+                const float cd = coarse_dis[i * nprobe + ik];
+                if (key < 0) {
+                    probe_bounds[ik] = is_ip
+                            ? -std::numeric_limits<float>::infinity()
+                            : std::numeric_limits<float>::infinity();
+                    continue;
+                }
+                const float r = list_radius_scale * list_radii[key];
+                if (is_ip) {
+                    // <q, x> <= <q, c> + |q| * |x - c|
+                    probe_bounds[ik] = cd + qnorm * r;
+                } else {
+                    // |q - x| >= |q - c| - |x - c|
+                    const float lb =
+                            std::max(std::sqrt(std::max(cd, 0.0f)) - r, 0.0f);
+                    probe_bounds[ik] = lb * lb;
+                }
+            }
+            for (size_t ik = nprobe - 1; ik > 0; ik--) {
+                probe_bounds[ik - 1] = is_ip
+                        ? std::max(probe_bounds[ik - 1], probe_bounds[ik])
+                        : std::min(probe_bounds[ik - 1], probe_bounds[ik]);
+            }
+        };
+
         if (pmode == 0 || pmode == 3) {
 #pragma omp for
             for (idx_t i = 0; i < n; i++) {
@@ -628,21 +852,67 @@ void IndexIVF::search_preassigned(
 
                 init_result(simi, idxi);
 
+                if (list_radii) {
+                    compute_probe_bounds(i);
+                }
+
                 idx_t nscan = 0;
+                size_t nprobed = 0;
+                size_t nlists_scanned = 0;
 
                 // loop over probes
                 for (size_t ik = 0; ik < nprobe; ik++) {
-                    nscan += scan_one_list(
-                            keys[i * nprobe + ik],
-                            coarse_dis[i * nprobe + ik],
-                            simi,
-                            idxi,
-                            max_codes - nscan);
+                    // a cancelled search keeps the results of the lists
+                    // scanned so far
+                    if (cancellation && cancellation->IsCancelled()) {
+                        break;
+                    }
+                    const idx_t key = keys[i * nprobe + ik];
+                    nprobed = ik + 1;
+                    if (list_filter && key >= 0) {
+                        // nothing to find in the list
+                        if (list_filter->valid_counts[key] == 0) {
+                            continue;
+                        }
+                        nlists_scanned++;
+                    }
+
+                    if (list_filter && key >= 0 &&
+                        list_filter->lims[key + 1] > list_filter->lims[key]) {
+                        nscan += scan_gathered_list(
+                                key, coarse_dis[i * nprobe + ik], simi, idxi);
+                    } else {
+                        nscan += scan_one_list(
+                                key,
+                                coarse_dis[i * nprobe + ik],
+                                simi,
+                                idxi,
+                                max_codes - nscan);
+                    }
 
                     // if ensure_topk_full enabled, also make sure nscan >= k, then stop search further
                     if (nscan >= max_codes && (!ensure_topk_full || nscan >= k)) {
                         break;
                     }
+
+                    // the empty lists are substituted by the next ones
+                    if (list_filter && nlists_scanned >= max_lists_num &&
+                        (!ensure_topk_full || nscan >= k)) {
+                        break;
+                    }
+
+                    // the heap is full and the remaining lists can't improve it
+                    if (list_radii && nprobed < nprobe &&
+                        nprobed >= min_nprobe && idxi[0] >= 0 &&
+                        (metric_type == METRIC_INNER_PRODUCT
+                                 ? probe_bounds[nprobed] <= simi[0]
+                                 : probe_bounds[nprobed] >= simi[0])) {
+                        break;
+                    }
+                }
+
+                if (nprobe_used) {
+                    nprobe_used[i] = nprobed;
                 }
 
                 ndis += nscan;
@@ -836,6 +1106,9 @@ void IndexIVF::range_search_preassigned(
     void* inverted_list_context =
             params ? params->inverted_list_context : nullptr;
 
+    const knowhere::CancellationToken* cancellation =
+            knowhere::CancellationToken::Current();
+
 #pragma omp parallel if (do_parallel) reduction(+ : nlistv, ndis)
     {
         RangeSearchPartialResult pres(result);
@@ -922,6 +1195,9 @@ void IndexIVF::range_search_preassigned(
                 size_t ndup = 0;
 
                 for (size_t ik = 0; ik < nprobe; ik++) {
+                    if (cancellation && cancellation->IsCancelled()) {
+                        break;
+                    }
                     scan_list_func(i, ik, qres);
 
                     // if no valid results in N continuous buckets,
@@ -1274,36 +1550,73 @@ std::unique_ptr<IVFIteratorWorkspace> IndexIVF::getIteratorWorkspace(
     auto max_backup_count =
             max_coarse_list_size + workspace->backup_count_threshold;
 
-    // compute distances of all centroids
-    auto coarse_idx = std::make_unique<idx_t[]>(nlist);
-    auto coarse_dis = std::make_unique<float[]>(nlist);
-    quantizer->search(
-            1,
-            workspace->query_data.data(),
-            nlist,
-            coarse_dis.get(),
-            coarse_idx.get(),
-            workspace->search_params
-                    ? workspace->search_params->quantizer_params
-                    : nullptr);
-
-    workspace->coarse_idx = std::move(coarse_idx);
-    workspace->coarse_dis = std::move(coarse_dis);
+    // centroids are ordered on demand, the closest nprobe ones for now
+    workspace->coarse_idx = std::make_unique<idx_t[]>(nlist);
+    workspace->coarse_dis = std::make_unique<float[]>(nlist);
+    std::fill_n(workspace->coarse_idx.get(), nlist, -1);
+    workspace->coarse_listed.assign(nlist, false);
     workspace->coarse_list_sizes = std::move(coarse_list_sizes);
     workspace->nprobe = nprobe;
     workspace->dists.reserve(max_backup_count);
+    order_iterator_next_lists(workspace.get());
 
     return workspace;
 }
 
+bool IndexIVF::order_iterator_next_lists(
+        IVFIteratorWorkspace* workspace) const {
+    const size_t ordered = workspace->coarse_size;
+    size_t k = ordered == 0 ? std::max<size_t>(workspace->nprobe, 1)
+                            : std::min(nlist, 2 * ordered);
+    std::vector<idx_t> idx;
+    std::vector<float> dis;
+
+    // the closest k centroids include the ordered ones, unless the
+    // quantizer is approximate; grow k until a new one shows up
+    while (workspace->coarse_size == ordered && ordered < nlist) {
+        idx.resize(k);
+        dis.resize(k);
+        quantizer->search(
+                1,
+                workspace->query_data.data(),
+                k,
+                dis.data(),
+                idx.data(),
+                workspace->search_params
+                        ? workspace->search_params->quantizer_params
+                        : nullptr);
+
+        for (size_t i = 0; i < k; i++) {
+            const idx_t list_no = idx[i];
+            if (list_no < 0 || workspace->coarse_listed[list_no]) {
+                continue;
+            }
+            workspace->coarse_listed[list_no] = true;
+            workspace->coarse_idx[workspace->coarse_size] = list_no;
+            workspace->coarse_dis[workspace->coarse_size] = dis[i];
+            workspace->coarse_size++;
+        }
+
+        if (k == nlist) {
+            break;
+        }
+        k = std::min(nlist, 2 * k);
+    }
+
+    return workspace->coarse_size > ordered;
+}
+
 void IndexIVF::getIteratorNextBatch(
         IVFIteratorWorkspace* workspace,
         size_t current_backup_count) const {
     workspace->dists.clear();
 
     while (current_backup_count + workspace->dists.size() <
-                   workspace->backup_count_threshold &&
-           workspace->next_visit_coarse_list_idx < nlist) {
+           workspace->backup_count_threshold) {
+        if (workspace->next_visit_coarse_list_idx >= workspace->coarse_size &&
+            !order_iterator_next_lists(workspace)) {
+            break;
+        }
         auto next_list_idx = workspace->next_visit_coarse_list_idx;
         workspace->next_visit_coarse_list_idx++;
 
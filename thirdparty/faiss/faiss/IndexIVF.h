@@ -11,6 +11,7 @@
 #define FAISS_INDEX_IVF_H
 
 #include <stdint.h>
+#include <functional>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -70,6 +71,21 @@ struct Level1Quantizer {
     ~Level1Quantizer();
 };
 
+/// The vectors of each list that are accepted by the selector of a search,
+/// computed by the caller for selective filters.
+struct IVFListFilter {
+    /// per list, the number of accepted vectors. Lists without any are
+    /// skipped and don't count as probes
+    std::vector<size_t> valid_counts;
+    /// lists with a few accepted vectors are scanned by gathering them, their
+    /// offsets are offsets[lims[list_no]:lims[list_no + 1]]. The range is
+    /// empty for the other lists
+    std::vector<size_t> lims;
+    std::vector<size_t> offsets;
+};
+
+struct IndexIVFStats;
+
 struct SearchParametersIVF : SearchParameters {
     size_t nprobe = 1;    ///< number of probes at query time
     size_t max_codes = 0; ///< max nb of codes to visit to do a query
@@ -85,6 +101,28 @@ struct SearchParametersIVF : SearchParameters {
     ///< continuous buckets with no valid results, terminate range search
     size_t max_empty_result_buckets = 0;
 
+    /// adaptive nprobe: per list, the max distance between the centroid and
+    /// the vectors of the list. When set, probing stops once no remaining
+    /// list can hold a vector better than the current k-th result.
+    /// Supported for L2 and inner product, parallel_mode = 0 or 3.
+    const float* list_radii = nullptr;
+    /// scales the radii, values < 1 stop earlier at the cost of recall
+    float list_radius_scale = 1.0f;
+    /// the number of lists that are always probed with list_radii
+    size_t min_nprobe = 0;
+    /// if set, receives the number of probed lists per query. IndexIVF::search
+    /// processes the queries in a single slice then
+    size_t* nprobe_used = nullptr;
+
+    /// if set, the stats of the search are added to it as well as to
+    /// indexIVF_stats
+    IndexIVFStats* stats = nullptr;
+
+    /// if set, lists without accepted vectors are skipped, and the scan stops
+    /// after max_lists_num non-empty lists (or once the top-k is full with
+    /// ensure_topk_full). Supported for parallel_mode = 0 or 3
+    const IVFListFilter* list_filter = nullptr;
+
     SearchParameters* quantizer_params = nullptr;
 
     /// context object to pass to InvertedLists
@@ -114,6 +152,8 @@ struct IVFIteratorWorkspace {
             nullptr; // backup coarse centroids distances (heap)
     std::unique_ptr<idx_t[]> coarse_idx =
             nullptr; // backup coarse centroids ids (heap)
+    size_t coarse_size = 0;          // nb of centroids ordered so far
+    std::vector<bool> coarse_listed; // whether a centroid is ordered
     std::unique_ptr<size_t[]> coarse_list_sizes =
             nullptr; // snapshot of the list_size
     std::unique_ptr<DistanceComputer> dis_refine;
@@ -264,6 +304,11 @@ struct IndexIVF : Index, IndexIVFInterface {
             IVFIteratorWorkspace* workspace,
             size_t current_backup_count) const;
 
+    /// Orders the next centroids of an iterator by the distance to its query,
+    /// the nprobe closest ones first and twice as many on each call after.
+    /// Returns false if there is no more list to visit.
+    bool order_iterator_next_lists(IVFIteratorWorkspace* workspace) const;
+
     void reset() override;
 
     /// Trains the quantizer and calls train_encoder to train sub-quantizers
@@ -290,6 +335,24 @@ struct IndexIVF : Index, IndexIVFInterface {
             const idx_t* precomputed_idx,
             void* inverted_list_context = nullptr);
 
+    /// writes the code of vector i to code, scratch is a buffer of d floats
+    /// of the calling thread
+    using encode_one_t =
+            std::function<void(idx_t i, uint8_t* code, float* scratch)>;
+
+    /** Adds n vectors whose assignments are precomputed with a single
+     * add_entries() per list: the vectors are grouped by list, then the
+     * lists are appended to in parallel, each by a single thread. Appends to
+     * concurrent lists are thus neither serialized nor a scan of all the
+     * vectors per thread.
+     */
+    void add_core_by_list(
+            idx_t n,
+            const float* x_norms,
+            const idx_t* xids,
+            const idx_t* precomputed_idx,
+            const encode_one_t& encode);
+
     /** Encodes a set of vectors as they would appear in the inverted lists
      *
      * @param list_nos   inverted list ids as returned by the
@@ -1790,8 +1790,11 @@ void IndexIVFFastScan::get_interator_next_batch_implem_10(
         LUT = workspace->dis_tables.get();
     }
     while (current_backup_count + workspace->dists.size() <
-                   workspace->backup_count_threshold &&
-           workspace->next_visit_coarse_list_idx < nlist) {
+           workspace->backup_count_threshold) {
+        if (workspace->next_visit_coarse_list_idx >= workspace->coarse_size &&
+            !order_iterator_next_lists(workspace)) {
+            break;
+        }
         auto next_list_idx = workspace->next_visit_coarse_list_idx;
         workspace->next_visit_coarse_list_idx++;
         if (!single_LUT) {
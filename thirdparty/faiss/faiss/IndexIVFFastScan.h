@@ -56,6 +56,8 @@ struct IVFFastScanIteratorWorkspace : IVFIteratorWorkspace {
         this->backup_count_threshold = base_workspace->backup_count_threshold;
         this->coarse_dis = std::move(base_workspace->coarse_dis);
         this->coarse_idx = std::move(base_workspace->coarse_idx);
+        this->coarse_size = base_workspace->coarse_size;
+        this->coarse_listed = std::move(base_workspace->coarse_listed);
         this->coarse_list_sizes = std::move(base_workspace->coarse_list_sizes);
         base_workspace = nullptr;
         return;
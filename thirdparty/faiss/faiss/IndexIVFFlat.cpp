@@ -28,6 +28,7 @@
 #include <faiss/impl/FaissAssert.h>
 #include <faiss/utils/distances.h>
 #include <faiss/utils/distances_if.h>
+#include <faiss/utils/threshold_filter.h>
 #include <faiss/utils/utils.h>
 
 namespace faiss {
@@ -293,7 +294,10 @@ struct IVFFlatScanner : InvertedListScanner {
             size_t k,
             size_t& scan_cnt) const override {
         const float* list_vecs = (const float*)codes;
-        size_t nup = 0;
+        auto heap = make_threshold_filtered_heap<C>(
+                k, simi, idxi, [&](const size_t j) -> idx_t {
+                    return store_pairs ? lo_build(list_no, j) : ids[j];
+                });
 
         // the lambda that filters acceptable elements.
         auto filter =
@@ -304,11 +308,7 @@ struct IVFFlatScanner : InvertedListScanner {
             [&](const float dis_in, const size_t j) {
                 const float dis = (code_norms == nullptr) ? dis_in : (dis_in / code_norms[j]);
                 scan_cnt++;
-                if (C::cmp(simi[0], dis)) {
-                    const int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
-                    heap_replace_top<C>(k, simi, idxi, dis, id);
-                    nup++;
-                }
+                heap.add(dis, j);
             };
 
         if constexpr (metric == METRIC_INNER_PRODUCT) {
@@ -320,7 +320,7 @@ struct IVFFlatScanner : InvertedListScanner {
                 xi, list_vecs, d, list_size, filter, apply);
         }
 
-        return nup;
+        return heap.flush();
     }
 
     void scan_codes_and_return(
@@ -424,7 +424,10 @@ struct IVFFlatBitsetViewScanner : InvertedListScanner {
             size_t k,
             size_t& scan_cnt) const override {
         const float* list_vecs = (const float*)codes;
-        size_t nup = 0;
+        auto heap = make_threshold_filtered_heap<C>(
+                k, simi, idxi, [&](const size_t j) -> idx_t {
+                    return store_pairs ? lo_build(list_no, j) : ids[j];
+                });
 
         // the lambda that filters acceptable elements.
         auto filter =
@@ -435,11 +438,7 @@ struct IVFFlatBitsetViewScanner : InvertedListScanner {
             [&](const float dis_in, const size_t j) {
                 const float dis = (code_norms == nullptr) ? dis_in : (dis_in / code_norms[j]);
                 scan_cnt++;
-                if (C::cmp(simi[0], dis)) {
-                    const int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
-                    heap_replace_top<C>(k, simi, idxi, dis, id);
-                    nup++;
-                }
+                heap.add(dis, j);
             };
 
         if constexpr (metric == METRIC_INNER_PRODUCT) {
@@ -451,7 +450,7 @@ struct IVFFlatBitsetViewScanner : InvertedListScanner {
                 xi, list_vecs, d, list_size, filter, apply);
         }
 
-        return nup;
+        return heap.flush();
     }
 
     void scan_codes_and_return(
@@ -584,6 +583,19 @@ IndexIVFFlatCC::IndexIVFFlatCC(
 
 IndexIVFFlatCC::IndexIVFFlatCC() {}
 
+void IndexIVFFlatCC::add_core(
+        idx_t n,
+        const float* x,
+        const float* x_norms,
+        const idx_t* xids,
+        const idx_t* coarse_idx,
+        void* /* inverted_list_context */) {
+    add_core_by_list(
+            n, x_norms, xids, coarse_idx, [&](idx_t i, uint8_t* code, float*) {
+                memcpy(code, x + i * d, code_size);
+            });
+}
+
 /*****************************************
  * IndexIVFFlatDedup implementation
  ******************************************/
@@ -77,6 +77,15 @@ struct IndexIVFFlatCC : IndexIVFFlat {
             bool is_cosine = false);
 
     IndexIVFFlatCC();
+
+    /// appends to each list at once, see add_core_by_list
+    void add_core(
+            idx_t n,
+            const float* x,
+            const float* x_norms,
+            const idx_t* xids,
+            const idx_t* precomputed_idx,
+            void* inverted_list_context = nullptr) override;
 };
 
 struct IndexIVFFlatDedup : IndexIVFFlat {
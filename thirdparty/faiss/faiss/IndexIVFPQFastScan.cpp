@@ -9,12 +9,14 @@
 
 #include <cassert>
 #include <cinttypes>
+#include <cmath>
 #include <cstdio>
 
 #include <omp.h>
 
 #include <memory>
 
+#include <faiss/FaissHook.h>
 #include <faiss/impl/AuxIndexStructures.h>
 #include <faiss/impl/FaissAssert.h>
 #include <faiss/utils/distances.h>
@@ -37,6 +39,110 @@ inline size_t roundup(size_t a, size_t b) {
     return (a + b - 1) / b * b;
 }
 
+namespace {
+
+// max nb of passes over the sub-quantizers when refining a code
+constexpr int anisotropic_niter = 4;
+
+/* Refines the PQ codes of targets to minimize the anisotropic loss
+ *
+ *     ||e||^2 + (eta - 1) * <e, u>^2
+ *
+ * where e is the quantization error and u is the direction of the vector
+ * x, by coordinate descent over the sub-quantizers. The targets are the
+ * vectors themselves, or their residuals if the index encodes residuals. */
+void refine_codes_anisotropic(
+        const ProductQuantizer& pq,
+        idx_t n,
+        const float* x,
+        const float* targets,
+        float eta,
+        uint8_t* codes) {
+    const size_t d = pq.d;
+    const size_t dsub = pq.dsub;
+
+#pragma omp parallel if (n > 1000)
+    {
+        std::vector<float> err(d);
+        std::vector<float> dir(d);
+        std::vector<uint64_t> assign(pq.M);
+
+#pragma omp for
+        for (idx_t i = 0; i < n; i++) {
+            const float* xi = x + i * d;
+            const float* ti = targets + i * d;
+            uint8_t* code = codes + i * pq.code_size;
+
+            const float norm = std::sqrt(fvec_norm_L2sqr(xi, d));
+            if (norm == 0) {
+                continue;
+            }
+            for (size_t j = 0; j < d; j++) {
+                dir[j] = xi[j] / norm;
+            }
+
+            PQDecoderGeneric decoder(code, pq.nbits);
+            for (size_t m = 0; m < pq.M; m++) {
+                assign[m] = decoder.decode();
+                const float* c = pq.get_centroids(m, assign[m]);
+                for (size_t j = 0; j < dsub; j++) {
+                    err[m * dsub + j] = ti[m * dsub + j] - c[j];
+                }
+            }
+            float err_sqr = fvec_norm_L2sqr(err.data(), d);
+            float err_par = fvec_inner_product(err.data(), dir.data(), d);
+
+            for (int iter = 0; iter < anisotropic_niter; iter++) {
+                bool changed = false;
+                for (size_t m = 0; m < pq.M; m++) {
+                    const float* tm = ti + m * dsub;
+                    const float* um = dir.data() + m * dsub;
+                    float* em = err.data() + m * dsub;
+
+                    // the loss terms without sub-vector m
+                    const float rest_sqr = err_sqr - fvec_norm_L2sqr(em, dsub);
+                    const float rest_par =
+                            err_par - fvec_inner_product(em, um, dsub);
+                    const float tm_par = fvec_inner_product(tm, um, dsub);
+
+                    uint64_t best = assign[m];
+                    float best_loss = HUGE_VALF;
+                    for (size_t k = 0; k < pq.ksub; k++) {
+                        const float* c = pq.get_centroids(m, k);
+                        const float c_par = fvec_inner_product(c, um, dsub);
+                        const float par = rest_par + tm_par - c_par;
+                        const float loss = fvec_L2sqr(tm, c, dsub) +
+                                (eta - 1) * par * par;
+                        if (loss < best_loss) {
+                            best_loss = loss;
+                            best = k;
+                        }
+                    }
+
+                    changed |= (best != assign[m]);
+                    assign[m] = best;
+                    const float* c = pq.get_centroids(m, best);
+                    for (size_t j = 0; j < dsub; j++) {
+                        em[j] = tm[j] - c[j];
+                    }
+                    err_sqr = rest_sqr + fvec_norm_L2sqr(em, dsub);
+                    err_par = rest_par + fvec_inner_product(em, um, dsub);
+                }
+                if (!changed) {
+                    break;
+                }
+            }
+
+            PQEncoderGeneric encoder(code, pq.nbits);
+            for (size_t m = 0; m < pq.M; m++) {
+                encoder.encode(assign[m]);
+            }
+        }
+    }
+}
+
+} // namespace
+
 IndexIVFPQFastScan::IndexIVFPQFastScan(
         Index* quantizer,
         size_t d,
@@ -168,8 +274,15 @@ void IndexIVFPQFastScan::encode_vectors(
             }
         }
         pq.compute_codes(residuals.data(), codes, n);
+        if (anisotropic_threshold > 0 && metric_type == METRIC_INNER_PRODUCT) {
+            refine_codes_anisotropic(
+                    pq, n, x, residuals.data(), anisotropic_eta(), codes);
+        }
     } else {
         pq.compute_codes(x, codes, n);
+        if (anisotropic_threshold > 0 && metric_type == METRIC_INNER_PRODUCT) {
+            refine_codes_anisotropic(pq, n, x, x, anisotropic_eta(), codes);
+        }
     }
 
     if (include_listnos) {
@@ -182,6 +295,11 @@ void IndexIVFPQFastScan::encode_vectors(
     }
 }
 
+float IndexIVFPQFastScan::anisotropic_eta() const {
+    const float t = std::min(anisotropic_threshold, 0.999f);
+    return (d - 1) * t * t / (1 - t * t);
+}
+
 /*********************************************************
  * Look-Up Table functions
  *********************************************************/
@@ -40,6 +40,13 @@ struct IndexIVFPQFastScan : IndexIVFFastScan {
     /// if use_precompute_table size (nlist, pq.M, pq.ksub)
     AlignedTable<float> precomputed_table;
 
+    /// if > 0, the codes of inner product indexes minimize the anisotropic
+    /// loss of ScaNN instead of the reconstruction error: an error parallel
+    /// to a vector costs (d - 1) * t^2 / (1 - t^2) times more than an
+    /// orthogonal one, t being this threshold relative to the norm of the
+    /// vector. It only affects the encoding and is not serialized.
+    float anisotropic_threshold = 0;
+
     // todo agzuhva: add back cosine support from knowhere
     IndexIVFPQFastScan(
             Index* quantizer,
@@ -72,6 +79,9 @@ struct IndexIVFPQFastScan : IndexIVFFastScan {
     /// build precomputed table, possibly updating use_precomputed_table
     void precompute_table();
 
+    /// the weight of parallel errors relative to orthogonal ones
+    float anisotropic_eta() const;
+
     /// same as the regular IVFPQ encoder. The codes are not reorganized by
     /// blocks a that point
     void encode_vectors(
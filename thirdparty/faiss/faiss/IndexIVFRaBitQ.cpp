@@ -9,6 +9,7 @@
 
 #include <faiss/impl/FaissAssert.h>
 #include <faiss/impl/RaBitQuantizer.h>
+#include <faiss/utils/Heap.h>
 #include <faiss/utils/distances_if.h>
 
 namespace faiss {
@@ -17,8 +18,10 @@ IndexIVFRaBitQ::IndexIVFRaBitQ(
         Index* quantizer,
         const size_t d,
         const size_t nlist,
-        MetricType metric)
-        : IndexIVF(quantizer, d, nlist, 0, metric), rabitq(d, metric) {
+        MetricType metric,
+        const size_t nb_bits)
+        : IndexIVF(quantizer, d, nlist, 0, metric),
+          rabitq(d, metric, nb_bits) {
     code_size = rabitq.code_size;
     invlists->code_size = code_size;
     is_trained = false;
@@ -122,7 +125,7 @@ struct RaBitInvertedListScanner : InvertedListScanner {
     std::vector<float> reconstructed_centroid;
     std::vector<float> query_vector;
 
-    std::unique_ptr<FlatCodesDistanceComputer> dc;
+    std::unique_ptr<RaBitQDistanceComputer> dc;
 
     uint8_t qb = 0;
 
@@ -161,6 +164,62 @@ struct RaBitInvertedListScanner : InvertedListScanner {
         return dc->distance_to_code(code);
     }
 
+    // the extended codes are read only for the candidates whose 1-bit
+    //   estimate is within its error bound of the heap top
+    size_t scan_codes(
+            size_t list_size,
+            const uint8_t* codes,
+            const float* code_norms,
+            const idx_t* ids,
+            float* simi,
+            idx_t* idxi,
+            size_t k,
+            size_t& scan_cnt) const override {
+        if (ivf_rabitq.rabitq.nb_bits <= 1) {
+            return InvertedListScanner::scan_codes(
+                    list_size,
+                    codes,
+                    code_norms,
+                    ids,
+                    simi,
+                    idxi,
+                    k,
+                    scan_cnt);
+        }
+
+        size_t nup = 0;
+        for (size_t j = 0; j < list_size; j++, codes += code_size) {
+            if (sel != nullptr) {
+                int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
+                if (!sel->is_member(id)) {
+                    continue;
+                }
+            }
+
+            scan_cnt++;
+            const float inv_norm =
+                    (code_norms == nullptr) ? 1.0f : (1.0f / code_norms[j]);
+            const float est = dc->distance_to_code_1bit(codes) * inv_norm;
+            const float bound = dc->error_bound(codes) * inv_norm;
+            if (keep_max ? (est + bound <= simi[0])
+                         : (est - bound >= simi[0])) {
+                continue;
+            }
+
+            const float dis = dc->distance_to_code(codes) * inv_norm;
+            if (keep_max ? (dis > simi[0]) : (dis < simi[0])) {
+                int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
+                if (keep_max) {
+                    minheap_replace_top(k, simi, idxi, dis, id);
+                } else {
+                    maxheap_replace_top(k, simi, idxi, dis, id);
+                }
+                nup++;
+            }
+        }
+        return nup;
+    }
+
     void internal_try_setup_dc() {
         if (!query_vector.empty() && !reconstructed_centroid.empty()) {
             // both query_vector and centroid are available!
@@ -270,7 +329,7 @@ float IVFRaBitDistanceComputer::operator()(idx_t i) {
     // compute the distance
     float distance = 0;
 
-    std::unique_ptr<FlatCodesDistanceComputer> dc(
+    std::unique_ptr<RaBitQDistanceComputer> dc(
             parent->rabitq.get_distance_computer(parent->qb, centroid.data()));
     dc->set_query(q);
     distance = dc->distance_to_code(code);
@@ -59,48 +59,28 @@ void IndexIVFScalarQuantizerCC::add_core(
         base_x = x_normalized.get();
     }
 
-    size_t nadd = 0;
     std::unique_ptr<ScalarQuantizer::SQuantizer> squant(sq.select_quantizer());
 
-    DirectMapAdd dm_add(direct_map, n, xids);
-
-#pragma omp parallel reduction(+ : nadd)
-    {
-        std::vector<float> residual(d);
-        std::vector<uint8_t> one_code(code_size);
-        int nt = omp_get_num_threads();
-        int rank = omp_get_thread_num();
-
-        // each thread takes care of a subset of lists
-        for (size_t i = 0; i < n; i++) {
-            int64_t list_no = coarse_idx[i];
-            if (list_no >= 0 && list_no % nt == rank) {
-                int64_t id = xids ? xids[i] : ntotal + i;
+    // the backup is read by id, so it is appended in the order of the ids
+    if (raw_data_backup_ != nullptr) {
+        for (idx_t i = 0; i < n; i++) {
+            raw_data_backup_->AppendDataBlock((const char*)(x + i * d));
+        }
+    }
 
+    add_core_by_list(
+            n,
+            nullptr,
+            xids,
+            coarse_idx,
+            [&](idx_t i, uint8_t* code, float* residual) {
                 const float* xi = base_x + i * d;
                 if (by_residual) {
-                    quantizer->compute_residual(xi, residual.data(), list_no);
-                    xi = residual.data();
+                    quantizer->compute_residual(xi, residual, coarse_idx[i]);
+                    xi = residual;
                 }
-
-                memset(one_code.data(), 0, code_size);
-                squant->encode_vector(xi, one_code.data());
-
-                size_t ofs = invlists->add_entry(
-                        list_no, id, one_code.data(), nullptr, inverted_list_context);
-
-                dm_add.add(i, list_no, ofs);
-                if (raw_data_backup_ != nullptr) {
-                    raw_data_backup_->AppendDataBlock((char*)(x + i * d));
-                }
-                nadd++;
-
-            } else if (rank == 0 && list_no == -1) {
-                dm_add.add(i, -1, 0);
-            }
-        }
-    }
-    ntotal += n;
+                squant->encode_vector(xi, code);
+            });
 }
 
 void IndexIVFScalarQuantizerCC::add_with_ids(
@@ -14,10 +14,13 @@
 
 #include <omp.h>
 
+#include <faiss/FaissHook.h>
 #include <faiss/impl/AuxIndexStructures.h>
+#include <faiss/impl/CodePacker.h>
 #include <faiss/impl/FaissAssert.h>
 #include <faiss/impl/IDSelector.h>
 #include <faiss/impl/ScalarQuantizer.h>
+#include <faiss/invlists/BlockInvertedLists.h>
 #include <faiss/utils/utils.h>
 
 namespace faiss {
@@ -100,6 +103,18 @@ FlatCodesDistanceComputer* IndexScalarQuantizer::get_FlatCodesDistanceComputer()
     return dc;
 }
 
+FlatCodesDistanceComputer* IndexScalarQuantizer::
+        get_half_precision_distance_computer() const {
+    ScalarQuantizer::SQDistanceComputer* dc =
+            sq.get_half_precision_distance_computer(metric_type);
+    if (dc == nullptr) {
+        return nullptr;
+    }
+    dc->code_size = sq.code_size;
+    dc->codes = codes.data();
+    return dc;
+}
+
 /* Codec interface */
 
 void IndexScalarQuantizer::sa_encode(idx_t n, const float* x, uint8_t* bytes)
@@ -220,6 +235,8 @@ void IndexIVFScalarQuantizer::add_core(
     FAISS_THROW_IF_NOT(is_trained);
 
     std::unique_ptr<ScalarQuantizer::SQuantizer> squant(sq.select_quantizer());
+    std::unique_ptr<CodePacker> packer(
+            interleaved_nvec() > 0 ? get_CodePacker() : nullptr);
 
     DirectMapAdd dm_add(direct_map, n, xids);
 
@@ -227,6 +244,8 @@ void IndexIVFScalarQuantizer::add_core(
     {
         std::vector<float> residual(d);
         std::vector<uint8_t> one_code(code_size);
+        // the code packed at the start of a block for interleaved lists
+        std::vector<uint8_t> one_block(packer ? packer->block_size : 0);
         int nt = omp_get_num_threads();
         int rank = omp_get_thread_num();
 
@@ -244,9 +263,15 @@ void IndexIVFScalarQuantizer::add_core(
 
                 memset(one_code.data(), 0, code_size);
                 squant->encode_vector(xi, one_code.data());
+                const uint8_t* code = one_code.data();
+                if (packer) {
+                    memset(one_block.data(), 0, one_block.size());
+                    packer->pack_1(code, 0, one_block.data());
+                    code = one_block.data();
+                }
 
                 size_t ofs = invlists->add_entry(
-                        list_no, id, one_code.data(), nullptr, inverted_list_context);
+                        list_no, id, code, nullptr, inverted_list_context);
 
                 dm_add.add(i, list_no, ofs);
 
@@ -263,15 +288,67 @@ InvertedListScanner* IndexIVFScalarQuantizer::get_InvertedListScanner(
         bool store_pairs,
         const IDSelector* sel,
         const IVFSearchParameters*) const {
+    const size_t nvec = interleaved_nvec();
+    if (nvec > 0) {
+        return sq_sel_interleaved_scanner(
+                metric_type,
+                &sq,
+                quantizer,
+                nvec,
+                store_pairs,
+                sel,
+                by_residual);
+    }
     return sq.select_InvertedListScanner(
             metric_type, quantizer, store_pairs, sel, by_residual);
 }
 
+void IndexIVFScalarQuantizer::set_interleaved(size_t nvec) {
+    FAISS_THROW_IF_NOT_MSG(
+            nvec == 16 || nvec == 32, "interleaved blocks of 16 or 32 only");
+    FAISS_THROW_IF_NOT_MSG(
+            sq.qtype == ScalarQuantizer::QT_8bit ||
+                    sq.qtype == ScalarQuantizer::QT_8bit_uniform ||
+                    sq.qtype == ScalarQuantizer::QT_4bit ||
+                    sq.qtype == ScalarQuantizer::QT_4bit_uniform,
+            "interleaved codes support 8-bit and 4-bit quantizers only");
+    FAISS_THROW_IF_NOT_MSG(
+            ntotal == 0 && invlists->compute_ntotal() == 0,
+            "the lists must be empty");
+    replace_invlists(
+            new BlockInvertedLists(
+                    nlist, new CodePackerInterleaved(code_size, nvec)),
+            true);
+}
+
+size_t IndexIVFScalarQuantizer::interleaved_nvec() const {
+    const auto* bil = dynamic_cast<const BlockInvertedLists*>(invlists);
+    return bil != nullptr ? bil->n_per_block : 0;
+}
+
+CodePacker* IndexIVFScalarQuantizer::get_CodePacker() const {
+    const size_t nvec = interleaved_nvec();
+    if (nvec > 0) {
+        return new CodePackerInterleaved(code_size, nvec);
+    }
+    return IndexIVF::get_CodePacker();
+}
+
 void IndexIVFScalarQuantizer::reconstruct_from_offset(
         int64_t list_no,
         int64_t offset,
         float* recons) const {
-    const uint8_t* code = invlists->get_single_code(list_no, offset);
+    std::vector<uint8_t> unpacked;
+    const uint8_t* code = nullptr;
+    if (interleaved_nvec() > 0) {
+        unpacked.resize(code_size);
+        std::unique_ptr<CodePacker> packer(get_CodePacker());
+        packer->unpack_1(
+                invlists->get_codes(list_no), offset, unpacked.data());
+        code = unpacked.data();
+    } else {
+        code = invlists->get_single_code(list_no, offset);
+    }
 
     if (by_residual) {
         std::vector<float> centroid(d);
@@ -52,6 +52,9 @@ struct IndexScalarQuantizer : IndexFlatCodes {
 
     FlatCodesDistanceComputer* get_FlatCodesDistanceComputer() const override;
 
+    /// see ScalarQuantizer::get_half_precision_distance_computer()
+    FlatCodesDistanceComputer* get_half_precision_distance_computer() const;
+
     /* standalone codec interface */
     void sa_encode(idx_t n, const float* x, uint8_t* bytes) const override;
 
@@ -108,6 +111,17 @@ struct IndexIVFScalarQuantizer : IndexIVF {
 
     /* standalone codec interface */
     void sa_decode(idx_t n, const uint8_t* bytes, float* x) const override;
+
+    /** store the codes of the lists interleaved by blocks of nvec (16 or 32)
+     * vectors, see CodePackerInterleaved, so that a query is scored against a
+     * whole block at once. 8-bit and 4-bit quantizers only, the lists must be
+     * empty. The lists become BlockInvertedLists. */
+    void set_interleaved(size_t nvec);
+
+    /// nb of vectors per interleaved block, 0 if the codes are row-major
+    size_t interleaved_nvec() const;
+
+    CodePacker* get_CodePacker() const override;
 };
 
 } // namespace faiss
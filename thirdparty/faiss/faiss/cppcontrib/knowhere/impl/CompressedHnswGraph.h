@@ -0,0 +1,242 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <faiss/impl/FaissAssert.h>
+#include <faiss/impl/HNSW.h>
+#include <faiss/utils/prefetch.h>
+
+namespace faiss {
+namespace cppcontrib {
+namespace knowhere {
+
+// A compact replacement for faiss::HNSW::neighbors.
+// * Level-0 neighbor lists are sorted and stored as deltas between
+//   consecutive ids. All deltas of a single list are bit-packed with the
+//   same bit width, so a list is decoded with a branchless loop that
+//   compilers vectorize.
+// * Neighbor lists of upper levels are kept as is, because they are
+//   small. Their layout is the same as in faiss::HNSW::neighbors, just
+//   without level-0 slots, so faiss::HNSW::offsets can still be used.
+// The order of level-0 neighbors is not preserved, which does not matter
+//   for the search.
+struct CompressedHnswGraph {
+    using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+    // level-0 lists, per node: the position of the first packed delta
+    //   (in bits) in l0_words
+    std::vector<uint64_t> l0_bit_offsets;
+    // level-0 lists, per node: the smallest neighbor id
+    std::vector<storage_idx_t> l0_first_ids;
+    // level-0 lists, per node: (the number of neighbors << 8) | bit width
+    std::vector<uint32_t> l0_meta;
+    // packed deltas, padded with an extra word for branchless decoding
+    std::vector<uint32_t> l0_words;
+
+    // the number of level-0 slots per node in the original graph
+    size_t nb_neighbors_0 = 0;
+
+    // neighbor lists of the upper levels
+    std::vector<storage_idx_t> upper_neighbors;
+
+    // compress the graph. hnsw.neighbors is left untouched.
+    static CompressedHnswGraph build(const faiss::HNSW& hnsw) {
+        CompressedHnswGraph graph;
+
+        const size_t ntotal = hnsw.levels.size();
+        graph.nb_neighbors_0 = hnsw.nb_neighbors(0);
+
+        graph.l0_bit_offsets.resize(ntotal);
+        graph.l0_first_ids.resize(ntotal);
+        graph.l0_meta.resize(ntotal);
+
+        std::vector<storage_idx_t> sorted;
+        sorted.reserve(graph.nb_neighbors_0);
+
+        uint64_t bit_offset = 0;
+        for (size_t i = 0; i < ntotal; i++) {
+            size_t begin = 0;
+            size_t end = 0;
+            hnsw.neighbor_range(i, 0, &begin, &end);
+
+            sorted.clear();
+            for (size_t j = begin; j < end; j++) {
+                if (hnsw.neighbors[j] < 0) {
+                    break;
+                }
+                sorted.push_back(hnsw.neighbors[j]);
+            }
+            std::sort(sorted.begin(), sorted.end());
+
+            // the widest delta defines the bit width of the list
+            uint32_t max_delta = 0;
+            for (size_t j = 1; j < sorted.size(); j++) {
+                max_delta = std::max<uint32_t>(
+                        max_delta, sorted[j] - sorted[j - 1]);
+            }
+            uint32_t width = 0;
+            while (width < 32 && (max_delta >> width) != 0) {
+                width += 1;
+            }
+
+            graph.l0_bit_offsets[i] = bit_offset;
+            graph.l0_first_ids[i] = sorted.empty() ? -1 : sorted[0];
+            graph.l0_meta[i] = ((uint32_t)sorted.size() << 8) | width;
+
+            for (size_t j = 1; j < sorted.size(); j++) {
+                graph.append_bits(
+                        bit_offset, sorted[j] - sorted[j - 1], width);
+                bit_offset += width;
+            }
+        }
+
+        // padding for 64-bit reads of the last word
+        graph.l0_words.resize((bit_offset + 31) / 32 + 2, 0);
+
+        // upper levels
+        const size_t nb_slots = hnsw.neighbors.size();
+        FAISS_THROW_IF_NOT(nb_slots >= ntotal * graph.nb_neighbors_0);
+        graph.upper_neighbors.reserve(
+                nb_slots - ntotal * graph.nb_neighbors_0);
+        for (size_t i = 0; i < ntotal; i++) {
+            const size_t begin = hnsw.offsets[i] + graph.nb_neighbors_0;
+            const size_t end = hnsw.offsets[i + 1];
+            for (size_t j = begin; j < end; j++) {
+                graph.upper_neighbors.push_back(hnsw.neighbors[j]);
+            }
+        }
+
+        return graph;
+    }
+
+    // restore hnsw.neighbors from the compressed graph
+    void decompress_into(faiss::HNSW& hnsw) const {
+        const size_t ntotal = hnsw.levels.size();
+        hnsw.neighbors =
+                MaybeOwnedVector<storage_idx_t>(hnsw.offsets[ntotal]);
+
+        std::vector<storage_idx_t> decoded(nb_neighbors_0);
+        for (size_t i = 0; i < ntotal; i++) {
+            const size_t count = decode_level_0(i, decoded.data());
+
+            const size_t offset = hnsw.offsets[i];
+            for (size_t j = 0; j < nb_neighbors_0; j++) {
+                hnsw.neighbors[offset + j] = (j < count) ? decoded[j] : -1;
+            }
+
+            size_t upper_begin = 0;
+            size_t upper_end = 0;
+            upper_neighbor_range(hnsw, i, 1, &upper_begin, &upper_end);
+            const size_t upper_size =
+                    hnsw.offsets[i + 1] - hnsw.offsets[i] - nb_neighbors_0;
+            for (size_t j = 0; j < upper_size; j++) {
+                hnsw.neighbors[offset + nb_neighbors_0 + j] =
+                        upper_neighbors[upper_begin + j];
+            }
+        }
+    }
+
+    // decode level-0 neighbors of a node into 'out', which must be able to
+    //   hold nb_neighbors_0 elements. Returns the number of neighbors.
+    inline size_t decode_level_0(
+            const storage_idx_t node_id,
+            storage_idx_t* __restrict out) const {
+        const uint32_t meta = l0_meta[node_id];
+        const size_t count = meta >> 8;
+        const uint32_t width = meta & 0xFF;
+        if (count == 0) {
+            return 0;
+        }
+
+        const uint64_t mask = (width == 32) ? 0xFFFFFFFFULL
+                                            : ((1ULL << width) - 1);
+        const uint64_t bit_offset = l0_bit_offsets[node_id];
+
+        // unpack the deltas
+        for (size_t j = 1; j < count; j++) {
+            const uint64_t pos = bit_offset + (j - 1) * width;
+            const size_t word = pos >> 5;
+            const uint64_t bits = (uint64_t)l0_words[word] |
+                    ((uint64_t)l0_words[word + 1] << 32);
+            out[j] = (storage_idx_t)((bits >> (pos & 31)) & mask);
+        }
+
+        // restore the ids
+        out[0] = l0_first_ids[node_id];
+        for (size_t j = 1; j < count; j++) {
+            out[j] += out[j - 1];
+        }
+
+        return count;
+    }
+
+    // the same as faiss::HNSW::neighbor_range() for levels above 0,
+    //   the range refers to upper_neighbors
+    inline void upper_neighbor_range(
+            const faiss::HNSW& hnsw,
+            const storage_idx_t node_id,
+            const int level,
+            size_t* begin,
+            size_t* end) const {
+        // every node before node_id occupies nb_neighbors_0 level-0 slots
+        const size_t o =
+                hnsw.offsets[node_id] - (size_t)node_id * nb_neighbors_0;
+        *begin = o + hnsw.cum_nb_neighbors(level) - nb_neighbors_0;
+        *end = o + hnsw.cum_nb_neighbors(level + 1) - nb_neighbors_0;
+    }
+
+    // prefetch a packed level-0 list of a node
+    inline void prefetch_level_0(const storage_idx_t node_id) const {
+        prefetch_L2(l0_words.data() + (l0_bit_offsets[node_id] >> 5));
+    }
+
+    // the number of bytes used
+    size_t size_in_bytes() const {
+        return l0_bit_offsets.size() * sizeof(uint64_t) +
+                l0_first_ids.size() * sizeof(storage_idx_t) +
+                l0_meta.size() * sizeof(uint32_t) +
+                l0_words.size() * sizeof(uint32_t) +
+                upper_neighbors.size() * sizeof(storage_idx_t);
+    }
+
+   private:
+    void append_bits(
+            const uint64_t bit_offset,
+            const uint32_t value,
+            const uint32_t width) {
+        if (width == 0) {
+            return;
+        }
+
+        const size_t word = bit_offset >> 5;
+        const uint32_t shift = bit_offset & 31;
+        if (l0_words.size() < word + 2) {
+            l0_words.resize(word + 2, 0);
+        }
+
+        const uint64_t bits = (uint64_t)value << shift;
+        l0_words[word] |= (uint32_t)bits;
+        l0_words[word + 1] |= (uint32_t)(bits >> 32);
+    }
+};
+
+} // namespace knowhere
+} // namespace cppcontrib
+} // namespace faiss
@@ -0,0 +1,241 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <faiss/FaissHook.h>
+#include <faiss/IndexCosine.h>
+#include <faiss/IndexPQ.h>
+#include <faiss/MetricType.h>
+#include <faiss/impl/FaissAssert.h>
+#include <faiss/impl/HNSW.h>
+#include <faiss/impl/pq4_fast_scan.h>
+#include <faiss/impl/simd_result_handlers.h>
+#include <faiss/utils/AlignedTable.h>
+#include <faiss/utils/quantize_lut.h>
+
+namespace faiss {
+namespace cppcontrib {
+namespace knowhere {
+
+// 4-bit PQ codes of the level-0 neighbors of every node, in the blocked
+//   layout of the fast-scan kernels (see pq4_fast_scan.h). All neighbors of
+//   a node are scored with a single pq4_accumulate_loop() call, which looks
+//   the distances up with SIMD shuffles instead of one table access per
+//   subquantizer and per neighbor.
+// Slot j of the block of a node holds the code of hnsw.neighbors at
+//   hnsw.offsets[node] + j, so the codes are valid only as long as the
+//   level-0 lists are not modified. Unused slots hold zero codes.
+struct HnswNeighborCodes {
+    using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+    // the size of a block of the fast-scan kernel
+    static constexpr size_t kBlockSize = 32;
+    // the quantized distances are accumulated as uint16
+    static constexpr size_t kMaxSubquantizers = 256;
+
+    // the storage the codes are taken from, not owned
+    const faiss::IndexPQ* storage = nullptr;
+
+    // the number of level-0 slots per node, and it rounded up to kBlockSize
+    size_t nb_neighbors_0 = 0;
+    size_t nb_padded = 0;
+    // the number of subquantizers, and it rounded up to 2
+    size_t M = 0;
+    size_t M2 = 0;
+    // the bytes of a block of a node
+    size_t block_bytes = 0;
+
+    // the blocks of all nodes
+    faiss::AlignedTable<uint8_t> blocks;
+    // the inverse L2 norms of the neighbors in every slot for cosine
+    //   storages, empty otherwise
+    std::vector<float> inverse_norms;
+
+    // whether the codes of a storage can be laid out for the fast-scan
+    static bool is_supported(const faiss::Index* storage) {
+        const auto* index_pq = dynamic_cast<const faiss::IndexPQ*>(storage);
+        return index_pq != nullptr && index_pq->pq.nbits == 4 &&
+                index_pq->pq.M <= kMaxSubquantizers;
+    }
+
+    // gather the codes of the level-0 neighbors of every node
+    static HnswNeighborCodes build(
+            const faiss::HNSW& hnsw,
+            const faiss::IndexPQ& storage) {
+        FAISS_THROW_IF_NOT(is_supported(&storage));
+
+        HnswNeighborCodes codes;
+        codes.storage = &storage;
+
+        const size_t ntotal = hnsw.levels.size();
+        codes.nb_neighbors_0 = hnsw.nb_neighbors(0);
+        codes.nb_padded = (codes.nb_neighbors_0 + kBlockSize - 1) /
+                kBlockSize * kBlockSize;
+        codes.M = storage.pq.M;
+        codes.M2 = (codes.M + 1) / 2 * 2;
+        codes.block_bytes = codes.nb_padded * codes.M2 / 2;
+        codes.blocks.resize(ntotal * codes.block_bytes);
+
+        const auto* norms =
+                dynamic_cast<const faiss::HasInverseL2Norms*>(&storage);
+        if (norms != nullptr) {
+            codes.inverse_norms.resize(ntotal * codes.nb_neighbors_0, 0.0f);
+        }
+
+        const size_t code_size = storage.code_size;
+        std::vector<uint8_t> flat(codes.nb_neighbors_0 * code_size);
+        for (size_t i = 0; i < ntotal; i++) {
+            size_t begin = 0;
+            size_t end = 0;
+            hnsw.neighbor_range(i, 0, &begin, &end);
+
+            std::fill(flat.begin(), flat.end(), 0);
+            for (size_t j = begin; j < end; j++) {
+                const storage_idx_t v = hnsw.neighbors[j];
+                if (v < 0) {
+                    break;
+                }
+                std::memcpy(
+                        flat.data() + (j - begin) * code_size,
+                        storage.codes.data() + (size_t)v * code_size,
+                        code_size);
+                if (norms != nullptr) {
+                    codes.inverse_norms[i * codes.nb_neighbors_0 + j - begin] =
+                            norms->get_inverse_l2_norms()[v];
+                }
+            }
+
+            faiss::pq4_pack_codes(
+                    flat.data(),
+                    codes.nb_neighbors_0,
+                    codes.M,
+                    codes.nb_padded,
+                    kBlockSize,
+                    codes.M2,
+                    codes.blocks.get() + i * codes.block_bytes);
+        }
+
+        return codes;
+    }
+
+    inline const uint8_t* node_block(const storage_idx_t node_id) const {
+        return blocks.get() + (size_t)node_id * block_bytes;
+    }
+
+    size_t size_in_bytes() const {
+        return blocks.size() + inverse_norms.size() * sizeof(float);
+    }
+};
+
+// Scores the level-0 neighbors of a node against a query with
+//   HnswNeighborCodes. The distances follow the convention of the HNSW
+//   search: smaller is better, so similarities are negated.
+// The distance tables are quantized to 8 bits, so the distances are
+//   approximations of the PQ ones.
+struct HnswNeighborScanner {
+    const HnswNeighborCodes& codes;
+
+    // the packed quantized distance tables of the query
+    faiss::AlignedTable<uint8_t> lut;
+    // the raw accumulated distances of the slots of a node
+    faiss::AlignedTable<uint16_t> raw;
+    // the distances of the slots of the last scanned node
+    std::vector<float> dis;
+    // raw distances are converted with dis = (b + raw / a) * query_scale
+    float a = 1.0f;
+    float b = 0.0f;
+    // the inverse L2 norm of the query for cosine storages, 1 otherwise
+    float query_scale = 1.0f;
+
+    std::vector<float> float_tables;
+    std::vector<uint8_t> quantized_tables;
+
+    explicit HnswNeighborScanner(const HnswNeighborCodes& codes_)
+            : codes{codes_},
+              lut(codes_.M2 * 16),
+              raw(codes_.nb_padded),
+              dis(codes_.nb_neighbors_0),
+              float_tables(codes_.M * 16),
+              quantized_tables(codes_.M2 * 16, 0) {}
+
+    void set_query(const float* x) {
+        const faiss::ProductQuantizer& pq = codes.storage->pq;
+        if (codes.storage->metric_type == faiss::METRIC_L2) {
+            pq.compute_distance_table(x, float_tables.data());
+        } else {
+            pq.compute_inner_prod_table(x, float_tables.data());
+            for (auto& v : float_tables) {
+                v = -v;
+            }
+        }
+
+        faiss::quantize_lut::round_uint8_per_column(
+                float_tables.data(), codes.M, 16, &a, &b);
+        for (size_t j = 0; j < codes.M * 16; j++) {
+            quantized_tables[j] = (uint8_t)float_tables[j];
+        }
+        faiss::pq4_pack_LUT(1, codes.M2, quantized_tables.data(), lut.get());
+
+        // the same as WithCosineNormDistanceComputer
+        query_scale = 1.0f;
+        if (!codes.inverse_norms.empty()) {
+            const float query_l2norm =
+                    faiss::fvec_norm_L2sqr(x, codes.storage->d);
+            query_scale =
+                    (query_l2norm <= 0) ? 1.0f : (1.0f / sqrtf(query_l2norm));
+        }
+    }
+
+    // the distances to the hnsw.neighbors slots of the level 0 of a node,
+    //   the values in the unused slots are meaningless
+    const float* scan(const HnswNeighborCodes::storage_idx_t node_id) {
+        faiss::simd_result_handlers::StoreResultHandler handler(
+                raw.get(), codes.nb_padded);
+        faiss::pq4_accumulate_loop(
+                1,
+                codes.nb_padded,
+                HnswNeighborCodes::kBlockSize,
+                codes.M2,
+                codes.node_block(node_id),
+                lut.get(),
+                handler,
+                nullptr);
+
+        const float one_a = query_scale / a;
+        const float b_scaled = b * query_scale;
+        for (size_t j = 0; j < codes.nb_neighbors_0; j++) {
+            dis[j] = b_scaled + raw[j] * one_a;
+        }
+        if (!codes.inverse_norms.empty()) {
+            const float* norms = codes.inverse_norms.data() +
+                    (size_t)node_id * codes.nb_neighbors_0;
+            for (size_t j = 0; j < codes.nb_neighbors_0; j++) {
+                dis[j] *= norms[j];
+            }
+        }
+        return dis.data();
+    }
+};
+
+} // namespace knowhere
+} // namespace cppcontrib
+} // namespace faiss
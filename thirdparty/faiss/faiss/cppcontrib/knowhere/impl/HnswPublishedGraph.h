@@ -0,0 +1,83 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <faiss/impl/HNSW.h>
+
+namespace faiss {
+namespace cppcontrib {
+namespace knowhere {
+
+// The part of an HNSW graph that a search is allowed to see while new nodes
+//   are being linked into the graph.
+// * nodes with ids >= ntotal are skipped, even if they are already
+//   referenced by neighbor lists of the visible nodes.
+// * the search starts from entry_point on max_level instead of
+//   hnsw.entry_point and hnsw.max_level, which are updated by the insertion.
+struct HnswPublishedGraph {
+    using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+    storage_idx_t ntotal = 0;
+    storage_idx_t entry_point = -1;
+    int max_level = -1;
+};
+
+// Publishes HnswPublishedGraph snapshots of a growing graph.
+// The number of nodes and the entry point are packed into a single word, so
+//   a reader never combines them from different versions of the graph.
+class HnswGraphPublisher {
+   public:
+    using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+    // makes all the nodes that are linked into hnsw visible
+    void publish(const faiss::HNSW& hnsw, const size_t ntotal) {
+        packed.store(pack(ntotal, hnsw.entry_point), std::memory_order_release);
+    }
+
+    // the latest published version. hnsw.levels must contain all the
+    //   published nodes.
+    HnswPublishedGraph load(const faiss::HNSW& hnsw) const {
+        const uint64_t value = packed.load(std::memory_order_acquire);
+
+        HnswPublishedGraph graph;
+        graph.ntotal = (storage_idx_t)(value >> 32);
+        graph.entry_point = (storage_idx_t)(uint32_t)(value & 0xFFFFFFFFULL);
+        // the entry point is always a node of the highest level
+        graph.max_level = (graph.entry_point < 0)
+                ? -1
+                : hnsw.levels[graph.entry_point] - 1;
+        return graph;
+    }
+
+    // the number of published nodes
+    size_t ntotal() const {
+        return (size_t)(packed.load(std::memory_order_acquire) >> 32);
+    }
+
+   private:
+    static uint64_t pack(const size_t ntotal, const storage_idx_t entry_point) {
+        return ((uint64_t)ntotal << 32) | (uint32_t)entry_point;
+    }
+
+    std::atomic<uint64_t> packed{pack(0, -1)};
+};
+
+} // namespace knowhere
+} // namespace cppcontrib
+} // namespace faiss
@@ -17,10 +17,16 @@
 // standard headers
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // Faiss-specific headers
 #include <faiss/Index.h>
@@ -29,11 +35,20 @@
 #include <faiss/impl/DistanceComputer.h>
 #include <faiss/impl/FaissException.h>
 #include <faiss/impl/HNSW.h>
+#include <faiss/impl/IDSelector.h>
 #include <faiss/impl/ResultHandler.h>
 #include <faiss/utils/ordered_key_value.h>
+#include <faiss/utils/prefetch.h>
 
 // Knowhere-specific headers
+#include <faiss/cppcontrib/knowhere/impl/CompressedHnswGraph.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswNeighborCodes.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswPublishedGraph.h>
+#include <faiss/cppcontrib/knowhere/impl/HnswSeedTable.h>
 #include <faiss/cppcontrib/knowhere/impl/Neighbor.h>
+#include <faiss/cppcontrib/knowhere/utils/Bitset.h>
+
+#include "knowhere/comp/cancellation.h"
 
 namespace faiss {
 namespace cppcontrib {
@@ -44,8 +59,65 @@ namespace {
 // whether to track statistics
 constexpr bool track_hnsw_stats = true;
 
+// the number of collected neighbors that are evaluated at once in
+//   the pipelined mode. Must be a multiple of 4.
+constexpr size_t pipelined_chunk_size = 64;
+
+// the hops between the checks of the CancellationToken of a search
+constexpr size_t cancellation_check_hops = 64;
+
+// the number of neighbors whose visited and filter bits are tested at once.
+//   Must be a multiple of 8 and fit the bits of a uint32_t.
+constexpr size_t neighbor_chunk_size = 32;
+
+// whether the visited table or the filter can prefetch the bit of an id
+template <typename T, typename = void>
+struct has_prefetch : std::false_type {};
+
+template <typename T>
+struct has_prefetch<
+        T,
+        std::void_t<decltype(std::declval<const T&>().prefetch(idx_t{}))>>
+        : std::true_type {};
+
 } // namespace
 
+// Detects that the level-0 search stopped improving its top-k results.
+// An expansion is stale if the k-th best distance did not improve by more
+//   than min_gain (relative). The search may be stopped after 'patience'
+//   stale expansions in a row. patience == 0 disables the detection.
+struct HnswEarlyTermination {
+    const size_t k;
+    const size_t patience;
+    const float min_gain;
+
+    float kth_distance = std::numeric_limits<float>::max();
+    size_t n_stale = 0;
+
+    HnswEarlyTermination(
+            const size_t k_,
+            const size_t patience_,
+            const float min_gain_)
+            : k{k_}, patience{patience_}, min_gain{min_gain_} {}
+
+    // called after every expansion, returns true if the search should stop
+    bool update(knowhere::NeighborSetDoublePopList& retset) {
+        if (patience == 0 || k == 0 || retset.size() < k) {
+            return false;
+        }
+
+        const float new_kth_distance = retset[k - 1].distance;
+        const bool improved =
+                (kth_distance == std::numeric_limits<float>::max()) ||
+                (kth_distance - new_kth_distance >
+                 min_gain * std::abs(kth_distance));
+        kth_distance = new_kth_distance;
+
+        n_stale = improved ? 0 : n_stale + 1;
+        return n_stale >= patience;
+    }
+};
+
 // Accomodates all the search logic and variables.
 /// * DistanceComputerT is responsible for computing distances
 /// * GraphVisitorT records visited edges
@@ -89,6 +161,45 @@ struct v2_hnsw_searcher {
     // the pointer is not owned.
     const faiss::SearchParametersHNSW* params;
 
+    // how many unvisited neighbors ahead of the one being evaluated
+    //   get their codes prefetched. 0 disables the pipelined expansion.
+    const size_t prefetch_depth;
+
+    // whether filtered out neighbors are expanded through their own
+    //   neighbors on the level 0 instead of being evaluated.
+    const bool two_hop_expansion;
+
+    // level-0 neighbor lists in a compressed form, if hnsw.neighbors were
+    //   replaced with them. nullptr means that hnsw.neighbors is used.
+    // the pointer is not owned.
+    const CompressedHnswGraph* compressed_graph;
+
+    // additional level-0 entry points. nullptr means that only the entry
+    //   point found on the upper levels is used.
+    // the pointer is not owned.
+    const HnswSeedTable* seed_table;
+
+    // the adaptive early termination of the level-0 search, see
+    //   HnswEarlyTermination. 0 disables it.
+    const size_t early_stop_patience;
+    const float early_stop_gap;
+
+    // the visible part of a graph that is being extended concurrently.
+    //   nullptr means that the whole graph is visible.
+    // the pointer is not owned.
+    const HnswPublishedGraph* published_graph;
+
+    // scores all level-0 neighbors of a node at once with the fast-scan
+    //   codes of the neighbors. nullptr means that the neighbors are
+    //   evaluated with qdis. Neither compressed nor published graphs keep
+    //   the slots the codes refer to, so it is not used with them.
+    // the pointer is not owned.
+    HnswNeighborScanner* neighbor_scanner;
+
+    // decoded neighbor lists for the compressed graph. Two lists may be
+    //   in use at the same time by evaluate_single_node_two_hop().
+    std::vector<storage_idx_t> decoded_neighbors[2];
+
     //
     v2_hnsw_searcher(
             const faiss::HNSW& hnsw_,
@@ -97,20 +208,120 @@ struct v2_hnsw_searcher {
             VisitedT& visited_nodes_,
             const FilterT& filter_,
             const float kAlpha_,
-            const faiss::SearchParametersHNSW* params_)
+            const faiss::SearchParametersHNSW* params_,
+            const size_t prefetch_depth_ = 0,
+            const bool two_hop_expansion_ = false,
+            const CompressedHnswGraph* compressed_graph_ = nullptr,
+            const HnswSeedTable* seed_table_ = nullptr,
+            const size_t early_stop_patience_ = 0,
+            const float early_stop_gap_ = 0.0f,
+            const HnswPublishedGraph* published_graph_ = nullptr,
+            HnswNeighborScanner* neighbor_scanner_ = nullptr)
             : hnsw{hnsw_},
               qdis{qdis_},
               graph_visitor{graph_visitor_},
               visited_nodes{visited_nodes_},
               filter{filter_},
               kAlpha{kAlpha_},
-              params{params_} {}
+              params{params_},
+              prefetch_depth{prefetch_depth_},
+              two_hop_expansion{two_hop_expansion_},
+              compressed_graph{compressed_graph_},
+              seed_table{seed_table_},
+              early_stop_patience{early_stop_patience_},
+              early_stop_gap{early_stop_gap_},
+              published_graph{published_graph_},
+              neighbor_scanner{
+                      (compressed_graph_ == nullptr &&
+                       published_graph_ == nullptr)
+                              ? neighbor_scanner_
+                              : nullptr} {
+        if (compressed_graph != nullptr) {
+            for (auto& decoded : decoded_neighbors) {
+                decoded.resize(compressed_graph->nb_neighbors_0);
+            }
+        } else if (published_graph != nullptr) {
+            // level 0 has the longest lists
+            for (auto& decoded : decoded_neighbors) {
+                decoded.resize(hnsw.nb_neighbors(0));
+            }
+        }
+    }
 
     v2_hnsw_searcher(const v2_hnsw_searcher&) = delete;
     v2_hnsw_searcher(v2_hnsw_searcher&&) = delete;
     v2_hnsw_searcher& operator=(const v2_hnsw_searcher&) = delete;
     v2_hnsw_searcher& operator=(v2_hnsw_searcher&&) = delete;
 
+    // returns neighbors of a node at a given level as a range [begin, end)
+    //   of the returned array, similar to faiss::HNSW::neighbor_range().
+    // compressed level-0 lists are decoded into decoded_neighbors[buffer_id].
+    inline const storage_idx_t* get_neighbors(
+            const storage_idx_t node_id,
+            const int level,
+            size_t* begin,
+            size_t* end,
+            const size_t buffer_id = 0) {
+        if (published_graph != nullptr) {
+            return get_visible_neighbors(node_id, level, begin, end, buffer_id);
+        }
+        if (compressed_graph == nullptr) {
+            hnsw.neighbor_range(node_id, level, begin, end);
+            return hnsw.neighbors.data();
+        }
+
+        if (level == 0) {
+            storage_idx_t* const decoded = decoded_neighbors[buffer_id].data();
+            *begin = 0;
+            *end = compressed_graph->decode_level_0(node_id, decoded);
+            return decoded;
+        }
+
+        compressed_graph->upper_neighbor_range(
+                hnsw, node_id, level, begin, end);
+        return compressed_graph->upper_neighbors.data();
+    }
+
+    // a copy of the published neighbors of a node, the list itself may be
+    //   rewritten by a concurrent insertion.
+    inline const storage_idx_t* get_visible_neighbors(
+            const storage_idx_t node_id,
+            const int level,
+            size_t* begin,
+            size_t* end,
+            const size_t buffer_id) {
+        size_t list_begin = 0;
+        size_t list_end = 0;
+        hnsw.neighbor_range(node_id, level, &list_begin, &list_end);
+
+        storage_idx_t* const visible = decoded_neighbors[buffer_id].data();
+        size_t count = 0;
+        for (size_t j = list_begin; j < list_end; j++) {
+            const storage_idx_t v = hnsw.neighbors[j];
+            if (v < 0) {
+                break;
+            }
+            if (v < published_graph->ntotal) {
+                visible[count++] = v;
+            }
+        }
+
+        *begin = 0;
+        *end = count;
+        return visible;
+    }
+
+    // the entry point and the top level of the visible graph
+    inline storage_idx_t get_entry_point() const {
+        return (published_graph != nullptr) ? published_graph->entry_point
+                                            : hnsw.entry_point;
+    }
+
+    inline int get_max_level() const {
+        return (published_graph != nullptr) ? published_graph->max_level
+                                            : hnsw.max_level;
+    }
+
     // greedily update a nearest vector at a given level.
     // * the update starts from the value in 'nearest'.
     faiss::HNSWStats greedy_update_nearest(
@@ -124,23 +335,26 @@ struct v2_hnsw_searcher {
 
             size_t begin = 0;
             size_t end = 0;
-            hnsw.neighbor_range(nearest, level, &begin, &end);
+            const storage_idx_t* const neighbors =
+                    get_neighbors(nearest, level, &begin, &end);
 
             // prefetch and eval the size
             size_t count = 0;
             for (size_t i = begin; i < end; i++) {
-                storage_idx_t v = hnsw.neighbors[i];
+                storage_idx_t v = neighbors[i];
                 if (v < 0) {
                     break;
                 }
 
-                // qdis.prefetch(v);
+                if (prefetch_depth > 0) {
+                    qdis.prefetch(v);
+                }
                 count += 1;
             }
 
             // visit neighbors
             for (size_t i = begin; i < begin + count; i++) {
-                storage_idx_t v = hnsw.neighbors[i];
+                storage_idx_t v = neighbors[i];
 
                 // compute the distance
                 const float dis = qdis(v);
@@ -168,13 +382,124 @@ struct v2_hnsw_searcher {
         }
     }
 
+    // prefetch the level-0 neighbor list of a node that is likely to be
+    //   expanded soon.
+    inline void prefetch_neighbor_list(const storage_idx_t node_id) const {
+        if (prefetch_depth > 0) {
+            if (compressed_graph != nullptr) {
+                compressed_graph->prefetch_level_0(node_id);
+            } else {
+                prefetch_L1(hnsw.neighbors.data() + hnsw.offsets[node_id]);
+            }
+        }
+    }
+
+    // copies the neighbors[j..end) of a hop, up to neighbor_chunk_size of
+    //   them and until the first -1, to ids and returns their number. The
+    //   visited and filter bits of all of them are prefetched first and then
+    //   tested together, so that their cache misses overlap instead of being
+    //   taken one neighbor at a time. The i-th bit of visited_mask is set if
+    //   ids[i] is visited and the i-th bit of member_mask if it passes the
+    //   filter. A neighbor repeated in the chunk is marked visited by the
+    //   caller only, after the masks are computed.
+    inline size_t test_neighbor_chunk(
+            const storage_idx_t* const neighbors,
+            const size_t j,
+            const size_t end,
+            storage_idx_t* const ids,
+            uint32_t& visited_mask,
+            uint32_t& member_mask) const {
+        const size_t n_max = std::min(neighbor_chunk_size, end - j);
+        size_t n = 0;
+        while (n < n_max && neighbors[j + n] >= 0) {
+            ids[n] = neighbors[j + n];
+            n += 1;
+        }
+
+        if constexpr (has_prefetch<VisitedT>::value) {
+            for (size_t i = 0; i < n; i++) {
+                visited_nodes.prefetch(ids[i]);
+            }
+        }
+        if constexpr (has_prefetch<FilterT>::value) {
+            for (size_t i = 0; i < n; i++) {
+                filter.prefetch(ids[i]);
+            }
+        }
+
+        visited_mask = 0;
+        size_t i = 0;
+        if constexpr (std::is_same_v<VisitedT, Bitset>) {
+            for (; i + 8 <= n; i += 8) {
+                visited_mask |= visited_nodes.get_8(ids + i) << i;
+            }
+        }
+        for (; i < n; i++) {
+            visited_mask |= uint32_t(visited_nodes.get(ids[i])) << i;
+        }
+
+        if constexpr (std::is_same_v<FilterT, faiss::IDSelectorAll>) {
+            member_mask = ~uint32_t(0);
+        } else {
+            member_mask = 0;
+            for (size_t i = 0; i < n; i++) {
+                member_mask |= uint32_t(filter.is_member(ids[i])) << i;
+            }
+        }
+
+        return n;
+    }
+
     // no loops, just check neighbors of a single node.
+    // evaluates the distances to the n saved neighbors, 8 at a time while
+    //   possible, then 4 at a time, then one by one. Every expansion
+    //   groups them the same way, so that their results are identical.
+    template <typename IndexT>
+    void evaluate_distances(const IndexT* ids, const size_t n, float* dis) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            idx_t ids8[8];
+            for (size_t k = 0; k < 8; k++) {
+                ids8[k] = ids[i + k];
+            }
+            qdis.distances_batch_8(ids8, dis + i);
+        }
+        if (i + 4 <= n) {
+            qdis.distances_batch_4(
+                    ids[i + 0],
+                    ids[i + 1],
+                    ids[i + 2],
+                    ids[i + 3],
+                    dis[i + 0],
+                    dis[i + 1],
+                    dis[i + 2],
+                    dis[i + 3]);
+            i += 4;
+        }
+        for (; i < n; i++) {
+            dis[i] = qdis(ids[i]);
+        }
+    }
+
     template <typename FuncAddCandidate>
     faiss::HNSWStats evaluate_single_node(
             const idx_t node_id,
             const int level,
             float& accumulated_alpha,
             FuncAddCandidate func_add_candidate) {
+        if (two_hop_expansion && level == 0) {
+            return evaluate_single_node_two_hop(
+                    node_id, level, func_add_candidate);
+        }
+        if (neighbor_scanner != nullptr && level == 0) {
+            return evaluate_single_node_fast_scan(
+                    node_id, accumulated_alpha, func_add_candidate);
+        }
+        if (prefetch_depth > 0) {
+            return evaluate_single_node_pipelined(
+                    node_id, level, accumulated_alpha, func_add_candidate);
+        }
+
         // // unused
         // bool do_dis_check = params ? params->check_relative_distance
         //                            : hnsw.check_relative_distance;
@@ -183,12 +508,115 @@ struct v2_hnsw_searcher {
 
         size_t begin = 0;
         size_t end = 0;
-        hnsw.neighbor_range(node_id, level, &begin, &end);
+        const storage_idx_t* const neighbors =
+                get_neighbors(node_id, level, &begin, &end);
 
         // todo: add prefetch
         size_t counter = 0;
-        size_t saved_indices[4];
-        int saved_statuses[4];
+        size_t saved_indices[8];
+        int saved_statuses[8];
+
+        size_t ndis = 0;
+
+        // evaluates the saved neighbors
+        auto evaluate_saved = [&]() {
+            float dis[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            evaluate_distances(saved_indices, counter, dis);
+
+            for (size_t id8 = 0; id8 < counter; id8++) {
+                // record a traversed edge
+                graph_visitor.visit_edge(
+                        level, node_id, saved_indices[id8], dis[id8]);
+
+                // add a record of visited nodes
+                knowhere::Neighbor nn(
+                        saved_indices[id8], dis[id8], saved_statuses[id8]);
+                func_add_candidate(nn);
+            }
+
+            counter = 0;
+        };
+        storage_idx_t chunk[neighbor_chunk_size];
+        for (size_t j = begin; j < end; j += neighbor_chunk_size) {
+            uint32_t visited_mask = 0;
+            uint32_t member_mask = 0;
+            const size_t n = test_neighbor_chunk(
+                    neighbors, j, end, chunk, visited_mask, member_mask);
+
+            for (size_t i = 0; i < n; i++) {
+                const storage_idx_t v1 = chunk[i];
+
+                // already visited?
+                if (((visited_mask >> i) & 1) || visited_nodes.get(v1)) {
+                    // yes, visited.
+                    graph_visitor.visit_edge(level, node_id, v1, -1);
+                    continue;
+                }
+
+                // not visited. mark as visited.
+                visited_nodes.set(v1);
+
+                // is the node disabled?
+                int status = knowhere::Neighbor::kValid;
+                if (!((member_mask >> i) & 1)) {
+                    // yes, disabled
+                    status = knowhere::Neighbor::kInvalid;
+
+                    // sometimes, disabled nodes are allowed to be used
+                    accumulated_alpha += kAlpha;
+                    if (accumulated_alpha < 1.0f) {
+                        continue;
+                    }
+
+                    accumulated_alpha -= 1.0f;
+                }
+
+                saved_indices[counter] = v1;
+                saved_statuses[counter] = status;
+                counter += 1;
+
+                ndis += 1;
+
+                if (counter == 8) {
+                    // evaluate 8x distances at once
+                    evaluate_saved();
+                }
+            }
+
+            if (n < neighbor_chunk_size) {
+                // no more neighbors
+                break;
+            }
+        }
+
+        // process leftovers
+        evaluate_saved();
+
+        // update stats
+        if (track_hnsw_stats) {
+            stats.ndis = ndis;
+            stats.nhops = 1;
+        }
+
+        // done
+        return stats;
+    }
+
+    // same as evaluate_single_node() on the level 0, but the distances to
+    //   all neighbors, visited ones included, come from a single fast-scan
+    //   call over the neighbor codes of the node.
+    template <typename FuncAddCandidate>
+    faiss::HNSWStats evaluate_single_node_fast_scan(
+            const idx_t node_id,
+            float& accumulated_alpha,
+            FuncAddCandidate func_add_candidate) {
+        faiss::HNSWStats stats;
+
+        size_t begin = 0;
+        size_t end = 0;
+        hnsw.neighbor_range(node_id, 0, &begin, &end);
+
+        const float* const dis = neighbor_scanner->scan(node_id);
 
         size_t ndis = 0;
         for (size_t j = begin; j < end; j++) {
@@ -201,18 +629,15 @@ struct v2_hnsw_searcher {
 
             // already visited?
             if (visited_nodes.get(v1)) {
-                // yes, visited.
-                graph_visitor.visit_edge(level, node_id, v1, -1);
+                graph_visitor.visit_edge(0, node_id, v1, -1);
                 continue;
             }
 
-            // not visited. mark as visited.
             visited_nodes.set(v1);
 
             // is the node disabled?
             int status = knowhere::Neighbor::kValid;
             if (!filter.is_member(v1)) {
-                // yes, disabled
                 status = knowhere::Neighbor::kInvalid;
 
                 // sometimes, disabled nodes are allowed to be used
@@ -224,63 +649,284 @@ struct v2_hnsw_searcher {
                 accumulated_alpha -= 1.0f;
             }
 
-            saved_indices[counter] = v1;
-            saved_statuses[counter] = status;
+            const float d = dis[j - begin];
+            graph_visitor.visit_edge(0, node_id, v1, d);
+
+            knowhere::Neighbor nn(v1, d, status);
+            func_add_candidate(nn);
+
+            ndis += 1;
+        }
+
+        // update stats
+        if (track_hnsw_stats) {
+            stats.ndis = ndis;
+            stats.nhops = 1;
+        }
+
+        return stats;
+    }
+
+    // same as evaluate_single_node(), but for highly selective filters.
+    // Filtered out neighbors are never evaluated. Instead, their own
+    //   neighbors that pass the filter are evaluated, so the subgraph of
+    //   valid nodes stays connected (similar to ACORN-1).
+    // The number of evaluated nodes is limited by the capacity of
+    //   the neighbor list, same as for a regular expansion.
+    template <typename FuncAddCandidate>
+    faiss::HNSWStats evaluate_single_node_two_hop(
+            const idx_t node_id,
+            const int level,
+            FuncAddCandidate func_add_candidate) {
+        faiss::HNSWStats stats;
+
+        size_t begin = 0;
+        size_t end = 0;
+        const storage_idx_t* const neighbors =
+                get_neighbors(node_id, level, &begin, &end);
+
+        const size_t max_candidates = end - begin;
+
+        size_t counter = 0;
+        size_t saved_indices[8];
+
+        size_t ndis = 0;
+
+        // evaluates the saved neighbors
+        auto evaluate_saved = [&]() {
+            float dis[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            evaluate_distances(saved_indices, counter, dis);
+
+            for (size_t id8 = 0; id8 < counter; id8++) {
+                // record a traversed edge
+                graph_visitor.visit_edge(
+                        level, node_id, saved_indices[id8], dis[id8]);
+
+                // add a record of visited nodes
+                knowhere::Neighbor nn(
+                        saved_indices[id8],
+                        dis[id8],
+                        knowhere::Neighbor::kValid);
+                func_add_candidate(nn);
+            }
+
+            counter = 0;
+        };
+
+        auto add_candidate = [&](const storage_idx_t v) {
+            saved_indices[counter] = v;
             counter += 1;
 
             ndis += 1;
 
-            if (counter == 4) {
-                // evaluate 4x distances at once
-                float dis[4] = {0, 0, 0, 0};
-                qdis.distances_batch_4(
-                        saved_indices[0],
-                        saved_indices[1],
-                        saved_indices[2],
-                        saved_indices[3],
-                        dis[0],
-                        dis[1],
-                        dis[2],
-                        dis[3]);
-
-                for (size_t id4 = 0; id4 < 4; id4++) {
-                    // record a traversed edge
-                    graph_visitor.visit_edge(
-                            level, node_id, saved_indices[id4], dis[id4]);
+            if (counter == 8) {
+                // evaluate 8x distances at once
+                evaluate_saved();
+            }
+        };
 
-                    // add a record of visited nodes
-                    knowhere::Neighbor nn(
-                            saved_indices[id4], dis[id4], saved_statuses[id4]);
-                    if (func_add_candidate(nn)) {
-#if defined(USE_PREFETCH)
-                        // TODO
-                        // _mm_prefetch(get_linklist0(v), _MM_HINT_T0);
-#endif
-                    }
+        // direct neighbors that pass the filter
+        for (size_t j = begin; j < end; j++) {
+            const storage_idx_t v1 = neighbors[j];
+
+            if (v1 < 0) {
+                // no more neighbors
+                break;
+            }
+
+            // already visited?
+            if (visited_nodes.get(v1)) {
+                // yes, visited.
+                graph_visitor.visit_edge(level, node_id, v1, -1);
+                continue;
+            }
+
+            // filtered out nodes are marked as visited once expanded
+            if (!filter.is_member(v1)) {
+                continue;
+            }
+
+            visited_nodes.set(v1);
+            add_candidate(v1);
+        }
+
+        // neighbors of filtered out direct neighbors
+        for (size_t j = begin; j < end && ndis < max_candidates; j++) {
+            const storage_idx_t v1 = neighbors[j];
+
+            if (v1 < 0) {
+                // no more neighbors
+                break;
+            }
+
+            if (visited_nodes.get(v1)) {
+                continue;
+            }
+
+            // v1 is filtered out, because all the valid ones
+            //   were marked as visited above
+            visited_nodes.set(v1);
+
+            size_t begin2 = 0;
+            size_t end2 = 0;
+            const storage_idx_t* const neighbors2 =
+                    get_neighbors(v1, level, &begin2, &end2, 1);
+
+            for (size_t j2 = begin2; j2 < end2 && ndis < max_candidates;
+                 j2++) {
+                const storage_idx_t v2 = neighbors2[j2];
+
+                if (v2 < 0) {
+                    // no more neighbors
+                    break;
                 }
 
-                counter = 0;
+                if (visited_nodes.get(v2)) {
+                    continue;
+                }
+
+                // filtered out nodes of the second hop are left unmarked,
+                //   they still may be reached from other nodes
+                if (!filter.is_member(v2)) {
+                    continue;
+                }
+
+                visited_nodes.set(v2);
+                add_candidate(v2);
             }
         }
 
         // process leftovers
-        for (size_t id4 = 0; id4 < counter; id4++) {
-            // evaluate a single distance
-            const float dis = qdis(saved_indices[id4]);
+        evaluate_saved();
+
+        // update stats
+        if (track_hnsw_stats) {
+            stats.ndis = ndis;
+            stats.nhops = 1;
+        }
+
+        // done
+        return stats;
+    }
+
+    // same as evaluate_single_node(), but software-pipelined.
+    // Unvisited neighbors are collected first, then their distances are
+    //   evaluated in the very same order and 8-grouping as in
+    //   evaluate_single_node() (so the results are identical), while
+    //   codes of the next 'prefetch_depth' neighbors are being prefetched.
+    //   Neighbor lists of the accepted candidates are prefetched as well,
+    //   because they are likely to be expanded next.
+    template <typename FuncAddCandidate>
+    faiss::HNSWStats evaluate_single_node_pipelined(
+            const idx_t node_id,
+            const int level,
+            float& accumulated_alpha,
+            FuncAddCandidate func_add_candidate) {
+        faiss::HNSWStats stats;
+
+        size_t begin = 0;
+        size_t end = 0;
+        const storage_idx_t* const neighbors =
+                get_neighbors(node_id, level, &begin, &end);
+
+        size_t counter = 0;
+        storage_idx_t saved_indices[pipelined_chunk_size];
+        int saved_statuses[pipelined_chunk_size];
+
+        size_t ndis = 0;
+
+        // evaluates the first 'n' saved neighbors
+        auto evaluate_saved = [&](const size_t n) {
+            for (size_t id8 = 0; id8 < n; id8 += 8) {
+                const size_t n8 = std::min<size_t>(8, n - id8);
+
+                // keep the pipeline full
+                for (size_t ip = id8 + prefetch_depth;
+                     ip < std::min(n, id8 + prefetch_depth + 8);
+                     ip++) {
+                    qdis.prefetch(saved_indices[ip]);
+                }
+
+                // evaluate up to 8x distances at once
+                float dis[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+                evaluate_distances(saved_indices + id8, n8, dis);
+
+                for (size_t j = 0; j < n8; j++) {
+                    const storage_idx_t v = saved_indices[id8 + j];
 
-            // record a traversed edge
-            graph_visitor.visit_edge(level, node_id, saved_indices[id4], dis);
+                    // record a traversed edge
+                    graph_visitor.visit_edge(level, node_id, v, dis[j]);
+
+                    // add a record of visited nodes
+                    knowhere::Neighbor nn(v, dis[j], saved_statuses[id8 + j]);
+                    if (func_add_candidate(nn) && level == 0) {
+                        prefetch_neighbor_list(v);
+                    }
+                }
+            }
+        };
+
+        storage_idx_t chunk[neighbor_chunk_size];
+        for (size_t j = begin; j < end; j += neighbor_chunk_size) {
+            uint32_t visited_mask = 0;
+            uint32_t member_mask = 0;
+            const size_t n = test_neighbor_chunk(
+                    neighbors, j, end, chunk, visited_mask, member_mask);
+
+            for (size_t i = 0; i < n; i++) {
+                const storage_idx_t v1 = chunk[i];
+
+                // already visited?
+                if (((visited_mask >> i) & 1) || visited_nodes.get(v1)) {
+                    // yes, visited.
+                    graph_visitor.visit_edge(level, node_id, v1, -1);
+                    continue;
+                }
+
+                // not visited. mark as visited.
+                visited_nodes.set(v1);
+
+                // is the node disabled?
+                int status = knowhere::Neighbor::kValid;
+                if (!((member_mask >> i) & 1)) {
+                    // yes, disabled
+                    status = knowhere::Neighbor::kInvalid;
 
-            // add a record of visited
-            knowhere::Neighbor nn(saved_indices[id4], dis, saved_statuses[id4]);
-            if (func_add_candidate(nn)) {
-#if defined(USE_PREFETCH)
-                // TODO
-                // _mm_prefetch(get_linklist0(v), _MM_HINT_T0);
-#endif
+                    // sometimes, disabled nodes are allowed to be used
+                    accumulated_alpha += kAlpha;
+                    if (accumulated_alpha < 1.0f) {
+                        continue;
+                    }
+
+                    accumulated_alpha -= 1.0f;
+                }
+
+                // start fetching the code right away, if it falls into
+                //   the prefetch window
+                if (counter < prefetch_depth) {
+                    qdis.prefetch(v1);
+                }
+
+                saved_indices[counter] = v1;
+                saved_statuses[counter] = status;
+                counter += 1;
+
+                ndis += 1;
+
+                if (counter == pipelined_chunk_size) {
+                    evaluate_saved(counter);
+                    counter = 0;
+                }
+            }
+
+            if (n < neighbor_chunk_size) {
+                // no more neighbors
+                break;
             }
         }
 
+        evaluate_saved(counter);
+
         // update stats
         if (track_hnsw_stats) {
             stats.ndis = ndis;
@@ -293,23 +939,36 @@ struct v2_hnsw_searcher {
 
     // perform the search on a given level.
     // it is assumed that retset is initialized and contains the initial nodes.
+    // early_stop_k is the number of results that are tracked for the
+    //   adaptive early termination, 0 means the full search.
     faiss::HNSWStats search_on_a_level(
             knowhere::NeighborSetDoublePopList& retset,
             const int level,
             knowhere::IteratorMinHeap* const __restrict disqualified = nullptr,
-            const float initial_accumulated_alpha = 1.0f) {
+            const float initial_accumulated_alpha = 1.0f,
+            const size_t early_stop_k = 0) {
         faiss::HNSWStats stats;
 
         //
         float accumulated_alpha = initial_accumulated_alpha;
 
+        HnswEarlyTermination early_termination(
+                early_stop_k, early_stop_patience, early_stop_gap);
+
         // what to do with a accepted candidate
         auto add_search_candidate = [&](const knowhere::Neighbor n) {
             return retset.insert(n, disqualified);
         };
 
         // iterate while possible
+        size_t nhops = 0;
         while (retset.has_next()) {
+            // a cancelled search keeps the candidates found so far
+            if (nhops++ % cancellation_check_hops == 0 &&
+                ::knowhere::CancellationToken::CurrentIsCancelled()) {
+                break;
+            }
+
             // get a node to be processed
             const knowhere::Neighbor neighbor = retset.pop();
 
@@ -324,6 +983,11 @@ struct v2_hnsw_searcher {
             if (track_hnsw_stats) {
                 stats.combine(local_stats);
             }
+
+            // the top-k results have converged
+            if (early_termination.update(retset)) {
+                break;
+            }
         }
 
         // done
@@ -337,7 +1001,7 @@ struct v2_hnsw_searcher {
         faiss::HNSWStats stats;
 
         // iterate through upper levels
-        for (int level = hnsw.max_level; level >= 1; level--) {
+        for (int level = get_max_level(); level >= 1; level--) {
             // update the visitor
             graph_visitor.visit_level(level);
 
@@ -354,6 +1018,61 @@ struct v2_hnsw_searcher {
         return stats;
     }
 
+    // initialize level-0 candidates with the entry point that was
+    //   found on the upper levels and with the seeds, if any.
+    void init_level_0(
+            knowhere::NeighborSetDoublePopList& retset,
+            const storage_idx_t nearest,
+            const float d_nearest) {
+        add_level_0_entry(retset, nearest, d_nearest);
+
+        if (seed_table == nullptr) {
+            return;
+        }
+
+        for (const storage_idx_t seed : seed_table->nodes) {
+            if (visited_nodes.get(seed)) {
+                continue;
+            }
+
+            add_level_0_entry(retset, seed, qdis(seed));
+        }
+    }
+
+    inline void add_level_0_entry(
+            knowhere::NeighborSetDoublePopList& retset,
+            const storage_idx_t node_id,
+            const float distance) {
+        if (!filter.is_member(node_id)) {
+            retset.insert(knowhere::Neighbor(
+                    node_id, distance, knowhere::Neighbor::kInvalid));
+        } else {
+            retset.insert(knowhere::Neighbor(
+                    node_id, distance, knowhere::Neighbor::kValid));
+        }
+
+        visited_nodes[node_id] = true;
+    }
+
+    // copy top-k candidates into the output, pad with -1 if needed.
+    static void populate_result(
+            knowhere::NeighborSetDoublePopList& retset,
+            const idx_t k,
+            float* __restrict distances,
+            idx_t* __restrict labels) {
+        const idx_t len = std::min((idx_t)retset.size(), k);
+        for (idx_t i = 0; i < len; i++) {
+            distances[i] = retset[i].distance;
+            labels[i] = (idx_t)retset[i].id;
+        }
+        if (len < k) {
+            for (idx_t idx = len; idx < k; idx++) {
+                labels[idx] = -1;
+                distances[idx] = std::numeric_limits<float>::max();
+            }
+        }
+    }
+
     // perform the search.
     faiss::HNSWStats search(
             const idx_t k,
@@ -362,7 +1081,7 @@ struct v2_hnsw_searcher {
         faiss::HNSWStats stats;
 
         // is the graph empty?
-        if (hnsw.entry_point == -1) {
+        if (get_entry_point() == -1) {
             return stats;
         }
 
@@ -379,7 +1098,7 @@ struct v2_hnsw_searcher {
         // greedy search on upper levels.
 
         // initialize the starting point.
-        storage_idx_t nearest = hnsw.entry_point;
+        storage_idx_t nearest = get_entry_point();
         float d_nearest = qdis(nearest);
 
         // iterate through upper levels
@@ -400,35 +1119,16 @@ struct v2_hnsw_searcher {
         knowhere::NeighborSetDoublePopList retset(n_candidates);
 
         // initialize retset with a single 'nearest' point
-        {
-            if (!filter.is_member(nearest)) {
-                retset.insert(knowhere::Neighbor(
-                        nearest, d_nearest, knowhere::Neighbor::kInvalid));
-            } else {
-                retset.insert(knowhere::Neighbor(
-                        nearest, d_nearest, knowhere::Neighbor::kValid));
-            }
-
-            visited_nodes[nearest] = true;
-        }
+        init_level_0(retset, nearest, d_nearest);
 
         // perform the search of the level 0.
-        faiss::HNSWStats local_stats = search_on_a_level(retset, 0);
+        faiss::HNSWStats local_stats =
+                search_on_a_level(retset, 0, nullptr, 1.0f, k);
 
         // todo: switch to brute-force in case of (retset.size() < k)
 
         // populate the result
-        const idx_t len = std::min((idx_t)retset.size(), k);
-        for (idx_t i = 0; i < len; i++) {
-            distances[i] = retset[i].distance;
-            labels[i] = (idx_t)retset[i].id;
-        }
-        if (len < k) {
-            for (idx_t idx = len; idx < k; idx++) {
-                labels[idx] = -1;
-                distances[idx] = std::numeric_limits<float>::max();
-            }
-        }
+        populate_result(retset, k, distances, labels);
         // update stats
         if (track_hnsw_stats) {
             stats.combine(local_stats);
@@ -446,7 +1146,7 @@ struct v2_hnsw_searcher {
         faiss::HNSWStats stats;
 
         // is the graph empty?
-        if (hnsw.entry_point == -1) {
+        if (get_entry_point() == -1) {
             return stats;
         }
 
@@ -463,7 +1163,7 @@ struct v2_hnsw_searcher {
         // greedy search on upper levels.
 
         // initialize the starting point.
-        storage_idx_t nearest = hnsw.entry_point;
+        storage_idx_t nearest = get_entry_point();
         float d_nearest = qdis(nearest);
 
         // iterate through upper levels
@@ -484,17 +1184,7 @@ struct v2_hnsw_searcher {
         knowhere::NeighborSetDoublePopList retset(n_candidates);
 
         // initialize retset with a single 'nearest' point
-        {
-            if (!filter.is_member(nearest)) {
-                retset.insert(knowhere::Neighbor(
-                        nearest, d_nearest, knowhere::Neighbor::kInvalid));
-            } else {
-                retset.insert(knowhere::Neighbor(
-                        nearest, d_nearest, knowhere::Neighbor::kValid));
-            }
-
-            visited_nodes[nearest] = true;
-        }
+        init_level_0(retset, nearest, d_nearest);
 
         // perform the search of the level 0.
         faiss::HNSWStats local_stats = search_on_a_level(retset, 0);
@@ -526,10 +1216,11 @@ struct v2_hnsw_searcher {
 
             size_t id_begin = 0;
             size_t id_end = 0;
-            hnsw.neighbor_range(current.second, 0, &id_begin, &id_end);
+            const storage_idx_t* const neighbors =
+                    get_neighbors(current.second, 0, &id_begin, &id_end);
 
             for (size_t id = id_begin; id < id_end; id++) {
-                const auto ngb = hnsw.neighbors[id];
+                const auto ngb = neighbors[id];
                 if (ngb == -1) {
                     break;
                 }
@@ -561,8 +1252,254 @@ struct v2_hnsw_searcher {
 
         return stats;
     }
+
+    // perform a group-by search.
+    // * every valid node of the level 0 is offered to 'groups' right when
+    //   its distance is evaluated, GroupsT::Add(id, distance).
+    // * the level 0 is traversed best-first with an unbounded frontier, so
+    //   the traversal can go on past the efSearch best nodes while the
+    //   groups are not settled.
+    // * it stops once the efSearch best nodes have converged and the
+    //   closest unexpanded node is not closer than GroupsT::Bound(), the
+    //   distance a node has to beat to enter the result.
+    template <typename GroupsT>
+    faiss::HNSWStats search_group_by(GroupsT& groups) {
+        faiss::HNSWStats stats;
+
+        // is the graph empty?
+        if (get_entry_point() == -1) {
+            return stats;
+        }
+
+        // grab some needed parameters
+        const size_t efSearch = params ? params->efSearch : hnsw.efSearch;
+
+        // greedy search on upper levels?
+        if (hnsw.upper_beam != 1) {
+            FAISS_THROW_MSG("Not implemented");
+            return stats;
+        }
+
+        // initialize the starting point.
+        storage_idx_t nearest = get_entry_point();
+        float d_nearest = qdis(nearest);
+
+        // iterate through upper levels
+        auto bottom_levels_stats = greedy_search_top_levels(nearest, d_nearest);
+
+        // update stats
+        if (track_hnsw_stats) {
+            stats.combine(bottom_levels_stats);
+        }
+
+        // level 0 search
+
+        // update the visitor
+        graph_visitor.visit_level(0);
+
+        // the nodes to expand, closest first
+        using frontier_item = std::pair<float, storage_idx_t>;
+        std::priority_queue<
+                frontier_item,
+                std::vector<frontier_item>,
+                std::greater<frontier_item>>
+                frontier;
+        // the efSearch best distances so far, farthest first
+        std::priority_queue<float> beam;
+
+        auto add_candidate = [&](const knowhere::Neighbor n) {
+            frontier.emplace(n.distance, n.id);
+            if (beam.size() < efSearch) {
+                beam.push(n.distance);
+            } else if (n.distance < beam.top()) {
+                beam.pop();
+                beam.push(n.distance);
+            }
+            if (n.status == knowhere::Neighbor::kValid) {
+                groups.Add(n.id, n.distance);
+            }
+            return true;
+        };
+
+        auto add_entry = [&](const storage_idx_t node_id,
+                             const float distance) {
+            visited_nodes[node_id] = true;
+            add_candidate(knowhere::Neighbor(
+                    node_id,
+                    distance,
+                    filter.is_member(node_id) ? knowhere::Neighbor::kValid
+                                              : knowhere::Neighbor::kInvalid));
+        };
+
+        add_entry(nearest, d_nearest);
+        if (seed_table != nullptr) {
+            for (const storage_idx_t seed : seed_table->nodes) {
+                if (!visited_nodes.get(seed)) {
+                    add_entry(seed, qdis(seed));
+                }
+            }
+        }
+
+        float accumulated_alpha = 1.0f;
+        size_t nhops = 0;
+        while (!frontier.empty()) {
+            if (nhops++ % cancellation_check_hops == 0 &&
+                ::knowhere::CancellationToken::CurrentIsCancelled()) {
+                break;
+            }
+
+            const auto [distance, node_id] = frontier.top();
+            if (beam.size() >= efSearch && distance > beam.top() &&
+                distance >= groups.Bound()) {
+                break;
+            }
+            frontier.pop();
+
+            faiss::HNSWStats local_stats = evaluate_single_node(
+                    node_id, 0, accumulated_alpha, add_candidate);
+
+            // update stats
+            if (track_hnsw_stats) {
+                stats.combine(local_stats);
+            }
+        }
+
+        return stats;
+    }
 };
 
+// perform the search for a group of queries that traverse the graph together.
+// * searchers[i] is responsible for the i-th query and owns its own distance
+//   computer and its own table of visited nodes.
+// * upper levels are descended level by level for all queries at once, so
+//   hub nodes of the upper levels are loaded once per group rather than
+//   once per query.
+// * level-0 frontier expansions of all queries are interleaved in a
+//   round-robin manner, so the neighbor lists of the nodes that are popular
+//   among the queries of a group stay cache-resident.
+// Every query performs the very same sequence of steps as in
+//   v2_hnsw_searcher::search(), so the results are identical.
+template <typename SearcherT>
+void v2_hnsw_batch_search(
+        SearcherT* const* const searchers,
+        const size_t nq,
+        const faiss::idx_t k,
+        float* __restrict distances,
+        faiss::idx_t* __restrict labels,
+        faiss::HNSWStats* __restrict stats) {
+    using storage_idx_t = faiss::HNSW::storage_idx_t;
+    using idx_t = faiss::idx_t;
+
+    if (nq == 0) {
+        return;
+    }
+
+    const faiss::HNSW& hnsw = searchers[0]->hnsw;
+    const storage_idx_t entry_point = searchers[0]->get_entry_point();
+
+    // is the graph empty?
+    if (entry_point == -1) {
+        return;
+    }
+
+    // greedy search on upper levels?
+    if (hnsw.upper_beam != 1) {
+        FAISS_THROW_MSG("Not implemented");
+        return;
+    }
+
+    // grab some needed parameters
+    const auto* params = searchers[0]->params;
+    const int efSearch = params ? params->efSearch : hnsw.efSearch;
+
+    // initialize the starting points.
+    std::vector<storage_idx_t> nearest(nq, entry_point);
+    std::vector<float> d_nearest(nq);
+    for (size_t q = 0; q < nq; q++) {
+        d_nearest[q] = searchers[q]->qdis(entry_point);
+    }
+
+    // iterate through upper levels, all queries at once
+    for (int level = searchers[0]->get_max_level(); level >= 1; level--) {
+        for (size_t q = 0; q < nq; q++) {
+            searchers[q]->graph_visitor.visit_level(level);
+
+            faiss::HNSWStats local_stats = searchers[q]->greedy_update_nearest(
+                    level, nearest[q], d_nearest[q]);
+
+            if (track_hnsw_stats) {
+                stats[q].combine(local_stats);
+            }
+        }
+    }
+
+    // level 0 search
+    const idx_t n_candidates = std::max((idx_t)efSearch, k);
+
+    std::vector<knowhere::NeighborSetDoublePopList> retsets;
+    retsets.reserve(nq);
+    for (size_t q = 0; q < nq; q++) {
+        searchers[q]->graph_visitor.visit_level(0);
+
+        retsets.emplace_back(n_candidates);
+        searchers[q]->init_level_0(retsets[q], nearest[q], d_nearest[q]);
+    }
+
+    // expand a single node per query at a time
+    std::vector<float> accumulated_alpha(nq, 1.0f);
+    std::vector<HnswEarlyTermination> early_terminations;
+    early_terminations.reserve(nq);
+    for (size_t q = 0; q < nq; q++) {
+        early_terminations.emplace_back(
+                k,
+                searchers[q]->early_stop_patience,
+                searchers[q]->early_stop_gap);
+    }
+    std::vector<bool> converged(nq, false);
+
+    size_t n_active = nq;
+    size_t nrounds = 0;
+    while (n_active > 0) {
+        if (nrounds++ % cancellation_check_hops == 0 &&
+            ::knowhere::CancellationToken::CurrentIsCancelled()) {
+            break;
+        }
+        n_active = 0;
+
+        for (size_t q = 0; q < nq; q++) {
+            knowhere::NeighborSetDoublePopList& retset = retsets[q];
+            if (converged[q] || !retset.has_next()) {
+                continue;
+            }
+
+            const knowhere::Neighbor neighbor = retset.pop();
+
+            faiss::HNSWStats local_stats = searchers[q]->evaluate_single_node(
+                    neighbor.id,
+                    0,
+                    accumulated_alpha[q],
+                    [&retset](const knowhere::Neighbor n) {
+                        return retset.insert(n);
+                    });
+
+            if (track_hnsw_stats) {
+                stats[q].combine(local_stats);
+            }
+
+            // the top-k results of this query have converged
+            converged[q] = early_terminations[q].update(retset);
+
+            n_active += 1;
+        }
+    }
+
+    // populate the results
+    for (size_t q = 0; q < nq; q++) {
+        SearcherT::populate_result(
+                retsets[q], k, distances + q * k, labels + q * k);
+    }
+}
+
 } // namespace knowhere
 } // namespace cppcontrib
 } // namespace faiss
@@ -0,0 +1,108 @@
+// Copyright (C) 2019-2024 Zilliz. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not
+// use this file except in compliance with the License. You may obtain a copy of
+// the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <faiss/Clustering.h>
+#include <faiss/IndexFlat.h>
+#include <faiss/IndexHNSW.h>
+#include <faiss/impl/HNSW.h>
+
+#include "simd/hook.h"
+
+namespace faiss {
+namespace cppcontrib {
+namespace knowhere {
+
+// Additional entry points for the level 0 of an HNSW graph.
+// The data is clustered with k-means, and every centroid is mapped to
+//   the closest graph node. A search evaluates these nodes together with
+//   the entry point found on the upper levels, so queries that are far from
+//   hnsw.entry_point start close to their own cluster.
+struct HnswSeedTable {
+    using storage_idx_t = faiss::HNSW::storage_idx_t;
+
+    // k-means is trained on this many vectors per centroid at most
+    static constexpr size_t kPointsPerCentroid = 64;
+
+    // graph nodes closest to the centroids, unique
+    std::vector<storage_idx_t> nodes;
+
+    // cluster the stored vectors of an index into n_centroids clusters.
+    //   vectors are reconstructed from the storage of the index.
+    static HnswSeedTable build(
+            const faiss::IndexHNSW& index,
+            size_t n_centroids) {
+        HnswSeedTable table;
+
+        const size_t ntotal = index.ntotal;
+        const size_t d = index.d;
+        n_centroids = std::min(n_centroids, ntotal);
+        if (n_centroids == 0) {
+            return table;
+        }
+
+        // pick a sample that is evenly spread over the ids
+        const size_t n_sample =
+                std::min(ntotal, n_centroids * kPointsPerCentroid);
+        std::vector<storage_idx_t> sample_ids(n_sample);
+        std::vector<float> sample(n_sample * d);
+        for (size_t i = 0; i < n_sample; i++) {
+            sample_ids[i] = (storage_idx_t)(i * ntotal / n_sample);
+            index.storage->reconstruct(sample_ids[i], sample.data() + i * d);
+        }
+
+        faiss::ClusteringParameters cp;
+        cp.niter = 10;
+        cp.max_points_per_centroid = kPointsPerCentroid;
+        faiss::Clustering clustering(d, n_centroids, cp);
+        faiss::IndexFlatL2 assigner(d);
+        clustering.train(n_sample, sample.data(), assigner);
+
+        // map every centroid to the closest sampled node
+        std::vector<float> tmp(n_sample);
+        table.nodes.reserve(n_centroids);
+        for (size_t i = 0; i < n_centroids; i++) {
+            const size_t nearest = faiss::fvec_L2sqr_ny_nearest(
+                    tmp.data(),
+                    clustering.centroids.data() + i * d,
+                    sample.data(),
+                    d,
+                    n_sample);
+            table.nodes.push_back(sample_ids[nearest]);
+        }
+
+        // several centroids may share a node
+        std::sort(table.nodes.begin(), table.nodes.end());
+        table.nodes.erase(
+                std::unique(table.nodes.begin(), table.nodes.end()),
+                table.nodes.end());
+
+        return table;
+    }
+
+    // the number of bytes used
+    size_t size_in_bytes() const {
+        return nodes.size() * sizeof(storage_idx_t);
+    }
+};
+
+} // namespace knowhere
+} // namespace cppcontrib
+} // namespace faiss
@@ -16,6 +16,12 @@
 #include <cstring>
 #include <memory>
 
+#include <faiss/utils/prefetch.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace faiss {
 namespace cppcontrib {
 namespace knowhere {
@@ -52,7 +58,8 @@ struct Bitset final {
 
         const size_t nbytes = (initial_size + 7) / 8; 
 
-        bitset.bits = std::make_unique<uint8_t[]>(nbytes);
+        // padded, so that get_8() may read 4 bytes starting at the last one
+        bitset.bits = std::make_unique<uint8_t[]>(nbytes + gather_padding);
         bitset.size = initial_size;
 
         return bitset;
@@ -75,6 +82,31 @@ struct Bitset final {
         return (bits[index >> 3] & (0x1 << (index & 0x7)));
     }
 
+    // the bits of indices[0..8), one per bit of the result. Read with a
+    //   single gather of the bytes holding them where AVX2 is available.
+    inline uint32_t get_8(const int32_t* indices) const {
+#if defined(__AVX2__)
+        const __m256i idx = _mm256_loadu_si256((const __m256i*)indices);
+        const __m256i words = _mm256_i32gather_epi32(
+                (const int*)bits.get(), _mm256_srli_epi32(idx, 3), 1);
+        const __m256i shifted = _mm256_srlv_epi32(
+                words, _mm256_and_si256(idx, _mm256_set1_epi32(7)));
+        // move the bit of every lane to its sign
+        return (uint32_t)_mm256_movemask_ps(
+                _mm256_castsi256_ps(_mm256_slli_epi32(shifted, 31)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < 8; i++) {
+            mask |= uint32_t(get(indices[i])) << i;
+        }
+        return mask;
+#endif
+    }
+
+    inline void prefetch(const size_t index) const {
+        prefetch_L1(bits.get() + (index >> 3));
+    }
+
     inline void set(const size_t index) {
         bits[index >> 3] |= uint8_t(0x1 << (index & 0x7));
     }
@@ -106,6 +138,8 @@ struct Bitset final {
         return get(bit_idx);
     }
 
+    static constexpr size_t gather_padding = sizeof(int32_t) - 1;
+
     std::unique_ptr<uint8_t[]> bits;
     size_t size = 0;
 };
@@ -64,4 +64,36 @@ void CodePackerFlat::unpack_1(
     unpack_all(block, flat_code);
 }
 
+/*********************************************
+ * CodePackerInterleaved
+ */
+
+CodePackerInterleaved::CodePackerInterleaved(size_t code_size, size_t nvec) {
+    this->code_size = code_size;
+    this->nvec = nvec;
+    block_size = code_size * nvec;
+}
+
+void CodePackerInterleaved::pack_1(
+        const uint8_t* flat_code,
+        size_t offset,
+        uint8_t* block) const {
+    block += (offset / nvec) * block_size;
+    offset %= nvec;
+    for (size_t b = 0; b < code_size; b++) {
+        block[b * nvec + offset] = flat_code[b];
+    }
+}
+
+void CodePackerInterleaved::unpack_1(
+        const uint8_t* block,
+        size_t offset,
+        uint8_t* flat_code) const {
+    block += (offset / nvec) * block_size;
+    offset %= nvec;
+    for (size_t b = 0; b < code_size; b++) {
+        flat_code[b] = block[b * nvec + offset];
+    }
+}
+
 } // namespace faiss
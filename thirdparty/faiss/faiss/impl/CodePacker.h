@@ -68,4 +68,17 @@ struct CodePackerFlat : CodePacker {
     void unpack_all(const uint8_t* block, uint8_t* flat_codes) const final;
 };
 
+/** Code packer that interleaves the bytes of nvec codes: byte b of the code
+ * at offset i of a block is stored at b * nvec + i, so a kernel can load the
+ * same byte of all the codes of a block at once. The offsets may go past a
+ * block, the following blocks are then addressed. */
+struct CodePackerInterleaved : CodePacker {
+    CodePackerInterleaved(size_t code_size, size_t nvec);
+
+    void pack_1(const uint8_t* flat_code, size_t offset, uint8_t* block)
+            const final;
+    void unpack_1(const uint8_t* block, size_t offset, uint8_t* flat_code)
+            const final;
+};
+
 } // namespace faiss
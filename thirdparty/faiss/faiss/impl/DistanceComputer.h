@@ -8,6 +8,9 @@
 #pragma once
 
 #include <faiss/Index.h>
+#include <faiss/utils/prefetch.h>
+
+#include <algorithm>
 
 namespace faiss {
 
@@ -53,9 +56,23 @@ struct DistanceComputer {
         dis3 = d3;
     }
 
+    /// compute distances of current query to the 8 stored vectors idx.
+    /// Falls back to distances_batch_4().
+    virtual void distances_batch_8(const idx_t* idx, float* dis) {
+        distances_batch_4(
+                idx[0], idx[1], idx[2], idx[3], dis[0], dis[1], dis[2], dis[3]);
+        distances_batch_4(
+                idx[4], idx[5], idx[6], idx[7], dis[4], dis[5], dis[6], dis[7]);
+    }
+
     /// compute distance between two stored vectors
     virtual float symmetric_dis(idx_t i, idx_t j) = 0;
 
+    /// hint that the vector i is going to be evaluated soon.
+    /// implementations that know where their codes live may issue
+    /// a software prefetch for it. Does nothing by default.
+    virtual void prefetch(idx_t /*i*/) {}
+
     virtual ~DistanceComputer() {}
 };
 
@@ -95,11 +112,22 @@ struct NegativeDistanceComputer : DistanceComputer {
         dis3 = -dis3;
     }
 
+    void distances_batch_8(const idx_t* idx, float* dis) override {
+        basedis->distances_batch_8(idx, dis);
+        for (size_t k = 0; k < 8; k++) {
+            dis[k] = -dis[k];
+        }
+    }
+
     /// compute distance between two stored vectors
     float symmetric_dis(idx_t i, idx_t j) override {
         return -basedis->symmetric_dis(i, j);
     }
 
+    void prefetch(idx_t i) override {
+        basedis->prefetch(i);
+    }
+
     virtual ~NegativeDistanceComputer() {
         delete basedis;
     }
@@ -122,6 +150,17 @@ struct FlatCodesDistanceComputer : DistanceComputer {
         return distance_to_code(codes + i * code_size);
     }
 
+    /// prefetch the leading cache lines of a code. Hardware prefetchers
+    /// are expected to pick up the rest of a long code.
+    void prefetch(idx_t i) override {
+        constexpr size_t kMaxPrefetchBytes = 256;
+        const uint8_t* code = codes + i * code_size;
+        const size_t nbytes = std::min(code_size, kMaxPrefetchBytes);
+        for (size_t offset = 0; offset < nbytes; offset += 64) {
+            prefetch_L1(code + offset);
+        }
+    }
+
     /// compute distance of current query to an encoded vector
     virtual float distance_to_code(const uint8_t* code) = 0;
 
@@ -648,6 +648,89 @@ void HNSW::add_with_locks(
     }
 }
 
+/**************************************************************
+ * Building, batched
+ **************************************************************/
+
+void HNSW::add_links_from_snapshot(
+        DistanceComputer& ptdis,
+        int pt_level,
+        storage_idx_t pt_id,
+        VisitedTable& vt,
+        bool keep_max_size_level0) {
+    storage_idx_t nearest = entry_point;
+    if (nearest < 0) {
+        return;
+    }
+
+    int level = max_level;
+    float d_nearest = ptdis(nearest);
+
+    for (; level > pt_level; level--) {
+        greedy_update_nearest(*this, ptdis, level, nearest, d_nearest);
+    }
+
+    for (; level >= 0; level--) {
+        std::priority_queue<NodeDistCloser> link_targets;
+        search_neighbors_to_add(
+                *this, ptdis, link_targets, nearest, d_nearest, level, vt);
+        ::faiss::shrink_neighbor_list(
+                ptdis, link_targets, nb_neighbors(level), keep_max_size_level0);
+
+        size_t begin, end;
+        neighbor_range(pt_id, level, &begin, &end);
+        while (!link_targets.empty() && begin < end) {
+            neighbors[begin++] = link_targets.top().id;
+            link_targets.pop();
+        }
+    }
+}
+
+void HNSW::add_reverse_links(
+        DistanceComputer& qdis,
+        storage_idx_t dest,
+        int level,
+        const storage_idx_t* srcs,
+        size_t n,
+        bool keep_max_size_level0) {
+    size_t begin, end;
+    neighbor_range(dest, level, &begin, &end);
+    size_t nfilled = begin;
+    while (nfilled < end && neighbors[nfilled] != -1) {
+        nfilled++;
+    }
+
+    if (nfilled + n <= end) {
+        // there is enough room for all of them
+        for (size_t i = 0; i < n; i++) {
+            neighbors[nfilled++] = srcs[i];
+        }
+        return;
+    }
+
+    // otherwise the old and the new neighbors fight out which to keep
+    std::priority_queue<NodeDistCloser> resultSet;
+    for (size_t i = begin; i < nfilled; i++) {
+        storage_idx_t neigh = neighbors[i];
+        resultSet.emplace(qdis.symmetric_dis(dest, neigh), neigh);
+    }
+    for (size_t i = 0; i < n; i++) {
+        resultSet.emplace(qdis.symmetric_dis(dest, srcs[i]), srcs[i]);
+    }
+
+    ::faiss::shrink_neighbor_list(
+            qdis, resultSet, end - begin, keep_max_size_level0);
+
+    size_t i = begin;
+    while (resultSet.size()) {
+        neighbors[i++] = resultSet.top().id;
+        resultSet.pop();
+    }
+    while (i < end) {
+        neighbors[i++] = -1;
+    }
+}
+
 /**************************************************************
  * Searching
  **************************************************************/
@@ -1154,8 +1237,8 @@ void HNSW::permute_entries(const idx_t* map) {
     }
     assert(new_offsets[ntotal] == offsets[ntotal]);
     // swap everyone
-    std::swap(levels, new_levels);
-    std::swap(offsets, new_offsets);
+    levels = std::move(new_levels);
+    offsets = std::move(new_offsets);
     neighbors = std::move(new_neighbors);
 }
 
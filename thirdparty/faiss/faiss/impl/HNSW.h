@@ -113,11 +113,11 @@ struct HNSW {
     std::vector<int> cum_nneighbor_per_level;
 
     /// level of each vector (base level = 1), size = ntotal
-    std::vector<int> levels;
+    MaybeOwnedVector<int> levels;
 
     /// offsets[i] is the offset in the neighbors array where vector i is stored
     /// size ntotal + 1
-    std::vector<size_t> offsets;
+    MaybeOwnedVector<size_t> offsets;
 
     /// neighbors[offsets[i]:offsets[i+1]] is the list of neighbors of vector i
     /// for all levels. this is where all storage goes.
@@ -198,6 +198,29 @@ struct HNSW {
             VisitedTable& vt,
             bool keep_max_size_level0 = false);
 
+    /** find the neighbors of point pt_id on all levels <= pt_level by
+     * searching the graph from entry_point, and write them to its own
+     * neighbor lists. No lock is taken: the caller guarantees that the
+     * searched part of the graph is not modified meanwhile and that
+     * pt_id is not reachable from it yet. */
+    void add_links_from_snapshot(
+            DistanceComputer& ptdis,
+            int pt_level,
+            storage_idx_t pt_id,
+            VisitedTable& vt,
+            bool keep_max_size_level0 = false);
+
+    /** add links from dest to the n points of srcs at a given level,
+     * pruning the neighbor list of dest once if it overflows. The
+     * neighbor list of dest must be owned by the caller. */
+    void add_reverse_links(
+            DistanceComputer& qdis,
+            storage_idx_t dest,
+            int level,
+            const storage_idx_t* srcs,
+            size_t n,
+            bool keep_max_size_level0 = false);
+
     /// search interface for 1 point, single thread
     HNSWStats search(
             DistanceComputer& qdis,
@@ -23,6 +23,15 @@ struct FactorsData {
     float sum_xb = 0;
 };
 
+// the factors of the extended code, for nb_bits > 1
+struct ExFactorsData {
+    // ||or - c||^2 / <o, ex_o>, for the extended code ex_o of
+    //   o = (or - c) / ||or - c||
+    float ex_dp_multiplier = 0;
+    // the error bound of the 1-bit distance is error_factor * ||qr - c||
+    float error_factor = 0;
+};
+
 struct QueryFactorsData {
     float c1 = 0;
     float c2 = 0;
@@ -32,12 +41,126 @@ struct QueryFactorsData {
     float qr_norm_L2sqr = 0;
 };
 
-static size_t get_code_size(const size_t d) {
-    return (d + 7) / 8 + sizeof(FactorsData);
+// the bound of the error of an estimate of sign bits is given with the
+//   confidence of epsilon_0 = 1.9 in the paper
+static constexpr float kErrorBoundEpsilon = 1.9f;
+
+// the number of scales that are tried for an extended code
+static constexpr size_t kExScaleSteps = 64;
+
+static size_t get_ex_code_size(const size_t d, const size_t nb_bits) {
+    return (nb_bits <= 1) ? 0
+                          : sizeof(ExFactorsData) + ((nb_bits - 1) * d + 7) / 8;
+}
+
+size_t RaBitQuantizer::compute_code_size(size_t d, size_t nb_bits) {
+    return (d + 7) / 8 + sizeof(FactorsData) + get_ex_code_size(d, nb_bits);
+}
+
+RaBitQuantizer::RaBitQuantizer(size_t d, MetricType metric, size_t nb_bits)
+        : Quantizer(d, compute_code_size(d, nb_bits)),
+          metric_type{metric},
+          nb_bits{nb_bits} {
+    FAISS_THROW_IF_NOT(nb_bits >= 1 && nb_bits <= 9);
 }
 
-RaBitQuantizer::RaBitQuantizer(size_t d, MetricType metric)
-        : Quantizer(d, get_code_size(d)), metric_type{metric} {}
+// the magnitude of the j-th dimension of an extended code
+static inline uint32_t get_ex_level(
+        const uint8_t* ex_code,
+        const size_t j,
+        const size_t ex_bits) {
+    const size_t bit = j * ex_bits;
+    const size_t byte = bit / 8;
+    const size_t shift = bit % 8;
+    uint32_t v = ex_code[byte] >> shift;
+    if (shift + ex_bits > 8) {
+        v |= uint32_t(ex_code[byte + 1]) << (8 - shift);
+    }
+    return v & ((1u << ex_bits) - 1);
+}
+
+static inline void set_ex_level(
+        uint8_t* ex_code,
+        const size_t j,
+        const size_t ex_bits,
+        const uint32_t v) {
+    const size_t bit = j * ex_bits;
+    const size_t byte = bit / 8;
+    const size_t shift = bit % 8;
+    ex_code[byte] |= uint8_t(v << shift);
+    if (shift + ex_bits > 8) {
+        ex_code[byte + 1] |= uint8_t(v >> (8 - shift));
+    }
+}
+
+// the extended code of a residual o = or - c: the dimension j is
+//   reconstructed as sign(o_j) * (level_j + 0.5). The levels are those of
+//   |o_j| * t for the scale t that maximizes the cosine between o and the
+//   reconstruction, out of kExScaleSteps of them.
+static void compute_ex_code(
+        const float* residual,
+        const size_t d,
+        const size_t ex_bits,
+        const float norm_L2sqr,
+        const float dp_oO,
+        uint8_t* ex_code) {
+    ExFactorsData* ex_fac = reinterpret_cast<ExFactorsData*>(ex_code);
+    uint8_t* levels = ex_code + sizeof(ExFactorsData);
+
+    const uint32_t max_level = (1u << ex_bits) - 1;
+    float max_abs = 0;
+    for (size_t j = 0; j < d; j++) {
+        max_abs = std::max(max_abs, std::abs(residual[j]));
+    }
+
+    float best_t = 0;
+    if (max_abs > 0) {
+        float best_cos = -1;
+        for (size_t step = 1; step <= kExScaleSteps; step++) {
+            const float t = (max_level + 1) * float(step) /
+                    (kExScaleSteps * max_abs);
+            float dp = 0;
+            float l2sqr = 0;
+            for (size_t j = 0; j < d; j++) {
+                const float a = std::abs(residual[j]);
+                const float level =
+                        std::min<float>(std::floor(a * t), max_level) + 0.5f;
+                dp += a * level;
+                l2sqr += level * level;
+            }
+            const float cos = dp / std::sqrt(l2sqr);
+            if (cos > best_cos) {
+                best_cos = cos;
+                best_t = t;
+            }
+        }
+    }
+
+    // <o, ex_o> against the unnormalized reconstruction
+    float dp_o_ex = 0;
+    for (size_t j = 0; j < d; j++) {
+        const float a = std::abs(residual[j]);
+        const uint32_t level =
+                std::min<uint32_t>(std::floor(a * best_t), max_level);
+        set_ex_level(levels, j, ex_bits, level);
+        dp_o_ex += a * (level + 0.5f);
+    }
+
+    // ||o|| * <o / ||o||, q> is estimated with ||o||^2 / <o, ex_o> * <ex_o, q>
+    ex_fac->ex_dp_multiplier =
+            (dp_o_ex < std::numeric_limits<float>::epsilon())
+            ? 0
+            : (norm_L2sqr / dp_o_ex);
+
+    // the bound of |<x, q> / <x, o> - <o, q>| for the unit vectors of the sign
+    //   code x and of o, scaled to the distance by 2 * ||o||
+    const float dp_sqr = dp_oO * dp_oO;
+    ex_fac->error_factor =
+            (d <= 1 || dp_sqr < std::numeric_limits<float>::epsilon())
+            ? std::numeric_limits<float>::max()
+            : 2 * std::sqrt(norm_L2sqr) * std::sqrt((1 - dp_sqr) / dp_sqr) *
+                    kErrorBoundEpsilon / std::sqrt(float(d - 1));
+}
 
 void RaBitQuantizer::train(size_t n, const float* x) {
     // does nothing
@@ -129,6 +252,21 @@ void RaBitQuantizer::compute_codes_core(
 
         fac->dp_multiplier = inv_dp_oO * std::sqrt(norm_L2sqr);
         fac->sum_xb = sum_xb;
+
+        if (nb_bits > 1) {
+            std::vector<float> residual(d);
+            for (size_t j = 0; j < d; j++) {
+                residual[j] = x[i * d + j] -
+                        ((centroid_in == nullptr) ? 0 : centroid_in[j]);
+            }
+            compute_ex_code(
+                    residual.data(),
+                    d,
+                    nb_bits - 1,
+                    norm_L2sqr,
+                    dp_oO,
+                    code + (d + 7) / 8 + sizeof(FactorsData));
+        }
     }
 }
 
@@ -136,6 +274,48 @@ void RaBitQuantizer::decode(const uint8_t* codes, float* x, size_t n) const {
     decode_core(codes, x, n, centroid);
 }
 
+// decodes a single code of dimensionality d
+static void decode_single_code(
+        const uint8_t* code,
+        float* x,
+        const size_t d,
+        const size_t nb_bits,
+        const float* centroid_in) {
+    const float inv_d_sqrt = (d == 0) ? 1.0f : (1.0f / std::sqrt((float)d));
+
+    // split the code into parts
+    const uint8_t* binary_data = code;
+    const FactorsData* fac =
+            reinterpret_cast<const FactorsData*>(code + (d + 7) / 8);
+
+    if (nb_bits > 1) {
+        const uint8_t* ex_code = code + (d + 7) / 8 + sizeof(FactorsData);
+        const ExFactorsData* ex_fac =
+                reinterpret_cast<const ExFactorsData*>(ex_code);
+        const uint8_t* levels = ex_code + sizeof(ExFactorsData);
+        for (size_t j = 0; j < d; j++) {
+            const uint8_t masker = (1 << (j % 8));
+            const float sign =
+                    ((binary_data[j / 8] & masker) == masker) ? 1 : -1;
+            const float level = get_ex_level(levels, j, nb_bits - 1) + 0.5f;
+            x[j] = sign * level * ex_fac->ex_dp_multiplier +
+                    ((centroid_in == nullptr) ? 0 : centroid_in[j]);
+        }
+        return;
+    }
+
+    //
+    for (size_t j = 0; j < d; j++) {
+        // extract i-th bit
+        const uint8_t masker = (1 << (j % 8));
+        const float bit = ((binary_data[j / 8] & masker) == masker) ? 1 : 0;
+
+        // compute the output code
+        x[j] = (bit - 0.5f) * fac->dp_multiplier * 2 * inv_d_sqrt +
+                ((centroid_in == nullptr) ? 0 : centroid_in[j]);
+    }
+}
+
 void RaBitQuantizer::decode_core(
         const uint8_t* codes,
         float* x,
@@ -144,31 +324,14 @@ void RaBitQuantizer::decode_core(
     FAISS_ASSERT(codes != nullptr);
     FAISS_ASSERT(x != nullptr);
 
-    const float inv_d_sqrt = (d == 0) ? 1.0f : (1.0f / std::sqrt((float)d));
-
 #pragma omp parallel for if (n > 1000)
     for (int64_t i = 0; i < n; i++) {
-        const uint8_t* code = codes + i * code_size;
-
-        // split the code into parts
-        const uint8_t* binary_data = code;
-        const FactorsData* fac =
-                reinterpret_cast<const FactorsData*>(code + (d + 7) / 8);
-
-        //
-        for (size_t j = 0; j < d; j++) {
-            // extract i-th bit
-            const uint8_t masker = (1 << (j % 8));
-            const float bit = ((binary_data[j / 8] & masker) == masker) ? 1 : 0;
-
-            // compute the output code
-            x[i * d + j] = (bit - 0.5f) * fac->dp_multiplier * 2 * inv_d_sqrt +
-                    ((centroid_in == nullptr) ? 0 : centroid_in[j]);
-        }
+        decode_single_code(
+                codes + i * code_size, x + i * d, d, nb_bits, centroid_in);
     }
 }
 
-struct RaBitDistanceComputer : FlatCodesDistanceComputer {
+struct RaBitDistanceComputer : RaBitQDistanceComputer {
     // dimensionality
     size_t d = 0;
     // a centroid to use
@@ -177,33 +340,115 @@ struct RaBitDistanceComputer : FlatCodesDistanceComputer {
     // the metric
     MetricType metric_type = MetricType::METRIC_L2;
 
+    // the rotated query (qr - c)
+    std::vector<float> rotated_q;
+    // some additional numbers for the query
+    QueryFactorsData query_fac;
+
+    // buffers for the reconstructed vectors of symmetric_dis()
+    std::vector<float> decoded_i;
+    std::vector<float> decoded_j;
+
     RaBitDistanceComputer();
 
+    // the extended estimate for nb_bits > 1
+    float distance_to_code(const uint8_t* code) override;
+
+    float error_bound(const uint8_t* code) const override;
+
+    // computed over the reconstructed vectors, so it is only as accurate as
+    //   sa_decode(). Good enough for selecting graph neighbors.
     float symmetric_dis(idx_t i, idx_t j) override;
+
+    // the distance for an estimate dp of ||or - c|| * <(or - c) / ||or - c||,
+    //   qr - c>, given or_c_l2sqr = ||or - c||^2 - (IP ? ||or||^2 : 0)
+    float distance_from_dp(const float or_c_l2sqr, const float dp) const {
+        // pre_dist = ||or - c||^2 + ||qr - c||^2 -
+        //     2 * ||or - c|| * ||qr - c|| * <q,o> - (IP ? ||or||^2 : 0)
+        const float pre_dist = or_c_l2sqr + query_fac.qr_to_c_L2sqr - 2 * dp;
+
+        if (metric_type == MetricType::METRIC_L2) {
+            // ||or - q||^ 2
+            return pre_dist;
+        } else {
+            // metric == MetricType::METRIC_INNER_PRODUCT
+
+            // this is ||q||^2
+            const float query_norm_sqr = query_fac.qr_norm_L2sqr;
+
+            // 2 * (or, q) = (||or - q||^2 - ||q||^2 - ||or||^2)
+            return -0.5f * (pre_dist - query_norm_sqr);
+        }
+    }
 };
 
 RaBitDistanceComputer::RaBitDistanceComputer() = default;
 
+float RaBitDistanceComputer::distance_to_code(const uint8_t* code) {
+    if (nb_bits <= 1) {
+        return distance_to_code_1bit(code);
+    }
+
+    const uint8_t* binary_data = code;
+    const FactorsData* fac =
+            reinterpret_cast<const FactorsData*>(code + (d + 7) / 8);
+    const uint8_t* ex_code = code + (d + 7) / 8 + sizeof(FactorsData);
+    const ExFactorsData* ex_fac =
+            reinterpret_cast<const ExFactorsData*>(ex_code);
+    const uint8_t* levels = ex_code + sizeof(ExFactorsData);
+    const size_t ex_bits = nb_bits - 1;
+
+    // <ex_o, qr - c>
+    float dot = 0;
+    for (size_t j = 0; j < d; j++) {
+        const uint8_t masker = (1 << (j % 8));
+        const float level = get_ex_level(levels, j, ex_bits) + 0.5f;
+        const float v = level * rotated_q[j];
+        dot += ((binary_data[j / 8] & masker) == masker) ? v : -v;
+    }
+
+    return distance_from_dp(
+            fac->or_minus_c_l2sqr, ex_fac->ex_dp_multiplier * dot);
+}
+
+float RaBitDistanceComputer::error_bound(const uint8_t* code) const {
+    FAISS_ASSERT(nb_bits > 1);
+    const ExFactorsData* ex_fac = reinterpret_cast<const ExFactorsData*>(
+            code + (d + 7) / 8 + sizeof(FactorsData));
+    const float bound =
+            ex_fac->error_factor * std::sqrt(query_fac.qr_to_c_L2sqr);
+    // the inner product is half of the distance term
+    return (metric_type == MetricType::METRIC_L2) ? bound : 0.5f * bound;
+}
+
 float RaBitDistanceComputer::symmetric_dis(idx_t i, idx_t j) {
-    FAISS_THROW_MSG("Not implemented");
+    FAISS_THROW_IF_NOT(codes != nullptr);
+
+    decoded_i.resize(d);
+    decoded_j.resize(d);
+    decode_single_code(
+            codes + i * code_size, decoded_i.data(), d, nb_bits, centroid);
+    decode_single_code(
+            codes + j * code_size, decoded_j.data(), d, nb_bits, centroid);
+
+    if (metric_type == MetricType::METRIC_INNER_PRODUCT) {
+        return fvec_inner_product(decoded_i.data(), decoded_j.data(), d);
+    } else {
+        return fvec_L2sqr(decoded_i.data(), decoded_j.data(), d);
+    }
 }
 
 struct RaBitDistanceComputerNotQ : RaBitDistanceComputer {
-    // the rotated query (qr - c)
-    std::vector<float> rotated_q;
-    // some additional numbers for the query
-    QueryFactorsData query_fac;
-
     RaBitDistanceComputerNotQ();
 
-    float distance_to_code(const uint8_t* code) override;
+    float distance_to_code_1bit(const uint8_t* code) override;
 
     void set_query(const float* x) override;
 };
 
 RaBitDistanceComputerNotQ::RaBitDistanceComputerNotQ() = default;
 
-float RaBitDistanceComputerNotQ::distance_to_code(const uint8_t* code) {
+float RaBitDistanceComputerNotQ::distance_to_code_1bit(const uint8_t* code) {
     FAISS_ASSERT(code != nullptr);
     FAISS_ASSERT(
             (metric_type == MetricType::METRIC_L2 ||
@@ -241,23 +486,7 @@ float RaBitDistanceComputerNotQ::distance_to_code(const uint8_t* code) {
     // this is ||or - c||^2 - (IP ? ||or||^2 : 0)
     const float or_c_l2sqr = fac->or_minus_c_l2sqr;
 
-    // pre_dist = ||or - c||^2 + ||qr - c||^2 -
-    //     2 * ||or - c|| * ||qr - c|| * <q,o> - (IP ? ||or||^2 : 0)
-    const float pre_dist = or_c_l2sqr + query_fac.qr_to_c_L2sqr -
-            2 * fac->dp_multiplier * final_dot;
-
-    if (metric_type == MetricType::METRIC_L2) {
-        // ||or - q||^ 2
-        return pre_dist;
-    } else {
-        // metric == MetricType::METRIC_INNER_PRODUCT
-
-        // this is ||q||^2
-        const float query_norm_sqr = query_fac.qr_norm_L2sqr;
-
-        // 2 * (or, q) = (||or - q||^2 - ||q||^2 - ||or||^2)
-        return -0.5f * (pre_dist - query_norm_sqr);
-    }
+    return distance_from_dp(or_c_l2sqr, fac->dp_multiplier * final_dot);
 }
 
 void RaBitDistanceComputerNotQ::set_query(const float* x) {
@@ -305,8 +534,6 @@ struct RaBitDistanceComputerQ : RaBitDistanceComputer {
     // we're using the proposed relayout-ed scheme from 3.3 that allows
     //    using popcounts for computing the distance.
     std::vector<uint8_t> rearranged_rotated_qq;
-    // some additional numbers for the query
-    QueryFactorsData query_fac;
 
     // the number of bits for SQ quantization of the query (qb > 0)
     uint8_t qb = 8;
@@ -315,14 +542,14 @@ struct RaBitDistanceComputerQ : RaBitDistanceComputer {
 
     RaBitDistanceComputerQ();
 
-    float distance_to_code(const uint8_t* code) override;
+    float distance_to_code_1bit(const uint8_t* code) override;
 
     void set_query(const float* x) override;
 };
 
 RaBitDistanceComputerQ::RaBitDistanceComputerQ() = default;
 
-float RaBitDistanceComputerQ::distance_to_code(const uint8_t* code) {
+float RaBitDistanceComputerQ::distance_to_code_1bit(const uint8_t* code) {
     FAISS_ASSERT(code != nullptr);
     FAISS_ASSERT(
             (metric_type == MetricType::METRIC_L2 ||
@@ -370,23 +597,7 @@ float RaBitDistanceComputerQ::distance_to_code(const uint8_t* code) {
     // this is ||or - c||^2 - (IP ? ||or||^2 : 0)
     const float or_c_l2sqr = fac->or_minus_c_l2sqr;
 
-    // pre_dist = ||or - c||^2 + ||qr - c||^2 -
-    //     2 * ||or - c|| * ||qr - c|| * <q,o> - (IP ? ||or||^2 : 0)
-    const float pre_dist = or_c_l2sqr + query_fac.qr_to_c_L2sqr -
-            2 * fac->dp_multiplier * final_dot;
-
-    if (metric_type == MetricType::METRIC_L2) {
-        // ||or - q||^ 2
-        return pre_dist;
-    } else {
-        // metric == MetricType::METRIC_INNER_PRODUCT
-
-        // this is ||q||^2
-        const float query_norm_sqr = query_fac.qr_norm_L2sqr;
-
-        // 2 * (or, q) = (||or - q||^2 - ||q||^2 - ||or||^2)
-        return -0.5f * (pre_dist - query_norm_sqr);
-    }
+    return distance_from_dp(or_c_l2sqr, fac->dp_multiplier * final_dot);
 }
 
 void RaBitDistanceComputerQ::set_query(const float* x) {
@@ -405,8 +616,8 @@ void RaBitDistanceComputerQ::set_query(const float* x) {
     // allocate space
     rotated_qq.resize(d);
 
-    // rotate the query
-    std::vector<float> rotated_q(d);
+    // rotate the query, the float one is kept for the extended codes
+    rotated_q.resize(d);
     for (size_t i = 0; i < d; i++) {
         rotated_q[i] = x[i] - ((centroid == nullptr) ? 0 : centroid[i]);
     }
@@ -475,7 +686,7 @@ void RaBitDistanceComputerQ::set_query(const float* x) {
     }
 }
 
-FlatCodesDistanceComputer* RaBitQuantizer::get_distance_computer(
+RaBitQDistanceComputer* RaBitQuantizer::get_distance_computer(
         uint8_t qb,
         const float* centroid_in) const {
     if (qb == 0) {
@@ -483,6 +694,7 @@ FlatCodesDistanceComputer* RaBitQuantizer::get_distance_computer(
         dc->metric_type = metric_type;
         dc->d = d;
         dc->centroid = centroid_in;
+        dc->nb_bits = nb_bits;
 
         return dc.release();
     } else {
@@ -491,6 +703,7 @@ FlatCodesDistanceComputer* RaBitQuantizer::get_distance_computer(
         dc->d = d;
         dc->centroid = centroid_in;
         dc->qb = qb;
+        dc->nb_bits = nb_bits;
 
         return dc.release();
     }
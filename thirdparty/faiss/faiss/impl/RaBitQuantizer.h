@@ -10,11 +10,36 @@
 
 namespace faiss {
 
+// the distance computer of RaBitQuantizer codes
+struct RaBitQDistanceComputer : FlatCodesDistanceComputer {
+    // the bits per dimension of the codes
+    size_t nb_bits = 1;
+
+    // the estimate of the distance from the sign bits only, what
+    //   distance_to_code() returns for nb_bits == 1
+    virtual float distance_to_code_1bit(const uint8_t* code) = 0;
+
+    // the bound of the error of distance_to_code_1bit() for nb_bits > 1, in
+    //   the units of the distance. The distance given by all the bits of a
+    //   code is expected to lie within it.
+    virtual float error_bound(const uint8_t* code) const = 0;
+};
+
 // the reference implementation of the https://arxiv.org/pdf/2405.12497
 //   Jianyang Gao, Cheng Long, "RaBitQ: Quantizing High-Dimensional Vectors
 //   with a Theoretical Error Bound for Approximate Nearest Neighbor Search".
 //
 // It is assumed that the Random Matrix Rotation is performed externally.
+//
+// nb_bits > 1 follows the extended RaBitQ of https://arxiv.org/pdf/2409.09913
+//   Jianyang Gao, Yutong Gou, Yuexuan Xu, Yongyi Yang, Cheng Long,
+//   Raymond Chi-Wing Wong, "Practical and Asymptotically Optimal Quantization
+//   of High-Dimensional Vectors in Euclidean Space for Approximate Nearest
+//   Neighbor Search". A code keeps the sign bits and their factors first, as
+//   for nb_bits == 1, then the error bound and the factor of the extended
+//   code, then nb_bits - 1 bits of the magnitude of every dimension. So a
+//   scan reads the magnitudes only for the candidates that the estimate of
+//   the sign bits can not rule out.
 struct RaBitQuantizer : Quantizer {
     // all RaBitQ operations are provided against a centroid, which needs
     //   to be provided Externally (!). Nullptr value implies that the centroid
@@ -31,11 +56,20 @@ struct RaBitQuantizer : Quantizer {
     //   possible. Thus, a quantizer has to introduce a metric.
     MetricType metric_type = MetricType::METRIC_L2;
 
-    RaBitQuantizer(size_t d = 0, MetricType metric = MetricType::METRIC_L2);
+    // the bits per dimension, 1 for the sign bit only, up to 9
+    size_t nb_bits = 1;
+
+    RaBitQuantizer(
+            size_t d = 0,
+            MetricType metric = MetricType::METRIC_L2,
+            size_t nb_bits = 1);
+
+    // the bytes of a code of d dimensions with nb_bits per dimension
+    static size_t compute_code_size(size_t d, size_t nb_bits);
 
     void train(size_t n, const float* x) override;
 
-    // every vector is expected to take (d + 7) / 8 + sizeof(FactorsData) bytes,
+    // every vector is expected to take compute_code_size(d, nb_bits) bytes
     void compute_codes(const float* x, uint8_t* codes, size_t n) const override;
 
     void compute_codes_core(
@@ -64,7 +98,7 @@ struct RaBitQuantizer : Quantizer {
     // returns the distance computer.
     // specify qb = 0 to get an DC that does not quantize a query
     // specify qb > 0 to have SQ qb-bits query
-    FlatCodesDistanceComputer* get_distance_computer(
+    RaBitQDistanceComputer* get_distance_computer(
             uint8_t qb,
             const float* centroid_in = nullptr) const;
 };
@@ -16,6 +16,7 @@
 #include <faiss/impl/IDSelector.h>
 #include <faiss/utils/Heap.h>
 #include <faiss/utils/partitioning.h>
+#include <faiss/utils/threshold_filter.h>
 #include <iostream>
 
 #include "knowhere/object.h"
@@ -266,6 +267,16 @@ struct HeapBlockResultHandler : BlockResultHandler<C, use_sel> {
             T* heap_dis = heap_dis_tab + i * k;
             TI* heap_ids = heap_ids_tab + i * k;
             const T* dis_tab_i = dis_tab + (j1 - j0) * (i - i0) - j0;
+            if constexpr (!use_sel && std::is_same_v<T, float>) {
+                heap_replace_top_filtered<C>(
+                        k,
+                        heap_dis,
+                        heap_ids,
+                        dis_tab_i + j0,
+                        j1 - j0,
+                        [&](const size_t j) { return j0 + j; });
+                continue;
+            }
             T thresh = heap_dis[0];
             for (size_t j = j0; j < j1; j++) {
                 if (this->is_in_selection(j)) {
@@ -169,6 +169,125 @@ SQDistanceComputer* ScalarQuantizer::get_distance_computer(
     return sq_get_distance_computer(metric, qtype, d, trained);
 }
 
+namespace {
+
+// see ScalarQuantizer::get_half_precision_distance_computer()
+template <typename T>
+struct HalfPrecisionSQDistanceComputer : ScalarQuantizer::SQDistanceComputer {
+    using dis_fn_t = float (*)(const T*, const T*, size_t);
+    using dis_batch_4_fn_t = void (*)(
+            const T*,
+            const T*,
+            const T*,
+            const T*,
+            const T*,
+            const size_t,
+            float&,
+            float&,
+            float&,
+            float&);
+
+    const size_t d;
+    // the hooks of the metric, read once
+    const dis_fn_t dis_fn;
+    const dis_batch_4_fn_t dis_batch_4_fn;
+    // the query in the type of the codes
+    std::vector<T> query;
+
+    HalfPrecisionSQDistanceComputer(
+            size_t d,
+            dis_fn_t dis_fn,
+            dis_batch_4_fn_t dis_batch_4_fn)
+            : d(d), dis_fn(dis_fn), dis_batch_4_fn(dis_batch_4_fn), query(d) {}
+
+    void set_query(const float* x) final {
+        q = x;
+        for (size_t i = 0; i < d; i++) {
+            query[i] = T(x[i]);
+        }
+    }
+
+    float query_to_code(const uint8_t* code) const override final {
+        return dis_fn(query.data(), (const T*)code, d);
+    }
+
+    float operator()(idx_t i) final {
+        return query_to_code(codes + i * code_size);
+    }
+
+    float symmetric_dis(idx_t i, idx_t j) override {
+        return dis_fn(
+                (const T*)(codes + i * code_size),
+                (const T*)(codes + j * code_size),
+                d);
+    }
+
+    void query_to_codes_batch_4(
+            const uint8_t* __restrict code_0,
+            const uint8_t* __restrict code_1,
+            const uint8_t* __restrict code_2,
+            const uint8_t* __restrict code_3,
+            float& dis0,
+            float& dis1,
+            float& dis2,
+            float& dis3) const override final {
+        dis_batch_4_fn(
+                query.data(),
+                (const T*)code_0,
+                (const T*)code_1,
+                (const T*)code_2,
+                (const T*)code_3,
+                d,
+                dis0,
+                dis1,
+                dis2,
+                dis3);
+    }
+
+    void distances_batch_4(
+            const idx_t idx0,
+            const idx_t idx1,
+            const idx_t idx2,
+            const idx_t idx3,
+            float& dis0,
+            float& dis1,
+            float& dis2,
+            float& dis3) override {
+        query_to_codes_batch_4(
+                codes + idx0 * code_size,
+                codes + idx1 * code_size,
+                codes + idx2 * code_size,
+                codes + idx3 * code_size,
+                dis0,
+                dis1,
+                dis2,
+                dis3);
+    }
+};
+
+} // namespace
+
+SQDistanceComputer* ScalarQuantizer::get_half_precision_distance_computer(
+        MetricType metric) const {
+    FAISS_THROW_IF_NOT(metric == METRIC_L2 || metric == METRIC_INNER_PRODUCT);
+    const bool is_ip = (metric == METRIC_INNER_PRODUCT);
+    if (qtype == QT_fp16) {
+        return new HalfPrecisionSQDistanceComputer<knowhere::fp16>(
+                d,
+                is_ip ? fp16_vec_inner_product : fp16_vec_L2sqr,
+                is_ip ? fp16_vec_inner_product_batch_4
+                      : fp16_vec_L2sqr_batch_4);
+    }
+    if (qtype == QT_bf16) {
+        return new HalfPrecisionSQDistanceComputer<knowhere::bf16>(
+                d,
+                is_ip ? bf16_vec_inner_product : bf16_vec_L2sqr,
+                is_ip ? bf16_vec_inner_product_batch_4
+                      : bf16_vec_L2sqr_batch_4);
+    }
+    return nullptr;
+}
+
 size_t ScalarQuantizer::cal_size() const {
     return sizeof(*this) + trained.size() * sizeof(float);
 }
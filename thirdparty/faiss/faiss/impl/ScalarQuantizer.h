@@ -128,6 +128,14 @@ struct ScalarQuantizer : Quantizer {
     SQDistanceComputer* get_distance_computer(
             MetricType metric = METRIC_L2) const;
 
+    /// a distance computer of QT_fp16 or QT_bf16 codes for the queries that
+    /// are exactly representable in the type of the codes, e.g. those of a
+    /// fp16 collection. The query is converted to that type once and scored
+    /// against the codes in it with the half-precision kernels, without
+    /// decoding the codes to fp32. nullptr for the other types.
+    SQDistanceComputer* get_half_precision_distance_computer(
+            MetricType metric = METRIC_L2) const;
+
     InvertedListScanner* select_InvertedListScanner(
             MetricType mt,
             const Index* quantizer,
@@ -7,6 +7,7 @@
 
 #include <faiss/impl/ScalarQuantizerDC_neon.h>
 #include <faiss/impl/ScalarQuantizerCodec_neon.h>
+#include <faiss/impl/ScalarQuantizerInterleaved.h>
 
 namespace faiss {
 
@@ -66,4 +67,16 @@ InvertedListScanner* sq_select_inverted_list_scanner_neon(
     }
 }
 
+InvertedListScanner* sq_select_interleaved_scanner_neon(
+        MetricType mt,
+        const ScalarQuantizer* sq,
+        const Index* quantizer,
+        size_t nvec,
+        bool store_pairs,
+        const IDSelector* sel,
+        bool by_residual) {
+    return sel0_interleaved_scanner(
+            mt, sq, quantizer, nvec, store_pairs, sel, by_residual);
+}
+
 } // namespace faiss
@@ -34,4 +34,13 @@ InvertedListScanner* sq_select_inverted_list_scanner_neon(
         const IDSelector* sel,
         bool by_residual);
 
+InvertedListScanner* sq_select_interleaved_scanner_neon(
+        MetricType mt,
+        const ScalarQuantizer* sq,
+        const Index* quantizer,
+        size_t nvec,
+        bool store_pairs,
+        const IDSelector* sel,
+        bool by_residual);
+
 } // namespace faiss
@@ -0,0 +1,312 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <faiss/IndexIVF.h>
+#include <faiss/impl/FaissAssert.h>
+#include <faiss/impl/IDSelector.h>
+#include <faiss/impl/ScalarQuantizer.h>
+#include <faiss/utils/Heap.h>
+
+namespace faiss {
+
+/*******************************************************************
+ * Scanners of the IndexIVFScalarQuantizer lists whose codes are interleaved
+ * by CodePackerInterleaved: byte b of the code at offset j of a block of NVEC
+ * codes is at b * NVEC + j.
+ *
+ * The distances of a query to all the codes of a block are accumulated byte
+ * by byte, in loops over the NVEC codes that the compiler vectorizes with the
+ * instruction set of the file that includes this header. Every
+ * ScalarQuantizerDC*.cpp gets its own copy, hence the internal linkage.
+ ********************************************************************/
+
+namespace {
+
+template <size_t NVEC, bool IS_IP, bool IS_4BIT>
+struct IVFSQInterleavedScanner : InvertedListScanner {
+    const Index* quantizer;
+    bool by_residual;
+    size_t d;
+
+    // the decoded dimension i of a code c is vmin[i] + (c + 0.5) * step[i],
+    //   the padding dimension of the odd 4-bit codes has a zero step
+    std::vector<float> vmin;
+    std::vector<float> step;
+
+    // L2: q[i] - vmin[i] - 0.5 * step[i], so that the difference with the
+    //   dimension i of a code c is qa[i] - c * step[i]. IP: q[i] * step[i]
+    std::vector<float> qa;
+    // IP: the part of the inner products that doesn't depend on the codes,
+    //   the coarse distance included
+    float accu0 = 0;
+    float ip_base = 0;
+
+    const float* x = nullptr;
+    std::vector<float> residual;
+
+    IVFSQInterleavedScanner(
+            const ScalarQuantizer& sq,
+            const Index* quantizer,
+            bool store_pairs,
+            const IDSelector* sel,
+            bool by_residual)
+            : InvertedListScanner(store_pairs, sel),
+              quantizer(quantizer),
+              by_residual(by_residual),
+              d(sq.d),
+              residual(sq.d) {
+        this->code_size = sq.code_size;
+        this->keep_max = IS_IP;
+
+        const bool uniform = sq.qtype == ScalarQuantizer::QT_8bit_uniform ||
+                sq.qtype == ScalarQuantizer::QT_4bit_uniform;
+        const float levels = IS_4BIT ? 15.0f : 255.0f;
+        const size_t n_dims = IS_4BIT ? code_size * 2 : code_size;
+        vmin.assign(n_dims, 0.0f);
+        step.assign(n_dims, 0.0f);
+        qa.assign(n_dims, 0.0f);
+        for (size_t i = 0; i < d; i++) {
+            vmin[i] = uniform ? sq.trained[0] : sq.trained[i];
+            step[i] = (uniform ? sq.trained[1] : sq.trained[d + i]) / levels;
+        }
+    }
+
+    void prepare_query(const float* q) {
+        ip_base = 0;
+        for (size_t i = 0; i < d; i++) {
+            if (IS_IP) {
+                qa[i] = q[i] * step[i];
+                ip_base += q[i] * (vmin[i] + 0.5f * step[i]);
+            } else {
+                qa[i] = q[i] - vmin[i] - 0.5f * step[i];
+            }
+        }
+    }
+
+    void set_query(const float* query) override {
+        x = query;
+        if (IS_IP || !by_residual) {
+            prepare_query(query);
+        }
+    }
+
+    void set_list(idx_t list_no, float coarse_dis) override {
+        this->list_no = list_no;
+        if (IS_IP) {
+            accu0 = (by_residual ? coarse_dis : 0) + ip_base;
+        } else if (by_residual) {
+            quantizer->compute_residual(x, residual.data(), list_no);
+            prepare_query(residual.data());
+        }
+    }
+
+    inline float distance_to_component(size_t i, int c) const {
+        if (IS_IP) {
+            return qa[i] * c;
+        }
+        const float t = qa[i] - c * step[i];
+        return t * t;
+    }
+
+    // a row-major code, as given by CodePackerInterleaved::unpack_1()
+    float distance_to_code(const uint8_t* code) const final {
+        float accu = 0;
+        for (size_t b = 0; b < code_size; b++) {
+            if (IS_4BIT) {
+                accu += distance_to_component(2 * b, code[b] & 0xf);
+                accu += distance_to_component(2 * b + 1, code[b] >> 4);
+            } else {
+                accu += distance_to_component(b, code[b]);
+            }
+        }
+        return IS_IP ? accu0 + accu : accu;
+    }
+
+    // the distances to the NVEC codes of a block
+    void distance_to_block(const uint8_t* block, float* dis) const {
+        float accu[NVEC] = {};
+        for (size_t b = 0; b < code_size; b++) {
+            const uint8_t* c = block + b * NVEC;
+            if (IS_4BIT) {
+                const float a0 = qa[2 * b], s0 = step[2 * b];
+                const float a1 = qa[2 * b + 1], s1 = step[2 * b + 1];
+                for (size_t j = 0; j < NVEC; j++) {
+                    const float c0 = c[j] & 0xf;
+                    const float c1 = c[j] >> 4;
+                    if (IS_IP) {
+                        accu[j] += a0 * c0 + a1 * c1;
+                    } else {
+                        const float t0 = a0 - c0 * s0;
+                        const float t1 = a1 - c1 * s1;
+                        accu[j] += t0 * t0 + t1 * t1;
+                    }
+                }
+            } else {
+                const float a = qa[b], s = step[b];
+                for (size_t j = 0; j < NVEC; j++) {
+                    const float cj = c[j];
+                    if (IS_IP) {
+                        accu[j] += a * cj;
+                    } else {
+                        const float t = a - cj * s;
+                        accu[j] += t * t;
+                    }
+                }
+            }
+        }
+        const float base = IS_IP ? accu0 : 0;
+        for (size_t j = 0; j < NVEC; j++) {
+            dis[j] = base + accu[j];
+        }
+    }
+
+    // calls apply(j, dis) on the codes accepted by the selector
+    template <class Apply>
+    void scan_blocks(
+            size_t list_size,
+            const uint8_t* codes,
+            const idx_t* ids,
+            Apply apply) const {
+        float dis[NVEC];
+        bool accepted[NVEC];
+        for (size_t j0 = 0; j0 < list_size; j0 += NVEC) {
+            const size_t n = std::min(NVEC, list_size - j0);
+            size_t n_accepted = n;
+            if (sel != nullptr) {
+                n_accepted = 0;
+                for (size_t j = 0; j < n; j++) {
+                    accepted[j] = sel->is_member(
+                            store_pairs ? j0 + j : ids[j0 + j]);
+                    n_accepted += accepted[j];
+                }
+                // the whole block is filtered out
+                if (n_accepted == 0) {
+                    continue;
+                }
+            }
+            distance_to_block(codes + j0 * code_size, dis);
+            for (size_t j = 0; j < n; j++) {
+                if (sel == nullptr || accepted[j]) {
+                    apply(j0 + j, dis[j]);
+                }
+            }
+        }
+    }
+
+    size_t scan_codes(
+            size_t list_size,
+            const uint8_t* codes,
+            const float* code_norms,
+            const idx_t* ids,
+            float* simi,
+            idx_t* idxi,
+            size_t k,
+            size_t& scan_cnt) const override {
+        size_t nup = 0;
+        scan_blocks(list_size, codes, ids, [&](size_t j, float dis) {
+            scan_cnt++;
+            if (IS_IP ? dis > simi[0] : dis < simi[0]) {
+                int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
+                if (IS_IP) {
+                    minheap_replace_top(k, simi, idxi, dis, id);
+                } else {
+                    maxheap_replace_top(k, simi, idxi, dis, id);
+                }
+                nup++;
+            }
+        });
+        return nup;
+    }
+
+    void scan_codes_and_return(
+            size_t list_size,
+            const uint8_t* codes,
+            const float* code_norms,
+            const idx_t* ids,
+            std::vector<knowhere::DistId>& out) const override {
+        scan_blocks(list_size, codes, ids, [&](size_t j, float dis) {
+            out.emplace_back(ids[j], dis);
+        });
+    }
+
+    void scan_codes_range(
+            size_t list_size,
+            const uint8_t* codes,
+            const float* code_norms,
+            const idx_t* ids,
+            float radius,
+            RangeQueryResult& res) const override {
+        scan_blocks(list_size, codes, ids, [&](size_t j, float dis) {
+            if (IS_IP ? dis > radius : dis < radius) {
+                int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
+                res.add(dis, id);
+            }
+        });
+    }
+};
+
+template <size_t NVEC>
+InvertedListScanner* sel_interleaved_scanner(
+        MetricType mt,
+        const ScalarQuantizer* sq,
+        const Index* quantizer,
+        bool store_pairs,
+        const IDSelector* sel,
+        bool by_residual) {
+    const bool is_4bit = sq->qtype == ScalarQuantizer::QT_4bit ||
+            sq->qtype == ScalarQuantizer::QT_4bit_uniform;
+    if (mt == METRIC_L2) {
+        if (is_4bit) {
+            return new IVFSQInterleavedScanner<NVEC, false, true>(
+                    *sq, quantizer, store_pairs, sel, by_residual);
+        }
+        return new IVFSQInterleavedScanner<NVEC, false, false>(
+                *sq, quantizer, store_pairs, sel, by_residual);
+    } else if (mt == METRIC_INNER_PRODUCT) {
+        if (is_4bit) {
+            return new IVFSQInterleavedScanner<NVEC, true, true>(
+                    *sq, quantizer, store_pairs, sel, by_residual);
+        }
+        return new IVFSQInterleavedScanner<NVEC, true, false>(
+                *sq, quantizer, store_pairs, sel, by_residual);
+    }
+    FAISS_THROW_MSG("unsupported metric type");
+}
+
+inline InvertedListScanner* sel0_interleaved_scanner(
+        MetricType mt,
+        const ScalarQuantizer* sq,
+        const Index* quantizer,
+        size_t nvec,
+        bool store_pairs,
+        const IDSelector* sel,
+        bool by_residual) {
+    FAISS_THROW_IF_NOT_MSG(
+            sq->qtype == ScalarQuantizer::QT_8bit ||
+                    sq->qtype == ScalarQuantizer::QT_8bit_uniform ||
+                    sq->qtype == ScalarQuantizer::QT_4bit ||
+                    sq->qtype == ScalarQuantizer::QT_4bit_uniform,
+            "interleaved codes support 8-bit and 4-bit quantizers only");
+    if (nvec == 16) {
+        return sel_interleaved_scanner<16>(
+                mt, sq, quantizer, store_pairs, sel, by_residual);
+    } else if (nvec == 32) {
+        return sel_interleaved_scanner<32>(
+                mt, sq, quantizer, store_pairs, sel, by_residual);
+    }
+    FAISS_THROW_FMT("unsupported interleaved block of %zd vectors", nvec);
+}
+
+} // namespace
+
+} // namespace faiss
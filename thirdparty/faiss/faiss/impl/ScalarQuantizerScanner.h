@@ -7,6 +7,7 @@
 //struct IDSelector;
 
 #include <faiss/utils/distances_if.h>
+#include <faiss/utils/threshold_filter.h>
 
 namespace faiss {
 
@@ -115,7 +116,6 @@ struct IVFSQScannerIP : InvertedListScanner {
             idx_t* idxi,
             size_t k,
             size_t& scan_cnt) const override {
-        size_t nup = 0;
         // baseline
         // for (size_t j = 0; j < list_size; j++, codes += code_size) {
         //     if (use_sel && !sel->is_member(use_sel == 1 ? ids[j] : j)) {
@@ -137,20 +137,20 @@ struct IVFSQScannerIP : InvertedListScanner {
             return (!use_sel || sel->is_member(use_sel == 1 ? ids[j] : j));
         };
 
+        auto heap = make_threshold_filtered_heap<CMin<float, idx_t>>(
+                k, simi, idxi, [&](const size_t j) -> idx_t {
+                    return store_pairs ? lo_build(list_no, j) : ids[j];
+                });
+
         // the lambda that applies a filtered element.
         auto apply = [&](const float dis_in, const size_t j) {
-            const float dis = accu0 + dis_in;
-            if (dis > simi[0]) {
-                int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
-                minheap_replace_top(k, simi, idxi, dis, id);
-                nup++;
-            }
+            heap.add(accu0 + dis_in, j);
         };
 
         // compute distances
         fvec_distance_ny_scalar_if(
                 dc, codes, code_size, list_size, filter, apply);
-        return nup;
+        return heap.flush();
     }
 
     void scan_codes_and_return(
@@ -258,8 +258,6 @@ struct IVFSQScannerL2 : InvertedListScanner {
             idx_t* idxi,
             size_t k,
             size_t& scan_cnt) const override {
-        size_t nup = 0;
-
         // // baseline
         // for (size_t j = 0; j < list_size; j++, codes += code_size) {
         //     if (use_sel && !sel->is_member(use_sel == 1 ? ids[j] : j)) {
@@ -279,21 +277,22 @@ struct IVFSQScannerL2 : InvertedListScanner {
         auto filter = 
             [&](const size_t j) { return (!use_sel || sel->is_member(use_sel == 1 ? ids[j] : j)); };
 
+        auto heap = make_threshold_filtered_heap<CMax<float, idx_t>>(
+                k, simi, idxi, [&](const size_t j) -> idx_t {
+                    return store_pairs ? lo_build(list_no, j) : ids[j];
+                });
+
         // the lambda that applies a filtered element.
         auto apply = 
             [&](const float dis, const size_t j) {
-                if (dis < simi[0]) {
-                    int64_t id = store_pairs ? lo_build(list_no, j) : ids[j];
-                    maxheap_replace_top(k, simi, idxi, dis, id);
-                    nup++;
-                }
+                heap.add(dis, j);
             };
 
         // compute distances
         fvec_distance_ny_scalar_if(
                 dc, codes, code_size, list_size, filter, apply);
 
-        return nup;
+        return heap.flush();
     }
 
     void scan_codes_and_return(
@@ -22,6 +22,8 @@
 #include <faiss/impl/io_macros.h>
 #include <faiss/utils/hamming.h>
 
+#include <faiss/impl/CodePacker.h>
+#include <faiss/invlists/BlockInvertedLists.h>
 #include <faiss/invlists/InvertedListsIOHook.h>
 #include <faiss/invlists/OnDiskInvertedLists.h>
 
@@ -669,8 +671,8 @@ static void read_ScalarQuantizer(ScalarQuantizer* ivsc, IOReader* f) {
 static void read_HNSW(HNSW* hnsw, IOReader* f) {
     READVECTOR(hnsw->assign_probas);
     READVECTOR(hnsw->cum_nneighbor_per_level);
-    READVECTOR(hnsw->levels);
-    READVECTOR(hnsw->offsets);
+    read_vector(hnsw->levels, f);
+    read_vector(hnsw->offsets, f);
     read_vector(hnsw->neighbors, f);
 
     READ1(hnsw->entry_point);
@@ -747,6 +749,20 @@ static void read_RaBitQuantizer(RaBitQuantizer* rabitq, IOReader* f) {
     READ1(rabitq->d);
     READ1(rabitq->code_size);
     READ1(rabitq->metric_type);
+    // the bits per dimension are told by the code size
+    rabitq->nb_bits = 0;
+    for (size_t nb_bits = 1; nb_bits <= 9; nb_bits++) {
+        if (RaBitQuantizer::compute_code_size(rabitq->d, nb_bits) ==
+            rabitq->code_size) {
+            rabitq->nb_bits = nb_bits;
+            break;
+        }
+    }
+    FAISS_THROW_IF_NOT_FMT(
+            rabitq->nb_bits > 0,
+            "invalid code size %zd of a RaBitQuantizer of %zd dimensions",
+            rabitq->code_size,
+            rabitq->d);
 }
 
 static void read_direct_map(DirectMap* dm, IOReader* f) {
@@ -1222,6 +1238,13 @@ Index* read_index(IOReader* f, int io_flags) {
             READ1(ivsc->by_residual);
         }
         read_InvertedLists(ivsc, f, io_flags);
+        // the packer of interleaved lists is not stored
+        if (auto bil = dynamic_cast<BlockInvertedLists*>(ivsc->invlists)) {
+            FAISS_THROW_IF_NOT(
+                    bil->block_size == bil->n_per_block * ivsc->code_size);
+            bil->packer = new CodePackerInterleaved(
+                    ivsc->code_size, bil->n_per_block);
+        }
         idx = ivsc;
     } else if (
             h == fourcc("IwLS") || h == fourcc("IwRQ") || h == fourcc("IwPL") ||
@@ -1367,7 +1390,7 @@ Index* read_index(IOReader* f, int io_flags) {
             h == fourcc("IHNf") || h == fourcc("IHNp") || h == fourcc("IHNs") ||
             h == fourcc("IHN2") || h == fourcc("IHNc") || h == fourcc("IHN9") ||
             h == fourcc("IHN8") || h == fourcc("IHN7") || h == fourcc("IHN6") ||
-            h == fourcc("IHN5")) {
+            h == fourcc("IHN5") || h == fourcc("IHN4") || h == fourcc("IHN3")) {
         IndexHNSW* idxhnsw = nullptr;
         if (h == fourcc("IHNf"))
             idxhnsw = new IndexHNSWFlat();
@@ -1389,6 +1412,10 @@ Index* read_index(IOReader* f, int io_flags) {
             idxhnsw = new IndexHNSWProductResidualQuantizer();
         if (h == fourcc("IHN5"))
             idxhnsw = new IndexHNSWProductResidualQuantizerCosine();
+        if (h == fourcc("IHN4"))
+            idxhnsw = new IndexHNSWRaBitQ();
+        if (h == fourcc("IHN3"))
+            idxhnsw = new IndexHNSWRaBitQCosine();
         read_index_header(idxhnsw, f);
         if (h == fourcc("IHNc")) {
             READ1(idxhnsw->keep_max_size_level0);
@@ -1502,6 +1529,17 @@ Index* read_index(IOReader* f, int io_flags) {
         READ1(idxq->qb);
         idxq->code_size = idxq->rabitq.code_size;
         idx = idxq;
+    } else if (h == fourcc("IxrC")) {
+        IndexRaBitQCosine* idxq = new IndexRaBitQCosine();
+        read_index_header(idxq, f);
+        read_RaBitQuantizer(&idxq->rabitq, f);
+        read_vector(idxq->codes, f);
+        READVECTOR(idxq->center);
+        READ1(idxq->qb);
+        idxq->code_size = idxq->rabitq.code_size;
+        // read inverse norms
+        READVECTOR(idxq->inverse_norms_storage.inverse_l2_norms);
+        idx = idxq;
     } else if (h == fourcc("IwrQ")) {
         // using 'IwrQ' instead of baseline's 'Iwrq'
         IndexIVFRaBitQ* ivrq = new IndexIVFRaBitQ();
@@ -1004,6 +1004,8 @@ void write_index(const Index* idx, IOWriter* f, int io_flags) {
                 : dynamic_cast<const IndexHNSWPQCosine*>(idx)   ? fourcc("IHN7")
                 : dynamic_cast<const IndexHNSWProductResidualQuantizer*>(idx)   ? fourcc("IHN6")
                 : dynamic_cast<const IndexHNSWProductResidualQuantizerCosine*>(idx)   ? fourcc("IHN5")
+                : dynamic_cast<const IndexHNSWRaBitQ*>(idx)   ? fourcc("IHN4")
+                : dynamic_cast<const IndexHNSWRaBitQCosine*>(idx)   ? fourcc("IHN3")
                                                                 : 0;
         FAISS_THROW_IF_NOT(h != 0);
         WRITE1(h);
@@ -1095,6 +1097,18 @@ void write_index(const Index* idx, IOWriter* f, int io_flags) {
         WRITE1(h);
         write_index_header(imm_2, f);
         write_index(imm_2->index, f);
+    } else if (
+            const IndexRaBitQCosine* idxq =
+                    dynamic_cast<const IndexRaBitQCosine*>(idx)) {
+        uint32_t h = fourcc("IxrC");
+        WRITE1(h);
+        write_index_header(idx, f);
+        write_RaBitQuantizer(&idxq->rabitq, f);
+        WRITEVECTOR(idxq->codes);
+        WRITEVECTOR(idxq->center);
+        WRITE1(idxq->qb);
+        // inverse norms
+        WRITEVECTOR(idxq->inverse_norms_storage.inverse_l2_norms);
     } else if (const IndexRaBitQ* idxq = dynamic_cast<const IndexRaBitQ*>(idx)) {
         // using 'IxrQ' instead of baseline's 'Ixrq'
         uint32_t h = fourcc("IxrQ");
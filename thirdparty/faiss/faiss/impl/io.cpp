@@ -196,6 +196,23 @@ size_t BlockFileIOWriter::flush_and_write(const char* ptr, size_t bytes) {
     return write(ptr, bytes);
 }
 
+size_t BlockFileIOWriter::reserve_blocks(size_t n) {
+    flush();
+    FAISS_THROW_IF_NOT_FMT(
+            fflush(f) == 0,
+            "could not flush %s: %s",
+            name.c_str(),
+            strerror(errno));
+    size_t pos = tellg();
+    current_block_id += n;
+    FAISS_THROW_IF_NOT_FMT(
+            fseek(f, tellg(), SEEK_SET) == 0,
+            "could not seek %s: %s",
+            name.c_str(),
+            strerror(errno));
+    return pos;
+}
+
 size_t BlockFileIOWriter::operator()(
         const void* ptr,
         size_t size,
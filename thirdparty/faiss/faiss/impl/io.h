@@ -125,6 +125,10 @@ struct BlockFileIOWriter : FileIOWriter {
 
     size_t flush_and_write(const char* ptr, size_t bytes);
 
+    // flushes and skips n blocks, which the caller writes with positioned
+    // writes on filedescriptor(). Returns the offset of the first one.
+    size_t reserve_blocks(size_t n);
+
     size_t get_current_block_id() {
         return current_block_id;
     }
@@ -716,6 +716,40 @@ void ConcurrentArrayInvertedLists::update_entries(
     assert(rest_entry == 0);
 }
 
+size_t ConcurrentArrayInvertedLists::append_entries(
+        size_t list_no,
+        size_t n_entry,
+        const idx_t* ids_in,
+        const encode_entries_t& encode) {
+    FAISS_THROW_IF_NOT_MSG(
+            !save_norm, "append_entries does not support code norms");
+    assert(list_no < nlist);
+    size_t o = list_size(list_no);
+    if (n_entry == 0) {
+        return o;
+    }
+    reserve(list_no, o + n_entry);
+
+    // the pieces of the append that fall in a single segment
+    const int64_t first_segment = o / segment_size;
+    const int64_t n_segment =
+            cal_segment_num(o + n_entry) - first_segment;
+#pragma omp parallel for if (n_segment > 1)
+    for (int64_t s = 0; s < n_segment; s++) {
+        const size_t segment_no = first_segment + s;
+        const size_t e0 = std::max(o, segment_no * segment_size) - o;
+        const size_t e1 =
+                std::min(o + n_entry, (segment_no + 1) * segment_size) - o;
+        const size_t segment_off = (o + e0) % segment_size;
+        memcpy(&ids[list_no][segment_no][segment_off],
+               ids_in + e0,
+               (e1 - e0) * sizeof(ids_in[0]));
+        encode(e0, e1, &codes[list_no][segment_no][segment_off]);
+    }
+    list_cur[list_no].store(o + n_entry);
+    return o;
+}
+
 InvertedLists* ConcurrentArrayInvertedLists::to_readonly() {
     return InvertedLists::to_readonly();
 }
@@ -735,6 +769,22 @@ void ConcurrentArrayInvertedLists::resize(size_t list_no, size_t new_size) {
     }
 
 }
+size_t ConcurrentArrayInvertedLists::add_list() {
+    // the atomics can not be moved, the sizes are copied to a larger vector
+    std::vector<std::atomic<size_t>> new_cur(nlist + 1);
+    for (size_t i = 0; i < nlist; i++) {
+        new_cur[i].store(list_cur[i].load());
+    }
+    new_cur[nlist].store(0);
+    list_cur.swap(new_cur);
+    ids.emplace_back();
+    codes.emplace_back();
+    if (save_norm) {
+        code_norms.emplace_back();
+    }
+    return nlist++;
+}
+
 size_t ConcurrentArrayInvertedLists::get_segment_num(size_t list_no) const {
     assert(list_no < nlist);
     auto o = list_cur[list_no].load();
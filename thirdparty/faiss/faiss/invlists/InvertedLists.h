@@ -18,6 +18,7 @@
 #include <atomic>
 #include <cassert>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <set>
 #include <vector>
@@ -443,10 +444,31 @@ struct ConcurrentArrayInvertedLists : InvertedLists {
             const idx_t* ids,
             const uint8_t* code) override;
 
+    /// writes the codes of entries [i0, i1) of an append to codes
+    using encode_entries_t =
+            std::function<void(size_t i0, size_t i1, uint8_t* codes)>;
+
+    /** appends n_entry entries for a single writer, without a copy of their
+     * codes: the segments of the append are filled by encode in place, in
+     * parallel, and the entries are published at once when all of them are
+     * written. Lists with code norms are not supported.
+     *
+     * @return the offset of the first entry
+     */
+    size_t append_entries(
+            size_t list_no,
+            size_t n_entry,
+            const idx_t* ids,
+            const encode_entries_t& encode);
+
     InvertedLists* to_readonly() override;
 
     void resize(size_t list_no, size_t new_size) override;
 
+    /// appends an empty list and returns its number. Not thread safe with
+    /// any reader or writer of the lists.
+    size_t add_list();
+
     ~ConcurrentArrayInvertedLists() override;
 
     size_t segment_size;
@@ -16,6 +16,9 @@
 
 #include <omp.h>
 
+#include <algorithm>
+#include <type_traits>
+
 #include <faiss/impl/IDSelector.h>
 #include <faiss/utils/hamming.h>
 #include <faiss/utils/jaccard-inl.h>
@@ -360,6 +363,69 @@ void binary_knn_mc(
     }
 }
 
+namespace {
+
+// the codes scored at once by the u8_*_distance_ny kernels
+constexpr size_t binary_knn_block_size = 256;
+
+struct HammingComputerNy {
+    const uint8_t* a = nullptr;
+    size_t code_size = 0;
+
+    HammingComputerNy() = default;
+
+    HammingComputerNy(const uint8_t* a8, size_t code_size) {
+        set(a8, code_size);
+    }
+
+    void set(const uint8_t* a8, size_t code_size_2) {
+        a = a8;
+        code_size = code_size_2;
+    }
+
+    // n is at most binary_knn_block_size
+    template <typename T>
+    void compute_ny(const uint8_t* b8, size_t n, T* dis) const {
+        if constexpr (std::is_same_v<T, int>) {
+            u8_hamming_distance_ny(a, b8, code_size, n, dis);
+        } else {
+            int tmp[binary_knn_block_size];
+            u8_hamming_distance_ny(a, b8, code_size, n, tmp);
+            std::copy(tmp, tmp + n, dis);
+        }
+    }
+};
+
+struct JaccardComputerNy {
+    const uint8_t* a = nullptr;
+    size_t code_size = 0;
+
+    JaccardComputerNy() = default;
+
+    JaccardComputerNy(const uint8_t* a8, size_t code_size) {
+        set(a8, code_size);
+    }
+
+    void set(const uint8_t* a8, size_t code_size_2) {
+        a = a8;
+        code_size = code_size_2;
+    }
+
+    // n is at most binary_knn_block_size
+    template <typename T>
+    void compute_ny(const uint8_t* b8, size_t n, T* dis) const {
+        if constexpr (std::is_same_v<T, float>) {
+            u8_jaccard_distance_ny(a, b8, code_size, n, dis);
+        } else {
+            float tmp[binary_knn_block_size];
+            u8_jaccard_distance_ny(a, b8, code_size, n, tmp);
+            std::copy(tmp, tmp + n, dis);
+        }
+    }
+};
+
+} // namespace
+
 template <class C, class MetricComputer>
 void binary_knn_hc(
         int bytes_per_code,
@@ -405,19 +471,25 @@ void binary_knn_hc(
             hc[i].set(bs1 + i * bytes_per_code, bytes_per_code);
         }
 
+        const size_t nblocks =
+                (n2 + binary_knn_block_size - 1) / binary_knn_block_size;
 #pragma omp parallel for
-        for (size_t j = 0; j < n2; j++) {
-            if (!sel || sel->is_member(j)) {
-                int thread_no = omp_get_thread_num();
+        for (size_t b = 0; b < nblocks; b++) {
+            int thread_no = omp_get_thread_num();
+            const size_t j0 = b * binary_knn_block_size;
+            const size_t j1 = std::min(j0 + binary_knn_block_size, n2);
+            const uint8_t* bs2_ = bs2 + j0 * bytes_per_code;
 
-                const uint8_t* bs2_ = bs2 + j * bytes_per_code;
-                for (size_t i = 0; i < ha->nh; i++) {
-                    T dis = hc[i].compute(bs2_);
-                    T* val_ = value + thread_no * thread_heap_size + i * k;
-                    int64_t* ids_ =
-                            labels + thread_no * thread_heap_size + i * k;
-                    if (C::cmp(val_[0], dis)) {
-                        faiss::heap_replace_top<C>(k, val_, ids_, dis, j);
+            T dis[binary_knn_block_size];
+            for (size_t i = 0; i < ha->nh; i++) {
+                hc[i].compute_ny(bs2_, j1 - j0, dis);
+                T* val_ = value + thread_no * thread_heap_size + i * k;
+                int64_t* ids_ = labels + thread_no * thread_heap_size + i * k;
+                for (size_t j = j0; j < j1; j++) {
+                    if ((!sel || sel->is_member(j)) &&
+                        C::cmp(val_[0], dis[j - j0])) {
+                        faiss::heap_replace_top<C>(
+                                k, val_, ids_, dis[j - j0], j);
                     }
                 }
             }
@@ -462,16 +534,17 @@ void binary_knn_hc(
             for (size_t i = 0; i < ha->nh; i++) {
                 MetricComputer hc(bs1 + i * bytes_per_code, bytes_per_code);
 
-                const uint8_t* bs2_ = bs2 + j0 * bytes_per_code;
-                T dis;
+                T dis[binary_knn_block_size];
                 T* __restrict bh_val_ = ha->val + i * k;
                 int64_t* __restrict bh_ids_ = ha->ids + i * k;
-                for (size_t j = j0; j < j1; j++, bs2_ += bytes_per_code) {
-                    if (!sel || sel->is_member(j)) {
-                        dis = hc.compute(bs2_);
-                        if (C::cmp(bh_val_[0], dis)) {
+                for (size_t jb = j0; jb < j1; jb += binary_knn_block_size) {
+                    const size_t je = std::min(jb + binary_knn_block_size, j1);
+                    hc.compute_ny(bs2 + jb * bytes_per_code, je - jb, dis);
+                    for (size_t j = jb; j < je; j++) {
+                        if ((!sel || sel->is_member(j)) &&
+                            C::cmp(bh_val_[0], dis[j - jb])) {
                             faiss::heap_replace_top<C>(
-                                    k, bh_val_, bh_ids_, dis, j);
+                                    k, bh_val_, bh_ids_, dis[j - jb], j);
                         }
                     }
                 }
@@ -490,55 +563,16 @@ void binary_knn_hc(
         size_t nb,
         size_t ncodes,
         const IDSelector* sel) {
+    // the codes are scored in blocks with the simd hooks, which cover every
+    // code size
     switch (metric_type) {
-        case METRIC_Jaccard: {
-            {
-                switch (ncodes) {
-#define binary_knn_hc_jaccard(ncodes)                     \
-    case ncodes:                                          \
-        binary_knn_hc<C, faiss::JaccardComputer##ncodes>( \
-                ncodes, ha, a, b, nb, sel);            \
-        break;
-                    binary_knn_hc_jaccard(8);
-                    binary_knn_hc_jaccard(16);
-                    binary_knn_hc_jaccard(32);
-                    binary_knn_hc_jaccard(64);
-                    binary_knn_hc_jaccard(128);
-                    binary_knn_hc_jaccard(256);
-                    binary_knn_hc_jaccard(512);
-#undef binary_knn_hc_jaccard
-                    default:
-                        binary_knn_hc<C, faiss::JaccardComputerDefault>(
-                                ncodes, ha, a, b, nb, sel);
-                        break;
-                }
-            }
+        case METRIC_Jaccard:
+            binary_knn_hc<C, JaccardComputerNy>(ncodes, ha, a, b, nb, sel);
             break;
-        }
 
-        case METRIC_Hamming: {
-            {
-                switch (ncodes) {
-#define binary_knn_hc_hamming(ncodes)                     \
-    case ncodes:                                          \
-        binary_knn_hc<C, faiss::HammingComputer##ncodes>( \
-                ncodes, ha, a, b, nb, sel);            \
-        break;
-                    binary_knn_hc_hamming(4);
-                    binary_knn_hc_hamming(8);
-                    binary_knn_hc_hamming(16);
-                    binary_knn_hc_hamming(20);
-                    binary_knn_hc_hamming(32);
-                    binary_knn_hc_hamming(64);
-#undef binary_knn_hc_hamming
-                    default:
-                        binary_knn_hc<C, faiss::HammingComputerDefault>(
-                                ncodes, ha, a, b, nb, sel);
-                        break;
-                }
-            }
+        case METRIC_Hamming:
+            binary_knn_hc<C, HammingComputerNy>(ncodes, ha, a, b, nb, sel);
             break;
-        }
 
         default:
             break;
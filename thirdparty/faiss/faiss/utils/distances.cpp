@@ -197,6 +197,62 @@ void exhaustive_inner_product_seq(
 }
 */
 
+// the queries scored together against a block of the database, and the size
+// of a block, so that it stays in L2 while they are scored against it
+constexpr size_t kBlockQueries = 8;
+constexpr size_t kBlockBytes = 128 * 1024;
+
+// the result handlers whose per-query handlers can be used side by side
+template <class BlockResultHandler>
+struct is_blockable_handler : std::true_type {};
+template <class C, bool use_sel>
+struct is_blockable_handler<RangeSearchBlockResultHandler<C, use_sel>>
+        : std::false_type {};
+
+// Scores the queries in tiles of kBlockQueries against blocks of the
+// database, so that every block is read from memory once per tile instead of
+// once per query. Every query of a tile keeps its own top-k, the distances are
+// consumed as they are computed. scan(i, j0, n, resi) scores query i against
+// the rows [j0, j0 + n).
+template <class BlockResultHandler, class Scan>
+void exhaustive_blocked_impl(
+        size_t d,
+        size_t nx,
+        size_t ny,
+        BlockResultHandler& res,
+        Scan&& scan) {
+    using SingleResultHandler = typename BlockResultHandler::SingleResultHandler;
+    const int64_t ntiles = (nx + kBlockQueries - 1) / kBlockQueries;
+    const size_t block_rows =
+            std::max<size_t>(64, kBlockBytes / (d * sizeof(float))) & ~size_t(3);
+    int nt = std::min(int(ntiles), omp_get_max_threads());
+
+#pragma omp parallel num_threads(nt)
+    {
+        std::vector<SingleResultHandler> resi;
+        resi.reserve(kBlockQueries);
+#pragma omp for
+        for (int64_t t = 0; t < ntiles; t++) {
+            const size_t i0 = t * kBlockQueries;
+            const size_t i1 = std::min(nx, i0 + kBlockQueries);
+            resi.clear();
+            for (size_t i = i0; i < i1; i++) {
+                resi.emplace_back(res);
+                resi.back().begin(i);
+            }
+            for (size_t j0 = 0; j0 < ny; j0 += block_rows) {
+                const size_t n = std::min(block_rows, ny - j0);
+                for (size_t i = i0; i < i1; i++) {
+                    scan(i, j0, n, resi[i - i0]);
+                }
+            }
+            for (auto& r : resi) {
+                r.end();
+            }
+        }
+    }
+}
+
 // An improved implementation that
 // 1. helps the branch predictor,
 // 2. computes distances for 4 elements per loop
@@ -210,6 +266,39 @@ void exhaustive_inner_product_seq_impl(
         BlockResultHandler& res,
         const SelectorHelper selector) {
     using SingleResultHandler = typename BlockResultHandler::SingleResultHandler;
+
+    if constexpr (is_blockable_handler<BlockResultHandler>::value) {
+        if (nx > 1) {
+            auto scan = [&](const size_t i,
+                            const size_t j0,
+                            const size_t n,
+                            SingleResultHandler& resi) {
+                const float* x_i = x + i * d;
+                const float* y_j0 = y + j0 * d;
+                auto apply = [&resi, j0](const float dis, const idx_t j) {
+                    resi.add_result(dis, j0 + j);
+                };
+                if constexpr (std::is_same_v<SelectorHelper, BitsetViewSelectorHelper>) {
+                    auto all = [](const size_t) { return true; };
+                    auto process = [&](const int64_t* ids, const size_t n_ids) {
+                        auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+                            apply(dis, ids[k]);
+                        };
+                        fvec_inner_products_ny_by_idx_if(x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    };
+                    bitset_gather_if(selector.bitset, selector.id_offset, j0, n, process);
+                } else {
+                    auto filter = [&selector, j0](const size_t j) {
+                        return selector.is_member(j0 + j);
+                    };
+                    fvec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+                }
+            };
+            exhaustive_blocked_impl(d, nx, ny, res, scan);
+            return;
+        }
+    }
+
     int nt = std::min(int(nx), omp_get_max_threads());
 
 #pragma omp parallel num_threads(nt)
@@ -231,7 +320,19 @@ void exhaustive_inner_product_seq_impl(
             };
 
             // compute distances
-            fvec_inner_products_ny_if(x_i, y, d, ny, filter, apply);
+            if constexpr (std::is_same_v<SelectorHelper, BitsetViewSelectorHelper>) {
+                // the rows left by the bitset are gathered, see bitset_gather_if()
+                auto all = [](const size_t) { return true; };
+                auto process = [&](const int64_t* ids, const size_t n) {
+                    auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+                        apply(dis, ids[k]);
+                    };
+                    fvec_inner_products_ny_by_idx_if(x_i, y, ids, d, n, all, apply_by_idx);
+                };
+                bitset_gather_if(selector.bitset, selector.id_offset, 0, ny, process);
+            } else {
+                fvec_inner_products_ny_if(x_i, y, d, ny, filter, apply);
+            }
 
             resi.end();
         }
@@ -324,6 +425,39 @@ void exhaustive_L2sqr_seq_impl(
         BlockResultHandler& res,
         const SelectorHelper selector) {
     using SingleResultHandler = typename BlockResultHandler::SingleResultHandler;
+
+    if constexpr (is_blockable_handler<BlockResultHandler>::value) {
+        if (nx > 1) {
+            auto scan = [&](const size_t i,
+                            const size_t j0,
+                            const size_t n,
+                            SingleResultHandler& resi) {
+                const float* x_i = x + i * d;
+                const float* y_j0 = y + j0 * d;
+                auto apply = [&resi, j0](const float dis, const idx_t j) {
+                    resi.add_result(dis, j0 + j);
+                };
+                if constexpr (std::is_same_v<SelectorHelper, BitsetViewSelectorHelper>) {
+                    auto all = [](const size_t) { return true; };
+                    auto process = [&](const int64_t* ids, const size_t n_ids) {
+                        auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+                            apply(dis, ids[k]);
+                        };
+                        fvec_L2sqr_ny_by_idx_if(x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    };
+                    bitset_gather_if(selector.bitset, selector.id_offset, j0, n, process);
+                } else {
+                    auto filter = [&selector, j0](const size_t j) {
+                        return selector.is_member(j0 + j);
+                    };
+                    fvec_L2sqr_ny_if(x_i, y_j0, d, n, filter, apply);
+                }
+            };
+            exhaustive_blocked_impl(d, nx, ny, res, scan);
+            return;
+        }
+    }
+
     int nt = std::min(int(nx), omp_get_max_threads());
 
 #pragma omp parallel num_threads(nt)
@@ -345,7 +479,19 @@ void exhaustive_L2sqr_seq_impl(
             };
 
             // compute distances
-            fvec_L2sqr_ny_if(x_i, y, d, ny, filter, apply);
+            if constexpr (std::is_same_v<SelectorHelper, BitsetViewSelectorHelper>) {
+                // the rows left by the bitset are gathered, see bitset_gather_if()
+                auto all = [](const size_t) { return true; };
+                auto process = [&](const int64_t* ids, const size_t n) {
+                    auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+                        apply(dis, ids[k]);
+                    };
+                    fvec_L2sqr_ny_by_idx_if(x_i, y, ids, d, n, all, apply_by_idx);
+                };
+                bitset_gather_if(selector.bitset, selector.id_offset, 0, ny, process);
+            } else {
+                fvec_L2sqr_ny_if(x_i, y, d, ny, filter, apply);
+            }
 
             resi.end();
         }
@@ -430,9 +576,16 @@ void exhaustive_cosine_seq(
 }
 */
 
+// the norm that a cosine is divided by, 1 for a zero vector
+inline float cosine_norm(const float* x, size_t d) {
+    const float norm = sqrtf(fvec_norm_L2sqr(x, d));
+    return norm == 0.0f ? 1.0f : norm;
+}
+
 // An improved implementation that
 // 1. helps the branch predictor,
 // 2. computes distances for 4 elements per loop
+// The queries need not be normalized, the scores are divided by their norms.
 template <class BlockResultHandler, class SelectorHelper>
 void exhaustive_cosine_seq_impl(
         const float* __restrict x,
@@ -444,6 +597,48 @@ void exhaustive_cosine_seq_impl(
         BlockResultHandler& res,
         const SelectorHelper selector) {
     using SingleResultHandler = typename BlockResultHandler::SingleResultHandler;
+
+    if constexpr (is_blockable_handler<BlockResultHandler>::value) {
+        if (nx > 1) {
+            std::vector<float> x_norms(nx);
+            for (size_t i = 0; i < nx; i++) {
+                x_norms[i] = cosine_norm(x + i * d, d);
+            }
+            auto scan = [&](const size_t i,
+                            const size_t j0,
+                            const size_t n,
+                            SingleResultHandler& resi) {
+                const float* x_i = x + i * d;
+                const float* y_j0 = y + j0 * d;
+                const float x_norm = x_norms[i];
+                auto apply = [&resi, x_norm, y, y_norms, d, j0](const float dis, const idx_t j) {
+                    float norm = (y_norms != nullptr)
+                            ? y_norms[j0 + j]
+                            : sqrtf(fvec_norm_L2sqr(y + (j0 + j) * d, d));
+                    norm = (norm == 0.0 ? 1.0 : norm);
+                    resi.add_result(dis / (x_norm * norm), j0 + j);
+                };
+                if constexpr (std::is_same_v<SelectorHelper, BitsetViewSelectorHelper>) {
+                    auto all = [](const size_t) { return true; };
+                    auto process = [&](const int64_t* ids, const size_t n_ids) {
+                        auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+                            apply(dis, ids[k]);
+                        };
+                        fvec_inner_products_ny_by_idx_if(x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    };
+                    bitset_gather_if(selector.bitset, selector.id_offset, j0, n, process);
+                } else {
+                    auto filter = [&selector, j0](const size_t j) {
+                        return selector.is_member(j0 + j);
+                    };
+                    fvec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+                }
+            };
+            exhaustive_blocked_impl(d, nx, ny, res, scan);
+            return;
+        }
+    }
+
     int nt = std::min(int(nx), omp_get_max_threads());
 
 #pragma omp parallel num_threads(nt)
@@ -452,6 +647,7 @@ void exhaustive_cosine_seq_impl(
 #pragma omp for
         for (int64_t i = 0; i < nx; i++) {
             const float* x_i = x + i * d;
+            const float x_norm = cosine_norm(x_i, d);
             resi.begin(i);
 
             // the lambda that filters acceptable elements.
@@ -460,17 +656,29 @@ void exhaustive_cosine_seq_impl(
             };
 
             // the lambda that applies a filtered element.
-            auto apply = [&resi, y, y_norms, d](const float ip, const idx_t j) {
+            auto apply = [&resi, x_norm, y, y_norms, d](const float ip, const idx_t j) {
                 float norm =
                     (y_norms != nullptr) ? 
                         y_norms[j] : 
                         sqrtf(fvec_norm_L2sqr(y + j * d, d));
                 norm = (norm == 0.0 ? 1.0 : norm);
-                resi.add_result(ip / norm, j);
+                resi.add_result(ip / (x_norm * norm), j);
             };
 
             // compute distances
-            fvec_inner_products_ny_if(x_i, y, d, ny, filter, apply);
+            if constexpr (std::is_same_v<SelectorHelper, BitsetViewSelectorHelper>) {
+                // the rows left by the bitset are gathered, see bitset_gather_if()
+                auto all = [](const size_t) { return true; };
+                auto process = [&](const int64_t* ids, const size_t n) {
+                    auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+                        apply(dis, ids[k]);
+                    };
+                    fvec_inner_products_ny_by_idx_if(x_i, y, ids, d, n, all, apply_by_idx);
+                };
+                bitset_gather_if(selector.bitset, selector.id_offset, 0, ny, process);
+            } else {
+                fvec_inner_products_ny_if(x_i, y, d, ny, filter, apply);
+            }
 
             resi.end();
         }
@@ -675,9 +883,13 @@ void exhaustive_cosine_blas(
     const size_t bs_y = distance_compute_blas_database_bs;
     // const size_t bs_x = 16, bs_y = 16;
     std::unique_ptr<float[]> ip_block(new float[bs_x * bs_y]);
+    std::unique_ptr<float[]> x_norms(new float[nx]);
     std::unique_ptr<float[]> y_norms(new float[ny]);
     std::unique_ptr<float[]> del2;
 
+    for (size_t i = 0; i < nx; i++) {
+        x_norms[i] = cosine_norm(x + i * d, d);
+    }
     if (y_norms_in == nullptr) {
         fvec_norms_L2(y_norms.get(), y, d, ny);
     }
@@ -714,13 +926,14 @@ void exhaustive_cosine_blas(
 #pragma omp parallel for
             for (int64_t i = i0; i < i1; i++) {
                 float* ip_line = ip_block.get() + (i - i0) * (j1 - j0);
+                const float x_norm = x_norms[i];
 
                 for (size_t j = j0; j < j1; j++) {
                     float ip = *ip_line;
                     float norm = (y_norms_in != nullptr) ? y_norms_in[j]
                                                          : y_norms[j];
                     norm = (norm == 0.0 ? 1.0 : norm);
-                    *ip_line = ip / norm;
+                    *ip_line = ip / (x_norm * norm);
                     ip_line++;
                 }
             }
@@ -869,6 +1082,7 @@ int distance_compute_blas_threshold = 16384;
 int distance_compute_blas_query_bs = 4096;
 int distance_compute_blas_database_bs = 1024;
 int distance_compute_min_k_reservoir = 100;
+int distance_compute_max_k_ny_topk = 64;
 
 void knn_inner_product(
         const float* x,
@@ -1006,6 +1220,25 @@ void exhaustive_L2sqr_nearest_imp(
     }
 }
 
+// the top k of every query by the fused ny_topk kernel, see
+// fvec_L2sqr_ny_topk()
+void exhaustive_L2sqr_topk_imp(
+        const float* __restrict x,
+        const float* __restrict y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        size_t k,
+        float* vals,
+        int64_t* ids) {
+    int nt = std::min(int(nx), omp_get_max_threads());
+
+#pragma omp parallel for num_threads(nt)
+    for (int64_t i = 0; i < nx; i++) {
+        fvec_L2sqr_ny_topk(x + i * d, y, d, ny, k, vals + i * k, ids + i * k);
+    }
+}
+
 void knn_L2sqr(
         const float* x,
         const float* y,
@@ -1039,7 +1272,12 @@ void knn_L2sqr(
     //     Top1BlockResultHandler<CMax<float, int64_t>> res(nx, vals, ids);
     //     knn_L2sqr_select(x, y, d, nx, ny, res, y_norm2, sel);
     // } else 
-    if (k < distance_compute_min_k_reservoir) {
+    if (sel == nullptr && k <= size_t(distance_compute_max_k_ny_topk) &&
+        (nx == 1 || ny * d * sizeof(float) <= kBlockBytes)) {
+        // a single query, or a database that fits a block: nothing to gain
+        // from the tiles, the distances are selected as they are computed
+        exhaustive_L2sqr_topk_imp(x, y, d, nx, ny, k, vals, ids);
+    } else if (k < distance_compute_min_k_reservoir) {
         if (sel == nullptr) {
             HeapBlockResultHandler<CMax<float, int64_t>, false> res(nx, vals, ids, k);
             knn_L2sqr_select(x, y, d, nx, ny, res, y_norm2);
@@ -1556,6 +1794,7 @@ void knn_cosine_by_idx(
 #pragma omp parallel for if (nx > 100)
     for (int64_t i = 0; i < nx; i++) {
         const float* x_ = x + i * d;
+        const float x_norm = cosine_norm(x_, d);
         const int64_t* idsi = ids + i * ld_ids;
         size_t j;
         float* __restrict simi = res_vals + i * k;
@@ -1572,7 +1811,7 @@ void knn_cosine_by_idx(
                     y_norms[idsi[j]] : 
                     sqrtf(fvec_norm_L2sqr(y + d * idsi[j], d));
             norm = (norm == 0.0 ? 1.0 : norm);
-            ip /= norm;
+            ip /= (x_norm * norm);
 
             if (ip > simi[0]) {
                 minheap_replace_top(k, simi, idxi, ip, idsi[j]);
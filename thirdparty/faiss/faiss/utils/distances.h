@@ -204,6 +204,11 @@ FAISS_API extern int distance_compute_blas_database_bs;
 // rather than a heap
 FAISS_API extern int distance_compute_min_k_reservoir;
 
+// up to this number of results, L2 searches of a single query or of a small
+// database select the results as the distances are computed, see
+// fvec_L2sqr_ny_topk()
+FAISS_API extern int distance_compute_max_k_ny_topk;
+
 /** Return the k nearest neighors of each of the nx vectors x among the ny
  *  vector y, w.r.t to max inner product.
  *
@@ -298,7 +303,9 @@ void all_L2sqr(
         const float* y_norms,
         const IDSelector* sel);
 
-// Knowhere-specific function
+// Knowhere-specific function. The queries x need not be normalized, the
+// scores are divided by the norms of both sides, as in the other cosine
+// functions.
 void knn_cosine(
         const float* x,
         const float* y,
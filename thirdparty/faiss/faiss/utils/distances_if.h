@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#pragma once
+
 #include <array>
 #include <cstddef>
 #include <optional>
@@ -12,6 +14,7 @@
 
 #include <faiss/impl/DistanceComputer.h>
 #include <faiss/utils/distances.h>
+#include "knowhere/bitsetview.h"
 #include "simd/hook.h"
 
 namespace faiss {
@@ -145,6 +148,40 @@ struct ByIdxRemapping {
     }    
 };
 
+// Gathers the rows [j0, j0 + ny) that are not filtered out by bitset and
+//   calls process() for them in groups of up to BUFFER_SIZE, their indices
+//   being relative to j0. The bitset is read 64 bits at a time and its words
+//   of filtered out rows are skipped, so that the rows left by a sparse bitset
+//   are both found and scored 4 at a time with the *_by_idx_if functions
+//   instead of being tested one by one.
+template<
+    // process the gathered rows.
+    //   void Process(const int64_t* ids, const size_t n);
+    typename Process,
+    size_t BUFFER_SIZE = 256>
+void bitset_gather_if(
+        const knowhere::BitsetView& bitset,
+        const size_t id_offset,
+        const size_t j0,
+        const size_t ny,
+        Process process) {
+    int64_t ids[BUFFER_SIZE];
+    size_t counter = 0;
+
+    const size_t from = id_offset + j0;
+    bitset.for_each_valid_index(from, from + ny, [&](const size_t idx) {
+        ids[counter++] = idx - from;
+        if (counter == BUFFER_SIZE) {
+            process(ids, counter);
+            counter = 0;
+        }
+    });
+
+    if (counter > 0) {
+        process(ids, counter);
+    }
+}
+
 } // namespace
 
 /***************************************************************************
@@ -24,6 +24,197 @@
 #include "simd/hook.h"
 namespace faiss {
 namespace {
+// the queries scored together against a block of the database
+constexpr size_t kBlockQueries = 8;
+// the size of a block of the database, so that it stays in L2 while the
+// queries of a tile are scored against it
+constexpr size_t kBlockBytes = 128 * 1024;
+
+// the result handlers whose per-query handlers can be used side by side
+template <class BlockResultHandler>
+struct is_blockable_handler : std::true_type {};
+template <class C, bool use_sel>
+struct is_blockable_handler<RangeSearchBlockResultHandler<C, use_sel>>
+        : std::false_type {};
+
+// Scores the queries in tiles of kBlockQueries against blocks of the
+// database, so that every block is read from memory once per tile instead of
+// once per query. Every query of a tile keeps its own top-k, so the distances
+// of a block are consumed as they are computed and never stored.
+// scan(i, j0, n, resi) scores query i against the rows [j0, j0 + n).
+template <typename DataType, class BlockResultHandler, class Scan>
+void exhaustive_blocked_impl_typed(
+        size_t d,
+        size_t nx,
+        size_t ny,
+        BlockResultHandler& res,
+        Scan&& scan) {
+    using SingleResultHandler =
+            typename BlockResultHandler::SingleResultHandler;
+    // a single query reads the database once anyway
+    const size_t block_rows = nx == 1
+            ? ny
+            : std::max<size_t>(64, kBlockBytes / (d * sizeof(DataType))) &
+                    ~size_t(3);
+
+    std::vector<SingleResultHandler> resi;
+    resi.reserve(kBlockQueries);
+    for (size_t i0 = 0; i0 < nx; i0 += kBlockQueries) {
+        const size_t i1 = std::min(nx, i0 + kBlockQueries);
+        resi.clear();
+        for (size_t i = i0; i < i1; i++) {
+            resi.emplace_back(res);
+            resi.back().begin(i);
+        }
+        for (size_t j0 = 0; j0 < ny; j0 += block_rows) {
+            const size_t n = std::min(block_rows, ny - j0);
+            for (size_t i = i0; i < i1; i++) {
+                scan(i, j0, n, resi[i - i0]);
+            }
+        }
+        for (auto& r : resi) {
+            r.end();
+        }
+    }
+}
+
+// the queries and rows of the database multiplied at once by the
+// *_vec_inner_products_nx_ny() hooks
+constexpr size_t kMatrixQueries = 16;
+constexpr size_t kMatrixRows = 256;
+// above it, the rows left by a bitset are scored one by one instead
+constexpr float kMatrixMaxFilterRatio = 0.5f;
+
+template <typename DataType>
+constexpr bool has_matrix_kernel_v =
+        std::is_same_v<DataType, knowhere::int8> ||
+        std::is_same_v<DataType, knowhere::bf16>;
+
+inline void matrix_inner_products(
+        float* ip,
+        const knowhere::int8* x,
+        const knowhere::int8* y,
+        size_t d,
+        size_t nx,
+        size_t ny) {
+    int8_vec_inner_products_nx_ny(ip, x, y, d, nx, ny);
+}
+
+inline void matrix_inner_products(
+        float* ip,
+        const knowhere::bf16* x,
+        const knowhere::bf16* y,
+        size_t d,
+        size_t nx,
+        size_t ny) {
+    bf16_vec_inner_products_nx_ny(ip, x, y, d, nx, ny);
+}
+
+inline float matrix_norm_L2sqr(const knowhere::int8* x, size_t d) {
+    return int8_vec_norm_L2sqr(x, d);
+}
+
+inline float matrix_norm_L2sqr(const knowhere::bf16* x, size_t d) {
+    return bf16_vec_norm_L2sqr(x, d);
+}
+
+// whether the int8 or bf16 queries are multiplied by blocks of the database
+// as matrices, on AMX tiles
+template <typename DataType, class IDSelector>
+bool use_matrix(const size_t nx, const IDSelector& selector) {
+    const bool supported = std::is_same_v<DataType, knowhere::int8>
+            ? support_int8_amx
+            : support_bf16_amx;
+    if (!supported || nx < 2) {
+        return false;
+    }
+    if constexpr (std::is_same_v<IDSelector, knowhere::BitsetViewIDSelector>) {
+        return selector.bitset_view.filter_ratio() < kMatrixMaxFilterRatio;
+    }
+    return true;
+}
+
+// Scores the queries in tiles of kMatrixQueries against blocks of
+// kMatrixRows of the database with matrix_inner_products(), and hands
+// finish(resi, i, j, ip, y_norm_sq) the inner products of the rows that the
+// selector accepts. y_norm_sq is the squared norm of row j if with_y_norms is
+// set, 0 otherwise.
+template <
+        typename DataType,
+        class BlockResultHandler,
+        class IDSelector,
+        class Finish>
+void exhaustive_matrix_impl(
+        const DataType* __restrict x,
+        const DataType* __restrict y,
+        size_t d,
+        size_t nx,
+        size_t ny,
+        BlockResultHandler& res,
+        const IDSelector& selector,
+        const bool with_y_norms,
+        Finish&& finish) {
+    using SingleResultHandler =
+            typename BlockResultHandler::SingleResultHandler;
+    std::vector<float> ip(kMatrixQueries * kMatrixRows);
+    std::vector<float> y_norms(kMatrixRows, 0);
+
+    std::vector<SingleResultHandler> resi;
+    resi.reserve(kMatrixQueries);
+    for (size_t i0 = 0; i0 < nx; i0 += kMatrixQueries) {
+        const size_t i1 = std::min(nx, i0 + kMatrixQueries);
+        resi.clear();
+        for (size_t i = i0; i < i1; i++) {
+            resi.emplace_back(res);
+            resi.back().begin(i);
+        }
+        for (size_t j0 = 0; j0 < ny; j0 += kMatrixRows) {
+            const size_t n = std::min(kMatrixRows, ny - j0);
+            matrix_inner_products(
+                    ip.data(), x + i0 * d, y + j0 * d, d, i1 - i0, n);
+            for (size_t j = 0; j < n; j++) {
+                if (!selector.is_member(j0 + j)) {
+                    continue;
+                }
+                if (with_y_norms) {
+                    y_norms[j] = matrix_norm_L2sqr(y + (j0 + j) * d, d);
+                }
+                for (size_t i = i0; i < i1; i++) {
+                    finish(resi[i - i0],
+                           i,
+                           j0 + j,
+                           ip[(i - i0) * n + j],
+                           y_norms[j]);
+                }
+            }
+        }
+        for (auto& r : resi) {
+            r.end();
+        }
+    }
+}
+
+// Scores the rows [j0, j0 + n) that the bitset of selector leaves, gathered
+// with bitset_gather_if(). kernel(ids, n_ids, filter, apply) is one of the
+// *_by_idx_if functions, apply gets the rows relative to j0.
+template <class Kernel, class Apply>
+void bitset_scan_typed(
+        const knowhere::BitsetViewIDSelector& selector,
+        const size_t j0,
+        const size_t n,
+        Kernel kernel,
+        Apply apply) {
+    auto all = [](const size_t) { return true; };
+    auto process = [&](const int64_t* ids, const size_t n_ids) {
+        auto apply_by_idx = [&apply, ids](const float dis, const size_t k) {
+            apply(dis, ids[k]);
+        };
+        kernel(ids, n_ids, all, apply_by_idx);
+    };
+    bitset_gather_if(
+            selector.bitset_view, selector.id_offset, j0, n, process);
+}
+
 template <typename DataType, class BlockResultHandler, class IDSelector>
 void exhaustive_inner_product_impl_typed(
         const DataType* __restrict x,
@@ -36,6 +227,68 @@ void exhaustive_inner_product_impl_typed(
     using SingleResultHandler =
             typename BlockResultHandler::SingleResultHandler;
 
+    if constexpr (
+            !std::is_same_v<IDSelector, IDSelectorArray> &&
+            is_blockable_handler<BlockResultHandler>::value) {
+        if constexpr (has_matrix_kernel_v<DataType>) {
+            if (use_matrix<DataType>(nx, selector)) {
+                auto finish = [](SingleResultHandler& resi,
+                                 const size_t,
+                                 const size_t j,
+                                 const float ip,
+                                 const float) { resi.add_result(ip, j); };
+                exhaustive_matrix_impl(
+                        x, y, d, nx, ny, res, selector, false, finish);
+                return;
+            }
+        }
+        auto scan = [&](const size_t i,
+                        const size_t j0,
+                        const size_t n,
+                        SingleResultHandler& resi) {
+            const DataType* x_i = x + i * d;
+            const DataType* y_j0 = y + j0 * d;
+            auto filter = [&selector, j0](const size_t j) {
+                return selector.is_member(j0 + j);
+            };
+            auto apply = [&resi, j0](const float ip, const idx_t j) {
+                resi.add_result(ip, j0 + j);
+            };
+            if constexpr (std::is_same_v<
+                                  IDSelector,
+                                  knowhere::BitsetViewIDSelector>) {
+                auto kernel = [&](const int64_t* ids,
+                                  const size_t n_ids,
+                                  auto all,
+                                  auto apply_by_idx) {
+                    if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                        fp16_vec_inner_products_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    } else if constexpr (std::is_same_v<
+                                                 DataType,
+                                                 knowhere::bf16>) {
+                        bf16_vec_inner_products_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    } else if constexpr (std::is_same_v<
+                                                 DataType,
+                                                 knowhere::int8>) {
+                        int8_vec_inner_products_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    }
+                };
+                bitset_scan_typed(selector, j0, n, kernel, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                fp16_vec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::bf16>) {
+                bf16_vec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::int8>) {
+                int8_vec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+            }
+        };
+        exhaustive_blocked_impl_typed<DataType>(d, nx, ny, res, scan);
+        return;
+    }
+
     SingleResultHandler resi(res);
     for (int64_t i = 0; i < nx; i++) {
         const DataType* x_i = x + i * d;
@@ -87,6 +340,80 @@ void exhaustive_L2sqr_seq_impl_typed(
     using SingleResultHandler =
             typename BlockResultHandler::SingleResultHandler;
 
+    if constexpr (
+            !std::is_same_v<IDSelector, IDSelectorArray> &&
+            is_blockable_handler<BlockResultHandler>::value) {
+        // bf16 keeps the distances of the differences, the expansion would
+        // lose the precision of close rows
+        if constexpr (std::is_same_v<DataType, knowhere::int8>) {
+            if (use_matrix<DataType>(nx, selector)) {
+                // the integer terms are exact, so that the distances are the
+                // ones of int8_vec_L2sqr()
+                std::vector<int64_t> x_norms(nx);
+                for (size_t i = 0; i < nx; i++) {
+                    x_norms[i] = (int64_t)int8_vec_norm_L2sqr(x + i * d, d);
+                }
+                auto finish = [&x_norms](SingleResultHandler& resi,
+                                         const size_t i,
+                                         const size_t j,
+                                         const float ip,
+                                         const float y_norm_sq) {
+                    const int64_t dis =
+                            x_norms[i] + (int64_t)y_norm_sq - 2 * (int64_t)ip;
+                    resi.add_result((float)dis, j);
+                };
+                exhaustive_matrix_impl(
+                        x, y, d, nx, ny, res, selector, true, finish);
+                return;
+            }
+        }
+        auto scan = [&](const size_t i,
+                        const size_t j0,
+                        const size_t n,
+                        SingleResultHandler& resi) {
+            const DataType* x_i = x + i * d;
+            const DataType* y_j0 = y + j0 * d;
+            auto filter = [&selector, j0](const size_t j) {
+                return selector.is_member(j0 + j);
+            };
+            auto apply = [&resi, j0](const float dis, const idx_t j) {
+                resi.add_result(dis, j0 + j);
+            };
+            if constexpr (std::is_same_v<
+                                  IDSelector,
+                                  knowhere::BitsetViewIDSelector>) {
+                auto kernel = [&](const int64_t* ids,
+                                  const size_t n_ids,
+                                  auto all,
+                                  auto apply_by_idx) {
+                    if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                        fp16_vec_L2sqr_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    } else if constexpr (std::is_same_v<
+                                                 DataType,
+                                                 knowhere::bf16>) {
+                        bf16_vec_L2sqr_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    } else if constexpr (std::is_same_v<
+                                                 DataType,
+                                                 knowhere::int8>) {
+                        int8_vec_L2sqr_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    }
+                };
+                bitset_scan_typed(selector, j0, n, kernel, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                fp16_vec_L2sqr_ny_if(x_i, y_j0, d, n, filter, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::bf16>) {
+                bf16_vec_L2sqr_ny_if(x_i, y_j0, d, n, filter, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::int8>) {
+                int8_vec_L2sqr_ny_if(x_i, y_j0, d, n, filter, apply);
+            }
+        };
+        exhaustive_blocked_impl_typed<DataType>(d, nx, ny, res, scan);
+        return;
+    }
+
     SingleResultHandler resi(res);
     for (int64_t i = 0; i < nx; i++) {
         const DataType* x_i = x + i * d;
@@ -147,6 +474,95 @@ void exhaustive_cosine_seq_impl_typed(
     } else if constexpr (std::is_same_v<DataType, knowhere::int8>) {
         norm_computer = int8_vec_norm_L2sqr;
     }
+
+    if constexpr (
+            !std::is_same_v<IDSelector, IDSelectorArray> &&
+            is_blockable_handler<BlockResultHandler>::value) {
+        std::vector<float> x_norms(nx);
+        for (size_t i = 0; i < nx; i++) {
+            x_norms[i] = sqrtf(norm_computer(x + i * d, d));
+            x_norms[i] = (x_norms[i] == 0.0 ? 1.0 : x_norms[i]);
+        }
+        if constexpr (has_matrix_kernel_v<DataType>) {
+            if (use_matrix<DataType>(nx, selector)) {
+                auto finish = [&x_norms, y_norms](
+                                      SingleResultHandler& resi,
+                                      const size_t i,
+                                      const size_t j,
+                                      const float ip,
+                                      const float y_norm_sq) {
+                    float y_norm = (y_norms != nullptr) ? y_norms[j]
+                                                        : sqrtf(y_norm_sq);
+                    y_norm = (y_norm == 0.0 ? 1.0 : y_norm);
+                    resi.add_result(ip / (x_norms[i] * y_norm), j);
+                };
+                exhaustive_matrix_impl(
+                        x,
+                        y,
+                        d,
+                        nx,
+                        ny,
+                        res,
+                        selector,
+                        y_norms == nullptr,
+                        finish);
+                return;
+            }
+        }
+        auto scan = [&](const size_t i,
+                        const size_t j0,
+                        const size_t n,
+                        SingleResultHandler& resi) {
+            const DataType* x_i = x + i * d;
+            const DataType* y_j0 = y + j0 * d;
+            const float x_norm = x_norms[i];
+            auto filter = [&selector, j0](const size_t j) {
+                return selector.is_member(j0 + j);
+            };
+            auto apply = [&resi, x_norm, y, y_norms, d, norm_computer, j0](
+                                 const float ip, const idx_t j) {
+                float y_norm = (y_norms != nullptr)
+                        ? y_norms[j0 + j]
+                        : sqrtf(norm_computer(y + (j0 + j) * d, d));
+
+                y_norm = (y_norm == 0.0 ? 1.0 : y_norm);
+                resi.add_result(ip / (x_norm * y_norm), j0 + j);
+            };
+            if constexpr (std::is_same_v<
+                                  IDSelector,
+                                  knowhere::BitsetViewIDSelector>) {
+                auto kernel = [&](const int64_t* ids,
+                                  const size_t n_ids,
+                                  auto all,
+                                  auto apply_by_idx) {
+                    if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                        fp16_vec_inner_products_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    } else if constexpr (std::is_same_v<
+                                                 DataType,
+                                                 knowhere::bf16>) {
+                        bf16_vec_inner_products_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    } else if constexpr (std::is_same_v<
+                                                 DataType,
+                                                 knowhere::int8>) {
+                        int8_vec_inner_products_ny_by_idx_if(
+                                x_i, y_j0, ids, d, n_ids, all, apply_by_idx);
+                    }
+                };
+                bitset_scan_typed(selector, j0, n, kernel, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                fp16_vec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::bf16>) {
+                bf16_vec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+            } else if constexpr (std::is_same_v<DataType, knowhere::int8>) {
+                int8_vec_inner_products_ny_if(x_i, y_j0, d, n, filter, apply);
+            }
+        };
+        exhaustive_blocked_impl_typed<DataType>(d, nx, ny, res, scan);
+        return;
+    }
+
     SingleResultHandler resi(res);
     for (int64_t i = 0; i < nx; i++) {
         const DataType* x_i = x + i * d;
@@ -290,7 +706,23 @@ void knn_L2sqr_typed(
         y += d * imin;
         sel = nullptr;
     }
-    if (k < distance_compute_min_k_reservoir) {
+    constexpr bool has_ny_topk = std::is_same_v<DataType, knowhere::fp16> ||
+            std::is_same_v<DataType, knowhere::bf16>;
+    if (has_ny_topk && sel == nullptr &&
+        k <= size_t(distance_compute_max_k_ny_topk) &&
+        (nx == 1 || ny * d * sizeof(DataType) <= kBlockBytes)) {
+        // a single query, or a database that fits a block: the distances are
+        // selected as they are computed, see fvec_L2sqr_ny_topk()
+        for (size_t i = 0; i < nx; i++) {
+            if constexpr (std::is_same_v<DataType, knowhere::fp16>) {
+                fp16_vec_L2sqr_ny_topk(
+                        x + i * d, y, d, ny, k, vals + i * k, ids + i * k);
+            } else if constexpr (std::is_same_v<DataType, knowhere::bf16>) {
+                bf16_vec_L2sqr_ny_topk(
+                        x + i * d, y, d, ny, k, vals + i * k, ids + i * k);
+            }
+        }
+    } else if (k < distance_compute_min_k_reservoir) {
         HeapBlockResultHandler<CMax<float, int64_t>> res(nx, vals, ids, k);
         if (const auto* sel_bs =
                     dynamic_cast<const knowhere::BitsetViewIDSelector*>(sel)) {
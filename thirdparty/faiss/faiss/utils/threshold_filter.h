@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include <faiss/utils/Heap.h>
+#include "simd/hook.h"
+
+namespace faiss {
+
+/*******************************************************************
+ * Top-k collection of the scores of a scan in blocks.
+ *
+ * Most of the scores of a long list are worse than the k-th best one
+ * found so far. The scores of a block are compared at once with the top
+ * of the heap, branch free (fvec_threshold_filter), and only the
+ * survivors go through the heap comparison, in order and against the top
+ * as it moves. The heap ends up the same as when every score is pushed
+ * one by one.
+ ********************************************************************/
+
+/// the scores that are compared with the top of the heap at once
+constexpr size_t THRESHOLD_FILTER_BLOCK_SIZE = 64;
+
+/// pushes the n scores dis[0..n) into the heap of k results ordered by C,
+/// get_id(j) being the id of dis[j]. Returns the number of heap updates.
+template <class C, typename GetId>
+inline size_t heap_replace_top_filtered(
+        size_t k,
+        typename C::T* heap_dis,
+        typename C::TI* heap_ids,
+        const float* dis,
+        size_t n,
+        GetId&& get_id) {
+    static_assert(std::is_same_v<typename C::T, float>);
+    uint32_t survivors[THRESHOLD_FILTER_BLOCK_SIZE];
+    size_t nup = 0;
+    for (size_t j0 = 0; j0 < n; j0 += THRESHOLD_FILTER_BLOCK_SIZE) {
+        const size_t nb = std::min(THRESHOLD_FILTER_BLOCK_SIZE, n - j0);
+        // a min-heap keeps the scores greater than its top
+        const size_t ns = fvec_threshold_filter(
+                dis + j0, nb, heap_dis[0], !C::is_max, survivors);
+        for (size_t s = 0; s < ns; s++) {
+            const size_t j = j0 + survivors[s];
+            if (C::cmp(heap_dis[0], dis[j])) {
+                heap_replace_top<C>(k, heap_dis, heap_ids, dis[j], get_id(j));
+                nup++;
+            }
+        }
+    }
+    return nup;
+}
+
+/// Collects the scores of a scan that come one at a time, e.g. from the
+/// apply() of fvec_*_ny_if(), and pushes them with heap_replace_top_filtered()
+/// a block at a time. flush() must be called once the scan is done.
+template <class C, typename GetId>
+struct ThresholdFilteredHeap {
+    using TI = typename C::TI;
+
+    size_t k;
+    float* heap_dis;
+    TI* heap_ids;
+    GetId get_id;
+
+    float dis[THRESHOLD_FILTER_BLOCK_SIZE];
+    // the positions in the scan of the scores of the block
+    size_t pos[THRESHOLD_FILTER_BLOCK_SIZE];
+    size_t n = 0;
+    size_t nup = 0;
+
+    ThresholdFilteredHeap(size_t k, float* heap_dis, TI* heap_ids, GetId get_id)
+            : k(k), heap_dis(heap_dis), heap_ids(heap_ids), get_id(get_id) {}
+
+    /// the score of the element at position j of the scan
+    inline void add(const float d, const size_t j) {
+        dis[n] = d;
+        pos[n] = j;
+        if (++n == THRESHOLD_FILTER_BLOCK_SIZE) {
+            flush();
+        }
+    }
+
+    /// pushes the pending scores, returns the heap updates of the whole scan
+    inline size_t flush() {
+        nup += heap_replace_top_filtered<C>(
+                k, heap_dis, heap_ids, dis, n, [&](const size_t s) {
+                    return get_id(pos[s]);
+                });
+        n = 0;
+        return nup;
+    }
+};
+
+template <class C, typename GetId>
+inline ThresholdFilteredHeap<C, GetId> make_threshold_filtered_heap(
+        size_t k,
+        float* heap_dis,
+        typename C::TI* heap_ids,
+        GetId get_id) {
+    return ThresholdFilteredHeap<C, GetId>(k, heap_dis, heap_ids, get_id);
+}
+
+} // namespace faiss
@@ -8,6 +8,7 @@
 
 #include "io/file_io.h"
 #include "knowhere/bitsetview.h"
+#include "knowhere/comp/cancellation.h"
 #include "knowhere/operands.h"
 #include "knowhere/utils.h"
 #pragma GCC diagnostic push
@@ -46,6 +47,8 @@ typedef unsigned int linklistsizeint;
 constexpr float kHnswSearchKnnBFFilterThreshold = 0.93f;
 constexpr float kHnswSearchRangeBFFilterThreshold = 0.97f;
 constexpr float kHnswSearchBFTopkThreshold = 0.5f;
+// the hops between the checks of the CancellationToken of a search
+constexpr size_t kHnswCancellationCheckHops = 64;
 
 enum Metric {
     L2 = 0,
@@ -364,7 +367,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         top_candidates.emplace(dist, ep_id);
         lowerBound = dist;
         candidateSet.emplace(-dist, ep_id);
-        visited[ep_id] = true;
+        visited.set(ep_id);
 
         while (!candidateSet.empty()) {
             std::pair<dist_t, tableint> curr_el_pair = candidateSet.top();
@@ -392,10 +395,10 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             for (size_t j = 0; j < size; j++) {
                 tableint candidate_id = *(datal + j);
                 // if (candidate_id == 0) continue;
-                if (visited[candidate_id]) {
+                if (visited.get(candidate_id)) {
                     continue;
                 }
-                visited[candidate_id] = true;
+                visited.set(candidate_id);
 
                 dist_t dist1 = calcDistance(cur_c, candidate_id);
                 if (top_candidates.size() < ef_construction_ || lowerBound > dist1) {
@@ -421,7 +424,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     template <typename AddSearchCandidate, bool has_deletions, bool collect_metrics = false>
     inline void
-    searchBaseLayerSTNext(const void* data_point, Neighbor next, std::vector<bool>& visited, float& accumulative_alpha,
+    searchBaseLayerSTNext(const void* data_point, Neighbor next, VisitedList& visited, float& accumulative_alpha,
                           const knowhere::BitsetView& bitset, AddSearchCandidate& add_search_candidate,
                           const knowhere::feder::hnsw::FederResultUniq& feder_result = nullptr) const {
         auto [u, d, s] = next;
@@ -438,7 +441,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 prefetchData(list[i + 1]);
             }
             tableint v = list[i];
-            if (visited[v]) {
+            if (visited.get(v)) {
                 if (feder_result != nullptr) {
                     feder_result->visit_info_.AddVisitRecord(0, u, v, -1.0);
                     feder_result->id_set_.insert(u);
@@ -446,7 +449,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 }
                 continue;
             }
-            visited[v] = true;
+            visited.set(v);
             int status = Neighbor::kValid;
             if (has_deletions && bitset.test((int64_t)v)) {
                 status = Neighbor::kInvalid;
@@ -478,7 +481,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     // Thus we include only a subset of filtered nodes(controlled by kAlpha) in the search path.
     template <bool has_deletions, bool collect_metrics = false>
     NeighborSetDoublePopList
-    searchBaseLayerST(tableint ep_id, const void* data_point, size_t ef, std::vector<bool>& visited,
+    searchBaseLayerST(tableint ep_id, const void* data_point, size_t ef, VisitedList& visited,
                       const knowhere::BitsetView& bitset,
                       const knowhere::feder::hnsw::FederResultUniq& feder_result = nullptr,
                       IteratorMinHeap* disqualified = nullptr, float accumulative_alpha = 1.0f) const {
@@ -494,10 +497,14 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             retset.insert(Neighbor(ep_id, dist, Neighbor::kInvalid));
         }
 
-        visited[ep_id] = true;
+        visited.set(ep_id);
         auto add_search_candidate = [&](Neighbor n) { return retset.insert(n, disqualified); };
         size_t hops = 0;
         while (retset.has_next()) {
+            // a cancelled search keeps the candidates found so far
+            if (hops % kHnswCancellationCheckHops == 0 && knowhere::CancellationToken::CurrentIsCancelled()) {
+                break;
+            }
             searchBaseLayerSTNext<decltype(add_search_candidate), has_deletions, collect_metrics>(
                 data_point, retset.pop(), visited, accumulative_alpha, bitset, add_search_candidate, feder_result);
             hops++;
@@ -564,7 +571,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 radius_queue.push({cand.distance, cand.id});
                 result.emplace_back(cand.distance, cand.id);
             }
-            visited[cand.id] = true;
+            visited.set(cand.id);
         }
 
         while (!radius_queue.empty()) {
@@ -580,8 +587,8 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             }
             for (size_t j = 1; j <= size; j++) {
                 int candidate_id = *(data + j);
-                if (!visited[candidate_id]) {
-                    visited[candidate_id] = true;
+                if (!visited.get(candidate_id)) {
+                    visited.set(candidate_id);
                     if (bitset.empty() || !bitset.test((int64_t)candidate_id)) {
                         dist_t dist = calcDistance(data_point, candidate_id);
                         if (dist < radius) {
@@ -1428,7 +1435,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         auto [currObj, vec_hash] = searchTopLayers(query_data, param, feder_result);
         NeighborSetDoublePopList retset;
         size_t ef = param ? param->ef_ : this->ef_;
-        auto visited = visited_list_pool_->getFreeVisitedList();
+        auto& visited = visited_list_pool_->getFreeVisitedList();
         if (!bitset.empty()) {
             retset = searchBaseLayerST<true, true>(currObj, query_data, std::max(ef, k), visited, bitset, feder_result);
         } else {
@@ -1598,7 +1605,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
         auto [currObj, vec_hash] = searchTopLayers(query_data, param, feder_result);
         NeighborSetDoublePopList retset;
-        auto visited = visited_list_pool_->getFreeVisitedList();
+        auto& visited = visited_list_pool_->getFreeVisitedList();
         if (!bitset.empty()) {
             retset = searchBaseLayerST<true, true>(currObj, query_data, ef, visited, bitset, feder_result);
         } else {
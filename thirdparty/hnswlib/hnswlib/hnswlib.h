@@ -136,6 +136,7 @@ AVX512Capable() {
 #include "knowhere/feder/HNSW.h"
 #include "knowhere/object.h"
 #include "neighbor.h"
+#include "visited_list_pool.h"
 
 namespace hnswlib {
 typedef int64_t labeltype;
@@ -201,9 +202,9 @@ struct IteratorWorkspace {
     // TODO test for memory usage of this heap and add a metric monitoring it.
     IteratorMinHeap to_visit;
     // Since iterators do not occupy a thread during the entire lifecycle of an
-    // iteration request, we cannot use the visited list in the shared visited list pool,
+    // iteration request, we cannot use the per-thread visited list of the visited list pool,
     // thus creating a new visited list for every new iteration request.
-    std::vector<bool> visited;
+    VisitedList visited;
     std::vector<knowhere::DistId> dists;
     const size_t ef;
     std::unique_ptr<SearchParam> param;
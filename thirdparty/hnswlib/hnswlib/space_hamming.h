@@ -1,6 +1,6 @@
 #pragma once
 
-#include <faiss/utils/binary_distances.h>
+#include "simd/hook.h"
 
 #include "hnswlib.h"
 
@@ -8,7 +8,9 @@ namespace hnswlib {
 
 static float
 Hamming(const void* pVect1v, const void* pVect2v, const void* qty_ptr) {
-    return faiss::xor_popcnt((const uint8_t*)pVect1v, (const uint8_t*)pVect2v, *((size_t*)qty_ptr) / 8);
+    int32_t dis;
+    faiss::u8_hamming_distance_ny((const uint8_t*)pVect1v, (const uint8_t*)pVect2v, *((size_t*)qty_ptr) / 8, 1, &dis);
+    return dis;
 }
 
 class HammingSpace : public SpaceInterface<float> {
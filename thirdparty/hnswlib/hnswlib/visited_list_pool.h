@@ -1,9 +1,7 @@
 #pragma once
 
 #include <algorithm>
-#include <mutex>
-#include <thread>
-#include <unordered_map>
+#include <cstdint>
 #include <vector>
 #include "knowhere/comp/thread_pool.h"
 
@@ -11,37 +9,83 @@ namespace hnswlib {
 
 ///////////////////////////////////////////////////////////
 //
-// Class for multi-threaded pool-management of VisitedLists
+// A visited table with epoch-based resets: an element is visited if its
+// tag equals the current epoch, so starting a new search only bumps the
+// epoch. The table is cleared only when the epoch wraps around.
+//
+/////////////////////////////////////////////////////////
+
+class VisitedList {
+    using vl_type = uint8_t;
+
+    std::vector<vl_type> tags;
+    vl_type epoch = 0;
+
+ public:
+    VisitedList() = default;
+
+    explicit VisitedList(size_t numelements) {
+        reset(numelements);
+    }
+
+    // start a new search over (at least) numelements elements
+    void
+    reset(size_t numelements) {
+        if (tags.size() < numelements) {
+            // new tags are 0, which is never a valid epoch
+            tags.resize(numelements, 0);
+        }
+        epoch += 1;
+        if (epoch == 0) {
+            std::fill(tags.begin(), tags.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    bool
+    get(size_t id) const {
+        return tags[id] == epoch;
+    }
+
+    void
+    set(size_t id) {
+        tags[id] = epoch;
+    }
+
+    size_t
+    capacity() const {
+        return tags.size();
+    }
+};
+
+///////////////////////////////////////////////////////////
+//
+// Class for multi-threaded management of VisitedLists
 //
 /////////////////////////////////////////////////////////
 
 class VisitedListPool {
     int numelements;
-    std::unordered_map<std::thread::id, std::vector<bool>> map;
-    std::mutex mtx;
 
  public:
     VisitedListPool(int numelements1) {
         numelements = numelements1;
     }
 
-    std::vector<bool>&
+    // Every thread owns a single visited table, which is shared by all the
+    // indexes that the thread searches and grows lazily to the largest one.
+    // A search must be done with the table before it asks for a new one.
+    VisitedList&
     getFreeVisitedList() {
-        std::unique_lock lk(mtx);
-        auto& res = map[std::this_thread::get_id()];
-        lk.unlock();
-        if (res.size() != numelements) {
-            res.assign(numelements, false);
-        } else {
-            std::fill(res.begin(), res.end(), false);
-        }
-        return res;
+        thread_local VisitedList visited;
+        visited.reset(numelements);
+        return visited;
     };
 
     int64_t
     size() {
         auto threads_num = knowhere::ThreadPool::GetGlobalSearchThreadPool()->size();
-        return threads_num * (sizeof(std::thread::id) + numelements * sizeof(bool)) + sizeof(*this);
+        return threads_num * numelements * sizeof(uint8_t) + sizeof(*this);
     }
 };
 }  // namespace hnswlib